@@ -229,6 +229,9 @@ TF_Tensor* TF_TensorMaybeMove(TF_Tensor* tensor) {
 
 void TF_DeleteTensor(TF_Tensor* t) {
   t->buffer->Unref();
+  if (t->encoded_buffer != nullptr) {
+    t->encoded_buffer->Unref();
+  }
   delete t;
 }
 
@@ -237,8 +240,6 @@ int TF_NumDims(const TF_Tensor* t) { return t->shape.dims(); }
 int64_t TF_Dim(const TF_Tensor* t, int dim_index) {
   return static_cast<int64_t>(t->shape.dim_size(dim_index));
 }
-size_t TF_TensorByteSize(const TF_Tensor* t) { return t->buffer->size(); }
-void* TF_TensorData(const TF_Tensor* t) { return t->buffer->data(); }
 
 // --------------------------------------------------------------------------
 size_t TF_StringEncode(const char* src, size_t src_len, char* dst,
@@ -393,7 +394,8 @@ void TF_Reset(const TF_SessionOptions* opt, const char** containers,
 namespace tensorflow {
 
 // Non-static for testing.
-bool TF_Tensor_DecodeStrings(TF_Tensor* src, Tensor* dst, TF_Status* status) {
+bool TF_Tensor_DecodeStrings(const TF_Tensor* src, Tensor* dst,
+                             TF_Status* status) {
   const tensorflow::int64 num_elements = src->shape.num_elements();
   const char* input = reinterpret_cast<const char*>(TF_TensorData(src));
   const size_t src_size = TF_TensorByteSize(src);
@@ -497,12 +499,130 @@ static TF_Tensor* EmptyTensor(TF_DataType dtype, const TensorShape& shape) {
                       [](void*, size_t, void*) {}, nullptr);
 }
 
+// Returns a TF_Tensor sharing the buffer of 'src'. The strings of a DT_STRING
+// tensor are shared as well, and only encoded if TF_TensorData() is called.
+static TF_Tensor* TF_TensorFromTensor(const Tensor& src) {
+  if (!src.IsInitialized() || src.NumElements() == 0) {
+    return EmptyTensor(static_cast<TF_DataType>(src.dtype()), src.shape());
+  }
+  TensorBuffer* buf = TensorCApi::Buffer(src);
+  buf->Ref();
+  return new TF_Tensor{static_cast<TF_DataType>(src.dtype()), src.shape(), buf,
+                       src.dtype() == DT_STRING};
+}
+
+// Sets 'dst' to a Tensor sharing the buffer of 'src', unless 'src' is a
+// TF_STRING tensor in the encoded format.
+static bool TF_TensorToTensor(const TF_Tensor* src, Tensor* dst,
+                              TF_Status* status) {
+  if (src->dtype != TF_STRING || src->native_strings) {
+    *dst = TensorCApi::MakeTensor(src->dtype, src->shape, src->buffer);
+    return true;
+  }
+  // TF_STRING tensors in the encoded format require copying since Tensor class
+  // expects a sequence of string objects.
+  return TF_Tensor_DecodeStrings(src, dst, status);
+}
+
+// Returns the buffer holding the data of 't' in the format described in
+// c_api.h, encoding the strings of a TF_STRING tensor on first use.
+static TensorBuffer* EncodedBuffer(const TF_Tensor* t) {
+  if (!t->native_strings) {
+    return t->buffer;
+  }
+  static mutex* const encoding_mu = new mutex;
+  mutex_lock l(*encoding_mu);
+  if (t->encoded_buffer == nullptr) {
+    TF_Tensor* encoded = TF_Tensor_EncodeStrings(
+        TensorCApi::MakeTensor(t->dtype, t->shape, t->buffer));
+    t->encoded_buffer = encoded->buffer;
+    delete encoded;
+  }
+  return t->encoded_buffer;
+}
+
 // Helpers for loading a TensorFlow plugin (a .so file).
 Status LoadLibrary(const char* library_filename, void** result,
                    const void** buf, size_t* len);
 
 }  // namespace tensorflow
 
+extern "C" {
+
+size_t TF_TensorByteSize(const TF_Tensor* t) {
+  return tensorflow::EncodedBuffer(t)->size();
+}
+
+void* TF_TensorData(const TF_Tensor* t) {
+  return tensorflow::EncodedBuffer(t)->data();
+}
+
+TF_Tensor* TF_NewStringTensor(const int64_t* dims, int num_dims,
+                              const char* const* data, const size_t* lengths,
+                              TF_Status* status) {
+  TensorShape shape;
+  for (int i = 0; i < num_dims; ++i) {
+    if (dims[i] < 0) {
+      status->status =
+          InvalidArgument("Dimension ", i, " is negative: ", dims[i]);
+      return nullptr;
+    }
+    shape.AddDim(dims[i]);
+  }
+  Tensor tensor(tensorflow::DT_STRING, shape);
+  auto strings = tensor.flat<tensorflow::string>();
+  for (tensorflow::int64 i = 0; i < strings.size(); ++i) {
+    strings(i).assign(data[i], lengths[i]);
+  }
+  status->status = Status::OK();
+  return tensorflow::TF_TensorFromTensor(tensor);
+}
+
+void TF_TensorStringElement(const TF_Tensor* t, int64_t index,
+                            const char** data, size_t* len,
+                            TF_Status* status) {
+  if (t->dtype != TF_STRING) {
+    status->status = InvalidArgument("Tensor is not a TF_STRING tensor");
+    return;
+  }
+  const tensorflow::int64 num_elements = t->shape.num_elements();
+  if (index < 0 || index >= num_elements) {
+    status->status = InvalidArgument("Element ", index,
+                                     " out of range for a tensor of ",
+                                     num_elements, " elements");
+    return;
+  }
+  status->status = Status::OK();
+  if (t->native_strings) {
+    const tensorflow::string& s =
+        static_cast<const tensorflow::string*>(t->buffer->data())[index];
+    *data = s.data();
+    *len = s.size();
+    return;
+  }
+  const char* input = static_cast<const char*>(t->buffer->data());
+  const size_t src_size = t->buffer->size();
+  if (static_cast<tensorflow::int64>(src_size / sizeof(tensorflow::uint64)) <
+      num_elements) {
+    status->status = InvalidArgument(
+        "Malformed TF_STRING tensor; too short to hold number of elements");
+    return;
+  }
+  const char* data_start = input + sizeof(tensorflow::uint64) * num_elements;
+  const char* limit = input + src_size;
+  tensorflow::uint64 offset;
+  memcpy(&offset, input + sizeof(tensorflow::uint64) * index, sizeof(offset));
+  if (static_cast<ptrdiff_t>(offset) >= (limit - data_start)) {
+    status->status = InvalidArgument("Malformed TF_STRING tensor; element ",
+                                     index, " out of range");
+    return;
+  }
+  const char* srcp = data_start + offset;
+  TF_StringDecode(srcp, limit - srcp, data, len, status);
+}
+
+}  // end extern "C"
+
 static void TF_Run_Setup(int noutputs, TF_Tensor** c_outputs,
                          TF_Status* status) {
   status->status = Status::OK();
@@ -517,14 +637,8 @@ static bool TF_Run_Inputs(
     TF_Status* status) {
   const int ninputs = input_pairs->size();
   for (int i = 0; i < ninputs; ++i) {
-    TF_Tensor* src = c_inputs[i];
-    if (c_inputs[i]->dtype != TF_STRING) {
-      (*input_pairs)[i].second = tensorflow::TensorCApi::MakeTensor(
-          src->dtype, src->shape, src->buffer);
-    } else if (!tensorflow::TF_Tensor_DecodeStrings(
-                   src, &(*input_pairs)[i].second, status)) {
-      // TF_STRING tensors require copying since Tensor class expects
-      // a sequence of string objects.
+    if (!tensorflow::TF_TensorToTensor(c_inputs[i], &(*input_pairs)[i].second,
+                                       status)) {
       return false;
     }
   }
@@ -578,21 +692,8 @@ static void TF_Run_Helper(
 
   // Store results in c_outputs[]
   for (int i = 0; i < noutputs; ++i) {
-    const Tensor& src = outputs[i];
-    if (!src.IsInitialized() || src.NumElements() == 0) {
-      c_outputs[i] = tensorflow::EmptyTensor(
-          static_cast<TF_DataType>(src.dtype()), src.shape());
-      continue;
-    }
-    if (src.dtype() != tensorflow::DT_STRING) {
-      // Share the underlying buffer.
-      TensorBuffer* buf = tensorflow::TensorCApi::Buffer(src);
-      buf->Ref();
-      c_outputs[i] = new TF_Tensor{static_cast<TF_DataType>(src.dtype()),
-                                   src.shape(), buf};
-    } else {
-      c_outputs[i] = tensorflow::TF_Tensor_EncodeStrings(src);
-    }
+    // Share the underlying buffer, including the strings of DT_STRING tensors.
+    c_outputs[i] = tensorflow::TF_TensorFromTensor(outputs[i]);
   }
 }
 
@@ -1035,16 +1136,7 @@ void TF_SetAttrTensor(TF_OperationDescription* desc, const char* attr_name,
                       TF_Tensor* value, TF_Status* status) {
   status->status = Status::OK();
   Tensor t;
-  bool ok = true;
-
-  if (value->dtype != TF_STRING) {
-    t = tensorflow::TensorCApi::MakeTensor(value->dtype, value->shape,
-                                           value->buffer);
-  } else {
-    // TF_STRING tensors require copying since Tensor class expects
-    // a sequence of string objects.
-    ok = tensorflow::TF_Tensor_DecodeStrings(value, &t, status);
-  }
+  const bool ok = tensorflow::TF_TensorToTensor(value, &t, status);
 
   if (ok) desc->node_builder.Attr(attr_name, t);
 }
@@ -1058,15 +1150,8 @@ void TF_SetAttrTensorList(TF_OperationDescription* desc, const char* attr_name,
   bool ok = true;
 
   for (int i = 0; i < num_values && ok; ++i) {
-    if (values[i]->dtype != TF_STRING) {
-      t.emplace_back(tensorflow::TensorCApi::MakeTensor(
-          values[i]->dtype, values[i]->shape, values[i]->buffer));
-    } else {
-      t.emplace_back(::tensorflow::DT_STRING);
-      // TF_STRING tensors require copying since Tensor class expects
-      // a sequence of string objects.
-      ok = tensorflow::TF_Tensor_DecodeStrings(values[i], &t.back(), status);
-    }
+    t.emplace_back();
+    ok = tensorflow::TF_TensorToTensor(values[i], &t.back(), status);
   }
 
   if (ok) desc->node_builder.Attr(attr_name, t);
@@ -1524,9 +1609,7 @@ void TF_OperationGetAttrTensor(TF_Operation* oper, const char* attr_name,
   Tensor t;
   status->status = tensorflow::GetNodeAttr(oper->node.def(), attr_name, &t);
   if (!status->status.ok()) return;
-  *value = new TF_Tensor{static_cast<TF_DataType>(t.dtype()), t.shape(),
-                         tensorflow::TensorCApi::Buffer(t)};
-  (*value)->buffer->Ref();
+  *value = tensorflow::TF_TensorFromTensor(t);
 }
 
 void TF_OperationGetAttrTensorList(TF_Operation* oper, const char* attr_name,
@@ -1538,9 +1621,7 @@ void TF_OperationGetAttrTensorList(TF_Operation* oper, const char* attr_name,
   const auto len = std::min(max_values, static_cast<int>(ts.size()));
   for (int i = 0; i < len; ++i) {
     const Tensor& t = ts[i];
-    values[i] = new TF_Tensor{static_cast<TF_DataType>(t.dtype()), t.shape(),
-                              tensorflow::TensorCApi::Buffer(t)};
-    values[i]->buffer->Ref();
+    values[i] = tensorflow::TF_TensorFromTensor(t);
   }
 }
 
@@ -2357,4 +2438,83 @@ void TF_SessionPRun(TF_Session* session, const char* handle,
                 output_values, target_names, nullptr, status);
 }
 
+void TF_SessionMakeCallable(TF_Session* session, const TF_Buffer* run_options,
+                            const TF_Output* inputs, int ninputs,
+                            const TF_Output* outputs, int noutputs,
+                            const TF_Operation* const* target_opers,
+                            int ntargets, int64_t* handle, TF_Status* status) {
+  if (!ExtendSessionGraphHelper(session, status)) {
+    return;
+  }
+
+  tensorflow::CallableOptions callable_options;
+  if (run_options != nullptr &&
+      !callable_options.mutable_run_options()->ParseFromArray(
+          run_options->data, run_options->length)) {
+    status->status = InvalidArgument("Unparseable RunOptions proto");
+    return;
+  }
+  for (int i = 0; i < ninputs; ++i) {
+    callable_options.add_feed(OutputName(inputs[i]));
+  }
+  for (int i = 0; i < noutputs; ++i) {
+    callable_options.add_fetch(OutputName(outputs[i]));
+  }
+  for (int i = 0; i < ntargets; ++i) {
+    callable_options.add_target(target_opers[i]->node.name());
+  }
+
+  Session::CallableHandle new_handle;
+  status->status =
+      session->session->MakeCallable(callable_options, &new_handle);
+  if (status->status.ok()) {
+    *handle = new_handle;
+  }
+}
+
+void TF_SessionRunCallable(TF_Session* session, int64_t handle,
+                           TF_Tensor* const* input_values, int ninputs,
+                           TF_Tensor** output_values, int noutputs,
+                           TF_Buffer* run_metadata, TF_Status* status) {
+  TF_Run_Setup(noutputs, output_values, status);
+  if (run_metadata != nullptr && run_metadata->data != nullptr) {
+    status->status =
+        InvalidArgument("Passing non-empty run_metadata is invalid.");
+    return;
+  }
+
+  std::vector<Tensor> feed_tensors(ninputs);
+  for (int i = 0; i < ninputs; ++i) {
+    if (!tensorflow::TF_TensorToTensor(input_values[i], &feed_tensors[i],
+                                       status)) {
+      return;
+    }
+  }
+
+  std::vector<Tensor> fetch_tensors;
+  RunMetadata run_metadata_proto;
+  status->status = session->session->RunCallable(
+      handle, feed_tensors, &fetch_tensors,
+      run_metadata != nullptr ? &run_metadata_proto : nullptr);
+  if (!status->status.ok()) return;
+  if (fetch_tensors.size() != static_cast<size_t>(noutputs)) {
+    status->status = InvalidArgument("Expected ", fetch_tensors.size(),
+                                     " output tensors, but got ", noutputs);
+    return;
+  }
+  if (run_metadata != nullptr) {
+    status->status = MessageToBuffer(run_metadata_proto, run_metadata);
+    if (!status->status.ok()) return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    output_values[i] = tensorflow::TF_TensorFromTensor(fetch_tensors[i]);
+  }
+}
+
+void TF_SessionReleaseCallable(TF_Session* session, int64_t handle,
+                               TF_Status* status) {
+  status->status = session->session->ReleaseCallable(handle);
+}
+
 }  // end extern "C"
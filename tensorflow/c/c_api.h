@@ -214,6 +214,12 @@ TF_CAPI_EXPORT extern TF_Buffer TF_GetBuffer(TF_Buffer* buffer);
 //   The string length (as a varint), followed by the contents of the string
 //   is encoded at data[start_offset[i]]]. TF_StringEncode and TF_StringDecode
 //   facilitate this encoding.
+//
+//   The TF_STRING tensors returned by TensorFlow, and those created by
+//   TF_NewStringTensor, hold their strings in the representation used by the
+//   runtime instead, and are only encoded in this format if TF_TensorData or
+//   TF_TensorByteSize is called. TF_TensorStringElement reads their strings
+//   without encoding them.
 
 typedef struct TF_Tensor TF_Tensor;
 
@@ -262,8 +268,35 @@ TF_CAPI_EXPORT extern int64_t TF_Dim(const TF_Tensor* tensor, int dim_index);
 TF_CAPI_EXPORT extern size_t TF_TensorByteSize(const TF_Tensor*);
 
 // Return a pointer to the underlying data buffer.
+//
+// For a TF_STRING tensor holding its strings in the representation used by the
+// runtime, the first call encodes them into a buffer owned by the tensor, and
+// writes to that buffer do not change the strings.
 TF_CAPI_EXPORT extern void* TF_TensorData(const TF_Tensor*);
 
+// Return a new TF_STRING tensor whose elements, in row major order, are the
+// `lengths[i]` bytes starting at `data[i]`, for each of the elements of the
+// tensor. The bytes are copied once, into the representation used by the
+// runtime, so that passing the tensor to a session doesn't decode it.
+//
+// Returns nullptr and sets an error into `status` on failure.
+TF_CAPI_EXPORT extern TF_Tensor* TF_NewStringTensor(const int64_t* dims,
+                                                    int num_dims,
+                                                    const char* const* data,
+                                                    const size_t* lengths,
+                                                    TF_Status* status);
+
+// Set `*data` and `*len` to the bytes of the element `index`, in row major
+// order, of the TF_STRING tensor `t`, without copying them. The bytes remain
+// valid until `t` is destroyed.
+//
+// Sets an error into `status` on failure.
+TF_CAPI_EXPORT extern void TF_TensorStringElement(const TF_Tensor* t,
+                                                  int64_t index,
+                                                  const char** data,
+                                                  size_t* len,
+                                                  TF_Status* status);
+
 // --------------------------------------------------------------------------
 // Encode the string `src` (`src_len` bytes long) into `dst` in the format
 // required by TF_STRING tensors. Does not write to memory more than `dst_len`
@@ -1131,6 +1164,56 @@ TF_CAPI_EXPORT extern void TF_SessionPRun(
 // Once called, no more calls to TF_SessionPRun should be made.
 TF_CAPI_EXPORT extern void TF_DeletePRunHandle(const char* handle);
 
+// Prepares the graph fragment that computes `outputs` from `inputs` and runs
+// `target_opers`, so that it can be run repeatedly with
+// TF_SessionRunCallable() without looking up the feeds, fetches and targets
+// again. `run_options`, which may be NULL, is the serialized representation of
+// a `RunOptions` protocol buffer used for every run.
+//
+// On success, `*handle` identifies the fragment; it should be released with
+// TF_SessionReleaseCallable() when it is no longer needed.
+// NOTE: This is EXPERIMENTAL and subject to change.
+TF_CAPI_EXPORT extern void TF_SessionMakeCallable(
+    TF_Session*, const TF_Buffer* run_options,
+    // Input names
+    const TF_Output* inputs, int ninputs,
+    // Output names
+    const TF_Output* outputs, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // Output handle
+    int64_t* handle,
+    // Output status
+    TF_Status*);
+
+// Runs the graph fragment identified by `handle`, feeding `input_values` in
+// the order of the `inputs` given to TF_SessionMakeCallable() and placing the
+// values of its `outputs`, in order, in `output_values`. `ninputs` and
+// `noutputs` must match those given to TF_SessionMakeCallable().
+// `run_metadata` is as in TF_SessionRun().
+//
+// Ownership of the elements of output_values[] is transferred to the caller,
+// which must eventually call TF_DeleteTensor on them. On failure,
+// output_values[] contains NULLs.
+// NOTE: This is EXPERIMENTAL and subject to change.
+TF_CAPI_EXPORT extern void TF_SessionRunCallable(
+    TF_Session*, int64_t handle,
+    // Input tensors
+    TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    TF_Tensor** output_values, int noutputs,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status*);
+
+// Releases the graph fragment identified by `handle`. Once called, no more
+// calls to TF_SessionRunCallable should be made with `handle`.
+// NOTE: This is EXPERIMENTAL and subject to change.
+TF_CAPI_EXPORT extern void TF_SessionReleaseCallable(TF_Session*,
+                                                     int64_t handle,
+                                                     TF_Status*);
+
 // --------------------------------------------------------------------------
 // The deprecated session API.  Please switch to the above instead of
 // TF_ExtendGraph(). This deprecated API can be removed at any time without
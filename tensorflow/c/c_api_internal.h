@@ -41,6 +41,13 @@ struct TF_Tensor {
   TF_DataType dtype;
   tensorflow::TensorShape shape;
   tensorflow::TensorBuffer* buffer;
+
+  // Whether 'buffer' holds the tensorflow::string elements of a TF_STRING
+  // tensor, shared with a tensorflow::Tensor, instead of the encoding described
+  // in c_api.h. That encoding is then only computed, into 'encoded_buffer',
+  // when TF_TensorData() or TF_TensorByteSize() is called.
+  bool native_strings;
+  mutable tensorflow::TensorBuffer* encoded_buffer;
 };
 
 struct TF_SessionOptions {
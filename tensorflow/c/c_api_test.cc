@@ -48,7 +48,8 @@ using tensorflow::Tensor;
 using tensorflow::TensorShape;
 
 namespace tensorflow {
-bool TF_Tensor_DecodeStrings(TF_Tensor* src, Tensor* dst, TF_Status* status);
+bool TF_Tensor_DecodeStrings(const TF_Tensor* src, Tensor* dst,
+                             TF_Status* status);
 TF_Tensor* TF_Tensor_EncodeStrings(const Tensor& src);
 }  // namespace tensorflow
 
@@ -179,6 +180,46 @@ TEST(CAPI, TensorEncodeDecodeStrings) {
   TestEncodeDecode(__LINE__, {"small", big, "small2"});
 }
 
+TEST(CAPI, StringTensor) {
+  const std::vector<string> data = {"hello", "", string(300, 'x')};
+  const char* bytes[] = {data[0].data(), data[1].data(), data[2].data()};
+  const size_t lengths[] = {data[0].size(), data[1].size(), data[2].size()};
+  const int64_t dims[] = {3};
+  TF_Status* status = TF_NewStatus();
+  TF_Tensor* t = TF_NewStringTensor(dims, 1, bytes, lengths, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  EXPECT_EQ(TF_STRING, TF_TensorType(t));
+
+  // The elements are read in place.
+  const char* element;
+  size_t len;
+  for (int i = 0; i < 3; ++i) {
+    TF_TensorStringElement(t, i, &element, &len, status);
+    ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+    EXPECT_EQ(data[i], string(element, len));
+  }
+  TF_TensorStringElement(t, 3, &element, &len, status);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status));
+
+  // TF_TensorData still returns the encoded format.
+  Tensor output;
+  ASSERT_TRUE(TF_Tensor_DecodeStrings(t, &output, status));
+  ASSERT_EQ(3, output.NumElements());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(data[i], output.flat<string>()(i));
+  }
+
+  // The elements of an encoded tensor can be read in place too.
+  TF_Tensor* encoded = TF_Tensor_EncodeStrings(output);
+  TF_TensorStringElement(encoded, 2, &element, &len, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  EXPECT_EQ(data[2], string(element, len));
+
+  TF_DeleteTensor(encoded);
+  TF_DeleteTensor(t);
+  TF_DeleteStatus(status);
+}
+
 TEST(CAPI, SessionOptions) {
   TF_SessionOptions* opt = TF_NewSessionOptions();
   TF_DeleteSessionOptions(opt);
@@ -1025,6 +1066,56 @@ TEST(CAPI, Session) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI, SessionCallable) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+
+  // feed + 2
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Output input = {feed, 0};
+  TF_Output output = {add, 0};
+  int64_t handle;
+  TF_SessionMakeCallable(session, nullptr, &input, 1, &output, 1, nullptr, 0,
+                         &handle, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  for (int i = 0; i < 3; ++i) {
+    TF_Tensor* input_value = Int32Tensor(i);
+    TF_Tensor* output_value = nullptr;
+    TF_SessionRunCallable(session, handle, &input_value, 1, &output_value, 1,
+                          nullptr, s);
+    TF_DeleteTensor(input_value);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    ASSERT_TRUE(output_value != nullptr);
+    EXPECT_EQ(TF_INT32, TF_TensorType(output_value));
+    EXPECT_EQ(i + 2, *static_cast<int32*>(TF_TensorData(output_value)));
+    TF_DeleteTensor(output_value);
+  }
+
+  TF_SessionReleaseCallable(session, handle, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_SessionRunCallable(session, handle, nullptr, 0, nullptr, 0, nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 TEST(CAPI, SessionPRun) {
   TF_Status* s = TF_NewStatus();
   TF_Graph* graph = TF_NewGraph();
@@ -30,6 +30,14 @@ constexpr char kSavedModelFilenamePb[] = "saved_model.pb";
 /// SavedModel text format proto filename.
 constexpr char kSavedModelFilenamePbTxt[] = "saved_model.pbtxt";
 
+/// SavedModel extra assets directory, which is not managed by the loader
+/// apart from the warmup requests.
+constexpr char kSavedModelAssetsExtraDirectory[] = "assets.extra";
+
+/// SavedModel warmup requests filename, in the extra assets directory.
+constexpr char kSavedModelWarmupRequestsFilename[] =
+    "saved_model_warmup_requests";
+
 /// SavedModel legacy init op key.
 constexpr char kSavedModelLegacyInitOpKey[] = "legacy_init_op";
 
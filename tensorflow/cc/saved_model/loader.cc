@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/constants.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
@@ -38,9 +39,20 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were succesfully loaded.",
     "model_path");
+auto* load_latency_by_stage = monitoring::Counter<2>::New(
+    "/tensorflow/cc/saved_model/load_latency_by_stage",
+    "Latency in microseconds of each stage of the loading of SavedModels.",
+    "model_path", "stage");
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
 
+uint64 GetLatencyMicroseconds(const uint64 start_microseconds) {
+  const uint64 end_microseconds = Env::Default()->NowMicros();
+  // Avoid clock skew.
+  if (end_microseconds < start_microseconds) return 0;
+  return end_microseconds - start_microseconds;
+}
+
 Status ReadSavedModel(const string& export_dir, SavedModel* saved_model_proto) {
   const string saved_model_pb_path =
       io::JoinPath(export_dir, kSavedModelFilenamePb);
@@ -197,6 +209,75 @@ Status RunLegacyInitOp(const RunOptions& run_options, const string& export_dir,
   return Status::OK();
 }
 
+// Replays the warmup requests stored with the SavedModel, if any, so that the
+// first runs of its signatures happen before the model is loaded.
+Status RunWarmupRequests(const RunOptions& run_options,
+                         const string& export_dir,
+                         const MetaGraphDef& meta_graph_def, Session* session) {
+  const string warmup_requests_path =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                   kSavedModelWarmupRequestsFilename);
+  if (!Env::Default()->FileExists(warmup_requests_path).ok()) {
+    return Status::OK();
+  }
+  LOG(INFO) << "Running warmup requests on SavedModel bundle.";
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(
+      Env::Default()->NewRandomAccessFile(warmup_requests_path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  int num_requests = 0;
+  for (;; ++num_requests) {
+    const Status read_status = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(read_status)) break;
+    TF_RETURN_IF_ERROR(read_status);
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Could not parse warmup request ", num_requests,
+                              " in ", warmup_requests_path);
+    }
+    const auto signature_it =
+        meta_graph_def.signature_def().find(request.signature_name());
+    if (signature_it == meta_graph_def.signature_def().end()) {
+      return errors::InvalidArgument("Warmup request ", num_requests,
+                                     " runs unknown signature '",
+                                     request.signature_name(), "'");
+    }
+    const SignatureDef& signature_def = signature_it->second;
+    std::vector<std::pair<string, Tensor>> inputs;
+    for (const auto& input : request.inputs()) {
+      const auto tensor_info_it = signature_def.inputs().find(input.first);
+      if (tensor_info_it == signature_def.inputs().end()) {
+        return errors::InvalidArgument(
+            "Warmup request ", num_requests, " feeds unknown input '",
+            input.first, "' of signature '", request.signature_name(), "'");
+      }
+      Tensor tensor;
+      if (!tensor.FromProto(input.second)) {
+        return errors::InvalidArgument("Warmup request ", num_requests,
+                                       " has an invalid tensor for input '",
+                                       input.first, "'");
+      }
+      inputs.push_back({tensor_info_it->second.name(), tensor});
+    }
+    std::vector<string> output_tensor_names;
+    for (const auto& output : signature_def.outputs()) {
+      output_tensor_names.push_back(output.second.name());
+    }
+    const uint64 start_microseconds = Env::Default()->NowMicros();
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(session->Run(run_options, inputs, output_tensor_names,
+                                    {}, &outputs, &run_metadata));
+    VLOG(1) << "Warmup request " << num_requests << " of signature '"
+            << request.signature_name() << "' took "
+            << GetLatencyMicroseconds(start_microseconds) << " microseconds.";
+  }
+  LOG(INFO) << "Ran " << num_requests << " warmup requests.";
+  return Status::OK();
+}
+
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs) {
   const auto& collection_def_map = meta_graph_def.collection_def();
@@ -225,6 +306,18 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   }
   LOG(INFO) << "Loading SavedModel from: " << export_dir;
 
+  // Logs and counts the time taken by each stage of the loading.
+  uint64 stage_start_microseconds = Env::Default()->NowMicros();
+  auto end_stage = [&export_dir, &stage_start_microseconds](const char* stage) {
+    const uint64 latency_microseconds =
+        GetLatencyMicroseconds(stage_start_microseconds);
+    LOG(INFO) << "SavedModel load stage " << stage << " took "
+              << latency_microseconds << " microseconds.";
+    load_latency_by_stage->GetCell(export_dir, stage)
+        ->IncrementBy(latency_microseconds);
+    stage_start_microseconds = Env::Default()->NowMicros();
+  };
+
   SavedModel saved_model_proto;
   TF_RETURN_IF_ERROR(ReadSavedModel(export_dir, &saved_model_proto));
 
@@ -233,6 +326,7 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
 
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
+  end_stage("create_session");
 
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(
@@ -242,6 +336,7 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                  bundle->meta_graph_def.saver_def().restore_op_name(),
                  bundle->meta_graph_def.saver_def().filename_tensor_name(),
                  asset_file_defs, bundle->session.get()));
+  end_stage("restore");
   if (HasMainOp(bundle->meta_graph_def)) {
     TF_RETURN_IF_ERROR(RunMainOp(run_options, export_dir,
                                  bundle->meta_graph_def, asset_file_defs,
@@ -251,6 +346,10 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                        bundle->meta_graph_def, asset_file_defs,
                                        bundle->session.get()));
   }
+  end_stage("init");
+  TF_RETURN_IF_ERROR(RunWarmupRequests(
+      run_options, export_dir, bundle->meta_graph_def, bundle->session.get()));
+  end_stage("warmup");
   return Status::OK();
 }
 
@@ -264,12 +363,8 @@ Status LoadSavedModel(const SessionOptions& session_options,
   const uint64 start_microseconds = Env::Default()->NowMicros();
   const Status status = LoadSavedModelInternal(session_options, run_options,
                                                export_dir, tags, bundle);
-  const uint64 load_latency_microsecs = [&]() -> uint64 {
-    const uint64 end_microseconds = Env::Default()->NowMicros();
-    // Avoid clock skew.
-    if (end_microseconds < start_microseconds) return 0;
-    return end_microseconds - start_microseconds;
-  }();
+  const uint64 load_latency_microsecs =
+      GetLatencyMicroseconds(start_microseconds);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "Loading SavedModel: " << status_str << ". Took "
               << load_latency_microsecs << " microseconds.";
@@ -24,7 +24,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
 
 namespace tensorflow {
 namespace {
@@ -91,6 +93,57 @@ class LoaderTest : public ::testing::Test {
         outputs[0],
         test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
   }
+
+  // Copies the half plus two SavedModel to a temporary directory and stores
+  // the given warmup requests with it.
+  string ExportWithWarmupRequests(
+      const string& name,
+      const std::vector<SavedModelWarmupRequest>& requests) {
+    const string src_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+    const string export_dir = io::JoinPath(testing::TmpDir(), name);
+    Env* env = Env::Default();
+    for (const string& dir :
+         {export_dir, io::JoinPath(export_dir, kSavedModelAssetsDirectory),
+          io::JoinPath(export_dir, kSavedModelVariablesDirectory),
+          io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory)}) {
+      TF_CHECK_OK(env->RecursivelyCreateDir(dir));
+    }
+    for (const string& file :
+         {string(kSavedModelFilenamePb),
+          io::JoinPath(kSavedModelAssetsDirectory, "foo.txt"),
+          io::JoinPath(kSavedModelVariablesDirectory, "variables.index"),
+          io::JoinPath(kSavedModelVariablesDirectory,
+                       "variables.data-00000-of-00001")}) {
+      string contents;
+      TF_CHECK_OK(
+          ReadFileToString(env, io::JoinPath(src_dir, file), &contents));
+      TF_CHECK_OK(
+          WriteStringToFile(env, io::JoinPath(export_dir, file), contents));
+    }
+
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(
+        io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                     kSavedModelWarmupRequestsFilename),
+        &file));
+    io::RecordWriter writer(file.get());
+    for (const SavedModelWarmupRequest& request : requests) {
+      TF_CHECK_OK(writer.WriteRecord(request.SerializeAsString()));
+    }
+    TF_CHECK_OK(file->Close());
+    return export_dir;
+  }
+
+  SavedModelWarmupRequest MakeRegressionWarmupRequest(
+      const string& signature_name) {
+    SavedModelWarmupRequest request;
+    request.set_signature_name(signature_name);
+    Tensor input = test::AsTensor<string>(
+        {MakeSerializedExample(0), MakeSerializedExample(1)}, TensorShape({2}));
+    input.AsProtoField(&(*request.mutable_inputs())[kRegressInputs]);
+    return request;
+  }
 };
 
 // Test for resource leaks related to TensorFlow session closing requirements
@@ -179,6 +232,34 @@ TEST_F(LoaderTest, MainOpFormat) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, WarmupRequests) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir = ExportWithWarmupRequests(
+      "warmup_requests", {MakeRegressionWarmupRequest("regress_x_to_y"),
+                          MakeRegressionWarmupRequest("regress_x_to_y")});
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
+TEST_F(LoaderTest, WarmupRequestWithUnknownSignature) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string export_dir = ExportWithWarmupRequests(
+      "warmup_unknown_signature", {MakeRegressionWarmupRequest("missing")});
+  Status st = LoadSavedModel(session_options, run_options, export_dir,
+                             {kSavedModelTagServe}, &bundle);
+  EXPECT_FALSE(st.ok());
+  EXPECT_TRUE(
+      StringPiece(st.error_message()).contains("unknown signature 'missing'"))
+      << st.error_message();
+}
+
 TEST_F(LoaderTest, InvalidExportPath) {
   SavedModelBundle bundle;
   RunOptions run_options;
@@ -59,13 +59,20 @@ bool Coordinator::AllRunnersStopped() {
 }
 
 Status Coordinator::RequestStop() {
-  mutex_lock l(mu_);
-  if (should_stop_) {
-    return Status(error::FAILED_PRECONDITION,
-                  "The Coordinator is not running.");
+  std::vector<std::function<void()>> stop_callbacks;
+  {
+    mutex_lock l(mu_);
+    if (should_stop_) {
+      return Status(error::FAILED_PRECONDITION,
+                    "The Coordinator is not running.");
+    }
+    should_stop_ = true;
+    wait_for_stop_.notify_all();
+    stop_callbacks.swap(stop_callbacks_);
+  }
+  for (const auto& callback : stop_callbacks) {
+    callback();
   }
-  should_stop_ = true;
-  wait_for_stop_.notify_all();
   return Status::OK();
 }
 
@@ -115,6 +122,17 @@ void Coordinator::WaitForStop() {
   }
 }
 
+void Coordinator::RegisterStopCallback(std::function<void()> callback) {
+  {
+    mutex_lock l(mu_);
+    if (!should_stop_) {
+      stop_callbacks_.push_back(std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
 Status Coordinator::ExportCostGraph(CostGraphDef* cost_graph) const {
   mutex_lock l(runners_lock_);
   for (auto& t : runners_) {
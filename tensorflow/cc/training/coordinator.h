@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CC_TRAINING_COORDINATOR_H_
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -106,6 +107,11 @@ class Coordinator {
   /// RequestStop() is called.
   void WaitForStop();
 
+  /// Registers a callback that RequestStop() calls, or calls it right away if
+  /// the coordinator is stopped. Unlike WaitForStop(), this does not hold a
+  /// thread until the stop is requested. The callback should not block.
+  void RegisterStopCallback(std::function<void()> callback);
+
   // Returns the cost graph from stored run metadata in registered runners.
   Status ExportCostGraph(CostGraphDef* cost_graph) const;
 
@@ -115,6 +121,7 @@ class Coordinator {
 
   mutex mu_;
   bool should_stop_ GUARDED_BY(mu_);
+  std::vector<std::function<void()>> stop_callbacks_ GUARDED_BY(mu_);
 
   mutex status_lock_;
   Status status_ GUARDED_BY(status_lock_);
@@ -53,6 +53,23 @@ TEST(CoordinatorTest, TestStopAndWaitOnStop) {
   EXPECT_TRUE(coord.ShouldStop());
 }
 
+TEST(CoordinatorTest, StopCallbacks) {
+  Coordinator coord;
+  int num_calls = 0;
+  coord.RegisterStopCallback([&num_calls]() { ++num_calls; });
+  coord.RegisterStopCallback([&num_calls]() { ++num_calls; });
+  EXPECT_EQ(0, num_calls);
+
+  TF_EXPECT_OK(coord.RequestStop());
+  EXPECT_EQ(2, num_calls);
+  EXPECT_FALSE(coord.RequestStop().ok());
+  EXPECT_EQ(2, num_calls);
+
+  // Callbacks registered after the stop are called right away.
+  coord.RegisterStopCallback([&num_calls]() { ++num_calls; });
+  EXPECT_EQ(3, num_calls);
+}
+
 class MockQueueRunner : public RunnerInterface {
  public:
   MockQueueRunner(Coordinator* coord) {
@@ -15,9 +15,28 @@ limitations under the License.
 
 #include "tensorflow/cc/training/queue_runner.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
+namespace {
+
+auto* enqueue_runs = monitoring::Counter<1>::New(
+    "/tensorflow/cc/queue_runner/enqueue_runs",
+    "The number of runs of the enqueue ops of the QueueRunners of each queue.",
+    "queue");
+
+auto* enqueue_run_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/cc/queue_runner/enqueue_run_usecs",
+     "The time that each run of an enqueue op of the QueueRunners of each "
+     "queue took, including the time that it waited for room in a full queue.",
+     "queue"},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+
+}  // namespace
+
+constexpr Session::CallableHandle QueueRunner::kNoCallable;
 
 Status QueueRunner::New(const QueueRunnerDef& queue_runner_def,
                         std::unique_ptr<QueueRunner>* result) {
@@ -33,6 +52,18 @@ Status QueueRunner::New(const QueueRunnerDef& queue_runner_def,
   return (*result)->Init(queue_runner_def);
 }
 
+Status QueueRunner::New(const QueueRunnerDef& queue_runner_def,
+                        Coordinator* coord, thread::ThreadPool* thread_pool,
+                        std::unique_ptr<QueueRunner>* result) {
+  if (thread_pool == nullptr) {
+    return Status(error::INVALID_ARGUMENT, "The thread pool cannot be null.");
+  }
+  result->reset(new QueueRunner());
+  (*result)->coord_ = coord;
+  (*result)->thread_pool_ = thread_pool;
+  return (*result)->Init(queue_runner_def);
+}
+
 void QueueRunner::AddErrorCallback(const std::function<void(Status)>& cb) {
   mutex_lock l(cb_mu_);
   callbacks_.push_back(cb);
@@ -68,13 +99,16 @@ Status QueueRunner::Init(const QueueRunnerDef& queue_runner_def) {
     }
   }
 
-  int nthreads = runs_;
-  if (coord_) {
-    // One more thread to call Stop()
-    nthreads++;
+  if (thread_pool_ == nullptr) {
+    int nthreads = runs_;
+    if (coord_) {
+      // One more thread to call Stop()
+      nthreads++;
+    }
+    owned_thread_pool_.reset(new thread::ThreadPool(
+        Env::Default(), SanitizeThreadSuffix(queue_name_), nthreads));
+    thread_pool_ = owned_thread_pool_.get();
   }
-  thread_pool_.reset(new thread::ThreadPool(
-      Env::Default(), SanitizeThreadSuffix(queue_name_), nthreads));
 
   return Status::OK();
 }
@@ -95,12 +129,35 @@ Status QueueRunner::StartAndCollectCostGraph(Session* sess,
 
 Status QueueRunner::Start(Session* sess, int wait_for) {
   counter_.reset(new BlockingCounter(runs_));
-  for (const string& enqueue_op : enqueue_op_names_) {
-    thread_pool_->Schedule(
-        std::bind(&QueueRunner::Run, this, sess, enqueue_op));
+  callables_.assign(enqueue_op_names_.size(), kNoCallable);
+  for (size_t i = 0; i < enqueue_op_names_.size(); ++i) {
+    CallableOptions callable_options;
+    callable_options.add_target(enqueue_op_names_[i]);
+    *callable_options.mutable_run_options() = run_options_;
+    // Sessions without callables run the enqueue op with Session::Run().
+    if (!sess->MakeCallable(callable_options, &callables_[i]).ok()) {
+      callables_[i] = kNoCallable;
+    }
   }
-  if (coord_) {
-    thread_pool_->Schedule(std::bind(&QueueRunner::Stop, this, sess));
+  for (size_t i = 0; i < enqueue_op_names_.size(); ++i) {
+    ScheduleRun(sess, i, true);
+  }
+  if (coord_ && owned_thread_pool_) {
+    ScheduleStop(sess);
+  } else if (coord_) {
+    // A shared thread pool cannot spare a thread to wait for the stop.
+    stop_callback_state_ = std::make_shared<StopCallbackState>();
+    {
+      mutex_lock l(stop_callback_state_->mu);
+      stop_callback_state_->runner = this;
+    }
+    std::shared_ptr<StopCallbackState> state = stop_callback_state_;
+    coord_->RegisterStopCallback([state, sess]() {
+      mutex_lock l(state->mu);
+      if (state->runner != nullptr) {
+        state->runner->ScheduleStop(sess);
+      }
+    });
   }
   // Wait for up to 'wait_for' milliseconds.
   if (wait_for > 0) {
@@ -137,11 +194,63 @@ void QueueRunner::Stop(Session* sess) {
 }
 
 Status QueueRunner::Join() {
-  thread_pool_.reset();
+  WaitForClosures();
+  if (stop_callback_state_) {
+    {
+      mutex_lock l(stop_callback_state_->mu);
+      stop_callback_state_->runner = nullptr;
+    }
+    stop_callback_state_.reset();
+    // The stop callback may have scheduled Stop() before it was disabled.
+    WaitForClosures();
+  }
   mutex_lock l(mu_);
   return status_;
 }
 
+void QueueRunner::WaitForClosures() {
+  mutex_lock l(mu_);
+  while (pending_closures_ > 0) {
+    closures_done_.wait(l);
+  }
+}
+
+void QueueRunner::ScheduleRun(Session* sess, int index, bool first_iteration) {
+  {
+    mutex_lock l(mu_);
+    ++pending_closures_;
+  }
+  thread_pool_->Schedule([this, sess, index, first_iteration]() {
+    Run(sess, index, first_iteration);
+    FinishClosure();
+  });
+}
+
+void QueueRunner::ScheduleStop(Session* sess) {
+  {
+    mutex_lock l(mu_);
+    ++pending_closures_;
+  }
+  auto stop = [this, sess]() {
+    Stop(sess);
+    FinishClosure();
+  };
+  if (owned_thread_pool_) {
+    thread_pool_->Schedule(stop);
+  } else {
+    // The threads of a shared pool may all wait in enqueue ops that only the
+    // cancel op unblocks.
+    Env::Default()->SchedClosure(stop);
+  }
+}
+
+void QueueRunner::FinishClosure() {
+  mutex_lock l(mu_);
+  if (--pending_closures_ == 0) {
+    closures_done_.notify_all();
+  }
+}
+
 void QueueRunner::UpdateStatus(const Status& status) {
   {
     mutex_lock l(mu_);
@@ -159,22 +268,28 @@ void QueueRunner::UpdateStatus(const Status& status) {
   }
 }
 
-void QueueRunner::Run(Session* sess, const string& enqueue_op) {
-  bool first_iteration = true;
+void QueueRunner::Run(Session* sess, int index, bool first_iteration) {
   Status status;
-  while (status.ok()) {
-    if (coord_ && coord_->ShouldStop()) {
-      break;
-    }
-    status = RealRun(sess, enqueue_op, true);
+  if (!coord_ || !coord_->ShouldStop()) {
+    status = RunEnqueue(sess, index);
     if (first_iteration) {
       if (!status.ok()) {
         mutex_lock l(mu_);
         enqueue_status_ = status;
       }
       counter_->DecrementCount();
-      first_iteration = false;
     }
+    if (status.ok()) {
+      ScheduleRun(sess, index, false);
+      return;
+    }
+  } else if (first_iteration) {
+    counter_->DecrementCount();
+  }
+
+  if (callables_[index] != kNoCallable) {
+    // The session may have been closed already.
+    sess->ReleaseCallable(callables_[index]).IgnoreError();
   }
   bool last_run = false;
   {
@@ -225,6 +340,29 @@ void QueueRunner::SetRunArgumentsAndCostGraph(const RunOptions* run_options) {
   }
 }
 
+Status QueueRunner::RunEnqueue(Session* sess, int index) {
+  const uint64 start_usecs = Env::Default()->NowMicros();
+  Status s;
+  if (callables_[index] == kNoCallable) {
+    s = RealRun(sess, enqueue_op_names_[index], true);
+  } else if (cg_mu_) {
+    std::vector<Tensor> unused_fetches;
+    RunMetadata metadata;
+    s = sess->RunCallable(callables_[index], {}, &unused_fetches, &metadata);
+    mutex_lock l(*cg_mu_);
+    cost_graph_->Swap(metadata.mutable_cost_graph());
+  } else {
+    std::vector<Tensor> unused_fetches;
+    s = sess->RunCallable(callables_[index], {}, &unused_fetches, nullptr);
+  }
+  if (s.ok()) {
+    enqueue_runs->GetCell(queue_name_)->IncrementBy(1);
+    enqueue_run_usecs->GetCell(queue_name_)
+        ->Add(Env::Default()->NowMicros() - start_usecs);
+  }
+  return s;
+}
+
 Status QueueRunner::RealRun(Session* sess, const string& op,
                             bool update_costs) {
   Status s;
@@ -35,6 +35,14 @@ namespace tensorflow {
 
 /// QueueRunner class imitates the behavior of the python version of QueueRunner
 /// which creates a thread for each enqueue op, runs close op on completion.
+///
+/// Each run of an enqueue op is a separate closure in the thread pool of the
+/// QueueRunner, and runs a callable (see Session::MakeCallable()) when the
+/// session supports them, which avoids looking up the executors of the enqueue
+/// op on every run. Several QueueRunners can share one thread pool, in which
+/// case a run that waits for room in a full queue holds a thread of the pool
+/// while it waits, so the pool should have a thread for each of the enqueue
+/// ops that may wait at the same time.
 class QueueRunner : public RunnerInterface {
  public:
   /// Creates a new QueueRunner from proto.
@@ -47,6 +55,14 @@ class QueueRunner : public RunnerInterface {
   static Status New(const QueueRunnerDef& queue_runner_def, Coordinator* coord,
                     std::unique_ptr<QueueRunner>* result);
 
+  /// Creates a new QueueRunner with a coordinator that runs its enqueue ops in
+  /// `thread_pool` instead of in a thread for each of them. `thread_pool`,
+  /// which may be shared with other QueueRunners, must outlive the
+  /// QueueRunner. `coord` may be nullptr.
+  static Status New(const QueueRunnerDef& queue_runner_def, Coordinator* coord,
+                    thread::ThreadPool* thread_pool,
+                    std::unique_ptr<QueueRunner>* result);
+
   /// Adds a callback that the queue runner will call when it detects an error.
   void AddErrorCallback(const std::function<void(Status)>& cb);
 
@@ -86,13 +102,37 @@ class QueueRunner : public RunnerInterface {
   Status ExportCostGraph(CostGraphDef* cost_graph) const override;
 
  private:
-  QueueRunner() : coord_(nullptr), stopped_(false), cg_mu_(nullptr) {}
+  QueueRunner()
+      : coord_(nullptr),
+        thread_pool_(nullptr),
+        stopped_(false),
+        cg_mu_(nullptr) {}
+
+  // The callables_ entry of an enqueue op that is run with Session::Run().
+  static constexpr Session::CallableHandle kNoCallable = -1;
 
   // Initializes the instance with the QueueRunnerDef proto.
   Status Init(const QueueRunnerDef& queue_runner_def);
 
-  // The Run function for each thread.
-  void Run(Session* sess, const string& enqueue_op);
+  // Schedules a run of enqueue_op_names_[index] in the thread pool.
+  void ScheduleRun(Session* sess, int index, bool first_iteration);
+
+  // Schedules Stop() in the thread pool, or in a thread of its own if the
+  // pool is shared.
+  void ScheduleStop(Session* sess);
+
+  // Runs enqueue_op_names_[index] once, and schedules its next run unless the
+  // run failed or the coordinator is stopping.
+  void Run(Session* sess, int index, bool first_iteration);
+
+  // Marks a closure scheduled by ScheduleRun() or ScheduleStop() as done.
+  void FinishClosure();
+
+  // Blocks until all the scheduled closures are done.
+  void WaitForClosures();
+
+  // Runs enqueue_op_names_[index], with its callable if it has one.
+  Status RunEnqueue(Session* sess, int index);
 
   // Updates the internal status; it only keeps OK or the first unexpected error
   // status.
@@ -116,15 +156,29 @@ class QueueRunner : public RunnerInterface {
   // code::Code casted to int to avoid a hash function.
   std::unordered_set<int> queue_closed_exception_types_;
 
-  std::unique_ptr<thread::ThreadPool> thread_pool_;
+  std::unique_ptr<thread::ThreadPool> owned_thread_pool_;
+  thread::ThreadPool* thread_pool_;
   mutex mu_;
   int runs_ = 0;
+  // The number of scheduled closures that have not finished.
+  int pending_closures_ GUARDED_BY(mu_) = 0;
+  condition_variable closures_done_;
   Status status_ GUARDED_BY(mu_);
   Status enqueue_status_ GUARDED_BY(mu_);
   std::unique_ptr<BlockingCounter> counter_;
+  // The callable of each enqueue op, or kNoCallable.
+  std::vector<Session::CallableHandle> callables_;
 
   Coordinator* coord_;
 
+  // Lets the stop callback registered with coord_ by a QueueRunner with a
+  // shared thread pool outlive the QueueRunner.
+  struct StopCallbackState {
+    mutex mu;
+    QueueRunner* runner GUARDED_BY(mu) = nullptr;
+  };
+  std::shared_ptr<StopCallbackState> stop_callback_state_;
+
   std::atomic<bool> stopped_;
 
   mutex cb_mu_;
@@ -329,6 +329,42 @@ TEST(QueueRunnerTest, TestCoordinatorStop) {
   TF_EXPECT_OK(coord.Join());
 }
 
+TEST(QueueRunnerTest, SharedThreadPool) {
+  auto graph_def = BuildDoubleQueueGraph();
+  SessionOptions options;
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(graph_def));
+
+  QueueRunnerDef queue_runner0 =
+      BuildQueueRunnerDef(kQueueName0, {kEnqueueOp0}, kCloseOp0, kCancelOp0,
+                          {Code::OUT_OF_RANGE, Code::CANCELLED});
+  QueueRunnerDef queue_runner1 =
+      BuildQueueRunnerDef(kQueueName1, {kEnqueueOp1}, kCloseOp1, kCancelOp1,
+                          {Code::OUT_OF_RANGE, Code::CANCELLED});
+
+  // Both runners share two threads, and no thread waits for the stop.
+  thread::ThreadPool thread_pool(Env::Default(), "shared", 2);
+  Coordinator coord;
+  std::unique_ptr<QueueRunner> qr0;
+  TF_EXPECT_OK(QueueRunner::New(queue_runner0, &coord, &thread_pool, &qr0));
+  TF_CHECK_OK(qr0->Start(session.get()));
+  std::unique_ptr<QueueRunner> qr1;
+  TF_EXPECT_OK(QueueRunner::New(queue_runner1, &coord, &thread_pool, &qr1));
+  TF_CHECK_OK(qr1->Start(session.get()));
+
+  TF_EXPECT_OK(coord.RegisterRunner(std::move(qr0)));
+  TF_EXPECT_OK(coord.RegisterRunner(std::move(qr1)));
+
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> dq;
+    TF_EXPECT_OK(session->Run({}, {kDequeueOp1}, {}, &dq));
+    EXPECT_EQ(*dq[0].scalar<int>().data(), 10);
+  }
+
+  TF_EXPECT_OK(coord.RequestStop());
+  TF_EXPECT_OK(coord.Join());
+}
+
 TEST(QueueRunnerTest, CallbackCalledOnError) {
   GraphDef graph_def = BuildSimpleGraph();
   auto session = BuildSessionAndInitVariable(graph_def);
@@ -109,6 +109,40 @@ void DumpStatsToStdout(const Stats& stats) {
   }
 }
 
+std::vector<int> ScalingThreadCounts(int max_threads) {
+  std::vector<int> counts;
+  for (int count = 1; count < max_threads; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(std::max(max_threads, 1));
+  return counts;
+}
+
+void DumpScalingToStdout(const std::vector<ThreadStats>& thread_stats) {
+  if (thread_stats.empty()) {
+    return;
+  }
+  auto mean_us = [](const Stats& stats) {
+    double sum_us = 0;
+    for (const int64 us : stats.per_iter_us) {
+      sum_us += us;
+    }
+    return sum_us / std::max<size_t>(stats.per_iter_us.size(), 1);
+  };
+  const double base_us = mean_us(thread_stats.front().stats);
+  const int base_threads = thread_stats.front().num_threads;
+  printf("Scaling relative to %d thread(s):\n", base_threads);
+  printf("  %8s %14s %8s %11s\n", "Threads", "Mean", "Speedup",
+         "Efficiency");
+  for (const ThreadStats& t : thread_stats) {
+    const double us = mean_us(t.stats);
+    const double speedup = us > 0 ? base_us / us : 0;
+    const double efficiency = speedup * base_threads / t.num_threads;
+    printf("  %8d %11.3f us %7.2fx %10.1f%%\n", t.num_threads, us, speedup,
+           efficiency * 100);
+  }
+}
+
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
   // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
   const int64 max_us = (options.max_micros <= 0 && options.max_iters <= 0)
@@ -56,6 +56,21 @@ struct Stats {
 // form.
 void DumpStatsToStdout(const Stats& stats);
 
+// ThreadStats holds the stats of a benchmark run on num_threads threads.
+struct ThreadStats {
+  int num_threads = 0;
+  Stats stats;
+};
+
+// ScalingThreadCounts returns the thread counts to run a benchmark with to
+// measure its scaling: the powers of two below `max_threads`, followed by
+// `max_threads` itself.
+std::vector<int> ScalingThreadCounts(int max_threads);
+
+// DumpScalingToStdout printfs to stdout the mean time per iteration of each of
+// the `thread_stats`, and its speedup and efficiency relative to the first.
+void DumpScalingToStdout(const std::vector<ThreadStats>& thread_stats);
+
 // BenchmarkFn is the signature of the function generated by tfcompile.
 typedef std::function<void()> BenchmarkFn;
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/aot/benchmark.h"
 
+#include <vector>
+
 #include "tensorflow/compiler/aot/test_graph_tfadd.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -40,6 +42,14 @@ TEST(Benchmark, Benchmark) {
   EXPECT_EQ(stats5.per_iter_us.size(), 5);
 }
 
+TEST(Benchmark, ScalingThreadCounts) {
+  EXPECT_EQ(ScalingThreadCounts(1), std::vector<int>({1}));
+  EXPECT_EQ(ScalingThreadCounts(4), std::vector<int>({1, 2, 4}));
+  EXPECT_EQ(ScalingThreadCounts(6), std::vector<int>({1, 2, 4, 6}));
+  // hardware_concurrency may return 0 if it is unknown.
+  EXPECT_EQ(ScalingThreadCounts(0), std::vector<int>({1}));
+}
+
 }  // namespace
 }  // namespace benchmark
 }  // namespace tfcompile
@@ -390,6 +390,14 @@ extern "C" void {{ENTRY}}(
 // buffers. The AllocMode constructor parameter may be used to modify the
 // buffer allocation strategy.
 //
+// The matrix multiplications and convolutions of the computation run on the
+// threads of the Eigen::ThreadPoolDevice passed to the constructor or to
+// set_thread_pool, which must be set before Run is called:
+//
+//   Eigen::ThreadPool pool(4 /* num_threads */);
+//   Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+//   {{CLASS}} computation(&device);
+//
 // Under the default allocation strategy, this class is thread-compatible:
 //   o Calls to non-const methods require exclusive access to the object.
 //   o Concurrent calls to const methods are OK, if those calls are made while
@@ -434,6 +442,13 @@ class {{CLASS}} {
         TempSizes(), kNumTemps, temps_, true /* annotate_initialized */);
   }
 
+  // Constructs the computation to run on the threads of 'pool', which must
+  // outlive it.
+  explicit {{CLASS}}(const Eigen::ThreadPoolDevice* pool,
+      AllocMode mode = AllocMode::ARGS_RESULTS_AND_TEMPS) : {{CLASS}}(mode) {
+    set_thread_pool(pool);
+  }
+
   ~{{CLASS}}() {
     tensorflow::tfcompile::runtime::FreeContiguous(alloc_args_);
     tensorflow::tfcompile::runtime::FreeContiguous(alloc_temps_);
@@ -106,8 +106,10 @@ void XlaDeviceLaunchOp::Compute(OpKernelContext* ctx) {
       SnapshotResourceVariables(ctx, num_resource_args_);
 
   const XlaCompiler::CompilationResult* kernel;
+  XlaCompilationCache::CompilationRef compilation_ref;
   OP_REQUIRES_OK(ctx, compiler->Compile(function_, num_constant_args_,
-                                        variables, ctx, &kernel, nullptr));
+                                        variables, ctx, &kernel, nullptr,
+                                        &compilation_ref));
 
   VLOG(1) << "XLA compilation complete...";
 
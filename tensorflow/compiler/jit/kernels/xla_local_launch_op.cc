@@ -15,21 +15,34 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/kernels/xla_local_launch_op.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/legacy_flags/xla_launch_op_flags.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_local_runtime_context.h"
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/util/stream_executor_util.h"
@@ -134,8 +147,114 @@ Status XlaAllocator::MakeTensorFromBuffer(gpu::DeviceMemoryBase buffer,
   return Status::OK();
 }
 
+namespace {
+
+// Allocates '*padded' with shape 'padded_shape', copies 'input' into its first
+// rows and zeroes the others. Uses 'stream' to copy device memory if it is
+// non-null.
+Status PadBatchDimension(OpKernelContext* ctx, gpu::Stream* stream,
+                         const Tensor& input, const TensorShape& padded_shape,
+                         Tensor* padded) {
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), padded_shape, padded));
+  const uint64 input_bytes = input.tensor_data().size();
+  const uint64 padding_bytes = padded->tensor_data().size() - input_bytes;
+  char* dst = const_cast<char*>(padded->tensor_data().data());
+  const char* src = input.tensor_data().data();
+  if (stream) {
+    gpu::DeviceMemoryBase gpu_dst(dst, input_bytes);
+    gpu::DeviceMemoryBase gpu_src(const_cast<char*>(src), input_bytes);
+    stream->ThenMemcpy(&gpu_dst, gpu_src, input_bytes);
+    gpu::DeviceMemoryBase gpu_padding(dst + input_bytes, padding_bytes);
+    stream->ThenMemZero(&gpu_padding, padding_bytes);
+  } else {
+    std::memcpy(dst, src, input_bytes);
+    std::memset(dst + input_bytes, 0, padding_bytes);
+  }
+  return Status::OK();
+}
+
+// Returns true if all the outputs of 'kernel' have a batch dimension of size
+// 'padded_batch', so that they can be sliced back to the batch size.
+bool OutputsHaveBatchDimension(const XlaCompiler::CompilationResult& kernel,
+                               int64 padded_batch) {
+  for (const XlaCompiler::OutputDescription& output : kernel.outputs) {
+    const TensorShape& shape =
+        output.is_constant ? output.constant_value.shape() : output.shape;
+    if (shape.dims() == 0 || shape.dim_size(0) != padded_batch) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Saves to the stats collector of 'ctx' the time taken by each instruction of
+// the entry computation of 'executable' recorded in 'profile', along with its
+// cost estimated by HloCostAnalysis, so that the timeline can attribute the
+// time spent in the launch op. The instructions are named "<op>/<instruction>"
+// and laid out one after the other from 'start_micros', in post order.
+void SaveHloExecutionProfile(OpKernelContext* ctx, xla::LocalClient* client,
+                             gpu::Stream* stream,
+                             const xla::Executable& executable,
+                             const xla::HloExecutionProfile& profile,
+                             int64 start_micros) {
+  const xla::Backend& backend = client->backend();
+  gpu::StreamExecutor* executor =
+      stream ? stream->parent() : backend.default_stream_executor();
+  const double clock_rate_ghz =
+      executor->GetDeviceDescription().clock_rate_ghz();
+  if (clock_rate_ghz <= 0) {
+    return;
+  }
+  const xla::HloComputation* computation =
+      executable.module().entry_computation();
+  xla::HloCostAnalysis cost_analysis([&backend](const xla::Shape& shape) {
+    return backend.compiler()->ShapeSizeBytes(shape);
+  });
+  Status status = computation->Accept(&cost_analysis);
+  if (!status.ok()) {
+    VLOG(1) << "Failed to analyze the cost of the HLO profile: " << status;
+    return;
+  }
+
+  int64 offset_micros = 0;
+  for (const xla::HloInstruction* instruction :
+       computation->MakeInstructionPostOrder()) {
+    const uint64 cycles = profile.GetProfileResult(*instruction);
+    if (cycles == 0) {
+      continue;
+    }
+    const int64 micros = cycles / clock_rate_ghz / 1000.0;
+    std::vector<string> operands;
+    for (const xla::HloInstruction* operand : instruction->operands()) {
+      operands.push_back(operand->name());
+    }
+    NodeExecStats* stats = new NodeExecStats;
+    stats->set_node_name(
+        strings::StrCat(ctx->op_kernel().name(), "/", instruction->name()));
+    stats->set_all_start_micros(start_micros + offset_micros);
+    stats->set_op_start_rel_micros(0);
+    stats->set_op_end_rel_micros(micros);
+    stats->set_all_end_rel_micros(micros);
+    // The timeline parses the labels of the form "name = op(inputs)".
+    stats->set_timeline_label(strings::StrCat(
+        instruction->name(), " = ",
+        xla::HloOpcodeString(instruction->opcode()), "(",
+        str_util::Join(operands, ", "), ") cycles: ", cycles,
+        " flops: ", cost_analysis.flop_count(*instruction),
+        " transcendentals: ", cost_analysis.transcendental_count(*instruction),
+        " bytes accessed: ", cost_analysis.bytes_accessed(*instruction)));
+    ctx->stats_collector()->Save(ctx->device()->attributes().name(), stats);
+    offset_micros += micros;
+  }
+}
+
+}  // namespace
+
 XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx), device_type_(ctx->device_type()) {
+    : AsyncOpKernel(ctx),
+      device_type_(ctx->device_type()),
+      async_compilation_(
+          legacy_flags::GetXlaLaunchOpFlags()->tf_xla_async_compilation) {
   const NameAttrList* func;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("function", &func));
   function_ = *func;
@@ -148,6 +267,67 @@ XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
   OP_REQUIRES(ctx, num_resource_args == 0,
               errors::Unimplemented(
                   "XlaLocalLaunchOp does not support resource variables"));
+
+  const string& buckets =
+      legacy_flags::GetXlaLaunchOpFlags()->tf_xla_batch_buckets;
+  if (buckets == "pow2") {
+    pow2_batch_buckets_ = true;
+  } else if (!buckets.empty()) {
+    for (const string& bucket : str_util::Split(buckets, ',')) {
+      int64 size;
+      OP_REQUIRES(ctx, strings::safe_strto64(bucket, &size) && size > 0,
+                  errors::InvalidArgument("Invalid tf_xla_batch_buckets: ",
+                                          buckets));
+      batch_buckets_.push_back(size);
+    }
+    std::sort(batch_buckets_.begin(), batch_buckets_.end());
+  }
+}
+
+int64 XlaLocalLaunchOp::BatchBucket(int64 batch) const {
+  if (pow2_batch_buckets_) {
+    int64 bucket = 1;
+    while (bucket < batch) {
+      bucket <<= 1;
+    }
+    return bucket;
+  }
+  auto it = std::lower_bound(batch_buckets_.begin(), batch_buckets_.end(),
+                             batch);
+  // Batches larger than all the buckets are not padded.
+  return it == batch_buckets_.end() ? batch : *it;
+}
+
+bool XlaLocalLaunchOp::GetPaddedShapes(
+    OpKernelContext* ctx, int64* batch, int64* padded_batch,
+    std::vector<TensorShape>* padded_shapes) const {
+  if (!pow2_batch_buckets_ && batch_buckets_.empty()) {
+    return false;
+  }
+  padded_shapes->clear();
+  for (int i = num_constant_args_; i < ctx->num_inputs(); ++i) {
+    const Tensor& input = ctx->input(i);
+    // Empty inputs are compiled as constants, and strings can't be copied
+    // with memcpy.
+    if (input.dims() == 0 || input.NumElements() == 0 ||
+        !DataTypeCanUseMemcpy(input.dtype()) ||
+        (i > num_constant_args_ && input.dim_size(0) != *batch)) {
+      return false;
+    }
+    *batch = input.dim_size(0);
+    padded_shapes->push_back(input.shape());
+  }
+  if (padded_shapes->empty()) {
+    return false;
+  }
+  *padded_batch = BatchBucket(*batch);
+  if (*padded_batch == *batch) {
+    return false;
+  }
+  for (TensorShape& shape : *padded_shapes) {
+    shape.set_dim(0, *padded_batch);
+  }
+  return true;
 }
 
 Status XlaLocalLaunchOp::BuildCompilationCache(XlaCompilationCache** compiler) {
@@ -180,11 +360,60 @@ Status XlaLocalLaunchOp::BuildCompilationCache(XlaCompilationCache** compiler) {
   options.client = client.ValueOrDie();
   options.allow_cpu_custom_calls = (platform_id == gpu::host::kHostPlatformId);
   options.local_executable_has_hybrid_result = true;
-  *compiler = new XlaCompilationCache(options);
+  *compiler = new XlaCompilationCache(
+      options, legacy_flags::GetXlaLaunchOpFlags()->tf_xla_max_cached_variants);
   return Status::OK();
 }
 
-void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
+void XlaLocalLaunchOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
+  bool compiling = false;
+  Launch(ctx, &compiling);
+  if (compiling) {
+    RunFunction(ctx, std::move(done));
+    return;
+  }
+  done();
+}
+
+void XlaLocalLaunchOp::RunFunction(OpKernelContext* ctx, DoneCallback done) {
+  VLOG(1) << "Running " << function_.name() << " while XLA compiles it";
+  FunctionLibraryRuntime* lib = ctx->function_library();
+  OP_REQUIRES_ASYNC(ctx, lib != nullptr,
+                    errors::Internal("No function library is provided."),
+                    done);
+
+  FunctionLibraryRuntime::Handle handle;
+  OP_REQUIRES_OK_ASYNC(
+      ctx, lib->Instantiate(function_.name(), function_.attr(), &handle), done);
+
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.runner = ctx->runner();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  std::vector<Tensor> args;
+  args.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    args.push_back(ctx->input(i));
+  }
+  std::vector<Tensor>* rets = new std::vector<Tensor>;
+  lib->Run(opts, handle, args, rets, [ctx, done, rets](const Status& status) {
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+    } else if (rets->size() != ctx->num_outputs()) {
+      ctx->SetStatus(errors::Internal("Expected ", ctx->num_outputs(),
+                                      " outputs, but the function returned ",
+                                      rets->size()));
+    } else {
+      for (size_t i = 0; i < rets->size(); ++i) {
+        ctx->set_output(i, (*rets)[i]);
+      }
+    }
+    delete rets;
+    done();
+  });
+}
+
+void XlaLocalLaunchOp::Launch(OpKernelContext* ctx, bool* compiling) {
   VLOG(1) << "XlaLocalLaunchOp::Compute "
           << Canonicalize(function_.name(), function_.attr());
   // We store information about the JIT-compiled XLA computation
@@ -210,8 +439,55 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
 
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
-  OP_REQUIRES_OK(ctx, compiler->Compile(function_, num_constant_args_, {}, ctx,
-                                        &kernel, &executable));
+  XlaCompilationCache::CompilationRef compilation_ref;
+
+  auto compile = [&](const std::vector<TensorShape>* arg_shapes) {
+    if (async_compilation_) {
+      return compiler->CompileAsync(function_, num_constant_args_, {}, ctx,
+                                    &kernel, &executable, &compilation_ref,
+                                    arg_shapes);
+    }
+    return compiler->Compile(function_, num_constant_args_, {}, ctx, &kernel,
+                             &executable, &compilation_ref, arg_shapes);
+  };
+
+  // Compiles for the padded batch size if the computation has a batch
+  // dimension, and for the shapes of the inputs otherwise.
+  int64 batch = 0;
+  int64 padded_batch = 0;
+  std::vector<TensorShape> padded_shapes;
+  if (GetPaddedShapes(ctx, &batch, &padded_batch, &padded_shapes)) {
+    Status status = compile(&padded_shapes);
+    if (status.ok() && kernel == nullptr) {
+      *compiling = true;
+      return;
+    }
+    if (!status.ok()) {
+      VLOG(1) << "Failed to compile for the padded batch: " << status;
+      padded_batch = 0;
+    } else if (!OutputsHaveBatchDimension(*kernel, padded_batch)) {
+      VLOG(1) << "Not padding the batch: some outputs don't have it";
+      padded_batch = 0;
+    }
+  }
+  if (padded_batch == 0) {
+    OP_REQUIRES_OK(ctx, compile(nullptr));
+    if (kernel == nullptr) {
+      *compiling = true;
+      return;
+    }
+  }
+
+  // Pads the non-constant inputs.
+  std::vector<Tensor> padded_inputs;
+  if (padded_batch > 0) {
+    padded_inputs.resize(padded_shapes.size());
+    for (int i = 0; i < padded_shapes.size(); ++i) {
+      OP_REQUIRES_OK(ctx, PadBatchDimension(
+                              ctx, stream, ctx->input(num_constant_args_ + i),
+                              padded_shapes[i], &padded_inputs[i]));
+    }
+  }
 
   VLOG(1) << "Executing XLA Computation...";
 
@@ -232,9 +508,11 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
     for (int i = 0; i < kernel->xla_input_shapes.size(); ++i) {
       int arg_num = kernel->input_mapping[i];
       const xla::Shape& shape = kernel->xla_input_shapes[i];
-      gpu::DeviceMemoryBase dmem(
-          const_cast<char*>(ctx->input(arg_num).tensor_data().data()),
-          ctx->input(arg_num).tensor_data().size());
+      const Tensor& input = padded_batch > 0
+                                ? padded_inputs[arg_num - num_constant_args_]
+                                : ctx->input(arg_num);
+      gpu::DeviceMemoryBase dmem(const_cast<char*>(input.tensor_data().data()),
+                                 input.tensor_data().size());
 
       arg_buffers[i] =
           xla::ShapedBuffer::MakeArrayShapedBuffer(
@@ -263,10 +541,22 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
     run_options.set_inter_op_thread_pool(
         ctx->device()->tensorflow_cpu_worker_threads()->workers);
     run_options.set_intra_op_thread_pool(&ctx->eigen_cpu_device());
+    // Breaks the time of the launch down by instruction if the step is traced
+    // and the executable was compiled with HLO profiling enabled.
+    std::unique_ptr<xla::HloExecutionProfile> hlo_execution_profile;
+    if (ctx->stats_collector() != nullptr &&
+        executable->executable()->hlo_profiling_enabled()) {
+      hlo_execution_profile.reset(new xla::HloExecutionProfile);
+      run_options.set_hlo_execution_profile(hlo_execution_profile.get());
+    }
     Env* env = Env::Default();
     auto start_time = env->NowMicros();
     auto run_result = executable->Run(arg_ptrs, run_options);
     OP_REQUIRES(ctx, run_result.ok(), run_result.status());
+    if (hlo_execution_profile != nullptr) {
+      SaveHloExecutionProfile(ctx, client, stream, *executable->executable(),
+                              *hlo_execution_profile, start_time);
+    }
 
     if (local_runtime_context.error) {
       ctx->CtxFailure(errors::InvalidArgument(
@@ -291,7 +581,10 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   for (int i = 0; i < ctx->num_outputs(); ++i) {
     if (kernel->outputs[i].is_constant) {
       // Output is a constant
-      const Tensor& const_tensor = kernel->outputs[i].constant_value;
+      Tensor const_tensor = kernel->outputs[i].constant_value;
+      if (padded_batch > 0) {
+        const_tensor = const_tensor.Slice(0, batch);
+      }
       const size_t total_bytes = const_tensor.TotalBytes();
       if (stream && total_bytes > 0) {
         // Copy host -> device. (Empty tensors don't have backing buffers.)
@@ -324,6 +617,9 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
       OP_REQUIRES_OK(ctx, xla_allocator.MakeTensorFromBuffer(
                               buffer, ctx->expected_output_dtype(i), shape,
                               &output_tensor));
+      if (padded_batch > 0) {
+        output_tensor = output_tensor.Slice(0, batch);
+      }
       ctx->set_output(i, output_tensor);
       ++output_num;
     }
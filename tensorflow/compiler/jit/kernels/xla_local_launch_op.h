@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 
+#include <vector>
+
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op.h"
@@ -34,20 +36,54 @@ namespace tensorflow {
 // XlaLocalLaunchOp uses xla::LocalClient::Compile() and
 // xla::LocalExecutable::Run(), and passes arguments into/out of XLA in device
 // memory.
-class XlaLocalLaunchOp : public OpKernel {
+//
+// If --tf_xla_batch_buckets is set, the batch dimension of the inputs is
+// padded up to the next bucket, so that one computation is compiled for all
+// the batch sizes in a bucket, and the outputs are sliced back to the batch
+// size. This assumes that the rows of the outputs only depend on the same rows
+// of the inputs, which the caller must guarantee.
+//
+// If --tf_xla_async_compilation is set, computations are compiled on
+// background threads, and the op runs its function with the TensorFlow
+// executor until they have been compiled.
+class XlaLocalLaunchOp : public AsyncOpKernel {
  public:
   explicit XlaLocalLaunchOp(OpKernelConstruction* ctx);
   ~XlaLocalLaunchOp() override;
 
-  void Compute(OpKernelContext* ctx) override;
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
+  // Compiles and runs the computation for the inputs of 'ctx'. Sets
+  // '*compiling' instead if it is being compiled in the background.
+  void Launch(OpKernelContext* ctx, bool* compiling);
+
+  // Runs the function of the op without XLA.
+  void RunFunction(OpKernelContext* ctx, DoneCallback done);
+
   // Builds a XlaCompilationCache class suitable for the current device.
   Status BuildCompilationCache(XlaCompilationCache** compiler);
 
+  // Returns the size the batch dimension 'batch' is padded to.
+  int64 BatchBucket(int64 batch) const;
+
+  // Returns true if the non-constant inputs of 'ctx' share a batch dimension
+  // that must be padded. If so, sets '*batch' to its size, '*padded_batch' to
+  // the size it is padded to and '*padded_shapes' to the padded shapes of the
+  // inputs.
+  bool GetPaddedShapes(OpKernelContext* ctx, int64* batch, int64* padded_batch,
+                       std::vector<TensorShape>* padded_shapes) const;
+
   DeviceType device_type_;
   NameAttrList function_;
   int num_constant_args_;
+  const bool async_compilation_;
+
+  // The sizes the batch dimension is padded to, in increasing order, unless
+  // pow2_batch_buckets_ pads it to powers of two.
+  std::vector<int64> batch_buckets_;
+  bool pow2_batch_buckets_ = false;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaLocalLaunchOp);
 };
 
@@ -0,0 +1,76 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Legacy flags for the XLA bridge's xla_launch_op module.
+
+#include <mutex>
+#include <vector>
+
+#include "tensorflow/compiler/jit/legacy_flags/xla_launch_op_flags.h"
+#include "tensorflow/compiler/xla/legacy_flags/parse_flags_from_env.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace legacy_flags {
+
+// Pointers to the parsed value of the flags and flag descriptors, initialized
+// via flags_init.
+static XlaLaunchOpFlags* flags;
+static std::vector<Flag>* flag_list;
+static std::once_flag flags_init;
+
+// Allocate *flags.  Called via call_once(&flags_init,...).
+static void AllocateFlags() {
+  flags = new XlaLaunchOpFlags;
+  flags->tf_xla_batch_buckets = "";
+  flags->tf_xla_max_cached_variants = 0;
+  flags->tf_xla_async_compilation = false;
+  flag_list = new std::vector<Flag>({
+      Flag("tf_xla_batch_buckets", &flags->tf_xla_batch_buckets,
+           "If non-empty, the batch dimension of the inputs of a cluster is "
+           "padded up to the next bucket, and its outputs are sliced back, "
+           "so that fewer batch sizes are compiled. Either \"pow2\" for "
+           "powers of two, or a comma-separated list of sizes. Only valid "
+           "for clusters whose rows are computed independently."),
+      Flag("tf_xla_max_cached_variants", &flags->tf_xla_max_cached_variants,
+           "Maximum number of compilations cached per cluster. The least "
+           "recently used one is evicted when it is exceeded. 0 means "
+           "unbounded."),
+      Flag("tf_xla_async_compilation", &flags->tf_xla_async_compilation,
+           "Compile clusters on background threads, and run their "
+           "TensorFlow functions until they are compiled, so that steps "
+           "don't wait for the compilation."),
+  });
+  xla::legacy_flags::ParseFlagsFromEnv(*flag_list);
+}
+
+// Append to *append_to flag definitions associated with the XLA bridge's
+// xla_launch_op module.
+void AppendXlaLaunchOpFlags(std::vector<Flag>* append_to) {
+  std::call_once(flags_init, &AllocateFlags);
+  append_to->insert(append_to->end(), flag_list->begin(), flag_list->end());
+}
+
+// Return a pointer to the XlaLaunchOpFlags struct;
+// repeated calls return the same pointer.
+// This should be called only after Flags::Parse() has returned.
+XlaLaunchOpFlags* GetXlaLaunchOpFlags() {
+  std::call_once(flags_init, &AllocateFlags);
+  return flags;
+}
+
+}  // namespace legacy_flags
+}  // namespace tensorflow
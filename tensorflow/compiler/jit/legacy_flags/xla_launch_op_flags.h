@@ -0,0 +1,53 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_LEGACY_FLAGS_XLA_LAUNCH_OP_FLAGS_H_
+#define TENSORFLOW_COMPILER_JIT_LEGACY_FLAGS_XLA_LAUNCH_OP_FLAGS_H_
+
+// Legacy flags for the XLA bridge's xla_launch_op module.
+
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace legacy_flags {
+
+// Append to *flag_list flag definitions associated with the XLA bridge's
+// xla_launch_op module.
+void AppendXlaLaunchOpFlags(std::vector<tensorflow::Flag>* flag_list);
+
+// The values of flags associated with the XLA bridge's
+// xla_launch_op module.
+typedef struct {
+  string tf_xla_batch_buckets;  // Sizes the batch dimension of the inputs of
+                                // a cluster is padded to: empty, "pow2" or a
+                                // comma-separated list of sizes.
+  int32 tf_xla_max_cached_variants;  // Maximum number of compilations cached
+                                     // per cluster; 0 means unbounded.
+  bool tf_xla_async_compilation;  // Compile clusters in the background, and
+                                  // run them without XLA meanwhile.
+} XlaLaunchOpFlags;
+
+// Return a pointer to the XlaLaunchOpFlags struct;
+// repeated calls return the same pointer.
+// This should be called only after Flags::Parse() has returned.
+XlaLaunchOpFlags* GetXlaLaunchOpFlags();
+
+}  // namespace legacy_flags
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_LEGACY_FLAGS_XLA_LAUNCH_OP_FLAGS_H_
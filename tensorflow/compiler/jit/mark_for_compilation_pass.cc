@@ -325,7 +325,10 @@ Status MarkForCompilationPass::Run(
     // Otherwise use the value of global_jit_level.
     return registration->enable_jit_by_default && global_jit_level > 0;
   };
-  return RunImpl(options, is_compilable);
+  // ON_1 is meant to compile only what is very likely to be improved.
+  return RunImpl(options, is_compilable,
+                 /*only_profitable_clusters=*/global_jit_level ==
+                     OptimizerOptions::ON_1);
 }
 
 // Is 'node' an operator that consumes only the shape of its input, not the
@@ -335,13 +338,66 @@ static bool IsShapeConsumerOp(const Node& node) {
          node.type_string() == "Size";
 }
 
+// Is 'node' an operator that XLA implements with the same library call
+// (Eigen, cuBLAS or cuDNN) as the TensorFlow kernel? Compiling these gains
+// nothing by itself, and they are too expensive to fuse their neighbours into.
+static bool IsLibraryCallOp(const Node& node) {
+  static const std::unordered_set<string>* const kLibraryCallOps =
+      new std::unordered_set<string>({
+          "BatchMatMul", "Conv2D", "Conv2DBackpropFilter",
+          "Conv2DBackpropInput", "Conv3D", "Conv3DBackpropFilterV2",
+          "Conv3DBackpropInputV2", "DepthwiseConv2dNative",
+          "DepthwiseConv2dNativeBackpropFilter",
+          "DepthwiseConv2dNativeBackpropInput", "MatMul",
+      });
+  return kLibraryCallOps->count(node.type_string()) > 0;
+}
+
+// Is 'node' an operator that does no computation once compiled, and so does
+// not make a cluster any more profitable?
+static bool IsFreeOp(const Node& node) {
+  static const std::unordered_set<string>* const kFreeOps =
+      new std::unordered_set<string>({
+          "Const", "ExpandDims", "Identity", "PreventGradient", "Reshape",
+          "Snapshot", "Squeeze", "StopGradient",
+      });
+  return IsShapeConsumerOp(node) || kFreeOps->count(node.type_string()) > 0;
+}
+
+// Is 'node' explicitly marked for compilation with _XlaCompile=true, either
+// itself or through the function it calls?
+static bool IsMarkedForCompilation(const Node& node,
+                                   const FunctionLibraryDefinition* flib_def) {
+  bool compile = false;
+  if (GetNodeAttr(node.def(), kXlaCompileAttr, &compile).ok()) {
+    return compile;
+  }
+  if (flib_def->GetAttr(node.def(), kXlaCompileAttr, &compile).ok()) {
+    return compile;
+  }
+  return false;
+}
+
+// Does 'node' have to be compiled because it is placed on a device that
+// requires compilation?
+static Status RequiresCompilation(const Node& node, bool* requires) {
+  DeviceType device_type("");
+  TF_RETURN_IF_ERROR(
+      DeviceTypeOfDevice(node.assigned_device_name(), &device_type));
+  const XlaOpRegistry::DeviceRegistration* registration;
+  XlaOpRegistry::GetCompilationDevice(device_type.type(), &registration);
+  *requires = registration->requires_compilation;
+  return Status::OK();
+}
+
 // Sequence number generator to ensure clusters have unique names.
 static std::atomic<int64> cluster_sequence_num;
 
 Status MarkForCompilationPass::RunImpl(
     const GraphOptimizationPassOptions& options,
     const std::function<bool(const Node*, const DeviceType&)>&
-        is_compilable_fn) {
+        is_compilable_fn,
+    bool only_profitable_clusters) {
   VLOG(1) << "MarkForCompilationPass::Run";
 
   // Make sure that kernels have been registered on the JIT device.
@@ -356,6 +412,24 @@ Status MarkForCompilationPass::RunImpl(
                                            : Env::Default(),
       is_compilable_fn, &compilation_candidates));
 
+  // Leaving library calls out of the candidates splits clusters at them.
+  if (only_profitable_clusters) {
+    for (auto it = compilation_candidates.begin();
+         it != compilation_candidates.end();) {
+      Node* node = *it;
+      bool requires_compilation;
+      TF_RETURN_IF_ERROR(RequiresCompilation(*node, &requires_compilation));
+      if (IsLibraryCallOp(*node) && !requires_compilation &&
+          !IsMarkedForCompilation(*node, options.flib_def)) {
+        VLOG(2) << "Compilation rejected node: library call " << node->name()
+                << ": " << node->def().op();
+        it = compilation_candidates.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
   GraphCycles cycles;
   for (int i = 0; i < graph->num_node_ids(); ++i) {
     // We rely on the node IDs in the cycle detection graph being consecutive
@@ -519,6 +593,7 @@ Status MarkForCompilationPass::RunImpl(
   // Count the number of elements in each cluster.
   std::vector<int> cluster_sizes(graph->num_node_ids());
   for (const Node* n : compilation_candidates) {
+    if (only_profitable_clusters && IsFreeOp(*n)) continue;
     int cluster = clusters[n->id()].GetRepresentative();
     cluster_sizes[cluster]++;
   }
@@ -536,28 +611,17 @@ Status MarkForCompilationPass::RunImpl(
     int cluster = clusters[n->id()].GetRepresentative();
 
     // Compile if the user marked this node _XlaCompile=true
-    bool compile_attr = false;
-    bool marked_for_compilation = false;
-    if (GetNodeAttr(n->def(), kXlaCompileAttr, &compile_attr).ok()) {
-      marked_for_compilation = compile_attr;
-    } else if (options.flib_def
-                   ->GetAttr(n->def(), kXlaCompileAttr, &compile_attr)
-                   .ok()) {
-      marked_for_compilation = compile_attr;
-    }
+    bool marked_for_compilation = IsMarkedForCompilation(*n, options.flib_def);
 
     // Compile if this operator is placed on a device that requires
     // compilation.
-    DeviceType device_type("");
-    TF_RETURN_IF_ERROR(
-        DeviceTypeOfDevice(n->assigned_device_name(), &device_type));
-    const XlaOpRegistry::DeviceRegistration* registration;
-    XlaOpRegistry::GetCompilationDevice(device_type.type(), &registration);
+    bool requires_compilation;
+    TF_RETURN_IF_ERROR(RequiresCompilation(*n, &requires_compilation));
 
     // Or compile if this is a cluster of >= min_cluster_size compilable
     // operators.
     if (cluster_sizes[cluster] >= min_cluster_size || marked_for_compilation ||
-        registration->requires_compilation) {
+        requires_compilation) {
       string& name = cluster_names[cluster];
       if (name.empty()) {
         name = strings::StrCat("cluster_", cluster_sequence_num++);
@@ -40,9 +40,16 @@ class MarkForCompilationPass : public GraphOptimizationPass {
   // unconditionally, call RunImpl() directly.
   // is_compilable_fn, if set, is a predicate that must be true for a node to
   // be compiled.
+  // If only_profitable_clusters is true, clusters that are unlikely to run
+  // faster than the TensorFlow kernels they replace are left alone: operators
+  // that XLA implements with the same library calls as TensorFlow (e.g.
+  // convolutions) are not clustered unless explicitly marked for compilation,
+  // and operators that do no computation (e.g. Identity) do not count towards
+  // --tf_xla_min_cluster_size.
   Status RunImpl(const GraphOptimizationPassOptions& options,
                  const std::function<bool(const Node*, const DeviceType&)>&
-                     is_compilable_fn = {});
+                     is_compilable_fn = {},
+                 bool only_profitable_clusters = false);
 };
 
 // Returns true iff 'ndef' is a call to a function that is compilable.  A
@@ -33,7 +33,8 @@ REGISTER_OP("UncompilableNullary").Output("o: float");
 REGISTER_OP("UncompilableUnary").Input("a: float").Output("o: float");
 
 void MarkForCompilation(std::unique_ptr<Graph>* graph,
-                        FunctionLibraryDefinition* flib_def) {
+                        FunctionLibraryDefinition* flib_def,
+                        bool only_profitable_clusters = false) {
   // Assign all nodes to the CPU device.
   static const char* kCpuDevice = "/job:localhost/replica:0/task:0/cpu:0";
   for (Node* n : (*graph)->nodes()) {
@@ -44,13 +45,16 @@ void MarkForCompilation(std::unique_ptr<Graph>* graph,
   opt_options.graph = graph;
   opt_options.flib_def = flib_def;
   MarkForCompilationPass pass;
-  CHECK(pass.RunImpl(opt_options).ok());
+  CHECK(pass.RunImpl(opt_options, /*is_compilable_fn=*/{},
+                     only_profitable_clusters)
+            .ok());
 }
 
-void MarkForCompilation(std::unique_ptr<Graph>* graph) {
+void MarkForCompilation(std::unique_ptr<Graph>* graph,
+                        bool only_profitable_clusters = false) {
   FunctionDefLibrary flib;
   FunctionLibraryDefinition flib_def((*graph)->op_registry(), flib);
-  MarkForCompilation(graph, &flib_def);
+  MarkForCompilation(graph, &flib_def, only_profitable_clusters);
 }
 
 std::unordered_map<string, string> GetClusters(const Graph& graph) {
@@ -455,5 +459,64 @@ TEST(XlaCompilationTest, CyclesWithDifferentScopesAndBridge) {
   EXPECT_EQ(clusters["B"], clusters["C"]);
 }
 
+TEST(XlaCompilationTest, ProfitableClustersSplitAtLibraryCalls) {
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  GraphDef graphdef;
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* a = ops::SourceOp("Const", builder.opts()
+                                         .WithName("A")
+                                         .WithAttr("dtype", DT_FLOAT)
+                                         .WithAttr("value", Tensor()));
+    Node* b = ops::UnaryOp("Relu", a, builder.opts().WithName("B"));
+    Node* c = ops::UnaryOp("Relu", b, builder.opts().WithName("C"));
+    Node* d = ops::BinaryOp("MatMul", c, c, builder.opts().WithName("D"));
+    Node* e = ops::UnaryOp("Relu", d, builder.opts().WithName("E"));
+    Node* f = ops::UnaryOp("Relu", e, builder.opts().WithName("F"));
+    ops::BinaryOp("MatMul", f, f,
+                  builder.opts().WithName("G").WithAttr(kXlaCompileAttr, true));
+    TF_EXPECT_OK(builder.ToGraph(graph.get()));
+  }
+
+  MarkForCompilation(&graph, /*only_profitable_clusters=*/true);
+  auto clusters = GetClusters(*graph);
+
+  // D is left to TensorFlow, splitting the chain in two, but G is compiled as
+  // it is explicitly marked for compilation.
+  EXPECT_EQ(6, clusters.size());
+  EXPECT_TRUE(clusters.find("D") == clusters.cend());
+  EXPECT_EQ(clusters["A"], clusters["B"]);
+  EXPECT_EQ(clusters["A"], clusters["C"]);
+  EXPECT_EQ(clusters["E"], clusters["F"]);
+  EXPECT_EQ(clusters["E"], clusters["G"]);
+  EXPECT_NE(clusters["A"], clusters["E"]);
+}
+
+TEST(XlaCompilationTest, ProfitableClustersIgnoreFreeOps) {
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  GraphDef graphdef;
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* a =
+        ops::SourceOp("UncompilableNullary", builder.opts().WithName("A"));
+    Node* b = ops::UnaryOp("Identity", a, builder.opts().WithName("B"));
+    Node* c = ops::UnaryOp("Relu", b, builder.opts().WithName("C"));
+    Node* d =
+        ops::UnaryOp("UncompilableUnary", c, builder.opts().WithName("D"));
+    Node* e = ops::UnaryOp("Relu", d, builder.opts().WithName("E"));
+    ops::UnaryOp("Relu", e, builder.opts().WithName("F"));
+    TF_EXPECT_OK(builder.ToGraph(graph.get()));
+  }
+
+  MarkForCompilation(&graph, /*only_profitable_clusters=*/true);
+  auto clusters = GetClusters(*graph);
+
+  // {B, C} does a single Relu, which is not worth compiling.
+  EXPECT_EQ(2, clusters.size());
+  EXPECT_EQ(clusters["E"], clusters["F"]);
+  EXPECT_TRUE(clusters.find("B") == clusters.cend());
+  EXPECT_TRUE(clusters.find("C") == clusters.cend());
+}
+
 }  // namespace
 }  // namespace tensorflow
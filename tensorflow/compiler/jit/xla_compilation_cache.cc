@@ -31,14 +31,34 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 
-XlaCompilationCache::XlaCompilationCache(const XlaCompiler::Options& options)
-    : compiler_(options) {}
+namespace {
+
+// The number of threads running the compilations started by CompileAsync.
+constexpr int kNumAsyncCompilationThreads = 4;
+
+thread::ThreadPool* AsyncCompilationThreads() {
+  static thread::ThreadPool* threads = new thread::ThreadPool(
+      Env::Default(), "xla_async_compilation", kNumAsyncCompilationThreads);
+  return threads;
+}
+
+auto* xla_compilation_cache_evictions = monitoring::Counter<0>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache_evictions",
+    "The number of computations evicted from the XLA compilation cache.");
+
+}  // namespace
+
+XlaCompilationCache::XlaCompilationCache(const XlaCompiler::Options& options,
+                                         int max_variants_per_function)
+    : compiler_(options),
+      max_variants_per_function_(max_variants_per_function) {}
 
 XlaCompilationCache::~XlaCompilationCache() = default;
 
@@ -94,7 +114,7 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
 Status XlaCompilationCache::BuildSignature(
     const NameAttrList& function, int num_constant_args,
     const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
-    Signature* signature) {
+    const std::vector<TensorShape>* arg_shapes, Signature* signature) {
   signature->name = Canonicalize(function.name(), function.attr());
   signature->arg_values.resize(num_constant_args);
 
@@ -109,8 +129,10 @@ Status XlaCompilationCache::BuildSignature(
   }
   // Add the types and shapes of the remaining arguments.
   while (input_num < ctx->num_inputs() - variable_args.size()) {
-    signature->arg_types.emplace_back(ctx->input_dtype(input_num),
-                                      ctx->input(input_num).shape());
+    signature->arg_types.emplace_back(
+        ctx->input_dtype(input_num),
+        arg_shapes ? (*arg_shapes)[input_num - num_constant_args]
+                   : ctx->input(input_num).shape());
     ++input_num;
   }
   // For variable signatures, use the type and shape of the variable's
@@ -132,9 +154,12 @@ namespace {
 
 // Builds a XlaCompiler::Argument vector from the arguments to the _XlaLaunch
 // op. The first `num_constant_args` arguments must be host-memory Tensors.
+// If `arg_shapes` is non-null, it overrides the shapes of the non-constant
+// arguments.
 Status BuildArguments(int num_constant_args,
                       const std::vector<OptionalTensor>& variable_args,
                       OpKernelContext* ctx,
+                      const std::vector<TensorShape>* arg_shapes,
                       std::vector<XlaCompiler::Argument>* args) {
   args->resize(ctx->num_inputs());
 
@@ -169,7 +194,8 @@ Status BuildArguments(int num_constant_args,
       arg.constant_value = input;
     }
     arg.type = input.dtype();
-    arg.shape = input.shape();
+    arg.shape = arg_shapes ? (*arg_shapes)[input_num - num_constant_args]
+                           : input.shape();
     ++input_num;
   }
 
@@ -204,11 +230,30 @@ Status BuildArguments(int num_constant_args,
 
 }  // namespace
 
+void XlaCompilationCache::UpdateVariants(const Signature& signature,
+                                         bool inserted, Entry* entry) {
+  std::list<Signature>& variants = variants_[signature.name];
+  if (inserted) {
+    variants.push_front(signature);
+    entry->lru_position = variants.begin();
+  } else {
+    variants.splice(variants.begin(), variants, entry->lru_position);
+  }
+  while (variants.size() > static_cast<size_t>(max_variants_per_function_)) {
+    // Callers still using the evicted entry hold references to it.
+    VLOG(1) << "Evicting " << SignatureDebugString(variants.back());
+    cache_.erase(variants.back());
+    variants.pop_back();
+    xla_compilation_cache_evictions->GetCell()->IncrementBy(1);
+  }
+}
+
 Status XlaCompilationCache::Compile(
     const NameAttrList& function, int num_constant_args,
     const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable, CompilationRef* compilation_ref,
+    const std::vector<TensorShape>* arg_shapes) {
   VLOG(1) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
@@ -232,46 +277,20 @@ Status XlaCompilationCache::Compile(
     }
   }
 
-  TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
-
-  Signature signature;
-  TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
-                                    ctx, &signature));
-
-  VLOG(2) << "Signature: " << SignatureDebugString(signature);
-  // The outer lock protects the existence of the cache entry. It does not
-  // protect the contents of the cache entry.
-  Entry* entry;
-  {
-    mutex_lock lock(mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
-    if (!e) {
-      e.reset(new Entry);
-    }
-    entry = e.get();
-  }
+  std::shared_ptr<Entry> entry;
+  TF_RETURN_IF_ERROR(LookupEntry(function, num_constant_args, variable_args,
+                                 ctx, arg_shapes, &entry));
+  *compilation_ref = entry;
 
   // Acquire the cache entry lock and compile, if necessary.
-  // TODO(phawkins): this locking will need to be restructured when we implement
-  // cache eviction.
   mutex_lock entry_lock(entry->mu);
   if (!entry->compiled) {
-    // Do the actual JIT compilation without holding the lock (it can take
-    // a long time.)
     std::vector<XlaCompiler::Argument> args;
-    TF_RETURN_IF_ERROR(
-        BuildArguments(num_constant_args, variable_args, ctx, &args));
-
-    std::unique_ptr<FunctionLibraryRuntime> flr(NewFunctionLibraryRuntime(
-        compiler_.device_mgr(), ctx->env(), compiler_.device(),
-        TF_GRAPH_DEF_VERSION,
-        ctx->function_library()->GetFunctionLibraryDefinition(),
-        OptimizerOptions(), nullptr /* custom_kernel_creator */));
-
-    entry->compiled = true;
-    entry->compilation_status = compiler_.CompileFunction(
-        flr.get(), function, args, &entry->compilation_result);
+    TF_RETURN_IF_ERROR(BuildArguments(num_constant_args, variable_args, ctx,
+                                      arg_shapes, &args));
+    CompileEntry(function, args, ctx->env(),
+                 ctx->function_library()->GetFunctionLibraryDefinition(),
+                 entry.get());
   }
   *compilation_result = &entry->compilation_result;
   if (entry->compilation_status.ok() && executable) {
@@ -287,4 +306,117 @@ Status XlaCompilationCache::Compile(
   return status;
 }
 
+Status XlaCompilationCache::CompileAsync(
+    const NameAttrList& function, int num_constant_args,
+    const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable, CompilationRef* compilation_ref,
+    const std::vector<TensorShape>* arg_shapes) {
+  VLOG(1) << "XlaCompilationCache::CompileAsync " << DebugString();
+  *compilation_result = nullptr;
+  *executable = nullptr;
+
+  std::shared_ptr<Entry> entry;
+  TF_RETURN_IF_ERROR(LookupEntry(function, num_constant_args, variable_args,
+                                 ctx, arg_shapes, &entry));
+  *compilation_ref = entry;
+
+  bool start = false;
+  {
+    mutex_lock lock(mu_);
+    if (!entry->async_compilation_started) {
+      entry->async_compilation_started = true;
+      start = true;
+    } else if (!entry->async_compilation_done) {
+      return Status::OK();
+    }
+  }
+
+  if (start) {
+    std::vector<XlaCompiler::Argument> args;
+    TF_RETURN_IF_ERROR(BuildArguments(num_constant_args, variable_args, ctx,
+                                      arg_shapes, &args));
+    // The compilation may outlive the step, and the function library of the
+    // step along with it.
+    std::shared_ptr<FunctionLibraryDefinition> flib_def =
+        std::make_shared<FunctionLibraryDefinition>(
+            *ctx->function_library()->GetFunctionLibraryDefinition());
+    Env* env = ctx->env();
+    Ref();
+    AsyncCompilationThreads()->Schedule(
+        [this, function, args, env, flib_def, entry]() {
+          {
+            mutex_lock entry_lock(entry->mu);
+            if (!entry->compiled) {
+              CompileEntry(function, args, env, flib_def.get(), entry.get());
+            }
+            if (entry->compilation_status.ok() &&
+                entry->executable == nullptr &&
+                !entry->compilation_result.computation.IsNull()) {
+              entry->compilation_status = compiler_.BuildExecutable(
+                  entry->compilation_result, &entry->executable);
+            }
+          }
+          {
+            mutex_lock lock(mu_);
+            entry->async_compilation_done = true;
+          }
+          Unref();
+        });
+    return Status::OK();
+  }
+
+  // The compilation is done, so this doesn't wait for the entry lock.
+  mutex_lock entry_lock(entry->mu);
+  *compilation_result = &entry->compilation_result;
+  *executable = entry->executable.get();
+  Status status = entry->compilation_status;
+  return status;
+}
+
+Status XlaCompilationCache::LookupEntry(
+    const NameAttrList& function, int num_constant_args,
+    const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
+    const std::vector<TensorShape>* arg_shapes,
+    std::shared_ptr<Entry>* entry) {
+  TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+  TF_RET_CHECK(arg_shapes == nullptr ||
+               arg_shapes->size() + num_constant_args + variable_args.size() ==
+                   ctx->num_inputs());
+
+  Signature signature;
+  TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
+                                    ctx, arg_shapes, &signature));
+
+  VLOG(2) << "Signature: " << SignatureDebugString(signature);
+  // The outer lock protects the existence of the cache entry. It does not
+  // protect the contents of the cache entry.
+  // The entry stays alive while we hold a reference, even if it is evicted.
+  mutex_lock lock(mu_);
+  // Find or create a cache entry.
+  std::shared_ptr<Entry>& e = cache_[signature];
+  const bool inserted = !e;
+  if (inserted) {
+    e = std::make_shared<Entry>();
+  }
+  *entry = e;
+  if (max_variants_per_function_ > 0) {
+    UpdateVariants(signature, inserted, entry->get());
+  }
+  return Status::OK();
+}
+
+void XlaCompilationCache::CompileEntry(
+    const NameAttrList& function,
+    const std::vector<XlaCompiler::Argument>& args, Env* env,
+    const FunctionLibraryDefinition* flib_def, Entry* entry) {
+  std::unique_ptr<FunctionLibraryRuntime> flr(NewFunctionLibraryRuntime(
+      compiler_.device_mgr(), env, compiler_.device(), TF_GRAPH_DEF_VERSION,
+      flib_def, OptimizerOptions(), nullptr /* custom_kernel_creator */));
+
+  entry->compiled = true;
+  entry->compilation_status = compiler_.CompileFunction(
+      flr.get(), function, args, &entry->compilation_result);
+}
+
 }  // namespace tensorflow
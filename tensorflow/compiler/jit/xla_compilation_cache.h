@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 #define TENSORFLOW_COMPILER_JIT_XLA_COMPILATION_CACHE_H_
 
+#include <list>
+#include <memory>
+
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -42,13 +45,19 @@ struct OptionalTensor {
 // Since XLA computations must have static shapes, the cache generates a new
 // XLA computation for each new set of input shapes.
 //
-// Currently no cache eviction policy is implemented and the cache grows without
-// bound.
+// If `max_variants_per_function` is positive, at most that many computations
+// are cached for each function, and the least recently used one is evicted
+// when a new one is compiled. Otherwise the cache grows without bound.
 class XlaCompilationCache : public ResourceBase {
  public:
-  explicit XlaCompilationCache(const XlaCompiler::Options& options);
+  explicit XlaCompilationCache(const XlaCompiler::Options& options,
+                               int max_variants_per_function = 0);
   ~XlaCompilationCache() override;
 
+  // Keeps the outputs of a compilation alive while the caller uses them, even
+  // if the cache evicts the compilation meanwhile.
+  typedef std::shared_ptr<const void> CompilationRef;
+
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
   // to execute an XLA Computation. Compilation results are cached.
   // `function` is the name of a Tensorflow function to compile.
@@ -60,12 +69,31 @@ class XlaCompilationCache : public ResourceBase {
   // be non-null. If `executable` is non-null, also builds an
   // xla::LocalExecutable and sets `executable to point to it. The resulting
   // executable pointer may be null if the computation has no non-constant
-  // outputs.
+  // outputs. `*compilation_ref` must be held while `*compilation_result` and
+  // `*executable` are used.
+  // If `arg_shapes` is non-null, it holds the shapes to compile the
+  // non-constant, non-variable arguments for, in order, instead of the shapes
+  // of the inputs of `ctx`, e.g. with a padded batch dimension.
   Status Compile(const NameAttrList& function, int num_constant_args,
                  const std::vector<OptionalTensor>& variable_args,
                  OpKernelContext* ctx,
                  const XlaCompiler::CompilationResult** compilation_result,
-                 xla::LocalExecutable** executable);
+                 xla::LocalExecutable** executable,
+                 CompilationRef* compilation_ref,
+                 const std::vector<TensorShape>* arg_shapes = nullptr);
+
+  // Like Compile, but doesn't wait for the compilation. The first call for a
+  // new signature starts compiling it on a background thread, along with its
+  // executable. Until that is done, sets `*compilation_result` and
+  // `*executable` to nullptr, and the caller is expected to run `function`
+  // without XLA.
+  Status CompileAsync(const NameAttrList& function, int num_constant_args,
+                      const std::vector<OptionalTensor>& variable_args,
+                      OpKernelContext* ctx,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable,
+                      CompilationRef* compilation_ref,
+                      const std::vector<TensorShape>* arg_shapes = nullptr);
 
   xla::Client* client() const { return compiler_.client(); }
 
@@ -73,6 +101,7 @@ class XlaCompilationCache : public ResourceBase {
 
  private:
   XlaCompiler compiler_;
+  const int max_variants_per_function_;
   std::unique_ptr<FunctionLibraryRuntime> function_library_runtime_;
 
   // Describes the types, shapes and any compile-time constant arguments
@@ -97,7 +126,9 @@ class XlaCompilationCache : public ResourceBase {
   // Builds the signature for a compilation.
   Status BuildSignature(const NameAttrList& function, int num_constant_args,
                         const std::vector<OptionalTensor>& variable_args,
-                        OpKernelContext* ctx, Signature* signature);
+                        OpKernelContext* ctx,
+                        const std::vector<TensorShape>* arg_shapes,
+                        Signature* signature);
 
   // The value associated with a cache entry.
   struct Entry {
@@ -115,12 +146,44 @@ class XlaCompilationCache : public ResourceBase {
     // The XLA executable compiled from <computation>. May be null if no
     // executable has been built.
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
+
+    // The position of the signature of the entry in the variants_ of its
+    // function, if the number of variants is bounded. Guarded by mu_.
+    std::list<Signature>::iterator lru_position;
+
+    // Whether CompileAsync started compiling the entry, and whether it is
+    // done. Guarded by mu_.
+    bool async_compilation_started = false;
+    bool async_compilation_done = false;
   };
 
+  // Finds or creates the cache entry for the arguments of `ctx`.
+  Status LookupEntry(const NameAttrList& function, int num_constant_args,
+                     const std::vector<OptionalTensor>& variable_args,
+                     OpKernelContext* ctx,
+                     const std::vector<TensorShape>* arg_shapes,
+                     std::shared_ptr<Entry>* entry);
+
+  // Compiles `function` for `args` into `entry`.
+  void CompileEntry(const NameAttrList& function,
+                    const std::vector<XlaCompiler::Argument>& args, Env* env,
+                    const FunctionLibraryDefinition* flib_def, Entry* entry)
+      EXCLUSIVE_LOCKS_REQUIRED(entry->mu);
+
+  // Marks the entry of `signature` as the most recently used variant of its
+  // function, and evicts the least recently used variants in excess.
+  // `inserted` tells whether the entry was just added to the cache.
+  void UpdateVariants(const Signature& signature, bool inserted, Entry* entry)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   mutex mu_;
-  std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
+  std::unordered_map<Signature, std::shared_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
 
+  // The signatures cached for each function, most recently used first. Only
+  // maintained if max_variants_per_function_ is positive.
+  std::unordered_map<string, std::list<Signature>> variants_ GUARDED_BY(mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
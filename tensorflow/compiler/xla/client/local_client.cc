@@ -195,9 +195,15 @@ StatusOr<std::unique_ptr<ShapedBuffer>> LocalExecutable::Run(
       StatusOr<std::unique_ptr<ShapedBuffer>>>(
       executable_.get(), &service_options, options.execution_profile(),
       backend_,
-      [&arguments](Executable* executable,
-                   const ServiceExecutableRunOptions* run_options,
-                   HloExecutionProfile* hlo_execution_profile) {
+      [&arguments, &options](Executable* executable,
+                             const ServiceExecutableRunOptions* run_options,
+                             HloExecutionProfile* hlo_execution_profile) {
+        // The profile requested by the caller takes precedence over the one
+        // logged by the service.
+        if (options.hlo_execution_profile() != nullptr &&
+            executable->hlo_profiling_enabled()) {
+          hlo_execution_profile = options.hlo_execution_profile();
+        }
         return executable->ExecuteOnStream(run_options, arguments,
                                            hlo_execution_profile);
       });
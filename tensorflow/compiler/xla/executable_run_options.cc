@@ -77,4 +77,14 @@ ExecutionProfile* ExecutableRunOptions::execution_profile() const {
   return execution_profile_;
 }
 
+ExecutableRunOptions& ExecutableRunOptions::set_hlo_execution_profile(
+    HloExecutionProfile* hlo_execution_profile) {
+  hlo_execution_profile_ = hlo_execution_profile;
+  return *this;
+}
+
+HloExecutionProfile* ExecutableRunOptions::hlo_execution_profile() const {
+  return hlo_execution_profile_;
+}
+
 }  // namespace xla
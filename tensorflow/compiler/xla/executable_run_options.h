@@ -41,6 +41,7 @@ namespace xla {
 
 class DeviceMemoryAllocator;
 class ExecutionProfile;
+class HloExecutionProfile;
 
 // Class containing options for running a LocalExecutable.
 class ExecutableRunOptions {
@@ -79,6 +80,13 @@ class ExecutableRunOptions {
   ExecutionProfile* execution_profile() const;
   ExecutableRunOptions& set_execution_profile(ExecutionProfile* profile);
 
+  // If set, and the executable was compiled with HLO profiling enabled, the
+  // cycles taken by each of its HLO instructions are written to
+  // 'hlo_execution_profile'. Does not take ownership.
+  HloExecutionProfile* hlo_execution_profile() const;
+  ExecutableRunOptions& set_hlo_execution_profile(
+      HloExecutionProfile* hlo_execution_profile);
+
  private:
   DeviceMemoryAllocator* allocator_ = nullptr;
   int device_ordinal_ = -1;
@@ -86,6 +94,7 @@ class ExecutableRunOptions {
   tensorflow::thread::ThreadPool* inter_op_thread_pool_ = nullptr;
   const Eigen::ThreadPoolDevice* intra_op_thread_pool_ = nullptr;
   ExecutionProfile* execution_profile_ = nullptr;
+  HloExecutionProfile* hlo_execution_profile_ = nullptr;
 };
 
 }  // namespace xla
@@ -40,6 +40,7 @@ static void AllocateFlags() {
   flags->xla_cpu_llvm_cl_opts = "";
   flags->xla_cpu_embed_ir = false;
   flags->xla_cpu_parallel = false;
+  flags->xla_cpu_llvm_compile_threads = 0;
   flag_list = new std::vector<tensorflow::Flag>({
       tensorflow::Flag(
           "xla_cpu_llvm_opt_level", &flags->xla_cpu_llvm_opt_level,
@@ -53,6 +54,10 @@ static void AllocateFlags() {
           "Embed the LLVM IR module string in the resultant CpuExecutable."),
       tensorflow::Flag("xla_cpu_parallel", &flags->xla_cpu_parallel,
                        "Use the multi-threaded CPU backend."),
+      tensorflow::Flag(
+          "xla_cpu_llvm_compile_threads", &flags->xla_cpu_llvm_compile_threads,
+          "The number of threads optimizing and compiling the LLVM IR of the "
+          "multi-threaded CPU backend, 0 for one per schedulable CPU."),
   });
   ParseFlagsFromEnv(*flag_list);
 }
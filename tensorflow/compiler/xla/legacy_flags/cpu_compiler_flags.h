@@ -41,6 +41,9 @@ typedef struct {
   bool xla_cpu_embed_ir;  // Embed the LLVM IR module string in the resultant
                           // CpuExecutable
   bool xla_cpu_parallel;  // Use the multi-threaded CPU backend.
+  // The number of threads optimizing and compiling the LLVM IR of the
+  // multi-threaded CPU backend, 0 for one per schedulable CPU.
+  int32 xla_cpu_llvm_compile_threads;
 } CpuCompilerFlags;
 
 // Return a pointer to the CpuCompilerFlags struct;
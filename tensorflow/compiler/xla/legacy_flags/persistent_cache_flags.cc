@@ -0,0 +1,68 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Legacy flags for XLA's persistent_cache module.
+
+#include <mutex>  // NOLINT(build/c++11): only using std::call_once, not mutex.
+#include <vector>
+
+#include "tensorflow/compiler/xla/legacy_flags/parse_flags_from_env.h"
+#include "tensorflow/compiler/xla/legacy_flags/persistent_cache_flags.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace xla {
+namespace legacy_flags {
+
+// Pointers to the parsed value of the flags and flag descriptors, initialized
+// via flags_init.
+static PersistentCacheFlags* flags;
+static std::vector<tensorflow::Flag>* flag_list;
+static std::once_flag flags_init;
+
+// Allocate *flags.  Called via call_once(&flags_init,...).
+static void AllocateFlags() {
+  flags = new PersistentCacheFlags;
+  flags->xla_persistent_cache_max_bytes = 1LL << 30;
+  flag_list = new std::vector<tensorflow::Flag>({
+      tensorflow::Flag("xla_persistent_cache_dir",
+                       &flags->xla_persistent_cache_dir,
+                       "Directory where the compiled code is shared across "
+                       "processes. Empty disables the cache."),
+      tensorflow::Flag("xla_persistent_cache_max_bytes",
+                       &flags->xla_persistent_cache_max_bytes,
+                       "Size of the persistent cache above which its oldest "
+                       "entries are evicted, or 0 to never evict them."),
+  });
+  ParseFlagsFromEnv(*flag_list);
+}
+
+// Append to *append_to flag definitions associated with XLA's persistent_cache
+// module.
+void AppendPersistentCacheFlags(std::vector<tensorflow::Flag>* append_to) {
+  std::call_once(flags_init, &AllocateFlags);
+  append_to->insert(append_to->end(), flag_list->begin(), flag_list->end());
+}
+
+// Return a pointer to the PersistentCacheFlags struct;
+// repeated calls return the same pointer.
+// This should be called only after Flags::Parse() has returned.
+PersistentCacheFlags* GetPersistentCacheFlags() {
+  std::call_once(flags_init, &AllocateFlags);
+  return flags;
+}
+
+}  // namespace legacy_flags
+}  // namespace xla
@@ -0,0 +1,52 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_LEGACY_FLAGS_PERSISTENT_CACHE_FLAGS_H_
+#define TENSORFLOW_COMPILER_XLA_LEGACY_FLAGS_PERSISTENT_CACHE_FLAGS_H_
+
+// Legacy flags for XLA's persistent_cache module.
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace xla {
+namespace legacy_flags {
+
+// Append to *flag_list flag definitions associated with XLA's persistent_cache
+// module.
+void AppendPersistentCacheFlags(std::vector<tensorflow::Flag>* flag_list);
+
+// The values of flags associated with XLA's persistent_cache module.
+typedef struct {
+  // Directory, possibly on a remote file system, where the compiled code is
+  // shared across processes. Empty disables the cache.
+  string xla_persistent_cache_dir;
+  // Size of the cache above which its oldest entries are evicted, or 0 to
+  // never evict them.
+  int64 xla_persistent_cache_max_bytes;
+} PersistentCacheFlags;
+
+// Return a pointer to the PersistentCacheFlags struct;
+// repeated calls return the same pointer.
+// This should be called only after Flags::Parse() has returned.
+PersistentCacheFlags* GetPersistentCacheFlags();
+
+}  // namespace legacy_flags
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_LEGACY_FLAGS_PERSISTENT_CACHE_FLAGS_H_
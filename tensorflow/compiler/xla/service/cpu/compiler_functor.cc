@@ -42,9 +42,11 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_avx.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_sse4_1.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/persistent_cache.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -76,6 +78,30 @@ operator()(llvm::Module& module) const {
     TF_CHECK_OK(f->Close());
   }
 
+  // Reuse the object file compiled from the same module by another process.
+  PersistentCache* cache = PersistentCache::Default();
+  string cache_key;
+  if (cache != nullptr) {
+    cache_key = CacheKey(module);
+    string object;
+    if (cache->Lookup(cache_key, &object)) {
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+          llvm::MemoryBuffer::getMemBufferCopy(object);
+      llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>>
+          object_file_or_error = llvm::object::ObjectFile::createObjectFile(
+              memory_buffer->getMemBufferRef());
+      if (object_file_or_error) {
+        VLOG(1) << "Loaded the object file of " << module.getName().str()
+                << " from the persistent cache";
+        return llvm::object::OwningBinary<llvm::object::ObjectFile>(
+            std::move(object_file_or_error.get()), std::move(memory_buffer));
+      }
+      llvm::consumeError(object_file_or_error.takeError());
+      LOG(WARNING) << "Ignoring the invalid cached object file of "
+                   << module.getName().str();
+    }
+  }
+
   // Build up optimization pipeline.
   AddOptimizationPasses(&module_passes, &function_passes);
 
@@ -100,6 +126,11 @@ operator()(llvm::Module& module) const {
   target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
+  if (cache != nullptr) {
+    cache->Insert(cache_key,
+                  string(stream_buffer.data(), stream_buffer.size()));
+  }
+
   // Construct ObjectFile from machine code buffer.
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
       new llvm::ObjectMemoryBuffer(std::move(stream_buffer)));
@@ -177,6 +208,27 @@ std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl(
 }
 }  // namespace
 
+string CompilerFunctor::CacheKey(const llvm::Module& module) const {
+  // The code generated for the target also depends on its fast-math options,
+  // and on the vectorized library functions available to it.
+  const llvm::TargetOptions& options = target_machine_->Options;
+  legacy_flags::CpuRuntimeFlags* flags = legacy_flags::GetCpuRuntimeFlags();
+  string key = tensorflow::strings::StrCat(
+      target_machine_->getTargetTriple().str(), ";",
+      target_machine_->getTargetCPU().str(), ";",
+      target_machine_->getTargetFeatureString().str(), ";", opt_level_, ";");
+  for (bool option :
+       {options.UnsafeFPMath, options.NoInfsFPMath, options.NoNaNsFPMath,
+        options.NoSignedZerosFPMath, available_intrinsics_.sse_intrinsics,
+        available_intrinsics_.avx_intrinsics, flags->xla_cpu_use_eigen}) {
+    tensorflow::strings::StrAppend(&key, option ? "1" : "0");
+  }
+  tensorflow::strings::StrAppend(&key, ";",
+                                 static_cast<int>(options.AllowFPOpFusion),
+                                 ";", llvm_ir::DumpModuleToString(module));
+  return key;
+}
+
 void CompilerFunctor::AddOptimizationPasses(
     llvm::legacy::PassManagerBase* module_passes,
     llvm::legacy::FunctionPassManager* function_passes) const {
@@ -21,6 +21,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/Object/ObjectFile.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -47,11 +48,17 @@ class CompilerFunctor {
         opt_level_(opt_level),
         available_intrinsics_(available_intrinsics) {}
 
-  // Compile a Module to an ObjectFile.
+  // Compile a Module to an ObjectFile. The object files are stored in the
+  // PersistentCache, if there is one, and reused by the next processes
+  // compiling the same module for the same target.
   llvm::object::OwningBinary<llvm::object::ObjectFile> operator()(
       llvm::Module& module) const;  // NOLINT
 
  private:
+  // Returns the key of the object file compiled from 'module' in the
+  // PersistentCache: the module and everything its compilation depends on.
+  string CacheKey(const llvm::Module& module) const;
+
   // Populates the given pass managers based on the optimization level.
   void AddOptimizationPasses(
       llvm::legacy::PassManagerBase* module_passes,
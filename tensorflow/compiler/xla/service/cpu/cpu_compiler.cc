@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <stddef.h>
 #include <string.h>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
@@ -80,6 +82,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace se = ::perftools::gputools;
 
@@ -379,8 +382,19 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
       parallel_computations.emplace(to_apply, instruction);
     }
 
+    // Split the large enough instructions into tasks computing a range of
+    // their output each. The tasks of an instruction run concurrently, so they
+    // are not split when profiling, as they would race on the profile counters.
+    ParallelTaskAssignment task_assignment(
+        module_config->hlo_profiling_enabled()
+            ? 1
+            : tensorflow::port::NumSchedulableCPUs(),
+        [this](const Shape& shape) { return ShapeSizeBytes(shape); });
+    std::unordered_map<const HloInstruction*, int64> parallel_task_counts;
+
     IrEmitter ir_emitter(*hlo_module, *module_config, *assignment,
-                         llvm_module.get(), &hlo_to_profile_idx);
+                         llvm_module.get(), &hlo_to_profile_idx,
+                         jit->target_machine());
     std::unique_ptr<std::map<HloInstruction*, string>> function_names(
         new std::map<HloInstruction*, string>());
     for (auto embedded_computation :
@@ -391,11 +405,22 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
       // IR generation purposes.
       bool computation_is_parallel =
           parallel_computation_iter != parallel_computations.end();
+      int64 task_count = 1;
+      if (computation_is_parallel) {
+        task_count = task_assignment.GetTargetParallelTaskCount(
+            *parallel_computation_iter->second);
+      }
+      if (task_count > 1) {
+        parallel_task_counts.emplace(parallel_computation_iter->second,
+                                     task_count);
+      }
       TF_ASSIGN_OR_RETURN(
           llvm::Function * ir_function,
           ir_emitter.EmitComputation(
               embedded_computation, embedded_computation->name(),
-              /*is_entry_computation=*/computation_is_parallel));
+              /*is_entry_computation=*/computation_is_parallel,
+              /*instruction_order=*/nullptr,
+              /*has_dynamic_loop_bounds=*/task_count > 1));
       // If this computation is parallel, remember it in the function name map.
       // This way we know what function to execute when we try to run code for
       // the Call instruction.
@@ -411,12 +436,20 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
       ir_module_string = llvm_ir::DumpModuleToString(*llvm_module);
     }
 
-    // JIT compile the LLVM IR module to in-memory machine code.
-    jit->AddModule(std::move(llvm_module));
+    // JIT compile the LLVM IR module to in-memory machine code. The parallel
+    // computations are external functions that only share the module, so they
+    // can be optimized and compiled concurrently.
+    const int compile_threads = flags->xla_cpu_llvm_compile_threads > 0
+                                    ? flags->xla_cpu_llvm_compile_threads
+                                    : tensorflow::port::NumSchedulableCPUs();
+    jit->AddModuleInParallel(
+        std::move(llvm_module),
+        std::min<int>(compile_threads, parallel_computations.size()));
     cpu_executable.reset(new ParallelCpuExecutable(
         std::move(jit), std::move(assignment), std::move(hlo_module),
         std::move(module_config), std::move(function_names),
-        std::move(hlo_to_profile_idx), std::move(aligned_constants)));
+        std::move(hlo_to_profile_idx), std::move(aligned_constants),
+        std::move(parallel_task_counts)));
 
     if (flags->xla_cpu_embed_ir) {
       static_cast<CpuExecutable&>(*cpu_executable)
@@ -450,7 +483,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
     // GetEmbeddedComputations guarantees that a called computation occurs
     // before a caller computation.
     IrEmitter ir_emitter(*hlo_module, *module_config, *assignment,
-                         llvm_module.get(), &hlo_to_profile_idx);
+                         llvm_module.get(), &hlo_to_profile_idx,
+                         jit->target_machine());
     for (auto embedded_computation :
          computation->MakeEmbeddedComputationsList()) {
       TF_RETURN_IF_ERROR(
@@ -612,7 +646,7 @@ CpuCompiler::CompileAheadOfTime(
             kMemoryAlignment));
 
     IrEmitter ir_emitter(*hlo_module, *module_config, *assignment, &llvm_module,
-                         /*hlo_to_profile_idx=*/nullptr);
+                         /*hlo_to_profile_idx=*/nullptr, target_machine.get());
     HloComputation* computation = hlo_module->entry_computation();
     for (auto embedded_computation :
          computation->MakeEmbeddedComputationsList()) {
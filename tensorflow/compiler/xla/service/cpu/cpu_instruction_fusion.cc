@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
 namespace xla {
 namespace cpu {
@@ -24,7 +26,19 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
                                       int64 operand_index) {
   HloInstruction* producer = consumer->mutable_operand(operand_index);
 
-  // Output fusion is not currently supported on CPUs.
+  // Tiled dots are fused into their elementwise consumers, which are applied to
+  // each element of the product once it is computed. As the consumers are
+  // elementwise and have the shape of the product, the element of the product
+  // they use has the index of the element they compute.
+  if (producer->opcode() == HloOpcode::kDot) {
+    return PotentiallyImplementedAsTiledDot(*producer) &&
+           consumer->IsElementwise() &&
+           consumer->opcode() != HloOpcode::kMap &&
+           ShapeUtil::Equal(consumer->shape(), producer->shape()) &&
+           InstructionFusion::ShouldFuse(consumer, operand_index);
+  }
+
+  // Only tiled dots are fused with their output on CPUs.
   if (producer->opcode() == HloOpcode::kFusion) {
     return false;
   }
@@ -45,5 +59,13 @@ bool CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
          InstructionFusion::ShouldFuse(consumer, operand_index);
 }
 
+HloInstruction::FusionKind CpuInstructionFusion::ChooseKind(
+    const HloInstruction* producer, const HloInstruction* consumer) {
+  if (producer->opcode() == HloOpcode::kDot) {
+    return HloInstruction::FusionKind::kOutput;
+  }
+  return InstructionFusion::ChooseKind(producer, consumer);
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -30,6 +30,11 @@ class CpuInstructionFusion : public InstructionFusion {
 
  protected:
   bool ShouldFuse(HloInstruction* consumer, int64 operand_index) override;
+
+  // Output fusions (tiled dots and their elementwise consumers) are kOutput,
+  // the other fusions kLoop.
+  HloInstruction::FusionKind ChooseKind(
+      const HloInstruction* producer, const HloInstruction* consumer) override;
 };
 
 }  // namespace cpu
@@ -15,13 +15,17 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 #include "external/llvm/include/llvm/IR/BasicBlock.h"
+#include "external/llvm/include/llvm/IR/Constants.h"
+#include "external/llvm/include/llvm/IR/DerivedTypes.h"
 #include "external/llvm/include/llvm/IR/Instructions.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/legacy_flags/cpu_runtime_flags.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
@@ -38,11 +42,29 @@ using llvm_ir::SetToFirstInsertPoint;
 
 namespace cpu {
 
+namespace {
+
+// The tiled matrix multiply accumulates tiles of kGemmTileRows rows and
+// kGemmTileVectors vectors of columns of the output in registers.
+constexpr int64 kGemmTileRows = 4;
+constexpr int64 kGemmTileVectors = 2;
+
+// The tiles are accumulated over blocks of kGemmBlockDepth rows of the rhs, so
+// that the part of these rows used by a column of tiles stays in the L1 cache.
+constexpr int64 kGemmBlockDepth = 128;
+
+// The alignment of the elements of the F32 arrays.
+constexpr int kGemmAlignment = sizeof(float);
+
+}  // namespace
+
 DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            bool transpose_rhs,
                            const llvm_ir::IrArray& target_array,
                            const llvm_ir::IrArray& lhs_array,
                            const llvm_ir::IrArray& rhs_array,
+                           const llvm_ir::ElementGenerator& epilogue_generator,
+                           int64 vector_register_byte_size,
                            llvm::Value* executable_run_options_value,
                            llvm::IRBuilder<>* ir_builder)
     : dot_(dot),
@@ -51,6 +73,8 @@ DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
       target_array_(target_array),
       lhs_array_(lhs_array),
       rhs_array_(rhs_array),
+      epilogue_generator_(epilogue_generator),
+      vector_register_byte_size_(vector_register_byte_size),
       executable_run_options_value_(executable_run_options_value),
       ir_builder_(ir_builder) {}
 
@@ -58,12 +82,15 @@ DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
     const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
     const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
     const llvm_ir::IrArray& rhs_array,
+    const llvm_ir::ElementGenerator& epilogue_generator,
+    int64 vector_register_byte_size,
     llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder) {
   PrimitiveType type = target_array.GetShape().element_type();
   TF_RET_CHECK(F32 == type || F64 == type);
   DotOpEmitter dot_emitter(dot, transpose_lhs, transpose_rhs, target_array,
-                           lhs_array, rhs_array, executable_run_options_value,
-                           ir_builder);
+                           lhs_array, rhs_array, epilogue_generator,
+                           vector_register_byte_size,
+                           executable_run_options_value, ir_builder);
   return dot_emitter.Emit();
 }
 
@@ -102,7 +129,13 @@ tensorflow::Status DotOpEmitter::Emit() {
     return EmitScalarDot();
   }
 
-  if (PotentiallyImplementedAsEigenDot(dot_)) {
+  if (CanEmitTiledGemm()) {
+    return EmitTiledGemm();
+  }
+
+  // The runtime can't apply the epilogue of an output fusion.
+  if (epilogue_generator_ == nullptr &&
+      PotentiallyImplementedAsEigenDot(dot_)) {
     return EmitCallToRuntime();
   }
 
@@ -203,6 +236,12 @@ tensorflow::Status DotOpEmitter::Emit() {
   }
 
   target_array_.EmitWriteArrayElement(target_index, result, ir_builder_);
+  if (epilogue_generator_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(llvm::Value * epilogue_result,
+                        epilogue_generator_(target_index));
+    target_array_.EmitWriteArrayElement(target_index, epilogue_result,
+                                        ir_builder_);
+  }
 
   // Set the IR builder insert point to the exit basic block of the outer most
   // loop.
@@ -312,6 +351,236 @@ tensorflow::Status DotOpEmitter::EmitCallToRuntime() {
   return tensorflow::Status::OK();
 }
 
+bool DotOpEmitter::CanEmitTiledGemm() const {
+  if (transpose_lhs_ || transpose_rhs_ ||
+      !PotentiallyImplementedAsTiledDot(dot_)) {
+    return false;
+  }
+  // The rows of the rhs and the output are loaded and stored as vectors.
+  auto is_row_major = [](const Shape& shape) {
+    return LayoutUtil::Minor(shape.layout(), 0) == 1;
+  };
+  const int64 vector_width = vector_register_byte_size_ / sizeof(float);
+  return vector_width >= 4 &&
+         rhs_array_.GetShape().dimensions(1) >= vector_width &&
+         is_row_major(lhs_array_.GetShape()) &&
+         is_row_major(rhs_array_.GetShape()) &&
+         is_row_major(target_array_.GetShape());
+}
+
+tensorflow::Status DotOpEmitter::EmitTiledGemm() {
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const int64 m = lhs_shape.dimensions(0);
+  const int64 k = lhs_shape.dimensions(1);
+  const int64 n = rhs_array_.GetShape().dimensions(1);
+  const int64 vector_width = vector_register_byte_size_ / sizeof(float);
+  // Narrow outputs are computed in tiles of a single vector of columns.
+  const int64 tile_vectors =
+      n >= kGemmTileVectors * vector_width ? kGemmTileVectors : 1;
+  const int64 tile_columns = tile_vectors * vector_width;
+  const int64 tiled_rows = m - m % kGemmTileRows;
+  const int64 tiled_columns = n - n % tile_columns;
+
+  // The loops over the tiles are emitted once for each block of the reduction
+  // dimension, as there are few of them for the shapes of tiled dots.
+  if (tiled_rows > 0) {
+    for (int64 reduction_start = 0; reduction_start < k;
+         reduction_start += kGemmBlockDepth) {
+      const int64 reduction_end =
+          std::min(k, reduction_start + kGemmBlockDepth);
+      TF_RETURN_IF_ERROR(EmitGemmTiles(
+          tiled_rows, tiled_columns, tile_vectors, reduction_start,
+          reduction_end, /*is_first_block=*/reduction_start == 0,
+          /*is_last_block=*/reduction_end == k));
+    }
+  }
+
+  // Compute the columns right of the tiles, then the rows below them.
+  TF_RETURN_IF_ERROR(EmitScalarGemmRegion(0, m, tiled_columns, n));
+  return EmitScalarGemmRegion(tiled_rows, m, 0, tiled_columns);
+}
+
+tensorflow::Status DotOpEmitter::EmitGemmTiles(
+    int64 tiled_rows, int64 tiled_columns, int64 tile_vectors,
+    int64 reduction_start, int64 reduction_end, bool is_first_block,
+    bool is_last_block) {
+  const int64 vector_width = vector_register_byte_size_ / sizeof(float);
+  const int64 tile_columns = tile_vectors * vector_width;
+  llvm::VectorType* vector_type =
+      llvm::VectorType::get(ir_builder_->getFloatTy(), vector_width);
+  auto vector_address = [this, vector_type](const llvm_ir::IrArray& array,
+                                            llvm::Value* row,
+                                            llvm::Value* column) {
+    return ir_builder_->CreateBitCast(
+        array.EmitArrayElementAddress(llvm_ir::IrArray::Index({row, column}),
+                                      ir_builder_),
+        vector_type->getPointerTo());
+  };
+
+  std::vector<llvm::AllocaInst*> accumulators;
+  for (int64 i = 0; i < kGemmTileRows * tile_vectors; ++i) {
+    accumulators.push_back(llvm_ir::EmitAllocaAtFunctionEntry(
+        vector_type, "tile_accumulator", ir_builder_));
+  }
+
+  // The columns of tiles are the outer loop, so that the rows of the rhs they
+  // use are reused by all the tiles of a column.
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> column_tile_loop =
+      loop_nest.AddLoop(0, tiled_columns / tile_columns, "column_tile");
+  std::unique_ptr<llvm_ir::ForLoop> row_tile_loop =
+      loop_nest.AddLoop(0, tiled_rows / kGemmTileRows, "row_tile");
+
+  SetToFirstInsertPoint(row_tile_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* row_start = ir_builder_->CreateMul(
+      row_tile_loop->GetIndVarValue(), ir_builder_->getInt64(kGemmTileRows));
+  llvm::Value* column_start = ir_builder_->CreateMul(
+      column_tile_loop->GetIndVarValue(), ir_builder_->getInt64(tile_columns));
+  std::vector<llvm::Value*> rows;
+  for (int64 row = 0; row < kGemmTileRows; ++row) {
+    rows.push_back(
+        ir_builder_->CreateAdd(row_start, ir_builder_->getInt64(row)));
+  }
+  std::vector<llvm::Value*> columns;
+  for (int64 vector = 0; vector < tile_vectors; ++vector) {
+    columns.push_back(ir_builder_->CreateAdd(
+        column_start, ir_builder_->getInt64(vector * vector_width)));
+  }
+
+  for (int64 row = 0; row < kGemmTileRows; ++row) {
+    for (int64 vector = 0; vector < tile_vectors; ++vector) {
+      llvm::Value* initial_value =
+          llvm::ConstantAggregateZero::get(vector_type);
+      if (!is_first_block) {
+        initial_value = ir_builder_->CreateAlignedLoad(
+            vector_address(target_array_, rows[row], columns[vector]),
+            kGemmAlignment);
+      }
+      ir_builder_->CreateStore(initial_value,
+                               accumulators[row * tile_vectors + vector]);
+    }
+  }
+
+  // Accumulate the products of a column of the lhs, broadcast to vectors, and
+  // the vectors of a row of the rhs.
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+      llvm_ir::ForLoop::EmitForLoop("tile_reduction",
+                                    ir_builder_->getInt64(reduction_start),
+                                    ir_builder_->getInt64(reduction_end),
+                                    ir_builder_->getInt64(1), ir_builder_);
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* reduction_index = reduction_loop->GetIndVarValue();
+  std::vector<llvm::Value*> rhs_vectors;
+  for (int64 vector = 0; vector < tile_vectors; ++vector) {
+    rhs_vectors.push_back(ir_builder_->CreateAlignedLoad(
+        vector_address(rhs_array_, reduction_index, columns[vector]),
+        kGemmAlignment));
+  }
+  for (int64 row = 0; row < kGemmTileRows; ++row) {
+    llvm::Value* lhs_vector = ir_builder_->CreateVectorSplat(
+        vector_width,
+        lhs_array_.EmitReadArrayElement(
+            llvm_ir::IrArray::Index({rows[row], reduction_index}),
+            ir_builder_));
+    for (int64 vector = 0; vector < tile_vectors; ++vector) {
+      llvm::AllocaInst* accumulator = accumulators[row * tile_vectors + vector];
+      ir_builder_->CreateStore(
+          ir_builder_->CreateFAdd(
+              ir_builder_->CreateLoad(accumulator),
+              ir_builder_->CreateFMul(lhs_vector, rhs_vectors[vector])),
+          accumulator);
+    }
+  }
+
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  for (int64 row = 0; row < kGemmTileRows; ++row) {
+    for (int64 vector = 0; vector < tile_vectors; ++vector) {
+      ir_builder_->CreateAlignedStore(
+          ir_builder_->CreateLoad(accumulators[row * tile_vectors + vector]),
+          vector_address(target_array_, rows[row], columns[vector]),
+          kGemmAlignment);
+    }
+  }
+  if (is_last_block && epilogue_generator_ != nullptr) {
+    TF_RETURN_IF_ERROR(
+        EmitEpilogue(row_start, kGemmTileRows, column_start, tile_columns));
+  }
+
+  SetToFirstInsertPoint(loop_nest.GetOuterLoopExitBasicBlock(), ir_builder_);
+  return tensorflow::Status::OK();
+}
+
+tensorflow::Status DotOpEmitter::EmitScalarGemmRegion(int64 row_start,
+                                                      int64 row_end,
+                                                      int64 column_start,
+                                                      int64 column_end) {
+  if (row_start == row_end || column_start == column_end) {
+    return tensorflow::Status::OK();
+  }
+
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> row_loop =
+      loop_nest.AddLoop(row_start, row_end, "row");
+  std::unique_ptr<llvm_ir::ForLoop> column_loop =
+      loop_nest.AddLoop(column_start, column_end, "column");
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop = loop_nest.AddLoop(
+      0, lhs_array_.GetShape().dimensions(1), "reduction");
+  llvm::Value* row = row_loop->GetIndVarValue();
+  llvm::Value* column = column_loop->GetIndVarValue();
+
+  llvm::AllocaInst* accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+      ir_builder_->getFloatTy(), "accumulator", ir_builder_);
+  ir_builder_->SetInsertPoint(
+      reduction_loop->GetPreheaderBasicBlock()->getTerminator());
+  ir_builder_->CreateStore(
+      llvm::ConstantFP::get(ir_builder_->getFloatTy(), 0.0), accumulator);
+
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* reduction_index = reduction_loop->GetIndVarValue();
+  llvm::Value* lhs_element = lhs_array_.EmitReadArrayElement(
+      llvm_ir::IrArray::Index({row, reduction_index}), ir_builder_);
+  llvm::Value* rhs_element = rhs_array_.EmitReadArrayElement(
+      llvm_ir::IrArray::Index({reduction_index, column}), ir_builder_);
+  llvm::Value* product = ir_builder_->CreateFMul(lhs_element, rhs_element);
+  ir_builder_->CreateStore(
+      ir_builder_->CreateFAdd(ir_builder_->CreateLoad(accumulator), product),
+      accumulator);
+
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  llvm_ir::IrArray::Index target_index({row, column});
+  target_array_.EmitWriteArrayElement(
+      target_index, ir_builder_->CreateLoad(accumulator), ir_builder_);
+  if (epilogue_generator_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(llvm::Value * epilogue_result,
+                        epilogue_generator_(target_index));
+    target_array_.EmitWriteArrayElement(target_index, epilogue_result,
+                                        ir_builder_);
+  }
+
+  SetToFirstInsertPoint(loop_nest.GetOuterLoopExitBasicBlock(), ir_builder_);
+  return tensorflow::Status::OK();
+}
+
+tensorflow::Status DotOpEmitter::EmitEpilogue(llvm::Value* row_start,
+                                              int64 rows,
+                                              llvm::Value* column_start,
+                                              int64 columns) {
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> row_loop =
+      loop_nest.AddLoop(0, rows, "epilogue_row");
+  std::unique_ptr<llvm_ir::ForLoop> column_loop =
+      loop_nest.AddLoop(0, columns, "epilogue_column");
+  SetToFirstInsertPoint(column_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm_ir::IrArray::Index index(
+      {ir_builder_->CreateAdd(row_start, row_loop->GetIndVarValue()),
+       ir_builder_->CreateAdd(column_start, column_loop->GetIndVarValue())});
+  TF_ASSIGN_OR_RETURN(llvm::Value * epilogue_result,
+                      epilogue_generator_(index));
+  target_array_.EmitWriteArrayElement(index, epilogue_result, ir_builder_);
+  SetToFirstInsertPoint(loop_nest.GetOuterLoopExitBasicBlock(), ir_builder_);
+  return tensorflow::Status::OK();
+}
+
 llvm_ir::IrArray::Index DotOpEmitter::EmitOperandArrayLoopNest(
     llvm_ir::ForLoopNest* loop_nest, const llvm_ir::IrArray& operand_array,
     int64 reduction_dimension, tensorflow::StringPiece name_suffix) {
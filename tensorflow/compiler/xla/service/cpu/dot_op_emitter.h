@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
+#include "tensorflow/compiler/xla/service/llvm_ir/loop_emitter.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -35,10 +36,20 @@ class DotOpEmitter {
   // place the result in target_array. IR is emitted at current insert point of
   // the builder. Upon completion of the method, the insert point is set to the
   // end of all instructions emitted for this operation.
+  //
+  // If epilogue_generator is not null, the elements of the result are replaced
+  // with the values it generates once they are computed. It is the generator
+  // of the root of an output fusion, which reads the elements of the result
+  // from target_array at the same index, see IrEmitter::HandleFusion.
+  //
+  // vector_register_byte_size is the size of the vector registers of the
+  // target, used to tile the matrix products emitted in IR.
   static tensorflow::Status EmitDotOperation(
       const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
       const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
       const llvm_ir::IrArray& rhs_array,
+      const llvm_ir::ElementGenerator& epilogue_generator,
+      int64 vector_register_byte_size,
       llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder);
 
  private:
@@ -46,6 +57,8 @@ class DotOpEmitter {
                bool transpose_rhs, const llvm_ir::IrArray& target_array,
                const llvm_ir::IrArray& lhs_array,
                const llvm_ir::IrArray& rhs_array,
+               const llvm_ir::ElementGenerator& epilogue_generator,
+               int64 vector_register_byte_size,
                llvm::Value* executable_run_options_value,
                llvm::IRBuilder<>* ir_builder);
 
@@ -59,6 +72,37 @@ class DotOpEmitter {
   // Emits a call to the CPU runtime to perform the matrix multiply.
   tensorflow::Status EmitCallToRuntime();
 
+  // Returns whether the matrix multiply can be emitted by EmitTiledGemm.
+  bool CanEmitTiledGemm() const;
+
+  // Emits a matrix multiply specialized for the shapes of the operands. The
+  // output is computed in tiles of a few rows and vectors of columns, which are
+  // accumulated in vector registers, and the reduction dimension is blocked so
+  // that the rows of the rhs used by a tile stay in the L1 cache.
+  tensorflow::Status EmitTiledGemm();
+
+  // Emits the loops computing the tiles of the output, accumulating the
+  // products of the columns of the lhs and the rows of the rhs in
+  // [reduction_start, reduction_end) into them. The tiles are initialized with
+  // zeros if is_first_block, else with the values stored in the output, and
+  // the epilogue is applied to them if is_last_block.
+  tensorflow::Status EmitGemmTiles(int64 tiled_rows, int64 tiled_columns,
+                                   int64 tile_vectors, int64 reduction_start,
+                                   int64 reduction_end, bool is_first_block,
+                                   bool is_last_block);
+
+  // Emits scalar loops computing the elements of the output in [row_start,
+  // row_end) x [column_start, column_end), e.g. those which are not part of a
+  // whole tile.
+  tensorflow::Status EmitScalarGemmRegion(int64 row_start, int64 row_end,
+                                          int64 column_start,
+                                          int64 column_end);
+
+  // Emits loops applying the epilogue to the given rectangle of the output,
+  // whose elements must have been computed.
+  tensorflow::Status EmitEpilogue(llvm::Value* row_start, int64 rows,
+                                  llvm::Value* column_start, int64 columns);
+
   // Emits a series of nested loops for iterating over an operand array in the
   // dot operation. Loops are constructed in major to minor dimension layout
   // order. No loop is emitted for the given reduction_dimension. The function
@@ -80,6 +124,8 @@ class DotOpEmitter {
   const llvm_ir::IrArray& target_array_;
   const llvm_ir::IrArray& lhs_array_;
   const llvm_ir::IrArray& rhs_array_;
+  const llvm_ir::ElementGenerator& epilogue_generator_;
+  const int64 vector_register_byte_size_;
   llvm::Value* executable_run_options_value_;
   llvm::IRBuilder<>* ir_builder_;
 };
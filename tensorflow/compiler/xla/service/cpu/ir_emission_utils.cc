@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 
+#include <algorithm>
+
 #include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/legacy_flags/cpu_runtime_flags.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
@@ -63,6 +65,11 @@ bool PotentiallyImplementedAsEigenConvolution(
 
 namespace {
 
+// The bounds of the products emitted by the tiled dot emitter.
+constexpr int64 kMaxTiledDotDimension = 512;
+constexpr int64 kMaxTiledDotMultiplies = 1 << 24;
+constexpr int64 kMinTiledDotColumns = 16;
+
 // Return whether the given shape is a matrix with no padding.
 bool IsRank2WithNoPadding(const Shape& shape) {
   return ShapeUtil::Rank(shape) == 2 && !LayoutUtil::IsPadded(shape);
@@ -123,5 +130,25 @@ bool PotentiallyImplementedAsEigenDot(const HloInstruction& hlo) {
   return false;
 }
 
+bool PotentiallyImplementedAsTiledDot(const HloInstruction& dot) {
+  if (dot.opcode() != HloOpcode::kDot) {
+    return false;
+  }
+  const Shape& lhs_shape = dot.operand(0)->shape();
+  const Shape& rhs_shape = dot.operand(1)->shape();
+  if (ShapeUtil::HasZeroElements(lhs_shape) ||
+      ShapeUtil::HasZeroElements(rhs_shape) ||
+      !AreValidGemmShapes(lhs_shape, rhs_shape, dot.shape())) {
+    return false;
+  }
+  const int64 m = lhs_shape.dimensions(0);
+  const int64 k = lhs_shape.dimensions(1);
+  const int64 n = rhs_shape.dimensions(1);
+  // The emitted loops run on a single thread, and vectorize the columns of the
+  // output, so larger or narrower products are left to Eigen.
+  return std::max({m, k, n}) <= kMaxTiledDotDimension &&
+         m * k * n <= kMaxTiledDotMultiplies && n >= kMinTiledDotColumns;
+}
+
 }  // namespace cpu
 }  // namespace xla
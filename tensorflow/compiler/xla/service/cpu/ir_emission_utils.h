@@ -26,6 +26,12 @@ bool PotentiallyImplementedAsEigenConvolution(
 
 bool PotentiallyImplementedAsEigenDot(const HloInstruction& dot);
 
+// Returns whether the given dot is a matrix product small enough to be emitted
+// as a tiled loop nest in IR rather than as a call to Eigen, e.g. the product
+// of a layer of a small neural network. The elementwise instructions consuming
+// such a dot are fused into it as an epilogue, see CpuInstructionFusion.
+bool PotentiallyImplementedAsTiledDot(const HloInstruction& dot);
+
 }  // namespace cpu
 }  // namespace xla
 
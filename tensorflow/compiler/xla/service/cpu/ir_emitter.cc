@@ -26,6 +26,7 @@ limitations under the License.
 
 #include "tensorflow/core/platform/logging.h"
 // IWYU pragma: no_include "llvm/IR/Intrinsics.gen.inc"
+#include "external/llvm/include/llvm/Analysis/TargetTransformInfo.h"
 #include "external/llvm/include/llvm/IR/BasicBlock.h"
 #include "external/llvm/include/llvm/IR/Constants.h"
 #include "external/llvm/include/llvm/IR/GlobalVariable.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
@@ -65,10 +67,12 @@ namespace cpu {
 IrEmitter::IrEmitter(
     const HloModule& hlo_module, const HloModuleConfig& hlo_module_config,
     const BufferAssignment& assignment, llvm::Module* llvm_module,
-    const std::unordered_map<const HloInstruction*, size_t>* hlo_to_profile_idx)
+    const std::unordered_map<const HloInstruction*, size_t>* hlo_to_profile_idx,
+    llvm::TargetMachine* target_machine)
     : assignment_(assignment),
       module_(llvm_module),
       arch_type_(llvm::Triple(llvm_module->getTargetTriple()).getArch()),
+      target_machine_(target_machine),
       ir_builder_(llvm_module->getContext()),
       hlo_to_profile_idx_(hlo_to_profile_idx),
       alias_analysis_(hlo_module, assignment, &llvm_module->getContext()),
@@ -79,10 +83,12 @@ IrEmitter::IrEmitter(
 StatusOr<llvm::Function*> IrEmitter::EmitComputation(
     HloComputation* computation, const string& function_name_prefix,
     bool is_entry_computation,
-    std::vector<const HloInstruction*>* instruction_order) {
+    std::vector<const HloInstruction*>* instruction_order,
+    bool has_dynamic_loop_bounds) {
   string function_name = name_uniquer_.GetUniqueName(function_name_prefix);
   VLOG(2) << "Emitting IR for CPU function [" << function_name_prefix << "]";
-  InitializeIrFunction(function_name, is_entry_computation);
+  InitializeIrFunction(function_name, is_entry_computation,
+                       has_dynamic_loop_bounds);
   // The rdtscp instruction is x86 specific.  We will fallback to LLVM's generic
   // readcyclecounter if it is unavailable.
   bool use_rdtscp = arch_type_ == llvm::Triple::ArchType::x86 ||
@@ -107,10 +113,11 @@ static llvm::Argument* GetArg(llvm::Function* f, int idx) {
 }
 
 void IrEmitter::InitializeIrFunction(const string& function_name,
-                                     bool is_entry_computation) {
+                                     bool is_entry_computation,
+                                     bool has_dynamic_loop_bounds) {
   // The function signature is:
   //   void function(i8* retval, i8* run_options, i8** params, i8** temps,
-  //                 i64* prof_counters)
+  //                 i64* prof_counters, i64* dynamic_loop_bounds)
   //
   // retval: points to the returned value.
   // params: address of an array with pointers to parameters.
@@ -153,6 +160,10 @@ void IrEmitter::InitializeIrFunction(const string& function_name,
   //                     /---------------------------------------------\
   //   prof counters ->  | counter 0 | counter 1 | ..... | counter N-1 |
   //  (elided for aot)   \---------------------------------------------/
+  //
+  //                          /-------------\
+  //   dynamic loop bounds -> | start | end |
+  //  (only if partitioned)   \-------------/
 
   // Even though the type of params and temps is void** in the host's view, in
   // LLVM IR this is represented by i8*, similarly to void*. It's up to the code
@@ -165,6 +176,10 @@ void IrEmitter::InitializeIrFunction(const string& function_name,
   if (hlo_to_profile_idx_) {
     compute_function_params.push_back(i64_ptr_type);
   }
+  has_dynamic_loop_bounds_ = has_dynamic_loop_bounds;
+  if (has_dynamic_loop_bounds) {
+    compute_function_params.push_back(i64_ptr_type);
+  }
   llvm::FunctionType* compute_function_type = llvm::FunctionType::get(
       /*Result=*/llvm::Type::getVoidTy(module_->getContext()),
       /*Params=*/compute_function_params,
@@ -191,6 +206,9 @@ void IrEmitter::InitializeIrFunction(const string& function_name,
   if (hlo_to_profile_idx_) {
     (++arg_iter)->setName("prof_counters");
   }
+  if (has_dynamic_loop_bounds) {
+    (++arg_iter)->setName("dynamic_loop_bounds");
+  }
 
   // We know a-priori that the function arguments are guaranteed to point to
   // disjoint objects.
@@ -757,7 +775,9 @@ Status IrEmitter::HandleDot(HloInstruction* dot, HloInstruction* lhs,
   // Dot operation is complicated so we delegate to a helper class.
   TF_RETURN_IF_ERROR(DotOpEmitter::EmitDotOperation(
       *dot, /*transpose_lhs=*/false, /*transpose_rhs=*/false, target_array,
-      lhs_array, rhs_array, GetExecutableRunOptionsArgument(), &ir_builder_));
+      lhs_array, rhs_array, /*epilogue_generator=*/nullptr,
+      GetVectorRegisterByteSize(), GetExecutableRunOptionsArgument(),
+      &ir_builder_));
 
   emitted_value_[dot] = target_address;
   return Status::OK();
@@ -1070,10 +1090,100 @@ Status IrEmitter::HandleParameter(HloInstruction* parameter) {
   return Status::OK();
 }
 
+namespace {
+
+// The maximum number of vector accumulators of a vectorized reduction. They
+// hide the latency of the vector operations, which the loop-carried dependency
+// on a single accumulator would expose.
+constexpr int64 kMaxReductionAccumulators = 4;
+
+// Returns true if the reduction of 'arg' over 'dimensions' by 'function' can be
+// emitted with vector instructions, and sets '*opcode' to the operation of
+// 'function'. The most-minor dimension of 'arg' must be reduced, so that
+// consecutive elements are combined, and 'function' must apply a single
+// binary operation to its parameters, whose partial results can be combined
+// in any order.
+bool IsVectorizableReduction(const HloInstruction& arg,
+                             tensorflow::gtl::ArraySlice<int64> dimensions,
+                             const HloComputation& function,
+                             bool fast_math_disabled, HloOpcode* opcode) {
+  const Shape& shape = arg.shape();
+  if ((shape.element_type() != F32 && shape.element_type() != F64) ||
+      ShapeUtil::Rank(shape) == 0 || !LayoutUtil::HasLayout(shape)) {
+    return false;
+  }
+  const int64 minor_dimension = LayoutUtil::Minor(shape.layout(), 0);
+  if (std::find(dimensions.begin(), dimensions.end(), minor_dimension) ==
+      dimensions.end()) {
+    return false;
+  }
+  const HloInstruction* root = function.root_instruction();
+  if (function.num_parameters() != 2 || function.instruction_count() != 3 ||
+      root->operand_count() != 2 ||
+      root->operand(0)->opcode() != HloOpcode::kParameter ||
+      root->operand(1)->opcode() != HloOpcode::kParameter ||
+      root->operand(0) == root->operand(1) ||
+      root->shape().element_type() != shape.element_type()) {
+    return false;
+  }
+  switch (root->opcode()) {
+    case HloOpcode::kAdd:
+    case HloOpcode::kMultiply:
+      // Combining the partial results in another order than the elements
+      // changes the rounding of floating-point sums and products.
+      if (fast_math_disabled) {
+        return false;
+      }
+      break;
+    case HloOpcode::kMaximum:
+    case HloOpcode::kMinimum:
+      break;
+    default:
+      return false;
+  }
+  *opcode = root->opcode();
+  return true;
+}
+
+// Returns the identity of the operation of a vectorized reduction, which the
+// vector accumulators start with.
+llvm::Constant* GetReductionIdentity(HloOpcode opcode, llvm::Type* type) {
+  switch (opcode) {
+    case HloOpcode::kAdd:
+      return llvm::ConstantFP::get(type, -0.0);
+    case HloOpcode::kMultiply:
+      return llvm::ConstantFP::get(type, 1.0);
+    case HloOpcode::kMaximum:
+      return llvm::ConstantFP::getInfinity(type, /*Negative=*/true);
+    case HloOpcode::kMinimum:
+      return llvm::ConstantFP::getInfinity(type, /*Negative=*/false);
+    default:
+      LOG(FATAL) << "Unexpected reduction " << HloOpcodeString(opcode);
+  }
+}
+
+}  // namespace
+
 Status IrEmitter::HandleReduce(HloInstruction* reduce, HloInstruction* arg,
                                HloInstruction* init_value,
                                tensorflow::gtl::ArraySlice<int64> dimensions,
                                HloComputation* function) {
+  HloOpcode reduction_opcode;
+  if (IsVectorizableReduction(*arg, dimensions, *function,
+                              hlo_module_config_.fast_math_disabled(),
+                              &reduction_opcode)) {
+    const Shape& arg_shape = arg->shape();
+    const int64 vector_width =
+        GetVectorRegisterByteSize() /
+        ShapeUtil::ByteSizeOfPrimitiveType(arg_shape.element_type());
+    const int64 minor_dimension_size =
+        arg_shape.dimensions(LayoutUtil::Minor(arg_shape.layout(), 0));
+    if (vector_width > 1 && minor_dimension_size >= vector_width) {
+      return EmitVectorizedReduce(reduce, arg, init_value, dimensions,
+                                  reduction_opcode, vector_width);
+    }
+  }
+
   // The called computation should have been emitted previously.
   llvm::Function* reducer_function = FindOrDie(emitted_functions_, function);
   return EmitTargetElementLoop(
@@ -1131,6 +1241,164 @@ Status IrEmitter::HandleReduce(HloInstruction* reduce, HloInstruction* arg,
       });
 }
 
+Status IrEmitter::EmitVectorizedReduce(
+    HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+    tensorflow::gtl::ArraySlice<int64> dimensions, HloOpcode reduction_opcode,
+    int64 vector_width) {
+  const Shape& arg_shape = arg->shape();
+  const int64 minor_dimension = LayoutUtil::Minor(arg_shape.layout(), 0);
+  const int64 minor_dimension_size = arg_shape.dimensions(minor_dimension);
+  // The minor dimension is reduced by blocks of one vector per accumulator,
+  // then by the remaining vectors, then by the remaining elements one by one.
+  const int64 accumulator_count = std::min(
+      kMaxReductionAccumulators, minor_dimension_size / vector_width);
+  const int64 block_size = accumulator_count * vector_width;
+  const int64 block_count = minor_dimension_size / block_size;
+  const int64 tail_vector_count =
+      (minor_dimension_size % block_size) / vector_width;
+  const int64 tail_start =
+      block_count * block_size + tail_vector_count * vector_width;
+  std::vector<int64> other_dimensions;
+  for (int64 dimension : dimensions) {
+    if (dimension != minor_dimension) {
+      other_dimensions.push_back(dimension);
+    }
+  }
+
+  return EmitTargetElementLoop(reduce, [=](const llvm_ir::IrArray::Index&
+                                               index) {
+    PrimitiveType element_type = arg_shape.element_type();
+    llvm::Type* element_ir_type =
+        llvm_ir::PrimitiveTypeToIrType(element_type, &ir_builder_);
+    llvm::VectorType* vector_type =
+        llvm::VectorType::get(element_ir_type, vector_width);
+    const int alignment = MinimumAlignmentForPrimitiveType(element_type);
+
+    // The vector accumulators start with the identity of the operation, and
+    // the scalar one with init_value.
+    std::vector<llvm::AllocaInst*> vector_accumulators;
+    for (int64 i = 0; i < accumulator_count; ++i) {
+      llvm::AllocaInst* accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+          vector_type, "vector_accumulator", &ir_builder_);
+      ir_builder_.CreateStore(
+          llvm::ConstantVector::getSplat(
+              vector_width,
+              GetReductionIdentity(reduction_opcode, element_ir_type)),
+          accumulator);
+      vector_accumulators.push_back(accumulator);
+    }
+    llvm::AllocaInst* accumulator_addr = llvm_ir::EmitAllocaAtFunctionEntry(
+        element_ir_type, "accumulator", &ir_builder_, alignment);
+    ir_builder_.CreateStore(
+        ir_builder_.CreateLoad(GetEmittedValueFor(init_value)),
+        accumulator_addr);
+
+    // Build the loops over the reduced dimensions other than the minor one,
+    // and fill in the rest of the input index with the induction Value*s
+    // taken from 'index', as in HandleReduce.
+    llvm_ir::ForLoopNest loops(&ir_builder_);
+    llvm_ir::IrArray::Index input_index = loops.AddLoopsForShapeOnDimensions(
+        arg_shape, other_dimensions, "reduction_dim");
+    llvm_ir::IrArray::Index::const_iterator it = index.begin();
+    for (int64 i = 0; i < ShapeUtil::Rank(arg_shape); ++i) {
+      if (input_index[i] == nullptr && i != minor_dimension) {
+        input_index[i] = *it++;
+      }
+    }
+    CHECK(index.end() == it);
+
+    llvm_ir::IrArray arg_array(GetIrArrayForOp(arg));
+    auto element_address = [&](llvm::Value* minor_position) {
+      llvm_ir::IrArray::Index element_index = input_index;
+      element_index[minor_dimension] = minor_position;
+      return arg_array.EmitArrayElementAddress(element_index, &ir_builder_);
+    };
+    auto accumulate_vector = [&](llvm::Value* minor_position,
+                                 llvm::AllocaInst* accumulator) {
+      llvm::Value* vector = ir_builder_.CreateAlignedLoad(
+          ir_builder_.CreateBitCast(element_address(minor_position),
+                                    vector_type->getPointerTo()),
+          alignment);
+      ir_builder_.CreateStore(
+          EmitReductionOperation(reduction_opcode,
+                                 ir_builder_.CreateLoad(accumulator), vector),
+          accumulator);
+    };
+
+    std::unique_ptr<llvm_ir::ForLoop> block_loop =
+        loops.AddLoop(0, block_count, "vectorized_reduction");
+    SetToFirstInsertPoint(block_loop->GetBodyBasicBlock(), &ir_builder_);
+    llvm::Value* block_start = ir_builder_.CreateMul(
+        block_loop->GetIndVarValue(), ir_builder_.getInt64(block_size));
+    for (int64 i = 0; i < accumulator_count; ++i) {
+      accumulate_vector(
+          ir_builder_.CreateAdd(block_start,
+                                ir_builder_.getInt64(i * vector_width)),
+          vector_accumulators[i]);
+    }
+
+    SetToFirstInsertPoint(block_loop->GetExitBasicBlock(), &ir_builder_);
+    for (int64 i = 0; i < tail_vector_count; ++i) {
+      accumulate_vector(ir_builder_.getInt64(block_count * block_size +
+                                             i * vector_width),
+                        vector_accumulators[i]);
+    }
+    for (int64 position = tail_start; position < minor_dimension_size;
+         ++position) {
+      llvm::Value* element = ir_builder_.CreateAlignedLoad(
+          element_address(ir_builder_.getInt64(position)), alignment);
+      ir_builder_.CreateStore(
+          EmitReductionOperation(reduction_opcode,
+                                 ir_builder_.CreateLoad(accumulator_addr),
+                                 element),
+          accumulator_addr);
+    }
+
+    // Reduce the vector accumulators to one, then its elements.
+    SetToFirstInsertPoint(loops.GetOuterLoopExitBasicBlock(), &ir_builder_);
+    llvm::Value* vector_result =
+        ir_builder_.CreateLoad(vector_accumulators[0]);
+    for (int64 i = 1; i < accumulator_count; ++i) {
+      vector_result = EmitReductionOperation(
+          reduction_opcode, vector_result,
+          ir_builder_.CreateLoad(vector_accumulators[i]));
+    }
+    llvm::Value* result = ir_builder_.CreateLoad(accumulator_addr);
+    for (int64 i = 0; i < vector_width; ++i) {
+      result = EmitReductionOperation(
+          reduction_opcode, result,
+          ir_builder_.CreateExtractElement(vector_result,
+                                           ir_builder_.getInt64(i)));
+    }
+    return result;
+  });
+}
+
+llvm::Value* IrEmitter::EmitReductionOperation(HloOpcode opcode,
+                                               llvm::Value* lhs,
+                                               llvm::Value* rhs) {
+  switch (opcode) {
+    case HloOpcode::kAdd:
+      return ir_builder_.CreateFAdd(lhs, rhs);
+    case HloOpcode::kMultiply:
+      return ir_builder_.CreateFMul(lhs, rhs);
+    case HloOpcode::kMaximum:
+      return llvm_ir::EmitCallToIntrinsic(llvm::Intrinsic::maxnum, {lhs, rhs},
+                                          {lhs->getType()}, &ir_builder_);
+    case HloOpcode::kMinimum:
+      return llvm_ir::EmitCallToIntrinsic(llvm::Intrinsic::minnum, {lhs, rhs},
+                                          {lhs->getType()}, &ir_builder_);
+    default:
+      LOG(FATAL) << "Unexpected reduction " << HloOpcodeString(opcode);
+  }
+}
+
+int64 IrEmitter::GetVectorRegisterByteSize() {
+  return target_machine_->getTargetTransformInfo(*compute_function_)
+             .getRegisterBitWidth(/*Vector=*/true) /
+         8;
+}
+
 Status IrEmitter::HandleSend(HloInstruction* send) {
   // TODO(b/33942983): Support Send/Recv on CPU.
   return Unimplemented("Send is not implemented on CPU. See b/33942983.");
@@ -1199,6 +1467,72 @@ Status IrEmitter::HandlePad(HloInstruction* pad) {
   return Status::OK();
 }
 
+Status IrEmitter::HandleDynamicUpdateSlice(HloInstruction* dynamic_update_slice,
+                                           HloInstruction* operand,
+                                           HloInstruction* update,
+                                           HloInstruction* start_indices) {
+  // The elemental emitter writes every element of the output, selecting
+  // between the operand and the update. Instead, the output starts as a copy
+  // of the operand, or aliases it when buffer assignment lets the two share a
+  // slice, and only the elements of the update are then written. In a loop
+  // which updates one slice of a large accumulator per iteration this avoids
+  // rewriting the whole accumulator every time.
+  auto operand_slice = assignment_.GetUniqueTopLevelSlice(operand);
+  auto output_slice = assignment_.GetUniqueTopLevelSlice(dynamic_update_slice);
+  if (GetDynamicLoopBoundsArgument() != nullptr || !operand_slice.ok() ||
+      !output_slice.ok() ||
+      !LayoutUtil::Equal(operand->shape().layout(),
+                         dynamic_update_slice->shape().layout())) {
+    return DefaultAction(dynamic_update_slice);
+  }
+
+  TF_ASSIGN_OR_RETURN(llvm::Value * target_address,
+                      EmitTargetAddressForOp(dynamic_update_slice));
+  emitted_value_[dynamic_update_slice] = target_address;
+  if (operand_slice.ValueOrDie() != output_slice.ValueOrDie()) {
+    TF_RETURN_IF_ERROR(EmitMemcpy(*operand, *dynamic_update_slice));
+  }
+  llvm_ir::IrArray target_array(target_address, dynamic_update_slice->shape());
+  AddAliasingInformationToIrArray(*dynamic_update_slice, &target_array);
+
+  // Writes element 'index' of the update to element start_index + index of
+  // the output. Like the elemental emitter, this drops the elements of the
+  // update which fall past the end of a dimension.
+  llvm_ir::IrArray update_array(GetIrArrayForOp(update));
+  llvm_ir::IrArray start_indices_array(GetIrArrayForOp(start_indices));
+  const Shape& output_shape = dynamic_update_slice->shape();
+  const int64 rank = ShapeUtil::Rank(output_shape);
+  auto loop_body_emitter =
+      [&](const llvm_ir::IrArray::Index& index) -> Status {
+    llvm_ir::IrArray::Index output_index(rank);
+    llvm::Value* in_bounds = ir_builder_.getTrue();
+    for (int64 i = 0; i < rank; ++i) {
+      llvm_ir::IrArray::Index dim_index({ir_builder_.getInt64(i)});
+      llvm::Value* start_index = ir_builder_.CreateZExtOrBitCast(
+          start_indices_array.EmitReadArrayElement(dim_index, &ir_builder_),
+          index[i]->getType());
+      output_index[i] = ir_builder_.CreateAdd(start_index, index[i]);
+      in_bounds = ir_builder_.CreateAnd(
+          in_bounds,
+          ir_builder_.CreateICmpULT(
+              output_index[i],
+              llvm::ConstantInt::get(index[i]->getType(),
+                                     output_shape.dimensions(i))),
+          "in_bounds");
+    }
+    llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
+        in_bounds, "in_bounds", &ir_builder_, /*emit_else=*/false);
+    llvm_ir::SetToFirstInsertPoint(if_data.true_block, &ir_builder_);
+    target_array.EmitWriteArrayElement(
+        output_index, update_array.EmitReadArrayElement(index, &ir_builder_),
+        &ir_builder_);
+    llvm_ir::SetToFirstInsertPoint(if_data.after_block, &ir_builder_);
+    return Status::OK();
+  };
+  return llvm_ir::LoopEmitter(loop_body_emitter, update->shape(), &ir_builder_)
+      .EmitLoop();
+}
+
 // If `hlo` is a Transpose, returns its operand; otherwise returns `hlo` itself.
 static const HloInstruction* StripTranspose(const HloInstruction& hlo) {
   if (hlo.IsRank2Transpose()) {
@@ -1245,8 +1579,66 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
     TF_RETURN_IF_ERROR(DotOpEmitter::EmitDotOperation(
         *dot, dot->operand(0)->IsRank2Transpose(),
         dot->operand(1)->IsRank2Transpose(), target_array, lhs_array, rhs_array,
+        /*epilogue_generator=*/nullptr, GetVectorRegisterByteSize(),
         GetExecutableRunOptionsArgument(), &ir_builder_));
 
+    emitted_value_[fusion] = target_address;
+    return Status::OK();
+  } else if (fusion->fusion_kind() == HloInstruction::FusionKind::kOutput) {
+    // The fused dot is emitted by DotOpEmitter, which applies its fused
+    // elementwise consumers to its result as an epilogue.
+    const HloInstruction* dot = nullptr;
+    for (const auto& fused_instruction : fusion->fused_instructions()) {
+      if (fused_instruction->opcode() == HloOpcode::kDot) {
+        TF_RET_CHECK(dot == nullptr);
+        dot = fused_instruction.get();
+      }
+    }
+    TF_RET_CHECK(dot != nullptr &&
+                 dot->operand(0)->opcode() == HloOpcode::kParameter &&
+                 dot->operand(1)->opcode() == HloOpcode::kParameter);
+    const HloInstruction* lhs =
+        fusion->operand(dot->operand(0)->parameter_number());
+    const HloInstruction* rhs =
+        fusion->operand(dot->operand(1)->parameter_number());
+
+    TF_RETURN_IF_ERROR(ElementTypesSameAndSupported(
+        /*instruction=*/*dot, /*operands=*/{lhs, rhs},
+        /*supported_types=*/{F32}));
+
+    llvm_ir::IrArray lhs_array(GetIrArrayForOp(lhs));
+    llvm_ir::IrArray rhs_array(GetIrArrayForOp(rhs));
+
+    Shape target_shape = fusion->shape();
+    TF_ASSIGN_OR_RETURN(llvm::Value * target_address,
+                        EmitTargetAddressForOp(fusion));
+    llvm_ir::IrArray target_array(target_address, target_shape);
+    AddAliasingInformationToIrArray(*fusion, &target_array);
+
+    std::vector<llvm_ir::IrArray> parameter_arrays;
+    for (HloInstruction* operand : fusion->operands()) {
+      parameter_arrays.push_back(GetIrArrayForOp(operand));
+    }
+    CpuElementalIrEmitter elemental_emitter(hlo_module_config_, &ir_builder_,
+                                            module_);
+    FusedIrEmitter fused_emitter(parameter_arrays, &elemental_emitter);
+    fused_emitter.BindInstructionToArray(dot, target_array);
+    TF_RETURN_IF_ERROR(fusion->fused_expression_root()->Accept(&fused_emitter));
+
+    VLOG(2) << "HandleFusion kOutput: ";
+    VLOG(2) << "  lhs operand: "
+            << llvm_ir::DumpToString(*lhs_array.GetBasePointer());
+    VLOG(2) << "  rhs operand: "
+            << llvm_ir::DumpToString(*rhs_array.GetBasePointer());
+    VLOG(2) << "  target: "
+            << llvm_ir::DumpToString(*target_array.GetBasePointer());
+
+    TF_RETURN_IF_ERROR(DotOpEmitter::EmitDotOperation(
+        *dot, /*transpose_lhs=*/false, /*transpose_rhs=*/false, target_array,
+        lhs_array, rhs_array, fused_emitter.GetRootGenerator(),
+        GetVectorRegisterByteSize(), GetExecutableRunOptionsArgument(),
+        &ir_builder_));
+
     emitted_value_[fusion] = target_address;
     return Status::OK();
   } else if (fusion->fusion_kind() == HloInstruction::FusionKind::kLoop) {
@@ -1571,6 +1963,13 @@ llvm::Argument* IrEmitter::GetProfileCountersArgument() {
   return hlo_to_profile_idx_ ? GetArg(compute_function_, 4) : nullptr;
 }
 
+llvm::Argument* IrEmitter::GetDynamicLoopBoundsArgument() {
+  if (!has_dynamic_loop_bounds_) {
+    return nullptr;
+  }
+  return GetArg(compute_function_, hlo_to_profile_idx_ ? 5 : 4);
+}
+
 llvm::Value* IrEmitter::GetTempBuffersArgument() {
   return GetArg(compute_function_, 3);
 }
@@ -1738,9 +2137,18 @@ Status IrEmitter::EmitTargetElementLoop(
   llvm_ir::IrArray target_array(target_address, target_shape);
   AddAliasingInformationToIrArray(*target_op, &target_array);
 
-  TF_RETURN_IF_ERROR(
-      llvm_ir::LoopEmitter(element_generator, target_array, &ir_builder_)
-          .EmitLoop());
+  if (auto* dynamic_loop_bounds = GetDynamicLoopBoundsArgument()) {
+    // The function only computes a range of the root, see
+    // ParallelTaskAssignment.
+    TF_RET_CHECK(target_op == target_op->parent()->root_instruction());
+    TF_RETURN_IF_ERROR(ParallelLoopEmitter(element_generator, target_array,
+                                           dynamic_loop_bounds, &ir_builder_)
+                           .EmitLoop());
+  } else {
+    TF_RETURN_IF_ERROR(
+        llvm_ir::LoopEmitter(element_generator, target_array, &ir_builder_)
+            .EmitLoop());
+  }
   emitted_value_[target_op] = target_address;
   return Status::OK();
 }
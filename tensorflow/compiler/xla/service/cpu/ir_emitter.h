@@ -27,6 +27,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/IRBuilder.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/IR/Value.h"
+#include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
@@ -60,10 +61,13 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // llvm_module: the LLVM module to emit IR into.
   // hlo_to_profile_idx: the mapping from HLO to its index in the profiling
   //                     array.
+  // target_machine: the target the code is generated for, which decides the
+  //                 width of the vector instructions emitted explicitly.
   IrEmitter(const HloModule& hlo_module, const HloModuleConfig& module_config,
             const BufferAssignment& assignment, llvm::Module* llvm_module,
             const std::unordered_map<const HloInstruction*, size_t>*
-                hlo_to_profile_idx);
+                hlo_to_profile_idx,
+            llvm::TargetMachine* target_machine);
   ~IrEmitter() override;
 
   // Emit and return the given HLO computation as an LLVM IR
@@ -73,11 +77,15 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // is the entry computation of the HLO module. If 'instruction_order' is given
   // then the HLO instructions are emitted in the given order.  In this case,
   // 'instruction_order' must be a topological sort of the set of nodes
-  // accessible from the root of the computation.
+  // accessible from the root of the computation. If 'has_dynamic_loop_bounds'
+  // is true, the function takes an extra "dynamic_loop_bounds" argument, and
+  // only computes the range of the most-major dimension of the root it points
+  // to, see ParallelLoopEmitter.
   StatusOr<llvm::Function*> EmitComputation(
       HloComputation* computation, const string& function_name_prefix,
       bool is_entry_computation,
-      std::vector<const HloInstruction*>* instruction_order = nullptr);
+      std::vector<const HloInstruction*>* instruction_order = nullptr,
+      bool has_dynamic_loop_bounds = false);
 
  protected:
   //
@@ -116,6 +124,10 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   Status HandleSend(HloInstruction* send) override;
   Status HandleRecv(HloInstruction* recv) override;
   Status HandlePad(HloInstruction* pad) override;
+  Status HandleDynamicUpdateSlice(HloInstruction* dynamic_update_slice,
+                                  HloInstruction* operand,
+                                  HloInstruction* update,
+                                  HloInstruction* start_indices) override;
   Status HandleTuple(
       HloInstruction* tuple,
       tensorflow::gtl::ArraySlice<HloInstruction*> operands) override;
@@ -138,7 +150,8 @@ class IrEmitter : public DfsHloVisitorWithDefault {
  private:
   // Private helper to initialize an IR function for the computation.
   void InitializeIrFunction(const string& function_name,
-                            bool is_entry_computation);
+                            bool is_entry_computation,
+                            bool has_dynamic_loop_bounds);
 
   // Convenience function to generate a GEP into the profile counter parameter
   // which would correspond to the index for a given HLO.
@@ -169,6 +182,10 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // computation function being emitted by this emitter.
   llvm::Argument* GetProfileCountersArgument();
 
+  // Get the llvm::Value* that represents the "dynamic_loop_bounds" argument of
+  // the computation function being emitted, or nullptr if it has none.
+  llvm::Argument* GetDynamicLoopBoundsArgument();
+
   // Get the xla::ExecutableRunOptions that represents the "run_options"
   // argument of the computation function being emitted by this emitter.
   llvm::Value* GetExecutableRunOptionsArgument();
@@ -247,6 +264,23 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       HloInstruction* target_op,
       const llvm_ir::ElementGenerator& element_generator);
 
+  // Emits the reduction of 'arg' over 'dimensions', which include its
+  // most-minor dimension, with vectors of 'vector_width' elements. The
+  // elements of the minor dimension are combined by several vector
+  // accumulators, which are reduced horizontally at the end.
+  Status EmitVectorizedReduce(HloInstruction* reduce, HloInstruction* arg,
+                              HloInstruction* init_value,
+                              tensorflow::gtl::ArraySlice<int64> dimensions,
+                              HloOpcode reduction_opcode, int64 vector_width);
+
+  // Emits the binary operation of a vectorized reduction, on scalars or
+  // vectors.
+  llvm::Value* EmitReductionOperation(HloOpcode opcode, llvm::Value* lhs,
+                                      llvm::Value* rhs);
+
+  // Returns the size of the vector registers of the target, e.g. 32 with AVX.
+  int64 GetVectorRegisterByteSize();
+
   // Emits a memcpy from the source instruction's result value to the
   // destination's.  Both source and destination must have an entry in the
   // emitted_value_ table.
@@ -280,6 +314,9 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // The target architecture.
   llvm::Triple::ArchType arch_type_;
 
+  // The target the code is generated for.
+  llvm::TargetMachine* target_machine_;
+
   // Used to produce unique names for generated functions.
   NameUniquer name_uniquer_;
 
@@ -294,6 +331,7 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // The following fields track the IR emission state. According to LLVM memory
   // management rules, their memory is owned by the module.
   llvm::Function* compute_function_;
+  bool has_dynamic_loop_bounds_ = false;
   llvm::IRBuilder<> ir_builder_;
 
   // Maps HLOs to their index into the profile counter array.
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <iterator>
 #include <list>
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_module_config.h"
@@ -62,18 +64,25 @@ ParallelCpuExecutable::ParallelCpuExecutable(
     std::unique_ptr<std::map<HloInstruction*, string>> function_names,
     std::unordered_map<const HloInstruction*, size_t> hlo_to_profile_idx,
     std::unordered_map<const HloInstruction*, std::unique_ptr<unsigned char[]>>
-        aligned_constants)
+        aligned_constants,
+    std::unordered_map<const HloInstruction*, int64> parallel_task_counts)
     : Executable(std::move(hlo_module), std::move(module_config)),
       jit_(std::move(jit)),
       assignment_(std::move(assignment)),
       functions_names_(std::move(function_names)),
       hlo_to_profile_idx_(std::move(hlo_to_profile_idx)),
-      aligned_constants_(std::move(aligned_constants)) {}
+      aligned_constants_(std::move(aligned_constants)),
+      parallel_task_counts_(std::move(parallel_task_counts)) {}
 
 // Type of the computation function we expect in the JIT.
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      uint64*);
 
+// Type of the computation functions of the instructions split into several
+// tasks, which take the range of the most-major dimension to compute.
+using ParallelComputeFunctionType = void (*)(void*, const void*, const void**,
+                                             void**, uint64*, int64*);
+
 // Given a pointer to an output buffer (following the CPU JIT calling
 // conventions), mark addresses that are "live". The initial pointer itself is
 // trivially live. If the shape of the buffer is a tuple, this analysis looks
@@ -218,6 +227,14 @@ Status ParallelCpuExecutable::ExecuteComputeFunctions(
   tensorflow::mutex completion_queue_lock;
   tensorflow::condition_variable completion_queue_cv;
   std::deque<HloInstruction*> completion_queue;
+  // Pushes a completed HLO instruction on the queue, the main thread will pop
+  // it off and potentially launch more work which uses the result.
+  auto complete = [&completion_queue, &completion_queue_lock,
+                   &completion_queue_cv](HloInstruction* instruction) {
+    tensorflow::mutex_lock l(completion_queue_lock);
+    completion_queue.push_back(instruction);
+    completion_queue_cv.notify_all();
+  };
   int64 instructions_in_flight = 0;
   while (!pending.empty() || instructions_in_flight > 0) {
     auto pending_it = pending.begin();
@@ -250,23 +267,45 @@ Status ParallelCpuExecutable::ExecuteComputeFunctions(
                        return FindOrDie(results, operand);
                      });
       auto function = FindOrDie(functions, instruction);
-      // The thread pool entry takes ownership of |operand_buffers|.
-      thread_pool->Schedule([instruction, &completion_queue,
-                             &completion_queue_lock, &completion_queue_cv,
-                             result_buffer, run_options, operand_buffers,
-                             temps_array, profile_counters_array, function] {
-        function(result_buffer, run_options, operand_buffers, temps_array,
-                 profile_counters_array);
-        delete[] operand_buffers;
-        // Push the completed HLO instruction on the queue, the main thread
-        // will pop it off and potentially launch more work which uses the
-        // result.
-        {
-          tensorflow::mutex_lock l(completion_queue_lock);
-          completion_queue.push_back(instruction);
-          completion_queue_cv.notify_all();
+      auto task_count_it = parallel_task_counts_.find(instruction);
+      const int64 task_count = task_count_it == parallel_task_counts_.end()
+                                   ? 1
+                                   : task_count_it->second;
+      if (task_count > 1) {
+        // The tasks are scheduled independently, so that idle threads of the
+        // pool pick them up while the others are busy. The last one to finish
+        // takes care of |operand_buffers| and completes the instruction.
+        auto parallel_function =
+            reinterpret_cast<ParallelComputeFunctionType>(function);
+        auto* tasks_remaining = new std::atomic<int64>(task_count);
+        for (const auto& bounds :
+             ParallelTaskAssignment::GetTaskBounds(*instruction, task_count)) {
+          thread_pool->Schedule([instruction, &complete, result_buffer,
+                                 run_options, operand_buffers, temps_array,
+                                 profile_counters_array, parallel_function,
+                                 bounds, tasks_remaining] {
+            int64 dynamic_loop_bounds[2] = {bounds.first, bounds.second};
+            parallel_function(result_buffer, run_options, operand_buffers,
+                              temps_array, profile_counters_array,
+                              dynamic_loop_bounds);
+            if (--*tasks_remaining == 0) {
+              delete tasks_remaining;
+              delete[] operand_buffers;
+              complete(instruction);
+            }
+          });
         }
-      });
+      } else {
+        // The thread pool entry takes ownership of |operand_buffers|.
+        thread_pool->Schedule([instruction, &complete, result_buffer,
+                               run_options, operand_buffers, temps_array,
+                               profile_counters_array, function] {
+          function(result_buffer, run_options, operand_buffers, temps_array,
+                   profile_counters_array);
+          delete[] operand_buffers;
+          complete(instruction);
+        });
+      }
 
       ++instructions_in_flight;
       pending_it = pending.erase(pending_it);
@@ -46,6 +46,10 @@ namespace cpu {
 //
 // Wraps a JIT-ed object that can be executed "on device". We JIT for the host
 // architecture, so JIT-ed code and host code share the same ABI.
+//
+// The instructions in 'parallel_task_counts' are split into that many tasks,
+// each computing a range of the most-major dimension of the result, see
+// ParallelTaskAssignment.
 class ParallelCpuExecutable : public Executable {
  public:
   ParallelCpuExecutable(
@@ -57,7 +61,8 @@ class ParallelCpuExecutable : public Executable {
       std::unordered_map<const HloInstruction*, size_t> hlo_to_profile_idx,
       std::unordered_map<const HloInstruction*,
                          std::unique_ptr<unsigned char[]>>
-          aligned_constants);
+          aligned_constants,
+      std::unordered_map<const HloInstruction*, int64> parallel_task_counts);
   ~ParallelCpuExecutable() override {}
 
   StatusOr<perftools::gputools::DeviceMemoryBase> ExecuteOnStream(
@@ -138,6 +143,10 @@ class ParallelCpuExecutable : public Executable {
   std::unordered_map<const HloInstruction*, std::unique_ptr<unsigned char[]>>
       aligned_constants_;
 
+  // The number of tasks computing each of the instructions split into more
+  // than one task.
+  const std::unordered_map<const HloInstruction*, int64> parallel_task_counts_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ParallelCpuExecutable);
 };
 
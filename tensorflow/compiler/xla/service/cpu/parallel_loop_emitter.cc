@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
+
+#include <memory>
+
+#include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+
+ParallelLoopEmitter::ParallelLoopEmitter(
+    const llvm_ir::ElementGenerator& target_element_generator,
+    const llvm_ir::IrArray& target_array, llvm::Value* dynamic_loop_bounds,
+    llvm::IRBuilder<>* ir_builder)
+    : LoopEmitter(target_element_generator, target_array, ir_builder),
+      dynamic_loop_bounds_(dynamic_loop_bounds) {}
+
+llvm_ir::IrArray::Index ParallelLoopEmitter::EmitIndexAndSetExitBasicBlock() {
+  CHECK(!ShapeUtil::IsTuple(shape_));
+  CHECK(!ShapeUtil::IsScalar(shape_));
+
+  // Loops are added from the most-major dimension down to the most-minor one,
+  // as in LoopEmitter. Only the first one has dynamic bounds.
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  llvm_ir::IrArray::Index array_index(shape_.dimensions_size());
+  const int64 num_dims = shape_.layout().minor_to_major_size();
+  for (int i = num_dims - 1; i >= 0; --i) {
+    const int64 dimension = shape_.layout().minor_to_major(i);
+    const string suffix = tensorflow::strings::Printf("dim.%lld", dimension);
+    std::unique_ptr<llvm_ir::ForLoop> loop;
+    if (i == num_dims - 1) {
+      llvm::Value* start_index = ir_builder_->CreateLoad(
+          ir_builder_->CreateGEP(dynamic_loop_bounds_,
+                                 ir_builder_->getInt64(0)),
+          "start_index");
+      llvm::Value* end_index = ir_builder_->CreateLoad(
+          ir_builder_->CreateGEP(dynamic_loop_bounds_,
+                                 ir_builder_->getInt64(1)),
+          "end_index");
+      loop = loop_nest.AddLoop(suffix, start_index, end_index);
+    } else {
+      loop = loop_nest.AddLoop(/*start_index=*/0,
+                               /*end_index=*/shape_.dimensions(dimension),
+                               suffix);
+    }
+    array_index[dimension] = loop->GetIndVarValue();
+  }
+
+  // Set IR builder insertion point to the loop body basic block of the
+  // innermost loop.
+  llvm::BasicBlock* innermost_body_bb = loop_nest.GetInnerLoopBodyBasicBlock();
+  ir_builder_->SetInsertPoint(innermost_body_bb,
+                              innermost_body_bb->getFirstInsertionPt());
+
+  // Set exit_bb_ to the exit block of the loop nest.
+  exit_bb_ = loop_nest.GetOuterLoopExitBasicBlock();
+  CHECK_NOTNULL(exit_bb_);
+
+  return array_index;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,127 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+
+#include <algorithm>
+
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// The minimum cost of a task, in flops and bytes accessed, so that running it
+// on another thread pays off: roughly ten microseconds of work.
+constexpr int64 kMinCostPerTask = 1 << 16;
+
+// Transcendental functions take roughly as long as this many flops.
+constexpr int64 kTranscendentalCost = 16;
+
+// Returns the size of the most-major dimension of 'shape'.
+int64 MostMajorDimensionSize(const Shape& shape) {
+  return shape.dimensions(LayoutUtil::Major(shape.layout(), 0));
+}
+
+}  // namespace
+
+ParallelTaskAssignment::ParallelTaskAssignment(
+    int64 max_parallelism, const HloCostAnalysis::ShapeSizeFunction& shape_size)
+    : max_parallelism_(max_parallelism), shape_size_(shape_size) {}
+
+/* static */ const HloInstruction*
+ParallelTaskAssignment::GetPartitionableInstruction(
+    const HloInstruction& call) {
+  if (call.opcode() != HloOpcode::kCall) {
+    return nullptr;
+  }
+  const HloComputation* computation = call.to_apply();
+  const HloInstruction* root = computation->root_instruction();
+  for (const auto& instruction : computation->instructions()) {
+    if (instruction.get() != root &&
+        instruction->opcode() != HloOpcode::kParameter &&
+        instruction->opcode() != HloOpcode::kConstant) {
+      return nullptr;
+    }
+  }
+  if (ShapeUtil::IsTuple(root->shape()) || ShapeUtil::IsScalar(root->shape()) ||
+      !LayoutUtil::HasLayout(root->shape())) {
+    return nullptr;
+  }
+  // The instructions whose output is emitted by a single loop nest over its
+  // elements, see IrEmitter::EmitTargetElementLoop.
+  switch (root->opcode()) {
+    case HloOpcode::kParameter:
+    case HloOpcode::kConstant:
+    case HloOpcode::kBitcast:
+      return nullptr;
+    case HloOpcode::kFusion:
+      return root->fusion_kind() == HloInstruction::FusionKind::kLoop
+                 ? root
+                 : nullptr;
+    case HloOpcode::kBroadcast:
+    case HloOpcode::kConcatenate:
+    case HloOpcode::kMap:
+    case HloOpcode::kReduce:
+    case HloOpcode::kReduceWindow:
+    case HloOpcode::kReverse:
+    case HloOpcode::kSlice:
+    case HloOpcode::kTranspose:
+      return root;
+    default:
+      return root->IsElementwise() ? root : nullptr;
+  }
+}
+
+int64 ParallelTaskAssignment::GetTargetParallelTaskCount(
+    const HloInstruction& call) const {
+  if (max_parallelism_ <= 1 || GetPartitionableInstruction(call) == nullptr) {
+    return 1;
+  }
+  HloCostAnalysis cost_analysis(shape_size_);
+  if (!call.to_apply()->root_instruction()->Accept(&cost_analysis).ok()) {
+    return 1;
+  }
+  const int64 cost =
+      cost_analysis.flop_count() +
+      kTranscendentalCost * cost_analysis.transcendental_count() +
+      cost_analysis.bytes_accessed();
+  const int64 task_count =
+      std::min({max_parallelism_, MostMajorDimensionSize(call.shape()),
+                cost / kMinCostPerTask});
+  VLOG(2) << "Cost of " << call.name() << ": " << cost << ", " << task_count
+          << " tasks";
+  return std::max<int64>(1, task_count);
+}
+
+/* static */ std::vector<std::pair<int64, int64>>
+ParallelTaskAssignment::GetTaskBounds(const HloInstruction& call,
+                                      int64 task_count) {
+  const int64 size = MostMajorDimensionSize(call.shape());
+  std::vector<std::pair<int64, int64>> bounds;
+  bounds.reserve(task_count);
+  for (int64 i = 0; i < task_count; ++i) {
+    bounds.emplace_back(i * size / task_count, (i + 1) * size / task_count);
+  }
+  return bounds;
+}
+
+}  // namespace cpu
+}  // namespace xla
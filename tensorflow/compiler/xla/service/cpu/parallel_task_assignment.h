@@ -0,0 +1,64 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace cpu {
+
+// Chooses how many tasks ParallelCpuExecutable splits the calls of the entry
+// computation into, so that large instructions run on many threads instead of
+// one.
+//
+// A call is split only if the computation it calls, outlined by
+// ParallelizationPreparation, is a single instruction whose elements are
+// computed independently of each other by one loop nest. Each task then
+// computes a range of the most-major dimension of the output.
+class ParallelTaskAssignment {
+ public:
+  // 'max_parallelism' is the maximum number of tasks per call.
+  ParallelTaskAssignment(int64 max_parallelism,
+                         const HloCostAnalysis::ShapeSizeFunction& shape_size);
+
+  // Returns the number of tasks to split 'call' into, or 1 if it must run as
+  // a single task.
+  int64 GetTargetParallelTaskCount(const HloInstruction& call) const;
+
+  // Returns the start and end of the range of the most-major dimension of the
+  // output of 'call' computed by each of its 'task_count' tasks.
+  static std::vector<std::pair<int64, int64>> GetTaskBounds(
+      const HloInstruction& call, int64 task_count);
+
+ private:
+  // Returns the instruction computed by 'call' if its tasks can be split.
+  static const HloInstruction* GetPartitionableInstruction(
+      const HloInstruction& call);
+
+  const int64 max_parallelism_;
+  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_TASK_ASSIGNMENT_H_
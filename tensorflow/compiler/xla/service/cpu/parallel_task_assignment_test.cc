@@ -0,0 +1,115 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+
+#include <utility>
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/util.h"
+
+#include "tensorflow/compiler/xla/test_helpers.h"
+
+namespace xla {
+namespace cpu {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+constexpr int64 kMaxParallelism = 8;
+
+class ParallelTaskAssignmentTest : public HloTestBase {
+ protected:
+  ParallelTaskAssignmentTest()
+      : task_assignment_(kMaxParallelism, [](const Shape& shape) {
+          return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+        }) {}
+
+  // Adds to module_ a call of a computation applying 'opcode' to a parameter
+  // of the given shape, and returns the call.
+  HloInstruction* AddCall(HloOpcode opcode, const Shape& shape) {
+    auto called_builder = HloComputation::Builder(TestName() + ".called");
+    auto param = called_builder.AddInstruction(
+        HloInstruction::CreateParameter(0, shape, "param"));
+    called_builder.AddInstruction(
+        HloInstruction::CreateUnary(shape, opcode, param));
+    HloComputation* called =
+        module_->AddEmbeddedComputation(called_builder.Build());
+
+    auto builder = HloComputation::Builder(TestName());
+    auto arg = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, shape, "arg"));
+    HloInstruction* call = builder.AddInstruction(
+        HloInstruction::CreateCall(shape, {arg}, called));
+    module_->AddEntryComputation(builder.Build());
+    return call;
+  }
+
+  std::unique_ptr<HloModule> module_ = MakeUnique<HloModule>(TestName());
+  ParallelTaskAssignment task_assignment_;
+};
+
+TEST_F(ParallelTaskAssignmentTest, LargeElementwiseCallIsSplit) {
+  HloInstruction* call =
+      AddCall(HloOpcode::kExp, ShapeUtil::MakeShape(F32, {1024, 1024}));
+  EXPECT_EQ(kMaxParallelism,
+            task_assignment_.GetTargetParallelTaskCount(*call));
+}
+
+TEST_F(ParallelTaskAssignmentTest, SmallCallIsNotSplit) {
+  HloInstruction* call =
+      AddCall(HloOpcode::kExp, ShapeUtil::MakeShape(F32, {4, 4}));
+  EXPECT_EQ(1, task_assignment_.GetTargetParallelTaskCount(*call));
+}
+
+TEST_F(ParallelTaskAssignmentTest, TasksAreLimitedByTheMostMajorDimension) {
+  HloInstruction* call =
+      AddCall(HloOpcode::kExp, ShapeUtil::MakeShape(F32, {2, 1024 * 1024}));
+  EXPECT_EQ(2, task_assignment_.GetTargetParallelTaskCount(*call));
+}
+
+TEST_F(ParallelTaskAssignmentTest, TupleCallIsNotSplit) {
+  const Shape shape = ShapeUtil::MakeShape(F32, {1024, 1024});
+  const Shape tuple_shape = ShapeUtil::MakeTupleShape({shape});
+  auto called_builder = HloComputation::Builder(TestName() + ".called");
+  auto param = called_builder.AddInstruction(
+      HloInstruction::CreateParameter(0, shape, "param"));
+  called_builder.AddInstruction(HloInstruction::CreateTuple({param}));
+  HloComputation* called =
+      module_->AddEmbeddedComputation(called_builder.Build());
+
+  auto builder = HloComputation::Builder(TestName());
+  auto arg =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "arg"));
+  HloInstruction* call = builder.AddInstruction(
+      HloInstruction::CreateCall(tuple_shape, {arg}, called));
+  module_->AddEntryComputation(builder.Build());
+  EXPECT_EQ(1, task_assignment_.GetTargetParallelTaskCount(*call));
+}
+
+TEST_F(ParallelTaskAssignmentTest, TaskBoundsCoverTheMostMajorDimension) {
+  HloInstruction* call =
+      AddCall(HloOpcode::kExp, ShapeUtil::MakeShape(F32, {10, 4}));
+  EXPECT_THAT(ParallelTaskAssignment::GetTaskBounds(*call, 3),
+              ElementsAre(Pair(0, 3), Pair(3, 6), Pair(6, 10)));
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -21,9 +21,15 @@ limitations under the License.
 #include <list>
 #include <utility>
 
+#include "external/llvm/include/llvm/Bitcode/BitcodeReader.h"
+#include "external/llvm/include/llvm/Bitcode/BitcodeWriter.h"
+#include "external/llvm/include/llvm/IR/LLVMContext.h"
 #include "external/llvm/include/llvm/IR/Mangler.h"
 #include "external/llvm/include/llvm/Support/CodeGen.h"
 #include "external/llvm/include/llvm/Support/Host.h"
+#include "external/llvm/include/llvm/Support/MemoryBuffer.h"
+#include "external/llvm/include/llvm/Support/raw_ostream.h"
+#include "external/llvm/include/llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
@@ -34,6 +40,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_conv2d.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -138,18 +146,28 @@ CompilerFunctor::VectorIntrinsics GetAvailableIntrinsics() {
   return intrinsics;
 }
 
+// Returns true if the module defines a function or a global variable.
+bool HasDefinitions(const llvm::Module &module) {
+  for (const llvm::Function &function : module.functions()) {
+    if (!function.isDeclaration()) {
+      return true;
+    }
+  }
+  for (const llvm::GlobalVariable &global : module.globals()) {
+    if (!global.isDeclaration()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions &target_options,
                            llvm::CodeGenOpt::Level opt_level)
-    : target_machine_(
-          CHECK_NOTNULL(llvm::EngineBuilder()
-                            .setTargetOptions(target_options)
-                            .setOptLevel(opt_level)
-                            .selectTarget(
-                                /*TargetTriple=*/llvm::Triple(), /*MArch=*/"",
-                                /*MCPU=*/GetHostCpuName(),
-                                /*MAttrs=*/DetectMachineAttributes()))),
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      target_machine_(CreateTargetMachine()),
       disassembler_(*target_machine_),
       data_layout_(target_machine_->createDataLayout()),
       compile_layer_(object_layer_,
@@ -172,12 +190,85 @@ SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModule(
   return handle;
 }
 
+SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModuleInParallel(
+    std::unique_ptr<llvm::Module> module, int num_partitions) {
+  if (num_partitions <= 1) {
+    return AddModule(std::move(module));
+  }
+
+  // An LLVMContext must not be used by several threads at once either, so
+  // each partition is written out as bitcode here and read back into a
+  // context of its own by the thread compiling it.
+  std::vector<std::string> partitions;
+  llvm::SplitModule(std::move(module), num_partitions,
+                    [&partitions](std::unique_ptr<llvm::Module> partition) {
+                      if (!HasDefinitions(*partition)) {
+                        return;
+                      }
+                      std::string bitcode;
+                      llvm::raw_string_ostream bitcode_stream(bitcode);
+                      llvm::WriteBitcodeToFile(partition.get(),
+                                               bitcode_stream);
+                      bitcode_stream.flush();
+                      partitions.push_back(std::move(bitcode));
+                    },
+                    /*PreserveLocals=*/true);
+  VLOG(1) << "Compiling " << partitions.size()
+          << " module partitions concurrently";
+
+  std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines;
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    target_machines.push_back(CreateTargetMachine());
+  }
+  std::vector<
+      std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>>
+      objects(partitions.size());
+  {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_compile", partitions.size());
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      pool.Schedule([this, i, &partitions, &target_machines, &objects]() {
+        llvm::LLVMContext context;
+        llvm::Expected<std::unique_ptr<llvm::Module>> partition_or_error =
+            llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(partitions[i], "partition"), context);
+        CHECK(partition_or_error) << "Invalid module partition";
+        const Disassembler disassembler(*target_machines[i]);
+        CompilerFunctor compiler(target_machines[i].get(), &disassembler,
+                                 opt_level_, GetAvailableIntrinsics());
+        objects[i] =
+            MakeUnique<llvm::object::OwningBinary<llvm::object::ObjectFile>>(
+                compiler(*partition_or_error.get()));
+      });
+    }
+  }
+
+  // All the object files are loaded by the same linker, which resolves the
+  // references between the partitions.
+  auto handle = object_layer_.addObjectSet(
+      std::move(objects), MakeUnique<llvm::SectionMemoryManager>(),
+      MakeUnique<SimpleResolver>());
+  module_handles_.push_back(handle);
+  return handle;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::ModuleHandleT handle) {
   module_handles_.erase(
       std::remove(module_handles_.begin(), module_handles_.end(), handle));
   compile_layer_.removeModuleSet(handle);
 }
 
+std::unique_ptr<llvm::TargetMachine> SimpleOrcJIT::CreateTargetMachine() const {
+  return std::unique_ptr<llvm::TargetMachine>(
+      CHECK_NOTNULL(llvm::EngineBuilder()
+                        .setTargetOptions(target_options_)
+                        .setOptLevel(opt_level_)
+                        .selectTarget(
+                            /*TargetTriple=*/llvm::Triple(), /*MArch=*/"",
+                            /*MCPU=*/GetHostCpuName(),
+                            /*MAttrs=*/DetectMachineAttributes())));
+}
+
 llvm::JITSymbol SimpleOrcJIT::FindSymbol(const std::string &name) {
   std::string mangled_name;
   {
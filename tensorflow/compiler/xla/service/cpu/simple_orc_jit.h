@@ -62,10 +62,20 @@ class SimpleOrcJIT {
     return target_machine_->getTargetTriple();
   }
 
+  // Target machine (host) this JIT generates code for.
+  llvm::TargetMachine* target_machine() const { return target_machine_.get(); }
+
   // Add a module to the JIT. Returns an opaque handle that can be used to later
   // remove this module.
   ModuleHandleT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Like AddModule, but splits the module into up to |num_partitions| modules
+  // that are optimized and compiled concurrently, and then linked together.
+  // Internal functions stay in the partition of the functions calling them,
+  // so that they can still be inlined into their callers.
+  ModuleHandleT AddModuleInParallel(std::unique_ptr<llvm::Module> module,
+                                    int num_partitions);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(ModuleHandleT handle);
 
@@ -74,6 +84,13 @@ class SimpleOrcJIT {
   llvm::JITSymbol FindSymbol(const std::string& name);
 
  private:
+  // Creates a target machine for the host with the options of this JIT. A
+  // target machine must not be used by several threads at once, so each
+  // thread compiling a module partition has one of its own.
+  std::unique_ptr<llvm::TargetMachine> CreateTargetMachine() const;
+
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
   std::vector<ModuleHandleT> module_handles_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const Disassembler disassembler_;
@@ -23,6 +23,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/DiagnosticPrinter.h"
 #include "external/llvm/include/llvm/IR/LLVMContext.h"
 #include "external/llvm/include/llvm/IR/Module.h"
+#include "tensorflow/compiler/xla/legacy_flags/gpu_backend_lib_flags.h"
 #include "tensorflow/compiler/xla/legacy_flags/gpu_compiler_flags.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
 #include "tensorflow/compiler/xla/service/gpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/llvm_gpu_backend/gpu_backend_lib.h"
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/pad_insertion.h"
 #include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
@@ -54,6 +56,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/persistent_cache.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -61,6 +64,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -150,6 +154,7 @@ tensorflow::Status OptimizeHloModule(HloModule* hlo_module,
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false);
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true);
     fusion.AddPass<FusionMerger>();
+    fusion.AddPass<MultiOutputFusion>();
     return fusion.Run(hlo_module).status();
   }
 }
@@ -188,6 +193,27 @@ tensorflow::Status PrepareHloModuleForIrEmitting(
   return pipeline.Run(hlo_module).status();
 }
 
+// Returns the key of the PTX compiled from 'llvm_module' in the
+// PersistentCache: the module and everything its compilation depends on.
+string PtxCacheKey(const llvm::Module& llvm_module,
+                   std::pair<int, int> compute_capability,
+                   const HloModuleConfig& hlo_module_config,
+                   const string& libdevice_dir_path) {
+  legacy_flags::GpuBackendLibFlags* flags =
+      legacy_flags::GetGpuBackendLibFlags();
+  string key = tensorflow::strings::StrCat(
+      compute_capability.first, ".", compute_capability.second, ";");
+  for (bool option : {hlo_module_config.fast_math_disabled(), flags->ftz,
+                      flags->fma, flags->verbose_ptx_asm}) {
+    tensorflow::strings::StrAppend(&key, option ? "1" : "0");
+  }
+  tensorflow::strings::StrAppend(&key, ";", flags->opt_level, ";",
+                                 flags->kernel, ";", flags->llvm_cl_opts, ";",
+                                 libdevice_dir_path, ";",
+                                 llvm_ir::DumpModuleToString(llvm_module));
+  return key;
+}
+
 // Invokes the ptxas tool on the given PTX string, and dumps its output.
 void DumpPtxasInfo(const string& ptx) {
   const string ptxas_path =
@@ -311,8 +337,21 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
     cc_major = 2;
     cc_minor = 0;
   }
-  TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
-                                         *module_config, libdevice_dir_));
+  // Reuse the PTX compiled from the same module by another process. The CUDA
+  // driver caches the code it compiles from the PTX by itself.
+  PersistentCache* cache = PersistentCache::Default();
+  string cache_key;
+  if (cache != nullptr) {
+    cache_key = PtxCacheKey(llvm_module, {cc_major, cc_minor}, *module_config,
+                            libdevice_dir_);
+  }
+  if (cache == nullptr || !cache->Lookup(cache_key, ptx)) {
+    TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
+                                           *module_config, libdevice_dir_));
+    if (cache != nullptr) {
+      cache->Insert(cache_key, *ptx);
+    }
+  }
 
   VLOG(2) << "LLVM module after optimizations:";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(llvm_module));
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_executable.h"
 
+#include <map>
 #include <set>
 #include <utility>
 #include <vector>
@@ -115,7 +116,37 @@ GpuExecutable::GpuExecutable(tensorflow::StringPiece ptx,
     : Executable(std::move(hlo_module), std::move(module_config)),
       ptx_(ptx),
       thunk_schedule_(std::move(thunk_schedule)),
-      assignment_(std::move(assignment)) {}
+      assignment_(std::move(assignment)) {
+  std::map<const Thunk*, int> thunk_to_event;
+  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+    ThunkLaunch launch;
+    launch.thunk = thunk;
+    launch.stream_no =
+        thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
+    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
+      launch.wait_events.push_back(FindOrDie(thunk_to_event, dependency));
+    }
+    launch.record_event = -1;
+    if (thunk_schedule_->Depended(thunk)) {
+      launch.record_event = event_count_++;
+      thunk_to_event[thunk] = launch.record_event;
+    }
+    thunk_launches_.push_back(std::move(launch));
+  }
+}
+
+Pool<se::Event>* GpuExecutable::GetEventPool(se::StreamExecutor* executor) {
+  tensorflow::mutex_lock lock(event_pools_mu_);
+  std::unique_ptr<Pool<se::Event>>& pool = event_pools_[executor];
+  if (pool == nullptr) {
+    pool = MakeUnique<Pool<se::Event>>([executor]() {
+      auto event = MakeUnique<se::Event>(executor);
+      event->Init();
+      return event;
+    });
+  }
+  return pool.get();
+}
 
 Status GpuExecutable::ExecuteThunks(
     const ServiceExecutableRunOptions* run_options,
@@ -137,29 +168,37 @@ Status GpuExecutable::ExecuteThunks(
     TF_ASSIGN_OR_RETURN(
         sub_streams.back(),
         run_options->BorrowStream(main_stream->parent()->device_ordinal()));
+    // The thunks on the substream may read the arguments, which are produced
+    // by the work enqueued on the main stream before this execution.
+    sub_streams.back()->ThenWaitFor(main_stream);
   }
 
-  std::map<const Thunk*, std::unique_ptr<se::Event>> thunk_to_finish_event;
-  for (Thunk* thunk : thunk_schedule_->TotalOrder()) {
+  // Only the thunks other streams depend on record an event, so the streams
+  // are only synchronized along the dependency edges of the schedule.
+  Pool<se::Event>* event_pool = GetEventPool(main_stream->parent());
+  std::vector<Pool<se::Event>::SmartPtr> events;
+  events.reserve(event_count_);
+  for (int i = 0; i < event_count_; ++i) {
+    events.push_back(event_pool->Allocate());
+  }
+
+  for (const ThunkLaunch& launch : thunk_launches_) {
+    Thunk* thunk = launch.thunk;
     TF_RETURN_IF_ERROR(thunk->Initialize(*this));
-    int32 stream_no =
-        thunk_schedule_->StreamNumberForHlo(*thunk->hlo_instruction());
     se::Stream* stream =
-        (stream_no == 0 ? main_stream : sub_streams[stream_no - 1].get());
+        (launch.stream_no == 0 ? main_stream
+                               : sub_streams[launch.stream_no - 1].get());
 
-    for (const Thunk* dependency : thunk_schedule_->DependsOn(thunk)) {
-      stream->ThenWaitFor(FindOrDie(thunk_to_finish_event, dependency).get());
+    for (int event : launch.wait_events) {
+      stream->ThenWaitFor(events[event].get());
     }
 
     profiler.StartOperation();
     VLOG(2) << "Executing the thunk for "
             << thunk->hlo_instruction()->ToString();
     TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(buffer_allocations, stream));
-    if (thunk_schedule_->Depended(thunk)) {
-      auto finish_event = MakeUnique<se::Event>(main_stream->parent());
-      finish_event->Init();
-      stream->ThenRecordEvent(finish_event.get());
-      thunk_to_finish_event[thunk] = std::move(finish_event);
+    if (launch.record_event != -1) {
+      stream->ThenRecordEvent(events[launch.record_event].get());
     }
     profiler.FinishOperation(thunk->hlo_instruction());
   }
@@ -16,8 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_GPU_EXECUTABLE_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/device_memory_allocator.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/compiler/xla/service/pool.h"
 #include "tensorflow/compiler/xla/service/shaped_buffer.h"
 #include "tensorflow/compiler/xla/service/tuple_points_to_analysis.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -36,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 
 namespace xla {
@@ -45,7 +49,8 @@ namespace gpu {
 //
 // Launches the given CUDA kernel via the StreamExecutor.
 //
-// This is an immutable data type after initialization, and thus thread safe.
+// This is an immutable data type after initialization, apart from the
+// internally synchronized pools of events, and thus thread safe.
 class GpuExecutable : public Executable {
  public:
   GpuExecutable(tensorflow::StringPiece ptx,
@@ -96,6 +101,23 @@ class GpuExecutable : public Executable {
   // computation. Uses points-to analysis from buffer assignment.
   const PointsToSet& GetRootPointsToSet() const;
 
+  // Returns the pool of the events signalling the dependencies across streams
+  // on `executor`.
+  Pool<perftools::gputools::Event>* GetEventPool(
+      perftools::gputools::StreamExecutor* executor);
+
+  // One step of the launch of the thunks, which ExecuteThunks replays in order
+  // on every execution rather than walking the thunk schedule again.
+  struct ThunkLaunch {
+    Thunk* thunk;
+    int stream_no;
+    // The events the stream waits for before launching `thunk`, indexing the
+    // events of an execution.
+    std::vector<int> wait_events;
+    // The event recorded after `thunk`, or -1 if no other stream depends on it.
+    int record_event;
+  };
+
   // The LLVM IR, in string format, of the unoptimized module generated for this
   // GpuExecutable. We save a string instead of an llvm::Module* because leaving
   // llvm::Module* in a singleton can cause the heap checker to emit false
@@ -115,6 +137,20 @@ class GpuExecutable : public Executable {
   // memory for every output/temp buffers.
   const std::unique_ptr<BufferAssignment> assignment_;
 
+  // The launch of the thunks in `thunk_schedule_`, and the number of events it
+  // records.
+  std::vector<ThunkLaunch> thunk_launches_;
+  int event_count_ = 0;
+
+  // The events of an execution are taken from the pool of its device and
+  // returned to it once all the thunks are launched: a stream waits for the
+  // last recording of an event at the time the wait is enqueued, so the events
+  // can be recorded again by the next execution right away.
+  tensorflow::mutex event_pools_mu_;
+  std::map<perftools::gputools::StreamExecutor*,
+           std::unique_ptr<Pool<perftools::gputools::Event>>>
+      event_pools_ GUARDED_BY(event_pools_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuExecutable);
 };
 
@@ -358,6 +358,70 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
         LOG(FATAL) << "Bad opcode for input fusion: "
                    << fusion->fused_expression_root()->opcode();
     }
+  } else if (fusion->IsMultiOutputFusion()) {
+    // Loop fusion instruction computing several outputs of the same dimensions,
+    // e.g. sibling elementwise operations reading the same input. The pointers
+    // to the output buffers are written to the tuple buffer of 'fusion' first,
+    // because the kernel and the users of the outputs read them from it.
+    const BufferAssignment& buffer_assignment =
+        ir_emitter_context_->buffer_assignment();
+    std::vector<BufferAllocation::Slice> tuple_element_buffers;
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      TF_ASSIGN_OR_RETURN(BufferAllocation::Slice slice,
+                          buffer_assignment.GetUniqueSlice(fusion, {i}));
+      tuple_element_buffers.push_back(slice);
+    }
+    std::vector<std::unique_ptr<Thunk>> thunks;
+    thunks.emplace_back(MakeUnique<TupleThunk>(
+        tuple_element_buffers, GetAllocationSlice(*fusion), fusion));
+    thunks.emplace_back(BuildKernelThunk(fusion));
+    auto* kernel_thunk = static_cast<KernelThunk*>(thunks.back().get());
+    thunk_sequence_->emplace_back(
+        MakeUnique<SequentialThunk>(std::move(thunks), fusion));
+
+    std::vector<llvm_ir::IrArray> parameter_arrays;
+    for (HloInstruction* operand : fusion->operands()) {
+      parameter_arrays.push_back(GetIrArray(*operand));
+    }
+    GpuElementalIrEmitter elemental_emitter(hlo_module_config_,
+                                            ir_emitter_context_->llvm_module(),
+                                            &ir_builder_, GetNestedComputer());
+    FusedIrEmitter fused_emitter(parameter_arrays, &elemental_emitter);
+    TF_RETURN_IF_ERROR(root->Accept(&fused_emitter));
+
+    // Load the pointers to the output buffers once, ahead of the loop.
+    std::vector<llvm_ir::IrArray> output_arrays;
+    std::vector<llvm_ir::ElementGenerator> output_generators;
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      const Shape& output_shape = fusion->shape().tuple_shapes(i);
+      output_arrays.push_back(llvm_ir::IrArray(
+          llvm_ir::EmitGetTupleElement(output_shape, i, /*alignment=*/1,
+                                       GetBasePointer(*fusion), &ir_builder_),
+          output_shape));
+      output_generators.push_back(fused_emitter.GetGenerator(root->operand(i)));
+    }
+
+    // All the outputs are computed in the same iteration, so that the elements
+    // of the operands they share are only read once.
+    auto loop_body_emitter =
+        [=](const llvm_ir::IrArray::Index& index) -> Status {
+      for (size_t i = 0; i < output_arrays.size(); ++i) {
+        TF_ASSIGN_OR_RETURN(llvm::Value * value, output_generators[i](index));
+        output_arrays[i].EmitWriteArrayElement(index, value, &ir_builder_);
+      }
+      return Status::OK();
+    };
+
+    // The outputs have the same dimensions, so the loop iterates over the
+    // first one.
+    const Shape& loop_shape = fusion->shape().tuple_shapes(0);
+    LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
+        loop_shape, ir_emitter_context_->device_description());
+    UpdateLaunchDimensions(launch_dimensions, kernel_thunk,
+                           ir_emitter_context_->llvm_module());
+    return ParallelLoopEmitter(loop_body_emitter, loop_shape,
+                               launch_dimensions, &ir_builder_)
+        .EmitLoop();
   } else if (HloInstruction::FusionKind::kLoop == fusion->fusion_kind() &&
              root->opcode() == HloOpcode::kDynamicUpdateSlice &&
              CanUpdateDynamicSliceInPlace(
@@ -405,7 +469,9 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
     // *) Map requested 'index' and slice 'start_index' to input/output shape
     //    as 'output_index'.
     // *) Reads value from 'update' element generator.
-    // *) Writes value to input/output array at 'output_index'.
+    // *) Writes value to input/output array at 'output_index', unless it falls
+    //    past the end of a dimension (the elemental emitter drops these
+    //    elements of the update as well).
     auto loop_body_emitter =
         [=](const llvm_ir::IrArray::Index& index) -> Status {
       // Emit IR to read dynamic start indices from hlo->operand(2).
@@ -418,22 +484,30 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
 
       // Calculate 'output_index' at which to write value from update.
       llvm_ir::IrArray::Index output_index(rank);
+      llvm::Value* in_bounds = ir_builder_.getTrue();
       for (int64 i = 0; i < rank; ++i) {
         // Emit IR which computes:
-        //   output_index = (start_index + index) % dim_size
+        //   output_index = start_index + index
+        //   in_bounds &= output_index < dim_size
         llvm::Value* dim_size = llvm::ConstantInt::get(
             index[i]->getType(), input->shape().dimensions(i));
         llvm::Value* start_index0 = ir_builder_.CreateZExtOrBitCast(
             start_index[i], index[i]->getType());
-        output_index[i] = ir_builder_.CreateURem(
-            ir_builder_.CreateAdd(start_index0, index[i]), dim_size);
+        output_index[i] = ir_builder_.CreateAdd(start_index0, index[i]);
+        in_bounds = ir_builder_.CreateAnd(
+            in_bounds, ir_builder_.CreateICmpULT(output_index[i], dim_size),
+            "in_bounds");
       }
 
+      llvm_ir::LlvmIfData if_data = llvm_ir::EmitIfThenElse(
+          in_bounds, "in_bounds", &ir_builder_, /*emit_else=*/false);
+      llvm_ir::SetToFirstInsertPoint(if_data.true_block, &ir_builder_);
       // Read value from 'update'.
       TF_ASSIGN_OR_RETURN(llvm::Value * input_value, element_generator(index));
       // Write value to output array.
       llvm_ir::IrArray(input_base_ptr, input->shape())
           .EmitWriteArrayElement(output_index, input_value, &ir_builder_);
+      llvm_ir::SetToFirstInsertPoint(if_data.after_block, &ir_builder_);
       return Status::OK();
     };
 
@@ -0,0 +1,271 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace xla {
+namespace gpu {
+
+namespace {
+
+// Fusion runs before layout assignment, so the sizes don't depend on the
+// layouts.
+int64 ShapeSizeBytes(const Shape& shape) {
+  return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+}
+
+// Returns whether 'instruction' can be fused with its siblings into a
+// multi-output fusion instruction emitted as one loop over its output.
+bool IsSiblingFusionCandidate(const HloInstruction& instruction) {
+  // The users of the root would have to read it through a GetTupleElement, and
+  // a scalar is too small for the fusion to pay off.
+  if (&instruction == instruction.parent()->root_instruction() ||
+      ShapeUtil::IsTuple(instruction.shape()) ||
+      ShapeUtil::IsScalar(instruction.shape())) {
+    return false;
+  }
+  // The fused siblings are removed from the computation.
+  if (!instruction.control_predecessors().empty() ||
+      !instruction.control_successors().empty()) {
+    return false;
+  }
+  if (instruction.opcode() == HloOpcode::kFusion) {
+    // Loop fusions rooted at DynamicUpdateSlice are emitted in place, and the
+    // other kinds of fusions match specific patterns.
+    return instruction.fusion_kind() == HloInstruction::FusionKind::kLoop &&
+           !instruction.IsMultiOutputFusion() &&
+           instruction.fused_expression_root()->opcode() !=
+               HloOpcode::kDynamicUpdateSlice;
+  }
+  return instruction.IsElementwise() && instruction.operand_count() > 0 &&
+         instruction.opcode() != HloOpcode::kRng &&
+         instruction.opcode() != HloOpcode::kMap && instruction.IsFusable();
+}
+
+// Returns whether 'to' transitively uses the output of 'from'.
+bool Reaches(HloInstruction* from, const HloInstruction* to) {
+  std::vector<HloInstruction*> stack(from->users().begin(),
+                                     from->users().end());
+  std::unordered_set<HloInstruction*> visited(stack.begin(), stack.end());
+  while (!stack.empty()) {
+    HloInstruction* instruction = stack.back();
+    stack.pop_back();
+    if (instruction == to) {
+      return true;
+    }
+    for (HloInstruction* user : instruction->users()) {
+      if (visited.insert(user).second) {
+        stack.push_back(user);
+      }
+    }
+  }
+  return false;
+}
+
+// Returns the bytes saved by reading each operand shared by 'siblings' once.
+double CalculateSavedBytes(const std::vector<HloInstruction*>& siblings) {
+  std::map<const HloInstruction*, int64> readers;
+  for (const HloInstruction* sibling : siblings) {
+    const std::unordered_set<const HloInstruction*> operands(
+        sibling->operands().begin(), sibling->operands().end());
+    for (const HloInstruction* operand : operands) {
+      ++readers[operand];
+    }
+  }
+  double bytes = 0.0;
+  for (const auto& operand_and_readers : readers) {
+    bytes += static_cast<double>(ShapeSizeBytes(
+                 operand_and_readers.first->shape())) *
+             (operand_and_readers.second - 1);
+  }
+  return bytes;
+}
+
+}  // anonymous namespace
+
+// SiblingFuser visits all instructions of 'computation' in post order, fusing
+// the siblings reading the output of each into a multi-output fusion
+// instruction. Accumulates and reports stats on successful/failed attempts.
+class SiblingFuser {
+ public:
+  explicit SiblingFuser(HloComputation* computation)
+      : computation_(computation), cost_analysis_(ShapeSizeBytes) {}
+
+  Status Run();
+
+  bool changed() const { return changed_; }
+
+ private:
+  // Fuses the siblings reading the output of 'operand', if it is profitable.
+  Status FuseSiblingsOf(HloInstruction* operand);
+
+  // Replaces 'siblings' with a multi-output fusion instruction.
+  Status Fuse(const std::vector<HloInstruction*>& siblings);
+
+  HloComputation* computation_;
+  // The costs of the instructions before any of them is fused.
+  HloCostAnalysis cost_analysis_;
+  // The siblings fused so far, which are no longer in the computation.
+  std::unordered_set<const HloInstruction*> fused_;
+  bool changed_ = false;
+
+  // Sibling fusion stats.
+  int total_visited_ = 0;
+  int total_fused_ = 0;
+  int num_fail_no_siblings_ = 0;
+  int num_fail_saved_bytes_ratio_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SiblingFuser);
+};
+
+Status SiblingFuser::Run() {
+  TF_RETURN_IF_ERROR(computation_->Accept(&cost_analysis_));
+  for (auto* instruction : computation_->MakeInstructionPostOrder()) {
+    if (fused_.count(instruction) == 0 && instruction->user_count() > 1 &&
+        !ShapeUtil::IsTuple(instruction->shape())) {
+      TF_RETURN_IF_ERROR(FuseSiblingsOf(instruction));
+    }
+  }
+
+  VLOG(1) << "SiblingFuser EXIT"
+          << " computation: " << computation_->name()
+          << " total_visited: " << total_visited_
+          << " total_fused: " << total_fused_ << " fusion failures { "
+          << " no_siblings: " << num_fail_no_siblings_
+          << " saved_bytes_ratio: " << num_fail_saved_bytes_ratio_ << " }";
+  return Status::OK();
+}
+
+Status SiblingFuser::FuseSiblingsOf(HloInstruction* operand) {
+  ++total_visited_;
+  // Greedily pick the candidates with the dimensions of the first one which
+  // don't depend on each other, lest the fusion instruction uses itself.
+  std::vector<HloInstruction*> siblings;
+  for (HloInstruction* user : operand->users()) {
+    if (!IsSiblingFusionCandidate(*user)) {
+      continue;
+    }
+    if (!siblings.empty() &&
+        !ShapeUtil::SameDimensions(siblings.front()->shape(), user->shape())) {
+      continue;
+    }
+    if (std::all_of(siblings.begin(), siblings.end(),
+                    [user](HloInstruction* sibling) {
+                      return !Reaches(sibling, user) && !Reaches(user, sibling);
+                    })) {
+      siblings.push_back(user);
+    }
+  }
+  if (siblings.size() < 2) {
+    ++num_fail_no_siblings_;
+    return Status::OK();
+  }
+
+  // Skip the siblings if reading their shared operands once saves too few of
+  // the bytes they access to outweigh the cost of the larger kernel.
+  const double saved_bytes = CalculateSavedBytes(siblings);
+  double accessed_bytes = 0.0;
+  for (const HloInstruction* sibling : siblings) {
+    accessed_bytes += cost_analysis_.bytes_accessed(*sibling);
+  }
+  const double saved_bytes_ratio = saved_bytes / std::max(1.0, accessed_bytes);
+  if (saved_bytes_ratio < MultiOutputFusion::GetThresholdSavedBytesRatio()) {
+    ++num_fail_saved_bytes_ratio_;
+    return Status::OK();
+  }
+
+  VLOG(2) << "Fusing siblings reading " << operand->name()
+          << " saved_bytes_ratio: " << saved_bytes_ratio << " { "
+          << tensorflow::str_util::Join(siblings, ", ",
+                                        [](string* out, HloInstruction* user) {
+                                          tensorflow::strings::StrAppend(
+                                              out, user->name());
+                                        })
+          << " }";
+  ++total_fused_;
+  changed_ = true;
+  return Fuse(siblings);
+}
+
+Status SiblingFuser::Fuse(const std::vector<HloInstruction*>& siblings) {
+  // Create a fusion instruction rooted at the tuple of the siblings, which are
+  // then its operands.
+  HloInstruction* tuple =
+      computation_->AddInstruction(HloInstruction::CreateTuple(siblings));
+  HloInstruction* fusion =
+      computation_->AddInstruction(HloInstruction::CreateFusion(
+          tuple->shape(), HloInstruction::FusionKind::kLoop, tuple));
+  TF_RETURN_IF_ERROR(computation_->RemoveInstruction(tuple));
+
+  // Make the users of each sibling read its output from the fusion instruction
+  // instead.
+  for (int64 i = 0; i < siblings.size(); ++i) {
+    HloInstruction* sibling = siblings[i];
+    HloInstruction* get_tuple_element =
+        computation_->AddInstruction(HloInstruction::CreateGetTupleElement(
+            sibling->shape(), fusion, i));
+    const std::vector<HloInstruction*> users = sibling->users();
+    for (HloInstruction* user : users) {
+      if (user != fusion) {
+        TF_RETURN_IF_ERROR(sibling->ReplaceUseWith(user, get_tuple_element));
+      }
+    }
+  }
+
+  for (HloInstruction* sibling : siblings) {
+    if (sibling->opcode() == HloOpcode::kFusion) {
+      fusion->MergeFusionInstruction(sibling);
+    } else {
+      fusion->FuseInstruction(sibling);
+    }
+    TF_RETURN_IF_ERROR(computation_->RemoveInstruction(sibling));
+    fused_.insert(sibling);
+  }
+  return Status::OK();
+}
+
+StatusOr<bool> MultiOutputFusion::Run(HloModule* module) {
+  bool changed = false;
+  VLOG(2) << "MultiOutputFusion for module: " << module->name();
+  for (auto& computation : module->computations()) {
+    VLOG(1) << "Before running SiblingFuser for computation: "
+            << computation->name();
+    XLA_VLOG_LINES(3, computation->ToString());
+
+    SiblingFuser sibling_fuser(computation.get());
+    TF_RETURN_IF_ERROR(sibling_fuser.Run());
+    changed |= sibling_fuser.changed();
+
+    VLOG(1) << "After running SiblingFuser for computation: "
+            << computation->name() << " changed: " << changed;
+    XLA_VLOG_LINES(3, computation->ToString());
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,49 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+#define THIRD_PARTY_TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// An HLO pass that fuses sibling instructions, i.e. instructions reading the
+// same operand, into one multi-output fusion instruction, so that the operand
+// is read from memory once rather than once per sibling.
+//
+// The siblings are elementwise instructions or loop fusion instructions with
+// the same dimensions, none of which depends on another. The users of each
+// sibling read its output through a GetTupleElement of the multi-output
+// fusion. The siblings are fused if the bytes saved by reading the shared
+// operand once are at least GetThresholdSavedBytesRatio() of the bytes the
+// siblings access, as estimated by HloCostAnalysis.
+class MultiOutputFusion : public HloPassInterface {
+ public:
+  tensorflow::StringPiece name() const override {
+    return "multi-output fusion";
+  }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  static double GetThresholdSavedBytesRatio() { return 0.1; }
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // THIRD_PARTY_TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/xla_data.pb.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class MultiOutputFusionTest : public HloTestBase {
+ protected:
+  MultiOutputFusionTest() : module_(TestName()) {}
+
+  // Returns the multi-output fusion instruction the root tuple of
+  // 'computation' reads its operands from, checking that they all are
+  // GetTupleElements of it.
+  HloInstruction* GetRootFusion(HloComputation* computation) {
+    HloInstruction* root = computation->root_instruction();
+    EXPECT_EQ(HloOpcode::kTuple, root->opcode());
+    HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+    for (int64 i = 0; i < root->operand_count(); ++i) {
+      const HloInstruction* operand = root->operand(i);
+      EXPECT_EQ(HloOpcode::kGetTupleElement, operand->opcode());
+      EXPECT_EQ(fusion, operand->operand(0));
+    }
+    EXPECT_TRUE(fusion->IsMultiOutputFusion());
+    return fusion;
+  }
+
+  HloModule module_;
+  const Shape data_shape_ = ShapeUtil::MakeShape(F32, {128, 1024});
+};
+
+TEST_F(MultiOutputFusionTest, FuseElementwiseSiblings) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  auto neg = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kNegate, param));
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, neg}));
+  HloComputation* computation = module_.AddEntryComputation(builder.Build());
+
+  EXPECT_TRUE(MultiOutputFusion().Run(&module_).ValueOrDie());
+  HloInstruction* fusion = GetRootFusion(computation);
+  EXPECT_EQ(HloInstruction::FusionKind::kLoop, fusion->fusion_kind());
+  EXPECT_EQ(1, fusion->operand_count());
+  EXPECT_EQ(param, fusion->operand(0));
+  const HloInstruction* fused_root = fusion->fused_expression_root();
+  EXPECT_EQ(HloOpcode::kExp, fused_root->operand(0)->opcode());
+  EXPECT_EQ(HloOpcode::kNegate, fused_root->operand(1)->opcode());
+}
+
+TEST_F(MultiOutputFusionTest, FuseLoopFusionSiblings) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  auto add = builder.AddInstruction(
+      HloInstruction::CreateBinary(data_shape_, HloOpcode::kAdd, exp, exp));
+  auto neg = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kNegate, param));
+  auto mul = builder.AddInstruction(HloInstruction::CreateBinary(
+      data_shape_, HloOpcode::kMultiply, neg, neg));
+  builder.AddInstruction(HloInstruction::CreateTuple({add, mul}));
+  HloComputation* computation = module_.AddEntryComputation(builder.Build());
+  computation->CreateFusionInstruction({add, exp},
+                                       HloInstruction::FusionKind::kLoop);
+  computation->CreateFusionInstruction({mul, neg},
+                                       HloInstruction::FusionKind::kLoop);
+
+  EXPECT_TRUE(MultiOutputFusion().Run(&module_).ValueOrDie());
+  HloInstruction* fusion = GetRootFusion(computation);
+  EXPECT_EQ(1, fusion->operand_count());
+  EXPECT_EQ(param, fusion->operand(0));
+  const HloInstruction* fused_root = fusion->fused_expression_root();
+  EXPECT_EQ(HloOpcode::kAdd, fused_root->operand(0)->opcode());
+  EXPECT_EQ(HloOpcode::kMultiply, fused_root->operand(1)->opcode());
+}
+
+TEST_F(MultiOutputFusionTest, DoNotFuseDependentSiblings) {
+  // The add is a sibling of the exp reading its output, so fusing them would
+  // make the fusion instruction use itself.
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  auto add = builder.AddInstruction(
+      HloInstruction::CreateBinary(data_shape_, HloOpcode::kAdd, param, exp));
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, add}));
+  module_.AddEntryComputation(builder.Build());
+
+  EXPECT_FALSE(MultiOutputFusion().Run(&module_).ValueOrDie());
+}
+
+TEST_F(MultiOutputFusionTest, DoNotFuseSiblingsOfDifferentDimensions) {
+  const Shape transposed_shape = ShapeUtil::MakeShape(F32, {1024, 128});
+  auto builder = HloComputation::Builder(TestName());
+  auto param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, data_shape_, "param"));
+  auto exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(data_shape_, HloOpcode::kExp, param));
+  auto transpose = builder.AddInstruction(
+      HloInstruction::CreateTranspose(transposed_shape, param, {1, 0}));
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, transpose}));
+  HloComputation* computation = module_.AddEntryComputation(builder.Build());
+  computation->CreateFusionInstruction({transpose},
+                                       HloInstruction::FusionKind::kLoop);
+
+  EXPECT_FALSE(MultiOutputFusion().Run(&module_).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
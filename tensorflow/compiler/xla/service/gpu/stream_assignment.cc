@@ -20,6 +20,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
 namespace xla {
 namespace gpu {
@@ -52,14 +54,40 @@ bool CanRunConcurrently(
   return !transitive_operands.IsConnected(&a, &b);
 }
 
+// Instructions computing at least this many flops are worth running
+// concurrently with the other expensive instructions, like GEMMs and
+// convolutions. Cheaper kernels are kept on the streams of their operands,
+// because the synchronization across streams would cost more than they gain.
+constexpr int64 kMinConcurrentFlops = 1LL << 24;
+
+// Returns whether `hlo` is worth being assigned a stream that doesn't run the
+// expensive instructions concurrent with it. Besides the instructions
+// dominated by their computation, this includes the copies of constants,
+// which are memcpys from the host that can overlap with the kernels.
+bool IsConcurrencyCandidate(const HloInstruction& hlo,
+                            const HloCostAnalysis& cost_analysis) {
+  if (ImplementedAsGemm(hlo) || ImplementedAsDnnConvolution(hlo)) {
+    return true;
+  }
+  if (hlo.opcode() == HloOpcode::kCopy &&
+      hlo.operand(0)->opcode() == HloOpcode::kConstant) {
+    return true;
+  }
+  return cost_analysis.flop_count(hlo) >= kMinConcurrentFlops;
+}
+
 // Returns which existing stream to assign to `hlo`, or -1 if a stream is not
 // needed. `stream_assignment` is the existing stream assignment for all
-// instructions topologically before `hlo`. `seen_gemms` contains all GEMMs that
-// are topologically before `hlo`.
+// instructions topologically before `hlo`. `seen_candidates` contains all
+// concurrency candidates that are topologically before `hlo`, and
+// `stream_loads` the work assigned to each stream so far, as estimated by
+// `cost_analysis`.
 int ComputeStreamToAssign(
     const HloInstruction& hlo, const StreamAssignment& stream_assignment,
     const HloComputation::ReachabilityMap& transitive_operands,
-    const std::vector<const HloInstruction*>& seen_gemms) {
+    const HloCostAnalysis& cost_analysis,
+    const std::vector<const HloInstruction*>& seen_candidates,
+    const std::vector<int64>& stream_loads) {
   if (hlo.opcode() == HloOpcode::kParameter ||
       hlo.opcode() == HloOpcode::kConstant) {
     // kParameter and kConstant do not need a thunk.
@@ -72,9 +100,9 @@ int ComputeStreamToAssign(
     return 0;
   }
 
-  if (!ImplementedAsGemm(hlo)) {
-    // If `hlo` is not implemented as a GEMM, keep it close to its operands to
-    // avoid excessive synchronization.
+  if (!IsConcurrencyCandidate(hlo, cost_analysis)) {
+    // If `hlo` is not worth running concurrently, keep it close to its
+    // operands to avoid excessive synchronization.
     int stream_no = -1;
     for (const auto* operand : hlo.operands()) {
       if (stream_assignment.HasStreamAssigned(*operand)) {
@@ -88,26 +116,31 @@ int ComputeStreamToAssign(
     return stream_no;
   }
 
-  // Assign different streams to concurrent GEMMs. The code below uses a
+  // Assign different streams to concurrent candidates. The code below uses a
   // greedy approach. First, we compute as forbidden_stream_numbers the
-  // streams assigned to GEMMs that are concurrent with `hlo`. Then, we assign
-  // `hlo` a different stream.
+  // streams assigned to candidates that are concurrent with `hlo`. Then, we
+  // assign `hlo` the least loaded of the other streams, so that the work is
+  // balanced across the streams.
   std::set<int> forbidden_stream_numbers;
-  for (const auto* seen_gemm : seen_gemms) {
-    int stream_no = stream_assignment.StreamNumberForHlo(*seen_gemm);
+  for (const auto* seen_candidate : seen_candidates) {
+    int stream_no = stream_assignment.StreamNumberForHlo(*seen_candidate);
     if (!forbidden_stream_numbers.count(stream_no) &&
-        CanRunConcurrently(*seen_gemm, hlo, transitive_operands)) {
+        CanRunConcurrently(*seen_candidate, hlo, transitive_operands)) {
       forbidden_stream_numbers.insert(stream_no);
     }
   }
 
+  int best_stream_no = -1;
   for (int stream_no = 0; stream_no < stream_assignment.StreamCount();
        ++stream_no) {
-    if (!forbidden_stream_numbers.count(stream_no)) {
-      return stream_no;
+    if (!forbidden_stream_numbers.count(stream_no) &&
+        (best_stream_no == -1 ||
+         stream_loads[stream_no] < stream_loads[best_stream_no])) {
+      best_stream_no = stream_no;
     }
   }
-  return stream_assignment.StreamCount();
+  return best_stream_no == -1 ? stream_assignment.StreamCount()
+                              : best_stream_no;
 }
 
 }  // namespace
@@ -117,15 +150,32 @@ std::unique_ptr<StreamAssignment> AssignStreams(const HloModule& module) {
   const HloComputation& computation = *module.entry_computation();
   std::unique_ptr<HloComputation::ReachabilityMap> transitive_operands =
       computation.ComputeTransitiveOperands();
-  std::vector<const HloInstruction*> seen_gemms;
+  // The layouts are assigned by now, so the sizes are exact.
+  HloCostAnalysis cost_analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  const Status status = computation.Accept(&cost_analysis);
+  if (!status.ok()) {
+    // Without costs only GEMMs and convolutions are run concurrently.
+    LOG(WARNING) << "Failed to analyze the costs of " << computation.name()
+                 << ": " << status;
+  }
+  // A rough estimate of the work assigned to each stream, to which each
+  // instruction contributes the larger of its flops and the bytes it accesses.
+  std::vector<int64> stream_loads(stream_assignment->StreamCount(), 0);
+  std::vector<const HloInstruction*> seen_candidates;
   for (const auto* hlo : computation.MakeInstructionPostOrder()) {
-    int stream_no = ComputeStreamToAssign(*hlo, *stream_assignment,
-                                          *transitive_operands, seen_gemms);
+    int stream_no =
+        ComputeStreamToAssign(*hlo, *stream_assignment, *transitive_operands,
+                              cost_analysis, seen_candidates, stream_loads);
     if (stream_no != -1) {
       stream_assignment->AssignStreamToHlo(hlo, stream_no);
+      stream_loads.resize(stream_assignment->StreamCount(), 0);
+      stream_loads[stream_no] += std::max(cost_analysis.flop_count(*hlo),
+                                          cost_analysis.bytes_accessed(*hlo));
     }
-    if (ImplementedAsGemm(*hlo)) {
-      seen_gemms.push_back(hlo);
+    if (IsConcurrencyCandidate(*hlo, cost_analysis)) {
+      seen_candidates.push_back(hlo);
     }
   }
   return stream_assignment;
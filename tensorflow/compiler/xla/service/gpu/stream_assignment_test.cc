@@ -74,6 +74,53 @@ TEST_F(StreamAssignmentTest, ConcurrentMatMul) {
             assignment->StreamNumberForHlo(*dot2));
 }
 
+TEST_F(StreamAssignmentTest, ConcurrentExpensiveElementwise) {
+  // Each of the two binary operations runs 2^24 flops, which is enough to run
+  // them concurrently.
+  const Shape f32_4096x4096 = ShapeUtil::MakeShape(F32, {4096, 4096});
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_4096x4096, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_4096x4096, /*name=*/"y"));
+  HloInstruction* add = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_4096x4096, HloOpcode::kAdd, x, y));
+  HloInstruction* mul = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_4096x4096, HloOpcode::kMultiply, x, y));
+  HloInstruction* sub = builder.AddInstruction(HloInstruction::CreateBinary(
+      f32_4096x4096, HloOpcode::kSubtract, add, mul));
+
+  HloModule module(TestName());
+  module.AddEntryComputation(builder.Build(sub));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(module);
+  EXPECT_NE(assignment->StreamNumberForHlo(*add),
+            assignment->StreamNumberForHlo(*mul));
+}
+
+TEST_F(StreamAssignmentTest, CheapElementwiseFollowsOperands) {
+  HloComputation::Builder builder("entry_computation");
+  HloInstruction* x = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/0, f32_2x2_, /*name=*/"x"));
+  HloInstruction* y = builder.AddInstruction(HloInstruction::CreateParameter(
+      /*parameter_number=*/1, f32_2x2_, /*name=*/"y"));
+  HloInstruction* dot1 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kDot, x, y));
+  HloInstruction* dot2 = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kDot, y, x));
+  HloInstruction* neg = builder.AddInstruction(
+      HloInstruction::CreateUnary(f32_2x2_, HloOpcode::kNegate, dot2));
+  HloInstruction* add = builder.AddInstruction(
+      HloInstruction::CreateBinary(f32_2x2_, HloOpcode::kAdd, dot1, neg));
+
+  HloModule module(TestName());
+  module.AddEntryComputation(builder.Build(add));
+
+  std::unique_ptr<StreamAssignment> assignment = AssignStreams(module);
+  EXPECT_EQ(assignment->StreamNumberForHlo(*dot2),
+            assignment->StreamNumberForHlo(*neg));
+}
+
 TEST_F(StreamAssignmentTest, LatticeMatMul) {
   //      d00      -- layer 0
   //     /   \
@@ -1653,6 +1653,11 @@ HloInstruction* HloInstruction::fused_expression_root() const {
   return fused_instructions_computation_->root_instruction();
 }
 
+bool HloInstruction::IsMultiOutputFusion() const {
+  return opcode_ == HloOpcode::kFusion &&
+         fused_expression_root()->opcode() == HloOpcode::kTuple;
+}
+
 HloInstruction* HloInstruction::fused_parameter(int64 parameter_number) const {
   CHECK_EQ(opcode_, HloOpcode::kFusion);
   CHECK(fused_instructions_computation_ != nullptr &&
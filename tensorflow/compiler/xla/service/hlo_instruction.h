@@ -553,6 +553,11 @@ class HloInstruction {
   // Precondition: opcode() == HloOpcode::kFusion
   HloInstruction* fused_expression_root() const;
 
+  // Returns true if this is a fusion instruction computing several outputs in
+  // one loop, i.e. whose fused expression root is a tuple of them. Each output
+  // is read by the users of the fusion through a GetTupleElement.
+  bool IsMultiOutputFusion() const;
+
   // Returns the computation for this fused instruction.
   //
   // Precondition: opcode() == HloOpcode::kFusion
@@ -584,6 +589,11 @@ class HloInstruction {
     return fusion_kind_;
   }
 
+  void set_fusion_kind(FusionKind kind) {
+    CHECK_EQ(HloOpcode::kFusion, opcode_);
+    fusion_kind_ = kind;
+  }
+
   // Merges the fused instructions from 'instruction_to_merge' into the
   // fused instruction set of 'this', updating operands as necessary.
   //
@@ -253,6 +253,7 @@ HloInstruction* InstructionFusion::Fuse(HloInstruction* producer,
 
   if (consumer->opcode() == HloOpcode::kFusion) {
     fusion_instruction = consumer;
+    fusion_instruction->set_fusion_kind(ChooseKind(producer, consumer));
   } else {
     fusion_instruction =
         computation_->AddInstruction(HloInstruction::CreateFusion(
@@ -299,6 +300,9 @@ bool InstructionFusion::ShouldFuse(HloInstruction* consumer,
 
 HloInstruction::FusionKind InstructionFusion::ChooseKind(
     const HloInstruction* producer, const HloInstruction* consumer) {
+  if (consumer->opcode() == HloOpcode::kFusion) {
+    return consumer->fusion_kind();
+  }
   return HloInstruction::FusionKind::kLoop;
 }
 
@@ -61,8 +61,9 @@ class InstructionFusion : public HloPassInterface {
   // Subtypes can override this with target-specific heuristics.
   virtual bool ShouldFuse(HloInstruction* consumer, int64 operand_index);
 
-  // Chooses a fusion kind for `producer` and `consumer`.
-  // Default method chooses `kLoop`.
+  // Chooses a fusion kind for `producer` and `consumer`. It is also called when
+  // `consumer` is a fusion instruction already, whose kind is then updated.
+  // Default method chooses the kind of such a `consumer`, or `kLoop`.
   virtual HloInstruction::FusionKind ChooseKind(const HloInstruction* producer,
                                                 const HloInstruction* consumer);
 
@@ -33,6 +33,10 @@ namespace xla {
 using llvm_ir::IrArray;
 
 Status FusedIrEmitter::DefaultAction(HloInstruction* hlo) {
+  if (generators_.count(hlo) > 0) {
+    // The instruction was bound to an array by BindInstructionToArray.
+    return Status::OK();
+  }
   generators_[hlo] =
       [=](const IrArray::Index& index) -> StatusOr<llvm::Value*> {
     if (generated_value_cache_[hlo].count(index.multidim()) > 0) {
@@ -128,6 +132,13 @@ Status FusedIrEmitter::HandleParameter(HloInstruction* parameter) {
   return Status::OK();
 }
 
+void FusedIrEmitter::BindInstructionToArray(const HloInstruction* instruction,
+                                            const IrArray& array) {
+  generators_[instruction] = [=](const IrArray::Index& index) {
+    return array.EmitReadArrayElement(index, ir_builder_);
+  };
+}
+
 Status FusedIrEmitter::FinishVisit(HloInstruction* root) {
   fused_root_ = root;
   return tensorflow::Status::OK();
@@ -56,6 +56,13 @@ class FusedIrEmitter : public DfsHloVisitorWithDefault {
 
   Status FinishVisit(HloInstruction* root) override;
 
+  // Makes the generator of the fused 'instruction' read its elements from
+  // 'array' rather than compute them. This lets the emitters of output fusions
+  // emit the fused instruction themselves, and only use the generators of the
+  // instructions consuming it. Must be called before Accept.
+  void BindInstructionToArray(const HloInstruction* instruction,
+                              const llvm_ir::IrArray& array);
+
   // Returns the generator function for the root of the fused computation.
   Generator GetRootGenerator() const;
 
@@ -0,0 +1,166 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_cache.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/legacy_flags/persistent_cache_flags.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/file_statistics.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+namespace {
+
+auto* persistent_cache_lookups = tensorflow::monitoring::Counter<1>::New(
+    "/tensorflow/compiler/xla/persistent_cache_lookups",
+    "The number of lookups in the persistent compilation cache.", "result");
+
+auto* persistent_cache_evictions = tensorflow::monitoring::Counter<0>::New(
+    "/tensorflow/compiler/xla/persistent_cache_evictions",
+    "The number of entries evicted from the persistent compilation cache.");
+
+// Each file starts with the fingerprint of the code it stores, so that the
+// files truncated or corrupted by the file system are ignored.
+constexpr size_t kHeaderSize = sizeof(tensorflow::uint64);
+
+}  // namespace
+
+/* static */ PersistentCache* PersistentCache::Default() {
+  static PersistentCache* cache = []() -> PersistentCache* {
+    legacy_flags::PersistentCacheFlags* flags =
+        legacy_flags::GetPersistentCacheFlags();
+    if (flags->xla_persistent_cache_dir.empty()) {
+      return nullptr;
+    }
+    return new PersistentCache(flags->xla_persistent_cache_dir,
+                               flags->xla_persistent_cache_max_bytes,
+                               tensorflow::Env::Default());
+  }();
+  return cache;
+}
+
+PersistentCache::PersistentCache(const string& dir, int64 max_bytes,
+                                 tensorflow::Env* env)
+    : dir_(dir), max_bytes_(max_bytes), env_(env) {}
+
+string PersistentCache::FileName(const string& key) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      dir_, tensorflow::strings::Printf(
+                "%016llx%016llx",
+                static_cast<unsigned long long>(fingerprint.high64),
+                static_cast<unsigned long long>(fingerprint.low64)));
+}
+
+bool PersistentCache::Lookup(const string& key, string* data) {
+  const string file_name = FileName(key);
+  string contents;
+  if (!env_->FileExists(file_name).ok() ||
+      !tensorflow::ReadFileToString(env_, file_name, &contents).ok()) {
+    persistent_cache_lookups->GetCell("miss")->IncrementBy(1);
+    return false;
+  }
+  if (contents.size() < kHeaderSize ||
+      tensorflow::core::DecodeFixed64(contents.data()) !=
+          tensorflow::Fingerprint64(contents.substr(kHeaderSize))) {
+    LOG(WARNING) << "Ignoring the corrupted compilation cache entry "
+                 << file_name;
+    persistent_cache_lookups->GetCell("miss")->IncrementBy(1);
+    return false;
+  }
+  persistent_cache_lookups->GetCell("hit")->IncrementBy(1);
+  *data = contents.substr(kHeaderSize);
+  return true;
+}
+
+void PersistentCache::Insert(const string& key, const string& data) {
+  const string file_name = FileName(key);
+  string contents(kHeaderSize, '\0');
+  tensorflow::core::EncodeFixed64(&contents[0],
+                                  tensorflow::Fingerprint64(data));
+  contents.append(data);
+
+  // Write a temporary file first, so that the other processes never read a
+  // partially written entry.
+  const string temp_name = tensorflow::strings::Printf(
+      "%s.tmp.%016llx", file_name.c_str(),
+      static_cast<unsigned long long>(tensorflow::random::New64()));
+  tensorflow::Status status = env_->RecursivelyCreateDir(dir_);
+  if (status.ok()) {
+    status = tensorflow::WriteStringToFile(env_, temp_name, contents);
+  }
+  if (status.ok()) {
+    status = env_->RenameFile(temp_name, file_name);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write the compilation cache entry " << file_name
+                 << ": " << status;
+    env_->DeleteFile(temp_name).IgnoreError();
+    return;
+  }
+  if (max_bytes_ > 0) {
+    Evict(file_name);
+  }
+}
+
+void PersistentCache::Evict(const string& newest) {
+  tensorflow::mutex_lock lock(eviction_mu_);
+  std::vector<string> children;
+  if (!env_->GetChildren(dir_, &children).ok()) {
+    return;
+  }
+  // The entries, by modification time.
+  std::vector<std::pair<int64, string>> entries;
+  int64 total_bytes = 0;
+  for (const string& child : children) {
+    const string file_name = tensorflow::io::JoinPath(dir_, child);
+    tensorflow::FileStatistics stat;
+    if (!env_->Stat(file_name, &stat).ok() || stat.is_directory) {
+      continue;
+    }
+    total_bytes += stat.length;
+    if (file_name != newest) {
+      entries.emplace_back(stat.mtime_nsec, file_name);
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  for (const auto& entry : entries) {
+    if (total_bytes <= max_bytes_) {
+      break;
+    }
+    tensorflow::FileStatistics stat;
+    // Another process may have evicted or replaced the entry already.
+    if (!env_->Stat(entry.second, &stat).ok() ||
+        !env_->DeleteFile(entry.second).ok()) {
+      continue;
+    }
+    VLOG(1) << "Evicted the compilation cache entry " << entry.second;
+    persistent_cache_evictions->GetCell()->IncrementBy(1);
+    total_bytes -= stat.length;
+  }
+}
+
+}  // namespace xla
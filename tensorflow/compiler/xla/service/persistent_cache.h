@@ -0,0 +1,74 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_CACHE_H_
+
+#include <string>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+
+// A cache of compiled code, e.g. object files or PTX, stored in a directory
+// that can be shared by many processes, so that restarted processes don't have
+// to compile their computations again. The directory can be on any file system
+// known to tensorflow::Env, e.g. a local disk or GCS.
+//
+// The cache is best-effort: failures to read or write it are logged, and make
+// the compiler compile the code as if it wasn't cached.
+class PersistentCache {
+ public:
+  // Returns the cache configured by the --xla_persistent_cache_dir flag, or
+  // nullptr if the flag is empty.
+  static PersistentCache* Default();
+
+  // When the entries stored in 'dir' take more than 'max_bytes', the oldest
+  // ones are evicted. They are never evicted if 'max_bytes' is 0.
+  PersistentCache(const string& dir, int64 max_bytes, tensorflow::Env* env);
+
+  // Looks up the code compiled for 'key', which must describe everything the
+  // code depends on, e.g. the LLVM IR, the target and the compiler options.
+  // Returns true and sets '*data' if there is one.
+  bool Lookup(const string& key, string* data);
+
+  // Stores 'data' as the code compiled for 'key', replacing any code stored
+  // for it, and evicts the oldest entries if the cache got too large.
+  void Insert(const string& key, const string& data);
+
+ private:
+  // Returns the name of the file storing the code compiled for 'key'.
+  string FileName(const string& key) const;
+
+  // Deletes the oldest entries, apart from 'newest', until the cache takes at
+  // most max_bytes_.
+  void Evict(const string& newest);
+
+  const string dir_;
+  const int64 max_bytes_;
+  tensorflow::Env* const env_;
+
+  // Serializes the evictions of this process.
+  tensorflow::mutex eviction_mu_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PersistentCache);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_PERSISTENT_CACHE_H_
@@ -0,0 +1,109 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/persistent_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+class PersistentCacheTest : public ::testing::Test {
+ protected:
+  // Returns a new empty directory for the cache.
+  string CacheDir(const string& name) {
+    const string dir = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                                "persistent_cache_test", name);
+    int64 undeleted_files, undeleted_dirs;
+    env_->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    return dir;
+  }
+
+  // Returns the names of the files in 'dir'.
+  std::vector<string> Files(const string& dir) {
+    std::vector<string> files;
+    TF_CHECK_OK(env_->GetChildren(dir, &files));
+    return files;
+  }
+
+  tensorflow::Env* env_ = tensorflow::Env::Default();
+};
+
+TEST_F(PersistentCacheTest, LookupInsertedCode) {
+  PersistentCache cache(CacheDir("lookup"), 0, env_);
+  string data;
+  EXPECT_FALSE(cache.Lookup("key", &data));
+
+  cache.Insert("key", "code");
+  ASSERT_TRUE(cache.Lookup("key", &data));
+  EXPECT_EQ("code", data);
+  EXPECT_FALSE(cache.Lookup("other key", &data));
+
+  cache.Insert("key", "new code");
+  ASSERT_TRUE(cache.Lookup("key", &data));
+  EXPECT_EQ("new code", data);
+}
+
+TEST_F(PersistentCacheTest, SharedAcrossInstances) {
+  const string dir = CacheDir("shared");
+  PersistentCache(dir, 0, env_).Insert("key", "code");
+
+  string data;
+  ASSERT_TRUE(PersistentCache(dir, 0, env_).Lookup("key", &data));
+  EXPECT_EQ("code", data);
+}
+
+TEST_F(PersistentCacheTest, IgnoreCorruptedEntries) {
+  const string dir = CacheDir("corrupted");
+  PersistentCache cache(dir, 0, env_);
+  cache.Insert("key", "code");
+  const std::vector<string> files = Files(dir);
+  ASSERT_EQ(1, files.size());
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(
+      env_, tensorflow::io::JoinPath(dir, files[0]), "garbage"));
+
+  string data;
+  EXPECT_FALSE(cache.Lookup("key", &data));
+}
+
+TEST_F(PersistentCacheTest, EvictOldestEntries) {
+  const string dir = CacheDir("eviction");
+  // Room for two entries of 100 bytes, with their headers.
+  PersistentCache cache(dir, 250, env_);
+  const string code(100, 'x');
+  // The modification times of local files may only have a resolution of a
+  // second.
+  const int64 delay_micros = 1100000;
+  cache.Insert("first", code);
+  env_->SleepForMicroseconds(delay_micros);
+  cache.Insert("second", code);
+  env_->SleepForMicroseconds(delay_micros);
+  cache.Insert("third", code);
+
+  EXPECT_EQ(2, Files(dir).size());
+  string data;
+  EXPECT_FALSE(cache.Lookup("first", &data));
+  EXPECT_TRUE(cache.Lookup("second", &data));
+  EXPECT_TRUE(cache.Lookup("third", &data));
+}
+
+}  // namespace
+}  // namespace xla
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -259,6 +260,54 @@ XLA_TEST_F(DotOperationTest, MatrixDotF32_260_3_520_MinorToMajorFF) {
   TestMatrixDot(260, 3, 520, false, false);
 }
 
+XLA_TEST_F(DotOperationTest, MatrixDotF32_67_45_130_MinorToMajorTT) {
+  TestMatrixDot(67, 45, 130, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_100_300_70_MinorToMajorTT) {
+  TestMatrixDot(100, 300, 70, true, true);
+}
+
+// The addition of the bias and the max are fused into the dot on CPU.
+XLA_TEST_F(DotOperationTest, MatrixDotF32WithBiasAndRelu) {
+  const int m = 33;
+  const int k = 70;
+  const int n = 50;
+  std::unique_ptr<Array2D<float>> lhs_data =
+      MakeLinspaceArray2D(-1.0, 1.0, m, k);
+  auto lhs_handle =
+      client_->TransferToServer(*LiteralUtil::CreateR2FromArray2D(*lhs_data))
+          .ConsumeValueOrDie();
+  std::unique_ptr<Array2D<float>> rhs_data =
+      MakeLinspaceArray2D(-1.0, 1.0, k, n);
+  auto rhs_handle =
+      client_->TransferToServer(*LiteralUtil::CreateR2FromArray2D(*rhs_data))
+          .ConsumeValueOrDie();
+  std::vector<float> bias(n);
+  for (int j = 0; j < n; ++j) {
+    bias[j] = 0.5f - 0.02f * j;
+  }
+
+  ComputationBuilder builder(client_, TestName());
+  auto product = builder.Dot(
+      builder.Parameter(0, ShapeUtil::MakeShape(F32, {m, k}), "lhs"),
+      builder.Parameter(1, ShapeUtil::MakeShape(F32, {k, n}), "rhs"));
+  auto biased = builder.Add(product, builder.ConstantR1<float>(bias),
+                            /*broadcast_dimensions=*/{1});
+  builder.Max(biased, builder.ConstantR0<float>(0.0f));
+
+  std::unique_ptr<Array2D<float>> expected =
+      ReferenceUtil::MatmulArray2D(*lhs_data, *rhs_data);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      (*expected)(i, j) = std::max((*expected)(i, j) + bias[j], 0.0f);
+    }
+  }
+  ComputeAndCompareR2<float>(&builder, *expected,
+                             {lhs_handle.get(), rhs_handle.get()},
+                             ErrorSpec(0.3, 3e-3));
+}
+
 XLA_TEST_F(DotOperationTest, SquareMatrixDotF32MinorToMajorFF) {
   constexpr bool kLhsRowMajor = false;
   constexpr bool kRhsRowMajor = false;
@@ -459,6 +459,40 @@ XLA_TEST_F(ReduceTest, MinReduce2DToR0) {
   ComputeAndCompareR0<float>(&builder, input_min, {}, ErrorSpec(0.0001));
 }
 
+// Max-reduces the rows of a matrix whose size is not a multiple of the vector
+// width of the CPU backend.
+XLA_TEST_F(ReduceTest, MaxReduce2DAmong1_7x107) {
+  ComputationBuilder builder(client_, TestName());
+  auto max = CreateScalarMaxComputation(F32, &builder);
+  Array2D<float> input(7, 107);
+  input.FillRandom(214.0f);
+  auto input_literal = LiteralUtil::CreateR2FromArray2D(input);
+  builder.Reduce(builder.ConstantLiteral(*input_literal),
+                 builder.ConstantR0<float>(-FLT_MAX), max, {1});
+
+  std::vector<float> expected(7, -FLT_MAX);
+  input.Each([&](int64 row, int64, float* v) {
+    expected[row] = std::max(expected[row], *v);
+  });
+  ComputeAndCompareR1<float>(&builder, expected, {}, ErrorSpec(0.0001));
+}
+
+// Add-reduces the rows of a matrix starting from a non-zero value, which is
+// added once per row.
+XLA_TEST_F(ReduceTest, AddReduce2DAmong1WithInitValue_3x67) {
+  ComputationBuilder builder(client_, TestName());
+  auto add = CreateScalarAddComputation(F32, &builder);
+  Array2D<float> input(3, 67);
+  input.FillRandom(1.0f);
+  auto input_literal = LiteralUtil::CreateR2FromArray2D(input);
+  builder.Reduce(builder.ConstantLiteral(*input_literal),
+                 builder.ConstantR0<float>(10.0f), add, {1});
+
+  std::vector<float> expected(3, 10.0f);
+  input.Each([&](int64 row, int64, float* v) { expected[row] += *v; });
+  ComputeAndCompareR1<float>(&builder, expected, {}, ErrorSpec(0.001));
+}
+
 // Reduces a matrix among dimension 1.
 XLA_TEST_F(ReduceTest, Reduce2DAmong1) {
   ComputationBuilder builder(client_, TestName());
@@ -474,7 +474,8 @@ TEST_F(WhileTest, DISABLED_ON_GPU(WhileLoopsWithSharedBodyAndInit)) {
 
 // WhileTest that uses DynamicUpdateSlice instruction in body computation.
 // Loop state tuple element 1 has as its single user operand(0) of
-// DynamicUpdateSlice, which will trigger in-place dynamic slice update on GPU.
+// DynamicUpdateSlice, which will trigger in-place dynamic slice update on CPU
+// and GPU.
 XLA_TEST_F(WhileTest, WhileWithDynamicUpdateSlice) {
   std::vector<Shape> shape_elements = {ShapeUtil::MakeShape(S32, {}),
                                        ShapeUtil::MakeShape(F32, {10})};
@@ -533,6 +534,56 @@ XLA_TEST_F(WhileTest, WhileWithDynamicUpdateSlice) {
   ComputeAndCompareTuple(&builder, *expected, {}, ErrorSpec(0.0001));
 }
 
+// Like WhileWithDynamicUpdateSlice, but the update of the last iteration
+// extends past the end of the loop state, so that its last element is dropped
+// instead of being written to the start of the loop state.
+XLA_TEST_F(WhileTest, WhileWithDynamicUpdateSlicePastTheEnd) {
+  std::vector<Shape> shape_elements = {ShapeUtil::MakeShape(S32, {}),
+                                       ShapeUtil::MakeShape(F32, {10})};
+  Shape result_shape = ShapeUtil::MakeTupleShape(shape_elements);
+
+  // Create a computation for the condition.
+  // Repeat for 5 iterations.
+  Computation condition;
+  {
+    ComputationBuilder builder(client_, "condition");
+    auto prev = builder.Parameter(0, result_shape, "prev");
+    auto iteration = builder.GetTupleElement(prev, 0);
+    builder.Gt(builder.ConstantR0<int32>(5), iteration);
+    condition = builder.Build().ConsumeValueOrDie();
+  }
+
+  // Create a computation for the body, which writes three elements at
+  // iteration * 2.
+  Computation body;
+  {
+    ComputationBuilder builder(client_, "body");
+    auto prev = builder.Parameter(0, result_shape, "prev");
+    auto iteration = builder.GetTupleElement(prev, 0);
+    auto out0 = builder.Add(iteration, builder.ConstantR0<int32>(1));
+    auto input = builder.GetTupleElement(prev, 1);
+    auto update = builder.ConvertElementType(builder.Broadcast(out0, {3}), F32);
+    auto starts = builder.Reshape(
+        builder.Mul(iteration, builder.ConstantR0<int32>(2)), {1});
+    auto out1 = builder.DynamicUpdateSlice(input, update, starts);
+
+    auto result = builder.Tuple({out0, out1});
+    body = builder.Build().ConsumeValueOrDie();
+  }
+
+  ComputationBuilder builder(client_, "while");
+  auto init = builder.Tuple(
+      {builder.ConstantR0<int32>(0), builder.ConstantR1<float>(10, 0.f)});
+  builder.While(condition, body, init);
+
+  auto expected_counter = LiteralUtil::CreateR0<int32>(5);
+  auto expected_data = LiteralUtil::CreateR1<float>(
+      {1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f, 4.0f, 4.0f, 5.0f, 5.0f});
+  auto expected =
+      LiteralUtil::MakeTuple({expected_counter.get(), expected_data.get()});
+  ComputeAndCompareTuple(&builder, *expected, {}, ErrorSpec(0.0001));
+}
+
 // Tests a while node when the result type T is a vector of S32.
 //
 // int32 result = (0, 0, 0, 0, 0, 0);
@@ -0,0 +1,34 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""All-reduce graphs that run over the transport between workers.
+
+@@all_reduce_gradients
+@@build_hierarchical_all_reduce
+@@build_ring_all_reduce
+@@build_tree_all_reduce
+
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.all_reduce.python.ops.all_reduce import all_reduce_gradients
+from tensorflow.contrib.all_reduce.python.ops.all_reduce import build_hierarchical_all_reduce
+from tensorflow.contrib.all_reduce.python.ops.all_reduce import build_ring_all_reduce
+from tensorflow.contrib.all_reduce.python.ops.all_reduce import build_tree_all_reduce
+
+from tensorflow.python.util.all_util import remove_undocumented
+remove_undocumented(__name__)
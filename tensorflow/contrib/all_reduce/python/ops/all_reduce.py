@@ -0,0 +1,445 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""All-reduce graphs built from ordinary ops placed on many devices.
+
+The functions in this module build the subgraph of an all-reduce out of
+element-wise ops, `split`, `concat` and `identity`, each placed on one of
+the participating devices. Data moves between devices only along the
+edges of this subgraph, so when the devices belong to different workers
+the graph partitioner inserts `Send`/`Recv` pairs that go over the
+worker transport of the cluster: gRPC, or RDMA if the servers use the
+"grpc+verbs" protocol. Nothing has to be set up at runtime, and the
+devices may be any mix of CPUs and GPUs.
+
+`build_ring_all_reduce` moves `2 * (n - 1) / n` times the size of the
+tensor in and out of each device, which is optimal for large tensors.
+`build_tree_all_reduce` takes `2 * log2(n)` steps instead of `2 * (n - 1)`,
+which suits small tensors, where latency dominates.
+`build_hierarchical_all_reduce` first reduces the tensors of each worker
+locally, so that only one device per worker takes part in the cross-worker
+all-reduce.
+
+`all_reduce_gradients` packs the gradients of data-parallel replicas into
+buckets, and all-reduces each bucket separately. Every bucket depends only
+on its own gradients, so the executor starts to send a bucket as soon as
+backprop has produced them, while the gradients of earlier layers are
+still being computed.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from tensorflow.python.framework import device as pydev
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+
+def _check_devices(input_tensors):
+  """Returns the devices of `input_tensors`, which must all be placed."""
+  if not input_tensors:
+    raise ValueError("input_tensors must not be empty")
+  devices = [t.device for t in input_tensors]
+  if not all(devices):
+    raise ValueError("All input tensors must be placed on a device")
+  return devices
+
+
+def _flatten(input_tensors):
+  """Reshapes each of `input_tensors` to a vector, on its own device.
+
+  Args:
+    input_tensors: List of tensors of the same shape.
+
+  Returns:
+    The list of vectors, and the common shape of `input_tensors`.
+
+  Raises:
+    ValueError: If the shapes of `input_tensors` differ.
+  """
+  shape = input_tensors[0].get_shape()
+  for t in input_tensors[1:]:
+    shape = shape.merge_with(t.get_shape())
+  flat = []
+  for t in input_tensors:
+    with ops.colocate_with(t):
+      flat.append(array_ops.reshape(t, [-1]))
+  return flat, shape
+
+
+def _unflatten(flat_tensors, shape, input_tensors):
+  """Reverses `_flatten`, giving each result the shape of its input."""
+  outputs = []
+  for t, i in zip(flat_tensors, input_tensors):
+    with ops.colocate_with(t):
+      if shape.is_fully_defined():
+        outputs.append(array_ops.reshape(t, shape.as_list()))
+      else:
+        outputs.append(array_ops.reshape(t, array_ops.shape(i)))
+  return outputs
+
+
+def _padded_split(tensor, pieces):
+  """Splits vector `tensor` into `pieces` pieces of the same length.
+
+  Args:
+    tensor: A vector.
+    pieces: The number of pieces.
+
+  Returns:
+    The list of pieces, and the number of zeros that padded `tensor` at the
+    end. The padding is a tensor if the length of `tensor` is not known
+    statically.
+  """
+  with ops.colocate_with(tensor):
+    length = tensor.get_shape()[0].value
+    if length is not None:
+      pad_len = (pieces - length % pieces) % pieces
+      if pad_len > 0:
+        tensor = array_ops.concat(
+            [tensor, array_ops.zeros([pad_len], dtype=tensor.dtype)], 0)
+      return array_ops.split(tensor, pieces), pad_len
+    length = array_ops.shape(tensor)[0]
+    pad_len = (pieces - length % pieces) % pieces
+    padding = array_ops.zeros(
+        array_ops.expand_dims(pad_len, 0), dtype=tensor.dtype)
+    return array_ops.split(array_ops.concat([tensor, padding], 0),
+                           pieces), pad_len
+
+
+def _strip_padding(tensor, pad_len):
+  """Removes the last `pad_len` elements of vector `tensor`."""
+  if isinstance(pad_len, int) and pad_len == 0:
+    return tensor
+  with ops.colocate_with(tensor):
+    length = array_ops.shape(tensor)[0] - pad_len
+    return array_ops.slice(tensor, [0], array_ops.expand_dims(length, 0))
+
+
+def build_ring_all_reduce(input_tensors, red_op=math_ops.add, un_op=None):
+  """Builds a ring all-reduce of `input_tensors`.
+
+  Each tensor is split into `n` chunks, where `n = len(input_tensors)`. In
+  `n - 1` reduce-scatter steps, every device passes one partially reduced
+  chunk to the next device around the ring, so that each device ends up
+  with one fully reduced chunk. In `n - 1` all-gather steps, the reduced
+  chunks then travel around the ring once more. Every step sends `1 / n`
+  of the tensor from each device to its successor, so all links of the
+  ring are busy at the same time.
+
+  The ring follows the order of `input_tensors`, which should therefore
+  list the devices of one worker next to each other.
+
+  Args:
+    input_tensors: List of tensors of the same shape and dtype, each on
+      its own device.
+    red_op: Binary element-wise reduction, e.g. `math_ops.add`.
+    un_op: Optional unary element-wise op applied to the fully reduced
+      values, e.g. to divide a sum by `n`.
+
+  Returns:
+    List of tensors with the reduced value, where tensor `i` is on the
+    device of `input_tensors[i]`.
+
+  Raises:
+    ValueError: If `input_tensors` is empty, not placed, or of different
+      shapes.
+  """
+  devices = _check_devices(input_tensors)
+  n = len(input_tensors)
+  if n == 1:
+    return [un_op(input_tensors[0]) if un_op else input_tensors[0]]
+  flat, shape = _flatten(input_tensors)
+  chunks = []
+  pad_lens = []
+  for t in flat:
+    pieces, pad_len = _padded_split(t, n)
+    chunks.append(pieces)
+    pad_lens.append(pad_len)
+
+  # Reduce-scatter: at step s, device i passes chunk (i - s) mod n on to
+  # device i + 1, which adds its own. Chunk j thus becomes fully reduced
+  # on device j - 1.
+  for s in range(n - 1):
+    for i in range(n):
+      dst = (i + 1) % n
+      j = (i - s) % n
+      with ops.device(devices[dst]):
+        chunks[dst][j] = red_op(chunks[i][j], chunks[dst][j])
+  if un_op:
+    for i in range(n):
+      j = (i + 1) % n
+      with ops.device(devices[i]):
+        chunks[i][j] = un_op(chunks[i][j])
+
+  # All-gather: at step s, device i passes on chunk (i + 1 - s) mod n,
+  # which it reduced itself or received in the previous step.
+  for s in range(n - 1):
+    for i in range(n):
+      dst = (i + 1) % n
+      j = (i + 1 - s) % n
+      with ops.device(devices[dst]):
+        chunks[dst][j] = array_ops.identity(chunks[i][j])
+
+  outputs = []
+  for i in range(n):
+    with ops.device(devices[i]):
+      outputs.append(
+          _strip_padding(array_ops.concat(chunks[i], 0), pad_lens[i]))
+  return _unflatten(outputs, shape, input_tensors)
+
+
+def build_tree_all_reduce(input_tensors, red_op=math_ops.add, un_op=None):
+  """Builds a binary tree all-reduce of `input_tensors`.
+
+  The tensors are reduced pairwise up a binary tree to the device of
+  `input_tensors[0]`, and the result is broadcast back down the same tree.
+  Each step sends whole tensors, so this takes less time than a ring only
+  for small tensors, or on few devices.
+
+  Args:
+    input_tensors: List of tensors of the same shape and dtype, each on
+      its own device.
+    red_op: Binary element-wise reduction, e.g. `math_ops.add`.
+    un_op: Optional unary element-wise op applied to the fully reduced
+      value.
+
+  Returns:
+    List of tensors with the reduced value, where tensor `i` is on the
+    device of `input_tensors[i]`.
+
+  Raises:
+    ValueError: If `input_tensors` is empty or not placed.
+  """
+  devices = _check_devices(input_tensors)
+  n = len(input_tensors)
+  values = list(input_tensors)
+  span = 1
+  while span < n:
+    for i in range(0, n - span, 2 * span):
+      with ops.device(devices[i]):
+        values[i] = red_op(values[i], values[i + span])
+    span *= 2
+  if un_op:
+    with ops.device(devices[0]):
+      values[0] = un_op(values[0])
+  outputs = [None] * n
+  outputs[0] = values[0]
+  while span > 1:
+    span //= 2
+    for i in range(0, n - span, 2 * span):
+      with ops.device(devices[i + span]):
+        outputs[i + span] = array_ops.identity(outputs[i])
+  return outputs
+
+
+def _worker_of(device):
+  """Returns the name of the worker that `device` belongs to."""
+  spec = pydev.DeviceSpec.from_string(device)
+  return (spec.job, spec.replica, spec.task)
+
+
+_ALGORITHMS = {
+    "ring": build_ring_all_reduce,
+    "tree": build_tree_all_reduce,
+}
+
+
+def build_hierarchical_all_reduce(input_tensors,
+                                  cross_worker_alg="ring",
+                                  red_op=math_ops.add,
+                                  un_op=None):
+  """Builds an all-reduce that reduces the tensors of each worker first.
+
+  The tensors on the devices of each worker are reduced onto the first of
+  those devices, in the order of `input_tensors`. These partial results
+  are then all-reduced across workers with `cross_worker_alg`, and each
+  result is copied to the other devices of its worker. Copies within a
+  worker are cheap compared to the network, so this sends each byte over
+  the network only from one device per worker.
+
+  Args:
+    input_tensors: List of tensors of the same shape and dtype, each on
+      its own device.
+    cross_worker_alg: "ring" or "tree", the algorithm of the all-reduce
+      across workers.
+    red_op: Binary element-wise reduction, e.g. `math_ops.add`.
+    un_op: Optional unary element-wise op applied to the fully reduced
+      values.
+
+  Returns:
+    List of tensors with the reduced value, where tensor `i` is on the
+    device of `input_tensors[i]`.
+
+  Raises:
+    ValueError: If `input_tensors` is empty or not placed, or
+      `cross_worker_alg` is unknown.
+  """
+  if cross_worker_alg not in _ALGORITHMS:
+    raise ValueError("Unknown all-reduce algorithm: %s" % cross_worker_alg)
+  devices = _check_devices(input_tensors)
+  groups = collections.OrderedDict()
+  for i, d in enumerate(devices):
+    groups.setdefault(_worker_of(d), []).append(i)
+
+  partials = []
+  for members in groups.values():
+    value = input_tensors[members[0]]
+    with ops.device(devices[members[0]]):
+      for i in members[1:]:
+        value = red_op(value, input_tensors[i])
+    partials.append(value)
+  reduced = _ALGORITHMS[cross_worker_alg](partials, red_op, un_op)
+
+  outputs = [None] * len(input_tensors)
+  for members, value in zip(groups.values(), reduced):
+    outputs[members[0]] = value
+    for i in members[1:]:
+      with ops.device(devices[i]):
+        outputs[i] = array_ops.identity(value)
+  return outputs
+
+
+def _num_bytes(tensor):
+  """Returns the size of `tensor` in bytes, or None if it is not known."""
+  shape = tensor.get_shape()
+  if not shape.is_fully_defined():
+    return None
+  return shape.num_elements() * tensor.dtype.size
+
+
+def _make_buckets(grads, bucket_bytes):
+  """Groups the indices of `grads` into buckets.
+
+  Gradients are visited from last to first, which is roughly the order in
+  which backprop produces them. Consecutive gradients of the same dtype
+  share a bucket as long as it stays within `bucket_bytes`; gradients
+  that are larger, or whose size is not known, get a bucket of their own.
+  None gradients are skipped.
+
+  Args:
+    grads: List of gradient tensors of one replica.
+    bucket_bytes: Maximum size of a bucket of more than one gradient.
+
+  Returns:
+    List of lists of indices into `grads`.
+  """
+  buckets = []
+  current = []
+  current_bytes = 0
+  for i in reversed(range(len(grads))):
+    if grads[i] is None:
+      continue
+    size = _num_bytes(grads[i])
+    if size is None or size >= bucket_bytes:
+      # Close the current bucket, which would otherwise wait for the
+      # gradients that come after this one.
+      if current:
+        buckets.append(current)
+        current = []
+        current_bytes = 0
+      buckets.append([i])
+      continue
+    if current and (current_bytes + size > bucket_bytes or
+                    grads[current[0]].dtype != grads[i].dtype):
+      buckets.append(current)
+      current = []
+      current_bytes = 0
+    current.append(i)
+    current_bytes += size
+  if current:
+    buckets.append(current)
+  return buckets
+
+
+def all_reduce_gradients(replica_grads,
+                         algorithm="ring",
+                         hierarchical=True,
+                         average=True,
+                         bucket_bytes=4 << 20):
+  """All-reduces the gradients of data-parallel replicas.
+
+  Small gradients are concatenated into buckets of up to `bucket_bytes`
+  bytes, so that they share the latency of one all-reduce, and each bucket
+  is all-reduced on its own.
+
+  Args:
+    replica_grads: List with one list of gradients per replica. The lists
+      must match in length, shapes and dtypes, and each replica's gradients
+      must be placed on the device of that replica; a gradient may be None
+      if it is None for all replicas.
+    algorithm: "ring" or "tree".
+    hierarchical: If True, reduce the gradients of the replicas of each
+      worker locally first, see `build_hierarchical_all_reduce`.
+    average: If True, return the mean of the gradients instead of the sum.
+    bucket_bytes: Maximum size of a bucket of more than one gradient.
+
+  Returns:
+    List with one list of reduced gradients per replica, in the order of
+    `replica_grads`.
+
+  Raises:
+    ValueError: If `replica_grads` is empty or its lists do not match, or
+      `algorithm` is unknown.
+  """
+  if not replica_grads:
+    raise ValueError("replica_grads must not be empty")
+  if algorithm not in _ALGORITHMS:
+    raise ValueError("Unknown all-reduce algorithm: %s" % algorithm)
+  num_replicas = len(replica_grads)
+  num_grads = len(replica_grads[0])
+  for grads in replica_grads[1:]:
+    if len(grads) != num_grads:
+      raise ValueError("All replicas must have the same number of gradients")
+    for g, first in zip(grads, replica_grads[0]):
+      if (g is None) != (first is None):
+        raise ValueError("A gradient is None for some replicas only")
+
+  un_op = None
+  if average:
+    un_op = lambda t: t / math_ops.cast(num_replicas, t.dtype)
+
+  def reduce_fn(tensors):
+    if hierarchical:
+      return build_hierarchical_all_reduce(tensors, algorithm, un_op=un_op)
+    return _ALGORITHMS[algorithm](tensors, un_op=un_op)
+
+  outputs = [[None] * num_grads for _ in range(num_replicas)]
+  with ops.name_scope("all_reduce_gradients"):
+    for bucket in _make_buckets(replica_grads[0], bucket_bytes):
+      if len(bucket) == 1:
+        i = bucket[0]
+        reduced = reduce_fn([grads[i] for grads in replica_grads])
+        for r in range(num_replicas):
+          outputs[r][i] = reduced[r]
+        continue
+      packed = []
+      for grads in replica_grads:
+        with ops.colocate_with(grads[bucket[0]]):
+          packed.append(
+              array_ops.concat(
+                  [array_ops.reshape(grads[i], [-1]) for i in bucket], 0))
+      reduced = reduce_fn(packed)
+      sizes = [replica_grads[0][i].get_shape().num_elements() for i in bucket]
+      for r in range(num_replicas):
+        with ops.colocate_with(reduced[r]):
+          parts = array_ops.split(reduced[r], sizes)
+          for i, part in zip(bucket, parts):
+            outputs[r][i] = array_ops.reshape(
+                part, replica_grads[r][i].get_shape().as_list())
+  return outputs
@@ -0,0 +1,160 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for all-reduce graphs."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.contrib.all_reduce.python.ops import all_reduce
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import device as pydev
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+_NUM_DEVICES = 5
+
+
+def _cpu(i):
+  return "/job:localhost/replica:0/task:0/cpu:%d" % i
+
+
+class AllReduceTest(test.TestCase):
+
+  def _config(self):
+    return config_pb2.ConfigProto(device_count={"CPU": _NUM_DEVICES})
+
+  def _makeInputs(self, num_devices, shape, dynamic=False):
+    values = [np.random.rand(*shape).astype(np.float32)
+              for _ in range(num_devices)]
+    tensors = []
+    feeds = {}
+    for i, v in enumerate(values):
+      with ops.device(_cpu(i)):
+        if dynamic:
+          t = array_ops.placeholder(np.float32)
+          feeds[t] = v
+        else:
+          t = constant_op.constant(v)
+        tensors.append(t)
+    return values, tensors, feeds
+
+  def _testAllReduce(self, build_fn, num_devices, shape, dynamic=False):
+    with ops.Graph().as_default():
+      values, tensors, feeds = self._makeInputs(num_devices, shape, dynamic)
+      outputs = build_fn(tensors)
+      self.assertEqual(num_devices, len(outputs))
+      for t, o in zip(tensors, outputs):
+        self.assertEqual(t.device, o.device)
+      with self.test_session(config=self._config()) as sess:
+        results = sess.run(outputs, feed_dict=feeds)
+      expected = np.sum(values, axis=0)
+      for r in results:
+        self.assertAllClose(expected, r, rtol=1e-5)
+
+  def testRing(self):
+    for num_devices in range(1, _NUM_DEVICES + 1):
+      # The shapes do not divide evenly into chunks.
+      self._testAllReduce(all_reduce.build_ring_all_reduce, num_devices, [7])
+      self._testAllReduce(
+          all_reduce.build_ring_all_reduce, num_devices, [3, 4, 5])
+    self._testAllReduce(
+        all_reduce.build_ring_all_reduce, 3, [2, 5], dynamic=True)
+
+  def testTree(self):
+    for num_devices in range(1, _NUM_DEVICES + 1):
+      self._testAllReduce(all_reduce.build_tree_all_reduce, num_devices, [7])
+
+  def testHierarchical(self):
+    for alg in ["ring", "tree"]:
+      self._testAllReduce(
+          lambda t, alg=alg: all_reduce.build_hierarchical_all_reduce(t, alg),
+          _NUM_DEVICES, [4, 3])
+
+  def testHierarchicalGroupsByWorker(self):
+    with ops.Graph().as_default() as g:
+      tensors = []
+      for task in range(3):
+        for gpu in range(2):
+          with ops.device("/job:worker/task:%d/gpu:%d" % (task, gpu)):
+            tensors.append(constant_op.constant([1.0, 2.0]))
+      outputs = all_reduce.build_hierarchical_all_reduce(tensors, "ring")
+      for t, o in zip(tensors, outputs):
+        self.assertEqual(t.device, o.device)
+      # Only the first device of each worker takes part in the ring, so
+      # no other device adds, or is sent, partial sums of other workers.
+      for op in g.get_operations():
+        if (op.type == "Add" and
+            pydev.DeviceSpec.from_string(op.device).device_index == 1):
+          self.fail("Unexpected cross-worker reduction on %s" % op.device)
+
+  def testAllReduceGradients(self):
+    shapes = [[3, 2], [5], [64, 64], [1], [2, 2, 2]]
+    num_replicas = 3
+    with ops.Graph().as_default():
+      values = [[np.random.rand(*s).astype(np.float32) for s in shapes]
+                for _ in range(num_replicas)]
+      replica_grads = []
+      for r in range(num_replicas):
+        with ops.device(_cpu(r)):
+          grads = [constant_op.constant(v) for v in values[r]]
+          grads.insert(2, None)
+          replica_grads.append(grads)
+      # Buckets of at most 64 bytes keep the large gradient on its own,
+      # and pack the small ones into several buckets.
+      outputs = all_reduce.all_reduce_gradients(
+          replica_grads, average=True, bucket_bytes=64)
+      self.assertIsNone(outputs[0][2])
+      fetches = [[g for g in grads if g is not None] for grads in outputs]
+      with self.test_session(config=self._config()) as sess:
+        results = sess.run(fetches)
+      for r in range(num_replicas):
+        for i, shape in enumerate(shapes):
+          expected = np.mean([values[k][i] for k in range(num_replicas)],
+                             axis=0)
+          self.assertAllEqual(shape, results[r][i].shape)
+          self.assertAllClose(expected, results[r][i], rtol=1e-5)
+
+  def testMakeBuckets(self):
+    with ops.Graph().as_default():
+      grads = [
+          array_ops.zeros([4]),  # 16 bytes
+          array_ops.zeros([4]),
+          array_ops.zeros([4], dtype=np.int32),
+          array_ops.zeros([100]),
+          array_ops.zeros([8]),  # 32 bytes
+          array_ops.placeholder(np.float32),
+      ]
+      self.assertEqual([[5], [4], [3], [2], [1, 0]],
+                       all_reduce._make_buckets(grads, 32))
+
+  def testErrors(self):
+    with self.assertRaisesRegexp(ValueError, "must not be empty"):
+      all_reduce.build_ring_all_reduce([])
+    with ops.Graph().as_default():
+      with self.assertRaisesRegexp(ValueError, "placed"):
+        all_reduce.build_tree_all_reduce([constant_op.constant(1.0)])
+      with ops.device(_cpu(0)):
+        t = constant_op.constant(1.0)
+      with self.assertRaisesRegexp(ValueError, "Unknown"):
+        all_reduce.build_hierarchical_all_reduce([t], "butterfly")
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,94 @@
+"""Builds Android inference libraries with only the kernels models need."""
+
+load(
+    "//tensorflow:tensorflow.bzl",
+    "clean_dep",
+    "if_android",
+    "tf_copts",
+    "tf_selective_registration_header",
+)
+
+# Builds lib<name>.so, the same library as libtensorflow_inference.so but
+# with only the ops, kernels and kernel types that the GraphDefs in graphs
+# use. The other kernels are compiled out of their registrations and then
+# stripped by the linker.
+#
+# For example, in a BUILD file:
+#   tf_selective_inference_library(
+#       name = "my_model_inference",
+#       graphs = ["my_model.pb"],
+#   )
+# and then:
+#   bazel build -c opt :libmy_model_inference.so \
+#       --crosstool_top=//external:android/crosstool \
+#       --host_crosstool_top=@bazel_tools//tools/cpp:toolchain \
+#       --cpu=armeabi-v7a
+def tf_selective_inference_library(
+    name,
+    graphs,
+    proto_fileformat="rawproto",
+    default_ops="NoOp:NoOp,_Recv:RecvOp,_Send:SendOp"):
+  tf_selective_registration_header(
+      name=name + "_ops_to_register",
+      graphs=graphs,
+      proto_fileformat=proto_fileformat,
+      default_ops=default_ops,)
+
+  native.cc_library(
+      name=name + "_lib",
+      srcs=if_android([
+          clean_dep("//tensorflow/core:android_op_registrations_and_gradients"),
+          clean_dep("//tensorflow/core/kernels:android_all_ops"),
+          clean_dep("//tensorflow/c:android_srcs"),
+          clean_dep("//tensorflow/java/src/main/native:android_srcs"),
+          clean_dep(
+              "//tensorflow/contrib/android:android_tensorflow_inference_jni_srcs"
+          ),
+      ]),
+      copts=tf_copts() + [
+          "-Os",
+          "-DSELECTIVE_REGISTRATION",
+          "-DSUPPORT_SELECTIVE_REGISTRATION",
+          "-ffunction-sections",
+          "-fdata-sections",
+      ],
+      tags=[
+          "manual",
+          "notap",
+      ],
+      deps=[
+          ":" + name + "_ops_to_register",
+          clean_dep(
+              "//tensorflow/core:android_tensorflow_lib_selective_registration"
+          ),
+          clean_dep("//third_party/eigen3"),
+          "@gemmlowp//:gemmlowp",
+      ],
+      alwayslink=1,)
+
+  linker_script = clean_dep(
+      "//tensorflow/contrib/android:jni/version_script.lds")
+  native.cc_binary(
+      name="lib" + name + ".so",
+      srcs=[],
+      linkopts=if_android([
+          "-landroid",
+          "-llog",
+          "-lm",
+          "-z defs",
+          "-s",
+          "-Wl,--gc-sections",
+          # This line must be directly followed by the linker script.
+          "-Wl,--version-script",
+          linker_script,
+      ]),
+      linkshared=1,
+      linkstatic=1,
+      tags=[
+          "manual",
+          "notap",
+      ],
+      deps=[
+          ":" + name + "_lib",
+          linker_script,
+      ],)
@@ -0,0 +1,203 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_ADAPTIVE_BATCH_POLICY_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_ADAPTIVE_BATCH_POLICY_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Adjusts online the timeout and the maximum size of the batches formed by a
+// batch scheduler queue, so that the 99th percentile of the task latencies
+// (queue time plus processing time) stays under a target, while batching as
+// much as the target allows.
+//
+// The policy measures the latency of the oldest task of each batch, from its
+// arrival to the completion of the batch, over a sliding window of batches.
+// Every 'adjustment_interval' batches:
+//  - If the 99th percentile of these latencies exceeds the target, the batch
+//    timeout is halved, and if processing the batches takes more than half of
+//    the target, the maximum batch size is reduced by a quarter.
+//  - If it is below 80% of the target, the batch timeout is raised by a
+//    sixteenth of the target and the maximum batch size by an eighth,
+//    up to the configured upper bounds.
+//
+// In addition, the maximum batch size is capped at the number of tasks
+// expected to arrive within the target latency given the measured arrival
+// rate, so that at low traffic batches are closed as soon as they hold the
+// tasks that may reasonably join them, rather than when the timeout expires.
+//
+// The latencies are measured from timestamps supplied by the caller, in
+// microseconds of an arbitrary clock. This class is thread-safe.
+class AdaptiveBatchPolicy {
+ public:
+  struct Options {
+    // The upper bound of the maximum batch size, which is where it starts.
+    int max_batch_size = 1000;
+
+    // The upper bound of the batch timeout, which is where it starts.
+    int64 max_batch_timeout_micros = 0;
+
+    // The target 99th percentile latency. Must be positive.
+    int64 target_latency_micros = 0;
+
+    // The number of batches over which the latency percentile is computed.
+    int window_size = 256;
+
+    // The number of batches between two adjustments.
+    int adjustment_interval = 16;
+  };
+
+  explicit AdaptiveBatchPolicy(const Options& options)
+      : options_(options),
+        max_batch_size_(options.max_batch_size),
+        batch_timeout_micros_(options.max_batch_timeout_micros) {
+    latencies_micros_.reserve(options.window_size);
+    processing_micros_.reserve(options.window_size);
+  }
+
+  // Records the arrival of a task at 'now_micros'.
+  void RecordArrival(uint64 now_micros) {
+    mutex_lock l(mu_);
+    if (has_arrival_ && now_micros >= last_arrival_micros_) {
+      const double interval = now_micros - last_arrival_micros_;
+      mean_interarrival_micros_ =
+          mean_interarrival_micros_ < 0
+              ? interval
+              : kSmoothing * interval +
+                    (1 - kSmoothing) * mean_interarrival_micros_;
+    }
+    has_arrival_ = true;
+    last_arrival_micros_ = now_micros;
+  }
+
+  // Records that a batch, whose oldest task arrived at 'start_micros', was
+  // processed from 'process_start_micros' to 'process_end_micros'.
+  void RecordBatch(uint64 start_micros, uint64 process_start_micros,
+                   uint64 process_end_micros) {
+    mutex_lock l(mu_);
+    AddSample(process_end_micros - start_micros, &latencies_micros_);
+    AddSample(process_end_micros - process_start_micros, &processing_micros_);
+    next_sample_ = (next_sample_ + 1) % options_.window_size;
+    if (++batches_since_adjustment_ >= options_.adjustment_interval) {
+      Adjust();
+      batches_since_adjustment_ = 0;
+    }
+  }
+
+  // Returns the size at which batches are currently closed.
+  int max_batch_size() const {
+    mutex_lock l(mu_);
+    int max_batch_size = max_batch_size_;
+    if (mean_interarrival_micros_ > 0) {
+      const double expected_tasks =
+          options_.target_latency_micros / mean_interarrival_micros_;
+      if (expected_tasks < max_batch_size) {
+        max_batch_size = std::max(1, static_cast<int>(expected_tasks));
+      }
+    }
+    return max_batch_size;
+  }
+
+  // Returns the time after which batches are currently closed.
+  int64 batch_timeout_micros() const {
+    mutex_lock l(mu_);
+    return batch_timeout_micros_;
+  }
+
+  // Returns the measured arrival rate, in tasks per second, or 0 if unknown.
+  double arrival_rate() const {
+    mutex_lock l(mu_);
+    return mean_interarrival_micros_ > 0 ? 1e6 / mean_interarrival_micros_
+                                         : 0;
+  }
+
+ private:
+  // The weight of the last inter-arrival time in the running mean.
+  static constexpr double kSmoothing = 0.05;
+
+  void AddSample(int64 sample, std::vector<int64>* samples)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (samples->size() < static_cast<size_t>(options_.window_size)) {
+      samples->push_back(sample);
+    } else {
+      (*samples)[next_sample_] = sample;
+    }
+  }
+
+  // Returns the 99th percentile of 'samples', which must not be empty.
+  static int64 Percentile99(std::vector<int64> samples) {
+    const size_t index = (samples.size() - 1) * 99 / 100;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+  }
+
+  void Adjust() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const int64 target = options_.target_latency_micros;
+    const int64 latency = Percentile99(latencies_micros_);
+    if (latency > target) {
+      batch_timeout_micros_ /= 2;
+      if (Percentile99(processing_micros_) > target / 2) {
+        max_batch_size_ = std::max(1, max_batch_size_ - max_batch_size_ / 4);
+      }
+    } else if (latency < target * 0.8) {
+      batch_timeout_micros_ =
+          std::min(options_.max_batch_timeout_micros,
+                   batch_timeout_micros_ + std::max<int64>(1, target / 16));
+      max_batch_size_ =
+          std::min(options_.max_batch_size,
+                   max_batch_size_ + std::max(1, max_batch_size_ / 8));
+    }
+  }
+
+  const Options options_;
+
+  mutable mutex mu_;
+
+  // The current maximum batch size, before the cap from the arrival rate.
+  int max_batch_size_ GUARDED_BY(mu_);
+
+  // The current batch timeout.
+  int64 batch_timeout_micros_ GUARDED_BY(mu_);
+
+  // The running mean of the time between two arrivals, or -1 if unknown.
+  double mean_interarrival_micros_ GUARDED_BY(mu_) = -1;
+  bool has_arrival_ GUARDED_BY(mu_) = false;
+  uint64 last_arrival_micros_ GUARDED_BY(mu_) = 0;
+
+  // The latencies of the oldest task and the processing times of the last
+  // 'window_size' batches, as ring buffers whose next entry to overwrite is
+  // 'next_sample_'.
+  std::vector<int64> latencies_micros_ GUARDED_BY(mu_);
+  std::vector<int64> processing_micros_ GUARDED_BY(mu_);
+  int next_sample_ GUARDED_BY(mu_) = 0;
+
+  int batches_since_adjustment_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveBatchPolicy);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_ADAPTIVE_BATCH_POLICY_H_
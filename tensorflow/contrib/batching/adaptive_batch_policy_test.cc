@@ -0,0 +1,108 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/adaptive_batch_policy.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+AdaptiveBatchPolicy::Options TestOptions() {
+  AdaptiveBatchPolicy::Options options;
+  options.max_batch_size = 64;
+  options.max_batch_timeout_micros = 800;
+  options.target_latency_micros = 1000;
+  options.window_size = 16;
+  options.adjustment_interval = 16;
+  return options;
+}
+
+// Records 'num_batches' batches whose oldest task waited in the queue for
+// 'queue_micros' and which took 'processing_micros' to process.
+void RecordBatches(int num_batches, int64 queue_micros, int64 processing_micros,
+                   AdaptiveBatchPolicy* policy) {
+  for (int i = 0; i < num_batches; ++i) {
+    const uint64 start_micros = 1000000;
+    policy->RecordBatch(start_micros, start_micros + queue_micros,
+                        start_micros + queue_micros + processing_micros);
+  }
+}
+
+TEST(AdaptiveBatchPolicyTest, StartsAtUpperBounds) {
+  AdaptiveBatchPolicy policy(TestOptions());
+  EXPECT_EQ(64, policy.max_batch_size());
+  EXPECT_EQ(800, policy.batch_timeout_micros());
+  EXPECT_EQ(0, policy.arrival_rate());
+}
+
+TEST(AdaptiveBatchPolicyTest, BacksOffWhenOverTarget) {
+  AdaptiveBatchPolicy policy(TestOptions());
+  // The batches are processed quickly, so only the timeout is reduced.
+  RecordBatches(15, 1900, 100, &policy);
+  EXPECT_EQ(800, policy.batch_timeout_micros());
+  RecordBatches(1, 1900, 100, &policy);
+  EXPECT_EQ(400, policy.batch_timeout_micros());
+  EXPECT_EQ(64, policy.max_batch_size());
+
+  // Processing the batches takes most of the target, so they get smaller too.
+  RecordBatches(16, 1400, 600, &policy);
+  EXPECT_EQ(200, policy.batch_timeout_micros());
+  EXPECT_EQ(48, policy.max_batch_size());
+}
+
+TEST(AdaptiveBatchPolicyTest, RaisesWhenUnderTarget) {
+  AdaptiveBatchPolicy policy(TestOptions());
+  RecordBatches(16, 1400, 600, &policy);
+  EXPECT_EQ(400, policy.batch_timeout_micros());
+  EXPECT_EQ(48, policy.max_batch_size());
+
+  RecordBatches(16, 50, 50, &policy);
+  EXPECT_EQ(400 + 1000 / 16, policy.batch_timeout_micros());
+  EXPECT_EQ(48 + 48 / 8, policy.max_batch_size());
+
+  // The adjustments stop at the upper bounds.
+  RecordBatches(16 * 10, 50, 50, &policy);
+  EXPECT_EQ(800, policy.batch_timeout_micros());
+  EXPECT_EQ(64, policy.max_batch_size());
+}
+
+TEST(AdaptiveBatchPolicyTest, LatenciesWithinTargetBandAreKept) {
+  AdaptiveBatchPolicy policy(TestOptions());
+  RecordBatches(16, 500, 400, &policy);
+  EXPECT_EQ(800, policy.batch_timeout_micros());
+  EXPECT_EQ(64, policy.max_batch_size());
+}
+
+TEST(AdaptiveBatchPolicyTest, BatchSizeIsCappedByArrivalRate) {
+  AdaptiveBatchPolicy policy(TestOptions());
+  // One task every 110us, i.e. 9 tasks within the target latency.
+  for (int i = 1; i <= 100; ++i) {
+    policy.RecordArrival(i * 110);
+  }
+  EXPECT_NEAR(1e6 / 110, policy.arrival_rate(), 1e-3);
+  EXPECT_EQ(9, policy.max_batch_size());
+
+  // At high rates, the batch size is bounded by the configured maximum.
+  for (int i = 1; i <= 1000; ++i) {
+    policy.RecordArrival(100 * 110 + i);
+  }
+  EXPECT_EQ(64, policy.max_batch_size());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
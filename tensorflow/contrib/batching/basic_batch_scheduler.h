@@ -176,6 +176,18 @@ class BasicBatchScheduler : public BatchScheduler<TaskType> {
     // parameter.
     int max_enqueued_batches = 10;
 
+    // If positive, the scheduler adjusts online the timeout and the size at
+    // which it closes batches, within 'batch_timeout_micros' and
+    // 'max_batch_size', to keep the 99th percentile of the task latencies
+    // (queue time plus processing time) under this target, in microseconds.
+    // See AdaptiveBatchPolicy.
+    int64 target_latency_micros = 0;
+
+    // If set, the tasks whose deadline (see BatchTask::deadline_micros()) has
+    // passed when their batch is about to be processed are removed from the
+    // batch and handed to this callback instead, on the batch thread.
+    std::function<void(std::unique_ptr<TaskType>)> expired_task_callback;
+
     // The following options are typically only overridden by test code.
 
     // The environment to use.
@@ -227,6 +239,10 @@ Status BasicBatchScheduler<TaskType>::Create(
       options.batch_timeout_micros;
   shared_scheduler_queue_options.max_enqueued_batches =
       options.max_enqueued_batches;
+  shared_scheduler_queue_options.target_latency_micros =
+      options.target_latency_micros;
+  shared_scheduler_queue_options.expired_task_callback =
+      options.expired_task_callback;
   std::unique_ptr<BatchScheduler<TaskType>> shared_scheduler_queue;
   TF_RETURN_IF_ERROR(shared_scheduler->AddQueue(shared_scheduler_queue_options,
                                                 process_batch_callback,
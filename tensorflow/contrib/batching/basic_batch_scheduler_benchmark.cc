@@ -388,11 +388,13 @@ BENCHMARK(ThroughputBM_LargeTimeout)
     ->Arg(64);
 
 static void RunLatencyBenchmark(int64 task_injection_interval_micros,
-                                int64 batch_timeout_micros) {
+                                int64 batch_timeout_micros,
+                                int64 target_latency_micros = 0) {
   BasicBatchScheduler<BenchmarkBatchTask>::Options scheduler_options;
   const int kMaxBatchSize = 100;
   scheduler_options.max_batch_size = kMaxBatchSize;
   scheduler_options.batch_timeout_micros = batch_timeout_micros;
+  scheduler_options.target_latency_micros = target_latency_micros;
   const int kNumBatchThreads = 2;
   scheduler_options.num_batch_threads = kNumBatchThreads;
   scheduler_options.max_enqueued_batches = INT_MAX;  // Unbounded queue.
@@ -417,6 +419,30 @@ static void RunLatencyBenchmarks() {
   }
 }
 
+// Sweeps the task injection rate from low to peak traffic, with the batch
+// timeout and size adjusted online to meet a latency target, rather than
+// fixed.
+static void RunAdaptiveLatencyBenchmarks() {
+  const int64 kMaxBatchTimeoutMicros = 5 * 1000;
+  for (const int64 target_latency_micros : {10 * 1000, 50 * 1000}) {
+    for (const int64 task_injection_interval_micros :
+         {1000, 500, 200, 100, 50, 20}) {
+      std::cout << "Latency benchmark w/ adaptive batch timeout up to "
+                << kMaxBatchTimeoutMicros / 1000.0 << "ms"
+                << "; "
+                << "target 99% latency " << target_latency_micros / 1000.0
+                << "ms"
+                << "; "
+                << "task injection rate "
+                << 1000000.0 / task_injection_interval_micros << "/sec"
+                << "\t...";
+      RunLatencyBenchmark(task_injection_interval_micros,
+                          kMaxBatchTimeoutMicros, target_latency_micros);
+    }
+    std::cout << std::endl;
+  }
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -427,6 +453,7 @@ int main(int argc, char** argv) {
 
   // Run latency benchmarks (outside of tensorflow benchmark framework).
   tensorflow::serving::RunLatencyBenchmarks();
+  tensorflow::serving::RunAdaptiveLatencyBenchmarks();
 
   // Run throughput benchmarks (via tensorflow benchmark framework).
   tensorflow::testing::RunBenchmarks();
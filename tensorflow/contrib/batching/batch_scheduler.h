@@ -29,6 +29,7 @@ limitations under the License.
 #include <stddef.h>
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -62,6 +63,14 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the time by which the task should be processed, in microseconds of
+  // the clock of the scheduler's Env, or the maximum uint64 value if it has no
+  // deadline. Schedulers may use it to order batches and to drop expired
+  // tasks.
+  virtual uint64 deadline_micros() const {
+    return std::numeric_limits<uint64>::max();
+  }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -35,13 +35,17 @@ typedef Eigen::GpuDevice GPUDevice;
 typedef Eigen::SyclDevice SYCLDevice;
 #endif  // TENSORFLOW_USE_SYCL
 
-// Concatenates 'inputs' into a single tensor along the zeroth dimension.
-// Requires that all elements of 'inputs' have element type T. Writes to the
-// op's output at position 'output_index', using 'context' for the allocation to
-// ensure proper device placement.
+// Concatenates 'inputs' into a single tensor along the zeroth dimension,
+// followed by 'padding_amount' copies of the first row of the first non-empty
+// input. Requires that all elements of 'inputs' have element type T. Writes to
+// the op's output at position 'output_index', using 'context' for the
+// allocation to ensure proper device placement.
+//
+// The inputs and the padding rows are copied directly into the output, and a
+// single input without padding is forwarded to the output without any copy.
 template <typename T>
 Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor>& inputs,
-              int output_index) {
+              int padding_amount, int output_index) {
   const int input_dims = inputs[0].dims();
   const TensorShape& input_shape = inputs[0].shape();
 
@@ -49,7 +53,8 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor>& inputs,
   // dimensional concat. Assuming the dimensions of any input tensor are
   // {y0, y1,...,ym-1}, we flatten it to {1, y}, where y = Prod_i(yi).
   std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>> inputs_flat;
-  inputs_flat.reserve(inputs.size());
+  inputs_flat.reserve(inputs.size() + padding_amount);
+  const Tensor* padding_source = nullptr;
   int64 output_dim0 = 0;
   for (int i = 0; i < inputs.size(); ++i) {
     const Tensor& input = inputs[i];
@@ -70,10 +75,31 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor>& inputs,
     if (input.NumElements() > 0) {
       inputs_flat.emplace_back(new typename TTypes<T, 2>::ConstMatrix(
           input.shaped<T, 2>({1, input.NumElements()})));
+      if (padding_source == nullptr) {
+        padding_source = &input;
+      }
     }
     output_dim0 += input.dim_size(0);
   }
 
+  if (padding_amount > 0) {
+    if (padding_source == nullptr) {
+      return errors::InvalidArgument(
+          "Cannot pad a batch whose input tensors are all empty");
+    }
+    // The padding rows all read the first row of 'padding_source' in place.
+    const int64 row_size =
+        padding_source->NumElements() / padding_source->dim_size(0);
+    for (int i = 0; i < padding_amount; ++i) {
+      inputs_flat.emplace_back(new typename TTypes<T, 2>::ConstMatrix(
+          padding_source->flat<T>().data(), 1, row_size));
+    }
+    output_dim0 += padding_amount;
+  } else if (inputs.size() == 1) {
+    context->set_output(output_index, inputs[0]);
+    return Status::OK();
+  }
+
   TensorShape output_shape(input_shape);
   output_shape.set_dim(0, output_dim0);
   Tensor* output = nullptr;
@@ -136,11 +162,11 @@ Status SplitEasyCases(OpKernelContext* context, const Tensor& input,
   return Status::OK();
 }
 
-// Handles the general case, on CPU.
+// Copies the 'size' rows of 'input' starting at row 'position' to a tensor
+// allocated in 'output', on CPU.
 template <typename T>
-Status SplitCPU(OpKernelContext* context, const Tensor& input,
-                const gtl::ArraySlice<int64>& sizes,
-                std::vector<Tensor>* outputs) {
+Status CopySliceCPU(OpKernelContext* context, const Tensor& input,
+                    int64 position, int64 size, Tensor* output) {
   int64 suffix_dim_size = 1;
   for (int i = 1; i < input.shape().dims(); ++i) {
     suffix_dim_size *= input.shape().dim_size(i);
@@ -148,21 +174,34 @@ Status SplitCPU(OpKernelContext* context, const Tensor& input,
   auto input_reshaped =
       input.shaped<T, 3>({1, input.shape().dim_size(0), suffix_dim_size});
 
+  TensorShape output_shape = input.shape();
+  output_shape.set_dim(0, size);
+  TF_RETURN_IF_ERROR(
+      context->allocate_temp(input.dtype(), output_shape, output));
+  auto output_shaped = output->shaped<T, 3>({1, size, suffix_dim_size});
+
+  Eigen::DSizes<Eigen::DenseIndex, 3> slice_indices{0, position, 0};
+  Eigen::DSizes<Eigen::DenseIndex, 3> slice_sizes{1, size, suffix_dim_size};
+  functor::Split<CPUDevice, T>()(context->eigen_device<CPUDevice>(),
+                                 output_shaped, input_reshaped, slice_indices,
+                                 slice_sizes);
+  return Status::OK();
+}
+
+// Handles the general case, on CPU. The splits which happen to start at an
+// aligned address are returned as slices of 'input', and only the others are
+// copied.
+template <typename T>
+Status SplitCPU(OpKernelContext* context, const Tensor& input,
+                const gtl::ArraySlice<int64>& sizes,
+                std::vector<Tensor>* outputs) {
   int64 position = 0;
   for (const int64 size : sizes) {
-    TensorShape output_shape = input.shape();
-    output_shape.set_dim(0, size);
-    Tensor output;
-    TF_RETURN_IF_ERROR(
-        context->allocate_temp(input.dtype(), output_shape, &output));
-    auto output_shaped = output.shaped<T, 3>({1, size, suffix_dim_size});
-
-    Eigen::DSizes<Eigen::DenseIndex, 3> slice_indices{0, position, 0};
-    Eigen::DSizes<Eigen::DenseIndex, 3> slice_sizes{1, size, suffix_dim_size};
-    functor::Split<CPUDevice, T>()(context->eigen_device<CPUDevice>(),
-                                   output_shaped, input_reshaped, slice_indices,
-                                   slice_sizes);
-
+    Tensor output = input.Slice(position, position + size);
+    if (!output.IsAligned()) {
+      TF_RETURN_IF_ERROR(
+          CopySliceCPU<T>(context, input, position, size, &output));
+    }
     outputs->emplace_back(output);
 
     position += size;
@@ -345,52 +384,21 @@ class BatchResource : public ResourceBase {
             task.done_callback);
       }
 
-      // Concatenate the tasks ith input tensors into a big output tensor.
+      // Concatenate the tasks ith input tensors into a big output tensor, and
+      // add padding as needed. Use the first row of the first non-empty task's
+      // tensor as the data for padding.
       std::vector<Tensor> to_concatenate;
       for (int task_idx = 0; task_idx < batch->num_tasks(); ++task_idx) {
         to_concatenate.push_back(batch->task(task_idx).inputs.at(i));
       }
 
-      // Add padding as needed. Use the first row of the first task's tensor as
-      // the data for padding.
-      if (padding_amount > 0) {
-        const Tensor& padding_source = batch->task(0).inputs.at(i);
-        Tensor padding;
-        if (padding_source.shape().dim_size(0) == 1) {
-          padding = padding_source;
-        } else {
-          const std::vector<int64> slice_sizes = {1};
-          const DataType type = padding_source.dtype();
-          Status slice_status;
-          std::vector<Tensor> slices;
-          switch (type) {
-#define CASE(type)                                                   \
-  case DataTypeToEnum<type>::value:                                  \
-    slice_status = SplitCPU<type>(last_task_context, padding_source, \
-                                  slice_sizes, &slices);             \
-    break;
-            TF_CALL_ALL_TYPES(CASE);
-#undef CASE
-            default:
-              slice_status =
-                  errors::InvalidArgument("Unsupported data type: ", type);
-              break;
-          }
-          OP_REQUIRES_OK_ASYNC(last_task_context, slice_status,
-                               last_task_callback);
-          padding = slices.at(0);
-        }
-        for (int i = 0; i < padding_amount; ++i) {
-          to_concatenate.push_back(padding);
-        }
-      }
-
       const DataType type = to_concatenate[0].dtype();
       Status concat_status;
       switch (type) {
-#define CASE(type)                                                      \
-  case DataTypeToEnum<type>::value:                                     \
-    concat_status = Concat<type>(last_task_context, to_concatenate, i); \
+#define CASE(type)                                                         \
+  case DataTypeToEnum<type>::value:                                        \
+    concat_status =                                                        \
+        Concat<type>(last_task_context, to_concatenate, padding_amount, i); \
     break;
         TF_CALL_ALL_TYPES(CASE);
 #undef CASE
@@ -834,9 +842,9 @@ class UnbatchGradResource : public ResourceBase {
 
     const DataType type = tensors[0].dtype();
     switch (type) {
-#define CASE(type)                                         \
-  case DataTypeToEnum<type>::value:                        \
-    TF_RETURN_IF_ERROR(Concat<type>(context, tensors, 0)); \
+#define CASE(type)                                            \
+  case DataTypeToEnum<type>::value:                           \
+    TF_RETURN_IF_ERROR(Concat<type>(context, tensors, 0, 0)); \
     break;
       TF_CALL_ALL_TYPES(CASE);
 #undef CASE
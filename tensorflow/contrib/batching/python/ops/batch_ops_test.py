@@ -108,6 +108,22 @@ class BatchOpsTest(test.TestCase):
       # Check that the batch tensor incorporates the padding.
       self.assertEqual(len(batch_t), 5)
 
+  def testBatchPaddingRepeatsFirstRow(self):
+    """Test that the padding rows are copies of the first row of the batch."""
+    with self.test_session() as sess:
+      inp = array_ops.placeholder(dtype=dtypes.float32, shape=[2, 3])
+      batched, index, _ = batch_ops.batch(
+          [inp], num_batch_threads=1, max_batch_size=4,
+          batch_timeout_micros=0, allowed_batch_sizes=[4],
+          grad_timeout_micros=0, batching_queue="")
+      batch_t, index_t = sess.run(
+          [batched, index], feed_dict={inp: [[1, 2, 3], [4, 5, 6]]})
+
+      self.assertAllEqual(
+          batch_t[0], [[1, 2, 3], [4, 5, 6], [1, 2, 3], [1, 2, 3]])
+      # The index tensor only covers the rows of the task.
+      self.assertAllEqual(index_t[0, 1:], [0, 2])
+
   def testMultipleBatch(self):
     """Tests that multiple batched tensors execute together."""
     with self.test_session() as sess:
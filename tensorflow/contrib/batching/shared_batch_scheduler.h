@@ -17,18 +17,24 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_SHARED_BATCH_SCHEDULER_H_
 
 #include <stddef.h>
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "tensorflow/contrib/batching/adaptive_batch_policy.h"
 #include "tensorflow/contrib/batching/batch_scheduler.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
@@ -157,6 +163,26 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     int max_enqueued_batches = 10;
+
+    // If positive, the queue adjusts online the timeout and the size at which
+    // it closes batches, within 'batch_timeout_micros' and 'max_batch_size',
+    // to keep the 99th percentile of the task latencies (queue time plus
+    // processing time) under this target, in microseconds, while forming
+    // batches as large as it allows. See AdaptiveBatchPolicy.
+    int64 target_latency_micros = 0;
+
+    // The priority of the queue. An available batch thread processes a
+    // schedulable batch of the queue with the highest priority. Among queues of
+    // equal priority, it picks the batch holding the task with the earliest
+    // deadline (see BatchTask::deadline_micros()), and the queues take turns
+    // if none of their tasks has a deadline.
+    int priority = 0;
+
+    // If set, the tasks whose deadline has passed when their batch is about to
+    // be processed are removed from the batch and handed to this callback
+    // instead, on the batch thread. The process-batch callback isn't invoked
+    // for batches whose tasks all expired.
+    std::function<void(std::unique_ptr<TaskType>)> expired_task_callback;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -167,9 +193,10 @@ class SharedBatchScheduler
   explicit SharedBatchScheduler(const Options& options);
 
   // The code executed in 'batch_threads_'. Obtains a batch to process from the
-  // queue pointed to by 'next_queue_to_schedule_', and processes it. If that
-  // queue declines to provide a batch to process, moves onto the next queue. If
-  // no queues provide a batch to process, just sleeps briefly and exits.
+  // queue with the highest priority which has a schedulable batch, breaking
+  // ties by the earliest deadline and then in round-robin order starting at
+  // 'next_queue_to_schedule_', and processes it. If no queues provide a batch
+  // to process, just sleeps briefly and exits.
   void ThreadLogic();
 
   const Options options_;
@@ -187,7 +214,7 @@ class SharedBatchScheduler
   QueueList queues_ GUARDED_BY(mu_);
 
   // An iterator over 'queues_', pointing to the queue from which the next
-  // available batch thread should grab work.
+  // available batch thread should grab work, all else being equal.
   typename QueueList::iterator next_queue_to_schedule_ GUARDED_BY(mu_);
 
   // Used by idle batch threads to wait for work to enter the system. Notified
@@ -205,6 +232,27 @@ class SharedBatchScheduler
 
 namespace internal {
 
+// Cells of the metrics of the batches processed by all the schedulers.
+inline monitoring::SamplerCell* BatchSizeMetric() {
+  static monitoring::SamplerCell* cell =
+      monitoring::Sampler<0>::New(
+          {"/tensorflow/serving/batching/batch_size",
+           "The size of each batch processed by a SharedBatchScheduler."},
+          monitoring::ExponentialBuckets(1.0, 2.0, 20))
+          ->GetCell();
+  return cell;
+}
+
+inline monitoring::SamplerCell* BatchProcessingTimeMetric() {
+  static monitoring::SamplerCell* cell =
+      monitoring::Sampler<0>::New(
+          {"/tensorflow/serving/batching/processing_time_usecs",
+           "The time to process each batch of a SharedBatchScheduler."},
+          monitoring::ExponentialBuckets(1.0, 2.0, 30))
+          ->GetCell();
+  return cell;
+}
+
 // A task queue for SharedBatchScheduler. Accepts tasks and accumulates them
 // into batches, and dispenses those batches to be processed via a "pull"
 // interface. The queue's behavior is governed by maximum batch size, timeout
@@ -223,6 +271,9 @@ namespace internal {
 // closed. If the front-most batch is open (i.e. the queue contains only one
 // batch) and has reached the timeout, it is immediately closed and returned;
 // otherwise no batch is returned for the request.
+//
+// The queue also tracks the earliest task deadline of each batch, which the
+// scheduler uses to pick among the queues' schedulable batches.
 template <typename TaskType>
 class Queue {
  public:
@@ -254,6 +305,10 @@ class Queue {
   // returns a batch, the batch is guaranteed to be closed.
   std::unique_ptr<Batch<TaskType>> ScheduleBatch();
 
+  // Returns whether ScheduleBatch() would return a batch at this time, and if
+  // so sets 'deadline_micros' to the earliest deadline of its tasks.
+  bool HasSchedulableBatch(uint64* deadline_micros);
+
   // Processes a batch that has been returned earlier by ScheduleBatch().
   void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
 
@@ -269,6 +324,8 @@ class Queue {
     return closed_;
   }
 
+  int priority() const { return options_.priority; }
+
  private:
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -281,6 +338,16 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the size and the timeout at which batches are currently closed,
+  // which are set by 'adaptive_policy_' if there is one.
+  int MaxBatchSize() const;
+  int64 BatchTimeoutMicros() const;
+
+  // Removes the expired tasks of 'batch', handing them to
+  // 'options_.expired_task_callback'.
+  std::unique_ptr<Batch<TaskType>> DropExpiredTasks(
+      std::unique_ptr<Batch<TaskType>> batch);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -308,6 +375,20 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ GUARDED_BY(mu_);
 
+  // The earliest task deadline of each batch in 'batches_', from front to back.
+  std::deque<uint64> deadlines_micros_ GUARDED_BY(mu_);
+
+  // Adjusts the batch size and timeout, if 'options_.target_latency_micros' is
+  // positive.
+  std::unique_ptr<AdaptiveBatchPolicy> adaptive_policy_;
+
+  // If 'adaptive_policy_' is set, the times at which the first task was added
+  // to each closed batch in 'batches_', from front to back, and to each batch
+  // being processed.
+  std::deque<uint64> closed_batch_start_times_micros_ GUARDED_BY(mu_);
+  std::unordered_map<const Batch<TaskType>*, uint64>
+      processed_batch_start_times_micros_ GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled. Used
   // to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ GUARDED_BY(mu_) = false;
@@ -402,6 +483,11 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.target_latency_micros < 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be non-negative; was ",
+        options.target_latency_micros);
+  }
 
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
@@ -449,39 +535,62 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
   {
     mutex_lock l(mu_);
 
+    // Visit each queue once, in round-robin order, looking for the best
+    // schedulable batch.
+    auto best_queue = queues_.end();
+    int best_priority = 0;
+    uint64 best_deadline_micros = 0;
     const int num_queues = queues_.size();
-    for (int num_queues_tried = 0;
-         batch_to_process == nullptr && num_queues_tried < num_queues;
+    auto queue_it = next_queue_to_schedule_;
+    for (int num_queues_tried = 0; num_queues_tried < num_queues;
          ++num_queues_tried) {
-      DCHECK(next_queue_to_schedule_ != queues_.end());
-
-      // If a closed queue responds to ScheduleBatch() with nullptr, the queue
-      // will never yield any further batches so we can drop it. To avoid a
-      // race, we take a snapshot of the queue's closedness state *before*
-      // calling ScheduleBatch().
-      const bool queue_closed = (*next_queue_to_schedule_)->closed();
-
-      // Ask '*next_queue_to_schedule_' if it wants us to process a batch.
-      batch_to_process = (*next_queue_to_schedule_)->ScheduleBatch();
-      if (batch_to_process != nullptr) {
-        queue_for_batch = next_queue_to_schedule_->get();
+      if (queue_it == queues_.end()) {
+        // We've hit the end. Wrap to the first queue.
+        queue_it = queues_.begin();
       }
 
-      // Advance 'next_queue_to_schedule_'.
-      if (queue_closed && (*next_queue_to_schedule_)->IsEmpty() &&
-          batch_to_process == nullptr) {
+      // If a closed queue has no schedulable batch, the queue will never yield
+      // any further batches so we can drop it. To avoid a race, we take a
+      // snapshot of the queue's closedness state *before* calling
+      // HasSchedulableBatch().
+      const bool queue_closed = (*queue_it)->closed();
+
+      uint64 deadline_micros;
+      if ((*queue_it)->HasSchedulableBatch(&deadline_micros)) {
+        const int priority = (*queue_it)->priority();
+        if (best_queue == queues_.end() || priority > best_priority ||
+            (priority == best_priority &&
+             deadline_micros < best_deadline_micros)) {
+          best_queue = queue_it;
+          best_priority = priority;
+          best_deadline_micros = deadline_micros;
+        }
+        ++queue_it;
+      } else if (queue_closed && (*queue_it)->IsEmpty()) {
         // We've encountered a closed queue with no work to do. Drop it.
-        DCHECK_NE(queue_for_batch, next_queue_to_schedule_->get());
-        next_queue_to_schedule_ = queues_.erase(next_queue_to_schedule_);
+        const bool is_next_queue = queue_it == next_queue_to_schedule_;
+        queue_it = queues_.erase(queue_it);
+        if (is_next_queue) {
+          next_queue_to_schedule_ = queue_it;
+        }
       } else {
-        ++next_queue_to_schedule_;
-      }
-      if (next_queue_to_schedule_ == queues_.end() && !queues_.empty()) {
-        // We've hit the end. Wrap to the first queue.
-        next_queue_to_schedule_ = queues_.begin();
+        ++queue_it;
       }
     }
 
+    if (best_queue != queues_.end()) {
+      // Only batch threads, which hold 'mu_', take batches from the queues, so
+      // the batch seen by HasSchedulableBatch() is still there.
+      batch_to_process = (*best_queue)->ScheduleBatch();
+      queue_for_batch = best_queue->get();
+      // Resume the round-robin order after the chosen queue, so that queues of
+      // equal priority take turns.
+      next_queue_to_schedule_ = std::next(best_queue);
+    }
+    if (next_queue_to_schedule_ == queues_.end() && !queues_.empty()) {
+      next_queue_to_schedule_ = queues_.begin();
+    }
+
     if (batch_to_process == nullptr) {
       // We couldn't find any work to do. Wait until a new batch becomes
       // schedulable, or some time has elapsed, before checking again.
@@ -505,8 +614,16 @@ Queue<TaskType>::Queue(
       env_(env),
       process_batch_callback_(process_batch_callback),
       schedulable_batch_callback_(schedulable_batch_callback) {
+  if (options.target_latency_micros > 0) {
+    AdaptiveBatchPolicy::Options policy_options;
+    policy_options.max_batch_size = options.max_batch_size;
+    policy_options.max_batch_timeout_micros = options.batch_timeout_micros;
+    policy_options.target_latency_micros = options.target_latency_micros;
+    adaptive_policy_.reset(new AdaptiveBatchPolicy(policy_options));
+  }
   // Create an initial, open batch.
   batches_.emplace_back(new Batch<TaskType>);
+  deadlines_micros_.push_back(std::numeric_limits<uint64>::max());
 }
 
 template <typename TaskType>
@@ -532,7 +649,12 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() > options_.max_batch_size) {
+    const uint64 now_micros = env_->NowMicros();
+    if (adaptive_policy_ != nullptr) {
+      adaptive_policy_->RecordArrival(now_micros);
+    }
+    if (!batches_.back()->empty() &&
+        batches_.back()->size() + (*task)->size() > MaxBatchSize()) {
       if (batches_.size() >= options_.max_enqueued_batches) {
         return errors::Unavailable(
             "The batch scheduling queue to which this task was submitted is "
@@ -541,8 +663,10 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       StartNewBatch();
     }
     if (batches_.back()->empty()) {
-      open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_start_time_micros_ = now_micros;
     }
+    deadlines_micros_.back() =
+        std::min(deadlines_micros_.back(), (*task)->deadline_micros());
     batches_.back()->AddTask(std::move(*task));
 
     if (!schedulable_batch_) {
@@ -575,10 +699,10 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
   const int num_new_batches_schedulable =
       options_.max_enqueued_batches - batches_.size();
+  const int max_batch_size = MaxBatchSize();
   const int open_batch_capacity =
-      options_.max_batch_size - batches_.back()->size();
-  return (num_new_batches_schedulable * options_.max_batch_size) +
-         open_batch_capacity;
+      std::max(0, max_batch_size - static_cast<int>(batches_.back()->size()));
+  return (num_new_batches_schedulable * max_batch_size) + open_batch_capacity;
 }
 
 template <typename TaskType>
@@ -600,6 +724,12 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
       ++num_batches_being_processed_;
       batch_to_schedule = std::move(batches_.front());
       batches_.pop_front();
+      deadlines_micros_.pop_front();
+      if (adaptive_policy_ != nullptr) {
+        processed_batch_start_times_micros_[batch_to_schedule.get()] =
+            closed_batch_start_times_micros_.front();
+        closed_batch_start_times_micros_.pop_front();
+      }
     } else {
       schedulable_batch_ = false;
     }
@@ -608,9 +738,43 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
   return batch_to_schedule;
 }
 
+template <typename TaskType>
+bool Queue<TaskType>::HasSchedulableBatch(uint64* deadline_micros) {
+  mutex_lock l(mu_);
+  if (batches_.size() >= 2 || IsOpenBatchSchedulable()) {
+    *deadline_micros = deadlines_micros_.front();
+    return true;
+  }
+  schedulable_batch_ = false;
+  return false;
+}
+
 template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
-  process_batch_callback_(std::move(batch));
+  uint64 start_time_micros = 0;
+  if (adaptive_policy_ != nullptr) {
+    mutex_lock l(mu_);
+    auto it = processed_batch_start_times_micros_.find(batch.get());
+    start_time_micros = it->second;
+    processed_batch_start_times_micros_.erase(it);
+  }
+  if (options_.expired_task_callback != nullptr) {
+    batch = DropExpiredTasks(std::move(batch));
+  }
+  const uint64 process_start_time_micros = env_->NowMicros();
+
+  if (!batch->empty()) {
+    BatchSizeMetric()->Add(batch->size());
+    process_batch_callback_(std::move(batch));
+  }
+  const uint64 process_end_time_micros = env_->NowMicros();
+  BatchProcessingTimeMetric()->Add(process_end_time_micros -
+                                   process_start_time_micros);
+
+  if (adaptive_policy_ != nullptr) {
+    adaptive_policy_->RecordBatch(start_time_micros, process_start_time_micros,
+                                  process_end_time_micros);
+  }
 
   {
     mutex_lock l(mu_);
@@ -651,8 +815,12 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
+  if (adaptive_policy_ != nullptr) {
+    closed_batch_start_times_micros_.push_back(open_batch_start_time_micros_);
+  }
   batches_.back()->Close();
   batches_.emplace_back(new Batch<TaskType>);
+  deadlines_micros_.push_back(std::numeric_limits<uint64>::max());
 }
 
 template <typename TaskType>
@@ -661,9 +829,54 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
+  return closed_ || open_batch->size() >= MaxBatchSize() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + BatchTimeoutMicros();
+}
+
+template <typename TaskType>
+int Queue<TaskType>::MaxBatchSize() const {
+  return adaptive_policy_ != nullptr ? adaptive_policy_->max_batch_size()
+                                     : options_.max_batch_size;
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::BatchTimeoutMicros() const {
+  return adaptive_policy_ != nullptr ? adaptive_policy_->batch_timeout_micros()
+                                     : options_.batch_timeout_micros;
+}
+
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::DropExpiredTasks(
+    std::unique_ptr<Batch<TaskType>> batch) {
+  const uint64 now_micros = env_->NowMicros();
+  bool has_expired_task = false;
+  for (int i = 0; i < batch->num_tasks(); ++i) {
+    if (batch->task(i).deadline_micros() <= now_micros) {
+      has_expired_task = true;
+      break;
+    }
+  }
+  if (!has_expired_task) {
+    return batch;
+  }
+
+  // Batch only removes its last task, so take them all out and put the live
+  // ones back in order into a new batch.
+  std::vector<std::unique_ptr<TaskType>> tasks(batch->num_tasks());
+  for (int i = tasks.size() - 1; i >= 0; --i) {
+    tasks[i] = batch->RemoveTask();
+  }
+  std::unique_ptr<Batch<TaskType>> live_batch(new Batch<TaskType>);
+  for (auto& task : tasks) {
+    if (task->deadline_micros() <= now_micros) {
+      options_.expired_task_callback(std::move(task));
+    } else {
+      live_batch->AddTask(std::move(task));
+    }
+  }
+  live_batch->Close();
+  return live_batch;
 }
 
 template <typename TaskType>
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/contrib/batching/shared_batch_scheduler.h"
 
+#include <limits>
+
 #include "tensorflow/contrib/batching/test_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -28,22 +30,30 @@ namespace {
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size) : size_(size) {}
+  explicit FakeTask(
+      size_t size,
+      uint64 deadline_micros = std::numeric_limits<uint64>::max())
+      : size_(size), deadline_micros_(deadline_micros) {}
 
   ~FakeTask() override = default;
 
   size_t size() const override { return size_; }
 
+  uint64 deadline_micros() const override { return deadline_micros_; }
+
  private:
   const size_t size_;
+  const uint64 deadline_micros_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
 };
 
-// Creates a FakeTask of size 'task_size', and calls 'scheduler->Schedule()' on
-// that task. Returns the resulting status.
-Status ScheduleTask(size_t task_size, BatchScheduler<FakeTask>* scheduler) {
-  std::unique_ptr<FakeTask> task(new FakeTask(task_size));
+// Creates a FakeTask of size 'task_size' and deadline 'deadline_micros', and
+// calls 'scheduler->Schedule()' on that task. Returns the resulting status.
+Status ScheduleTask(
+    size_t task_size, BatchScheduler<FakeTask>* scheduler,
+    uint64 deadline_micros = std::numeric_limits<uint64>::max()) {
+  std::unique_ptr<FakeTask> task(new FakeTask(task_size, deadline_micros));
   Status status = scheduler->Schedule(&task);
   // Schedule() should have consumed 'task' iff it returned Status::OK.
   CHECK_EQ(status.ok(), task == nullptr);
@@ -590,6 +600,235 @@ TEST(SharedBatchSchedulerTest, QueueDestructorBlocksUntilAllTasksProcessed) {
   stop_teardown.Notify();
 }
 
+TEST(SharedBatchSchedulerTest, AdaptiveQueueClosesBatchesAtArrivalRate) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  mutex mu;
+  std::vector<size_t> batch_sizes;
+  auto callback = [&mu, &batch_sizes](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    mutex_lock l(mu);
+    batch_sizes.push_back(batch->size());
+  };
+
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 100;
+    queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+    queue_options.max_enqueued_batches = 10;
+    queue_options.target_latency_micros = 1000;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // One task arrives every 250us, so 4 tasks arrive within the target
+    // latency and the batches are closed at that size, well before the
+    // timeout.
+    for (int i = 0; i < 8; ++i) {
+      TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+      env.AdvanceByMicroseconds(250);
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+
+  EXPECT_EQ((std::vector<size_t>{4, 4}), batch_sizes);
+}
+
+TEST(SharedBatchSchedulerTest, AdaptiveQueueRejectsNegativeTargetLatency) {
+  SharedBatchScheduler<FakeTask>::Options options;
+  std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.target_latency_micros = -1;
+  std::unique_ptr<BatchScheduler<FakeTask>> queue;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            scheduler
+                ->AddQueue(queue_options,
+                           [](std::unique_ptr<Batch<FakeTask>> batch) {},
+                           &queue)
+                .code());
+}
+
+TEST(SharedBatchSchedulerTest, HigherPriorityQueueIsServedFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<string> processed;
+    Notification first_batch_scheduled, first_batch_proceed;
+    auto high_callback = [&mu, &processed, &first_batch_scheduled,
+                          &first_batch_proceed](
+        std::unique_ptr<Batch<FakeTask>> batch) {
+      if (!first_batch_scheduled.HasBeenNotified()) {
+        first_batch_scheduled.Notify();
+        first_batch_proceed.WaitForNotification();
+      }
+      mutex_lock l(mu);
+      processed.push_back("high");
+    };
+    auto low_callback = [&mu,
+                         &processed](std::unique_ptr<Batch<FakeTask>> batch) {
+      mutex_lock l(mu);
+      processed.push_back("low");
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 1000 * 1000;
+    queue_options.max_enqueued_batches = 100;
+    queue_options.priority = 1;
+    std::unique_ptr<BatchScheduler<FakeTask>> high_queue;
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, high_callback, &high_queue));
+    queue_options.priority = 0;
+    std::unique_ptr<BatchScheduler<FakeTask>> low_queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, low_callback, &low_queue));
+
+    // Occupy the batch thread with a batch of the high priority queue, after
+    // which the round-robin order would move on to the low priority queue.
+    TF_ASSERT_OK(ScheduleTask(10, high_queue.get()));
+    first_batch_scheduled.WaitForNotification();
+
+    TF_ASSERT_OK(ScheduleTask(10, low_queue.get()));
+    TF_ASSERT_OK(ScheduleTask(10, high_queue.get()));
+    first_batch_proceed.Notify();
+
+    start_teardown.Notify();
+    high_queue = nullptr;
+    low_queue = nullptr;
+    EXPECT_EQ((std::vector<string>{"high", "high", "low"}), processed);
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, EarliestDeadlineIsServedFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<int> processed;
+    Notification first_batch_scheduled, first_batch_proceed;
+    auto queue_0_callback = [&mu, &processed, &first_batch_scheduled,
+                             &first_batch_proceed](
+        std::unique_ptr<Batch<FakeTask>> batch) {
+      if (!first_batch_scheduled.HasBeenNotified()) {
+        first_batch_scheduled.Notify();
+        first_batch_proceed.WaitForNotification();
+      }
+      mutex_lock l(mu);
+      processed.push_back(0);
+    };
+    auto queue_1_callback = [&mu, &processed](
+        std::unique_ptr<Batch<FakeTask>> batch) {
+      mutex_lock l(mu);
+      processed.push_back(1);
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 1000 * 1000;
+    queue_options.max_enqueued_batches = 100;
+    std::vector<std::unique_ptr<BatchScheduler<FakeTask>>> queues(2);
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, queue_0_callback, &queues[0]));
+    TF_ASSERT_OK(
+        scheduler->AddQueue(queue_options, queue_1_callback, &queues[1]));
+
+    // Occupy the batch thread with a batch of queue 0, after which the
+    // round-robin order would move on to queue 1.
+    TF_ASSERT_OK(ScheduleTask(10, queues[0].get()));
+    first_batch_scheduled.WaitForNotification();
+
+    TF_ASSERT_OK(ScheduleTask(10, queues[1].get(), 2000));
+    TF_ASSERT_OK(ScheduleTask(10, queues[0].get(), 1000));
+    first_batch_proceed.Notify();
+
+    start_teardown.Notify();
+    queues.clear();
+    EXPECT_EQ((std::vector<int>{0, 0, 1}), processed);
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerTest, DropsExpiredTasks) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<size_t> expired_task_sizes;
+    auto expired_task_callback = [&mu, &expired_task_sizes](
+        std::unique_ptr<FakeTask> task) {
+      mutex_lock l(mu);
+      expired_task_sizes.push_back(task->size());
+    };
+    Notification batch_processed;
+    auto callback = [&batch_processed](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      ASSERT_EQ(2, batch->num_tasks());
+      EXPECT_EQ(2, batch->task(0).size());
+      EXPECT_EQ(4, batch->task(1).size());
+      batch_processed.Notify();
+    };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 100;
+    queue_options.expired_task_callback = expired_task_callback;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    TF_ASSERT_OK(ScheduleTask(1, queue.get(), 50));
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(3, queue.get(), 80));
+    TF_ASSERT_OK(ScheduleTask(4, queue.get(), 1000));
+
+    // The batch times out after the first and third tasks expired.
+    env.AdvanceByMicroseconds(100);
+    batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ((std::vector<size_t>{1, 3}), expired_task_sizes);
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,244 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/models/flat_tree_ensemble.h"
+
+#include <algorithm>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace models {
+
+namespace {
+
+// The number of examples each tree is evaluated on before the next one.
+constexpr int kBlockSize = 16;
+
+}  // namespace
+
+FlatTreeEnsemble::FlatTreeEnsemble(
+    const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+    bool only_finalized_trees) {
+  for (int32 tree = 0; tree < config.trees_size(); ++tree) {
+    if (only_finalized_trees && config.tree_metadata_size() > 0 &&
+        !config.tree_metadata(tree).is_finalized()) {
+      continue;
+    }
+    AddTree(config.trees(tree), config.tree_weights(tree));
+  }
+}
+
+void FlatTreeEnsemble::AddTree(
+    const boosted_trees::trees::DecisionTreeConfig& tree, const float weight) {
+  using boosted_trees::trees::TreeNode;
+  QCHECK_GT(tree.nodes_size(), 0) << "Empty tree";
+  const int32 base = type_.size();
+  roots_.push_back(base);
+  auto add_split = [this, base, &tree](NodeType type, int32 feature_column,
+                                       int32 left_id, int32 right_id) {
+    QCHECK(left_id > 0 && left_id < tree.nodes_size() && right_id > 0 &&
+           right_id < tree.nodes_size())
+        << "Invalid tree: " << tree.DebugString();
+    type_.push_back(type);
+    feature_column_.push_back(feature_column);
+    threshold_.push_back(0);
+    left_.push_back(base + left_id);
+    right_.push_back(base + right_id);
+    begin_.push_back(categorical_ids_.size());
+    end_.push_back(categorical_ids_.size());
+  };
+  for (const TreeNode& node : tree.nodes()) {
+    switch (node.node_case()) {
+      case TreeNode::kLeaf: {
+        type_.push_back(kLeaf);
+        feature_column_.push_back(0);
+        threshold_.push_back(0);
+        left_.push_back(0);
+        right_.push_back(0);
+        begin_.push_back(leaf_values_.size());
+        if (node.leaf().has_sparse_vector()) {
+          const auto& leaf = node.leaf().sparse_vector();
+          QCHECK_EQ(leaf.index_size(), leaf.value_size());
+          for (int i = 0; i < leaf.index_size(); ++i) {
+            leaf_classes_.push_back(leaf.index(i));
+            leaf_values_.push_back(weight * leaf.value(i));
+          }
+        } else {
+          QCHECK(node.leaf().has_vector()) << "Unknown leaf type";
+          const auto& leaf = node.leaf().vector();
+          for (int i = 0; i < leaf.value_size(); ++i) {
+            leaf_classes_.push_back(i);
+            leaf_values_.push_back(weight * leaf.value(i));
+          }
+        }
+        end_.push_back(leaf_values_.size());
+        break;
+      }
+      case TreeNode::kDenseFloatBinarySplit: {
+        const auto& split = node.dense_float_binary_split();
+        add_split(kDenseFloatSplit, split.feature_column(), split.left_id(),
+                  split.right_id());
+        threshold_.back() = split.threshold();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultLeft: {
+        const auto& split =
+            node.sparse_float_binary_split_default_left().split();
+        add_split(kSparseFloatSplitDefaultLeft, split.feature_column(),
+                  split.left_id(), split.right_id());
+        threshold_.back() = split.threshold();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultRight: {
+        const auto& split =
+            node.sparse_float_binary_split_default_right().split();
+        add_split(kSparseFloatSplitDefaultRight, split.feature_column(),
+                  split.left_id(), split.right_id());
+        threshold_.back() = split.threshold();
+        break;
+      }
+      case TreeNode::kCategoricalIdBinarySplit: {
+        const auto& split = node.categorical_id_binary_split();
+        add_split(kCategoricalIdSplit, split.feature_column(), split.left_id(),
+                  split.right_id());
+        categorical_ids_.push_back(split.feature_id());
+        end_.back() = categorical_ids_.size();
+        break;
+      }
+      case TreeNode::kCategoricalIdSetMembershipBinarySplit: {
+        const auto& split = node.categorical_id_set_membership_binary_split();
+        add_split(kCategoricalIdSetMembershipSplit, split.feature_column(),
+                  split.left_id(), split.right_id());
+        categorical_ids_.insert(categorical_ids_.end(),
+                                split.feature_ids().begin(),
+                                split.feature_ids().end());
+        end_.back() = categorical_ids_.size();
+        break;
+      }
+      case TreeNode::NODE_NOT_SET: {
+        QCHECK(false) << "Invalid node in tree: " << node.DebugString();
+        break;
+      }
+    }
+  }
+}
+
+int32 FlatTreeEnsemble::Traverse(
+    int32 root, const boosted_trees::utils::Example& example) const {
+  int32 node = root;
+  while (true) {
+    const int32 column = feature_column_[node];
+    switch (type_[node]) {
+      case kLeaf: {
+        return node;
+      }
+      case kDenseFloatSplit: {
+        node = example.dense_float_features[column] <= threshold_[node]
+                   ? left_[node]
+                   : right_[node];
+        break;
+      }
+      case kSparseFloatSplitDefaultLeft: {
+        const auto& feature = example.sparse_float_features[column];
+        node = !feature.has_value() || feature.get_value() <= threshold_[node]
+                   ? left_[node]
+                   : right_[node];
+        break;
+      }
+      case kSparseFloatSplitDefaultRight: {
+        const auto& feature = example.sparse_float_features[column];
+        node = feature.has_value() && feature.get_value() <= threshold_[node]
+                   ? left_[node]
+                   : right_[node];
+        break;
+      }
+      case kCategoricalIdSplit: {
+        node = example.sparse_int_features[column].count(
+                   categorical_ids_[begin_[node]]) > 0
+                   ? left_[node]
+                   : right_[node];
+        break;
+      }
+      case kCategoricalIdSetMembershipSplit: {
+        const int64* ids_begin = categorical_ids_.data() + begin_[node];
+        const int64* ids_end = categorical_ids_.data() + end_[node];
+        bool found = false;
+        for (const int64 feature_id : example.sparse_int_features[column]) {
+          if (std::binary_search(ids_begin, ids_end, feature_id)) {
+            found = true;
+            break;
+          }
+        }
+        node = found ? left_[node] : right_[node];
+        break;
+      }
+    }
+  }
+}
+
+void FlatTreeEnsemble::Predict(
+    const boosted_trees::utils::BatchFeatures& features,
+    thread::ThreadPool* thread_pool,
+    TTypes<float>::Matrix output_predictions) const {
+  // Zero out predictions as the model is additive.
+  output_predictions.setZero();
+
+  const int64 batch_size = features.batch_size();
+  if (batch_size <= 0) {
+    return;
+  }
+
+  auto predict_block = [this, &output_predictions](
+      const std::vector<boosted_trees::utils::Example>& block,
+      int num_examples) {
+    for (const int32 root : roots_) {
+      for (int i = 0; i < num_examples; ++i) {
+        const int32 leaf = Traverse(root, block[i]);
+        for (int32 v = begin_[leaf]; v < end_[leaf]; ++v) {
+          output_predictions(block[i].example_idx, leaf_classes_[v]) +=
+              leaf_values_[v];
+        }
+      }
+    }
+  };
+
+  auto update_predictions = [&features, &predict_block](int64 start,
+                                                        int64 end) {
+    // The iterator reuses a single Example, so the examples of a block are
+    // copied out; the copies reuse their buffers from block to block.
+    std::vector<boosted_trees::utils::Example> block(kBlockSize);
+    int num_examples = 0;
+    auto examples_iterable = features.examples_iterable(start, end);
+    for (const auto& example : examples_iterable) {
+      block[num_examples++] = example;
+      if (num_examples == kBlockSize) {
+        predict_block(block, num_examples);
+        num_examples = 0;
+      }
+    }
+    if (num_examples > 0) {
+      predict_block(block, num_examples);
+    }
+  };
+
+  boosted_trees::utils::ParallelFor(batch_size, thread_pool->NumThreads(),
+                                    thread_pool, update_predictions);
+}
+
+}  // namespace models
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_MODELS_FLAT_TREE_ENSEMBLE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_MODELS_FLAT_TREE_ENSEMBLE_H_
+
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
+#include "tensorflow/contrib/boosted_trees/lib/utils/example.h"
+#include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace models {
+
+// A tree ensemble flattened for inference, to be built once when a model is
+// loaded.  The nodes of all the trees are kept in one set of arrays, with
+// the children of a node referred to by their index in the arrays and the
+// leaf values multiplied by the tree weights, so that traversals read a few
+// contiguous arrays instead of chasing through the protos.  Predict()
+// evaluates each tree on a block of examples before moving on to the next,
+// so the nodes of a tree stay in the cache while they are used.
+//
+// Gives the same predictions as MultipleAdditiveTrees::Predict without
+// dropout.  This class is immutable and thread safe.
+class FlatTreeEnsemble {
+ public:
+  FlatTreeEnsemble(
+      const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+      bool only_finalized_trees);
+
+  // Sets output_predictions to the predictions of the ensemble for the
+  // examples of the batch.
+  void Predict(const boosted_trees::utils::BatchFeatures& features,
+               thread::ThreadPool* thread_pool,
+               TTypes<float>::Matrix output_predictions) const;
+
+  int32 num_trees() const { return roots_.size(); }
+  int32 num_nodes() const { return type_.size(); }
+
+ private:
+  enum NodeType : uint8 {
+    kLeaf,
+    kDenseFloatSplit,
+    kSparseFloatSplitDefaultLeft,
+    kSparseFloatSplitDefaultRight,
+    kCategoricalIdSplit,
+    kCategoricalIdSetMembershipSplit,
+  };
+
+  // Appends the nodes of "tree", whose leaf values are scaled by "weight".
+  void AddTree(const boosted_trees::trees::DecisionTreeConfig& tree,
+               float weight);
+
+  // Returns the index of the leaf "example" reaches from node "root".
+  int32 Traverse(int32 root,
+                 const boosted_trees::utils::Example& example) const;
+
+  // The index of the root of each tree.
+  std::vector<int32> roots_;
+
+  // Per node.  The splits compare the feature in "feature_column" with
+  // "threshold" (float splits) or with the ids in [begin, end) of
+  // "categorical_ids", and go on to "left" or "right".  The values of a leaf
+  // are in [begin, end) of "leaf_classes" and "leaf_values".
+  std::vector<NodeType> type_;
+  std::vector<int32> feature_column_;
+  std::vector<float> threshold_;
+  std::vector<int32> left_;
+  std::vector<int32> right_;
+  std::vector<int32> begin_;
+  std::vector<int32> end_;
+
+  std::vector<int64> categorical_ids_;
+  std::vector<int32> leaf_classes_;
+  std::vector<float> leaf_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FlatTreeEnsemble);
+};
+
+}  // namespace models
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_MODELS_FLAT_TREE_ENSEMBLE_H_
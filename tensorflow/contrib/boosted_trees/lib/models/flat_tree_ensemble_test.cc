@@ -0,0 +1,218 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/models/flat_tree_ensemble.h"
+
+#include "tensorflow/contrib/boosted_trees/lib/models/multiple_additive_trees.h"
+#include "tensorflow/contrib/boosted_trees/lib/testutil/batch_features_testutil.h"
+#include "tensorflow/contrib/boosted_trees/lib/testutil/random_tree_gen.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+using boosted_trees::trees::DecisionTreeEnsembleConfig;
+using test::AsTensor;
+
+namespace boosted_trees {
+namespace models {
+namespace {
+
+const int32 kNumThreadsMultiThreaded = 6;
+const int32 kNumThreadsSingleThreaded = 1;
+
+class FlatTreeEnsembleTest : public ::testing::Test {
+ protected:
+  FlatTreeEnsembleTest() : batch_features_(2) {
+    // Create a batch of two examples having one dense float feature and one
+    // sparse int feature each.
+    // Instance | DenseF1 | SparseI1 |
+    // 0        |   7     |  3, 5    |
+    // 1        |  -2     |  4       |
+    auto dense_float_matrix = AsTensor<float>({7.0f, -2.0f}, {2, 1});
+    auto sparse_int_indices = AsTensor<int64>({0, 0, 0, 1, 1, 0}, {3, 2});
+    auto sparse_int_values = AsTensor<int64>({3, 5, 4});
+    auto sparse_int_shape = AsTensor<int64>({2, 2});
+    TF_EXPECT_OK(batch_features_.Initialize(
+        {dense_float_matrix}, {}, {}, {}, {sparse_int_indices},
+        {sparse_int_values}, {sparse_int_shape}));
+  }
+
+  boosted_trees::utils::BatchFeatures batch_features_;
+};
+
+TEST_F(FlatTreeEnsembleTest, Empty) {
+  DecisionTreeEnsembleConfig tree_ensemble_config;
+  FlatTreeEnsemble ensemble(tree_ensemble_config, false);
+  EXPECT_EQ(0, ensemble.num_trees());
+
+  auto output_tensor = AsTensor<float>({9.0f, 23.0f}, {2, 1});
+  auto output_matrix = output_tensor.matrix<float>();
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsSingleThreaded);
+  ensemble.Predict(batch_features_, &threads, output_matrix);
+  EXPECT_EQ(0, output_matrix(0, 0));
+  EXPECT_EQ(0, output_matrix(1, 0));
+}
+
+TEST_F(FlatTreeEnsembleTest, CategoricalSplits) {
+  DecisionTreeEnsembleConfig tree_ensemble_config;
+
+  // Tree 1 goes left if the feature contains id 4.
+  auto* tree1 = tree_ensemble_config.add_trees();
+  auto* id_split = tree1->add_nodes()->mutable_categorical_id_binary_split();
+  id_split->set_feature_column(0);
+  id_split->set_feature_id(4);
+  id_split->set_left_id(1);
+  id_split->set_right_id(2);
+  auto* leaf1 = tree1->add_nodes()->mutable_leaf()->mutable_vector();
+  leaf1->add_value(1.0f);
+  leaf1->add_value(2.0f);
+  auto* leaf2 = tree1->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  leaf2->add_index(1);
+  leaf2->add_value(-1.0f);
+
+  // Tree 2 goes left if the feature contains one of the ids {1, 5, 8}.
+  auto* tree2 = tree_ensemble_config.add_trees();
+  auto* set_split = tree2->add_nodes()
+                        ->mutable_categorical_id_set_membership_binary_split();
+  set_split->set_feature_column(0);
+  set_split->add_feature_ids(1);
+  set_split->add_feature_ids(5);
+  set_split->add_feature_ids(8);
+  set_split->set_left_id(1);
+  set_split->set_right_id(2);
+  auto* leaf3 = tree2->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  leaf3->add_index(0);
+  leaf3->add_value(0.5f);
+  auto* leaf4 = tree2->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  leaf4->add_index(0);
+  leaf4->add_value(0.25f);
+
+  tree_ensemble_config.add_tree_weights(1.0);
+  tree_ensemble_config.add_tree_weights(2.0);
+
+  FlatTreeEnsemble ensemble(tree_ensemble_config, false);
+  EXPECT_EQ(2, ensemble.num_trees());
+  EXPECT_EQ(6, ensemble.num_nodes());
+
+  auto output_tensor = AsTensor<float>({0.0f, 0.0f, 0.0f, 0.0f}, {2, 2});
+  auto output_matrix = output_tensor.matrix<float>();
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsSingleThreaded);
+  ensemble.Predict(batch_features_, &threads, output_matrix);
+  // Example 0 goes right in tree 1 and left in tree 2.
+  EXPECT_FLOAT_EQ(2 * 0.5f, output_matrix(0, 0));
+  EXPECT_FLOAT_EQ(-1.0f, output_matrix(0, 1));
+  // Example 1 goes left in tree 1 and right in tree 2.
+  EXPECT_FLOAT_EQ(1.0f + 2 * 0.25f, output_matrix(1, 0));
+  EXPECT_FLOAT_EQ(2.0f, output_matrix(1, 1));
+}
+
+TEST_F(FlatTreeEnsembleTest, OnlyFinalizedTrees) {
+  DecisionTreeEnsembleConfig tree_ensemble_config;
+  for (const float value : {-0.4f, 0.7f}) {
+    auto* leaf = tree_ensemble_config.add_trees()
+                     ->add_nodes()
+                     ->mutable_leaf()
+                     ->mutable_sparse_vector();
+    leaf->add_index(0);
+    leaf->add_value(value);
+    tree_ensemble_config.add_tree_weights(1.0);
+  }
+  tree_ensemble_config.add_tree_metadata()->set_is_finalized(true);
+  tree_ensemble_config.add_tree_metadata()->set_is_finalized(false);
+
+  auto output_tensor = AsTensor<float>({0.0f, 0.0f}, {2, 1});
+  auto output_matrix = output_tensor.matrix<float>();
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsSingleThreaded);
+  FlatTreeEnsemble finalized(tree_ensemble_config, true);
+  EXPECT_EQ(1, finalized.num_trees());
+  finalized.Predict(batch_features_, &threads, output_matrix);
+  EXPECT_FLOAT_EQ(-0.4f, output_matrix(0, 0));
+  EXPECT_FLOAT_EQ(-0.4f, output_matrix(1, 0));
+
+  FlatTreeEnsemble all(tree_ensemble_config, false);
+  EXPECT_EQ(2, all.num_trees());
+  all.Predict(batch_features_, &threads, output_matrix);
+  EXPECT_FLOAT_EQ(0.3f, output_matrix(0, 0));
+  EXPECT_FLOAT_EQ(0.3f, output_matrix(1, 0));
+}
+
+TEST(FlatTreeEnsembleRandomTest, MatchesMultipleAdditiveTrees) {
+  const int kBatchSize = 100;
+  const int kNumDenseFeatures = 10;
+  const int kNumSparseFeatures = 20;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rng(&philox);
+  boosted_trees::utils::BatchFeatures batch_features(kBatchSize);
+  boosted_trees::testutil::RandomlyInitializeBatchFeatures(
+      &rng, kNumDenseFeatures, kNumSparseFeatures, 0.5, 0.9, &batch_features);
+  boosted_trees::testutil::RandomTreeGen tree_gen(&rng, kNumDenseFeatures,
+                                                  kNumSparseFeatures);
+  const DecisionTreeEnsembleConfig tree_ensemble_config =
+      tree_gen.GenerateEnsemble(6, 50);
+
+  Tensor expected_tensor(DT_FLOAT, TensorShape({kBatchSize, 1}));
+  Tensor no_dropout_tensor(DT_FLOAT, TensorShape({kBatchSize, 1}));
+  Tensor output_tensor(DT_FLOAT, TensorShape({kBatchSize, 1}));
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsMultiThreaded);
+  MultipleAdditiveTrees::Predict(tree_ensemble_config, false, {},
+                                 batch_features, &threads,
+                                 expected_tensor.matrix<float>(),
+                                 no_dropout_tensor.matrix<float>());
+  FlatTreeEnsemble ensemble(tree_ensemble_config, false);
+  EXPECT_EQ(50, ensemble.num_trees());
+  ensemble.Predict(batch_features, &threads, output_tensor.matrix<float>());
+  test::ExpectTensorEqual<float>(expected_tensor, output_tensor);
+}
+
+void BM_FlatTreeEnsemblePredict(int iters, int batch_size, int num_trees) {
+  testing::StopTiming();
+  const int kNumDenseFeatures = 10;
+  const int kNumSparseFeatures = 20;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rng(&philox);
+  boosted_trees::utils::BatchFeatures batch_features(batch_size);
+  boosted_trees::testutil::RandomlyInitializeBatchFeatures(
+      &rng, kNumDenseFeatures, kNumSparseFeatures, 0.5, 0.9, &batch_features);
+  boosted_trees::testutil::RandomTreeGen tree_gen(&rng, kNumDenseFeatures,
+                                                  kNumSparseFeatures);
+  FlatTreeEnsemble ensemble(tree_gen.GenerateEnsemble(6, num_trees), false);
+  Tensor output_tensor(DT_FLOAT, TensorShape({batch_size, 1}));
+  tensorflow::thread::ThreadPool threads(tensorflow::Env::Default(), "test",
+                                         kNumThreadsSingleThreaded);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    ensemble.Predict(batch_features, &threads, output_tensor.matrix<float>());
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch_size);
+}
+BENCHMARK(BM_FlatTreeEnsemblePredict)
+    ->ArgPair(1, 100)
+    ->ArgPair(1, 1000)
+    ->ArgPair(128, 100)
+    ->ArgPair(128, 1000);
+
+}  // namespace
+}  // namespace models
+}  // namespace boosted_trees
+}  // namespace tensorflow
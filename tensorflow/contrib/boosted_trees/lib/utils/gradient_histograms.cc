@@ -0,0 +1,111 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/utils/gradient_histograms.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace utils {
+
+GradientHistograms::GradientHistograms(const int32 num_partitions,
+                                       const int32 num_buckets)
+    : num_partitions_(num_partitions),
+      num_buckets_(num_buckets),
+      histograms_(2 * static_cast<int64>(num_partitions) * num_buckets, 0) {
+  CHECK_GE(num_partitions, 0);
+  CHECK_GT(num_buckets, 0);
+}
+
+void GradientHistograms::Bucketize(const std::vector<float>& boundaries,
+                                   gtl::ArraySlice<float> values,
+                                   std::vector<int32>* bucket_ids) {
+  bucket_ids->resize(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    (*bucket_ids)[i] =
+        std::lower_bound(boundaries.begin(), boundaries.end(), values[i]) -
+        boundaries.begin();
+  }
+}
+
+void GradientHistograms::Accumulate(gtl::ArraySlice<int32> partition_ids,
+                                    gtl::ArraySlice<int32> bucket_ids,
+                                    gtl::ArraySlice<float> gradients,
+                                    gtl::ArraySlice<float> hessians,
+                                    thread::ThreadPool* thread_pool) {
+  const int64 batch_size = partition_ids.size();
+  CHECK_EQ(batch_size, bucket_ids.size());
+  CHECK_EQ(batch_size, gradients.size());
+  CHECK_EQ(batch_size, hessians.size());
+  if (batch_size == 0) {
+    return;
+  }
+
+  // The histograms of each shard, keyed by the first example of the shard.
+  mutex mu;
+  std::map<int64, std::vector<float>> shard_histograms;
+  auto accumulate_shard = [this, &partition_ids, &bucket_ids, &gradients,
+                           &hessians, &mu,
+                           &shard_histograms](int64 start, int64 end) {
+    std::vector<float> histograms(histograms_.size(), 0);
+    for (int64 i = start; i < end; ++i) {
+      DCHECK(partition_ids[i] >= 0 && partition_ids[i] < num_partitions_);
+      DCHECK(bucket_ids[i] >= 0 && bucket_ids[i] < num_buckets_);
+      const int64 index = Index(partition_ids[i], bucket_ids[i]);
+      histograms[index] += gradients[i];
+      histograms[index + 1] += hessians[i];
+    }
+    mutex_lock l(mu);
+    shard_histograms[start] = std::move(histograms);
+  };
+  ParallelFor(batch_size, thread_pool->NumThreads(), thread_pool,
+              accumulate_shard);
+
+  for (const auto& shard : shard_histograms) {
+    const std::vector<float>& histograms = shard.second;
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+      histograms_[i] += histograms[i];
+    }
+  }
+}
+
+void GradientHistograms::SetToDifference(const GradientHistograms& parent,
+                                         const int32 parent_partition,
+                                         const int32 sibling_partition,
+                                         const int32 partition) {
+  CHECK_EQ(num_buckets_, parent.num_buckets_);
+  const float* parent_histograms =
+      parent.histograms_.data() + parent.Index(parent_partition, 0);
+  const float* sibling_histograms =
+      histograms_.data() + Index(sibling_partition, 0);
+  float* histograms = histograms_.data() + Index(partition, 0);
+  for (int32 i = 0; i < 2 * num_buckets_; ++i) {
+    histograms[i] = parent_histograms[i] - sibling_histograms[i];
+  }
+}
+
+void GradientHistograms::Clear() {
+  std::fill(histograms_.begin(), histograms_.end(), 0);
+}
+
+}  // namespace utils
+}  // namespace boosted_trees
+}  // namespace tensorflow
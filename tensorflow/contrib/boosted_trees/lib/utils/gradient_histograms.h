@@ -0,0 +1,96 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_UTILS_GRADIENT_HISTOGRAMS_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_UTILS_GRADIENT_HISTOGRAMS_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace utils {
+
+// Dense histograms of the gradients and hessians of one feature column, with
+// one histogram of "num_buckets" buckets per partition (tree node).  The
+// feature values are bucketized once against the boundaries generated by a
+// WeightedQuantilesStream, after which accumulating an example is an add
+// into a contiguous array instead of a lookup in a map keyed by
+// (partition, bucket).  Bucket b holds the examples whose value is at most
+// boundaries[b], so the split "value <= boundaries[b]" sends buckets [0, b]
+// left.
+//
+// Only one of two sibling partitions needs to be accumulated: the histogram
+// of the other is the histogram of their parent minus that of the first,
+// see SetToDifference().
+class GradientHistograms {
+ public:
+  GradientHistograms(int32 num_partitions, int32 num_buckets);
+
+  // Sets bucket_ids to the bucket of each of the values, for histograms
+  // with boundaries.size() + 1 buckets.
+  static void Bucketize(const std::vector<float>& boundaries,
+                        gtl::ArraySlice<float> values,
+                        std::vector<int32>* bucket_ids);
+
+  // Adds example i with gradient gradients[i] and hessian hessians[i] to the
+  // bucket bucket_ids[i] of the histogram of partition partition_ids[i].
+  // The examples are split over the thread pool, with each shard filling
+  // its own histograms, which are then summed in a deterministic order.
+  void Accumulate(gtl::ArraySlice<int32> partition_ids,
+                  gtl::ArraySlice<int32> bucket_ids,
+                  gtl::ArraySlice<float> gradients,
+                  gtl::ArraySlice<float> hessians,
+                  thread::ThreadPool* thread_pool);
+
+  // Sets the histogram of partition "partition" to the histogram of
+  // partition "parent_partition" of "parent" minus the histogram of
+  // partition "sibling_partition" of this object.
+  void SetToDifference(const GradientHistograms& parent,
+                       int32 parent_partition, int32 sibling_partition,
+                       int32 partition);
+
+  // Sets all the histograms to zero.
+  void Clear();
+
+  float gradient(int32 partition, int32 bucket) const {
+    return histograms_[Index(partition, bucket)];
+  }
+  float hessian(int32 partition, int32 bucket) const {
+    return histograms_[Index(partition, bucket) + 1];
+  }
+
+  int32 num_partitions() const { return num_partitions_; }
+  int32 num_buckets() const { return num_buckets_; }
+
+ private:
+  // The gradient of a bucket is followed by its hessian, so that adding an
+  // example touches a single cache line.
+  int64 Index(int32 partition, int32 bucket) const {
+    return 2 * (static_cast<int64>(partition) * num_buckets_ + bucket);
+  }
+
+  const int32 num_partitions_;
+  const int32 num_buckets_;
+  std::vector<float> histograms_;
+};
+
+}  // namespace utils
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_UTILS_GRADIENT_HISTOGRAMS_H_
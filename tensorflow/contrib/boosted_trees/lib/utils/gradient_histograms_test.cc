@@ -0,0 +1,124 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/utils/gradient_histograms.h"
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace utils {
+namespace {
+
+const int32 kNumThreads = 6;
+
+class GradientHistogramsTest : public ::testing::Test {
+ protected:
+  GradientHistogramsTest()
+      : threads_(tensorflow::Env::Default(), "test", kNumThreads) {}
+
+  thread::ThreadPool threads_;
+};
+
+TEST_F(GradientHistogramsTest, Bucketize) {
+  std::vector<int32> bucket_ids;
+  GradientHistograms::Bucketize({1.0f, 2.0f, 5.0f},
+                                {-3.0f, 1.0f, 1.5f, 2.0f, 4.0f, 6.0f},
+                                &bucket_ids);
+  EXPECT_EQ(std::vector<int32>({0, 0, 1, 1, 2, 3}), bucket_ids);
+}
+
+TEST_F(GradientHistogramsTest, Accumulate) {
+  GradientHistograms histograms(2, 3);
+  histograms.Accumulate({0, 1, 0, 0, 1}, {2, 0, 2, 1, 0},
+                        {0.5f, -1.0f, 1.5f, 2.0f, 3.0f},
+                        {1.0f, 2.0f, 1.0f, 0.5f, 0.25f}, &threads_);
+  EXPECT_FLOAT_EQ(0.0f, histograms.gradient(0, 0));
+  EXPECT_FLOAT_EQ(2.0f, histograms.gradient(0, 1));
+  EXPECT_FLOAT_EQ(0.5f, histograms.hessian(0, 1));
+  EXPECT_FLOAT_EQ(2.0f, histograms.gradient(0, 2));
+  EXPECT_FLOAT_EQ(2.0f, histograms.hessian(0, 2));
+  EXPECT_FLOAT_EQ(2.0f, histograms.gradient(1, 0));
+  EXPECT_FLOAT_EQ(2.25f, histograms.hessian(1, 0));
+  EXPECT_FLOAT_EQ(0.0f, histograms.gradient(1, 2));
+
+  histograms.Clear();
+  EXPECT_FLOAT_EQ(0.0f, histograms.gradient(0, 2));
+  EXPECT_FLOAT_EQ(0.0f, histograms.hessian(1, 0));
+}
+
+TEST_F(GradientHistogramsTest, AccumulateIsDeterministic) {
+  const int kBatchSize = 10000;
+  random::PhiloxRandom philox(13, 17);
+  random::SimplePhilox rng(&philox);
+  std::vector<int32> partition_ids;
+  std::vector<int32> bucket_ids;
+  std::vector<float> gradients;
+  std::vector<float> hessians;
+  for (int i = 0; i < kBatchSize; ++i) {
+    partition_ids.push_back(rng.Uniform(4));
+    bucket_ids.push_back(rng.Uniform(16));
+    gradients.push_back(rng.RandFloat() - 0.5f);
+    hessians.push_back(rng.RandFloat());
+  }
+  GradientHistograms expected(4, 16);
+  thread::ThreadPool single_thread(tensorflow::Env::Default(), "test", 1);
+  expected.Accumulate(partition_ids, bucket_ids, gradients, hessians,
+                      &single_thread);
+  for (int run = 0; run < 3; ++run) {
+    GradientHistograms histograms(4, 16);
+    histograms.Accumulate(partition_ids, bucket_ids, gradients, hessians,
+                          &threads_);
+    GradientHistograms again(4, 16);
+    again.Accumulate(partition_ids, bucket_ids, gradients, hessians,
+                     &threads_);
+    for (int32 partition = 0; partition < 4; ++partition) {
+      for (int32 bucket = 0; bucket < 16; ++bucket) {
+        EXPECT_NEAR(expected.gradient(partition, bucket),
+                    histograms.gradient(partition, bucket), 1e-3);
+        EXPECT_NEAR(expected.hessian(partition, bucket),
+                    histograms.hessian(partition, bucket), 1e-3);
+        EXPECT_EQ(again.gradient(partition, bucket),
+                  histograms.gradient(partition, bucket));
+        EXPECT_EQ(again.hessian(partition, bucket),
+                  histograms.hessian(partition, bucket));
+      }
+    }
+  }
+}
+
+TEST_F(GradientHistogramsTest, SetToDifference) {
+  // The parent layer has a single partition holding all the examples, which
+  // are split into partition 0 (examples 0 and 2) and partition 1 in the
+  // child layer.
+  GradientHistograms parent(1, 2);
+  parent.Accumulate({0, 0, 0, 0}, {0, 1, 1, 0}, {1.0f, 2.0f, 3.0f, 4.0f},
+                    {0.1f, 0.2f, 0.3f, 0.4f}, &threads_);
+  GradientHistograms children(2, 2);
+  children.Accumulate({0, 0}, {0, 1}, {1.0f, 3.0f}, {0.1f, 0.3f}, &threads_);
+  children.SetToDifference(parent, 0, 0, 1);
+  EXPECT_FLOAT_EQ(4.0f, children.gradient(1, 0));
+  EXPECT_FLOAT_EQ(0.4f, children.hessian(1, 0));
+  EXPECT_FLOAT_EQ(2.0f, children.gradient(1, 1));
+  EXPECT_FLOAT_EQ(0.2f, children.hessian(1, 1));
+  EXPECT_FLOAT_EQ(1.0f, children.gradient(0, 0));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace boosted_trees
+}  // namespace tensorflow
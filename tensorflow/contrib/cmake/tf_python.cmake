@@ -233,6 +233,9 @@ add_python_module("tensorflow/tensorboard/plugins/projector")
 add_python_module("tensorflow/tensorboard/plugins/text")
 add_python_module("tensorflow/tensorboard/scripts")
 add_python_module("tensorflow/contrib")
+add_python_module("tensorflow/contrib/all_reduce")
+add_python_module("tensorflow/contrib/all_reduce/python")
+add_python_module("tensorflow/contrib/all_reduce/python/ops")
 add_python_module("tensorflow/contrib/android")
 add_python_module("tensorflow/contrib/android/java")
 add_python_module("tensorflow/contrib/android/java/org")
@@ -796,6 +799,8 @@ if(WIN32)
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/blas_gemm.h"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/gru_ops.cc"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/gru_ops.h"
+        "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/quantized_gru_ops.cc"
+        "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/quantized_rnn_ops.h"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/ops/gru_ops.cc"
     )
     set(tf_gru_gpu_srcs
@@ -807,6 +812,8 @@ if(WIN32)
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/blas_gemm.h"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/lstm_ops.cc"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/lstm_ops.h"
+        "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/quantized_lstm_ops.cc"
+        "${tensorflow_source_dir}/tensorflow/contrib/rnn/kernels/quantized_rnn_ops.h"
         "${tensorflow_source_dir}/tensorflow/contrib/rnn/ops/lstm_ops.cc"
     )
     set(tf_lstm_gpu_srcs
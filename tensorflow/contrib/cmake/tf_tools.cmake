@@ -40,6 +40,8 @@ endif(tensorflow_ENABLE_GRPC_SUPPORT)
 file(GLOB_RECURSE tf_tools_transform_graph_lib_srcs
     "${tensorflow_source_dir}/tensorflow/tools/graph_transforms/*.h"
     "${tensorflow_source_dir}/tensorflow/tools/graph_transforms/*.cc"
+    "${tensorflow_source_dir}/tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
+    "${tensorflow_source_dir}/tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.cc"
 )
 
 file(GLOB_RECURSE tf_tools_transform_graph_lib_exclude_srcs
@@ -132,6 +134,8 @@ set(benchmark_model "benchmark_model")
 add_executable(${benchmark_model}
     "${tensorflow_source_dir}/tensorflow/tools/benchmark/benchmark_model.cc"
     "${tensorflow_source_dir}/tensorflow/tools/benchmark/benchmark_model_main.cc"
+    "${tensorflow_source_dir}/tensorflow/tools/benchmark/device_control.cc"
+    "${tensorflow_source_dir}/tensorflow/tools/benchmark/run_stats.cc"
     $<TARGET_OBJECTS:tf_core_lib>
     $<TARGET_OBJECTS:tf_core_cpu>
     $<TARGET_OBJECTS:tf_core_framework>
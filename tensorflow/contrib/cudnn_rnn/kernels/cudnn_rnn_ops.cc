@@ -19,7 +19,10 @@ limitations under the License.
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <map>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_set>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -319,6 +322,10 @@ struct CudnnModelShapes {
   TensorShape hidden_state_shape;
 };
 
+// The shapes the descriptors of a RNN model and of its tensors are created
+// for: num_layers, num_units, input_size, seq_length and batch_size.
+typedef std::tuple<int, int, int, int, int> CudnnDescriptorsKey;
+
 // Extract and checks the forward input tensors, parameters, and shapes from the
 // OpKernelContext.
 Status ExtractForwardInput(OpKernelContext* context,
@@ -374,6 +381,22 @@ Status ExtractForwardInput(OpKernelContext* context,
 }
 
 using perftools::gputools::dnn::RnnDescriptor;
+using perftools::gputools::dnn::RnnSequenceTensorDescriptor;
+using perftools::gputools::dnn::RnnStateTensorDescriptor;
+
+// The descriptors of a RNN model, and of its input, output and hidden state
+// tensors for one sequence length and batch size.
+struct CudnnRnnDescriptors {
+  std::unique_ptr<RnnDescriptor> rnn_desc;
+  std::unique_ptr<RnnSequenceTensorDescriptor> input_desc;
+  std::unique_ptr<RnnStateTensorDescriptor> hidden_state_desc;
+  std::unique_ptr<RnnSequenceTensorDescriptor> output_desc;
+};
+
+// The number of shapes a kernel caches the descriptors of. Sequence models
+// see a new shape for each sequence length, so the cache starts over when it
+// is full rather than growing without bound.
+const int kMaxCachedDescriptors = 64;
 
 template <typename T>
 void RestoreParams(const OpInputList params_input,
@@ -423,9 +446,79 @@ class CudnnRNNKernelCommon : public OpKernel {
   }
   CudnnModelTypes model_types() const { return model_types_; }
 
+  // Returns the descriptors for `model_shapes`, creating them the first time
+  // the kernel sees these shapes. Creating them takes several cuDNN calls and
+  // the allocation of the dropout state on every step otherwise. The tensor
+  // descriptors are only created if model_shapes.seq_length > 0.
   template <typename T>
-  Status ExtractCudnnRNNParamsInfo(OpKernelContext* context,
-                                   std::unique_ptr<RnnDescriptor>* rnn_desc) {
+  Status GetDescriptors(perftools::gputools::StreamExecutor* executor,
+                        const CudnnModelShapes& model_shapes,
+                        std::shared_ptr<const CudnnRnnDescriptors>* out) {
+    const CudnnDescriptorsKey key(
+        model_shapes.num_layers, model_shapes.num_units,
+        model_shapes.input_size, model_shapes.seq_length,
+        model_shapes.batch_size);
+    {
+      mutex_lock l(descriptors_mu_);
+      auto cached = descriptors_.find(key);
+      if (cached != descriptors_.end()) {
+        *out = cached->second;
+        return Status::OK();
+      }
+    }
+
+    RnnInputMode input_mode;
+    TF_RETURN_IF_ERROR(ToRNNInputMode(rnn_input_mode(), model_shapes.num_units,
+                                      model_shapes.input_size, &input_mode));
+    // TODO(zhengxq): add dropout support.
+    auto data_type = ToDataType<T>::value;
+    std::shared_ptr<CudnnRnnDescriptors> descriptors(new CudnnRnnDescriptors);
+    auto rnn_desc_s = executor->createRnnDescriptor(
+        model_shapes.num_layers, model_shapes.num_units,
+        model_shapes.input_size, input_mode, rnn_direction_mode(), rnn_mode(),
+        data_type, 0.f /*dropout*/, 0 /*seed*/, nullptr /*state_allocator*/);
+    TF_RETURN_IF_ERROR(FromExecutorStatus(rnn_desc_s));
+    descriptors->rnn_desc = rnn_desc_s.ConsumeValueOrDie();
+
+    if (model_shapes.seq_length > 0) {
+      const auto& input_shape = model_shapes.input_shape;
+      auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
+          input_shape.dim_size(0), input_shape.dim_size(1),
+          input_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(input_desc_s));
+      descriptors->input_desc = input_desc_s.ConsumeValueOrDie();
+
+      const auto& hidden_state_shape = model_shapes.hidden_state_shape;
+      auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
+          hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
+          hidden_state_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(hidden_state_desc_s));
+      descriptors->hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
+
+      const auto& output_shape = model_shapes.output_shape;
+      auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
+          output_shape.dim_size(0), output_shape.dim_size(1),
+          output_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(output_desc_s));
+      descriptors->output_desc = output_desc_s.ConsumeValueOrDie();
+    }
+
+    mutex_lock l(descriptors_mu_);
+    if (descriptors_.size() >= kMaxCachedDescriptors) {
+      // The steps still running with the evicted descriptors share them.
+      descriptors_.clear();
+    }
+    // Another step may have created the descriptors meanwhile; either copy
+    // works.
+    descriptors_[key] = descriptors;
+    *out = std::move(descriptors);
+    return Status::OK();
+  }
+
+  template <typename T>
+  Status ExtractCudnnRNNParamsInfo(
+      OpKernelContext* context,
+      std::shared_ptr<const CudnnRnnDescriptors>* descriptors) {
     const Tensor* num_layers_t = nullptr;
     TF_RETURN_IF_ERROR(context->input("num_layers", &num_layers_t));
     if (!TensorShapeUtils::IsScalar(num_layers_t->shape())) {
@@ -445,23 +538,23 @@ class CudnnRNNKernelCommon : public OpKernel {
     }
     int input_size = input_size_t->scalar<int>()();
 
-    RnnInputMode input_mode;
-    TF_RETURN_IF_ERROR(
-        ToRNNInputMode(rnn_input_mode(), num_units, input_size, &input_mode));
+    // The parameters do not depend on the sequences the model runs on.
+    CudnnModelShapes model_shapes;
+    model_shapes.num_layers = num_layers;
+    model_shapes.num_units = num_units;
+    model_shapes.input_size = input_size;
+    model_shapes.seq_length = 0;
+    model_shapes.batch_size = 0;
     auto* stream = context->op_device_context()->stream();
-    auto rnn_desc_s = stream->parent()->createRnnDescriptor(
-        num_layers, num_units, input_size, input_mode, rnn_direction_mode(),
-        rnn_mode(), ToDataType<T>::value, 0.f /*dropout*/, 0 /*seed*/,
-        nullptr /*state_allocator*/);
-    if (!rnn_desc_s.ok()) {
-      return FromExecutorStatus(rnn_desc_s);
-    }
-    *rnn_desc = rnn_desc_s.ConsumeValueOrDie();
-    return Status::OK();
+    return GetDescriptors<T>(stream->parent(), model_shapes, descriptors);
   }
 
  private:
   CudnnModelTypes model_types_;
+
+  mutex descriptors_mu_;
+  std::map<CudnnDescriptorsKey, std::shared_ptr<const CudnnRnnDescriptors>>
+      descriptors_ GUARDED_BY(descriptors_mu_);
 };
 
 // A class that returns the size of the opaque parameter buffer. The user should
@@ -475,8 +568,10 @@ class CudnnRNNParamsSizeOp<GPUDevice, T, Index> : public CudnnRNNKernelCommon {
       : CudnnRNNKernelCommon(context) {}
 
   void Compute(OpKernelContext* context) override {
-    std::unique_ptr<RnnDescriptor> rnn_desc;
-    OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
+    std::shared_ptr<const CudnnRnnDescriptors> descriptors;
+    OP_REQUIRES_OK(context,
+                   ExtractCudnnRNNParamsInfo<T>(context, &descriptors));
+    const RnnDescriptor* rnn_desc = descriptors->rnn_desc.get();
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
         << "params_size_in_bytes must be multiple of element size";
@@ -514,8 +609,10 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
     auto input_ptr = StreamExecutorUtil::AsDeviceMemory<T>(input);
     auto* stream = context->op_device_context()->stream();
 
-    std::unique_ptr<RnnDescriptor> rnn_desc;
-    OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
+    std::shared_ptr<const CudnnRnnDescriptors> descriptors;
+    OP_REQUIRES_OK(context,
+                   ExtractCudnnRNNParamsInfo<T>(context, &descriptors));
+    const RnnDescriptor* rnn_desc = descriptors->rnn_desc.get();
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
         << "params_size_in_bytes must be multiple of element size";
@@ -539,11 +636,14 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
     int num_layers = num_layers_t->scalar<int>()();
     int num_params_per_layer = num_params_ / num_layers;
 
-    CHECK(num_params_ == rnn_desc->ParamsWeightRegions().size())
+    // The regions are returned by value, so only get them once.
+    const RnnDescriptor::ParamsRegions weight_regions =
+        rnn_desc->ParamsWeightRegions();
+    CHECK(num_params_ == weight_regions.size())
         << "Number of params mismatch. Expected " << num_params_ << ", got "
-        << rnn_desc->ParamsWeightRegions().size();
-    for (int i = 0; i < rnn_desc->ParamsWeightRegions().size(); i++) {
-      int64 size_in_bytes = rnn_desc->ParamsWeightRegions()[i].size;
+        << weight_regions.size();
+    for (int i = 0; i < weight_regions.size(); i++) {
+      int64 size_in_bytes = weight_regions[i].size;
       int64 size = size_in_bytes / sizeof(T);
       int width = (i < num_params_per_layer / 2) ? input_size : num_units;
       int height = num_units;
@@ -551,11 +651,10 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
                                     << width * height << ", got " << size;
       // If data is aligned, use slice view to avoid expensive memcpy.
       bool start_aligned =
-          rnn_desc->ParamsWeightRegions()[i].offset % EIGEN_MAX_ALIGN_BYTES ==
-          0;
+          weight_regions[i].offset % EIGEN_MAX_ALIGN_BYTES == 0;
       bool size_aligned = size_in_bytes % EIGEN_MAX_ALIGN_BYTES == 0;
       if (start_aligned && size_aligned) {
-        int start = rnn_desc->ParamsWeightRegions()[i].offset / sizeof(T);
+        int start = weight_regions[i].offset / sizeof(T);
         int end = start + size_in_bytes / sizeof(T);
         context->set_output(i, input.Slice(start, end));
       } else {
@@ -564,27 +663,27 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
             context,
             context->allocate_output(i, TensorShape({width, height}), &output));
         DeviceMemoryBase data_src_ptr = SliceDeviceMemory(
-            input_ptr, rnn_desc->ParamsWeightRegions()[i].offset,
-            size_in_bytes);
+            input_ptr, weight_regions[i].offset, size_in_bytes);
         auto data_dst_ptr = StreamExecutorUtil::AsDeviceMemory<T>(*output);
         stream->ThenMemcpy(&data_dst_ptr, data_src_ptr, size_in_bytes);
       }
     }
 
-    CHECK(num_params_ == rnn_desc->ParamsBiasRegions().size())
+    const RnnDescriptor::ParamsRegions bias_regions =
+        rnn_desc->ParamsBiasRegions();
+    CHECK(num_params_ == bias_regions.size())
         << "Number of params mismatch. Expected " << num_params_ << ", got "
-        << rnn_desc->ParamsBiasRegions().size();
-    for (int i = 0; i < rnn_desc->ParamsBiasRegions().size(); i++) {
-      int64 size_in_bytes = rnn_desc->ParamsBiasRegions()[i].size;
+        << bias_regions.size();
+    for (int i = 0; i < bias_regions.size(); i++) {
+      int64 size_in_bytes = bias_regions[i].size;
       int64 size = size_in_bytes / sizeof(T);
       CHECK(size == num_units) << "Params size mismatch. Expected " << num_units
                                << ", got " << size;
       // If data is aligned, use slice view to avoid expensive memcpy.
-      bool start_aligned =
-          rnn_desc->ParamsBiasRegions()[i].offset % EIGEN_MAX_ALIGN_BYTES == 0;
+      bool start_aligned = bias_regions[i].offset % EIGEN_MAX_ALIGN_BYTES == 0;
       bool size_aligned = size_in_bytes % EIGEN_MAX_ALIGN_BYTES == 0;
       if (start_aligned && size_aligned) {
-        int start = rnn_desc->ParamsBiasRegions()[i].offset / sizeof(T);
+        int start = bias_regions[i].offset / sizeof(T);
         int end = start + size_in_bytes / sizeof(T);
         context->set_output(num_params_ + i, input.Slice(start, end));
       } else {
@@ -593,7 +692,7 @@ class CudnnRNNParamsToCanonical<GPUDevice, T> : public CudnnRNNKernelCommon {
                        context->allocate_output(num_params_ + i,
                                                 TensorShape({size}), &output));
         DeviceMemoryBase data_src_ptr = SliceDeviceMemory(
-            input_ptr, rnn_desc->ParamsBiasRegions()[i].offset, size_in_bytes);
+            input_ptr, bias_regions[i].offset, size_in_bytes);
         auto data_dst_ptr = StreamExecutorUtil::AsDeviceMemory<T>(*output);
         stream->ThenMemcpy(&data_dst_ptr, data_src_ptr, size_in_bytes);
       }
@@ -622,8 +721,10 @@ class CudnnRNNCanonicalToParams<GPUDevice, T> : public CudnnRNNKernelCommon {
       : CudnnRNNKernelCommon(context) {}
 
   void Compute(OpKernelContext* context) override {
-    std::unique_ptr<RnnDescriptor> rnn_desc;
-    OP_REQUIRES_OK(context, ExtractCudnnRNNParamsInfo<T>(context, &rnn_desc));
+    std::shared_ptr<const CudnnRnnDescriptors> descriptors;
+    OP_REQUIRES_OK(context,
+                   ExtractCudnnRNNParamsInfo<T>(context, &descriptors));
+    const RnnDescriptor* rnn_desc = descriptors->rnn_desc.get();
     int64 params_size_in_bytes = rnn_desc->ParamsSizeInBytes();
     CHECK(params_size_in_bytes % sizeof(T) == 0)
         << "params_size_in_bytes must be multiple of element size";
@@ -673,7 +774,6 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     OP_REQUIRES_OK(context,
                    ExtractForwardInput(context, model_types(), &input, &input_h,
                                        &input_c, &params, &model_shapes));
-    const auto& input_shape = model_shapes.input_shape;
     const auto& hidden_state_shape = model_shapes.hidden_state_shape;
     const auto& output_shape = model_shapes.output_shape;
 
@@ -693,39 +793,13 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     }
 
     auto* stream = context->op_device_context()->stream();
-    auto* executor = stream->parent();
-    RnnInputMode input_mode;
-    OP_REQUIRES_OK(context,
-                   ToRNNInputMode(rnn_input_mode(), model_shapes.num_units,
-                                  model_shapes.input_size, &input_mode));
-    // TODO(zhengxq): add dropout support.
-    // TODO(zhengxq): cache the descriptor so we don't have to create them all
-    // the time.
-    auto data_type = ToDataType<T>::value;
-    auto rnn_desc_s = executor->createRnnDescriptor(
-        model_shapes.num_layers, model_shapes.num_units,
-        model_shapes.input_size, input_mode, rnn_direction_mode(), rnn_mode(),
-        data_type, 0.f /*dropout*/, 0 /*seed*/, nullptr /*state_allocator*/);
-    OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
-    auto rnn_desc = rnn_desc_s.ConsumeValueOrDie();
-
-    auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
-        input_shape.dim_size(0), input_shape.dim_size(1),
-        input_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(input_desc_s));
-    auto input_desc = input_desc_s.ConsumeValueOrDie();
-
-    auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
-        hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
-        hidden_state_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(hidden_state_desc_s));
-    auto hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
-
-    auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
-        output_shape.dim_size(0), output_shape.dim_size(1),
-        output_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(output_desc_s));
-    auto output_desc = output_desc_s.ConsumeValueOrDie();
+    std::shared_ptr<const CudnnRnnDescriptors> descriptors;
+    OP_REQUIRES_OK(context, GetDescriptors<T>(stream->parent(), model_shapes,
+                                              &descriptors));
+    const auto& rnn_desc = descriptors->rnn_desc;
+    const auto& input_desc = descriptors->input_desc;
+    const auto& hidden_state_desc = descriptors->hidden_state_desc;
+    const auto& output_desc = descriptors->output_desc;
 
     auto input_data = AsDeviceMemory<T>(input);
     auto input_h_data = AsDeviceMemory<T>(input_h);
@@ -793,11 +867,9 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                    ExtractForwardInput(context, model_types(), &input, &input_h,
                                        &input_c, &params, &model_shapes));
 
-    const auto& input_shape = model_shapes.input_shape;
     const auto& hidden_state_shape = model_shapes.hidden_state_shape;
     const auto& output_shape = model_shapes.output_shape;
 
-    auto data_type = ToDataType<T>::value;
     const Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->input("output", &output));
     OP_REQUIRES(context, output_shape == output->shape(),
@@ -876,38 +948,13 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                                                      &params_backprop));
 
     auto* stream = context->op_device_context()->stream();
-    auto* executor = stream->parent();
-    RnnInputMode input_mode;
-    OP_REQUIRES_OK(context,
-                   ToRNNInputMode(rnn_input_mode(), model_shapes.num_units,
-                                  model_shapes.input_size, &input_mode));
-    // TODO(zhengxq): add dropout support.
-    // TODO(zhengxq): cache the descriptor so we don't have to create them all
-    // the time.
-    auto rnn_desc_s = executor->createRnnDescriptor(
-        model_shapes.num_layers, model_shapes.num_units,
-        model_shapes.input_size, input_mode, rnn_direction_mode(), rnn_mode(),
-        data_type, 0.f /*dropout*/, 0 /*seed*/, nullptr /*state_allocator*/);
-    OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
-    auto rnn_desc = rnn_desc_s.ConsumeValueOrDie();
-
-    auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
-        input_shape.dim_size(0), input_shape.dim_size(1),
-        input_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(input_desc_s));
-    auto input_desc = input_desc_s.ConsumeValueOrDie();
-
-    auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
-        hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
-        hidden_state_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(hidden_state_desc_s));
-    auto hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
-
-    auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
-        output_shape.dim_size(0), output_shape.dim_size(1),
-        output_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(output_desc_s));
-    auto output_desc = output_desc_s.ConsumeValueOrDie();
+    std::shared_ptr<const CudnnRnnDescriptors> descriptors;
+    OP_REQUIRES_OK(context, GetDescriptors<T>(stream->parent(), model_shapes,
+                                              &descriptors));
+    const auto& rnn_desc = descriptors->rnn_desc;
+    const auto& input_desc = descriptors->input_desc;
+    const auto& hidden_state_desc = descriptors->hidden_state_desc;
+    const auto& output_desc = descriptors->output_desc;
 
     auto input_data = AsDeviceMemory<T>(input);
     auto input_h_data = AsDeviceMemory<T>(input_h);
@@ -16,6 +16,7 @@
 #define EIGEN_USE_THREADS
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <numeric>
 #include <tuple>
@@ -34,6 +35,7 @@
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -123,8 +125,22 @@ class KmeansPlusPlusInitializationOp : public OpKernel {
 
     const Eigen::Map<const MatrixXfRowMajor> points(
         points_tensor.matrix<float>().data(), num_points, point_dimensions);
-    const Eigen::VectorXf points_half_squared_norm =
-        0.5 * points.rowwise().squaredNorm();
+
+    // The distance computations, which take O(num_points * point_dimensions)
+    // for every sample, are sharded over the points. Sampling itself stays
+    // sequential, so the result does not depend on the number of threads.
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    auto shard_points = [&worker_threads, num_points, point_dimensions](
+        const std::function<void(int64, int64)>& work) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_points,
+            3 * point_dimensions, work);
+    };
+
+    Eigen::VectorXf points_half_squared_norm(num_points);
+    shard_points([&](int64 start, int64 limit) {
+      points_half_squared_norm.segment(start, limit - start) =
+          0.5 * points.middleRows(start, limit - start).rowwise().squaredNorm();
+    });
 
     Eigen::Map<MatrixXfRowMajor> sampled_points(
         output_sampled_points_tensor->matrix<float>().data(), num_to_sample,
@@ -162,24 +178,36 @@ class KmeansPlusPlusInitializationOp : public OpKernel {
       return index;
     };
 
+    // Sets new_min_distances to the distances from all points to the nearest
+    // of the selected points and the point at sampled_index.
+    auto get_new_min_distances = [&](int64 sampled_index,
+                                     Eigen::VectorXf* new_min_distances) {
+      shard_points([&](int64 start, int64 limit) {
+        const int64 num_rows = limit - start;
+        new_min_distances->segment(start, num_rows) =
+            min_distances.segment(start, num_rows)
+                .cwiseMin(GetHalfSquaredDistancesToY(
+                    points.middleRows(start, num_rows),
+                    points_half_squared_norm.segment(start, num_rows),
+                    points.row(sampled_index),
+                    points_half_squared_norm(sampled_index)));
+      });
+    };
+
     auto sample_one_point = [&]() {
       const int64 sampled_index = draw_one_sample();
-      min_distances = min_distances.cwiseMin(GetHalfSquaredDistancesToY(
-          points, points_half_squared_norm, points.row(sampled_index),
-          points_half_squared_norm(sampled_index)));
+      get_new_min_distances(sampled_index, &min_distances);
       return sampled_index;
     };
 
+    Eigen::VectorXf best_new_min_distances(num_points);
+    Eigen::VectorXf new_min_distances(num_points);
     auto sample_one_point_with_retries = [&]() {
-      Eigen::VectorXf best_new_min_distances(num_points);
       float best_potential = std::numeric_limits<float>::infinity();
       int64 best_sampled_index = 0;
       for (int i = 1 + num_retries_per_sample; i > 0; --i) {
         const int64 sampled_index = draw_one_sample();
-        Eigen::VectorXf new_min_distances =
-            min_distances.cwiseMin(GetHalfSquaredDistancesToY(
-                points, points_half_squared_norm, points.row(sampled_index),
-                points_half_squared_norm(sampled_index)));
+        get_new_min_distances(sampled_index, &new_min_distances);
         const float potential = new_min_distances.sum();
         if (potential < best_potential) {
           best_potential = potential;
@@ -208,7 +236,6 @@ class KmeansPlusPlusInitializationOp : public OpKernel {
   // Returns a column vector with the i-th element set to half the squared
   // euclidean distance between the i-th row of xs, and y. Precomputed norms for
   // each row of xs and y must be provided for efficiency.
-  // TODO(ands): Parallelize this for large xs.
   static Eigen::VectorXf GetHalfSquaredDistancesToY(
       const Eigen::Ref<const MatrixXfRowMajor>& xs,
       const Eigen::Ref<const Eigen::VectorXf>& xs_half_squared_norm,
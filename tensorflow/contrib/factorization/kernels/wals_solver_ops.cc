@@ -17,21 +17,19 @@
 // TODO(agarwal,rmlarsen): Add security checks to the code.
 
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+#include "third_party/eigen3/Eigen/Cholesky"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -61,12 +59,7 @@ typedef Eigen::Map<
 class WALSComputePartialLhsAndRhsOp : public OpKernel {
  public:
   explicit WALSComputePartialLhsAndRhsOp(OpKernelConstruction* context)
-      : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->MatchSignature(
-                                {DT_FLOAT, DT_FLOAT, DT_FLOAT, DT_FLOAT,
-                                 DT_INT64, DT_FLOAT, DT_INT64, DT_BOOL},
-                                {DT_FLOAT, DT_FLOAT}));
-  }
+      : WALSComputePartialLhsAndRhsOp(context, false) {}
 
   void Compute(OpKernelContext* context) override {
     const Tensor& factors = context->input(0);
@@ -111,20 +104,36 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     ConstEigenMatrixInt64Map indices_mat(input_indices.matrix<int64>().data(),
                                          2, num_nonzero_elements);
 
-    Tensor* output_lhs_tensor;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(
-                       0, TensorShape({block_size, factor_dim, factor_dim}),
-                       &output_lhs_tensor));
-    auto output_lhs_t = output_lhs_tensor->tensor<float, 3>();
-    output_lhs_t.setZero();
-    Tensor* output_rhs_tensor;
-    OP_REQUIRES_OK(context, context->allocate_output(
-                                1, TensorShape({block_size, factor_dim}),
-                                &output_rhs_tensor));
-    EigenMatrixFloatMap rhs_mat(output_rhs_tensor->matrix<float>().data(),
-                                factor_dim, block_size);
-    rhs_mat.setZero();
+    // When solving, the normal equations of each row are built in local
+    // matrices starting from the shared gramian, and only the solutions are
+    // written out.
+    const float* gramian_data = nullptr;
+    Tensor* output_lhs_tensor = nullptr;
+    Tensor* output_rhs_tensor = nullptr;
+    Tensor* output_solutions_tensor = nullptr;
+    if (solve_) {
+      const Tensor& gramian = context->input(8);
+      OP_REQUIRES(context,
+                  TensorShapeUtils::IsSquareMatrix(gramian.shape()) &&
+                      gramian.dim_size(0) == factor_dim,
+                  InvalidArgument("Input gramian should be a ", factor_dim,
+                                  " x ", factor_dim, " matrix."));
+      gramian_data = gramian.flat<float>().data();
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  0, TensorShape({block_size, factor_dim}),
+                                  &output_solutions_tensor));
+      output_solutions_tensor->flat<float>().setZero();
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(
+                         0, TensorShape({block_size, factor_dim, factor_dim}),
+                         &output_lhs_tensor));
+      output_lhs_tensor->flat<float>().setZero();
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  1, TensorShape({block_size, factor_dim}),
+                                  &output_rhs_tensor));
+      output_rhs_tensor->flat<float>().setZero();
+    }
     const bool is_transpose = input_is_transpose.scalar<bool>()();
 
     auto get_input_index = [is_transpose, &indices_mat](int64 i) {
@@ -141,10 +150,9 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     std::vector<int64> perm(num_nonzero_elements);
     std::iota(perm.begin(), perm.end(), 0);
 
-    typedef std::pair<int64, int64> Shard;
-    std::vector<Shard> shards;
+    typedef std::pair<int64, int64> Run;
+    std::vector<Run> runs;
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    int64 shard_total = 0;
     // Compute a permutation such that get_input_index(perm[i]) is sorted, use
     // stable_sort to preserve spatial locality.
     std::stable_sort(perm.begin(), perm.end(),
@@ -153,7 +161,7 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
                      });
 
     // Compute the start and end of runs with identical input_index.
-    // These are the shards of work that can be processed in parallel
+    // These are the units of work that can be processed in parallel
     // without locking.
     int64 start = 0;
     int64 end = 0;
@@ -163,104 +171,144 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
              get_input_index(perm[start]) == get_input_index(perm[end])) {
         ++end;
       }
-      shards.emplace_back(start, end);
-      shard_total += end - start;
+      runs.emplace_back(start, end);
     }
-    CHECK_EQ(shard_total, num_nonzero_elements);
-    CHECK_LE(shards.size(), num_nonzero_elements);
-    CHECK_GT(shards.size(), 0);
+    CHECK_LE(runs.size(), num_nonzero_elements);
+    if (runs.empty()) return;
 
     // Batch the rank-one updates into a rank-k update to lower memory traffic
     const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
-
-    BlockingCounter counter(shards.size());
-    // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
+    std::atomic<bool> solve_failed(false);
+    // Lambda encapsulating the computation for the runs in
+    // [first_run, last_run).
+    // Consecutive runs are handed to one call, which sets up its batching
+    // matrix and solver once for all of them.
+    auto work = [&](int64 first_run, int64 last_run) {
+      Eigen::MatrixXf factor_batch(factor_dim, kMaxBatchSize);
+      Eigen::MatrixXf local_lhs;
+      Eigen::VectorXf local_rhs;
+      Eigen::LLT<Eigen::MatrixXf, Eigen::Lower> llt;
+      if (solve_) {
+        local_lhs.resize(factor_dim, factor_dim);
+        local_rhs.resize(factor_dim);
       }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
-
-      CHECK_GE(shard.first, 0);
-      CHECK_LE(shard.second, perm.size());
-      CHECK_LE(shard.first, shard.second);
-      const int64 input_index = get_input_index(perm[shard.first]);
-      // Acccumulate the rhs and lhs terms in the normal equations
-      // for the non-zero elements in the row or column of the sparse matrix
-      // corresponding to input_index.
-      int num_batched = 0;
-      EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
-                                      input_index * factor_dim * factor_dim,
-                                  factor_dim, factor_dim);
-      auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
-      for (int64 p = shard.first; p < shard.second; ++p) {
-        const int64 i = perm[p];
-        // Check that all entries in the shard have the same input index.
-        CHECK_EQ(input_index, get_input_index(i));
-        const int64 factor_index = get_factor_index(i);
-        const float input_value = input_values_vec(i);
-        const float weight =
-            input_weights_vec(input_index) * factor_weights_vec(factor_index);
-        CHECK_GE(weight, 0);
-        factor_batch.col(num_batched) =
-            factors_mat.col(factor_index) * std::sqrt(weight);
-        ++num_batched;
-        if (num_batched == kMaxBatchSize) {
-          lhs_symm.rankUpdate(factor_batch);
-          num_batched = 0;
+      for (int64 r = first_run; r < last_run; ++r) {
+        const Run& run = runs[r];
+        CHECK_GE(run.first, 0);
+        CHECK_LE(run.second, perm.size());
+        CHECK_LE(run.first, run.second);
+        const int64 input_index = get_input_index(perm[run.first]);
+        // Acccumulate the rhs and lhs terms in the normal equations
+        // for the non-zero elements in the row or column of the sparse matrix
+        // corresponding to input_index.
+        EigenMatrixFloatMap lhs_mat(
+            solve_ ? local_lhs.data()
+                   : output_lhs_tensor->flat<float>().data() +
+                         input_index * factor_dim * factor_dim,
+            factor_dim, factor_dim);
+        EigenMatrixFloatMap rhs_mat(
+            solve_ ? local_rhs.data()
+                   : output_rhs_tensor->flat<float>().data() +
+                         input_index * factor_dim,
+            factor_dim, 1);
+        if (solve_) {
+          lhs_mat = ConstEigenMatrixFloatMap(gramian_data, factor_dim,
+                                             factor_dim);
+          rhs_mat.setZero();
         }
+        auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
+        int num_batched = 0;
+        for (int64 p = run.first; p < run.second; ++p) {
+          const int64 i = perm[p];
+          // Check that all entries in the run have the same input index.
+          CHECK_EQ(input_index, get_input_index(i));
+          const int64 factor_index = get_factor_index(i);
+          const float input_value = input_values_vec(i);
+          const float weight =
+              input_weights_vec(input_index) * factor_weights_vec(factor_index);
+          CHECK_GE(weight, 0);
+          factor_batch.col(num_batched) =
+              factors_mat.col(factor_index) * std::sqrt(weight);
+          ++num_batched;
+          if (num_batched == kMaxBatchSize) {
+            lhs_symm.rankUpdate(factor_batch);
+            num_batched = 0;
+          }
 
-        rhs_mat.col(input_index) +=
-            input_value * (w_0 + weight) * factors_mat.col(factor_index);
-      }
-      if (num_batched != 0) {
-        auto factor_block =
-            factor_batch.block(0, 0, factors_mat.rows(), num_batched);
-        lhs_symm.rankUpdate(factor_block);
+          rhs_mat.col(0) +=
+              input_value * (w_0 + weight) * factors_mat.col(factor_index);
+        }
+        if (num_batched != 0) {
+          auto factor_block =
+              factor_batch.block(0, 0, factors_mat.rows(), num_batched);
+          lhs_symm.rankUpdate(factor_block);
+        }
+        if (solve_) {
+          // The factorization only reads the lower triangular part.
+          llt.compute(lhs_mat);
+          if (llt.info() != Eigen::Success) {
+            solve_failed = true;
+            return;
+          }
+          EigenMatrixFloatMap solution(
+              output_solutions_tensor->flat<float>().data() +
+                  input_index * factor_dim,
+              factor_dim, 1);
+          solution = llt.solve(rhs_mat);
+        } else {
+          // Copy lower triangular to upper triangular part of normal equation
+          // matrix.
+          lhs_mat = lhs_symm;
+        }
       }
-      // Copy lower triangular to upper triangular part of normal equation
-      // matrix.
-      lhs_mat = lhs_symm;
-      counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
+    // The cost of a run is its rank-one updates plus, when solving, the
+    // factorization.
+    const int64 cost_per_run =
+        (num_nonzero_elements / runs.size() + (solve_ ? factor_dim : 0)) *
+        factor_dim * factor_dim;
+    Shard(worker_threads.num_threads, worker_threads.workers, runs.size(),
+          cost_per_run, work);
+    OP_REQUIRES(context, !solve_failed,
+                InvalidArgument("The normal equations are not positive "
+                                "definite."));
+  }
+
+ protected:
+  WALSComputePartialLhsAndRhsOp(OpKernelConstruction* context, bool solve)
+      : OpKernel(context), solve_(solve) {
+    if (solve) {
+      OP_REQUIRES_OK(context, context->MatchSignature(
+                                  {DT_FLOAT, DT_FLOAT, DT_FLOAT, DT_FLOAT,
+                                   DT_INT64, DT_FLOAT, DT_INT64, DT_BOOL,
+                                   DT_FLOAT},
+                                  {DT_FLOAT}));
+    } else {
+      OP_REQUIRES_OK(context, context->MatchSignature(
+                                  {DT_FLOAT, DT_FLOAT, DT_FLOAT, DT_FLOAT,
+                                   DT_INT64, DT_FLOAT, DT_INT64, DT_BOOL},
+                                  {DT_FLOAT, DT_FLOAT}));
     }
-    // Inline execute the 1st shard.
-    work(shards[0]);
-    counter.Wait();
   }
+
+ private:
+  const bool solve_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("WALSComputePartialLhsAndRhs").Device(DEVICE_CPU),
                         WALSComputePartialLhsAndRhsOp);
 
+// Builds the normal equations like WALSComputePartialLhsAndRhs, adds the
+// gramian to the lhs of each row, and solves them with a Cholesky
+// factorization, so the per-row lhs never leaves the op.
+class WALSComputeAndSolveOp : public WALSComputePartialLhsAndRhsOp {
+ public:
+  explicit WALSComputeAndSolveOp(OpKernelConstruction* context)
+      : WALSComputePartialLhsAndRhsOp(context, true) {}
+};
+
+REGISTER_KERNEL_BUILDER(Name("WALSComputeAndSolve").Device(DEVICE_CPU),
+                        WALSComputeAndSolveOp);
+
 }  // namespace tensorflow
@@ -45,6 +45,39 @@ partial_lhs: 3-D tensor with size input_block_size x k x k.
 partial_rhs: Matrix with size input_block_size x k.
 )");
 
+REGISTER_OP("WALSComputeAndSolve")
+    .Input("factors: float32")
+    .Input("factor_weights: float32")
+    .Input("unobserved_weights: float32")
+    .Input("input_weights: float32")
+    .Input("input_indices: int64")
+    .Input("input_values: float32")
+    .Input("input_block_size: int64")
+    .Input("input_is_transpose: bool")
+    .Input("gramian: float32")
+    .Output("solutions: float32")
+    .SetShapeFn(shape_inference::UnknownShape)
+    .Doc(R"(
+Computes the WALS normal equations of the rows of the input and solves them.
+
+Equivalent to adding gramian to each partial_lhs of WALSComputePartialLhsAndRhs
+and solving with partial_rhs, but the normal equations are solved with a
+Cholesky factorization in the op, as they are built.
+
+factors: Matrix of size m * k.
+factor_weights: Vector of size m. Corresponds to column weights
+unobserved_weights: Scalar. Weight for unobserved input entries.
+input_weights: Vector of size n. Corresponds to row weights.
+input_indices: Indices for the input SparseTensor.
+input_values: Values for the input SparseTensor.
+input_block_size: Scalar. Number of rows spanned by input.
+input_is_transpose: If true, logically transposes the input for processing.
+gramian: Symmetric positive definite matrix of size k * k, added to the lhs of
+  the normal equations of every row.
+solutions: Matrix with size input_block_size x k. Rows without input entries
+  are zero.
+)");
+
 REGISTER_OP("MaskedMatmul")
     .Input("a: float32")
     .Input("b: float32")
@@ -78,6 +78,26 @@ class WalsSolverOpsTest(test.TestCase):
                                               [0.160400, 0.220000, 0.279600],
                                               [0.492800, 0.563200, 0.633600]])
 
+  def testWalsComputeAndSolve(self):
+    sparse_block = SparseBlock3x3()
+    gramian = np.array([[2.0, 0.1, 0.2], [0.1, 3.0, 0.3],
+                        [0.2, 0.3, 4.0]]).astype(np.float32)
+    with self.test_session():
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           self._column_factors, self._column_weights, self._unobserved_weights,
+           self._row_weights, sparse_block.indices, sparse_block.values,
+           sparse_block.dense_shape[0], False)
+      solutions = gen_factorization_ops.wals_compute_and_solve(
+          self._column_factors, self._column_weights, self._unobserved_weights,
+          self._row_weights, sparse_block.indices, sparse_block.values,
+          sparse_block.dense_shape[0], False, gramian)
+      expected = [
+          np.linalg.solve(lhs + gramian, rhs)
+          for lhs, rhs in zip(lhs_tensor.eval(), rhs_matrix.eval())
+      ]
+      self.assertAllClose(expected, solutions.eval())
+
 
 if __name__ == "__main__":
   test.main()
@@ -860,21 +860,17 @@ class WALSModel(object):
 
       col_weights = embedding_ops.embedding_lookup(
           col_wt, gather_indices, partition_strategy="div")
-      partial_lhs, total_rhs = (
-          gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
-              right,
-              col_weights,
-              self._unobserved_weight,
-              row_weights_slice,
-              new_sp_input.indices,
-              new_sp_input.values,
-              num_rows,
-              transpose_input,
-              name="wals_compute_partial_lhs_rhs"))
-      total_lhs = array_ops.expand_dims(total_lhs, 0) + partial_lhs
-      total_rhs = array_ops.expand_dims(total_rhs, -1)
-      new_left_values = array_ops.squeeze(
-          linalg_ops.matrix_solve(total_lhs, total_rhs), [2])
+      new_left_values = gen_factorization_ops.wals_compute_and_solve(
+          right,
+          col_weights,
+          self._unobserved_weight,
+          row_weights_slice,
+          new_sp_input.indices,
+          new_sp_input.values,
+          num_rows,
+          transpose_input,
+          total_lhs,
+          name="wals_compute_and_solve")
 
     update_op_name = "row_update" if update_row_factors else "col_update"
     update_op = self.scatter_update(left, update_indices, new_left_values,
@@ -37,29 +37,6 @@ namespace {
 // https://www.ffmpeg.org/ffmpeg-formats.html
 const char* kValidFileFormats[] = {"mp3", "mp4", "ogg", "wav"};
 
-// Writes binary data to a file.
-Status WriteFile(const string& filename, tensorflow::StringPiece contents) {
-  Env& env = *Env::Default();
-  std::unique_ptr<WritableFile> file;
-  TF_RETURN_IF_ERROR(env.NewWritableFile(filename, &file));
-  TF_RETURN_IF_ERROR(file->Append(contents));
-  TF_RETURN_IF_ERROR(file->Close());
-  return Status::OK();
-}
-
-// Cleans up a file on destruction.
-class FileDeleter {
- public:
-  explicit FileDeleter(const string& filename) : filename_(filename) {}
-  ~FileDeleter() {
-    Env& env = *Env::Default();
-    env.DeleteFile(filename_).IgnoreError();
-  }
-
- private:
-  const string filename_;
-};
-
 }  // namespace
 
 class DecodeAudioOp : public OpKernel {
@@ -95,16 +72,11 @@ class DecodeAudioOp : public OpKernel {
         errors::InvalidArgument("contents must be scalar but got shape ",
                                 contents.shape().DebugString()));
 
-    // Write the input data to a temp file.
-    const tensorflow::StringPiece file_contents = contents.scalar<string>()();
-    const string input_filename = GetTempFilename(file_format_);
-    OP_REQUIRES_OK(context, WriteFile(input_filename, file_contents));
-    FileDeleter deleter(input_filename);
-
     // Run FFmpeg on the data and verify results.
+    const tensorflow::StringPiece file_contents = contents.scalar<string>()();
     std::vector<float> output_samples;
     Status result =
-        ffmpeg::ReadAudioFile(input_filename, file_format_, samples_per_second_,
+        ffmpeg::ReadAudioData(file_contents, file_format_, samples_per_second_,
                               channel_count_, &output_samples);
     if (result.code() == error::Code::NOT_FOUND) {
       OP_REQUIRES(
@@ -16,12 +16,19 @@
 #include "tensorflow/contrib/ffmpeg/ffmpeg_lib.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <vector>
 
 #include "tensorflow/core/lib/io/path.h"
@@ -38,8 +45,17 @@ namespace {
 const char kFfmpegExecutable[] = "ffmpeg";
 const int32 kDefaultProbeSize = 5000000;  // 5MB
 
+// FFmpeg reads its input from stdin and writes the decoded samples to stdout
+// through these, instead of temp files.
+const char kStdinPipe[] = "pipe:0";
+const char kStdoutPipe[] = "pipe:1";
+
+// Formats whose demuxer may need to seek in the input (eg: the index of an
+// mp4 file can be at its end), which a pipe does not allow. Their input goes
+// through a temp file.
+const char* kSeekableInputFormats[] = {"mp4"};
+
 std::vector<string> FfmpegCommandLine(const string& input_filename,
-                                      const string& output_filename,
                                       const string& input_format_id,
                                       int32 samples_per_second,
                                       int32 channel_count) {
@@ -57,8 +73,7 @@ std::vector<string> FfmpegCommandLine(const string& input_filename,
     // Output set (in several ways) to signed 16-bit little-endian ints.
     "-codec:a:0", "pcm_s16le", "-sample_fmt", "s16", "-f", "s16le",
     "-sn",  // No subtitle recording.
-    "-y",  // Overwrite output file.
-    StrCat(output_filename)
+    kStdoutPipe
   };
 }
 
@@ -98,25 +113,159 @@ bool IsBinaryInstalled(const string& binary_name) {
   return false;
 }
 
-[[noreturn]] int ExecuteFfmpeg(const std::vector<string>& args) {
+// Runs in the child process. Only async-signal-safe functions may be called
+// between fork and exec, so the arguments are prepared by the parent.
+[[noreturn]] void ExecuteFfmpeg(char* const* args, int stdin_fd,
+                                int stdout_fd) {
+  if (::dup2(stdin_fd, STDIN_FILENO) < 0 ||
+      ::dup2(stdout_fd, STDOUT_FILENO) < 0) {
+    ::_exit(errno);
+  }
+  ::close(stdin_fd);
+  ::close(stdout_fd);
+  ::execvp(kFfmpegExecutable, args);
+  // exec only returns on error.
+  ::_exit(errno);
+}
+
+// Writes input to the stdin of FFmpeg while reading its stdout into output,
+// so that neither process blocks on a full pipe. Closes both descriptors.
+Status CommunicateWithFfmpeg(StringPiece input, int stdin_fd, int stdout_fd,
+                             string* output) {
+  // FFmpeg may exit before reading all of its input. Writing to the pipe then
+  // raises SIGPIPE, which is blocked in this thread so that the write fails
+  // with EPIPE instead of killing the process.
+  sigset_t sigpipe_set;
+  sigemptyset(&sigpipe_set);
+  sigaddset(&sigpipe_set, SIGPIPE);
+  sigset_t old_set;
+  pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set);
+  bool sigpipe_raised = false;
+
+  ::fcntl(stdin_fd, F_SETFL, ::fcntl(stdin_fd, F_GETFL) | O_NONBLOCK);
+  if (input.empty()) {
+    ::close(stdin_fd);
+    stdin_fd = -1;
+  }
+  Status status;
+  char buffer[1 << 16];
+  while (stdout_fd >= 0) {
+    struct pollfd fds[2];
+    int nfds = 0;
+    fds[nfds++] = {stdout_fd, POLLIN, 0};
+    if (stdin_fd >= 0) {
+      fds[nfds++] = {stdin_fd, POLLOUT, 0};
+    }
+    if (::poll(fds, nfds, -1) < 0) {
+      if (errno == EINTR) continue;
+      status = errors::Unknown("poll failed: ", errno);
+      break;
+    }
+    if (nfds > 1 && fds[1].revents != 0) {
+      const ssize_t written = ::write(stdin_fd, input.data(), input.size());
+      if (written >= 0) {
+        input.remove_prefix(written);
+      } else if (errno == EPIPE) {
+        // FFmpeg does not want any more input.
+        sigpipe_raised = true;
+        input.clear();
+      } else if (errno != EAGAIN && errno != EINTR) {
+        status = errors::Unknown("write to FFmpeg failed: ", errno);
+        break;
+      }
+      if (input.empty()) {
+        ::close(stdin_fd);
+        stdin_fd = -1;
+      }
+    }
+    if (fds[0].revents != 0) {
+      const ssize_t bytes_read = ::read(stdout_fd, buffer, sizeof(buffer));
+      if (bytes_read > 0) {
+        output->append(buffer, bytes_read);
+      } else if (bytes_read == 0) {
+        ::close(stdout_fd);
+        stdout_fd = -1;
+      } else if (errno != EINTR) {
+        status = errors::Unknown("read from FFmpeg failed: ", errno);
+        break;
+      }
+    }
+  }
+  if (stdin_fd >= 0) ::close(stdin_fd);
+  if (stdout_fd >= 0) ::close(stdout_fd);
+
+  // Consume the SIGPIPE raised by a failed write, if any, before unblocking.
+  sigset_t pending;
+  if (sigpipe_raised && sigpending(&pending) == 0 &&
+      sigismember(&pending, SIGPIPE)) {
+    int signal;
+    sigwait(&sigpipe_set, &signal);
+  }
+  pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+  return status;
+}
+
+// Runs FFmpeg with the given arguments, input as its stdin, and returns its
+// stdout in output.
+Status RunFfmpeg(const std::vector<string>& args, StringPiece input,
+                 string* output) {
+  // Unfortunately, it's impossible to differentiate an exec failure due to the
+  // binary being missing and an error from the binary's execution. Therefore,
+  // check to see if the binary *should* be available. If not, return an error
+  // that will be converted into a helpful error message by the TensorFlow op.
+  if (!IsBinaryInstalled(kFfmpegExecutable)) {
+    return Status(error::Code::NOT_FOUND, StrCat("FFmpeg could not be found."));
+  }
+
   std::vector<char*> args_chars;
+  args_chars.push_back(const_cast<char*>(kFfmpegExecutable));
   std::transform(args.begin(), args.end(), std::back_inserter(args_chars),
                  [](const string& s) { return const_cast<char*>(s.c_str()); });
   args_chars.push_back(nullptr);
 
-  ::execvp(kFfmpegExecutable, args_chars.data());
-  // exec only returns on error.
-  const int error = errno;
-  LOG(ERROR) << "FFmpeg could not be executed: " << error;
-  ::_exit(error);
-}
+  int stdin_pipe[2];
+  int stdout_pipe[2];
+  if (::pipe(stdin_pipe) < 0) {
+    return Status(error::Code::UNKNOWN, StrCat("pipe failed: ", errno));
+  }
+  if (::pipe(stdout_pipe) < 0) {
+    const int error = errno;
+    ::close(stdin_pipe[0]);
+    ::close(stdin_pipe[1]);
+    return Status(error::Code::UNKNOWN, StrCat("pipe failed: ", error));
+  }
 
-// Reads a PCM file using signed little endian 16-bit encoding (s16le).
-std::vector<float> ReadPcmFile(const string& filename) {
-  string raw_data;
-  TF_QCHECK_OK(ReadFileToString(Env::Default(), filename, &raw_data))
-      << "Could not read FFmpeg output file: " << filename;
+  // Execute ffmpeg and report errors.
+  pid_t child_pid = ::fork();
+  if (child_pid < 0) {
+    const int error = errno;
+    for (int fd : {stdin_pipe[0], stdin_pipe[1], stdout_pipe[0],
+                   stdout_pipe[1]}) {
+      ::close(fd);
+    }
+    return Status(error::Code::UNKNOWN, StrCat("fork failed: ", error));
+  }
+  if (child_pid == 0) {
+    ::close(stdin_pipe[1]);
+    ::close(stdout_pipe[0]);
+    ExecuteFfmpeg(args_chars.data(), stdin_pipe[0], stdout_pipe[1]);
+  }
+  ::close(stdin_pipe[0]);
+  ::close(stdout_pipe[1]);
+  const Status communicate_status =
+      CommunicateWithFfmpeg(input, stdin_pipe[1], stdout_pipe[0], output);
+  int status_code;
+  while (::waitpid(child_pid, &status_code, 0) < 0 && errno == EINTR) {
+  }
+  if (status_code) {
+    return Status(error::Code::UNKNOWN,
+                  StrCat("FFmpeg execution failed: ", status_code));
+  }
+  return communicate_status;
+}
 
+// Converts PCM data using signed little endian 16-bit encoding (s16le).
+std::vector<float> PcmToSamples(const string& raw_data) {
   std::vector<float> samples;
   const int32 sample_count = raw_data.size() / sizeof(int16);
   samples.reserve(sample_count);
@@ -202,6 +351,8 @@ string BuildWavFile(int32 samples_per_second, int32 channel_count,
 }  // namespace
 
 string GetTempFilename(const string& extension) {
+  // The counter keeps the names unique across the threads of this process.
+  static std::atomic<int64> counter(0);
   for (const char* dir : std::vector<const char*>(
            {getenv("TEST_TMPDIR"), getenv("TMPDIR"), getenv("TMP"), "/tmp"})) {
     if (!dir || !dir[0]) {
@@ -209,7 +360,8 @@ string GetTempFilename(const string& extension) {
     }
     struct stat statbuf;
     if (!stat(dir, &statbuf) && S_ISDIR(statbuf.st_mode)) {
-      return io::JoinPath(dir, StrCat("tmp_file_", getpid(), ".", extension));
+      return io::JoinPath(dir, StrCat("tmp_file_", getpid(), "_", counter++,
+                                      ".", extension));
     }
   }
   LOG(FATAL) << "No temp directory found.";
@@ -220,39 +372,36 @@ Status ReadAudioFile(const string& filename,
                      int32 samples_per_second,
                      int32 channel_count,
                      std::vector<float>* output_samples) {
-  // Create an argument list.
-  string output_filename = GetTempFilename("raw");
-  const std::vector<string> args =
-      FfmpegCommandLine(filename, output_filename, audio_format_id,
-                        samples_per_second, channel_count);
+  const std::vector<string> args = FfmpegCommandLine(
+      filename, audio_format_id, samples_per_second, channel_count);
+  string raw_data;
+  TF_RETURN_IF_ERROR(RunFfmpeg(args, StringPiece(), &raw_data));
+  *output_samples = PcmToSamples(raw_data);
+  return Status::OK();
+}
 
-  // Unfortunately, it's impossible to differentiate an exec failure due to the
-  // binary being missing and an error from the binary's execution. Therefore,
-  // check to see if the binary *should* be available. If not, return an error
-  // that will be converted into a helpful error message by the TensorFlow op.
-  if (!IsBinaryInstalled(kFfmpegExecutable)) {
-    return Status(error::Code::NOT_FOUND, StrCat("FFmpeg could not be found."));
+Status ReadAudioData(StringPiece contents, const string& audio_format_id,
+                     int32 samples_per_second, int32 channel_count,
+                     std::vector<float>* output_samples) {
+  if (std::find(std::begin(kSeekableInputFormats),
+                std::end(kSeekableInputFormats),
+                audio_format_id) != std::end(kSeekableInputFormats)) {
+    const string input_filename = GetTempFilename(audio_format_id);
+    TF_RETURN_IF_ERROR(
+        WriteStringToFile(Env::Default(), input_filename, contents));
+    const Status status =
+        ReadAudioFile(input_filename, audio_format_id, samples_per_second,
+                      channel_count, output_samples);
+    Env::Default()->DeleteFile(input_filename).IgnoreError();
+    return status;
   }
 
-  // Execute ffmpeg and report errors.
-  pid_t child_pid = ::fork();
-  if (child_pid < 0) {
-    return Status(error::Code::UNKNOWN, StrCat("fork failed: ", errno));
-  }
-  if (child_pid == 0) {
-    ExecuteFfmpeg(args);
-  } else {
-    int status_code;
-    ::waitpid(child_pid, &status_code, 0);
-    if (status_code) {
-      return Status(error::Code::UNKNOWN,
-                    StrCat("FFmpeg execution failed: ", status_code));
-    }
-    *output_samples = ReadPcmFile(output_filename);
-    TF_QCHECK_OK(Env::Default()->DeleteFile(output_filename))
-        << output_filename;
-    return Status::OK();
-  }
+  const std::vector<string> args = FfmpegCommandLine(
+      kStdinPipe, audio_format_id, samples_per_second, channel_count);
+  string raw_data;
+  TF_RETURN_IF_ERROR(RunFfmpeg(args, contents, &raw_data));
+  *output_samples = PcmToSamples(raw_data);
+  return Status::OK();
 }
 
 Status CreateAudioFile(const string& audio_format_id, int32 bits_per_second,
@@ -134,6 +134,28 @@ TEST(FfmpegLibTest, TestRoundTripWav) {
   EXPECT_EQ(original_audio, written_audio);
 }
 
+TEST(FfmpegLibTest, TestReadAudioDataMatchesFile) {
+  {
+    mutex_lock l(mu);
+    if (!should_ffmpeg_be_installed) {
+      return;
+    }
+  }
+
+  for (const char* test_filename : {kTestWavFilename, kTestMp3Filename}) {
+    const string filename = io::JoinPath(TensorFlowSrcRoot(), test_filename);
+    const string format = io::Extension(filename).ToString();
+    string contents;
+    ASSERT_TRUE(ReadFileToString(Env::Default(), filename, &contents).ok());
+    std::vector<float> from_file;
+    ASSERT_TRUE(ReadAudioFile(filename, format, 10000, 1, &from_file).ok());
+    std::vector<float> from_data;
+    ASSERT_TRUE(ReadAudioData(contents, format, 10000, 1, &from_data).ok());
+    EXPECT_FALSE(from_data.empty());
+    EXPECT_EQ(from_file, from_data);
+  }
+}
+
 }  // namespace
 }  // namespace ffmpeg
 }  // namespace tensorflow
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 
 namespace tensorflow {
 namespace ffmpeg {
@@ -36,6 +37,13 @@ Status ReadAudioFile(const string& filename,
                      int32 channel_count,
                      std::vector<float>* output_samples);
 
+// Like ReadAudioFile, but decodes the contents of an audio file held in
+// memory. The contents are streamed to ffmpeg through a pipe rather than
+// written to disk, except for formats that ffmpeg may need to seek in (mp4).
+Status ReadAudioData(StringPiece contents, const string& audio_format_id,
+                     int32 samples_per_second, int32 channel_count,
+                     std::vector<float>* output_samples);
+
 // Creates an audio file using ffmpeg in a specific format. The samples are in
 // [-1.0, 1.0]. If there are multiple channels in the audio then each frame will
 // contain a separate sample for each channel. Frames are ordered by time.
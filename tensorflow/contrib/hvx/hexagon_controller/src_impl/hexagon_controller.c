@@ -43,7 +43,7 @@ extern uint8_t inception_dummy_int_data_224x224[];
 extern uint8_t inception_dummy_int_data_299x299[];
 extern float inception_dummy_float_data_299x299[];
 
-#define HEXAGON_CONTROLLER_VERSION 92
+#define HEXAGON_CONTROLLER_VERSION 93
 
 // allocate print bufsize in advance @MB
 #define PRINT_BUFSIZE (2 * 1024 * 1024)
@@ -57,10 +57,15 @@ static const int INPUT_NODE_DATA_BUFFER_SIZE = 1024 * 1024 * 2;
 // (1008 is enough for inception)
 static const int OUTPUT_NODE_DATA_BUFFER_SIZE = 300 * 300 * 3 * 4;
 
-static struct NodeDataFloat s_input_node_data_float_buffer;
-static float* s_output_node_data_float_buffer;
+// number of input / output node data buffer sets, so that the input of the
+// next execution can be filled while the graph runs on the current one
+#define NODE_DATA_BUFFER_COUNT 2
+
+static struct NodeDataFloat
+    s_input_node_data_float_buffer[NODE_DATA_BUFFER_COUNT];
+static float* s_output_node_data_float_buffer[NODE_DATA_BUFFER_COUNT];
 static int s_output_node_data_float_buffer_byte_size;
-static int s_output_node_data_float_array_size;
+static int s_output_node_data_float_array_size[NODE_DATA_BUFFER_COUNT];
 static uint32_t s_target_graph_id;
 
 static bool s_dbg_use_inception_dummy_data = false;
@@ -92,21 +97,28 @@ void hexagon_controller_InitInputNodeDataToInceptionDummyData(int version) {
 
 bool hexagon_controller_ExecuteGraphWithBuffer(
     uint32_t nn_id, bool show_ranking) {
+  return hexagon_controller_ExecuteGraphWithBufferAt(0, nn_id, show_ranking);
+}
+
+bool hexagon_controller_ExecuteGraphWithBufferAt(
+    int buffer_index, uint32_t nn_id, bool show_ranking) {
+  if (buffer_index < 0 || buffer_index >= NODE_DATA_BUFFER_COUNT) {
+    TFMLOGE("Invalid buffer index %d", buffer_index);
+    return false;
+  }
+  const struct NodeDataFloat* input =
+      &s_input_node_data_float_buffer[buffer_index];
+  float* output = s_output_node_data_float_buffer[buffer_index];
   uint32_t out_batches, out_height, out_width, out_depth;
   uint32_t out_data_size;
-  int x = s_input_node_data_float_buffer.x;
-  int y = s_input_node_data_float_buffer.y;
-  int z = s_input_node_data_float_buffer.z;
-  int d = s_input_node_data_float_buffer.d;
-  uint8_t *byte_data = s_input_node_data_float_buffer.byte_array_data;
-  int array_size = s_input_node_data_float_buffer.array_size;
   const bool success = hexagon_controller_ExecuteGraph(
-      nn_id, x, y, z, d, byte_data, array_size,
+      nn_id, input->x, input->y, input->z, input->d, input->byte_array_data,
+      input->array_size,
       &out_batches, &out_height, &out_width, &out_depth,
-      (uint8_t *)s_output_node_data_float_buffer,
+      (uint8_t *)output,
       s_output_node_data_float_buffer_byte_size,
       &out_data_size);
-  s_output_node_data_float_array_size =
+  s_output_node_data_float_array_size[buffer_index] =
       out_batches * out_height * out_width * out_depth;
   if (!success) {
     TFMLOGE("Execution failed");
@@ -118,7 +130,7 @@ bool hexagon_controller_ExecuteGraphWithBuffer(
   static const int OUT_RANKING_SIZE = 5;
   int out_ranking[OUT_RANKING_SIZE];
   hexagon_controller_PrintMaxNIdx(
-      s_output_node_data_float_buffer,
+      output,
       out_batches * out_height * out_width * out_depth,
       OUT_RANKING_SIZE, out_ranking);
   TFMLOGD("%d x %d x %d x %d, byte size = %d\n",
@@ -168,45 +180,83 @@ int hexagon_controller_GetHexagonBinaryVersion() {
   return retval;
 }
 
+int hexagon_controller_GetNodeDataBufferCount() {
+  return NODE_DATA_BUFFER_COUNT;
+}
+
+// Node data buffers are passed to hexagon_nn_execute on every execution, so
+// they are allocated in ION memory shared with ADSP to avoid copying them
+// in FastRPC calls.
+static void* AllocateNodeDataBuffer(int byte_size) {
+#ifdef USE_ION_MEMORY
+  return rpcmem_alloc(RPCMEM_HEAP_DEFAULT, RPCMEM_FLAG_CACHED, byte_size);
+#else
+  return malloc(byte_size);
+#endif
+}
+
+static void ReleaseNodeDataBuffer(void* buf) {
+#ifdef USE_ION_MEMORY
+  rpcmem_free(buf);
+#else
+  free(buf);
+#endif
+}
+
 bool hexagon_controller_AllocateNodeDataBuffers(
     int input_size, int output_size) {
   TFMLOGD("Allocate memory for input / output node data float");
-  if (s_input_node_data_float_buffer.buf_size != 0) {
+  if (s_input_node_data_float_buffer[0].buf_size != 0) {
     TFMLOGE("ERROR! input buffer is already allocated!!");
     return false;
   } else {
+#ifdef USE_ION_MEMORY
+    rpcmem_init();
+#endif
     int byte_array_data_size = USE_FLOAT_DATA ?
         input_size * sizeof(float) : input_size; /* sizeof(uint8_t) ? */
-    s_input_node_data_float_buffer.buf_size = input_size;
-    // unused? remove?
-    s_input_node_data_float_buffer.array_data =
-        malloc(input_size * sizeof(float));
-    s_input_node_data_float_buffer.byte_array_data =
-        malloc(byte_array_data_size);
-
-    s_output_node_data_float_buffer = malloc(output_size * sizeof(float));
+    for (int i = 0; i < NODE_DATA_BUFFER_COUNT; ++i) {
+      struct NodeDataFloat* input = &s_input_node_data_float_buffer[i];
+      input->buf_size = input_size;
+      // unused? remove?
+      input->array_data = malloc(input_size * sizeof(float));
+      input->byte_array_data = AllocateNodeDataBuffer(byte_array_data_size);
+
+      s_output_node_data_float_buffer[i] =
+          AllocateNodeDataBuffer(output_size * sizeof(float));
+      s_output_node_data_float_array_size[i] = 0;
+      if (input->byte_array_data == NULL ||
+          s_output_node_data_float_buffer[i] == NULL) {
+        TFMLOGE("ERROR! failed to allocate node data buffers!!");
+        return false;
+      }
+    }
     s_output_node_data_float_buffer_byte_size = output_size * sizeof(float);
-    s_output_node_data_float_array_size = 0;
     TFMLOGD("allocate node data buffers");
   }
   return true;
 }
 
 bool hexagon_controller_ReleaseNodeDataBuffers() {
-  if (s_input_node_data_float_buffer.buf_size == 0) {
+  if (s_input_node_data_float_buffer[0].buf_size == 0) {
     TFMLOGE("ERROR! input buffer has not been allocated yet!!");
     return false;
-  } else {
-    s_input_node_data_float_buffer.buf_size = 0;
-    free(s_input_node_data_float_buffer.array_data);
   }
   if (s_output_node_data_float_buffer_byte_size == 0) {
     TFMLOGE("ERROR! output buffer has not been allocated yet!!");
     return false;
-  } else {
-    s_output_node_data_float_buffer_byte_size = 0;
-    free(s_input_node_data_float_buffer.byte_array_data);
   }
+  for (int i = 0; i < NODE_DATA_BUFFER_COUNT; ++i) {
+    struct NodeDataFloat* input = &s_input_node_data_float_buffer[i];
+    input->buf_size = 0;
+    free(input->array_data);
+    ReleaseNodeDataBuffer(input->byte_array_data);
+    ReleaseNodeDataBuffer(s_output_node_data_float_buffer[i]);
+  }
+  s_output_node_data_float_buffer_byte_size = 0;
+#ifdef USE_ION_MEMORY
+  rpcmem_deinit();
+#endif
   return true;
 }
 
@@ -214,18 +264,18 @@ bool hexagon_controller_CopyByteNodeData(
     int x, int y, int z, int d, int type_byte_size, uint8_t* array_data) {
   int array_byte_size = x * y * z * d * type_byte_size;
   TFMLOGD("--- %d, %d, %d, %d, %d, %d",x,y,z,d,type_byte_size,array_byte_size);
-  if (s_input_node_data_float_buffer.buf_size < array_byte_size) {
+  struct NodeDataFloat* input = &s_input_node_data_float_buffer[0];
+  if (input->buf_size < array_byte_size) {
     TFMLOGE("ERROR! input buffer size is too small! %d < %d",
-            s_input_node_data_float_buffer.buf_size, array_byte_size);
+            input->buf_size, array_byte_size);
     return false;
   }
-  memcpy(s_input_node_data_float_buffer.byte_array_data,
-         array_data, array_byte_size);
-  s_input_node_data_float_buffer.array_size = array_byte_size;
-  s_input_node_data_float_buffer.x = x;
-  s_input_node_data_float_buffer.y = y;
-  s_input_node_data_float_buffer.z = z;
-  s_input_node_data_float_buffer.d = d;
+  memcpy(input->byte_array_data, array_data, array_byte_size);
+  input->array_size = array_byte_size;
+  input->x = x;
+  input->y = y;
+  input->z = z;
+  input->d = d;
   return true;
 }
 
@@ -290,13 +340,33 @@ void hexagon_controller_GrowMemorySize() {
 }
 
 struct NodeDataFloat* hexagon_controller_GetInputNodeDataFloatBuffer() {
-  return &s_input_node_data_float_buffer;
+  return hexagon_controller_GetInputNodeDataFloatBufferAt(0);
 }
 
 float* hexagon_controller_GetOutputNodeDataFloatBuffer(
     const char *const node_name, int* out_array_size) {
-  *out_array_size = s_output_node_data_float_array_size;
-  return s_output_node_data_float_buffer;
+  return hexagon_controller_GetOutputNodeDataFloatBufferAt(
+      0, node_name, out_array_size);
+}
+
+struct NodeDataFloat* hexagon_controller_GetInputNodeDataFloatBufferAt(
+    int buffer_index) {
+  if (buffer_index < 0 || buffer_index >= NODE_DATA_BUFFER_COUNT) {
+    TFMLOGE("Invalid buffer index %d", buffer_index);
+    return NULL;
+  }
+  return &s_input_node_data_float_buffer[buffer_index];
+}
+
+float* hexagon_controller_GetOutputNodeDataFloatBufferAt(
+    int buffer_index, const char *const node_name, int* out_array_size) {
+  if (buffer_index < 0 || buffer_index >= NODE_DATA_BUFFER_COUNT) {
+    TFMLOGE("Invalid buffer index %d", buffer_index);
+    *out_array_size = -1;
+    return NULL;
+  }
+  *out_array_size = s_output_node_data_float_array_size[buffer_index];
+  return s_output_node_data_float_buffer[buffer_index];
 }
 
 // Append const node to the graph
@@ -40,6 +40,9 @@ int hexagon_controller_GetWrapperVersion();
 
 int hexagon_controller_GetHexagonBinaryVersion();
 
+// Returns the number of input / output node data buffer sets
+int hexagon_controller_GetNodeDataBufferCount();
+
 // Hexagon perf functions
 int hexagon_controller_InitHexagonWithMaxAttributes(int enable_dcvs,
                                                     int bus_usage, int version);
@@ -68,6 +71,12 @@ struct NodeDataFloat* hexagon_controller_GetInputNodeDataFloatBuffer();
 float* hexagon_controller_GetOutputNodeDataFloatBuffer(
     const char* const node_name, int* out_array_size);
 
+struct NodeDataFloat* hexagon_controller_GetInputNodeDataFloatBufferAt(
+    int buffer_index);
+
+float* hexagon_controller_GetOutputNodeDataFloatBufferAt(
+    int buffer_index, const char* const node_name, int* out_array_size);
+
 // Graph functions
 uint32_t hexagon_controller_InstantiateGraph();
 
@@ -89,6 +98,10 @@ bool hexagon_controller_ExecuteGraph(
 bool hexagon_controller_ExecuteGraphWithBuffer(uint32_t nn_id,
                                                bool show_ranking);
 
+bool hexagon_controller_ExecuteGraphWithBufferAt(int buffer_index,
+                                                 uint32_t nn_id,
+                                                 bool show_ranking);
+
 void hexagon_controller_DumpPerf(uint32_t nn_id);
 
 void hexagon_controller_DumpNodeName(uint32_t nn_id);
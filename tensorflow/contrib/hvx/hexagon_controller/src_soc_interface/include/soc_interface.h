@@ -50,6 +50,21 @@ bool soc_interface_FillInputNodeFloat(int x, int y, int z, int d,
 // Load output data from SOC
 bool soc_interface_ReadOutputNodeFloat(const char* const node_name,
                                        uint8_t** buf, uint64_t* buf_size);
+// Returns the number of input and output buffer sets on SOC. The inputs of
+// one buffer set can be filled while the graph runs on another one.
+int soc_interface_GetNodeDataBufferCount();
+// Send input data to the input buffer of buffer_index on SOC
+bool soc_interface_FillInputNodeFloatInBuffer(int buffer_index, int x, int y,
+                                              int z, int d,
+                                              const uint8_t* const buf,
+                                              uint64_t buf_size);
+// Execute graph on SOC with the input and output buffers of buffer_index
+bool soc_interface_ExecuteGraphInBuffer(int buffer_index);
+// Load output data from the output buffer of buffer_index on SOC
+bool soc_interface_ReadOutputNodeFloatInBuffer(int buffer_index,
+                                               const char* const node_name,
+                                               uint8_t** buf,
+                                               uint64_t* buf_size);
 // Setup graph
 // TODO(satok): Remove and use runtime version
 bool soc_interface_setupDummyGraph(int version);
@@ -73,6 +73,22 @@ bool soc_interface_ExecuteGraph() {
   return true;
 }
 
+int soc_interface_GetNodeDataBufferCount() {
+  return hexagon_controller_GetNodeDataBufferCount();
+}
+
+bool soc_interface_ExecuteGraphInBuffer(int buffer_index) {
+  TFMLOGD("ExecuteGraphInBuffer %d", buffer_index);
+  const uint32_t graph_id = hexagon_controller_GetTargetGraphId();
+  if (graph_id == 0) {
+    TFMLOGE("Graph id has not been set yet.");
+    return false;
+  }
+  // Skip the ranking of the results to keep the CPU free for the next inputs.
+  return hexagon_controller_ExecuteGraphWithBufferAt(
+      buffer_index, graph_id, false);
+}
+
 bool soc_interface_TeardownGraph() {
   TFMLOGD("TeardownGraph");
   const uint32_t graph_id = hexagon_controller_GetTargetGraphId();
@@ -87,9 +103,18 @@ bool soc_interface_TeardownGraph() {
 bool soc_interface_FillInputNodeFloat(
     int x, int y, int z, int d, const uint8_t* const buf,
     uint64_t buf_size) {
-  TFMLOGD("FillInputNodeFloat");
+  return soc_interface_FillInputNodeFloatInBuffer(0, x, y, z, d, buf, buf_size);
+}
+
+bool soc_interface_FillInputNodeFloatInBuffer(
+    int buffer_index, int x, int y, int z, int d, const uint8_t* const buf,
+    uint64_t buf_size) {
+  TFMLOGD("FillInputNodeFloat %d", buffer_index);
   struct NodeDataFloat* node_data_float =
-      hexagon_controller_GetInputNodeDataFloatBuffer();
+      hexagon_controller_GetInputNodeDataFloatBufferAt(buffer_index);
+  if (node_data_float == NULL) {
+    return false;
+  }
   const int array_size = x * y * z * d;
   if (array_size > node_data_float->buf_size) {
     TFMLOGE("Array size exceeds buf size %d > %d",
@@ -112,10 +137,17 @@ bool soc_interface_FillInputNodeFloat(
 // TODO(satok): Remove and use runtime version
 bool soc_interface_ReadOutputNodeFloat(
     const char* const node_name, uint8_t** buf, uint64_t *buf_size) {
-  TFMLOGD("ReadOutputNodeFloat");
+  return soc_interface_ReadOutputNodeFloatInBuffer(0, node_name, buf, buf_size);
+}
+
+bool soc_interface_ReadOutputNodeFloatInBuffer(
+    int buffer_index, const char* const node_name, uint8_t** buf,
+    uint64_t *buf_size) {
+  TFMLOGD("ReadOutputNodeFloat %d", buffer_index);
   int array_size = -1;
   float* output_node_data_float =
-      hexagon_controller_GetOutputNodeDataFloatBuffer(node_name, &array_size);
+      hexagon_controller_GetOutputNodeDataFloatBufferAt(
+          buffer_index, node_name, &array_size);
   if (array_size < 0) {
     TFMLOGE("Failed to read data.");
     return false;
@@ -49,6 +49,10 @@ class ColumnInterface {
   virtual InternalType DoFeature(int64 batch, int64 n,
                                  InternalType not_used) const = 0;
 
+  // Returns the FeatureCount(batch) string features of the specified batch,
+  // which are contiguous, or nullptr if the column does not hold strings.
+  virtual const string* StringFeatures(int64 batch) const = 0;
+
   virtual ~ColumnInterface() {}
 };
 
@@ -89,6 +93,11 @@ class SparseTensorColumn : public ColumnInterface<InternalType> {
     return values_.vec<string>().data()[start + n];
   }
 
+  const string* StringFeatures(int64 batch) const override {
+    if (DT_STRING != values_.dtype()) return nullptr;
+    return values_.vec<string>().data() + feature_start_indices_[batch];
+  }
+
   ~SparseTensorColumn() override {}
 
  private:
@@ -122,12 +131,66 @@ class DenseTensorColumn : public ColumnInterface<InternalType> {
     return tensor_.matrix<string>()(batch, n);
   }
 
+  const string* StringFeatures(int64 batch) const override {
+    if (DT_STRING != tensor_.dtype()) return nullptr;
+    return &tensor_.matrix<string>()(batch, 0);
+  }
+
   ~DenseTensorColumn() override {}
 
  private:
   const Tensor& tensor_;
 };
 
+// ProductIterator generates cartesian products based on indices.
+template <typename InternalType>
+class ProductIterator {
+ public:
+  explicit ProductIterator(
+      const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>&
+          columns,
+      int64 batch_index)
+      : columns_(columns), batch_index_(batch_index) {
+    next_permutation_.resize(columns_.size(), 0);
+    // Sets has_next_ to false if any feature column has 0 features.
+    has_next_ = true;
+    for (int i = 0; i < columns_.size(); i++) {
+      if (columns_[i]->FeatureCount(batch_index_) == 0) {
+        has_next_ = false;
+        break;
+      }
+    }
+  }
+
+  std::vector<int> Next() {
+    std::vector<int> permutation(next_permutation_);
+
+    // Generates next permutation, if available.
+    bool carry = true;
+    for (int i = next_permutation_.size() - 1; i >= 0; i--) {
+      if (carry) {
+        next_permutation_[i] = next_permutation_[i] + 1;
+      }
+      if (next_permutation_[i] == columns_[i]->FeatureCount(batch_index_)) {
+        next_permutation_[i] = 0;
+      } else {
+        carry = false;
+        break;
+      }
+    }
+    has_next_ = !carry;
+    return permutation;
+  }
+
+  bool HasNext() { return has_next_; }
+
+ private:
+  bool has_next_;
+  const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
+  const int64 batch_index_;
+  std::vector<int> next_permutation_;
+};
+
 // Updates Output tensors with sparse crosses.
 template <typename OutType>
 class OutputUpdater {
@@ -135,25 +198,23 @@ class OutputUpdater {
   OutputUpdater(const std::vector<int64>& output_start_indices,
                 Tensor* indices_out, Tensor* values_out)
       : output_start_indices_(output_start_indices),
-        indices_out_(indices_out),
-        values_out_(values_out) {}
+        indices_matrix_(indices_out->matrix<int64>()),
+        values_vec_(values_out->vec<OutType>()) {}
 
   void Update(const int64 batch_index, const int64 cross_count,
               const OutType& cross) const {
     const int64 output_index = output_start_indices_[batch_index] + cross_count;
 
-    auto indices_matrix = indices_out_->matrix<int64>();
-    indices_matrix(output_index, 0) = batch_index;
-    indices_matrix(output_index, 1) = cross_count;
+    indices_matrix_(output_index, 0) = batch_index;
+    indices_matrix_(output_index, 1) = cross_count;
 
-    auto value_vec = values_out_->vec<OutType>();
-    value_vec(output_index) = cross;
+    values_vec_(output_index) = cross;
   }
 
  private:
   const std::vector<int64>& output_start_indices_;
-  Tensor* indices_out_;
-  Tensor* values_out_;
+  typename TTypes<int64>::Matrix indices_matrix_;
+  typename TTypes<OutType>::Vec values_vec_;
 };
 
 // Generates the sparse crosses as concatenation of strings.
@@ -178,10 +239,91 @@ class StringCrosser {
     return str_util::Join(cross_vec, k_feature_separator);
   }
 
+  // Generates all the crosses of the row batch_index.
+  template <typename Updater>
+  void GenerateRow(const int64 batch_index, const Updater& updater) const {
+    ProductIterator<InternalType> product_iterator(columns_, batch_index);
+    int64 cross_count = 0;
+    while (product_iterator.HasNext()) {
+      const auto permutation = product_iterator.Next();
+      updater.Update(batch_index, cross_count,
+                     Generate(batch_index, permutation));
+      cross_count++;
+    }
+  }
+
  private:
   const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
 };
 
+// Generates all the hashed crosses of the row batch_index, in the order of
+// ProductIterator. The features of the row are fingerprinted once, rather
+// than once per cross they appear in, and consecutive crosses share the
+// hash of the features they have in common: only the hashes of the columns
+// after the last one to change are recomputed.
+template <typename HashCombineFn, typename Updater>
+void GenerateHashedCrosses(
+    const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns,
+    const int64 batch_index, const uint64 seed, const int64 num_buckets,
+    HashCombineFn hash_combine, const Updater& updater) {
+  const int num_columns = columns.size();
+  std::vector<std::vector<uint64>> features(num_columns);
+  gtl::InlinedVector<int64, 8> feature_counts(num_columns);
+  for (int i = 0; i < num_columns; ++i) {
+    const int64 feature_count = columns[i]->FeatureCount(batch_index);
+    // If one column is missing any feature, there won't be any cross.
+    if (feature_count == 0) {
+      return;
+    }
+    feature_counts[i] = feature_count;
+    const string* string_features = columns[i]->StringFeatures(batch_index);
+    if (string_features != nullptr) {
+      features[i].resize(feature_count);
+      Fingerprint64Batch(string_features, feature_count, features[i].data());
+      continue;
+    }
+    features[i].reserve(feature_count);
+    for (int64 n = 0; n < feature_count; ++n) {
+      features[i].push_back(columns[i]->Feature(batch_index, n));
+    }
+  }
+
+  // prefix_hashes[i] is the hash of the features of the first i columns of
+  // the current cross.
+  gtl::InlinedVector<uint64, 8> prefix_hashes(num_columns + 1);
+  prefix_hashes[0] = seed;
+  gtl::InlinedVector<int64, 8> permutation(num_columns, 0);
+  int first_changed = 0;
+  int64 cross_count = 0;
+  while (true) {
+    for (int i = first_changed; i < num_columns; ++i) {
+      prefix_hashes[i + 1] =
+          hash_combine(prefix_hashes[i], features[i][permutation[i]]);
+    }
+    const uint64 hashed_output = prefix_hashes[num_columns];
+    // The return value is int64 based on the number of buckets.
+    if (num_buckets > 0) {
+      updater.Update(batch_index, cross_count, hashed_output % num_buckets);
+    } else {
+      // To prevent negative output we take modulo to max int64.
+      updater.Update(batch_index, cross_count,
+                     hashed_output % std::numeric_limits<int64>::max());
+    }
+    cross_count++;
+
+    // Moves to the next permutation, the last column changing fastest.
+    int i = num_columns - 1;
+    while (i >= 0 && ++permutation[i] == feature_counts[i]) {
+      permutation[i] = 0;
+      --i;
+    }
+    if (i < 0) {
+      break;
+    }
+    first_changed = i;
+  }
+}
+
 // Generates the sparse crosses as nested hash to avoid string manipulations.
 class HashCrosser {
  public:
@@ -208,6 +350,18 @@ class HashCrosser {
     }
   }
 
+  // Generates all the crosses of the row batch_index.
+  template <typename Updater>
+  void GenerateRow(const int64 batch_index, const Updater& updater) const {
+    // Seed is chosen based on third_party/tensorflow/core/lib/hash/hash.h
+    static const int64 kInitialHashSeed = 0xDECAFCAFFE;
+
+    GenerateHashedCrosses(
+        columns_, batch_index, kInitialHashSeed, num_buckets_,
+        [](uint64 a, uint64 b) -> uint64 { return HashCombine(a, b); },
+        updater);
+  }
+
  private:
   static int64 HashCombine(int64 a, int64 b) {
     return a ^ (b + 0x9e3779b97f4a7800 + (a << 10) + (a >> 4));
@@ -242,61 +396,19 @@ class HashCrosserV2 {
     }
   }
 
+  // Generates all the crosses of the row batch_index.
+  template <typename Updater>
+  void GenerateRow(const int64 batch_index, const Updater& updater) const {
+    GenerateHashedCrosses(columns_, batch_index, hash_key_, num_buckets_,
+                          FingerprintCat64, updater);
+  }
+
  private:
   const std::vector<std::unique_ptr<ColumnInterface<int64>>>& columns_;
   const int64 num_buckets_;
   const uint64 hash_key_;
 };
 
-// ProductIterator generates cartesian products based on indices.
-template <typename InternalType>
-class ProductIterator {
- public:
-  explicit ProductIterator(
-      const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>&
-          columns,
-      int64 batch_index)
-      : columns_(columns), batch_index_(batch_index) {
-    next_permutation_.resize(columns_.size(), 0);
-    // Sets has_next_ to false if any feature column has 0 features.
-    has_next_ = true;
-    for (int i = 0; i < columns_.size(); i++) {
-      if (columns_[i]->FeatureCount(batch_index_) == 0) {
-        has_next_ = false;
-        break;
-      }
-    }
-  }
-
-  std::vector<int> Next() {
-    std::vector<int> permutation(next_permutation_);
-
-    // Generates next permutation, if available.
-    bool carry = true;
-    for (int i = next_permutation_.size() - 1; i >= 0; i--) {
-      if (carry) {
-        next_permutation_[i] = next_permutation_[i] + 1;
-      }
-      if (next_permutation_[i] == columns_[i]->FeatureCount(batch_index_)) {
-        next_permutation_[i] = 0;
-      } else {
-        carry = false;
-        break;
-      }
-    }
-    has_next_ = !carry;
-    return permutation;
-  }
-
-  bool HasNext() { return has_next_; }
-
- private:
-  bool has_next_;
-  const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns_;
-  const int64 batch_index_;
-  std::vector<int> next_permutation_;
-};
-
 template <bool HASHED_OUTPUT, typename InternalType, bool VERSION_2>
 struct CrossTraits;
 
@@ -360,24 +472,23 @@ class SparseFeatureCrossOp : public OpKernel {
     std::vector<int64> output_start_indices(batch_size);
     CreateOutputTensors(columns, batch_size, context, &indices_out, &values_out,
                         &shape_out, &output_start_indices);
+    if (!context->status().ok()) return;
 
     typename CrossTraits<HASHED_OUTPUT, InternalType, VERSION_2>::Updater
         updater(output_start_indices, indices_out, values_out);
-    auto do_work = [this, &columns, crosser, updater](int64 begin, int64 end) {
-      for (int b = begin; b < end; b++) {
-        ProductIterator<InternalType> product_iterator(columns, b);
-        int64 cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count, crosser.Generate(b, permutation));
-          cross_count++;
-        }
+    auto do_work = [&crosser, &updater](int64 begin, int64 end) {
+      for (int64 b = begin; b < end; b++) {
+        crosser.GenerateRow(b, updater);
       }
     };
 
     auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
-    // TODO(zakaria): optimize kCostPerUnit
-    const int kCostPerUnit = 5000 * indices_list_in.size();
+    // The cost of a row grows with its number of crosses, each of which
+    // combines a feature of every column.
+    const int64 average_cross_count =
+        batch_size > 0 ? indices_out->dim_size(0) / batch_size : 0;
+    const int64 kCostPerUnit =
+        std::max<int64>(1, average_cross_count) * columns.size() * 1000;
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
           kCostPerUnit, do_work);
   }
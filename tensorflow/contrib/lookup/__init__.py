@@ -30,6 +30,8 @@
 @@HashTable
 @@MutableHashTable
 @@MutableDenseHashTable
+@@MemmappedHashTable
+@@EmbeddingVariable
 @@TableInitializerBase
 @@KeyValueTensorInitializer
 @@TextFileIndex
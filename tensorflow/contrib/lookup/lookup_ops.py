@@ -1664,3 +1664,383 @@ class MutableDenseHashTable(LookupInterface):
       return gen_data_flow_ops._lookup_table_import(self.op._table_ref,
                                                     restored_tensors[0],
                                                     restored_tensors[1])
+
+
+class MemmappedHashTable(LookupInterface):
+  """An immutable hash table served from a memory-mapped file.
+
+  The table is read from a file written by the
+  `convert_vocab_memmapped_format` tool, which precompiles a vocabulary text
+  file into a sorted binary table.  The file is mapped into memory when the
+  table is first used, and lookups read it directly, so loading the table does
+  not parse the vocabulary and the mapped pages are shared by every process
+  that serves the same file.
+
+  Keys and values must be `tf.int64` or `tf.string`.
+
+  Example usage:
+
+  ```python
+  table = tf.contrib.lookup.MemmappedHashTable("vocab.mmtable",
+                                               key_dtype=tf.string,
+                                               value_dtype=tf.int64,
+                                               default_value=-1)
+  out = table.lookup(query_keys)
+  print out.eval()
+  ```
+  """
+
+  def __init__(self,
+               filename,
+               key_dtype,
+               value_dtype,
+               default_value,
+               shared_name=None,
+               name="MemmappedHashTable"):
+    """Creates a `MemmappedHashTable` object.
+
+    Args:
+      filename: A scalar string `Tensor` with the filename of the table.
+      key_dtype: the type of the key tensors.
+      value_dtype: the type of the value tensors.
+      default_value: The value to use if a key is missing in the table.
+      shared_name: If non-empty, this table will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+
+    Returns:
+      A `MemmappedHashTable` object.
+    """
+    self._default_value = ops.convert_to_tensor(default_value,
+                                                dtype=value_dtype)
+    self._default_value.get_shape().merge_with(tensor_shape.scalar())
+    with ops.name_scope(name, "MemmappedHashTable", [filename]) as scope:
+      filename = ops.convert_to_tensor(filename, dtypes.string)
+      # pylint: disable=protected-access
+      self._table_ref = gen_data_flow_ops._memmapped_hash_table(
+          filename,
+          shared_name=shared_name,
+          key_dtype=key_dtype,
+          value_dtype=value_dtype,
+          name=scope)
+      # pylint: enable=protected-access
+    super(MemmappedHashTable, self).__init__(key_dtype, value_dtype,
+                                             self._table_ref.op.name.split(
+                                                 "/")[-1])
+
+  def size(self, name=None):
+    """Compute the number of elements in this table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of elements in this table.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._lookup_table_size(self._table_ref, name=name)
+
+  def lookup(self, keys, name=None):
+    """Looks up `keys` in a table, outputs the corresponding values.
+
+    The `default_value` is used for keys not present in the table.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape. Must match the
+        table's key_dtype.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor containing the values in the same shape as `keys` using the
+        table's value type.
+
+    Raises:
+      TypeError: when `keys` do not match the table data types.
+    """
+    if keys.dtype != self._key_dtype:
+      raise TypeError("Signature mismatch. Keys must be dtype %s, got %s." %
+                      (self._key_dtype, keys.dtype))
+
+    with ops.name_scope(name, "%s_lookup_table_find" % self._name,
+                        (self._table_ref, keys, self._default_value)) as name:
+      # pylint: disable=protected-access
+      values = gen_data_flow_ops._lookup_table_find(self._table_ref,
+                                                    keys,
+                                                    self._default_value,
+                                                    name=name)
+
+    values.set_shape(keys.get_shape())
+    return values
+
+  def export(self, name=None):
+    """Returns tensors of all keys and values in the table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A pair of tensors with the first tensor containing all keys, in sorted
+        order for `tf.int64` keys, and the second tensors containing all
+        values in the table.
+    """
+    with ops.name_scope(name, "%s_lookup_table_export_values" % self._name,
+                        [self._table_ref]) as name:
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._lookup_table_export(
+          self._table_ref,
+          self._key_dtype,
+          self._value_dtype,
+          name=name)
+
+
+class EmbeddingVariable(LookupInterface):
+  """A variable of float rows keyed by int64 ids, which grows with the ids.
+
+  The variable only holds the rows of the ids it has seen: the row of an id is
+  created the first time the id is gathered or updated, so its memory grows
+  with the number of distinct ids instead of with the largest id, and
+  checkpoints only hold the live rows.  A new row is `initial_value` plus a
+  uniform noise in `[-initial_scale, initial_scale)` that only depends on
+  `seed`, the id and the position in the row.
+
+  The gradient of `lookup` with respect to the variable handle is an
+  `IndexedSlices`, which `apply_gradient_descent` and `apply_adagrad` apply to
+  the rows of its indices.
+
+  Example usage:
+
+  ```python
+  embeddings = tf.contrib.lookup.EmbeddingVariable(dim=16, initial_scale=0.1)
+  rows = embeddings.lookup(ids)
+  loss = ...
+  grad, = tf.gradients(loss, [embeddings.table_ref])
+  train_op = embeddings.apply_gradient_descent(0.1, grad)
+  ```
+  """
+
+  def __init__(self,
+               dim,
+               initial_value=0.0,
+               initial_scale=0.0,
+               seed=0,
+               shared_name=None,
+               name="EmbeddingVariable",
+               checkpoint=True):
+    """Creates an empty `EmbeddingVariable` object.
+
+    Args:
+      dim: The number of elements of each row.
+      initial_value: The mean of the initial values of the rows.
+      initial_scale: The half width of the range of the initial values of the
+        rows.
+      seed: The seed of the initial values of the rows.
+      shared_name: If non-empty, this variable will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+      checkpoint: if True, the rows of the variable are saved to and restored
+        from checkpoints. If `shared_name` is empty for a checkpointed
+        variable, it is shared using the variable node name.
+
+    Returns:
+      An `EmbeddingVariable` object.
+    """
+    self._value_shape = tensor_shape.vector(dim)
+
+    # The variable must be shared if checkpointing is requested for
+    # multi-worker training to work correctly. Use the node name if no
+    # shared_name has been explicitly specified.
+    use_node_name_sharing = checkpoint and shared_name is None
+    # pylint: disable=protected-access
+    self._table_ref = gen_data_flow_ops._embedding_variable(
+        shared_name=shared_name,
+        use_node_name_sharing=use_node_name_sharing,
+        value_shape=self._value_shape,
+        initial_value=initial_value,
+        initial_scale=initial_scale,
+        seed=seed,
+        name=name)
+    # pylint: enable=protected-access
+    super(EmbeddingVariable, self).__init__(dtypes.int64, dtypes.float32,
+                                            self._table_ref.op.name.split(
+                                                "/")[-1])
+
+    if checkpoint:
+      saveable = EmbeddingVariable._Saveable(self, name)
+      ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS, saveable)
+
+  @property
+  def table_ref(self):
+    """Get the underlying variable handle."""
+    return self._table_ref
+
+  @property
+  def dim(self):
+    """The number of elements of each row."""
+    return self._value_shape[0].value
+
+  def size(self, name=None):
+    """Compute the number of rows in this variable.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of rows in this variable.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._lookup_table_size_v2(self._table_ref,
+                                                     name=name)
+
+  def lookup(self, keys, name=None):
+    """Gathers the rows of `keys`, creating the rows that do not exist yet.
+
+    Args:
+      keys: The `tf.int64` ids of the rows. Can be a tensor of any shape.
+      name: A name for the operation (optional).
+
+    Returns:
+      A `tf.float32` tensor of shape `keys.shape + [dim]` with the rows.
+
+    Raises:
+      TypeError: when `keys` are not `tf.int64`.
+    """
+    keys = ops.convert_to_tensor(keys, dtypes.int64)
+    if keys.dtype != self._key_dtype:
+      raise TypeError("Signature mismatch. Keys must be dtype %s, got %s." %
+                      (self._key_dtype, keys.dtype))
+
+    with ops.name_scope(name, "%s_gather" % self._name,
+                        (self._table_ref, keys)) as name:
+      # pylint: disable=protected-access
+      values = gen_data_flow_ops._embedding_variable_gather(self._table_ref,
+                                                            keys,
+                                                            name=name)
+
+    values.set_shape(keys.get_shape().concatenate(self._value_shape))
+    return values
+
+  def insert(self, keys, values, name=None):
+    """Replaces the rows of `keys` with `values`.
+
+    Args:
+      keys: The `tf.int64` ids of the rows. Can be a tensor of any shape.
+      values: The `tf.float32` rows, of shape `keys.shape + [dim]`.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+
+    Raises:
+      TypeError: when `keys` or `values` doesn't match the variable data
+        types.
+    """
+    self.check_table_dtypes(keys.dtype, values.dtype)
+    with ops.name_scope(name, "%s_lookup_table_insert" % self._name,
+                        [self._table_ref, keys, values]) as name:
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._lookup_table_insert_v2(
+          self._table_ref, keys, values, name=name)
+
+  def export(self, name=None):
+    """Returns tensors of all ids and rows in the variable.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A pair of tensors with the first tensor containing all ids and the
+        second tensors containing the rows of the ids.
+    """
+    with ops.name_scope(name, "%s_lookup_table_export_values" % self._name,
+                        [self._table_ref]) as name:
+      # pylint: disable=protected-access
+      exported_keys, exported_values = (
+          gen_data_flow_ops._lookup_table_export_v2(
+              self._table_ref,
+              self._key_dtype,
+              self._value_dtype,
+              name=name))
+
+    exported_values.set_shape(exported_keys.get_shape().concatenate(
+        self._value_shape))
+    return exported_keys, exported_values
+
+  def apply_gradient_descent(self, learning_rate, grad, name=None):
+    """Subtracts `learning_rate * grad` from the rows of the gradient indices.
+
+    Args:
+      learning_rate: A scalar `tf.float32` learning rate.
+      grad: An `IndexedSlices` gradient of the variable, such as the gradient
+        of `lookup`.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_apply_gradient_descent" % self._name,
+                        [self._table_ref, learning_rate, grad]) as name:
+      # pylint: disable=protected-access
+      apply_op = (
+          gen_data_flow_ops._embedding_variable_sparse_apply_gradient_descent)
+      return apply_op(
+          self._table_ref,
+          math_ops.cast(learning_rate, dtypes.float32),
+          grad.values,
+          grad.indices,
+          name=name)
+
+  def apply_adagrad(self, accumulators, learning_rate, grad, name=None):
+    """Applies `grad` to the rows of its indices with the adagrad scheme.
+
+    Args:
+      accumulators: The `EmbeddingVariable` of the squared gradient sums, with
+        the same `dim` and a positive `initial_value`.
+      learning_rate: A scalar `tf.float32` learning rate.
+      grad: An `IndexedSlices` gradient of the variable, such as the gradient
+        of `lookup`.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_apply_adagrad" % self._name,
+                        [self._table_ref, accumulators.table_ref,
+                         learning_rate, grad]) as name:
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._embedding_variable_sparse_apply_adagrad(
+          self._table_ref,
+          accumulators.table_ref,
+          math_ops.cast(learning_rate, dtypes.float32),
+          grad.values,
+          grad.indices,
+          name=name)
+
+  class _Saveable(BaseSaverBuilder.SaveableObject):
+    """SaveableObject implementation for EmbeddingVariable."""
+
+    def __init__(self, table, name):
+      tensors = table.export()
+      specs = [
+          BaseSaverBuilder.SaveSpec(tensors[0], "", name + "-keys"),
+          BaseSaverBuilder.SaveSpec(tensors[1], "", name + "-values")
+      ]
+      # pylint: disable=protected-access
+      super(EmbeddingVariable._Saveable, self).__init__(table, specs, name)
+
+    def restore(self, restored_tensors, unused_restored_shapes):
+      # pylint: disable=protected-access
+      return gen_data_flow_ops._lookup_table_import_v2(
+          self.op._table_ref, restored_tensors[0], restored_tensors[1])
+
+
+@ops.RegisterGradient("EmbeddingVariableGather")
+def _EmbeddingVariableGatherGrad(op, grad):
+  """The gradient of the rows gathered from an embedding variable."""
+  ids = array_ops.reshape(op.inputs[1], [-1])
+  values = array_ops.reshape(
+      grad, array_ops.concat([[-1], array_ops.shape(grad)[-1:]], 0))
+  return [ops.IndexedSlices(values, ids), None]
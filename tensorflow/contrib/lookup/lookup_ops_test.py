@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 
 import os
+import struct
 import tempfile
 import numpy as np
 import six
@@ -32,6 +33,8 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gradients_impl
+from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 from tensorflow.python.training import saver
@@ -1168,6 +1171,178 @@ class MutableDenseHashTableOpTest(test.TestCase):
         self.assertAllEqual(0, table2.size().eval())
 
 
+class MemmappedHashTableOpTest(test.TestCase):
+
+  def _createTableFile(self, basename, keys, values):
+    """Writes an int64 to int64 table in the format of memmapped_lookup_table.h.
+
+    The file holds a header (magic, key and value dtypes, number of entries,
+    and the offsets of the keys and values), then the sorted keys and the
+    values in the same order, all in host byte order.
+    """
+    table_file = os.path.join(self.get_temp_dir(), basename)
+    entries = sorted(zip(keys, values))
+    n = len(entries)
+    header_size = struct.calcsize("=8siiQQQ")
+    with open(table_file, "wb") as f:
+      f.write(
+          struct.pack("=8siiQQQ", b"TFMMLKU1", dtypes.int64.as_datatype_enum,
+                      dtypes.int64.as_datatype_enum, n, header_size,
+                      header_size + 8 * n))
+      f.write(struct.pack("=%dq" % n, *[k for k, _ in entries]))
+      f.write(struct.pack("=%dq" % n, *[v for _, v in entries]))
+    return table_file
+
+  def testMemmappedHashTable(self):
+    table_file = self._createTableFile("table", [11, 3, 7], [0, 1, 2])
+    with self.test_session():
+      table = lookup.MemmappedHashTable(
+          table_file, dtypes.int64, dtypes.int64, default_value=-1)
+      self.assertAllEqual(3, table.size().eval())
+
+      keys = constant_op.constant([[3, 7], [11, 5]], dtypes.int64)
+      output = table.lookup(keys)
+      self.assertAllEqual([2, 2], output.get_shape())
+      self.assertAllEqual([[1, 2], [0, -1]], output.eval())
+
+      exported_keys, exported_values = table.export()
+      self.assertAllEqual([3, 7, 11], exported_keys.eval())
+      self.assertAllEqual([1, 2, 0], exported_values.eval())
+
+  def testMemmappedHashTableDTypeMismatch(self):
+    table_file = self._createTableFile("mismatch", [1, 2], [3, 4])
+    with self.test_session():
+      table = lookup.MemmappedHashTable(
+          table_file, dtypes.int64, dtypes.string, default_value="n/a")
+      with self.assertRaisesOpError("maps int64 to int64"):
+        table.size().eval()
+
+  def testMemmappedHashTableNotATable(self):
+    not_a_table = os.path.join(self.get_temp_dir(), "not_a_table")
+    with open(not_a_table, "w") as f:
+      f.write("brain\nsalad\nsurgery\nand some more lines\n")
+    with self.test_session():
+      table = lookup.MemmappedHashTable(
+          not_a_table, dtypes.string, dtypes.int64, default_value=-1)
+      with self.assertRaises(errors_impl.DataLossError):
+        table.size().eval()
+
+
+class EmbeddingVariableOpTest(test.TestCase):
+
+  def testLookupCreatesRows(self):
+    with self.test_session():
+      embeddings = lookup.EmbeddingVariable(2, initial_value=1.0)
+      self.assertAllEqual(0, embeddings.size().eval())
+
+      ids = constant_op.constant([[3, 1 << 40], [3, -7]], dtypes.int64)
+      output = embeddings.lookup(ids)
+      self.assertAllEqual([2, 2, 2], output.get_shape())
+      self.assertAllClose(np.ones([2, 2, 2]), output.eval())
+      self.assertAllEqual(3, embeddings.size().eval())
+
+  def testInitialValuesOnlyDependOnIdAndSeed(self):
+    with self.test_session():
+      a = lookup.EmbeddingVariable(
+          8, initial_value=0.5, initial_scale=0.25, seed=3, name="a")
+      b = lookup.EmbeddingVariable(
+          8, initial_value=0.5, initial_scale=0.25, seed=3, name="b")
+      c = lookup.EmbeddingVariable(
+          8, initial_value=0.5, initial_scale=0.25, seed=4, name="c")
+      a_rows = a.lookup(constant_op.constant([5, 9], dtypes.int64)).eval()
+      b_rows = b.lookup(constant_op.constant([9, 5], dtypes.int64)).eval()
+      c_rows = c.lookup(constant_op.constant([5, 9], dtypes.int64)).eval()
+      self.assertAllEqual(a_rows, b_rows[::-1])
+      self.assertFalse(np.array_equal(a_rows, c_rows))
+      self.assertTrue(np.all(a_rows >= 0.25))
+      self.assertTrue(np.all(a_rows < 0.75))
+      self.assertFalse(np.array_equal(a_rows[0], a_rows[1]))
+
+  def testInsertAndExport(self):
+    with self.test_session():
+      embeddings = lookup.EmbeddingVariable(2)
+      embeddings.insert(
+          constant_op.constant([4, 2], dtypes.int64),
+          constant_op.constant([[1, 2], [3, 4]], dtypes.float32)).run()
+      self.assertAllEqual(2, embeddings.size().eval())
+
+      output = embeddings.lookup(constant_op.constant([2, 4, 6], dtypes.int64))
+      self.assertAllClose([[3, 4], [1, 2], [0, 0]], output.eval())
+
+      exported_keys, exported_values = embeddings.export()
+      self.assertAllEqual([None, 2], exported_values.get_shape().as_list())
+      keys, values = exported_keys.eval(), exported_values.eval()
+      order = np.argsort(keys)
+      self.assertAllEqual([2, 4, 6], keys[order])
+      self.assertAllClose([[3, 4], [1, 2], [0, 0]], values[order])
+
+  def testApplyGradientDescent(self):
+    with self.test_session():
+      embeddings = lookup.EmbeddingVariable(2, initial_value=1.0)
+      ids = constant_op.constant([7, 3, 7], dtypes.int64)
+      loss = math_ops.reduce_sum(embeddings.lookup(ids))
+      grad, = gradients_impl.gradients(loss, [embeddings.table_ref])
+      self.assertTrue(isinstance(grad, ops.IndexedSlices))
+      embeddings.apply_gradient_descent(0.5, grad).run()
+
+      output = embeddings.lookup(constant_op.constant([3, 7], dtypes.int64))
+      self.assertAllClose([[0.5, 0.5], [0, 0]], output.eval())
+
+  def testApplyAdagrad(self):
+    with self.test_session():
+      embeddings = lookup.EmbeddingVariable(1, initial_value=1.0, name="e")
+      accumulators = lookup.EmbeddingVariable(
+          1, initial_value=0.1, name="accum")
+      grad = ops.IndexedSlices(
+          constant_op.constant([[3], [4]], dtypes.float32),
+          constant_op.constant([2, 2], dtypes.int64))
+      embeddings.apply_adagrad(accumulators, 2.0, grad).run()
+
+      accum = 0.1
+      value = 1.0
+      for g in [3.0, 4.0]:
+        accum += g * g
+        value -= 2.0 * g / np.sqrt(accum)
+      ids = constant_op.constant([2], dtypes.int64)
+      self.assertAllClose([[accum]], accumulators.lookup(ids).eval())
+      self.assertAllClose([[value]], embeddings.lookup(ids).eval())
+
+  def testApplyAdagradDimMismatch(self):
+    with self.test_session():
+      embeddings = lookup.EmbeddingVariable(2, name="e")
+      accumulators = lookup.EmbeddingVariable(3, name="accum")
+      grad = ops.IndexedSlices(
+          constant_op.constant([[1, 2]], dtypes.float32),
+          constant_op.constant([0], dtypes.int64))
+      with self.assertRaisesOpError("same row size"):
+        embeddings.apply_adagrad(accumulators, 0.1, grad).run()
+
+  def testSaveRestore(self):
+    save_dir = os.path.join(self.get_temp_dir(), "save_restore")
+    save_path = os.path.join(tempfile.mkdtemp(prefix=save_dir), "embedding")
+
+    with self.test_session(graph=ops.Graph()) as sess:
+      embeddings = lookup.EmbeddingVariable(
+          2, initial_scale=1.0, seed=1, name="e")
+      rows = embeddings.lookup(
+          constant_op.constant([1 << 50, 3], dtypes.int64)).eval()
+      self.assertAllEqual(2, embeddings.size().eval())
+      save = saver.Saver()
+      save.save(sess, save_path)
+
+    with self.test_session(graph=ops.Graph()) as sess:
+      embeddings = lookup.EmbeddingVariable(
+          2, initial_scale=1.0, seed=2, name="e")
+      embeddings.lookup(constant_op.constant([8], dtypes.int64)).eval()
+      save = saver.Saver()
+      save.restore(sess, save_path)
+      self.assertAllEqual(2, embeddings.size().eval())
+      self.assertAllClose(
+          rows,
+          embeddings.lookup(
+              constant_op.constant([1 << 50, 3], dtypes.int64)).eval())
+
+
 class IndexTableFromFile(test.TestCase):
 
   def _createVocabFile(self, basename, values=("brain", "salad", "surgery")):
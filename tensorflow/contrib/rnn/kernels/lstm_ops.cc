@@ -618,6 +618,23 @@ class SliceHelper {
   const Device& device_;
 };
 
+// Sets "rows" to rows [begin, end) of the matrix "t", copied to a temporary
+// tensor if they are not aligned.
+template <typename Device, typename T>
+Status AlignedRows(OpKernelContext* ctx, const Tensor& t, int64 begin,
+                   int64 end, Tensor* rows) {
+  const Tensor slice = t.Slice(begin, end);
+  if (slice.IsAligned()) {
+    *rows = slice;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(t.dtype(), slice.shape(), rows));
+  functor::TensorCopyUnaligned<Device, T>()(ctx->eigen_device<Device>(),
+                                            slice.unaligned_flat<T>(),
+                                            rows->flat<T>());
+  return Status::OK();
+}
+
 }  // namespace
 
 template <typename Device, typename T, bool USE_CUBLAS>
@@ -745,12 +762,6 @@ class BlockLSTMOp : public OpKernel {
     Tensor* h_out;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("h", batch_cell_shape, &h_out));
 
-    Tensor xh_tensor;
-    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
-                            DataTypeToEnum<T>::v(),
-                            TensorShape({batch_size, input_size + cell_size}),
-                            &xh_tensor));
-
     Tensor icfo_tensor;
     OP_REQUIRES_OK(ctx,
                    ctx->allocate_temp(DataTypeToEnum<T>::v(),
@@ -760,9 +771,46 @@ class BlockLSTMOp : public OpKernel {
     const Device& device = ctx->eigen_device<Device>();
 
     const int64 seq_len_max = seq_len_max_tensor->scalar<int64>()();
+    OP_REQUIRES(ctx, seq_len_max <= timelen,
+                errors::InvalidArgument("seq_len_max ", seq_len_max,
+                                        " is larger than the time length ",
+                                        timelen));
+
+    // The input projections x[t] * w_x + b of all the timesteps are computed
+    // by a single GEMM, which leaves only the much smaller recurrent GEMM
+    // h[t - 1] * w_h to each timestep.
+    Tensor icfo_x_tensor;
+    Tensor w_h_tensor;
+    if (seq_len_max > 0) {
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(
+                   DataTypeToEnum<T>::v(),
+                   TensorShape({seq_len_max, batch_size, cell_size * 4}),
+                   &icfo_x_tensor));
+      Tensor w_x_tensor;
+      OP_REQUIRES_OK(ctx, (AlignedRows<Device, T>(ctx, *w_tensor, 0,
+                                                  input_size, &w_x_tensor)));
+      OP_REQUIRES_OK(ctx, (AlignedRows<Device, T>(ctx, *w_tensor, input_size,
+                                                  input_size + cell_size,
+                                                  &w_h_tensor)));
+      Tensor x_tensor;
+      OP_REQUIRES_OK(
+          ctx, (AlignedRows<Device, T>(ctx, *x, 0, seq_len_max, &x_tensor)));
+      const Tensor& const_x_tensor = x_tensor;
+      const Tensor& const_w_x_tensor = w_x_tensor;
+      functor::BlockLSTMInputProjection<Device, T, USE_CUBLAS>()(
+          ctx, device,
+          const_x_tensor.shaped<T, 2>({seq_len_max * batch_size, input_size}),
+          const_w_x_tensor.matrix<T>(), b_tensor->vec<T>(),
+          icfo_x_tensor.shaped<T, 2>(
+              {seq_len_max * batch_size, cell_size * 4}));
+    }
+
+    const Tensor& const_w_h_tensor = w_h_tensor;
+
     SliceHelper<Device, T> slicer(ctx);
     for (int64 t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
+      const Tensor icfo_x_step = slicer.InputSlice(icfo_x_tensor, t, "icfo_x");
       const Tensor& cs_prev_tensor2 =
           t == 0 ? *cs_prev_tensor
                  : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
@@ -777,16 +825,15 @@ class BlockLSTMOp : public OpKernel {
       Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
       Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
 
-      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS>(batch_size, input_size,
+      functor::BlockLSTMFpropStep<Device, T, USE_CUBLAS>(batch_size, input_size,
                                                          cell_size)(
           ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
+          icfo_x_step.matrix<T>(), cs_prev_tensor2.matrix<T>(),
+          h_prev_tensor2.matrix<T>(), const_w_h_tensor.matrix<T>(),
           wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(), icfo_tensor.matrix<T>(),
-          h_tensor.matrix<T>());
+          i_tensor.matrix<T>(), cs_tensor.matrix<T>(), f_tensor.matrix<T>(),
+          o_tensor.matrix<T>(), ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+          icfo_tensor.matrix<T>(), h_tensor.matrix<T>());
       slicer.FinishTimeStep();
     }
 
@@ -817,18 +864,42 @@ REGISTER_KERNEL(float);
 
 #if GOOGLE_CUDA
 namespace functor {
-#define DECLARE_GPU_SPEC(T)                                              \
-  template <>                                                            \
-  void TensorZero<GPUDevice, T>::operator()(const GPUDevice& d,          \
-                                            typename TTypes<T>::Flat t); \
-                                                                         \
-  extern template struct TensorZero<GPUDevice, T>;                       \
-                                                                         \
-  template <>                                                            \
-  void TensorUnalignedZero<GPUDevice, T>::operator()(                    \
-      const GPUDevice& d, typename TTypes<T>::UnalignedFlat t);          \
-                                                                         \
-  extern template struct TensorUnalignedZero<GPUDevice, T>;
+#define DECLARE_GPU_SPEC(T)                                                   \
+  template <>                                                                 \
+  void TensorZero<GPUDevice, T>::operator()(const GPUDevice& d,               \
+                                            typename TTypes<T>::Flat t);      \
+                                                                              \
+  extern template struct TensorZero<GPUDevice, T>;                            \
+                                                                              \
+  template <>                                                                 \
+  void TensorUnalignedZero<GPUDevice, T>::operator()(                         \
+      const GPUDevice& d, typename TTypes<T>::UnalignedFlat t);               \
+                                                                              \
+  extern template struct TensorUnalignedZero<GPUDevice, T>;                   \
+                                                                              \
+  template <>                                                                 \
+  void BlockLSTMInputProjection<GPUDevice, T, true>::operator()(              \
+      OpKernelContext* ctx, const GPUDevice& d,                               \
+      typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix w_x, \
+      typename TTypes<T>::ConstVec b, typename TTypes<T>::Matrix icfo_x);     \
+                                                                              \
+  extern template struct BlockLSTMInputProjection<GPUDevice, T, true>;        \
+                                                                              \
+  template <>                                                                 \
+  void BlockLSTMFpropStep<GPUDevice, T, true>::operator()(                    \
+      OpKernelContext* ctx, const GPUDevice& d, const T forget_bias,          \
+      const T cell_clip, bool use_peephole,                                   \
+      typename TTypes<T>::ConstMatrix icfo_x,                                 \
+      typename TTypes<T>::ConstMatrix cs_prev,                                \
+      typename TTypes<T>::ConstMatrix h_prev,                                 \
+      typename TTypes<T>::ConstMatrix w_h, typename TTypes<T>::ConstVec wci,  \
+      typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,     \
+      typename TTypes<T>::Matrix i, typename TTypes<T>::Matrix cs,            \
+      typename TTypes<T>::Matrix f, typename TTypes<T>::Matrix o,             \
+      typename TTypes<T>::Matrix ci, typename TTypes<T>::Matrix co,           \
+      typename TTypes<T>::Matrix icfo, typename TTypes<T>::Matrix h);         \
+                                                                              \
+  extern template struct BlockLSTMFpropStep<GPUDevice, T, true>;
 
 DECLARE_GPU_SPEC(float);
 // DECLARE_GPU_SPEC(double);
@@ -171,6 +171,22 @@ struct LSTMBlockCellFprop : public LSTMBlockCell {
     Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({batch_size_, 1});
     icfo.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
 
+    ApplyGates(d, forget_bias, cell_clip, use_peephole, cs_prev, wci, wcf, wco,
+               icfo, i, cs, f, o, ci, co, h);
+  }
+
+  // Computes the gates, the cell state and the output from the
+  // pre-activations icfo = xh * w + b.
+  void ApplyGates(const Device& d, const T forget_bias, const T cell_clip,
+                  bool use_peephole, typename TTypes<T>::ConstMatrix cs_prev,
+                  typename TTypes<T>::ConstVec wci,
+                  typename TTypes<T>::ConstVec wcf,
+                  typename TTypes<T>::ConstVec wco,
+                  typename TTypes<T>::Matrix icfo, typename TTypes<T>::Matrix i,
+                  typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
+                  typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
+                  typename TTypes<T>::Matrix co,
+                  typename TTypes<T>::Matrix h) {
     Eigen::array<Eigen::DenseIndex, 2> p_shape({1, cell_size_});
     Eigen::array<Eigen::DenseIndex, 2> p_broadcast_shape({batch_size_, 1});
 
@@ -223,6 +239,56 @@ struct LSTMBlockCellFprop : public LSTMBlockCell {
   }
 };
 
+// Computes the input part of the pre-activations, x * w_x + b, of all the
+// timesteps of a sequence with a single GEMM. x is [timelen * batch_size,
+// input_size] and w_x holds the first input_size rows of w.
+template <typename Device, typename T, bool USE_CUBLAS>
+struct BlockLSTMInputProjection {
+  void operator()(OpKernelContext* ctx, const Device& d,
+                  typename TTypes<T>::ConstMatrix x,
+                  typename TTypes<T>::ConstMatrix w_x,
+                  typename TTypes<T>::ConstVec b,
+                  typename TTypes<T>::Matrix icfo_x) {
+    TensorBlasGemm<Device, T, USE_CUBLAS>::compute(ctx, d, false, false, T(1),
+                                                   x, w_x, T(0), icfo_x);
+    Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
+    Eigen::array<Eigen::DenseIndex, 2> broadcast_shape(
+        {icfo_x.dimensions()[0], 1});
+    icfo_x.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
+  }
+};
+
+// One timestep of BlockLSTM given its precomputed input projection icfo_x.
+// Only the recurrent weights w_h, the last cell_size rows of w, are read,
+// and x and h_prev are not concatenated.
+template <typename Device, typename T, bool USE_CUBLAS>
+struct BlockLSTMFpropStep : public LSTMBlockCellFprop<Device, T, USE_CUBLAS> {
+  BlockLSTMFpropStep(const int batch_size, const int input_size,
+                     const int cell_size)
+      : LSTMBlockCellFprop<Device, T, USE_CUBLAS>(batch_size, input_size,
+                                                  cell_size) {}
+
+  void operator()(
+      OpKernelContext* ctx, const Device& d, const T forget_bias,
+      const T cell_clip, bool use_peephole,
+      typename TTypes<T>::ConstMatrix icfo_x,
+      typename TTypes<T>::ConstMatrix cs_prev,
+      typename TTypes<T>::ConstMatrix h_prev,
+      typename TTypes<T>::ConstMatrix w_h, typename TTypes<T>::ConstVec wci,
+      typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,
+      typename TTypes<T>::Matrix i, typename TTypes<T>::Matrix cs,
+      typename TTypes<T>::Matrix f, typename TTypes<T>::Matrix o,
+      typename TTypes<T>::Matrix ci, typename TTypes<T>::Matrix co,
+      typename TTypes<T>::Matrix icfo, typename TTypes<T>::Matrix h) {
+    // icfo = icfo_x + h_prev * w_h
+    icfo.device(d) = icfo_x;
+    TensorBlasGemm<Device, T, USE_CUBLAS>::compute(ctx, d, false, false, T(1),
+                                                   h_prev, w_h, T(1), icfo);
+    this->ApplyGates(d, forget_bias, cell_clip, use_peephole, cs_prev, wci,
+                     wcf, wco, icfo, i, cs, f, o, ci, co, h);
+  }
+};
+
 template <typename Device, typename T, bool USE_CUBLAS>
 struct LSTMBlockCellBprop : public LSTMBlockCell {
   LSTMBlockCellBprop(const int batch_size, const int input_size,
@@ -0,0 +1,254 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements an eight-bit version of the GRU block cell.
+
+#include <string.h>
+#include <vector>
+
+#include "tensorflow/contrib/rnn/kernels/quantized_rnn_ops.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+using quantized_rnn::FixedPointMultiplier;
+using quantized_rnn::QuantizedRange;
+
+class QuantizedGRUBlockCellOp : public OpKernel {
+ public:
+  explicit QuantizedGRUBlockCellOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    gemm_context_.set_max_num_threads(
+        ctx->device()->tensorflow_cpu_worker_threads()->num_threads);
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& x_tensor = ctx->input(0);
+    const Tensor& h_prev_tensor = ctx->input(1);
+    const Tensor& w_ru_tensor = ctx->input(2);
+    const Tensor& w_c_tensor = ctx->input(3);
+    const Tensor& b_ru_tensor = ctx->input(4);
+    const Tensor& b_c_tensor = ctx->input(5);
+
+    QuantizedRange x_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(6), ctx->input(7), "x", &x_range));
+    QuantizedRange h_prev_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(8), ctx->input(9), "h_prev",
+                            &h_prev_range));
+    QuantizedRange w_ru_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(10), ctx->input(11), "w_ru",
+                            &w_ru_range));
+    QuantizedRange w_c_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(12), ctx->input(13), "w_c",
+                            &w_c_range));
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(x_tensor.shape()),
+                errors::InvalidArgument("x is not a matrix: ",
+                                        x_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(h_prev_tensor.shape()),
+                errors::InvalidArgument("h_prev is not a matrix: ",
+                                        h_prev_tensor.shape().DebugString()));
+    const int64 batch_size = x_tensor.dim_size(0);
+    const int64 input_size = x_tensor.dim_size(1);
+    const int64 cell_size = h_prev_tensor.dim_size(1);
+    const TensorShape state_shape({batch_size, cell_size});
+
+    OP_REQUIRES(ctx, h_prev_tensor.dim_size(0) == batch_size,
+                errors::InvalidArgument("h_prev.dims(0) != batch_size: ",
+                                        h_prev_tensor.dim_size(0), " vs. ",
+                                        batch_size));
+    OP_REQUIRES(
+        ctx, w_ru_tensor.shape() ==
+                 TensorShape({input_size + cell_size, cell_size * 2}),
+        errors::InvalidArgument("w_ru must be of shape [input_size + "
+                                "cell_size, cell_size * 2], got ",
+                                w_ru_tensor.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, w_c_tensor.shape() ==
+                 TensorShape({input_size + cell_size, cell_size}),
+        errors::InvalidArgument("w_c must be of shape [input_size + "
+                                "cell_size, cell_size], got ",
+                                w_c_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, b_ru_tensor.shape() == TensorShape({cell_size * 2}),
+                errors::InvalidArgument("b_ru must be of shape "
+                                        "[cell_size * 2], got ",
+                                        b_ru_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, b_c_tensor.shape() == TensorShape({cell_size}),
+                errors::InvalidArgument("b_c must be of shape [cell_size], "
+                                        "got ",
+                                        b_c_tensor.shape().DebugString()));
+
+    Tensor* h_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, state_shape, &h_tensor));
+    Tensor* h_min_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, {}, &h_min_tensor));
+    h_min_tensor->flat<float>()(0) = quantized_rnn::kOutputMin;
+    Tensor* h_max_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, {}, &h_max_tensor));
+    h_max_tensor->flat<float>()(0) = quantized_rnn::kOutputMax;
+    if (batch_size == 0 || cell_size == 0) {
+      return;
+    }
+
+    const double gate_scale = 1 << quantized_rnn::kGateFractionalBits;
+    FixedPointMultiplier x_ru_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            x_range.scale * w_ru_range.scale * gate_scale,
+                            &x_ru_multiplier));
+    FixedPointMultiplier h_ru_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            h_prev_range.scale * w_ru_range.scale * gate_scale,
+                            &h_ru_multiplier));
+    FixedPointMultiplier x_c_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            x_range.scale * w_c_range.scale * gate_scale,
+                            &x_c_multiplier));
+    FixedPointMultiplier h_c_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            h_prev_range.scale * w_c_range.scale * gate_scale,
+                            &h_c_multiplier));
+    // Converts h_prev to kActivationBits bits to update it.
+    FixedPointMultiplier h_prev_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            h_prev_range.scale *
+                                (1 << quantized_rnn::kActivationBits),
+                            &h_prev_multiplier));
+
+    Tensor x_ru;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DT_INT32, TensorShape({batch_size, cell_size * 2}),
+                            &x_ru));
+    Tensor h_ru;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DT_INT32, TensorShape({batch_size, cell_size * 2}),
+                            &h_ru));
+    Tensor x_c;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_INT32, state_shape, &x_c));
+    Tensor h_prevr_c;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DT_INT32, state_shape, &h_prevr_c));
+    // h_prev \circ r, in the range of h_prev.
+    Tensor h_prevr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_QUINT8, state_shape, &h_prevr));
+
+    const quint8* x = x_tensor.flat<quint8>().data();
+    const quint8* h_prev = h_prev_tensor.flat<quint8>().data();
+    const quint8* w_ru = w_ru_tensor.flat<quint8>().data();
+    const quint8* w_c = w_c_tensor.flat<quint8>().data();
+    int32* x_ru_data = x_ru.flat<int32>().data();
+    int32* h_ru_data = h_ru.flat<int32>().data();
+    int32* x_c_data = x_c.flat<int32>().data();
+    int32* h_prevr_c_data = h_prevr_c.flat<int32>().data();
+    quint8* h_prevr_data = h_prevr.flat<quint8>().data();
+
+    std::vector<int32> b_ru(cell_size * 2);
+    for (int64 j = 0; j < cell_size * 2; ++j) {
+      b_ru[j] = quantized_rnn::FloatToFixedPoint(
+          b_ru_tensor.flat<float>()(j), quantized_rnn::kGateFractionalBits);
+    }
+    std::vector<int32> b_c(cell_size);
+    for (int64 j = 0; j < cell_size; ++j) {
+      b_c[j] = quantized_rnn::FloatToFixedPoint(
+          b_c_tensor.flat<float>()(j), quantized_rnn::kGateFractionalBits);
+    }
+
+    mutex_lock l(mu_);
+    // [r_bar u_bar] = x_h_prev * w_ru + b_ru
+    if (input_size > 0) {
+      quantized_rnn::QuantizedGemm(&gemm_context_, x, w_ru, batch_size,
+                                   cell_size * 2, input_size, input_size,
+                                   cell_size * 2, x_range.zero_point,
+                                   w_ru_range.zero_point, x_ru_data);
+      quantized_rnn::QuantizedGemm(&gemm_context_, x, w_c, batch_size,
+                                   cell_size, input_size, input_size,
+                                   cell_size, x_range.zero_point,
+                                   w_c_range.zero_point, x_c_data);
+    } else {
+      memset(x_ru_data, 0, batch_size * cell_size * 2 * sizeof(int32));
+      memset(x_c_data, 0, batch_size * cell_size * sizeof(int32));
+    }
+    quantized_rnn::QuantizedGemm(
+        &gemm_context_, h_prev, w_ru + input_size * cell_size * 2, batch_size,
+        cell_size * 2, cell_size, cell_size, cell_size * 2,
+        h_prev_range.zero_point, w_ru_range.zero_point, h_ru_data);
+
+    // u is kept for the update of h.
+    std::vector<int32> u(batch_size * cell_size);
+    for (int64 n = 0; n < batch_size; ++n) {
+      for (int64 c = 0; c < cell_size; ++c) {
+        const int64 r_index = n * cell_size * 2 + c;
+        const int64 u_index = r_index + cell_size;
+        const int32 r = quantized_rnn::FixedPointSigmoid(
+            quantized_rnn::SaturateToInt32(
+                x_ru_multiplier.Apply(x_ru_data[r_index]) +
+                h_ru_multiplier.Apply(h_ru_data[r_index]) + b_ru[c]));
+        u[n * cell_size + c] = quantized_rnn::FixedPointSigmoid(
+            quantized_rnn::SaturateToInt32(
+                x_ru_multiplier.Apply(x_ru_data[u_index]) +
+                h_ru_multiplier.Apply(h_ru_data[u_index]) +
+                b_ru[cell_size + c]));
+
+        // h_prevr = h_prev \circ r
+        const int64 index = n * cell_size + c;
+        const int64 h_prevr_value =
+            h_prev_range.zero_point +
+            quantized_rnn::RoundingShiftRight(
+                int64{h_prev[index].value - h_prev_range.zero_point} * r,
+                quantized_rnn::kActivationBits);
+        h_prevr_data[index] = static_cast<uint8>(
+            std::min<int64>(std::max<int64>(h_prevr_value, 0), 255));
+      }
+    }
+
+    // c_bar = x_h_prevr * w_c + b_c
+    quantized_rnn::QuantizedGemm(
+        &gemm_context_, h_prevr_data, w_c + input_size * cell_size,
+        batch_size, cell_size, cell_size, cell_size, cell_size,
+        h_prev_range.zero_point, w_c_range.zero_point, h_prevr_c_data);
+
+    quint8* h = h_tensor->flat<quint8>().data();
+    for (int64 index = 0; index < batch_size * cell_size; ++index) {
+      const int32 c = quantized_rnn::FixedPointTanh(
+          quantized_rnn::SaturateToInt32(
+              x_c_multiplier.Apply(x_c_data[index]) +
+              h_c_multiplier.Apply(h_prevr_c_data[index]) +
+              b_c[index % cell_size]));
+      const int64 h_prev_value = h_prev_multiplier.Apply(
+          h_prev[index].value - h_prev_range.zero_point);
+      // h = (1-u) \circ c + u \circ h_prev
+      h[index] = quantized_rnn::ActivationProductToOutput(
+          int64{(1 << quantized_rnn::kActivationBits) - u[index]} * c +
+          u[index] * h_prev_value);
+    }
+  }
+
+ private:
+  mutex mu_;
+  gemmlowp::GemmContext gemm_context_ GUARDED_BY(mu_);
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedGRUBlockCell").Device(DEVICE_CPU),
+                        QuantizedGRUBlockCellOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,245 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Implements an eight-bit version of the LSTM block cell.
+
+#include <string.h>
+#include <vector>
+
+#include "tensorflow/contrib/rnn/kernels/quantized_rnn_ops.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+using quantized_rnn::FixedPointMultiplier;
+using quantized_rnn::QuantizedRange;
+
+class QuantizedLSTMBlockCellOp : public OpKernel {
+ public:
+  explicit QuantizedLSTMBlockCellOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("forget_bias", &forget_bias_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("cell_clip", &cell_clip_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_peephole", &use_peephole_));
+    gemm_context_.set_max_num_threads(
+        ctx->device()->tensorflow_cpu_worker_threads()->num_threads);
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& x_tensor = ctx->input(0);
+    const Tensor& cs_prev_tensor = ctx->input(1);
+    const Tensor& h_prev_tensor = ctx->input(2);
+    const Tensor& w_tensor = ctx->input(3);
+    const Tensor& wci_tensor = ctx->input(4);
+    const Tensor& wcf_tensor = ctx->input(5);
+    const Tensor& wco_tensor = ctx->input(6);
+    const Tensor& b_tensor = ctx->input(7);
+
+    QuantizedRange x_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(8), ctx->input(9), "x", &x_range));
+    QuantizedRange h_prev_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(10), ctx->input(11), "h_prev",
+                            &h_prev_range));
+    QuantizedRange w_range;
+    OP_REQUIRES_OK(ctx, quantized_rnn::GetQuantizedRange(
+                            ctx->input(12), ctx->input(13), "w", &w_range));
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(x_tensor.shape()),
+                errors::InvalidArgument("x is not a matrix: ",
+                                        x_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(cs_prev_tensor.shape()),
+                errors::InvalidArgument("cs_prev is not a matrix: ",
+                                        cs_prev_tensor.shape().DebugString()));
+    const int64 batch_size = x_tensor.dim_size(0);
+    const int64 input_size = x_tensor.dim_size(1);
+    const int64 cell_size = cs_prev_tensor.dim_size(1);
+    const TensorShape state_shape({batch_size, cell_size});
+
+    OP_REQUIRES(ctx, cs_prev_tensor.shape() == state_shape,
+                errors::InvalidArgument("cs_prev must be of shape ",
+                                        state_shape.DebugString(), ", got ",
+                                        cs_prev_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, h_prev_tensor.shape() == state_shape,
+                errors::InvalidArgument("h_prev must be of shape ",
+                                        state_shape.DebugString(), ", got ",
+                                        h_prev_tensor.shape().DebugString()));
+    OP_REQUIRES(
+        ctx, w_tensor.shape() ==
+                 TensorShape({input_size + cell_size, cell_size * 4}),
+        errors::InvalidArgument("w must be of shape [input_size + cell_size, "
+                                "cell_size * 4], got ",
+                                w_tensor.shape().DebugString()));
+    OP_REQUIRES(ctx, b_tensor.shape() == TensorShape({cell_size * 4}),
+                errors::InvalidArgument("b must be of shape [cell_size * 4], "
+                                        "got ",
+                                        b_tensor.shape().DebugString()));
+    if (use_peephole_) {
+      for (const Tensor* peephole : {&wci_tensor, &wcf_tensor, &wco_tensor}) {
+        OP_REQUIRES(ctx, peephole->shape() == TensorShape({cell_size}),
+                    errors::InvalidArgument(
+                        "The peephole weights must be of shape [cell_size], "
+                        "got ",
+                        peephole->shape().DebugString()));
+      }
+    }
+
+    Tensor* cs_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, state_shape, &cs_tensor));
+    Tensor* h_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(1, state_shape, &h_tensor));
+    Tensor* h_min_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, {}, &h_min_tensor));
+    h_min_tensor->flat<float>()(0) = quantized_rnn::kOutputMin;
+    Tensor* h_max_tensor = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(3, {}, &h_max_tensor));
+    h_max_tensor->flat<float>()(0) = quantized_rnn::kOutputMax;
+    if (batch_size == 0 || cell_size == 0) {
+      return;
+    }
+
+    // The accumulators of x * w and h_prev * w are scaled separately to the
+    // gate pre-activations, since x and h_prev have different ranges.
+    const double gate_scale = 1 << quantized_rnn::kGateFractionalBits;
+    FixedPointMultiplier x_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            x_range.scale * w_range.scale * gate_scale,
+                            &x_multiplier));
+    FixedPointMultiplier h_multiplier;
+    OP_REQUIRES_OK(ctx, FixedPointMultiplier::Create(
+                            h_prev_range.scale * w_range.scale * gate_scale,
+                            &h_multiplier));
+
+    const int64 gates_size = cell_size * 4;
+    Tensor x_gates;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DT_INT32, TensorShape({batch_size, gates_size}),
+                            &x_gates));
+    Tensor h_gates;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DT_INT32, TensorShape({batch_size, gates_size}),
+                            &h_gates));
+    int32* x_gates_data = x_gates.flat<int32>().data();
+    int32* h_gates_data = h_gates.flat<int32>().data();
+    const quint8* w_data = w_tensor.flat<quint8>().data();
+    {
+      mutex_lock l(mu_);
+      if (input_size > 0) {
+        quantized_rnn::QuantizedGemm(
+            &gemm_context_, x_tensor.flat<quint8>().data(), w_data,
+            batch_size, gates_size, input_size, input_size, gates_size,
+            x_range.zero_point, w_range.zero_point, x_gates_data);
+      } else {
+        memset(x_gates_data, 0, batch_size * gates_size * sizeof(int32));
+      }
+      quantized_rnn::QuantizedGemm(
+          &gemm_context_, h_prev_tensor.flat<quint8>().data(),
+          w_data + input_size * gates_size, batch_size, gates_size, cell_size,
+          cell_size, gates_size, h_prev_range.zero_point, w_range.zero_point,
+          h_gates_data);
+    }
+
+    // The biases, with the forget bias, and the peephole weights, scaled to
+    // multiply the cell state, in fixed point.
+    std::vector<int32> biases(gates_size);
+    const auto b = b_tensor.flat<float>();
+    for (int64 j = 0; j < gates_size; ++j) {
+      const bool forget_gate = j >= cell_size * 2 && j < cell_size * 3;
+      biases[j] = quantized_rnn::FloatToFixedPoint(
+          b(j) + (forget_gate ? forget_bias_ : 0.0f),
+          quantized_rnn::kGateFractionalBits);
+    }
+    const int peephole_bits = quantized_rnn::kGateFractionalBits -
+                              quantized_rnn::kCellStateFractionalBits;
+    std::vector<int32> wci(cell_size, 0);
+    std::vector<int32> wcf(cell_size, 0);
+    std::vector<int32> wco(cell_size, 0);
+    if (use_peephole_) {
+      for (int64 j = 0; j < cell_size; ++j) {
+        wci[j] = quantized_rnn::FloatToFixedPoint(wci_tensor.flat<float>()(j),
+                                                  peephole_bits);
+        wcf[j] = quantized_rnn::FloatToFixedPoint(wcf_tensor.flat<float>()(j),
+                                                  peephole_bits);
+        wco[j] = quantized_rnn::FloatToFixedPoint(wco_tensor.flat<float>()(j),
+                                                  peephole_bits);
+      }
+    }
+    const int32 cs_limit = std::min<int32>(
+        std::numeric_limits<int16>::max(),
+        cell_clip_ > 0.0f
+            ? quantized_rnn::FloatToFixedPoint(
+                  cell_clip_, quantized_rnn::kCellStateFractionalBits)
+            : std::numeric_limits<int32>::max());
+
+    const qint16* cs_prev = cs_prev_tensor.flat<qint16>().data();
+    qint16* cs = cs_tensor->flat<qint16>().data();
+    quint8* h = h_tensor->flat<quint8>().data();
+    for (int64 n = 0; n < batch_size; ++n) {
+      const int32* x_row = x_gates_data + n * gates_size;
+      const int32* h_row = h_gates_data + n * gates_size;
+      // The pre-activation of gate 'j', plus 'peephole'.
+      auto gate = [&](int64 j, int64 peephole) {
+        return quantized_rnn::SaturateToInt32(
+            x_multiplier.Apply(x_row[j]) + h_multiplier.Apply(h_row[j]) +
+            biases[j] + peephole);
+      };
+      for (int64 c = 0; c < cell_size; ++c) {
+        const int64 cs_prev_value = cs_prev[n * cell_size + c].value;
+        const int32 i = quantized_rnn::FixedPointSigmoid(
+            gate(c, cs_prev_value * wci[c]));
+        const int32 ci = quantized_rnn::FixedPointTanh(gate(cell_size + c, 0));
+        const int32 f = quantized_rnn::FixedPointSigmoid(
+            gate(cell_size * 2 + c, cs_prev_value * wcf[c]));
+
+        // cs = ci .* i + cs_prev .* f
+        const int64 cs_value =
+            quantized_rnn::RoundingShiftRight(
+                int64{ci} * i, 2 * quantized_rnn::kActivationBits -
+                                   quantized_rnn::kCellStateFractionalBits) +
+            quantized_rnn::RoundingShiftRight(cs_prev_value * f,
+                                              quantized_rnn::kActivationBits);
+        const int32 cs_clipped = static_cast<int32>(
+            std::min<int64>(std::max<int64>(cs_value, -cs_limit), cs_limit));
+        cs[n * cell_size + c] = static_cast<int16>(cs_clipped);
+
+        const int32 o = quantized_rnn::FixedPointSigmoid(
+            gate(cell_size * 3 + c, int64{cs_clipped} * wco[c]));
+        const int32 co =
+            quantized_rnn::FixedPointTanh(cs_clipped * (1 << peephole_bits));
+        h[n * cell_size + c] =
+            quantized_rnn::ActivationProductToOutput(int64{co} * o);
+      }
+    }
+  }
+
+ private:
+  float forget_bias_;
+  float cell_clip_;
+  bool use_peephole_;
+
+  mutex mu_;
+  gemmlowp::GemmContext gemm_context_ GUARDED_BY(mu_);
+};
+
+REGISTER_KERNEL_BUILDER(Name("QuantizedLSTMBlockCell").Device(DEVICE_CPU),
+                        QuantizedLSTMBlockCellOp);
+
+}  // namespace tensorflow
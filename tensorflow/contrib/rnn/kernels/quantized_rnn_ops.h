@@ -0,0 +1,231 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_RNN_KERNELS_QUANTIZED_RNN_OPS_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_RNN_KERNELS_QUANTIZED_RNN_OPS_H_
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+#define GEMMLOWP_ALLOW_SLOW_SCALAR_FALLBACK
+#include "public/gemmlowp.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+// Fixed-point arithmetic shared by the eight-bit LSTM and GRU block cells.
+//
+// The gate matrix multiplications accumulate in int32 with gemmlowp, and
+// everything else is computed in fixed point without requantizing between the
+// steps:
+//   - the gate pre-activations are int32 with kGateFractionalBits bits,
+//   - the sigmoid and tanh of the gates are int32 with kActivationBits bits,
+//   - the LSTM cell state is a qint16 with kCellStateFractionalBits bits,
+//   - the output h is a quint8 of fixed range [kOutputMin, kOutputMax], which
+//     holds the outputs of both cells, so that it feeds the next step as is.
+
+namespace tensorflow {
+namespace quantized_rnn {
+
+constexpr int kGateFractionalBits = 24;
+constexpr int kActivationBits = 15;
+constexpr int kCellStateFractionalBits = 11;
+
+// The output h is quantized with a scale of 1 / 128 and a zero point of 128.
+constexpr float kOutputMin = -1.0f;
+constexpr float kOutputMax = 127.0f / 128.0f;
+constexpr int32 kOutputZeroPoint = 128;
+constexpr int kOutputFractionalBits = 7;
+
+inline int32 SaturateToInt32(int64 value) {
+  return static_cast<int32>(
+      std::min<int64>(std::max<int64>(value, std::numeric_limits<int32>::min()),
+                      std::numeric_limits<int32>::max()));
+}
+
+// Divides by 2^shift, rounding to nearest.
+inline int64 RoundingShiftRight(int64 value, int shift) {
+  return (value + (int64{1} << (shift - 1))) >> shift;
+}
+
+// Multiplication of integers by a real multiplier, represented as an int32
+// mantissa and a shift like the gemmlowp output stages.
+class FixedPointMultiplier {
+ public:
+  FixedPointMultiplier() : mantissa_(0), shift_(1) {}
+
+  // Returns an error if the multiplier is too large.
+  static Status Create(double multiplier, FixedPointMultiplier* result) {
+    int exponent;
+    const double fraction = frexp(multiplier, &exponent);
+    int64 mantissa = static_cast<int64>(round(fraction * (int64{1} << 31)));
+    if (mantissa == (int64{1} << 31)) {
+      mantissa /= 2;
+      ++exponent;
+    }
+    result->mantissa_ = static_cast<int32>(mantissa);
+    result->shift_ = 31 - exponent;
+    if (result->shift_ < 1) {
+      return errors::InvalidArgument("Multiplier ", multiplier,
+                                     " is too large");
+    }
+    if (result->shift_ > 62) {
+      result->mantissa_ = 0;
+      result->shift_ = 1;
+    }
+    return Status::OK();
+  }
+
+  int64 Apply(int64 value) const {
+    return RoundingShiftRight(value * mantissa_, shift_);
+  }
+
+ private:
+  int32 mantissa_;
+  int shift_;
+};
+
+// The sigmoid of [-16, 16] by steps of 1 / 16 with kActivationBits bits,
+// interpolated linearly in between, which is within 1e-4 of the sigmoid.
+class SigmoidTable {
+ public:
+  static const SigmoidTable& Get() {
+    static const SigmoidTable* table = new SigmoidTable;
+    return *table;
+  }
+
+  // Returns the sigmoid of 'x' with kGateFractionalBits bits.
+  int32 Sigmoid(int32 x) const {
+    const int32 limit = kRange << kGateFractionalBits;
+    if (x <= -limit) {
+      return values_[0];
+    }
+    if (x >= limit) {
+      return values_[kSize - 1];
+    }
+    const int32 offset = x + limit;
+    const int32 index = offset >> kFractionBits;
+    // The fraction is reduced to kActivationBits bits so that its product
+    // with the difference of two values holds in an int32.
+    const int32 fraction =
+        (offset & ((1 << kFractionBits) - 1)) >>
+        (kFractionBits - kActivationBits);
+    return values_[index] +
+           ((values_[index + 1] - values_[index]) * fraction >>
+            kActivationBits);
+  }
+
+ private:
+  static constexpr int kRange = 16;
+  static constexpr int kStepsPerUnit = 16;
+  static constexpr int kSize = 2 * kRange * kStepsPerUnit + 1;
+  static constexpr int kFractionBits = kGateFractionalBits - 4;
+
+  SigmoidTable() {
+    for (int i = 0; i < kSize; ++i) {
+      const double x = static_cast<double>(i) / kStepsPerUnit - kRange;
+      values_[i] = static_cast<int32>(
+          round((1 << kActivationBits) / (1.0 + exp(-x))));
+    }
+  }
+
+  int32 values_[kSize];
+};
+
+// The sigmoid of 'x' with kGateFractionalBits bits, with kActivationBits bits.
+inline int32 FixedPointSigmoid(int32 x) {
+  return SigmoidTable::Get().Sigmoid(x);
+}
+
+// The tanh of 'x' with kGateFractionalBits bits, with kActivationBits bits, as
+// 2 * sigmoid(2 * x) - 1.
+inline int32 FixedPointTanh(int32 x) {
+  const int32 doubled = SaturateToInt32(int64{x} * 2);
+  return 2 * FixedPointSigmoid(doubled) - (1 << kActivationBits);
+}
+
+// Converts the float 'value' to a fixed-point int32 with 'fractional_bits'
+// bits, saturating.
+inline int32 FloatToFixedPoint(float value, int fractional_bits) {
+  return SaturateToInt32(
+      static_cast<int64>(round(static_cast<double>(value) *
+                               (int64{1} << fractional_bits))));
+}
+
+// Converts a product of activations, with 2 * kActivationBits bits, to the
+// quantized output h.
+inline quint8 ActivationProductToOutput(int64 product) {
+  const int64 value =
+      RoundingShiftRight(product,
+                         2 * kActivationBits - kOutputFractionalBits) +
+      kOutputZeroPoint;
+  return static_cast<uint8>(std::min<int64>(std::max<int64>(value, 0), 255));
+}
+
+// The quantization scale and zero point of a quint8 tensor of range
+// [min, max].
+struct QuantizedRange {
+  float scale;
+  int32 zero_point;
+};
+
+inline Status GetQuantizedRange(const Tensor& min_tensor,
+                                const Tensor& max_tensor, const string& name,
+                                QuantizedRange* range) {
+  if (min_tensor.NumElements() != 1 || max_tensor.NumElements() != 1) {
+    return errors::InvalidArgument("The range of ", name,
+                                   " must be two scalars");
+  }
+  const float min = min_tensor.flat<float>()(0);
+  const float max = max_tensor.flat<float>()(0);
+  if (!(max > min)) {
+    return errors::InvalidArgument("The max of ", name, ", ", max,
+                                   ", must be larger than its min, ", min);
+  }
+  range->scale = (max - min) / 255.0f;
+  range->zero_point = static_cast<int32>(
+      std::min(255.0f, std::max(0.0f, roundf(-min / range->scale))));
+  return Status::OK();
+}
+
+// Computes the int32 'result' [m, n] = (a - a_zero_point) *
+// (b - b_zero_point), with row-major quint8 'a' [m, k] and 'b' [k, n] of
+// strides 'lda' and 'ldb'.
+inline void QuantizedGemm(gemmlowp::GemmContext* context, const quint8* a,
+                          const quint8* b, int m, int n, int k, int lda,
+                          int ldb, int32 a_zero_point, int32 b_zero_point,
+                          int32* result) {
+  gemmlowp::MatrixMap<const std::uint8_t, gemmlowp::MapOrder::RowMajor> lhs(
+      &a->value, m, k, lda);
+  gemmlowp::MatrixMap<const std::uint8_t, gemmlowp::MapOrder::RowMajor> rhs(
+      &b->value, k, n, ldb);
+  gemmlowp::MatrixMap<std::int32_t, gemmlowp::MapOrder::RowMajor> out(
+      result, m, n, n);
+  const std::tuple<> empty_pipeline = {};
+  gemmlowp::GemmWithOutputPipeline<std::uint8_t, std::int32_t,
+                                   gemmlowp::DefaultL8R8BitDepthParams>(
+      context, lhs, rhs, &out, -a_zero_point, -b_zero_point, empty_pipeline);
+  // Since gemmlowp uses assembly to write to the output, msan won't detect
+  // the output buffer as written to, so we mark it manually.
+  TF_ANNOTATE_MEMORY_IS_INITIALIZED(result, m * n * sizeof(int32));
+}
+
+}  // namespace quantized_rnn
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_RNN_KERNELS_QUANTIZED_RNN_OPS_H_
@@ -211,3 +211,68 @@ d_b_ru = sum of d_r_bar_u_bar along axis = 0
 d_b_c = sum of d_c_bar along axis = 0
 ```
 )doc");
+
+REGISTER_OP("QuantizedGRUBlockCell")
+    .Input("x: quint8")
+    .Input("h_prev: quint8")
+    .Input("w_ru: quint8")
+    .Input("w_c: quint8")
+    .Input("b_ru: float")
+    .Input("b_c: float")
+    .Input("min_x: float")
+    .Input("max_x: float")
+    .Input("min_h_prev: float")
+    .Input("max_h_prev: float")
+    .Input("min_w_ru: float")
+    .Input("max_w_ru: float")
+    .Input("min_w_c: float")
+    .Input("max_w_c: float")
+    .Output("h: quint8")
+    .Output("min_h: float")
+    .Output("max_h: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x, h_prev, unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &x));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &h_prev));
+      for (int i = 6; i < 14; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+
+      DimensionHandle batch_size = c->Dim(x, 0);
+      DimensionHandle cell_size = c->Dim(h_prev, 1);
+      c->set_output(0, c->Matrix(batch_size, cell_size));
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return tensorflow::Status::OK();
+    })
+    .Doc(R"doc(
+Computes the GRU cell forward propagation for 1 time step in eight bits.
+
+This is the inference equivalent of GRUBlockCell, for quantized GRU graphs.
+The matrix multiplications accumulate in 32 bits, and the gates and their
+activations are then computed in fixed point. h_prev \circ r is kept in the
+range of h_prev for the multiplication by w_c.
+
+The output h is in the fixed range [-1, 127 / 128], so that the outputs of a
+step can feed the next one without requantization.
+
+x: Input to the GRU cell.
+h_prev: State input from the previous GRU cell.
+w_ru: Weight matrix for the reset and update gate.
+w_c: Weight matrix for the cell connection gate.
+b_ru: Bias vector for the reset and update gate.
+b_c: Bias vector for the cell connection gate.
+min_x: The float value that the lowest quantized x value represents.
+max_x: The float value that the highest quantized x value represents.
+min_h_prev: The float value that the lowest quantized h_prev value represents.
+max_h_prev: The float value that the highest quantized h_prev value
+  represents.
+min_w_ru: The float value that the lowest quantized w_ru value represents.
+max_w_ru: The float value that the highest quantized w_ru value represents.
+min_w_c: The float value that the lowest quantized w_c value represents.
+max_w_c: The float value that the highest quantized w_c value represents.
+
+h: Current state of the GRU cell.
+min_h: The float value that the lowest quantized h value represents.
+max_h: The float value that the highest quantized h value represents.
+)doc");
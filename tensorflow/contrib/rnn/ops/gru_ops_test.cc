@@ -62,4 +62,18 @@ TEST_F(GruOpsTest, GRUBlockCellGrad_ShapeFn) {
            "in0;[d0_0,d1_1];[d0_0,d1_1];[d0_0,d2_1]");
 }
 
+TEST_F(GruOpsTest, QuantizedGRUBlockCell_ShapeFn) {
+  ShapeInferenceTestOp op("QuantizedGRUBlockCell");
+
+  // Rank checks.
+  INFER_ERROR("must be rank 2", op, "[?];?;?;?;?;?;?;?;?;?;?;?;?;?");
+  INFER_ERROR("must be rank 2", op, "?;[?];?;?;?;?;?;?;?;?;?;?;?;?");
+  INFER_ERROR("must be rank 0", op, "?;?;?;?;?;?;[1];?;?;?;?;?;?;?");
+
+  // Output
+  INFER_OK(op, "?;?;?;?;?;?;?;?;?;?;?;?;?;?", "[?,?];[];[]");
+  INFER_OK(op, "[?,?];[?,?];?;?;?;?;[];[];[];[];[];[];[];[]",
+           "[d0_0,d1_1];[];[]");
+}
+
 }  // namespace tensorflow
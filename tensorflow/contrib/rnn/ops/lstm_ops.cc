@@ -348,4 +348,82 @@ wco_grad: The gradient for wco to be back-propped.
 b_grad: The gradient for w to be back-propped.
 )doc");
 
+REGISTER_OP("QuantizedLSTMBlockCell")
+    .Input("x: quint8")
+    .Input("cs_prev: qint16")
+    .Input("h_prev: quint8")
+    .Input("w: quint8")
+    .Input("wci: float")
+    .Input("wcf: float")
+    .Input("wco: float")
+    .Input("b: float")
+    .Input("min_x: float")
+    .Input("max_x: float")
+    .Input("min_h_prev: float")
+    .Input("max_h_prev: float")
+    .Input("min_w: float")
+    .Input("max_w: float")
+    .Output("cs: qint16")
+    .Output("h: quint8")
+    .Output("min_h: float")
+    .Output("max_h: float")
+    .Attr("forget_bias: float = 1.0")
+    .Attr("cell_clip: float = 3.0")
+    .Attr("use_peephole: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x, cs_prev, unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &x));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &cs_prev));
+      for (int i = 8; i < 14; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+
+      DimensionHandle batch_size = c->Dim(x, 0);
+      DimensionHandle cell_size = c->Dim(cs_prev, 1);
+      ShapeHandle output = c->Matrix(batch_size, cell_size);
+      c->set_output(0, output);
+      c->set_output(1, output);
+      c->set_output(2, c->Scalar());
+      c->set_output(3, c->Scalar());
+      return tensorflow::Status::OK();
+    })
+    .Doc(R"doc(
+Computes the LSTM cell forward propagation for 1 time step in eight bits.
+
+This is the inference equivalent of LSTMBlockCell, for quantized LSTM graphs.
+The matrix multiplication of [x, h_prev] by the weights accumulates in 32 bits,
+and the gates, their activations and the cell state are then computed in fixed
+point, with sigmoid and tanh approximations within 1e-4 and 2e-4 of the exact
+functions.
+
+The cell state is a 16 bit value with 11 fractional bits, of range [-16, 16).
+The output h is in the fixed range [-1, 127 / 128], so that the outputs of a
+step can feed the next one without requantization.
+
+cell_clip: Value to clip the 'cs' value to, at most 16.
+use_peephole: Whether to use peephole weights.
+forget_bias: The forget gate bias.
+
+x: The input to the LSTM cell, shape (batch_size, num_inputs).
+cs_prev: Value of the cell state at previous time step.
+h_prev: Output of the previous cell at previous time step.
+w: The weight matrix.
+wci: The weight matrix for input gate peephole connection.
+wcf: The weight matrix for forget gate peephole connection.
+wco: The weight matrix for output gate peephole connection.
+b: The bias vector.
+min_x: The float value that the lowest quantized x value represents.
+max_x: The float value that the highest quantized x value represents.
+min_h_prev: The float value that the lowest quantized h_prev value represents.
+max_h_prev: The float value that the highest quantized h_prev value
+  represents.
+min_w: The float value that the lowest quantized w value represents.
+max_w: The float value that the highest quantized w value represents.
+
+cs: The cell state before the tanh.
+h: The output h vector.
+min_h: The float value that the lowest quantized h value represents.
+max_h: The float value that the highest quantized h value represents.
+)doc");
+
 }  // end namespace tensorflow
@@ -78,6 +78,26 @@ TEST_F(LSTMOpsTest, LSTMBlockCellGrad_ShapeFn) {
            "[d0_0,d1_1];[d0_0,16];[d1_1];[d1_1];[d1_1]");
 }
 
+TEST_F(LSTMOpsTest, QuantizedLSTMBlockCell_ShapeFn) {
+  ShapeInferenceTestOp op("QuantizedLSTMBlockCell");
+
+  // The 6 inputs after x and cs_prev don't affect shape inference, and the
+  // last 6 are the ranges.
+  string input_suffix = strings::StrCat(";", JoinedCopies("?", 12));
+  string range_suffix = strings::StrCat(";", JoinedCopies("[]", 6));
+
+  // Rank checks.
+  INFER_ERROR("must be rank 2", op, "[?];?" + input_suffix);
+  INFER_ERROR("must be rank 2", op, "?;[?]" + input_suffix);
+  INFER_ERROR("must be rank 0", op,
+              "?;?;?;?;?;?;?;?;[1];" + JoinedCopies("?", 5));
+
+  // Output
+  INFER_OK(op, "?;?" + input_suffix, "[?,?];[?,?];[];[]");
+  INFER_OK(op, "[?,?];[?,?];?;?;?;?;?;?" + range_suffix,
+           "[d0_0,d1_1];[d0_0,d1_1];[];[]");
+}
+
 TEST_F(LSTMOpsTest, BlockLSTM_ShapeFn) {
   ShapeInferenceTestOp op("BlockLSTM");
 
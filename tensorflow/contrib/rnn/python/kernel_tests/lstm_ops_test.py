@@ -35,6 +35,7 @@ from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 
 block_lstm = lstm_ops._block_lstm  # pylint: disable=protected-access
+lstm_block_cell = lstm_ops._lstm_block_cell  # pylint: disable=protected-access
 
 
 class LSTMBlockCellTest(test.TestCase):
@@ -475,6 +476,88 @@ class LSTMBlockCellTest(test.TestCase):
       for basic, unfused in zip(basic_wgrads, unfused_wgrads):
         self.assertAllClose(basic, unfused, rtol=1e-2, atol=1e-2)
 
+  def _compareBlockLSTMToLSTMBlockCell(self, seq_len_max, use_peephole):
+    batch_size = 3
+    input_size = 4
+    cell_size = 5
+    time_len = 6
+    with self.test_session(use_gpu=self._use_gpu, graph=ops.Graph()) as sess:
+
+      def random_tensor(*shape):
+        return constant_op.constant(
+            0.5 * np.random.randn(*shape), dtype=dtypes.float32)
+
+      x = [random_tensor(batch_size, input_size) for _ in range(time_len)]
+      w = random_tensor(input_size + cell_size, cell_size * 4)
+      b = random_tensor(cell_size * 4)
+      wci = random_tensor(cell_size)
+      wcf = random_tensor(cell_size)
+      wco = random_tensor(cell_size)
+      cs_prev = random_tensor(batch_size, cell_size)
+      h_prev = random_tensor(batch_size, cell_size)
+
+      _, block_cs, _, _, _, _, block_h = block_lstm(
+          ops.convert_to_tensor(seq_len_max, dtype=dtypes.int64),
+          x,
+          w,
+          b,
+          cs_prev=cs_prev,
+          h_prev=h_prev,
+          wci=wci,
+          wcf=wcf,
+          wco=wco,
+          use_peephole=use_peephole)
+
+      cell_cs = []
+      cell_h = []
+      cs = cs_prev
+      h = h_prev
+      for t in range(seq_len_max):
+        _, cs, _, _, _, _, h = lstm_block_cell(
+            x[t],
+            cs,
+            h,
+            w,
+            b,
+            wci=wci,
+            wcf=wcf,
+            wco=wco,
+            use_peephole=use_peephole)
+        cell_cs.append(cs)
+        cell_h.append(h)
+
+      block_cs, block_h, cell_cs, cell_h = sess.run(
+          [block_cs, block_h, cell_cs, cell_h])
+
+    # BlockLSTM computes the input projections of all the timesteps before
+    # adding the recurrent ones, so the sums are rounded differently.
+    self.assertAllClose(cell_cs, block_cs[:seq_len_max], rtol=1e-5, atol=1e-5)
+    self.assertAllClose(cell_h, block_h[:seq_len_max], rtol=1e-5, atol=1e-5)
+    if seq_len_max < time_len:
+      zeros = np.zeros([time_len - seq_len_max, batch_size, cell_size])
+      self.assertAllEqual(zeros, block_cs[seq_len_max:])
+      self.assertAllEqual(zeros, block_h[seq_len_max:])
+
+  def testBlockLSTMMatchesLSTMBlockCell(self):
+    for use_peephole in [False, True]:
+      self._compareBlockLSTMToLSTMBlockCell(6, use_peephole)
+
+  def testBlockLSTMShorterSeqLenMax(self):
+    for use_peephole in [False, True]:
+      self._compareBlockLSTMToLSTMBlockCell(4, use_peephole)
+    self._compareBlockLSTMToLSTMBlockCell(0, False)
+
+  def testBlockLSTMSeqLenMaxLargerThanTimeLen(self):
+    with self.test_session(use_gpu=self._use_gpu, graph=ops.Graph()) as sess:
+      x = [array_ops.zeros([2, 3]) for _ in range(3)]
+      w = array_ops.zeros([3 + 4, 4 * 4])
+      b = array_ops.zeros([4 * 4])
+      _, _, _, _, _, _, h = block_lstm(
+          ops.convert_to_tensor(4, dtype=dtypes.int64), x, w, b)
+      with self.assertRaisesOpError(
+          "seq_len_max 4 is larger than the time length 3"):
+        sess.run(h)
+
 
 class LSTMBlockCellGpuTest(LSTMBlockCellTest):
   _use_gpu = True
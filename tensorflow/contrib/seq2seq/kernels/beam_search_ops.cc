@@ -21,6 +21,8 @@ limitations under the License.
 
 #include "tensorflow/contrib/seq2seq/kernels/beam_search_ops.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <vector>
 
@@ -146,6 +148,191 @@ struct GatherTree<CPUDevice, int32> {
 
 }  // namespace functor
 
+// Fuses the per-step ops of beam search decoding.  The log-softmax, masking,
+// length penalty and top-k are computed for each batch entry in one pass
+// over its logits, keeping only the beam_width best continuations instead of
+// materializing the scores of all beam_width * vocab_size of them.
+template <typename T>
+class BeamSearchStepOp : public OpKernel {
+ public:
+  explicit BeamSearchStepOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& logits = ctx->input(0);
+    const Tensor& log_probs = ctx->input(1);
+    const Tensor& lengths = ctx->input(2);
+    const Tensor& finished = ctx->input(3);
+    const Tensor& time = ctx->input(4);
+    const Tensor& end_token = ctx->input(5);
+    const Tensor& length_penalty_weight = ctx->input(6);
+    OP_REQUIRES(
+        ctx, logits.dims() == 3,
+        errors::InvalidArgument("logits must be a 3-tensor, saw shape: ",
+                                logits.shape().DebugString()));
+    const int64 batch_size = logits.dim_size(0);
+    const int64 beam_width = logits.dim_size(1);
+    const int64 vocab_size = logits.dim_size(2);
+    const TensorShape beams_shape({batch_size, beam_width});
+    for (const Tensor* t : {&log_probs, &lengths, &finished}) {
+      OP_REQUIRES(ctx, t->shape() == beams_shape,
+                  errors::InvalidArgument(
+                      "The beam state must be shaped ",
+                      beams_shape.DebugString(), ", saw shape: ",
+                      t->shape().DebugString()));
+    }
+    for (const Tensor* t : {&time, &end_token, &length_penalty_weight}) {
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(t->shape()),
+                  errors::InvalidArgument("Expected a scalar, saw shape: ",
+                                          t->shape().DebugString()));
+    }
+    const bool first_step = time.scalar<int32>()() == 0;
+    const int32 eos = end_token.scalar<int32>()();
+    const T penalty_weight = length_penalty_weight.scalar<T>()();
+    // At time 0 only the first beam is continued.
+    const int64 num_source_beams = first_step ? 1 : beam_width;
+    OP_REQUIRES(ctx, num_source_beams * vocab_size >= beam_width,
+                errors::InvalidArgument("Need at least beam_width (",
+                                        beam_width, ") continuations, got ",
+                                        num_source_beams * vocab_size));
+
+    Tensor* scores_t;
+    Tensor* predicted_ids_t;
+    Tensor* parent_ids_t;
+    Tensor* next_log_probs_t;
+    Tensor* next_lengths_t;
+    Tensor* next_finished_t;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, beams_shape, &scores_t));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(1, beams_shape, &predicted_ids_t));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(2, beams_shape, &parent_ids_t));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(3, beams_shape, &next_log_probs_t));
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(4, beams_shape, &next_lengths_t));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(5, beams_shape, &next_finished_t));
+    if (batch_size * beam_width == 0) return;
+
+    const auto logits_t = logits.tensor<T, 3>();
+    const auto log_probs_m = log_probs.matrix<T>();
+    const auto lengths_m = lengths.matrix<int32>();
+    const auto finished_m = finished.matrix<bool>();
+    auto scores = scores_t->matrix<T>();
+    auto predicted_ids = predicted_ids_t->matrix<int32>();
+    auto parent_ids = parent_ids_t->matrix<int32>();
+    auto next_log_probs = next_log_probs_t->matrix<T>();
+    auto next_lengths = next_lengths_t->matrix<int32>();
+    auto next_finished = next_finished_t->matrix<bool>();
+
+    // Returns the length penalty of https://arxiv.org/abs/1609.08144.
+    auto length_penalty = [penalty_weight](int32 length) -> T {
+      if (penalty_weight == T(0)) return T(1);
+      return std::pow((T(5) + length) / T(6), penalty_weight);
+    };
+
+    auto DoWork = [&](int64 start_batch, int64 limit_batch) {
+      // A min-heap of the best continuations found so far, worst on top.
+      std::vector<Candidate> heap;
+      heap.reserve(beam_width);
+      for (int64 batch = start_batch; batch < limit_batch; ++batch) {
+        heap.clear();
+        auto consider = [&heap, beam_width](const Candidate& candidate) {
+          if (static_cast<int64>(heap.size()) < beam_width) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), Better);
+          } else if (Better(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), Better);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), Better);
+          }
+        };
+        for (int64 beam = 0; beam < num_source_beams; ++beam) {
+          const T beam_log_prob = log_probs_m(batch, beam);
+          const int32 length = lengths_m(batch, beam);
+          const int64 offset = beam * vocab_size;
+          if (finished_m(batch, beam)) {
+            // A finished beam puts all its probability mass on end_token, and
+            // the lowest score on every other token.
+            const T lowest = Eigen::NumTraits<T>::lowest();
+            const T eos_score = beam_log_prob / length_penalty(length);
+            const T other_score =
+                (beam_log_prob + lowest) / length_penalty(length);
+            for (int64 word = 0; word < vocab_size; ++word) {
+              const bool is_eos = word == eos;
+              consider({is_eos ? eos_score : other_score,
+                        is_eos ? beam_log_prob : beam_log_prob + lowest,
+                        offset + word});
+            }
+            continue;
+          }
+          const T* beam_logits = &logits_t(batch, beam, 0);
+          T max_logit = beam_logits[0];
+          for (int64 word = 1; word < vocab_size; ++word) {
+            max_logit = std::max(max_logit, beam_logits[word]);
+          }
+          T sum_exp = 0;
+          for (int64 word = 0; word < vocab_size; ++word) {
+            sum_exp += std::exp(beam_logits[word] - max_logit);
+          }
+          const T log_normalizer = max_logit + std::log(sum_exp);
+          const T eos_penalty = length_penalty(length);
+          const T other_penalty = length_penalty(length + 1);
+          for (int64 word = 0; word < vocab_size; ++word) {
+            const T total_log_prob =
+                beam_log_prob + (beam_logits[word] - log_normalizer);
+            const T score =
+                total_log_prob / (word == eos ? eos_penalty : other_penalty);
+            consider({score, total_log_prob, offset + word});
+          }
+        }
+        std::sort_heap(heap.begin(), heap.end(), Better);
+        for (int64 k = 0; k < beam_width; ++k) {
+          const Candidate& candidate = heap[k];
+          const int32 parent = candidate.index / vocab_size;
+          const int32 word = candidate.index % vocab_size;
+          const bool is_finished = finished_m(batch, parent) || word == eos;
+          scores(batch, k) = candidate.score;
+          predicted_ids(batch, k) = word;
+          parent_ids(batch, k) = parent;
+          next_log_probs(batch, k) = candidate.log_prob;
+          next_finished(batch, k) = is_finished;
+          next_lengths(batch, k) =
+              lengths_m(batch, parent) + (is_finished ? 0 : 1);
+        }
+      }
+    };
+    // Guesstimate of cost: an exp and a few adds, compares and a division
+    // per continuation.
+    const int64 batch_cost =
+        num_source_beams * vocab_size *
+        (Eigen::TensorOpCost::DivCost<T>() +
+         10 * Eigen::TensorOpCost::AddCost<T>());
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          batch_cost, DoWork);
+  }
+
+ private:
+  struct Candidate {
+    T score;
+    T log_prob;
+    int64 index;
+  };
+
+  // Orders candidates by decreasing score, and by increasing index among
+  // equal scores, like top_k.
+  static bool Better(const Candidate& a, const Candidate& b) {
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+  }
+};
+
+#define REGISTER_KERNEL(T)                                              \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("BeamSearchStep").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      BeamSearchStepOp<T>);
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(double);
+#undef REGISTER_KERNEL
+
 #if GOOGLE_CUDA
 namespace functor {
 #define DECLARE_GPU_SPEC(T)                            \
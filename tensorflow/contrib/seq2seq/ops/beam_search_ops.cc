@@ -65,4 +65,65 @@ sequence_length: `[batch_size, beam_width]`.
 beams: `[max_time, batch_size, beam_width]`.
 )doc");
 
+REGISTER_OP("BeamSearchStep")
+    .Input("logits: T")
+    .Input("log_probs: T")
+    .Input("lengths: int32")
+    .Input("finished: bool")
+    .Input("time: int32")
+    .Input("end_token: int32")
+    .Input("length_penalty_weight: T")
+    .Output("scores: T")
+    .Output("predicted_ids: int32")
+    .Output("parent_ids: int32")
+    .Output("next_log_probs: T")
+    .Output("next_lengths: int32")
+    .Output("next_finished: bool")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle logits, beams, unused;
+
+      // logits is shaped [batch_size, beam_width, vocab_size], and the beam
+      // state and all outputs are shaped [batch_size, beam_width].
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &logits));
+      TF_RETURN_IF_ERROR(c->Subshape(logits, 0, 2, &beams));
+      for (int i = 1; i < 4; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 2, &unused));
+        TF_RETURN_IF_ERROR(c->Merge(beams, c->input(i), &beams));
+      }
+      for (int i = 4; i < 7; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+
+      for (int i = 0; i < 6; ++i) {
+        c->set_output(i, beams);
+      }
+      return tensorflow::Status::OK();
+    })
+    .Doc(R"doc(
+Performs one step of beam search decoding.
+
+Computes the log-softmax of the logits, masks the finished beams so that they
+can only continue with end_token, adds the log probabilities of the beams and
+selects the beam_width best continuations of each batch entry by their length
+penalized scores.  At time 0 all beams are assumed to be equal and only the
+continuations of the first beam are considered.
+
+logits: `[batch_size, beam_width, vocab_size]`.
+log_probs: `[batch_size, beam_width]`, the log probabilities of the beams.
+lengths: `[batch_size, beam_width]`, the lengths of the beams.
+finished: `[batch_size, beam_width]`, whether the beams are finished.
+time: Scalar, the decoding step.
+end_token: Scalar, the token that marks the end of decoding.
+length_penalty_weight: Scalar weight to penalize length. Disabled with 0.0.
+scores: `[batch_size, beam_width]`, the scores of the selected continuations,
+  best first.
+predicted_ids: `[batch_size, beam_width]`, the tokens of the continuations.
+parent_ids: `[batch_size, beam_width]`, the beams they continue.
+next_log_probs: `[batch_size, beam_width]`, the log probabilities of the new
+  beams.
+next_lengths: `[batch_size, beam_width]`, the lengths of the new beams.
+next_finished: `[batch_size, beam_width]`, whether the new beams are finished.
+)doc");
+
 }  // end namespace tensorflow
@@ -221,9 +221,69 @@ class TestBeamStep(test.TestCase):
     self.assertAllEqual(next_state_.log_probs, expected_log_probs)
 
 
+class TestFusedBeamStep(test.TestCase):
+  """Tests that the fused beam search step matches the unfused one."""
+
+  def _testMatchesUnfused(self, time, length_penalty_weight):
+    batch_size = 4
+    beam_width = 3
+    vocab_size = 7
+    end_token = 2
+    np.random.seed(time)
+    beam_state = beam_search_decoder.BeamSearchDecoderState(
+        cell_state=array_ops.zeros([batch_size, beam_width]),
+        log_probs=ops.convert_to_tensor(
+            -np.random.rand(batch_size, beam_width), dtype=dtypes.float32),
+        lengths=ops.convert_to_tensor(
+            np.random.randint(1, 5, size=[batch_size, beam_width]),
+            dtype=dtypes.int32),
+        finished=ops.convert_to_tensor(
+            np.random.rand(batch_size, beam_width) < 0.3))
+    logits = ops.convert_to_tensor(
+        np.random.randn(batch_size, beam_width, vocab_size),
+        dtype=dtypes.float32)
+
+    outputs, next_state = beam_search_decoder._beam_search_step(
+        time=time,
+        logits=logits,
+        beam_state=beam_state,
+        batch_size=ops.convert_to_tensor(batch_size),
+        beam_width=beam_width,
+        end_token=end_token,
+        length_penalty_weight=length_penalty_weight)
+    fused_outputs, fused_next_state = (
+        beam_search_decoder._fused_beam_search_step(
+            time=time,
+            logits=logits,
+            beam_state=beam_state,
+            end_token=end_token,
+            length_penalty_weight=length_penalty_weight))
+
+    with self.test_session() as sess:
+      outputs_, next_state_, fused_outputs_, fused_next_state_ = sess.run(
+          [outputs, next_state, fused_outputs, fused_next_state])
+
+    self.assertAllClose(outputs_.scores, fused_outputs_.scores)
+    self.assertAllEqual(outputs_.predicted_ids, fused_outputs_.predicted_ids)
+    self.assertAllEqual(outputs_.parent_ids, fused_outputs_.parent_ids)
+    self.assertAllClose(next_state_.log_probs, fused_next_state_.log_probs)
+    self.assertAllEqual(next_state_.lengths, fused_next_state_.lengths)
+    self.assertAllEqual(next_state_.finished, fused_next_state_.finished)
+
+  def testFirstStep(self):
+    self._testMatchesUnfused(time=0, length_penalty_weight=0.0)
+
+  def testLaterStep(self):
+    self._testMatchesUnfused(time=3, length_penalty_weight=0.0)
+
+  def testLengthPenalty(self):
+    self._testMatchesUnfused(time=2, length_penalty_weight=0.6)
+
+
 class BeamSearchDecoderTest(test.TestCase):
 
-  def _testDynamicDecodeRNN(self, time_major, has_attention):
+  def _testDynamicDecodeRNN(self, time_major, has_attention,
+                            fused_step=False):
     encoder_sequence_length = [3, 2, 3, 1, 0]
     decoder_sequence_length = [2, 0, 1, 2, 3]
     batch_size = 5
@@ -268,7 +328,8 @@ class BeamSearchDecoderTest(test.TestCase):
           initial_state=cell_state,
           beam_width=beam_width,
           output_layer=output_layer,
-          length_penalty_weight=0.0)
+          length_penalty_weight=0.0,
+          fused_step=fused_step)
 
       final_outputs, final_state, final_sequence_lengths = (
           decoder.dynamic_decode(
@@ -316,6 +377,10 @@ class BeamSearchDecoderTest(test.TestCase):
   def testDynamicDecodeRNNBatchMajorYesAttention(self):
     self._testDynamicDecodeRNN(time_major=False, has_attention=True)
 
+  def testDynamicDecodeRNNBatchMajorFusedStep(self):
+    self._testDynamicDecodeRNN(
+        time_major=False, has_attention=False, fused_step=True)
+
 
 if __name__ == '__main__':
   test.main()
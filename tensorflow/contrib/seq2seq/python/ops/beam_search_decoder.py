@@ -121,7 +121,8 @@ class BeamSearchDecoder(decoder.Decoder):
                initial_state,
                beam_width,
                output_layer=None,
-               length_penalty_weight=0.0):
+               length_penalty_weight=0.0,
+               fused_step=False):
     """Initialize BeamSearchDecoder.
 
     Args:
@@ -136,6 +137,8 @@ class BeamSearchDecoder(decoder.Decoder):
         `tf.layers.Dense`.  Optional layer to apply to the RNN output prior
         to storing the result or sampling.
       length_penalty_weight: Float weight to penalize length. Disabled with 0.0.
+      fused_step: Python bool.  If True, the beam search step after the cell
+        runs as a single `BeamSearchStep` op, which only has a CPU kernel.
 
     Raises:
       TypeError: if `cell` is not an instance of `RNNCell`,
@@ -170,6 +173,7 @@ class BeamSearchDecoder(decoder.Decoder):
     self._batch_size = array_ops.size(start_tokens)
     self._beam_width = beam_width
     self._length_penalty_weight = length_penalty_weight
+    self._fused_step = fused_step
     self._initial_cell_state = nest.map_structure(
         self._maybe_split_batch_beams,
         initial_state, self._cell.state_size)
@@ -427,14 +431,22 @@ class BeamSearchDecoder(decoder.Decoder):
       if self._output_layer is not None:
         cell_outputs = self._output_layer(cell_outputs)
 
-      beam_search_output, beam_search_state = _beam_search_step(
-          time=time,
-          logits=cell_outputs,
-          beam_state=state,
-          batch_size=batch_size,
-          beam_width=beam_width,
-          end_token=end_token,
-          length_penalty_weight=length_penalty_weight)
+      if self._fused_step:
+        beam_search_output, beam_search_state = _fused_beam_search_step(
+            time=time,
+            logits=cell_outputs,
+            beam_state=state,
+            end_token=end_token,
+            length_penalty_weight=length_penalty_weight)
+      else:
+        beam_search_output, beam_search_state = _beam_search_step(
+            time=time,
+            logits=cell_outputs,
+            beam_state=state,
+            batch_size=batch_size,
+            beam_width=beam_width,
+            end_token=end_token,
+            length_penalty_weight=length_penalty_weight)
       finished = beam_search_state.finished
       sample_ids = beam_search_output.predicted_ids
       next_inputs = control_flow_ops.cond(
@@ -557,6 +569,53 @@ def _beam_search_step(time, logits, beam_state, batch_size, beam_width,
   return output, next_state
 
 
+def _fused_beam_search_step(time, logits, beam_state, end_token,
+                            length_penalty_weight):
+  """Performs a single step of Beam Search Decoding in one op.
+
+  Computes the same outputs as `_beam_search_step`, with a single
+  `BeamSearchStep` op in place of the log-softmax, masking, top-k and gathers.
+
+  Args:
+    time: Beam search time step, should start at 0. At time 0 we assume
+      that all beams are equal and consider only the first beam for
+      continuations.
+    logits: Logits at the current time step. A tensor of shape
+      `[batch_size, beam_width, vocab_size]`
+    beam_state: Current state of the beam search.
+      An instance of `BeamSearchDecoderState`.
+    end_token: The int32 end token.
+    length_penalty_weight: Float weight to penalize length. Disabled with 0.0.
+
+  Returns:
+    A new beam state.
+  """
+  (scores, predicted_ids, parent_ids, next_log_probs, next_lengths,
+   next_finished) = beam_search_ops.beam_search_step(
+       logits=logits,
+       log_probs=beam_state.log_probs,
+       lengths=beam_state.lengths,
+       finished=beam_state.finished,
+       time=ops.convert_to_tensor(time, dtype=dtypes.int32, name="time"),
+       end_token=end_token,
+       length_penalty_weight=ops.convert_to_tensor(
+           length_penalty_weight, dtype=logits.dtype,
+           name="length_penalty_weight"))
+
+  next_state = BeamSearchDecoderState(
+      cell_state=beam_state.cell_state,
+      log_probs=next_log_probs,
+      lengths=next_lengths,
+      finished=next_finished)
+
+  output = BeamSearchDecoderOutput(
+      scores=scores,
+      predicted_ids=predicted_ids,
+      parent_ids=parent_ids)
+
+  return output, next_state
+
+
 def _get_scores(log_probs, sequence_lengths, length_penalty_weight):
   """Calculates scores for beam search hypotheses.
 
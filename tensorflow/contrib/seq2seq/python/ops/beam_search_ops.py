@@ -25,3 +25,4 @@ _beam_search_ops_so = loader.load_op_library(
     resource_loader.get_path_to_datafile("_beam_search_ops.so"))
 
 gather_tree = gen_beam_search_ops.gather_tree
+beam_search_step = gen_beam_search_ops.beam_search_step
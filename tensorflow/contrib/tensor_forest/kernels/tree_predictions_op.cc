@@ -15,6 +15,7 @@
 // TreePredictions returns the per-class probabilities for each input by
 // evaluating the given tree.
 #include <algorithm>
+#include <vector>
 
 #include "tensorflow/contrib/tensor_forest/kernels/data_spec.h"
 #include "tensorflow/contrib/tensor_forest/kernels/tree_utils.h"
@@ -41,10 +42,124 @@ using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
 namespace {
+// The number of examples that are moved down the tree together.
+const int32 kBlockSize = 64;
+
+// Decides which way examples go at the nodes of a tree.  The data spec is
+// looked up once per split node instead of on every visit, and the sparse
+// values of an example are found by a search over its own row only.
+class NodeDecider {
+ public:
+  NodeDecider(const Tensor& input_data, const Tensor& sparse_input_indices,
+              const Tensor& sparse_input_values, const Tensor& tree_tensor,
+              const tensorforest::TensorForestDataSpec& input_spec,
+              int32 num_data) {
+    if (input_data.shape().dims() == 2) {
+      dense_data_ = input_data.flat<float>().data();
+      dense_stride_ = input_data.shape().dim_size(1);
+    }
+    if (sparse_input_indices.shape().dims() == 2) {
+      sparse_indices_ = sparse_input_indices.flat<int64>().data();
+      sparse_stride_ = sparse_input_indices.shape().dim_size(1);
+      sparse_values_ = sparse_input_values.flat<float>().data();
+      // The indices are sorted, so the values of each example are in one
+      // contiguous range.
+      row_starts_.resize(num_data + 1, 0);
+      const int64 num_values = sparse_input_indices.shape().dim_size(0);
+      for (int64 k = 0; k < num_values; ++k) {
+        const int64 row =
+            internal::SubtleMustCopy(sparse_indices_[k * sparse_stride_]);
+        if (FastBoundsCheck(row, num_data)) {
+          ++row_starts_[row + 1];
+        }
+      }
+      for (int32 i = 0; i < num_data; ++i) {
+        row_starts_[i + 1] += row_starts_[i];
+      }
+    }
+
+    const auto tree = tree_tensor.tensor<int32, 2>();
+    const int32 num_nodes = static_cast<int32>(tree_tensor.dim_size(0));
+    features_.resize(num_nodes, 0);
+    sparse_.resize(num_nodes, false);
+    types_.resize(num_nodes, tensorforest::kDataFloat);
+    for (int32 node = 0; node < num_nodes; ++node) {
+      if (tree(node, CHILDREN_INDEX) < 0) continue;
+      const int32 feature = tree(node, FEATURE_INDEX);
+      if (feature < input_spec.dense_features_size()) {
+        features_[node] = feature;
+        types_[node] = tensorforest::FindDenseFeatureSpec(feature, input_spec);
+      } else {
+        features_[node] = feature - input_spec.dense_features_size();
+        sparse_[node] = true;
+        types_[node] =
+            tensorforest::FindSparseFeatureSpec(features_[node], input_spec);
+      }
+    }
+  }
+
+  // Returns true if example i goes to the right child of the split node.
+  bool Decide(int32 i, int32 node, float threshold) const {
+    const int32 feature = features_[node];
+    const float value =
+        sparse_[node] ? SparseValue(i, feature) : DenseValue(i, feature);
+    return tensorforest::Decide(value, threshold, types_[node]);
+  }
+
+ private:
+  float DenseValue(int32 i, int32 feature) const {
+    if (dense_data_ == nullptr) {
+      LOG(ERROR) << "trying to access nonexistent dense features.";
+      return 0;
+    }
+    return dense_data_[i * dense_stride_ + feature];
+  }
+
+  // Returns the j-th sparse feature of example i, or 0 if it isn't set.
+  float SparseValue(int32 i, int32 j) const {
+    if (sparse_indices_ == nullptr) {
+      LOG(ERROR) << "trying to access nonexistent sparse features.";
+      return 0;
+    }
+    int64 low = row_starts_[i];
+    int64 high = row_starts_[i + 1];
+    while (low < high) {
+      const int64 mid = (low + high) / 2;
+      const int64 midj =
+          internal::SubtleMustCopy(sparse_indices_[mid * sparse_stride_ + 1]);
+      if (midj == j) {
+        return sparse_values_[mid];
+      }
+      if (midj < j) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return 0;
+  }
+
+  const float* dense_data_ = nullptr;
+  int64 dense_stride_ = 0;
+  const int64* sparse_indices_ = nullptr;
+  int64 sparse_stride_ = 0;
+  const float* sparse_values_ = nullptr;
+  std::vector<int64> row_starts_;
+
+  // Per node, the column of the feature it splits on within the dense or
+  // sparse features, whether it is sparse, and its type.
+  std::vector<int32> features_;
+  std::vector<bool> sparse_;
+  std::vector<DataColumnTypes> types_;
+};
+
 // Traverse the tree for every example from start to end. Put the resulting
 // prediction probability into output_predictions[i].
-void Evaluate(OpKernelContext* context,
-              const std::function<bool(int, int32, float)>& decide,
+//
+// The examples are moved down the tree in blocks, one level at a time, so
+// that the traversals of a block are independent of each other and share
+// the nodes near the root while they are in the cache.
+void Evaluate(OpKernelContext* context, const NodeDecider& decider,
               const Tensor& weights, const Tensor& tree_tensor,
               const Tensor& tree_thresholds, int valid_leaf_threshold,
               Tensor* output_predictions, int32 start, int32 end) {
@@ -57,31 +172,48 @@ void Evaluate(OpKernelContext* context,
   const int32 num_classes = static_cast<int32>(weights.shape().dim_size(1));
   const int32 num_nodes = static_cast<int32>(tree_tensor.shape().dim_size(0));
 
-  for (int i = start; i < end; i++) {
-    int node_index = 0;
-    int parent = -1;
-    while (true) {
-      OP_REQUIRES(context, FastBoundsCheck(node_index, num_nodes),
-                  errors::InvalidArgument("node_index not in valid range."))
-      const int32 left_child = tree(node_index, CHILDREN_INDEX);
-      if (left_child == LEAF_NODE) {
-        const int32 flat_leaf_index = node_index * num_classes + 1;
-        const int32 flat_parent_index = parent * num_classes + 1;
-        std::vector<float> means(num_classes - 1);
-        tensorforest::GetParentWeightedMean(
-            node_pcw(node_index, 0), node_pcw.data() + flat_leaf_index,
-            node_pcw(parent, 0), node_pcw.data() + flat_parent_index,
-            valid_leaf_threshold, num_classes - 1, &means);
-        const int32 start_index = i * (num_classes - 1);
-        std::copy(means.begin(), means.end(), out.data() + start_index);
-        break;
-      } else if (left_child == FREE_NODE) {
-        LOG(ERROR) << "Reached a free node, not good.";
-        return;
+  std::vector<float> means(num_classes - 1);
+  int32 examples[kBlockSize];
+  int32 nodes[kBlockSize];
+  int32 parents[kBlockSize];
+  for (int32 block_start = start; block_start < end;
+       block_start += kBlockSize) {
+    int32 num_active = std::min(kBlockSize, end - block_start);
+    for (int32 k = 0; k < num_active; ++k) {
+      examples[k] = block_start + k;
+      nodes[k] = 0;
+      parents[k] = -1;
+    }
+    while (num_active > 0) {
+      int32 num_still_active = 0;
+      for (int32 k = 0; k < num_active; ++k) {
+        const int32 i = examples[k];
+        const int32 node_index = nodes[k];
+        OP_REQUIRES(context, FastBoundsCheck(node_index, num_nodes),
+                    errors::InvalidArgument("node_index not in valid range."))
+        const int32 left_child = tree(node_index, CHILDREN_INDEX);
+        if (left_child == LEAF_NODE) {
+          const int32 parent = parents[k];
+          const int32 flat_leaf_index = node_index * num_classes + 1;
+          const int32 flat_parent_index = parent * num_classes + 1;
+          tensorforest::GetParentWeightedMean(
+              node_pcw(node_index, 0), node_pcw.data() + flat_leaf_index,
+              node_pcw(parent, 0), node_pcw.data() + flat_parent_index,
+              valid_leaf_threshold, num_classes - 1, &means);
+          const int32 start_index = i * (num_classes - 1);
+          std::copy(means.begin(), means.end(), out.data() + start_index);
+          continue;
+        } else if (left_child == FREE_NODE) {
+          LOG(ERROR) << "Reached a free node, not good.";
+          return;
+        }
+        examples[num_still_active] = i;
+        parents[num_still_active] = node_index;
+        nodes[num_still_active] =
+            left_child + decider.Decide(i, node_index, thresholds(node_index));
+        ++num_still_active;
       }
-      parent = node_index;
-      const int32 feature = tree(node_index, FEATURE_INDEX);
-      node_index = left_child + decide(i, feature, thresholds(node_index));
+      num_active = num_still_active;
     }
   }
 }
@@ -189,28 +321,20 @@ class TreePredictions : public OpKernel {
                    context->allocate_output(0, output_shape,
                                             &output_predictions));
 
-    // Lambdas to capture the eigen-tensors so we don't the conversion overhead
-    // on each call to DecideNode.
-    const auto get_dense = tensorforest::GetDenseFunctor(input_data);
-    const auto get_sparse = tensorforest::GetSparseFunctor(sparse_input_indices,
-                                                           sparse_input_values);
-
-    auto decide = [&get_dense, &get_sparse, this](int example, int32 feature,
-                                                  float threshold) {
-      return tensorforest::DecideNode(get_dense, get_sparse, example, feature,
-                                      threshold, input_spec_);
-    };
+    const NodeDecider decider(input_data, sparse_input_indices,
+                              sparse_input_values, tree_tensor, input_spec_,
+                              num_data);
 
     auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
     int num_threads = worker_threads->num_threads;
 
     const int64 costPerUnit = 800;
-    auto work = [context, &decide, &node_per_class_weights, &tree_tensor,
+    auto work = [context, &decider, &node_per_class_weights, &tree_tensor,
                  &tree_thresholds, this, &output_predictions,
                  num_data](int64 start, int64 end) {
       CHECK(start <= end);
       CHECK(end <= num_data);
-      Evaluate(context, decide, node_per_class_weights, tree_tensor,
+      Evaluate(context, decider, node_per_class_weights, tree_tensor,
                tree_thresholds, valid_leaf_threshold_, output_predictions,
                static_cast<int32>(start), static_cast<int32>(end));
     };
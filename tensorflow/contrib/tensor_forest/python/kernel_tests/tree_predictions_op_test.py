@@ -96,6 +96,32 @@ class TreePredictionsDenseTest(test_util.TensorFlowTestCase):
       self.assertAllClose([[0.2, 0.4, 0.4], [0.2, 0.4, 0.4], [0.2, 0.8, 0.0],
                            [0.2, 0.8, 0.0]], predictions.eval())
 
+  def testManyExamples(self):
+    # Enough examples to fill several blocks, ending at different depths.
+    input_data = [[-1., 0.], [1., -2.], [1., 2.]] * 100
+
+    tree = [[1, 0], [-1, 0], [3, 1], [-1, 0], [-1, 0]]
+    tree_thresholds = [0., 0., 0., 0., 0.]
+    node_pcw = [[1.0, 0.3, 0.4, 0.3], [1.0, 0.1, 0.1, 0.8],
+                [1.0, 0.5, 0.25, 0.25], [1.0, 0.6, 0.2, 0.2],
+                [1.0, 0.0, 0.5, 0.5]]
+
+    with self.test_session():
+      predictions = tensor_forest_ops.tree_predictions(
+          input_data,
+          self.nothing,
+          self.nothing,
+          self.nothing,
+          tree,
+          tree_thresholds,
+          node_pcw,
+          input_spec=self.data_spec,
+          valid_leaf_threshold=1)
+
+      self.assertAllClose(
+          [[0.1, 0.1, 0.8], [0.6, 0.2, 0.2], [0.0, 0.5, 0.5]] * 100,
+          predictions.eval())
+
   def testNoInput(self):
     input_data = []
 
@@ -142,9 +142,11 @@ def print_model_analysis(graph,
               'micros' and 'bytes'.
     op_log: tensorflow::tfprof::OpLog proto. users can use this proto to
             group together ops and use a op_type to select the group.
-    tfprof_cmd: string. Either 'scope' or 'graph'. 'scope' view organize
-                ops using their name scopes. 'graph' view organize ops using
-                their graph inputs.
+    tfprof_cmd: string. Either 'scope', 'graph' or 'critical_path'. 'scope'
+                view organize ops using their name scopes. 'graph' view
+                organize ops using their graph inputs. 'critical_path' view
+                shows the ops on the critical path of the step in run_meta
+                and the idle time of each device.
     tfprof_options: See 'tfprof help' for details.
   Returns:
     TFProfNode proto. Side effect: a formatted output to stdout.
@@ -27,6 +27,8 @@ See @{$python/contrib.training} guide.
 @@bucket_by_sequence_length
 @@GreedyLoadBalancingStrategy
 @@byte_size_load_fn
+@@ConsistentHashStrategy
+@@propose_ps_placement
 @@FailureTolerator
 @@rejection_sample
 @@stratified_sample
@@ -19,6 +19,9 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import bisect
+import hashlib
+
 import numpy as np
 
 from tensorflow.python.framework import tensor_shape
@@ -105,3 +108,147 @@ def byte_size_load_fn(op):
     shape = tensor_shape.TensorShape(op.get_attr("shape"))
   shape.assert_is_fully_defined()
   return shape.num_elements() * elem_size
+
+
+def _stable_hash(key):
+  """Returns a hash of the string `key` that is the same in every process."""
+  return int(hashlib.md5(key.encode("utf-8")).hexdigest()[:16], 16)
+
+
+class _HashRing(object):
+  """A consistent hash ring with `virtual_nodes` points per task."""
+
+  def __init__(self, num_tasks, virtual_nodes):
+    if num_tasks <= 0:
+      raise ValueError("num_tasks must be positive, got %d" % num_tasks)
+    if virtual_nodes <= 0:
+      raise ValueError(
+          "virtual_nodes must be positive, got %d" % virtual_nodes)
+    points = sorted(
+        (_stable_hash("%d-%d" % (task, i)), task)
+        for task in range(num_tasks) for i in range(virtual_nodes))
+    self._hashes = [h for h, _ in points]
+    self._tasks = [task for _, task in points]
+
+  def tasks(self, name):
+    """Yields every task once, in ring order starting at `name`."""
+    start = bisect.bisect(self._hashes, _stable_hash(name))
+    seen = set()
+    for i in range(len(self._tasks)):
+      task = self._tasks[(start + i) % len(self._tasks)]
+      if task not in seen:
+        seen.add(task)
+        yield task
+
+
+class ConsistentHashStrategy(object):
+  """Places ps ops on the ps task that consistent hashing of their name picks.
+
+  Unlike round-robin placement, the task of an op depends only on its name
+  and the number of tasks, not on the order in which the ops are created,
+  and adding a ps task moves only about `1 / num_tasks` of the ops.  An op
+  named in `placement`, e.g. a hot variable shard that
+  `propose_ps_placement` moved away from its hashed task, is placed on the
+  task given there instead.
+
+  Since checkpoints refer to variables by name and not by device, a
+  variable is moved to another task by restoring a checkpoint into a graph
+  that is built with the new placement.
+
+  This class is intended to be used as a `ps_strategy` in
+  `tf.train.replica_device_setter`.
+  """
+
+  def __init__(self, num_tasks, placement=None, virtual_nodes=64):
+    """Create a new `ConsistentHashStrategy`.
+
+    Args:
+      num_tasks: Number of ps tasks to place ops on.
+      placement: Optional dictionary from op name to the ps task index of
+        that op, e.g. as returned by `propose_ps_placement`.
+      virtual_nodes: Number of points of each task on the hash ring.  More
+        points spread the ops more evenly.
+
+    Raises:
+      ValueError: if `num_tasks` or `virtual_nodes` is not positive, or a
+        task in `placement` is out of range.
+    """
+    self._ring = _HashRing(num_tasks, virtual_nodes)
+    self._placement = dict(placement or {})
+    for name, task in self._placement.items():
+      if not 0 <= task < num_tasks:
+        raise ValueError("Task %d of %s is not in [0, %d)" %
+                         (task, name, num_tasks))
+
+  def __call__(self, op):
+    """Choose a ps task index for the given `Operation`.
+
+    Args:
+      op: A `Operation` to be placed on ps.
+
+    Returns:
+      The ps task index of `op` in `placement` if any, and otherwise the
+      first task on the hash ring after the hash of its name.
+    """
+    task = self._placement.get(op.name)
+    if task is None:
+      task = next(self._ring.tasks(op.name))
+    return task
+
+
+def propose_ps_placement(loads, num_tasks, max_load_factor=1.25,
+                         virtual_nodes=64):
+  """Proposes ps tasks for ops with measured loads by consistent hashing.
+
+  Each op goes to its task on the hash ring of `ConsistentHashStrategy`,
+  unless that would load the task more than `max_load_factor` times the
+  average load, in which case it goes to the next task on the ring that has
+  room for it.  The ops are placed from the most to the least loaded, so
+  hot variable shards are spread over the tasks, and the ops that stay
+  where consistent hashing placed them stay there from one proposal to the
+  next.
+
+  The loads can for instance be the bytes that each variable sent and
+  received, which parameter servers report in their
+  `/tensorflow/core/rendezvous/sent_tensor_bytes` and
+  `/tensorflow/core/rendezvous/received_tensor_bytes` metrics, per
+  producing node, through the `GetMetrics` worker method.  There are no
+  units for load, but the loads must be consistent with each other.
+
+  Args:
+    loads: Dictionary from op name to the non-negative load of that op.
+    num_tasks: Number of ps tasks to place ops on.
+    max_load_factor: How much more than the average load a task may get.
+    virtual_nodes: Number of points of each task on the hash ring, which
+      must match the `ConsistentHashStrategy` that uses the result.
+
+  Returns:
+    A dictionary from op name to ps task index, to pass as the `placement`
+    of a `ConsistentHashStrategy`.  Only the ops whose task differs from the
+    one that consistent hashing picks are included.
+
+  Raises:
+    ValueError: if `num_tasks` or `virtual_nodes` is not positive,
+      `max_load_factor` is less than 1, or a load is negative.
+  """
+  if max_load_factor < 1:
+    raise ValueError(
+        "max_load_factor must be at least 1, got %f" % max_load_factor)
+  ring = _HashRing(num_tasks, virtual_nodes)
+  if any(load < 0 for load in loads.values()):
+    raise ValueError("Loads must be non-negative")
+  capacity = max_load_factor * sum(loads.values()) / num_tasks
+  task_loads = [0] * num_tasks
+  placement = {}
+  # Sorting by name as well makes the proposal deterministic.
+  for name, load in sorted(loads.items(),
+                           key=lambda item: (-item[1], item[0])):
+    tasks = list(ring.tasks(name))
+    task = next((t for t in tasks if task_loads[t] + load <= capacity),
+                None)
+    if task is None:
+      task = min(tasks, key=lambda t: task_loads[t])
+    task_loads[task] += load
+    if task != tasks[0]:
+      placement[name] = task
+  return placement
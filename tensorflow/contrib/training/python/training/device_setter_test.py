@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import collections
+
 from tensorflow.contrib.training.python.training import device_setter as device_setter_lib
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
@@ -93,5 +95,92 @@ class GreedyLoadBalancingStrategyTest(test.TestCase):
       self.assertDeviceEqual("/job:ps/task:0", u.initializer.device)
 
 
+# Stands in for the ops that a ps strategy places, of which it only uses the
+# name.
+_FakeOp = collections.namedtuple("_FakeOp", ["name"])
+
+
+class ConsistentHashStrategyTest(test.TestCase):
+  _cluster_spec = server_lib.ClusterSpec({
+      "ps": ["ps0:2222", "ps1:2222", "ps2:2222"],
+      "worker": ["worker0:2222"]
+  })
+
+  def _VariableTasks(self, names, ps_strategy):
+    """Returns the ps task of the variables created in the order of `names`."""
+    tasks = {}
+    with ops.Graph().as_default():
+      with ops.device(
+          device_setter.replica_device_setter(
+              cluster=self._cluster_spec, ps_strategy=ps_strategy)):
+        for name in names:
+          v = variables.Variable(array_ops.zeros([2, 2]), name=name)
+          tasks[name] = v.device
+    return tasks
+
+  def testPlacementDoesNotDependOnCreationOrder(self):
+    names = ["var%d" % i for i in range(20)]
+    tasks = self._VariableTasks(
+        names, device_setter_lib.ConsistentHashStrategy(3))
+    self.assertEqual(
+        tasks,
+        self._VariableTasks(
+            reversed(names), device_setter_lib.ConsistentHashStrategy(3)))
+    self.assertEqual(3, len(set(tasks.values())))
+
+  def testPlacementOverridesHash(self):
+    task = device_setter_lib.ConsistentHashStrategy(3)(_FakeOp("var"))
+    moved_task = (task + 1) % 3
+    tasks = self._VariableTasks(
+        ["var"],
+        device_setter_lib.ConsistentHashStrategy(3, {"var": moved_task}))
+    self.assertDeviceEqual("/job:ps/task:%d" % moved_task, tasks["var"])
+
+  def testAddingTaskMovesFewOps(self):
+    names = ["var%d" % i for i in range(300)]
+
+    def _Tasks(num_tasks):
+      strategy = device_setter_lib.ConsistentHashStrategy(num_tasks)
+      return [strategy(_FakeOp(name)) for name in names]
+
+    moved = sum(a != b for a, b in zip(_Tasks(3), _Tasks(4)))
+    # About a quarter of the ops move to the new task, and no others.
+    self.assertLess(moved, 0.4 * len(names))
+    self.assertTrue(all(b == 3 for a, b in zip(_Tasks(3), _Tasks(4))
+                        if a != b))
+
+  def testInvalidPlacement(self):
+    with self.assertRaises(ValueError):
+      device_setter_lib.ConsistentHashStrategy(2, {"var": 2})
+
+
+class ProposePsPlacementTest(test.TestCase):
+
+  def testSpreadsHotShards(self):
+    loads = {"emb/part_%d" % i: 100 for i in range(4)}
+    loads.update({"var%d" % i: 1 for i in range(40)})
+    placement = device_setter_lib.propose_ps_placement(loads, 4)
+    strategy = device_setter_lib.ConsistentHashStrategy(4, placement)
+    task_loads = [0] * 4
+    for name, load in loads.items():
+      task_loads[strategy(_FakeOp(name))] += load
+    self.assertLessEqual(max(task_loads), 1.25 * sum(loads.values()) / 4)
+
+  def testUniformLoadsKeepHashedTasks(self):
+    loads = {"var%d" % i: 1 for i in range(4)}
+    self.assertEqual(
+        {},
+        device_setter_lib.propose_ps_placement(
+            loads, 1, max_load_factor=1.0))
+
+  def testInvalidArguments(self):
+    with self.assertRaises(ValueError):
+      device_setter_lib.propose_ps_placement({"var": 1}, 0)
+    with self.assertRaises(ValueError):
+      device_setter_lib.propose_ps_placement({"var": 1}, 2, 0.5)
+    with self.assertRaises(ValueError):
+      device_setter_lib.propose_ps_placement({"var": -1}, 2)
+
+
 if __name__ == "__main__":
   test.main()
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/immutable_constant_op.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 namespace tensorflow {
@@ -134,16 +135,23 @@ class NodeConverter {
 Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes) {
-  Env* default_env = Env::Default();
   GraphDef graph_def;
   const auto load_graph_status =
-      ReadBinaryProto(default_env, in_graph_filename, &graph_def);
+      ReadBinaryProto(Env::Default(), in_graph_filename, &graph_def);
   if (!load_graph_status.ok()) {
     return tensorflow::errors::NotFound("Failed to load graph at '",
                                         in_graph_filename, "' : ",
                                         load_graph_status.error_message());
   }
+  return ConvertGraphDefConstantsToImmutable(graph_def, out_graph_filename,
+                                             min_conversion_size_bytes);
+}
 
+Status ConvertGraphDefConstantsToImmutable(const GraphDef& input_graph_def,
+                                           const string& out_graph_filename,
+                                           int min_conversion_size_bytes) {
+  Env* default_env = Env::Default();
+  GraphDef graph_def = input_graph_def;
   NodeConverter node_converter;
 
   // Create output writer.
@@ -169,4 +177,29 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
   return Status::OK();
 }
 
+Status LoadMemmappedModel(Env* env, const string& package_filename,
+                          std::unique_ptr<MemmappedEnv>* memmapped_env,
+                          std::unique_ptr<Session>* session) {
+  memmapped_env->reset(new MemmappedEnv(env));
+  TF_RETURN_IF_ERROR((*memmapped_env)->InitializeFromFile(package_filename));
+
+  GraphDef graph_def;
+  TF_RETURN_IF_ERROR(
+      ReadBinaryProto(memmapped_env->get(),
+                      MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+                      &graph_def));
+
+  SessionOptions options;
+  // Constant folding would copy the mapped weights into new constants, so
+  // it's turned off to keep them in the file.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  options.env = memmapped_env->get();
+  Session* session_pointer = nullptr;
+  TF_RETURN_IF_ERROR(NewSession(options, &session_pointer));
+  session->reset(session_pointer);
+  return (*session)->Create(graph_def);
+}
+
 }  // namespace tensorflow
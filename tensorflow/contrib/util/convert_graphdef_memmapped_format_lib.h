@@ -16,9 +16,13 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
 
+#include <memory>
 #include <string>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
 
 namespace tensorflow {
 
@@ -29,6 +33,21 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes);
 
+// Same as above, for a graph that is already in memory, such as the output of
+// the graph transforms.
+Status ConvertGraphDefConstantsToImmutable(const GraphDef& graph_def,
+                                           const string& out_graph_filename,
+                                           int min_conversion_size_bytes);
+
+// Maps the file 'package_filename' written by the functions above into
+// 'memmapped_env', and creates 'session' running its graph. The weights of the
+// ImmutableConst ops are read straight from the mapped file, so they are
+// neither parsed nor copied at load time. 'memmapped_env' must outlive
+// 'session'.
+Status LoadMemmappedModel(Env* env, const string& package_filename,
+                          std::unique_ptr<MemmappedEnv>* memmapped_env,
+                          std::unique_ptr<Session>* session);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
@@ -89,6 +89,42 @@ TEST(ConvertGraphdefMemmappedFormatTest, ConvertModel) {
   EXPECT_EQ(outputs.front().flat<float>()(2), 2.0f * 3.0f * kTensorHeight);
 }
 
+TEST(ConvertGraphdefMemmappedFormatTest, ConvertAndLoadGraphDef) {
+  constexpr int kTensorWidth = 4000;
+  constexpr int kTensorHeight = 100;
+  Tensor test_tensor1(DT_FLOAT, TensorShape({kTensorWidth, kTensorHeight}));
+  test::FillFn<float>(&test_tensor1, [](int) -> float { return 2.0; });
+  Tensor test_tensor2(DT_FLOAT, TensorShape({kTensorHeight, kTensorWidth}));
+  test::FillFn<float>(&test_tensor2, [](int) -> float { return 3.0; });
+
+  auto root = Scope::NewRootScope().ExitOnError();
+  Output m = ops::MatMul(root, test_tensor1, test_tensor2);
+  const string result_name = m.node()->name();
+  GraphDef graph_def;
+  TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+
+  const string filename_mmap =
+      io::JoinPath(testing::TmpDir(), "in_memory_graphdef.mmap");
+  TF_ASSERT_OK(
+      ConvertGraphDefConstantsToImmutable(graph_def, filename_mmap, 10000));
+
+  std::unique_ptr<MemmappedEnv> memmapped_env;
+  std::unique_ptr<Session> session;
+  TF_ASSERT_OK(LoadMemmappedModel(Env::Default(), filename_mmap,
+                                  &memmapped_env, &session));
+  GraphDef loaded_graph_def;
+  TF_ASSERT_OK(ReadBinaryProto(
+      memmapped_env.get(),
+      MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+      &loaded_graph_def));
+  ASSERT_TRUE(GraphHasImmutableConstNodes(loaded_graph_def));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {result_name + ":0"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs.front().flat<float>()(0), 2.0f * 3.0f * kTensorHeight);
+}
+
 TEST(ConvertGraphdefMemmappedFormatTest, NotSupportedTypesConvert) {
   // Create a graph with strings.
   const string dir = testing::TmpDir();
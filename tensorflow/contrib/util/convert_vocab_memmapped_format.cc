@@ -0,0 +1,117 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Utility that precompiles a vocabulary text file, as read by the
+// InitializeTableFromTextFile op, into a lookup table that MemmappedHashTable
+// serves directly from a memory-mapped file.
+//
+//  tensorflow/contrib/util/convert_vocab_memmapped_format
+//        --in_vocab=vocab.txt --out_table=vocab.mmtable
+//
+// Parameters:
+// in_vocab - name of the vocabulary text file.
+// out_table - name of the output file, where the table in memmapped format
+// will be saved.
+// key_dtype, value_dtype - the types of the keys and values of the table,
+// int64 or string.
+// key_index, value_index - where to extract the key and value from each line:
+// -2 for the whole line, -1 for the line number, or the index of a field of
+// the line split by delimiter.
+// delimiter - the delimiter of the fields of a line.
+// vocab_size - the number of lines to read, or -1 for all lines.
+
+#include <vector>
+
+#include "tensorflow/contrib/util/convert_vocab_memmapped_format_lib.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+int ParseFlagsAndConvertVocab(int argc, char* argv[]) {
+  string in_vocab = "";
+  string out_table = "";
+  string key_dtype_name = "string";
+  string value_dtype_name = "int64";
+  int32 key_index = -2;
+  int32 value_index = -1;
+  string delimiter = "\t";
+  int64 vocab_size = -1;
+  std::vector<Flag> flag_list = {
+      Flag("in_vocab", &in_vocab, "input vocabulary text file"),
+      Flag("out_table", &out_table, "output table"),
+      Flag("key_dtype", &key_dtype_name, "type of the keys, int64 or string"),
+      Flag("value_dtype", &value_dtype_name,
+           "type of the values, int64 or string"),
+      Flag("key_index", &key_index,
+           "field of a line to take the key from, -2 for the whole line and "
+           "-1 for the line number"),
+      Flag("value_index", &value_index,
+           "field of a line to take the value from, -2 for the whole line and "
+           "-1 for the line number"),
+      Flag("delimiter", &delimiter, "delimiter of the fields of a line"),
+      Flag("vocab_size", &vocab_size,
+           "number of lines to read, or -1 for all lines"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(usage.c_str(), &argc, &argv);
+  if (!parse_result) {
+    LOG(ERROR) << "\n" << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+  if (in_vocab.empty()) {
+    LOG(ERROR) << "in_vocab can't be empty";
+    return -1;
+  }
+  if (out_table.empty()) {
+    LOG(ERROR) << "out_table can't be empty";
+    return -1;
+  }
+  DataType key_dtype;
+  DataType value_dtype;
+  if (!DataTypeFromString(key_dtype_name, &key_dtype) ||
+      !DataTypeFromString(value_dtype_name, &value_dtype)) {
+    LOG(ERROR) << "key_dtype and value_dtype must be int64 or string";
+    return -1;
+  }
+  if (delimiter.size() != 1) {
+    LOG(ERROR) << "delimiter must be a single character";
+    return -1;
+  }
+  const auto result = ConvertVocabToMemmappedFormat(
+      in_vocab, out_table, key_dtype, value_dtype, key_index, value_index,
+      delimiter[0], vocab_size);
+  if (!result.ok()) {
+    LOG(ERROR) << "Conversion failed " << result.error_message();
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::ParseFlagsAndConvertVocab(argc, argv);
+}
@@ -0,0 +1,128 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/convert_vocab_memmapped_format_lib.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/lookup_table_init_op.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/memmapped_lookup_table.h"
+
+namespace tensorflow {
+namespace {
+
+// An InitializableLookupTable that only collects the keys and values it is
+// initialized with, in order.
+class CollectingTable : public lookup::InitializableLookupTable {
+ public:
+  CollectingTable(DataType key_dtype, DataType value_dtype)
+      : key_dtype_(key_dtype), value_dtype_(value_dtype) {}
+
+  size_t size() const override { return num_elements_; }
+
+  DataType key_dtype() const override { return key_dtype_; }
+
+  DataType value_dtype() const override { return value_dtype_; }
+
+  // Returns the collected keys and values as vectors.
+  void GetKeysAndValues(Tensor* keys, Tensor* values) const {
+    *keys = Concatenate(key_dtype_, keys_);
+    *values = Concatenate(value_dtype_, values_);
+  }
+
+ protected:
+  Status DoPrepare(size_t expected_num_elements) override {
+    keys_.reserve(expected_num_elements);
+    values_.reserve(expected_num_elements);
+    return Status::OK();
+  }
+
+  Status DoInsert(const Tensor& keys, const Tensor& values) override {
+    // The iterator reuses the buffers of keys and values for the next lines.
+    keys_.push_back(tensor::DeepCopy(keys));
+    values_.push_back(tensor::DeepCopy(values));
+    num_elements_ += keys.NumElements();
+    return Status::OK();
+  }
+
+  Status DoFind(const Tensor& keys, Tensor* values,
+                const Tensor& default_value) override {
+    return errors::Unimplemented("CollectingTable does not support Find");
+  }
+
+ private:
+  template <typename T>
+  static void CopyElements(const std::vector<Tensor>& batches, Tensor* out) {
+    auto flat = out->flat<T>();
+    int64 i = 0;
+    for (const Tensor& batch : batches) {
+      const auto batch_flat = batch.flat<T>();
+      for (int64 j = 0; j < batch_flat.size(); ++j) {
+        flat(i++) = batch_flat(j);
+      }
+    }
+  }
+
+  Tensor Concatenate(DataType dtype, const std::vector<Tensor>& batches) const {
+    Tensor out(dtype, TensorShape({num_elements_}));
+    if (dtype == DT_INT64) {
+      CopyElements<int64>(batches, &out);
+    } else {
+      CopyElements<string>(batches, &out);
+    }
+    return out;
+  }
+
+  const DataType key_dtype_;
+  const DataType value_dtype_;
+  std::vector<Tensor> keys_;
+  std::vector<Tensor> values_;
+  int64 num_elements_ = 0;
+};
+
+}  // namespace
+
+Status ConvertVocabToMemmappedFormat(const string& in_vocab_filename,
+                                     const string& out_table_filename,
+                                     DataType key_dtype, DataType value_dtype,
+                                     int32 key_index, int32 value_index,
+                                     char delimiter, int64 vocab_size) {
+  for (DataType dtype : {key_dtype, value_dtype}) {
+    if (dtype != DT_INT64 && dtype != DT_STRING) {
+      return errors::InvalidArgument(
+          "Keys and values must be int64 or string, got ",
+          DataTypeString(dtype));
+    }
+  }
+  CollectingTable* table = new CollectingTable(key_dtype, value_dtype);
+  core::ScopedUnref unref_table(table);
+  TF_RETURN_IF_ERROR(lookup::InitializeTableFromTextFile(
+      in_vocab_filename, vocab_size, delimiter, key_index, value_index,
+      Env::Default(), table));
+  Tensor keys;
+  Tensor values;
+  table->GetKeysAndValues(&keys, &values);
+  return WriteMemmappedLookupTable(Env::Default(), out_table_filename, keys,
+                                   values);
+}
+
+}  // namespace tensorflow
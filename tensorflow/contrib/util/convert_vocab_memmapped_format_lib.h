@@ -0,0 +1,38 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_VOCAB_MEMMAPPED_FORMAT_LIB_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_VOCAB_MEMMAPPED_FORMAT_LIB_H_
+
+#include <string>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Converts a vocabulary text file into a lookup table that MemmappedHashTable
+// serves from a memory-mapped file.  The key and value of each line are
+// extracted as by the InitializeTableFromTextFile op, given key_index,
+// value_index, delimiter and vocab_size.
+Status ConvertVocabToMemmappedFormat(const string& in_vocab_filename,
+                                     const string& out_table_filename,
+                                     DataType key_dtype, DataType value_dtype,
+                                     int32 key_index, int32 value_index,
+                                     char delimiter, int64 vocab_size);
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_VOCAB_MEMMAPPED_FORMAT_LIB_H_
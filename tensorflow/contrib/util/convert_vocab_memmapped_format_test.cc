@@ -0,0 +1,69 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/convert_vocab_memmapped_format_lib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/memmapped_lookup_table.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ConvertVocabMemmappedFormatTest, WordsToIds) {
+  const string dir = testing::TmpDir();
+  const string vocab = io::JoinPath(dir, "vocab.txt");
+  const string out = io::JoinPath(dir, "vocab.mmtable");
+  TF_ASSERT_OK(
+      WriteStringToFile(Env::Default(), vocab, "brain\nsalad\nsurgery\n"));
+  TF_ASSERT_OK(ConvertVocabToMemmappedFormat(vocab, out, DT_STRING, DT_INT64,
+                                             -2, -1, '\t', -1));
+
+  std::unique_ptr<MemmappedLookupTable> table;
+  TF_ASSERT_OK(MemmappedLookupTable::Open(Env::Default(), out, &table));
+  ASSERT_EQ(3, table->size());
+  EXPECT_EQ(0, table->int64_value(table->Find(StringPiece("brain"))));
+  EXPECT_EQ(1, table->int64_value(table->Find(StringPiece("salad"))));
+  EXPECT_EQ(2, table->int64_value(table->Find(StringPiece("surgery"))));
+  EXPECT_EQ(-1, table->Find(StringPiece("tank")));
+}
+
+TEST(ConvertVocabMemmappedFormatTest, IdsToFields) {
+  const string dir = testing::TmpDir();
+  const string vocab = io::JoinPath(dir, "fields.txt");
+  const string out = io::JoinPath(dir, "fields.mmtable");
+  TF_ASSERT_OK(
+      WriteStringToFile(Env::Default(), vocab, "7,seven\n3,three\n5,five\n"));
+  TF_ASSERT_OK(ConvertVocabToMemmappedFormat(vocab, out, DT_INT64, DT_STRING,
+                                             0, 1, ',', -1));
+
+  std::unique_ptr<MemmappedLookupTable> table;
+  TF_ASSERT_OK(MemmappedLookupTable::Open(Env::Default(), out, &table));
+  ASSERT_EQ(3, table->size());
+  EXPECT_EQ("seven", table->string_value(table->Find(7)));
+  EXPECT_EQ("three", table->string_value(table->Find(3)));
+  EXPECT_EQ("five", table->string_value(table->Find(5)));
+}
+
+TEST(ConvertVocabMemmappedFormatTest, UnsupportedType) {
+  const string dir = testing::TmpDir();
+  EXPECT_TRUE(errors::IsInvalidArgument(ConvertVocabToMemmappedFormat(
+      io::JoinPath(dir, "vocab.txt"), io::JoinPath(dir, "float.mmtable"),
+      DT_STRING, DT_FLOAT, -2, -1, '\t', -1)));
+}
+
+}  // namespace
+}  // namespace tensorflow
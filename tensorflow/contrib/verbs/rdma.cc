@@ -16,11 +16,13 @@ limitations under the License.
 #ifdef TENSORFLOW_USE_VERBS
 
 #include "tensorflow/contrib/verbs/rdma.h"
+#include <algorithm>
 #include <cstdlib>
 #include "tensorflow/contrib/verbs/verbs_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
+#include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
 #include "tensorflow/core/framework/rendezvous.h"
@@ -83,6 +85,128 @@ ibv_pd* alloc_protection_domain(ibv_context* context) {
   return pd;
 }
 
+namespace {
+bool AddrLessThanRegion(const void* addr, const ibv_mr* mr) {
+  return addr < mr->addr;
+}
+}  // namespace
+
+RdmaMemoryMgr& RdmaMemoryMgr::Singleton() {
+  static RdmaMemoryMgr* instance = new RdmaMemoryMgr;
+  return *instance;
+}
+
+void RdmaMemoryMgr::InstallHostAllocatorVisitors() {
+  {
+    mutex_lock lock{mu_};
+    if (host_visitors_installed_) return;
+    host_visitors_installed_ = true;
+  }
+  ProcessState::AllocVisitor alloc_visitor = [this](void* ptr, size_t size) {
+    InsertMemoryRegion(ptr, size);
+  };
+  ProcessState::AllocVisitor free_visitor = [this](void* ptr, size_t size) {
+    EvictMemoryRegion(ptr, size);
+  };
+  ProcessState* ps = ProcessState::singleton();
+  ps->AddCPUAllocVisitor(alloc_visitor);
+  ps->AddCPUFreeVisitor(free_visitor);
+  ps->AddCUDAHostAllocVisitor(0, alloc_visitor);
+}
+
+void RdmaMemoryMgr::InstallGPUAllocatorVisitors(const DeviceMgr* device_mgr) {
+  {
+    mutex_lock lock{mu_};
+    if (gpu_visitors_installed_) return;
+    gpu_visitors_installed_ = true;
+  }
+  std::vector<int> bus_ids;
+  for (const Device* device : device_mgr->ListDevices()) {
+    if (device->tensorflow_gpu_device_info() == nullptr) continue;
+    const int bus_id = device->attributes().locality().bus_id();
+    if (std::find(bus_ids.begin(), bus_ids.end(), bus_id) == bus_ids.end()) {
+      bus_ids.push_back(bus_id);
+    }
+  }
+  for (int bus_id : bus_ids) {
+    ProcessState::singleton()->AddGPUAllocVisitor(
+        bus_id, [this](void* ptr, size_t size) {
+          InsertMemoryRegion(ptr, size);
+        });
+  }
+}
+
+void RdmaMemoryMgr::SetProtectionDomain(ibv_pd* pd) {
+  mutex_lock lock{mu_};
+  if (pd_ != nullptr) {
+    LOG(WARNING) << "Memory regions are already registered with another "
+                 << "protection domain; tensors will be copied before "
+                 << "being sent";
+    return;
+  }
+  pd_ = pd;
+  for (const auto& region : pending_) {
+    RegisterLocked(region.first, region.second);
+  }
+  pending_.clear();
+}
+
+void RdmaMemoryMgr::InsertMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  mutex_lock lock{mu_};
+  if (pd_ == nullptr) {
+    pending_.emplace_back(addr, length);
+  } else {
+    RegisterLocked(addr, length);
+  }
+}
+
+void RdmaMemoryMgr::RegisterLocked(void* addr, size_t length) {
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr,
+                               AddrLessThanRegion);
+  if (iter != mrs_.begin() && (*(iter - 1))->addr == addr) {
+    // Reported by more than one visitor.
+    return;
+  }
+  ibv_mr* mr = ibv_reg_mr(pd_, addr, length,
+                          IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+  if (mr == nullptr) {
+    // E.g. device memory without GPUDirect support in the driver.
+    LOG(WARNING) << "Failed to register memory region of " << length
+                 << " bytes at " << addr
+                 << "; tensors in it will be copied before being sent";
+    return;
+  }
+  mrs_.insert(iter, mr);
+}
+
+void RdmaMemoryMgr::EvictMemoryRegion(void* addr, size_t length) {
+  mutex_lock lock{mu_};
+  pending_.erase(
+      std::remove(pending_.begin(), pending_.end(),
+                  std::pair<void*, size_t>(addr, length)),
+      pending_.end());
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr,
+                               AddrLessThanRegion);
+  if (iter != mrs_.begin() && (*(iter - 1))->addr == addr) {
+    --iter;
+    CHECK(!ibv_dereg_mr(*iter)) << "ibv_dereg_mr failed";
+    mrs_.erase(iter);
+  }
+}
+
+ibv_mr* RdmaMemoryMgr::FindMemoryRegion(ibv_pd* pd, const void* addr,
+                                        size_t length) {
+  mutex_lock lock{mu_};
+  if (pd != pd_) return nullptr;
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr,
+                               AddrLessThanRegion);
+  if (iter == mrs_.begin()) return nullptr;
+  ibv_mr* mr = *(iter - 1);
+  const char* end = static_cast<const char*>(mr->addr) + mr->length;
+  return static_cast<const char*>(addr) + length <= end ? mr : nullptr;
+}
+
 RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
     : context_(open_default_device()),
       pd_(alloc_protection_domain(context_)),
@@ -93,6 +217,7 @@ RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
                       0);
   CHECK(cq_) << "Failed to create completion queue";
   CHECK(!ibv_req_notify_cq(cq_, 0)) << "Failed to request CQ notification";
+  RdmaMemoryMgr::Singleton().SetProtectionDomain(pd_);
   polling_thread_.reset(Env::Default()->StartThread(
       ThreadOptions(), "RdmaAdapterCQThread", [this] { Process_CQ(); }));
   VLOG(2) << "Start RdmaAdapter: " << name();
@@ -218,6 +343,7 @@ void RdmaAdapter::Process_CQ() {
         }
       } else if (wc_[i].opcode == IBV_WC_RDMA_WRITE) {
         RdmaBuffer* rb = reinterpret_cast<RdmaBuffer*>(wc_[i].wr_id);
+        rb->ReleaseWriteSource();
         rb->SetBufferStatus(local, idle);
         RdmaMessage rm;
         RdmaMessage::ParseMessage(rm, rb->buffer_);
@@ -241,7 +367,8 @@ RdmaChannel::RdmaChannel(const RdmaAdapter* adapter, const string local_name,
     attr.recv_cq = adapter_->cq_;
     attr.cap.max_send_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
     attr.cap.max_recv_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
-    attr.cap.max_send_sge = 1;
+    // A tensor write gathers the message header and the tensor content.
+    attr.cap.max_send_sge = 2;
     attr.cap.max_recv_sge = 1;
     attr.qp_type = IBV_QPT_RC;
 
@@ -587,18 +714,27 @@ void RdmaBuffer::EnqueueItem(string item) {
   queue_.push(item);
 }
 
-// Rdma-Write the content of the buffer
-void RdmaBuffer::Write(uint32_t imm_data, size_t buffer_size) {
-  struct ibv_sge list;
-  list.addr = (uint64_t)buffer_;
-  list.length = buffer_size;
-  list.lkey = self_->lkey;
+// Rdma-Write the content of the buffer, and the payload if there is one.
+void RdmaBuffer::Write(uint32_t imm_data, size_t buffer_size,
+                       const void* payload, size_t payload_size,
+                       const ibv_mr* payload_mr) {
+  struct ibv_sge list[2];
+  list[0].addr = (uint64_t)buffer_;
+  list[0].length = buffer_size;
+  list[0].lkey = self_->lkey;
+  int num_sge = 1;
+  if (payload_size > 0) {
+    list[1].addr = (uint64_t)payload;
+    list[1].length = payload_size;
+    list[1].lkey = payload_mr->lkey;
+    num_sge = 2;
+  }
 
   struct ibv_send_wr wr;
   memset(&wr, 0, sizeof(wr));
   wr.wr_id = (uint64_t)this;
-  wr.sg_list = &list;
-  wr.num_sge = 1;
+  wr.sg_list = list;
+  wr.num_sge = num_sge;
   wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
   wr.send_flags = IBV_SEND_SIGNALED;
   wr.imm_data = imm_data;
@@ -649,6 +785,40 @@ void RdmaMessageBuffer::SendNextItem() {
   }
 }
 
+// Find the tensor whose memory a raw tensor write reads from.
+// GPU tensors are written straight from device memory when it is
+// registered (GPUDirect RDMA), and copied to CUDA host memory otherwise;
+// other tensors are written from their own memory.
+// Args:
+//   in: the tensor to be sent
+//   src_dev: the device "in" is on
+//   send_args: the arguments "in" was sent with
+//   on_gpu: whether "in" is in GPU memory
+//   src: the tensor to write from
+// Returns:
+//   status of the copy to host memory, if one is needed
+Status RdmaTensorBuffer::PrepareRawWriteSource(
+    const Tensor& in, Device* src_dev, const Rendezvous::Args& send_args,
+    bool on_gpu, Tensor* src) {
+  if (!on_gpu) {
+    *src = in;
+    return Status::OK();
+  }
+  if (RdmaMemoryMgr::Singleton().FindMemoryRegion(
+          channel_->adapter_->pd_, DMAHelper::base(&in), in.TotalBytes())) {
+    // The kernels that produced "in" may still be running.
+    *src = in;
+    return GPUUtil::Sync(src_dev);
+  }
+  AllocatorAttributes host_alloc_attr;
+  host_alloc_attr.set_on_host(true);
+  host_alloc_attr.set_gpu_compatible(true);
+  *src = Tensor(src_dev->GetAllocator(host_alloc_attr), in.dtype(),
+                in.shape());
+  return VerbsUtil::CopyGPUTensorToCPUSync(src_dev, send_args.device_context,
+                                           &in, src);
+}
+
 // Send the next tensor from the buffer's job queue.
 void RdmaTensorBuffer::SendNextItem() {
   // get the key
@@ -691,16 +861,15 @@ void RdmaTensorBuffer::SendNextItem() {
           << src_dev->attributes().incarnation()
           << ". Your worker job was probably restarted. Check your "
           << "worker job for the reason why it was restarted.";
-      Device* dst_dev = nullptr;
-      // destination is on CPU.
-      s = channel_->adapter_->worker_env_->device_mgr->LookupDevice("CPU:0",
-                                                                    &dst_dev);
-      CHECK(s.ok()) << "dst device not found";
-      AllocatorAttributes dst_alloc_attr;
-      dst_alloc_attr.set_on_host(true);
-      // string tensor needs to be serialized
-      if (src_dev->tensorflow_gpu_device_info() &&
-          (!send_args.alloc_attrs.on_host())) {
+      const bool on_gpu = src_dev->tensorflow_gpu_device_info() &&
+                          (!send_args.alloc_attrs.on_host());
+      // Tensors whose content is a flat array are written as is, from
+      // their own memory when it is registered; only string tensors need
+      // to be serialized.
+      const bool raw = DataTypeCanUseMemcpy(in.dtype());
+      if (raw) {
+        tensor_bytes = in.TotalBytes();
+      } else if (on_gpu) {
         CHECK(send_args.device_context)
             << "send dev name: " << src_dev->name()
             << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
@@ -712,7 +881,9 @@ void RdmaTensorBuffer::SendNextItem() {
         // tensor is in CPU memory.
         in.AsProtoTensorContent(&proto);
       }
-      tensor_bytes = proto.ByteSize();
+      if (!raw) {
+        tensor_bytes = proto.ByteSize();
+      }
       // maybe some margin for string tensor?
       buffer_size += tensor_bytes;
       // prepare message
@@ -760,17 +931,36 @@ void RdmaTensorBuffer::SendNextItem() {
         rm.type_ = RDMA_MESSAGE_TENSOR_WRITE;
         string message = RdmaMessage::CreateMessage(rm);
         memcpy(buffer_, message.data(), message.size());
-        if (!is_dead) {
-          // copy the tensor buffer content
-          void* output =
-              static_cast<void*>(static_cast<char*>(buffer_) +
-                                 RdmaMessage::kTensorBufferStartIndex);
-          CHECK(tensor_bytes + RdmaMessage::kTensorBufferStartIndex <= size_);
-          proto.SerializeToArray(output, tensor_bytes);
+        CHECK(tensor_bytes + RdmaMessage::kTensorBufferStartIndex <= size_);
+        void* output = static_cast<void*>(static_cast<char*>(buffer_) +
+                                          RdmaMessage::kTensorBufferStartIndex);
+        if (is_dead) {
+          Write(imm_data, RdmaMessage::kMessageTotalBytes);
+        } else if (raw) {
+          Tensor src;
+          s = PrepareRawWriteSource(in, src_dev, send_args, on_gpu, &src);
+          CHECK(s.ok()) << "copy tensor from gpu sync";
+          const void* content = DMAHelper::base(&src);
+          const ibv_mr* mr = nullptr;
+          if (tensor_bytes > 0) {
+            mr = RdmaMemoryMgr::Singleton().FindMemoryRegion(
+                channel_->adapter_->pd_, content, tensor_bytes);
+          }
+          if (mr != nullptr) {
+            {
+              mutex_lock lock{mu_};
+              write_source_ = src;
+            }
+            Write(imm_data, RdmaMessage::kTensorBufferStartIndex, content,
+                  tensor_bytes, mr);
+          } else {
+            if (tensor_bytes > 0) memcpy(output, content, tensor_bytes);
+            Write(imm_data, buffer_size);
+          }
         } else {
-          buffer_size = RdmaMessage::kMessageTotalBytes;
+          proto.SerializeToArray(output, tensor_bytes);
+          Write(imm_data, buffer_size);
         }
-        Write(imm_data, buffer_size);
       } else {
         mu_.unlock();
         // put back the key since it is not sent;
@@ -25,9 +25,13 @@ limitations under the License.
 #include <queue>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/env.h"
@@ -60,6 +64,52 @@ enum RdmaMessageType {
   RDMA_MESSAGE_TENSOR_WRITE
 };
 class RdmaBuffer;
+
+// Class that keeps the memory regions that tensors are allocated from
+// registered with the Rdma adapter, so that tensors can be written to a
+// remote peer straight from their own memory.
+// Regions are reported by visitors installed in the allocators of
+// ProcessState, which may run before the adapter exists; such regions
+// are registered once the protection domain is set.
+class RdmaMemoryMgr {
+ public:
+  static RdmaMemoryMgr& Singleton();
+
+  // Installs visitors in the CPU and CUDA host allocators of ProcessState.
+  // Must be called before the first call to
+  // ProcessState::GetCPUAllocator(), i.e. before the devices are created,
+  // for CPU allocations to be covered.
+  void InstallHostAllocatorVisitors();
+  // Installs visitors in the allocators of the GPUs in "device_mgr", so
+  // that GPU tensors are written to the peer without a copy to host
+  // memory. This needs a NIC and driver that support GPUDirect RDMA.
+  void InstallGPUAllocatorVisitors(const DeviceMgr* device_mgr);
+
+  // Registers the pending and all future regions with "pd".  Only the
+  // first protection domain set is used.
+  void SetProtectionDomain(ibv_pd* pd);
+  void InsertMemoryRegion(void* addr, size_t length);
+  void EvictMemoryRegion(void* addr, size_t length);
+  // Returns the region registered with "pd" that contains
+  // [addr, addr + length), or nullptr if there is none.
+  ibv_mr* FindMemoryRegion(ibv_pd* pd, const void* addr, size_t length);
+
+ private:
+  RdmaMemoryMgr() {}
+  void RegisterLocked(void* addr, size_t length) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  bool host_visitors_installed_ GUARDED_BY(mu_) = false;
+  bool gpu_visitors_installed_ GUARDED_BY(mu_) = false;
+  ibv_pd* pd_ GUARDED_BY(mu_) = nullptr;
+  // Regions reported before the protection domain was set.
+  std::vector<std::pair<void*, size_t>> pending_ GUARDED_BY(mu_);
+  // Registered regions, sorted by address.
+  std::vector<ibv_mr*> mrs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RdmaMemoryMgr);
+};
+
 // Class that represents the Rdma Adapter.
 // Responsible for creation of the completion queue, and handling
 // of work completions.
@@ -179,6 +229,11 @@ class RdmaBuffer {
     }
     mu_.unlock();
   }
+  // Drops the tensor that the last Write() read its payload from.
+  inline void ReleaseWriteSource() {
+    mutex_lock lock{mu_};
+    write_source_ = Tensor();
+  }
   void FreeBuffer();
   void EnqueueItem(string Item);
   virtual void SendNextItem(){};
@@ -187,7 +242,12 @@ class RdmaBuffer {
   uint32_t LookupBufferIndex(const string& buffer_name) {
     return const_cast<RdmaChannel*>(channel_)->LookupBufferIndex(buffer_name);
   }
-  void Write(uint32_t imm_data, size_t buffer_size);
+  // Rdma-Writes the first "buffer_size" bytes of the buffer followed, if
+  // "payload_size" is not zero, by "payload_size" bytes at "payload",
+  // which must lie in "payload_mr".
+  void Write(uint32_t imm_data, size_t buffer_size,
+             const void* payload = nullptr, size_t payload_size = 0,
+             const ibv_mr* payload_mr = nullptr);
 
  protected:
   const RdmaChannel* channel_;
@@ -199,6 +259,8 @@ class RdmaBuffer {
   mutex mu_;
   RemoteMR remote_;
   std::queue<string> queue_ GUARDED_BY(mu_);
+  // Keeps the memory of the payload of an outstanding write alive.
+  Tensor write_source_ GUARDED_BY(mu_);
   BufferStatus local_status_ GUARDED_BY(mu_) = none;
   BufferStatus remote_status_ GUARDED_BY(mu_) = none;
 };
@@ -225,6 +287,11 @@ class RdmaTensorBuffer : public RdmaBuffer {
   explicit RdmaTensorBuffer(RdmaChannel* channel, string name);
   virtual ~RdmaTensorBuffer() override {}
   void SendNextItem() override;
+
+ private:
+  Status PrepareRawWriteSource(const Tensor& in, Device* src_dev,
+                               const Rendezvous::Args& send_args, bool on_gpu,
+                               Tensor* src);
 };
 
 struct RdmaMessage {
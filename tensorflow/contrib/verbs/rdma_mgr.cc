@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -29,6 +30,13 @@ RdmaMgr::RdmaMgr(const WorkerEnv* const worker_env,
                  GrpcChannelCache* const channel_cache)
     : worker_env_(worker_env), channel_cache_(channel_cache) {
   rdma_adapter_ = new RdmaAdapter(worker_env_);
+  bool use_gpu_direct = false;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_VERBS_USE_GPU_DIRECT", false,
+                                 &use_gpu_direct));
+  if (use_gpu_direct) {
+    RdmaMemoryMgr::Singleton().InstallGPUAllocatorVisitors(
+        worker_env_->device_mgr);
+  }
   // hardcoded to default session (legacy_session_)
   // TODO: use WorkerSessionForSession
   // need to pass in session handle
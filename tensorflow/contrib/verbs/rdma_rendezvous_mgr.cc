@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -98,15 +99,35 @@ void RdmaRemoteRendezvous::RecvFromRemoteAsync(
     RdmaMessage::ParseMessage(rm, rb->buffer_);
     CHECK(rm.type_ == RDMA_MESSAGE_TENSOR_WRITE);
     Tensor val;
+    const bool on_gpu = dst_dev->tensorflow_gpu_device_info() &&
+                        (!recv_args.alloc_attrs.on_host());
+    const bool raw = DataTypeCanUseMemcpy(rm.data_type_);
     if (!rm.is_dead_) {
       void* input = static_cast<char*>(rb->buffer_) +
                     RdmaMessage::kTensorBufferStartIndex;
-      TensorProto proto;
       CHECK(rm.tensor_bytes_ + RdmaMessage::kTensorBufferStartIndex <=
             rb->size_);
-      CHECK(ParseProtoUnlimited(&proto, input, rm.tensor_bytes_))
-          << "fail to parse proto from array";
-      s = dst_dev->MakeTensorFromProto(proto, recv_args.alloc_attrs, &val);
+      if (raw) {
+        // The content was written as is.  It is copied out so that the
+        // buffer can be released right away; GPU tensors are staged in
+        // CUDA host memory.
+        AllocatorAttributes host_alloc_attr;
+        host_alloc_attr.set_on_host(true);
+        host_alloc_attr.set_gpu_compatible(true);
+        val = Tensor(dst_dev->GetAllocator(on_gpu ? host_alloc_attr
+                                                  : recv_args.alloc_attrs),
+                     rm.data_type_, rm.tensor_shape_);
+        CHECK(val.TotalBytes() == rm.tensor_bytes_)
+            << "tensor and message size do not agree!";
+        if (rm.tensor_bytes_ > 0) {
+          memcpy(DMAHelper::base(&val), input, rm.tensor_bytes_);
+        }
+      } else {
+        TensorProto proto;
+        CHECK(ParseProtoUnlimited(&proto, input, rm.tensor_bytes_))
+            << "fail to parse proto from array";
+        s = dst_dev->MakeTensorFromProto(proto, recv_args.alloc_attrs, &val);
+      }
     }
 
     rc->RemoveRecvCallback(key_with_step_id);
@@ -119,7 +140,24 @@ void RdmaRemoteRendezvous::RecvFromRemoteAsync(
     RdmaBuffer* tb = rc->tx_message_buffer_;
     tb->EnqueueItem(message);
     tb->SendNextItem();
-    done(s, Args(), recv_args, val, rm.is_dead_);
+    if (rm.is_dead_ || !raw || !on_gpu) {
+      done(s, Args(), recv_args, val, rm.is_dead_);
+      return;
+    }
+    const DeviceContext* device_context = recv_args.device_context;
+    if (device_context == nullptr) {
+      device_context = dst_dev->tensorflow_gpu_device_info()->default_context;
+    }
+    Tensor* host_val = new Tensor(val);
+    Tensor* gpu_val = new Tensor(dst_dev->GetAllocator(recv_args.alloc_attrs),
+                                 val.dtype(), val.shape());
+    GPUUtil::CopyCPUTensorToGPU(
+        host_val, device_context, dst_dev, gpu_val,
+        [host_val, gpu_val, recv_args, done](const Status& s) {
+          done(s, Args(), recv_args, *gpu_val, false);
+          delete host_val;
+          delete gpu_val;
+        });
   });
   // append key to message queue
   RdmaBuffer* rb = rc->tx_message_buffer_;
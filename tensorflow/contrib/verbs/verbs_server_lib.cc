@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/contrib/verbs/verbs_server_lib.h"
 
+#include "tensorflow/contrib/verbs/rdma.h"
 #include "tensorflow/contrib/verbs/rdma_mgr.h"
 #include "tensorflow/contrib/verbs/rdma_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/server_lib.h"
@@ -78,6 +79,8 @@ Status VerbsServer::ChannelCacheFactory(const ServerDef& server_def,
 
 Status VerbsServer::Init(ServiceInitFunction service_func,
                          RendezvousMgrCreationFunction rendezvous_mgr_func) {
+  // The devices, and thus the allocators, are created by GrpcServer::Init.
+  RdmaMemoryMgr::Singleton().InstallHostAllocatorVisitors();
   Status s = GrpcServer::Init(service_func, rendezvous_mgr_func);
   {
     mutex_lock l(mu_);
@@ -36,6 +36,21 @@ Status VerbsUtil::SetProtoFromGPUSync(const Tensor& tensor, Device* dev,
 }
 
 // static
+Status VerbsUtil::CopyGPUTensorToCPUSync(Device* gpu_device,
+                                         const DeviceContext* device_context,
+                                         const Tensor* gpu_tensor,
+                                         Tensor* cpu_tensor) {
+  Notification n;
+  Status status;
+  GPUUtil::CopyGPUTensorToCPU(gpu_device, device_context, gpu_tensor,
+                              cpu_tensor, [&n, &status](const Status& s) {
+                                status = s;
+                                n.Notify();
+                              });
+  n.WaitForNotification();
+  return status;
+}
+
 string VerbsUtil::AppendStepidToKey(const string& key, int64 step_id) {
   return strings::StrCat(key, ";", step_id);
 }
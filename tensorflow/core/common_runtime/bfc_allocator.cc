@@ -15,24 +15,81 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Raises '*value' to 'x' if it is smaller.
+void AtomicMax(std::atomic<int64>* value, int64 x) {
+  int64 current = value->load(std::memory_order_relaxed);
+  while (current < x && !value->compare_exchange_weak(current, x)) {
+  }
+}
+
+auto* allocator_events = monitoring::Counter<2>::New(
+    "/tensorflow/core/bfc_allocator/events",
+    "The number of times each allocator grew its memory, flushed its thread "
+    "caches or ran out of memory.",
+    "allocator", "event");
+
+}  // namespace
+
+// The events of a memory trace are fixed-size records written to a buffer
+// allocated up front, claimed with an atomic increment, and only converted
+// to protos by StopMemoryTrace().
+struct BFCAllocator::MemoryTrace {
+  struct Event {
+    MemoryAllocatorEvent::Kind kind;
+    int64 time_micros;
+    const void* ptr;
+    int64 requested_bytes;
+    int64 allocated_bytes;
+    int32 bin;
+    int64 allocation_id;
+    const string* kernel_name;
+    int64 bytes_in_use;
+  };
+
+  explicit MemoryTrace(int64 max_events)
+      : max_events(max_events), events(new Event[max_events]), next_event(0) {}
+
+  const int64 max_events;
+  std::unique_ptr<Event[]> events;
+  std::atomic<int64> next_event;
+  // Guarded by the lock_ of the allocator.
+  std::vector<MemoryAllocatorSnapshot> snapshots;
+};
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-                           bool allow_growth, const string& name)
+                           bool allow_growth, const string& name,
+                           bool use_thread_cache)
     : suballocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      thread_caches_(use_thread_cache ? new ThreadCache[kNumThreadCaches]
+                                      : nullptr),
+      bytes_limit_(static_cast<int64>(total_memory)),
+      extend_events_(allocator_events->GetCell(name, "extend")),
+      flush_events_(allocator_events->GetCell(name, "thread_cache_flush")),
+      oom_events_(allocator_events->GetCell(name, "out_of_memory")) {
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -44,7 +101,6 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
 
   // Allocate the requested amount of memory.
   memory_limit_ = total_memory;
-  stats_.bytes_limit = static_cast<int64>(total_memory);
 
   // Create a bunch of bins of various good sizes.
 
@@ -76,6 +132,7 @@ BFCAllocator::~BFCAllocator() {
   for (BinNum b = 0; b < kNumBins; b++) {
     BinFromIndex(b)->~Bin();
   }
+  delete memory_trace_.load();
 }
 
 BFCAllocator::Chunk* BFCAllocator::ChunkFromHandle(ChunkHandle h) {
@@ -139,6 +196,7 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
 
   VLOG(1) << "Allocated memory at " << mem_addr << " to "
           << static_cast<void*>(static_cast<char*>(mem_addr) + bytes);
+  extend_events_->IncrementBy(1);
   region_manager_.AddAllocationRegion(mem_addr, bytes);
 
   // Create one large chunk for the whole memory space that will
@@ -160,6 +218,14 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
   // Insert the chunk into the right bin.
   InsertFreeChunkIntoBin(h);
 
+  RecordMemoryEvent(MemoryAllocatorEvent::EXTEND, mem_addr, 0, bytes,
+                    kInvalidBinNum, -1, nullptr);
+  MemoryTrace* trace = memory_trace_.load(std::memory_order_acquire);
+  if (trace != nullptr) {
+    trace->snapshots.emplace_back();
+    FillMemorySnapshot(&trace->snapshots.back());
+  }
+
   // Invoke visitors on newly allocated region.
   for (const auto& visitor : region_visitors_) {
     visitor(mem_addr, bytes);
@@ -187,15 +253,22 @@ void BFCAllocator::DeallocateChunk(ChunkHandle h) {
 }
 
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes) {
+  return AllocateRawWithRetry(unused_alignment, num_bytes, nullptr);
+}
+
+void* BFCAllocator::AllocateRawWithRetry(size_t unused_alignment,
+                                         size_t num_bytes,
+                                         const string* kernel_name) {
   // Fast path: Try once to allocate without getting the retry_helper_ involved
-  void* r = AllocateRawInternal(unused_alignment, num_bytes, false);
+  void* r =
+      AllocateRawInternal(unused_alignment, num_bytes, false, kernel_name);
   if (r != nullptr) {
     return r;
   } else {
     static const int64 kMaxMillisToWait = 10000;  // 10 seconds
     return retry_helper_.AllocateRaw(
-        [this](size_t a, size_t nb, bool v) {
-          return AllocateRawInternal(a, nb, v);
+        [this, kernel_name](size_t a, size_t nb, bool v) {
+          return AllocateRawInternal(a, nb, v, kernel_name);
         },
         kMaxMillisToWait, unused_alignment, num_bytes);
   }
@@ -206,7 +279,8 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
   if (allocation_attr.no_retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
-    void* result = AllocateRawInternal(unused_alignment, num_bytes, false);
+    void* result = AllocateRawInternal(unused_alignment, num_bytes, false,
+                                       allocation_attr.kernel_name);
     if (result == nullptr) {
       // The counter incrementing is not thread-safe. But we don't really care.
       // TODO(zhengxq): we should implement a LOG_FIRST_N and LOG_EVERY_N for
@@ -224,7 +298,8 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     }
     return result;
   } else {
-    return AllocateRaw(unused_alignment, num_bytes);
+    return AllocateRawWithRetry(unused_alignment, num_bytes,
+                                allocation_attr.kernel_name);
   }
 }
 
@@ -239,7 +314,8 @@ size_t BFCAllocator::RoundedBytes(size_t bytes) {
 
 void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
                                         size_t num_bytes,
-                                        bool dump_log_on_failure) {
+                                        bool dump_log_on_failure,
+                                        const string* kernel_name) {
   if (num_bytes == 0) {
     LOG(ERROR) << "tried to allocate 0 bytes";
     return nullptr;
@@ -249,18 +325,35 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (thread_caches_ != nullptr && rounded_bytes <= kMaxThreadCacheBytes) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes, kernel_name);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
   mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, kernel_name);
   if (ptr != nullptr) {
     return ptr;
   }
 
   // Try to extend
   if (Extend(rounded_bytes)) {
-    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, kernel_name);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
+  // Chunks parked in the thread caches cannot be coalesced, so give them
+  // back to the bins before giving up.
+  if (thread_caches_ != nullptr && FlushThreadCaches()) {
+    flush_events_->IncrementBy(1);
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, kernel_name);
     if (ptr != nullptr) {
       return ptr;
     }
@@ -269,6 +362,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
+  oom_events_->IncrementBy(1);
   if (dump_log_on_failure) {
     LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
                  << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
@@ -280,7 +374,7 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
 }
 
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
-                                 size_t num_bytes) {
+                                 size_t num_bytes, const string* kernel_name) {
   // First identify the first bin that could satisfy rounded_bytes.
   for (; bin_num < kNumBins; bin_num++) {
     // Start searching from the first bin for the smallest chunk that fits
@@ -314,12 +408,10 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         chunk->allocation_id = next_allocation_id_++;
 
         // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.max_bytes_in_use =
-            std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
-        stats_.max_alloc_size =
-            std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
+        RecordAlloc(chunk->size);
+        RecordMemoryEvent(MemoryAllocatorEvent::ALLOCATE, chunk->ptr,
+                          num_bytes, chunk->size, BinNumForSize(chunk->size),
+                          chunk->allocation_id, kernel_name);
 
         VLOG(4) << "Returning: " << chunk->ptr;
         if (VLOG_IS_ON(4)) {
@@ -378,14 +470,78 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  std::vector<void*> overflow;
+  if (thread_caches_ != nullptr) {
+    // Fast path: the chunk came from the calling thread's cache.
+    ThreadCache* cache = &thread_caches_[ThreadCacheIndex()];
+    bool found = false;
+    {
+      mutex_lock cl(cache->mu);
+      auto it = cache->live_chunks.find(ptr);
+      if (it != cache->live_chunks.end()) {
+        const size_t size = it->second.size;
+        RecordFree(size);
+        RecordMemoryEvent(MemoryAllocatorEvent::DEALLOCATE, ptr,
+                          it->second.requested_size, size, BinNumForSize(size),
+                          it->second.allocation_id, nullptr);
+        cache->live_chunks.erase(it);
+        ParkInThreadCache(cache, ptr, size, &overflow);
+        found = true;
+      }
+    }
+    if (found) {
+      if (!overflow.empty()) {
+        mutex_lock l(lock_);
+        for (void* p : overflow) {
+          ReleaseCachedChunk(p);
+        }
+      }
+      return;
+    }
+  }
+
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
+  Chunk* c = ChunkFromHandle(h);
 
-  // Consider coalescing it.
-  FreeAndMaybeCoalesce(h);
+  if (c->thread_cache != kNoThreadCache) {
+    // The chunk came from another thread's cache; return it there.
+    ThreadCache* cache = &thread_caches_[c->thread_cache];
+    mutex_lock cl(cache->mu);
+    auto it = cache->live_chunks.find(ptr);
+    CHECK(it != cache->live_chunks.end());
+    RecordFree(c->size);
+    RecordMemoryEvent(MemoryAllocatorEvent::DEALLOCATE, ptr,
+                      it->second.requested_size, c->size,
+                      BinNumForSize(c->size), it->second.allocation_id,
+                      nullptr);
+    cache->live_chunks.erase(it);
+    ParkInThreadCache(cache, ptr, c->size, &overflow);
+  } else if (thread_caches_ != nullptr && c->size <= kMaxThreadCacheBytes) {
+    // Park the chunk in the calling thread's cache instead of coalescing
+    // it.  It stays in use as far as the bins are concerned.
+    c->thread_cache = ThreadCacheIndex();
+    ThreadCache* cache = &thread_caches_[c->thread_cache];
+    mutex_lock cl(cache->mu);
+    RecordFree(c->size);
+    RecordMemoryEvent(MemoryAllocatorEvent::DEALLOCATE, ptr, c->requested_size,
+                      c->size, BinNumForSize(c->size), c->allocation_id,
+                      nullptr);
+    ParkInThreadCache(cache, ptr, c->size, &overflow);
+  } else {
+    RecordFree(c->size);
+    RecordMemoryEvent(MemoryAllocatorEvent::DEALLOCATE, ptr, c->requested_size,
+                      c->size, BinNumForSize(c->size), c->allocation_id,
+                      nullptr);
+    // Consider coalescing it.
+    FreeAndMaybeCoalesce(h);
+  }
+  for (void* p : overflow) {
+    ReleaseCachedChunk(p);
+  }
 
   if (VLOG_IS_ON(4)) {
     LOG(INFO) << "F: " << RenderOccupancy();
@@ -465,9 +621,6 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   // Mark the chunk as no longer in use
   c->allocation_id = -1;
 
-  // Updates the stats.
-  stats_.bytes_in_use -= c->size;
-
   // This chunk is no longer in-use, consider coalescing the chunk
   // with adjacent chunks.
   ChunkHandle chunk_to_reassign = h;
@@ -516,6 +669,273 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
   }
 }
 
+int BFCAllocator::ThreadCacheIndex() const {
+  return std::hash<std::thread::id>()(std::this_thread::get_id()) %
+         kNumThreadCaches;
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes,
+                                            const string* kernel_name) {
+  ThreadCache* cache = &thread_caches_[ThreadCacheIndex()];
+  mutex_lock cl(cache->mu);
+  std::vector<void*>& free_chunks =
+      cache->free_chunks[rounded_bytes / kMinAllocationSize - 1];
+  if (free_chunks.empty()) {
+    return nullptr;
+  }
+  void* ptr = free_chunks.back();
+  free_chunks.pop_back();
+  const int64 allocation_id = next_allocation_id_++;
+  cache->live_chunks[ptr] = {rounded_bytes, num_bytes, allocation_id};
+  RecordAlloc(rounded_bytes);
+  RecordMemoryEvent(MemoryAllocatorEvent::ALLOCATE, ptr, num_bytes,
+                    rounded_bytes, BinNumForSize(rounded_bytes), allocation_id,
+                    kernel_name);
+  return ptr;
+}
+
+void BFCAllocator::ParkInThreadCache(ThreadCache* cache, void* ptr,
+                                     size_t size,
+                                     std::vector<void*>* overflow) {
+  DCHECK_EQ(0, size % kMinAllocationSize);
+  std::vector<void*>& free_chunks =
+      cache->free_chunks[size / kMinAllocationSize - 1];
+  free_chunks.push_back(ptr);
+  if (free_chunks.size() > kMaxThreadCacheChunksPerClass) {
+    // Keep the most recently freed half, which is the most likely to
+    // still be warm.
+    const auto mid = free_chunks.begin() + free_chunks.size() / 2;
+    overflow->insert(overflow->end(), free_chunks.begin(), mid);
+    free_chunks.erase(free_chunks.begin(), mid);
+  }
+}
+
+void BFCAllocator::ReleaseCachedChunk(void* ptr) {
+  BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+  CHECK(h != kInvalidChunkHandle);
+  Chunk* c = ChunkFromHandle(h);
+  DCHECK_NE(c->thread_cache, kNoThreadCache);
+  c->thread_cache = kNoThreadCache;
+  FreeAndMaybeCoalesce(h);
+}
+
+bool BFCAllocator::FlushThreadCaches() {
+  std::vector<void*> released;
+  for (int i = 0; i < kNumThreadCaches; ++i) {
+    ThreadCache* cache = &thread_caches_[i];
+    mutex_lock cl(cache->mu);
+    for (std::vector<void*>& free_chunks : cache->free_chunks) {
+      released.insert(released.end(), free_chunks.begin(), free_chunks.end());
+      free_chunks.clear();
+    }
+  }
+  for (void* p : released) {
+    ReleaseCachedChunk(p);
+  }
+  VLOG(1) << "Released " << released.size() << " chunks from thread caches";
+  return !released.empty();
+}
+
+BFCAllocator::ThreadCache::LiveChunk BFCAllocator::GetLiveChunk(const Chunk* c,
+                                                                void* ptr) {
+  ThreadCache* cache = &thread_caches_[c->thread_cache];
+  mutex_lock cl(cache->mu);
+  auto it = cache->live_chunks.find(ptr);
+  CHECK(it != cache->live_chunks.end())
+      << "Asked about cached chunk that is not in use: " << ptr;
+  return it->second;
+}
+
+void BFCAllocator::RecordAlloc(size_t size) {
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  const int64 bytes_in_use = bytes_in_use_.fetch_add(size) + size;
+  AtomicMax(&max_bytes_in_use_, bytes_in_use);
+  AtomicMax(&max_alloc_size_, size);
+}
+
+void BFCAllocator::RecordFree(size_t size) { bytes_in_use_.fetch_sub(size); }
+
+void BFCAllocator::RecordMemoryEvent(MemoryAllocatorEvent::Kind kind,
+                                     const void* ptr, size_t requested_bytes,
+                                     size_t allocated_bytes, BinNum bin,
+                                     int64 allocation_id,
+                                     const string* kernel_name) {
+  MemoryTrace* trace = memory_trace_.load(std::memory_order_acquire);
+  if (trace == nullptr) {
+    return;
+  }
+  const int64 index = trace->next_event.fetch_add(1, std::memory_order_relaxed);
+  if (index >= trace->max_events) {
+    return;
+  }
+  MemoryTrace::Event* event = &trace->events[index];
+  event->kind = kind;
+  event->time_micros = Env::Default()->NowMicros();
+  event->ptr = ptr;
+  event->requested_bytes = requested_bytes;
+  event->allocated_bytes = allocated_bytes;
+  event->bin = bin;
+  event->allocation_id = allocation_id;
+  event->kernel_name = kernel_name;
+  event->bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+}
+
+BFCAllocator::MemoryTrace* BFCAllocator::SwapMemoryTrace(MemoryTrace* trace) {
+  MemoryTrace* old = memory_trace_.exchange(trace);
+  // Recorders hold lock_, which we hold, or the mutex of a thread cache.
+  // Once each of those has been taken, no thread still uses 'old'.
+  if (thread_caches_ != nullptr) {
+    for (int i = 0; i < kNumThreadCaches; ++i) {
+      mutex_lock cl(thread_caches_[i].mu);
+    }
+  }
+  return old;
+}
+
+void BFCAllocator::StartMemoryTrace(int64 max_events) {
+  CHECK_GT(max_events, 0);
+  MemoryTrace* old;
+  {
+    mutex_lock l(lock_);
+    old = SwapMemoryTrace(new MemoryTrace(max_events));
+  }
+  delete old;
+}
+
+bool BFCAllocator::StopMemoryTrace(MemoryAllocatorTrace* trace) {
+  std::unique_ptr<MemoryTrace> t;
+  std::vector<MemoryAllocatorSnapshot> snapshots;
+  {
+    mutex_lock l(lock_);
+    t.reset(SwapMemoryTrace(nullptr));
+    if (t == nullptr) {
+      return false;
+    }
+    snapshots.swap(t->snapshots);
+    snapshots.emplace_back();
+    FillMemorySnapshot(&snapshots.back());
+  }
+
+  trace->Clear();
+  trace->set_allocator_name(name_);
+  const int64 num_events = std::min(t->next_event.load(), t->max_events);
+  trace->set_num_dropped_events(t->next_event.load() - num_events);
+  int64 peak = -1;
+  for (int64 i = 0; i < num_events; ++i) {
+    const MemoryTrace::Event& event = t->events[i];
+    MemoryAllocatorEvent* proto = trace->add_events();
+    proto->set_kind(event.kind);
+    proto->set_time_micros(event.time_micros);
+    proto->set_ptr(reinterpret_cast<uint64>(event.ptr));
+    proto->set_requested_bytes(event.requested_bytes);
+    proto->set_allocated_bytes(event.allocated_bytes);
+    proto->set_bin(event.bin);
+    proto->set_allocation_id(event.allocation_id);
+    if (event.kernel_name != nullptr) {
+      proto->set_kernel_name(*event.kernel_name);
+    }
+    proto->set_bytes_in_use(event.bytes_in_use);
+    if (peak < 0 || event.bytes_in_use > t->events[peak].bytes_in_use) {
+      peak = i;
+    }
+  }
+  for (MemoryAllocatorSnapshot& snapshot : snapshots) {
+    trace->add_snapshots()->Swap(&snapshot);
+  }
+  if (peak < 0) {
+    return true;
+  }
+
+  // Replay the allocations up to the peak to find those live at the peak.
+  trace->set_peak_bytes_in_use(t->events[peak].bytes_in_use);
+  trace->set_peak_time_micros(t->events[peak].time_micros);
+  std::unordered_map<int64, const MemoryTrace::Event*> live;
+  for (int64 i = 0; i <= peak; ++i) {
+    const MemoryTrace::Event& event = t->events[i];
+    if (event.kind == MemoryAllocatorEvent::ALLOCATE) {
+      live[event.allocation_id] = &event;
+    } else if (event.kind == MemoryAllocatorEvent::DEALLOCATE) {
+      live.erase(event.allocation_id);
+    }
+  }
+  std::unordered_map<string, MemoryKernelUsage> usage;
+  for (const auto& it : live) {
+    const string kernel_name =
+        it.second->kernel_name != nullptr ? *it.second->kernel_name : "";
+    MemoryKernelUsage* u = &usage[kernel_name];
+    u->set_kernel_name(kernel_name);
+    u->set_bytes(u->bytes() + it.second->allocated_bytes);
+    u->set_num_allocations(u->num_allocations() + 1);
+  }
+  std::vector<const MemoryKernelUsage*> sorted;
+  for (const auto& it : usage) {
+    sorted.push_back(&it.second);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const MemoryKernelUsage* a, const MemoryKernelUsage* b) {
+              if (a->bytes() != b->bytes()) {
+                return a->bytes() > b->bytes();
+              }
+              return a->kernel_name() < b->kernel_name();
+            });
+  for (const MemoryKernelUsage* u : sorted) {
+    *trace->add_peak_usage_by_kernel() = *u;
+  }
+  return true;
+}
+
+void BFCAllocator::GetMemorySnapshot(MemoryAllocatorSnapshot* snapshot) {
+  mutex_lock l(lock_);
+  FillMemorySnapshot(snapshot);
+}
+
+void BFCAllocator::FillMemorySnapshot(MemoryAllocatorSnapshot* snapshot) {
+  snapshot->Clear();
+  snapshot->set_time_micros(Env::Default()->NowMicros());
+  snapshot->set_num_regions(region_manager_.regions().size());
+  for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++) {
+    MemoryAllocatorBinStats* bin = snapshot->add_bins();
+    bin->set_bin(bin_num);
+    bin->set_bin_size(BinNumToSize(bin_num));
+  }
+  int64 region_bytes = 0;
+  int64 bytes_in_use = 0;
+  int64 free_bytes = 0;
+  int64 largest_free_chunk_bytes = 0;
+  for (const auto& region : region_manager_.regions()) {
+    region_bytes += region.memory_size();
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      const int64 size = c->size;
+      MemoryAllocatorBinStats* bin =
+          snapshot->mutable_bins(BinNumForSize(c->size));
+      if (c->in_use()) {
+        bin->set_chunks_in_use(bin->chunks_in_use() + 1);
+        bin->set_bytes_in_use(bin->bytes_in_use() + size);
+        bin->set_requested_bytes_in_use(bin->requested_bytes_in_use() +
+                                        c->requested_size);
+        bytes_in_use += size;
+      } else {
+        bin->set_free_chunks(bin->free_chunks() + 1);
+        bin->set_free_bytes(bin->free_bytes() + size);
+        free_bytes += size;
+        largest_free_chunk_bytes = std::max(largest_free_chunk_bytes, size);
+      }
+      h = c->next;
+    }
+  }
+  snapshot->set_region_bytes(region_bytes);
+  snapshot->set_bytes_in_use(bytes_in_use);
+  snapshot->set_free_bytes(free_bytes);
+  snapshot->set_largest_free_chunk_bytes(largest_free_chunk_bytes);
+  if (free_bytes > 0) {
+    snapshot->set_fragmentation(
+        1.0 - static_cast<double>(largest_free_chunk_bytes) / free_bytes);
+  }
+}
+
 bool BFCAllocator::TracksAllocationSizes() { return true; }
 
 size_t BFCAllocator::RequestedSize(void* ptr) {
@@ -524,6 +944,9 @@ size_t BFCAllocator::RequestedSize(void* ptr) {
   CHECK(h != kInvalidChunkHandle)
       << "Asked for requested size of pointer we never allocated: " << ptr;
   BFCAllocator::Chunk* c = ChunkFromHandle(h);
+  if (c->thread_cache != kNoThreadCache) {
+    return GetLiveChunk(c, ptr).requested_size;
+  }
   return c->requested_size;
 }
 
@@ -542,6 +965,9 @@ int64 BFCAllocator::AllocationId(void* ptr) {
   CHECK(h != kInvalidChunkHandle)
       << "Asked for allocation id of pointer we never allocated: " << ptr;
   BFCAllocator::Chunk* c = ChunkFromHandle(h);
+  if (c->thread_cache != kNoThreadCache) {
+    return GetLiveChunk(c, ptr).allocation_id;
+  }
   return c->allocation_id;
 }
 
@@ -699,12 +1125,17 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
   }
   LOG(INFO) << "Sum Total of in-use chunks: "
             << strings::HumanReadableNumBytes(total_bytes);
-  LOG(INFO) << "Stats: \n" << stats_.DebugString();
+  AllocatorStats stats;
+  GetStats(&stats);
+  LOG(INFO) << "Stats: \n" << stats.DebugString();
 }
 
 void BFCAllocator::GetStats(AllocatorStats* stats) {
-  mutex_lock l(lock_);
-  *stats = stats_;
+  stats->num_allocs = num_allocs_.load();
+  stats->bytes_in_use = bytes_in_use_.load();
+  stats->max_bytes_in_use = max_bytes_in_use_.load();
+  stats->max_alloc_size = max_alloc_size_.load();
+  stats->bytes_limit = bytes_limit_;
 }
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -23,7 +24,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/visitable_allocator.h"
+#include "tensorflow/core/framework/log_memory.pb.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -41,11 +45,30 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// Optionally, small chunks can be cached in front of the bins, in the
+// style of tcmalloc's thread caches: a freed chunk of at most
+// kMaxThreadCacheBytes is parked, uncoalesced, in a cache chosen by the
+// identity of the freeing thread, and a later allocation of the same
+// rounded size on a thread that maps to that cache reuses it without
+// taking the allocator-wide lock.  Caches that grow too large return
+// chunks to the bins in batches, and all cached chunks are returned
+// before an allocation is allowed to fail.  AllocatorStats count only
+// the bytes held by clients, and RequestedSize() and AllocationId()
+// report the values of the current allocation, so the accounting done by
+// callers such as TrackingAllocator is unaffected by the caches.
+//
+// A memory trace can be started at any time to record every allocation,
+// deallocation and region extension, with the chunk, bin and kernel
+// involved, into a buffer allocated up front.  When no trace is in
+// progress the cost is a relaxed atomic load per call.
 class BFCAllocator : public VisitableAllocator {
  public:
-  // Takes ownership of sub_allocator.
+  // Takes ownership of sub_allocator.  If 'use_thread_cache' is true,
+  // small chunks are cached per thread as described above.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-               bool allow_growth, const string& name);
+               bool allow_growth, const string& name,
+               bool use_thread_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -69,11 +92,28 @@ class BFCAllocator : public VisitableAllocator {
 
   void GetStats(AllocatorStats* stats) override;
 
+  // Starts recording a memory trace of up to 'max_events' events,
+  // discarding any trace in progress.  The kernel names passed in the
+  // AllocationAttributes must stay valid until the trace is stopped.
+  void StartMemoryTrace(int64 max_events);
+
+  // Stops the trace in progress and fills '*trace' with its events, its
+  // snapshots and the attribution of its peak memory.  Returns false if no
+  // trace was in progress.
+  bool StopMemoryTrace(MemoryAllocatorTrace* trace);
+
+  // Fills '*snapshot' with the current layout of the memory.
+  void GetMemorySnapshot(MemoryAllocatorSnapshot* snapshot);
+
  private:
   struct Bin;
+  struct MemoryTrace;
 
+  void* AllocateRawWithRetry(size_t alignment, size_t num_bytes,
+                             const string* kernel_name);
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
-                            bool dump_log_on_failure);
+                            bool dump_log_on_failure,
+                            const string* kernel_name);
   void DeallocateRawInternal(void* ptr);
 
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
@@ -119,6 +159,13 @@ class BFCAllocator : public VisitableAllocator {
     // What bin are we in?
     BinNum bin_num = kInvalidBinNum;
 
+    // If not kNoThreadCache, the chunk belongs to thread_caches_[thread_cache]
+    // and is either parked in that cache or held by a client that got it
+    // from there.  Such a chunk looks in use to the bins, and its
+    // requested_size and allocation_id are stale; the current values live
+    // in the cache's live_chunks map.
+    int thread_cache = kNoThreadCache;
+
     bool in_use() const { return allocation_id != -1; }
 
     string DebugString(BFCAllocator* a,
@@ -174,6 +221,36 @@ class BFCAllocator : public VisitableAllocator {
   static const size_t kMinAllocationBits = 8;
   static const size_t kMinAllocationSize = 1 << kMinAllocationBits;
 
+  static const int kNoThreadCache = -1;
+  static const int kNumThreadCaches = 16;
+  // Chunks of at most this many bytes are eligible for the thread caches.
+  static const size_t kMaxThreadCacheBytes = 64 << 10;
+  static const int kNumThreadCacheClasses =
+      kMaxThreadCacheBytes / kMinAllocationSize;
+  // When a size class of one cache holds more free chunks than this, the
+  // older half of them is returned to the bins.
+  static const int kMaxThreadCacheChunksPerClass = 32;
+
+  // A ThreadCache holds chunks owned by one of the kNumThreadCaches caches.
+  // Threads are mapped to caches by hashing their id, so a cache is only
+  // shared by threads that collide.
+  struct ThreadCache {
+    // The size, requested size and allocation id of a chunk that a client
+    // got from this cache.
+    struct LiveChunk {
+      size_t size;
+      size_t requested_size;
+      int64 allocation_id;
+    };
+
+    mutex mu;
+    // Free chunks by size class; class i holds chunks of exactly
+    // (i + 1) * kMinAllocationSize bytes, most recently freed last.
+    std::vector<void*> free_chunks[kNumThreadCacheClasses] GUARDED_BY(mu);
+    // Chunks handed out from this cache, by address.
+    gtl::FlatMap<void*, LiveChunk> live_chunks GUARDED_BY(mu);
+  };
+
   // AllocationRegion maps pointers to ChunkHandles for a single
   // contiguous memory region.
   //
@@ -306,8 +383,8 @@ class BFCAllocator : public VisitableAllocator {
 
   // Returns a pointer to an underlying allocated chunk of size
   // 'rounded_bytes'.
-  void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes)
-      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes,
+                     const string* kernel_name) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Splits the chunk specified by 'h' into two chunks, one at least
   // of size 'num_bytes'.
@@ -336,6 +413,53 @@ class BFCAllocator : public VisitableAllocator {
   // Removes the chunk metadata represented by 'h'.
   void DeleteChunk(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Returns the index of the thread cache used by the calling thread.
+  int ThreadCacheIndex() const;
+
+  // Returns a cached chunk of exactly 'rounded_bytes' from the calling
+  // thread's cache, or nullptr if there is none.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes,
+                                const string* kernel_name);
+
+  // Parks the free chunk at 'ptr' of 'size' bytes in 'cache'.  If the size
+  // class overflows, moves the chunks that should go back to the bins to
+  // '*overflow'.
+  void ParkInThreadCache(ThreadCache* cache, void* ptr, size_t size,
+                         std::vector<void*>* overflow)
+      EXCLUSIVE_LOCKS_REQUIRED(cache->mu);
+
+  // Takes a parked chunk away from its cache and frees it into the bins.
+  void ReleaseCachedChunk(void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Releases every parked chunk of every cache.  Returns true if any chunk
+  // was released.
+  bool FlushThreadCaches() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the live-chunk entry for 'ptr', which must belong to a cache.
+  ThreadCache::LiveChunk GetLiveChunk(const Chunk* c, void* ptr)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Update the stats for a chunk of 'size' bytes handed to or returned by
+  // a client.
+  void RecordAlloc(size_t size);
+  void RecordFree(size_t size);
+
+  // Adds an event to the memory trace in progress, if any.  Must be called
+  // with lock_ or the mutex of a thread cache held, so that
+  // StopMemoryTrace() can wait for recorders to finish.
+  void RecordMemoryEvent(MemoryAllocatorEvent::Kind kind, const void* ptr,
+                         size_t requested_bytes, size_t allocated_bytes,
+                         BinNum bin, int64 allocation_id,
+                         const string* kernel_name);
+
+  void FillMemorySnapshot(MemoryAllocatorSnapshot* snapshot)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Replaces the memory trace in progress with 'trace' and returns the old
+  // one, once no thread can be recording into it any more.
+  MemoryTrace* SwapMemoryTrace(MemoryTrace* trace)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   string RenderOccupancy() EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpMemoryLog(size_t num_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -405,11 +529,31 @@ class BFCAllocator : public VisitableAllocator {
   std::vector<Visitor> region_visitors_;
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ GUARDED_BY(lock_);
-
-  // Stats.
-  AllocatorStats stats_ GUARDED_BY(lock_);
+  // newly-created chunk.  Atomic because the thread caches assign ids
+  // without holding lock_.
+  std::atomic<int64> next_allocation_id_;
+
+  // nullptr unless the thread caches are enabled.  Lock order is lock_
+  // before ThreadCache::mu.
+  std::unique_ptr<ThreadCache[]> thread_caches_;
+
+  // Stats.  The counters are atomic so that allocations served by the
+  // thread caches keep them exact without taking lock_.
+  const int64 bytes_limit_;
+  std::atomic<int64> num_allocs_{0};
+  std::atomic<int64> bytes_in_use_{0};
+  std::atomic<int64> max_bytes_in_use_{0};
+  std::atomic<int64> max_alloc_size_{0};
+
+  // Cells of the allocator events metric, kept for the slow paths of
+  // AllocateRawInternal() so that they never look up the registry.
+  monitoring::CounterCell* const extend_events_;
+  monitoring::CounterCell* const flush_events_;
+  monitoring::CounterCell* const oom_events_;
+
+  // The memory trace in progress, or nullptr.  Owned.  Only replaced by
+  // SwapMemoryTrace().
+  std::atomic<MemoryTrace*> memory_trace_{nullptr};
 
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
@@ -32,6 +32,14 @@ string BuildGraphOptions::DebugString() const {
   for (auto& s : target_nodes) {
     strings::StrAppend(&rv, s, ", ");
   }
+  for (const auto& feed_device : feed_devices) {
+    strings::StrAppend(&rv, "\nFeed device: ", feed_device.first, " -> ",
+                       feed_device.second);
+  }
+  for (const auto& fetch_device : fetch_devices) {
+    strings::StrAppend(&rv, "\nFetch device: ", fetch_device.first, " -> ",
+                       fetch_device.second);
+  }
   return rv;
 }
 
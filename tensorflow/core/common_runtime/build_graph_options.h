@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_BUILD_GRAPH_OPTIONS_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BUILD_GRAPH_OPTIONS_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/platform/types.h"
@@ -36,6 +37,11 @@ struct BuildGraphOptions {
   // TODO(mrry): Remove this when the distributed runtime supports Arg/Retval.
   bool use_function_convention = false;
 
+  // Map feed and fetch endpoints to the devices on which their tensors live,
+  // if other than the client device. Requires use_function_convention.
+  std::unordered_map<string, string> feed_devices;
+  std::unordered_map<string, string> fetch_devices;
+
   DebugOptions debug_options;
 
   string DebugString() const;
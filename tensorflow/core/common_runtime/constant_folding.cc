@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -27,8 +28,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -41,6 +44,36 @@ limitations under the License.
 
 namespace tensorflow {
 
+bool ConstantFoldingCache::Lookup(const Fprint128& key,
+                                  std::vector<Tensor>* tensors) {
+  mutex_lock l(mu_);
+  auto iter = tensors_.find(key);
+  if (iter == tensors_.end()) {
+    return false;
+  }
+  *tensors = iter->second;
+  return true;
+}
+
+void ConstantFoldingCache::Insert(const Fprint128& key,
+                                  const std::vector<Tensor>& tensors) {
+  int64 bytes = 0;
+  for (const Tensor& tensor : tensors) {
+    bytes += tensor.TotalBytes();
+  }
+  mutex_lock l(mu_);
+  if (size_in_bytes_ + bytes > capacity_in_bytes_ || tensors_.count(key) > 0) {
+    return;
+  }
+  tensors_[key] = tensors;
+  size_in_bytes_ += bytes;
+}
+
+int64 ConstantFoldingCache::size() {
+  mutex_lock l(mu_);
+  return tensors_.size();
+}
+
 namespace {
 
 bool IsConstantFoldable(const Node* n,
@@ -82,6 +115,27 @@ bool IsConstantFoldable(const Node* n,
   return true;
 }
 
+// Adds `n` to `refiner`, and returns true if shape inference shows that an
+// output of `n` is larger than `max_bytes`.
+bool HasOutputLargerThan(ShapeRefiner* refiner, const Node* n,
+                         int64 max_bytes) {
+  // The inputs of `n` may be missing from `refiner`, in which case the size of
+  // the outputs is unknown.
+  if (!refiner->AddNode(n).ok()) {
+    return false;
+  }
+  shape_inference::InferenceContext* c = refiner->GetContext(n);
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    shape_inference::ShapeHandle shape = c->output(i);
+    if (c->FullyDefined(shape) &&
+        c->Value(c->NumElements(shape)) * DataTypeSize(n->output_type(i)) >
+            max_bytes) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Returns the constant foldable nodes in `nodes` in topological order.
 // Populates `constant_control_deps` with the non-constant control depedencies
 // of each constant node.
@@ -90,10 +144,11 @@ void FindConstantFoldableNodes(
     std::unordered_map<const Node*, gtl::FlatSet<Node*>>*
         constant_control_deps) {
   bool internal_node_inserted = false;
+  ShapeRefiner refiner(graph->versions().producer(), graph->op_registry());
   // Walk the nodes in data flow order
   ReverseDFS(
-      *graph, nullptr,
-      [nodes, constant_control_deps, &internal_node_inserted, opts](Node* n) {
+      *graph, nullptr, [nodes, constant_control_deps, &internal_node_inserted,
+                        &refiner, opts](Node* n) {
         if (IsConstantFoldable(n, opts.consider)) {
           // A node is constant provided all of its non-control
           // incoming Tensors come from constant nodes.
@@ -110,6 +165,17 @@ void FindConstantFoldableNodes(
               break;
             }
           }
+          // Evaluating a node with a large output can take a lot of memory,
+          // and the output will not be replaced with a constant.
+          if (all_parents_constant &&
+              HasOutputLargerThan(&refiner, n,
+                                  opts.max_constant_size_in_bytes) &&
+              !n->IsConstant()) {
+            VLOG(1) << "Not folding " << n->name()
+                    << ", which has an output larger than "
+                    << opts.max_constant_size_in_bytes << " bytes";
+            all_parents_constant = false;
+          }
           if (all_parents_constant) {
             gtl::FlatSet<Node*>& control_deps = (*constant_control_deps)[n];
             for (const Edge* e : n->in_edges()) {
@@ -182,6 +248,34 @@ Graph* GetConstantGraph(const Graph* orig_graph,
   return constant_graph;
 }
 
+// Returns the key of the tensors named `tensor_names` of `constant_graph` in a
+// ConstantFoldingCache.
+Fprint128 ConstantGraphKey(const Graph& constant_graph,
+                           const std::vector<string>& tensor_names) {
+  GraphDef graph_def;
+  constant_graph.ToGraphDef(&graph_def);
+  // Serializing the GraphDef is not deterministic, because of the attr maps.
+  string key = strings::StrCat(graph_def.versions().producer(), ";");
+  for (const NodeDef& node : graph_def.node()) {
+    strings::StrAppend(&key, node.name(), ";", node.op(), ";", node.device(),
+                       ";");
+    for (const string& input : node.input()) {
+      strings::StrAppend(&key, input, ",");
+    }
+    const std::map<string, AttrValue> attrs(node.attr().begin(),
+                                            node.attr().end());
+    for (const auto& attr : attrs) {
+      string value;
+      attr.second.SerializeToString(&value);
+      strings::StrAppend(&key, attr.first, "=", value.size(), ":", value, ";");
+    }
+  }
+  for (const string& tensor_name : tensor_names) {
+    strings::StrAppend(&key, tensor_name, ",");
+  }
+  return Fingerprint128(key);
+}
+
 int64 UniqueConstantId() {
   static std::atomic_int_fast64_t id;
   return id.fetch_add(1);
@@ -195,7 +289,8 @@ int64 UniqueConstantId() {
 // new constant node.
 bool ReplaceTensorWithConstant(Graph* graph, Device* partition_device,
                                NodeAndOutput tensor, const Tensor& constant,
-                               const gtl::FlatSet<Node*>& control_deps) {
+                               const gtl::FlatSet<Node*>& control_deps,
+                               int64 max_constant_size_in_bytes) {
   // Be conservative when replacing a tensor with a constant, when not
   // running on CPU.
   // 1) If the destination tensor is not an int32 tensor, and has HOST_MEMORY
@@ -204,8 +299,9 @@ bool ReplaceTensorWithConstant(Graph* graph, Device* partition_device,
   // constraint, do not replace it.
   // 3) If the constant op created does not have a kernel implementation
   // for the device, do not use it.
-  // 4) If the size of the constant in bytes is too large (> 10M), do not
-  // replace it. This prevents the size of the Graph from growing too large.
+  // 4) If the size of the constant in bytes is too large (>
+  // max_constant_size_in_bytes), do not replace it. This prevents the size of
+  // the Graph from growing too large.
   // TODO(keveman): Consider adding a new constant op that has a kernel
   // implementation for all types, but with HostMemory constraint on it's
   // output.
@@ -229,7 +325,7 @@ bool ReplaceTensorWithConstant(Graph* graph, Device* partition_device,
       return false;
     }
   }
-  if (constant.TotalBytes() > 10 * 1024 * 1024) {
+  if (constant.TotalBytes() > max_constant_size_in_bytes) {
     return false;
   }
 
@@ -322,7 +418,7 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     tensors_to_replace.push_back({n.second, n.first.second});
   }
 
-  auto graph_runner = std::unique_ptr<GraphRunner>(new GraphRunner(env));
+  std::unique_ptr<GraphRunner> graph_runner;
   // Evaluate the constant foldable nodes.
   std::vector<Tensor> outputs;
   auto delete_tensors = gtl::MakeCleanup([&graph_runner, &outputs] {
@@ -331,14 +427,24 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     graph_runner.reset(nullptr);
   });
 
-  Status s =
-      graph_runner->Run(constant_graph.get(), function_library, {} /* inputs*/,
-                        tensors_to_fetch_names, &outputs);
-  if (!s.ok()) {
-    VLOG(1) << "Could not fetch constants: " << s;
-    *was_mutated = false;
-    // This is not an error, so return the status as OK.
-    return s;
+  Fprint128 cache_key;
+  if (opts.cache != nullptr) {
+    cache_key = ConstantGraphKey(*constant_graph, tensors_to_fetch_names);
+  }
+  if (opts.cache == nullptr || !opts.cache->Lookup(cache_key, &outputs)) {
+    graph_runner.reset(new GraphRunner(env));
+    Status s = graph_runner->Run(constant_graph.get(), function_library,
+                                 {} /* inputs*/, tensors_to_fetch_names,
+                                 &outputs, opts.thread_pool);
+    if (!s.ok()) {
+      VLOG(1) << "Could not fetch constants: " << s;
+      *was_mutated = false;
+      // This is not an error, so return the status as OK.
+      return s;
+    }
+    if (opts.cache != nullptr) {
+      opts.cache->Insert(cache_key, outputs);
+    }
   }
 
   // Fetch the constant tensors and replace the corresponding tensors in the
@@ -349,7 +455,8 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
         constant_control_deps[tensors_to_replace[c].first];
     if (ReplaceTensorWithConstant(graph, partition_device,
                                   tensors_to_replace[c], outputs[c],
-                                  control_deps)) {
+                                  control_deps,
+                                  opts.max_constant_size_in_bytes)) {
       ++num_nodes_replaced;
     }
   }
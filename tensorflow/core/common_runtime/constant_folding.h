@@ -16,19 +16,69 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_CONSTANT_FOLDING_H_
 #define TENSORFLOW_COMMON_RUNTIME_CONSTANT_FOLDING_H_
 
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
+// Caches the tensors that ConstantFold() evaluates for a set of constant
+// foldable nodes, so that folding the same nodes again, e.g. when a
+// DirectSession creates the executors of another subgraph of its graph, does
+// not evaluate them again. Thread-safe.
+class ConstantFoldingCache {
+ public:
+  // Caches at most "capacity_in_bytes" bytes of tensors.
+  explicit ConstantFoldingCache(int64 capacity_in_bytes)
+      : capacity_in_bytes_(capacity_in_bytes) {}
+
+  // Sets "*tensors" to the tensors cached for "key" and returns true, or
+  // returns false if there are none.
+  bool Lookup(const Fprint128& key, std::vector<Tensor>* tensors);
+
+  // Caches "tensors" for "key", unless that would exceed the capacity.
+  void Insert(const Fprint128& key, const std::vector<Tensor>& tensors);
+
+  // Returns the number of cached sets of tensors.
+  int64 size();
+
+ private:
+  const int64 capacity_in_bytes_;
+  mutex mu_;
+  int64 size_in_bytes_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<Fprint128, std::vector<Tensor>, Fprint128Hasher> tensors_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ConstantFoldingCache);
+};
+
 // Options specific to constant folding optimizations.
 struct ConstantFoldingOptions {
   // If "consider" is not a nullptr, then only constant fold a node "n" if
   // consider(n) returns true.
   std::function<bool(const Node*)> consider = nullptr;
+
+  // Tensors larger than this are not replaced with constants. Nodes with an
+  // output that shape inference shows to be larger are not evaluated either,
+  // so that folding e.g. a reduction of a large Fill() does not allocate it.
+  int64 max_constant_size_in_bytes = 10 * 1024 * 1024;
+
+  // If not nullptr, the constant foldable nodes are evaluated in this thread
+  // pool, which evaluates independent nodes in parallel, instead of on the
+  // calling thread.
+  thread::ThreadPool* thread_pool = nullptr;
+
+  // If not nullptr, the evaluated tensors are looked up in and added to this
+  // cache.
+  ConstantFoldingCache* cache = nullptr;
 };
 
 // Perform constant folding optimization on "graph".
@@ -261,6 +261,64 @@ TEST_F(ConstantFoldingTest, TestNoReplaceLargeConstant) {
   EXPECT_FALSE(was_mutated);
 }
 
+TEST_F(ConstantFoldingTest, TestNoEvaluateLargeOutput) {
+  auto build_graph = [](Graph* g) {
+    Scope s = Scope::NewRootScope();
+    auto dims = ops::Const<int>(s, {256, 1024});
+    auto fill = ops::Fill(s, dims, ops::Const<float>(s, 1.0f));
+    auto sum = ops::Sum(s, fill, ops::Const<int>(s, {0, 1}));
+    auto sum_send = ops::_Send(s.WithOpName("sum_send"), sum, "sum_send",
+                               "sender", 0, "receiver");
+    TF_ASSERT_OK(s.ToGraph(g));
+  };
+
+  // The 1MB Fill() is not evaluated, so neither is the Sum() that uses it.
+  Graph g(OpRegistry::Global());
+  build_graph(&g);
+  ConstantFoldingOptions opts;
+  opts.max_constant_size_in_bytes = 1024 * 1024 - 1;
+  bool was_mutated;
+  TF_EXPECT_OK(
+      ConstantFold(opts, nullptr, Env::Default(), nullptr, &g, &was_mutated));
+  EXPECT_FALSE(was_mutated);
+
+  Graph g2(OpRegistry::Global());
+  build_graph(&g2);
+  opts.max_constant_size_in_bytes = 1024 * 1024;
+  TF_EXPECT_OK(
+      ConstantFold(opts, nullptr, Env::Default(), nullptr, &g2, &was_mutated));
+  EXPECT_TRUE(was_mutated);
+  Node* sum_send = NodeNameIndex(g2).at("sum_send");
+  ExpectNodeClose<float>(*(sum_send->in_nodes().begin()), {256 * 1024}, {});
+}
+
+TEST_F(ConstantFoldingTest, ParallelAndCached) {
+  thread::ThreadPool thread_pool(Env::Default(), "constant_folding", 4);
+  ConstantFoldingCache cache(1024);
+  ConstantFoldingOptions opts;
+  opts.thread_pool = &thread_pool;
+  opts.cache = &cache;
+  for (int i = 0; i < 2; ++i) {
+    Scope s = Scope::NewRootScope();
+    BuildSimpleGraph(&s);
+    Graph g(OpRegistry::Global());
+    TF_ASSERT_OK(s.ToGraph(&g));
+
+    bool was_mutated;
+    TF_ASSERT_OK(
+        ConstantFold(opts, nullptr, Env::Default(), nullptr, &g, &was_mutated));
+    EXPECT_TRUE(was_mutated);
+    // The second graph reuses the constants folded in the first.
+    EXPECT_EQ(1, cache.size());
+
+    std::unordered_map<string, Node*> index = NodeNameIndex(g);
+    ExpectNodeClose<float>(*(index.at("s1")->in_nodes().begin()),
+                           {1.0, 2.0, 3.0, 4.0}, {2, 2});
+    ExpectNodeClose<float>(*(index.at("s2")->in_nodes().begin()),
+                           {2.0, 1.0, 4.0, 3.0}, {2, 2});
+  }
+}
+
 TEST_F(ConstantFoldingTest, TestNoReplaceFunctionCall) {
   FunctionDefLibrary flib;
   *flib.add_function() = test::function::XTimesTwo();
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/simple_placer.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/step_trace_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/graph.pb_text.h"
@@ -71,6 +74,92 @@ auto* direct_session_runs = monitoring::Counter<0>::New(
     "/tensorflow/core/direct_session_runs",
     "The number of times DirectSession::Run() has been called.");
 
+auto* direct_session_executor_reuses = monitoring::Counter<0>::New(
+    "/tensorflow/core/direct_session_executor_reuses",
+    "The number of Run signatures served by the executors of another "
+    "signature.");
+
+// The bytes of folded constants that a DirectSession caches.
+constexpr int64 kConstantFoldingCacheBytes = 64 << 20;
+
+// Collects the nodes that run in 'graph', apart from the ones carrying the
+// feeds and fetches, which differ between signatures.
+void CollectRunNodes(const Graph& graph, std::unordered_set<string>* run_nodes,
+                     int* num_stateful_run_nodes) {
+  for (const Node* n : graph.nodes()) {
+    if (!n->IsOp() || n->IsSend() || n->IsRecv() ||
+        n->type_string() == "_Arg" || n->type_string() == "_Retval") {
+      continue;
+    }
+    run_nodes->insert(n->name());
+    if (n->op_def().is_stateful()) ++*num_stateful_run_nodes;
+  }
+}
+
+// Runs the closures of a step on the thread that waits for the step, in
+// place of the inter-op thread pool.
+class CallerThreadRunner {
+ public:
+  void Schedule(std::function<void()> closure) {
+    mutex_lock l(mu_);
+    closures_.push_back(std::move(closure));
+    cv_.notify_one();
+  }
+
+  // Makes Run() return once it has run the closures scheduled so far.
+  void Stop() {
+    mutex_lock l(mu_);
+    stopped_ = true;
+    cv_.notify_one();
+  }
+
+  // Runs the scheduled closures until Stop() is called.  If 'timeout_in_ms'
+  // is positive and passes first, calls 'on_timeout' once and goes on
+  // running the closures, which must complete before the step is torn down.
+  void Run(int64 timeout_in_ms, const std::function<void()>& on_timeout) {
+    Env* env = Env::Default();
+    uint64 deadline_micros =
+        timeout_in_ms > 0 ? env->NowMicros() + timeout_in_ms * 1000 : 0;
+    std::deque<std::function<void()>> closures;
+    for (;;) {
+      bool timed_out = false;
+      {
+        mutex_lock l(mu_);
+        while (closures_.empty() && !stopped_ && !timed_out) {
+          if (deadline_micros == 0) {
+            cv_.wait(l);
+            continue;
+          }
+          const uint64 now_micros = env->NowMicros();
+          if (now_micros >= deadline_micros) {
+            timed_out = true;
+          } else {
+            WaitForMilliseconds(
+                &l, &cv_,
+                std::max<int64>(1, (deadline_micros - now_micros) / 1000));
+          }
+        }
+        if (closures_.empty() && stopped_) return;
+        closures.swap(closures_);
+      }
+      if (timed_out) {
+        deadline_micros = 0;
+        on_timeout();
+      }
+      for (std::function<void()>& closure : closures) {
+        closure();
+      }
+      closures.clear();
+    }
+  }
+
+ private:
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<std::function<void()>> closures_ GUARDED_BY(mu_);
+  bool stopped_ GUARDED_BY(mu_) = false;
+};
+
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
   const int32 t = options.config.inter_op_parallelism_threads();
   if (t != 0) return t;
@@ -116,6 +205,15 @@ string GetRendezvousKey(const string& tensor_name,
                          frame_iter.frame_id, ":", frame_iter.iter_id);
 }
 
+// Returns true if the step 'step_count' is among the 'fraction' of the
+// steps that are traced, spread evenly over the steps.
+bool IsSampledStep(double fraction, int64 step_count) {
+  if (fraction <= 0.0) return false;
+  if (fraction >= 1.0) return true;
+  return static_cast<int64>((step_count + 1) * fraction) >
+         static_cast<int64>(step_count * fraction);
+}
+
 }  // namespace
 
 class DirectSessionFactory : public SessionFactory {
@@ -226,6 +324,7 @@ DirectSession::DirectSession(const SessionOptions& options,
                              DirectSessionFactory* const factory)
     : options_(options),
       device_mgr_(device_mgr),
+      constant_folding_cache_(kConstantFoldingCacheBytes),
       factory_(factory),
       cancellation_manager_(new CancellationManager()),
       operation_timeout_in_ms_(options_.config.operation_timeout_in_ms()) {
@@ -331,12 +430,31 @@ Status DirectSession::MaybeInitializeExecutionState(
 
 Status DirectSession::Create(const GraphDef& graph) {
   if (graph.node_size() > 0) {
-    mutex_lock l(graph_def_lock_);
-    if (graph_created_) {
-      return errors::AlreadyExists(
-          "A Graph has already been created for this session.");
+    {
+      mutex_lock l(graph_def_lock_);
+      if (graph_created_) {
+        return errors::AlreadyExists(
+            "A Graph has already been created for this session.");
+      }
+      TF_RETURN_IF_ERROR(ExtendLocked(graph));
+    }
+    // Create the executors of the expected signatures, so that their first
+    // runs don't have to.
+    for (const RunSignature& signature :
+         options_.config.graph_options().warmup_signatures()) {
+      const std::vector<string> feeds(signature.feed().begin(),
+                                      signature.feed().end());
+      const std::vector<string> fetches(signature.fetch().begin(),
+                                        signature.fetch().end());
+      const std::vector<string> targets(signature.target().begin(),
+                                        signature.target().end());
+      DebugOptions debug_options;
+      RunStateArgs run_state_args(debug_options);
+      ExecutorsAndKeys* executors_and_keys;
+      TF_RETURN_IF_ERROR(GetOrCreateExecutors(thread_pools_[0], feeds, fetches,
+                                              targets, &executors_and_keys,
+                                              &run_state_args));
     }
-    return ExtendLocked(graph);
   }
   return Status::OK();
 }
@@ -429,8 +547,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   ExecutorsAndKeys* executors_and_keys;
   RunStateArgs run_state_args(run_options.debug_options());
 
-  Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
+  const int64 step_id = step_id_counter_.fetch_add(1);
 
   TF_RETURN_IF_ERROR(
       GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
@@ -440,7 +557,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   std::unique_ptr<DebuggerStateInterface> debugger_state;
   if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
     TF_RETURN_IF_ERROR(CreateDebuggerState(
-        run_options.debug_options(), args.step_id, executor_step_count,
+        run_options.debug_options(), step_id, executor_step_count,
         input_tensor_names, output_names, target_nodes, &debugger_state));
   }
 
@@ -467,34 +584,83 @@ Status DirectSession::Run(const RunOptions& run_options,
     return s;
   }
 
+  if (LogMemory::IsEnabled()) {
+    LogMemory::RecordStep(step_id, run_state_args.handle);
+  }
+  TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, &call_frame,
+                                 executors_and_keys, executor_step_count,
+                                 output_names, run_metadata));
+
+  // Receive outputs.
+  if (outputs) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    outputs->clear();
+    outputs->reserve(sorted_outputs.size());
+    for (const string& output_name : output_names) {
+      outputs->emplace_back(
+          std::move(sorted_outputs[executors_and_keys
+                                       ->output_name_to_index[output_name]]));
+    }
+  }
+
+  return Status::OK();
+}
+
+Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
+                                  FunctionCallFrame* call_frame,
+                                  ExecutorsAndKeys* executors_and_keys,
+                                  int64 executor_step_count,
+                                  const std::vector<string>& output_names,
+                                  RunMetadata* run_metadata) {
   // Create a run state and start execution.
-  RunState run_state(args.step_id, &devices_);
+  RunState run_state(step_id, &devices_);
   run_state.rendez = new IntraProcessRendezvous(device_mgr_.get());
   CancellationManager step_cancellation_manager;
-  args.call_frame = &call_frame;
+  Executor::Args args;
+  args.step_id = step_id;
+  args.call_frame = call_frame;
+
+  std::unique_ptr<CallerThreadRunner> caller_runner;
+  if (options_.config.run_steps_in_caller_thread()) {
+    caller_runner.reset(new CallerThreadRunner);
+  }
 
   // Start parallel Executors.
   const size_t num_executors = executors_and_keys->items.size();
   ExecutorBarrier* barrier = new ExecutorBarrier(
-      num_executors, run_state.rendez, [&run_state](const Status& ret) {
+      num_executors, run_state.rendez,
+      [&run_state, &caller_runner](const Status& ret) {
         {
           mutex_lock l(run_state.mu_);
           run_state.status.Update(ret);
         }
+        if (caller_runner) caller_runner->Stop();
         run_state.executors_done.Notify();
       });
 
   args.rendezvous = run_state.rendez;
   args.cancellation_manager = &step_cancellation_manager;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  if (caller_runner) {
+    CallerThreadRunner* runner = caller_runner.get();
+    args.runner = [runner](Executor::Args::Closure c) {
+      runner->Schedule(std::move(c));
+    };
+  } else {
+    thread::ThreadPool* pool =
+        thread_pools_[run_options.inter_op_thread_pool()];
+    args.runner = [this, pool](Executor::Args::Closure c) {
+      SchedClosure(pool, std::move(c));
+    };
+  }
   args.session_state = &session_state_;
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
-  if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
-  }
   args.sync_on_finish = sync_on_finish_;
 
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
@@ -516,6 +682,16 @@ Status DirectSession::Run(const RunOptions& run_options,
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
   }
+  std::unique_ptr<StepTraceCollector> step_trace_collector;
+  if (args.stats_collector == nullptr && run_metadata != nullptr &&
+      IsSampledStep(options_.config.graph_options().step_trace_fraction(),
+                    executor_step_count)) {
+    const int64 max_events =
+        options_.config.graph_options().step_trace_max_events();
+    step_trace_collector.reset(
+        new StepTraceCollector(max_events > 0 ? max_events : 1 << 16));
+    args.step_trace_collector = step_trace_collector.get();
+  }
 
 #if GOOGLE_CUDA
   std::unique_ptr<GPUTracer> tracer;
@@ -548,10 +724,21 @@ Status DirectSession::Run(const RunOptions& run_options,
     item.executor->RunAsync(args, barrier->Get());
   }
 
-  WaitForNotification(&run_state, &step_cancellation_manager,
-                      run_options.timeout_in_ms() > 0
-                          ? run_options.timeout_in_ms()
-                          : operation_timeout_in_ms_);
+  const int64 timeout_in_ms = run_options.timeout_in_ms() > 0
+                                  ? run_options.timeout_in_ms()
+                                  : operation_timeout_in_ms_;
+  if (caller_runner) {
+    caller_runner->Run(timeout_in_ms, [&run_state,
+                                       &step_cancellation_manager]() {
+      {
+        mutex_lock l(run_state.mu_);
+        run_state.status.Update(Status(error::DEADLINE_EXCEEDED,
+                                       "Timed out waiting for notification"));
+      }
+      step_cancellation_manager.StartCancel();
+    });
+  }
+  WaitForNotification(&run_state, &step_cancellation_manager, timeout_in_ms);
 
   if (!cancellation_manager_->DeregisterCallback(cancellation_token)) {
     // The step has been cancelled: make sure we don't attempt to receive the
@@ -568,29 +755,19 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 #endif  // GOOGLE_CUDA
 
+  if (step_trace_collector) {
+    if (step_trace_collector->num_dropped() > 0) {
+      VLOG(1) << "Dropped the trace of " << step_trace_collector->num_dropped()
+              << " node executions of step " << step_id;
+    }
+    step_trace_collector->ToStepStats(run_metadata->mutable_step_stats());
+  }
+
   {
     mutex_lock l(run_state.mu_);
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
-  // Receive outputs.
-  if (outputs) {
-    std::vector<Tensor> sorted_outputs;
-    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
-    if (errors::IsInternal(s)) {
-      return errors::InvalidArgument(s.error_message());
-    } else if (!s.ok()) {
-      return s;
-    }
-    outputs->clear();
-    outputs->reserve(sorted_outputs.size());
-    for (const string& output_name : output_names) {
-      outputs->emplace_back(
-          std::move(sorted_outputs[executors_and_keys
-                                       ->output_name_to_index[output_name]]));
-    }
-  }
-
   // Save the output tensors of this run we choose to keep.
   TF_RETURN_IF_ERROR(
       run_state.tensor_store.SaveTensors(output_names, &session_state_));
@@ -608,6 +785,15 @@ Status DirectSession::Run(const RunOptions& run_options,
     }
     args.stats_collector->BuildCostModel(&cost_model_manager_, device_to_graph);
 
+    if (options_.config.graph_options().use_cost_model_priorities()) {
+      for (const auto& item : executors_and_keys->items) {
+        std::vector<int64> priorities;
+        cost_model_manager_.FindOrCreateCostModel(item.graph)
+            ->LongestPathPriorities(*item.graph, &priorities);
+        item.executor->SetNodePriorities(std::move(priorities));
+      }
+    }
+
     // annotate stats onto cost graph.
     CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
     for (const auto& item : executors_and_keys->items) {
@@ -630,6 +816,162 @@ Status DirectSession::Run(const RunOptions& run_options,
   return Status::OK();
 }
 
+Status DirectSession::MakeCallable(const CallableOptions& callable_options,
+                                   CallableHandle* out_handle) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
+  }
+  const RunOptions& run_options = callable_options.run_options();
+  if (run_options.inter_op_thread_pool() < 0 ||
+      run_options.inter_op_thread_pool() >= thread_pools_.size()) {
+    return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
+                                   run_options.inter_op_thread_pool());
+  }
+  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
+    return errors::Unimplemented(
+        "Debug tensor watches are not supported by callables.");
+  }
+
+  std::shared_ptr<Callable> callable(new Callable);
+  callable->options = callable_options;
+  const std::vector<string> feed_names(callable_options.feed().begin(),
+                                       callable_options.feed().end());
+  callable->fetch_names.assign(callable_options.fetch().begin(),
+                               callable_options.fetch().end());
+  const std::vector<string> target_names(callable_options.target().begin(),
+                                         callable_options.target().end());
+
+  RunStateArgs run_state_args(run_options.debug_options());
+  std::unordered_set<Device*> fetch_devices;
+  for (const auto& feed_device : callable_options.feed_devices()) {
+    if (std::find(feed_names.begin(), feed_names.end(), feed_device.first) ==
+        feed_names.end()) {
+      return errors::InvalidArgument("Device given for ", feed_device.first,
+                                     ", which is not fed.");
+    }
+    Device* device;
+    TF_RETURN_IF_ERROR(device_mgr_->LookupDevice(feed_device.second, &device));
+    run_state_args.feed_devices[feed_device.first] = device->name();
+  }
+  for (const auto& fetch_device : callable_options.fetch_devices()) {
+    if (std::find(callable->fetch_names.begin(), callable->fetch_names.end(),
+                  fetch_device.first) == callable->fetch_names.end()) {
+      return errors::InvalidArgument("Device given for ", fetch_device.first,
+                                     ", which is not fetched.");
+    }
+    Device* device;
+    TF_RETURN_IF_ERROR(
+        device_mgr_->LookupDevice(fetch_device.second, &device));
+    run_state_args.fetch_devices[fetch_device.first] = device->name();
+    fetch_devices.insert(device);
+  }
+  callable->fetch_devices.assign(fetch_devices.begin(), fetch_devices.end());
+
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(
+      thread_pools_[run_options.inter_op_thread_pool()], feed_names,
+      callable->fetch_names, target_names, &callable->executors_and_keys,
+      &run_state_args));
+  for (const string& feed_name : feed_names) {
+    callable->feed_indices.push_back(
+        callable->executors_and_keys->input_name_to_index.at(feed_name));
+  }
+  for (const string& fetch_name : callable->fetch_names) {
+    callable->fetch_indices.push_back(
+        callable->executors_and_keys->output_name_to_index.at(fetch_name));
+  }
+
+  mutex_lock l(callables_lock_);
+  *out_handle = next_callable_handle_++;
+  callables_[*out_handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors,
+                                  RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+  std::shared_ptr<Callable> callable;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    callable = it->second;
+  }
+  if (feed_tensors.size() != callable->feed_indices.size()) {
+    return errors::InvalidArgument("Expected ", callable->feed_indices.size(),
+                                   " feed tensors, but got ",
+                                   feed_tensors.size());
+  }
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+  const int64 step_id = step_id_counter_.fetch_add(1);
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(feed_tensors.size());
+  for (size_t i = 0; i < feed_tensors.size(); ++i) {
+    if (feed_tensors[i].dtype() == DT_RESOURCE) {
+      TF_RETURN_IF_ERROR(ResourceHandleToInputTensor(
+          feed_tensors[i], &feed_args[callable->feed_indices[i]]));
+    } else {
+      feed_args[callable->feed_indices[i]] = feed_tensors[i];
+    }
+  }
+  Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  if (LogMemory::IsEnabled()) {
+    LogMemory::RecordStep(step_id, "");
+  }
+  RunMetadata unused_run_metadata;
+  TF_RETURN_IF_ERROR(RunInternal(
+      step_id, callable->options.run_options(), &call_frame,
+      executors_and_keys, executor_step_count, callable->fetch_names,
+      run_metadata != nullptr ? run_metadata : &unused_run_metadata));
+  // The kernels producing the fetched tensors in device memory may still be
+  // running on the device streams.
+  for (Device* device : callable->fetch_devices) {
+    TF_RETURN_IF_ERROR(device->Sync());
+  }
+
+  if (fetch_tensors != nullptr) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    fetch_tensors->resize(callable->fetch_indices.size());
+    for (size_t i = 0; i < callable->fetch_indices.size(); ++i) {
+      (*fetch_tensors)[i] =
+          std::move(sorted_outputs[callable->fetch_indices[i]]);
+    }
+  }
+  return Status::OK();
+}
+
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (callables_.erase(handle) == 0) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  return Status::OK();
+}
+
 Status DirectSession::PRunSetup(const std::vector<string>& input_names,
                                 const std::vector<string>& output_names,
                                 const std::vector<string>& target_nodes,
@@ -992,11 +1334,22 @@ Status DirectSession::GetOrCreateExecutors(
         run_state_args->debug_options.debug_tensor_watch_opts());
   }
 
+  string devices_summary;
+  for (const auto& feed_device : run_state_args->feed_devices) {
+    strings::StrAppend(&devices_summary, feed_device.first, "@",
+                       feed_device.second, ",");
+  }
+  strings::StrAppend(&devices_summary, "->");
+  for (const auto& fetch_device : run_state_args->fetch_devices) {
+    strings::StrAppend(&devices_summary, fetch_device.first, "@",
+                       fetch_device.second, ",");
+  }
+
   // Fast lookup path, no sorting.
   const string key = strings::StrCat(
       str_util::Join(inputs, ","), "->", str_util::Join(outputs, ","), "/",
       str_util::Join(target_nodes, ","), "/", run_state_args->is_partial_run,
-      "/", debug_tensor_watches_summary);
+      "/", debug_tensor_watches_summary, "/", devices_summary);
   // Set the handle, if it's needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1029,7 +1382,8 @@ Status DirectSession::GetOrCreateExecutors(
   const string sorted_key = strings::StrCat(
       str_util::Join(inputs_sorted, ","), "->",
       str_util::Join(outputs_sorted, ","), "/", str_util::Join(tn_sorted, ","),
-      "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary);
+      "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary,
+      "/", devices_summary);
   // Set the handle, if its needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1048,7 +1402,6 @@ Status DirectSession::GetOrCreateExecutors(
     }
   }
 
-  // Nothing found, so create the executors and store in the cache.
   BuildGraphOptions options;
   options.feed_endpoints = inputs_sorted;
   options.fetch_endpoints = outputs_sorted;
@@ -1057,8 +1410,43 @@ Status DirectSession::GetOrCreateExecutors(
   if (!run_state_args->debug_options.debug_tensor_watch_opts().empty()) {
     options.debug_options = run_state_args->debug_options;
   }
+  options.feed_devices.insert(run_state_args->feed_devices.begin(),
+                              run_state_args->feed_devices.end());
+  options.fetch_devices.insert(run_state_args->fetch_devices.begin(),
+                               run_state_args->fetch_devices.end());
+  // Executors that feed or fetch device memory can't run other signatures.
+  const bool reusable =
+      !run_state_args->is_partial_run &&
+      run_state_args->debug_options.debug_tensor_watch_opts().empty() &&
+      devices_summary == "->";
+
+  // The executors of another signature may run this one too, in which case
+  // this signature's graph is only pruned, not partitioned and optimized.
+  if (reusable) {
+    std::shared_ptr<ExecutorsAndKeys> covering =
+        FindCoveringExecutors(options);
+    if (covering != nullptr) {
+      direct_session_executor_reuses->GetCell()->IncrementBy(1);
+      mutex_lock l(executor_lock_);
+      auto insert_result = executors_.emplace(sorted_key, covering);
+      executors_.emplace(key, insert_result.first->second);
+      *executors_and_keys = insert_result.first->second.get();
+      return Status::OK();
+    }
+  }
 
+  // Nothing found, so create the executors and store in the cache.
   std::shared_ptr<ExecutorsAndKeys> ek(new ExecutorsAndKeys);
+  for (const string& input : inputs_sorted) {
+    ek->signature.add_feed(input);
+  }
+  for (const string& output : outputs_sorted) {
+    ek->signature.add_fetch(output);
+  }
+  for (const string& target : tn_sorted) {
+    ek->signature.add_target(target);
+  }
+  ek->reusable = reusable;
 
   // The executor_lock_ is intentionally released while executor is
   // being created.
@@ -1084,10 +1472,19 @@ Status DirectSession::GetOrCreateExecutors(
       }
     }
   }
+  if (ek->reusable) {
+    for (const auto& partition : graphs) {
+      CollectRunNodes(*partition.second, &ek->run_nodes,
+                      &ek->num_stateful_run_nodes);
+    }
+  }
   ek->items.reserve(graphs.size());
   const auto& optimizer_opts =
       options_.config.graph_options().optimizer_options();
-  GraphOptimizer optimizer(optimizer_opts);
+  ConstantFoldingOptions cf_opts;
+  cf_opts.thread_pool = thread_pools_[0];
+  cf_opts.cache = &constant_folding_cache_;
+  GraphOptimizer optimizer(optimizer_opts, cf_opts);
   for (auto iter = graphs.begin(); iter != graphs.end(); ++iter) {
     const string& partition_name = iter->first;
     std::unique_ptr<Graph>& partition_graph = iter->second;
@@ -1129,6 +1526,11 @@ Status DirectSession::GetOrCreateExecutors(
       }
     };
     params.node_outputs_cb = node_outputs_callback_;
+    if (optimizer_opts.use_work_stealing_executor()) {
+      params.num_work_stealing_workers = thread_pools_[0]->NumThreads();
+    }
+    params.use_step_arena_for_temps = optimizer_opts.use_step_arena_for_temps();
+    params.use_static_memory_plan = optimizer_opts.use_static_memory_plan();
 
     optimizer.Optimize(lib, options_.env, device, &iter->second);
 
@@ -1197,6 +1599,74 @@ Status DirectSession::GetOrCreateExecutors(
   return Status::OK();
 }
 
+std::shared_ptr<DirectSession::ExecutorsAndKeys>
+DirectSession::FindCoveringExecutors(const BuildGraphOptions& options) {
+  // Placing each pruned graph costs more than the executors it would save.
+  if (options_.config.graph_options().place_pruned_graph()) {
+    return nullptr;
+  }
+  std::vector<std::shared_ptr<ExecutorsAndKeys>> candidates;
+  {
+    mutex_lock l(executor_lock_);
+    std::unordered_set<const ExecutorsAndKeys*> seen;
+    for (const auto& entry : executors_) {
+      const ExecutorsAndKeys* ek = entry.second.get();
+      if (!ek->reusable || !seen.insert(ek).second) continue;
+      const RunSignature& signature = ek->signature;
+      if (static_cast<size_t>(signature.feed_size()) ==
+              options.feed_endpoints.size() &&
+          std::equal(options.feed_endpoints.begin(),
+                     options.feed_endpoints.end(), signature.feed().begin()) &&
+          std::includes(signature.fetch().begin(), signature.fetch().end(),
+                        options.fetch_endpoints.begin(),
+                        options.fetch_endpoints.end())) {
+        candidates.push_back(entry.second);
+      }
+    }
+  }
+  if (candidates.empty()) {
+    return nullptr;
+  }
+
+  std::unique_ptr<SimpleClientGraph> client_graph;
+  {
+    mutex_lock l(graph_def_lock_);
+    // An invalid signature is reported when creating its own executors.
+    if (!execution_state_->BuildGraph(options, &client_graph).ok()) {
+      return nullptr;
+    }
+  }
+  std::unordered_set<string> run_nodes;
+  int num_stateful_run_nodes = 0;
+  CollectRunNodes(client_graph->graph, &run_nodes, &num_stateful_run_nodes);
+  for (const auto& ek : candidates) {
+    // The executors must not run more stateful nodes than requested.
+    if (ek->num_stateful_run_nodes != num_stateful_run_nodes) continue;
+    bool covers = true;
+    for (const string& name : run_nodes) {
+      if (ek->run_nodes.count(name) == 0) {
+        covers = false;
+        break;
+      }
+    }
+    if (covers) return ek;
+  }
+  return nullptr;
+}
+
+std::vector<RunSignature> DirectSession::GetCachedSignatures() {
+  std::vector<RunSignature> signatures;
+  mutex_lock l(executor_lock_);
+  std::unordered_set<const ExecutorsAndKeys*> seen;
+  for (const auto& entry : executors_) {
+    const ExecutorsAndKeys* ek = entry.second.get();
+    if (ek->reusable && seen.insert(ek).second) {
+      signatures.push_back(ek->signature);
+    }
+  }
+  return signatures;
+}
+
 Status DirectSession::CreateGraphs(
     const BuildGraphOptions& subgraph_options,
     std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_DIRECT_SESSION_H_
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -41,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -91,6 +94,14 @@ class DirectSession : public Session {
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
 
+  ::tensorflow::Status MakeCallable(const CallableOptions& callable_options,
+                                    CallableHandle* out_handle) override;
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors,
+                                   RunMetadata* run_metadata) override;
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+
   // Reset clears 'containers' from the device_mgr of the DirectSession.
   // If 'containers' is empty, then Reset clears the default container.
   ::tensorflow::Status Reset(const std::vector<string>& containers);
@@ -101,6 +112,10 @@ class DirectSession : public Session {
     cost_model_manager_.ExportCostModels(cost_models);
   }
 
+  // Returns the signatures of the Run calls whose executors are cached, e.g.
+  // to be passed as the GraphOptions.warmup_signatures of a later session.
+  std::vector<RunSignature> GetCachedSignatures();
+
  private:
   typedef DirectSession ME;
 
@@ -121,6 +136,10 @@ class DirectSession : public Session {
   // 'input_keys' are the rendezvous keys for the feeds and 'output_keys'
   // are rendezvous keys for the fetches.
   // 'flib_def' is the function library used by graphs in 'items'.
+  // 'signature' is the sorted signature the executors were created for, and
+  // 'run_nodes' the nodes they run apart from the ones carrying the feeds and
+  // fetches. If 'reusable', they can also serve the signatures with the same
+  // feeds that run a subset of 'run_nodes' with the same stateful nodes.
   // TODO(phawkins): currently partitions always share the same function
   // library. Consider giving each partition its own function library to enable
   // per-partition rewrites.
@@ -139,6 +158,11 @@ class DirectSession : public Session {
 
     DataTypeVector input_types;
     DataTypeVector output_types;
+
+    RunSignature signature;
+    bool reusable = false;
+    std::unordered_set<string> run_nodes;
+    int num_stateful_run_nodes = 0;
   };
 
   // For each live partial execution, the session maintains a RunState.
@@ -168,6 +192,19 @@ class DirectSession : public Session {
     ~RunState();
   };
 
+  // A subgraph prepared by MakeCallable(). 'feed_indices' and 'fetch_indices'
+  // map the position of each feed and fetch of 'options' to its position in
+  // the call frame of 'executors_and_keys', which is owned by 'executors_'.
+  struct Callable {
+    CallableOptions options;
+    std::vector<string> fetch_names;
+    ExecutorsAndKeys* executors_and_keys = nullptr;
+    std::vector<size_t> feed_indices;
+    std::vector<size_t> fetch_indices;
+    // The devices to synchronize before the fetched tensors can be read.
+    std::vector<Device*> fetch_devices;
+  };
+
   struct RunStateArgs {
     RunStateArgs(const DebugOptions& options) : debug_options(options) {}
 
@@ -175,6 +212,10 @@ class DirectSession : public Session {
     string handle;
     std::unique_ptr<Graph> graph;
     const DebugOptions& debug_options;
+    // The devices of the feeds and fetches whose tensors are not in host
+    // memory, as in CallableOptions.
+    std::map<string, string> feed_devices;
+    std::map<string, string> fetch_devices;
   };
 
   // Initializes the base execution state given the 'graph',
@@ -190,6 +231,23 @@ class DirectSession : public Session {
       gtl::ArraySlice<string> outputs, gtl::ArraySlice<string> target_nodes,
       ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
 
+  // Runs the executors of 'executors_and_keys' for step 'step_id', feeding and
+  // fetching through 'call_frame', and saves the session tensors fetched by
+  // 'output_names'. Shared by Run() and RunCallable().
+  ::tensorflow::Status RunInternal(int64 step_id,
+                                   const RunOptions& run_options,
+                                   FunctionCallFrame* call_frame,
+                                   ExecutorsAndKeys* executors_and_keys,
+                                   int64 executor_step_count,
+                                   const std::vector<string>& output_names,
+                                   RunMetadata* run_metadata);
+
+  // Looks for cached executors that can run 'options', whose graph only
+  // needs to be pruned to check it, rather than partitioned and optimized.
+  // Returns nullptr if there are none.
+  std::shared_ptr<ExecutorsAndKeys> FindCoveringExecutors(
+      const BuildGraphOptions& options);
+
   // Creates several graphs given the existing graph_def_ and the
   // input feeds and fetches, given 'devices'. The graphs share a common
   // function library 'flib_def'.
@@ -268,6 +326,10 @@ class DirectSession : public Session {
   std::vector<thread::ThreadPool*> thread_pools_;
   bool owns_thread_pools_ = false;
 
+  // The constants folded in the partitions of the executors created so far,
+  // which the executors created later for other subgraphs reuse.
+  ConstantFoldingCache constant_folding_cache_;
+
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
   // Schedules 'c' for execution on pool.
@@ -286,6 +348,12 @@ class DirectSession : public Session {
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
       GUARDED_BY(executor_lock_);
 
+  // Holds mappings from handle to the subgraphs prepared by MakeCallable().
+  mutex callables_lock_;
+  std::unordered_map<CallableHandle, std::shared_ptr<Callable>> callables_
+      GUARDED_BY(callables_lock_);
+  CallableHandle next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+
   // This holds all the tensors that are currently alive in the session.
   SessionState session_state_;
 
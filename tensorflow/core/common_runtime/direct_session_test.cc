@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -107,6 +108,228 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunStepsInCallerThread) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.set_run_steps_in_caller_thread(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  for (int i = 0; i < 10; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, WarmupSignatures) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  RunSignature* signature =
+      options.config.mutable_graph_options()->add_warmup_signatures();
+  signature->add_fetch(y_ + ":0");
+  signature->add_target(y_neg_);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+
+  // The executors are created along with the graph.
+  std::vector<RunSignature> signatures = direct_session->GetCachedSignatures();
+  ASSERT_EQ(1, signatures.size());
+  ASSERT_EQ(1, signatures[0].fetch_size());
+  EXPECT_EQ(y_ + ":0", signatures[0].fetch(0));
+  ASSERT_EQ(1, signatures[0].target_size());
+  EXPECT_EQ(y_neg_, signatures[0].target(0));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {y_neg_}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_EQ(1, direct_session->GetCachedSignatures().size());
+}
+
+TEST_F(DirectSessionMinusAXTest, ReuseExecutorsOfCoveringSignature) {
+  Initialize({3, 2, -1, 0});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+
+  // Fetching a subset of the outputs, or running the same nodes as targets,
+  // reuses the executors of the first signature.
+  TF_ASSERT_OK(session->Run({}, {y_neg_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(-5.0, outputs[0].matrix<float>()(0, 0));
+  TF_ASSERT_OK(session->Run({}, {}, {y_neg_}, &outputs));
+  EXPECT_EQ(1, direct_session->GetCachedSignatures().size());
+
+  // The first signature doesn't fetch x.
+  TF_ASSERT_OK(session->Run({}, {x_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(1.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_EQ(2, direct_session->GetCachedSignatures().size());
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithStepArena) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_use_step_arena_for_temps(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The fetched outputs of earlier steps stay valid while later steps
+  // recycle their arenas.
+  std::vector<Tensor> all_outputs;
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    all_outputs.insert(all_outputs.end(), outputs.begin(), outputs.end());
+  }
+  for (int i = 0; i < all_outputs.size(); i += 2) {
+    EXPECT_FLOAT_EQ(5.0, all_outputs[i].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, all_outputs[i + 1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithStaticMemoryPlan) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_use_static_memory_plan(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The first step records the output sizes and later steps run from the
+  // slab. Fetched outputs keep their slots busy, so they stay valid while
+  // later steps allocate those outputs dynamically.
+  std::vector<Tensor> all_outputs;
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    all_outputs.insert(all_outputs.end(), outputs.begin(), outputs.end());
+  }
+  for (int i = 0; i < all_outputs.size(); i += 2) {
+    EXPECT_FLOAT_EQ(5.0, all_outputs[i].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, all_outputs[i + 1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, TestConcurrencyWithStaticMemoryPlan) {
+  Initialize({1, 2, 3, 4});
+  SessionOptions options;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_use_static_memory_plan(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Concurrent steps return several ExecutorStates to the pool, all but one
+  // of which drop their slabs there.
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+  std::vector<string> output_names = {y_ + ":0"};
+  auto fn = [&session, output_names]() {
+    for (int i = 0; i < 100; ++i) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+      ASSERT_EQ(1, outputs.size());
+      EXPECT_FLOAT_EQ(3.0, outputs[0].matrix<float>()(0, 0));
+    }
+  };
+  for (int i = 0; i < 4; ++i) {
+    tp->Schedule(fn);
+  }
+
+  // Wait for the functions to finish.
+  delete tp;
+}
+
+TEST(DirectSessionTest, ConcatInputsWrittenInPlaceWithStaticMemoryPlan) {
+  Graph g(OpRegistry::Global());
+  Tensor x_value(DT_FLOAT, TensorShape({16, 16}));
+  x_value.flat<float>().setConstant(1.0f);
+  Node* x = test::graph::Constant(&g, x_value);
+  Tensor w_value(DT_FLOAT, TensorShape({16, 16}));
+  w_value.flat<float>().setConstant(2.0f);
+  Node* w = test::graph::Constant(&g, w_value);
+  Node* axis = test::graph::Constant(&g, test::AsScalar<int32>(0));
+  // The outputs of both Negs are only consumed by the Concat, so once the
+  // sizes are known they are written directly into its output.
+  Node* concat = test::graph::ConcatV2(
+      &g,
+      {test::graph::Unary(&g, "Neg", x), test::graph::Unary(&g, "Neg", w)},
+      axis);
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_use_static_memory_plan(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // Feeding x with fewer rows than in the first step moves the second
+  // input of the Concat away from the place that the plan gave it.
+  for (const int rows : {16, 16, 8, 24, 16}) {
+    Tensor x_feed(DT_FLOAT, TensorShape({rows, 16}));
+    x_feed.flat<float>().setConstant(1.0f);
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{x->name(), x_feed}}, {concat->name() + ":0"},
+                              {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    Tensor expected(DT_FLOAT, TensorShape({rows + 16, 16}));
+    auto expected_flat = expected.flat<float>();
+    for (int i = 0; i < expected_flat.size(); ++i) {
+      expected_flat(i) = i < rows * 16 ? -1.0f : -2.0f;
+    }
+    test::ExpectTensorEqual<float>(expected, outputs[0]);
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithCostModelPriorities) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()->set_build_cost_model(2);
+  options.config.mutable_graph_options()->set_use_cost_model_priorities(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Every other step rebuilds the cost model and the priorities of the
+  // steps that follow.
+  for (int i = 0; i < 5; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {y_ + ":0", y_neg_ + ":0"}, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(-5.0, outputs[1].matrix<float>()(0, 0));
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, TestFeed) {
   Initialize({1, 2, 3, 4});
   std::unique_ptr<Session> session(CreateSession());
@@ -136,6 +359,42 @@ TEST_F(DirectSessionMinusAXTest, TestFeed) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunCallable) {
+  Initialize({1, 2, 3, 4});
+  std::unique_ptr<Session> session(CreateSession());
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  CallableOptions callable_options;
+  callable_options.add_feed(x_);
+  callable_options.add_fetch(y_neg_ + ":0");
+  callable_options.add_fetch(y_ + ":0");
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    test::FillValues<float>(&t, {5.0f + i, 6});
+    TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs, nullptr));
+
+    // The outputs are in the order of the fetches.
+    ASSERT_EQ(2, outputs.size());
+    EXPECT_FLOAT_EQ(-(17.0 + i), outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(17.0 + i, outputs[1].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(39.0 + 3 * i, outputs[1].matrix<float>()(1, 0));
+  }
+
+  // The number of feed tensors must match the feeds of the callable.
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->RunCallable(handle, {}, &outputs, nullptr)));
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      session->RunCallable(handle, {}, &outputs, nullptr)));
+  EXPECT_TRUE(errors::IsInvalidArgument(session->ReleaseCallable(handle)));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   std::unique_ptr<Session> session(CreateSession());
@@ -293,6 +552,42 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithSampledStepTrace) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()->set_step_trace_fraction(0.5);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Every other step is traced.
+  int num_traced_steps = 0;
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(RunOptions(), {}, {y_ + ":0"}, {y_neg_},
+                              &outputs, &run_metadata));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    if (run_metadata.step_stats().dev_stats_size() == 0) continue;
+    ++num_traced_steps;
+    EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
+    for (const DeviceStepStats& dev_stats :
+         run_metadata.step_stats().dev_stats()) {
+      for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+        EXPECT_FALSE(node_stats.node_name().empty());
+        EXPECT_GT(node_stats.all_start_micros(), 0);
+        EXPECT_LE(node_stats.op_start_rel_micros(),
+                  node_stats.op_end_rel_micros());
+        EXPECT_LE(node_stats.op_end_rel_micros(),
+                  node_stats.all_end_rel_micros());
+      }
+    }
+  }
+  EXPECT_EQ(2, num_traced_steps);
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -1161,7 +1456,8 @@ TEST(DirectSessionTest, TestDirectSessionReset) {
 
 // A simple benchmark for the overhead of `DirectSession::Run()` calls
 // with varying numbers of feeds/fetches.
-void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
+void FeedFetchBenchmarkHelper(int iters, int num_feeds,
+                              bool run_steps_in_caller_thread) {
   testing::StopTiming();
 
   Tensor value(DT_FLOAT, TensorShape());
@@ -1195,6 +1491,7 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
   GraphDef gd;
   g.ToGraphDef(&gd);
   SessionOptions opts;
+  opts.config.set_run_steps_in_caller_thread(run_steps_in_caller_thread);
   std::unique_ptr<Session> sess(NewSession(opts));
   TF_CHECK_OK(sess->Create(gd));
   {
@@ -1216,10 +1513,14 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
 }
 
 void BM_FeedFetch(int iters, int num_feeds) {
-  FeedFetchBenchmarkHelper(iters, num_feeds);
+  FeedFetchBenchmarkHelper(iters, num_feeds, false);
+}
+void BM_FeedFetchInCallerThread(int iters, int num_feeds) {
+  FeedFetchBenchmarkHelper(iters, num_feeds, true);
 }
 
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_FeedFetchInCallerThread)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
 }  // namespace
 }  // namespace tensorflow
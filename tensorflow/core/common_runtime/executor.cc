@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -24,7 +25,11 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/step_trace_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -37,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_segment.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -50,6 +56,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
@@ -66,6 +73,27 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Block size of the per-step arenas for temporaries. Temporaries of up to
+// a quarter of this are carved out of shared blocks; larger ones come from
+// the device allocator.
+static const size_t kStepArenaBlockSize = 256 << 10;
+
+// Returns a new arena for the temporaries of the kernels on 'device'.
+StepArenaAllocator* NewStepArena(Device* device) {
+  return new StepArenaAllocator(kStepArenaBlockSize,
+                                device->GetAllocator(AllocatorAttributes()));
+}
+
+auto* op_compute_time_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/op_compute_time_usecs",
+     "The time to compute each kernel, by op type.", "op"},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+
+auto* node_scheduling_delay_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/executor/node_scheduling_delay_usecs",
+     "The time from a node becoming ready to its kernel starting."},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -152,6 +180,12 @@ void SetOutput(NodeExecStats* nt, int slot, const Tensor* v) {
   v->FillDescription(no->mutable_tensor_description());
 }
 
+void RecordSchedulingDelay(int64 scheduled_usec, int64 start_usec) {
+  static monitoring::SamplerCell* const cell =
+      node_scheduling_delay_usecs->GetCell();
+  if (scheduled_usec > 0) cell->Add(start_usec - scheduled_usec);
+}
+
 void SetMemory(NodeExecStats* nt, OpKernelContext* ctx) {
   for (const auto& allocator_pair : ctx->wrapped_allocators()) {
     AllocatorMemoryUsed* memory = nt->add_memory();
@@ -193,10 +227,13 @@ void SetReferencedTensors(NodeExecStats* nt,
 }  // namespace nodestats
 
 class ExecutorImpl;
+class ExecutorState;
 class GraphView;
 
 struct EdgeInfo {
-  int dst_id;
+  // Byte offset of the NodeItem of the destination in GraphView::space_,
+  // so that activating an edge needs no lookup by node id.
+  uint32 dst_offset;
   int output_slot : 31;
   // true if this is the last info for output_slot in the EdgeInfo list.
   bool is_last : 1;
@@ -212,6 +249,9 @@ struct NodeItem {
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
+  // The compute time metric of the op of this node.
+  monitoring::SamplerCell* compute_time_cell = nullptr;
+
   bool kernel_is_expensive : 1;  // True iff kernel->IsExpensive()
   bool kernel_is_async : 1;      // True iff kernel->AsAsync() != nullptr
   bool is_merge : 1;             // True iff IsMerge(node)
@@ -221,6 +261,12 @@ struct NodeItem {
   bool is_sink : 1;              // True iff IsSink(node)
   // True iff IsEnter(node) || IsExit(node) || IsNextIteration(node)
   bool is_enter_exit_or_next_iter : 1;
+  // True iff this node and the destination of its only output edge are
+  // both inexpensive, synchronous, non-control-flow nodes, and that edge
+  // is the destination's only input. The destination is then run right
+  // after this node in the same thread, as part of a chain, without any
+  // pending-count or frame bookkeeping (see ExecutorState::Process).
+  bool has_inline_successor : 1;
 
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
@@ -231,7 +277,12 @@ struct NodeItem {
   // for this node.
   int input_start = 0;
 
-  // Number of output edges.
+  // Index of the 1st output of this node in per-output tables that span
+  // the whole graph, such as OutputMemoryPlan::output_slots.
+  int output_start = 0;
+
+  // Number of output edges, not counting the edges into the sink node,
+  // which is never run.
   size_t num_output_edges;
 
   PendingCounts::Handle pending_id;
@@ -316,6 +367,11 @@ class GraphView {
                 : reinterpret_cast<NodeItem*>(space_ + node_offsets_[id]));
   }
 
+  // Returns the destination of an output edge of a NodeItem.
+  NodeItem* dst(const EdgeInfo& e) const {
+    return reinterpret_cast<NodeItem*>(space_ + e.dst_offset);
+  }
+
  private:
   char* InitializeNode(char* ptr, const Node* n);
   size_t NodeItemBytes(const Node* n);
@@ -337,18 +393,7 @@ class ExecutorImpl : public Executor {
     CHECK(p.delete_kernel != nullptr);
   }
 
-  ~ExecutorImpl() override {
-    for (int i = 0; i < graph_->num_node_ids(); i++) {
-      NodeItem* item = gview_.node(i);
-      if (item != nullptr) {
-        params_.delete_kernel(item->kernel);
-      }
-    }
-    for (auto fiter : frame_info_) {
-      delete fiter.second;
-    }
-    delete graph_;
-  }
+  ~ExecutorImpl() override;
 
   Status Initialize();
 
@@ -359,6 +404,8 @@ class ExecutorImpl : public Executor {
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
+  void SetNodePriorities(std::vector<int64> priorities) override;
+
  private:
   friend class ExecutorState;
 
@@ -397,10 +444,77 @@ class ExecutorImpl : public Executor {
     }
   };
 
+  // Returns the ExecutorState of a completed step to the pool for reuse
+  // by a later step, or deletes it if the pool is full. At most one pooled
+  // state keeps its StaticMemorySlab, so the pool holds at most one slab
+  // however many states it has, and the slabs alive at any time are at
+  // most one per running step plus one.
+  // REQUIRES: is_loop_free_.
+  void ReleaseState(ExecutorState* state) const;
+
   static Status BuildControlFlowInfo(const Graph* graph,
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
 
+  // Sets NodeItem::has_inline_successor for every node that links two
+  // cheap nodes of a straight-line chain.
+  void FindInlineChains();
+
+  // The outputs that a StaticMemorySlab may serve, and their slots.
+  struct OutputMemoryPlan {
+    // True until the output sizes are known. Each candidate output then
+    // has its own empty slot, whose allocator falls back to the device
+    // allocator and records the size of the output.
+    bool is_profile = false;
+    StaticMemoryPlan plan;
+    // output_slots[item.output_start + i] is the slot of output i of the
+    // node of "item", or -1 if the output is allocated dynamically.
+    std::vector<int> output_slots;
+    // output_parts[item.output_start + i] is the part of a slot that
+    // output i of the node of "item" is written into in place, or -1.
+    std::vector<int> output_parts;
+    // True for the outputs that their slot's parts are written for.
+    std::vector<bool> owns_parts;
+
+    // A Concat along dimension 0, whose inputs could be written in place
+    // into its output. Outputs are given as indices into per-output
+    // tables.
+    struct Concat {
+      int output;
+      std::vector<int> inputs;
+      std::vector<int> input_nodes;
+      // True for the inputs whose only consumer is the Concat.
+      std::vector<bool> in_place;
+    };
+    // Only in the profiling plan.
+    std::vector<Concat> concats;
+  };
+
+  // If params_.use_static_memory_plan and the graph is loop-free, sets
+  // memory_plan_ to a profiling plan for every output that
+  // allocate_output() could take from a slab.
+  void InitializeMemoryPlan();
+
+  // Adds to "profile" the Concats whose inputs may be written into their
+  // output if the sizes recorded by the profile line up.
+  void FindInPlaceConcats(OutputMemoryPlan* profile) const;
+
+  std::shared_ptr<const OutputMemoryPlan> memory_plan() const {
+    mutex_lock l(memory_plan_mu_);
+    return memory_plan_;
+  }
+
+  // Replaces the profiling plan "profile" by a static memory plan for the
+  // output sizes "requested_bytes" (per slot of "profile") that a step
+  // recorded. Does nothing if the plan was already replaced.
+  void UpdateMemoryPlan(const OutputMemoryPlan& profile,
+                        const std::vector<int64>& requested_bytes) const;
+
+  std::shared_ptr<const std::vector<int64>> node_priorities() const {
+    mutex_lock l(node_priorities_mu_);
+    return node_priorities_;
+  }
+
   FrameInfo* EnsureFrameInfo(const string& fname) {
     auto slot = &frame_info_[fname];
     if (*slot == nullptr) {
@@ -425,6 +539,39 @@ class ExecutorImpl : public Executor {
   // the overhead of constructing it for each executor instance.
   gtl::FlatMap<string, FrameInfo*, HashStr> frame_info_;
 
+  // True iff the graph has no frames other than the root frame. All the
+  // per-step state of such a graph lives in a single root frame and
+  // iteration, so whole ExecutorStates are recycled across steps rather
+  // than rebuilt by every RunAsync().
+  bool is_loop_free_ = false;
+
+  // ExecutorStates of completed steps, ready to be Reset() for reuse.
+  // Only used when is_loop_free_. Only the back one may hold a slab, so
+  // that the next step reuses it.
+  mutable mutex state_pool_mu_;
+  mutable std::vector<ExecutorState*> state_pool_ GUARDED_BY(state_pool_mu_);
+
+  // True iff params_.use_step_arena_for_temps and the device is a CPU
+  // device, whose temporaries can then live in host memory from a
+  // StepArenaAllocator.
+  bool use_step_arena_ = false;
+
+  // Total number of outputs of all nodes in the graph.
+  int total_outputs_ = 0;
+
+  // Null unless static memory planning is enabled. ExecutorStates build
+  // their StaticMemorySlabs from the current plan.
+  mutable mutex memory_plan_mu_;
+  mutable std::shared_ptr<const OutputMemoryPlan> memory_plan_
+      GUARDED_BY(memory_plan_mu_);
+
+  // The priorities set by SetNodePriorities(), indexed by node id, or null
+  // for the default order. Each step schedules with the priorities it
+  // started with.
+  mutable mutex node_priorities_mu_;
+  std::shared_ptr<const std::vector<int64>> node_priorities_
+      GUARDED_BY(node_priorities_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -453,8 +600,17 @@ GraphView::~GraphView() {
   delete[] space_;
 }
 
+// Returns the number of out edges of "n" that NodeItem keeps.
+static size_t NumOutputEdges(const Node* n) {
+  size_t num_output_edges = 0;
+  for (const Edge* e : n->out_edges()) {
+    if (!e->dst()->IsSink()) ++num_output_edges;
+  }
+  return num_output_edges;
+}
+
 size_t GraphView::NodeItemBytes(const Node* n) {
-  const size_t num_output_edges = n->out_edges().size();
+  const size_t num_output_edges = NumOutputEdges(n);
   const int num_inputs = n->num_inputs();
   const int num_outputs = n->num_outputs();
 
@@ -487,24 +643,16 @@ size_t GraphView::NodeItemBytes(const Node* n) {
 
 char* GraphView::InitializeNode(char* ptr, const Node* n) {
   const int id = n->id();
-  CHECK(node_offsets_[id] == kuint32max);  // Initial value in constructor
+  // Assigned by Initialize() before any NodeItem is initialized.
+  CHECK_EQ(node_offsets_[id], static_cast<uint32>(ptr - space_));
 
   const size_t bytes = NodeItemBytes(n);
   constexpr size_t kItemAlignment = sizeof(NodeItem*);
   CHECK_EQ(reinterpret_cast<uintptr_t>(ptr) % kItemAlignment, 0);
   NodeItem* item = reinterpret_cast<NodeItem*>(ptr);
-
-  // We store a 32-bit offset relative to the beginning of space_, so that we
-  // only need an array of 32-bit values to map from node id to the NodeItem*,
-  // (versus 64 bits on most machines if we just stored an array of NodeItem*
-  // pointers). Casting to int64 is needed on 32bit CPU to avoid comparing
-  // values as "int" vs "size_t" in CHECK_LE.
-  CHECK_LE(static_cast<int64>(ptr - space_), kuint32max);
-  const uint32 offset = static_cast<uint32>(ptr - space_);
-  node_offsets_[id] = offset;
   ptr += bytes;
 
-  const size_t num_output_edges = n->out_edges().size();
+  const size_t num_output_edges = NumOutputEdges(n);
   const int num_inputs = n->num_inputs();
   const int num_outputs = n->num_outputs();
 
@@ -521,7 +669,8 @@ char* GraphView::InitializeNode(char* ptr, const Node* n) {
   gtl::InlinedVector<EdgeInfo*, 4> last_indices(num_outputs, nullptr);
   EdgeInfo* dst_edge = item->output_edge_base();
   for (auto e : n->out_edges()) {
-    dst_edge->dst_id = e->dst()->id();
+    if (e->dst()->IsSink()) continue;
+    dst_edge->dst_offset = node_offsets_[e->dst()->id()];
     CHECK_LE(e->src_output(), ((int32)0x3FFFFFFF));  // Must fit in 31 bits
     dst_edge->output_slot = e->src_output();
     dst_edge->is_last = false;
@@ -562,16 +711,26 @@ void GraphView::Initialize(const Graph* g) {
   CHECK(node_offsets_ == nullptr);
   const int num_nodes = g->num_node_ids();
   num_nodes_ = num_nodes;
-  size_t total_bytes = 0;
-  for (const Node* n : g->nodes()) {
-    total_bytes += NodeItemBytes(n);
-  }
-
   node_offsets_ = new uint32[num_nodes];
   for (int i = 0; i < num_nodes; i++) {
     node_offsets_[i] = kuint32max;
   }
 
+  // The offsets of all the NodeItems are assigned first, so that the
+  // output edges can refer to their destinations by offset.
+  //
+  // We store a 32-bit offset relative to the beginning of space_, so that we
+  // only need an array of 32-bit values to map from node id to the NodeItem*,
+  // (versus 64 bits on most machines if we just stored an array of NodeItem*
+  // pointers). Casting to int64 is needed on 32bit CPU to avoid comparing
+  // values as "int" vs "size_t" in CHECK_LE.
+  size_t total_bytes = 0;
+  for (const Node* n : g->nodes()) {
+    CHECK_LE(static_cast<int64>(total_bytes), kuint32max);
+    node_offsets_[n->id()] = static_cast<uint32>(total_bytes);
+    total_bytes += NodeItemBytes(n);
+  }
+
   space_ = new char[total_bytes];  // NodeItem objects are allocated here
   char* ptr = space_;
   for (const Node* n : g->nodes()) {
@@ -636,6 +795,8 @@ Status ExecutorImpl::Initialize() {
 
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
+    item->output_start = total_outputs_;
+    total_outputs_ += n->num_outputs();
 
     Status s = params_.create_kernel(n->def(), &item->kernel);
     if (!s.ok()) {
@@ -645,6 +806,7 @@ Status ExecutorImpl::Initialize() {
       return s;
     }
     CHECK(item->kernel);
+    item->compute_time_cell = op_compute_time_usecs->GetCell(n->type_string());
     item->kernel_is_expensive = item->kernel->IsExpensive();
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
     item->is_merge = IsMerge(n);
@@ -654,6 +816,7 @@ Status ExecutorImpl::Initialize() {
     item->is_sink = IsSink(n);
     item->is_enter_exit_or_next_iter =
         (IsEnter(n) || IsExit(n) || IsNextIteration(n));
+    item->has_inline_successor = false;
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -676,8 +839,236 @@ Status ExecutorImpl::Initialize() {
   // Initialize PendingCounts only after item->pending_id is initialized for
   // all nodes.
   InitializePending(graph_, cf_info);
+  FindInlineChains();
+  is_loop_free_ = (frame_info_.size() == 1);
+  use_step_arena_ = params_.use_step_arena_for_temps &&
+                    params_.device->device_type() == DEVICE_CPU;
 
-  return gview_.SetAllocAttrs(graph_, params_.device);
+  TF_RETURN_IF_ERROR(gview_.SetAllocAttrs(graph_, params_.device));
+  InitializeMemoryPlan();
+  return Status::OK();
+}
+
+void ExecutorImpl::InitializeMemoryPlan() {
+  if (!params_.use_static_memory_plan || !is_loop_free_) return;
+  auto profile = std::make_shared<OutputMemoryPlan>();
+  profile->is_profile = true;
+  profile->output_slots.assign(total_outputs_, -1);
+  profile->output_parts.assign(total_outputs_, -1);
+  profile->owns_parts.assign(total_outputs_, false);
+  for (const Node* n : graph_->nodes()) {
+    const NodeItem* item = gview_.node(n->id());
+    for (int i = 0; i < item->num_outputs; ++i) {
+      const DataType dtype = item->output_type(i);
+      // Only plain device memory is planned; host-memory outputs and
+      // types whose elements own memory are allocated dynamically.
+      if (IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype) ||
+          item->output_attrs()[i].value != 0) {
+        continue;
+      }
+      profile->output_slots[item->output_start + i] =
+          profile->plan.slot_sizes.size();
+      profile->plan.slot_sizes.push_back(0);
+      profile->plan.slot_offsets.push_back(0);
+    }
+  }
+  FindInPlaceConcats(profile.get());
+  mutex_lock l(memory_plan_mu_);
+  memory_plan_ = std::move(profile);
+}
+
+// Returns true iff "n" is a Concat or ConcatV2 whose axis is the constant
+// 0, and sets "values" to its data input edges in order.
+static bool IsConcatOfRows(const Node* n, std::vector<const Edge*>* values) {
+  int axis_input;
+  int num_values;
+  if (n->type_string() == "Concat") {
+    axis_input = 0;
+  } else if (n->type_string() == "ConcatV2") {
+    axis_input = n->num_inputs() - 1;
+  } else {
+    return false;
+  }
+  if (!GetNodeAttr(n->def(), "N", &num_values).ok() ||
+      num_values + 1 != n->num_inputs()) {
+    return false;
+  }
+  std::vector<const Edge*> inputs(n->num_inputs(), nullptr);
+  for (const Edge* e : n->in_edges()) {
+    if (!e->IsControlEdge()) inputs[e->dst_input()] = e;
+  }
+  for (const Edge* e : inputs) {
+    if (e == nullptr) return false;
+  }
+  const Node* axis = inputs[axis_input]->src();
+  const TensorProto* value;
+  Tensor axis_tensor;
+  if (axis->type_string() != "Const" ||
+      !GetNodeAttr(axis->def(), "value", &value).ok() ||
+      !axis_tensor.FromProto(*value) || axis_tensor.dtype() != DT_INT32 ||
+      axis_tensor.NumElements() != 1 || axis_tensor.flat<int32>()(0) != 0) {
+    return false;
+  }
+  inputs.erase(inputs.begin() + axis_input);
+  values->swap(inputs);
+  return true;
+}
+
+void ExecutorImpl::FindInPlaceConcats(OutputMemoryPlan* profile) const {
+  std::vector<const Edge*> values;
+  for (const Node* n : graph_->nodes()) {
+    const int output = gview_.node(n->id())->output_start;
+    if (!IsConcatOfRows(n, &values) || profile->output_slots[output] < 0) {
+      continue;
+    }
+    OutputMemoryPlan::Concat concat;
+    concat.output = output;
+    bool any_in_place = false;
+    for (const Edge* e : values) {
+      const Node* src = e->src();
+      const int input = gview_.node(src->id())->output_start + e->src_output();
+      int num_consumers = 0;
+      for (const Edge* out : src->out_edges()) {
+        if (!out->IsControlEdge() && out->src_output() == e->src_output()) {
+          ++num_consumers;
+        }
+      }
+      // An output that is also consumed elsewhere, or twice by the
+      // Concat, must keep a buffer of its own.
+      const bool in_place = num_consumers == 1 &&
+                            profile->output_slots[input] >= 0 &&
+                            !IsTransferNode(src);
+      concat.inputs.push_back(input);
+      concat.input_nodes.push_back(src->id());
+      concat.in_place.push_back(in_place);
+      any_in_place |= in_place;
+    }
+    if (any_in_place) profile->concats.push_back(std::move(concat));
+  }
+}
+
+void ExecutorImpl::UpdateMemoryPlan(
+    const OutputMemoryPlan& profile,
+    const std::vector<int64>& requested_bytes) const {
+  {
+    mutex_lock l(memory_plan_mu_);
+    if (memory_plan_.get() != &profile) return;
+  }
+  auto output_bytes = [&profile, &requested_bytes](int output) -> int64 {
+    const int slot = profile.output_slots[output];
+    return slot < 0 ? 0 : requested_bytes[slot];
+  };
+
+  // Lay out the inputs of each Concat along dimension 0 in its output,
+  // back to back as the Concat would copy them. An input is written in
+  // place if its offset keeps the alignment that kernels expect and it
+  // does not own parts itself; then it needs no buffer of its own, and
+  // its producer becomes a writer of the Concat's buffer.
+  std::vector<bool> is_concat(total_outputs_, false);
+  for (const auto& concat : profile.concats) {
+    is_concat[concat.output] = true;
+  }
+  std::vector<int> part_owner(total_outputs_, -1);
+  std::vector<int64> part_offset(total_outputs_, 0);
+  std::unordered_map<int, std::vector<int>> writers;
+  for (const auto& concat : profile.concats) {
+    std::vector<int> in_place;
+    std::vector<int64> offsets;
+    int64 offset = 0;
+    for (size_t k = 0; k < concat.inputs.size(); ++k) {
+      const int input = concat.inputs[k];
+      const int64 bytes = output_bytes(input);
+      if (concat.in_place[k] && bytes > 0 && !is_concat[input] &&
+          offset % Allocator::kAllocatorAlignment == 0) {
+        in_place.push_back(k);
+        offsets.push_back(offset);
+      }
+      offset += bytes;
+    }
+    // The recorded sizes do not add up, e.g. because an input was not
+    // allocated through a slot, so the layout is unknown.
+    if (in_place.empty() || offset != output_bytes(concat.output)) continue;
+    for (size_t j = 0; j < in_place.size(); ++j) {
+      const int k = in_place[j];
+      part_owner[concat.inputs[k]] = concat.output;
+      part_offset[concat.inputs[k]] = offsets[j];
+      writers[concat.output].push_back(concat.input_nodes[k]);
+    }
+  }
+
+  std::vector<PlannedBuffer> buffers;
+  std::vector<int> buffer_outputs;
+  int64 total_bytes = 0;
+  for (const Node* n : graph_->nodes()) {
+    const NodeItem* item = gview_.node(n->id());
+    for (int i = 0; i < item->num_outputs; ++i) {
+      const int output = item->output_start + i;
+      const int64 bytes = output_bytes(output);
+      if (bytes == 0 || part_owner[output] >= 0) continue;
+      buffers.push_back({n->id(), i, bytes, {}});
+      auto it = writers.find(output);
+      if (it != writers.end()) buffers.back().writer_node_ids = it->second;
+      buffer_outputs.push_back(output);
+      total_bytes += bytes;
+    }
+  }
+  auto plan = std::make_shared<OutputMemoryPlan>();
+  plan->output_slots.assign(total_outputs_, -1);
+  plan->output_parts.assign(total_outputs_, -1);
+  plan->owns_parts.assign(total_outputs_, false);
+  Status s = PlanStaticMemory(*graph_, buffers, &plan->plan);
+  if (s.ok()) {
+    for (size_t b = 0; b < buffers.size(); ++b) {
+      plan->output_slots[buffer_outputs[b]] = plan->plan.buffer_slots[b];
+    }
+    for (int output = 0; output < total_outputs_; ++output) {
+      const int owner = part_owner[output];
+      if (owner < 0) continue;
+      plan->output_parts[output] = plan->plan.slot_parts.size();
+      plan->plan.slot_parts.push_back({plan->output_slots[owner],
+                                       part_offset[output],
+                                       output_bytes(output)});
+      plan->owns_parts[owner] = true;
+    }
+    VLOG(1) << "Static memory plan for " << buffers.size() << " outputs ("
+            << total_bytes << " bytes) uses " << plan->plan.slot_sizes.size()
+            << " slots in a slab of " << plan->plan.slab_bytes
+            << " bytes; " << plan->plan.slot_parts.size()
+            << " outputs are written into Concat outputs in place";
+  } else {
+    // Keep the empty plan, so that every output is allocated dynamically.
+    LOG(WARNING) << "Static memory planning disabled: " << s;
+  }
+  mutex_lock l(memory_plan_mu_);
+  if (memory_plan_.get() == &profile) {
+    memory_plan_ = std::move(plan);
+  }
+}
+
+// Returns true iff "item" may be part of an inline chain: it is cheap
+// enough to never be worth dispatching to another thread, completes
+// synchronously, and its activation needs no special handling.
+static bool IsChainable(const NodeItem& item) {
+  return !item.kernel_is_expensive && !item.kernel_is_async &&
+         !item.is_merge && !item.is_enter_exit_or_next_iter &&
+         !item.is_control_trigger && !item.is_sink &&
+         !IsTransferNode(item.node);
+}
+
+void ExecutorImpl::FindInlineChains() {
+  for (const Node* n : graph_->nodes()) {
+    NodeItem* item = gview_.node(n->id());
+    if (item->num_output_edges != 1 || !IsChainable(*item)) continue;
+    const EdgeInfo& e = item->output_edge(0);
+    const NodeItem* dst_item = gview_.dst(e);
+    if (e.output_slot == Graph::kControlSlot ||
+        dst_item->node->in_edges().size() != 1) {
+      continue;
+    }
+    if (IsChainable(*dst_item)) {
+      item->has_inline_successor = true;
+    }
+  }
 }
 
 Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
@@ -784,8 +1175,19 @@ class ExecutorState {
   ExecutorState(const Executor::Args& args, ExecutorImpl* impl);
   ~ExecutorState();
 
+  // Prepares an ExecutorState recycled from a successfully completed step
+  // to run a new step with "args", without reallocating its frame,
+  // iteration, pending counts or input entries.
+  // REQUIRES: impl->is_loop_free_.
+  void Reset(const Executor::Args& args);
+
   void RunAsync(Executor::DoneCallback done);
 
+  bool has_slab() const { return slab_ != nullptr; }
+
+  // Drops the StaticMemorySlab, which the next Reset() rebuilds.
+  void ReleaseSlab();
+
  private:
   // Either a tensor pointer (pass-by-reference) or a tensor (pass-by-value).
   // TODO(yuanbyu): A better way to do "has_value"?
@@ -925,6 +1327,18 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Restores the state at the start of a step: clears any leftover
+    // input entries and resets the counts to the initial snapshot in
+    // *pending_counts with a single memcpy.
+    void Reset(const PendingCounts* pending_counts, int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i] = Entry();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.ResetFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
@@ -985,6 +1399,11 @@ class ExecutorState {
     // The FrameState of its parent frame.
     FrameState* parent_frame = nullptr;
 
+    // If true, this frame and its iteration are kept by the ExecutorState
+    // for the next step instead of being deleted when they are done. Only
+    // the root frame of a loop-free graph is reused.
+    bool reused = false;
+
     // The maximum allowed number of parallel iterations.
     const int max_parallel_iterations;
 
@@ -1163,6 +1582,19 @@ class ExecutorState {
     int front_index_;
   };
 
+  // A ready node waiting in the work-stealing ready queue. Carries the
+  // owning ExecutorState because the queue may outlive it.
+  struct ReadyNode {
+    ReadyNode() : node(nullptr, nullptr, -1, false) {}
+    ReadyNode(ExecutorState* s, const TaggedNode& n, int64 usec)
+        : state(s), node(n), scheduled_usec(usec) {}
+
+    ExecutorState* state = nullptr;
+    TaggedNode node;
+    int64 scheduled_usec = 0;
+  };
+  typedef WorkStealingQueue<ReadyNode> ReadyQueue;
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1178,6 +1610,7 @@ class ExecutorState {
   // Step-local container.
   ScopedStepContainer* step_container_;
   StepStatsCollector* stats_collector_;
+  StepTraceCollector* step_trace_collector_;
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
@@ -1187,6 +1620,30 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
 
+  // Non-null iff impl_->params_.num_work_stealing_workers > 0. Shared
+  // with the worker loops started on runner_, which may still be
+  // draining it after this ExecutorState is deleted.
+  std::shared_ptr<ReadyQueue> ready_queue_;
+
+  // Non-null iff impl_->use_step_arena_. Kernels allocate their
+  // temporaries from it, and it is recycled when the step finishes.
+  StepArenaAllocator* temp_arena_ = nullptr;
+
+  // Non-null iff impl_ has a memory plan, in which case slab_ holds the
+  // memory of slab_plan_ and output_allocators_[item.output_start + i]
+  // is the allocator of output i of the node of "item", or null if the
+  // output is allocated dynamically. The slab is reused across steps,
+  // unless ReleaseSlab() drops it while this state is pooled.
+  std::shared_ptr<const ExecutorImpl::OutputMemoryPlan> slab_plan_;
+  StaticMemorySlab* slab_ = nullptr;
+  std::vector<Allocator*> output_allocators_;
+
+  // Rebuilds slab_ if impl_'s memory plan has changed.
+  void UpdateSlab();
+
+  // impl_'s node priorities when the step started, or null.
+  std::shared_ptr<const std::vector<int64>> priorities_;
+
   // Owned.
 
   // A flag that is set on error after the frame state has been
@@ -1196,6 +1653,11 @@ class ExecutorState {
   // The root frame in which the execution of this step is started.
   FrameState* root_frame_;
 
+  // Non-null iff impl_->is_loop_free_, in which case root_frame_->reused
+  // is set and this is the root frame's only iteration. Both outlive the
+  // step so that the ExecutorState can be Reset() and reused.
+  IterationState* root_iteration_ = nullptr;
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
@@ -1230,8 +1692,14 @@ class ExecutorState {
   void CleanupFramesIterations(FrameState* frame, int64 iter,
                                TaggedNodeSeq* ready);
 
-  // Process a ready node in current thread.
-  void Process(TaggedNode node, int64 scheduled_usec);
+  // Process a ready node in current thread. "worker" is the
+  // work-stealing slot of the current thread, or -1 if the caller is
+  // not a work-stealing worker.
+  void Process(TaggedNode node, int64 scheduled_usec, int worker);
+
+  // Drains "queue" on behalf of worker slot "worker", until the queue
+  // is empty and the slot has been released.
+  static void RunWorker(std::shared_ptr<ReadyQueue> queue, int worker);
 
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -1244,6 +1712,24 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         EntryVector* outputs, NodeExecStats* stats);
 
+  // If "item" has an inline successor that can take "outputs" directly,
+  // moves the output into the successor's input, appends the successor
+  // to "inline_ready" and returns true. The successor inherits the
+  // outstanding op of "tagged_node", so neither the frame's pending
+  // counts nor num_outstanding_ops_ are touched. Otherwise returns false
+  // and the caller must PropagateOutputs() as usual.
+  bool ForwardToInlineSuccessor(const TaggedNode& tagged_node,
+                                const NodeItem& item, EntryVector* outputs,
+                                TaggedNodeReadyQueue* inline_ready);
+
+  // Finalizes and saves (or deletes) the stats of a finished node. Takes
+  // ownership of "stats", which may be nullptr.
+  void SaveNodeStats(const Node* node, NodeExecStats* stats);
+
+  // Finalizes and records the trace event of a finished node, if "event"
+  // is not nullptr.
+  void SaveTraceEvent(StepTraceCollector::Event* event);
+
   // After processing the outputs, propagates the outputs to their dsts.
   // Contents of *outputs are left in an indeterminate state after
   // returning from this method.
@@ -1253,12 +1739,21 @@ class ExecutorState {
   // "node" just finishes. Takes ownership of "stats". Returns true if
   // execution has completed.
   bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
-                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready);
+                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready,
+                int worker);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
-  // nodes in 'ready' into 'inline_ready'.
+  // nodes in 'ready' into 'inline_ready'. With priorities_, the nodes are
+  // taken by decreasing priority, and the expensive node kept inline is the
+  // one with the highest priority.
   void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+                     TaggedNodeReadyQueue* inline_ready, int worker);
+
+  // Runs "tagged_node" on another thread: either as a closure on runner_,
+  // or, in work-stealing mode, by pushing it onto worker "worker"'s ready
+  // deque and starting a new worker loop if a slot is idle.
+  void Dispatch(const TaggedNode& tagged_node, int64 scheduled_usec,
+                int worker);
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1298,6 +1793,7 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
       stats_collector_(args.stats_collector),
+      step_trace_collector_(args.step_trace_collector),
       slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
       call_frame_(args.call_frame),
       impl_(impl),
@@ -1318,9 +1814,32 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       root_frame_->pending_counts, root_frame_->total_input_tensors);
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
+
+  if (impl_->is_loop_free_) {
+    root_frame_->reused = true;
+    root_iteration_ = root_frame_->iterations[0];
+  }
+
+  if (impl_->params_.num_work_stealing_workers > 0) {
+    ready_queue_ =
+        std::make_shared<ReadyQueue>(impl_->params_.num_work_stealing_workers);
+  }
+  if (impl_->use_step_arena_) {
+    temp_arena_ = NewStepArena(impl_->params_.device);
+  }
+  UpdateSlab();
+  priorities_ = impl_->node_priorities();
 }
 
 ExecutorState::~ExecutorState() {
+  if (root_iteration_ != nullptr) {
+    // The reused root frame is no longer in outstanding_frames_ if its
+    // step completed, and its iteration is owned by root_iteration_.
+    outstanding_frames_.erase(root_frame_->frame_name);
+    root_frame_->iterations[0] = nullptr;
+    delete root_frame_;
+    delete root_iteration_;
+  }
   for (auto name_frame : outstanding_frames_) {
     delete name_frame.second;
   }
@@ -1328,6 +1847,87 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  if (temp_arena_ != nullptr) {
+    temp_arena_->Release();
+  }
+  if (slab_ != nullptr) {
+    slab_->Unref();
+  }
+}
+
+void ExecutorState::ReleaseSlab() {
+  if (slab_ == nullptr) return;
+  // Buffers that are still alive keep the slab.
+  slab_->Unref();
+  slab_ = nullptr;
+  slab_plan_.reset();
+  output_allocators_.clear();
+}
+
+void ExecutorState::UpdateSlab() {
+  std::shared_ptr<const ExecutorImpl::OutputMemoryPlan> plan =
+      impl_->memory_plan();
+  if (plan == slab_plan_) return;
+  if (slab_ != nullptr) {
+    // Buffers that are still alive keep the old slab.
+    slab_->Unref();
+  }
+  slab_plan_ = std::move(plan);
+  slab_ = new StaticMemorySlab(
+      slab_plan_->plan,
+      impl_->params_.device->GetAllocator(AllocatorAttributes()));
+  output_allocators_.resize(slab_plan_->output_slots.size());
+  for (size_t i = 0; i < output_allocators_.size(); ++i) {
+    const int slot = slab_plan_->output_slots[i];
+    const int part = slab_plan_->output_parts[i];
+    if (part >= 0) {
+      output_allocators_[i] = slab_->part_allocator(part);
+    } else if (slot < 0) {
+      output_allocators_[i] = nullptr;
+    } else if (slab_plan_->owns_parts[i]) {
+      output_allocators_[i] = slab_->owner_allocator(slot);
+    } else {
+      output_allocators_[i] = slab_->slot_allocator(slot);
+    }
+  }
+}
+
+void ExecutorState::Reset(const Executor::Args& args) {
+  DCHECK(root_iteration_ != nullptr);
+  step_id_ = args.step_id;
+  rendezvous_ = args.rendezvous;
+  session_state_ = args.session_state;
+  tensor_store_ = args.tensor_store;
+  step_container_ = args.step_container;
+  stats_collector_ = args.stats_collector;
+  step_trace_collector_ = args.step_trace_collector;
+  delete slice_reader_cache_;
+  slice_reader_cache_ = new checkpoint::TensorSliceReaderCacheWrapper;
+  call_frame_ = args.call_frame;
+  cancellation_manager_ = args.cancellation_manager;
+  runner_ = args.runner;
+  sync_on_finish_ = args.sync_on_finish;
+  num_outstanding_ops_ = 0;
+  for (auto it : device_context_map_) {
+    it->Unref();
+  }
+  device_context_map_.clear();
+  if (impl_->use_step_arena_ && temp_arena_ == nullptr) {
+    // The previous step's arena was left to temporaries that outlived it.
+    temp_arena_ = NewStepArena(impl_->params_.device);
+  }
+  UpdateSlab();
+  priorities_ = impl_->node_priorities();
+
+  {
+    mutex_lock l(root_frame_->mu);
+    root_frame_->num_outstanding_iterations = 1;
+    root_iteration_->Reset(root_frame_->pending_counts,
+                           root_frame_->total_input_tensors);
+    root_frame_->SetIteration(0, root_iteration_);
+  }
+  mutex_lock l(mu_);
+  outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1436,7 +2036,7 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(ready, nullptr, -1);
   }
 }
 
@@ -1474,6 +2074,10 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStats* stats;
+  // Points to trace_event if the node is traced.
+  StepTraceCollector::Event* trace = nullptr;
+  StepTraceCollector::Event trace_event;
+  int64 compute_start_usec = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1485,7 +2089,8 @@ struct ExecutorState::AsyncState {
   }
 };
 
-void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
+void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec,
+                            int worker) {
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -1504,6 +2109,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   params.rendezvous = rendezvous_;
   params.session_state = session_state_;
   params.tensor_store = tensor_store_;
+  params.stats_collector = stats_collector_;
   params.cancellation_manager = cancellation_manager_;
   params.call_frame = call_frame_;
   params.function_library = impl_->params_.function_library;
@@ -1514,9 +2120,12 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   params.input_device_contexts = &input_device_contexts;
   params.input_alloc_attrs = &input_alloc_attrs;
   params.runner = &runner_;
+  params.step_temp_allocator = temp_arena_;
 
   Status s;
   NodeExecStats* stats = nullptr;
+  StepTraceCollector::Event trace_event;
+  StepTraceCollector::Event* trace = nullptr;
   EntryVector outputs;
   bool completed = false;
   inline_ready.push_back(tagged_node);
@@ -1551,6 +2160,16 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       nodestats::SetScheduled(stats, scheduled_usec);
       nodestats::SetAllStart(stats);
     }
+    trace = nullptr;
+    if (step_trace_collector_ && !stats && !tagged_node.is_dead) {
+      trace = &trace_event;
+      trace->node = node;
+      trace->device = &impl_->params_.device->name();
+      trace->scheduled_micros = scheduled_usec;
+      trace->all_start_micros = nodestats::NowInUsec();
+      trace->op_start_micros = trace->all_start_micros;
+      trace->op_end_micros = trace->all_start_micros;
+    }
 
     if (vlog_) {
       VLOG(1) << "Process node: " << id << " step " << params.step_id << " "
@@ -1582,8 +2201,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           (first_input + i)->ClearVal();
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
+        SaveTraceEvent(trace);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed =
+            NodeDone(s, item.node, ready, stats, &inline_ready, worker);
         continue;
       }
 
@@ -1593,6 +2214,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.frame_iter = FrameAndIter(input_frame->frame_id, input_iter);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      params.output_allocator_array =
+          slab_ == nullptr ? nullptr
+                           : output_allocators_.data() + item.output_start;
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1601,6 +2225,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         launched_asynchronously = true;
         AsyncState* state =
             new AsyncState(params, tagged_node, &item, first_input, stats);
+        if (trace) {
+          state->trace_event = *trace;
+          state->trace = &state->trace_event;
+        }
 
         auto done = [this, state]() {
           Device* device = impl_->params_.device;
@@ -1612,6 +2240,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                     << SummarizeNodeDef(state->item->node->def());
           }
           if (stats) nodestats::SetOpEnd(stats);
+          const int64 compute_end_usec = nodestats::NowInUsec();
+          state->item->compute_time_cell->Add(compute_end_usec -
+                                              state->compute_start_usec);
+          if (state->trace) state->trace->op_end_micros = compute_end_usec;
           EntryVector outputs;
           Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
           if (stats) nodestats::SetMemory(stats, &state->ctx);
@@ -1638,19 +2270,32 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
             device->ConsumeListOfAccessedTensors(state->ctx.op_device_context(),
                                                  accessed);
           }
+          SaveTraceEvent(state->trace);
           bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, ready, stats, nullptr, -1);
           delete state;
           if (completed) Finish();
         };
         if (stats) nodestats::SetOpStart(stats);
+        state->compute_start_usec = nodestats::NowInUsec();
+        if (state->trace) {
+          state->trace->op_start_micros = state->compute_start_usec;
+        }
+        nodestats::RecordSchedulingDelay(scheduled_usec,
+                                         state->compute_start_usec);
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         if (stats) nodestats::SetOpStart(stats);
+        const int64 compute_start_usec = nodestats::NowInUsec();
+        if (trace) trace->op_start_micros = compute_start_usec;
+        nodestats::RecordSchedulingDelay(scheduled_usec, compute_start_usec);
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        const int64 compute_end_usec = nodestats::NowInUsec();
+        item.compute_time_cell->Add(compute_end_usec - compute_start_usec);
         if (stats) nodestats::SetOpEnd(stats);
+        if (trace) trace->op_end_micros = compute_end_usec;
 
         s = ProcessOutputs(item, &ctx, &outputs, stats);
         if (s.ok() && impl_->device_record_tensor_accesses_) {
@@ -1669,8 +2314,12 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         (first_input + i)->ClearVal();
       }
       MaybeMarkCompleted(input_frame, input_iter, id);
-      // Propagates outputs.
-      if (s.ok()) {
+      // Propagates outputs, directly to the next node of an inline chain
+      // if possible.
+      const bool chained = s.ok() && ForwardToInlineSuccessor(
+                                         tagged_node, item, &outputs,
+                                         &inline_ready);
+      if (s.ok() && !chained) {
         PropagateOutputs(tagged_node, &item, &outputs, &ready);
       }
       outputs.clear();
@@ -1679,11 +2328,16 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // device_context is set above in synchronous computes
         device->ConsumeListOfAccessedTensors(device_context, accessed_tensors);
       }
-      if (stats) {
-        scheduled_usec = nodestats::NowInUsec();
+      scheduled_usec = nodestats::NowInUsec();
+      SaveTraceEvent(trace);
+      if (chained) {
+        // The successor takes over this node's outstanding op, so there
+        // is nothing to account for beyond the stats.
+        SaveNodeStats(item.node, stats);
+        continue;
       }
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed = NodeDone(s, item.node, ready, stats, &inline_ready, worker);
     }
   }  // while !inline_ready.empty()
 
@@ -1994,9 +2648,28 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
   }
 }
 
-bool ExecutorState::NodeDone(const Status& s, const Node* node,
-                             const TaggedNodeSeq& ready, NodeExecStats* stats,
-                             TaggedNodeReadyQueue* inline_ready) {
+bool ExecutorState::ForwardToInlineSuccessor(
+    const TaggedNode& tagged_node, const NodeItem& item, EntryVector* outputs,
+    TaggedNodeReadyQueue* inline_ready) {
+  // mark_started() expects the pending count to have dropped to zero, so
+  // chains are not used while tracking node states for debugging.
+  if (!item.has_inline_successor || tagged_node.is_dead || vlog_) {
+    return false;
+  }
+  const EdgeInfo& e = item.output_edge(0);
+  Entry* output = &(*outputs)[e.output_slot];
+  // A dead output needs the regular deadness propagation.
+  if (!output->has_value) return false;
+  const NodeItem* dst_item = impl_->gview_.dst(e);
+  Entry* input_tensors =
+      GetInputTensors(tagged_node.input_frame, tagged_node.input_iter);
+  input_tensors[dst_item->input_start + e.input_slot] = std::move(*output);
+  inline_ready->push_back(TaggedNode(dst_item->node, tagged_node.input_frame,
+                                     tagged_node.input_iter, false));
+  return true;
+}
+
+void ExecutorState::SaveNodeStats(const Node* node, NodeExecStats* stats) {
   if (stats) {
     nodestats::SetAllEnd(stats);
     if (!SetTimelineLabel(node, stats)) {
@@ -2006,6 +2679,19 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
       delete stats;
     }
   }
+}
+
+void ExecutorState::SaveTraceEvent(StepTraceCollector::Event* event) {
+  if (event) {
+    event->all_end_micros = nodestats::NowInUsec();
+    step_trace_collector_->Record(*event);
+  }
+}
+
+bool ExecutorState::NodeDone(const Status& s, const Node* node,
+                             const TaggedNodeSeq& ready, NodeExecStats* stats,
+                             TaggedNodeReadyQueue* inline_ready, int worker) {
+  SaveNodeStats(node, stats);
 
   bool abort_run = false;
   if (!s.ok()) {
@@ -2036,39 +2722,82 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
 
   // Schedule the ready nodes in 'ready'.
   if (s.ok()) {
-    ScheduleReady(ready, inline_ready);
+    ScheduleReady(ready, inline_ready, worker);
   }
   return completed;
 }
 
+void ExecutorState::Dispatch(const TaggedNode& tagged_node,
+                             int64 scheduled_usec, int worker) {
+  if (ready_queue_ == nullptr) {
+    runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                      scheduled_usec, -1));
+    return;
+  }
+  ready_queue_->Push(worker, ReadyNode(this, tagged_node, scheduled_usec));
+  // Prefer waking the slot next to ours, so that the new worker starts
+  // by stealing from our deque.
+  const int new_worker = ready_queue_->StartWorker(worker + 1);
+  if (new_worker >= 0) {
+    runner_(std::bind(&ExecutorState::RunWorker, ready_queue_, new_worker));
+  }
+}
+
+// static
+void ExecutorState::RunWorker(std::shared_ptr<ReadyQueue> queue, int worker) {
+  ReadyNode item;
+  do {
+    while (queue->PopOrSteal(worker, &item)) {
+      // NOTE: Process() deletes item.state when the step completes, so
+      // only "queue" may be touched after it returns.
+      item.state->Process(item.node, item.scheduled_usec, worker);
+    }
+  } while (queue->StopWorker(worker));
+}
+
 void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
-                                  TaggedNodeReadyQueue* inline_ready) {
+                                  TaggedNodeReadyQueue* inline_ready,
+                                  int worker) {
   if (ready.empty()) return;
 
-  int64 scheduled_usec = 0;
-  if (stats_collector_) {
-    scheduled_usec = nodestats::NowInUsec();
-  }
+  // Orders the nodes by decreasing priority, so that the nodes on the
+  // longest remaining path are not queued behind the others.
+  const TaggedNodeSeq* ordered = &ready;
+  TaggedNodeSeq by_priority;
+  if (priorities_ != nullptr && ready.size() > 1) {
+    const std::vector<int64>& priorities = *priorities_;
+    by_priority = ready;
+    std::stable_sort(by_priority.begin(), by_priority.end(),
+                     [&priorities](const TaggedNode& a, const TaggedNode& b) {
+                       return priorities[a.node->id()] >
+                              priorities[b.node->id()];
+                     });
+    ordered = &by_priority;
+  }
+
+  const int64 scheduled_usec = nodestats::NowInUsec();
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
-    for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_usec); });
+    for (auto& tagged_node : *ordered) {
+      Dispatch(tagged_node, scheduled_usec, worker);
     }
     return;
   }
   const GraphView& gview = impl_->gview_;
   const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
+  for (auto& tagged_node : *ordered) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
     if (tagged_node.is_dead || !item.kernel_is_expensive) {
       // Inline this inexpensive node.
       inline_ready->push_back(tagged_node);
+    } else if (curr_expensive_node && ordered == &by_priority) {
+      // Keep the first, highest priority, expensive node for this thread.
+      Dispatch(tagged_node, scheduled_usec, worker);
     } else {
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
+        Dispatch(*curr_expensive_node, scheduled_usec, worker);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2080,8 +2809,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
+      Dispatch(*curr_expensive_node, scheduled_usec, worker);
     }
   }
 }
@@ -2230,7 +2958,17 @@ void ExecutorState::Finish() {
     // the user until the step (and its side-effects) has actually completed.
     status = impl_->params_.device->Sync();
   }
-  delete this;
+  if (temp_arena_ != nullptr && !temp_arena_->EndStep()) {
+    temp_arena_ = nullptr;
+  }
+  if (slab_plan_ != nullptr && slab_plan_->is_profile && status.ok()) {
+    impl_->UpdateMemoryPlan(*slab_plan_, slab_->RequestedBytes());
+  }
+  if (root_iteration_ != nullptr && status.ok()) {
+    impl_->ReleaseState(this);
+  } else {
+    delete this;
+  }
   CHECK(done_cb != nullptr);
   runner([=]() { done_cb(status); });
 }
@@ -2346,7 +3084,7 @@ void ExecutorState::DeleteFrame(FrameState* frame, TaggedNodeSeq* ready) {
     mutex_lock executor_lock(mu_);
     outstanding_frames_.erase(frame_name);
   }
-  delete frame;
+  if (!frame->reused) delete frame;
 }
 
 void ExecutorState::CleanupFramesIterations(FrameState* frame, int64 iter,
@@ -2380,15 +3118,10 @@ void ExecutorState::FrameState::ActivateNodes(const NodeItem* item,
   Entry* input_tensors = iter_state->input_tensors;
   for (size_t out_index = 0; out_index < num_output_edges; out_index++) {
     const EdgeInfo& e = edges[out_index];
-    const int dst_id = e.dst_id;
-    const NodeItem* dst_item = gview.node(dst_id);
+    const NodeItem* dst_item = gview.dst(e);
     const PendingCounts::Handle dst_pending_id = dst_item->pending_id;
     const int src_slot = e.output_slot;
 
-    // TODO(yuanbyu): We don't need this if we require the subgraph
-    // given to an executor not to contain a sink node.
-    if (dst_item->is_sink) continue;
-
     bool dst_dead = false;
     bool dst_ready = false;
     // True iff this input for dst is needed. We only set this input for
@@ -2545,7 +3278,7 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
     // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    if (!reused) delete GetIteration(curr_iter);
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2559,8 +3292,68 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
   return IsFrameDone();
 }
 
+ExecutorImpl::~ExecutorImpl() {
+  {
+    mutex_lock l(state_pool_mu_);
+    for (ExecutorState* state : state_pool_) {
+      delete state;
+    }
+  }
+  for (int i = 0; i < graph_->num_node_ids(); i++) {
+    NodeItem* item = gview_.node(i);
+    if (item != nullptr) {
+      params_.delete_kernel(item->kernel);
+    }
+  }
+  for (auto fiter : frame_info_) {
+    delete fiter.second;
+  }
+  delete graph_;
+}
+
+void ExecutorImpl::ReleaseState(ExecutorState* state) const {
+  // Enough to cover the usual number of concurrent steps on one executor.
+  static constexpr size_t kMaxPooledStates = 16;
+  {
+    mutex_lock l(state_pool_mu_);
+    if (state_pool_.size() < kMaxPooledStates) {
+      if (!state_pool_.empty() && state_pool_.back()->has_slab()) {
+        state->ReleaseSlab();
+        state_pool_.insert(state_pool_.end() - 1, state);
+      } else {
+        state_pool_.push_back(state);
+      }
+      return;
+    }
+  }
+  delete state;
+}
+
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
-  (new ExecutorState(args, this))->RunAsync(std::move(done));
+  ExecutorState* state = nullptr;
+  if (is_loop_free_) {
+    mutex_lock l(state_pool_mu_);
+    if (!state_pool_.empty()) {
+      state = state_pool_.back();
+      state_pool_.pop_back();
+    }
+  }
+  if (state == nullptr) {
+    state = new ExecutorState(args, this);
+  } else {
+    state->Reset(args);
+  }
+  state->RunAsync(std::move(done));
+}
+
+void ExecutorImpl::SetNodePriorities(std::vector<int64> priorities) {
+  std::shared_ptr<const std::vector<int64>> p;
+  if (!priorities.empty()) {
+    CHECK_EQ(priorities.size(), static_cast<size_t>(graph_->num_node_ids()));
+    p = std::make_shared<const std::vector<int64>>(std::move(priorities));
+  }
+  mutex_lock l(node_priorities_mu_);
+  node_priorities_ = std::move(p);
 }
 
 }  // end namespace
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/session_state.h"
@@ -29,6 +31,7 @@ limitations under the License.
 namespace tensorflow {
 
 class StepStatsCollector;
+class StepTraceCollector;
 
 // Executor runs a graph computation.
 // Example:
@@ -67,6 +70,8 @@ class Executor {
   //
   // RunAsync() calls "stats_collector", if not null, to keep track of
   // stats. This allows us to collect statistics and traces on demand.
+  // Otherwise it records the execution times of the nodes in
+  // "step_trace_collector", if not null, which is much cheaper.
   //
   // RunAsync() is provided a "call_frame", if the executor is used
   // for executing a function, is used to pass arguments and return
@@ -84,6 +89,7 @@ class Executor {
     int64 step_id = 0;
     Rendezvous* rendezvous = nullptr;
     StepStatsCollector* stats_collector = nullptr;
+    StepTraceCollector* step_trace_collector = nullptr;
     FunctionCallFrame* call_frame = nullptr;
     CancellationManager* cancellation_manager = nullptr;
     SessionState* session_state = nullptr;
@@ -118,6 +124,13 @@ class Executor {
     n.WaitForNotification();
     return ret;
   }
+
+  // Sets the scheduling priority of each node of the graph, indexed by
+  // node id, for the steps started after this call: of the nodes that
+  // become ready together, the ones with higher priorities are run or
+  // dispatched first. An empty "priorities" restores the default order.
+  // Executors are free to ignore the priorities.
+  virtual void SetNodePriorities(std::vector<int64> priorities) {}
 };
 
 // Creates an Executor that computes the given "graph".
@@ -141,6 +154,25 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // If > 0, expensive ready nodes are dispatched through this many
+  // per-worker ready deques with work stealing, instead of one closure
+  // per node on Args::runner. A worker runs the successors it makes
+  // ready itself and steals from other workers when it runs dry, so at
+  // most this many closures are outstanding on the runner per step.
+  // Typically set to the number of threads backing the runner.
+  int num_work_stealing_workers = 0;
+
+  // If true and "device" is a CPU device, temporaries allocated by kernels
+  // come from a per-step arena (see StepArenaAllocator) that is recycled
+  // when the step finishes.
+  bool use_step_arena_for_temps = false;
+
+  // If true and the graph is loop-free, outputs that need no special
+  // allocator attributes are served from a slab laid out by a static
+  // memory plan (see static_memory_plan.h). The first step records the
+  // output sizes, and later steps reuse the slab.
+  bool use_static_memory_plan = false;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
@@ -203,6 +203,9 @@ class FunctionLibraryRuntimeImpl : public FunctionLibraryRuntime {
   struct Item : public core::RefCounted {
     const Graph* graph = nullptr;  // Owned by exec.
     Executor* exec = nullptr;
+    // False if the graph has no Send or Recv nodes, whose calls then run
+    // without a rendezvous.
+    bool needs_rendezvous = true;
 
     ~Item() override { delete this->exec; }
   };
@@ -499,6 +502,13 @@ Status FunctionLibraryRuntimeImpl::CreateItem(Handle handle, Item** item) {
   *item = new Item;
   (*item)->graph = graph;
   (*item)->exec = exec;
+  (*item)->needs_rendezvous = false;
+  for (const Node* n : graph->nodes()) {
+    if (n->IsSend() || n->IsRecv()) {
+      (*item)->needs_rendezvous = true;
+      break;
+    }
+  }
   return Status::OK();
 }
 
@@ -560,9 +570,10 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
   exec_args.call_frame = frame;
   exec_args.cancellation_manager = opts.cancellation_manager;
   exec_args.runner = *opts.runner;
-  // TODO(zhifengc): we can avoid creating rendez here if we know
-  // there is no send/recv nodes in the graph.
-  auto* rendez = new IntraProcessRendezvous(device_mgr_);
+  IntraProcessRendezvous* rendez = nullptr;
+  if (item->needs_rendezvous) {
+    rendez = new IntraProcessRendezvous(device_mgr_);
+  }
   exec_args.rendezvous = rendez;
   item->exec->RunAsync(
       // Executor args
@@ -570,7 +581,7 @@ void FunctionLibraryRuntimeImpl::Run(const Options& opts, Handle handle,
       // Done callback.
       [item, frame, rets, rendez, done](const Status& status) {
         item->Unref();
-        rendez->Unref();
+        if (rendez != nullptr) rendez->Unref();
         Status s = status;
         if (s.ok()) {
           s = frame->GetRetvals(rets);
@@ -956,6 +967,11 @@ static void InlineFunctionBody(Graph* g, Node* caller,
 }
 
 bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
+  return ExpandInlineFunctions(lib, graph, -1);
+}
+
+bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph,
+                           int max_nodes) {
   std::vector<std::pair<Node*, const FunctionBody*>> candidates;
   const FunctionLibraryDefinition* fld = lib->GetFunctionLibraryDefinition();
   for (Node* node : graph->nodes()) {
@@ -979,6 +995,17 @@ bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph) {
     }
     const FunctionBody* fbody = lib->GetFunctionBody(handle);
     CHECK_NOTNULL(fbody);
+    int body_nodes = 0;
+    for (const Node* n : fbody->graph->nodes()) {
+      if (n->IsOp() && n->type_string() != kArgOp &&
+          n->type_string() != kRetOp) {
+        ++body_nodes;
+      }
+    }
+    if (max_nodes >= 0 && body_nodes > max_nodes) {
+      VLOG(3) << "too large to inline: " << node->DebugString();
+      continue;
+    }
     candidates.push_back({node, fbody});
   }
   for (const auto& p : candidates) {
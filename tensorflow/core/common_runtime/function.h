@@ -116,6 +116,12 @@ bool RemoveListArrayConverter(Graph* g);
 // multiple times by calling ExpandInlineFunctions a few times.
 bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph);
 
+// Like ExpandInlineFunctions above, but only inlines the calls of
+// functions whose bodies have at most "max_nodes" nodes, not counting
+// their argument and return value nodes.
+bool ExpandInlineFunctions(FunctionLibraryRuntime* lib, Graph* graph,
+                           int max_nodes);
+
 // Dump the contents of the "graph" to log files if the logging level is
 // sufficiently high.
 void DumpGraph(StringPiece label, const Graph* g);
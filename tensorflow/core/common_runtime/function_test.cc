@@ -391,6 +391,20 @@ TEST_F(FunctionLibraryRuntimeTest, ExpandInlineFunctions) {
   }
 }
 
+
+TEST_F(FunctionLibraryRuntimeTest, ExpandInlineFunctionsWithMaxNodes) {
+  Init({test::function::XTimesTwo(), test::function::XTimesFour(),
+        test::function::XTimes16()});
+  std::unique_ptr<Graph> g = GetFuncBody("XTimes16", {{"T", DT_FLOAT}});
+  ASSERT_TRUE(g != nullptr);
+
+  // XTimesFour calls XTimesTwo twice, whose body has three nodes.
+  EXPECT_FALSE(ExpandInlineFunctions(lib_.get(), g.get(), 1));
+  EXPECT_TRUE(ExpandInlineFunctions(lib_.get(), g.get(), 2));
+  EXPECT_FALSE(ExpandInlineFunctions(lib_.get(), g.get(), 2));
+  EXPECT_TRUE(ExpandInlineFunctions(lib_.get(), g.get(), 3));
+  EXPECT_FALSE(ExpandInlineFunctions(lib_.get(), g.get(), 3));
+}
 TEST_F(FunctionLibraryRuntimeTest, OptimizeGraph) {
   Init({test::function::XTimesTwo(), test::function::XTimesFour(),
         test::function::XTimes16()});
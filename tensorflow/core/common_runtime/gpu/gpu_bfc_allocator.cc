@@ -29,8 +29,10 @@ GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory,
                                  const GPUOptions& gpu_options)
     : BFCAllocator(
           new GPUMemAllocator(
-              GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie()),
+              GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie(),
+              gpu_options.per_process_gpu_memory_fraction() > 1.0),
           total_memory, gpu_options.allow_growth(),
-          strings::StrCat("GPU_", device_id, "_bfc")) {}
+          strings::StrCat("GPU_", device_id, "_bfc"),
+          gpu_options.use_allocator_thread_cache()) {}
 
 }  // namespace tensorflow
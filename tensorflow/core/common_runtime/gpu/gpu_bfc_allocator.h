@@ -49,9 +49,11 @@ class GPUBFCAllocator : public BFCAllocator {
 // Suballocator for GPU memory.
 class GPUMemAllocator : public SubAllocator {
  public:
-  // Note: stream_exec cannot be null.
-  explicit GPUMemAllocator(perftools::gputools::StreamExecutor* stream_exec)
-      : stream_exec_(stream_exec) {
+  // Note: stream_exec cannot be null. If use_unified_memory, allocates
+  // unified memory, which may exceed the memory of the GPU.
+  explicit GPUMemAllocator(perftools::gputools::StreamExecutor* stream_exec,
+                           bool use_unified_memory = false)
+      : stream_exec_(stream_exec), use_unified_memory_(use_unified_memory) {
     CHECK(stream_exec_ != nullptr);
   }
   ~GPUMemAllocator() override {}
@@ -59,20 +61,29 @@ class GPUMemAllocator : public SubAllocator {
   void* Alloc(size_t alignment, size_t num_bytes) override {
     void* ptr = nullptr;
     if (num_bytes > 0) {
-      ptr = stream_exec_->AllocateArray<char>(num_bytes).opaque();
+      if (use_unified_memory_) {
+        ptr = stream_exec_->UnifiedMemoryAllocate(num_bytes);
+      } else {
+        ptr = stream_exec_->AllocateArray<char>(num_bytes).opaque();
+      }
     }
     return ptr;
   }
 
   void Free(void* ptr, size_t num_bytes) override {
     if (ptr != nullptr) {
-      gpu::DeviceMemoryBase gpu_ptr(ptr);
-      stream_exec_->Deallocate(&gpu_ptr);
+      if (use_unified_memory_) {
+        stream_exec_->UnifiedMemoryDeallocate(ptr);
+      } else {
+        gpu::DeviceMemoryBase gpu_ptr(ptr);
+        stream_exec_->Deallocate(&gpu_ptr);
+      }
     }
   }
 
  private:
   perftools::gputools::StreamExecutor* stream_exec_;  // not owned, non-null
+  const bool use_unified_memory_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(GPUMemAllocator);
 };
@@ -18,9 +18,11 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 
 #include <algorithm>
+#include <thread>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
@@ -258,6 +260,147 @@ TEST(GPUBFCAllocatorTest, AllocationsAndDeallocationsWithGrowth) {
   LOG(INFO) << "Alloc stats: \n" << stats.DebugString();
 }
 
+TEST(GPUBFCAllocatorTest, ThreadCacheKeepsStatsExact) {
+  GPUOptions options;
+  options.set_use_allocator_thread_cache(true);
+  GPUBFCAllocator a(0, 1 << 30, options);
+
+  void* p1 = a.AllocateRaw(1, 1000);
+  EXPECT_EQ(1000, a.RequestedSize(p1));
+  EXPECT_EQ(1024, a.AllocatedSize(p1));
+  const int64 id1 = a.AllocationId(p1);
+  a.DeallocateRaw(p1);
+  CheckStats(&a, 1, 0, 1024, 1024);
+
+  // The parked chunk is reused for the next allocation of the same
+  // rounded size, which gets its own requested size and id.
+  void* p2 = a.AllocateRaw(1, 800);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(800, a.RequestedSize(p2));
+  EXPECT_EQ(1024, a.AllocatedSize(p2));
+  EXPECT_GT(a.AllocationId(p2), id1);
+  CheckStats(&a, 2, 1024, 1024, 1024);
+
+  // Freeing from another thread returns the chunk to its cache.
+  std::thread t([&a, p2]() { a.DeallocateRaw(p2); });
+  t.join();
+  CheckStats(&a, 2, 0, 1024, 1024);
+}
+
+TEST(GPUBFCAllocatorTest, ThreadCacheIsFlushedBeforeFailing) {
+  GPUOptions options;
+  options.set_use_allocator_thread_cache(true);
+  // Configure a 1MiB byte limit.
+  GPUBFCAllocator a(0, 1 << 20, options);
+
+  // Fill the allocator with small chunks and free them into the caches.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; i++) {
+    void* raw = a.AllocateRaw(1, 16384);
+    ASSERT_NE(nullptr, raw);
+    ptrs.push_back(raw);
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  CheckStats(&a, 64, 0, 1 << 20, 16384);
+
+  // Only coalescing the parked chunks can satisfy this request.
+  void* big = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(nullptr, big);
+  a.DeallocateRaw(big);
+}
+
+TEST(GPUBFCAllocatorTest, MemoryTrace) {
+  GPUOptions options;
+  options.set_allow_growth(true);
+  GPUBFCAllocator a(0, 1 << 30, options);
+  a.StartMemoryTrace(100);
+
+  const string kernel_a = "a";
+  const string kernel_b = "b";
+  AllocationAttributes attr_a;
+  attr_a.kernel_name = &kernel_a;
+  AllocationAttributes attr_b;
+  attr_b.kernel_name = &kernel_b;
+  void* p1 = a.AllocateRaw(1, 1000, attr_a);
+  void* p2 = a.AllocateRaw(1, 2048, attr_b);
+  void* p3 = a.AllocateRaw(1, 512);
+  a.DeallocateRaw(p1);
+  void* p4 = a.AllocateRaw(1, 4096, attr_b);
+
+  MemoryAllocatorTrace trace;
+  ASSERT_TRUE(a.StopMemoryTrace(&trace));
+  EXPECT_FALSE(a.StopMemoryTrace(&trace));
+  EXPECT_EQ(a.Name(), trace.allocator_name());
+  EXPECT_EQ(0, trace.num_dropped_events());
+
+  // The first allocation grows the allocator by 1MiB.
+  ASSERT_EQ(6, trace.events_size());
+  EXPECT_EQ(MemoryAllocatorEvent::EXTEND, trace.events(0).kind());
+  EXPECT_EQ(1 << 20, trace.events(0).allocated_bytes());
+  const MemoryAllocatorEvent& alloc = trace.events(1);
+  EXPECT_EQ(MemoryAllocatorEvent::ALLOCATE, alloc.kind());
+  EXPECT_EQ(reinterpret_cast<uint64>(p1), alloc.ptr());
+  EXPECT_EQ(1000, alloc.requested_bytes());
+  EXPECT_EQ(1024, alloc.allocated_bytes());
+  EXPECT_EQ(2, alloc.bin());
+  EXPECT_EQ("a", alloc.kernel_name());
+  EXPECT_EQ(1024, alloc.bytes_in_use());
+  EXPECT_EQ("", trace.events(3).kernel_name());
+  const MemoryAllocatorEvent& dealloc = trace.events(4);
+  EXPECT_EQ(MemoryAllocatorEvent::DEALLOCATE, dealloc.kind());
+  EXPECT_EQ(alloc.allocation_id(), dealloc.allocation_id());
+  EXPECT_EQ(2048 + 512, dealloc.bytes_in_use());
+
+  // Only the allocations of p2, p3 and p4 are live at the peak.
+  EXPECT_EQ(2048 + 512 + 4096, trace.peak_bytes_in_use());
+  EXPECT_EQ(trace.events(5).time_micros(), trace.peak_time_micros());
+  ASSERT_EQ(2, trace.peak_usage_by_kernel_size());
+  EXPECT_EQ("b", trace.peak_usage_by_kernel(0).kernel_name());
+  EXPECT_EQ(2048 + 4096, trace.peak_usage_by_kernel(0).bytes());
+  EXPECT_EQ(2, trace.peak_usage_by_kernel(0).num_allocations());
+  EXPECT_EQ("", trace.peak_usage_by_kernel(1).kernel_name());
+  EXPECT_EQ(512, trace.peak_usage_by_kernel(1).bytes());
+
+  // The free chunk left by p1 is too small for p4.
+  ASSERT_EQ(2, trace.snapshots_size());
+  EXPECT_EQ(1 << 20, trace.snapshots(0).free_bytes());
+  EXPECT_EQ(0.0, trace.snapshots(0).fragmentation());
+  const MemoryAllocatorSnapshot& snapshot = trace.snapshots(1);
+  const int64 free_bytes = (1 << 20) - 2048 - 512 - 4096;
+  EXPECT_EQ(1, snapshot.num_regions());
+  EXPECT_EQ(1 << 20, snapshot.region_bytes());
+  EXPECT_EQ(2048 + 512 + 4096, snapshot.bytes_in_use());
+  EXPECT_EQ(free_bytes, snapshot.free_bytes());
+  EXPECT_EQ(free_bytes - 1024, snapshot.largest_free_chunk_bytes());
+  EXPECT_NEAR(1024.0 / free_bytes, snapshot.fragmentation(), 1e-9);
+  EXPECT_EQ(1, snapshot.bins(2).free_chunks());
+  EXPECT_EQ(1024, snapshot.bins(2).free_bytes());
+  EXPECT_EQ(1, snapshot.bins(4).chunks_in_use());
+  EXPECT_EQ(4096, snapshot.bins(4).bytes_in_use());
+
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  a.DeallocateRaw(p4);
+}
+
+TEST(GPUBFCAllocatorTest, MemoryTraceDropsEventsBeyondCapacity) {
+  GPUBFCAllocator a(0, 1 << 30);
+  a.StartMemoryTrace(2);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 5; i++) {
+    ptrs.push_back(a.AllocateRaw(1, 256));
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  MemoryAllocatorTrace trace;
+  ASSERT_TRUE(a.StopMemoryTrace(&trace));
+  EXPECT_EQ(2, trace.events_size());
+  EXPECT_EQ(9, trace.num_dropped_events());
+}
+
 TEST(GPUBFCAllocatorTest, DISABLED_AllocatorReceivesZeroMemory) {
   GPUBFCAllocator a(0, 1UL << 60);
   GPUBFCAllocator b(0, 1UL << 60);
@@ -317,6 +460,46 @@ static void BM_AllocationThreaded(int iters, int num_threads) {
 }
 BENCHMARK(BM_AllocationThreaded)->Arg(1)->Arg(4)->Arg(16);
 
+// Small allocations from many threads, with and without the thread caches.
+static void BM_AllocationThreadedSmall(int iters, int num_threads,
+                                       int use_thread_cache) {
+  testing::StopTiming();
+  GPUOptions options;
+  options.set_use_allocator_thread_cache(use_thread_cache != 0);
+  GPUBFCAllocator a(0, 1uLL << 33, options);
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  BlockingCounter done(num_threads);
+  const int iters_per_thread = std::max(1, iters / num_threads);
+  testing::StartTiming();
+
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &done, iters_per_thread]() {
+      // Keep a few allocations alive so that consecutive ones do not
+      // simply reuse the chunk that was just freed.
+      std::vector<int> sizes = {256, 1024, 4096, 512, 16384, 2048, 768};
+      std::vector<void*> held(8, nullptr);
+      for (int i = 0; i < iters_per_thread; i++) {
+        void*& slot = held[i % held.size()];
+        if (slot != nullptr) a.DeallocateRaw(slot);
+        slot = a.AllocateRaw(1, sizes[i % sizes.size()]);
+      }
+      for (void* p : held) {
+        if (p != nullptr) a.DeallocateRaw(p);
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+}
+BENCHMARK(BM_AllocationThreadedSmall)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1);
+
 // A more complex benchmark that defers deallocation of an object for
 // "delay" allocations.
 static void BM_AllocationDelayed(int iters, int delay) {
@@ -348,6 +531,20 @@ static void BM_AllocationDelayed(int iters, int delay) {
 }
 BENCHMARK(BM_AllocationDelayed)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
 
+TEST(GPUBFCAllocatorTest, UnifiedMemory) {
+  GPUOptions options;
+  options.set_allow_growth(true);
+  options.set_per_process_gpu_memory_fraction(2.0);
+  GPUBFCAllocator a(0, 1 << 30, options);
+  // Unified memory may be accessed from the host.
+  char* p = static_cast<char*>(a.AllocateRaw(1, 1 << 20));
+  ASSERT_NE(nullptr, p);
+  memset(p, 7, 1 << 20);
+  EXPECT_EQ(7, p[(1 << 20) - 1]);
+  a.DeallocateRaw(p);
+  CheckStats(&a, 1, 0, 1 << 20, 1 << 20);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
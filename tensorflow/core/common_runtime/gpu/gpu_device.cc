@@ -187,7 +187,16 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
       cpu_allocator_(cpu_allocator),
       gpu_id_(gpu_id),
       sync_every_op_(sync_every_op),
-      max_streams_(max_streams) {
+      max_streams_(max_streams),
+      use_unified_memory_(
+          options.config.gpu_options().per_process_gpu_memory_fraction() >
+          1.0) {
+  const int64 quota =
+      options.config.gpu_options().per_session_gpu_memory_limit_bytes();
+  if (quota > 0) {
+    quota_allocator_ = new QuotaAllocator(gpu_allocator, quota, name);
+    gpu_allocator_ = quota_allocator_;
+  }
   ProcessState::singleton()->EnableGPUDevice();
 }
 
@@ -200,6 +209,8 @@ BaseGPUDevice::~BaseGPUDevice() {
     delete stream_group.device_to_host;
     delete stream_group.device_to_device;
   }
+  // Tensors of this session may outlive the device.
+  if (quota_allocator_ != nullptr) quota_allocator_->Release();
 }
 
 Status BaseGPUDevice::Init(const SessionOptions& options) {
@@ -305,11 +316,35 @@ Status BaseGPUDevice::FillContextMap(const Graph* graph,
   for (Node* n : graph->nodes()) {
     auto mapped_stream = node_to_stream_id[n->id()];
     CHECK_LE(mapped_stream, num_streams);
-    auto ctx = device_contexts_[mapped_stream];
+    GPUDeviceContext* ctx = device_contexts_[mapped_stream];
+
+    // A control edge orders its destination after its source on the
+    // device only if they run on the same stream: otherwise give the
+    // destination its own context, which waits for the source's stream.
+    std::vector<gpu::Stream*> control_streams;
+    for (const Edge* e : n->in_edges()) {
+      if (!e->IsControlEdge() || e->src()->IsSource()) continue;
+      gpu::Stream* control_stream =
+          streams_[node_to_stream_id[e->src()->id()]].compute;
+      if (control_stream != ctx->stream() &&
+          std::find(control_streams.begin(), control_streams.end(),
+                    control_stream) == control_streams.end()) {
+        control_streams.push_back(control_stream);
+      }
+    }
+    if (control_streams.empty()) {
+      ctx->Ref();
+    } else {
+      ctx = new GPUDeviceContext(ctx->stream_id(), ctx->stream(),
+                                 ctx->host_to_device_stream(),
+                                 ctx->device_to_host_stream(),
+                                 ctx->device_to_device_stream(),
+                                 std::move(control_streams));
+    }
     VLOG(3) << "Assigned stream " << node_to_stream_id[n->id()]
             << " ==> stream[" << ctx->stream_id() << "] for node id " << n->id()
-            << " " << n->type_string() << " " << n->name();
-    ctx->Ref();
+            << " " << n->type_string() << " " << n->name() << ", waiting for "
+            << ctx->control_streams().size() << " control streams";
     (*device_context_map)[n->id()] = ctx;
   }
 
@@ -355,47 +390,14 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
   gpu::Stream* stream = gpu_device_context->stream();
   const auto stream_id = gpu_device_context->stream_id();
 
-  const bool vlog_1 = VLOG_IS_ON(1);
-  const bool vlog_2 = vlog_1 && VLOG_IS_ON(2);
-
-  if (vlog_1) {
+  if (VLOG_IS_ON(1)) {
     VLOG(1) << "GpuDevice::Compute " << op_kernel->name() << " op "
             << op_kernel->def().op() << " on GPU" << gpu_id_ << " stream["
             << stream_id << "]";
   }
 
-  const auto num_streams = streams_.size();
-  if (num_streams > 1) {
-    // If this op's device context is different from the other contexts,
-    // we must wait on the stream.
-    for (int i = 0; i < context->num_inputs(); ++i) {
-      const GPUDeviceContext* idc =
-          static_cast<GPUDeviceContext*>(context->input_device_context(i));
-      OP_REQUIRES(context, idc != nullptr,
-                  errors::Internal("Input device context ", i,
-                                   " was not set properly."));
-      if (vlog_2) {
-        const void* base;
-        size_t len;
-        if (context->has_input(i)) {
-          if (IsRefType(context->input_dtype(i))) {
-            Tensor tensor = context->mutable_input(i, false);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          } else {
-            const Tensor& tensor = context->input(i);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          }
-          LOG(INFO) << "Input " << i << " " << base << "  " << len;
-          LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
-                    << idc->stream_id() << "])"
-                    << ((idc->stream() == stream) ? " not needed" : "");
-        }
-      }
-      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
-    }
-  }
+  OP_REQUIRES_OK(context, WaitForInputStreams(context, gpu_device_context));
+  PrefetchInputs(op_kernel, context, stream);
   gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
   op_kernel->Compute(context);
   if (context->status().ok()) {
@@ -409,6 +411,58 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
   }
 }
 
+Status BaseGPUDevice::WaitForInputStreams(
+    OpKernelContext* context, GPUDeviceContext* gpu_device_context) {
+  if (streams_.size() == 1) {
+    return Status::OK();
+  }
+  gpu::Stream* stream = gpu_device_context->stream();
+  const bool vlog_2 = VLOG_IS_ON(2);
+
+  // Wait once for each stream other than this op's that one of its inputs
+  // or control inputs was computed on.
+  gtl::InlinedVector<gpu::Stream*, 4> waited_for;
+  auto wait_for = [stream, &waited_for](gpu::Stream* other) {
+    if (other != stream && std::find(waited_for.begin(), waited_for.end(),
+                                     other) == waited_for.end()) {
+      stream->ThenWaitFor(other);
+      waited_for.push_back(other);
+    }
+  };
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    const GPUDeviceContext* idc =
+        static_cast<GPUDeviceContext*>(context->input_device_context(i));
+    if (idc == nullptr) {
+      return errors::Internal("Input device context ", i,
+                              " was not set properly.");
+    }
+    if (vlog_2) {
+      const void* base;
+      size_t len;
+      if (context->has_input(i)) {
+        if (IsRefType(context->input_dtype(i))) {
+          Tensor tensor = context->mutable_input(i, false);
+          base = DMAHelper::base(&tensor);
+          len = tensor.TotalBytes();
+        } else {
+          const Tensor& tensor = context->input(i);
+          base = DMAHelper::base(&tensor);
+          len = tensor.TotalBytes();
+        }
+        LOG(INFO) << "Input " << i << " " << base << "  " << len;
+        LOG(INFO) << "  stream[" << gpu_device_context->stream_id()
+                  << "].ThenWaitFor(stream[" << idc->stream_id() << "])"
+                  << ((idc->stream() == stream) ? " not needed" : "");
+      }
+    }
+    wait_for(idc->stream());
+  }
+  for (gpu::Stream* control_stream : gpu_device_context->control_streams()) {
+    wait_for(control_stream);
+  }
+  return Status::OK();
+}
+
 void BaseGPUDevice::ConsumeListOfAccessedTensors(
     DeviceContext* device_context, const TensorReferenceVector& tensor_refs) {
   GPUDeviceContext* gpu_device_context = device_contexts_[0];
@@ -419,6 +473,29 @@ void BaseGPUDevice::ConsumeListOfAccessedTensors(
   em_->ThenDeleteTensors(stream, tensor_refs);
 }
 
+void BaseGPUDevice::PrefetchInputs(OpKernel* op_kernel,
+                                   OpKernelContext* context,
+                                   gpu::Stream* stream) {
+  if (!use_unified_memory_) return;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (!context->has_input(i) ||
+        op_kernel->input_memory_types()[i] == HOST_MEMORY) {
+      continue;
+    }
+    const Tensor tensor = IsRefType(context->input_dtype(i))
+                              ? context->mutable_input(i, false)
+                              : context->input(i);
+    if (tensor.TotalBytes() > 0) {
+      gpu::DeviceMemoryBase location(
+          const_cast<void*>(DMAHelper::base(&tensor)), tensor.TotalBytes());
+      if (!executor_->MemPrefetch(stream, location, tensor.TotalBytes())) {
+        VLOG(2) << "Could not prefetch input " << i << " of "
+                << op_kernel->name();
+      }
+    }
+  }
+}
+
 // Based on the semantics of Device::Sync this call should wait for
 // all streams not just the current one.
 Status BaseGPUDevice::Sync() { return GPUUtil::SyncAll(this); }
@@ -436,12 +513,23 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   VLOG(1) << "GpuDevice::ComputeAsync " << op_kernel->name() << " op "
           << op_kernel->def().op() << " on GPU" << gpu_id_ << " stream["
           << stream_id << "]";
+  OP_REQUIRES_OK_ASYNC(context,
+                       WaitForInputStreams(context, gpu_device_context), done);
+  PrefetchInputs(op_kernel, context, gpu_device_context->stream());
 
   // When TraceMe profiling is off (which is the default), the
   // following TraceMe constructor is simply a conditional test of
   // false value. Measurements show that its overhead is negligible.
   port::Tracing::TraceMe activity(op_kernel->name(), op_kernel->type_string());
-  op_kernel->ComputeAsync(context, done);
+  // Annotate the kernels launched before ComputeAsync() returns, so that the
+  // GPU tracer attributes them to this op.
+  if (port::Tracing::ScopedAnnotation::Enabled()) {
+    port::Tracing::ScopedAnnotation annotation(op_kernel->name(),
+                                               op_kernel->type_string());
+    op_kernel->ComputeAsync(context, done);
+  } else {
+    op_kernel->ComputeAsync(context, done);
+  }
 }
 
 Status BaseGPUDevice::MakeTensorFromProto(const TensorProto& tensor_proto,
@@ -537,6 +625,36 @@ void BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
   }
 }
 
+namespace {
+
+// StreamExecutor tells whether two GPUs have peer access to one another,
+// but not whether it is over PCIe or NVLink, so all the links are alike.
+const int32 kStreamExecutorLinkStrength = 1;
+
+// Returns the links of "/gpu:tf_gpu_id" to the other GPUs with which it has
+// peer access, where "/gpu:i" is the visible GPU valid_gpu_ids[i].
+LocalLinks GetLocalLinks(const std::vector<int>& valid_gpu_ids,
+                         int tf_gpu_id) {
+  gpu::Platform* gpu_manager = GPUMachineManager();
+  gpu::StreamExecutor* from =
+      gpu_manager->ExecutorForDevice(valid_gpu_ids[tf_gpu_id]).ValueOrDie();
+  LocalLinks links;
+  for (int i = 0; i < valid_gpu_ids.size(); ++i) {
+    if (i == tf_gpu_id) continue;
+    gpu::StreamExecutor* to =
+        gpu_manager->ExecutorForDevice(valid_gpu_ids[i]).ValueOrDie();
+    if (from->CanEnablePeerAccessTo(to)) {
+      InterconnectLink* link = links.add_link();
+      link->set_device_id(i);
+      link->set_type("StreamExecutor");
+      link->set_strength(kStreamExecutorLinkStrength);
+    }
+  }
+  return links;
+}
+
+}  // namespace
+
 Status BaseGPUDeviceFactory::CreateDevices(const SessionOptions& options,
                                            const string& name_prefix,
                                            std::vector<Device*>* devices) {
@@ -551,11 +669,12 @@ Status BaseGPUDeviceFactory::CreateDevices(const SessionOptions& options,
   if (static_cast<size_t>(n) > valid_gpu_ids.size()) {
     n = valid_gpu_ids.size();
   }
+  valid_gpu_ids.resize(n);
   for (int i = 0; i < n; i++) {
     BaseGPUDevice* gpu_device;
-    TF_RETURN_IF_ERROR(CreateGPUDevice(options,
-                                       strings::StrCat(name_prefix, "/gpu:", i),
-                                       valid_gpu_ids[i], &gpu_device));
+    TF_RETURN_IF_ERROR(CreateGPUDevice(
+        options, strings::StrCat(name_prefix, "/gpu:", i), valid_gpu_ids[i],
+        GetLocalLinks(valid_gpu_ids, i), &gpu_device));
     TF_RETURN_IF_ERROR(gpu_device->Init(options));
     devices->push_back(gpu_device);
   }
@@ -590,6 +709,7 @@ static string GetShortDeviceDescription(int device_id,
 
 Status BaseGPUDeviceFactory::CreateGPUDevice(const SessionOptions& options,
                                              const string& name, int gpu_id,
+                                             const LocalLinks& links,
                                              BaseGPUDevice** out_device) {
   CHECK_GE(gpu_id, 0);
 
@@ -629,13 +749,20 @@ Status BaseGPUDeviceFactory::CreateGPUDevice(const SessionOptions& options,
     allocated_memory = total_memory * config_memory_fraction;
   }
 
-  Bytes allocated_bytes = static_cast<Bytes>(allocated_memory);
+  // The session shares the allocator of the process, but may only use its
+  // quota of it.
+  const int64 session_quota =
+      options.config.gpu_options().per_session_gpu_memory_limit_bytes();
+  Bytes allocated_bytes = static_cast<Bytes>(
+      session_quota > 0 ? std::min(allocated_memory, session_quota)
+                        : allocated_memory);
 
   // Get GPU bus_id from its reported NUMA affinity.  Because GPUs are
   // virtualized in some environments, we can't just use the GPU id.
   // NUMA locales are indexed from 0, buses are indexed from 1.
   DeviceLocality dev_locality;
   dev_locality.set_bus_id(numa_node + 1);
+  *dev_locality.mutable_links() = links;
   VLOG(1) << "GPUDevice id " << gpu_id << " on bus " << dev_locality.bus_id()
           << " numa: " << numa_node << " pci: " << desc.pci_bus_id();
 
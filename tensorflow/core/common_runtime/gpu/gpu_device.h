@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/quota_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -109,12 +110,30 @@ class BaseGPUDevice : public LocalDevice {
   int gpu_id_ = -1;
   const bool sync_every_op_ = false;
   const int32 max_streams_;
+  // GPUOptions::per_process_gpu_memory_fraction > 1.
+  const bool use_unified_memory_;
+  // Charges the allocations of this device, and so of its session, against
+  // GPUOptions::per_session_gpu_memory_limit_bytes, if set. gpu_allocator_
+  // points at it then.
+  QuotaAllocator* quota_allocator_ = nullptr;
   std::unique_ptr<EventMgr> em_;
 
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
+
+  // Makes the compute stream of gpu_device_context wait for the streams of
+  // the inputs of context and of the control inputs of its node, when they
+  // are different.
+  Status WaitForInputStreams(OpKernelContext* context,
+                             GPUDeviceContext* gpu_device_context);
+
+  // If use_unified_memory_, enqueues on stream the migration to this GPU of
+  // the inputs of op_kernel in device memory, so that the driver moves them
+  // in bulk rather than page fault by page fault.
+  void PrefetchInputs(OpKernel* op_kernel, OpKernelContext* context,
+                      gpu::Stream* stream);
 };
 
 class BaseGPUDeviceFactory : public DeviceFactory {
@@ -124,7 +143,8 @@ class BaseGPUDeviceFactory : public DeviceFactory {
 
  private:
   Status CreateGPUDevice(const SessionOptions& options, const string& name,
-                         int gpu_id, BaseGPUDevice** out_device);
+                         int gpu_id, const LocalLinks& links,
+                         BaseGPUDevice** out_device);
 
   virtual BaseGPUDevice* CreateGPUDevice(const SessionOptions& options,
                                          const string& name, Bytes memory_limit,
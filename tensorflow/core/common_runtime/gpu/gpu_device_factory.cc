@@ -17,6 +17,8 @@ limitations under the License.
 
 #define EIGEN_USE_GPU
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
@@ -29,9 +31,10 @@ class GPUDevice : public BaseGPUDevice {
             Bytes memory_limit, const DeviceLocality& locality, int gpu_id,
             const string& physical_device_desc, Allocator* gpu_allocator,
             Allocator* cpu_allocator)
-      : BaseGPUDevice(options, name, memory_limit, locality, gpu_id,
-                      physical_device_desc, gpu_allocator, cpu_allocator,
-                      false /* sync every op */, 1 /* max_streams */) {
+      : BaseGPUDevice(
+            options, name, memory_limit, locality, gpu_id, physical_device_desc,
+            gpu_allocator, cpu_allocator, false /* sync every op */,
+            std::max(1, options.config.gpu_options().num_compute_streams())) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
@@ -34,6 +36,13 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
           gpu_options.polling_inactive_delay_msecs()
               ? gpu_options.polling_inactive_delay_msecs()
               : 1),
+      adaptive_polling_(gpu_options.event_completion() ==
+                        GPUOptions::ADAPTIVE_POLLING),
+      use_host_callbacks_(gpu_options.event_completion() ==
+                          GPUOptions::HOST_CALLBACK),
+      polling_spin_usecs_(gpu_options.polling_spin_usecs()
+                              ? gpu_options.polling_spin_usecs()
+                              : 50),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
@@ -46,6 +55,19 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
 EventMgr::~EventMgr() {
   StopPollingLoop();
 
+  // The pending host callbacks refer to this object, so wait for them to run
+  // and then release their InUse records along with the queued ones.
+  {
+    mutex_lock l(mu_);
+    while (!callback_pending_.empty()) {
+      callbacks_drained_.wait(l);
+    }
+    for (InUse& iu : callback_done_) {
+      used_events_.push_back(iu);
+    }
+    callback_done_.clear();
+  }
+
   // Events are owned by this object.
   for (auto& e : free_events_) {
     delete e;
@@ -127,14 +149,34 @@ void EventMgr::FlushAccumulatedTensors() {
 // contention, which argue for longer delay.  The current strategy is
 // to poll frequently when the queue is non-empty, and infrequently
 // otherwise.
+//
+// With adaptive_polling_, the loop instead spins for polling_spin_usecs_
+// after each completion, when the next event of a busy stream is likely to
+// complete soon, and then backs off exponentially while nothing completes.
+// With use_host_callbacks_ there is nothing to poll: the loop only frees
+// the memory of the InUse records whose host callbacks have run.
 void EventMgr::PollLoop() {
+  Env* env = Env::Default();
   bool queue_empty = false;
+  uint64 last_progress_micros = env->NowMicros();
+  int64 backoff_usecs = 1;
   while (!stop_polling_->HasBeenNotified()) {
-    if (queue_empty) {
+    if (use_host_callbacks_) {
+      mutex_lock l(mu_);
+      if (callback_done_.empty()) {
+        WaitForMilliseconds(&l, &events_pending_,
+                            polling_inactive_delay_msecs_);
+      }
+    } else if (queue_empty) {
       mutex_lock l(mu_);
       WaitForMilliseconds(&l, &events_pending_, polling_inactive_delay_msecs_);
-    } else {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+    } else if (!adaptive_polling_) {
+      env->SleepForMicroseconds(polling_active_delay_usecs_);
+    } else if (env->NowMicros() - last_progress_micros >=
+               static_cast<uint64>(polling_spin_usecs_)) {
+      env->SleepForMicroseconds(backoff_usecs);
+      backoff_usecs = std::min<int64>(
+          2 * backoff_usecs, 1000LL * polling_inactive_delay_msecs_);
     }
     ToFreeVector to_free;
     {
@@ -142,14 +184,37 @@ void EventMgr::PollLoop() {
       PollEvents(true, &to_free);
       queue_empty = used_events_.empty();
     }
+    if (!to_free.empty() || queue_empty) {
+      last_progress_micros = env->NowMicros();
+      backoff_usecs = 1;
+    }
     FreeMemory(to_free);
   }
   polling_stopped_->Notify();
 }
 
+void EventMgr::HostCallbackDone(uint64 id) {
+  mutex_lock l(mu_);
+  auto it = callback_pending_.find(id);
+  CHECK(it != callback_pending_.end());
+  callback_done_.push_back(it->second);
+  callback_pending_.erase(it);
+  if (callback_pending_.empty()) callbacks_drained_.notify_all();
+  events_pending_.notify_all();
+}
+
 void EventMgr::QueueInUse(gpu::Stream* stream, InUse iu) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  if (use_host_callbacks_) {
+    // The stream runs the callback once the work enqueued before it has
+    // completed, which is what the Event would have recorded.
+    const uint64 id = next_callback_id_++;
+    iu.event = nullptr;
+    callback_pending_.emplace(id, iu);
+    stream->ThenDoHostCallback([this, id]() { HostCallbackDone(id); });
+    return;
+  }
   // Events are created on demand, and repeatedly reused.  There is no
   // limit placed here on the number of allocated Events.
   if (free_events_.empty()) {
@@ -189,6 +254,13 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
                           gtl::InlinedVector<InUse, 4>* to_free) {
   VLOG(2) << "PollEvents  free_events_ " << free_events_.size()
           << " used_events_ " << used_events_.size();
+  if (use_host_callbacks_) {
+    for (InUse& iu : callback_done_) {
+      to_free->push_back(iu);
+    }
+    callback_done_.clear();
+    return;
+  }
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
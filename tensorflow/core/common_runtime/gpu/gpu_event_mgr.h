@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_EVENT_MGR_H_
 
 #include <deque>
+#include <unordered_map>
 #include <vector>
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -95,6 +96,10 @@ class EventMgr {
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
   const int32 polling_inactive_delay_msecs_;
+  // See GPUOptions::EventCompletion.
+  const bool adaptive_polling_;
+  const bool use_host_callbacks_;
+  const int32 polling_spin_usecs_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -130,9 +135,9 @@ class EventMgr {
     }
   }
 
-  // Stream-enqueue an unused Event and save with it a collection of
-  // Tensors and/or a BufRec to be deleted only after the Event
-  // records.
+  // Stream-enqueue an unused Event (or, if use_host_callbacks_, a host
+  // callback) and save with it a collection of Tensors and/or a BufRec to
+  // be deleted only after the Event records.
   void QueueInUse(perftools::gputools::Stream* stream, InUse in_use)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -164,6 +169,11 @@ class EventMgr {
   // straggler Events.
   void PollLoop();
 
+  // Called from the host callback enqueued for callback_pending_[id] once
+  // its stream reaches it. Calls no CUDA function, as host callbacks must
+  // not: the InUse is retired by the next PollEvents().
+  void HostCallbackDone(uint64 id);
+
   // Setup/Teardown functions for the polling loop.
   void StartPollingLoop();
   void StopPollingLoop();
@@ -180,6 +190,13 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // If use_host_callbacks_: the InUse records whose host callbacks have not
+  // run yet, by id, and those whose callbacks have run.
+  uint64 next_callback_id_ GUARDED_BY(mu_) = 0;
+  std::unordered_map<uint64, InUse> callback_pending_ GUARDED_BY(mu_);
+  std::vector<InUse> callback_done_ GUARDED_BY(mu_);
+  condition_variable callbacks_drained_ GUARDED_BY(mu_);
+
   std::unique_ptr<Notification> stop_polling_;
   std::unique_ptr<Notification> polling_stopped_;
 
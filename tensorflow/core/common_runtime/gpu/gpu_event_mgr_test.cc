@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <atomic>
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -246,6 +247,54 @@ TEST(EventMgr, NonEmptyShutdown) {
   }
 }
 
+// With either non-default EventCompletion, the polling loop alone retires
+// the deferred tensors and runs the callbacks once the stream reaches them.
+void TestEventCompletion(GPUOptions::EventCompletion event_completion) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.set_event_completion(event_completion);
+  EventMgr em(stream_exec, gpu_options);
+  std::unique_ptr<gpu::Stream> stream(new gpu::Stream(stream_exec));
+  CHECK(stream.get());
+  stream->Init();
+  live_tensor_bytes = 0;
+  for (int i = 0; i < 5; ++i) {
+    TensorReferenceVector v;
+    AddTensorReference(&v, 100 * 1048576);
+    em.ThenDeleteTensors(stream.get(), v);
+  }
+  Notification n;
+  em.ThenExecute(stream.get(), [&n]() { n.Notify(); });
+  n.WaitForNotification();
+  EXPECT_EQ(0, live_tensor_bytes);
+}
+
+TEST(EventMgr, AdaptivePolling) {
+  TestEventCompletion(GPUOptions::ADAPTIVE_POLLING);
+}
+
+TEST(EventMgr, HostCallback) { TestEventCompletion(GPUOptions::HOST_CALLBACK); }
+
+// Deleting the EventMgr while host callbacks are pending waits for them.
+TEST(EventMgr, HostCallbackShutdown) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.set_event_completion(GPUOptions::HOST_CALLBACK);
+  std::unique_ptr<gpu::Stream> stream(new gpu::Stream(stream_exec));
+  CHECK(stream.get());
+  stream->Init();
+  live_tensor_bytes = 0;
+  {
+    EventMgr em(stream_exec, gpu_options);
+    for (int i = 0; i < 5; ++i) {
+      TensorReferenceVector v;
+      AddTensorReference(&v, 100 * 1048576);
+      em.ThenDeleteTensors(stream.get(), v);
+    }
+  }
+  EXPECT_EQ(0, live_tensor_bytes);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
@@ -15,7 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 
-#include <set>
+#include <algorithm>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -61,33 +61,46 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
       }
     }
   }
-  // We perform stream assignment assuming a large number of
-  // stream IDs and then map these down to the required number of streams
-  // using simple round-robin.
-  // Stream Assignment strategy:
-  // 1. Nodes with zero inputs are always be executed on a
-  // fresh stream.
-  // 2. Try to execute a node on the same stream as one of its
-  // inputs to avoid inter-stream dependencies.
-  // 3. If any input comes from a node with a large fanout then
-  // perhaps an indication that it is shared between parallel
-  // streams of work. We choose a new stream here so that all consumers
-  // of the tensor are likely to run in parallel.
-  int highest_stream_id = -1;
+  // Stream assignment strategy:
+  // 1. Nodes are grouped into chains, each of which runs on a single
+  // stream. The first consumer (in topological order) of a node's outputs
+  // continues its chain, so that a sequence of dependent kernels needs no
+  // inter-stream dependencies.
+  // 2. A node that only consumes outputs whose chains have already been
+  // continued, or no outputs at all, starts a new chain: it is a branch
+  // that is independent of the chains of its inputs from then on, and may
+  // run in parallel with them.
+  // 3. A new chain goes to the stream with the fewest nodes so far, so that
+  // independent branches are spread across the streams.
+  std::vector<int> chain_to_stream_id;
+  std::vector<int> node_to_chain(graph->num_node_ids(), -1);
+  std::vector<bool> continued(graph->num_node_ids(), false);
+  std::vector<int> stream_size(opts.max_streams, 0);
   for (Node* n : order) {
     VLOG(3) << "Inspecting node " << n->DebugString();
     const int node_id = n->id();
     const string& op = n->type_string();
 
     // Determine a suitable stream to use.
-    int stream_id = highest_stream_id + 1;
+    int chain = -1;
     for (const Edge* e : n->in_edges()) {
-      const size_t fanout = e->src()->out_edges().size();
-      if (fanout == 1) {
-        stream_id = (*node_to_stream_id)[e->src()->id()];
+      if (e->IsControlEdge()) continue;
+      const int src_id = e->src()->id();
+      if (!continued[src_id]) {
+        continued[src_id] = true;
+        chain = node_to_chain[src_id];
         break;
       }
     }
+    if (chain < 0) {
+      chain = chain_to_stream_id.size();
+      chain_to_stream_id.push_back(
+          std::min_element(stream_size.begin(), stream_size.end()) -
+          stream_size.begin());
+    }
+    node_to_chain[node_id] = chain;
+    int stream_id = chain_to_stream_id[chain];
+
     // Override stream for specific op types.
     if (op == "_Send") {
       if (opts.send_stream >= 0) stream_id = opts.send_stream;
@@ -99,10 +112,10 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
       if (opts.compute_stream >= 0) stream_id = opts.compute_stream;
     }
 
-    (*node_to_stream_id)[node_id] = stream_id % opts.max_streams;
-    highest_stream_id = std::max(stream_id, highest_stream_id);
+    (*node_to_stream_id)[node_id] = stream_id;
+    stream_size[stream_id]++;
   }
-  VLOG(1) << "Identified " << highest_stream_id << " candidate streams for "
+  VLOG(1) << "Identified " << chain_to_stream_id.size() << " chains of "
           << order.size() << " nodes.";
 
   return Status::OK();
@@ -103,6 +103,35 @@ TEST_F(GpuStreamUtilTest, SimpleGraphManyStreams) {
   }
 }
 
+TEST_F(GpuStreamUtilTest, IndependentBranches) {
+  auto root = Scope::NewRootScope().ExitOnError();
+  Output a = ops::Const(root.WithOpName("a"), {{1.0f}});
+  Output b1 = ops::Square(root.WithOpName("b1"), a);
+  Output c1 = ops::Square(root.WithOpName("c1"), b1);
+  Output b2 = ops::Neg(root.WithOpName("b2"), a);
+  Output c2 = ops::Neg(root.WithOpName("c2"), b2);
+  ops::Add(root.WithOpName("d"), c1, c2);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<int, int> node_to_stream_id;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = 2;
+  TF_ASSERT_OK(gpu_stream_util::AssignStreams(&g, opts, &node_to_stream_id));
+
+  std::unordered_map<string, int> stream;
+  for (Node* n : g.nodes()) {
+    stream[n->name()] = node_to_stream_id[n->id()];
+  }
+  // Both chains run on a stream of their own, and the first one continues
+  // the chain of their common input. The join continues one of them.
+  EXPECT_EQ(stream["b1"], stream["c1"]);
+  EXPECT_EQ(stream["b2"], stream["c2"]);
+  EXPECT_NE(stream["c1"], stream["c2"]);
+  EXPECT_TRUE(stream["a"] == stream["b1"] || stream["a"] == stream["b2"]);
+  EXPECT_TRUE(stream["d"] == stream["c1"] || stream["d"] == stream["c2"]);
+}
+
 TEST_F(GpuStreamUtilTest, StreamOverrides) {
   auto root = Scope::NewRootScope().ExitOnError();
   ops::_Recv(root.WithOpName("input"), DT_FLOAT, "input", "/cpu:0", 0,
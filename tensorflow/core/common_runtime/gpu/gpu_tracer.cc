@@ -18,10 +18,14 @@ limitations under the License.
 #if GOOGLE_CUDA
 
 #include <stdlib.h>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/cupti_wrapper.h"
 #include "tensorflow/core/platform/env.h"
@@ -160,9 +164,15 @@ class CUPTIManager {
   static constexpr size_t kBufferSize = 32 * 1024;
   // Required alignment of CUPTI buffers.
   static constexpr size_t kBufferAlignment = 8;
+  // Maximum number of completed buffers kept for reuse.  The records of a
+  // buffer are delivered to the client as soon as CUPTI completes it, so
+  // only a few buffers are in flight at any time.
+  static constexpr size_t kMaxFreeBuffers = 64;
 
   mutex mu_;
   CUPTIClient *client_ GUARDED_BY(mu_);
+  mutex buffers_mu_;
+  std::vector<uint8_t *> free_buffers_ GUARDED_BY(buffers_mu_);
   std::unique_ptr<perftools::gputools::profiler::CuptiWrapper> cupti_wrapper_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CUPTIManager);
@@ -215,9 +225,20 @@ Status CUPTIManager::DisableTrace() {
 void CUPTIManager::InternalBufferRequested(uint8_t **buffer, size_t *size,
                                            size_t *maxNumRecords) {
   VLOG(2) << "BufferRequested";
-  void *p = port::AlignedMalloc(kBufferSize, kBufferAlignment);
+  uint8_t *p = nullptr;
+  {
+    mutex_lock l(buffers_mu_);
+    if (!free_buffers_.empty()) {
+      p = free_buffers_.back();
+      free_buffers_.pop_back();
+    }
+  }
+  if (p == nullptr) {
+    p = reinterpret_cast<uint8_t *>(
+        port::AlignedMalloc(kBufferSize, kBufferAlignment));
+  }
   *size = kBufferSize;
-  *buffer = reinterpret_cast<uint8_t *>(p);
+  *buffer = p;
   *maxNumRecords = 0;
 }
 
@@ -227,23 +248,32 @@ void CUPTIManager::InternalBufferCompleted(CUcontext ctx, uint32_t streamId,
   VLOG(2) << "BufferCompleted";
   CUptiResult status;
   CUpti_Activity *record = NULL;
-  mutex_lock l(mu_);  // Hold mu_ while using client_.
-  if (client_ && validSize > 0) {
-    do {
-      status =
-          cupti_wrapper_->ActivityGetNextRecord(buffer, validSize, &record);
-      if (status == CUPTI_SUCCESS) {
-        client_->ActivityCallback(*record);
-      } else {
-        break;
+  {
+    mutex_lock l(mu_);  // Hold mu_ while using client_.
+    if (client_ && validSize > 0) {
+      do {
+        status =
+            cupti_wrapper_->ActivityGetNextRecord(buffer, validSize, &record);
+        if (status == CUPTI_SUCCESS) {
+          client_->ActivityCallback(*record);
+        } else {
+          break;
+        }
+      } while (1);
+
+      // report any records dropped from the queue
+      size_t dropped;
+      CUPTI_CALL(ActivityGetNumDroppedRecords(ctx, streamId, &dropped));
+      if (dropped != 0) {
+        LOG(WARNING) << "Dropped " << dropped << " activity records";
       }
-    } while (1);
-
-    // report any records dropped from the queue
-    size_t dropped;
-    CUPTI_CALL(ActivityGetNumDroppedRecords(ctx, streamId, &dropped));
-    if (dropped != 0) {
-      LOG(WARNING) << "Dropped " << dropped << " activity records";
+    }
+  }
+  {
+    mutex_lock l(buffers_mu_);
+    if (size == kBufferSize && free_buffers_.size() < kMaxFreeBuffers) {
+      free_buffers_.push_back(buffer);
+      return;
     }
   }
   port::AlignedFree(buffer);
@@ -304,11 +334,16 @@ class GPUTracerImpl : public GPUTracer,
     VLOG(2) << "PushAnnotation " << name;
     struct Impl : public port::Tracing::Engine::Annotation {
       string annotation;
-      explicit Impl(StringPiece n) : annotation(n.ToString()) {
+      const char *outer_annotation;
+      explicit Impl(StringPiece n)
+          : annotation(n.ToString()),
+            outer_annotation(tls_current_annotation.get()) {
         // Remember the most recent ScopedAnnotation for each thread.
         tls_current_annotation.get() = annotation.c_str();
       }
-      ~Impl() { tls_current_annotation.get() = nullptr; }
+      // Annotations are destroyed in LIFO order, so the kernels launched
+      // after an inner annotation is gone belong to the outer one.
+      ~Impl() { tls_current_annotation.get() = outer_annotation; }
     };
     return new Impl(name);
   }
@@ -330,6 +365,21 @@ class GPUTracerImpl : public GPUTracer,
     uint32 device_id;
     uint32 stream_id;
     uint32 correlation_id;
+    // Points into kernel_names_.
+    const string *name;
+    uint32 grid[3];
+    uint32 block[3];
+    uint32 registers_per_thread;
+    uint32 shared_memory_bytes;
+  };
+  // Internal struct to record the limits of the multiprocessors of a device,
+  // which bound the occupancy of the kernels.
+  struct DeviceRecord {
+    uint32 threads_per_warp;
+    uint32 max_warps_per_multiprocessor;
+    uint32 max_blocks_per_multiprocessor;
+    uint32 max_registers_per_multiprocessor;
+    uint32 max_shared_memory_per_multiprocessor;
   };
   // Internal struct to record memcpy operations.
   struct MemcpyRecord {
@@ -352,6 +402,18 @@ class GPUTracerImpl : public GPUTracer,
   // Records the mapping between correlation ID and kernel name.
   void AddCorrelationId(uint32 correlation_id, const string &name);
 
+  // Returns the fraction of the warps of a multiprocessor of 'device' that
+  // can be active running 'kernel', as limited by its block size, registers
+  // and shared memory.  This ignores the allocation granularity of the
+  // registers and shared memory, so it is an upper bound of the achieved
+  // occupancy, but a kernel well below it is latency bound.
+  static double TheoreticalOccupancy(const DeviceRecord &device,
+                                     const KernelRecord &kernel);
+
+  // Returns a description of 'kernel' for the timeline.
+  static string KernelDetails(const KernelRecord &kernel,
+                              const DeviceRecord *device);
+
   // Returns the current system time in microseconds.
   inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
 
@@ -364,6 +426,8 @@ class GPUTracerImpl : public GPUTracer,
   std::map<uint32, string> correlations_ GUARDED_BY(trace_mu_);
   std::vector<KernelRecord> kernel_records_ GUARDED_BY(trace_mu_);
   std::vector<MemcpyRecord> memcpy_records_ GUARDED_BY(trace_mu_);
+  std::unordered_set<string> kernel_names_ GUARDED_BY(trace_mu_);
+  std::map<uint32, DeviceRecord> devices_ GUARDED_BY(trace_mu_);
 
   mutex mu_;
   bool enabled_ GUARDED_BY(mu_);
@@ -547,9 +611,35 @@ void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
     case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
       if (kernel_records_.size() >= kMaxRecords) return;
       auto *kernel = reinterpret_cast<const CUpti_ActivityKernel3 *>(&record);
-      kernel_records_.push_back(KernelRecord{kernel->start, kernel->end,
-                                             kernel->deviceId, kernel->streamId,
-                                             kernel->correlationId});
+      // The name is only valid for the duration of the callback.
+      const string *name =
+          &*kernel_names_.insert(kernel->name ? kernel->name : "unknown")
+                .first;
+      kernel_records_.push_back(KernelRecord{
+          kernel->start,
+          kernel->end,
+          kernel->deviceId,
+          kernel->streamId,
+          kernel->correlationId,
+          name,
+          {static_cast<uint32>(kernel->gridX),
+           static_cast<uint32>(kernel->gridY),
+           static_cast<uint32>(kernel->gridZ)},
+          {static_cast<uint32>(kernel->blockX),
+           static_cast<uint32>(kernel->blockY),
+           static_cast<uint32>(kernel->blockZ)},
+          kernel->registersPerThread,
+          static_cast<uint32>(kernel->staticSharedMemory +
+                              kernel->dynamicSharedMemory)});
+      break;
+    }
+    case CUPTI_ACTIVITY_KIND_DEVICE: {
+      auto *device = reinterpret_cast<const CUpti_ActivityDevice2 *>(&record);
+      devices_[device->id] = DeviceRecord{
+          device->numThreadsPerWarp, device->maxWarpsPerMultiprocessor,
+          device->maxBlocksPerMultiprocessor,
+          device->maxRegistersPerMultiprocessor,
+          device->maxSharedMemoryPerMultiprocessor};
       break;
     }
     default:
@@ -557,6 +647,50 @@ void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
   }
 }
 
+/*static*/ double GPUTracerImpl::TheoreticalOccupancy(
+    const DeviceRecord &device, const KernelRecord &kernel) {
+  const uint64 threads_per_block = static_cast<uint64>(kernel.block[0]) *
+                                   kernel.block[1] * kernel.block[2];
+  if (threads_per_block == 0 || device.threads_per_warp == 0 ||
+      device.max_warps_per_multiprocessor == 0) {
+    return 0;
+  }
+  const uint64 warps_per_block =
+      (threads_per_block + device.threads_per_warp - 1) /
+      device.threads_per_warp;
+  uint64 blocks = std::min<uint64>(
+      device.max_blocks_per_multiprocessor,
+      device.max_warps_per_multiprocessor / warps_per_block);
+  const uint64 registers_per_block = static_cast<uint64>(
+      kernel.registers_per_thread) * warps_per_block * device.threads_per_warp;
+  if (registers_per_block > 0) {
+    blocks = std::min<uint64>(
+        blocks, device.max_registers_per_multiprocessor / registers_per_block);
+  }
+  if (kernel.shared_memory_bytes > 0) {
+    blocks = std::min<uint64>(blocks,
+                              device.max_shared_memory_per_multiprocessor /
+                                  kernel.shared_memory_bytes);
+  }
+  return static_cast<double>(blocks * warps_per_block) /
+         device.max_warps_per_multiprocessor;
+}
+
+/*static*/ string GPUTracerImpl::KernelDetails(const KernelRecord &kernel,
+                                               const DeviceRecord *device) {
+  string details = strings::StrCat(
+      *kernel.name, " grid:", kernel.grid[0], "x", kernel.grid[1], "x",
+      kernel.grid[2], " block:", kernel.block[0], "x", kernel.block[1], "x",
+      kernel.block[2], " regs:", kernel.registers_per_thread,
+      " smem:", kernel.shared_memory_bytes);
+  if (device != nullptr) {
+    strings::StrAppend(
+        &details, strings::Printf(" occupancy:%.0f%%",
+                                  100 * TheoreticalOccupancy(*device, kernel)));
+  }
+  return details;
+}
+
 Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
   mutex_lock l(mu_);
   if (enabled_) {
@@ -583,8 +717,9 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
     ns->set_op_end_rel_micros(elapsed_us);
     ns->set_all_end_rel_micros(elapsed_us);
     ns->set_node_name(name);
-    // TODO(pbar) Generate details based on the kernel activity record.
-    // ns->set_timeline_label(details);
+    auto device = devices_.find(rec.device_id);
+    ns->set_timeline_label(KernelDetails(
+        rec, device != devices_.end() ? &device->second : nullptr));
     auto nscopy = new NodeExecStats;
     *nscopy = *ns;
     collector->Save(strings::StrCat(stream_device, "all"), ns);
@@ -604,9 +739,14 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
     auto copyKind = static_cast<CUpti_ActivityMemcpyKind>(rec.copyKind);
     auto srcKind = static_cast<CUpti_ActivityMemoryKind>(rec.srcKind);
     auto dstKind = static_cast<CUpti_ActivityMemoryKind>(rec.dstKind);
+    // Bytes per nanosecond are GB/s.
+    const double throughput =
+        static_cast<double>(rec.bytes) /
+        std::max<uint64_t>(rec.end_timestamp - rec.start_timestamp, 1);
     const string details = strings::Printf(
-        "MEMCPY%s %llu bytes (%s to %s)", getMemcpyKindString(copyKind),
-        rec.bytes, getMemoryKindString(srcKind), getMemoryKindString(dstKind));
+        "MEMCPY%s %llu bytes (%s to %s) %.2f GB/s",
+        getMemcpyKindString(copyKind), rec.bytes, getMemoryKindString(srcKind),
+        getMemoryKindString(dstKind), throughput);
     ns->set_node_name(
         strings::StrCat(name, ":MEMCPY", getMemcpyKindString(copyKind)));
     ns->set_timeline_label(details);
@@ -15,12 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
@@ -32,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -113,6 +120,188 @@ void* GetBase(const Tensor* src) {
 
 void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+namespace {
+
+// Copies between pageable host memory and a GPU are synchronous, and go
+// through a staging buffer of the driver anyway. Copies of at least
+// kStagingMinBytes of a host tensor that was not allocated by the CUDA host
+// allocator instead go through the pinned buffers of a StagingPool, in
+// chunks of kStagingChunkBytes: the memcpy of a chunk to or from pinned
+// memory on the host overlaps the DMA of the others.
+const int64 kStagingMinBytes = 1 << 16;
+const int64 kStagingChunkBytes = 1 << 22;
+// The number of pinned buffers the process may stage copies through at
+// once. The remainder of a copy that finds none free is copied directly,
+// from or to pageable memory.
+const int kMaxStagingChunks = 16;
+
+class StagingPool {
+ public:
+  static StagingPool* Get() {
+    static StagingPool* pool = new StagingPool;
+    return pool;
+  }
+
+  // True if the copy of the "total_bytes" of "host_tensor" should be staged.
+  bool ShouldStage(const Tensor& host_tensor, int64 total_bytes) {
+    if (total_bytes < kStagingMinBytes) return false;
+    AllocationDescription desc;
+    DMAHelper::buffer(&host_tensor)->FillAllocationDescription(&desc);
+    return desc.allocator_name() != pinned_allocator_name_;
+  }
+
+  // Returns a free pinned buffer of kStagingChunkBytes, or nullptr if
+  // kMaxStagingChunks are in use.
+  char* Acquire() {
+    mutex_lock l(mu_);
+    if (!free_.empty()) {
+      char* buf = free_.back();
+      free_.pop_back();
+      return buf;
+    }
+    if (num_allocated_ == kMaxStagingChunks) return nullptr;
+    char* buf = static_cast<char*>(pinned_allocator_->AllocateRaw(
+        Allocator::kAllocatorAlignment, kStagingChunkBytes));
+    if (buf != nullptr) ++num_allocated_;
+    return buf;
+  }
+
+  void Release(char* buf) {
+    mutex_lock l(mu_);
+    free_.push_back(buf);
+  }
+
+ private:
+  StagingPool()
+      : pinned_allocator_(ProcessState::singleton()->GetCUDAHostAllocator(0)),
+        pinned_allocator_name_(pinned_allocator_->Name()) {}
+
+  Allocator* const pinned_allocator_;
+  const string pinned_allocator_name_;
+  mutex mu_;
+  std::vector<char*> free_ GUARDED_BY(mu_);
+  int num_allocated_ GUARDED_BY(mu_) = 0;
+};
+
+// Enqueues on "stream" the copy of "total_bytes" from pageable "src" to
+// "dst", staged through the StagingPool. Returns once "src" may be reused.
+void StagedCopyToDevice(EventMgr* event_mgr, gpu::Stream* stream,
+                        const char* src, void* dst, int64 total_bytes) {
+  StagingPool* pool = StagingPool::Get();
+  for (int64 offset = 0; offset < total_bytes; offset += kStagingChunkBytes) {
+    const int64 bytes = std::min(kStagingChunkBytes, total_bytes - offset);
+    DeviceMemoryBase dst_chunk(static_cast<char*>(dst) + offset, bytes);
+    char* staging = pool->Acquire();
+    if (staging == nullptr) {
+      DeviceMemoryBase dst_rest(static_cast<char*>(dst) + offset,
+                                total_bytes - offset);
+      stream->ThenMemcpy(&dst_rest, src + offset, total_bytes - offset);
+      return;
+    }
+    memcpy(staging, src + offset, bytes);
+    stream->ThenMemcpy(&dst_chunk, staging, bytes);
+    event_mgr->ThenExecute(stream, [pool, staging]() {
+      pool->Release(staging);
+    });
+  }
+}
+
+// Calls "done" once Unref() has been called once more than Ref().
+class StagedCopyDone {
+ public:
+  explicit StagedCopyDone(std::function<void()> done)
+      : done_(std::move(done)) {}
+
+  void Ref() { count_.fetch_add(1); }
+  void Unref() {
+    if (count_.fetch_sub(1) == 1) {
+      done_();
+      delete this;
+    }
+  }
+
+ private:
+  std::function<void()> done_;
+  std::atomic<int> count_{1};
+};
+
+// Enqueues on "stream" the copy of "total_bytes" from "src" to pageable
+// "dst", staged through the StagingPool, and calls "done" once "dst" holds
+// all of them.
+void StagedCopyFromDevice(EventMgr* event_mgr, gpu::Stream* stream,
+                          const void* src, char* dst, int64 total_bytes,
+                          std::function<void()> done) {
+  StagingPool* pool = StagingPool::Get();
+  StagedCopyDone* copy_done = new StagedCopyDone(std::move(done));
+  for (int64 offset = 0; offset < total_bytes; offset += kStagingChunkBytes) {
+    const int64 bytes = std::min(kStagingChunkBytes, total_bytes - offset);
+    DeviceMemoryBase src_chunk(
+        const_cast<char*>(static_cast<const char*>(src)) + offset, bytes);
+    char* staging = pool->Acquire();
+    if (staging == nullptr) {
+      DeviceMemoryBase src_rest(src_chunk.opaque(), total_bytes - offset);
+      stream->ThenMemcpy(dst + offset, src_rest, total_bytes - offset);
+      break;
+    }
+    stream->ThenMemcpy(staging, src_chunk, bytes);
+    copy_done->Ref();
+    event_mgr->ThenExecute(
+        stream, [pool, staging, dst, offset, bytes, copy_done]() {
+          memcpy(dst + offset, staging, bytes);
+          pool->Release(staging);
+          copy_done->Unref();
+        });
+  }
+  event_mgr->ThenExecute(stream, [copy_done]() { copy_done->Unref(); });
+}
+
+// True if "src" has a direct link to "dst" in its DeviceLocality, or is it.
+bool HasDirectLink(const Device* src, const Device* dst) {
+  if (src == dst) return true;
+  const int dst_id = dst->parsed_name().id;
+  for (const auto& link : src->attributes().locality().links().link()) {
+    if (link.device_id() == dst_id) return true;
+  }
+  return false;
+}
+
+// Enqueues the copy of "total_bytes" from "src" on the GPU of "send_stream"
+// to "dst" on the GPU of "recv_stream", staged through the StagingPool: the
+// DMA of a chunk to the host on "send_stream" overlaps that of the previous
+// one from the host on "recv_stream". Calls "done" once "dst" holds all the
+// bytes.
+void StagedCopyDeviceToDevice(EventMgr* recv_event_mgr,
+                              gpu::Stream* send_stream,
+                              gpu::Stream* recv_stream, const void* src,
+                              void* dst, int64 total_bytes,
+                              std::function<void()> done) {
+  StagingPool* pool = StagingPool::Get();
+  char* src_base = const_cast<char*>(static_cast<const char*>(src));
+  char* dst_base = static_cast<char*>(dst);
+  for (int64 offset = 0; offset < total_bytes; offset += kStagingChunkBytes) {
+    const int64 bytes = std::min(kStagingChunkBytes, total_bytes - offset);
+    char* staging = pool->Acquire();
+    if (staging == nullptr) {
+      DeviceMemoryBase src_rest(src_base + offset, total_bytes - offset);
+      DeviceMemoryBase dst_rest(dst_base + offset, total_bytes - offset);
+      send_stream->ThenMemcpy(&dst_rest, src_rest, total_bytes - offset);
+      break;
+    }
+    DeviceMemoryBase src_chunk(src_base + offset, bytes);
+    DeviceMemoryBase dst_chunk(dst_base + offset, bytes);
+    send_stream->ThenMemcpy(staging, src_chunk, bytes);
+    recv_stream->ThenWaitFor(send_stream);
+    recv_stream->ThenMemcpy(&dst_chunk, staging, bytes);
+    recv_event_mgr->ThenExecute(recv_stream, [pool, staging]() {
+      pool->Release(staging);
+    });
+  }
+  recv_stream->ThenWaitFor(send_stream);
+  recv_event_mgr->ThenExecute(recv_stream, std::move(done));
+}
+
+}  // namespace
+
 /*static*/
 void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
                               const DeviceContext* device_context,
@@ -214,6 +403,37 @@ void GPUUtil::DeviceToDeviceCopy(DeviceContext* send_dev_context,
   send_device_to_device_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = input->TotalBytes();
+  if (total_bytes >= kStagingMinBytes && !HasDirectLink(src, dst)) {
+    // Without peer access the driver would stage the copy through host
+    // memory synchronously, so pipeline it through pinned buffers instead.
+    auto recv_stream =
+        static_cast<const GPUDeviceContext*>(recv_dev_context)->stream();
+    auto recv_host_to_device_stream =
+        static_cast<const GPUDeviceContext*>(recv_dev_context)
+            ->host_to_device_stream();
+    const DeviceBase::GpuDeviceInfo* recv_dev_info =
+        dst->tensorflow_gpu_device_info();
+    if (recv_stream == nullptr || recv_host_to_device_stream == nullptr ||
+        recv_dev_info == nullptr) {
+      done(errors::Internal("No recv gpu stream is available."));
+      return;
+    }
+    recv_host_to_device_stream->ThenWaitFor(recv_stream);
+    TensorReference input_ref(*input);
+    StagedCopyDeviceToDevice(
+        recv_dev_info->event_mgr, send_device_to_device_stream,
+        recv_host_to_device_stream, GetBase(input), GetBase(output),
+        total_bytes, [done, send_device_to_device_stream,
+                      recv_host_to_device_stream, input_ref]() {
+          input_ref.Unref();
+          if (!send_device_to_device_stream->ok() ||
+              !recv_host_to_device_stream->ok()) {
+            LOG(FATAL) << "GPU->GPU Memcpy failed";
+          }
+          done(Status::OK());
+        });
+    return;
+  }
   if (total_bytes > 0) {
     void* src_ptr = GetBase(input);
     DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
@@ -281,23 +501,30 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64 total_bytes = gpu_tensor->TotalBytes();
+  // Use of the input may outlive stack scope, so keep a ref.
+  TensorReference input_ref(*gpu_tensor);
+  auto copy_done = [send_device_to_host_stream, done, input_ref]() {
+    if (!send_device_to_host_stream->ok()) {
+      LOG(FATAL) << "GPU->CPU Memcpy failed";
+    }
+    input_ref.Unref();
+    done(Status::OK());
+  };
+  if (total_bytes > 0 &&
+      StagingPool::Get()->ShouldStage(*cpu_tensor, total_bytes)) {
+    StagedCopyFromDevice(dev_info->event_mgr, send_device_to_host_stream,
+                         GetBase(gpu_tensor),
+                         static_cast<char*>(GetBase(cpu_tensor)), total_bytes,
+                         copy_done);
+    return;
+  }
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
     void* dst_ptr = GetBase(cpu_tensor);
     send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
   }
-  // Use of the input may outlive stack scope, so keep a ref.
-  TensorReference input_ref(*gpu_tensor);
-  dev_info->event_mgr->ThenExecute(
-      send_device_to_host_stream,
-      [send_device_to_host_stream, done, input_ref]() {
-        if (!send_device_to_host_stream->ok()) {
-          LOG(FATAL) << "GPU->CPU Memcpy failed";
-        }
-        input_ref.Unref();
-        done(Status::OK());
-      });
+  dev_info->event_mgr->ThenExecute(send_device_to_host_stream, copy_done);
 }
 
 /*  static */
@@ -327,7 +554,12 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
 
   const int64 total_bytes = cpu_tensor->TotalBytes();
   // Note that 0-size tensors have no backing buffer.
-  if (total_bytes > 0) {
+  if (total_bytes > 0 &&
+      StagingPool::Get()->ShouldStage(*cpu_tensor, total_bytes)) {
+    StagedCopyToDevice(dev_info->event_mgr, recv_host_to_device_stream,
+                       static_cast<const char*>(GetBase(cpu_tensor)),
+                       GetBase(gpu_tensor), total_bytes);
+  } else if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
     void* dst_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
@@ -152,16 +153,22 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
 }
 
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
-  // Although we're temporarily ignoring numa_node, check for legality.
   CHECK_GE(numa_node, 0);
-  // TODO(tucker): actually maintain separate CPUAllocators for
-  // different numa_nodes.  For now, just one.
-  numa_node = 0;
+  // Each NUMA node has its own pool, so that a buffer first touched by the
+  // threads of one node is only reused on that node.
+  if (numa_node >= port::NUMANumNodes()) numa_node = 0;
   mutex_lock lock(mu_);
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
-    Allocator* allocator =
+    VisitableAllocator* pool =
         new PoolAllocator(100 /*pool_size_limit*/, true /*auto_resize*/,
                           new BasicCPUAllocator(), new NoopRounder, "cpu_pool");
+    for (const AllocVisitor& v : cpu_alloc_visitors_) {
+      pool->AddAllocVisitor(v);
+    }
+    for (const AllocVisitor& v : cpu_free_visitors_) {
+      pool->AddFreeVisitor(v);
+    }
+    Allocator* allocator = pool;
     if (LogMemory::IsEnabled()) {
       // Wrap the allocator to track allocation ids for better logging
       // at the cost of performance.
@@ -169,7 +176,7 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
     }
     cpu_allocators_.push_back(allocator);
   }
-  return cpu_allocators_[0];
+  return cpu_allocators_[numa_node];
 }
 
 Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
@@ -210,9 +217,14 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
       LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
     }
     int64 cuda_host_mem_limit = cuda_host_mem_limit_in_mb * (1LL << 20);
-    Allocator* allocator =
+    VisitableAllocator* bfc =
         new BFCAllocator(new CUDAHostAllocator(se), cuda_host_mem_limit,
                          true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    for (const AllocVisitor& v : cuda_host_alloc_visitors_) {
+      bfc->AddAllocVisitor(v);
+    }
+    cuda_host_visitable_allocators_.push_back(bfc);
+    Allocator* allocator = bfc;
 
     if (LogMemory::IsEnabled()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -254,4 +266,36 @@ void ProcessState::AddGPUAllocVisitor(int bus_id, AllocVisitor visitor) {
 #endif  // GOOGLE_CUDA
 }
 
+void ProcessState::AddCPUAllocVisitor(AllocVisitor visitor) {
+  mutex_lock lock(mu_);
+  if (!cpu_allocators_.empty()) {
+    LOG(WARNING) << "AddCPUAllocVisitor called after the CPU allocator was "
+                 << "created; the visitor will not be called";
+    return;
+  }
+  cpu_alloc_visitors_.push_back(visitor);
+}
+
+void ProcessState::AddCPUFreeVisitor(AllocVisitor visitor) {
+  mutex_lock lock(mu_);
+  if (!cpu_allocators_.empty()) {
+    LOG(WARNING) << "AddCPUFreeVisitor called after the CPU allocator was "
+                 << "created; the visitor will not be called";
+    return;
+  }
+  cpu_free_visitors_.push_back(visitor);
+}
+
+void ProcessState::AddCUDAHostAllocVisitor(int numa_node,
+                                           AllocVisitor visitor) {
+#if GOOGLE_CUDA
+  CHECK_GE(numa_node, 0);
+  mutex_lock lock(mu_);
+  for (VisitableAllocator* allocator : cuda_host_visitable_allocators_) {
+    allocator->AddAllocVisitor(visitor);
+  }
+  cuda_host_alloc_visitors_.push_back(visitor);
+#endif  // GOOGLE_CUDA
+}
+
 }  // namespace tensorflow
@@ -107,6 +107,21 @@ class ProcessState {
   typedef std::function<void(void*, size_t)> AllocVisitor;
   virtual void AddGPUAllocVisitor(int bus_id, AllocVisitor visitor);
 
+  // Registers functions to be called on every region of memory that the
+  // CPU allocator obtains from the system, and on every region that it
+  // returns to the system, with the same intention as
+  // AddGPUAllocVisitor().  The CPU allocator cannot visit regions it has
+  // already obtained, so visitors only take effect if they are added
+  // before the first call to GetCPUAllocator().
+  virtual void AddCPUAllocVisitor(AllocVisitor visitor);
+  virtual void AddCPUFreeVisitor(AllocVisitor visitor);
+
+  // Registers a function to be called on every region of memory that the
+  // CUDA host allocator for "numa_node" obtains, including the regions
+  // obtained before the call.
+  // TEMPORARY: ignores numa_node, like GetCUDAHostAllocator().
+  virtual void AddCUDAHostAllocVisitor(int numa_node, AllocVisitor visitor);
+
   typedef std::unordered_map<const void*, MemDesc> MDMap;
 
  protected:
@@ -121,6 +136,12 @@ class ProcessState {
   std::vector<VisitableAllocator*> gpu_allocators_ GUARDED_BY(mu_);
   std::vector<std::vector<AllocVisitor>> gpu_visitors_ GUARDED_BY(mu_);
   std::vector<Allocator*> cuda_host_allocators_ GUARDED_BY(mu_);
+  // The allocators in cuda_host_allocators_, before any wrapping.
+  std::vector<VisitableAllocator*> cuda_host_visitable_allocators_
+      GUARDED_BY(mu_);
+  std::vector<AllocVisitor> cpu_alloc_visitors_ GUARDED_BY(mu_);
+  std::vector<AllocVisitor> cpu_free_visitors_ GUARDED_BY(mu_);
+  std::vector<AllocVisitor> cuda_host_alloc_visitors_ GUARDED_BY(mu_);
 
   virtual ~ProcessState();
 
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 
@@ -32,15 +35,20 @@ namespace gpu = ::perftools::gputools;
 class GPUDeviceContext : public DeviceContext {
  public:
   // Does not take ownership of streams.
+  //
+  // control_streams: the compute streams of the control inputs of the
+  // nodes that use this context, which they wait for before computing.
   GPUDeviceContext(int stream_id, gpu::Stream* stream,
                    gpu::Stream* host_to_device_stream,
                    gpu::Stream* device_to_host_stream,
-                   gpu::Stream* device_to_device_stream)
+                   gpu::Stream* device_to_device_stream,
+                   std::vector<gpu::Stream*> control_streams = {})
       : stream_id_(stream_id),
         stream_(stream),
         host_to_device_stream_(host_to_device_stream),
         device_to_host_stream_(device_to_host_stream),
-        device_to_device_stream_(device_to_device_stream) {}
+        device_to_device_stream_(device_to_device_stream),
+        control_streams_(std::move(control_streams)) {}
 
   ~GPUDeviceContext() override {}
 
@@ -51,6 +59,9 @@ class GPUDeviceContext : public DeviceContext {
     return device_to_device_stream_;
   }
   int stream_id() const { return stream_id_; }
+  const std::vector<gpu::Stream*>& control_streams() const {
+    return control_streams_;
+  }
 
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor,
@@ -74,6 +85,8 @@ class GPUDeviceContext : public DeviceContext {
   gpu::Stream* device_to_host_stream_;
   // The stream to use for copy data between GPU.
   gpu::Stream* device_to_device_stream_;
+  // The streams to wait for before computing, besides those of the inputs.
+  std::vector<gpu::Stream*> control_streams_;
 };
 
 }  // namespace tensorflow
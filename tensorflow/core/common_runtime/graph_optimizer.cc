@@ -24,11 +24,19 @@ limitations under the License.
 
 namespace tensorflow {
 
-GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts) : opts_(opts) {
+GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts)
+    : GraphOptimizer(opts, ConstantFoldingOptions()) {}
+
+GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts,
+                               const ConstantFoldingOptions& cf_opts)
+    : opts_(opts), cf_opts_(cf_opts) {
   if (opts_.opt_level() >= OptimizerOptions::L1) {
     opts_.set_do_common_subexpression_elimination(true);
     opts_.set_do_constant_folding(true);
   }
+  if (opts_.max_folded_constant_bytes() > 0) {
+    cf_opts_.max_constant_size_in_bytes = opts_.max_folded_constant_bytes();
+  }
 }
 
 GraphOptimizer::~GraphOptimizer() {}
@@ -38,6 +46,10 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
   Graph* g = graph->get();
   DumpGraph("Initial", g);
 
+  // Inlining small functions needs the same cleanups as inlining all.
+  const bool inlines_functions = opts_.do_function_inlining() ||
+                                 opts_.max_inlined_function_nodes() > 0;
+
   bool changed = true;
   const int kMaxRounds = 10;
   for (int rounds = 0; rounds < kMaxRounds; ++rounds) {
@@ -46,19 +58,18 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
       DumpGraph("RemoveListArrayConverter", g);
       changed = true;
     }
-    if (opts_.do_function_inlining() && RemoveDeadNodes(g)) {
+    if (inlines_functions && RemoveDeadNodes(g)) {
       DumpGraph("RemoveDeadNodes", g);
       changed = true;
     }
-    if (opts_.do_function_inlining() && RemoveIdentityNodes(g)) {
+    if (inlines_functions && RemoveIdentityNodes(g)) {
       DumpGraph("RemoveIdentityNodes", g);
       changed = true;
     }
 
     if (opts_.do_constant_folding()) {
-      ConstantFoldingOptions cf_opts;
       bool was_mutated;
-      ConstantFold(cf_opts, runtime, env, device, g, &was_mutated)
+      ConstantFold(cf_opts_, runtime, env, device, g, &was_mutated)
           .IgnoreError();
       if (was_mutated) {
         RemoveDeadNodes(g);
@@ -67,7 +78,7 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
       }
     }
 
-    if (opts_.do_function_inlining() && FixupSourceAndSinkEdges(g)) {
+    if (inlines_functions && FixupSourceAndSinkEdges(g)) {
       DumpGraph("FixupSourceAndSinkEdges", g);
       changed = true;
     }
@@ -79,6 +90,12 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
     if (opts_.do_function_inlining() && ExpandInlineFunctions(runtime, g)) {
       DumpGraph("ExpandInlineFunctions", g);
       changed = true;
+    } else if (!opts_.do_function_inlining() &&
+               opts_.max_inlined_function_nodes() > 0 &&
+               ExpandInlineFunctions(runtime, g,
+                                     opts_.max_inlined_function_nodes())) {
+      DumpGraph("ExpandInlineFunctions", g);
+      changed = true;
     }
     if (!changed) break;
   }
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_OPTIMIZER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_OPTIMIZER_H_
 
+#include "tensorflow/core/common_runtime/constant_folding.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -27,6 +28,12 @@ namespace tensorflow {
 class GraphOptimizer {
  public:
   GraphOptimizer(const OptimizerOptions& opts);
+
+  // Like above, but constant folding, if 'opts' enables it, uses 'cf_opts'.
+  // A positive 'opts.max_folded_constant_bytes' overrides
+  // 'cf_opts.max_constant_size_in_bytes'.
+  GraphOptimizer(const OptimizerOptions& opts,
+                 const ConstantFoldingOptions& cf_opts);
   ~GraphOptimizer();
 
   // Applies optimization passes specified in 'opts' to 'graph'.
@@ -39,6 +46,7 @@ class GraphOptimizer {
 
  private:
   OptimizerOptions opts_;
+  ConstantFoldingOptions cf_opts_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(GraphOptimizer);
 };
@@ -102,7 +102,8 @@ GraphRunner::~GraphRunner() {}
 Status GraphRunner::Run(Graph* graph, FunctionLibraryRuntime* function_library,
                         const NamedTensorList& inputs,
                         const std::vector<string>& output_names,
-                        std::vector<Tensor>* outputs) {
+                        std::vector<Tensor>* outputs,
+                        thread::ThreadPool* thread_pool) {
   if (cpu_device_ == nullptr) {
     return errors::NotFound("Cannot find a device for GraphRunner.");
   }
@@ -139,9 +140,16 @@ Status GraphRunner::Run(Graph* graph, FunctionLibraryRuntime* function_library,
   // Create the local executor and the Rendezvous for fetching back the
   // constants.
 
-  // Run operators on the local thread. We should not need concurrency here; we
-  // should not be running expensive operators.
-  auto runner = [](Executor::Args::Closure c) { c(); };
+  // Run operators on the local thread unless the caller provides a thread
+  // pool. We should not be running expensive operators, but large graphs can
+  // have many independent ones.
+  std::function<void(Executor::Args::Closure)> runner =
+      [](Executor::Args::Closure c) { c(); };
+  if (thread_pool != nullptr) {
+    runner = [thread_pool](Executor::Args::Closure c) {
+      thread_pool->Schedule(std::move(c));
+    };
+  }
 
   // Take ownership and pass to NewLocalExecutor
   Graph* g = graph_to_run.release();
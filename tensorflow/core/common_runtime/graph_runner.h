@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -55,13 +56,17 @@ class GraphRunner {
   // NOTE: The output tensors share lifetime with the GraphRunner, and could
   // be destroyed once the GraphRunner is destroyed.
   //
+  // The nodes run on the calling thread, unless `thread_pool` is not
+  // nullptr, in which case independent nodes run in parallel in it.
+  //
   // REQUIRES: `graph`, `env`, and `outputs` are not nullptr.
   // `function_library` may be nullptr.
   typedef std::vector<std::pair<string, Tensor>> NamedTensorList;
   Status Run(Graph* graph, FunctionLibraryRuntime* function_library,
              const NamedTensorList& inputs,
              const std::vector<string>& output_names,
-             std::vector<Tensor>* outputs);
+             std::vector<Tensor>* outputs,
+             thread::ThreadPool* thread_pool = nullptr);
 
  private:
   std::unique_ptr<Device> cpu_device_;
@@ -76,6 +76,17 @@ Benchmark::Benchmark(const string& device, Graph* g,
   params.delete_kernel = [](OpKernel* kernel) {
     DeleteNonCachedKernel(kernel);
   };
+  if (options->config.graph_options()
+          .optimizer_options()
+          .use_work_stealing_executor()) {
+    params.num_work_stealing_workers = pool_->NumThreads();
+  }
+  params.use_step_arena_for_temps = options->config.graph_options()
+                                        .optimizer_options()
+                                        .use_step_arena_for_temps();
+  params.use_static_memory_plan = options->config.graph_options()
+                                      .optimizer_options()
+                                      .use_static_memory_plan();
 
   if (init) {
     Executor* init_exec;
@@ -16,12 +16,17 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/common_runtime/local_device.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -31,17 +36,32 @@ namespace tensorflow {
 bool LocalDevice::use_global_threadpool_ = true;
 
 struct LocalDevice::EigenThreadPoolInfo {
-  EigenThreadPoolInfo(const SessionOptions& options) {
+  // If numa_node is not port::kNUMANoAffinity, the threads are bound to the
+  // CPUs of that node, and the intra-op threads are split evenly over the
+  // nodes.
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
-    if (intra_op_parallelism_threads == 0) {
-      intra_op_parallelism_threads = port::NumSchedulableCPUs();
+    ThreadOptions thread_options;
+    if (numa_node == port::kNUMANoAffinity) {
+      if (intra_op_parallelism_threads == 0) {
+        intra_op_parallelism_threads = port::NumSchedulableCPUs();
+      }
+    } else {
+      thread_options.numa_node = numa_node;
+      if (intra_op_parallelism_threads == 0) {
+        intra_op_parallelism_threads = port::NUMANumNodeCPUs(numa_node);
+      } else {
+        intra_op_parallelism_threads =
+            std::max(1, intra_op_parallelism_threads / port::NUMANumNodes());
+      }
     }
     VLOG(1) << "Local device intra op parallelism threads: "
-            << intra_op_parallelism_threads;
+            << intra_op_parallelism_threads << " numa: " << numa_node;
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
-    eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+    eigen_worker_threads_.workers =
+        new thread::ThreadPool(options.env, thread_options, "Eigen",
+                               intra_op_parallelism_threads);
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -67,17 +87,37 @@ LocalDevice::LocalDevice(const SessionOptions& options,
   // If we're running on the CPU, log warnings if we're not compiled using the
   // best flags for performance.
   port::WarnAboutUnusedCPUFeatures();
+  // NUMA locales are indexed from 0, buses are indexed from 1.
+  int numa_node = port::kNUMANoAffinity;
+  if (options.config.use_numa_affinity() && port::NUMANumNodes() > 1 &&
+      attributes.locality().bus_id() > 0 &&
+      attributes.locality().bus_id() <= port::NUMANumNodes()) {
+    numa_node = attributes.locality().bus_id() - 1;
+  }
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  if (use_global_threadpool_ && numa_node == port::kNUMANoAffinity) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node);
     tp_info = global_tp_info;
+  } else if (use_global_threadpool_) {
+    // The devices on a NUMA node share one threadpool bound to the node.
+    static mutex* mu = new mutex;
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_infos =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>(
+            port::NUMANumNodes());
+    mutex_lock l(*mu);
+    tp_info = (*numa_tp_infos)[numa_node];
+    if (tp_info == nullptr) {
+      tp_info = new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+      (*numa_tp_infos)[numa_node] = tp_info;
+    }
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
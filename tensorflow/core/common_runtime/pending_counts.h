@@ -91,6 +91,14 @@ class PendingCounts {
 
   ~PendingCounts() { delete[] bytes_; }
 
+  // Overwrites all counts with those of "other", which must have been
+  // created from the same Layout.  Lets a reused PendingCounts be reset
+  // to its initial snapshot with a single memcpy.
+  void ResetFrom(const PendingCounts& other) {
+    CHECK_EQ(num_bytes_, other.num_bytes_);
+    memcpy(bytes_, other.bytes_, num_bytes_);
+  }
+
   void set_initial_count(Handle h, size_t pending_count) {
     if (h.is_large_) {
       LargeCounts* c = Large(h);
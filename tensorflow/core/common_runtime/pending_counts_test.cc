@@ -75,6 +75,29 @@ TEST(PendingCounts, CopyConstructor) {
   }
 }
 
+TEST(PendingCounts, ResetFrom) {
+  const int C = 300;
+  PendingCounts::Layout layout;
+  std::vector<PendingCounts::Handle> h(C);
+  for (int id = 0; id < C; id++) {
+    h[id] = layout.CreateHandle(id, id);
+  }
+  PendingCounts initial(layout);
+  for (int id = 0; id < C; id++) {
+    initial.set_initial_count(h[id], id);
+  }
+  PendingCounts c(initial);
+  for (int id = 1; id < C; id++) {
+    c.increment_dead_count(h[id]);
+    c.decrement_pending(h[id], 1);
+  }
+  c.ResetFrom(initial);
+  for (int id = 0; id < C; id++) {
+    EXPECT_EQ(initial.pending(h[id]), c.pending(h[id]));
+    EXPECT_EQ(0, c.dead_count(h[id]));
+  }
+}
+
 TEST(PendingCounts, MarkLiveShowsUpAsCount) {
   PendingCounts::Layout layout;
   PendingCounts::Handle handles[2];
@@ -0,0 +1,130 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/quota_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+auto* quota_rejections = monitoring::Counter<1>::New(
+    "/tensorflow/core/quota_allocator/rejections",
+    "The number of allocations that did not fit in the quota of their "
+    "client.",
+    "label");
+
+// How long an allocation that exceeds the quota waits for the client to
+// deallocate memory, as the BFCAllocator does when it runs out.
+const int64 kMaxMillisToWait = 10000;
+
+}  // namespace
+
+QuotaAllocator::QuotaAllocator(Allocator* allocator, int64 quota_bytes,
+                               const string& label)
+    : allocator_(allocator), quota_bytes_(quota_bytes), label_(label) {
+  CHECK(allocator_->TracksAllocationSizes())
+      << "QuotaAllocator needs " << allocator_->Name()
+      << " to track allocation sizes";
+  stats_.bytes_limit = quota_bytes_;
+}
+
+void* QuotaAllocator::AllocateRaw(size_t alignment, size_t num_bytes,
+                                  const AllocationAttributes& allocation_attr) {
+  const int64 bytes = num_bytes;
+  {
+    mutex_lock l(mu_);
+    DCHECK(!orphaned_);
+    if (stats_.bytes_in_use + bytes > quota_bytes_ &&
+        !allocation_attr.no_retry_on_failure) {
+      const uint64 deadline_micros =
+          Env::Default()->NowMicros() + kMaxMillisToWait * 1000;
+      while (stats_.bytes_in_use + bytes > quota_bytes_) {
+        const uint64 now_micros = Env::Default()->NowMicros();
+        if (now_micros >= deadline_micros) break;
+        WaitForMilliseconds(&l, &memory_returned_,
+                            (deadline_micros - now_micros + 999) / 1000);
+      }
+    }
+    if (stats_.bytes_in_use + bytes > quota_bytes_) {
+      if (!allocation_attr.no_retry_on_failure) {
+        LOG(WARNING) << label_ << " ran out of its quota of "
+                     << strings::HumanReadableNumBytes(quota_bytes_)
+                     << " of " << allocator_->Name() << ", with "
+                     << strings::HumanReadableNumBytes(stats_.bytes_in_use)
+                     << " in use, when trying to allocate "
+                     << strings::HumanReadableNumBytes(bytes);
+      }
+      quota_rejections->GetCell(label_)->IncrementBy(1);
+      return nullptr;
+    }
+    // Charge the quota before allocating, so that concurrent allocations
+    // cannot exceed it together.
+    stats_.bytes_in_use += bytes;
+    ++num_live_;
+  }
+  void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  mutex_lock l(mu_);
+  if (ptr == nullptr) {
+    stats_.bytes_in_use -= bytes;
+    --num_live_;
+    memory_returned_.notify_all();
+    return nullptr;
+  }
+  ++stats_.num_allocs;
+  stats_.max_bytes_in_use =
+      std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+  stats_.max_alloc_size = std::max(stats_.max_alloc_size, bytes);
+  return ptr;
+}
+
+void QuotaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  const int64 bytes = allocator_->RequestedSize(ptr);
+  allocator_->DeallocateRaw(ptr);
+  bool delete_this = false;
+  {
+    mutex_lock l(mu_);
+    DCHECK_GT(num_live_, 0);
+    stats_.bytes_in_use -= bytes;
+    memory_returned_.notify_all();
+    delete_this = --num_live_ == 0 && orphaned_;
+  }
+  if (delete_this) delete this;
+}
+
+void QuotaAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock l(mu_);
+  *stats = stats_;
+}
+
+void QuotaAllocator::Release() {
+  {
+    mutex_lock l(mu_);
+    if (num_live_ > 0) {
+      orphaned_ = true;
+      return;
+    }
+  }
+  delete this;
+}
+
+}  // namespace tensorflow
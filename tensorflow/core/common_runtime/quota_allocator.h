@@ -0,0 +1,89 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_QUOTA_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_QUOTA_ALLOCATOR_H_
+
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// QuotaAllocator limits the memory that one client of an allocator shared
+// with others, e.g. the GPU devices of one session, may hold at once, and
+// accounts for it: GetStats() reports the allocations made through this
+// wrapper only, with bytes_limit the quota.
+//
+// An allocation that would exceed the quota waits for the client to
+// deallocate memory, like the BFCAllocator does when it runs out, and
+// fails if it still does not fit after a while.  The failures are
+// counted, by label, in /tensorflow/core/quota_allocator/rejections.
+//
+// The wrapped allocator must track allocation sizes, and outlive this one.
+// This class is thread-safe.
+class QuotaAllocator : public Allocator {
+ public:
+  QuotaAllocator(Allocator* allocator, int64 quota_bytes, const string& label);
+
+  string Name() override { return allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  bool TracksAllocationSizes() override { return true; }
+  size_t RequestedSize(void* ptr) override {
+    return allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(void* ptr) override {
+    return allocator_->AllocatedSize(ptr);
+  }
+  int64 AllocationId(void* ptr) override {
+    return allocator_->AllocationId(ptr);
+  }
+  void GetStats(AllocatorStats* stats) override;
+
+  // Gives up the caller's ownership: deletes the allocator now if no
+  // allocation is live, and otherwise as soon as the last one is
+  // deallocated.
+  void Release();
+
+ private:
+  ~QuotaAllocator() override {}
+
+  Allocator* const allocator_;  // not owned
+  const int64 quota_bytes_;
+  const string label_;
+
+  mutex mu_;
+  condition_variable memory_returned_;
+  AllocatorStats stats_ GUARDED_BY(mu_);
+  // Number of allocations handed out and not yet deallocated.
+  int64 num_live_ GUARDED_BY(mu_) = 0;
+  // Set once the owner gave up the allocator while allocations were live.
+  bool orphaned_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(QuotaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_QUOTA_ALLOCATOR_H_
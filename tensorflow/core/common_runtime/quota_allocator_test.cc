@@ -0,0 +1,105 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/quota_allocator.h"
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+class QuotaAllocatorTest : public ::testing::Test {
+ protected:
+  QuotaAllocatorTest()
+      : shared_(new HostSubAllocator, 1 << 24, false, "shared") {}
+
+  BFCAllocator shared_;
+};
+
+TEST_F(QuotaAllocatorTest, RejectsAllocationsOverQuota) {
+  QuotaAllocator* a = new QuotaAllocator(&shared_, 1 << 20, "session_a");
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 600 << 10);
+  ASSERT_NE(nullptr, p1);
+  EXPECT_EQ(nullptr, a->AllocateRaw(Allocator::kAllocatorAlignment,
+                                    600 << 10, no_retry));
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 400 << 10);
+  ASSERT_NE(nullptr, p2);
+
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(2, stats.num_allocs);
+  EXPECT_EQ(1000 << 10, stats.bytes_in_use);
+  EXPECT_EQ(1 << 20, stats.bytes_limit);
+
+  // Other clients of the shared allocator are not charged.
+  void* other = shared_.AllocateRaw(Allocator::kAllocatorAlignment, 4 << 20);
+  ASSERT_NE(nullptr, other);
+  a->GetStats(&stats);
+  EXPECT_EQ(1000 << 10, stats.bytes_in_use);
+  shared_.DeallocateRaw(other);
+
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(p2);
+  a->GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(1000 << 10, stats.max_bytes_in_use);
+  a->Release();
+}
+
+TEST_F(QuotaAllocatorTest, WaitsForDeallocations) {
+  QuotaAllocator* a = new QuotaAllocator(&shared_, 1 << 20, "session_a");
+  void* p1 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(nullptr, p1);
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "deallocate", [a, p1]() {
+        Env::Default()->SleepForMicroseconds(100000);
+        a->DeallocateRaw(p1);
+      }));
+  void* p2 = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  EXPECT_NE(nullptr, p2);
+  thread.reset();
+  a->DeallocateRaw(p2);
+  a->Release();
+}
+
+TEST_F(QuotaAllocatorTest, OutlivesReleaseUntilLastDeallocation) {
+  QuotaAllocator* a = new QuotaAllocator(&shared_, 1 << 20, "session_a");
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 10);
+  ASSERT_NE(nullptr, p);
+  a->Release();
+  // Deletes the allocator.
+  a->DeallocateRaw(p);
+  AllocatorStats stats;
+  shared_.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+}  // namespace
+}  // namespace tensorflow
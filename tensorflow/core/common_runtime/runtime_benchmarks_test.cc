@@ -0,0 +1,244 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Microbenchmarks of the paths of the core runtime that every step goes
+// through: executor dispatch, rendezvous, the BFC allocator, tensor
+// creation, queues, record reading and Example parsing.
+//
+// Run with --benchmarks=all, or through
+// //tensorflow/tools/test:core_runtime_benchmark to get the results as
+// BenchmarkEntries that //tensorflow/tools/test:compare_benchmarks can
+// compare between builds.
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+namespace tensorflow {
+namespace {
+
+// Single threaded, so that the benchmarks measure the per-op overhead of
+// the runtime rather than the parallelism of the host.
+SessionOptions* GetOptions() {
+  static SessionOptions* opts = [] {
+    SessionOptions* opts = new SessionOptions;
+    opts->config.set_intra_op_parallelism_threads(1);
+    opts->config.set_inter_op_parallelism_threads(1);
+    return opts;
+  }();
+  return opts;
+}
+
+// A chain of 'num_nodes' Identity nodes: the executor dispatches one op per
+// node, each doing almost no work.
+void BM_ExecutorDispatch(int iters, int num_nodes) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1.0;
+  Node* cur = test::graph::Constant(g, value);
+  for (int i = 0; i < num_nodes; ++i) {
+    cur = test::graph::Identity(g, cur);
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+  test::Benchmark("cpu", g, GetOptions()).Run(iters);
+}
+BENCHMARK(BM_ExecutorDispatch)->Arg(16)->Arg(256);
+
+void BM_RendezvousSendRecv(int iters) {
+  testing::StopTiming();
+  Rendezvous* rendez = NewLocalRendezvous();
+  Rendezvous::ParsedKey key;
+  TF_CHECK_OK(Rendezvous::ParseKey(
+      Rendezvous::CreateKey("/job:a/replica:0/task:0/cpu:0", 1,
+                            "/job:a/replica:0/task:0/cpu:0", "t",
+                            FrameAndIter(0, 0)),
+      &key));
+  Tensor sent(DT_FLOAT, TensorShape({}));
+  sent.scalar<float>()() = 1.0;
+  Tensor received;
+  bool is_dead = false;
+  Rendezvous::Args args;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(rendez->Send(key, args, sent, is_dead));
+    TF_CHECK_OK(rendez->Recv(key, args, &received, &is_dead));
+  }
+  testing::StopTiming();
+  rendez->Unref();
+}
+BENCHMARK(BM_RendezvousSendRecv);
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+// Allocates and frees a batch of 'num_bytes' buffers per iteration, with
+// or without the thread caches of the allocator.
+void BM_BFCAllocator(int iters, int num_bytes, int use_thread_cache) {
+  testing::StopTiming();
+  const int kBatch = 16;
+  BFCAllocator a(new HostSubAllocator, 1 << 30, false, "bench",
+                 use_thread_cache != 0);
+  std::vector<void*> ptrs(kBatch);
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatch);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < kBatch; ++j) {
+      ptrs[j] = a.AllocateRaw(Allocator::kAllocatorAlignment, num_bytes);
+    }
+    for (int j = 0; j < kBatch; ++j) {
+      a.DeallocateRaw(ptrs[j]);
+    }
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_BFCAllocator)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(16 << 10, 0)
+    ->ArgPair(16 << 10, 1)
+    ->ArgPair(4 << 20, 0);
+
+void BM_TensorCreate(int iters, int num_elements) {
+  const TensorShape shape({num_elements});
+  for (int i = 0; i < iters; ++i) {
+    Tensor t(DT_FLOAT, shape);
+  }
+}
+BENCHMARK(BM_TensorCreate)->Arg(1)->Arg(1 << 10)->Arg(1 << 20);
+
+// Each step enqueues a tensor into a FIFO queue and then dequeues it.
+void BM_QueueEnqueueDequeue(int iters, int lock_free) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1.0;
+  Node* component = test::graph::Constant(g, value);
+  Node* queue;
+  TF_CHECK_OK(NodeBuilder(g->NewName("queue"), "FIFOQueueV2")
+                  .Attr("component_types", {DT_FLOAT})
+                  .Attr("capacity", 16)
+                  .Attr("lock_free", lock_free != 0)
+                  .Finalize(g, &queue));
+  Node* enqueue;
+  TF_CHECK_OK(NodeBuilder(g->NewName("enqueue"), "QueueEnqueueV2")
+                  .Input(queue)
+                  .Input({NodeBuilder::NodeOut(component)})
+                  .Finalize(g, &enqueue));
+  Node* dequeue;
+  TF_CHECK_OK(NodeBuilder(g->NewName("dequeue"), "QueueDequeueV2")
+                  .Input(queue)
+                  .Attr("component_types", {DT_FLOAT})
+                  .ControlInput(enqueue)
+                  .Finalize(g, &dequeue));
+  testing::ItemsProcessed(iters);
+  test::Benchmark("cpu", g, GetOptions()).Run(iters);
+}
+BENCHMARK(BM_QueueEnqueueDequeue)->Arg(0)->Arg(1);
+
+// Reads a file of 'record_bytes' records, starting over at its end.
+void BM_RecordReader(int iters, int record_bytes) {
+  testing::StopTiming();
+  const int kNumRecords = 1024;
+  Env* env = Env::Default();
+  const string fname = io::JoinPath(
+      testing::TmpDir(), strings::StrCat("bm_record_reader_", record_bytes));
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    const string record(record_bytes, 'x');
+    for (int i = 0; i < kNumRecords; ++i) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(file->Close());
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  testing::BytesProcessed(static_cast<int64>(iters) * record_bytes);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (i % kNumRecords == 0) {
+      offset = 0;
+    }
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(env->DeleteFile(fname));
+}
+BENCHMARK(BM_RecordReader)->Arg(100)->Arg(16 << 10);
+
+// Parses a batch of Examples, each holding one dense float feature of
+// 'num_floats' values.
+void BM_ParseExample(int iters, int num_floats) {
+  testing::StopTiming();
+  const int kBatchSize = 128;
+  Example example;
+  auto* floats = (*example.mutable_features()->mutable_feature())["floats"]
+                     .mutable_float_list();
+  for (int i = 0; i < num_floats; ++i) {
+    floats->add_value(i);
+  }
+  const std::vector<string> serialized(kBatchSize,
+                                       example.SerializeAsString());
+
+  example::FastParseExampleConfig config;
+  example::FastParseExampleConfig::Dense dense;
+  dense.feature_name = "floats";
+  dense.dtype = DT_FLOAT;
+  dense.shape = PartialTensorShape({num_floats});
+  dense.default_value = Tensor(DT_FLOAT, TensorShape({0}));
+  dense.variable_length = false;
+  dense.elements_per_stride = num_floats;
+  config.dense.push_back(dense);
+
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    example::Result result;
+    TF_CHECK_OK(
+        example::FastParseExample(config, serialized, {}, nullptr, &result));
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_ParseExample)->Arg(1)->Arg(1 << 10);
+
+}  // namespace
+}  // namespace tensorflow
@@ -51,6 +51,25 @@ Status Session::PRun(const string& handle,
       "Partial run is not supported for this session.");
 }
 
+Status Session::MakeCallable(const CallableOptions& callable_options,
+                             CallableHandle* out_handle) {
+  return errors::Unimplemented(
+      "MakeCallable is not supported for this session.");
+}
+
+Status Session::RunCallable(CallableHandle handle,
+                            const std::vector<Tensor>& feed_tensors,
+                            std::vector<Tensor>* fetch_tensors,
+                            RunMetadata* run_metadata) {
+  return errors::Unimplemented(
+      "RunCallable is not supported for this session.");
+}
+
+Status Session::ReleaseCallable(CallableHandle handle) {
+  return errors::Unimplemented(
+      "ReleaseCallable is not supported for this session.");
+}
+
 Session* NewSession(const SessionOptions& options) {
   SessionFactory* factory;
   Status s = SessionFactory::GetFactory(options, &factory);
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_set>
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -31,6 +33,18 @@ using shape_inference::DimensionHandle;
 using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
+namespace {
+
+// Returns true if 'shape' is described by its DebugString(), i.e. if it has no
+// unknown dimension whose identity matters.
+bool IsShapeKnownOrUnranked(InferenceContext* c, ShapeHandle shape) {
+  return !c->RankKnown(shape) || c->FullyDefined(shape);
+}
+
+}  // namespace
+
+constexpr int64 ShapeRefiner::kMaxShapeCacheKeySize;
+
 ShapeRefiner::ShapeRefiner(int graph_def_version,
                            const OpRegistryInterface* ops)
     : graph_def_version_(graph_def_version),
@@ -100,8 +114,39 @@ Status ShapeRefiner::AddNode(const Node* node) {
     return c->construction_status();
   }
 
-  // Run the shape inference function, and return if there was an error.
-  TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, c.get()));
+  string cache_key;
+  const bool cacheable = GetShapeCacheKey(node, c.get(), &cache_key);
+  auto cached = cacheable ? shape_cache_.find(cache_key) : shape_cache_.end();
+  if (cached != shape_cache_.end()) {
+    // Reuse the shapes inferred for an identical node.
+    for (int i = 0; i < c->num_outputs(); ++i) {
+      c->set_output(i, cached->second.outputs[i]);
+      c->set_output_handle_dtype(i, cached->second.output_handle_dtypes[i]);
+      c->set_output_handle_shape(i, cached->second.output_handle_shapes[i]);
+    }
+  } else {
+    // Run the shape inference function, and return if there was an error.
+    TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, c.get()));
+
+    // The shapes can be reused if the shape function didn't look at the
+    // values of the inputs.
+    bool reusable = cacheable;
+    for (int i = 0; reusable && i < c->num_inputs(); ++i) {
+      reusable = !c->requested_input_tensor(i) &&
+                 !c->requested_input_tensor_as_partial_shape(i);
+    }
+    CachedShapes shapes;
+    for (int i = 0; reusable && i < c->num_outputs(); ++i) {
+      reusable = IsShapeKnownOrUnranked(c.get(), c->output(i)) &&
+                 IsShapeKnownOrUnranked(c.get(), c->output_handle_shape(i));
+      shapes.outputs.push_back(c->output(i));
+      shapes.output_handle_dtypes.push_back(c->output_handle_dtype(i));
+      shapes.output_handle_shapes.push_back(c->output_handle_shape(i));
+    }
+    if (reusable) {
+      shape_cache_[cache_key] = std::move(shapes);
+    }
+  }
 
   // Store the resulting InferenceContext object in the map.
   node_to_context_[node].swap(c);
@@ -109,6 +154,37 @@ Status ShapeRefiner::AddNode(const Node* node) {
   return Status::OK();
 }
 
+bool ShapeRefiner::GetShapeCacheKey(const Node* node, InferenceContext* c,
+                                    string* key) const {
+  // The nodes without inputs are cheap to infer, and often have large
+  // attributes, e.g. the value of constants.
+  if (c->num_inputs() == 0) return false;
+  strings::StrAppend(key, node->type_string(), ";", graph_def_version_, ";");
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    if (!IsShapeKnownOrUnranked(c, c->input(i))) return false;
+    strings::StrAppend(key, c->DebugString(c->input(i)), ";");
+    if (node->input_type(i) == DT_RESOURCE) {
+      ShapeHandle handle_shape = c->input_handle_shape(i);
+      if (!IsShapeKnownOrUnranked(c, handle_shape)) return false;
+      strings::StrAppend(key, c->input_handle_dtype(i), ":",
+                         c->DebugString(handle_shape), ";");
+    }
+  }
+  // Serialize the attributes in a deterministic order.
+  std::vector<StringPiece> attr_names;
+  for (const auto& attr : node->def().attr()) {
+    attr_names.push_back(attr.first);
+  }
+  std::sort(attr_names.begin(), attr_names.end());
+  string value;
+  for (StringPiece name : attr_names) {
+    node->def().attr().at(name.ToString()).SerializeToString(&value);
+    strings::StrAppend(key, name, "=", value.size(), ":", value);
+    if (key->size() > kMaxShapeCacheKeySize) return false;
+  }
+  return true;
+}
+
 Status ShapeRefiner::SetShape(const Node* node, int output_port,
                               ShapeHandle shape) {
   auto c = GetContext(node);
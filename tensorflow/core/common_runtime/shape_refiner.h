@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/graph_runner.h"
@@ -116,6 +117,12 @@ class ShapeRefiner {
   Status RunShapeFn(const Node* node, const OpRegistrationData* op_reg_data,
                     shape_inference::InferenceContext* c);
 
+  // Sets '*key' to the key of the shapes inferred for 'node' in the
+  // shape_cache_, and returns true, if they only depend on its op, its
+  // attributes and the input shapes in 'c'.
+  bool GetShapeCacheKey(const Node* node, shape_inference::InferenceContext* c,
+                        string* key) const;
+
   int32 graph_def_version_;
   const OpRegistryInterface* const ops_registry_;
 
@@ -141,6 +148,21 @@ class ShapeRefiner {
   static constexpr int64 kMaxTensorSize = 1024;
   std::unordered_map<string, Tensor> const_tensor_map_;
 
+  // The output shapes inferred for a node, which are reused for the nodes
+  // with the same op and attributes and the same fully defined input shapes,
+  // e.g. the steps of an unrolled RNN. The shapes are owned by the
+  // InferenceContext of the node they were inferred for.
+  //
+  // Only the shapes that are fully defined, or whose rank is unknown, are
+  // stored: the unknown dimensions of different nodes must stay distinct.
+  struct CachedShapes {
+    std::vector<shape_inference::ShapeHandle> outputs;
+    std::vector<DataType> output_handle_dtypes;
+    std::vector<shape_inference::ShapeHandle> output_handle_shapes;
+  };
+  static constexpr int64 kMaxShapeCacheKeySize = 1024;
+  std::unordered_map<string, CachedShapes> shape_cache_;
+
   bool require_shape_inference_fns_ = true;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ShapeRefiner);
@@ -62,6 +62,45 @@ TEST(ShapeRefinerTest, MatMul) {
   EXPECT_SHAPE("[2,2]", m, mm, 0);
 }
 
+TEST(ShapeRefinerTest, ReuseShapesOfIdenticalNodes) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Const(root, {{1.0f}, {2.0f}});
+  auto b = ops::Const(root, {{1.0f, 2.0f}});
+  auto mm1 = ops::MatMul(root, a, b);
+  auto mm2 = ops::MatMul(root, a, b);
+  // The same op and input shapes, but different attributes.
+  auto mm3 = ops::MatMul(root, a, b,
+                         ops::MatMul::TransposeA(true).TransposeB(true));
+
+  TF_ASSERT_OK(m.AddNode(a.node()));
+  TF_ASSERT_OK(m.AddNode(b.node()));
+  TF_ASSERT_OK(m.AddNode(mm1.node()));
+  TF_ASSERT_OK(m.AddNode(mm2.node()));
+  TF_ASSERT_OK(m.AddNode(mm3.node()));
+
+  EXPECT_SHAPE("[2,2]", m, mm1, 0);
+  EXPECT_SHAPE("[2,2]", m, mm2, 0);
+  EXPECT_SHAPE("[1,1]", m, mm3, 0);
+}
+
+TEST(ShapeRefinerTest, ReuseShapesWithUnknownDims) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Const(root, {{true}, {false}});
+  auto w1 = ops::Where(root, a);
+  auto w2 = ops::Where(root, a);
+
+  TF_ASSERT_OK(m.AddNode(a.node()));
+  TF_ASSERT_OK(m.AddNode(w1.node()));
+  TF_ASSERT_OK(m.AddNode(w2.node()));
+
+  EXPECT_SHAPE("[?,2]", m, w1, 0);
+  EXPECT_SHAPE("[?,2]", m, w2, 0);
+}
+
 TEST(ShapeRefinerTest, InvalidOrder) {
   ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
   Scope root = Scope::NewRootScope();
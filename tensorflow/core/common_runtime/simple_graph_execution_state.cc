@@ -288,7 +288,8 @@ Status SimpleGraphExecutionState::InitBaseGraph(
     TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
         new_graph.get(), options.feed_endpoints, options.fetch_endpoints,
         options.target_nodes, device_set_->client_device()->attributes(),
-        options.use_function_convention, rewrite_metadata_.get()));
+        options.use_function_convention, options.feed_devices,
+        options.fetch_devices, rewrite_metadata_.get()));
   }
 
   // Save stateful placements before placing.
@@ -343,7 +344,8 @@ Status SimpleGraphExecutionState::BuildGraph(
     TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
         ng.get(), options.feed_endpoints, options.fetch_endpoints,
         options.target_nodes, device_set_->client_device()->attributes(),
-        options.use_function_convention, &rewrite_metadata));
+        options.use_function_convention, options.feed_devices,
+        options.fetch_devices, &rewrite_metadata));
   } else {
     // This SimpleGraphExecutionState represents a graph that was
     // pruned when this was constructed, so we copy the metadata from
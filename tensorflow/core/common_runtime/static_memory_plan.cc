@@ -0,0 +1,356 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The liveness analysis keeps one bit per pair of nodes.
+const int kMaxPlannedNodes = 8192;
+
+// Set of node ids, as a bitmap.
+class NodeSet {
+ public:
+  explicit NodeSet(int num_nodes) : words_((num_nodes + 63) / 64, 0) {}
+
+  void Insert(int id) { words_[id / 64] |= uint64{1} << (id % 64); }
+  bool Contains(int id) const {
+    return (words_[id / 64] >> (id % 64)) & uint64{1};
+  }
+  void InsertAll(const NodeSet& other) {
+    for (size_t i = 0; i < words_.size(); ++i) words_[i] |= other.words_[i];
+  }
+
+ private:
+  std::vector<uint64> words_;
+};
+
+int64 AlignUp(int64 bytes) {
+  const int64 a = Allocator::kAllocatorAlignment;
+  return (bytes + a - 1) / a * a;
+}
+
+}  // namespace
+
+Status PlanStaticMemory(const Graph& graph,
+                        const std::vector<PlannedBuffer>& buffers,
+                        StaticMemoryPlan* plan) {
+  const int num_nodes = graph.num_node_ids();
+  if (num_nodes > kMaxPlannedNodes) {
+    return errors::InvalidArgument("Graph has ", num_nodes,
+                                   " nodes; static memory planning supports "
+                                   "at most ",
+                                   kMaxPlannedNodes);
+  }
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<int> position(num_nodes, -1);
+  for (size_t i = 0; i < order.size(); ++i) {
+    position[order[i]->id()] = i;
+  }
+
+  // ancestors[n] holds every node that finishes before n starts.
+  std::vector<NodeSet> ancestors(num_nodes, NodeSet(num_nodes));
+  for (const Node* n : order) {
+    NodeSet& a = ancestors[n->id()];
+    for (const Edge* e : n->in_edges()) {
+      const int src = e->src()->id();
+      if (position[src] >= position[n->id()]) {
+        return errors::InvalidArgument(
+            "Static memory planning requires an acyclic graph, but ",
+            n->name(), " is on a cycle");
+      }
+      a.InsertAll(ancestors[src]);
+      a.Insert(src);
+    }
+  }
+
+  // The nodes that must finish before each buffer is dead.
+  std::vector<std::vector<int>> last_users(buffers.size());
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    const Node* n = graph.FindNodeId(buffers[b].node_id);
+    CHECK(n != nullptr) << "No node with id " << buffers[b].node_id;
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() && e->src_output() == buffers[b].output) {
+        last_users[b].push_back(e->dst()->id());
+      }
+    }
+    if (last_users[b].empty()) {
+      last_users[b].push_back(n->id());
+    }
+  }
+
+  // The nodes that write into each buffer, and the position of the first
+  // of them, from which on the buffer is live.
+  std::vector<std::vector<int>> writers(buffers.size());
+  std::vector<int> first_position(buffers.size());
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    writers[b] = buffers[b].writer_node_ids;
+    writers[b].push_back(buffers[b].node_id);
+    first_position[b] = position[buffers[b].node_id];
+    for (int w : buffers[b].writer_node_ids) {
+      CHECK(graph.FindNodeId(w) != nullptr) << "No node with id " << w;
+      first_position[b] = std::min(first_position[b], position[w]);
+    }
+  }
+
+  std::vector<int> by_position(buffers.size());
+  for (size_t b = 0; b < buffers.size(); ++b) by_position[b] = b;
+  std::stable_sort(by_position.begin(), by_position.end(),
+                   [&first_position](int x, int y) {
+                     return first_position[x] < first_position[y];
+                   });
+
+  // Buffers are visited in topological order, so a buffer that may take
+  // over a slot from the slot's last occupant may also take it over from
+  // every earlier one.
+  plan->slot_sizes.clear();
+  plan->buffer_slots.assign(buffers.size(), -1);
+  std::vector<int> last_occupant;
+  for (int b : by_position) {
+    int best = -1;
+    for (size_t s = 0; s < last_occupant.size(); ++s) {
+      bool dead = true;
+      for (int user : last_users[last_occupant[s]]) {
+        for (int w : writers[b]) {
+          if (!ancestors[w].Contains(user)) {
+            dead = false;
+            break;
+          }
+        }
+        if (!dead) break;
+      }
+      if (!dead) continue;
+      // Prefer the smallest slot that fits, or else the largest one,
+      // which then grows the least.
+      if (best < 0) {
+        best = s;
+        continue;
+      }
+      const int64 size = plan->slot_sizes[s];
+      const int64 best_size = plan->slot_sizes[best];
+      const int64 bytes = buffers[b].bytes;
+      if (best_size < bytes ? size > best_size
+                            : size >= bytes && size < best_size) {
+        best = s;
+      }
+    }
+    if (best < 0) {
+      best = last_occupant.size();
+      last_occupant.push_back(b);
+      plan->slot_sizes.push_back(0);
+    }
+    last_occupant[best] = b;
+    plan->slot_sizes[best] =
+        std::max(plan->slot_sizes[best], AlignUp(buffers[b].bytes));
+    plan->buffer_slots[b] = best;
+  }
+
+  plan->slot_offsets.resize(plan->slot_sizes.size());
+  plan->slab_bytes = 0;
+  for (size_t s = 0; s < plan->slot_sizes.size(); ++s) {
+    plan->slot_offsets[s] = plan->slab_bytes;
+    plan->slab_bytes += plan->slot_sizes[s];
+  }
+  return Status::OK();
+}
+
+// The memory of a slot and the state that its allocators share.
+struct StaticMemorySlab::Slot {
+  Slot(StaticMemorySlab* slab, char* ptr, int64 size);
+
+  char* const ptr;
+  const int64 size;
+  std::unique_ptr<SlotAllocator> allocator;
+  std::unique_ptr<SlotAllocator> owner_allocator;
+
+  mutex mu;
+  // True while a buffer, parts excepted, holds the slot's memory.
+  bool in_use GUARDED_BY(mu) = false;
+  // Number of parts of the slot that are in use.
+  int live_parts GUARDED_BY(mu) = 0;
+};
+
+class StaticMemorySlab::SlotAllocator : public Allocator {
+ public:
+  enum Kind { kSlot, kOwner, kPart };
+
+  SlotAllocator(StaticMemorySlab* slab, Slot* slot, Kind kind, int64 offset,
+                int64 size)
+      : slab_(slab),
+        slot_(slot),
+        kind_(kind),
+        ptr_(slot->ptr == nullptr ? nullptr : slot->ptr + offset),
+        size_(ptr_ == nullptr ? 0 : size) {}
+
+  string Name() override { return "static_slab"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    const int64 bytes = num_bytes;
+    int64 requested = requested_.load(std::memory_order_relaxed);
+    while (requested < bytes &&
+           !requested_.compare_exchange_weak(requested, bytes)) {
+    }
+    // A part only matches a request of its own size, so that the data
+    // ends up exactly where the owner expects it.
+    const bool fits = kind_ == kPart ? bytes == size_ : bytes <= size_;
+    void* ptr = nullptr;
+    if (bytes > 0 && fits && alignment <= Allocator::kAllocatorAlignment &&
+        Acquire()) {
+      ptr = ptr_;
+    } else {
+      ptr = slab_->base_->AllocateRaw(alignment, num_bytes, allocation_attr);
+    }
+    // Buffers from the base allocator are also returned through this
+    // allocator, so they keep the slab alive as well.
+    if (ptr != nullptr) slab_->Ref();
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == nullptr) return;
+    if (ptr == ptr_) {
+      Release();
+    } else {
+      slab_->base_->DeallocateRaw(ptr);
+    }
+    slab_->Unref();
+  }
+
+  int64 requested() const { return requested_.load(); }
+
+ private:
+  // Claims the memory of this allocator, if it is free.
+  bool Acquire() {
+    mutex_lock l(slot_->mu);
+    switch (kind_) {
+      case kSlot:
+        if (slot_->in_use || slot_->live_parts > 0) return false;
+        slot_->in_use = true;
+        return true;
+      case kOwner:
+        if (slot_->in_use) return false;
+        slot_->in_use = true;
+        return true;
+      case kPart:
+        if (slot_->in_use || part_in_use_) return false;
+        part_in_use_ = true;
+        ++slot_->live_parts;
+        return true;
+    }
+    return false;
+  }
+
+  void Release() {
+    mutex_lock l(slot_->mu);
+    if (kind_ == kPart) {
+      part_in_use_ = false;
+      --slot_->live_parts;
+    } else {
+      slot_->in_use = false;
+    }
+  }
+
+  StaticMemorySlab* const slab_;
+  Slot* const slot_;
+  const Kind kind_;
+  char* const ptr_;
+  const int64 size_;
+  bool part_in_use_ = false;  // Guarded by slot_->mu.
+  std::atomic<int64> requested_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SlotAllocator);
+};
+
+StaticMemorySlab::Slot::Slot(StaticMemorySlab* slab, char* ptr, int64 size)
+    : ptr(ptr), size(size) {
+  allocator.reset(new SlotAllocator(slab, this, SlotAllocator::kSlot, 0, size));
+  owner_allocator.reset(
+      new SlotAllocator(slab, this, SlotAllocator::kOwner, 0, size));
+}
+
+StaticMemorySlab::StaticMemorySlab(const StaticMemoryPlan& plan,
+                                   Allocator* base)
+    : base_(base) {
+  if (plan.slab_bytes > 0) {
+    memory_ = base_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                 plan.slab_bytes);
+    if (memory_ == nullptr) {
+      LOG(WARNING) << "Could not allocate a static memory slab of "
+                   << plan.slab_bytes << " bytes; using dynamic allocation";
+    }
+  }
+  slots_.reserve(plan.slot_sizes.size());
+  for (size_t s = 0; s < plan.slot_sizes.size(); ++s) {
+    char* ptr = nullptr;
+    if (memory_ != nullptr && plan.slot_sizes[s] > 0) {
+      ptr = static_cast<char*>(memory_) + plan.slot_offsets[s];
+    }
+    slots_.emplace_back(new Slot(this, ptr, plan.slot_sizes[s]));
+  }
+  parts_.reserve(plan.slot_parts.size());
+  for (const SlotPart& part : plan.slot_parts) {
+    CHECK(part.offset >= 0 && part.bytes >= 0 &&
+          part.offset + part.bytes <= plan.slot_sizes[part.slot]);
+    CHECK_EQ(0, part.offset % Allocator::kAllocatorAlignment);
+    parts_.emplace_back(new SlotAllocator(this, slots_[part.slot].get(),
+                                          SlotAllocator::kPart, part.offset,
+                                          part.bytes));
+  }
+}
+
+StaticMemorySlab::~StaticMemorySlab() {
+  if (memory_ != nullptr) {
+    base_->DeallocateRaw(memory_);
+  }
+}
+
+Allocator* StaticMemorySlab::slot_allocator(int slot) {
+  return slots_[slot]->allocator.get();
+}
+
+Allocator* StaticMemorySlab::owner_allocator(int slot) {
+  return slots_[slot]->owner_allocator.get();
+}
+
+Allocator* StaticMemorySlab::part_allocator(int part) {
+  return parts_[part].get();
+}
+
+std::vector<int64> StaticMemorySlab::RequestedBytes() const {
+  std::vector<int64> bytes(slots_.size());
+  for (size_t s = 0; s < slots_.size(); ++s) {
+    bytes[s] = std::max(slots_[s]->allocator->requested(),
+                        slots_[s]->owner_allocator->requested());
+  }
+  return bytes;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+#define TENSORFLOW_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An output buffer to be placed in a static memory plan: output
+// "output" of the node with id "node_id", which takes "bytes" bytes.
+struct PlannedBuffer {
+  int node_id;
+  int output;
+  int64 bytes;
+  // Other nodes that write into the buffer in place before "node_id"
+  // runs, e.g. the producers of the inputs of a Concat whose output is
+  // the buffer. The buffer is then live from the start of the first of
+  // them.
+  std::vector<int> writer_node_ids;
+};
+
+// A part of a slot that a buffer is written into in place: "bytes" bytes
+// at "offset" from the start of slot "slot". The offset is a multiple of
+// Allocator::kAllocatorAlignment.
+struct SlotPart {
+  int slot;
+  int64 offset;
+  int64 bytes;
+};
+
+// A static memory plan divides one slab of memory into disjoint slots,
+// and assigns each buffer to a slot that it shares only with buffers
+// whose lifetimes cannot overlap its own.
+struct StaticMemoryPlan {
+  // Offset and size in bytes of each slot. Offsets are multiples of
+  // Allocator::kAllocatorAlignment.
+  std::vector<int64> slot_offsets;
+  std::vector<int64> slot_sizes;
+  // Total size of the slab.
+  int64 slab_bytes = 0;
+  // buffer_slots[i] is the slot of the i-th buffer passed to
+  // PlanStaticMemory().
+  std::vector<int> buffer_slots;
+  // Parts of slots that are handed out separately, see
+  // StaticMemorySlab::part_allocator(). Filled in by the caller.
+  std::vector<SlotPart> slot_parts;
+};
+
+// Computes a static memory plan for "buffers", which are outputs of nodes
+// in "graph". A buffer is assumed to be live from the start of its node
+// until all consumers of the output have finished, or until its node has
+// finished if there are none, or from the start of the first of its
+// writer_node_ids if it has any. Two buffers share a slot only if every
+// consumer of one is an ancestor of the other's nodes, so that they are
+// never live at the same time in any schedule the executor may pick.
+// Slots are assigned greedily in topological order, each buffer going to
+// the best-fitting free slot, in the style of a heap simulation.
+//
+// Returns an error if "graph" has a cycle or too many nodes for the
+// quadratic liveness analysis.
+Status PlanStaticMemory(const Graph& graph,
+                        const std::vector<PlannedBuffer>& buffers,
+                        StaticMemoryPlan* plan);
+
+// StaticMemorySlab holds the memory of a StaticMemoryPlan and hands out
+// one Allocator per slot. The allocator of a slot returns the slot's
+// memory when a request fits and the slot is not already in use, and
+// otherwise falls back to the base allocator. A slot thus stays safe if
+// the runtime keeps a buffer alive longer than planned, e.g. because a
+// kernel forwarded it to its output or the client fetched it: the next
+// buffer planned for the slot simply gets dynamic memory instead.
+//
+// The parts of a slot let the inputs of an op be written directly into
+// their place in the op's output buffer: each input takes its part from
+// part_allocator(), and the op then takes the whole slot from
+// owner_allocator() and finds its inputs already in place. A part is
+// only handed out while the slot is free, and the slot only to its
+// owner while a part is in use, so that the parts of a slot are never
+// live at the same time as any other buffer planned for it.
+//
+// Each slot or part in use holds a reference on the slab, so the slab
+// outlives all buffers carved out of it. StaticMemorySlab is
+// thread-safe.
+class StaticMemorySlab : public core::RefCounted {
+ public:
+  // Allocates the slab for "plan" from "base", which must outlive the
+  // slab. If the slab cannot be allocated, every slot falls back to
+  // "base".
+  StaticMemorySlab(const StaticMemoryPlan& plan, Allocator* base);
+
+  int num_slots() const { return slots_.size(); }
+  Allocator* slot_allocator(int slot);
+
+  // Like slot_allocator(), but for the buffer that the parts of the slot
+  // are written for, so it also returns the slot's memory while parts of
+  // it are in use.
+  Allocator* owner_allocator(int slot);
+
+  // Returns the allocator of plan.slot_parts[part]. It returns the memory
+  // of the part for a request of exactly its size while both the part
+  // and its slot are free, and otherwise falls back to the base
+  // allocator.
+  Allocator* part_allocator(int part);
+
+  // Returns, for each slot, the largest request its allocator has seen,
+  // including requests that did not fit.
+  std::vector<int64> RequestedBytes() const;
+
+ private:
+  struct Slot;
+  class SlotAllocator;
+
+  ~StaticMemorySlab() override;
+
+  Allocator* const base_;
+  void* memory_ = nullptr;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<std::unique_ptr<SlotAllocator>> parts_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemorySlab);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
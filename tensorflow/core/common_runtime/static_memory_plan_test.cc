@@ -0,0 +1,184 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor Scalar() { return test::AsScalar<float>(1.0f); }
+
+TEST(PlanStaticMemoryTest, ChainReusesSlots) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar());
+  Node* b = test::graph::Identity(&g, a);
+  Node* c = test::graph::Identity(&g, b);
+  Node* d = test::graph::Identity(&g, c);
+
+  StaticMemoryPlan plan;
+  TF_ASSERT_OK(PlanStaticMemory(
+      g, {{a->id(), 0, 100}, {b->id(), 0, 100}, {c->id(), 0, 40},
+          {d->id(), 0, 100}},
+      &plan));
+
+  // The output of a is dead once b has finished, so c and d can take over
+  // its slot in turn; b's output is still live while c runs.
+  ASSERT_EQ(2, plan.slot_sizes.size());
+  EXPECT_EQ(plan.buffer_slots[0], plan.buffer_slots[2]);
+  EXPECT_EQ(plan.buffer_slots[1], plan.buffer_slots[3]);
+  EXPECT_NE(plan.buffer_slots[0], plan.buffer_slots[1]);
+  for (int s = 0; s < 2; ++s) {
+    EXPECT_EQ(0, plan.slot_offsets[s] % Allocator::kAllocatorAlignment);
+    EXPECT_GE(plan.slot_sizes[s], 100);
+  }
+  EXPECT_EQ(plan.slot_sizes[0] + plan.slot_sizes[1], plan.slab_bytes);
+}
+
+TEST(PlanStaticMemoryTest, ParallelBranchesDoNotShareSlots) {
+  Graph g(OpRegistry::Global());
+  Node* x = test::graph::Constant(&g, Scalar());
+  Node* left = test::graph::Identity(&g, x);
+  Node* right = test::graph::Identity(&g, x);
+  Node* sum = test::graph::Add(&g, left, right);
+
+  StaticMemoryPlan plan;
+  TF_ASSERT_OK(PlanStaticMemory(g,
+                                {{x->id(), 0, 64},
+                                 {left->id(), 0, 64},
+                                 {right->id(), 0, 64},
+                                 {sum->id(), 0, 64}},
+                                &plan));
+
+  // The branches may run concurrently, and x stays live until both have
+  // finished; only sum may reuse the slot of x.
+  EXPECT_NE(plan.buffer_slots[1], plan.buffer_slots[2]);
+  EXPECT_NE(plan.buffer_slots[0], plan.buffer_slots[1]);
+  EXPECT_NE(plan.buffer_slots[0], plan.buffer_slots[2]);
+  EXPECT_EQ(plan.buffer_slots[0], plan.buffer_slots[3]);
+  EXPECT_EQ(3, plan.slot_sizes.size());
+}
+
+TEST(PlanStaticMemoryTest, WritersExtendLiveness) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar());
+  Node* b = test::graph::Identity(&g, a);
+  Node* c = test::graph::Identity(&g, b);
+
+  // On its own, c's output could take over the slot of a's output, which
+  // is dead once b has finished. But b writes into c's output while it
+  // reads a's.
+  StaticMemoryPlan plan;
+  TF_ASSERT_OK(
+      PlanStaticMemory(g, {{a->id(), 0, 64}, {c->id(), 0, 64}}, &plan));
+  EXPECT_EQ(plan.buffer_slots[0], plan.buffer_slots[1]);
+  TF_ASSERT_OK(PlanStaticMemory(
+      g, {{a->id(), 0, 64}, {c->id(), 0, 64, {b->id()}}}, &plan));
+  EXPECT_NE(plan.buffer_slots[0], plan.buffer_slots[1]);
+}
+
+TEST(StaticMemorySlabTest, BusySlotFallsBack) {
+  StaticMemoryPlan plan;
+  plan.slot_offsets = {0};
+  plan.slot_sizes = {64};
+  plan.slab_bytes = 64;
+  StaticMemorySlab* slab = new StaticMemorySlab(plan, cpu_allocator());
+  Allocator* a = slab->slot_allocator(0);
+
+  void* first = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* second = a->AllocateRaw(Allocator::kAllocatorAlignment, 32);
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  ASSERT_NE(nullptr, second);
+  ASSERT_NE(nullptr, large);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(std::vector<int64>({128}), slab->RequestedBytes());
+  a->DeallocateRaw(second);
+  a->DeallocateRaw(large);
+
+  // Once the slot is free again, it serves the next request that fits.
+  a->DeallocateRaw(first);
+  void* third = a->AllocateRaw(Allocator::kAllocatorAlignment, 48);
+  EXPECT_EQ(first, third);
+  a->DeallocateRaw(third);
+  slab->Unref();
+}
+
+TEST(StaticMemorySlabTest, PartsAreWrittenInPlace) {
+  StaticMemoryPlan plan;
+  plan.slot_offsets = {0};
+  plan.slot_sizes = {256};
+  plan.slab_bytes = 256;
+  plan.slot_parts = {{0, 0, 64}, {0, 128, 128}};
+  StaticMemorySlab* slab = new StaticMemorySlab(plan, cpu_allocator());
+  Allocator* first = slab->part_allocator(0);
+  Allocator* second = slab->part_allocator(1);
+  Allocator* owner = slab->owner_allocator(0);
+
+  // A part only serves a request of its own size.
+  void* mismatch = second->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* a = first->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  void* b = second->AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  char* base = static_cast<char*>(a);
+  EXPECT_EQ(base + 128, b);
+  EXPECT_TRUE(mismatch < base || mismatch >= base + 256);
+  second->DeallocateRaw(mismatch);
+
+  // While the parts are in use, only the owner may take their slot.
+  void* other = slab->slot_allocator(0)->AllocateRaw(
+      Allocator::kAllocatorAlignment, 256);
+  EXPECT_NE(base, other);
+  slab->slot_allocator(0)->DeallocateRaw(other);
+  void* whole = owner->AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  EXPECT_EQ(base, whole);
+  first->DeallocateRaw(a);
+  second->DeallocateRaw(b);
+
+  // The parts of a slot in use fall back until the owner is done.
+  void* busy = first->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_NE(base, busy);
+  first->DeallocateRaw(busy);
+  owner->DeallocateRaw(whole);
+  void* again = first->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_EQ(base, again);
+  first->DeallocateRaw(again);
+  slab->Unref();
+}
+
+TEST(StaticMemorySlabTest, TensorOutlivesSlab) {
+  StaticMemoryPlan plan;
+  plan.slot_offsets = {0, 64};
+  plan.slot_sizes = {64, 64};
+  plan.slab_bytes = 128;
+  StaticMemorySlab* slab = new StaticMemorySlab(plan, cpu_allocator());
+  Tensor t(slab->slot_allocator(1), DT_FLOAT, TensorShape({4}));
+  slab->Unref();
+
+  // The tensor holds a reference that keeps its slot valid.
+  t.flat<float>().setConstant(3.0f);
+  test::ExpectTensorEqual<float>(
+      t, test::AsTensor<float>({3.0f, 3.0f, 3.0f, 3.0f}, {4}));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(size_t block_size,
+                                       Allocator* large_allocator)
+    : max_arena_bytes_(block_size / 4),
+      large_allocator_(large_allocator),
+      arena_(block_size) {}
+
+StepArenaAllocator::~StepArenaAllocator() {}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes == 0) {
+    // The arena returns nullptr for empty requests, which callers would
+    // mistake for an allocation failure.
+    num_bytes = 1;
+  }
+  if (num_bytes > max_arena_bytes_) {
+    void* ptr = large_allocator_->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) return nullptr;
+    mutex_lock l(mu_);
+    DCHECK(!orphaned_);
+    ++num_live_;
+    large_ptrs_.insert(ptr);
+    return ptr;
+  }
+  mutex_lock l(mu_);
+  DCHECK(!orphaned_);
+  ++num_live_;
+  return arena_.AllocAligned(num_bytes, alignment);
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  bool delete_this = false;
+  bool is_large = false;
+  {
+    mutex_lock l(mu_);
+    DCHECK_GT(num_live_, 0);
+    is_large = large_ptrs_.erase(ptr) > 0;
+    delete_this = --num_live_ == 0 && orphaned_;
+  }
+  if (is_large) large_allocator_->DeallocateRaw(ptr);
+  if (delete_this) delete this;
+}
+
+bool StepArenaAllocator::EndStep() {
+  mutex_lock l(mu_);
+  if (num_live_ > 0) {
+    VLOG(1) << num_live_ << " step arena allocations outlive their step";
+    orphaned_ = true;
+    return false;
+  }
+  arena_.Reset();
+  return true;
+}
+
+void StepArenaAllocator::Release() {
+  if (EndStep()) delete this;
+}
+
+}  // namespace tensorflow
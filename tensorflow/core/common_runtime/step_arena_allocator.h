@@ -0,0 +1,91 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/arena.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// StepArenaAllocator hands out host memory from a core::Arena for the
+// duration of one step.  DeallocateRaw() does not return memory to the
+// arena; instead all of it is recycled at once when the owner calls
+// EndStep() at the end of the step.
+//
+// Requests of more than a quarter of a block are passed to a wrapped
+// allocator instead, so that large buffers are freed as soon as they are
+// deallocated rather than at the end of the step, and a failure to allocate
+// one returns nullptr rather than aborting in the arena.
+//
+// Buffers may outlive the step, e.g. a temporary that a kernel turned
+// into an output that the client fetched.  EndStep() detects this and,
+// rather than recycling memory that is still referenced, hands the
+// allocator over to its remaining buffers: it then deletes itself once
+// the last of them is deallocated.
+//
+// This class is thread-safe.
+class StepArenaAllocator : public Allocator {
+ public:
+  // Blocks of the arena are 'block_size' bytes.  Requests of more than a
+  // quarter of a block go to 'large_allocator', which must outlive all of
+  // them.
+  StepArenaAllocator(size_t block_size, Allocator* large_allocator);
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Ends the current step.  If no allocation is live, recycles the arena
+  // for the next step and returns true.  Otherwise returns false, and the
+  // allocator deletes itself after the last live allocation is
+  // deallocated; the caller must not use it again.
+  bool EndStep();
+
+  // Gives up the caller's ownership: deletes the allocator now if no
+  // allocation is live, and otherwise as soon as the last one is
+  // deallocated.
+  void Release();
+
+ private:
+  ~StepArenaAllocator() override;
+
+  // Requests of more than this many bytes go to large_allocator_.
+  const size_t max_arena_bytes_;
+  Allocator* const large_allocator_;
+
+  mutex mu_;
+  core::Arena arena_ GUARDED_BY(mu_);
+  // The live allocations of large_allocator_.
+  std::unordered_set<void*> large_ptrs_ GUARDED_BY(mu_);
+  // Number of allocations handed out and not yet deallocated.
+  int64 num_live_ GUARDED_BY(mu_) = 0;
+  // Set once the owner gave up the allocator while allocations were live.
+  bool orphaned_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Passes allocations to cpu_allocator() and counts the live ones, but fails
+// those of more than 'limit' bytes.
+class CountingAllocator : public Allocator {
+ public:
+  explicit CountingAllocator(size_t limit) : limit_(limit) {}
+
+  string Name() override { return "counting"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    if (num_bytes > limit_) return nullptr;
+    ++num_live_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    --num_live_;
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  int num_live() const { return num_live_; }
+
+ private:
+  const size_t limit_;
+  int num_live_ = 0;
+};
+
+TEST(StepArenaAllocatorTest, AllocationsAreAligned) {
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, cpu_allocator());
+  std::vector<void*> ptrs;
+  for (int s = 1; s < 600; s += 7) {
+    void* raw = a->AllocateRaw(Allocator::kAllocatorAlignment, s);
+    ASSERT_NE(nullptr, raw);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(raw) %
+                     Allocator::kAllocatorAlignment);
+    ptrs.push_back(raw);
+  }
+  // Empty requests still get a distinct non-null pointer.
+  void* empty = a->AllocateRaw(Allocator::kAllocatorAlignment, 0);
+  EXPECT_NE(nullptr, empty);
+  ptrs.push_back(empty);
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, RecyclesMemoryAcrossSteps) {
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, cpu_allocator());
+  void* first = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  a->DeallocateRaw(first);
+  EXPECT_TRUE(a->EndStep());
+
+  // The next step starts again at the beginning of the first block.
+  void* second = a->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  EXPECT_EQ(first, second);
+  a->DeallocateRaw(second);
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, LargeRequestsUseWrappedAllocator) {
+  CountingAllocator wrapped(1 << 20);
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, &wrapped);
+  void* small = a->AllocateRaw(Allocator::kAllocatorAlignment, 256);
+  EXPECT_EQ(0, wrapped.num_live());
+  void* large = a->AllocateRaw(Allocator::kAllocatorAlignment, 257);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(1, wrapped.num_live());
+
+  // Large buffers are freed right away, not at the end of the step.
+  a->DeallocateRaw(large);
+  EXPECT_EQ(0, wrapped.num_live());
+  a->DeallocateRaw(small);
+  EXPECT_TRUE(a->EndStep());
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, LargeRequestFailureReturnsNull) {
+  CountingAllocator wrapped(1 << 20);
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, &wrapped);
+  EXPECT_EQ(nullptr, a->AllocateRaw(Allocator::kAllocatorAlignment, 2 << 20));
+  // The failed request is not a live allocation.
+  EXPECT_TRUE(a->EndStep());
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, LargeTensorOutlivesStep) {
+  CountingAllocator wrapped(1 << 20);
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, &wrapped);
+  Tensor escaped(a, DT_FLOAT, TensorShape({1024}));
+  EXPECT_FALSE(a->EndStep());
+  EXPECT_EQ(1, wrapped.num_live());
+  // The orphaned allocator still frees the buffer through the wrapped one.
+  escaped = Tensor();
+  EXPECT_EQ(0, wrapped.num_live());
+}
+
+TEST(StepArenaAllocatorTest, TensorOutlivesStep) {
+  StepArenaAllocator* a = new StepArenaAllocator(1 << 10, cpu_allocator());
+  Tensor escaped(a, DT_FLOAT, TensorShape({4}));
+  {
+    Tensor temp(a, DT_FLOAT, TensorShape({16}));
+    temp.flat<float>().setZero();
+  }
+  escaped.flat<float>().setConstant(2.0f);
+
+  // The escaped tensor keeps the arena, and the allocator, alive.
+  EXPECT_FALSE(a->EndStep());
+  test::ExpectTensorEqual<float>(
+      escaped, test::AsTensor<float>({2.0f, 2.0f, 2.0f, 2.0f}, {4}));
+  // Dropping the last reference deletes the allocator.
+  escaped = Tensor();
+}
+
+static void BM_StepArenaAllocation(int iters, int num_temps) {
+  StepArenaAllocator* a = new StepArenaAllocator(256 << 10, cpu_allocator());
+  std::vector<void*> ptrs(num_temps);
+  while (--iters > 0) {
+    for (int i = 0; i < num_temps; ++i) {
+      ptrs[i] = a->AllocateRaw(Allocator::kAllocatorAlignment, 256 + 64 * i);
+    }
+    for (void* p : ptrs) {
+      a->DeallocateRaw(p);
+    }
+    a->EndStep();
+  }
+  a->Release();
+}
+BENCHMARK(BM_StepArenaAllocation)->Arg(1)->Arg(16)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,102 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_trace_collector.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+// An id of the calling thread, so that the timeline shows the nodes run by
+// each thread on its own row.
+uint32 CurrentThreadId() {
+  return static_cast<uint32>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+// The label of the node in the timeline, "name = op(inputs)".
+string TimelineLabel(const Node* node) {
+  const NodeDef& def = node->def();
+  return strings::StrCat(
+      def.name(), " = ", def.op(), "(",
+      str_util::Join(
+          std::vector<StringPiece>(def.input().begin(), def.input().end()),
+          ", "),
+      ")");
+}
+
+}  // namespace
+
+StepTraceCollector::StepTraceCollector(int64 max_events)
+    : max_events_(std::max<int64>(max_events, 0)),
+      events_(new Event[max_events_]),
+      next_event_(0) {}
+
+void StepTraceCollector::Record(const Event& event) {
+  const int64 index = next_event_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= max_events_) return;
+  Event* dst = &events_[index];
+  *dst = event;
+  dst->thread_id = CurrentThreadId();
+}
+
+void StepTraceCollector::ToStepStats(StepStats* step_stats) const {
+  std::unordered_map<StringPiece, DeviceStepStats*, StringPiece::Hasher>
+      device_stats;
+  const int64 num = num_events();
+  for (int64 i = 0; i < num; ++i) {
+    const Event& event = events_[i];
+    if (IsTransferNode(event.node)) continue;
+    DeviceStepStats*& dev_stats = device_stats[*event.device];
+    if (dev_stats == nullptr) {
+      dev_stats = step_stats->add_dev_stats();
+      dev_stats->set_device(*event.device);
+    }
+    NodeExecStats* nt = dev_stats->add_node_stats();
+    nt->set_node_name(event.node->name());
+    nt->set_scheduled_micros(event.scheduled_micros);
+    nt->set_all_start_micros(event.all_start_micros);
+    nt->set_op_start_rel_micros(event.op_start_micros -
+                                event.all_start_micros);
+    nt->set_op_end_rel_micros(event.op_end_micros - event.all_start_micros);
+    nt->set_all_end_rel_micros(event.all_end_micros -
+                               event.all_start_micros);
+    nt->set_thread_id(event.thread_id);
+    nt->set_timeline_label(TimelineLabel(event.node));
+  }
+}
+
+int64 StepTraceCollector::num_events() const {
+  return std::min(next_event_.load(std::memory_order_acquire), max_events_);
+}
+
+int64 StepTraceCollector::num_dropped() const {
+  return std::max<int64>(
+      next_event_.load(std::memory_order_acquire) - max_events_, 0);
+}
+
+}  // namespace tensorflow
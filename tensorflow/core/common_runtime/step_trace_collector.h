@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_TRACE_COLLECTOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_TRACE_COLLECTOR_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Node;
+class StepStats;
+
+// StepTraceCollector records the execution times of the nodes of a step
+// as fixed-size binary events, cheaply enough to trace a sample of the
+// steps of a production job, unlike a StepStatsCollector which builds a
+// NodeExecStats proto per node under a lock.
+//
+// The events are written to a buffer allocated up front, claimed with an
+// atomic increment, and are only converted to a StepStats by ToStepStats()
+// once the step is done. Events beyond the capacity of the buffer are
+// dropped and counted.
+//
+// Record() is thread-safe and lock-free. ToStepStats() must not be called
+// concurrently with Record(), and the nodes and device names of the events
+// must outlive it.
+class StepTraceCollector {
+ public:
+  struct Event {
+    const Node* node;
+    const string* device;
+    int64 scheduled_micros;
+    int64 all_start_micros;
+    int64 op_start_micros;
+    int64 op_end_micros;
+    int64 all_end_micros;
+    // Set by Record() to an id of the recording thread.
+    uint32 thread_id;
+  };
+
+  // Holds up to 'max_events' events.
+  explicit StepTraceCollector(int64 max_events);
+
+  void Record(const Event& event);
+
+  // Adds a NodeExecStats to 'step_stats' for each recorded event, except
+  // those of transfer nodes, grouped by device.
+  void ToStepStats(StepStats* step_stats) const;
+
+  int64 num_events() const;
+  int64 num_dropped() const;
+
+ private:
+  const int64 max_events_;
+  std::unique_ptr<Event[]> events_;
+  std::atomic<int64> next_event_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepTraceCollector);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_TRACE_COLLECTOR_H_
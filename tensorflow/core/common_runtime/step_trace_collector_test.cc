@@ -0,0 +1,129 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_trace_collector.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+StepTraceCollector::Event MakeEvent(const Node* node, const string* device,
+                                    int64 start) {
+  StepTraceCollector::Event event;
+  event.node = node;
+  event.device = device;
+  event.scheduled_micros = start - 1;
+  event.all_start_micros = start;
+  event.op_start_micros = start + 1;
+  event.op_end_micros = start + 3;
+  event.all_end_micros = start + 4;
+  return event;
+}
+
+TEST(StepTraceCollectorTest, ConvertsEventsToStepStats) {
+  Graph graph(OpRegistry::Global());
+  Node* a = test::graph::Constant(&graph, Tensor(DT_FLOAT, {}), "a");
+  Node* b = test::graph::Constant(&graph, Tensor(DT_FLOAT, {}), "b");
+  const string cpu0 = "/job:localhost/replica:0/task:0/cpu:0";
+  const string cpu1 = "/job:localhost/replica:0/task:0/cpu:1";
+
+  StepTraceCollector collector(16);
+  collector.Record(MakeEvent(a, &cpu0, 100));
+  collector.Record(MakeEvent(b, &cpu1, 200));
+  collector.Record(MakeEvent(b, &cpu0, 300));
+  EXPECT_EQ(3, collector.num_events());
+  EXPECT_EQ(0, collector.num_dropped());
+
+  StepStats step_stats;
+  collector.ToStepStats(&step_stats);
+  ASSERT_EQ(2, step_stats.dev_stats_size());
+  const DeviceStepStats& dev0 = step_stats.dev_stats(0);
+  EXPECT_EQ(cpu0, dev0.device());
+  ASSERT_EQ(2, dev0.node_stats_size());
+  const NodeExecStats& a_stats = dev0.node_stats(0);
+  EXPECT_EQ("a", a_stats.node_name());
+  EXPECT_EQ(99, a_stats.scheduled_micros());
+  EXPECT_EQ(100, a_stats.all_start_micros());
+  EXPECT_EQ(1, a_stats.op_start_rel_micros());
+  EXPECT_EQ(3, a_stats.op_end_rel_micros());
+  EXPECT_EQ(4, a_stats.all_end_rel_micros());
+  EXPECT_EQ("a = Const()", a_stats.timeline_label());
+  EXPECT_EQ("b", dev0.node_stats(1).node_name());
+  EXPECT_EQ(300, dev0.node_stats(1).all_start_micros());
+
+  const DeviceStepStats& dev1 = step_stats.dev_stats(1);
+  EXPECT_EQ(cpu1, dev1.device());
+  ASSERT_EQ(1, dev1.node_stats_size());
+  EXPECT_EQ("b", dev1.node_stats(0).node_name());
+}
+
+TEST(StepTraceCollectorTest, DropsEventsBeyondCapacity) {
+  Graph graph(OpRegistry::Global());
+  Node* a = test::graph::Constant(&graph, Tensor(DT_FLOAT, {}), "a");
+  const string cpu0 = "/job:localhost/replica:0/task:0/cpu:0";
+
+  StepTraceCollector collector(2);
+  for (int i = 0; i < 5; ++i) {
+    collector.Record(MakeEvent(a, &cpu0, 100 * (i + 1)));
+  }
+  EXPECT_EQ(2, collector.num_events());
+  EXPECT_EQ(3, collector.num_dropped());
+
+  StepStats step_stats;
+  collector.ToStepStats(&step_stats);
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  EXPECT_EQ(2, step_stats.dev_stats(0).node_stats_size());
+}
+
+TEST(StepTraceCollectorTest, RecordsConcurrently) {
+  Graph graph(OpRegistry::Global());
+  Node* a = test::graph::Constant(&graph, Tensor(DT_FLOAT, {}), "a");
+  const string cpu0 = "/job:localhost/replica:0/task:0/cpu:0";
+
+  const int kNumThreads = 4;
+  const int kEventsPerThread = 1000;
+  StepTraceCollector collector(kNumThreads * kEventsPerThread);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&collector, a, &cpu0]() {
+        for (int i = 0; i < kEventsPerThread; ++i) {
+          collector.Record(MakeEvent(a, &cpu0, i + 1));
+        }
+      });
+    }
+  }
+  EXPECT_EQ(kNumThreads * kEventsPerThread, collector.num_events());
+  EXPECT_EQ(0, collector.num_dropped());
+
+  StepStats step_stats;
+  collector.ToStepStats(&step_stats);
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  EXPECT_EQ(kNumThreads * kEventsPerThread,
+            step_stats.dev_stats(0).node_stats_size());
+}
+
+}  // namespace
+}  // namespace tensorflow
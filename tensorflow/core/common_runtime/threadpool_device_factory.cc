@@ -19,6 +19,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -28,17 +29,25 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    // TODO(zhifengc/tucker): Figure out the number of available CPUs
-    // and/or NUMA configuration.
-    int n = 1;
+    // TODO(zhifengc/tucker): Figure out the number of available CPUs.
+    const int num_numa_nodes =
+        options.config.use_numa_affinity() ? port::NUMANumNodes() : 1;
+    int n = num_numa_nodes;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/cpu:", i);
+      // The devices are spread round-robin over the NUMA nodes, which
+      // LocalDevice binds their intra-op threads to.  NUMA locales are
+      // indexed from 0, buses are indexed from 1.
+      DeviceLocality locality;
+      if (num_numa_nodes > 1) {
+        locality.set_bus_id(i % num_numa_nodes + 1);
+      }
       devices->push_back(new ThreadPoolDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(), cpu_allocator()));
+          options, name, Bytes(256 << 20), locality, cpu_allocator()));
     }
 
     return Status::OK();
@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// WorkStealingQueue<T> holds one ready deque per worker slot. A worker
+// pops the most recently pushed item from the back of its own deque
+// (so that a node's successors tend to run on the thread whose caches
+// already hold the node's outputs) and, when its own deque is empty,
+// steals the oldest item from the front of another worker's deque.
+//
+// The queue also tracks which worker slots are occupied. A producer
+// that pushes work calls StartWorker() to claim an idle slot and, on
+// success, starts a loop that drains the queue on behalf of that slot.
+// A worker that runs out of work calls StopWorker(), which releases the
+// slot unless an item was pushed concurrently, in which case the worker
+// must keep going. Together these guarantee that no pushed item is ever
+// left behind without a worker to run it.
+//
+// All methods are thread-safe.
+template <typename T>
+class WorkStealingQueue {
+ public:
+  explicit WorkStealingQueue(int num_workers)
+      : num_workers_(num_workers),
+        deques_(new Deque[num_workers]),
+        busy_(new std::atomic<bool>[num_workers]) {
+    CHECK_GT(num_workers, 0);
+    for (int i = 0; i < num_workers; ++i) {
+      busy_[i].store(false, std::memory_order_relaxed);
+    }
+  }
+
+  int num_workers() const { return num_workers_; }
+
+  // Appends "item" to the back of the deque owned by "worker". If
+  // "worker" is negative (the producer is not a worker of this queue),
+  // the deques are chosen round-robin.
+  void Push(int worker, T item) {
+    if (worker < 0) {
+      worker = next_.fetch_add(1, std::memory_order_relaxed) % num_workers_;
+    }
+    DCHECK_LT(worker, num_workers_);
+    Deque& d = deques_[worker];
+    {
+      mutex_lock l(d.mu);
+      d.items.push_back(std::move(item));
+    }
+    size_.fetch_add(1);
+  }
+
+  // Pops an item from the back of "worker"'s deque, or steals one from
+  // the front of another deque. Returns false iff no item was found.
+  bool PopOrSteal(int worker, T* item) {
+    if (size_.load() == 0) return false;
+    if (PopBack(worker, item)) return true;
+    for (int i = 1; i < num_workers_; ++i) {
+      if (PopFront((worker + i) % num_workers_, item)) return true;
+    }
+    return false;
+  }
+
+  // Tries to claim an idle worker slot, starting the search at "hint".
+  // Returns the claimed slot, or -1 if every slot is already busy.
+  int StartWorker(int hint) {
+    if (hint < 0) hint = 0;
+    for (int i = 0; i < num_workers_; ++i) {
+      const int w = (hint + i) % num_workers_;
+      bool expected = false;
+      if (!busy_[w].load(std::memory_order_relaxed) &&
+          busy_[w].compare_exchange_strong(expected, true)) {
+        return w;
+      }
+    }
+    return -1;
+  }
+
+  // Releases "worker"'s slot after PopOrSteal() came up empty. Returns
+  // true iff the caller raced with a Push(), re-acquired its slot, and
+  // must keep draining.
+  bool StopWorker(int worker) {
+    busy_[worker].store(false);
+    if (size_.load() == 0) return false;
+    bool expected = false;
+    return busy_[worker].compare_exchange_strong(expected, true);
+  }
+
+  // Returns the number of queued items. Only for testing and debugging.
+  int64 size() const { return size_.load(); }
+
+ private:
+  struct Deque {
+    mutex mu;
+    std::deque<T> items GUARDED_BY(mu);
+  };
+
+  bool PopBack(int worker, T* item) {
+    Deque& d = deques_[worker];
+    mutex_lock l(d.mu);
+    if (d.items.empty()) return false;
+    *item = std::move(d.items.back());
+    d.items.pop_back();
+    size_.fetch_sub(1);
+    return true;
+  }
+
+  bool PopFront(int worker, T* item) {
+    Deque& d = deques_[worker];
+    mutex_lock l(d.mu);
+    if (d.items.empty()) return false;
+    *item = std::move(d.items.front());
+    d.items.pop_front();
+    size_.fetch_sub(1);
+    return true;
+  }
+
+  const int num_workers_;
+  std::unique_ptr<Deque[]> deques_;
+  std::unique_ptr<std::atomic<bool>[]> busy_;
+
+  // Total number of items across all deques. Incremented after an item
+  // becomes visible in a deque and decremented after it is removed, so
+  // that a worker observing size_ == 0 after releasing its slot knows
+  // that any concurrent producer will observe the released slot.
+  std::atomic<int64> size_{0};
+  std::atomic<uint32> next_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
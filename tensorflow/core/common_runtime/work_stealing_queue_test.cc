@@ -0,0 +1,122 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueueTest, OwnerPopsLifo) {
+  WorkStealingQueue<int> q(2);
+  q.Push(0, 1);
+  q.Push(0, 2);
+  q.Push(0, 3);
+  EXPECT_EQ(3, q.size());
+  int v = 0;
+  EXPECT_TRUE(q.PopOrSteal(0, &v));
+  EXPECT_EQ(3, v);
+  EXPECT_TRUE(q.PopOrSteal(0, &v));
+  EXPECT_EQ(2, v);
+  EXPECT_TRUE(q.PopOrSteal(0, &v));
+  EXPECT_EQ(1, v);
+  EXPECT_FALSE(q.PopOrSteal(0, &v));
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingQueueTest, ThiefStealsFifo) {
+  WorkStealingQueue<int> q(3);
+  q.Push(0, 1);
+  q.Push(0, 2);
+  int v = 0;
+  EXPECT_TRUE(q.PopOrSteal(2, &v));
+  EXPECT_EQ(1, v);
+  EXPECT_TRUE(q.PopOrSteal(1, &v));
+  EXPECT_EQ(2, v);
+  EXPECT_FALSE(q.PopOrSteal(1, &v));
+}
+
+TEST(WorkStealingQueueTest, ExternalPushesRoundRobin) {
+  WorkStealingQueue<int> q(2);
+  q.Push(-1, 1);
+  q.Push(-1, 2);
+  // Each worker finds one item in its own deque.
+  int v0 = 0, v1 = 0;
+  EXPECT_TRUE(q.PopOrSteal(0, &v0));
+  EXPECT_TRUE(q.PopOrSteal(1, &v1));
+  EXPECT_EQ(3, v0 + v1);
+  EXPECT_NE(v0, v1);
+}
+
+TEST(WorkStealingQueueTest, WorkerSlots) {
+  WorkStealingQueue<int> q(2);
+  EXPECT_EQ(1, q.StartWorker(1));
+  EXPECT_EQ(0, q.StartWorker(1));
+  EXPECT_EQ(-1, q.StartWorker(0));
+  // An empty queue releases the slot.
+  EXPECT_FALSE(q.StopWorker(1));
+  EXPECT_EQ(1, q.StartWorker(0));
+  // A non-empty queue keeps the worker running.
+  q.Push(0, 7);
+  EXPECT_TRUE(q.StopWorker(0));
+  EXPECT_EQ(-1, q.StartWorker(0));
+}
+
+// Runs many producers against a pool of workers started on demand, and
+// checks that every pushed item is consumed exactly once.
+TEST(WorkStealingQueueTest, Concurrent) {
+  const int kWorkers = 4;
+  const int kProducers = 8;
+  const int kItemsPerProducer = 10000;
+  auto q = std::make_shared<WorkStealingQueue<int>>(kWorkers);
+  std::atomic<int64> sum(0);
+  BlockingCounter consumed(kProducers * kItemsPerProducer);
+  std::function<void(int)> run_worker = [q, &sum, &consumed](int worker) {
+    int v;
+    do {
+      while (q->PopOrSteal(worker, &v)) {
+        sum += v;
+        consumed.DecrementCount();
+      }
+    } while (q->StopWorker(worker));
+  };
+  // Declared last so that it is destroyed, and thus joined, first.
+  thread::ThreadPool pool(Env::Default(), "test", kWorkers + kProducers);
+  for (int p = 0; p < kProducers; ++p) {
+    pool.Schedule([q, &pool, &run_worker]() {
+      for (int i = 1; i <= kItemsPerProducer; ++i) {
+        q->Push(-1, i);
+        const int w = q->StartWorker(0);
+        if (w >= 0) pool.Schedule([&run_worker, w]() { run_worker(w); });
+      }
+    });
+  }
+  consumed.Wait();
+  EXPECT_EQ(static_cast<int64>(kProducers) * kItemsPerProducer *
+                (kItemsPerProducer + 1) / 2,
+            sum.load());
+  EXPECT_EQ(0, q->size());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/debug/debug_io_utils.h"
 
+#include <limits>
 #include <vector>
 
 #if defined(PLATFORM_GOOGLE)
@@ -26,8 +27,10 @@ limitations under the License.
 #pragma comment(lib,"Ws2_32.lib")
 #endif
 
+#include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/util/event.pb.h"
@@ -86,8 +89,208 @@ string AppendTimestampToFilePath(const string& in, const uint64 timestamp) {
   return out;
 }
 
+// The debug op under whose name tensors that are not published in full are
+// summarized.
+const char kSummaryDebugOp[] = "DebugNumericSummary";
+
+auto* published_tensors = monitoring::Counter<1>::New(
+    "/tensorflow/core/debug/published_tensors",
+    "The number of debug tensors published through a DebugURLPublisher, by "
+    "whether they were published in full, as a summary, or dropped.",
+    "publication");
+
+// Fill summary with the output DebugNumericSummary would have for values,
+// with no custom bounds.
+template <typename T>
+void SummarizeValues(const Tensor& values, Tensor* summary) {
+  int64 element_count = 0;
+  int64 counts[6] = {0};  // nan, -inf, negative, zero, positive, +inf.
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double mean = std::numeric_limits<double>::quiet_NaN();
+  double variance = std::numeric_limits<double>::quiet_NaN();
+
+  if (values.IsInitialized()) {
+    auto flat = values.flat<T>();
+    element_count = flat.size();
+    int64 finite_count = 0;
+    double sum = 0.0;
+    for (int64 i = 0; i < element_count; ++i) {
+      const double x = static_cast<double>(flat(i));
+      if (Eigen::numext::isnan(x)) {
+        counts[0]++;
+      } else if (Eigen::numext::isinf(x)) {
+        counts[x < 0.0 ? 1 : 5]++;
+      } else {
+        counts[x < 0.0 ? 2 : (x > 0.0 ? 4 : 3)]++;
+        min = std::min(min, x);
+        max = std::max(max, x);
+        sum += x;
+        finite_count++;
+      }
+    }
+    if (finite_count > 0) {
+      mean = sum / finite_count;
+      variance = 0.0;
+      for (int64 i = 0; i < element_count; ++i) {
+        const double x = static_cast<double>(flat(i));
+        if (!Eigen::numext::isnan(x) && !Eigen::numext::isinf(x)) {
+          variance += (x - mean) * (x - mean);
+        }
+      }
+      variance /= finite_count;
+    }
+  }
+
+  *summary = Tensor(DT_DOUBLE, TensorShape({12}));
+  auto out = summary->vec<double>();
+  out(0) = values.IsInitialized() ? 1.0 : 0.0;
+  out(1) = static_cast<double>(element_count);
+  for (int i = 0; i < 6; ++i) {
+    out(2 + i) = static_cast<double>(counts[i]);
+  }
+  out(8) = min;
+  out(9) = max;
+  out(10) = mean;
+  out(11) = variance;
+}
+
+// Returns false if tensor is not of a type DebugNumericSummary supports.
+bool SummarizeTensor(const Tensor& tensor, Tensor* summary) {
+  switch (tensor.dtype()) {
+#define CASE(T)                          \
+  case DataTypeToEnum<T>::value:         \
+    SummarizeValues<T>(tensor, summary); \
+    return true;
+    TF_CALL_bool(CASE);
+    TF_CALL_INTEGRAL_TYPES(CASE);
+    TF_CALL_float(CASE);
+    TF_CALL_double(CASE);
+#undef CASE
+    default:
+      return false;
+  }
+}
+
+// The publishers of the debug URLs that do not have the default options.
+struct DebugURLPublishers {
+  mutex mu;
+  std::unordered_map<string, std::shared_ptr<DebugURLPublisher>> publishers
+      GUARDED_BY(mu);
+};
+
+DebugURLPublishers* GetDebugURLPublishers() {
+  static DebugURLPublishers* publishers = new DebugURLPublishers;
+  return publishers;
+}
+
 }  // namespace
 
+DebugURLPublisher::DebugURLPublisher(const string& debug_url,
+                                     const DebugPublishOptions& options)
+    : debug_url_(debug_url),
+      options_(options),
+      max_queued_bytes_(options.max_queued_bytes() > 0
+                            ? options.max_queued_bytes()
+                            : 64LL << 20) {
+  if (options_.asynchronous()) {
+    thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "tf_debug_publisher", [this]() { IOLoop(); }));
+  }
+}
+
+DebugURLPublisher::~DebugURLPublisher() {
+  {
+    mutex_lock l(mu_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  // Joins the I/O thread, which drains the queue first.
+  thread_.reset();
+}
+
+bool DebugURLPublisher::AdmitTensor(int64 num_bytes) {
+  if (options_.max_tensor_bytes() > 0 &&
+      num_bytes > options_.max_tensor_bytes()) {
+    return false;
+  }
+  mutex_lock l(mu_);
+  if (options_.max_bytes_per_run() > 0 &&
+      run_bytes_ + num_bytes > options_.max_bytes_per_run()) {
+    return false;
+  }
+  // Concurrent debug ops may overshoot this bound by the tensors they admit
+  // before scheduling them.
+  if (thread_ != nullptr && pending_bytes_ + num_bytes > max_queued_bytes_) {
+    return false;
+  }
+  run_bytes_ += num_bytes;
+  return true;
+}
+
+Status DebugURLPublisher::Schedule(std::function<Status()> publish,
+                                   int64 num_bytes) {
+  if (thread_ == nullptr) {
+    return publish();
+  }
+  {
+    mutex_lock l(mu_);
+    queue_.emplace_back(std::move(publish), num_bytes);
+    ++num_pending_;
+    pending_bytes_ += num_bytes;
+  }
+  work_cv_.notify_one();
+  return Status::OK();
+}
+
+void DebugURLPublisher::EndRun() {
+  mutex_lock l(mu_);
+  run_bytes_ = 0;
+}
+
+Status DebugURLPublisher::Flush() {
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) {
+    done_cv_.wait(l);
+  }
+  Status s = status_;
+  status_ = Status::OK();
+  return s;
+}
+
+void DebugURLPublisher::IOLoop() {
+  while (true) {
+    std::pair<std::function<Status()>, int64> item;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !stop_) {
+        work_cv_.wait(l);
+      }
+      if (queue_.empty()) {
+        return;
+      }
+      item = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    const Status s = item.first();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to publish debug data to " << debug_url_
+                 << " asynchronously, due to: " << s.error_message();
+    }
+    // Release the tensor before the bytes it holds.
+    item.first = nullptr;
+
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+      --num_pending_;
+      pending_bytes_ -= item.second;
+    }
+    done_cv_.notify_all();
+  }
+}
+
 Status ReadEventFromFile(const string& dump_file_path, Event* event) {
   Env* env(Env::Default());
 
@@ -236,33 +439,55 @@ Status DebugIO::PublishDebugTensor(const string& tensor_name,
   int num_failed_urls = 0;
   std::vector<Status> fail_statuses;
   for (const string& url : debug_urls) {
-    if (str_util::Lowercase(url).find(kFileURLScheme) == 0) {
-      const string dump_root_dir = url.substr(strlen(kFileURLScheme));
-
-      Status s =
-          DebugFileIO::DumpTensorToDir(node_name, output_slot, debug_op, tensor,
-                                       wall_time_us, dump_root_dir, nullptr);
-      if (!s.ok()) {
-        num_failed_urls++;
-        fail_statuses.push_back(s);
-      }
-    } else if (str_util::Lowercase(url).find(kGrpcURLScheme) == 0) {
-#if defined(PLATFORM_GOOGLE)
-      Status s = DebugGrpcIO::SendTensorThroughGrpcStream(
-          node_name, output_slot, debug_op, tensor, wall_time_us, url,
-          gated_grpc);
-
-      if (!s.ok()) {
-        num_failed_urls++;
-        fail_statuses.push_back(s);
-      }
-#else
+    if (str_util::Lowercase(url).find(kGrpcURLScheme) == 0) {
+#if !defined(PLATFORM_GOOGLE)
       GRPC_OSS_UNIMPLEMENTED_ERROR;
 #endif
-    } else {
+    } else if (str_util::Lowercase(url).find(kFileURLScheme) != 0) {
       return Status(error::UNAVAILABLE,
                     strings::StrCat("Invalid debug target URL: ", url));
     }
+
+    Status s;
+    std::shared_ptr<DebugURLPublisher> publisher = GetPublisher(url);
+    if (publisher == nullptr) {
+      s = PublishDebugTensorToURL(node_name, output_slot, debug_op, tensor,
+                                  wall_time_us, url, gated_grpc);
+    } else {
+      // Gate on the watch key of debug_op even if a summary is published.
+      if (gated_grpc &&
+          !IsDebugURLGateOpen(strings::StrCat(tensor_name, ":", debug_op),
+                              url)) {
+        continue;
+      }
+
+      Tensor published = tensor;
+      string published_debug_op = debug_op;
+      if (publisher->AdmitTensor(tensor.TotalBytes())) {
+        published_tensors->GetCell("full")->IncrementBy(1);
+      } else if (debug_op != kSummaryDebugOp &&
+                 SummarizeTensor(tensor, &published)) {
+        published_tensors->GetCell("summary")->IncrementBy(1);
+        published_debug_op = kSummaryDebugOp;
+      } else {
+        published_tensors->GetCell("dropped")->IncrementBy(1);
+        continue;
+      }
+
+      s = publisher->Schedule(
+          [node_name, output_slot, published_debug_op, published,
+           wall_time_us, url]() {
+            return PublishDebugTensorToURL(node_name, output_slot,
+                                           published_debug_op, published,
+                                           wall_time_us, url, false);
+          },
+          published.TotalBytes());
+    }
+
+    if (!s.ok()) {
+      num_failed_urls++;
+      fail_statuses.push_back(s);
+    }
   }
 
   if (num_failed_urls == 0) {
@@ -280,6 +505,27 @@ Status DebugIO::PublishDebugTensor(const string& tensor_name,
   }
 }
 
+// static
+Status DebugIO::PublishDebugTensorToURL(
+    const string& node_name, const int32 output_slot, const string& debug_op,
+    const Tensor& tensor, const uint64 wall_time_us, const string& debug_url,
+    const bool gated_grpc) {
+  if (str_util::Lowercase(debug_url).find(kFileURLScheme) == 0) {
+    const string dump_root_dir = debug_url.substr(strlen(kFileURLScheme));
+    return DebugFileIO::DumpTensorToDir(node_name, output_slot, debug_op,
+                                        tensor, wall_time_us, dump_root_dir,
+                                        nullptr);
+  }
+#if defined(PLATFORM_GOOGLE)
+  return DebugGrpcIO::SendTensorThroughGrpcStream(node_name, output_slot,
+                                                  debug_op, tensor,
+                                                  wall_time_us, debug_url,
+                                                  gated_grpc);
+#else
+  GRPC_OSS_UNIMPLEMENTED_ERROR;
+#endif
+}
+
 // static
 Status DebugIO::PublishDebugTensor(const string& tensor_name,
                                    const string& debug_op, const Tensor& tensor,
@@ -305,6 +551,12 @@ Status DebugIO::PublishGraph(const Graph& graph,
 
   Status status = Status::OK();
   for (const string& debug_url : debug_urls) {
+    // Publish the graph after the tensors of the previous runs.
+    std::shared_ptr<DebugURLPublisher> publisher = GetPublisher(debug_url);
+    if (publisher != nullptr) {
+      status.Update(publisher->Flush());
+    }
+
     if (debug_url.find(kFileURLScheme) == 0) {
       const string dump_root_dir = debug_url.substr(strlen(kFileURLScheme));
       const string file_name = strings::StrCat("_tfdbg_graph_", now_micros);
@@ -380,6 +632,64 @@ bool DebugIO::IsDebugURLGateOpen(const string& watch_key,
 
 // static
 Status DebugIO::CloseDebugURL(const string& debug_url) {
+  std::shared_ptr<DebugURLPublisher> publisher = GetPublisher(debug_url);
+  if (publisher == nullptr) {
+    return CloseDebugURLNow(debug_url);
+  }
+  publisher->EndRun();
+  return publisher->Schedule(
+      [debug_url]() { return CloseDebugURLNow(debug_url); }, 0);
+}
+
+// static
+Status DebugIO::ConfigureDebugURL(const string& debug_url,
+                                  const DebugPublishOptions& options) {
+  const bool has_default_options = !options.asynchronous() &&
+                                   options.max_bytes_per_run() == 0 &&
+                                   options.max_tensor_bytes() == 0;
+
+  std::shared_ptr<DebugURLPublisher> publisher;
+  std::shared_ptr<DebugURLPublisher> old_publisher;
+  DebugURLPublishers* publishers = GetDebugURLPublishers();
+  {
+    mutex_lock l(publishers->mu);
+    auto it = publishers->publishers.find(debug_url);
+    if (it != publishers->publishers.end()) {
+      if (!has_default_options && it->second->options().SerializeAsString() ==
+                                      options.SerializeAsString()) {
+        publisher = it->second;
+      } else {
+        old_publisher = it->second;
+        publishers->publishers.erase(it);
+      }
+    }
+    if (publisher == nullptr && !has_default_options) {
+      publisher.reset(new DebugURLPublisher(debug_url, options));
+      publishers->publishers[debug_url] = publisher;
+    }
+  }
+
+  Status s;
+  if (old_publisher != nullptr) {
+    s.Update(old_publisher->Flush());
+  }
+  if (publisher != nullptr) {
+    s.Update(publisher->Flush());
+  }
+  return s;
+}
+
+// static
+std::shared_ptr<DebugURLPublisher> DebugIO::GetPublisher(
+    const string& debug_url) {
+  DebugURLPublishers* publishers = GetDebugURLPublishers();
+  mutex_lock l(publishers->mu);
+  auto it = publishers->publishers.find(debug_url);
+  return it == publishers->publishers.end() ? nullptr : it->second;
+}
+
+// static
+Status DebugIO::CloseDebugURLNow(const string& debug_url) {
   if (debug_url.find(DebugIO::kGrpcURLScheme) == 0) {
 #if defined(PLATFORM_GOOGLE)
     return DebugGrpcIO::CloseGrpcStream(debug_url);
@@ -16,14 +16,22 @@ limitations under the License.
 #ifndef TENSORFLOW_DEBUG_IO_UTILS_H_
 #define TENSORFLOW_DEBUG_IO_UTILS_H_
 
+#include <deque>
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/debug.pb.h"
 #include "tensorflow/core/util/event.pb.h"
 
 namespace tensorflow {
@@ -40,6 +48,64 @@ struct DebugWatchAndURLSpec {
   const bool gated_grpc;
 };
 
+// Publishes the debug data of one debug URL under the bounds of a
+// DebugPublishOptions, from a dedicated I/O thread if the options ask for
+// asynchronous publishing.
+class DebugURLPublisher {
+ public:
+  DebugURLPublisher(const string& debug_url,
+                    const DebugPublishOptions& options);
+
+  // Waits for everything scheduled to be published.
+  ~DebugURLPublisher();
+
+  const DebugPublishOptions& options() const { return options_; }
+
+  // Returns whether a tensor of num_bytes bytes may be published in full
+  // given the bounds of the options, and if so charges it to the budget of
+  // the current run.
+  bool AdmitTensor(int64 num_bytes);
+
+  // Calls publish, inline if the publishing is synchronous and on the I/O
+  // thread otherwise. num_bytes is the amount of tensor data publish holds
+  // on to until it has run.
+  //
+  // Returns the status of publish if it ran inline, and OK otherwise: the
+  // errors of asynchronous publishing are logged, and returned by Flush().
+  Status Schedule(std::function<Status()> publish, int64 num_bytes);
+
+  // Resets the budget of the current run.
+  void EndRun();
+
+  // Waits until everything scheduled has been published. Returns the errors
+  // of the asynchronous publishing since the last call.
+  Status Flush();
+
+ private:
+  void IOLoop();
+
+  const string debug_url_;
+  const DebugPublishOptions options_;
+  const int64 max_queued_bytes_;
+
+  mutex mu_;
+  condition_variable work_cv_;
+  condition_variable done_cv_;
+  // The functions to publish, and their numbers of bytes.
+  std::deque<std::pair<std::function<Status()>, int64>> queue_
+      GUARDED_BY(mu_);
+  // Including the item being published.
+  int64 num_pending_ GUARDED_BY(mu_) = 0;
+  int64 pending_bytes_ GUARDED_BY(mu_) = 0;
+  int64 run_bytes_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+  bool stop_ GUARDED_BY(mu_) = false;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DebugURLPublisher);
+};
+
 class DebugIO {
  public:
   static Status PublishDebugMetadata(
@@ -127,10 +193,36 @@ class DebugIO {
   static bool IsDebugURLGateOpen(const string& watch_key,
                                  const string& debug_url);
 
+  // Ends the publishing of a Session::Run() to a debug URL. For grpc://
+  // URLs, closes the stream after everything the run published to it.
   static Status CloseDebugURL(const string& debug_url);
 
+  // Sets the options for publishing to a debug URL, which apply until the
+  // next call for the same URL. First waits for everything published
+  // asynchronously to the URL, and returns the errors of doing so.
+  //
+  // Tensors that are not published in full because of the bounds of the
+  // options are published as the output of DebugNumericSummary on them
+  // instead (under the watch key <tensor_name>:DebugNumericSummary), or
+  // dropped if DebugNumericSummary does not support their type.
+  static Status ConfigureDebugURL(const string& debug_url,
+                                  const DebugPublishOptions& options);
+
   static const char* const kFileURLScheme;
   static const char* const kGrpcURLScheme;
+
+ private:
+  // Returns the publisher of debug_url, or nullptr if debug_url has the
+  // default options.
+  static std::shared_ptr<DebugURLPublisher> GetPublisher(
+      const string& debug_url);
+
+  static Status PublishDebugTensorToURL(
+      const string& node_name, const int32 output_slot, const string& debug_op,
+      const Tensor& tensor, const uint64 wall_time_us, const string& debug_url,
+      const bool gated_grpc);
+
+  static Status CloseDebugURLNow(const string& debug_url);
 };
 
 // Helper class for debug ops.
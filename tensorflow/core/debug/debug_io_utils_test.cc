@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/event.pb.h"
@@ -353,5 +354,99 @@ TEST_F(DebugIOUtilsTest, PublishTensorConcurrentlyToPartiallyOverlappingPaths) {
   }
 }
 
+TEST_F(DebugIOUtilsTest, PublishTensorsOverMaxTensorBytesAsSummaries) {
+  Initialize();
+
+  const string dump_root = io::JoinPath(testing::TmpDir(), "max_tensor_bytes");
+  const string debug_url = strings::StrCat("file://", dump_root);
+  const std::vector<string> urls({debug_url});
+  const uint64 wall_time = env_->NowMicros();
+  const string full_path = DebugFileIO::GetDumpFilePath(
+      dump_root, "tensor_a", 0, "DebugIdentity", wall_time);
+  const string summary_path = DebugFileIO::GetDumpFilePath(
+      dump_root, "tensor_a", 0, "DebugNumericSummary", wall_time);
+  const string string_summary_path = DebugFileIO::GetDumpFilePath(
+      dump_root, "tensor_b", 0, "DebugNumericSummary", wall_time);
+
+  DebugPublishOptions options;
+  options.set_max_tensor_bytes(8);
+  TF_ASSERT_OK(DebugIO::ConfigureDebugURL(debug_url, options));
+
+  // tensor_a_ holds 16 bytes: only its summary is published.
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor("tensor_a:0", "DebugIdentity",
+                                           *tensor_a_, wall_time, urls));
+  EXPECT_FALSE(env_->FileExists(full_path).ok());
+  Event event;
+  TF_ASSERT_OK(ReadEventFromFile(summary_path, &event));
+  ASSERT_EQ(1, event.summary().value().size());
+  EXPECT_EQ("tensor_a:0:DebugNumericSummary",
+            event.summary().value(0).node_name());
+  Tensor summary(DT_DOUBLE);
+  ASSERT_TRUE(summary.FromProto(event.summary().value(0).tensor()));
+  test::ExpectTensorEqual<double>(
+      test::AsTensor<double>({1.0, 4.0, 0.0, 0.0, 1.0, 1.0, 2.0, 0.0, -1.0,
+                              5.0, 1.75, 5.6875}),
+      summary);
+
+  // DebugNumericSummary does not support strings: tensor_b_ is dropped.
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor("tensor_b:0", "DebugIdentity",
+                                           *tensor_b_, wall_time, urls));
+  EXPECT_FALSE(env_->FileExists(string_summary_path).ok());
+
+  TF_ASSERT_OK(DebugIO::ConfigureDebugURL(debug_url, DebugPublishOptions()));
+  int64 undeleted_files = 0;
+  int64 undeleted_dirs = 0;
+  TF_ASSERT_OK(
+      env_->DeleteRecursively(dump_root, &undeleted_files, &undeleted_dirs));
+}
+
+TEST_F(DebugIOUtilsTest, PublishTensorsAsynchronouslyWithinRunBudget) {
+  Initialize();
+
+  const string dump_root = io::JoinPath(testing::TmpDir(), "asynchronous");
+  const string debug_url = strings::StrCat("file://", dump_root);
+  const std::vector<string> urls({debug_url});
+  const uint64 wall_time = env_->NowMicros();
+  std::vector<string> full_paths;
+  std::vector<string> summary_paths;
+  for (int slot = 0; slot < 3; ++slot) {
+    full_paths.push_back(DebugFileIO::GetDumpFilePath(
+        dump_root, "tensor_a", slot, "DebugIdentity", wall_time));
+    summary_paths.push_back(DebugFileIO::GetDumpFilePath(
+        dump_root, "tensor_a", slot, "DebugNumericSummary", wall_time));
+  }
+
+  DebugPublishOptions options;
+  options.set_asynchronous(true);
+  options.set_max_bytes_per_run(16);
+  TF_ASSERT_OK(DebugIO::ConfigureDebugURL(debug_url, options));
+
+  // The first run has budget for one of the two tensors.
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor("tensor_a:0", "DebugIdentity",
+                                           *tensor_a_, wall_time, urls));
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor("tensor_a:1", "DebugIdentity",
+                                           *tensor_a_, wall_time, urls));
+  TF_ASSERT_OK(DebugIO::CloseDebugURL(debug_url));
+
+  // The next run waits for the tensors of the first one, and has its own
+  // budget.
+  TF_ASSERT_OK(DebugIO::ConfigureDebugURL(debug_url, options));
+  TF_EXPECT_OK(env_->FileExists(full_paths[0]));
+  EXPECT_FALSE(env_->FileExists(summary_paths[0]).ok());
+  EXPECT_FALSE(env_->FileExists(full_paths[1]).ok());
+  TF_EXPECT_OK(env_->FileExists(summary_paths[1]));
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor("tensor_a:2", "DebugIdentity",
+                                           *tensor_a_, wall_time, urls));
+  TF_ASSERT_OK(DebugIO::CloseDebugURL(debug_url));
+
+  TF_ASSERT_OK(DebugIO::ConfigureDebugURL(debug_url, DebugPublishOptions()));
+  TF_EXPECT_OK(env_->FileExists(full_paths[2]));
+
+  int64 undeleted_files = 0;
+  int64 undeleted_dirs = 0;
+  TF_ASSERT_OK(
+      env_->DeleteRecursively(dump_root, &undeleted_files, &undeleted_dirs));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -27,6 +27,15 @@ DebuggerState::DebuggerState(const DebugOptions& debug_options) {
       debug_urls_.insert(url);
     }
   }
+
+  for (const string& debug_url : debug_urls_) {
+    Status s = DebugIO::ConfigureDebugURL(debug_url,
+                                          debug_options.publish_options());
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to publish the debug data of previous runs to "
+                 << debug_url << ", due to: " << s.error_message();
+    }
+  }
 }
 
 DebuggerState::~DebuggerState() {
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
@@ -35,6 +36,36 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+auto* sent_tensor_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rendezvous/sent_tensor_bytes",
+    "The number of bytes of the tensors that this worker sent to other "
+    "workers, by the node that produced them.",
+    "node");
+auto* received_tensor_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rendezvous/received_tensor_bytes",
+    "The number of bytes of the tensors that this worker received from "
+    "other workers, by the node that produced them.",
+    "node");
+
+// Returns the name of the node that produced the tensor of "parsed", whose
+// edge name is "edge_<id>_<node>" for the edges that the graph partitioner
+// adds.
+string ProducerName(const Rendezvous::ParsedKey& parsed) {
+  StringPiece name = parsed.edge_name;
+  if (name.Consume("edge_")) {
+    const size_t pos = name.find('_');
+    if (pos != StringPiece::npos) {
+      name.remove_prefix(pos + 1);
+      return name.ToString();
+    }
+  }
+  return parsed.edge_name.ToString();
+}
+
+}  // namespace
+
 BaseRendezvousMgr::BaseRendezvousMgr(const WorkerEnv* worker_env,
                                      const string& worker_name)
     : worker_env_(worker_env), worker_name_(worker_name) {}
@@ -98,6 +129,15 @@ Status BaseRendezvousMgr::RecvLocal(int64 step_id,
   return ret;
 }
 
+Status BaseRendezvousMgr::AcceptPushedTensor(
+    int64 step_id, const Rendezvous::ParsedKey& parsed, const Tensor& val,
+    bool is_dead) {
+  BaseRemoteRendezvous* rendez = FindOrCreate(step_id);
+  Status s = rendez->AcceptPushedTensor(parsed, val, is_dead);
+  rendez->Unref();
+  return s;
+}
+
 void BaseRendezvousMgr::Cleanup(int64 step_id) {
   Rendezvous* rendez = nullptr;
   {
@@ -285,7 +325,101 @@ void BaseRemoteRendezvous::RecvLocalAsync(const ParsedKey& parsed,
     done(s, Args(), Args(), Tensor(), false);
     return;
   }
-  local_->RecvAsync(parsed, Args(), std::move(done));
+  local_->RecvAsync(
+      parsed, Args(),
+      [parsed, done](const Status& s, const Rendezvous::Args& send_args,
+                     const Rendezvous::Args& recv_args, const Tensor& val,
+                     bool is_dead) {
+        if (s.ok() && !is_dead) {
+          RecordSentTensor(parsed, val);
+        }
+        done(s, send_args, recv_args, val, is_dead);
+      });
+}
+
+Status BaseRemoteRendezvous::AcceptPushedTensor(const ParsedKey& parsed,
+                                                const Tensor& val,
+                                                bool is_dead) {
+  VLOG(1) << "RemoteRendezvous AcceptPushedTensor " << this << " "
+          << parsed.FullKey();
+  TF_RETURN_IF_ERROR(ValidateDevices(parsed, false /*!is_src*/));
+  if (!is_dead) {
+    RecordReceivedTensor(parsed, val);
+  }
+  // The pushed tensor is in host memory.
+  Rendezvous::Args args;
+  args.alloc_attrs.set_on_host(true);
+  return local_->Send(parsed, args, val, is_dead);
+}
+
+void BaseRemoteRendezvous::RecvPushedAsync(const ParsedKey& parsed,
+                                           const Rendezvous::Args& recv_args,
+                                           DoneCallback done) {
+  local_->RecvAsync(
+      parsed, recv_args,
+      [this, parsed, done](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& in, bool is_dead) {
+        const bool dst_host =
+            (recv_args.alloc_attrs.on_host() || parsed.dst.type == "CPU");
+        if (!status.ok() || is_dead || dst_host) {
+          done(status, send_args, recv_args, in, is_dead);
+          return;
+        }
+        Device* dst_device;
+        Status s =
+            env_->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
+        DeviceContext* dev_context = recv_args.device_context;
+        if (s.ok() && dev_context == nullptr) {
+          if (dst_device->tensorflow_gpu_device_info() == nullptr) {
+            s = errors::Internal("No device context to copy ",
+                                 parsed.FullKey(), " to ", dst_device->name());
+          } else {
+            dev_context =
+                dst_device->tensorflow_gpu_device_info()->default_context;
+          }
+        }
+        if (s.ok() && !DMAHelper::CanUseDMA(&in)) {
+          s = errors::InvalidArgument("Non-DMA-safe ",
+                                      DataTypeString(in.dtype()),
+                                      " tensor may not be copied to a GPU.");
+        }
+        if (!s.ok()) {
+          done(s, send_args, recv_args, Tensor(), false);
+          return;
+        }
+        Allocator* out_allocator =
+            dst_device->GetAllocator(recv_args.alloc_attrs);
+        Tensor* out = new Tensor(out_allocator, in.dtype(), in.shape());
+        if (!out->IsInitialized()) {
+          delete out;
+          done(errors::ResourceExhausted(
+                   "OOM when allocating tensor with shape ",
+                   in.shape().DebugString(), " on ", dst_device->name()),
+               send_args, recv_args, Tensor(), false);
+          return;
+        }
+        Tensor* host = new Tensor(in);
+        dev_context->CopyCPUTensorToDevice(
+            host, dst_device, out,
+            [done, send_args, recv_args, host, out](const Status& s) {
+              done(s, send_args, recv_args, *out, false);
+              delete host;
+              delete out;
+            });
+      });
+}
+
+void BaseRemoteRendezvous::RecordSentTensor(const ParsedKey& parsed,
+                                            const Tensor& val) {
+  sent_tensor_bytes->GetCell(ProducerName(parsed))
+      ->IncrementBy(val.TotalBytes());
+}
+
+void BaseRemoteRendezvous::RecordReceivedTensor(const ParsedKey& parsed,
+                                                const Tensor& val) {
+  received_tensor_bytes->GetCell(ProducerName(parsed))
+      ->IncrementBy(val.TotalBytes());
 }
 
 void BaseRemoteRendezvous::StartAbort(const Status& s) {
@@ -80,6 +80,10 @@ class BaseRendezvousMgr : public RendezvousMgrInterface {
   Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                    Tensor* val, bool* is_dead) override;
 
+  // This method is used by the rpc handler of PushTensor.
+  Status AcceptPushedTensor(int64 step_id, const Rendezvous::ParsedKey& parsed,
+                            const Tensor& val, bool is_dead) override;
+
   // Removes rendezvous for "step_id".
   //
   // TODO(zhifengc): Have a background thread in worker that
@@ -147,11 +151,35 @@ class BaseRemoteRendezvous : public Rendezvous {
   // REQUIRES: "parsed" is one that will be Saved into the local rendezvous.
   void RecvLocalAsync(const ParsedKey& parsed, DoneCallback done);
 
+  // This method is called only by the local Worker, forwarded through
+  // the same method on RendezvousMgr, when a remote worker has pushed the
+  // host tensor "val" for "parsed" to this worker.  Buffers "val" in
+  // local_ for RecvPushedAsync().
+  //
+  // REQUIRES: "parsed"'s destination is in this worker.
+  Status AcceptPushedTensor(const ParsedKey& parsed, const Tensor& val,
+                            bool is_dead);
+
  protected:
   virtual void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
                                    const Rendezvous::Args& args,
                                    DoneCallback done) = 0;
 
+  // Runs "done" with the tensor for "parsed" once the remote producer has
+  // pushed it to this worker, see AcceptPushedTensor().  The tensor is
+  // copied to "parsed"'s destination device unless it is received in host
+  // memory.
+  void RecvPushedAsync(const ParsedKey& parsed, const Rendezvous::Args& args,
+                       DoneCallback done);
+
+  // Adds the bytes of "val", which this worker sent to or received from
+  // another worker, to the transfer metrics of the node that produced it.
+  // Both metrics are labeled with the producer's name, which for the reads
+  // of a variable on a parameter server is the variable (or its "read"
+  // op), so they show which variables load a parameter server the most.
+  static void RecordSentTensor(const ParsedKey& parsed, const Tensor& val);
+  static void RecordReceivedTensor(const ParsedKey& parsed, const Tensor& val);
+
   // Returns true if "src" and "dst" are located in the same worker,
   // and hence may use a local rendezvous.
   virtual bool IsSameWorker(DeviceNameUtils::ParsedName src,
@@ -169,6 +197,11 @@ class BaseRemoteRendezvous : public Rendezvous {
   const string worker_name_;
   const int64 step_id_;
 
+  // If "is_src" is true, checks that the rendezvous key "parsed"'s
+  // source is in this process. If "is_src" is false, checks that the
+  // rendezvous key "parsed"'s destination is in this process.
+  Status ValidateDevices(const Rendezvous::ParsedKey& parsed, bool is_src);
+
  private:
   Rendezvous* local_;  // Owns a Ref on this object.
 
@@ -180,11 +213,6 @@ class BaseRemoteRendezvous : public Rendezvous {
   // Active outstanding RecvTensor calls.
   gtl::FlatSet<BaseRecvTensorCall*> active_ GUARDED_BY(mu_);
 
-  // If "is_src" is true, checks that the rendezvous key "parsed"'s
-  // source is in this process. If "is_src" is false, checks that the
-  // rendezvous key "parsed"'s destination is in this process.
-  Status ValidateDevices(const Rendezvous::ParsedKey& parsed, bool is_src);
-
   // Callback handling the case when a rendezvous has been
   // accomplished in local_ and the consumer is local to this process.
   // Tensor "in" will be copied into "out". The key "parsed" encodes
@@ -56,10 +56,11 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(const Graph* graph) {
+  void Create(const Graph* graph, int num_work_stealing_workers = 0) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_;
+    params.num_work_stealing_workers = num_work_stealing_workers;
     params.create_kernel = [this, version](const NodeDef& ndef,
                                            OpKernel** kernel) {
       return CreateNonCachedKernel(device_, nullptr, ndef, version, kernel);
@@ -242,6 +243,67 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+// Loop-free graphs recycle their per-step state, so run repeatedly with
+// the same executor, including a step that fails halfway.
+TEST_F(ExecutorTest, RepeatedRuns) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(256, g);
+  Create(g);
+  for (int i = 0; i < 8; ++i) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    if (i == 3) {
+      rendez->StartAbort(errors::Aborted(""));
+      EXPECT_TRUE(errors::IsAborted(Run(rendez)));
+      rendez->Unref();
+      continue;
+    }
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(i), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(256.0 * i, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g, thread_pool_->NumThreads());
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, RandomTreeWorkStealingSingleWorker) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(1024, g);
+  Create(g, 1);
+  for (int i = 0; i < 4; ++i) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(1024.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -277,6 +339,23 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildConcurrentAddAssign(g);
+  Create(g, thread_pool_->NumThreads());
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -316,6 +395,49 @@ TEST_F(ExecutorTest, SimpleSwitchDead) {
   EXPECT_TRUE(is_dead);
 }
 
+// A long chain of Identity nodes runs as a single inline chain.
+TEST_F(ExecutorTest, IdentityChain) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* v = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  for (int i = 0; i < 100; ++i) {
+    v = test::graph::Identity(g, v);
+  }
+  test::graph::Send(g, v, "b", BOB, 1, ALICE);
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(3.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_FALSE(is_dead);
+  EXPECT_EQ(3.0, V(out));
+}
+
+// Deadness still propagates through a chain of inexpensive nodes.
+TEST_F(ExecutorTest, IdentityChainDead) {
+  Graph* g = new Graph(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g, VB(true));
+  Node* v = test::graph::Switch(g, in0, in1);
+  for (int i = 0; i < 10; ++i) {
+    v = test::graph::Identity(g, v);
+  }
+  test::graph::Send(g, v, "c", BOB, 1, ALICE);
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
 TEST_F(ExecutorTest, Abort) {
   // e = a + b + c + d
   Graph* g = new Graph(OpRegistry::Global());
@@ -409,4 +531,80 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// Builds a graph of "width" independent chains of "depth" scalar Adds,
+// i.e. many small expensive kernels whose successors become ready one at
+// a time.
+static Graph* ManyChains(int width, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* one = test::graph::Constant(g, V(1.0));
+  for (int i = 0; i < width; ++i) {
+    Node* v = one;
+    for (int j = 0; j < depth; ++j) {
+      v = test::graph::Add(g, v, one);
+    }
+  }
+  return g;
+}
+
+static void BM_executor(int iters, int width, int depth,
+                        bool work_stealing) {
+  testing::StopTiming();
+  SessionOptions options;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_use_work_stealing_executor(work_stealing);
+  test::Benchmark bm("cpu", ManyChains(width, depth), &options);
+  testing::ItemsProcessed(static_cast<int64>(iters) * width * depth);
+  testing::StartTiming();
+  bm.Run(iters);
+}
+
+static void BM_executor_ThreadPool(int iters, int width, int depth) {
+  BM_executor(iters, width, depth, false);
+}
+BENCHMARK(BM_executor_ThreadPool)
+    ->ArgPair(16, 1024)
+    ->ArgPair(256, 16)
+    ->ArgPair(1024, 4);
+
+static void BM_executor_WorkStealing(int iters, int width, int depth) {
+  BM_executor(iters, width, depth, true);
+}
+BENCHMARK(BM_executor_WorkStealing)
+    ->ArgPair(16, 1024)
+    ->ArgPair(256, 16)
+    ->ArgPair(1024, 4);
+
+// Measures a straight-line chain of "length" Identity nodes, which the
+// executor runs inline without per-node frame bookkeeping.
+static void BM_executor_IdentityChain(int iters, int length) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* v = test::graph::Constant(g, V(1.0));
+  for (int i = 0; i < length; ++i) {
+    v = test::graph::Identity(g, v);
+  }
+  test::Benchmark bm("cpu", g);
+  testing::ItemsProcessed(static_cast<int64>(iters) * length);
+  testing::StartTiming();
+  bm.Run(iters);
+}
+BENCHMARK(BM_executor_IdentityChain)->Arg(16)->Arg(1024);
+
+// Measures the fixed per-step overhead of the executor on a loop-free
+// graph of "num_nodes" NoOps, each depending on a single root NoOp.
+static void BM_executor_StepOverhead(int iters, int num_nodes) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* root = test::graph::NoOp(g, {});
+  for (int i = 1; i < num_nodes; ++i) {
+    test::graph::NoOp(g, {root});
+  }
+  test::Benchmark bm("cpu", g);
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+  testing::StartTiming();
+  bm.Run(iters);
+}
+BENCHMARK(BM_executor_StepOverhead)->Arg(10)->Arg(1000)->Arg(100000);
+
 }  // namespace tensorflow
@@ -243,6 +243,12 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
       }
     };
 
+    if (optimizer_opts.use_work_stealing_executor()) {
+      params.num_work_stealing_workers =
+          worker_env_->compute_pool->NumThreads();
+    }
+    params.use_step_arena_for_temps = optimizer_opts.use_step_arena_for_temps();
+
     optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph);
 
     // EXPERIMENTAL: tfdbg inserts debug nodes (i.e., probes) to the graph.
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/master_session.h"
 
+#include <algorithm>
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -38,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -51,6 +54,19 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+auto* master_session_graph_reuses = monitoring::Counter<0>::New(
+    "/tensorflow/core/master_session_graph_reuses",
+    "The number of Run signatures served by the registered graph of "
+    "another signature.");
+
+auto* master_session_graph_evictions = monitoring::Counter<0>::New(
+    "/tensorflow/core/master_session_graph_evictions",
+    "The number of graphs evicted from the MasterSession graph cache.");
+
+}  // namespace
+
 // MasterSession wraps SimpleClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -68,8 +84,12 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
         client_graph_(std::move(cg)),
         session_opts_(session_opts),
         is_partial_(is_partial),
+        cleanup_steps_with_run_graph_(
+            !is_partial &&
+            session_opts.config.rpc_options().cleanup_steps_with_run_graph()),
         debug_opts_(bopts.debug_options),
-        worker_cache_(worker_cache) {
+        worker_cache_(worker_cache),
+        bopts_(bopts) {
     VLOG(1) << "Created ReffedClientGraph for node with "
             << client_graph_->graph.num_node_ids();
 
@@ -79,12 +99,48 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     for (Node* n : execution_state->full_graph()->nodes()) {
       name_to_node_.insert({n->name(), n});
     }
+
+    // Remember which nodes run, for testing if this graph can serve
+    // other signatures. Sends and recvs only carry feeds and fetches.
+    for (const Node* n : client_graph_->graph.nodes()) {
+      if (!n->IsOp() || n->IsSend() || n->IsRecv()) continue;
+      node_names_.insert(n->name());
+      if (n->op_def().is_stateful()) ++num_stateful_nodes_;
+    }
   }
 
   ~ReffedClientGraph() override { DeregisterPartitions(); }
 
   const SimpleClientGraph* client_graph() { return client_graph_.get(); }
 
+  // Returns true if steps of the signature "opts", whose client graph is
+  // "cg", can be run by this graph, returning only the fetches of
+  // "opts". This is the case when both take the same feeds, this graph
+  // computes every fetch of "opts", and the nodes it runs in addition to
+  // those of "cg" have no side effects.
+  bool Subsumes(const BuildGraphOptions& opts,
+                const SimpleClientGraph& cg) const {
+    if (is_partial_ ||
+        !bopts_.debug_options.debug_tensor_watch_opts().empty() ||
+        !opts.debug_options.debug_tensor_watch_opts().empty()) {
+      return false;
+    }
+    if (opts.feed_endpoints != bopts_.feed_endpoints ||
+        !std::includes(bopts_.fetch_endpoints.begin(),
+                       bopts_.fetch_endpoints.end(),
+                       opts.fetch_endpoints.begin(),
+                       opts.fetch_endpoints.end())) {
+      return false;
+    }
+    int num_stateful_nodes = 0;
+    for (const Node* n : cg.graph.nodes()) {
+      if (!n->IsOp() || n->IsSend() || n->IsRecv()) continue;
+      if (node_names_.count(n->name()) == 0) return false;
+      if (n->op_def().is_stateful()) ++num_stateful_nodes;
+    }
+    return num_stateful_nodes == num_stateful_nodes_;
+  }
+
   std::unique_ptr<ProfileHandler> GetProfileHandler(uint64 step,
                                                     int64 execution_count,
                                                     const RunOptions& ropts) {
@@ -175,6 +231,19 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // `done` when all cleanup RPCs have completed.
   void CleanupPartitionsAsync(int64 step_id, StatusCallback done);
 
+  // True if the steps that succeeded are cleaned up with the RunGraph calls
+  // of the next step, see RPCOptions.cleanup_steps_with_run_graph.
+  bool cleanup_steps_with_run_graph() const {
+    return cleanup_steps_with_run_graph_;
+  }
+
+  // Has the workers clean up the states for the step "step_id" when the
+  // next step runs, or when this graph is deregistered.
+  void CleanupPartitionsWithNextStep(int64 step_id) {
+    mutex_lock l(mu_);
+    steps_to_clean_up_.push_back(step_id);
+  }
+
   // Post-processing of any runtime statistics gathered during execution.
   void ProcessStats(int64 step_id, PerStepState* pss,
                     ProfileHandler* ph, const RunOptions& options,
@@ -208,10 +277,17 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const std::unique_ptr<SimpleClientGraph> client_graph_;
   const SessionOptions session_opts_;
   const bool is_partial_;
+  const bool cleanup_steps_with_run_graph_;
   const DebugOptions& debug_opts_;
   WorkerCacheInterface* const worker_cache_;  // Not owned.
   std::unordered_map<StringPiece, Node*, StringPiece::Hasher> name_to_node_;
 
+  // The signature this graph was built for, and the nodes of
+  // client_graph_ other than sends and recvs.
+  const BuildGraphOptions bopts_;
+  std::unordered_set<string> node_names_;
+  int num_stateful_nodes_ = 0;
+
   // Graph partitioned into per-location subgraphs.
   struct Part {
     // Worker name.
@@ -249,6 +325,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // init_result_ remembers the initialization error if any.
   Status init_result_ GUARDED_BY(mu_);
 
+  // The steps to clean up with the RunGraph calls of the next step.
+  std::vector<int64> steps_to_clean_up_ GUARDED_BY(mu_);
+
   std::unique_ptr<StatsPublisherInterface> stats_publisher_;
 
   // Send/Recv nodes that are the result of client-added
@@ -497,6 +576,12 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
       return errors::InvalidArgument("Duplicated feeds: ", req.feed_name(i));
     }
   }
+  std::unordered_set<StringPiece, StringPiece::Hasher> fetches(3);
+  if (!is_partial_) {
+    for (size_t i = 0; i < req.num_fetches(); ++i) {
+      fetches.insert(req.fetch_name(i));
+    }
+  }
 
   // Prepares a number of calls to workers. One call per partition.
 
@@ -574,17 +659,30 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
         TF_RETURN_IF_ERROR(
             c->req->AddSendFromRunStepRequest(req, feed_index, key));
       }
+      // This graph may also serve signatures that fetch only some of its
+      // outputs (see Subsumes()), so only the requested ones are received.
       for (const auto& key_fetch : part.key_fetch) {
+        if (fetches.count(key_fetch.second) == 0) continue;
         const string& key = key_fetch.first;
         c->req->add_recv_key(key);
       }
     }
   }
 
+  // The earlier steps to clean up are passed along with this step.
+  std::vector<int64> cleanup_step_ids;
+  if (cleanup_steps_with_run_graph_) {
+    mutex_lock l(mu_);
+    cleanup_step_ids.swap(steps_to_clean_up_);
+  }
+
   // Issues RunGraph calls.
   for (int i = 0; i < num; ++i) {
     const Part& part = partitions_[i];
     RunManyGraphs::Call* call = calls.get(i);
+    for (const int64 cleanup_step_id : cleanup_step_ids) {
+      call->req->add_cleanup_step_id(cleanup_step_id);
+    }
     TRACEPRINTF("Partition %d %s", i, part.name.c_str());
     part.worker->RunGraphAsync(
         &call->opts, call->req.get(), call->resp.get(),
@@ -601,6 +699,14 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
   }
   calls.Wait();
   call_opts->ClearCancelCallback();
+  if (!cleanup_step_ids.empty() && (!success || !calls.status().ok())) {
+    // Some workers may not have received the steps to clean up. Cleaning up
+    // a step twice is harmless, so they are all passed again.
+    mutex_lock l(mu_);
+    steps_to_clean_up_.insert(steps_to_clean_up_.end(),
+                              cleanup_step_ids.begin(),
+                              cleanup_step_ids.end());
+  }
   if (success) {
     cm->DeregisterCallback(token);
   } else {
@@ -861,30 +967,61 @@ Status MasterSession::ReffedClientGraph::CheckFetches(
 
 // Asynchronously deregisters subgraphs on the workers, without waiting for the
 // result.
+//
+// The steps that are still to be cleaned up with the next step are cleaned
+// up with CleanupGraph calls, and each worker is released once all of its
+// calls are done.
 void MasterSession::ReffedClientGraph::DeregisterPartitions() {
   struct Call {
     DeregisterGraphRequest req;
     DeregisterGraphResponse resp;
+    std::vector<CleanupGraphRequest> cleanup_reqs;
+    std::vector<CleanupGraphResponse> cleanup_resps;
+    std::atomic<int> num_pending{0};
   };
+  std::vector<int64> cleanup_step_ids;
+  {
+    mutex_lock l(mu_);
+    cleanup_step_ids.swap(steps_to_clean_up_);
+  }
   for (Part& part : partitions_) {
     // The graph handle may be empty if we failed during partition registration.
     if (!part.graph_handle.empty()) {
       Call* c = new Call;
       c->req.set_graph_handle(part.graph_handle);
+      c->cleanup_reqs.resize(cleanup_step_ids.size());
+      c->cleanup_resps.resize(cleanup_step_ids.size());
+      c->num_pending = 1 + cleanup_step_ids.size();
       // NOTE(mrry): We must capture `worker_cache_` since `this`
       // could be deleted before the callback is called.
       WorkerCacheInterface* worker_cache = worker_cache_;
       const string name = part.name;
       WorkerInterface* w = part.worker;
       CHECK_NOTNULL(w);
-      auto cb = [worker_cache, c, name, w](const Status& s) {
+      auto call_done = [worker_cache, c, name, w]() {
+        if (--c->num_pending == 0) {
+          delete c;
+          worker_cache->ReleaseWorker(name, w);
+        }
+      };
+      for (size_t i = 0; i < cleanup_step_ids.size(); ++i) {
+        c->cleanup_reqs[i].set_step_id(cleanup_step_ids[i]);
+        w->CleanupGraphAsync(&c->cleanup_reqs[i], &c->cleanup_resps[i],
+                             [call_done](const Status& s) {
+                               if (!s.ok()) {
+                                 LOG(ERROR) << "Cleanup partition error: "
+                                            << s;
+                               }
+                               call_done();
+                             });
+      }
+      auto cb = [call_done](const Status& s) {
         if (!s.ok()) {
           // This error is potentially benign, so we don't log at the
           // error level.
           LOG(INFO) << "DeregisterGraph error: " << s;
         }
-        delete c;
-        worker_cache->ReleaseWorker(name, w);
+        call_done();
       };
       w->DeregisterGraphAsync(&c->req, &c->resp, cb);
     }
@@ -1062,7 +1199,7 @@ Status MasterSession::Extend(const ExtendSessionRequest* req,
 Status MasterSession::StartStep(const BuildGraphOptions& opts, int64* count,
                                 ReffedClientGraph** rcg, bool is_partial) {
   const uint64 hash = HashBuildGraphOptions(opts);
-  ReffedClientGraph* to_unref = nullptr;
+  std::vector<ReffedClientGraph*> to_unref;
   {
     mutex_lock l(mu_);
     // Keep track of how many times this subgraph has been executed in
@@ -1082,21 +1219,65 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, int64* count,
               << "\n";
       std::unique_ptr<SimpleClientGraph> client_graph;
       TF_RETURN_IF_ERROR(execution_state_->BuildGraph(opts, &client_graph));
-      auto entry = new ReffedClientGraph(
-          handle_, opts, std::move(client_graph), session_opts_,
-          stats_publisher_factory_, execution_state_.get(), is_partial,
-          env_->worker_cache);
+      ReffedClientGraph* entry = nullptr;
+      if (!is_partial) {
+        // Reuses the partitions of a graph that can run this signature
+        // too, which saves partitioning and registering a new graph.
+        for (const auto& p : run_graphs_) {
+          if (p.second->Subsumes(opts, *client_graph)) {
+            entry = p.second;
+            entry->Ref();
+            master_session_graph_reuses->GetCell()->IncrementBy(1);
+            VLOG(1) << "Reusing the graph of hash " << p.first;
+            break;
+          }
+        }
+      }
+      if (entry == nullptr) {
+        entry = new ReffedClientGraph(
+            handle_, opts, std::move(client_graph), session_opts_,
+            stats_publisher_factory_, execution_state_.get(), is_partial,
+            env_->worker_cache);
+      }
 
       iter = m->insert({hash, entry}).first;
+      if (!is_partial) EvictRunGraphs(hash, &to_unref);
       VLOG(1) << "Preparing to execute new graph";
     }
+    if (!is_partial) run_graphs_last_use_[hash] = ++run_graphs_clock_;
     *rcg = iter->second;
     (*rcg)->Ref();
   }
-  if (to_unref) to_unref->Unref();
+  for (ReffedClientGraph* r : to_unref) r->Unref();
   return Status::OK();
 }
 
+void MasterSession::EvictRunGraphs(uint64 keep,
+                                   std::vector<ReffedClientGraph*>* to_unref) {
+  const int32 limit =
+      session_opts_.config.graph_options().max_cached_graphs();
+  if (limit <= 0) return;
+  while (run_graphs_.size() > static_cast<size_t>(limit)) {
+    auto victim = run_graphs_.end();
+    uint64 oldest = ~0ull;
+    for (auto iter = run_graphs_.begin(); iter != run_graphs_.end(); ++iter) {
+      if (iter->first == keep) continue;
+      const uint64 last_use = run_graphs_last_use_[iter->first];
+      if (last_use < oldest) {
+        oldest = last_use;
+        victim = iter;
+      }
+    }
+    if (victim == run_graphs_.end()) break;
+    VLOG(1) << "Evicting the graph of hash " << victim->first;
+    // The graph is deregistered once running steps release it.
+    to_unref->push_back(victim->second);
+    run_graphs_last_use_.erase(victim->first);
+    run_graphs_.erase(victim);
+    master_session_graph_evictions->GetCell()->IncrementBy(1);
+  }
+}
+
 void MasterSession::ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                                    RCGMap* rcg_map) {
   VLOG(1) << "Discarding all reffed graphs";
@@ -1436,6 +1617,10 @@ Status MasterSession::DoRunWithLocalExecution(
       }
     }
   }
+  if (s.ok() && rcg->cleanup_steps_with_run_graph()) {
+    rcg->CleanupPartitionsWithNextStep(step_id);
+    return s;
+  }
   rcg->Ref();
   rcg->CleanupPartitionsAsync(step_id, [rcg](const Status& s) {
     if (!s.ok()) {
@@ -1460,6 +1645,7 @@ Status MasterSession::Close() {
     }
     ClearRunsTable(&to_unref, &run_graphs_);
     ClearRunsTable(&to_unref, &partial_run_graphs_);
+    run_graphs_last_use_.clear();
   }
   for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   return Status::OK();
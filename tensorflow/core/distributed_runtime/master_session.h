@@ -124,12 +124,18 @@ class MasterSession : public core::RefCounted {
   // ReffedClientGraph the can execute it.  We keep up to one old copy
   // of each ReffedClientGraph around because if it gets deallocated
   // before a new substitute has been created, Variables can go out of
-  // scope and lose their state.
+  // scope and lose their state. Several signatures may share one
+  // ReffedClientGraph, when it can also run the steps of the others.
   class ReffedClientGraph;
   typedef std::unordered_map<uint64, ReffedClientGraph*> RCGMap;
   RCGMap run_graphs_ GUARDED_BY(mu_);
   RCGMap partial_run_graphs_ GUARDED_BY(mu_);
 
+  // When each entry of run_graphs_ was last used, as a tick of
+  // run_graphs_clock_, for evicting the least recently used one.
+  std::unordered_map<uint64, uint64> run_graphs_last_use_ GUARDED_BY(mu_);
+  uint64 run_graphs_clock_ GUARDED_BY(mu_) = 0;
+
   struct PerStepState {
     bool collect_costs = false;
     bool collect_timeline = false;
@@ -185,6 +191,10 @@ class MasterSession : public core::RefCounted {
                    ReffedClientGraph** graph, bool is_partial);
   void ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                       RCGMap* rcg_map) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Evicts the least recently used entries of run_graphs_, except
+  // "keep", until at most graph_options.max_cached_graphs remain.
+  void EvictRunGraphs(uint64 keep, std::vector<ReffedClientGraph*>* to_unref)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status DoRunWithLocalExecution(CallOptions* opts,
                                  const RunStepRequestWrapper& req,
                                  MutableRunStepResponseWrapper* resp);
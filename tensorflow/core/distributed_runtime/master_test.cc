@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -61,10 +62,12 @@ class MasterTest : public ::testing::Test {
   // rpc calls.
 
   Status CreateSession(const GraphDef& def, string* handle,
-                            int64* initial_version) {
+                       int64* initial_version,
+                       const ConfigProto& config = ConfigProto()) {
     ::grpc::ClientContext ctx;
     CreateSessionRequest req;
     *(req.mutable_graph_def()) = def;
+    *(req.mutable_config()) = config;
     // Invokes placement frequently.
     req.mutable_config()->set_placement_period(1);
     CreateSessionResponse resp;
@@ -207,6 +210,49 @@ TEST_F(MasterTest, Extend) {
   TF_ASSERT_OK(CloseSession(handle));
 }
 
+TEST_F(MasterTest, SubsetFetchesAndGraphCacheLimit) {
+  Tensor a_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&a_tensor, {1.0, 2.0});
+  Tensor b_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&b_tensor, {10.0, 20.0});
+  Tensor c_expected(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&c_expected, {11.0, 22.0});
+
+  Graph graph(OpRegistry::Global());
+  Node* a_node = test::graph::Constant(&graph, a_tensor, "A");
+  Node* b_node = test::graph::Constant(&graph, b_tensor, "B");
+  Node* c_node = test::graph::Add(&graph, a_node, b_node);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  const string c_name = strings::StrCat(c_node->name(), ":0");
+
+  ConfigProto config;
+  config.mutable_graph_options()->set_max_cached_graphs(2);
+  string handle;
+  int64 initial_version;
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version, config));
+
+  // The first graph also serves the signatures that fetch some of its
+  // outputs, which must only receive the tensors they asked for. Each
+  // signature is run twice, so that evicted graphs are rebuilt.
+  Tensor a, b, c;
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(RunStep(handle, {}, {{"A:0", &a}, {"B:0", &b}, {c_name, &c}}));
+    test::ExpectTensorEqual<float>(a, a_tensor);
+    test::ExpectTensorEqual<float>(b, b_tensor);
+    test::ExpectTensorEqual<float>(c, c_expected);
+    TF_ASSERT_OK(RunStep(handle, {}, {{"A:0", &a}}));
+    test::ExpectTensorEqual<float>(a, a_tensor);
+    TF_ASSERT_OK(RunStep(handle, {}, {{c_name, &c}}));
+    test::ExpectTensorEqual<float>(c, c_expected);
+    TF_ASSERT_OK(RunStep(handle, {}, {{"B:0", &b}, {c_name, &c}}));
+    test::ExpectTensorEqual<float>(b, b_tensor);
+    test::ExpectTensorEqual<float>(c, c_expected);
+  }
+
+  TF_ASSERT_OK(CloseSession(handle));
+}
+
 TEST_F(MasterTest, ExtendUpdateStatefulFails) {
   GraphDef def_0;  // Empty.
   string handle;
@@ -114,29 +114,32 @@ const RunStepRequest& InMemoryRunStepRequest::ToProto() const {
   return *proto_version_;
 }
 
+MutableProtoRunStepRequest::MutableProtoRunStepRequest()
+    : request_(protobuf::Arena::CreateMessage<RunStepRequest>(&arena_)) {}
+
 const string& MutableProtoRunStepRequest::session_handle() const {
-  return request_.session_handle();
+  return request_->session_handle();
 }
 void MutableProtoRunStepRequest::set_session_handle(const string& handle) {
-  request_.set_session_handle(handle);
+  request_->set_session_handle(handle);
 }
 
 const string& MutableProtoRunStepRequest::partial_run_handle() const {
-  return request_.partial_run_handle();
+  return request_->partial_run_handle();
 }
 void MutableProtoRunStepRequest::set_partial_run_handle(const string& handle) {
-  request_.set_partial_run_handle(handle);
+  request_->set_partial_run_handle(handle);
 }
 
 size_t MutableProtoRunStepRequest::num_feeds() const {
-  return request_.feed_size();
+  return request_->feed_size();
 }
 const string& MutableProtoRunStepRequest::feed_name(size_t i) const {
-  return request_.feed(i).name();
+  return request_->feed(i).name();
 }
 Status MutableProtoRunStepRequest::FeedValue(size_t i,
                                              Tensor* out_tensor) const {
-  if (!ParseTensorProtoToTensor(request_.feed(i).tensor(), out_tensor)) {
+  if (!ParseTensorProtoToTensor(request_->feed(i).tensor(), out_tensor)) {
     return errors::InvalidArgument("Invalid TensorProto for feed value ", i);
   } else {
     return Status::OK();
@@ -145,55 +148,55 @@ Status MutableProtoRunStepRequest::FeedValue(size_t i,
 
 Status MutableProtoRunStepRequest::FeedValue(size_t i,
                                              TensorProto* out_tensor) const {
-  *out_tensor = request_.feed(i).tensor();
+  *out_tensor = request_->feed(i).tensor();
   return Status::OK();
 }
 
 void MutableProtoRunStepRequest::add_feed(const string& name,
                                           const Tensor& value) {
-  NamedTensorProto* feed = request_.add_feed();
+  NamedTensorProto* feed = request_->add_feed();
   feed->set_name(name);
   TensorProto* value_proto = feed->mutable_tensor();
   value.AsProtoTensorContent(value_proto);
 }
 
 size_t MutableProtoRunStepRequest::num_fetches() const {
-  return request_.fetch_size();
+  return request_->fetch_size();
 }
 
 const string& MutableProtoRunStepRequest::fetch_name(size_t i) const {
-  return request_.fetch(i);
+  return request_->fetch(i);
 }
 void MutableProtoRunStepRequest::add_fetch(const string& name) {
-  request_.add_fetch(name);
+  request_->add_fetch(name);
 }
 
 size_t MutableProtoRunStepRequest::num_targets() const {
-  return request_.target_size();
+  return request_->target_size();
 }
 
 const string& MutableProtoRunStepRequest::target_name(size_t i) const {
-  return request_.target(i);
+  return request_->target(i);
 }
 
 void MutableProtoRunStepRequest::add_target(const string& name) {
-  request_.add_target(name);
+  request_->add_target(name);
 }
 
 const RunOptions& MutableProtoRunStepRequest::options() const {
-  return request_.options();
+  return request_->options();
 }
 
 RunOptions* MutableProtoRunStepRequest::mutable_options() {
-  return request_.mutable_options();
+  return request_->mutable_options();
 }
 
 string MutableProtoRunStepRequest::DebugString() const {
-  return request_.DebugString();
+  return request_->DebugString();
 }
 
 const RunStepRequest& MutableProtoRunStepRequest::ToProto() const {
-  return request_;
+  return *request_;
 }
 
 ProtoRunStepRequest::ProtoRunStepRequest(const RunStepRequest* request)
@@ -317,6 +320,18 @@ void InMemoryRunGraphRequest::set_is_last_partial_run(
   is_last_partial_run_ = is_last_partial_run;
 }
 
+size_t InMemoryRunGraphRequest::num_cleanup_step_ids() const {
+  return cleanup_step_ids_.size();
+}
+
+int64 InMemoryRunGraphRequest::cleanup_step_id(size_t i) const {
+  return cleanup_step_ids_[i];
+}
+
+void InMemoryRunGraphRequest::add_cleanup_step_id(int64 step_id) {
+  cleanup_step_ids_.push_back(step_id);
+}
+
 const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
   if (!proto_version_) {
     proto_version_.reset(new RunGraphRequest);
@@ -333,45 +348,51 @@ const RunGraphRequest& InMemoryRunGraphRequest::ToProto() const {
     }
     proto_version_->set_is_partial(is_partial());
     proto_version_->set_is_last_partial_run(is_last_partial_run());
+    for (size_t i = 0; i < num_cleanup_step_ids(); ++i) {
+      proto_version_->add_cleanup_step_id(cleanup_step_id(i));
+    }
   }
   return *proto_version_;
 }
 
+MutableProtoRunGraphRequest::MutableProtoRunGraphRequest()
+    : request_(protobuf::Arena::CreateMessage<RunGraphRequest>(&arena_)) {}
+
 const string& MutableProtoRunGraphRequest::graph_handle() const {
-  return request_.graph_handle();
+  return request_->graph_handle();
 }
 
 void MutableProtoRunGraphRequest::set_graph_handle(const string& handle) {
-  request_.set_graph_handle(handle);
+  request_->set_graph_handle(handle);
 }
 
 int64 MutableProtoRunGraphRequest::step_id() const {
-  return request_.step_id();
+  return request_->step_id();
 }
 
 void MutableProtoRunGraphRequest::set_step_id(int64 step_id) {
-  request_.set_step_id(step_id);
+  request_->set_step_id(step_id);
 }
 
 const ExecutorOpts& MutableProtoRunGraphRequest::exec_opts() const {
-  return request_.exec_opts();
+  return request_->exec_opts();
 }
 
 ExecutorOpts* MutableProtoRunGraphRequest::mutable_exec_opts() {
-  return request_.mutable_exec_opts();
+  return request_->mutable_exec_opts();
 }
 
 size_t MutableProtoRunGraphRequest::num_sends() const {
-  return request_.send_size();
+  return request_->send_size();
 }
 
 const string& MutableProtoRunGraphRequest::send_key(size_t i) const {
-  return request_.send(i).name();
+  return request_->send(i).name();
 }
 
 Status MutableProtoRunGraphRequest::SendValue(size_t i,
                                               Tensor* out_tensor) const {
-  if (!ParseTensorProtoToTensor(request_.send(i).tensor(), out_tensor)) {
+  if (!ParseTensorProtoToTensor(request_->send(i).tensor(), out_tensor)) {
     return errors::InvalidArgument("Invalid TensorProto for feed value ", i);
   } else {
     return Status::OK();
@@ -381,43 +402,55 @@ Status MutableProtoRunGraphRequest::SendValue(size_t i,
 Status MutableProtoRunGraphRequest::AddSendFromRunStepRequest(
     const RunStepRequestWrapper& run_step_request, size_t i,
     const string& send_key) {
-  NamedTensorProto* send = request_.add_send();
+  NamedTensorProto* send = request_->add_send();
   send->set_name(send_key);
   TF_RETURN_IF_ERROR(run_step_request.FeedValue(i, send->mutable_tensor()));
   return Status::OK();
 }
 
 size_t MutableProtoRunGraphRequest::num_recvs() const {
-  return request_.recv_key_size();
+  return request_->recv_key_size();
 }
 
 const string& MutableProtoRunGraphRequest::recv_key(size_t i) const {
-  return request_.recv_key(i);
+  return request_->recv_key(i);
 }
 
 void MutableProtoRunGraphRequest::add_recv_key(const string& recv_key) {
-  request_.add_recv_key(recv_key);
+  request_->add_recv_key(recv_key);
 }
 
 bool MutableProtoRunGraphRequest::is_partial() const {
-  return request_.is_partial();
+  return request_->is_partial();
 }
 
 void MutableProtoRunGraphRequest::set_is_partial(bool is_partial) {
-  request_.set_is_partial(is_partial);
+  request_->set_is_partial(is_partial);
 }
 
 bool MutableProtoRunGraphRequest::is_last_partial_run() const {
-  return request_.is_last_partial_run();
+  return request_->is_last_partial_run();
 }
 
 void MutableProtoRunGraphRequest::set_is_last_partial_run(
     bool is_last_partial_run) {
-  request_.set_is_last_partial_run(is_last_partial_run);
+  request_->set_is_last_partial_run(is_last_partial_run);
+}
+
+size_t MutableProtoRunGraphRequest::num_cleanup_step_ids() const {
+  return request_->cleanup_step_id_size();
+}
+
+int64 MutableProtoRunGraphRequest::cleanup_step_id(size_t i) const {
+  return request_->cleanup_step_id(i);
+}
+
+void MutableProtoRunGraphRequest::add_cleanup_step_id(int64 step_id) {
+  request_->add_cleanup_step_id(step_id);
 }
 
 const RunGraphRequest& MutableProtoRunGraphRequest::ToProto() const {
-  return request_;
+  return *request_;
 }
 
 ProtoRunGraphRequest::ProtoRunGraphRequest(const RunGraphRequest* request)
@@ -461,6 +494,14 @@ bool ProtoRunGraphRequest::is_last_partial_run() const {
   return request_->is_last_partial_run();
 }
 
+size_t ProtoRunGraphRequest::num_cleanup_step_ids() const {
+  return request_->cleanup_step_id_size();
+}
+
+int64 ProtoRunGraphRequest::cleanup_step_id(size_t i) const {
+  return request_->cleanup_step_id(i);
+}
+
 const RunGraphRequest& ProtoRunGraphRequest::ToProto() const {
   return *request_;
 }
@@ -497,22 +538,25 @@ RunGraphResponse* InMemoryRunGraphResponse::get_proto() {
   LOG(FATAL) << "Cannot get a mutable protobuf for an InMemoryRunGraphResponse";
 }
 
+OwnedProtoRunGraphResponse::OwnedProtoRunGraphResponse()
+    : response_(protobuf::Arena::CreateMessage<RunGraphResponse>(&arena_)) {}
+
 size_t OwnedProtoRunGraphResponse::num_recvs() const {
-  return response_.recv_size();
+  return response_->recv_size();
 }
 
 const string& OwnedProtoRunGraphResponse::recv_key(size_t i) const {
-  return response_.recv(i).name();
+  return response_->recv(i).name();
 }
 
 Status OwnedProtoRunGraphResponse::RecvValue(size_t i,
                                              TensorProto* out_tensor) {
-  out_tensor->Swap(response_.mutable_recv(i)->mutable_tensor());
+  out_tensor->Swap(response_->mutable_recv(i)->mutable_tensor());
   return Status::OK();
 }
 
 Status OwnedProtoRunGraphResponse::RecvValue(size_t i, Tensor* out_tensor) {
-  if (!ParseTensorProtoToTensor(response_.recv(i).tensor(), out_tensor)) {
+  if (!ParseTensorProtoToTensor(response_->recv(i).tensor(), out_tensor)) {
     return errors::InvalidArgument("Invalid TensorProto for recv value ", i);
   } else {
     return Status::OK();
@@ -521,21 +565,21 @@ Status OwnedProtoRunGraphResponse::RecvValue(size_t i, Tensor* out_tensor) {
 
 void OwnedProtoRunGraphResponse::AddRecv(const string& key,
                                          const Tensor& value) {
-  NamedTensorProto* recv = response_.add_recv();
+  NamedTensorProto* recv = response_->add_recv();
   recv->set_name(key);
   TensorProto* value_proto = recv->mutable_tensor();
   value.AsProtoTensorContent(value_proto);
 }
 
 StepStats* OwnedProtoRunGraphResponse::mutable_step_stats() {
-  return response_.mutable_step_stats();
+  return response_->mutable_step_stats();
 }
 
 CostGraphDef* OwnedProtoRunGraphResponse::mutable_cost_graph() {
-  return response_.mutable_cost_graph();
+  return response_->mutable_cost_graph();
 }
 
-RunGraphResponse* OwnedProtoRunGraphResponse::get_proto() { return &response_; }
+RunGraphResponse* OwnedProtoRunGraphResponse::get_proto() { return response_; }
 
 NonOwnedProtoRunGraphResponse::NonOwnedProtoRunGraphResponse(
     RunGraphResponse* response)
@@ -615,17 +659,20 @@ RunStepResponse* InMemoryRunStepResponse::get_proto() {
   LOG(FATAL) << "Cannot get a mutable protobuf for an InMemoryRunStepResponse";
 }
 
+OwnedProtoRunStepResponse::OwnedProtoRunStepResponse()
+    : response_(protobuf::Arena::CreateMessage<RunStepResponse>(&arena_)) {}
+
 size_t OwnedProtoRunStepResponse::num_tensors() const {
-  return response_.tensor_size();
+  return response_->tensor_size();
 }
 
 const string& OwnedProtoRunStepResponse::tensor_name(size_t i) const {
-  return response_.tensor(i).name();
+  return response_->tensor(i).name();
 }
 
 Status OwnedProtoRunStepResponse::TensorValue(size_t i,
                                               Tensor* out_tensor) const {
-  if (!ParseTensorProtoToTensor(response_.tensor(i).tensor(), out_tensor)) {
+  if (!ParseTensorProtoToTensor(response_->tensor(i).tensor(), out_tensor)) {
     return errors::InvalidArgument("Invalid TensorProto for fetch value ", i);
   } else {
     return Status::OK();
@@ -633,22 +680,22 @@ Status OwnedProtoRunStepResponse::TensorValue(size_t i,
 }
 
 const RunMetadata& OwnedProtoRunStepResponse::metadata() const {
-  return response_.metadata();
+  return response_->metadata();
 }
 
 Status OwnedProtoRunStepResponse::AddTensorFromRunGraphResponse(
     const string& name, MutableRunGraphResponseWrapper* run_graph_response,
     size_t i) {
-  NamedTensorProto* response_tensor = response_.add_tensor();
+  NamedTensorProto* response_tensor = response_->add_tensor();
   response_tensor->set_name(name);
   return run_graph_response->RecvValue(i, response_tensor->mutable_tensor());
 }
 
 RunMetadata* OwnedProtoRunStepResponse::mutable_metadata() {
-  return response_.mutable_metadata();
+  return response_->mutable_metadata();
 }
 
-RunStepResponse* OwnedProtoRunStepResponse::get_proto() { return &response_; }
+RunStepResponse* OwnedProtoRunStepResponse::get_proto() { return response_; }
 
 NonOwnedProtoRunStepResponse::NonOwnedProtoRunStepResponse(
     RunStepResponse* response)
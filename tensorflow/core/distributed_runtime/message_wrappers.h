@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb_text.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/protobuf/master.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
@@ -146,6 +147,8 @@ class InMemoryRunStepRequest : public MutableRunStepRequestWrapper {
 // client and master in different address spaces.
 class MutableProtoRunStepRequest : public MutableRunStepRequestWrapper {
  public:
+  MutableProtoRunStepRequest();
+
   // RunStepRequestWrapper methods.
   const string& session_handle() const override;
   const string& partial_run_handle() const override;
@@ -170,7 +173,10 @@ class MutableProtoRunStepRequest : public MutableRunStepRequestWrapper {
   RunOptions* mutable_options() override;
 
  private:
-  RunStepRequest request_;
+  // The message and all of its feeds are allocated on arena_, which frees
+  // them at once when the wrapper is destroyed.
+  protobuf::Arena arena_;
+  RunStepRequest* const request_;
 };
 
 // Wrapper for immutable RunStep requests that use a non-owned
@@ -253,6 +259,10 @@ class RunGraphRequestWrapper {
   // True if this is the last partial run request in a sequence of requests.
   virtual bool is_last_partial_run() const = 0;
 
+  // The ids of earlier steps to clean up before running this one.
+  virtual size_t num_cleanup_step_ids() const = 0;
+  virtual int64 cleanup_step_id(size_t i) const = 0;
+
   // Returns the wrapped data as a protocol buffer message.
   virtual const RunGraphRequest& ToProto() const = 0;
 };
@@ -275,6 +285,7 @@ class MutableRunGraphRequestWrapper : public RunGraphRequestWrapper {
   virtual void add_recv_key(const string& recv_key) = 0;
   virtual void set_is_partial(bool is_partial) = 0;
   virtual void set_is_last_partial_run(bool is_last_partial_run) = 0;
+  virtual void add_cleanup_step_id(int64 step_id) = 0;
 };
 
 class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
@@ -290,6 +301,8 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  size_t num_cleanup_step_ids() const override;
+  int64 cleanup_step_id(size_t i) const override;
   const RunGraphRequest& ToProto() const override;
 
   // MutableRunGraphRequestWrapper methods.
@@ -302,6 +315,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
+  void add_cleanup_step_id(int64 step_id) override;
 
  private:
   string graph_handle_;
@@ -311,6 +325,7 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
   gtl::InlinedVector<string, 4> recvs_;
   bool is_partial_ = false;
   bool is_last_partial_run_ = false;
+  gtl::InlinedVector<int64, 4> cleanup_step_ids_;
 
   // Holds a cached and owned representation of the proto
   // representation of this request, if needed, so that `ToProto()`
@@ -324,6 +339,8 @@ class InMemoryRunGraphRequest : public MutableRunGraphRequestWrapper {
 
 class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
  public:
+  MutableProtoRunGraphRequest();
+
   // RunGraphRequestWrapper methods.
   const string& graph_handle() const override;
   int64 step_id() const override;
@@ -335,6 +352,8 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  size_t num_cleanup_step_ids() const override;
+  int64 cleanup_step_id(size_t i) const override;
   const RunGraphRequest& ToProto() const override;
 
   // MutableRunGraphRequestWrapper methods.
@@ -347,9 +366,12 @@ class MutableProtoRunGraphRequest : public MutableRunGraphRequestWrapper {
   void add_recv_key(const string& recv_key) override;
   void set_is_partial(bool is_partial) override;
   void set_is_last_partial_run(bool is_last_partial_run) override;
+  void add_cleanup_step_id(int64 step_id) override;
 
  private:
-  RunGraphRequest request_;
+  // Allocated on arena_, together with the TensorProto of each send.
+  protobuf::Arena arena_;
+  RunGraphRequest* const request_;
 };
 
 class ProtoRunGraphRequest : public RunGraphRequestWrapper {
@@ -367,6 +389,8 @@ class ProtoRunGraphRequest : public RunGraphRequestWrapper {
   const string& recv_key(size_t i) const override;
   bool is_partial() const override;
   bool is_last_partial_run() const override;
+  size_t num_cleanup_step_ids() const override;
+  int64 cleanup_step_id(size_t i) const override;
   const RunGraphRequest& ToProto() const override;
 
  private:
@@ -451,6 +475,8 @@ class InMemoryRunGraphResponse : public MutableRunGraphResponseWrapper {
 // Proto-based message wrapper for use on the client side of the RunGraph RPC.
 class OwnedProtoRunGraphResponse : public MutableRunGraphResponseWrapper {
  public:
+  OwnedProtoRunGraphResponse();
+
   // MutableRunGraphResponseWrapper methods.
   size_t num_recvs() const override;
   const string& recv_key(size_t i) const override;
@@ -464,7 +490,10 @@ class OwnedProtoRunGraphResponse : public MutableRunGraphResponseWrapper {
   RunGraphResponse* get_proto() override;
 
  private:
-  RunGraphResponse response_;
+  // The message and all of its tensors are allocated on arena_, which
+  // frees them at once when the wrapper is destroyed.
+  protobuf::Arena arena_;
+  RunGraphResponse* const response_;
 };
 
 // Proto-based message wrapper for use on the server side of the RunGraph RPC.
@@ -570,6 +599,8 @@ class InMemoryRunStepResponse : public MutableRunStepResponseWrapper {
 // Proto-based message wrapper for use on the client side of the RunStep RPC.
 class OwnedProtoRunStepResponse : public MutableRunStepResponseWrapper {
  public:
+  OwnedProtoRunStepResponse();
+
   // MutableRunStepResponseWrapper methods.
   size_t num_tensors() const override;
   const string& tensor_name(size_t i) const override;
@@ -584,7 +615,9 @@ class OwnedProtoRunStepResponse : public MutableRunStepResponseWrapper {
   RunStepResponse* get_proto() override;
 
  private:
-  RunStepResponse response_;
+  // Allocated on arena_, see OwnedProtoRunGraphResponse.
+  protobuf::Arena arena_;
+  RunStepResponse* const response_;
 };
 
 // Proto-based message wrapper for use on the server side of the RunStep RPC.
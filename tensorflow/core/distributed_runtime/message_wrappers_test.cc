@@ -78,6 +78,8 @@ static void BuildRunGraphRequest(
   run_graph_request->add_recv_key("recv_2");
   run_graph_request->add_recv_key("recv_3");
   run_graph_request->set_is_partial(true);
+  run_graph_request->add_cleanup_step_id(11);
+  run_graph_request->add_cleanup_step_id(12);
 }
 
 static void CheckRunGraphRequest(const RunGraphRequestWrapper& request) {
@@ -93,6 +95,9 @@ static void CheckRunGraphRequest(const RunGraphRequestWrapper& request) {
   test::ExpectTensorEqual<int32>(TensorB(), val);
   EXPECT_TRUE(request.is_partial());
   EXPECT_FALSE(request.is_last_partial_run());
+  ASSERT_EQ(2, request.num_cleanup_step_ids());
+  EXPECT_EQ(11, request.cleanup_step_id(0));
+  EXPECT_EQ(12, request.cleanup_step_id(1));
 }
 
 static void BuildRunGraphResponse(
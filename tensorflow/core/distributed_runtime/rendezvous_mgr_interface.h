@@ -65,6 +65,15 @@ class RendezvousMgrInterface {
   virtual Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                            Tensor* val, bool* is_dead) = 0;
 
+  // Finds the local rendezvous instance for the "step_id", and buffers
+  // in it the tensor for "parsed" that the remote producer pushed to
+  // this worker.
+  //
+  // This method is used by the rpc handler of PushTensor.
+  virtual Status AcceptPushedTensor(int64 step_id,
+                                    const Rendezvous::ParsedKey& parsed,
+                                    const Tensor& val, bool is_dead) = 0;
+
   // Removes rendezvous for "step_id".
   //
   // TODO(zhifengc): Have a background thread in worker that
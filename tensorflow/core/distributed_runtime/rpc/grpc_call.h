@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CALL_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CALL_H_
 
+#include <type_traits>
+
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/protobuf.h"
 
 #include "grpc++/grpc++.h"
 #include "grpc++/impl/codegen/service_type.h"
@@ -128,6 +131,25 @@ class UntypedCall : public core::RefCounted {
   };
 };
 
+// Allocates a request or response message of type `T` on `arena`.
+// Protocol buffer messages are created as arena messages, so that all of
+// their submessages, strings and repeated fields also come from `arena`;
+// other types, such as `::grpc::ByteBuffer`, are only owned by it.
+template <class T,
+          bool kIsMessage = std::is_base_of<protobuf::MessageLite, T>::value>
+struct CallMessageFactory {
+  static T* New(protobuf::Arena* arena) {
+    return protobuf::Arena::CreateMessage<T>(arena);
+  }
+};
+
+template <class T>
+struct CallMessageFactory<T, false> {
+  static T* New(protobuf::Arena* arena) {
+    return protobuf::Arena::Create<T>(arena);
+  }
+};
+
 // Represents a pending call with known request and response message
 // types, and a known request-handling method.
 template <class Service, class GrpcService, class RequestMessage,
@@ -148,7 +170,10 @@ class Call : public UntypedCall<Service> {
       Call<Service, GrpcService, RequestMessage, ResponseMessage>*);
 
   Call(HandleRequestFunction handle_request_function)
-      : handle_request_function_(handle_request_function), responder_(&ctx_) {}
+      : request(*CallMessageFactory<RequestMessage>::New(&arena_)),
+        response(*CallMessageFactory<ResponseMessage>::New(&arena_)),
+        handle_request_function_(handle_request_function),
+        responder_(&ctx_) {}
 
   virtual ~Call() {}
 
@@ -199,6 +224,7 @@ class Call : public UntypedCall<Service> {
                              bool supports_cancel) {
     auto call = new Call<Service, GrpcService, RequestMessage, ResponseMessage>(
         handle_request_function);
+    call->cq_ = cq;
     if (supports_cancel) {
       call->RegisterCancellationHandler();
     }
@@ -220,6 +246,7 @@ class Call : public UntypedCall<Service> {
       bool supports_cancel) {
     auto call = new Call<Service, GrpcService, RequestMessage, ResponseMessage>(
         handle_request_function);
+    call->cq_ = cq;
     if (supports_cancel) {
       call->RegisterCancellationHandler();
     }
@@ -230,8 +257,18 @@ class Call : public UntypedCall<Service> {
                                     &call->request_received_tag_);
   }
 
-  RequestMessage request;
-  ResponseMessage response;
+  // The completion queue that this call was enqueued on.
+  ::grpc::ServerCompletionQueue* cq() const { return cq_; }
+
+ private:
+  // Owns `request` and `response`, and all the memory they allocate while
+  // the call is handled, which is freed at once when the call is deleted.
+  // Declared first so that it is constructed before them.
+  protobuf::Arena arena_;
+
+ public:
+  RequestMessage& request;
+  ResponseMessage& response;
 
  private:
   // Creates a completion queue tag for handling cancellation by the client.
@@ -243,6 +280,7 @@ class Call : public UntypedCall<Service> {
   }
 
   HandleRequestFunction handle_request_function_;
+  ::grpc::ServerCompletionQueue* cq_ = nullptr;
   ::grpc::ServerContext ctx_;
   ::grpc::ServerAsyncResponseWriter<ResponseMessage> responder_;
 
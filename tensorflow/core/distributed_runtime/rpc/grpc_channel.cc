@@ -181,6 +181,30 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
     return cache->TranslateTask(target);
   }
 
+  SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
+    // The cache of the job of "target" knows whether it is still a member.
+    GrpcChannelCache* cache;
+    {
+      mutex_lock l(mu_);
+      cache = gtl::FindPtrOrNull(target_caches_, target);
+    }
+    if (cache != nullptr) {
+      return cache->FindWorkerChannel(target);
+    }
+    return CachingGrpcChannelCache::FindWorkerChannel(target);
+  }
+
+  Status UpdateHostPorts(const string& job_id,
+                         const std::map<int, string>& host_ports) override {
+    for (GrpcChannelCache* cache : caches_) {
+      Status s = cache->UpdateHostPorts(job_id, host_ports);
+      if (!errors::IsNotFound(s)) {
+        return s;
+      }
+    }
+    return errors::NotFound("No job \"", job_id, "\" in the cluster");
+  }
+
  protected:
   SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
     for (GrpcChannelCache* cache : caches_) {
@@ -211,12 +235,14 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
                          ChannelCreationFunction channel_func)
       : job_id_(job_id),
         host_ports_(host_ports),
+        known_host_ports_(host_ports),
         channel_func_(std::move(channel_func)) {
     LOG(INFO) << "Initialize GrpcChannelCache for job " << ToString();
   }
   ~SparseGrpcChannelCache() override {}
 
   void ListWorkers(std::vector<string>* workers) const override {
+    mutex_lock l(mu_);
     workers->reserve(workers->size() + host_ports_.size());
     for (const auto& id_host_port : host_ports_) {
       workers->emplace_back(MakeAddress(job_id_, id_host_port.first));
@@ -238,6 +264,7 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
       return "";
     }
     int32 task = parsed.has_task ? parsed.task : -1;
+    mutex_lock l(mu_);
     auto iter = host_ports_.find(task);
     if (iter == host_ports_.end()) {
       LOG(WARNING) << "Task " << task << " was not defined in sparse job "
@@ -247,6 +274,42 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
     return iter->second;
   }
 
+  SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
+    // Channels are cached by target, and a target keeps its address, but the
+    // channel of a task that left the job must not be returned.
+    if (TranslateTask(target).empty()) {
+      return nullptr;
+    }
+    return CachingGrpcChannelCache::FindWorkerChannel(target);
+  }
+
+  Status UpdateHostPorts(const string& job_id,
+                         const std::map<int, string>& host_ports) override {
+    if (job_id != job_id_) {
+      return errors::NotFound("No job \"", job_id, "\" in the cluster");
+    }
+    for (const auto& id_host_port : host_ports) {
+      TF_RETURN_IF_ERROR(ValidateHostPortPair(id_host_port.second));
+    }
+    {
+      mutex_lock l(mu_);
+      for (const auto& id_host_port : host_ports) {
+        auto iter = known_host_ports_.find(id_host_port.first);
+        if (iter != known_host_ports_.end() &&
+            iter->second != id_host_port.second) {
+          return errors::InvalidArgument(
+              "Task ", id_host_port.first, " of job \"", job_id_,
+              "\" cannot move from ", iter->second, " to ",
+              id_host_port.second, "; add the new address as a new task");
+        }
+      }
+      host_ports_ = host_ports;
+      known_host_ports_.insert(host_ports.begin(), host_ports.end());
+    }
+    LOG(INFO) << "Update GrpcChannelCache for job " << ToString();
+    return Status::OK();
+  }
+
  protected:
   SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
     const string host_port = TranslateTask(target);
@@ -258,6 +321,7 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
 
  private:
   string ToString() {
+    mutex_lock l(mu_);
     std::vector<string> task_strings;
     task_strings.reserve(host_ports_.size());
     for (const auto& id_host_port : host_ports_) {
@@ -269,7 +333,11 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   }
 
   const string job_id_;
-  const std::map<int, string> host_ports_;
+  mutable mutex mu_;
+  // The current tasks of the job.
+  std::map<int, string> host_ports_ GUARDED_BY(mu_);
+  // Every task that has been in the job, with its address.
+  std::map<int, string> known_host_ports_ GUARDED_BY(mu_);
   const ChannelCreationFunction channel_func_;
   TF_DISALLOW_COPY_AND_ASSIGN(SparseGrpcChannelCache);
 };
@@ -75,6 +75,14 @@ class GrpcChannelCache {
 
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
+
+  // Replaces the tasks of the job "job_id" with "host_ports", e.g. when
+  // workers join or leave an elastic job.  Workers that are removed are no
+  // longer listed, and FindWorkerChannel() returns nullptr for them.
+  // A task that stays in the job, or leaves and joins it again, must keep
+  // its address.  Returns NotFound if this cache does not handle "job_id".
+  virtual Status UpdateHostPorts(const string& job_id,
+                                 const std::map<int, string>& host_ports) = 0;
 };
 
 typedef std::function<SharedGrpcChannelPtr(string)> ChannelCreationFunction;
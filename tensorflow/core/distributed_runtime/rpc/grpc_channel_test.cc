@@ -18,6 +18,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
@@ -144,6 +145,42 @@ TEST(GrpcChannelTest, SparseHostPorts) {
             workers);
 }
 
+TEST(GrpcChannelTest, UpdateHostPorts) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(spec.AddHostPortsJob("mnist", {{0, "a:1"}, {1, "b:2"}}));
+  TF_EXPECT_OK(spec.AddHostPortsJob("ps", std::map<int, string>({{0, "p:1"}})));
+  ChannelCreationFunction channel_func =
+      ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
+  std::unique_ptr<GrpcChannelCache> cc(NewGrpcChannelCache(spec, channel_func));
+  EXPECT_NE(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:1"));
+  EXPECT_EQ(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:2"));
+
+  // Task 1 leaves the job and task 2 joins it.
+  TF_EXPECT_OK(cc->UpdateHostPorts("mnist", {{0, "a:1"}, {2, "c:3"}}));
+  EXPECT_NE(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:0"));
+  EXPECT_EQ(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:1"));
+  EXPECT_NE(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:2"));
+  EXPECT_EQ("c:3", cc->TranslateTask("/job:mnist/replica:0/task:2"));
+  std::vector<string> workers;
+  cc->ListWorkers(&workers);
+  std::sort(workers.begin(), workers.end());
+  EXPECT_EQ(std::vector<string>({"/job:mnist/replica:0/task:0",
+                                 "/job:mnist/replica:0/task:2",
+                                 "/job:ps/replica:0/task:0"}),
+            workers);
+
+  // Task 1 may come back at its old address only.
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      cc->UpdateHostPorts("mnist", {{0, "a:1"}, {1, "d:4"}})));
+  EXPECT_EQ(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:1"));
+  TF_EXPECT_OK(cc->UpdateHostPorts("mnist", {{0, "a:1"}, {1, "b:2"}}));
+  EXPECT_NE(nullptr, cc->FindWorkerChannel("/job:mnist/replica:0/task:1"));
+
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      cc->UpdateHostPorts("mnist", {{0, "a:1"}, {3, "d"}})));
+  EXPECT_TRUE(errors::IsNotFound(cc->UpdateHostPorts("other", {{0, "a:1"}})));
+}
+
 TEST(GrpcChannelTest, NewHostPortGrpcChannelValidation) {
   SharedGrpcChannelPtr mock_ptr;
 
@@ -30,6 +30,9 @@ limitations under the License.
 // RunGraph on workers.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_master_service.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "grpc++/alarm.h"
 #include "grpc++/server_builder.h"
 
@@ -38,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_master_service_impl.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/protobuf/master.pb.h"
@@ -47,16 +51,28 @@ namespace tensorflow {
 class GrpcMasterService : public AsyncServiceInterface {
  public:
   GrpcMasterService(Master* master, int64 default_timeout_in_ms,
+                    const RPCOptions& rpc_options,
                     ::grpc::ServerBuilder* builder)
       : master_impl_(master),
         default_timeout_in_ms_(default_timeout_in_ms),
+        num_polling_threads_per_queue_(
+            std::max(1, rpc_options.num_server_polling_threads_per_queue())),
+        run_call_depth_(rpc_options.server_run_call_depth() > 0
+                            ? rpc_options.server_run_call_depth()
+                            : 100),
         is_shutdown_(false) {
     builder->RegisterService(&master_service_);
-    cq_ = builder->AddCompletionQueue();
+    const int num_queues =
+        std::max(1, rpc_options.num_server_completion_queues());
+    for (int i = 0; i < num_queues; ++i) {
+      cqs_.push_back(builder->AddCompletionQueue());
+    }
   }
 
   ~GrpcMasterService() {
-    delete shutdown_alarm_;
+    for (::grpc::Alarm* alarm : shutdown_alarms_) {
+      delete alarm;
+    }
   }
 
   void Shutdown() override {
@@ -71,51 +87,86 @@ class GrpcMasterService : public AsyncServiceInterface {
     }
     if (did_shutdown) {
       // NOTE(mrry): This enqueues a special event (with a null tag)
-      // that causes the completion queue to be shut down on the
+      // that causes the completion queue to be shut down on a
       // polling thread.
-      shutdown_alarm_ =
-          new ::grpc::Alarm(cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+      for (const auto& cq : cqs_) {
+        shutdown_alarms_.push_back(new ::grpc::Alarm(
+            cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr));
+      }
     }
   }
 
 // This macro creates a new request for the given RPC method name
-// (e.g., `ENQUEUE_REQUEST(RunStep);`), and enqueues it on
-// `this->cq_`.
+// (e.g., `ENQUEUE_REQUEST(cq, RunStep, true);`), and enqueues it on
+// the completion queue `cq`.
 //
-// This macro is invoked one or more times for each RPC method to
-// ensure that there are sufficient completion queue entries to
-// handle incoming requests without blocking.
+// This macro is invoked one or more times for each RPC method and
+// completion queue to ensure that there are sufficient completion
+// queue entries to handle incoming requests without blocking.
 //
 // The implementation of the request handler for each RPC method
 // must ensure that it calls ENQUEUE_REQUEST() for that RPC method,
-// to keep accepting new requests.
-#define ENQUEUE_REQUEST(method, supports_cancel)                              \
+// on the queue of the call it handles, to keep accepting new requests.
+#define ENQUEUE_REQUEST(cq, method, supports_cancel)                          \
   do {                                                                        \
     mutex_lock l(mu_);                                                        \
     if (!is_shutdown_) {                                                      \
       Call<GrpcMasterService, grpc::MasterService::AsyncService,              \
            method##Request, method##Response>::                               \
-          EnqueueRequest(&master_service_, cq_.get(),                         \
+          EnqueueRequest(&master_service_, (cq),                              \
                          &grpc::MasterService::AsyncService::Request##method, \
                          &GrpcMasterService::method##Handler,                 \
                          (supports_cancel));                                  \
     }                                                                         \
   } while (0)
 
+  // Polls the first completion queue, and starts the other polling
+  // threads.
   void HandleRPCsLoop() override {
-    ENQUEUE_REQUEST(CreateSession, true);
-    ENQUEUE_REQUEST(ExtendSession, false);
-    for (int i = 0; i < 100; ++i) {
-      ENQUEUE_REQUEST(PartialRunSetup, false);
-      ENQUEUE_REQUEST(RunStep, true);
+    for (const auto& cq_ptr : cqs_) {
+      ::grpc::ServerCompletionQueue* cq = cq_ptr.get();
+      ENQUEUE_REQUEST(cq, CreateSession, true);
+      ENQUEUE_REQUEST(cq, ExtendSession, false);
+      for (int i = 0; i < run_call_depth_; ++i) {
+        ENQUEUE_REQUEST(cq, PartialRunSetup, false);
+        ENQUEUE_REQUEST(cq, RunStep, true);
+      }
+      ENQUEUE_REQUEST(cq, CloseSession, false);
+      ENQUEUE_REQUEST(cq, ListDevices, false);
+      ENQUEUE_REQUEST(cq, Reset, false);
     }
-    ENQUEUE_REQUEST(CloseSession, false);
-    ENQUEUE_REQUEST(ListDevices, false);
-    ENQUEUE_REQUEST(Reset, false);
 
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (size_t i = 0; i < cqs_.size(); ++i) {
+      for (int j = (i == 0 ? 1 : 0); j < num_polling_threads_per_queue_;
+           ++j) {
+        ::grpc::ServerCompletionQueue* cq = cqs_[i].get();
+        threads.emplace_back(Env::Default()->StartThread(
+            ThreadOptions(), "TF_master_service",
+            [this, cq]() { PollCompletionQueue(cq); }));
+      }
+    }
+    PollCompletionQueue(cqs_[0].get());
+    // Joins the other polling threads.
+    threads.clear();
+  }
+
+ private:
+  Master* master_impl_ = nullptr;  // Not owned.
+  const int64 default_timeout_in_ms_;
+  std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> cqs_;
+  const int num_polling_threads_per_queue_;
+  const int run_call_depth_;
+  grpc::MasterService::AsyncService master_service_;
+
+  mutex mu_;
+  bool is_shutdown_ GUARDED_BY(mu_);
+  std::vector<::grpc::Alarm*> shutdown_alarms_;
+
+  void PollCompletionQueue(::grpc::ServerCompletionQueue* cq) {
     void* tag;
     bool ok;
-    while (cq_->Next(&tag, &ok)) {
+    while (cq->Next(&tag, &ok)) {
       UntypedCall<GrpcMasterService>::Tag* callback_tag =
           static_cast<UntypedCall<GrpcMasterService>::Tag*>(tag);
       if (callback_tag) {
@@ -123,21 +174,11 @@ class GrpcMasterService : public AsyncServiceInterface {
       } else {
         // NOTE(mrry): A null `callback_tag` indicates that this is
         // the shutdown alarm.
-        cq_->Shutdown();
+        cq->Shutdown();
       }
     }
   }
 
- private:
-  Master* master_impl_ = nullptr;  // Not owned.
-  const int64 default_timeout_in_ms_;
-  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
-  grpc::MasterService::AsyncService master_service_;
-
-  mutex mu_;
-  bool is_shutdown_ GUARDED_BY(mu_);
-  ::grpc::Alarm* shutdown_alarm_ = nullptr;
-
   template <class RequestMessage, class ResponseMessage>
   using MasterCall = Call<GrpcMasterService, grpc::MasterService::AsyncService,
                           RequestMessage, ResponseMessage>;
@@ -149,7 +190,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                                 [call](const Status& status) {
                                   call->SendResponse(ToGrpcStatus(status));
                                 });
-    ENQUEUE_REQUEST(CreateSession, true);
+    ENQUEUE_REQUEST(call->cq(), CreateSession, true);
   }
 
   // RPC handler for extending a session.
@@ -159,7 +200,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                                 [call](const Status& status) {
                                   call->SendResponse(ToGrpcStatus(status));
                                 });
-    ENQUEUE_REQUEST(ExtendSession, false);
+    ENQUEUE_REQUEST(call->cq(), ExtendSession, false);
   }
 
   // RPC handler for setting up a partial run call.
@@ -169,7 +210,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                                   [call](const Status& status) {
                                     call->SendResponse(ToGrpcStatus(status));
                                   });
-    ENQUEUE_REQUEST(PartialRunSetup, false);
+    ENQUEUE_REQUEST(call->cq(), PartialRunSetup, false);
   }
 
   // RPC handler for running one step in a session.
@@ -193,7 +234,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                             delete wrapped_request;
                             call->SendResponse(ToGrpcStatus(status));
                           });
-    ENQUEUE_REQUEST(RunStep, true);
+    ENQUEUE_REQUEST(call->cq(), RunStep, true);
   }
 
   // RPC handler for deleting a session.
@@ -203,7 +244,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                                [call](const Status& status) {
                                  call->SendResponse(ToGrpcStatus(status));
                                });
-    ENQUEUE_REQUEST(CloseSession, false);
+    ENQUEUE_REQUEST(call->cq(), CloseSession, false);
   }
 
   // RPC handler for listing devices.
@@ -213,7 +254,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                               [call](const Status& status) {
                                 call->SendResponse(ToGrpcStatus(status));
                               });
-    ENQUEUE_REQUEST(ListDevices, false);
+    ENQUEUE_REQUEST(call->cq(), ListDevices, false);
   }
 
   // RPC handler for resetting all sessions.
@@ -222,7 +263,7 @@ class GrpcMasterService : public AsyncServiceInterface {
                         [call](const Status& status) {
                           call->SendResponse(ToGrpcStatus(status));
                         });
-    ENQUEUE_REQUEST(Reset, false);
+    ENQUEUE_REQUEST(call->cq(), Reset, false);
   }
 #undef ENQUEUE_REQUEST
 
@@ -231,8 +272,10 @@ class GrpcMasterService : public AsyncServiceInterface {
 
 AsyncServiceInterface* NewGrpcMasterService(Master* master,
                                             int64 default_timeout_in_ms,
+                                            const RPCOptions& rpc_options,
                                             ::grpc::ServerBuilder* builder) {
-  return new GrpcMasterService(master, default_timeout_in_ms, builder);
+  return new GrpcMasterService(master, default_timeout_in_ms, rpc_options,
+                               builder);
 }
 
 }  // end namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace grpc {
 class ServerBuilder;
@@ -28,8 +29,11 @@ namespace tensorflow {
 class AsyncServiceInterface;
 class Master;
 
+// Returns an implementation of MasterService rpc service, which polls
+// as many completion queues as "rpc_options" asks for.
 AsyncServiceInterface* NewGrpcMasterService(Master* master,
                                             int64 default_timeout_in_ms,
+                                            const RPCOptions& rpc_options,
                                             ::grpc::ServerBuilder* builder);
 
 }  // namespace tensorflow
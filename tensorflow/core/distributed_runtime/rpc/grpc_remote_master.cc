@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/master_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_master_service_impl.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -63,11 +64,44 @@ class GrpcRemoteMaster : public MasterInterface {
 
   Status RunStep(CallOptions* call_options, RunStepRequestWrapper* request,
                  MutableRunStepResponseWrapper* response) override {
+    // The feeds are encoded from their buffers, which large ones share
+    // with the request instead of being copied into TensorProtos.
+    RunStepRequest header;
+    header.set_session_handle(request->session_handle());
+    header.set_partial_run_handle(request->partial_run_handle());
+    for (size_t i = 0; i < request->num_fetches(); ++i) {
+      header.add_fetch(request->fetch_name(i));
+    }
+    for (size_t i = 0; i < request->num_targets(); ++i) {
+      header.add_target(request->target_name(i));
+    }
+    *header.mutable_options() = request->options();
+    std::vector<std::pair<string, Tensor>> feeds(request->num_feeds());
+    for (size_t i = 0; i < request->num_feeds(); ++i) {
+      feeds[i].first = request->feed_name(i);
+      TF_RETURN_IF_ERROR(request->FeedValue(i, &feeds[i].second));
+    }
+    ::grpc::ByteBuffer encoded;
+    grpc::EncodeNamedTensorsToByteBuffer(
+        header, RunStepRequest::kFeedFieldNumber, feeds, &encoded);
+
     ::grpc::ClientContext ctx;
     ctx.set_fail_fast(false);
     SetDeadline(&ctx, call_options->GetTimeout());
-    return FromGrpcStatus(stub_->RunStep(&ctx, request->ToProto(),
-                                         get_proto_from_wrapper(response)));
+    return FromGrpcStatus(
+        stub_->RunStep(&ctx, encoded, get_proto_from_wrapper(response)));
+  }
+
+  Status RunStep(CallOptions* call_options, const RunStepRequest* request,
+                 RunStepResponse* response) override {
+    ::grpc::ClientContext ctx;
+    ctx.set_fail_fast(false);
+    SetDeadline(&ctx, call_options->GetTimeout());
+    return FromGrpcStatus(stub_->RunStep(&ctx, *request, response));
+  }
+
+  MutableRunStepRequestWrapper* CreateRunStepRequest() override {
+    return new InMemoryRunStepRequest;
   }
 
   Status CloseSession(CallOptions* call_options,
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
@@ -47,8 +48,10 @@ class GrpcRemoteWorker : public WorkerInterface {
         cleanupgraph_(Method(GrpcWorkerMethod::kCleanupGraph)),
         cleanupall_(Method(GrpcWorkerMethod::kCleanupAll)),
         recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
+        pushtensor_(Method(GrpcWorkerMethod::kPushTensor)),
         logging_(Method(GrpcWorkerMethod::kLogging)),
         tracing_(Method(GrpcWorkerMethod::kTracing)),
+        getmetrics_(Method(GrpcWorkerMethod::kGetMetrics)),
         logger_(logger) {}
 
   ~GrpcRemoteWorker() override {}
@@ -84,10 +87,47 @@ class GrpcRemoteWorker : public WorkerInterface {
   void RunGraphAsync(CallOptions* call_opts, RunGraphRequestWrapper* request,
                      MutableRunGraphResponseWrapper* response,
                      StatusCallback done) override {
-    IssueRequest(&request->ToProto(), get_proto_from_wrapper(response),
+    // The sent tensors are encoded from their buffers, which large ones
+    // share with the request instead of being copied into TensorProtos.
+    RunGraphRequest header;
+    header.set_graph_handle(request->graph_handle());
+    header.set_step_id(request->step_id());
+    *header.mutable_exec_opts() = request->exec_opts();
+    for (size_t i = 0; i < request->num_recvs(); ++i) {
+      header.add_recv_key(request->recv_key(i));
+    }
+    header.set_is_partial(request->is_partial());
+    header.set_is_last_partial_run(request->is_last_partial_run());
+    for (size_t i = 0; i < request->num_cleanup_step_ids(); ++i) {
+      header.add_cleanup_step_id(request->cleanup_step_id(i));
+    }
+    std::vector<std::pair<string, Tensor>> sends(request->num_sends());
+    for (size_t i = 0; i < request->num_sends(); ++i) {
+      sends[i].first = request->send_key(i);
+      Status s = request->SendValue(i, &sends[i].second);
+      if (!s.ok()) {
+        done(s);
+        return;
+      }
+    }
+    ::grpc::ByteBuffer encoded;
+    grpc::EncodeNamedTensorsToByteBuffer(
+        header, RunGraphRequest::kSendFieldNumber, sends, &encoded);
+
+    // "response" comes from CreateRunGraphResponse() on this worker, so the
+    // received tensors are parsed straight into its Tensors.
+    IssueRequest(&encoded, static_cast<InMemoryRunGraphResponse*>(response),
                  rungraph_, std::move(done), call_opts);
   }
 
+  MutableRunGraphRequestWrapper* CreateRunGraphRequest() override {
+    return new InMemoryRunGraphRequest;
+  }
+
+  MutableRunGraphResponseWrapper* CreateRunGraphResponse() override {
+    return new InMemoryRunGraphResponse;
+  }
+
   void CleanupGraphAsync(const CleanupGraphRequest* request,
                          CleanupGraphResponse* response,
                          StatusCallback done) override {
@@ -129,7 +169,11 @@ class GrpcRemoteWorker : public WorkerInterface {
         if (logger_->LoggingActive()) {
           int64 end_usec = Env::Default()->NowMicros();
           int64 step_id = request->step_id();
-          int64 bytes = response->tensor().TotalBytes();
+          // A chunked transfer is logged once per chunk.
+          int64 bytes = response->chunk_bytes() > 0
+                            ? response->chunk_bytes()
+                            : response->tensor().TotalBytes();
+          int64 wire_bytes = response->content_wire_bytes();
           int64 send_start_usec = start_usec;
           // If a send start time was reported by the other side, use
           // that instead.  Maybe we should mark the display if we're using
@@ -159,7 +203,7 @@ class GrpcRemoteWorker : public WorkerInterface {
                                       key_parts[3],  // tensor name
                                       key_parts[0],  // src_device
                                       key_parts[2],  // dst_device
-                                      bytes);
+                                      bytes, wire_bytes);
           }
         }
         VLOG(2) << "done callback, req: " << request->DebugString()
@@ -174,6 +218,12 @@ class GrpcRemoteWorker : public WorkerInterface {
                  std::move(*cb_to_use), call_opts);
   }
 
+  void PushTensorAsync(const PushTensorRequest* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override {
+    IssueRequest(request, response, pushtensor_, std::move(done));
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -184,6 +234,12 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, tracing_, done);
   }
 
+  void GetMetricsAsync(const GetMetricsRequest* request,
+                       GetMetricsResponse* response,
+                       StatusCallback done) override {
+    IssueRequest(request, response, getmetrics_, done);
+  }
+
  private:
   // Object allocated per active RPC.
   template <class RequestMessage, class ResponseMessage>
@@ -260,8 +316,10 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::RpcMethod cleanupgraph_;
   const ::grpc::RpcMethod cleanupall_;
   const ::grpc::RpcMethod recvtensor_;
+  const ::grpc::RpcMethod pushtensor_;
   const ::grpc::RpcMethod logging_;
   const ::grpc::RpcMethod tracing_;
+  const ::grpc::RpcMethod getmetrics_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
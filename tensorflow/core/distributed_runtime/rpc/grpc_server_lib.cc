@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <set>
 
 #include "grpc++/grpc++.h"
 #include "grpc++/security/credentials.h"
@@ -62,13 +63,6 @@ class NoReusePortOption : public ::grpc::ServerBuilderOption {
                          plugins) override {}
 };
 
-// static utility function
-RendezvousMgrInterface* NewRpcRendezvousMgr(
-    const WorkerEnv* env, const string& worker_name,
-    WorkerCacheInterface* worker_cache) {
-  return new RpcRendezvousMgr(env, worker_name, worker_cache);
-}
-
 }  // namespace
 
 GrpcServer::GrpcServer(const ServerDef& server_def, Env* env)
@@ -173,11 +167,13 @@ Status GrpcServer::Init(ServiceInitFunction service_func,
   builder.SetOption(
       std::unique_ptr<::grpc::ServerBuilderOption>(new NoReusePortOption));
   master_impl_ = CreateMaster(&master_env_);
-  master_service_ = NewGrpcMasterService(
-      master_impl_.get(), config.operation_timeout_in_ms(), &builder);
+  master_service_ =
+      NewGrpcMasterService(master_impl_.get(), config.operation_timeout_in_ms(),
+                           config.rpc_options(), &builder);
   worker_impl_ = NewGrpcWorker(&worker_env_);
   worker_service_ =
-      NewGrpcWorkerService(worker_impl_.get(), &builder).release();
+      NewGrpcWorkerService(worker_impl_.get(), config.rpc_options(), &builder)
+          .release();
   // extra service:
   if (service_func != nullptr) {
     service_func(&worker_env_, &builder);
@@ -189,13 +185,15 @@ Status GrpcServer::Init(ServiceInitFunction service_func,
   }
 
   WorkerCacheInterface* worker_cache;
-  TF_RETURN_IF_ERROR(WorkerCacheFactory(server_def_, &worker_cache));
+  TF_RETURN_IF_ERROR(
+      WorkerCacheFactory(server_def_, &worker_cache, &channel_cache_));
   CHECK_NE(nullptr, worker_cache);
 
   // Set up worker environment.
   std::unique_ptr<RendezvousMgrInterface> rendezvous_mgr(
       rendevous_mgr_func == nullptr ?
-      new RpcRendezvousMgr(&worker_env_, name_prefix, worker_cache) :
+      new RpcRendezvousMgr(&worker_env_, name_prefix, worker_cache,
+                           config.rpc_options()) :
       rendevous_mgr_func(&worker_env_, name_prefix, worker_cache));
   worker_env_.session_mgr = new SessionMgr(
       &worker_env_, SessionMgr::WorkerNameFromServerDef(server_def_),
@@ -254,7 +252,8 @@ Status GrpcServer::ParseChannelSpec(const ServerDef& server_def,
 }
 
 Status GrpcServer::WorkerCacheFactory(const ServerDef& server_def,
-                                      WorkerCacheInterface** worker_cache) {
+                                      WorkerCacheInterface** worker_cache,
+                                      GrpcChannelCache** channel_cache_out) {
   string name_prefix =
       strings::StrCat("/job:", server_def.job_name(), "/replica:0",
                       "/task:", server_def.task_index());
@@ -277,11 +276,57 @@ Status GrpcServer::WorkerCacheFactory(const ServerDef& server_def,
                                    " differs from expected port ", bound_port_);
   }
 
+  if (channel_cache_out != nullptr) {
+    *channel_cache_out = channel_cache.get();
+  }
   *worker_cache = NewGrpcWorkerCacheWithLocalWorker(
       channel_cache.release(), worker_impl_.get(), name_prefix);
   return Status::OK();
 }
 
+Status GrpcServer::UpdateClusterDef(const ClusterDef& cluster) {
+  ServerDef server_def = server_def_;
+  *server_def.mutable_cluster() = cluster;
+  GrpcChannelSpec channel_spec;
+  TF_RETURN_IF_ERROR(ParseChannelSpec(server_def, &channel_spec));
+
+  // The jobs of the cluster are fixed, as is the address of this task.
+  std::set<string> job_names;
+  for (const auto& job : server_def_.cluster().job()) {
+    job_names.insert(job.name());
+  }
+  if (channel_spec.host_ports_jobs().size() != job_names.size()) {
+    return errors::InvalidArgument("The cluster must keep its ",
+                                   job_names.size(), " jobs");
+  }
+  for (const auto& job : channel_spec.host_ports_jobs()) {
+    if (job_names.count(job.job_id) == 0) {
+      return errors::InvalidArgument("Job \"", job.job_id,
+                                     "\" is not in the cluster");
+    }
+    if (job.job_id != server_def_.job_name()) continue;
+    const auto iter = job.host_ports.find(server_def_.task_index());
+    if (iter == job.host_ports.end() ||
+        iter->second != strings::StrCat("localhost:", bound_port_)) {
+      // The address of this task is "localhost:<port>" in the channel spec
+      // of the server, see Init().
+      return errors::InvalidArgument(
+          "Task ", server_def_.task_index(), " of job \"",
+          server_def_.job_name(), "\" must keep its address");
+    }
+  }
+
+  mutex_lock l(mu_);
+  if (channel_cache_ == nullptr) {
+    return errors::FailedPrecondition("Server has not been initialized.");
+  }
+  for (const auto& job : channel_spec.host_ports_jobs()) {
+    TF_RETURN_IF_ERROR(
+        channel_cache_->UpdateHostPorts(job.job_id, job.host_ports));
+  }
+  return Status::OK();
+}
+
 Status GrpcServer::Start() {
   mutex_lock l(mu_);
   switch (state_) {
@@ -366,7 +411,7 @@ Status GrpcServer::Create(const ServerDef& server_def, Env* env,
   std::unique_ptr<GrpcServer> ret(
       new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   ServiceInitFunction service_func = nullptr;
-  TF_RETURN_IF_ERROR(ret->Init(service_func, NewRpcRendezvousMgr));
+  TF_RETURN_IF_ERROR(ret->Init(service_func, nullptr));
   *out_server = std::move(ret);
   return Status::OK();
 }
@@ -65,6 +65,14 @@ class GrpcServer : public ServerInterface {
   Status Join() override;
   const string target() const override;
 
+  // Updates the tasks of the jobs of this server's cluster to those in
+  // "cluster", e.g. when workers of an elastic job join or leave.  The
+  // sessions that are created afterwards use the new tasks, while running
+  // sessions keep the devices that they started with.  "cluster" must have
+  // the same jobs as the cluster of this server, this task must keep its
+  // address, and so must every task that stays in or comes back to a job.
+  Status UpdateClusterDef(const ClusterDef& cluster);
+
  protected:
   Status Init(ServiceInitFunction service_func,
               RendezvousMgrCreationFunction rendezvous_mgr_func);
@@ -80,9 +88,11 @@ class GrpcServer : public ServerInterface {
 
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
-  // Creates a WorkerCacheInterface for a session.
+  // Creates a WorkerCacheInterface for a session.  If "channel_cache" is
+  // not null, it is set to the channel cache that "*worker_cache" owns.
   Status WorkerCacheFactory(const ServerDef& server_def,
-                            WorkerCacheInterface** worker_cache);
+                            WorkerCacheInterface** worker_cache,
+                            GrpcChannelCache** channel_cache = nullptr);
 
   // Parses a ServerDef into a GrpcChannelSpec.
   Status ParseChannelSpec(const ServerDef& server_def,
@@ -132,6 +142,9 @@ class GrpcServer : public ServerInterface {
   std::unique_ptr<Thread> worker_thread_ GUARDED_BY(mu_);
 
   std::unique_ptr<::grpc::Server> server_ GUARDED_BY(mu_);
+
+  // The channel cache of master_env_.worker_cache, which owns it.
+  GrpcChannelCache* channel_cache_ GUARDED_BY(mu_) = nullptr;
 };
 
 }  // namespace tensorflow
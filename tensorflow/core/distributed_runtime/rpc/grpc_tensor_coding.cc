@@ -27,7 +27,6 @@ limitations under the License.
 namespace tensorflow {
 namespace grpc {
 
-static void do_nothing(void* raw) {}
 static void unref_tensorbuffer(void* raw) {
   TensorBuffer* buf = static_cast<TensorBuffer*>(raw);
   buf->Unref();
@@ -71,9 +70,8 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 // If the tensor data is larger than "kLargeTensorBytes", then A through
 // D2 will be encoded in one gpr_slice, and E will be encoded in a second
 // gpr_slice that points to the backing store for the tensor data, to avoid
-// copying the tensor data (and the gpr_slice setup will be arrange so as
-// to dereference the underlying tensor data buffer when it is no longer
-// needed in the "*result" ByteBuffer).
+// copying the tensor data.  The second slice holds a reference on the
+// TensorBuffer, which it drops when grpc destroys the slice.
 static int VarLengthEncodingSize(uint32 tag, size_t bytes) {
   return core::VarintLength(tag << 3) + core::VarintLength(bytes) + bytes;
 }
@@ -138,9 +136,64 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
+// Tensor data of more than this many bytes is shared, not copied.
+static const size_t kLargeTensorBytes = 1024;
+
+// Returns a slice that points to "tdata", which lies in the buffer of
+// "val", and holds a reference on that buffer until grpc destroys it.
+static ::grpc::Slice SharedTensorDataSlice(const Tensor& val,
+                                           StringPiece tdata) {
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  buf->Ref();
+  gpr_slice s = gpr_slice_new_with_user_data(
+      const_cast<void*>(static_cast<const void*>(tdata.data())), tdata.size(),
+      unref_tensorbuffer, const_cast<TensorBuffer*>(buf));
+  return ::grpc::Slice(s, ::grpc::Slice::STEAL_REF);
+}
+
+// Returns a slice that holds a copy of "data".
+static ::grpc::Slice CopiedSlice(StringPiece data) {
+  gpr_slice s = gpr_slice_malloc(data.size());
+  memcpy(GPR_SLICE_START_PTR(s), data.data(), data.size());
+  return ::grpc::Slice(s, ::grpc::Slice::STEAL_REF);
+}
+
+// Sets "*result" to the bytes of "prefix" followed by "tdata", which
+// lies in the buffer of "val".
+//
+// If "tdata" is small, it is copied after "prefix" into a single
+// gpr_slice.  Otherwise it is encoded in a second gpr_slice that points
+// to the backing store of "val", to avoid copying the tensor data.  The
+// slice holds a reference on the TensorBuffer, which it drops when grpc
+// destroys the slice.
+static void EncodeWithTensorData(StringPiece prefix, const Tensor& val,
+                                 StringPiece tdata,
+                                 ::grpc::ByteBuffer* result) {
+  const bool tensor_data_is_large = (tdata.size() > kLargeTensorBytes);
+  ::grpc::Slice slices[2];
+  int num_slices = 0;
+  {
+    size_t slice_len =
+        prefix.size() + (tensor_data_is_large ? 0 : tdata.size());
+    gpr_slice s0 = gpr_slice_malloc(slice_len);
+    memcpy(GPR_SLICE_START_PTR(s0), prefix.data(), prefix.size());
+    if (!tensor_data_is_large) {
+      memcpy(GPR_SLICE_START_PTR(s0) + prefix.size(), tdata.data(),
+             tdata.size());
+    }
+    slices[0] = ::grpc::Slice(s0, ::grpc::Slice::STEAL_REF);
+    num_slices += 1;
+  }
+
+  if (tensor_data_is_large) {
+    slices[1] = SharedTensorDataSlice(val, tdata);
+    num_slices += 1;
+  }
+  *result = ::grpc::ByteBuffer(&slices[0], num_slices);
+}
+
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result) {
-  const int kLargeTensorBytes = 1024;
   RecvTensorResponse response;
   if (is_dead) {
     response.set_is_dead(is_dead);
@@ -173,15 +226,6 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
         (header.size() +
          VarLengthEncodingSize(RecvTensorResponse::kTensorFieldNumber,
                                overall_tensor_proto_bytesize));
-    // If "tensor_data_is_large == false", we copy the tensor data to the
-    // end of the buffer we are preparing that holds the rest of the
-    // RecvTensorResponse protocol buffer.
-    //
-    // If "tensor_data_is_large == true", we arrange to share the backing
-    // store of the data by creating a slice that also points to the
-    // backing store, with appropriate reference counts to keep the
-    // backing store alive as needed.
-    bool tensor_data_is_large = (tdata.size() > kLargeTensorBytes);
     size_t encoder_size = expected_size - tdata.size();
 
     // Encode all but the actual "tdata", but including the tag and
@@ -201,66 +245,117 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               tdata.size());
 
     // All but the tensor backing store are serialized now
+    EncodeWithTensorData(StringPiece(e.data(), e.size()), val, tdata, result);
+    CHECK_EQ(result->Length(), expected_size);
+  }
+}
 
-    // Now allocate memory and put into the ByteBuffer
-    ::grpc::Slice slices[3];
-    int num_slices = 0;
-    {
-      size_t slice_len = e.size() + (tensor_data_is_large ? 0 : tdata.size());
-      gpr_slice s0 = gpr_slice_malloc(slice_len);
-      memcpy(GPR_SLICE_START_PTR(s0), e.data(), e.size());
-      if (!tensor_data_is_large) {
-        // (E)
-        memcpy(GPR_SLICE_START_PTR(s0) + e.size(), tdata.data(), tdata.size());
-      }
-      slices[0] = ::grpc::Slice(s0, ::grpc::Slice::STEAL_REF);
-      num_slices += 1;
-    }
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset,
+                                   int64 num_bytes,
+                                   ::grpc::ByteBuffer* result) {
+  DCHECK(DataTypeCanUseMemcpy(val.dtype()));
+  RecvTensorResponse response;
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  string header;  // All of RecvTensorResponse except tensor and the chunk
+  response.AppendToString(&header);
 
-    if (tensor_data_is_large) {
-      // Encode the actual tensor data by pointing to the backing store,
-      // and add a special zero-length slice that is really a TensorBuffer
-      // reference that we will unref when we are done.
-      //
-      // TODO(jeff): Note that this approach relies on the fact that
-      // slices are destroyed in the order in which they are added to
-      // the ByteBuffer.  In principle, these could be broken by future
-      // hypothetical grpc_slice-related changes (e.g. the
-      // implementation could decide to destroy 0-length slices
-      // eagerly).  In practice, this does not happen with the current
-      // implementation, and the gpr_slice interface at the moment does
-      // not allow us to do the Tensor-unreferencing in the right way
-      // (since the Tensor pointer is different than the backing store
-      // array pointer).
-      //
-      // TODO(jeff,sanjay): switch to using new
-      // gsr_slice_new_with_user_data interface that allows for
-      // different pointers for the data and the argument to the
-      // destroy function once that has been added integrated into grpc
-      // (see https://github.com/grpc/grpc/pull/7488)
-
-      // (E) Encode tensor data, but by sharing backing store
-
-      const TensorBuffer* buf = DMAHelper::buffer(&val);
-      buf->Ref();
-      gpr_slice s1 = gpr_slice_new(
-          const_cast<void*>(static_cast<const void*>(tdata.data())),
-          tdata.size(), do_nothing);
-      slices[1] = ::grpc::Slice(s1, ::grpc::Slice::STEAL_REF);
-
-      gpr_slice s2 = gpr_slice_new(const_cast<TensorBuffer*>(buf),
-                                   0, unref_tensorbuffer);
-      slices[2] = ::grpc::Slice(s2, ::grpc::Slice::STEAL_REF);
-      num_slices += 2;
-    }
-    size_t total_bytes = 0;
-    for (int i = 0; i < num_slices; i++) {
-      total_bytes += slices[i].size();
+  // Only the first chunk carries the dtype and shape.
+  gtl::InlinedVector<char, 128> skeleton(SkeletonEncodingSizeUpperBound(val));
+  io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
+  if (offset == 0) {
+    EncodeSkeleton(val, &e_skeleton);
+  }
+  const StringPiece chunk = val.tensor_data().substr(offset, num_bytes);
+  DCHECK_EQ(chunk.size(), num_bytes);
+
+  size_t encoder_size =
+      header.size() +
+      VarLengthEncodingSize(RecvTensorResponse::kTensorChunkFieldNumber,
+                            chunk.size()) -
+      chunk.size();
+  if (offset == 0) {
+    encoder_size += VarLengthEncodingSize(
+        RecvTensorResponse::kTensorFieldNumber, e_skeleton.size());
+  }
+  gtl::InlinedVector<char, 1024> space(encoder_size);
+  io::ProtoEncodeHelper e(space.data(), space.size());
+  e.WriteRawBytes(header);
+  if (offset == 0) {
+    e.WriteVarlengthBeginning(RecvTensorResponse::kTensorFieldNumber,
+                              e_skeleton.size());
+    e.WriteRawBytes(StringPiece(e_skeleton.data(), e_skeleton.size()));
+  }
+  e.WriteVarlengthBeginning(RecvTensorResponse::kTensorChunkFieldNumber,
+                            chunk.size());
+  EncodeWithTensorData(StringPiece(e.data(), e.size()), val, chunk, result);
+}
+
+void EncodeNamedTensorsToByteBuffer(
+    const protobuf::MessageLite& proto, int tensors_field,
+    const std::vector<std::pair<string, Tensor>>& tensors,
+    ::grpc::ByteBuffer* result) {
+  std::vector<::grpc::Slice> slices;
+  // The encoding that has not been added to "slices" yet.
+  string pending;
+  proto.AppendToString(&pending);
+  for (const auto& named_tensor : tensors) {
+    const string& name = named_tensor.first;
+    const Tensor& val = named_tensor.second;
+    if (!DataTypeCanUseMemcpy(val.dtype())) {
+      NamedTensorProto named_proto;
+      named_proto.set_name(name);
+      val.AsProtoTensorContent(named_proto.mutable_tensor());
+      string encoded;
+      named_proto.AppendToString(&encoded);
+      char header[2 * core::kMaxVarint32Bytes];
+      io::ProtoEncodeHelper e(header, sizeof(header));
+      e.WriteVarlengthBeginning(tensors_field, encoded.size());
+      pending.append(e.data(), e.size());
+      pending.append(encoded);
+      continue;
     }
-    CHECK_EQ(total_bytes, expected_size);
 
-    *result = ::grpc::ByteBuffer(&slices[0], num_slices);
+    // The NamedTensorProto is encoded as in EncodeTensorToByteBuffer(),
+    // with the name in place of the fields of the RecvTensorResponse.
+    gtl::InlinedVector<char, 128> skeleton(SkeletonEncodingSizeUpperBound(val));
+    io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
+    EncodeSkeleton(val, &e_skeleton);
+
+    StringPiece tdata = val.tensor_data();
+    const uint32 tensor_proto_bytes =
+        e_skeleton.size() +
+        VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
+                              tdata.size());
+    const uint32 named_tensor_bytes =
+        VarLengthEncodingSize(NamedTensorProto::kNameFieldNumber,
+                              name.size()) +
+        VarLengthEncodingSize(NamedTensorProto::kTensorFieldNumber,
+                              tensor_proto_bytes);
+    const size_t encoder_size =
+        VarLengthEncodingSize(tensors_field, named_tensor_bytes) -
+        tdata.size();
+    gtl::InlinedVector<char, 1024> space(encoder_size);
+    io::ProtoEncodeHelper e(space.data(), space.size());
+    e.WriteVarlengthBeginning(tensors_field, named_tensor_bytes);
+    e.WriteString(NamedTensorProto::kNameFieldNumber, name);
+    e.WriteVarlengthBeginning(NamedTensorProto::kTensorFieldNumber,
+                              tensor_proto_bytes);
+    e.WriteRawBytes(StringPiece(e_skeleton.data(), e_skeleton.size()));
+    e.WriteVarlengthBeginning(TensorProto::kTensorContentFieldNumber,
+                              tdata.size());
+    pending.append(e.data(), e.size());
+    if (tdata.size() > kLargeTensorBytes) {
+      slices.push_back(CopiedSlice(pending));
+      pending.clear();
+      slices.push_back(SharedTensorDataSlice(val, tdata));
+    } else {
+      pending.append(tdata.data(), tdata.size());
+    }
+  }
+  if (!pending.empty() || slices.empty()) {
+    slices.push_back(CopiedSlice(pending));
   }
+  *result = ::grpc::ByteBuffer(slices.data(), slices.size());
 }
 
 }  // namespace grpc
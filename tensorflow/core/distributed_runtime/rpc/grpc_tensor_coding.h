@@ -16,12 +16,18 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/types.h"
+
 namespace grpc {
 class ByteBuffer;
 }  // namespace grpc
 
 namespace tensorflow {
-class Tensor;
 class RecvTensorResponse;
 
 // TODO(jeff,sanjay): this should not be grpc specific.  Instead of
@@ -45,12 +51,42 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 // control flow operations elsewhere caused the path on which this
 // Tensor exists to not be taken).
 //
-// "val" holds the tensor value to be encoded.
+// "val" holds the tensor value to be encoded.  The data of large tensors
+// is not copied: *result refers to val's buffer, and holds a reference
+// on it until *result has been destroyed, so "val" must not be modified
+// in the meantime.
 //
 // Discards original contents of *result.
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result);
 
+// Encode the "num_bytes" bytes of the content of "val" that start at
+// "offset" into a byte buffer in a format that is parseable as a
+// RecvTensorResponse protocol buffer holding them in "tensor_chunk".
+// The chunk at offset 0 also carries the dtype and shape of "val".  As
+// in EncodeTensorToByteBuffer(), large chunks share val's buffer.
+//
+// REQUIRES: DataTypeCanUseMemcpy(val.dtype()), and the chunk lies
+// within val.tensor_data().
+//
+// Discards original contents of *result.
+void EncodeTensorChunkToByteBuffer(const Tensor& val, int64 offset,
+                                   int64 num_bytes,
+                                   ::grpc::ByteBuffer* result);
+
+// Encodes "proto" followed by a NamedTensorProto for each of "tensors" in
+// the repeated field "tensors_field" of its message type into a byte
+// buffer, which is parseable as that message with the tensors appended to
+// the field.  As in EncodeTensorToByteBuffer(), the data of large tensors
+// is shared, not copied, so "tensors" must not be modified until *result
+// has been destroyed.
+//
+// Discards original contents of *result.
+void EncodeNamedTensorsToByteBuffer(
+    const protobuf::MessageLite& proto, int tensors_field,
+    const std::vector<std::pair<string, Tensor>>& tensors,
+    ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -18,6 +18,7 @@ limitations under the License.
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -100,4 +101,107 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, LargeTensorSharesBuffer) {
+  Tensor t(DT_FLOAT, TensorShape({64, 64}));
+  test::FillIota<float>(&t, 0.0f);
+  const Tensor expected = tensor::DeepCopy(t);
+  const char* data = t.tensor_data().data();
+
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, &buf);
+  // The buffer keeps the tensor data alive after the tensor is gone.
+  t = Tensor();
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  bool shared = false;
+  string tmp;
+  for (const auto& s : slices) {
+    shared |= reinterpret_cast<const char*>(s.begin()) == data;
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  EXPECT_TRUE(shared);
+
+  RecvTensorResponse response;
+  ASSERT_TRUE(response.ParseFromString(tmp));
+  Tensor result_tensor;
+  ASSERT_TRUE(result_tensor.FromProto(response.tensor()));
+  test::ExpectTensorEqual<float>(expected, result_tensor);
+}
+
+TEST_F(GrpcTensorCodingTest, Chunks) {
+  Tensor t(DT_INT32, TensorShape({1000}));
+  test::FillIota<int32>(&t, 0);
+  const StringPiece content = t.tensor_data();
+  const int64 total_bytes = content.size();
+  const int64 chunk_bytes = 1600;
+
+  string received;
+  for (int64 offset = 0; offset < total_bytes; offset += chunk_bytes) {
+    const int64 num_bytes = std::min(chunk_bytes, total_bytes - offset);
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorChunkToByteBuffer(t, offset, num_bytes, &buf);
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+
+    RecvTensorResponse response;
+    ASSERT_TRUE(response.ParseFromString(tmp));
+    EXPECT_EQ(offset == 0, response.has_tensor());
+    if (offset == 0) {
+      EXPECT_EQ(DT_INT32, response.tensor().dtype());
+      EXPECT_EQ(t.shape(), TensorShape(response.tensor().tensor_shape()));
+      EXPECT_TRUE(response.tensor().tensor_content().empty());
+    }
+    EXPECT_EQ(num_bytes, response.tensor_chunk().size());
+    received += response.tensor_chunk();
+  }
+  EXPECT_EQ(content, received);
+}
+
+TEST_F(GrpcTensorCodingTest, NamedTensors) {
+  Tensor large(DT_FLOAT, TensorShape({64, 64}));
+  test::FillIota<float>(&large, 0.0f);
+  std::vector<std::pair<string, Tensor>> tensors = {
+      {"small", test::AsTensor<int32>({1, 2, 3})},
+      {"large", large},
+      {"strings", test::AsTensor<string>({"a", "bc"})},
+      {"", Tensor(DT_INT64, TensorShape({0, 2}))}};
+  RunGraphRequest header;
+  header.set_graph_handle("graph");
+  header.set_step_id(17);
+  header.add_recv_key("recv");
+
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeNamedTensorsToByteBuffer(
+      header, RunGraphRequest::kSendFieldNumber, tensors, &buf);
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  bool shared = false;
+  string tmp;
+  for (const auto& s : slices) {
+    shared |= reinterpret_cast<const char*>(s.begin()) ==
+              large.tensor_data().data();
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  EXPECT_TRUE(shared);
+
+  RunGraphRequest request;
+  ASSERT_TRUE(request.ParseFromString(tmp));
+  EXPECT_EQ("graph", request.graph_handle());
+  EXPECT_EQ(17, request.step_id());
+  ASSERT_EQ(1, request.recv_key_size());
+  EXPECT_EQ("recv", request.recv_key(0));
+  ASSERT_EQ(tensors.size(), request.send_size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(tensors[i].first, request.send(i).name());
+    Tensor result_tensor;
+    ASSERT_TRUE(result_tensor.FromProto(request.send(i).tensor()));
+    EXPECT_EQ(tensors[i].second.DebugString(), result_tensor.DebugString());
+  }
+}
+
 }  // namespace tensorflow
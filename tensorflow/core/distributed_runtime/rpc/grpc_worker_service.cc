@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
+#include <algorithm>
 #include <deque>
+#include <vector>
 
 #include "grpc++/alarm.h"
 #include "grpc++/server_builder.h"
@@ -36,12 +38,15 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -50,15 +55,43 @@ namespace tensorflow {
 
 namespace {
 
+auto* recv_tensor_wait_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/grpc_worker/recv_tensor_wait_usecs",
+     "The time a RecvTensor request waits for its tensor to be produced."},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+monitoring::SamplerCell* const recv_tensor_wait_time =
+    recv_tensor_wait_usecs->GetCell();
+
 class GrpcWorkerService : public AsyncServiceInterface {
  public:
-  GrpcWorkerService(GrpcWorker* worker, ::grpc::ServerBuilder* builder)
-      : worker_(worker), is_shutdown_(false) {
+  GrpcWorkerService(GrpcWorker* worker, const RPCOptions& rpc_options,
+                    ::grpc::ServerBuilder* builder)
+      : worker_(worker),
+        num_polling_threads_per_queue_(
+            std::max(1, rpc_options.num_server_polling_threads_per_queue())),
+        recv_tensor_call_depth_(
+            rpc_options.server_recv_tensor_call_depth() > 0
+                ? rpc_options.server_recv_tensor_call_depth()
+                : 1000),
+        run_call_depth_(rpc_options.server_run_call_depth() > 0
+                            ? rpc_options.server_run_call_depth()
+                            : 100),
+        push_tensor_call_depth_(
+            rpc_options.push_tensors() ? recv_tensor_call_depth_ : 1),
+        is_shutdown_(false) {
     builder->RegisterService(&worker_service_);
-    cq_ = builder->AddCompletionQueue();
+    const int num_queues =
+        std::max(1, rpc_options.num_server_completion_queues());
+    for (int i = 0; i < num_queues; ++i) {
+      cqs_.push_back(builder->AddCompletionQueue());
+    }
   }
 
-  ~GrpcWorkerService() override { delete shutdown_alarm_; }
+  ~GrpcWorkerService() override {
+    for (::grpc::Alarm* alarm : shutdown_alarms_) {
+      delete alarm;
+    }
+  }
 
   void Shutdown() override {
     bool did_shutdown = false;
@@ -72,70 +105,107 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
     if (did_shutdown) {
       // NOTE(mrry): This enqueues a special event (with a null tag)
-      // that causes the completion queue to be shut down on the
+      // that causes the completion queue to be shut down on a
       // polling thread.
-      shutdown_alarm_ =
-          new ::grpc::Alarm(cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+      for (const auto& cq : cqs_) {
+        shutdown_alarms_.push_back(new ::grpc::Alarm(
+            cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr));
+      }
     }
   }
 
 // This macro creates a new request for the given RPC method name
-// (e.g., `ENQUEUE_REQUEST(GetStatus, false);`), and enqueues it on
-// `this->cq_`.
+// (e.g., `ENQUEUE_REQUEST(cq, GetStatus, false);`), and enqueues it on
+// the completion queue `cq`.
 //
-// This macro is invoked one or more times for each RPC method to
-// ensure that there are sufficient completion queue entries to
-// handle incoming requests without blocking.
+// This macro is invoked one or more times for each RPC method and
+// completion queue to ensure that there are sufficient completion
+// queue entries to handle incoming requests without blocking.
 //
 // The implementation of the request handler for each RPC method
 // must ensure that it calls ENQUEUE_REQUEST() for that RPC method,
-// to keep accepting new requests.
-#define ENQUEUE_REQUEST(method, supports_cancel)                       \
+// on the queue of the call it handles, to keep accepting new requests.
+#define ENQUEUE_REQUEST(cq, method, supports_cancel)                   \
   do {                                                                 \
     mutex_lock l(shutdown_mu_);                                        \
     if (!is_shutdown_) {                                               \
       Call<GrpcWorkerService, grpc::WorkerService::AsyncService,       \
            method##Request, method##Response>::                        \
           EnqueueRequestForMethod(                                     \
-              &worker_service_, cq_.get(),                             \
+              &worker_service_, (cq),                                  \
               static_cast<int>(GrpcWorkerMethod::k##method),           \
               &GrpcWorkerService::method##Handler, (supports_cancel)); \
     }                                                                  \
   } while (0)
 
-  // This method blocks forever handling requests from the completion queue.
+  // This method blocks forever handling requests from the completion
+  // queues. It polls the first queue itself, and starts the other
+  // polling threads.
   void HandleRPCsLoop() override {
-    // TODO(mrry): This may require performance engineering. We can
-    // add more threads to service the completion queue, and add more
-    // of various request types if they are short and frequent.
     // Currently we allow unbounded numbers of pending calls for each
     // method, by re-enqueuing a request before the previous one
     // completes, and we may decide to bound some of the request
     // types.
-    ENQUEUE_REQUEST(GetStatus, false);
-    ENQUEUE_REQUEST(CleanupAll, false);
-    ENQUEUE_REQUEST(RegisterGraph, false);
-    ENQUEUE_REQUEST(DeregisterGraph, false);
-
-    // TODO(mrry): Determine a better policy for enqueuing the appropriate
-    // number of each request type.
-    for (int i = 0; i < 1000; ++i) {
-      EnqueueRecvTensorRequestRaw();
-    }
-    for (int i = 0; i < 100; ++i) {
-      ENQUEUE_REQUEST(RunGraph, true);
+    for (const auto& cq_ptr : cqs_) {
+      ::grpc::ServerCompletionQueue* cq = cq_ptr.get();
+      ENQUEUE_REQUEST(cq, GetStatus, false);
+      ENQUEUE_REQUEST(cq, CleanupAll, false);
+      ENQUEUE_REQUEST(cq, RegisterGraph, false);
+      ENQUEUE_REQUEST(cq, DeregisterGraph, false);
+
+      for (int i = 0; i < recv_tensor_call_depth_; ++i) {
+        EnqueueRecvTensorRequestRaw(cq);
+      }
+      for (int i = 0; i < push_tensor_call_depth_; ++i) {
+        ENQUEUE_REQUEST(cq, PushTensor, false);
+      }
+      for (int i = 0; i < run_call_depth_; ++i) {
+        ENQUEUE_REQUEST(cq, RunGraph, true);
+      }
+      for (int i = 0; i < run_call_depth_; ++i) {
+        ENQUEUE_REQUEST(cq, CleanupGraph, false);
+      }
+
+      ENQUEUE_REQUEST(cq, Logging, false);
+      ENQUEUE_REQUEST(cq, Tracing, false);
+      ENQUEUE_REQUEST(cq, GetMetrics, false);
     }
-    for (int i = 0; i < 100; ++i) {
-      ENQUEUE_REQUEST(CleanupGraph, false);
+
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (size_t i = 0; i < cqs_.size(); ++i) {
+      for (int j = (i == 0 ? 1 : 0); j < num_polling_threads_per_queue_;
+           ++j) {
+        ::grpc::ServerCompletionQueue* cq = cqs_[i].get();
+        threads.emplace_back(worker_->env()->env->StartThread(
+            ThreadOptions(), "TF_worker_service",
+            [this, cq]() { PollCompletionQueue(cq); }));
+      }
     }
+    PollCompletionQueue(cqs_[0].get());
+    // Joins the other polling threads.
+    threads.clear();
+  }
 
-    ENQUEUE_REQUEST(Logging, false);
-    ENQUEUE_REQUEST(Tracing, false);
+ private:
+  GrpcWorker* worker_ = nullptr;  // Not owned.
+  std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> cqs_;
+  const int num_polling_threads_per_queue_;
+  const int recv_tensor_call_depth_;
+  const int run_call_depth_;
+  // Tensors are only pushed to this worker if RPCOptions.push_tensors.
+  const int push_tensor_call_depth_;
 
+  grpc::WorkerService::AsyncService worker_service_;
+
+  mutex shutdown_mu_;
+  bool is_shutdown_ GUARDED_BY(shutdown_mu_);
+  std::vector<::grpc::Alarm*> shutdown_alarms_;
+
+  void PollCompletionQueue(::grpc::ServerCompletionQueue* cq) {
     void* tag;
     bool ok;
 
-    while (cq_->Next(&tag, &ok)) {
+    while (cq->Next(&tag, &ok)) {
       UntypedCall<GrpcWorkerService>::Tag* callback_tag =
           static_cast<UntypedCall<GrpcWorkerService>::Tag*>(tag);
       if (callback_tag) {
@@ -143,21 +213,11 @@ class GrpcWorkerService : public AsyncServiceInterface {
       } else {
         // NOTE(mrry): A null `callback_tag` indicates that this is
         // the shutdown alarm.
-        cq_->Shutdown();
+        cq->Shutdown();
       }
     }
   }
 
- private:
-  GrpcWorker* worker_ = nullptr;  // Not owned.
-  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
-
-  grpc::WorkerService::AsyncService worker_service_;
-
-  mutex shutdown_mu_;
-  bool is_shutdown_ GUARDED_BY(shutdown_mu_);
-  ::grpc::Alarm* shutdown_alarm_ = nullptr;
-
   void Schedule(std::function<void()> f) {
     worker_->env()->compute_pool->Schedule(std::move(f));
   }
@@ -167,7 +227,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
   // `HandleRPCsLoop()` when the next Foo RPC is received. Each
   // `FooHandler` call schedules a closure on `worker_->env()->compute_pool`,
   // and is responsible for requesting the next Foo call by calling
-  // `ENQUEUE_REQUEST(Foo)`.
+  // `ENQUEUE_REQUEST(call->cq(), Foo)`.
 
   template <class RequestMessage, class ResponseMessage>
   using WorkerCall = Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
@@ -178,7 +238,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->GetStatus(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(GetStatus, false);
+    ENQUEUE_REQUEST(call->cq(), GetStatus, false);
   }
 
   void CleanupAllHandler(
@@ -187,7 +247,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->CleanupAll(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(CleanupAll, false);
+    ENQUEUE_REQUEST(call->cq(), CleanupAll, false);
   }
 
   void RegisterGraphHandler(
@@ -196,7 +256,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->RegisterGraph(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(RegisterGraph, false);
+    ENQUEUE_REQUEST(call->cq(), RegisterGraph, false);
   }
 
   void DeregisterGraphHandler(
@@ -205,7 +265,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->DeregisterGraph(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(DeregisterGraph, false);
+    ENQUEUE_REQUEST(call->cq(), DeregisterGraph, false);
   }
 
   void RunGraphHandler(WorkerCall<RunGraphRequest, RunGraphResponse>* call) {
@@ -226,7 +286,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
                                call->SendResponse(ToGrpcStatus(s));
                              });
     });
-    ENQUEUE_REQUEST(RunGraph, true);
+    ENQUEUE_REQUEST(call->cq(), RunGraph, true);
   }
 
   void RecvTensorHandlerRaw(
@@ -241,7 +301,16 @@ class GrpcWorkerService : public AsyncServiceInterface {
                                  call->SendResponse(ToGrpcStatus(s));
                                });
     });
-    EnqueueRecvTensorRequestRaw();
+    EnqueueRecvTensorRequestRaw(call->cq());
+  }
+
+  void PushTensorHandler(
+      WorkerCall<PushTensorRequest, PushTensorResponse>* call) {
+    Schedule([this, call]() {
+      Status s = worker_->PushTensor(&call->request, &call->response);
+      call->SendResponse(ToGrpcStatus(s));
+    });
+    ENQUEUE_REQUEST(call->cq(), PushTensor, false);
   }
 
   void CleanupGraphHandler(
@@ -250,7 +319,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->CleanupGraph(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(CleanupGraph, false);
+    ENQUEUE_REQUEST(call->cq(), CleanupGraph, false);
   }
 
   void LoggingHandler(WorkerCall<LoggingRequest, LoggingResponse>* call) {
@@ -258,7 +327,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->Logging(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(Logging, false);
+    ENQUEUE_REQUEST(call->cq(), Logging, false);
   }
 
   void TracingHandler(WorkerCall<TracingRequest, TracingResponse>* call) {
@@ -266,17 +335,26 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Status s = worker_->Tracing(&call->request, &call->response);
       call->SendResponse(ToGrpcStatus(s));
     });
-    ENQUEUE_REQUEST(Tracing, false);
+    ENQUEUE_REQUEST(call->cq(), Tracing, false);
+  }
+
+  void GetMetricsHandler(
+      WorkerCall<GetMetricsRequest, GetMetricsResponse>* call) {
+    Schedule([this, call]() {
+      Status s = worker_->GetMetrics(&call->request, &call->response);
+      call->SendResponse(ToGrpcStatus(s));
+    });
+    ENQUEUE_REQUEST(call->cq(), GetMetrics, false);
   }
 #undef ENQUEUE_REQUEST
 
-  void EnqueueRecvTensorRequestRaw() {
+  void EnqueueRecvTensorRequestRaw(::grpc::ServerCompletionQueue* cq) {
     mutex_lock l(shutdown_mu_);
     if (!is_shutdown_) {
       Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
            RecvTensorRequest, ::grpc::ByteBuffer>::
           EnqueueRequestForMethod(
-              &worker_service_, cq_.get(),
+              &worker_service_, cq,
               static_cast<int>(GrpcWorkerMethod::kRecvTensor),
               &GrpcWorkerService::RecvTensorHandlerRaw,
               true /* supports cancel*/);
@@ -297,9 +375,15 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
                                  const RecvTensorRequest* request,
                                  ::grpc::ByteBuffer* response,
                                  StatusCallback done) {
+  if (request->chunk_offset() != 0) {
+    RecvTensorChunk(request, response, done);
+    return;
+  }
   const int64 step_id = request->step_id();
   WorkerSession* session = env_->session_mgr->WorkerSessionForStepId(step_id);
   const string& key = request->rendezvous_key();
+  const int64 max_chunk_bytes = request->max_chunk_bytes();
+  const RPCOptions::TensorEncoding encoding = request->tensor_encoding();
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
   Status s = Rendezvous::ParseKey(key, &parsed);
@@ -317,12 +401,16 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
   // of execution of the callback lambda body below, an RPC
   // cancellation should abort the rendezvous.
   opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  const int64 start_micros = Env::Default()->NowMicros();
   session->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev](const Status& status,
-                                      const Rendezvous::Args& send_args,
-                                      const Rendezvous::Args& recv_args,
-                                      const Tensor& val, const bool is_dead) {
+      [this, opts, response, done, src_dev, step_id, key, max_chunk_bytes,
+       encoding, start_micros](const Status& status,
+                               const Rendezvous::Args& send_args,
+                               const Rendezvous::Args& recv_args,
+                               const Tensor& val, const bool is_dead) {
+        recv_tensor_wait_time->Add(Env::Default()->NowMicros() -
+                                   start_micros);
         opts->ClearCancelCallback();
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
@@ -337,37 +425,41 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
             if (src_dev->tensorflow_gpu_device_info() && (!on_host)) {
 #if GOOGLE_CUDA
               const DeviceContext* send_dev_context = send_args.device_context;
-              RecvTensorResponse* tmp = new RecvTensorResponse;
-              tmp->set_is_dead(is_dead);
               CHECK(send_dev_context)
                   << "send dev name: " << src_dev->name()
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
-              // "val" is on a GPU. Uses GPUUtil to fill the response proto.
-              StatusCallback response_ready = [response, done,
-                                               tmp](const Status& s) {
-                // The value is now ready to be returned on the wire.
-                tmp->set_send_start_micros(Env::Default()->NowMicros());
-
-                grpc::EncodeRecvTensorResponseToByteBuffer(*tmp, response);
+              if (is_dead) {
+                grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+                done(Status::OK());
+                return;
+              }
+              // Copy "val" into pinned host memory, and then encode the
+              // copy into the response without serializing it into a
+              // TensorProto first: the response then shares the copy's
+              // buffer instead of holding two more copies of the data.
+              AllocatorAttributes host_attrs;
+              host_attrs.set_on_host(true);
+              host_attrs.set_gpu_compatible(true);
+              Tensor* host_copy = new Tensor(src_dev->GetAllocator(host_attrs),
+                                             val.dtype(), val.shape());
+              StatusCallback response_ready = [this, response, done, host_copy,
+                                               step_id, key, max_chunk_bytes,
+                                               encoding](const Status& s) {
+                if (s.ok()) {
+                  EncodeRecvTensor(step_id, key, max_chunk_bytes, encoding,
+                                   false, *host_copy, response);
+                }
                 done(s);
-                delete tmp;
+                delete host_copy;
               };
-
-              // TODO (jeff,sanjay,mrry): Avoid copy on GPU path by
-              // modifying GPUUtil::SetProtoFromGPU to accept a
-              // ::grpc::ByteBuffer to serialize to, rather than
-              // encoding into a protocol buffer and then
-              // serializing that (i.e. figure out how to use
-              // EncodeTensorToByteBuffer on this path rather than
-              // EncodeRecvTensorResponseToByteBuffer)
-              GPUUtil::SetProtoFromGPU(val, src_dev, send_dev_context,
-                                       tmp->mutable_tensor(), is_dead,
-                                       response_ready);
+              GPUUtil::CopyGPUTensorToCPU(src_dev, send_dev_context, &val,
+                                          host_copy, response_ready);
 #else
               done(errors::Internal("No GPU device in process"));
 #endif  // GOOGLE_CUDA
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              EncodeRecvTensor(step_id, key, max_chunk_bytes, encoding,
+                               is_dead, val, response);
               done(Status::OK());
             }
           }
@@ -378,6 +470,104 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
       });
 }
 
+// Tensor content of at most this many bytes is always sent as RAW.
+static const int64 kMinEncodedTensorBytes = 1024;
+
+void GrpcWorker::EncodeRecvTensor(int64 step_id, const string& key,
+                                  int64 max_chunk_bytes,
+                                  RPCOptions::TensorEncoding encoding,
+                                  bool is_dead, const Tensor& val,
+                                  ::grpc::ByteBuffer* response) {
+  if (max_chunk_bytes <= 0 || is_dead || !DataTypeCanUseMemcpy(val.dtype()) ||
+      static_cast<int64>(val.tensor_data().size()) <= max_chunk_bytes) {
+    string encoded;
+    if (encoding != RPCOptions::RAW && !is_dead &&
+        static_cast<int64>(val.TotalBytes()) > kMinEncodedTensorBytes &&
+        EncodeTensorContent(encoding, val, &encoded)) {
+      // The tensor proto carries only the dtype and shape.
+      RecvTensorResponse proto;
+      proto.mutable_tensor()->set_dtype(val.dtype());
+      val.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+      proto.set_tensor_encoding(encoding);
+      proto.mutable_encoded_tensor_content()->swap(encoded);
+      proto.set_send_start_micros(Env::Default()->NowMicros());
+      grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+    } else {
+      grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+    }
+    return;
+  }
+  {
+    mutex_lock l(chunk_mu_);
+    ChunkedTensor& chunked = chunked_tensors_[std::make_pair(step_id, key)];
+    const int64 num_chunks =
+        (val.tensor_data().size() + max_chunk_bytes - 1) / max_chunk_bytes;
+    chunked.tensor = val;
+    chunked.chunk_bytes = max_chunk_bytes;
+    chunked.sent.assign(num_chunks, false);
+    chunked.sent[0] = true;
+    chunked.chunks_left = num_chunks - 1;
+  }
+  grpc::EncodeTensorChunkToByteBuffer(val, 0, max_chunk_bytes, response);
+}
+
+void GrpcWorker::RecvTensorChunk(const RecvTensorRequest* request,
+                                 ::grpc::ByteBuffer* response,
+                                 StatusCallback done) {
+  const int64 offset = request->chunk_offset();
+  const int64 max_chunk_bytes = request->max_chunk_bytes();
+  Tensor val;
+  int64 num_bytes = 0;
+  Status s;
+  {
+    mutex_lock l(chunk_mu_);
+    auto it = chunked_tensors_.find(
+        std::make_pair(request->step_id(), request->rendezvous_key()));
+    if (it == chunked_tensors_.end()) {
+      s = errors::FailedPrecondition("No chunked transfer of ",
+                                     request->rendezvous_key(),
+                                     " is in progress for step ",
+                                     request->step_id());
+    } else {
+      ChunkedTensor& chunked = it->second;
+      const int64 total_bytes = chunked.tensor.tensor_data().size();
+      if (max_chunk_bytes != chunked.chunk_bytes || offset < 0 ||
+          offset >= total_bytes || offset % max_chunk_bytes != 0) {
+        s = errors::InvalidArgument("Invalid chunk at offset ", offset,
+                                    " of ", request->rendezvous_key());
+      } else {
+        val = chunked.tensor;
+        num_bytes = std::min(max_chunk_bytes, total_bytes - offset);
+        const int64 chunk = offset / max_chunk_bytes;
+        if (!chunked.sent[chunk]) {
+          chunked.sent[chunk] = true;
+          --chunked.chunks_left;
+        }
+        if (chunked.chunks_left == 0) {
+          chunked_tensors_.erase(it);
+        }
+      }
+    }
+  }
+  if (s.ok()) {
+    grpc::EncodeTensorChunkToByteBuffer(val, offset, num_bytes, response);
+  }
+  done(s);
+}
+
+void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
+                                   CleanupGraphResponse* response,
+                                   StatusCallback done) {
+  const int64 step_id = request->step_id();
+  {
+    mutex_lock l(chunk_mu_);
+    chunked_tensors_.erase(
+        chunked_tensors_.lower_bound(std::make_pair(step_id, string())),
+        chunked_tensors_.lower_bound(std::make_pair(step_id + 1, string())));
+  }
+  Worker::CleanupGraphAsync(request, response, std::move(done));
+}
+
 WorkerEnv* GrpcWorker::env() { return env_; }
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
@@ -385,9 +575,10 @@ std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
 }
 
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
-    GrpcWorker* worker, ::grpc::ServerBuilder* builder) {
+    GrpcWorker* worker, const RPCOptions& rpc_options,
+    ::grpc::ServerBuilder* builder) {
   return std::unique_ptr<AsyncServiceInterface>(
-      new GrpcWorkerService(worker, builder));
+      new GrpcWorkerService(worker, rpc_options, builder));
 }
 
 }  // namespace tensorflow
@@ -16,7 +16,15 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace grpc {
 class ByteBuffer;
@@ -34,17 +42,57 @@ class GrpcWorker : public Worker {
   GrpcWorker(WorkerEnv* env);
 
   // Specialized version of RecvTensor for gRPC, which avoids a copy.
+  // Tensors may be sent in chunks, see RecvTensorRequest.max_chunk_bytes.
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        ::grpc::ByteBuffer* response, StatusCallback done);
 
+  // Also forgets the tensors of the step whose chunks are being sent.
+  void CleanupGraphAsync(const CleanupGraphRequest* request,
+                         CleanupGraphResponse* response,
+                         StatusCallback done) override;
+
   WorkerEnv* env();
+
+ private:
+  // Encodes "val" into "*response", or only its first chunk if the
+  // request allows chunks of "max_chunk_bytes" and "val" is larger. In
+  // the latter case "val" is kept for the requests of the other chunks.
+  // Unchunked content is encoded with "encoding" if that makes it smaller.
+  void EncodeRecvTensor(int64 step_id, const string& key,
+                        int64 max_chunk_bytes,
+                        RPCOptions::TensorEncoding encoding, bool is_dead,
+                        const Tensor& val, ::grpc::ByteBuffer* response);
+
+  // Responds to a request for a chunk after the first of a tensor that
+  // EncodeRecvTensor() has kept. The tensor is forgotten once each of its
+  // chunks has been sent; a chunk requested again before, e.g. by a retried
+  // call, is sent again.
+  void RecvTensorChunk(const RecvTensorRequest* request,
+                       ::grpc::ByteBuffer* response, StatusCallback done);
+
+  // A tensor whose chunks are being sent.
+  struct ChunkedTensor {
+    Tensor tensor;
+    int64 chunk_bytes;
+    std::vector<bool> sent;  // Whether each chunk has been sent.
+    int64 chunks_left;       // The number of chunks not sent yet.
+  };
+
+  mutex chunk_mu_;
+  // Keyed by step id and rendezvous key.
+  std::map<std::pair<int64, string>, ChunkedTensor> chunked_tensors_
+      GUARDED_BY(chunk_mu_);
+
+  friend class GrpcWorkerTest;
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env);
 
-// Returns an implementation of WorkerService rpc service.
+// Returns an implementation of WorkerService rpc service, which polls
+// as many completion queues as "rpc_options" asks for.
 std::unique_ptr<AsyncServiceInterface> NewGrpcWorkerService(
-    GrpcWorker* worker, ::grpc::ServerBuilder* builder);
+    GrpcWorker* worker, const RPCOptions& rpc_options,
+    ::grpc::ServerBuilder* builder);
 
 }  // namespace tensorflow
 
@@ -26,6 +26,7 @@ limitations under the License.
 #include "grpc++/impl/codegen/sync_stream.h"
 #include "grpc++/support/byte_buffer.h"
 
+#include "tensorflow/core/distributed_runtime/message_wrappers.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_serialization_traits.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -36,6 +37,8 @@ TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RegisterGraphRequest);
 TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RunGraphRequest);
 // Contains potentially large StepStats, TensorProto.
 TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::RunGraphResponse);
+// Contains potentially large TensorProto.
+TF_GRPC_ALLOW_UNLIMITED_MESSAGE_SIZE(tensorflow::PushTensorRequest);
 
 namespace tensorflow {
 class GrpcByteSource : public TensorResponse::Source {
@@ -102,6 +105,41 @@ class SerializationTraits<tensorflow::TensorResponse>
     return result;
   }
 };
+
+// Support parsing of tensorflow::InMemoryRunGraphResponse.
+// Wire-format is identical to RunGraphResponse.
+template <>
+class SerializationTraits<tensorflow::InMemoryRunGraphResponse>
+    : public UnlimitedSizeProtoSerializationTraits<
+          tensorflow::InMemoryRunGraphResponse> {
+ public:
+  static Status Serialize(const tensorflow::InMemoryRunGraphResponse& msg,
+                          grpc_byte_buffer** bp, bool* own_buffer) {
+    LOG(FATAL) << "Not implemented: RunGraphResponse is only parsed into an "
+                  "InMemoryRunGraphResponse";
+    return Status();
+  }
+  static Status Deserialize(grpc_byte_buffer* buffer,
+                            tensorflow::InMemoryRunGraphResponse* msg,
+                            int max_message_size = INT_MAX) {
+    if (buffer == nullptr) {
+      return Status(StatusCode::INTERNAL, "No payload");
+    }
+    Status result = g_core_codegen_interface->ok();
+    if (result.ok()) {
+      ::tensorflow::GrpcByteSource source(buffer);
+      auto s = ::tensorflow::ParseRunGraphResponse(
+          &source, ::tensorflow::cpu_allocator(), msg);
+      if (!s.ok()) {
+        result = Status(StatusCode::INTERNAL,
+                        ::tensorflow::strings::StrCat(
+                            "RunGraphResponse parse error", s.ToString()));
+      }
+    }
+    g_core_codegen_interface->grpc_byte_buffer_destroy(buffer);
+    return result;
+  }
+};
 }  // namespace grpc
 
 namespace tensorflow {
@@ -116,11 +154,13 @@ enum class GrpcWorkerMethod {
   kCleanupGraph,
   kCleanupAll,
   kRecvTensor,
+  kPushTensor,
   kLogging,
   kTracing,
+  kGetMetrics,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kTracing) + 1;
+    static_cast<int>(GrpcWorkerMethod::kGetMetrics) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
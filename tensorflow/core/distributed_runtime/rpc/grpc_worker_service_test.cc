@@ -0,0 +1,124 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
+
+#include "grpc++/support/byte_buffer.h"
+#include "grpc++/support/slice.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+class GrpcWorkerTest : public ::testing::Test {
+ protected:
+  // The chunked transfers don't use the worker env.
+  GrpcWorkerTest() : worker_(nullptr) {}
+
+  // Starts a chunked transfer of "val" as the RecvTensor call of "key"
+  // would, and returns the content of its first chunk.
+  string StartChunks(int64 step_id, const string& key, int64 chunk_bytes,
+                     const Tensor& val) {
+    ::grpc::ByteBuffer buf;
+    worker_.EncodeRecvTensor(step_id, key, chunk_bytes, RPCOptions::RAW,
+                             false, val, &buf);
+    return ChunkContent(buf);
+  }
+
+  // Requests the chunk at "offset", setting "*content" to its content.
+  Status RecvChunk(int64 step_id, const string& key, int64 chunk_bytes,
+                   int64 offset, string* content) {
+    RecvTensorRequest request;
+    request.set_step_id(step_id);
+    request.set_rendezvous_key(key);
+    request.set_max_chunk_bytes(chunk_bytes);
+    request.set_chunk_offset(offset);
+    ::grpc::ByteBuffer buf;
+    Status status;
+    worker_.RecvTensorAsync(nullptr, &request, &buf,
+                            [&status](const Status& s) { status = s; });
+    if (status.ok()) {
+      *content = ChunkContent(buf);
+    }
+    return status;
+  }
+
+  bool IsKept(int64 step_id, const string& key) {
+    mutex_lock l(worker_.chunk_mu_);
+    return worker_.chunked_tensors_.count(std::make_pair(step_id, key)) > 0;
+  }
+
+  static string ChunkContent(const ::grpc::ByteBuffer& buf) {
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+    RecvTensorResponse response;
+    EXPECT_TRUE(response.ParseFromString(tmp));
+    return response.tensor_chunk();
+  }
+
+  GrpcWorker worker_;
+};
+
+TEST_F(GrpcWorkerTest, ChunkRequestedTwice) {
+  Tensor t(DT_INT32, TensorShape({1000}));
+  test::FillIota<int32>(&t, 0);
+  const string content = t.tensor_data().ToString();
+  const int64 chunk_bytes = 1600;
+
+  EXPECT_EQ(content.substr(0, chunk_bytes),
+            StartChunks(1, "key", chunk_bytes, t));
+  string chunk;
+  TF_EXPECT_OK(RecvChunk(1, "key", chunk_bytes, 1600, &chunk));
+  EXPECT_EQ(content.substr(1600, chunk_bytes), chunk);
+
+  // A retried request gets the same chunk, and doesn't count as the last one.
+  chunk.clear();
+  TF_EXPECT_OK(RecvChunk(1, "key", chunk_bytes, 1600, &chunk));
+  EXPECT_EQ(content.substr(1600, chunk_bytes), chunk);
+  EXPECT_TRUE(IsKept(1, "key"));
+
+  TF_EXPECT_OK(RecvChunk(1, "key", chunk_bytes, 3200, &chunk));
+  EXPECT_EQ(content.substr(3200), chunk);
+  EXPECT_FALSE(IsKept(1, "key"));
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      RecvChunk(1, "key", chunk_bytes, 3200, &chunk)));
+}
+
+TEST_F(GrpcWorkerTest, InvalidChunks) {
+  Tensor t(DT_INT32, TensorShape({1000}));
+  test::FillIota<int32>(&t, 0);
+  StartChunks(1, "key", 1600, t);
+
+  string chunk;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(RecvChunk(1, "key", 1600, 800, &chunk)));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(RecvChunk(1, "key", 1600, 4800, &chunk)));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(RecvChunk(1, "key", 800, 1600, &chunk)));
+  EXPECT_TRUE(
+      errors::IsFailedPrecondition(RecvChunk(2, "key", 1600, 1600, &chunk)));
+  EXPECT_TRUE(IsKept(1, "key"));
+}
+
+}  // namespace tensorflow
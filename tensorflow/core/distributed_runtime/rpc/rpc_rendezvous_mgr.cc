@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -39,8 +40,16 @@ namespace {
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, const string& worker_name,
-                      WorkerCacheInterface* cache, int64 step_id)
-      : BaseRemoteRendezvous(env, worker_name, step_id, false), cache_(cache) {}
+                      WorkerCacheInterface* cache, int64 step_id,
+                      const RPCOptions& rpc_options)
+      : BaseRemoteRendezvous(env, worker_name, step_id, false),
+        cache_(cache),
+        rpc_options_(rpc_options) {}
+
+  // Pushes "val" to the worker of its destination if IsPushed(parsed),
+  // and otherwise buffers it for a RecvTensor call from that worker.
+  Status Send(const ParsedKey& parsed, const Rendezvous::Args& args,
+              const Tensor& val, const bool is_dead) override;
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -50,18 +59,42 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Returns true if the tensor for "parsed" is pushed by the worker that
+  // produces it instead of fetched by the worker that consumes it, see
+  // RPCOptions.push_tensors.  Only tensors that are produced in host
+  // memory are pushed.
+  bool IsPushed(const Rendezvous::ParsedKey& parsed) {
+    return rpc_options_.push_tensors() && parsed.src.type == "CPU" &&
+           (parsed.dst.type == "CPU" || parsed.dst.type == "GPU") &&
+           !IsSameWorker(parsed.src, parsed.dst);
+  }
+
   WorkerCacheInterface* const cache_;  // Not owned.
+  const RPCOptions rpc_options_;
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
+// Maximum number of chunk requests that a RpcRecvTensorCall keeps in
+// flight for a tensor that is transferred in chunks.
+static const int kMaxChunksInFlight = 4;
+
 // Used only to retrieve tensors from remote processes.
+//
+// If chunked transfers are enabled, the call asks the sender to return
+// large tensors in chunks. The first response then carries the dtype
+// and shape, and the first chunk, and the call fetches the remaining
+// chunks with up to kMaxChunksInFlight concurrent requests, each of which
+// is decoded straight into the destination tensor. Tensors for devices
+// other than the CPU are assembled in pinned host memory and copied to
+// the device once complete.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
   RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
 
   void Init(WorkerInterface* wi, int64 step_id, StringPiece key,
             AllocatorAttributes alloc_attrs, Device* dst_device,
-            const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+            const Rendezvous::Args& recv_args, const RPCOptions& rpc_options,
+            Rendezvous::DoneCallback done) {
     wi_ = wi;
     alloc_attrs_ = alloc_attrs;
     dst_device_ = dst_device;
@@ -69,6 +102,16 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     done_ = std::move(done);
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_tensor_encoding(rpc_options.recv_tensor_encoding());
+    const int64 chunk_bytes = rpc_options.recv_tensor_chunk_bytes();
+    const bool on_host = alloc_attrs_.on_host() ||
+                         dst_device_->attributes().device_type() == "CPU";
+    if (chunk_bytes > 0 &&
+        (on_host || dst_device_->tensorflow_gpu_device_info() != nullptr)) {
+      chunk_bytes_ = chunk_bytes;
+      stage_on_host_ = !on_host;
+      req_.set_max_chunk_bytes(chunk_bytes);
+    }
   }
 
   void Reset(WorkerCacheInterface* wc) {
@@ -80,9 +123,17 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     // opts_ appropriately.
     req_.Clear();
     resp_.Clear();
+    chunk_bytes_ = 0;
+    stage_on_host_ = false;
+    device_tensor_ = Tensor();
+    has_device_tensor_ = false;
     {
       mutex_lock l(mu_);
       status_ = Status::OK();
+      total_bytes_ = 0;
+      next_chunk_offset_ = 0;
+      finishing_ = false;
+      recv_done_ = nullptr;
     }
     done_ = nullptr;
   }
@@ -104,6 +155,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     {
       mutex_lock l(mu_);
       status_.Update(s);
+      for (ChunkCall* chunk : active_chunks_) {
+        chunk->opts.StartCancel();
+      }
     }
     opts_.StartCancel();
   }
@@ -113,7 +167,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     return status_;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const {
+    return has_device_tensor_ ? device_tensor_ : resp_.tensor();
+  }
 
   bool is_dead() const { return resp_.metadata().is_dead(); }
 
@@ -124,9 +180,22 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
  private:
   friend class RpcRemoteRendezvous;
 
+  // The request and response for one chunk after the first.
+  struct ChunkCall {
+    int64 offset;
+    CallOptions opts;
+    RecvTensorRequest req;
+    TensorResponse resp;
+  };
+
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
-    resp_.InitAlloc(dst_device_, alloc_attrs_);
+    AllocatorAttributes attrs = alloc_attrs_;
+    if (stage_on_host_) {
+      attrs.set_on_host(true);
+      attrs.set_gpu_compatible(true);
+    }
+    resp_.InitAlloc(dst_device_, attrs);
     using namespace std::placeholders;
     StatusCallback cb = std::bind(
         [this](std::function<void()> recv_done,
@@ -135,13 +204,130 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
           if (!s.ok()) {
             mutex_lock l(mu_);
             status_.Update(s);
+          } else if (resp_.chunk_bytes() > 0) {
+            StartChunks(std::move(recv_done));
+            return;
           }
-          recv_done();
+          FinishRecv(std::move(recv_done));
         },
         std::move(recv_done), _1);
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
   }
 
+  // Starts fetching the chunks after the first, which resp_ holds.
+  void StartChunks(std::function<void()> recv_done) {
+    {
+      mutex_lock l(mu_);
+      recv_done_ = std::move(recv_done);
+      total_bytes_ = resp_.tensor().TotalBytes();
+      next_chunk_offset_ = resp_.chunk_bytes();
+      if (resp_.chunk_bytes() != chunk_bytes_) {
+        status_.Update(errors::Internal("Received a chunk of ",
+                                        resp_.chunk_bytes(),
+                                        " bytes, but requested chunks of ",
+                                        chunk_bytes_, " bytes"));
+      }
+    }
+    int started = 0;
+    while (started < kMaxChunksInFlight && StartNextChunk()) {
+      ++started;
+    }
+    if (started == 0) {
+      MaybeFinishChunks();
+    }
+  }
+
+  // Starts the request for the next chunk. Returns false if there is no
+  // chunk left to request, or the call has failed.
+  bool StartNextChunk() {
+    ChunkCall* chunk = new ChunkCall;
+    {
+      mutex_lock l(mu_);
+      if (!status_.ok() || next_chunk_offset_ >= total_bytes_) {
+        delete chunk;
+        return false;
+      }
+      chunk->offset = next_chunk_offset_;
+      next_chunk_offset_ += chunk_bytes_;
+      active_chunks_.insert(chunk);
+    }
+    chunk->req = req_;
+    chunk->req.set_chunk_offset(chunk->offset);
+    chunk->resp.InitChunk(resp_, chunk->offset);
+    wi_->RecvTensorAsync(&chunk->opts, &chunk->req, &chunk->resp,
+                         [this, chunk](const Status& s) {
+                           ChunkDone(chunk, s);
+                         });
+    return true;
+  }
+
+  void ChunkDone(ChunkCall* chunk, Status s) {
+    {
+      mutex_lock l(mu_);
+      const int64 expected_bytes =
+          std::min(chunk_bytes_, total_bytes_ - chunk->offset);
+      if (s.ok() && chunk->resp.chunk_bytes() != expected_bytes) {
+        s = errors::Internal("Expected ", expected_bytes,
+                             " bytes in the chunk at offset ", chunk->offset,
+                             " but received ", chunk->resp.chunk_bytes());
+      }
+      status_.Update(s);
+      active_chunks_.erase(chunk);
+    }
+    delete chunk;
+    if (!StartNextChunk()) {
+      MaybeFinishChunks();
+    }
+  }
+
+  // Finishes the call once no chunk request is in flight any more.
+  void MaybeFinishChunks() {
+    std::function<void()> recv_done;
+    {
+      mutex_lock l(mu_);
+      if (!active_chunks_.empty() || finishing_) return;
+      finishing_ = true;
+      recv_done = std::move(recv_done_);
+    }
+    FinishRecv(std::move(recv_done));
+  }
+
+  // Copies the received tensor to the destination device if it was
+  // staged in host memory, and then calls "recv_done".
+  void FinishRecv(std::function<void()> recv_done) {
+    if (!stage_on_host_ || !status().ok() || is_dead()) {
+      recv_done();
+      return;
+    }
+    const Tensor& host_tensor = resp_.tensor();
+    device_tensor_ = Tensor(dst_device_->GetAllocator(alloc_attrs_),
+                            host_tensor.dtype(), host_tensor.shape());
+    if (!device_tensor_.IsInitialized()) {
+      {
+        mutex_lock l(mu_);
+        status_.Update(errors::ResourceExhausted(
+            "OOM when allocating tensor with shape ",
+            host_tensor.shape().DebugString(), " on ", dst_device_->name()));
+      }
+      recv_done();
+      return;
+    }
+    has_device_tensor_ = true;
+    DeviceContext* dev_context = recv_args_.device_context;
+    if (dev_context == nullptr) {
+      dev_context = dst_device_->tensorflow_gpu_device_info()->default_context;
+    }
+    dev_context->CopyCPUTensorToDevice(
+        &host_tensor, dst_device_, &device_tensor_,
+        [this, recv_done](const Status& s) {
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            status_.Update(s);
+          }
+          recv_done();
+        });
+  }
+
   string src_worker_;
   string src_rel_device_;
   WorkerInterface* wi_;
@@ -153,8 +339,21 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   Rendezvous::Args recv_args_;
   Rendezvous::DoneCallback done_;
 
+  // Size of the chunks to request, or 0 if tensors are not chunked.
+  int64 chunk_bytes_ = 0;
+  // True iff resp_ receives into host memory, from which the tensor is
+  // copied to device_tensor_ on dst_device_.
+  bool stage_on_host_ = false;
+  Tensor device_tensor_;
+  bool has_device_tensor_ = false;
+
   mutable mutex mu_;
   Status status_ GUARDED_BY(mu_);
+  int64 total_bytes_ GUARDED_BY(mu_) = 0;
+  int64 next_chunk_offset_ GUARDED_BY(mu_) = 0;
+  std::unordered_set<ChunkCall*> active_chunks_ GUARDED_BY(mu_);
+  bool finishing_ GUARDED_BY(mu_) = false;
+  std::function<void()> recv_done_ GUARDED_BY(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorCall);
 };
@@ -270,9 +469,61 @@ class WorkerFreeListCache : public WorkerCacheInterface {
   std::unordered_map<string, WorkerState> workers_ GUARDED_BY(mu_);
 };
 
+Status RpcRemoteRendezvous::Send(const ParsedKey& parsed,
+                                 const Rendezvous::Args& args,
+                                 const Tensor& val, const bool is_dead) {
+  if (!IsPushed(parsed)) {
+    return BaseRemoteRendezvous::Send(parsed, args, val, is_dead);
+  }
+  TF_RETURN_IF_ERROR(ValidateDevices(parsed, true /* is_src */));
+  string dst_worker;
+  string dst_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.dst_device, &dst_worker,
+                                        &dst_rel_device)) {
+    return errors::Internal(parsed.dst_device,
+                            " is invalid remote destination device.");
+  }
+  WorkerInterface* wi = cache_->CreateWorker(dst_worker);
+  if (wi == nullptr) {
+    return errors::Internal("No worker known as ", dst_worker);
+  }
+
+  struct Call {
+    PushTensorRequest req;
+    PushTensorResponse resp;
+  };
+  Call* call = new Call;
+  call->req.set_step_id(step_id_);
+  call->req.set_rendezvous_key(parsed.FullKey().ToString());
+  call->req.set_is_dead(is_dead);
+  if (!is_dead) {
+    val.AsProtoTensorContent(call->req.mutable_tensor());
+    RecordSentTensor(parsed, val);
+  }
+  // A failed push leaves the consumer waiting, so it fails the step here,
+  // which makes the master abort the step on every worker.
+  Ref();
+  wi->PushTensorAsync(&call->req, &call->resp,
+                      [this, call, wi, dst_worker](const Status& s) {
+                        if (!s.ok()) {
+                          StartAbort(s);
+                        }
+                        cache_->ReleaseWorker(dst_worker, wi);
+                        delete call;
+                        Unref();
+                      });
+  return Status::OK();
+}
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
+  // The producer pushes the tensor into the local rendezvous.
+  if (IsPushed(parsed)) {
+    RecvPushedAsync(parsed, recv_args, std::move(done));
+    return;
+  }
+
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -300,19 +551,22 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   }
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+             recv_args, rpc_options_, std::move(done));
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
 
   // Start "call".
   Ref();
-  call->Start([this, call]() {
+  call->Start([this, call, parsed]() {
     // Removes "call" from active_. Prevent StartAbort().
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
     // current status should be bad.
     Status s = call->status();
+    if (s.ok() && !call->is_dead()) {
+      RecordReceivedTensor(parsed, call->tensor());
+    }
     call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
     cache_->ReleaseWorker(call->src_worker_, call->wi_);
     call->wi_ = nullptr;
@@ -325,15 +579,17 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env,
                                    const string& worker_name,
-                                   WorkerCacheInterface* worker_cache)
+                                   WorkerCacheInterface* worker_cache,
+                                   const RPCOptions& rpc_options)
     : BaseRendezvousMgr(env, worker_name),
-      cache_(new WorkerFreeListCache(worker_cache)) {}
+      cache_(new WorkerFreeListCache(worker_cache)),
+      rpc_options_(rpc_options) {}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env,
                                                const string& worker_name) {
   return new RpcRemoteRendezvous(worker_env, worker_name, cache_.get(),
-                                 step_id);
+                                 step_id, rpc_options_);
 }
 
 }  // end namespace tensorflow
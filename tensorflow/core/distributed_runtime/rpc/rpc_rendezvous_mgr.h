@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -42,10 +43,16 @@ namespace tensorflow {
 //
 // Tensors sent and recved through rendezvous managed by this
 // RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+//
+// "rpc_options" controls how tensors are fetched from other workers:
+// whether large tensors are fetched in chunks (see
+// RPCOptions.recv_tensor_chunk_bytes), and how their content is encoded
+// on the wire (see RPCOptions.recv_tensor_encoding).
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env, const string& worker_name,
-                            WorkerCacheInterface* worker_cache);
+                            WorkerCacheInterface* worker_cache,
+                            const RPCOptions& rpc_options = RPCOptions());
 
  protected:
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env,
@@ -55,6 +62,8 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
   // Private cache_ that allows us to reuse WorkerInterface objects.
   std::unique_ptr<WorkerCacheInterface> cache_;
 
+  const RPCOptions rpc_options_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
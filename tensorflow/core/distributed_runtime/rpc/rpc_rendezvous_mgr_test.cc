@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
@@ -101,6 +102,43 @@ TEST_F(RpcRendezvousMgrTest, LocalSendRecv) {
   rmgr_.Cleanup(step_id);
 }
 
+// Returns the value of the point of "metric" whose label is "label", or -1
+// if there is no such point.
+int64 MetricValue(const string& metric, const string& label) {
+  const std::unique_ptr<monitoring::CollectedMetrics> collected =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = collected->point_set_map.find(metric);
+  if (it == collected->point_set_map.end()) return -1;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == label) {
+      return point->int64_value;
+    }
+  }
+  return -1;
+}
+
+TEST_F(RpcRendezvousMgrTest, SentTensorBytesByProducer) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:3/cpu:0", "edge_5_var/read",
+      FrameAndIter(0, 0)));
+  const Tensor sent = V("peach");
+  {
+    Rendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    Rendezvous::Args args;
+    TF_ASSERT_OK(rendez->Send(key, args, sent, false));
+  }
+  Tensor val(DT_FLOAT);
+  bool val_dead = false;
+  TF_ASSERT_OK(rmgr_.RecvLocal(step_id, key, &val, &val_dead));
+  EXPECT_EQ(static_cast<int64>(sent.TotalBytes()),
+            MetricValue("/tensorflow/core/rendezvous/sent_tensor_bytes",
+                        "var/read"));
+  rmgr_.Cleanup(step_id);
+}
+
 TEST_F(RpcRendezvousMgrTest, LocalAbort) {
   const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
       "/job:mnist/replica:1/task:2/cpu:0", 7890,
@@ -150,6 +188,39 @@ TEST_F(RpcRendezvousMgrTest, CleanupAll) {
   }
 }
 
+TEST_F(RpcRendezvousMgrTest, PushedRecv) {
+  RPCOptions rpc_options;
+  rpc_options.set_push_tensors(true);
+  RpcRendezvousMgr push_rmgr(&env, worker_session_.worker_name, cache_,
+                             rpc_options);
+  const int64 step_id = 123;
+  // Produced on another worker, which pushes the tensor.
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:0", "foo", FrameAndIter(0, 0)));
+  {
+    Rendezvous* rendez = push_rmgr.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    SchedClosure([&push_rmgr, key]() {
+      TF_EXPECT_OK(push_rmgr.AcceptPushedTensor(step_id, key, V("peach"),
+                                                false));
+    });
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    Rendezvous::Args args;
+    TF_ASSERT_OK(rendez->Recv(key, args, &val, &val_dead));
+    EXPECT_EQ(V(val), "peach");
+    EXPECT_FALSE(val_dead);
+  }
+  // A tensor for another worker is not accepted.
+  const Rendezvous::ParsedKey other_key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:4/cpu:0", "foo", FrameAndIter(0, 0)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      push_rmgr.AcceptPushedTensor(step_id, other_key, V("peach"), false)));
+  push_rmgr.Cleanup(step_id);
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/default_device.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -247,4 +248,89 @@ BENCHMARK(BM_SingleDevice)
     ->ArgPair(4, 10000)
     ->ArgPair(1, 1000000);
 
+// Starts a "ps" and a "worker" task whose servers poll "num_queues"
+// completion queues each, and returns the target of the worker.
+// The servers are never shut down.
+static string StartParameterServerCluster(int num_queues) {
+  const int ps_port = testing::PickUnusedPortOrDie();
+  const int worker_port = testing::PickUnusedPortOrDie();
+  for (const string& job_name : {"ps", "worker"}) {
+    ServerDef server;
+    server.set_protocol("grpc");
+    server.set_job_name(job_name);
+    server.set_task_index(0);
+    auto ps_job = server.mutable_cluster()->add_job();
+    ps_job->set_name("ps");
+    (*ps_job->mutable_tasks())[0] = strings::StrCat("localhost:", ps_port);
+    auto worker_job = server.mutable_cluster()->add_job();
+    worker_job->set_name("worker");
+    (*worker_job->mutable_tasks())[0] =
+        strings::StrCat("localhost:", worker_port);
+
+    auto config = server.mutable_default_session_config();
+    (*config->mutable_device_count())["CPU"] = 1;
+    config->mutable_rpc_options()->set_num_server_completion_queues(
+        num_queues);
+
+    std::unique_ptr<ServerInterface> svr;
+    TF_CHECK_OK(NewServer(server, &svr));
+    TF_CHECK_OK(svr->Start());
+    svr.release();
+  }
+  return strings::StrCat("grpc://localhost:", worker_port);
+}
+
+// Runs steps from "num_clients" concurrent sessions, each of which fetches
+// a tensor from the parameter server, so that the ps serves RunGraph and
+// RecvTensor calls of all clients at the same time.
+static void BM_ConcurrentClients(int iters, int num_clients, int num_queues) {
+  testing::StopTiming();
+  SessionOptions options;
+  options.target = StartParameterServerCluster(num_queues);
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  Scope s = Scope::NewRootScope();
+  Output x = Const(s.WithOpName("x").WithDevice("/job:ps/task:0/cpu:0"),
+                   1.0f, {1000});
+  Identity(s.WithOpName("y").WithDevice("/job:worker/task:0/cpu:0"), x);
+  GraphDef def;
+  TF_CHECK_OK(s.ToGraphDef(&def));
+
+  std::vector<std::unique_ptr<Session>> sessions;
+  for (int i = 0; i < num_clients; ++i) {
+    sessions.emplace_back(NewSession(options));
+    TF_CHECK_OK(sessions.back()->Create(def));
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(sessions.back()->Run({}, {"y:0"}, {}, &outputs));
+  }
+  testing::SetLabel(strings::StrCat(num_clients, " clients; ", num_queues,
+                                    " completion queues"));
+
+  thread::ThreadPool clients(Env::Default(), "clients", num_clients);
+  BlockingCounter counter(num_clients);
+  testing::StartTiming();
+  for (int i = 0; i < num_clients; ++i) {
+    const int steps = iters / num_clients + (i < iters % num_clients ? 1 : 0);
+    Session* session = sessions[i].get();
+    clients.Schedule([session, steps, &counter]() {
+      std::vector<Tensor> outputs;
+      for (int step = 0; step < steps; ++step) {
+        outputs.clear();
+        TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+  for (auto& session : sessions) {
+    TF_CHECK_OK(session->Close());
+  }
+}
+BENCHMARK(BM_ConcurrentClients)
+    ->ArgPair(100, 1)
+    ->ArgPair(100, 4)
+    ->ArgPair(200, 1)
+    ->ArgPair(200, 4);
+
 }  // namespace tensorflow
@@ -59,7 +59,8 @@ Status SessionMgr::CreateSession(const string& session,
   TF_RETURN_IF_ERROR(worker_cache_factory_(server_def, &worker_cache));
 
   std::unique_ptr<RendezvousMgrInterface> rendezvous_mgr(
-      new RpcRendezvousMgr(worker_env_, worker_name, worker_cache));
+      new RpcRendezvousMgr(worker_env_, worker_name, worker_cache,
+                           server_def.default_session_config().rpc_options()));
 
   std::unique_ptr<GraphMgr> graph_mgr(
       new GraphMgr(worker_env_, rendezvous_mgr.get()));
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 
@@ -26,12 +29,15 @@ void TensorResponse::Clear() {
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
   already_used_ = false;
+  chunk_offset_ = 0;
   ClearTensor();
 }
 
 void TensorResponse::ClearTensor() {
   meta_.Clear();
   tensor_ = Tensor();
+  chunk_bytes_ = 0;
+  content_wire_bytes_ = 0;
 }
 
 void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
@@ -45,6 +51,28 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
+void TensorResponse::InitChunk(const TensorResponse& first, int64 offset) {
+  Clear();
+  on_host_ = first.on_host_;
+  device_ = first.device_;
+  alloc_attrs_ = first.alloc_attrs_;
+  allocator_ = first.allocator_;
+  tensor_ = first.tensor_;
+  chunk_offset_ = offset;
+}
+
+char* TensorResponse::ChunkDestination(int64 num_bytes) {
+  if (!tensor_.IsInitialized() || !DataTypeCanUseMemcpy(tensor_.dtype())) {
+    return nullptr;
+  }
+  StringPiece buf = tensor_.tensor_data();
+  if (num_bytes <= 0 || chunk_offset_ < 0 ||
+      chunk_offset_ + num_bytes > static_cast<int64>(buf.size())) {
+    return nullptr;
+  }
+  return const_cast<char*>(buf.data()) + chunk_offset_;
+}
+
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
@@ -82,6 +110,18 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (!meta_.encoded_tensor_content().empty()) {
+      // The device makes tensors from protos only, so decode the content
+      // on the host first.
+      Tensor decoded;
+      if (!decoded.FromProto(cpu_allocator(), meta_.tensor()) ||
+          !DecodeTensorContent(meta_.tensor_encoding(),
+                               meta_.encoded_tensor_content(), &decoded)) {
+        return errors::InvalidArgument("Cannot decode tensor from response");
+      }
+      decoded.AsProtoTensorContent(meta_.mutable_tensor());
+      meta_.clear_encoded_tensor_content();
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -107,7 +147,9 @@ namespace {
 // We only need some of the wiretype values for this code
 enum WireType {
   WIRETYPE_VARINT = 0,
+  WIRETYPE_FIXED64 = 1,
   WIRETYPE_LENGTH_DELIMITED = 2,
+  WIRETYPE_FIXED32 = 5,
 };
 inline int GetTagFieldNumber(uint32 tag) { return tag >> 3; }
 inline WireType GetTagWireType(uint32 tag) {
@@ -136,10 +178,14 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
   return input->DecrementRecursionDepthAndPopLimit(p.first);
 }
 
-}  // namespace
-
-bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+// Parses the TensorProto submessage at "input" into "*tensor_meta" and
+// "*tensor", reading the content directly into a buffer allocated with
+// "allocator".  On success, sets "*content_bytes" to the size of the
+// content.  Returns false if the submessage cannot be parsed on this fast
+// path, e.g. because its dtype cannot be memcpy-ed.
+bool ParseTensorContent(protobuf::io::CodedInputStream* input,
+                        Allocator* allocator, TensorProto* tensor_meta,
+                        Tensor* tensor, int64* content_bytes) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -150,8 +196,8 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
-        tensor_ = std::move(t);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
+        *tensor = std::move(t);
       }
       return ok;
     }
@@ -190,15 +236,16 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
         // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
+        // and compatible with what allocator wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
-        tensor_ = std::move(t);
+        *tensor = std::move(t);
+        *content_bytes = num_bytes;
         break;
       }
       default: {
@@ -210,6 +257,14 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
+}  // namespace
+
+bool TensorResponse::ParseTensorSubmessage(
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+  return ParseTensorContent(input, allocator_, tensor_meta, &tensor_,
+                            &content_wire_bytes_);
+}
+
 bool TensorResponse::ParseFast(Source* source) {
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
@@ -255,6 +310,40 @@ bool TensorResponse::ParseFast(Source* source) {
           return false;
         break;
       }
+      case RecvTensorResponse::kTensorChunkFieldNumber: {
+        // The chunk follows the dtype and shape, if any, so the tensor it
+        // belongs to has been allocated by now.
+        int num_bytes;
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadVarintSizeAsInt(&input, &num_bytes))
+          return false;
+        char* dst = ChunkDestination(num_bytes);
+        if (dst == nullptr || !input.ReadRaw(dst, num_bytes)) return false;
+        chunk_bytes_ = num_bytes;
+        content_wire_bytes_ = num_bytes;
+        break;
+      }
+      case RecvTensorResponse::kTensorEncodingFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        meta_.set_tensor_encoding(
+            static_cast<RPCOptions::TensorEncoding>(static_cast<int>(v)));
+        break;
+      }
+      case RecvTensorResponse::kEncodedTensorContentFieldNumber: {
+        // The encoding and the tensor that the content decodes into
+        // precede the content.
+        int num_bytes;
+        string encoded;
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadVarintSizeAsInt(&input, &num_bytes) ||
+            !input.ReadString(&encoded, num_bytes) ||
+            !tensor_.IsInitialized() ||
+            !DecodeTensorContent(meta_.tensor_encoding(), encoded, &tensor_))
+          return false;
+        content_wire_bytes_ = num_bytes;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -270,11 +359,33 @@ bool TensorResponse::ParseSlow(Source* source) {
     return false;
   }
 
-  Tensor parsed(meta_.tensor().dtype());
-  if (!parsed.FromProto(allocator_, meta_.tensor())) {
-    return false;
+  // Only the first chunk of a chunked tensor has a dtype and shape; the
+  // later ones go to the tensor that InitChunk() set up.
+  if (meta_.tensor_chunk().empty() || meta_.has_tensor()) {
+    Tensor parsed(meta_.tensor().dtype());
+    if (!parsed.FromProto(allocator_, meta_.tensor())) {
+      return false;
+    }
+    tensor_ = std::move(parsed);
+    content_wire_bytes_ = meta_.tensor().tensor_content().size();
+  }
+  if (!meta_.encoded_tensor_content().empty()) {
+    if (!DecodeTensorContent(meta_.tensor_encoding(),
+                             meta_.encoded_tensor_content(), &tensor_)) {
+      return false;
+    }
+    content_wire_bytes_ = meta_.encoded_tensor_content().size();
+    meta_.clear_encoded_tensor_content();
+  }
+  if (!meta_.tensor_chunk().empty()) {
+    const string& chunk = meta_.tensor_chunk();
+    char* dst = ChunkDestination(chunk.size());
+    if (dst == nullptr) return false;
+    memcpy(dst, chunk.data(), chunk.size());
+    chunk_bytes_ = chunk.size();
+    content_wire_bytes_ = chunk.size();
+    meta_.clear_tensor_chunk();
   }
-  tensor_ = std::move(parsed);
 
   // Reduce memory usage for big tensors.
   {
@@ -286,4 +397,214 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+bool EncodeTensorContent(RPCOptions::TensorEncoding encoding,
+                         const Tensor& val, string* encoded) {
+  if (!DataTypeCanUseMemcpy(val.dtype())) return false;
+  const StringPiece content = val.tensor_data();
+  switch (encoding) {
+    case RPCOptions::SNAPPY:
+      return port::Snappy_Compress(content.data(), content.size(), encoded) &&
+             encoded->size() < content.size();
+    case RPCOptions::BFLOAT16: {
+      if (val.dtype() != DT_FLOAT || val.NumElements() == 0) return false;
+      const int64 n = val.NumElements();
+      encoded->resize(n * sizeof(bfloat16));
+      FloatToBFloat16(val.flat<float>().data(),
+                      reinterpret_cast<bfloat16*>(&(*encoded)[0]), n);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool DecodeTensorContent(RPCOptions::TensorEncoding encoding,
+                         StringPiece encoded, Tensor* val) {
+  if (!DataTypeCanUseMemcpy(val->dtype())) return false;
+  StringPiece content = val->tensor_data();
+  switch (encoding) {
+    case RPCOptions::SNAPPY: {
+      size_t length;
+      return port::Snappy_GetUncompressedLength(encoded.data(),
+                                                encoded.size(), &length) &&
+             length == content.size() &&
+             port::Snappy_Uncompress(encoded.data(), encoded.size(),
+                                     const_cast<char*>(content.data()));
+    }
+    case RPCOptions::BFLOAT16: {
+      const int64 n = val->NumElements();
+      if (val->dtype() != DT_FLOAT ||
+          encoded.size() != static_cast<size_t>(n) * sizeof(bfloat16)) {
+        return false;
+      }
+      // "encoded" need not be aligned for bfloat16.
+      std::vector<bfloat16> values(n);
+      memcpy(values.data(), encoded.data(), encoded.size());
+      BFloat16ToFloat(values.data(), val->flat<float>().data(), n);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+namespace {
+
+// Copies the field with "tag" at "input" to "output" unchanged.  Groups,
+// which no message parsed here contains, are not supported.
+bool CopyField(uint32 tag, protobuf::io::CodedInputStream* input,
+               protobuf::io::CodedOutputStream* output) {
+  output->WriteTag(tag);
+  switch (GetTagWireType(tag)) {
+    case WIRETYPE_VARINT: {
+      protobuf_uint64 v;
+      if (!input->ReadVarint64(&v)) return false;
+      output->WriteVarint64(v);
+      return true;
+    }
+    case WIRETYPE_FIXED64: {
+      protobuf_uint64 v;
+      if (!input->ReadLittleEndian64(&v)) return false;
+      output->WriteLittleEndian64(v);
+      return true;
+    }
+    case WIRETYPE_LENGTH_DELIMITED: {
+      int length;
+      string value;
+      if (!ReadVarintSizeAsInt(input, &length) ||
+          !input->ReadString(&value, length)) {
+        return false;
+      }
+      output->WriteVarint32(length);
+      output->WriteString(value);
+      return true;
+    }
+    case WIRETYPE_FIXED32: {
+      uint32 v;
+      if (!input->ReadLittleEndian32(&v)) return false;
+      output->WriteLittleEndian32(v);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Parses the NamedTensorProto submessage at "input" into "*name" and
+// "*tensor".  Returns false if it cannot be parsed on the fast path.
+bool ParseNamedTensor(protobuf::io::CodedInputStream* input,
+                      Allocator* allocator, string* name, Tensor* tensor) {
+  bool seen_tensor = false;
+  while (true) {
+    auto p = input->ReadTagWithCutoff(127);
+    int tag = GetTagFieldNumber(p.first);
+    WireType wt = GetTagWireType(p.first);
+    if (!p.second) {
+      return tag == 0 && seen_tensor;
+    }
+    int length;
+    if (wt != WIRETYPE_LENGTH_DELIMITED ||
+        !ReadVarintSizeAsInt(input, &length)) {
+      return false;
+    }
+    switch (tag) {
+      case NamedTensorProto::kNameFieldNumber: {
+        if (!input->ReadString(name, length)) return false;
+        break;
+      }
+      case NamedTensorProto::kTensorFieldNumber: {
+        TensorProto tensor_meta;
+        int64 content_bytes;
+        std::pair<protobuf::io::CodedInputStream::Limit, int> p =
+            input->IncrementRecursionDepthAndPushLimit(length);
+        if (p.second < 0 ||
+            !ParseTensorContent(input, allocator, &tensor_meta, tensor,
+                                &content_bytes) ||
+            !input->DecrementRecursionDepthAndPopLimit(p.first)) {
+          return false;
+        }
+        seen_tensor = true;
+        break;
+      }
+      default: {
+        return false;
+      }
+    }
+  }
+}
+
+// Parses the message encoded in the data yielded by source->contents(),
+// whose field "tensors_field" is a repeated NamedTensorProto, reading the
+// tensors into "*tensors" and all the other fields into "*rest".  Returns
+// false if any of the tensors cannot be parsed on the fast path.
+bool ParseNamedTensorsFast(TensorResponse::Source* source, int tensors_field,
+                           Allocator* allocator,
+                           std::vector<std::pair<string, Tensor>>* tensors,
+                           protobuf::MessageLite* rest) {
+  protobuf::io::CodedInputStream input(source->contents());
+  input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+  string rest_bytes;
+  {
+    protobuf::io::StringOutputStream rest_stream(&rest_bytes);
+    protobuf::io::CodedOutputStream rest_output(&rest_stream);
+    while (true) {
+      const uint32 tag = input.ReadTag();
+      if (tag == 0) {
+        if (!input.ConsumedEntireMessage()) return false;
+        break;
+      }
+      if (GetTagFieldNumber(tag) != tensors_field) {
+        if (!CopyField(tag, &input, &rest_output)) return false;
+        continue;
+      }
+      int length;
+      if (GetTagWireType(tag) != WIRETYPE_LENGTH_DELIMITED ||
+          !ReadVarintSizeAsInt(&input, &length)) {
+        return false;
+      }
+      std::pair<protobuf::io::CodedInputStream::Limit, int> p =
+          input.IncrementRecursionDepthAndPushLimit(length);
+      tensors->emplace_back();
+      if (p.second < 0 ||
+          !ParseNamedTensor(&input, allocator, &tensors->back().first,
+                            &tensors->back().second) ||
+          !input.DecrementRecursionDepthAndPopLimit(p.first)) {
+        return false;
+      }
+    }
+  }
+  return rest->ParseFromString(rest_bytes);
+}
+
+}  // namespace
+
+Status ParseRunGraphResponse(TensorResponse::Source* source,
+                             Allocator* allocator,
+                             InMemoryRunGraphResponse* response) {
+  std::vector<std::pair<string, Tensor>> recvs;
+  RunGraphResponse rest;
+  if (!ParseNamedTensorsFast(source, RunGraphResponse::kRecvFieldNumber,
+                             allocator, &recvs, &rest)) {
+    // Fall back to parsing the whole message, e.g. for string tensors.
+    recvs.clear();
+    if (!rest.ParseFromZeroCopyStream(source->contents())) {
+      return errors::InvalidArgument("Cannot parse RunGraphResponse");
+    }
+    for (const NamedTensorProto& recv : rest.recv()) {
+      Tensor parsed(recv.tensor().dtype());
+      if (!parsed.FromProto(allocator, recv.tensor())) {
+        return errors::InvalidArgument("Cannot parse tensor for ",
+                                       recv.name(), " from RunGraphResponse");
+      }
+      recvs.emplace_back(recv.name(), std::move(parsed));
+    }
+  }
+  for (const auto& recv : recvs) {
+    response->AddRecv(recv.first, recv.second);
+  }
+  response->mutable_step_stats()->Swap(rest.mutable_step_stats());
+  response->mutable_cost_graph()->Swap(rest.mutable_cost_graph());
+  return Status::OK();
+}
+
 }  // namespace tensorflow
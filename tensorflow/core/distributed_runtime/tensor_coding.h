@@ -27,6 +27,7 @@ namespace tensorflow {
 
 class Allocator;
 class DeviceBase;
+class InMemoryRunGraphResponse;
 class TensorProto;
 
 // TensorResponse can be used as the destination of an RPC that returns
@@ -46,6 +47,11 @@ class TensorResponse {
   // Initialize memory allocation related members.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
+  // Prepares *this to receive the chunk at "offset" of a tensor that is
+  // transferred in chunks, and whose first chunk "first" has received.
+  // The chunk is written directly into first.tensor().
+  void InitChunk(const TensorResponse& first, int64 offset);
+
   // Source provides a way for a particular RPC implementation to provide
   // received data to ParseFrom.
   class Source {
@@ -87,7 +93,20 @@ class TensorResponse {
   // modified.
   const RecvTensorResponse& metadata() const { return meta_; }
 
+  // Returns the number of bytes of tensor content that the parsed
+  // response carried as a chunk, or 0 if the tensor was not chunked.
+  int64 chunk_bytes() const { return chunk_bytes_; }
+
+  // Returns the number of bytes that the tensor content of the parsed
+  // response took on the wire, which is less than its decoded size if
+  // the content was encoded or only a chunk of it was sent.
+  int64 content_wire_bytes() const { return content_wire_bytes_; }
+
  private:
+  // Returns where to write a chunk of "num_bytes" bytes of tensor
+  // content, or nullptr if it does not fit in tensor_.
+  char* ChunkDestination(int64 num_bytes);
+
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
@@ -100,8 +119,32 @@ class TensorResponse {
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
+  int64 chunk_offset_ = 0;
+  int64 chunk_bytes_ = 0;
+  int64 content_wire_bytes_ = 0;
 };
 
+// Encodes the content of "val" with "encoding" into "*encoded". Returns
+// false if "encoding" does not apply to the dtype of "val" or does not
+// make its content smaller, in which case the content should be sent as
+// RAW.
+bool EncodeTensorContent(RPCOptions::TensorEncoding encoding,
+                         const Tensor& val, string* encoded);
+
+// Decodes "encoded", which EncodeTensorContent() produced with "encoding",
+// into "*val", which must already have the original dtype and shape.
+// Returns false if "encoded" is not a valid encoding of such a tensor.
+bool DecodeTensorContent(RPCOptions::TensorEncoding encoding,
+                         StringPiece encoded, Tensor* val);
+
+// Parses the RunGraphResponse encoded in the data yielded by
+// source->contents() into *response.  Where possible, the content of each
+// received tensor is read directly into a Tensor allocated with
+// "allocator", without first building a TensorProto for it.
+Status ParseRunGraphResponse(TensorResponse::Source* source,
+                             Allocator* allocator,
+                             InMemoryRunGraphResponse* response);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/distributed_runtime/message_wrappers.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -155,6 +157,159 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, Chunks) {
+  Tensor src(DT_FLOAT, TensorShape({3, 10}));
+  test::FillIota<float>(&src, 1.0f);
+  const StringPiece content = src.tensor_data();
+  const int64 chunk_bytes = 48;
+
+  // The first chunk carries the dtype and shape.
+  RecvTensorResponse first;
+  first.mutable_tensor()->set_dtype(src.dtype());
+  src.shape().AsProto(first.mutable_tensor()->mutable_tensor_shape());
+  first.set_tensor_chunk(content.substr(0, chunk_bytes).ToString());
+  string encoded;
+  first.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  StringSource source(&encoded, 16);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(chunk_bytes, response.chunk_bytes());
+  EXPECT_EQ(src.shape(), response.tensor().shape());
+
+  // The later chunks are written into the same tensor, in any order.
+  for (int64 offset = 2 * chunk_bytes; offset >= chunk_bytes;
+       offset -= chunk_bytes) {
+    RecvTensorResponse chunk;
+    chunk.set_tensor_chunk(content.substr(offset, chunk_bytes).ToString());
+    string encoded_chunk;
+    chunk.AppendToString(&encoded_chunk);
+    TensorResponse chunk_response;
+    chunk_response.InitChunk(response, offset);
+    StringSource chunk_source(&encoded_chunk, 16);
+    TF_EXPECT_OK(chunk_response.ParseFrom(&chunk_source));
+    EXPECT_EQ(std::min<int64>(chunk_bytes, content.size() - offset),
+              chunk_response.chunk_bytes());
+  }
+  test::ExpectTensorEqual<float>(src, response.tensor());
+
+  // A chunk beyond the end of the tensor is rejected.
+  RecvTensorResponse overflow;
+  overflow.set_tensor_chunk(string(chunk_bytes, 'x'));
+  string encoded_overflow;
+  overflow.AppendToString(&encoded_overflow);
+  TensorResponse overflow_response;
+  overflow_response.InitChunk(response, 2 * chunk_bytes);
+  StringSource overflow_source(&encoded_overflow, 16);
+  EXPECT_FALSE(overflow_response.ParseFrom(&overflow_source).ok());
+}
+
+void ExpectEncodedContentRoundTrip(RPCOptions::TensorEncoding encoding,
+                                   const Tensor& src) {
+  string content;
+  if (!EncodeTensorContent(encoding, src, &content)) {
+    // E.g. if snappy is not available on this platform.
+    LOG(INFO) << "Tensor encoding " << RPCOptions::TensorEncoding_Name(encoding)
+              << " does not apply";
+    return;
+  }
+  EXPECT_LT(content.size(), src.TotalBytes());
+
+  RecvTensorResponse proto;
+  proto.mutable_tensor()->set_dtype(src.dtype());
+  src.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+  proto.set_tensor_encoding(encoding);
+  proto.set_encoded_tensor_content(content);
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  StringSource source(&encoded, 16);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(content.size(), response.content_wire_bytes());
+  test::ExpectTensorEqual<float>(src, response.tensor());
+
+  // Content that does not decode to the tensor's shape is rejected.
+  proto.mutable_tensor()->mutable_tensor_shape()->mutable_dim(0)->set_size(3);
+  string bad;
+  proto.AppendToString(&bad);
+  TensorResponse bad_response;
+  bad_response.InitAlloc(&cpu_device, AllocatorAttributes());
+  StringSource bad_source(&bad, 16);
+  EXPECT_FALSE(bad_response.ParseFrom(&bad_source).ok());
+}
+
+TEST_F(TensorResponseTest, EncodedContent) {
+  // Small integers are exact in bfloat16, and repeat well for snappy.
+  Tensor src(DT_FLOAT, TensorShape({4, 256}));
+  auto flat = src.flat<float>();
+  for (int i = 0; i < flat.size(); ++i) flat(i) = i % 16;
+  ExpectEncodedContentRoundTrip(RPCOptions::SNAPPY, src);
+  ExpectEncodedContentRoundTrip(RPCOptions::BFLOAT16, src);
+
+  // Only float tensors can be sent as bfloat16.
+  Tensor ints(DT_INT32, TensorShape({16}));
+  string content;
+  EXPECT_FALSE(EncodeTensorContent(RPCOptions::BFLOAT16, ints, &content));
+  EXPECT_FALSE(EncodeTensorContent(RPCOptions::RAW, src, &content));
+}
+
+void ExpectRunGraphResponseRoundTrip(const std::vector<Tensor>& recvs) {
+  RunGraphResponse proto;
+  for (size_t i = 0; i < recvs.size(); ++i) {
+    NamedTensorProto* recv = proto.add_recv();
+    recv->set_name(strings::StrCat("recv", i));
+    if (DataTypeCanUseMemcpy(recvs[i].dtype())) {
+      recvs[i].AsProtoTensorContent(recv->mutable_tensor());
+    } else {
+      recvs[i].AsProtoField(recv->mutable_tensor());
+    }
+  }
+  proto.mutable_step_stats()->add_dev_stats()->set_device("/cpu:0");
+  proto.mutable_cost_graph()->add_node()->set_name("node");
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  InMemoryRunGraphResponse response;
+  StringSource source(&encoded, 7);
+  TF_ASSERT_OK(ParseRunGraphResponse(&source, cpu_allocator(), &response));
+  ASSERT_EQ(recvs.size(), response.num_recvs());
+  for (size_t i = 0; i < recvs.size(); ++i) {
+    EXPECT_EQ(strings::StrCat("recv", i), response.recv_key(i));
+    Tensor parsed;
+    TF_ASSERT_OK(response.RecvValue(i, &parsed));
+    EXPECT_EQ(recvs[i].DebugString(), parsed.DebugString());
+  }
+  ASSERT_EQ(1, response.mutable_step_stats()->dev_stats_size());
+  EXPECT_EQ("/cpu:0", response.mutable_step_stats()->dev_stats(0).device());
+  ASSERT_EQ(1, response.mutable_cost_graph()->node_size());
+  EXPECT_EQ("node", response.mutable_cost_graph()->node(0).name());
+}
+
+TEST(ParseRunGraphResponseTest, Tensors) {
+  ExpectRunGraphResponseRoundTrip({});
+  ExpectRunGraphResponseRoundTrip({test::AsTensor<float>({1.5f, -2.0f}),
+                                   test::AsTensor<int64>({7}, {1, 1}),
+                                   Tensor(DT_INT32, TensorShape({0}))});
+}
+
+TEST(ParseRunGraphResponseTest, StringTensors) {
+  // String tensors take the slow path through RunGraphResponse.
+  ExpectRunGraphResponseRoundTrip({test::AsTensor<float>({3.0f}),
+                                   test::AsTensor<string>({"a", "bc"})});
+}
+
+TEST(ParseRunGraphResponseTest, BadInput) {
+  string bad("\x0a\x05junk");
+  InMemoryRunGraphResponse response;
+  StringSource source(&bad, -1);
+  EXPECT_FALSE(ParseRunGraphResponse(&source, cpu_allocator(), &response).ok());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace tensorflow {
@@ -172,6 +174,14 @@ Status Worker::PrepareRunGraph(RunGraphRequestWrapper* req,
 void Worker::RunGraphAsync(CallOptions* opts, RunGraphRequestWrapper* request,
                            MutableRunGraphResponseWrapper* response,
                            StatusCallback done) {
+  // The master may pass the steps to clean up with the next step instead of
+  // calling CleanupGraph.
+  for (size_t i = 0; i < request->num_cleanup_step_ids(); ++i) {
+    CleanupGraphRequest cleanup_request;
+    cleanup_request.set_step_id(request->cleanup_step_id(i));
+    CleanupGraphResponse cleanup_response;
+    CleanupGraph(&cleanup_request, &cleanup_response).IgnoreError();
+  }
   if (request->is_partial()) {
     DoPartialRunGraph(opts, request, response, std::move(done));
   } else {
@@ -389,6 +399,41 @@ void Worker::TracingAsync(const TracingRequest* request,
   done(errors::Unimplemented("Tracing"));
 }
 
+void Worker::GetMetricsAsync(const GetMetricsRequest* request,
+                             GetMetricsResponse* response,
+                             StatusCallback done) {
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  std::unique_ptr<monitoring::CollectedMetrics> collected =
+      monitoring::CollectionRegistry::Default()->CollectMetrics(options);
+  for (const auto& name_and_point_set : collected->point_set_map) {
+    const string& name = name_and_point_set.first;
+    if (!StringPiece(name).starts_with(request->name_prefix())) continue;
+    Metric* metric = response->add_metric();
+    metric->set_name(name);
+    auto descriptor = collected->metric_descriptor_map.find(name);
+    if (descriptor != collected->metric_descriptor_map.end()) {
+      metric->set_description(descriptor->second->description);
+    }
+    for (const auto& point : name_and_point_set.second->points) {
+      MetricPoint* metric_point = metric->add_point();
+      for (const auto& label : point->labels) {
+        (*metric_point->mutable_labels())[label.name] = label.value;
+      }
+      switch (point->value_type) {
+        case monitoring::ValueType::kInt64:
+          metric_point->set_int64_value(point->int64_value);
+          break;
+        case monitoring::ValueType::kHistogram:
+          *metric_point->mutable_histogram_value() = point->histogram_value;
+          break;
+      }
+      metric_point->set_start_timestamp_millis(point->start_timestamp_millis);
+      metric_point->set_end_timestamp_millis(point->end_timestamp_millis);
+    }
+  }
+  done(Status::OK());
+}
+
 // Helper for RecvTensor. Validates "key" and returns the source
 // device in "*src_dev".
 Status Worker::PrepareRecvTensor(const Rendezvous::ParsedKey& parsed,
@@ -419,4 +464,25 @@ void Worker::RecvTensorAsync(CallOptions* opts,
   done(errors::Unimplemented("Worker::RecvTensorAsync()"));
 }
 
+void Worker::PushTensorAsync(const PushTensorRequest* request,
+                             PushTensorResponse* response,
+                             StatusCallback done) {
+  const int64 step_id = request->step_id();
+  Rendezvous::ParsedKey parsed;
+  Status s = Rendezvous::ParseKey(request->rendezvous_key(), &parsed);
+  Tensor val;
+  if (s.ok() && !request->is_dead() &&
+      !val.FromProto(cpu_allocator(), request->tensor())) {
+    s = errors::InvalidArgument("Cannot parse the tensor pushed for ",
+                                request->rendezvous_key());
+  }
+  if (s.ok()) {
+    WorkerSession* session =
+        env_->session_mgr->WorkerSessionForStepId(step_id);
+    s = session->rendezvous_mgr->AcceptPushedTensor(step_id, parsed, val,
+                                                    request->is_dead());
+  }
+  done(s);
+}
+
 }  // namespace tensorflow
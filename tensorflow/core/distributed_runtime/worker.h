@@ -78,12 +78,20 @@ class Worker : public WorkerInterface {
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override;
 
+  void PushTensorAsync(const PushTensorRequest* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override;
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
   void TracingAsync(const TracingRequest* request, TracingResponse* response,
                     StatusCallback done) override;
 
+  void GetMetricsAsync(const GetMetricsRequest* request,
+                       GetMetricsResponse* response,
+                       StatusCallback done) override;
+
  protected:
   WorkerEnv* const env_;  // Not owned.
 
@@ -85,13 +85,18 @@ void WorkerCacheLogger::RecordRecvTensor(int64 step_id, int64 start_usecs,
                                          const string& tensor_name,
                                          const string& src_device,
                                          const string& dst_device,
-                                         int64 bytes) {
+                                         int64 bytes, int64 wire_bytes) {
   NodeExecStats* ns = new NodeExecStats;
   ns->set_node_name("RecvTensor");
-  string byte_string = strings::StrCat("[", bytes, "B] ");
+  string byte_string = strings::StrCat(bytes, "B");
   if (bytes >= 0.1 * 1048576.0) {
-    byte_string = strings::Printf("[%.1fMB] ", bytes / 1048576.0);
+    byte_string = strings::Printf("%.1fMB", bytes / 1048576.0);
   }
+  if (wire_bytes >= 0 && wire_bytes < bytes) {
+    strings::Appendf(&byte_string, ", %.1f%% on wire",
+                     100.0 * wire_bytes / bytes);
+  }
+  byte_string = strings::StrCat("[", byte_string, "] ");
   ns->set_timeline_label(strings::StrCat(byte_string, tensor_name, " from ",
                                          src_device, " to ", dst_device));
   ns->set_all_start_micros(start_usecs);
@@ -55,10 +55,12 @@ class WorkerCacheLogger {
   }
 
   // Generates a NodeExecStats record with the given data, and saves for
-  // later retrieval by RetrieveLogs().
+  // later retrieval by RetrieveLogs(). "wire_bytes" is the size of the
+  // tensor content as sent, if it was encoded to fewer than "bytes".
   void RecordRecvTensor(int64 step_id, int64 start_usecs, int64 end_usecs,
                         const string& tensor_name, const string& src_device,
-                        const string& dst_device, int64 bytes);
+                        const string& dst_device, int64 bytes,
+                        int64 wire_bytes = -1);
 
  private:
   mutex count_mu_;
@@ -102,12 +102,20 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  virtual void PushTensorAsync(const PushTensorRequest* request,
+                               PushTensorResponse* response,
+                               StatusCallback done) = 0;
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
   virtual void TracingAsync(const TracingRequest* request,
                             TracingResponse* response, StatusCallback done) = 0;
 
+  virtual void GetMetricsAsync(const GetMetricsRequest* request,
+                               GetMetricsResponse* response,
+                               StatusCallback done) = 0;
+
   Status GetStatus(const GetStatusRequest* request,
                    GetStatusResponse* response) {
     return CallAndWait(&ME::GetStatusAsync, request, response);
@@ -133,6 +141,11 @@ class WorkerInterface {
     return CallAndWait(&ME::CleanupAllAsync, request, response);
   }
 
+  Status PushTensor(const PushTensorRequest* request,
+                    PushTensorResponse* response) {
+    return CallAndWait(&ME::PushTensorAsync, request, response);
+  }
+
   Status Logging(const LoggingRequest* request, LoggingResponse* response) {
     return CallAndWait(&ME::LoggingAsync, request, response);
   }
@@ -141,6 +154,11 @@ class WorkerInterface {
     return CallAndWait(&ME::TracingAsync, request, response);
   }
 
+  Status GetMetrics(const GetMetricsRequest* request,
+                    GetMetricsResponse* response) {
+    return CallAndWait(&ME::GetMetricsAsync, request, response);
+  }
+
  protected:
   // Instances of WorkerInterface must be deleted by a call to
   // WorkerCacheInterface::ReleaseWorker().
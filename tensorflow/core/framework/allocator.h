@@ -42,6 +42,10 @@ struct AllocationAttributes {
   // which Op is performing the allocation, and sets this flag to
   // true.
   bool allocation_will_be_logged = false;
+  // If not null, the name of the kernel making the allocation, recorded by
+  // allocators that trace their memory.  It must stay valid until such a
+  // trace is stopped.
+  const string* kernel_name = nullptr;
 };
 
 // Runtime statistics collected by an allocator.
@@ -359,6 +363,9 @@ Allocator* cpu_allocator();
 // AllocatorStats. By default, it's disabled.
 void EnableCPUAllocatorStats(bool enable);
 
+// Returns true if the process-wide cpu allocator collects AllocatorStats.
+bool CPUAllocatorStatsEnabled();
+
 // If 'enable' is true, the process-wide cpu allocator collects full
 // statistics. By default, it's disabled.
 void EnableCPUAllocatorFullStats(bool enable);
@@ -26,9 +26,10 @@ class OpKernelContext;
 
 namespace lookup {
 
-// Forward declaration so we can define GetInitializableLookupTable() in
-// LookupInterface.
+// Forward declarations so we can define GetInitializableLookupTable() and
+// GetEmbeddingVariable() in LookupInterface.
 class InitializableLookupTable;
+class EmbeddingVariable;
 
 // Lookup interface for batch lookups used by table lookup ops.
 class LookupInterface : public ResourceBase {
@@ -124,6 +125,10 @@ class LookupInterface : public ResourceBase {
     return nullptr;
   }
 
+  // Returns an EmbeddingVariable, a subclass of LookupInterface, if the
+  // current object is an EmbeddingVariable. Otherwise, returns nullptr.
+  virtual EmbeddingVariable* GetEmbeddingVariable() { return nullptr; }
+
  protected:
   virtual ~LookupInterface() = default;
 
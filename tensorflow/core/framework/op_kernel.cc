@@ -587,9 +587,16 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
+  logged_attr.kernel_name = &params_->op_kernel->name();
   Tensor new_tensor(a, type, shape, logged_attr);
 
   if (!new_tensor.IsInitialized()) {
@@ -614,7 +621,16 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Allocator* planned = params_->output_allocator_array == nullptr
+                           ? nullptr
+                           : params_->output_allocator_array[index];
+  Status s;
+  if (planned != nullptr && attr.value == 0 && !track_allocations()) {
+    s = allocate_tensor(planned, type, shape, output_tensor,
+                        AllocationAttributes());
+  } else {
+    s = allocate_tensor(type, shape, output_tensor, attr);
+  }
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -626,6 +642,11 @@ Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
     const AllocationAttributes& allocation_attr) {
+  if (params_->step_temp_allocator != nullptr && !track_allocations() &&
+      !allocator_attr.gpu_compatible() && !allocator_attr.nic_compatible()) {
+    return allocate_tensor(params_->step_temp_allocator, type, shape, out_temp,
+                           allocation_attr);
+  }
   Status s =
       allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
   if (track_allocations() && out_temp->TotalBytes() > 0) {
@@ -67,6 +67,7 @@ class AsyncOpKernel;
 class OpKernelConstruction;  // declared below
 class OpKernelContext;       // declared below
 class ResourceMgr;
+class StepStatsCollector;
 
 class OpKernel {
  public:
@@ -532,6 +533,9 @@ class OpKernelContext {
     // The tensor store for this op.
     TensorStore* tensor_store = nullptr;
 
+    // Collects the stats of the step this op runs in, if it is traced.
+    StepStatsCollector* stats_collector = nullptr;
+
     // Mechanism used by this op kernel invocation to register a callback
     // for its cancellation.
     CancellationManager* cancellation_manager = nullptr;
@@ -558,6 +562,19 @@ class OpKernelContext {
 
     // TensorSliceReaderCache support.
     checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache = nullptr;
+
+    // If not null, allocate_temp() takes temporaries that need no special
+    // (GPU- or NIC-compatible) host memory from this allocator instead of
+    // the device's, unless allocations are being tracked.  The memory is
+    // expected to be reclaimed in bulk at the end of the step.
+    Allocator* step_temp_allocator = nullptr;
+
+    // If not null, array indexed by output number for this node of the
+    // allocators that a static memory plan assigned to the outputs, or
+    // null for outputs that are allocated dynamically.  allocate_output()
+    // uses the planned allocator when the output needs no special
+    // allocator attributes, unless allocations are being tracked.
+    Allocator* const* output_allocator_array = nullptr;
   };
 
   // params must outlive the OpKernelContext.
@@ -929,6 +946,13 @@ class OpKernelContext {
   // An op kernel can access the tensor store of the run it belongs to.
   TensorStore* tensor_store() const { return params_->tensor_store; }
 
+  // If not nullptr, the step is traced and an op kernel may save to it the
+  // stats of the work it does, e.g. of the sub-computations of a compiled
+  // cluster, in addition to the stats the executor saves for the op itself.
+  StepStatsCollector* stats_collector() const {
+    return params_->stats_collector;
+  }
+
   // Function call support.
   //
   // If this kernel invocation is within a function execution,
@@ -1084,6 +1108,9 @@ class OpKernelContext {
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
 
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
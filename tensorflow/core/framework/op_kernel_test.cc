@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 #include <vector>
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -334,6 +335,58 @@ TEST_F(OpKernelTest, SaveTempTrue) {
   delete params.device;
 }
 
+// An allocator of at most 'limit' bytes per request.
+class LimitedAllocator : public Allocator {
+ public:
+  explicit LimitedAllocator(size_t limit) : limit_(limit) {}
+  string Name() override { return "limited"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    if (num_bytes > limit_) return nullptr;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+ private:
+  const size_t limit_;
+};
+
+TEST_F(OpKernelTest, AllocateTempFromStepArena) {
+  Env* env = Env::Default();
+  OpKernelContext::Params params;
+  params.record_tensor_accesses = false;
+  params.device = new DummyDevice(env, params.record_tensor_accesses);
+  LimitedAllocator device_allocator(1 << 20);
+  StepArenaAllocator* arena =
+      new StepArenaAllocator(1 << 10, &device_allocator);
+  params.step_temp_allocator = arena;
+  Status status;
+  std::unique_ptr<OpKernel> op(
+      CreateOpKernel(DEVICE_CPU, params.device, cpu_allocator(),
+                     CreateNodeDef("Test1", {DT_FLOAT, DT_INT32}),
+                     TF_GRAPH_DEF_VERSION, &status));
+  EXPECT_TRUE(status.ok());
+  params.op_kernel = op.get();
+  OpKernelContext* ctx = new OpKernelContext(&params);
+
+  {
+    Tensor small;
+    TF_EXPECT_OK(ctx->allocate_temp(DT_FLOAT, TensorShape({16}), &small));
+    Tensor large;
+    TF_EXPECT_OK(ctx->allocate_temp(DT_FLOAT, TensorShape({1024}), &large));
+    // A temporary too large for the device allocator is an error, not an
+    // abort.
+    Tensor too_large;
+    EXPECT_TRUE(errors::IsResourceExhausted(ctx->allocate_temp(
+        DT_FLOAT, TensorShape({1 << 20}), &too_large)));
+  }
+
+  delete ctx;
+  arena->Release();
+  delete params.device;
+}
+
 TEST_F(OpKernelTest, InputDtype) {
   Env* env = Env::Default();
   OpKernelContext::Params params;
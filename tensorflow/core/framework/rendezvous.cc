@@ -156,14 +156,15 @@ class LocalRendezvousImpl : public Rendezvous {
     Args recv_args;
     uint64 key_hash = KeyHash(key.FullKey());
     VLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
+    Shard* shard = GetShard(key_hash);
     {
-      mutex_lock l(mu_);
-      if (!status_.ok()) {
-        return status_;
+      mutex_lock l(shard->mu);
+      if (!shard->status.ok()) {
+        return shard->status;
       }
       Item* item = nullptr;
-      Table::iterator iter = table_.find(key_hash);
-      if (iter == table_.end()) {
+      Table::iterator iter = shard->table.find(key_hash);
+      if (iter == shard->table.end()) {
         // There is no waiter for this message. Insert the message
         // into the waiters table. The waiter will pick it up when
         // arrives.
@@ -180,7 +181,7 @@ class LocalRendezvousImpl : public Rendezvous {
         // The allocator attributes of item->value.
         item->send_alloc_attrs = send_args.alloc_attrs;
 
-        CHECK(table_.insert({key_hash, item}).second);
+        CHECK(shard->table.insert({key_hash, item}).second);
         return Status::OK();
       } else {
         item = iter->second;
@@ -224,19 +225,21 @@ class LocalRendezvousImpl : public Rendezvous {
                  DoneCallback done) override {
     uint64 key_hash = KeyHash(key.FullKey());
     VLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    mutex* mu = &shard->mu;
+    mu->lock();
+    if (!shard->status.ok()) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
+      Status s = shard->status;
+      mu->unlock();
       done(s, Args(), recv_args, Tensor(), false);
       return;
     }
-    Table::iterator iter = table_.find(key_hash);
-    if (iter != table_.end()) {
+    Table::iterator iter = shard->table.find(key_hash);
+    if (iter != shard->table.end()) {
       Item* item = iter->second;
       if (item->has_been_recvd && !tolerate_dup_recv_) {
-        mu_.unlock();
+        mu->unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       } else if (item->waiter == nullptr || tolerate_dup_recv_) {
@@ -259,13 +262,13 @@ class LocalRendezvousImpl : public Rendezvous {
         Args send_args;
         send_args.device_context = item->send_dev_context;
         send_args.alloc_attrs = item->send_alloc_attrs;
-        mu_.unlock();
+        mu->unlock();
         done(Status::OK(), send_args, recv_args, v, is_dead);
         if (send_dev_context) send_dev_context->Unref();
       } else {
         // Already have a waiter in the waiters table under this key,
         // which should not happen.
-        mu_.unlock();
+        mu->unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       }
@@ -281,21 +284,24 @@ class LocalRendezvousImpl : public Rendezvous {
       item->recv_dev_context = recv_args.device_context;
       item->recv_dev_context->Ref();
     }
-    CHECK(table_.insert({key_hash, item}).second);
-    mu_.unlock();
+    CHECK(shard->table.insert({key_hash, item}).second);
+    mu->unlock();
     return;
   }
 
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
-    std::vector<Item*> items;
     {
-      mutex_lock l(mu_);
-      if (!status_.ok()) return;
-      status_ = status;
-      items.reserve(table_.size());
-      for (const auto& p : table_) items.push_back(p.second);
-      table_.clear();
+      mutex_lock l(abort_mu_);
+      if (aborted_) return;
+      aborted_ = true;
+    }
+    std::vector<Item*> items;
+    for (Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      shard.status = status;
+      for (const auto& p : shard.table) items.push_back(p.second);
+      shard.table.clear();
     }
     for (Item* item : items) {
       if (item->waiter != nullptr) {
@@ -335,14 +341,27 @@ class LocalRendezvousImpl : public Rendezvous {
 
   typedef gtl::FlatMap<uint64, Item*> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_;
+  // The table is sharded by key hash, so that the Sends and Recvs of
+  // different edges of a step mostly take different locks.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+  };
+  Shard* GetShard(uint64 key_hash) {
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
+
+  Shard shards_[kNumShards];
+  mutex abort_mu_;
+  bool aborted_ GUARDED_BY(abort_mu_) = false;
 
   ~LocalRendezvousImpl() override {
-    for (auto i : table_) {
-      delete i.second;
+    for (Shard& shard : shards_) {
+      for (auto i : shard.table) {
+        delete i.second;
+      }
     }
   }
 
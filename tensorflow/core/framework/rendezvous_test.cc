@@ -251,6 +251,31 @@ TEST_F(LocalRendezvousTest, RecvSleepAbort) {
   EXPECT_TRUE(errors::IsAborted(status));
 }
 
+// The pending Recvs of all keys are aborted, whichever shard of the
+// table they are waiting in.
+TEST_F(LocalRendezvousTest, AbortManyPendingRecvs) {
+  static const int N = 100;
+  BlockingState state;
+  state.counter = N;
+  for (int i = 0; i < N; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat(i)), Rendezvous::Args(),
+        [&state](const Status& s, const Rendezvous::Args& send_args,
+                 const Rendezvous::Args& recv_args, const Tensor& v,
+                 const bool dead) {
+          EXPECT_TRUE(errors::IsAborted(s));
+          bool done = false;
+          {
+            mutex_lock l(state.lock);
+            done = --state.counter == 0;
+          }
+          if (done) state.done.Notify();
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  state.done.WaitForNotification();
+}
+
 TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
   rendez_->StartAbort(errors::Aborted(""));
   Tensor val(DT_STRING);
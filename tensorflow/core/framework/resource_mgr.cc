@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_mgr.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -65,18 +67,19 @@ ResourceMgr::ResourceMgr(const string& default_container)
 ResourceMgr::~ResourceMgr() { Clear(); }
 
 void ResourceMgr::Clear() {
-  mutex_lock l(mu_);
-  for (const auto& p : containers_) {
-    for (const auto& q : *p.second) {
-      q.second->Unref();
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    for (const auto& p : shard.containers) {
+      for (const auto& q : *p.second) {
+        q.second->Unref();
+      }
+      delete p.second;
     }
-    delete p.second;
+    shard.containers.clear();
   }
-  containers_.clear();
 }
 
 string ResourceMgr::DebugString() const {
-  mutex_lock l(mu_);
   struct Line {
     const string* container;
     const string type;
@@ -84,15 +87,19 @@ string ResourceMgr::DebugString() const {
     const string detail;
   };
   std::vector<Line> lines;
-  for (const auto& p : containers_) {
-    const string& container = p.first;
-    for (const auto& q : *p.second) {
-      const Key& key = q.first;
-      const char* type = DebugTypeName(key.first);
-      const string& resource = key.second;
-      Line l{&container, port::Demangle(type), &resource,
-             q.second->DebugString()};
-      lines.push_back(l);
+  for (const Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    mutex_lock type_names_l(debug_type_names_mu_);
+    for (const auto& p : shard.containers) {
+      const string& container = p.first;
+      for (const auto& q : *p.second) {
+        const Key& key = q.first;
+        const char* type = DebugTypeName(key.first);
+        const string& resource = key.second;
+        Line l{&container, port::Demangle(type), &resource,
+               q.second->DebugString()};
+        lines.push_back(l);
+      }
     }
   }
   std::vector<string> text;
@@ -108,12 +115,14 @@ string ResourceMgr::DebugString() const {
 Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
                              const string& name, ResourceBase* resource) {
   {
-    mutex_lock l(mu_);
-    Container** b = &containers_[container];
+    Shard& shard = shards_[ShardIndex(type.hash_code(), name)];
+    mutex_lock l(shard.mu);
+    Container** b = &shard.containers[container];
     if (*b == nullptr) {
       *b = new Container;
     }
     if ((*b)->insert({{type.hash_code(), name}, resource}).second) {
+      mutex_lock type_names_l(debug_type_names_mu_);
       TF_RETURN_IF_ERROR(InsertDebugTypeName(type.hash_code(), type.name()));
       return Status::OK();
     }
@@ -126,19 +135,33 @@ Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
 Status ResourceMgr::DoLookup(const string& container, TypeIndex type,
                              const string& name,
                              ResourceBase** resource) const {
-  mutex_lock l(mu_);
-  const Container* b = gtl::FindPtrOrNull(containers_, container);
-  if (b == nullptr) {
-    return errors::NotFound("Container ", container, " does not exist.");
+  {
+    const Shard& shard = shards_[ShardIndex(type.hash_code(), name)];
+    mutex_lock l(shard.mu);
+    const Container* b = gtl::FindPtrOrNull(shard.containers, container);
+    if (b != nullptr) {
+      auto r = gtl::FindPtrOrNull(*b, {type.hash_code(), name});
+      if (r != nullptr) {
+        *resource = const_cast<ResourceBase*>(r);
+        (*resource)->Ref();
+        return Status::OK();
+      }
+    }
   }
-  auto r = gtl::FindPtrOrNull(*b, {type.hash_code(), name});
-  if (r == nullptr) {
-    return errors::NotFound("Resource ", container, "/", name, "/", type.name(),
-                            " does not exist.");
+  return ResourceNotFound(container, name, type.name());
+}
+
+Status ResourceMgr::ResourceNotFound(const string& container,
+                                     const string& name,
+                                     const string& type_name) const {
+  for (const Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    if (shard.containers.count(container) > 0) {
+      return errors::NotFound("Resource ", container, "/", name, "/",
+                              type_name, " does not exist.");
+    }
   }
-  *resource = const_cast<ResourceBase*>(r);
-  (*resource)->Ref();
-  return Status::OK();
+  return errors::NotFound("Container ", container, " does not exist.");
 }
 
 Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
@@ -146,20 +169,20 @@ Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
                              const string& type_name) {
   ResourceBase* base = nullptr;
   {
-    mutex_lock l(mu_);
-    Container* b = gtl::FindPtrOrNull(containers_, container);
-    if (b == nullptr) {
-      return errors::NotFound("Container ", container, " does not exist.");
-    }
-    auto iter = b->find({type_hash_code, resource_name});
-    if (iter == b->end()) {
-      return errors::NotFound("Resource ", container, "/", resource_name, "/",
-                              type_name, " does not exist.");
+    Shard& shard = shards_[ShardIndex(type_hash_code, resource_name)];
+    mutex_lock l(shard.mu);
+    Container* b = gtl::FindPtrOrNull(shard.containers, container);
+    if (b != nullptr) {
+      auto iter = b->find({type_hash_code, resource_name});
+      if (iter != b->end()) {
+        base = iter->second;
+        b->erase(iter);
+      }
     }
-    base = iter->second;
-    b->erase(iter);
   }
-  CHECK(base != nullptr);
+  if (base == nullptr) {
+    return ResourceNotFound(container, resource_name, type_name);
+  }
   base->Unref();
   return Status::OK();
 }
@@ -175,22 +198,22 @@ Status ResourceMgr::Delete(const ResourceHandle& handle) {
 }
 
 Status ResourceMgr::Cleanup(const string& container) {
-  Container* b = nullptr;
-  {
-    mutex_lock l(mu_);
-    auto iter = containers_.find(container);
-    if (iter == containers_.end()) {
-      // Nothing to cleanup, it's OK.
-      return Status::OK();
+  std::vector<Container*> containers;
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.mu);
+    auto iter = shard.containers.find(container);
+    if (iter != shard.containers.end()) {
+      containers.push_back(iter->second);
+      shard.containers.erase(iter);
     }
-    b = iter->second;
-    containers_.erase(iter);
   }
-  CHECK(b != nullptr);
-  for (const auto& p : *b) {
-    p.second->Unref();
+  // Nothing to cleanup if no shard has the container, it's OK.
+  for (Container* b : containers) {
+    for (const auto& p : *b) {
+      p.second->Unref();
+    }
+    delete b;
   }
-  delete b;
   return Status::OK();
 }
 
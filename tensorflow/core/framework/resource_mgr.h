@@ -171,8 +171,27 @@ class ResourceMgr {
   typedef std::unordered_map<Key, ResourceBase*, KeyHash, KeyEqual> Container;
 
   const string default_container_;
-  mutable mutex mu_;
-  std::unordered_map<string, Container*> containers_ GUARDED_BY(mu_);
+
+  // The resources are sharded by the hash of their type and name, each shard
+  // holding its own map of containers, so that the lookups of different
+  // resources, which are mostly in the same container, take different
+  // locks. A container exists as long as one of the shards has it.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutable mutex mu;
+    std::unordered_map<string, Container*> containers GUARDED_BY(mu);
+  };
+  Shard shards_[kNumShards];
+
+  static int ShardIndex(uint64 type_hash_code, const string& name) {
+    return (Hash64(name.data(), name.size(), type_hash_code) >> 32) %
+           kNumShards;
+  }
+
+  // Returns the NotFound error of a resource that is not in its shard,
+  // which says whether its container exists in any shard.
+  Status ResourceNotFound(const string& container, const string& name,
+                          const string& type_name) const;
 
   Status DoCreate(const string& container, TypeIndex type, const string& name,
                   ResourceBase* resource) TF_MUST_USE_RESULT;
@@ -186,16 +205,18 @@ class ResourceMgr {
 
   // Inserts the type name for 'hash_code' into the hash_code to type name map.
   Status InsertDebugTypeName(uint64 hash_code, const string& type_name)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
+      EXCLUSIVE_LOCKS_REQUIRED(debug_type_names_mu_) TF_MUST_USE_RESULT;
 
   // Returns the type name for the 'hash_code'.
   // Returns "<unknown>" if a resource with such a type was never inserted into
   // the container.
   const char* DebugTypeName(uint64 hash_code) const
-      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+      EXCLUSIVE_LOCKS_REQUIRED(debug_type_names_mu_);
 
   // Map from type hash_code to type name.
-  std::unordered_map<uint64, string> debug_type_names_ GUARDED_BY(mu_);
+  mutable mutex debug_type_names_mu_;
+  std::unordered_map<uint64, string> debug_type_names_
+      GUARDED_BY(debug_type_names_mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(ResourceMgr);
 };
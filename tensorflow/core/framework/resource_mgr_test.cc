@@ -121,6 +121,28 @@ TEST(ResourceMgrTest, Basic) {
   TF_CHECK_OK(rm.Cleanup("bar"));
 }
 
+// The resources of one container are spread over the shards of the
+// manager, which must still look them up and clean them up together.
+TEST(ResourceMgrTest, ManyResourcesInOneContainer) {
+  ResourceMgr rm;
+  const int kNumResources = 100;
+  for (int i = 0; i < kNumResources; ++i) {
+    TF_CHECK_OK(rm.Create("foo", strings::StrCat("r", i),
+                          new Resource(strings::StrCat(i))));
+  }
+  for (int i = 0; i < kNumResources; ++i) {
+    EXPECT_EQ(strings::StrCat("R/", i),
+              Find<Resource>(rm, "foo", strings::StrCat("r", i)));
+  }
+  HasError(FindErr<Resource>(rm, "foo", "xxx"), "Not found: Resource foo/xxx");
+
+  TF_CHECK_OK(rm.Cleanup("foo"));
+  for (int i = 0; i < kNumResources; ++i) {
+    HasError(FindErr<Resource>(rm, "foo", strings::StrCat("r", i)),
+             "Not found: Container foo");
+  }
+}
+
 TEST(ResourceMgr, CreateOrLookup) {
   ResourceMgr rm;
   EXPECT_EQ("R/cat", LookupOrCreate<Resource>(&rm, "foo", "bar", "cat"));
@@ -23,6 +23,10 @@ limitations under the License.
 //   default constructors and destructors when T is not a simple type
 //   (e.g., string.), and skips them otherwise.
 //
+// * InlineBuffer<T>: holds a small array T[n] of a simple type T in
+//   the buffer object itself, so that scalars and other tiny tensors
+//   on the CPU allocator cost one allocation instead of two.
+//
 // * Helper<T>: provides various routines given type T.  The routines
 //   includes running the constructor and destructor of T[], encoding
 //   an decoding T[] into/from a Cord, etc.
@@ -41,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -101,6 +106,58 @@ class Buffer : public BufferBase {
   TF_DISALLOW_COPY_AND_ASSIGN(Buffer);
 };
 
+// The largest array, in bytes, that InlineBuffer holds.
+constexpr size_t kMaxInlineBytes = 16;
+
+// Typed ref-counted buffer holding T[n] in place, where T is a simple
+// type and sizeof(T) * n <= kMaxInlineBytes. The buffer object and its
+// elements are allocated in one block, aligned as the CPU allocator
+// aligns its allocations.
+template <typename T>
+class InlineBuffer : public BufferBase {
+ public:
+  InlineBuffer(Allocator* a, int64 n) : BufferBase(a), elem_(n) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return sizeof(T) * elem_; }
+
+  void* operator new(size_t size) {
+    return port::AlignedMalloc(size, Allocator::kAllocatorAlignment);
+  }
+  void operator delete(void* ptr) { port::AlignedFree(ptr); }
+
+ private:
+  alignas(Allocator::kAllocatorAlignment) char data_[kMaxInlineBytes];
+  int64 elem_;
+
+  ~InlineBuffer() override {}
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Returns true if a tensor of "n" elements of T from "a" can use an
+// InlineBuffer. That bypasses the allocator, so it is only done for the
+// plain CPU allocator when nothing tracks, counts or logs its allocations.
+template <typename T>
+bool UseInlineBuffer(Allocator* a, int64 n) {
+  return is_simple_type<T>::value && sizeof(T) * n <= kMaxInlineBytes &&
+         a == cpu_allocator() && !a->TracksAllocationSizes() &&
+         !CPUAllocatorStatsEnabled() && !LogMemory::IsEnabled();
+}
+
+template <typename T>
+TensorBuffer* NewBuffer(Allocator* a, int64 n) {
+  if (UseInlineBuffer<T>(a, n)) return new InlineBuffer<T>(a, n);
+  return new Buffer<T>(a, n);
+}
+
+template <typename T>
+TensorBuffer* NewBuffer(Allocator* a, int64 n,
+                        const AllocationAttributes& allocation_attr) {
+  if (UseInlineBuffer<T>(a, n)) return new InlineBuffer<T>(a, n);
+  return new Buffer<T>(a, n, allocation_attr);
+}
+
 void LogUnexpectedSize(int64 actual, int64 expected) {
   LOG(ERROR) << "Input size was " << actual << " and expected " << expected;
 }
@@ -582,7 +639,7 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    CASES(type, buf_ = NewBuffer<T>(a, shape.num_elements()));
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
     LogMemory::RecordTensorAllocation("Unknown", LogMemory::UNKNOWN_STEP_ID,
@@ -596,7 +653,7 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    CASES(type, buf_ = NewBuffer<T>(a, shape.num_elements(), allocation_attr));
   }
   if (!allocation_attr.allocation_will_be_logged && buf_ != nullptr &&
       buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -892,6 +892,49 @@ static void BM_Assign(int iters) {
 }
 BENCHMARK(BM_Assign);
 
+// Tiny tensors of simple types keep their elements in their buffer,
+// which must still be aligned and shared like any other buffer.
+TEST(Tensor, TinyTensors) {
+  Tensor scalar(DT_DOUBLE, TensorShape({}));
+  scalar.scalar<double>()() = 3.5;
+  EXPECT_TRUE(scalar.IsAligned());
+  EXPECT_EQ(sizeof(double), scalar.TotalBytes());
+
+  Tensor copy = scalar;
+  EXPECT_TRUE(copy.SharesBufferWith(scalar));
+  copy.scalar<double>()() = 4.5;
+  EXPECT_EQ(4.5, scalar.scalar<double>()());
+
+  Tensor vec(DT_INT32, TensorShape({4}));
+  test::FillValues<int32>(&vec, {1, 2, 3, 4});
+  EXPECT_TRUE(vec.IsAligned());
+  Tensor slice = vec.Slice(2, 4);
+  EXPECT_TRUE(slice.SharesBufferWith(vec));
+  test::ExpectTensorEqual<int32>(slice,
+                                 test::AsTensor<int32>({3, 4}, {2}));
+
+  Tensor reshaped;
+  ASSERT_TRUE(reshaped.CopyFrom(vec, TensorShape({2, 2})));
+  EXPECT_TRUE(reshaped.SharesBufferWith(vec));
+
+  // One element more than fits in place.
+  Tensor larger(DT_INT32, TensorShape({5}));
+  EXPECT_TRUE(larger.IsAligned());
+  EXPECT_EQ(5 * sizeof(int32), larger.TotalBytes());
+
+  // While the CPU allocator collects stats, tiny tensors go through it too.
+  EnableCPUAllocatorStats(true);
+  AllocatorStats before;
+  cpu_allocator()->GetStats(&before);
+  {
+    Tensor counted(DT_INT32, TensorShape({2}));
+    AllocatorStats after;
+    cpu_allocator()->GetStats(&after);
+    EXPECT_EQ(before.num_allocs + 1, after.num_allocs);
+  }
+  EnableCPUAllocatorStats(false);
+}
+
 // Ensure tensor_data() works on empty tensors
 TEST(Tensor, EmptyTensorData) {
   Tensor empty;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -216,6 +217,23 @@ Microseconds CostModel::TimeEstimate(const Node* node) const {
   return std::max(kMinTimeEstimate, TotalTime(node) / std::max(1, count));
 }
 
+void CostModel::LongestPathPriorities(const Graph& graph,
+                                      std::vector<int64>* priorities) const {
+  priorities->assign(graph.num_node_ids(), 0);
+  // In post order, the successors of a node come before it, except for the
+  // destinations of back edges, which are still 0.
+  std::vector<Node*> order;
+  GetPostOrder(graph, &order);
+  for (const Node* n : order) {
+    int64 longest_out = 0;
+    for (const Edge* e : n->out_edges()) {
+      longest_out = std::max(longest_out, (*priorities)[e->dst()->id()]);
+    }
+    const int64 time = n->IsOp() ? TimeEstimate(n).value() : 0;
+    (*priorities)[n->id()] = longest_out + time;
+  }
+}
+
 void CostModel::CheckInitialized(const Graph& graph) const {
   for (const Node* n : graph.nodes()) {
     if (n->IsOp()) {
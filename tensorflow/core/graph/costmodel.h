@@ -106,6 +106,13 @@ class CostModel {
   // Returns a prediction for one execution of "node".
   Microseconds TimeEstimate(const Node* node) const;
 
+  // Sets (*priorities)[n->id()], for every node n of "graph", to the
+  // estimated time in microseconds of the longest path from n to a node
+  // without successors, including n itself. Back edges of loops are
+  // ignored. Nodes without an estimate count for kMinTimeEstimate.
+  void LongestPathPriorities(const Graph& graph,
+                             std::vector<int64>* priorities) const;
+
   // Check that an estimate is available for every OP node in graph.
   void CheckInitialized(const Graph& graph) const;
 
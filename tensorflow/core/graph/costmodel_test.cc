@@ -0,0 +1,70 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/graph/costmodel.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+void RecordTime(const Node* n, int64 micros, CostModel* cm) {
+  cm->RecordCount(n, 1);
+  cm->RecordTime(n, Microseconds(micros));
+}
+
+TEST(CostModelTest, LongestPathPriorities) {
+  Graph g(OpRegistry::Global());
+  Tensor value(DT_FLOAT, TensorShape({}));
+  value.scalar<float>()() = 1.0;
+  // in -> short -> out and in -> long_a -> long_b -> out.
+  Node* in = test::graph::Constant(&g, value);
+  Node* short_path = test::graph::Identity(&g, in);
+  Node* long_a = test::graph::Identity(&g, in);
+  Node* long_b = test::graph::Identity(&g, long_a);
+  Node* out = test::graph::Add(&g, short_path, long_b);
+  // Not timed.
+  Node* side = test::graph::Identity(&g, in);
+  FixupSourceAndSinkEdges(&g);
+
+  CostModel cm(false);
+  cm.InitFromGraph(g);
+  RecordTime(in, 10, &cm);
+  RecordTime(short_path, 50, &cm);
+  RecordTime(long_a, 20, &cm);
+  RecordTime(long_b, 40, &cm);
+  RecordTime(out, 5, &cm);
+
+  std::vector<int64> priorities;
+  cm.LongestPathPriorities(g, &priorities);
+  ASSERT_EQ(g.num_node_ids(), priorities.size());
+  EXPECT_EQ(5, priorities[out->id()]);
+  EXPECT_EQ(45, priorities[long_b->id()]);
+  EXPECT_EQ(65, priorities[long_a->id()]);
+  EXPECT_EQ(55, priorities[short_path->id()]);
+  EXPECT_EQ(75, priorities[in->id()]);
+  EXPECT_EQ(1, priorities[side->id()]);
+  EXPECT_EQ(75, priorities[g.source_node()->id()]);
+  EXPECT_EQ(0, priorities[g.sink_node()->id()]);
+}
+
+}  // namespace
+}  // namespace tensorflow
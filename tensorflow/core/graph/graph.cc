@@ -287,6 +287,12 @@ Node* Graph::AddNode(const NodeDef& node_def, Status* status) {
     return nullptr;
   }
 
+  return AddNode(node_def, op_def, inputs, outputs);
+}
+
+Node* Graph::AddNode(const NodeDef& node_def, const OpDef* op_def,
+                     const DataTypeVector& inputs,
+                     const DataTypeVector& outputs) {
   Node* node = AllocateNode(
       new Node::Properties(op_def, node_def, inputs, outputs), nullptr);
   return node;
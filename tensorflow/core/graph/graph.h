@@ -361,6 +361,12 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(const NodeDef& node_def, Status* status);
 
+  // Adds a new node to this graph whose Op and input/output types were
+  // already inferred from 'node_def', e.g. concurrently for many nodes, and
+  // returns it. *this owns the returned instance.
+  Node* AddNode(const NodeDef& node_def, const OpDef* op_def,
+                const DataTypeVector& inputs, const DataTypeVector& outputs);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
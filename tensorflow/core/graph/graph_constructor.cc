@@ -32,14 +32,21 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/scanner.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
 
 namespace {
+// The graphs with fewer nodes are prepared for conversion by a single thread,
+// which is faster than starting a pool of threads.
+const int kMinNodesForParallelPrepare = 1 << 14;
+
 inline bool IsMerge(const NodeDef& node_def) {
   return node_def.op() == "Merge" || node_def.op() == "RefMerge";
 }
@@ -131,6 +138,7 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  Status PrepareNodes();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -139,7 +147,9 @@ class GraphConstructor {
   void Undo();
 
   Status ValidateColocationConstraints(const NodeDef& node_def);
-  Status MakeNode(const NodeDef& node_def, Node** node);
+  // 'gdef_index' is the index of 'node_def' within gdef_, or -1 if it wasn't
+  // prepared by PrepareNodes().
+  Status MakeNode(const NodeDef& node_def, int gdef_index, Node** node);
   Status MakeEdge(Node* src, int output_index, Node* dst, int input_index);
   Status ValidateShape(Node* node);
   Status ModifyNodeDefForImport(NodeDef* node_def);
@@ -194,6 +204,28 @@ class GraphConstructor {
   // all nodes it outputs to.
   std::vector<gtl::InlinedVector<int, 4>> outputs_;
 
+  // The following are only used when converting a GraphDef as it is, i.e.
+  // when !opts_.importing, to save looking up the ops and the nodes by name
+  // during the conversion.
+
+  // Mapping between index within gdef_ and the index within gdef_ and output
+  // index of each of its inputs.
+  std::vector<gtl::InlinedVector<std::pair<int, int>, 4>> input_sources_;
+
+  // Mapping between index within gdef_ and its converted Node, which is
+  // nullptr until the NodeDef is converted.
+  std::vector<Node*> converted_nodes_;
+
+  // The Op and input/output types of each NodeDef in gdef_, computed
+  // concurrently by PrepareNodes(). 'op_def' is nullptr if they couldn't be
+  // inferred, in which case the conversion of the NodeDef reports the error.
+  struct PreparedNode {
+    const OpDef* op_def = nullptr;
+    DataTypeVector inputs;
+    DataTypeVector outputs;
+  };
+  std::vector<PreparedNode> prepared_nodes_;
+
   // Used in the conversion from gdef_ to g_ to represent the ith input
   // of a node.
   struct InputInfo {
@@ -354,6 +386,10 @@ Status GraphConstructor::InitFromEdges() {
   const int num_nodes = gdef_->node_size();
   pending_count_.reserve(num_nodes);
   outputs_.resize(num_nodes);
+  if (!opts_.importing) {
+    input_sources_.resize(num_nodes);
+    converted_nodes_.resize(num_nodes, nullptr);
+  }
 
   // Parse the inputs for each node.
   for (int n = 0; n < num_nodes; ++n) {
@@ -385,7 +421,54 @@ Status GraphConstructor::InitFromEdges() {
                                        node_def.input(i), "'");
       }
       outputs_[iter->second.gdef_index].push_back(n);
+      if (!opts_.importing) {
+        input_sources_[n].push_back(
+            std::make_pair(iter->second.gdef_index, id.second));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status GraphConstructor::PrepareNodes() {
+  if (opts_.importing) return Status::OK();
+  const int num_nodes = gdef_->node_size();
+  prepared_nodes_.resize(num_nodes);
+
+  // Look up each op once: the lookups take a lock of the op registry, which
+  // the threads below would contend for.
+  std::unordered_map<StringPiece, const OpDef*, StringPiece::Hasher> op_defs;
+  for (int n = 0; n < num_nodes; ++n) {
+    const string& op = gdef_->node(n).op();
+    auto iter = op_defs.find(op);
+    if (iter == op_defs.end()) {
+      const OpDef* op_def;
+      if (!g_->op_registry()->LookUpOpDef(op, &op_def).ok()) {
+        op_def = nullptr;
+      }
+      iter = op_defs.insert(std::make_pair(StringPiece(op), op_def)).first;
+    }
+    prepared_nodes_[n].op_def = iter->second;
+  }
+
+  auto prepare = [this](int64 start, int64 limit) {
+    for (int64 n = start; n < limit; ++n) {
+      PreparedNode* prepared = &prepared_nodes_[n];
+      if (prepared->op_def == nullptr) continue;
+      if (!InOutTypesForNode(gdef_->node(n), *prepared->op_def,
+                             &prepared->inputs, &prepared->outputs)
+               .ok()) {
+        prepared->op_def = nullptr;
+      }
     }
+  };
+  const int num_threads = port::NumSchedulableCPUs();
+  if (num_nodes < kMinNodesForParallelPrepare || num_threads < 2) {
+    prepare(0, num_nodes);
+  } else {
+    thread::ThreadPool pool(Env::Default(), "graph_constructor", num_threads);
+    // Inferring the types of a node takes a few thousand cycles.
+    pool.ParallelFor(num_nodes, 5000, prepare);
   }
   return Status::OK();
 }
@@ -407,11 +490,18 @@ Status GraphConstructor::ValidateColocationConstraints(
   return Status::OK();
 }
 
-Status GraphConstructor::MakeNode(const NodeDef& node_def, Node** node) {
+Status GraphConstructor::MakeNode(const NodeDef& node_def, int gdef_index,
+                                  Node** node) {
   // Add the node to the graph.
-  Status status;
-  *node = g_->AddNode(node_def, &status);
-  if (!status.ok()) return status;
+  if (gdef_index >= 0 && prepared_nodes_[gdef_index].op_def != nullptr) {
+    const PreparedNode& prepared = prepared_nodes_[gdef_index];
+    *node = g_->AddNode(node_def, prepared.op_def, prepared.inputs,
+                        prepared.outputs);
+  } else {
+    Status status;
+    *node = g_->AddNode(node_def, &status);
+    if (!status.ok()) return status;
+  }
   if (opts_.expect_device_spec) {
     (*node)->set_assigned_device_name(node_def.device());
   }
@@ -608,6 +698,7 @@ Status GraphConstructor::Convert() {
   // Import functions before adding nodes, since imported nodes may refer to
   // functions
   TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(gdef_->library()));
+  TF_RETURN_IF_ERROR(PrepareNodes());
 
   std::vector<InputInfo> inputs;
   int processed = 0;
@@ -653,21 +744,32 @@ Status GraphConstructor::Convert() {
 
     TF_RETURN_IF_ERROR(ValidateColocationConstraints(*node_def));
     for (int i = 0; i < node_def->input_size(); ++i) {
-      TensorId id(ParseTensorName(node_def->input(i)));
+      StringPiece src_name;
       Node* src_node;
       int src_index;
 
-      if (!input_already_exists[i]) {
+      if (!opts_.importing) {
+        // The input was already located by InitFromEdges().
+        const std::pair<int, int>& src = input_sources_[o][i];
+        src_name = gdef_->node(src.first).name();
+        src_node = converted_nodes_[src.first];
+        src_index = src.second;
+        if (src_node == nullptr) has_data_back_edge = true;
+      } else if (!input_already_exists[i]) {
         // Locate input in newly-imported nodes
+        TensorId id(ParseTensorName(node_def->input(i)));
         auto iter = gdef_nodes_.find(id.first);
         DCHECK(iter != gdef_nodes_.end()) << id.first;
+        src_name = id.first;
         src_node = iter->second.node;
         src_index = id.second;
         if (src_node == nullptr) has_data_back_edge = true;
       } else {
         // Input refers to preexistng node in graph
+        TensorId id(ParseTensorName(node_def->input(i)));
         auto iter = existing_nodes_.find(id.first);
         DCHECK(iter != existing_nodes_.end()) << id.first;
+        src_name = id.first;
         src_node = iter->second;
         src_index = id.second;
       }
@@ -675,11 +777,14 @@ Status GraphConstructor::Convert() {
       if (src_node != nullptr && src_index >= src_node->num_outputs()) {
         return errors::InvalidArgument(
             "Node '", node_def->name(), "': Connecting to invalid output ",
-            id.second, " of source node ", id.first, " which has ",
+            src_index, " of source node ", src_name, " which has ",
             src_node->num_outputs(), " outputs");
       }
 
-      inputs.push_back(InputInfo(id.first.ToString(), src_node, src_index));
+      // The name is only needed to add the back edges.
+      inputs.push_back(InputInfo(
+          src_node == nullptr ? src_name.ToString() : string(), src_node,
+          src_index));
     }
 
     if (has_data_back_edge && !IsMerge(*node_def)) {
@@ -693,9 +798,10 @@ Status GraphConstructor::Convert() {
       AddPrefixToNodeDef(input_already_exists, &imported_node_def);
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&imported_node_def));
     }
-    TF_RETURN_IF_ERROR(MakeNode(*node_def, &node));
+    TF_RETURN_IF_ERROR(MakeNode(*node_def, opts_.importing ? -1 : o, &node));
     // Use original_node_def so name StringPiece remains valid
     gdef_nodes_[original_node_def.name()].node = node;
+    if (!opts_.importing) converted_nodes_[o] = node;
 
     // Add edges from inputs to *node to the graph.
     for (size_t i = 0; i < inputs.size(); ++i) {
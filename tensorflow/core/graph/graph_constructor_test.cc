@@ -883,6 +883,40 @@ TEST_F(GraphConstructorTest, SimpleModelWithControlEdges) {
   EXPECT_TRUE(HasControlEdge("t1", "t2"));
 }
 
+// Returns a chain of TestMul nodes long enough for their types to be inferred
+// concurrently.
+string LargeModel(int num_nodes) {
+  string gdef_ascii = "node { name: 'input' op: 'TestInput' }";
+  for (int i = 0; i < num_nodes; ++i) {
+    string inputs = i == 0 ? "'input'" : strings::StrCat("'m", i - 1, "'");
+    strings::StrAppend(&inputs, ", 'input:1'");
+    if (i > 1) strings::StrAppend(&inputs, ", '^m", i - 2, "'");
+    strings::StrAppend(&gdef_ascii, "node { name: 'm", i,
+                       "' op: 'TestMul' input: [ ", inputs, " ] }");
+  }
+  return gdef_ascii;
+}
+
+TEST_F(GraphConstructorTest, LargeModel) {
+  const int num_nodes = 1 << 15;
+  ExpectOK(LargeModel(num_nodes));
+  // The source and sink nodes are in the graph too.
+  EXPECT_EQ(num_nodes + 3, graph_.num_nodes());
+  EXPECT_TRUE(HasEdge("input", 0, "m0", 0));
+  EXPECT_TRUE(HasEdge("m41", 0, "m42", 0));
+  EXPECT_TRUE(HasEdge("input", 1, "m42", 1));
+  EXPECT_TRUE(HasControlEdge("m40", "m42"));
+}
+
+TEST_F(GraphConstructorTest, Error_LargeModelTypeMismatch) {
+  // The errors are the same as for small graphs.
+  ExpectError(strings::StrCat(LargeModel(1 << 15),
+                              "node { name: 'int' op: 'TestInt' input: [ "
+                              "'input' ] }"),
+              {"Input 0 of node int was passed float from input:0 "
+               "incompatible with expected int32."});
+}
+
 TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
   ExpectError(
       "node { name: 'W1' op: 'TestParams' }"
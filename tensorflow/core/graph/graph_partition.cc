@@ -80,6 +80,19 @@ struct PairIntHash {
     return std::hash<int>()(x.first) ^ std::hash<int>()(x.second);
   }
 };
+
+struct PairIntStringHash {
+ public:
+  std::size_t operator()(const std::pair<int, string>& x) const {
+    return Hash64(x.second.data(), x.second.size(), x.first);
+  }
+};
+// A map from (src node id, dst location) to a data edge that transfers an
+// output of src to dst location.
+typedef std::unordered_map<std::pair<int, string>, const Edge*,
+                           PairIntStringHash>
+    DataTransferMap;
+
 // A map used to store memory types for the inputs/outputs of every node.
 // The key is a pair of ints consisting of a node id and input/output index.
 typedef std::unordered_map<std::pair<int, int>, MemoryType, PairIntHash>
@@ -721,6 +734,37 @@ Status AddControlFlow(const PartitionOptions& opts, Graph* g,
   return Status::OK();
 }
 
+// Collects, for every node and location, a data edge that sends an output
+// of the node to that location. A control edge from the node to the
+// location can wait on the recv of that edge instead of a transfer of its
+// own: the recv completes only once the node has run. Outputs of ref type,
+// which are not deduplicated, outputs of Switch, which can be dead while the
+// Switch itself is not, and edges into distributed loops are skipped.
+void FindDataTransfers(const PartitionOptions& opts, const Graph& g,
+                       DataTransferMap* transfers) {
+  auto in_control_loop = [](const Node* node) {
+    for (const Edge* in_edge : node->in_edges()) {
+      if (in_edge->IsControlEdge() && IsMerge(in_edge->src()) &&
+          IsControlLoop(in_edge->src())) {
+        return true;
+      }
+    }
+    return false;
+  };
+  for (const Edge* edge : g.edges()) {
+    const Node* src = edge->src();
+    const Node* dst = edge->dst();
+    if (edge->IsControlEdge() || !src->IsOp() || !dst->IsOp() ||
+        IsSwitch(src) || IsRefType(src->output_type(edge->src_output())) ||
+        in_control_loop(dst)) {
+      continue;
+    }
+    string dst_loc = opts.node_to_loc(dst);
+    if (dst_loc == opts.node_to_loc(src)) continue;
+    transfers->insert({{src->id(), std::move(dst_loc)}, edge});
+  }
+}
+
 }  // end namespace
 
 Status AddControlEdges(const PartitionOptions& opts,
@@ -819,6 +863,9 @@ Status Partition(const PartitionOptions& opts, Graph* g,
   status = BuildMemoryDeviceInfo(*g, &g_info);
   if (!status.ok()) return status;
 
+  DataTransferMap data_transfers;
+  FindDataTransfers(opts, *g, &data_transfers);
+
   string dstp;
   std::vector<const Edge*> inputs;
   DupRecvTable dup_recv(3);
@@ -914,10 +961,23 @@ Status Partition(const PartitionOptions& opts, Graph* g,
         }
       }
 
+      // A control edge waits on a data transfer from src to the dst
+      // partition, if there is one, instead of a transfer of its own. This
+      // is not done in distributed loops, where the recvs are themselves
+      // controlled by the loop.
+      const Edge* transfer_edge = edge;
+      if (edge->IsControlEdge() && control_flow_edge == nullptr) {
+        auto transfer = data_transfers.find({src->id(), dstp});
+        if (transfer != data_transfers.end()) {
+          transfer_edge = transfer->second;
+        }
+      }
+
       // Check whether there is already a send/recv pair transferring
       // the same tensor/control from the src to dst partition.
-      const bool on_host = IsDstInputOnHost(edge, g_info);
-      DupRecvKey key{src->id(), edge->src_output(), dst_graph, on_host};
+      const bool on_host = IsDstInputOnHost(transfer_edge, g_info);
+      DupRecvKey key{src->id(), transfer_edge->src_output(), dst_graph,
+                     on_host};
       auto iter = dup_recv.find(key);
       if (iter != dup_recv.end()) {
         // We found one. Reuse the data/control transferred already.
@@ -939,7 +999,7 @@ Status Partition(const PartitionOptions& opts, Graph* g,
       }
 
       NodeDefBuilder::NodeOut send_from;
-      if (edge->IsControlEdge()) {
+      if (transfer_edge->IsControlEdge()) {
         // Insert a dummy const node that will generate a tiny
         // data element to be sent from send to recv.
         VLOG(1) << "Send/Recv control: " << src->assigned_device_name() << "["
@@ -954,18 +1014,19 @@ Status Partition(const PartitionOptions& opts, Graph* g,
         AddInput(dummy, src->name(), Graph::kControlSlot);
         send_from.Reset(dummy->name(), 0, DT_FLOAT);
       } else {
-        send_from.Reset(src->name(), edge->src_output(), EdgeType(edge));
+        send_from.Reset(src->name(), transfer_edge->src_output(),
+                        EdgeType(transfer_edge));
       }
 
       // Need to split edge by placing matching send/recv nodes on
       // the src/dst sides of the edge.
-      NodeDef* send = AddSend(opts, g_info, src_graph, edge, send_from,
-                              send_start_time, &status);
+      NodeDef* send = AddSend(opts, g_info, src_graph, transfer_edge,
+                              send_from, send_start_time, &status);
       if (!status.ok()) return status;
 
       NodeDef* real_recv = nullptr;
-      NodeDef* recv =
-          AddRecv(opts, g_info, dst_graph, edge, &real_recv, &status);
+      NodeDef* recv = AddRecv(opts, g_info, dst_graph, transfer_edge,
+                              &real_recv, &status);
       if (!status.ok()) return status;
 
       // Fix up the control flow edge.
@@ -983,8 +1044,8 @@ Status Partition(const PartitionOptions& opts, Graph* g,
                  Graph::kControlSlot);
       }
 
-      if (!edge->IsControlEdge() &&
-          IsRefType(src->output_type(edge->src_output()))) {
+      if (!transfer_edge->IsControlEdge() &&
+          IsRefType(src->output_type(transfer_edge->src_output()))) {
         AddNodeAttr("_start_time", recv_start_time, recv);
         if (real_recv != recv) {
           AddNodeAttr("_start_time", recv_start_time, real_recv);
@@ -327,22 +327,17 @@ TEST_F(GraphPartitionTest, CrossDevice_DataControl) {
 
   string a = "/job:a/replica:0/task:0/cpu:0";
   string b = "/job:a/replica:0/task:0/cpu:1";
+  // The control edge to B3 waits on the recv of the data sent to B2 instead
+  // of a send/recv pair of its own.
   a1 = FloatInput(scope_a_.WithOpName("A1"));
-  auto c = Const(scope_a_.WithOpName("A1/_0").WithControlDependencies(a1), {});
-  // NOTE: Send 0 A1/_1 -> A1/_2 is not necessarily needed. We could
-  // use A1/_0 -> A1/_4 as the control as a minor optimization.
-  _Send(scope_a_.WithOpName("A1/_1"), c, "edge_1_A1", a, 82, b);
-  _Send(scope_a_.WithOpName("A1/_4"), a1, "edge_2_A1", a, 82, b);
+  _Send(scope_a_.WithOpName("A1/_0"), a1, "edge_2_A1", a, 82, b);
   ExpectMatchA();
 
-  auto recv1 =
-      _Recv(scope_b_.WithOpName("A1/_2"), DT_FLOAT, "edge_1_A1", a, 82, b);
-  auto id1 = Identity(scope_b_.WithOpName("A1/_3"), recv1);
-  auto recv2 =
-      _Recv(scope_b_.WithOpName("A1/_5"), DT_FLOAT, "edge_2_A1", a, 82, b);
+  auto recv =
+      _Recv(scope_b_.WithOpName("A1/_1"), DT_FLOAT, "edge_2_A1", a, 82, b);
   b1 = FloatInput(scope_b_.WithOpName("B1"));
-  Combine(scope_b_.WithOpName("B2"), recv2, b1);
-  FloatInput(scope_b_.WithOpName("B3").WithControlDependencies(id1));
+  Combine(scope_b_.WithOpName("B2"), recv, b1);
+  FloatInput(scope_b_.WithOpName("B3").WithControlDependencies(recv));
   ExpectMatchB();
 }
 
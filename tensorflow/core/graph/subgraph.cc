@@ -53,10 +53,11 @@ namespace {
 // Return true on success.  On error, return false and sets *error to
 // an appropriate error message (and *g is left in an indeterminate
 // state).
-static Status FeedInputs(Graph* g, const DeviceAttributes& device_info,
-                         const gtl::ArraySlice<string>& fed_outputs,
-                         bool use_function_convention,
-                         subgraph::NameIndex* name_index,
+static Status FeedInputs(
+    Graph* g, const DeviceAttributes& device_info,
+    const gtl::ArraySlice<string>& fed_outputs, bool use_function_convention,
+    const std::unordered_map<string, string>& feed_devices,
+    subgraph::NameIndex* name_index,
                          DataTypeVector* out_feed_types) {
   out_feed_types->clear();
   out_feed_types->reserve(fed_outputs.size());
@@ -101,7 +102,10 @@ static Status FeedInputs(Graph* g, const DeviceAttributes& device_info,
                              .Attr("index", static_cast<int32>(i))
                              .Finalize(g, &recv_node));
     }
-    recv_node->set_assigned_device_name(device_info.name());
+    auto device_it = feed_devices.find(t);
+    recv_node->set_assigned_device_name(device_it == feed_devices.end()
+                                            ? device_info.name()
+                                            : device_it->second);
 
     // Copy the _output_shapes from the original node to the feed node,
     // if any.
@@ -201,7 +205,9 @@ namespace subgraph {
 
 Status FetchOutputs(Graph* g, const DeviceAttributes& device_info,
                     const gtl::ArraySlice<string>& fetch_outputs,
-                    bool use_function_convention, NameIndex* name_index,
+                    bool use_function_convention,
+                    const std::unordered_map<string, string>& fetch_devices,
+                    NameIndex* name_index,
                     std::vector<Node*>* out_fetch_nodes,
                     DataTypeVector* out_fetch_types) {
   out_fetch_nodes->clear();
@@ -263,7 +269,10 @@ Status FetchOutputs(Graph* g, const DeviceAttributes& device_info,
                              .Attr("index", static_cast<int32>(i))
                              .Finalize(g, &send_node));
     }
-    send_node->set_assigned_device_name(device_info.name());
+    auto device_it = fetch_devices.find(t);
+    send_node->set_assigned_device_name(device_it == fetch_devices.end()
+                                            ? device_info.name()
+                                            : device_it->second);
 
     // Update the index.
     (*name_index)[send_node->name()] = send_node;
@@ -282,10 +291,30 @@ Status RewriteGraphForExecution(
     const gtl::ArraySlice<string>& target_node_names,
     const DeviceAttributes& device_info, bool use_function_convention,
     RewriteGraphMetadata* out_metadata) {
+  return RewriteGraphForExecution(g, fed_outputs, fetch_outputs,
+                                  target_node_names, device_info,
+                                  use_function_convention, {}, {},
+                                  out_metadata);
+}
+
+Status RewriteGraphForExecution(
+    Graph* g, const gtl::ArraySlice<string>& fed_outputs,
+    const gtl::ArraySlice<string>& fetch_outputs,
+    const gtl::ArraySlice<string>& target_node_names,
+    const DeviceAttributes& device_info, bool use_function_convention,
+    const std::unordered_map<string, string>& feed_devices,
+    const std::unordered_map<string, string>& fetch_devices,
+    RewriteGraphMetadata* out_metadata) {
   if (fetch_outputs.empty() && target_node_names.empty()) {
     return errors::InvalidArgument(
         "Must specify at least one target to fetch or execute.");
   }
+  if (!use_function_convention &&
+      (!feed_devices.empty() || !fetch_devices.empty())) {
+    return errors::InvalidArgument(
+        "Feeds and fetches can only be placed on other devices than the "
+        "client device with the function calling convention.");
+  }
 
   std::unordered_set<string> endpoints;
   for (const string& endpoint_name : fed_outputs) {
@@ -315,16 +344,16 @@ Status RewriteGraphForExecution(
   // kept up to date.
   if (!fed_outputs.empty()) {
     TF_RETURN_IF_ERROR(FeedInputs(g, device_info, fed_outputs,
-                                  use_function_convention, &name_index,
-                                  &out_metadata->feed_types));
+                                  use_function_convention, feed_devices,
+                                  &name_index, &out_metadata->feed_types));
   }
 
   // Add the fetch nodes, also updating "name_index".
   std::vector<Node*> fetch_nodes;
   if (!fetch_outputs.empty()) {
-    TF_RETURN_IF_ERROR(FetchOutputs(g, device_info, fetch_outputs,
-                                    use_function_convention, &name_index,
-                                    &fetch_nodes, &out_metadata->fetch_types));
+    TF_RETURN_IF_ERROR(FetchOutputs(
+        g, device_info, fetch_outputs, use_function_convention, fetch_devices,
+        &name_index, &fetch_nodes, &out_metadata->fetch_types));
   }
 
   // Prune the graph to only compute what is needed for the fetch nodes and the
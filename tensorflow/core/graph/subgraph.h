@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_GRAPH_SUBGRAPH_H_
 
 #include <string>
+#include <unordered_map>
 
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/graph/graph.h"
@@ -71,6 +72,19 @@ Status RewriteGraphForExecution(
     const DeviceAttributes& device_info, bool use_function_convention,
     RewriteGraphMetadata* out_metadata);
 
+// As above, but the feed and fetch nodes of the endpoints in "feed_devices"
+// and "fetch_devices" are placed on the devices they map to, rather than on
+// the device described by device_info, so that the fed and fetched tensors
+// live in the memory of these devices. Requires use_function_convention.
+Status RewriteGraphForExecution(
+    Graph* g, const gtl::ArraySlice<string>& fed_outputs,
+    const gtl::ArraySlice<string>& fetch_outputs,
+    const gtl::ArraySlice<string>& target_node_names,
+    const DeviceAttributes& device_info, bool use_function_convention,
+    const std::unordered_map<string, string>& feed_devices,
+    const std::unordered_map<string, string>& fetch_devices,
+    RewriteGraphMetadata* out_metadata);
+
 typedef std::unordered_map<StringPiece, Node*, StringPiece::Hasher> NameIndex;
 
 // Augment "*g" by adding special "fetch" nodes that connect to the
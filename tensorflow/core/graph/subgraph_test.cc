@@ -267,6 +267,32 @@ TEST_F(SubgraphTest, FetchOutputs1_FunctionConvention) {
       "retval_t2_0_3");
 }
 
+TEST_F(SubgraphTest, FeedAndFetchDevices_FunctionConvention) {
+  ExpectOK(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'input:1' ] }"
+      "node { name: 't2' op: 'TestRelu' input: 't1' }");
+  DeviceAttributes device_info;
+  device_info.set_name("/job:a/replica:0/task:0/cpu:0");
+  const string gpu = "/job:a/replica:0/task:0/gpu:0";
+  subgraph::RewriteGraphMetadata metadata;
+  TF_ASSERT_OK(subgraph::RewriteGraphForExecution(
+      graph(), {"input:1"}, {"t1", "t2"}, {}, device_info,
+      true /* use_function_convention */, {{"input:1", gpu}}, {{"t2", gpu}},
+      &metadata));
+  ExpectNodes("W1,_arg_input_1_0,t1,t2,_retval_t1_0_0,_retval_t2_0_1");
+  EXPECT_EQ(gpu, FindNode("_arg_input_1_0")->assigned_device_name());
+  EXPECT_EQ(device_info.name(),
+            FindNode("_retval_t1_0_0")->assigned_device_name());
+  EXPECT_EQ(gpu, FindNode("_retval_t2_0_1")->assigned_device_name());
+
+  // Recv and Send nodes always run on the client device.
+  EXPECT_TRUE(errors::IsInvalidArgument(subgraph::RewriteGraphForExecution(
+      graph(), {}, {"t1"}, {}, device_info,
+      false /* use_function_convention */, {}, {{"t1", gpu}}, &metadata)));
+}
+
 TEST_F(SubgraphTest, FetchOutputs2) {
   ExpectOK(
       "node { name: 'W1' op: 'TestParams' }"
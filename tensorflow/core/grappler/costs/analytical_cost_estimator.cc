@@ -0,0 +1,157 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns the size of a tensor in bytes, or -1 if its shape isn't fully known.
+int64 GetTensorSize(const OpInfo::TensorProperties& tensor) {
+  if (tensor.shape().unknown_rank()) {
+    return -1;
+  }
+  int64 size = DataTypeSize(BaseType(tensor.dtype()));
+  for (const auto& dim : tensor.shape().dim()) {
+    if (dim.size() < 0) {
+      return -1;
+    }
+    size *= dim.size();
+  }
+  return size;
+}
+
+}  // namespace
+
+Status AnalyticalCostEstimator::Initialize(const GrapplerItem& item) {
+  item_ = item;
+  return Status::OK();
+}
+
+OpInfo::DeviceProperties AnalyticalCostEstimator::GetDeviceProperties(
+    const string& device) const {
+  auto properties = devices_.find(device);
+  if (properties != devices_.end()) {
+    return properties->second;
+  }
+  DeviceNameUtils::ParsedName parsed;
+  if (DeviceNameUtils::ParseFullName(device, &parsed) && parsed.has_type &&
+      str_util::Uppercase(parsed.type) == "GPU") {
+    return GetLocalGPUInfo(parsed.has_id ? parsed.id : 0);
+  }
+  // The nodes that aren't placed yet run on the CPU by default.
+  return GetLocalCPUInfo();
+}
+
+Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
+                                             CostGraphDef* cost_graph,
+                                             Costs* overall_cost) const {
+  if (item_.fetch.empty()) {
+    return errors::InvalidArgument(
+        "The cost of a graph can only be predicted for fetch nodes");
+  }
+  GrapplerItem item = item_;
+  item.graph = optimized_graph;
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+
+  std::unordered_map<string, OpInfo::DeviceProperties> device_properties;
+  std::unordered_map<string, int> node_ids;
+  bool inaccurate = false;
+  VirtualScheduler scheduler(optimized_graph, item_.fetch);
+  Costs node_costs;
+  do {
+    const NodeDef* node = scheduler.GetCurrNode();
+    OpInfo op_features;
+    op_features.set_op(node->op());
+    *op_features.mutable_attr() = node->attr();
+    for (const auto& input : properties.GetInputProperties(node->name())) {
+      *op_features.add_inputs() = input;
+    }
+    const std::vector<OpInfo::TensorProperties> outputs =
+        properties.GetOutputProperties(node->name());
+    for (const auto& output : outputs) {
+      *op_features.add_outputs() = output;
+    }
+    auto device = device_properties.find(node->device());
+    if (device == device_properties.end()) {
+      device = device_properties
+                   .emplace(node->device(), GetDeviceProperties(node->device()))
+                   .first;
+    }
+    *op_features.mutable_device() = device->second;
+
+    node_costs = node_estimator_.PredictCosts(op_features);
+    inaccurate = inaccurate || node_costs.inaccurate;
+
+    if (cost_graph != nullptr) {
+      // The nodes are scheduled after their inputs, whose ids are therefore
+      // already known.
+      const int id = cost_graph->node_size();
+      node_ids[node->name()] = id;
+      CostGraphDef::Node* cost_node = cost_graph->add_node();
+      cost_node->set_name(node->name());
+      cost_node->set_device(node->device());
+      cost_node->set_id(id);
+      for (const string& input : node->input()) {
+        const int port = NodePosition(input);
+        const int input_id = node_ids[NodeName(input)];
+        if (port < 0) {
+          cost_node->add_control_input(input_id);
+        } else {
+          auto* input_info = cost_node->add_input_info();
+          input_info->set_preceding_node(input_id);
+          input_info->set_preceding_port(port);
+        }
+      }
+      for (const auto& output : outputs) {
+        auto* output_info = cost_node->add_output_info();
+        output_info->set_size(GetTensorSize(output));
+        output_info->set_alias_input_port(-1);
+        *output_info->mutable_shape() = output.shape();
+        output_info->set_dtype(output.dtype());
+      }
+      cost_node->set_compute_cost(
+          node_costs.execution_time.asMicroSeconds().count());
+      cost_node->set_compute_time(
+          node_costs.compute_time.asMicroSeconds().count());
+      cost_node->set_memory_time(
+          node_costs.memory_time.asMicroSeconds().count());
+    }
+  } while (scheduler.MarkCurrNodeExecuted(node_costs));
+
+  *overall_cost = scheduler.Summary();
+  overall_cost->inaccurate = inaccurate;
+  return Status::OK();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
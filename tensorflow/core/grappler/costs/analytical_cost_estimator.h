@@ -0,0 +1,73 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
+#define TENSORFLOW_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
+
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+class CostGraphDef;
+class GraphDef;
+}  // namespace tensorflow
+
+namespace tensorflow {
+namespace grappler {
+
+// Estimate the cost of running a Grappler item without running it: the shapes
+// inferred statically by GraphProperties are used to predict the cost of each
+// node with the OpLevelCostEstimator, and the VirtualScheduler combines them
+// into the step time and the peak memory usage of the graph.
+class AnalyticalCostEstimator : public CostEstimator {
+ public:
+  // The nodes are assumed to run on the local CPU and GPUs.
+  AnalyticalCostEstimator() {}
+  // The nodes placed on the devices named in `devices` are assumed to run on
+  // devices with these properties, which lets graphs be tuned for machines
+  // other than the local one. The other nodes run on the local devices.
+  explicit AnalyticalCostEstimator(
+      const std::unordered_map<string, OpInfo::DeviceProperties>& devices)
+      : devices_(devices) {}
+  ~AnalyticalCostEstimator() override {}
+
+  // Initalizes the estimator for the specified grappler item.
+  // This implementation always returns OK.
+  Status Initialize(const GrapplerItem& item) override;
+
+  // Predicts the cost of the ops of the optimized graph from their shapes,
+  // and annotates the CostGraphDef with the predictions.
+  // Returns the predicted latency of the whole graph, and its peak memory
+  // usage as the max_memory.
+  Status PredictCosts(const GraphDef& optimized_graph, CostGraphDef* cost_graph,
+                      Costs* overall_cost) const override;
+
+ private:
+  OpInfo::DeviceProperties GetDeviceProperties(const string& device) const;
+
+  GrapplerItem item_;
+  std::unordered_map<string, OpInfo::DeviceProperties> devices_;
+  OpLevelCostEstimator node_estimator_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
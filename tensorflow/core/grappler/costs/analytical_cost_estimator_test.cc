@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kCpu0[] = "/job:localhost/replica:0/task:0/cpu:0";
+
+class AnalyticalCostEstimatorTest : public ::testing::Test {
+ protected:
+  // A CPU running 100 billion operations per second, and reading 32GB/s.
+  std::unordered_map<string, OpInfo::DeviceProperties> Devices() {
+    OpInfo::DeviceProperties cpu;
+    cpu.set_type("CPU");
+    cpu.set_bandwidth(32000000);
+    std::unordered_map<string, OpInfo::DeviceProperties> devices;
+    devices[kCpu0] = cpu;
+    return devices;
+  }
+
+  // Builds a graph running a 1000x1000 matrix product followed by a Relu.
+  GrapplerItem MatMulRelu() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCpu0);
+    Output a = ops::Const(s.WithOpName("a"), 1.0f, {1000, 1000});
+    Output b = ops::Const(s.WithOpName("b"), 1.0f, {1000, 1000});
+    Output m = ops::MatMul(s.WithOpName("m"), a, b);
+    Output r = ops::Relu(s.WithOpName("r"), m);
+
+    GrapplerItem item;
+    item.fetch.push_back("r");
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(AnalyticalCostEstimatorTest, PredictStepTimeAndMemory) {
+  GrapplerItem item = MatMulRelu();
+  AnalyticalCostEstimator estimator(Devices());
+  TF_ASSERT_OK(estimator.Initialize(item));
+
+  CostGraphDef cost_graph;
+  Costs costs;
+  TF_ASSERT_OK(estimator.PredictCosts(item.graph, &cost_graph, &costs));
+
+  // The MatMul runs 2e9 operations, and the Relu reads and writes 8MB.
+  EXPECT_EQ(Costs::Duration(20000000 + 250000), costs.execution_time);
+  // The output of the MatMul is live until the Relu has run.
+  EXPECT_EQ(8000000, costs.max_memory);
+  EXPECT_FALSE(costs.inaccurate);
+
+  EXPECT_EQ(4, cost_graph.node_size());
+  for (const auto& node : cost_graph.node()) {
+    EXPECT_EQ(kCpu0, node.device());
+    EXPECT_EQ(1, node.output_info_size());
+    if (node.name() == "m") {
+      EXPECT_EQ(2, node.input_info_size());
+      EXPECT_EQ(20000, node.compute_cost());
+      EXPECT_EQ(4000000, node.output_info(0).size());
+    } else if (node.name() == "r") {
+      EXPECT_EQ(1, node.input_info_size());
+      EXPECT_EQ(250, node.compute_cost());
+    }
+  }
+}
+
+TEST_F(AnalyticalCostEstimatorTest, RequiresFetchNodes) {
+  GrapplerItem item = MatMulRelu();
+  item.fetch.clear();
+  AnalyticalCostEstimator estimator(Devices());
+  TF_ASSERT_OK(estimator.Initialize(item));
+
+  Costs costs;
+  EXPECT_FALSE(estimator.PredictCosts(item.graph, nullptr, &costs).ok());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
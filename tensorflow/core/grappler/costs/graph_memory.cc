@@ -83,7 +83,7 @@ void GraphMemory::InferMemUsageForNodes(
 }
 
 int64 GraphMemory::InferMemUsageForNeighbors(
-    const std::vector<OpInfo::TensorProperties>& props) const {
+    const std::vector<OpInfo::TensorProperties>& props) {
   int64 neighbors_memory_usage = 0;
   for (const auto& prop : props) {
     DataType dtype = prop.dtype();
@@ -99,7 +99,7 @@ int64 GraphMemory::InferMemUsageForNeighbors(
         shape.mutable_dim(i)->set_size(1);
       }
     }
-    int num_elems = TensorShape(shape).num_elements();
+    int64 num_elems = TensorShape(shape).num_elements();
     neighbors_memory_usage += num_elems * size;
   }
   return neighbors_memory_usage;
@@ -42,12 +42,15 @@ class GraphMemory {
   // that which is needed for a single node to perform its computations.
   int64 GetBestCaseMemoryUsage() const { return best_case_memory_usage_; }
 
+  // Estimated size in bytes of the given tensors. Tensors of unknown rank are
+  // skipped, and unknown dimensions are assumed to be 1.
+  static int64 InferMemUsageForNeighbors(
+      const std::vector<OpInfo::TensorProperties>& props);
+
  private:
   void InferMemUsageForNodes(const std::vector<const NodeDef*>& nodes,
                              GraphProperties* properties, int64* worst_case,
                              int64* best_case) const;
-  int64 InferMemUsageForNeighbors(
-      const std::vector<OpInfo::TensorProperties>& props) const;
 
   // Inputs
   GrapplerItem item_;
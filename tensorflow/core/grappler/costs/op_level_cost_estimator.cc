@@ -0,0 +1,524 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// A multiply-accumulate counts as two operations.
+constexpr int kOpsPerMac = 2;
+// Used when the properties of a device don't describe its performance.
+constexpr double kDefaultCpuGigaops = 100;
+constexpr double kDefaultCpuGbPerSec = 32;
+constexpr double kDefaultGpuGigaops = 4000;
+constexpr double kDefaultGpuGbPerSec = 200;
+// The number of CUDA cores of the multiprocessors of recent GPUs.
+constexpr int kGpuCoresPerMultiprocessor = 128;
+
+// Returns the dimensions of a tensor of the given rank. The dimensions that
+// aren't known are set to 1, and set *found_unknown_shapes.
+std::vector<int64> GetDims(const OpInfo::TensorProperties& tensor, int rank,
+                           bool* found_unknown_shapes) {
+  std::vector<int64> dims(rank, 1);
+  const TensorShapeProto& shape = tensor.shape();
+  if (shape.unknown_rank() || shape.dim_size() != rank) {
+    *found_unknown_shapes = true;
+    return dims;
+  }
+  for (int i = 0; i < rank; ++i) {
+    if (shape.dim(i).size() < 0) {
+      *found_unknown_shapes = true;
+    } else {
+      dims[i] = shape.dim(i).size();
+    }
+  }
+  return dims;
+}
+
+string GetStringAttr(const OpInfo& op_features, const string& name,
+                     const string& default_value) {
+  auto attr = op_features.attr().find(name);
+  return attr == op_features.attr().end() ? default_value : attr->second.s();
+}
+
+bool GetBoolAttr(const OpInfo& op_features, const string& name) {
+  auto attr = op_features.attr().find(name);
+  return attr != op_features.attr().end() && attr->second.b();
+}
+
+// The dimensions of a 2D convolution.
+struct ConvolutionDimensions {
+  int64 batch;
+  int64 in_rows;
+  int64 in_cols;
+  int64 in_depth;
+  int64 filter_rows;
+  int64 filter_cols;
+  int64 out_depth;
+  int64 stride_rows;
+  int64 stride_cols;
+};
+
+// Reads the strides of a convolution from its attributes.
+void GetStrides(const OpInfo& op_features, bool nchw,
+                ConvolutionDimensions* dims) {
+  dims->stride_rows = 1;
+  dims->stride_cols = 1;
+  auto strides = op_features.attr().find("strides");
+  if (strides != op_features.attr().end() &&
+      strides->second.list().i_size() == 4) {
+    dims->stride_rows = strides->second.list().i(nchw ? 2 : 1);
+    dims->stride_cols = strides->second.list().i(nchw ? 3 : 2);
+  }
+}
+
+int64 GetOutputSize(int64 input_size, int64 filter_size, int64 stride,
+                    const string& padding) {
+  stride = std::max<int64>(stride, 1);
+  if (padding == "VALID") {
+    input_size = input_size - filter_size + 1;
+  }
+  return std::max<int64>((input_size + stride - 1) / stride, 1);
+}
+
+// Returns the number of operations of a convolution whose output has
+// out_rows * out_cols positions.
+int64 CountConvolutionOperations(const ConvolutionDimensions& dims,
+                                 int64 out_rows, int64 out_cols) {
+  return dims.batch * out_rows * out_cols * dims.filter_rows *
+         dims.filter_cols * dims.in_depth * dims.out_depth * kOpsPerMac;
+}
+
+}  // namespace
+
+OpLevelCostEstimator::OpLevelCostEstimator() {
+  device_cost_impl_ = {
+      {"Conv2D", &OpLevelCostEstimator::PredictConv2D},
+      {"_FusedConv2D", &OpLevelCostEstimator::PredictConv2D},
+      {"Conv2DBackpropInput",
+       &OpLevelCostEstimator::PredictConv2DBackpropInput},
+      {"Conv2DBackpropFilter",
+       &OpLevelCostEstimator::PredictConv2DBackpropFilter},
+      {"MatMul", &OpLevelCostEstimator::PredictMatMul},
+      {"_FusedMatMul", &OpLevelCostEstimator::PredictMatMul},
+      {"SparseMatMul", &OpLevelCostEstimator::PredictMatMul},
+      {"BatchMatMul", &OpLevelCostEstimator::PredictBatchMatMul},
+
+      // These ops only alias or forward their inputs, or are bookkeeping.
+      {"NoOp", &OpLevelCostEstimator::PredictNoOp},
+      {"Identity", &OpLevelCostEstimator::PredictNoOp},
+      {"RefIdentity", &OpLevelCostEstimator::PredictNoOp},
+      {"StopGradient", &OpLevelCostEstimator::PredictNoOp},
+      {"PreventGradient", &OpLevelCostEstimator::PredictNoOp},
+      {"Const", &OpLevelCostEstimator::PredictNoOp},
+      {"Placeholder", &OpLevelCostEstimator::PredictNoOp},
+      {"PlaceholderV2", &OpLevelCostEstimator::PredictNoOp},
+      {"PlaceholderWithDefault", &OpLevelCostEstimator::PredictNoOp},
+      {"Variable", &OpLevelCostEstimator::PredictNoOp},
+      {"VariableV2", &OpLevelCostEstimator::PredictNoOp},
+      {"VarHandleOp", &OpLevelCostEstimator::PredictNoOp},
+      {"Reshape", &OpLevelCostEstimator::PredictNoOp},
+      {"Squeeze", &OpLevelCostEstimator::PredictNoOp},
+      {"ExpandDims", &OpLevelCostEstimator::PredictNoOp},
+      {"Shape", &OpLevelCostEstimator::PredictNoOp},
+      {"Size", &OpLevelCostEstimator::PredictNoOp},
+      {"Rank", &OpLevelCostEstimator::PredictNoOp},
+      {"Enter", &OpLevelCostEstimator::PredictNoOp},
+      {"Exit", &OpLevelCostEstimator::PredictNoOp},
+      {"Switch", &OpLevelCostEstimator::PredictNoOp},
+      {"Merge", &OpLevelCostEstimator::PredictNoOp},
+      {"NextIteration", &OpLevelCostEstimator::PredictNoOp},
+  };
+
+  elementwise_ops_ = {
+      // Unary ops.
+      {"Abs", 1},
+      {"Ceil", 1},
+      {"Cast", 1},
+      {"Elu", 1},
+      {"Exp", 4},
+      {"Floor", 1},
+      {"Log", 4},
+      {"Neg", 1},
+      {"Reciprocal", 4},
+      {"Relu", 1},
+      {"Relu6", 1},
+      {"Rsqrt", 4},
+      {"Sigmoid", 4},
+      {"Sign", 1},
+      {"Sqrt", 4},
+      {"Square", 1},
+      {"Tanh", 4},
+      // Binary ops, and AddN which runs one addition per extra input.
+      {"Add", 1},
+      {"AddN", 1},
+      {"BiasAdd", 1},
+      {"Div", 4},
+      {"Equal", 1},
+      {"Greater", 1},
+      {"GreaterEqual", 1},
+      {"Less", 1},
+      {"LessEqual", 1},
+      {"Maximum", 1},
+      {"Minimum", 1},
+      {"Mul", 1},
+      {"NotEqual", 1},
+      {"RealDiv", 4},
+      {"ReluGrad", 1},
+      {"Relu6Grad", 1},
+      {"SquaredDifference", 2},
+      {"Sub", 1},
+  };
+}
+
+Costs OpLevelCostEstimator::PredictCosts(const OpInfo& op_features) const {
+  auto impl = device_cost_impl_.find(op_features.op());
+  if (impl != device_cost_impl_.end()) {
+    return (this->*impl->second)(op_features);
+  }
+  if (elementwise_ops_.find(op_features.op()) != elementwise_ops_.end()) {
+    return PredictCwiseOp(op_features);
+  }
+  VLOG(1) << "Missing cost model for op: " << op_features.op();
+  return PredictUnknownOp(op_features);
+}
+
+OpLevelCostEstimator::DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
+    const OpInfo::DeviceProperties& device) const {
+  DeviceInfo info;
+  // Frequencies are in MHz.
+  const double giga_cycles_per_sec =
+      device.num_cores() * device.frequency() * 1e-3;
+  if (device.type() == "GPU") {
+    info.gigaops = giga_cycles_per_sec > 0
+                       ? giga_cycles_per_sec * kGpuCoresPerMultiprocessor *
+                             kOpsPerMac
+                       : kDefaultGpuGigaops;
+    info.gb_per_sec = kDefaultGpuGbPerSec;
+  } else {
+    // Each core runs a vector multiply-accumulate per cycle.
+    int vector_width = 1;
+    auto instruction_set = device.environment().find("cpu_instruction_set");
+    if (instruction_set != device.environment().end()) {
+      if (instruction_set->second.find("AVX") != string::npos) {
+        vector_width = 8;
+      } else if (instruction_set->second.find("SSE") != string::npos) {
+        vector_width = 4;
+      }
+    }
+    info.gigaops = giga_cycles_per_sec > 0
+                       ? giga_cycles_per_sec * vector_width * kOpsPerMac
+                       : kDefaultCpuGigaops;
+    info.gb_per_sec = kDefaultCpuGbPerSec;
+  }
+  // The bandwidth is in KB/s.
+  if (device.bandwidth() > 0) {
+    info.gb_per_sec = device.bandwidth() * 1e-6;
+  }
+  return info;
+}
+
+Costs OpLevelCostEstimator::PredictConv2D(const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  Costs costs = PredictOpCountBasedCost(
+      CountConv2DOperations(op_features, &found_unknown_shapes), op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictConv2DBackpropInput(
+    const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  Costs costs = PredictOpCountBasedCost(
+      CountConv2DBackpropOperations(op_features, &found_unknown_shapes),
+      op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictConv2DBackpropFilter(
+    const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  Costs costs = PredictOpCountBasedCost(
+      CountConv2DBackpropOperations(op_features, &found_unknown_shapes),
+      op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictMatMul(const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  Costs costs = PredictOpCountBasedCost(
+      CountMatMulOperations(op_features, &found_unknown_shapes), op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictBatchMatMul(
+    const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  Costs costs = PredictOpCountBasedCost(
+      CountBatchMatMulOperations(op_features, &found_unknown_shapes),
+      op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictCwiseOp(const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  int64 num_elements = 0;
+  if (op_features.outputs_size() > 0) {
+    for (const auto& output : op_features.outputs()) {
+      num_elements +=
+          CalculateTensorElementCount(output, &found_unknown_shapes);
+    }
+  } else {
+    // Broadcasting makes the output as large as the largest input.
+    for (const auto& input : op_features.inputs()) {
+      num_elements =
+          std::max(num_elements,
+                   CalculateTensorElementCount(input, &found_unknown_shapes));
+    }
+  }
+  const int num_operands = std::max(op_features.inputs_size() - 1, 1);
+  const double operations = static_cast<double>(num_elements) *
+                            elementwise_ops_.at(op_features.op()) *
+                            num_operands;
+  Costs costs = PredictOpCountBasedCost(operations, op_features);
+  costs.inaccurate = costs.inaccurate || found_unknown_shapes;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictNoOp(const OpInfo& op_features) const {
+  return Costs::ZeroCosts();
+}
+
+Costs OpLevelCostEstimator::PredictUnknownOp(const OpInfo& op_features) const {
+  // Assume the op is bound by its memory accesses.
+  Costs costs = PredictOpCountBasedCost(0, op_features);
+  costs.inaccurate = true;
+  return costs;
+}
+
+Costs OpLevelCostEstimator::PredictOpCountBasedCost(
+    double operations, const OpInfo& op_features) const {
+  bool found_unknown_shapes = false;
+  const DeviceInfo device_info = GetDeviceInfo(op_features.device());
+  const double input_size =
+      CalculateInputSize(op_features, &found_unknown_shapes);
+  const double output_size =
+      CalculateOutputSize(op_features, &found_unknown_shapes);
+
+  Costs costs = Costs::ZeroCosts();
+  // Billions of operations per second and GB/s are also operations and bytes
+  // per nanosecond.
+  costs.compute_time = Costs::Duration(operations / device_info.gigaops);
+  costs.memory_time =
+      Costs::Duration((input_size + output_size) / device_info.gb_per_sec);
+  costs.execution_time = std::max(costs.compute_time, costs.memory_time);
+  costs.max_memory = output_size;
+  costs.max_per_op_buffers = input_size + output_size;
+  costs.inaccurate = found_unknown_shapes;
+  VLOG(2) << "Op " << op_features.op() << ": " << operations
+          << " operations, " << input_size + output_size << " bytes, "
+          << costs.execution_time;
+  return costs;
+}
+
+int64 OpLevelCostEstimator::CountConv2DOperations(const OpInfo& op_features,
+                                                  bool* found_unknown_shapes) {
+  if (op_features.inputs_size() < 2) {
+    *found_unknown_shapes = true;
+    return 0;
+  }
+  const bool nchw = GetStringAttr(op_features, "data_format", "NHWC") == "NCHW";
+  const std::vector<int64> input =
+      GetDims(op_features.inputs(0), 4, found_unknown_shapes);
+  const std::vector<int64> filter =
+      GetDims(op_features.inputs(1), 4, found_unknown_shapes);
+
+  ConvolutionDimensions dims;
+  dims.batch = input[0];
+  dims.in_rows = input[nchw ? 2 : 1];
+  dims.in_cols = input[nchw ? 3 : 2];
+  dims.in_depth = input[nchw ? 1 : 3];
+  // The filters are in HWIO format.
+  dims.filter_rows = filter[0];
+  dims.filter_cols = filter[1];
+  dims.out_depth = filter[3];
+  GetStrides(op_features, nchw, &dims);
+
+  const string padding = GetStringAttr(op_features, "padding", "SAME");
+  return CountConvolutionOperations(
+      dims,
+      GetOutputSize(dims.in_rows, dims.filter_rows, dims.stride_rows, padding),
+      GetOutputSize(dims.in_cols, dims.filter_cols, dims.stride_cols, padding));
+}
+
+int64 OpLevelCostEstimator::CountConv2DBackpropOperations(
+    const OpInfo& op_features, bool* found_unknown_shapes) {
+  if (op_features.inputs_size() < 3) {
+    *found_unknown_shapes = true;
+    return 0;
+  }
+  const bool nchw = GetStringAttr(op_features, "data_format", "NHWC") == "NCHW";
+  // Both gradients run as many operations as the convolution, whose output
+  // has the shape of out_backprop.
+  const std::vector<int64> out_backprop =
+      GetDims(op_features.inputs(2), 4, found_unknown_shapes);
+  ConvolutionDimensions dims;
+  dims.batch = out_backprop[0];
+  dims.out_depth = out_backprop[nchw ? 1 : 3];
+  const int64 out_rows = out_backprop[nchw ? 2 : 1];
+  const int64 out_cols = out_backprop[nchw ? 3 : 2];
+
+  // The filter is input 1 of Conv2DBackpropInput. Conv2DBackpropFilter only
+  // has its shape, as the value of input 1.
+  std::vector<int64> filter(4, 1);
+  if (op_features.op() == "Conv2DBackpropFilter") {
+    Tensor filter_sizes;
+    if (op_features.inputs(1).has_value() &&
+        filter_sizes.FromProto(op_features.inputs(1).value()) &&
+        filter_sizes.dtype() == DT_INT32 && filter_sizes.NumElements() == 4) {
+      for (int i = 0; i < 4; ++i) {
+        filter[i] = filter_sizes.flat<int32>()(i);
+      }
+    } else {
+      *found_unknown_shapes = true;
+      const std::vector<int64> input =
+          GetDims(op_features.inputs(0), 4, found_unknown_shapes);
+      filter[2] = input[nchw ? 1 : 3];
+    }
+  } else {
+    filter = GetDims(op_features.inputs(1), 4, found_unknown_shapes);
+  }
+  dims.filter_rows = filter[0];
+  dims.filter_cols = filter[1];
+  dims.in_depth = filter[2];
+  return CountConvolutionOperations(dims, out_rows, out_cols);
+}
+
+int64 OpLevelCostEstimator::CountMatMulOperations(const OpInfo& op_features,
+                                                  bool* found_unknown_shapes) {
+  if (op_features.inputs_size() < 2) {
+    *found_unknown_shapes = true;
+    return 0;
+  }
+  const std::vector<int64> a =
+      GetDims(op_features.inputs(0), 2, found_unknown_shapes);
+  const std::vector<int64> b =
+      GetDims(op_features.inputs(1), 2, found_unknown_shapes);
+  const bool transpose_a = GetBoolAttr(op_features, "transpose_a");
+  const bool transpose_b = GetBoolAttr(op_features, "transpose_b");
+  const int64 m = transpose_a ? a[1] : a[0];
+  const int64 k = transpose_a ? a[0] : a[1];
+  const int64 n = transpose_b ? b[0] : b[1];
+  return m * k * n * kOpsPerMac;
+}
+
+int64 OpLevelCostEstimator::CountBatchMatMulOperations(
+    const OpInfo& op_features, bool* found_unknown_shapes) {
+  if (op_features.inputs_size() < 2) {
+    *found_unknown_shapes = true;
+    return 0;
+  }
+  const OpInfo::TensorProperties& x = op_features.inputs(0);
+  const OpInfo::TensorProperties& y = op_features.inputs(1);
+  const int rank = x.shape().dim_size();
+  if (x.shape().unknown_rank() || rank < 2) {
+    *found_unknown_shapes = true;
+    return 0;
+  }
+  const std::vector<int64> x_dims = GetDims(x, rank, found_unknown_shapes);
+  const std::vector<int64> y_dims = GetDims(y, rank, found_unknown_shapes);
+  int64 batch = 1;
+  for (int i = 0; i < rank - 2; ++i) {
+    batch *= x_dims[i];
+  }
+  const bool adj_x = GetBoolAttr(op_features, "adj_x");
+  const bool adj_y = GetBoolAttr(op_features, "adj_y");
+  const int64 m = adj_x ? x_dims[rank - 1] : x_dims[rank - 2];
+  const int64 k = adj_x ? x_dims[rank - 2] : x_dims[rank - 1];
+  const int64 n = adj_y ? y_dims[rank - 2] : y_dims[rank - 1];
+  return batch * m * k * n * kOpsPerMac;
+}
+
+int64 OpLevelCostEstimator::CalculateTensorElementCount(
+    const OpInfo::TensorProperties& tensor, bool* found_unknown_shapes) {
+  const TensorShapeProto& shape = tensor.shape();
+  if (shape.unknown_rank()) {
+    *found_unknown_shapes = true;
+    return 1;
+  }
+  int64 num_elements = 1;
+  for (const auto& dim : shape.dim()) {
+    if (dim.size() < 0) {
+      *found_unknown_shapes = true;
+    } else {
+      num_elements *= dim.size();
+    }
+  }
+  return num_elements;
+}
+
+int64 OpLevelCostEstimator::CalculateTensorSize(
+    const OpInfo::TensorProperties& tensor, bool* found_unknown_shapes) {
+  const int64 element_size = DataTypeSize(BaseType(tensor.dtype()));
+  if (element_size == 0) {
+    *found_unknown_shapes = true;
+  }
+  return CalculateTensorElementCount(tensor, found_unknown_shapes) *
+         element_size;
+}
+
+int64 OpLevelCostEstimator::CalculateInputSize(const OpInfo& op_features,
+                                               bool* found_unknown_shapes) {
+  int64 total_size = 0;
+  for (const auto& input : op_features.inputs()) {
+    total_size += CalculateTensorSize(input, found_unknown_shapes);
+  }
+  return total_size;
+}
+
+int64 OpLevelCostEstimator::CalculateOutputSize(const OpInfo& op_features,
+                                                bool* found_unknown_shapes) {
+  int64 total_size = 0;
+  if (op_features.outputs_size() > 0) {
+    for (const auto& output : op_features.outputs()) {
+      total_size += CalculateTensorSize(output, found_unknown_shapes);
+    }
+    return total_size;
+  }
+  for (const auto& input : op_features.inputs()) {
+    total_size =
+        std::max(total_size, CalculateTensorSize(input, found_unknown_shapes));
+  }
+  return total_size;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
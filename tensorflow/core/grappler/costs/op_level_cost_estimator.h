@@ -0,0 +1,106 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
+#define TENSORFLOW_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
+
+#include <map>
+#include <string>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Estimates the cost of running a single op from its description, without
+// running it. The number of operations and the number of bytes read and
+// written by the op are derived from the shapes of its inputs and outputs,
+// and converted to a time with a roofline model of its device: the op takes
+// as long as the slowest of its computations and its memory accesses.
+class OpLevelCostEstimator {
+ public:
+  OpLevelCostEstimator();
+  virtual ~OpLevelCostEstimator() {}
+
+  // Returns the predicted cost of the op described by op_features. The
+  // execution time is flagged as inaccurate when the op isn't modeled, or
+  // when some of the shapes it depends on are unknown.
+  Costs PredictCosts(const OpInfo& op_features) const;
+
+  // Peak performance of a device.
+  struct DeviceInfo {
+    double gigaops;     // Billions of operations per second.
+    double gb_per_sec;  // Memory bandwidth, in GB/s.
+  };
+
+  // Returns the peak performance of the device, falling back to typical
+  // values for the properties that aren't known.
+  virtual DeviceInfo GetDeviceInfo(
+      const OpInfo::DeviceProperties& device) const;
+
+ protected:
+  typedef Costs (OpLevelCostEstimator::*CostImpl)(
+      const OpInfo& op_features) const;
+
+  Costs PredictConv2D(const OpInfo& op_features) const;
+  Costs PredictConv2DBackpropInput(const OpInfo& op_features) const;
+  Costs PredictConv2DBackpropFilter(const OpInfo& op_features) const;
+  Costs PredictMatMul(const OpInfo& op_features) const;
+  Costs PredictBatchMatMul(const OpInfo& op_features) const;
+  Costs PredictCwiseOp(const OpInfo& op_features) const;
+  Costs PredictNoOp(const OpInfo& op_features) const;
+  Costs PredictUnknownOp(const OpInfo& op_features) const;
+
+  // Returns the cost of an op that runs `operations` operations and accesses
+  // all of its inputs and outputs once.
+  Costs PredictOpCountBasedCost(double operations,
+                                const OpInfo& op_features) const;
+
+  // The number of operations of the ops, which are products of the dimensions
+  // of their inputs. The unknown dimensions count as 1, and set
+  // *found_unknown_shapes.
+  static int64 CountConv2DOperations(const OpInfo& op_features,
+                                     bool* found_unknown_shapes);
+  static int64 CountConv2DBackpropOperations(const OpInfo& op_features,
+                                             bool* found_unknown_shapes);
+  static int64 CountMatMulOperations(const OpInfo& op_features,
+                                     bool* found_unknown_shapes);
+  static int64 CountBatchMatMulOperations(const OpInfo& op_features,
+                                          bool* found_unknown_shapes);
+
+  // The number of elements and bytes of tensors.
+  static int64 CalculateTensorElementCount(
+      const OpInfo::TensorProperties& tensor, bool* found_unknown_shapes);
+  static int64 CalculateTensorSize(const OpInfo::TensorProperties& tensor,
+                                   bool* found_unknown_shapes);
+  static int64 CalculateInputSize(const OpInfo& op_features,
+                                  bool* found_unknown_shapes);
+  // Ops whose outputs aren't described are assumed to write as many bytes as
+  // their largest input.
+  static int64 CalculateOutputSize(const OpInfo& op_features,
+                                   bool* found_unknown_shapes);
+
+ private:
+  std::map<string, CostImpl> device_cost_impl_;
+  // The number of operations that the element-wise ops run per element of
+  // their output.
+  std::map<string, int> elementwise_ops_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_COSTS_OP_LEVEL_COST_ESTIMATOR_H_
@@ -0,0 +1,198 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Describes a float tensor of the given shape. Negative dimensions are
+// unknown.
+void DescribeTensor(const std::vector<int64>& dims,
+                    OpInfo::TensorProperties* tensor) {
+  tensor->set_dtype(DT_FLOAT);
+  for (int64 dim : dims) {
+    tensor->mutable_shape()->add_dim()->set_size(dim);
+  }
+}
+
+OpInfo DescribeMatMul(int64 m, int64 k, int64 n) {
+  OpInfo op_features;
+  op_features.set_op("MatMul");
+  op_features.mutable_device()->set_type("CPU");
+  DescribeTensor({m, k}, op_features.add_inputs());
+  DescribeTensor({k, n}, op_features.add_inputs());
+  DescribeTensor({m, n}, op_features.add_outputs());
+  return op_features;
+}
+
+class OpLevelCostEstimatorTest : public ::testing::Test {
+ protected:
+  OpLevelCostEstimator estimator_;
+};
+
+TEST_F(OpLevelCostEstimatorTest, DefaultDeviceInfo) {
+  OpInfo::DeviceProperties cpu;
+  cpu.set_type("CPU");
+  OpLevelCostEstimator::DeviceInfo info = estimator_.GetDeviceInfo(cpu);
+  EXPECT_EQ(100, info.gigaops);
+  EXPECT_EQ(32, info.gb_per_sec);
+
+  OpInfo::DeviceProperties gpu;
+  gpu.set_type("GPU");
+  info = estimator_.GetDeviceInfo(gpu);
+  EXPECT_EQ(4000, info.gigaops);
+  EXPECT_EQ(200, info.gb_per_sec);
+}
+
+TEST_F(OpLevelCostEstimatorTest, DeviceInfoFromProperties) {
+  OpInfo::DeviceProperties cpu;
+  cpu.set_type("CPU");
+  cpu.set_num_cores(4);
+  cpu.set_frequency(2000);
+  cpu.set_bandwidth(16000000);
+  (*cpu.mutable_environment())["cpu_instruction_set"] = "AVX";
+  OpLevelCostEstimator::DeviceInfo info = estimator_.GetDeviceInfo(cpu);
+  // 4 cores at 2GHz, each running 8 multiply-accumulates per cycle.
+  EXPECT_DOUBLE_EQ(128, info.gigaops);
+  EXPECT_DOUBLE_EQ(16, info.gb_per_sec);
+
+  OpInfo::DeviceProperties gpu;
+  gpu.set_type("GPU");
+  gpu.set_num_cores(10);
+  gpu.set_frequency(1000);
+  info = estimator_.GetDeviceInfo(gpu);
+  EXPECT_DOUBLE_EQ(10 * 128 * 2, info.gigaops);
+  EXPECT_EQ(200, info.gb_per_sec);
+}
+
+TEST_F(OpLevelCostEstimatorTest, ComputeBoundMatMul) {
+  Costs costs = estimator_.PredictCosts(DescribeMatMul(1000, 1000, 1000));
+  // 2e9 operations at 100 Gops, and 12MB at 32 GB/s.
+  EXPECT_EQ(Costs::Duration(20000000), costs.compute_time);
+  EXPECT_EQ(Costs::Duration(375000), costs.memory_time);
+  EXPECT_EQ(costs.compute_time, costs.execution_time);
+  EXPECT_EQ(4000000, costs.max_memory);
+  EXPECT_EQ(12000000, costs.max_per_op_buffers);
+  EXPECT_FALSE(costs.inaccurate);
+}
+
+TEST_F(OpLevelCostEstimatorTest, TransposedMatMul) {
+  OpInfo op_features = DescribeMatMul(100, 10, 1000);
+  // The same product, with a transposed 10x100 first input.
+  op_features.mutable_inputs(0)->mutable_shape()->mutable_dim(0)->set_size(10);
+  op_features.mutable_inputs(0)->mutable_shape()->mutable_dim(1)->set_size(
+      100);
+  (*op_features.mutable_attr())["transpose_a"].set_b(true);
+  EXPECT_EQ(estimator_.PredictCosts(DescribeMatMul(100, 10, 1000)).compute_time,
+            estimator_.PredictCosts(op_features).compute_time);
+}
+
+TEST_F(OpLevelCostEstimatorTest, MatMulWithUnknownShapes) {
+  Costs costs = estimator_.PredictCosts(DescribeMatMul(-1, 1000, 1000));
+  EXPECT_TRUE(costs.inaccurate);
+  // The unknown dimension counts as 1.
+  EXPECT_EQ(Costs::Duration(20000), costs.compute_time);
+}
+
+TEST_F(OpLevelCostEstimatorTest, Conv2D) {
+  OpInfo op_features;
+  op_features.set_op("Conv2D");
+  op_features.mutable_device()->set_type("CPU");
+  DescribeTensor({16, 32, 32, 8}, op_features.add_inputs());
+  DescribeTensor({3, 3, 8, 64}, op_features.add_inputs());
+  DescribeTensor({16, 16, 16, 64}, op_features.add_outputs());
+  (*op_features.mutable_attr())["padding"].set_s("SAME");
+  auto* strides = (*op_features.mutable_attr())["strides"].mutable_list();
+  for (int stride : {1, 2, 2, 1}) {
+    strides->add_i(stride);
+  }
+
+  Costs costs = estimator_.PredictCosts(op_features);
+  // 16x16x16 output positions, each running 3x3x8x64 multiply-accumulates.
+  const int64 operations = 16 * 16 * 16 * 3 * 3 * 8 * 64 * 2;
+  EXPECT_EQ(Costs::Duration(operations / 100), costs.compute_time);
+  EXPECT_EQ(costs.compute_time, costs.execution_time);
+  EXPECT_FALSE(costs.inaccurate);
+}
+
+TEST_F(OpLevelCostEstimatorTest, Conv2DBackpropFilter) {
+  OpInfo op_features;
+  op_features.set_op("Conv2DBackpropFilter");
+  op_features.mutable_device()->set_type("CPU");
+  DescribeTensor({16, 32, 32, 8}, op_features.add_inputs());
+  OpInfo::TensorProperties* filter_sizes = op_features.add_inputs();
+  filter_sizes->set_dtype(DT_INT32);
+  filter_sizes->mutable_shape()->add_dim()->set_size(4);
+  Tensor filter_sizes_value(DT_INT32, TensorShape({4}));
+  filter_sizes_value.flat<int32>().setValues({3, 3, 8, 64});
+  filter_sizes_value.AsProtoTensorContent(filter_sizes->mutable_value());
+  DescribeTensor({16, 32, 32, 64}, op_features.add_inputs());
+  DescribeTensor({3, 3, 8, 64}, op_features.add_outputs());
+
+  Costs costs = estimator_.PredictCosts(op_features);
+  const int64 operations = 16 * 32 * 32 * 3 * 3 * 8 * 64 * 2;
+  EXPECT_EQ(Costs::Duration(operations / 100), costs.compute_time);
+  EXPECT_FALSE(costs.inaccurate);
+}
+
+TEST_F(OpLevelCostEstimatorTest, MemoryBoundCwiseOp) {
+  OpInfo op_features;
+  op_features.set_op("Add");
+  op_features.mutable_device()->set_type("CPU");
+  DescribeTensor({1000, 1000}, op_features.add_inputs());
+  DescribeTensor({1000, 1000}, op_features.add_inputs());
+  DescribeTensor({1000, 1000}, op_features.add_outputs());
+
+  Costs costs = estimator_.PredictCosts(op_features);
+  EXPECT_EQ(Costs::Duration(10000), costs.compute_time);
+  EXPECT_EQ(Costs::Duration(375000), costs.memory_time);
+  EXPECT_EQ(costs.memory_time, costs.execution_time);
+  EXPECT_FALSE(costs.inaccurate);
+}
+
+TEST_F(OpLevelCostEstimatorTest, NoOp) {
+  OpInfo op_features;
+  op_features.set_op("Identity");
+  DescribeTensor({1000, 1000}, op_features.add_inputs());
+  DescribeTensor({1000, 1000}, op_features.add_outputs());
+
+  Costs costs = estimator_.PredictCosts(op_features);
+  EXPECT_EQ(Costs::Duration::zero(), costs.execution_time);
+  EXPECT_FALSE(costs.inaccurate);
+}
+
+TEST_F(OpLevelCostEstimatorTest, UnknownOp) {
+  OpInfo op_features;
+  op_features.set_op("SomeOp");
+  op_features.mutable_device()->set_type("CPU");
+  DescribeTensor({1000, 1000}, op_features.add_inputs());
+  DescribeTensor({1000, 1000}, op_features.add_outputs());
+
+  Costs costs = estimator_.PredictCosts(op_features);
+  // The op is assumed to be bound by its memory accesses.
+  EXPECT_EQ(Costs::Duration(250000), costs.execution_time);
+  EXPECT_TRUE(costs.inaccurate);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
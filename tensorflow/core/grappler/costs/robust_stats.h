@@ -27,6 +27,9 @@ class RobustStats {
   double lo() const { return lo_; }
   double hi() const { return hi_; }
   double mean() const { return mean_; }
+  // The scaled median absolute deviation, a robust estimate of the standard
+  // deviation.
+  double stddev() const { return stddev_; }
 
  private:
   void HuberMAD(const std::vector<double>& values);
@@ -49,9 +49,15 @@ Costs CombineCosts(const Costs& left, const Costs& right) {
 
 VirtualScheduler::VirtualScheduler(const GraphDef& graph,
                                    const std::vector<string>& fetch_nodes)
+    : VirtualScheduler(graph, fetch_nodes, nullptr) {}
+
+VirtualScheduler::VirtualScheduler(const GraphDef& graph,
+                                   const std::vector<string>& fetch_nodes,
+                                   TransferCostFn transfer_cost)
     : graph_costs_(Costs::ZeroCosts()),
       // TODO(dyoon): Use a better way than FIFO.
-      ready_nodes_(new FIFOManager()) {
+      ready_nodes_(new FIFOManager()),
+      transfer_cost_(std::move(transfer_cost)) {
   // First, get the nodes that would run to output fetch_nodes.
   std::vector<const NodeDef*> nodes =
       ComputeTransitiveFanin(graph, fetch_nodes);
@@ -66,7 +72,6 @@ VirtualScheduler::VirtualScheduler(const GraphDef& graph,
   // Build node_map.
   for (const auto* node : nodes) {
     auto& node_state = GetNodeStateOrCreateIt(node);
-    // TODO(dyoon): add SendRecv considering devices and control dependency.
     for (const string& input : node->input()) {
       const NodeDef* in = name_to_node[NodeName(input)];
       CHECK(in);
@@ -94,6 +99,22 @@ NodeState& VirtualScheduler::GetNodeStateOrCreateIt(const NodeDef* node) {
   return it->second;
 }
 
+Costs::Duration VirtualScheduler::GetTimeInputsReady(const NodeDef* node) {
+  const auto& node_state = node_map_[node];
+  Costs::Duration time_ready;
+  // The inputs are recorded in the order of node->input().
+  for (int i = 0; i < node_state.inputs.size(); ++i) {
+    const NodeDef* input = node_state.inputs[i];
+    Costs::Duration time_input_ready = node_map_[input].time_finished;
+    if (transfer_cost_ && input->device() != node->device()) {
+      time_input_ready +=
+          transfer_cost_(*input, NodePosition(node->input(i)), *node);
+    }
+    time_ready = std::max(time_ready, time_input_ready);
+  }
+  return time_ready;
+}
+
 bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
   // Update graph_costs_ and per-op costs.
   graph_costs_ = CombineCosts(graph_costs_, node_costs);
@@ -121,6 +142,12 @@ bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
   device.device_costs = CombineCosts(device.device_costs, node_costs);
   auto curr_time = device.GetCurrTime();
   node_state.time_finished = curr_time;
+  if (node_costs.max_memory != kMemoryUnknown) {
+    node_state.output_memory = node_costs.max_memory;
+    device.memory_usage += node_state.output_memory;
+    device.max_memory_usage =
+        std::max(device.max_memory_usage, device.memory_usage);
+  }
 
   // Update device's per-op cost.
   {
@@ -142,8 +169,9 @@ bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
       auto& output_state = node_map_[output];
       output_state.num_inputs_ready++;
       if (output_state.num_inputs_ready == output_state.inputs.size()) {
-        // This output node is now ready.
-        output_state.time_ready = curr_time;
+        // This output node is now ready, once the inputs produced on other
+        // devices have been transferred to its own.
+        output_state.time_ready = GetTimeInputsReady(output);
         ready_nodes_->AddNode(output);
       }
     }
@@ -155,8 +183,7 @@ bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
       if (input_state.num_outputs_executed == input_state.outputs.size()) {
         // All the outputs are executed; no reference to this input nodel
         input_state.time_no_reference = curr_time;
-        // TODO(dyoon): collect device memory usage; note that this input node
-        // use device memory between time_scheduled and time_no_reference.
+        device_[input->device()].memory_usage -= input_state.output_memory;
       }
     }
   }
@@ -186,13 +213,15 @@ Costs VirtualScheduler::Summary() const {
   // Print per device summary
   VLOG(1) << "Devices:";
   Costs critical_path_costs = Costs::ZeroCosts();
+  int64 max_memory_usage = 0;
 
   for (const auto& device : device_) {
     const auto& name = device.first;
     const auto& state = device.second;
     VLOG(1) << "Device = " << name
             << ", num_nodes = " << state.nodes_executed.size()
-            << ", execution_time = " << state.GetCurrTime().count();
+            << ", execution_time = " << state.GetCurrTime().count()
+            << ", max_memory_usage = " << state.max_memory_usage;
     VLOG(1) << "Per-op execution time:";
     for (const auto& op_cost_pair : state.op_to_cost) {
       const auto& op = op_cost_pair.first;
@@ -204,7 +233,9 @@ Costs VirtualScheduler::Summary() const {
     if (critical_path_costs.execution_time <= state.GetCurrTime()) {
       critical_path_costs = state.device_costs;
     }
+    max_memory_usage = std::max(max_memory_usage, state.max_memory_usage);
   }
+  critical_path_costs.max_memory = max_memory_usage;
 
   VLOG(1) << "Critical path execution time: "
           << critical_path_costs.execution_time.count();
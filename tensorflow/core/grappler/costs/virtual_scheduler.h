@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_COSTS_VIRTUAL_SCHEDULER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_COSTS_VIRTUAL_SCHEDULER_H_
 
+#include <functional>
 #include <list>
 #include <memory>
 #include <unordered_map>
@@ -32,6 +33,8 @@ struct NodeState {
   std::vector<const NodeDef*> outputs;
   int num_inputs_ready;
   int num_outputs_executed;
+  // Size of the outputs of the node, in bytes.
+  int64 output_memory;
   Costs::Duration time_ready;
   Costs::Duration time_scheduled;
   Costs::Duration time_finished;
@@ -45,6 +48,7 @@ struct NodeState {
   NodeState() {
     num_inputs_ready = 0;
     num_outputs_executed = 0;
+    output_memory = 0;
     time_ready = Costs::Duration::max();
     time_scheduled = Costs::Duration::max();
     time_finished = Costs::Duration::max();
@@ -56,8 +60,15 @@ struct DeviceState {
   std::vector<const NodeDef*> nodes_executed;
   Costs device_costs;
   std::map<string, Costs> op_to_cost;  // Per-op cost.
-
-  DeviceState() { device_costs = Costs::ZeroCosts(); }
+  // Bytes of the outputs that are still referenced, and their peak.
+  int64 memory_usage;
+  int64 max_memory_usage;
+
+  DeviceState() {
+    device_costs = Costs::ZeroCosts();
+    memory_usage = 0;
+    max_memory_usage = 0;
+  }
 
   Costs::Duration GetCurrTime() const { return device_costs.execution_time; }
 };
@@ -92,22 +103,42 @@ class FIFOManager : public ReadyNodeManager {
 // dependencies, device, etc.
 class VirtualScheduler {
  public:
+  // Returns the time it takes to send output `port` of `from` (or -1 for a
+  // control dependency) to `to`, which runs on another device.
+  typedef std::function<Costs::Duration(const NodeDef& from, int port,
+                                        const NodeDef& to)>
+      TransferCostFn;
+
   VirtualScheduler(const GraphDef& graph,
                    const std::vector<string>& fetch_nodes);
+  // Same as above, but the inputs that come from another device only reach
+  // their consumers after the Send/Recv time estimated by transfer_cost.
+  VirtualScheduler(const GraphDef& graph,
+                   const std::vector<string>& fetch_nodes,
+                   TransferCostFn transfer_cost);
 
   const NodeDef* GetCurrNode() const;
+  // The max_memory of node_costs, if known, is the size of the outputs of the
+  // node, which stay in the memory of its device until all their consumers
+  // have run.
   bool MarkCurrNodeExecuted(const Costs& node_costs);
 
+  // Returns the costs of the device that finishes last. Their max_memory is
+  // the highest peak memory usage of the devices.
   Costs Summary() const;
 
  private:
   NodeState& GetNodeStateOrCreateIt(const NodeDef* node);
+  // Returns the time at which all the inputs of node are available on its
+  // device.
+  Costs::Duration GetTimeInputsReady(const NodeDef* node);
 
   Costs graph_costs_;                   // Graph cost.
   std::map<string, Costs> op_to_cost_;  // Per-op cost.
   std::unique_ptr<ReadyNodeManager> ready_nodes_;
   std::unordered_map<const NodeDef*, NodeState> node_map_;
   std::unordered_map<string, DeviceState> device_;
+  TransferCostFn transfer_cost_;
 };
 
 }  // namespace grappler
@@ -0,0 +1,694 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+bool IsControlInput(const string& input) {
+  return !input.empty() && input[0] == '^';
+}
+
+// Returns the input with an explicit position, so that "x" and "x:0" compare
+// equal.
+string CanonicalInput(const string& input) {
+  int position;
+  const string name = ParseNodeName(input, &position);
+  if (position < 0) {
+    return strings::StrCat("^", name);
+  }
+  return strings::StrCat(name, ":", position);
+}
+
+bool IsCommutative(const NodeDef& node) {
+  static const std::unordered_set<string>* commutative_ops =
+      new std::unordered_set<string>({"Add", "AddN", "Equal", "LogicalAnd",
+                                      "LogicalOr", "Maximum", "Minimum", "Mul",
+                                      "NotEqual"});
+  return commutative_ops->count(node.op()) > 0;
+}
+
+// The inputs of the node in a canonical order: the regular inputs in order,
+// sorted if the op is commutative, then the sorted control inputs.
+std::vector<string> CanonicalInputs(const NodeDef& node) {
+  std::vector<string> regular_inputs;
+  std::vector<string> control_inputs;
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(CanonicalInput(input));
+    } else {
+      regular_inputs.push_back(CanonicalInput(input));
+    }
+  }
+  if (IsCommutative(node)) {
+    std::sort(regular_inputs.begin(), regular_inputs.end());
+  }
+  std::sort(control_inputs.begin(), control_inputs.end());
+  control_inputs.erase(
+      std::unique(control_inputs.begin(), control_inputs.end()),
+      control_inputs.end());
+  regular_inputs.insert(regular_inputs.end(), control_inputs.begin(),
+                        control_inputs.end());
+  return regular_inputs;
+}
+
+uint64 ComputationHash(const NodeDef& node) {
+  uint64 hash = Hash64(node.op());
+  hash = Hash64Combine(hash, Hash64(node.device()));
+  for (const string& input : CanonicalInputs(node)) {
+    hash = Hash64Combine(hash, Hash64(input));
+  }
+  return hash;
+}
+
+bool SameComputation(const NodeDef& a, const NodeDef& b) {
+  if (a.op() != b.op() || a.device() != b.device() ||
+      a.attr_size() != b.attr_size() ||
+      CanonicalInputs(a) != CanonicalInputs(b)) {
+    return false;
+  }
+  for (const auto& attr : a.attr()) {
+    auto it = b.attr().find(attr.first);
+    if (it == b.attr().end() || !AreAttrValuesEqual(attr.second, it->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsStateful(const NodeDef& node) {
+  const OpDef* op_def = nullptr;
+  Status status = OpRegistry::Global()->LookUpOpDef(node.op(), &op_def);
+  return !status.ok() || op_def->is_stateful();
+}
+
+// Orders the nodes so that each node comes after its inputs, except along the
+// back edges of loops, whose nodes come last in the order of the graph.
+std::vector<NodeDef*> TopologicalOrder(GraphDef* graph) {
+  std::unordered_map<string, int> index;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    index[graph->node(i).name()] = i;
+  }
+  std::vector<int> num_pending(graph->node_size(), 0);
+  std::vector<std::vector<int>> fanouts(graph->node_size());
+  for (int i = 0; i < graph->node_size(); ++i) {
+    for (const string& input : graph->node(i).input()) {
+      auto it = index.find(NodeName(input));
+      if (it != index.end()) {
+        fanouts[it->second].push_back(i);
+        ++num_pending[i];
+      }
+    }
+  }
+  std::vector<NodeDef*> order;
+  std::vector<bool> ordered(graph->node_size(), false);
+  std::deque<int> ready;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    if (num_pending[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  while (!ready.empty()) {
+    const int i = ready.front();
+    ready.pop_front();
+    order.push_back(graph->mutable_node(i));
+    ordered[i] = true;
+    for (int fanout : fanouts[i]) {
+      if (--num_pending[fanout] == 0) {
+        ready.push_back(fanout);
+      }
+    }
+  }
+  for (int i = 0; i < graph->node_size(); ++i) {
+    if (!ordered[i]) {
+      order.push_back(graph->mutable_node(i));
+    }
+  }
+  return order;
+}
+
+bool HasControlInputs(const NodeDef& node) {
+  return node.input_size() > 0 &&
+         IsControlInput(node.input(node.input_size() - 1));
+}
+
+bool GetConstTensor(const NodeDef* node, Tensor* tensor) {
+  if (node == nullptr || node->op() != "Const") {
+    return false;
+  }
+  auto it = node->attr().find("value");
+  return it != node->attr().end() && tensor->FromProto(it->second.tensor());
+}
+
+// Reads the permutation held by the Const `node`.
+bool GetPermutation(const NodeDef* node, std::vector<int64>* permutation) {
+  Tensor tensor;
+  if (!GetConstTensor(node, &tensor) || tensor.dims() != 1) {
+    return false;
+  }
+  for (int64 i = 0; i < tensor.NumElements(); ++i) {
+    if (tensor.dtype() == DT_INT32) {
+      permutation->push_back(tensor.vec<int32>()(i));
+    } else if (tensor.dtype() == DT_INT64) {
+      permutation->push_back(tensor.vec<int64>()(i));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether every value of type `from` is exactly representable in type `to`,
+// so that casting to `to` and back to `from` is the identity.
+bool IsLosslessCast(DataType from, DataType to) {
+  switch (from) {
+    case DT_HALF:
+      return to == DT_FLOAT || to == DT_DOUBLE;
+    case DT_FLOAT:
+      return to == DT_DOUBLE;
+    case DT_INT8:
+      return to == DT_INT16 || to == DT_INT32 || to == DT_INT64;
+    case DT_UINT8:
+      return to == DT_INT16 || to == DT_UINT16 || to == DT_INT32 ||
+             to == DT_INT64;
+    case DT_INT16:
+    case DT_UINT16:
+      return to == DT_INT32 || to == DT_INT64;
+    case DT_INT32:
+      return to == DT_INT64 || to == DT_DOUBLE;
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+void MultiplyScalars(const Tensor& a, const Tensor& b, Tensor* product) {
+  product->scalar<T>()() = a.scalar<T>()() * b.scalar<T>()();
+}
+
+// Computes the product of the scalars a and b, of the same type.
+bool MultiplyScalars(const Tensor& a, const Tensor& b, Tensor* product) {
+  *product = Tensor(a.dtype(), TensorShape({}));
+  switch (a.dtype()) {
+    case DT_FLOAT:
+      MultiplyScalars<float>(a, b, product);
+      return true;
+    case DT_DOUBLE:
+      MultiplyScalars<double>(a, b, product);
+      return true;
+    case DT_INT32:
+      MultiplyScalars<int32>(a, b, product);
+      return true;
+    case DT_INT64:
+      MultiplyScalars<int64>(a, b, product);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Reads the fully defined shape recorded in the _output_shapes attribute of
+// the node for the given output.
+bool GetRecordedShape(const NodeDef* node, int position,
+                      TensorShapeProto* shape) {
+  if (node == nullptr || position < 0) {
+    return false;
+  }
+  auto it = node->attr().find("_output_shapes");
+  if (it == node->attr().end() || it->second.list().shape_size() <= position) {
+    return false;
+  }
+  *shape = it->second.list().shape(position);
+  if (shape->unknown_rank()) {
+    return false;
+  }
+  for (const auto& dim : shape->dim()) {
+    if (dim.size() < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ArithmeticOptimizer::CanDedup(const NodeDef& node) const {
+  if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+    return false;
+  }
+  // Fed nodes and the nodes that drive the control flow of loops are not
+  // determined by their inputs.
+  if (IsPlaceholder(node) || node.op() == "PlaceholderWithDefault" ||
+      node.op() == "Enter" || node.op() == "RefEnter" || node.op() == "Exit" ||
+      node.op() == "RefExit" || node.op() == "Merge" ||
+      node.op() == "RefMerge" || node.op() == "NextIteration" ||
+      node.op() == "RefNextIteration" || node.op() == "LoopCond") {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  for (const auto& arg : op_def->input_arg()) {
+    if (arg.is_ref()) {
+      return false;
+    }
+  }
+  for (const auto& arg : op_def->output_arg()) {
+    if (arg.is_ref()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ArithmeticOptimizer::DedupComputations(
+    const std::vector<NodeDef*>& topo_order) {
+  // Since the nodes are visited after their inputs, the consumers of a node
+  // see the input it was merged into when they are visited.
+  std::unordered_map<uint64, std::vector<NodeDef*>> computations;
+  int num_deduped = 0;
+  for (NodeDef* node : topo_order) {
+    if (!CanDedup(*node)) {
+      continue;
+    }
+    std::vector<NodeDef*>& candidates = computations[ComputationHash(*node)];
+    NodeDef* equivalent = nullptr;
+    for (NodeDef* candidate : candidates) {
+      if (SameComputation(*candidate, *node)) {
+        equivalent = candidate;
+        break;
+      }
+    }
+    if (equivalent == nullptr) {
+      candidates.push_back(node);
+      continue;
+    }
+    for (NodeDef* consumer : node_map_->GetOutputs(node->name())) {
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        int position;
+        const string input = ParseNodeName(consumer->input(i), &position);
+        if (input != node->name()) {
+          continue;
+        }
+        if (position < 0) {
+          *consumer->mutable_input(i) =
+              strings::StrCat("^", equivalent->name());
+        } else if (position == 0) {
+          *consumer->mutable_input(i) = equivalent->name();
+        } else {
+          *consumer->mutable_input(i) =
+              strings::StrCat(equivalent->name(), ":", position);
+        }
+      }
+      node_map_->AddOutput(equivalent->name(), consumer->name());
+    }
+    maybe_dead_.insert(node->name());
+    ++num_deduped;
+  }
+  VLOG(1) << "Merged " << num_deduped << " duplicated computations.";
+}
+
+NodeDef* ArithmeticOptimizer::AddNode(const NodeDef& node,
+                                      const string& suffix) {
+  NodeDef* new_node = graph_->add_node();
+  new_node->set_name(AddPrefixToNodeName(
+      strings::StrCat(node.name(), "_", suffix), kArithmeticOptimizer));
+  new_node->set_device(node.device());
+  node_map_->AddNode(new_node->name(), new_node);
+  return new_node;
+}
+
+string ArithmeticOptimizer::SimplifyTransposePair(const NodeDef& node) {
+  // Transpose(Transpose(x, p1), p2) is x when p2 undoes p1.
+  const NodeDef* inner = node_map_->GetNode(node.input(0));
+  if (inner == nullptr || inner->op() != "Transpose" ||
+      NodePosition(node.input(0)) != 0 || HasControlInputs(*inner)) {
+    return "";
+  }
+  std::vector<int64> inner_permutation;
+  std::vector<int64> permutation;
+  if (!GetPermutation(node_map_->GetNode(inner->input(1)),
+                      &inner_permutation) ||
+      !GetPermutation(node_map_->GetNode(node.input(1)), &permutation) ||
+      inner_permutation.size() != permutation.size()) {
+    return "";
+  }
+  const int64 rank = permutation.size();
+  for (int64 i = 0; i < rank; ++i) {
+    if (permutation[i] < 0 || permutation[i] >= rank ||
+        inner_permutation[permutation[i]] != i) {
+      return "";
+    }
+  }
+  return inner->input(0);
+}
+
+string ArithmeticOptimizer::SimplifyReshapePair(NodeDef* node) {
+  // Reshape(Reshape(x, s1), s2) is Reshape(x, s2) since a reshape does not
+  // reorder the elements.
+  const NodeDef* inner = node_map_->GetNode(node->input(0));
+  if (inner == nullptr || inner->op() != "Reshape" ||
+      HasControlInputs(*inner)) {
+    return "";
+  }
+  maybe_dead_.insert(inner->name());
+  *node->mutable_input(0) = inner->input(0);
+  node_map_->AddOutput(NodeName(inner->input(0)), node->name());
+  return "";
+}
+
+string ArithmeticOptimizer::SimplifyCastPair(const NodeDef& node) {
+  // Cast(Cast(x, A -> B), B -> A) is x when B represents all the values of A.
+  const NodeDef* inner = node_map_->GetNode(node.input(0));
+  if (inner == nullptr || inner->op() != "Cast" || HasControlInputs(*inner)) {
+    return "";
+  }
+  auto src = inner->attr().find("SrcT");
+  auto dst = node.attr().find("DstT");
+  if (src == inner->attr().end() || dst == node.attr().end() ||
+      src->second.type() != dst->second.type() ||
+      inner->attr().count("DstT") == 0 ||
+      !IsLosslessCast(src->second.type(), inner->attr().at("DstT").type())) {
+    return "";
+  }
+  return inner->input(0);
+}
+
+string ArithmeticOptimizer::CollapseScalarMulChain(NodeDef* node) {
+  // Mul(Mul(x, c1), c2) is Mul(x, c1 * c2) when c1 and c2 are scalar
+  // constants.
+  for (int outer = 0; outer < 2; ++outer) {
+    Tensor scale;
+    const NodeDef* scale_node = node_map_->GetNode(node->input(outer));
+    if (!GetConstTensor(scale_node, &scale) || scale.dims() != 0) {
+      continue;
+    }
+    const NodeDef* inner = node_map_->GetNode(node->input(1 - outer));
+    if (inner == nullptr || inner->op() != "Mul" ||
+        HasControlInputs(*inner)) {
+      continue;
+    }
+    for (int i = 0; i < 2; ++i) {
+      Tensor inner_scale;
+      if (!GetConstTensor(node_map_->GetNode(inner->input(i)), &inner_scale) ||
+          inner_scale.dims() != 0 || inner_scale.dtype() != scale.dtype()) {
+        continue;
+      }
+      Tensor product;
+      if (!MultiplyScalars(inner_scale, scale, &product)) {
+        continue;
+      }
+      NodeDef* product_node = AddNode(*node, "scale");
+      product_node->set_op("Const");
+      (*product_node->mutable_attr())["dtype"].set_type(product.dtype());
+      product.AsProtoTensorContent(
+          (*product_node->mutable_attr())["value"].mutable_tensor());
+      // A constant in a loop runs in the frame of the control inputs it
+      // inherits from the scale it replaces.
+      for (const string& input : scale_node->input()) {
+        *product_node->add_input() = input;
+        node_map_->AddOutput(NodeName(input), product_node->name());
+      }
+      const string x = inner->input(1 - i);
+      maybe_dead_.insert(inner->name());
+      maybe_dead_.insert(scale_node->name());
+      *node->mutable_input(1 - outer) = x;
+      *node->mutable_input(outer) = product_node->name();
+      node_map_->AddOutput(NodeName(x), node->name());
+      node_map_->AddOutput(product_node->name(), node->name());
+      return "";
+    }
+  }
+  return "";
+}
+
+string ArithmeticOptimizer::HoistCommonFactorOutOfAddN(NodeDef* node) {
+  // AddN(Mul(a1, x), ..., Mul(an, x)) is Mul(AddN(a1, ..., an), x), as long
+  // as the ai have the same shape.
+  if (node->input_size() < 2 || HasControlInputs(*node)) {
+    return "";
+  }
+  std::vector<const NodeDef*> products;
+  for (const string& input : node->input()) {
+    const NodeDef* product = node_map_->GetNode(input);
+    if (product == nullptr || product->op() != "Mul" ||
+        HasControlInputs(*product) ||
+        nodes_to_preserve_.find(product->name()) != nodes_to_preserve_.end() ||
+        node_map_->GetOutputs(product->name()).size() != 1) {
+      return "";
+    }
+    products.push_back(product);
+  }
+  for (int common = 0; common < 2; ++common) {
+    const string factor = CanonicalInput(products[0]->input(common));
+    std::vector<string> other_factors;
+    for (const NodeDef* product : products) {
+      if (CanonicalInput(product->input(0)) == factor) {
+        other_factors.push_back(product->input(1));
+      } else if (CanonicalInput(product->input(1)) == factor) {
+        other_factors.push_back(product->input(0));
+      } else {
+        break;
+      }
+    }
+    if (other_factors.size() != products.size()) {
+      continue;
+    }
+
+    // The sum of the other factors must not broadcast.  They all have the
+    // shape of the products when the common factor is a scalar constant, and
+    // they trivially have the same shape when they are all scalar constants.
+    // Otherwise their recorded shapes must match.
+    Tensor value;
+    bool same_shapes =
+        GetConstTensor(node_map_->GetNode(factor), &value) && value.dims() == 0;
+    if (!same_shapes) {
+      same_shapes = true;
+      for (const string& other_factor : other_factors) {
+        if (!GetConstTensor(node_map_->GetNode(other_factor), &value) ||
+            value.dims() != 0) {
+          same_shapes = false;
+          break;
+        }
+      }
+    }
+    if (!same_shapes) {
+      TensorShapeProto first_shape;
+      same_shapes = GetRecordedShape(node_map_->GetNode(other_factors[0]),
+                                     NodePosition(other_factors[0]),
+                                     &first_shape);
+      for (const string& other_factor : other_factors) {
+        TensorShapeProto shape;
+        if (!same_shapes ||
+            !GetRecordedShape(node_map_->GetNode(other_factor),
+                              NodePosition(other_factor), &shape) ||
+            shape.SerializeAsString() != first_shape.SerializeAsString()) {
+          same_shapes = false;
+          break;
+        }
+      }
+    }
+    if (!same_shapes) {
+      continue;
+    }
+
+    NodeDef* sum = AddNode(*node, "hoist_add");
+    sum->set_op("AddN");
+    *sum->mutable_attr() = node->attr();
+    sum->mutable_attr()->erase("_output_shapes");
+    for (const string& other_factor : other_factors) {
+      *sum->add_input() = other_factor;
+      node_map_->AddOutput(NodeName(other_factor), sum->name());
+    }
+    for (const NodeDef* product : products) {
+      maybe_dead_.insert(product->name());
+    }
+    // The AddN becomes the product, so that its consumers are unchanged.
+    const string factor_input = products[0]->input(common);
+    node->set_op("Mul");
+    node->mutable_attr()->erase("N");
+    node->clear_input();
+    *node->add_input() = sum->name();
+    *node->add_input() = factor_input;
+    node_map_->AddOutput(sum->name(), node->name());
+    node_map_->AddOutput(NodeName(factor_input), node->name());
+    return "";
+  }
+  return "";
+}
+
+string ArithmeticOptimizer::TrySimplify(NodeDef* node) {
+  if (node->input_size() == 0) {
+    return "";
+  }
+  // The nodes that are replaced must not be preserved, while those rewritten
+  // in place keep their name and value.
+  const bool preserve =
+      nodes_to_preserve_.find(node->name()) != nodes_to_preserve_.end();
+  if (node->op() == "Transpose" && node->input_size() == 2 && !preserve) {
+    return SimplifyTransposePair(*node);
+  }
+  if (node->op() == "Reshape" && node->input_size() >= 2) {
+    return SimplifyReshapePair(node);
+  }
+  if (node->op() == "Cast" && !IsControlInput(node->input(0)) && !preserve) {
+    return SimplifyCastPair(*node);
+  }
+  if (node->op() == "Mul" && node->input_size() == 2) {
+    return CollapseScalarMulChain(node);
+  }
+  if (node->op() == "AddN") {
+    return HoistCommonFactorOutOfAddN(node);
+  }
+  return "";
+}
+
+void ArithmeticOptimizer::SimplifyArithmetic(
+    const std::vector<NodeDef*>& topo_order) {
+  int num_simplified = 0;
+  for (NodeDef* node : topo_order) {
+    // The nodes rewritten away by their consumers were visited before them,
+    // so this only skips the nodes merged into equivalent ones.
+    if (maybe_dead_.find(node->name()) != maybe_dead_.end()) {
+      continue;
+    }
+    const string replacement = TrySimplify(node);
+    if (replacement.empty()) {
+      continue;
+    }
+    // The replacement is a single tensor.  The control dependencies on the
+    // node become control dependencies on the node of the tensor.
+    for (NodeDef* consumer : node_map_->GetOutputs(node->name())) {
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        int position;
+        const string input = ParseNodeName(consumer->input(i), &position);
+        if (input != node->name()) {
+          continue;
+        }
+        if (position < 0) {
+          *consumer->mutable_input(i) =
+              strings::StrCat("^", NodeName(replacement));
+        } else {
+          *consumer->mutable_input(i) = replacement;
+        }
+      }
+      node_map_->AddOutput(NodeName(replacement), consumer->name());
+    }
+    maybe_dead_.insert(node->name());
+    ++num_simplified;
+  }
+  VLOG(1) << "Simplified " << num_simplified << " nodes.";
+}
+
+void ArithmeticOptimizer::RemoveDeadNodes(GraphDef* optimized_graph) {
+  std::unordered_map<string, int> num_consumers;
+  for (const auto& node : optimized_graph->node()) {
+    for (const string& input : node.input()) {
+      ++num_consumers[NodeName(input)];
+    }
+  }
+  std::unordered_set<string> dead;
+  std::vector<string> worklist(maybe_dead_.begin(), maybe_dead_.end());
+  while (!worklist.empty()) {
+    const string name = worklist.back();
+    worklist.pop_back();
+    if (dead.count(name) > 0 || num_consumers[name] > 0 ||
+        nodes_to_preserve_.find(name) != nodes_to_preserve_.end()) {
+      continue;
+    }
+    const NodeDef* node = node_map_->GetNode(name);
+    if (node == nullptr || IsStateful(*node)) {
+      continue;
+    }
+    dead.insert(name);
+    // The inputs of the node may only have been consumed by it.
+    for (const string& input : node->input()) {
+      const string input_name = NodeName(input);
+      if (--num_consumers[input_name] == 0) {
+        worklist.push_back(input_name);
+      }
+    }
+  }
+
+  GraphDef graph;
+  for (const auto& node : optimized_graph->node()) {
+    if (dead.find(node.name()) == dead.end()) {
+      *graph.add_node() = node;
+    }
+  }
+  *graph.mutable_versions() = optimized_graph->versions();
+  *graph.mutable_library() = optimized_graph->library();
+  optimized_graph->Swap(&graph);
+  VLOG(1) << "Removed " << dead.size() << " dead nodes.";
+}
+
+Status ArithmeticOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  graph_ = optimized_graph;
+  node_map_.reset(new NodeMap(graph_));
+  nodes_to_preserve_.clear();
+  maybe_dead_.clear();
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+
+  // The simplifications add nodes after the ordered ones, which they only
+  // consume through the nodes they rewrite.
+  const std::vector<NodeDef*> topo_order = TopologicalOrder(graph_);
+  DedupComputations(topo_order);
+  SimplifyArithmetic(topo_order);
+  RemoveDeadNodes(optimized_graph);
+  node_map_.reset();
+  graph_ = nullptr;
+
+  VLOG(1) << "Optimized graph from " << item.graph.node_size() << " to "
+          << optimized_graph->node_size() << " nodes.";
+  return Status::OK();
+}
+
+void ArithmeticOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                   const GraphDef& optimized_graph,
+                                   double result) {
+  // Nothing to do for ArithmeticOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+const char kArithmeticOptimizer[] = "ArithmeticOptimizer";
+
+// Simplify the arithmetic of a graph:
+// * Merge the nodes that compute the same value from the same inputs.
+// * Remove the pairs of Transpose, Reshape and Cast that undo each other.
+// * Hoist the common factor out of the products summed by an AddN.
+// * Collapse the chains of multiplications by scalar constants.
+class ArithmeticOptimizer : public GraphOptimizer {
+ public:
+  ArithmeticOptimizer() {}
+  ~ArithmeticOptimizer() override {}
+
+  string name() const override { return "arithmetic_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  bool CanDedup(const NodeDef& node) const;
+
+  void DedupComputations(const std::vector<NodeDef*>& topo_order);
+
+  // Returns the tensor that replaces the output of `node`, or an empty string
+  // if none does.  The simplification may also rewrite `node` in place.
+  string TrySimplify(NodeDef* node);
+
+  string SimplifyTransposePair(const NodeDef& node);
+  string SimplifyReshapePair(NodeDef* node);
+  string SimplifyCastPair(const NodeDef& node);
+  string CollapseScalarMulChain(NodeDef* node);
+  string HoistCommonFactorOutOfAddN(NodeDef* node);
+
+  void SimplifyArithmetic(const std::vector<NodeDef*>& topo_order);
+
+  // Removes the nodes that the rewrites left without consumers.
+  void RemoveDeadNodes(GraphDef* optimized_graph);
+
+  // Adds a node named after `node` and `suffix` to the graph.
+  NodeDef* AddNode(const NodeDef& node, const string& suffix);
+
+  GraphDef* graph_ = nullptr;
+  std::unique_ptr<NodeMap> node_map_;
+  std::unordered_set<string> nodes_to_preserve_;
+  // The nodes that may have been left without consumers.
+  std::unordered_set<string> maybe_dead_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
@@ -0,0 +1,330 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ArithmeticOptimizerTest : public ::testing::Test {};
+
+TEST_F(ArithmeticOptimizerTest, NoOp) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output y = ops::Sqrt(s.WithOpName("y"), x);
+  Output out = ops::Identity(s.WithOpName("out"), y);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    EXPECT_EQ(item.graph.node(i).name(), output.node(i).name());
+    EXPECT_EQ(item.graph.node(i).input_size(), output.node(i).input_size());
+  }
+}
+
+TEST_F(ArithmeticOptimizerTest, DedupCommutativeComputations) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT);
+  Output a1 = ops::Add(s.WithOpName("a1"), x, y);
+  Output a2 = ops::Add(s.WithOpName("a2"), y, x);
+  Output s1 = ops::Sqrt(s.WithOpName("s1"), a1);
+  Output s2 = ops::Sqrt(s.WithOpName("s2"), a2);
+  Output out = ops::Sub(s.WithOpName("out"), s1, s2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // a2 is merged into a1, and then s2 into s1.
+  NodeMap node_map(&output);
+  EXPECT_EQ(5, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("a2"));
+  EXPECT_EQ(nullptr, node_map.GetNode("s2"));
+  const NodeDef* new_out = node_map.GetNode("out");
+  ASSERT_NE(nullptr, new_out);
+  EXPECT_EQ(2, new_out->input_size());
+  EXPECT_EQ("s1", new_out->input(0));
+  EXPECT_EQ("s1", new_out->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, DedupKeepsStatefulOps) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output shape = ops::Const(s.WithOpName("shape"), {2, 2});
+  Output r1 = ops::RandomUniform(s.WithOpName("r1"), shape, DT_FLOAT);
+  Output r2 = ops::RandomUniform(s.WithOpName("r2"), shape, DT_FLOAT);
+  Output out = ops::Sub(s.WithOpName("out"), r1, r2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(4, output.node_size());
+  const NodeDef* new_out = node_map.GetNode("out");
+  ASSERT_NE(nullptr, new_out);
+  EXPECT_EQ("r1", new_out->input(0));
+  EXPECT_EQ("r2", new_out->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveInverseTransposes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output p1 = ops::Const(s.WithOpName("p1"), {1, 2, 0});
+  Output p2 = ops::Const(s.WithOpName("p2"), {2, 0, 1});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, p1);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, p2);
+  Output out = ops::Identity(s.WithOpName("out"), t2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(2, output.node_size());
+  const NodeDef* new_out = node_map.GetNode("out");
+  ASSERT_NE(nullptr, new_out);
+  EXPECT_EQ("x", new_out->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepTransposesThatDoNotCancel) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output p = ops::Const(s.WithOpName("p"), {1, 2, 0});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, p);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, p);
+  Output out = ops::Identity(s.WithOpName("out"), t2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(5, output.node_size());
+  EXPECT_EQ("t2", node_map.GetNode("out")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, CollapseReshapes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output s1 = ops::Const(s.WithOpName("s1"), {-1});
+  Output s2 = ops::Const(s.WithOpName("s2"), {2, -1});
+  Output r1 = ops::Reshape(s.WithOpName("r1"), x, s1);
+  Output r2 = ops::Reshape(s.WithOpName("r2"), r1, s2);
+
+  GrapplerItem item;
+  item.fetch.push_back("r2");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(3, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("r1"));
+  const NodeDef* new_r2 = node_map.GetNode("r2");
+  ASSERT_NE(nullptr, new_r2);
+  EXPECT_EQ("x", new_r2->input(0));
+  EXPECT_EQ("s2", new_r2->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveLosslessCasts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output c1 = ops::Cast(s.WithOpName("c1"), x, DT_DOUBLE);
+  Output c2 = ops::Cast(s.WithOpName("c2"), c1, DT_FLOAT);
+  Output out = ops::Identity(s.WithOpName("out"), c2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(2, output.node_size());
+  EXPECT_EQ("x", node_map.GetNode("out")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepLossyCasts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output c1 = ops::Cast(s.WithOpName("c1"), x, DT_INT32);
+  Output c2 = ops::Cast(s.WithOpName("c2"), c1, DT_FLOAT);
+  Output out = ops::Identity(s.WithOpName("out"), c2);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(4, output.node_size());
+  EXPECT_EQ("c2", node_map.GetNode("out")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, CollapseScalarMuls) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output c1 = ops::Const(s.WithOpName("c1"), 2.0f);
+  Output c2 = ops::Const(s.WithOpName("c2"), 3.0f);
+  Output m1 = ops::Mul(s.WithOpName("m1"), x, c1);
+  Output m2 = ops::Mul(s.WithOpName("m2"), c2, m1);
+
+  GrapplerItem item;
+  item.fetch.push_back("m2");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // m2 becomes Mul(x, 6).
+  NodeMap node_map(&output);
+  EXPECT_EQ(3, output.node_size());
+  const NodeDef* new_m2 = node_map.GetNode("m2");
+  ASSERT_NE(nullptr, new_m2);
+  EXPECT_EQ("x", new_m2->input(1));
+  const NodeDef* scale = node_map.GetNode(new_m2->input(0));
+  ASSERT_NE(nullptr, scale);
+  EXPECT_EQ("Const", scale->op());
+  Tensor value;
+  EXPECT_TRUE(value.FromProto(scale->attr().at("value").tensor()));
+  EXPECT_EQ(0, value.dims());
+  EXPECT_EQ(6.0f, value.scalar<float>()());
+}
+
+TEST_F(ArithmeticOptimizerTest, HoistCommonFactor) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), 5.0f);
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT);
+  Output z = ops::Placeholder(s.WithOpName("z"), DT_FLOAT);
+  Output m1 = ops::Mul(s.WithOpName("m1"), y, x);
+  Output m2 = ops::Mul(s.WithOpName("m2"), x, z);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // out becomes Mul(AddN(y, z), x).
+  NodeMap node_map(&output);
+  EXPECT_EQ(5, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("m1"));
+  EXPECT_EQ(nullptr, node_map.GetNode("m2"));
+  const NodeDef* new_out = node_map.GetNode("out");
+  ASSERT_NE(nullptr, new_out);
+  EXPECT_EQ("Mul", new_out->op());
+  EXPECT_EQ(2, new_out->input_size());
+  EXPECT_EQ("x", new_out->input(1));
+  const NodeDef* sum = node_map.GetNode(new_out->input(0));
+  ASSERT_NE(nullptr, sum);
+  EXPECT_EQ("AddN", sum->op());
+  EXPECT_EQ(2, sum->input_size());
+  EXPECT_EQ("y", sum->input(0));
+  EXPECT_EQ("z", sum->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, DoNotHoistFactorOfUnknownShapes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT);
+  Output z = ops::Placeholder(s.WithOpName("z"), DT_FLOAT);
+  Output m1 = ops::Mul(s.WithOpName("m1"), y, x);
+  Output m2 = ops::Mul(s.WithOpName("m2"), x, z);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // y and z may broadcast against each other, so their sum may not have the
+  // shape of the products.
+  NodeMap node_map(&output);
+  EXPECT_EQ(6, output.node_size());
+  EXPECT_EQ("AddN", node_map.GetNode("out")->op());
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepFetchNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output c1 = ops::Cast(s.WithOpName("c1"), x, DT_DOUBLE);
+  Output c2 = ops::Cast(s.WithOpName("c2"), c1, DT_FLOAT);
+  Output c3 = ops::Cast(s.WithOpName("c3"), c1, DT_FLOAT);
+
+  GrapplerItem item;
+  item.fetch.push_back("c2");
+  item.fetch.push_back("c3");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The fetched casts are not merged nor removed.
+  NodeMap node_map(&output);
+  EXPECT_EQ(4, output.node_size());
+  EXPECT_NE(nullptr, node_map.GetNode("c2"));
+  EXPECT_NE(nullptr, node_map.GetNode("c3"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,420 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/cost_based_placement.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Rough estimates of the compute time of the nodes whose cost was not
+// measured: a node is assumed to be bound by the memory bandwidth of its
+// device, plus a fixed overhead to launch it.
+constexpr double kCpuOpOverheadNs = 1000;
+constexpr double kCpuBytesPerNs = 10;
+constexpr double kGpuOpOverheadNs = 2000;
+constexpr double kGpuBytesPerNs = 100;
+// Rough estimate of a Send/Recv between two devices of the same machine.
+constexpr double kTransferLatencyNs = 10000;
+constexpr double kTransferBytesPerNs = 6;
+// Bypassing host memory, e.g. between GPUs with peer access.
+constexpr double kDirectTransferBytesPerNs = 12;
+
+// Every candidate placement is simulated on the whole graph, so bound the
+// number of simulations.
+constexpr int kMaxSimulations = 1000;
+
+int FindRoot(int node, std::vector<int>* parents) {
+  while ((*parents)[node] != node) {
+    (*parents)[node] = (*parents)[(*parents)[node]];
+    node = (*parents)[node];
+  }
+  return node;
+}
+
+void Union(int a, int b, std::vector<int>* parents) {
+  (*parents)[FindRoot(a, parents)] = FindRoot(b, parents);
+}
+
+}  // namespace
+
+CostBasedPlacement::CostBasedPlacement(
+    const OpPerformanceList& op_performance) {
+  for (const auto& perf : op_performance.op_performance()) {
+    if (!perf.node().empty()) {
+      measured_costs_[std::make_pair(
+          perf.node(), str_util::Uppercase(perf.op().device().type()))] =
+          perf.compute_cost();
+    }
+  }
+}
+
+void CostBasedPlacement::ComputeTensorBytes() {
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const auto& node : graph_.node()) {
+    name_to_node[node.name()] = &node;
+    std::vector<int64>& output_bytes = output_bytes_[&node];
+    auto shapes = node.attr().find("_output_shapes");
+    const OpDef* op_def = nullptr;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+    if (shapes == node.attr().end() ||
+        !OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        !InOutTypesForNode(node, *op_def, &input_types, &output_types).ok()) {
+      continue;
+    }
+    const auto& shape_list = shapes->second.list();
+    for (int i = 0; i < output_types.size() && i < shape_list.shape_size();
+         ++i) {
+      const TensorShapeProto& shape = shape_list.shape(i);
+      // Unknown dimensions count as 1, which keeps the relative sizes of the
+      // tensors that share an unknown batch size.
+      int64 num_bytes =
+          shape.unknown_rank() ? 0 : DataTypeSize(BaseType(output_types[i]));
+      for (const auto& dim : shape.dim()) {
+        num_bytes *= std::max<int64>(dim.size(), 1);
+      }
+      output_bytes.push_back(num_bytes);
+    }
+  }
+
+  for (const auto& node : graph_.node()) {
+    const std::vector<int64>& output_bytes = output_bytes_[&node];
+    int64 num_bytes =
+        std::accumulate(output_bytes.begin(), output_bytes.end(), 0ll);
+    for (const string& input : node.input()) {
+      const int port = NodePosition(input);
+      auto input_node = name_to_node.find(NodeName(input));
+      if (port < 0 || input_node == name_to_node.end()) {
+        continue;
+      }
+      const std::vector<int64>& input_bytes = output_bytes_[input_node->second];
+      if (port < input_bytes.size()) {
+        num_bytes += input_bytes[port];
+      }
+    }
+    bytes_accessed_[&node] = num_bytes;
+  }
+}
+
+void CostBasedPlacement::BuildGroups() {
+  std::unordered_map<string, int> node_index;
+  for (int i = 0; i < graph_.node_size(); ++i) {
+    node_index[graph_.node(i).name()] = i;
+  }
+
+  // Group the nodes that must be colocated: the members of a colocation
+  // group, and the nodes that read a reference or a resource with the node
+  // that produces it.
+  std::vector<int> parents(graph_.node_size());
+  std::iota(parents.begin(), parents.end(), 0);
+  std::vector<bool> pinned(graph_.node_size(), false);
+  for (int i = 0; i < graph_.node_size(); ++i) {
+    const NodeDef& node = graph_.node(i);
+    auto colocation = node.attr().find(kColocationAttrName);
+    if (colocation != node.attr().end()) {
+      for (const string& group : colocation->second.list().s()) {
+        StringPiece name(group);
+        if (!name.Consume(kColocationGroupPrefix)) {
+          continue;
+        }
+        auto colocated = node_index.find(name.ToString());
+        if (colocated != node_index.end()) {
+          Union(i, colocated->second, &parents);
+        }
+      }
+    }
+    const OpDef* op_def = nullptr;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+    if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+        !InOutTypesForNode(node, *op_def, &input_types, &output_types).ok()) {
+      // Leave the nodes we know nothing about where they are.
+      pinned[i] = true;
+      continue;
+    }
+    for (int j = 0; j < input_types.size() && j < node.input_size(); ++j) {
+      if (!IsRefType(input_types[j]) && input_types[j] != DT_RESOURCE) {
+        continue;
+      }
+      auto input = node_index.find(NodeName(node.input(j)));
+      if (input != node_index.end()) {
+        Union(i, input->second, &parents);
+      }
+    }
+  }
+
+  std::map<int, std::vector<int>> members;
+  for (int i = 0; i < graph_.node_size(); ++i) {
+    members[FindRoot(i, &parents)].push_back(i);
+  }
+
+  std::vector<DeviceNameUtils::ParsedName> devices(device_names_.size());
+  for (int d = 0; d < device_names_.size(); ++d) {
+    DeviceNameUtils::ParseFullName(device_names_[d], &devices[d]);
+  }
+  for (const auto& root_and_members : members) {
+    Group group;
+    bool placeable = true;
+    for (int i : root_and_members.second) {
+      placeable = placeable && !pinned[i];
+      group.nodes.push_back(graph_.mutable_node(i));
+    }
+    if (!placeable) {
+      continue;
+    }
+    for (int d = 0; d < device_names_.size(); ++d) {
+      const DeviceType device_type(device_types_[device_names_[d]]);
+      bool has_kernels = true;
+      for (const NodeDef* node : group.nodes) {
+        if (!FindKernelDef(device_type, *node, nullptr, nullptr).ok()) {
+          has_kernels = false;
+          break;
+        }
+      }
+      if (has_kernels) {
+        group.devices.push_back(d);
+      }
+    }
+    if (group.devices.empty()) {
+      continue;
+    }
+
+    // Start from the device requested for the group, or from the first GPU
+    // (or the first device) as the SimplePlacer would.
+    const NodeDef* requested = nullptr;
+    for (const NodeDef* node : group.nodes) {
+      if (!node->device().empty()) {
+        requested = node;
+        break;
+      }
+    }
+    int initial_device = -1;
+    if (requested != nullptr) {
+      DeviceNameUtils::ParsedName spec;
+      if (!DeviceNameUtils::ParseFullName(requested->device(), &spec)) {
+        continue;
+      }
+      for (int d : group.devices) {
+        if (DeviceNameUtils::IsSpecification(spec, devices[d])) {
+          initial_device = d;
+          break;
+        }
+      }
+    } else {
+      initial_device = group.devices[0];
+      for (int d : group.devices) {
+        if (device_types_[device_names_[d]] == DEVICE_GPU) {
+          initial_device = d;
+          break;
+        }
+      }
+    }
+    if (initial_device < 0) {
+      // The group runs on another machine, or on a device that has no kernel
+      // for one of its nodes.
+      continue;
+    }
+    groups_.push_back(std::move(group));
+    AssignDevice(groups_.size() - 1, initial_device);
+    Group& placed = groups_.back();
+    for (const NodeDef* node : placed.nodes) {
+      placed.compute_time += GetComputeTime(*node);
+    }
+  }
+}
+
+string CostBasedPlacement::GetDeviceType(const NodeDef& node) const {
+  auto device_type = device_types_.find(node.device());
+  if (device_type != device_types_.end()) {
+    return device_type->second;
+  }
+  DeviceNameUtils::ParsedName parsed;
+  if (DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+      parsed.has_type) {
+    return str_util::Uppercase(parsed.type);
+  }
+  return DEVICE_CPU;
+}
+
+Costs::Duration CostBasedPlacement::GetComputeTime(const NodeDef& node) const {
+  const string device_type = GetDeviceType(node);
+  auto measured =
+      measured_costs_.find(std::make_pair(node.name(), device_type));
+  if (measured != measured_costs_.end()) {
+    return Costs::Duration(measured->second);
+  }
+  auto bytes_accessed = bytes_accessed_.find(&node);
+  const double num_bytes =
+      bytes_accessed == bytes_accessed_.end() ? 0 : bytes_accessed->second;
+  if (device_type == DEVICE_GPU) {
+    return Costs::Duration(kGpuOpOverheadNs + num_bytes / kGpuBytesPerNs);
+  }
+  return Costs::Duration(kCpuOpOverheadNs + num_bytes / kCpuBytesPerNs);
+}
+
+Costs::Duration CostBasedPlacement::GetTransferTime(const NodeDef& from,
+                                                    int port,
+                                                    const NodeDef& to) const {
+  double num_bytes = 0;
+  auto output_bytes = output_bytes_.find(&from);
+  if (port >= 0 && output_bytes != output_bytes_.end() &&
+      port < output_bytes->second.size()) {
+    num_bytes = output_bytes->second[port];
+  }
+  const double bytes_per_ns =
+      direct_links_.count(std::make_pair(from.device(), to.device()))
+          ? kDirectTransferBytesPerNs
+          : kTransferBytesPerNs;
+  return Costs::Duration(kTransferLatencyNs + num_bytes / bytes_per_ns);
+}
+
+void CostBasedPlacement::AssignDevice(int group, int device) {
+  groups_[group].device = device;
+  for (NodeDef* node : groups_[group].nodes) {
+    node->set_device(device_names_[device]);
+  }
+}
+
+Costs::Duration CostBasedPlacement::Simulate(
+    const std::vector<string>& fetch) const {
+  VirtualScheduler scheduler(
+      graph_, fetch, [this](const NodeDef& from, int port, const NodeDef& to) {
+        return GetTransferTime(from, port, to);
+      });
+  Costs node_costs;
+  do {
+    const NodeDef* node = scheduler.GetCurrNode();
+    node_costs = Costs::ZeroCosts();
+    node_costs.execution_time = GetComputeTime(*node);
+    node_costs.compute_time = node_costs.execution_time;
+  } while (scheduler.MarkCurrNodeExecuted(node_costs));
+  return scheduler.Summary().execution_time;
+}
+
+Status CostBasedPlacement::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                    GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (cluster == nullptr || cluster->GetDevices().size() < 2 ||
+      item.fetch.empty()) {
+    return Status::OK();
+  }
+  for (const auto& node : item.graph.node()) {
+    if (node.op() == "NextIteration" || node.op() == "RefNextIteration") {
+      VLOG(1) << "The virtual scheduler can't simulate loops, keeping the "
+                 "current placement.";
+      return Status::OK();
+    }
+  }
+
+  graph_ = item.graph;
+  device_names_.clear();
+  device_types_.clear();
+  direct_links_.clear();
+  // The devices by canonical name, to find the peers of their links.
+  std::unordered_map<string, string> canonical_names;
+  for (const auto& device : cluster->GetDevices()) {
+    device_names_.push_back(device.name());
+    device_types_[device.name()] = device.device_type();
+    DeviceNameUtils::ParsedName parsed;
+    if (DeviceNameUtils::ParseFullName(device.name(), &parsed)) {
+      canonical_names[DeviceNameUtils::ParsedNameToString(parsed)] =
+          device.name();
+    }
+  }
+  for (const auto& device : cluster->GetDevices()) {
+    DeviceNameUtils::ParsedName peer;
+    if (!DeviceNameUtils::ParseFullName(device.name(), &peer)) continue;
+    for (const auto& link : device.locality().links().link()) {
+      peer.id = link.device_id();
+      auto it = canonical_names.find(DeviceNameUtils::ParsedNameToString(peer));
+      if (it != canonical_names.end()) {
+        direct_links_.emplace(device.name(), it->second);
+      }
+    }
+  }
+  ComputeTensorBytes();
+  BuildGroups();
+
+  // Try the costliest groups first, since moving them matters the most.
+  std::vector<int> order(groups_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return groups_[a].compute_time > groups_[b].compute_time;
+  });
+
+  const Costs::Duration initial_time = Simulate(item.fetch);
+  Costs::Duration best_time = initial_time;
+  int num_simulations = 1;
+  bool improved = !groups_.empty();
+  while (improved && num_simulations < kMaxSimulations) {
+    improved = false;
+    for (int g : order) {
+      const int current_device = groups_[g].device;
+      int best_device = current_device;
+      for (int d : groups_[g].devices) {
+        if (d == current_device || num_simulations >= kMaxSimulations) {
+          continue;
+        }
+        AssignDevice(g, d);
+        const Costs::Duration time = Simulate(item.fetch);
+        ++num_simulations;
+        if (time < best_time) {
+          best_time = time;
+          best_device = d;
+        }
+      }
+      AssignDevice(g, best_device);
+      improved = improved || best_device != current_device;
+    }
+  }
+
+  VLOG(1) << "Predicted step time went from " << initial_time << " to "
+          << best_time << " after " << num_simulations << " simulations.";
+  if (best_time < initial_time) {
+    optimized_graph->Swap(&graph_);
+  }
+  graph_.Clear();
+  output_bytes_.clear();
+  bytes_accessed_.clear();
+  groups_.clear();
+  return Status::OK();
+}
+
+void CostBasedPlacement::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                  const GraphDef& optimized_graph,
+                                  double result) {
+  // Nothing to do for CostBasedPlacement.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
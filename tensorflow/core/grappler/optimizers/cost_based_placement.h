@@ -0,0 +1,95 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_COST_BASED_PLACEMENT_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_COST_BASED_PLACEMENT_H_
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Place the nodes of a graph on the devices of the cluster so as to minimize
+// the step time predicted by the VirtualScheduler, which accounts for the
+// compute time of the nodes and for the Send/Recv transfers between devices.
+// Starting from the current placement, the groups of nodes that must be
+// colocated are moved one at a time to the device that lowers the predicted
+// step time the most, until no move improves it.
+class CostBasedPlacement : public GraphOptimizer {
+ public:
+  CostBasedPlacement() {}
+  // The compute_cost measured for a node (e.g. with the
+  // MeasuringCostEstimator) on a type of device is used instead of the
+  // built-in estimate whenever the node runs on a device of that type.
+  explicit CostBasedPlacement(const OpPerformanceList& op_performance);
+  ~CostBasedPlacement() override {}
+
+  string name() const override { return "cost_based_placement"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Nodes that must run on the same device, and the devices of the cluster
+  // that have a kernel for all of them.
+  struct Group {
+    std::vector<NodeDef*> nodes;
+    std::vector<int> devices;
+    int device = -1;
+    Costs::Duration compute_time;
+  };
+
+  // Computes the number of bytes of the outputs of the nodes of graph_, and
+  // the number of bytes each node reads and writes.
+  void ComputeTensorBytes();
+  // Splits the nodes of graph_ into the groups that may be placed, and
+  // assigns them their initial device. The other nodes keep their device.
+  void BuildGroups();
+  string GetDeviceType(const NodeDef& node) const;
+  Costs::Duration GetComputeTime(const NodeDef& node) const;
+  Costs::Duration GetTransferTime(const NodeDef& from, int port,
+                                  const NodeDef& to) const;
+  void AssignDevice(int group, int device);
+  // Returns the step time predicted by the VirtualScheduler for graph_.
+  Costs::Duration Simulate(const std::vector<string>& fetch) const;
+
+  // compute_cost in nanoseconds, keyed by node name and device type.
+  std::map<std::pair<string, string>, int64> measured_costs_;
+
+  GraphDef graph_;
+  std::vector<string> device_names_;
+  std::unordered_map<string, string> device_types_;
+  // The pairs of devices with a direct link in the DeviceLocality of the
+  // first one, e.g. GPUs with peer access to one another.
+  std::set<std::pair<string, string>> direct_links_;
+  std::unordered_map<const NodeDef*, std::vector<int64>> output_bytes_;
+  std::unordered_map<const NodeDef*, int64> bytes_accessed_;
+  std::vector<Group> groups_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_COST_BASED_PLACEMENT_H_
@@ -0,0 +1,168 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/cost_based_placement.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kCpu0[] = "/job:localhost/replica:0/task:0/cpu:0";
+constexpr char kCpu1[] = "/job:localhost/replica:0/task:0/cpu:1";
+
+// A cluster of two CPUs that never runs anything.
+class TwoCpuCluster : public Cluster {
+ public:
+  TwoCpuCluster() : Cluster(0) {
+    for (const string& name : {kCpu0, kCpu1}) {
+      DeviceAttributes device;
+      device.set_name(name);
+      device.set_device_type("CPU");
+      devices_.push_back(device);
+    }
+  }
+
+  Status Provision() override { return Status::OK(); }
+  Status Initialize(const GrapplerItem& item) override { return Status::OK(); }
+  Status Run(const GraphDef& graph_def,
+             const std::vector<std::pair<string, Tensor>>& feed,
+             const std::vector<string>& fetch,
+             RunMetadata* metadata) override {
+    return errors::Unimplemented("TwoCpuCluster doesn't run graphs");
+  }
+};
+
+class CostBasedPlacementTest : public ::testing::Test {
+ protected:
+  // Records that `node` takes 1ms on a CPU.
+  void AddCost(const string& node) {
+    OpPerformance* perf = op_performance_.add_op_performance();
+    perf->set_node(node);
+    perf->mutable_op()->mutable_device()->set_type("CPU");
+    perf->set_compute_cost(1000000);
+  }
+
+  OpPerformanceList op_performance_;
+  TwoCpuCluster cluster_;
+};
+
+TEST_F(CostBasedPlacementTest, SpreadIndependentBranches) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output m1 = ops::MatMul(s.WithOpName("m1"), a, a);
+  Output m2 = ops::MatMul(s.WithOpName("m2"), a, a);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  AddCost("m1");
+  AddCost("m2");
+
+  CostBasedPlacement optimizer(op_performance_);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(&cluster_, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(4, output.node_size());
+  const string& device1 = node_map.GetNode("m1")->device();
+  const string& device2 = node_map.GetNode("m2")->device();
+  EXPECT_TRUE(device1 == kCpu0 || device1 == kCpu1) << device1;
+  EXPECT_TRUE(device2 == kCpu0 || device2 == kCpu1) << device2;
+  EXPECT_NE(device1, device2);
+}
+
+TEST_F(CostBasedPlacementTest, MoveColocatedNodesTogether) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output m1 = ops::MatMul(s.WithOpName("m1"), a, a);
+  Output m2 = ops::MatMul(s.WithOpName("m2").ColocateWith(m1), a, a);
+  Output m3 = ops::MatMul(s.WithOpName("m3"), a, a);
+  // Runs on another machine, so it keeps its device.
+  Output b = ops::Placeholder(
+      s.WithOpName("b").WithDevice("/job:worker/task:1/cpu:0"), DT_FLOAT);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2, m3, b});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  AddCost("m1");
+  AddCost("m2");
+  AddCost("m3");
+
+  CostBasedPlacement optimizer(op_performance_);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(&cluster_, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(node_map.GetNode("m1")->device(), node_map.GetNode("m2")->device());
+  EXPECT_NE(node_map.GetNode("m1")->device(), node_map.GetNode("m3")->device());
+  EXPECT_EQ("/job:worker/task:1/cpu:0", node_map.GetNode("b")->device());
+}
+
+TEST_F(CostBasedPlacementTest, KeepPlacementWhenTransfersCostMore) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output m1 = ops::MatMul(s.WithOpName("m1"), a, a);
+  Output m2 = ops::MatMul(s.WithOpName("m2"), a, a);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // Without measured costs the nodes are far cheaper than a Send/Recv.
+  CostBasedPlacement optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(&cluster_, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  for (const auto& node : output.node()) {
+    EXPECT_EQ("", node.device()) << node.name();
+  }
+}
+
+TEST_F(CostBasedPlacementTest, NoClusterNoPlacement) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output m1 = ops::MatMul(s.WithOpName("m1"), a, a);
+  Output m2 = ops::MatMul(s.WithOpName("m2"), a, a);
+  Output out = ops::AddN(s.WithOpName("out"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  AddCost("m1");
+  AddCost("m2");
+
+  CostBasedPlacement optimizer(op_performance_);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const auto& node : output.node()) {
+    EXPECT_EQ("", node.device()) << node.name();
+  }
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
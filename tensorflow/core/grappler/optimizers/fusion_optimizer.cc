@@ -0,0 +1,207 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+bool IsControlInput(const string& input) {
+  return !input.empty() && input[0] == '^';
+}
+
+bool IsActivation(const NodeDef& node) {
+  return node.op() == "Relu" || node.op() == "Relu6";
+}
+
+string GetDataFormat(const NodeDef& node) {
+  auto attr = node.attr().find("data_format");
+  if (attr == node.attr().end()) {
+    return "NHWC";
+  }
+  return attr->second.s();
+}
+
+// Returns true if a kernel is registered for the fused node on the device it
+// is assigned to, or on the CPU if it is not assigned yet.
+bool HasFusedKernel(const NodeDef& node) {
+  string device_type = DEVICE_CPU;
+  DeviceNameUtils::ParsedName parsed;
+  if (DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+      parsed.has_type) {
+    device_type = str_util::Uppercase(parsed.type);
+  }
+  return FindKernelDef(DeviceType(device_type), node, nullptr, nullptr).ok();
+}
+
+}  // namespace
+
+const NodeDef* FusionOptimizer::GetFusableInput(const NodeDef& node,
+                                                const string& op) const {
+  if (node.input_size() == 0 || IsControlInput(node.input(0)) ||
+      NodePosition(node.input(0)) != 0) {
+    return nullptr;
+  }
+  const NodeDef* input = node_map_->GetNode(node.input(0));
+  // The value of the input disappears in the fused node, so nothing else may
+  // read it.
+  if (input == nullptr || input->op() != op ||
+      input->device() != node.device() ||
+      removed_nodes_.find(input->name()) != removed_nodes_.end() ||
+      nodes_to_preserve_.find(input->name()) != nodes_to_preserve_.end() ||
+      node_map_->GetOutputs(input->name()).size() != 1) {
+    return nullptr;
+  }
+  return input;
+}
+
+bool FusionOptimizer::FusePattern(const NodeDef& node) {
+  const NodeDef* bias_add = &node;
+  string activation = "Identity";
+  if (IsActivation(node)) {
+    bias_add = GetFusableInput(node, "BiasAdd");
+    if (bias_add == nullptr) {
+      return false;
+    }
+    activation = node.op();
+  } else if (node.op() != "BiasAdd") {
+    return false;
+  }
+  if (bias_add->input_size() < 2 || IsControlInput(bias_add->input(1))) {
+    return false;
+  }
+
+  string fused_op = "_FusedConv2D";
+  const NodeDef* product = GetFusableInput(*bias_add, "Conv2D");
+  if (product != nullptr) {
+    // The bias is added to the channels of the convolution.
+    if (GetDataFormat(*product) != GetDataFormat(*bias_add)) {
+      return false;
+    }
+  } else {
+    fused_op = "_FusedMatMul";
+    product = GetFusableInput(*bias_add, "MatMul");
+  }
+  if (product == nullptr || product->input_size() < 2 ||
+      IsControlInput(product->input(1))) {
+    return false;
+  }
+
+  NodeDef fused;
+  fused.set_name(node.name());
+  fused.set_op(fused_op);
+  fused.set_device(node.device());
+  *fused.add_input() = product->input(0);
+  *fused.add_input() = product->input(1);
+  *fused.add_input() = bias_add->input(1);
+  // The fused node runs after the control inputs of all the nodes it fuses.
+  std::unordered_set<string> control_inputs;
+  for (const NodeDef* fused_node : {product, bias_add, &node}) {
+    for (const string& input : fused_node->input()) {
+      if (IsControlInput(input) && control_inputs.insert(input).second) {
+        *fused.add_input() = input;
+      }
+    }
+  }
+  *fused.mutable_attr() = product->attr();
+  (*fused.mutable_attr())["activation"].set_s(activation);
+  auto output_shapes = node.attr().find("_output_shapes");
+  if (output_shapes != node.attr().end()) {
+    (*fused.mutable_attr())["_output_shapes"] = output_shapes->second;
+  }
+  if (!HasFusedKernel(fused)) {
+    return false;
+  }
+
+  removed_nodes_.insert(product->name());
+  if (bias_add != &node) {
+    removed_nodes_.insert(bias_add->name());
+  }
+  fused_nodes_[node.name()].Swap(&fused);
+  return true;
+}
+
+Status FusionOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                 GraphDef* optimized_graph) {
+  GraphDef graph = item.graph;
+  node_map_.reset(new NodeMap(&graph));
+  nodes_to_preserve_.clear();
+  fused_nodes_.clear();
+  removed_nodes_.clear();
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+
+  // Fuse the activations first, so that the BiasAdd nodes they consume are
+  // not fused on their own.
+  int num_fused = 0;
+  for (const auto& node : graph.node()) {
+    if (IsActivation(node) && FusePattern(node)) {
+      ++num_fused;
+    }
+  }
+  for (const auto& node : graph.node()) {
+    if (node.op() == "BiasAdd" &&
+        removed_nodes_.find(node.name()) == removed_nodes_.end() &&
+        FusePattern(node)) {
+      ++num_fused;
+    }
+  }
+
+  optimized_graph->Clear();
+  for (const auto& node : graph.node()) {
+    if (removed_nodes_.find(node.name()) != removed_nodes_.end()) {
+      continue;
+    }
+    auto fused = fused_nodes_.find(node.name());
+    if (fused != fused_nodes_.end()) {
+      *optimized_graph->add_node() = fused->second;
+    } else {
+      *optimized_graph->add_node() = node;
+    }
+  }
+  *optimized_graph->mutable_versions() = graph.versions();
+  *optimized_graph->mutable_library() = graph.library();
+  node_map_.reset();
+  fused_nodes_.clear();
+  removed_nodes_.clear();
+
+  VLOG(1) << "Fused " << num_fused << " patterns.";
+  return Status::OK();
+}
+
+void FusionOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                               const GraphDef& optimized_graph,
+                               double result) {
+  // Nothing to do for FusionOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,65 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuse Conv2D and MatMul with the BiasAdd and the activation (Relu or Relu6)
+// that follow them into a single _FusedConv2D or _FusedMatMul node, which
+// applies the bias and the activation in the same pass over its output.
+// The patterns are only fused when the device of their nodes has a kernel for
+// the fused op.
+class FusionOptimizer : public GraphOptimizer {
+ public:
+  FusionOptimizer() {}
+  ~FusionOptimizer() override {}
+
+  string name() const override { return "fusion_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns the node of the first input of `node` if it runs `op` and may be
+  // fused into `node`, or nullptr.
+  const NodeDef* GetFusableInput(const NodeDef& node, const string& op) const;
+
+  // Fuses the pattern that ends with `node` into a node that replaces it.
+  // Returns false if `node` does not end a pattern that can be fused.
+  bool FusePattern(const NodeDef& node);
+
+  std::unique_ptr<NodeMap> node_map_;
+  std::unordered_set<string> nodes_to_preserve_;
+  // The fused nodes, keyed by the name of the node they replace.
+  std::unordered_map<string, NodeDef> fused_nodes_;
+  // The nodes fused into the nodes that replace their consumers.
+  std::unordered_set<string> removed_nodes_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
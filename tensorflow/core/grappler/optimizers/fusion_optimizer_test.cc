@@ -0,0 +1,145 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class FusionOptimizerTest : public ::testing::Test {};
+
+TEST_F(FusionOptimizerTest, FuseConv2DBiasAddRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+  Output filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT);
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+  Output conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "SAME");
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  Output out = ops::Identity(s.WithOpName("out"), relu);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(5, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("conv"));
+  EXPECT_EQ(nullptr, node_map.GetNode("bias_add"));
+  const NodeDef* fused = node_map.GetNode("relu");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedConv2D", fused->op());
+  EXPECT_EQ(3, fused->input_size());
+  EXPECT_EQ("input", fused->input(0));
+  EXPECT_EQ("filter", fused->input(1));
+  EXPECT_EQ("bias", fused->input(2));
+  EXPECT_EQ("Relu", fused->attr().at("activation").s());
+  EXPECT_EQ("SAME", fused->attr().at("padding").s());
+  EXPECT_EQ("relu", node_map.GetNode("out")->input(0));
+}
+
+TEST_F(FusionOptimizerTest, FuseMatMulBiasAdd) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b,
+                              ops::MatMul::TransposeB(true));
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+  GrapplerItem item;
+  item.fetch.push_back("bias_add");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(4, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("matmul"));
+  const NodeDef* fused = node_map.GetNode("bias_add");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedMatMul", fused->op());
+  EXPECT_EQ("Identity", fused->attr().at("activation").s());
+  EXPECT_TRUE(fused->attr().at("transpose_b").b());
+}
+
+TEST_F(FusionOptimizerTest, KeepValuesReadByOtherNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b);
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  Output relu = ops::Relu6(s.WithOpName("relu"), bias_add);
+  // The gradient of Relu6 reads the input of the activation.
+  Output grad = ops::Relu6Grad(s.WithOpName("grad"), relu, bias_add);
+
+  GrapplerItem item;
+  item.fetch.push_back("grad");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Only the MatMul and the BiasAdd are fused.
+  NodeMap node_map(&output);
+  EXPECT_EQ(6, output.node_size());
+  EXPECT_EQ(nullptr, node_map.GetNode("matmul"));
+  EXPECT_EQ("_FusedMatMul", node_map.GetNode("bias_add")->op());
+  EXPECT_EQ("Relu6", node_map.GetNode("relu")->op());
+}
+
+TEST_F(FusionOptimizerTest, KeepFetchedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+  Output filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT);
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT);
+  Output conv = ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                            "VALID");
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv, bias);
+
+  GrapplerItem item;
+  item.fetch.push_back("conv");
+  item.fetch.push_back("bias_add");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(5, output.node_size());
+  EXPECT_EQ("Conv2D", node_map.GetNode("conv")->op());
+  EXPECT_EQ("BiasAdd", node_map.GetNode("bias_add")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -49,37 +50,101 @@ std::set<string> GetOpsFormatSupported() {
                                            "FusedBatchNorm",
                                            "FusedBatchNormGrad",
                                            "MaxPool",
-                                           "MaxPoolGrad"};
+                                           "MaxPoolGrad",
+                                           "MaxPoolGradGrad"};
   return ops_format_supported;
 }
 
 std::set<string> GetOpsFormatAgnostic() {
-  std::set<string> ops_format_agnostic = {"Add",
+  std::set<string> ops_format_agnostic = {"Abs",
+                                          "Add",
                                           "AddN",
+                                          "Ceil",
                                           "Concat",
                                           "ConcatV2",
+                                          "Elu",
+                                          "EluGrad",
+                                          "Exp",
                                           "Floor",
                                           "Identity",
+                                          "Log",
+                                          "Max",
+                                          "Maximum",
+                                          "Mean",
+                                          "Min",
+                                          "Minimum",
+                                          "MirrorPad",
                                           "Mul",
                                           "Neg",
+                                          "Pad",
+                                          "Prod",
                                           "RealDiv",
+                                          "Reciprocal",
+                                          "ReciprocalGrad",
                                           "Relu",
+                                          "Relu6",
+                                          "Relu6Grad",
                                           "ReluGrad",
+                                          "Rsqrt",
+                                          "RsqrtGrad",
+                                          "Sigmoid",
+                                          "SigmoidGrad",
+                                          "Sign",
                                           "Slice",
+                                          "Softplus",
+                                          "SoftplusGrad",
+                                          "Softsign",
+                                          "SoftsignGrad",
+                                          "Sqrt",
+                                          "SqrtGrad",
+                                          "Square",
                                           "SquaredDifference",
                                           "Squeeze",
                                           "Sub",
-                                          "Sum"};
+                                          "Sum",
+                                          "Tanh",
+                                          "TanhGrad"};
   return ops_format_agnostic;
 }
 
-bool IsNodeNHWCToNCHW(const string& node_name) {
-  const string transpose_node_prefix = kTransposeNHWCToNCHW;
-  string prefix = node_name.substr(0, transpose_node_prefix.length());
-  if (prefix.compare(transpose_node_prefix) == 0) {
-    return true;
+// The gradients of elementwise activations, whose two inputs have the shape of
+// their output.
+bool IsElementwiseGrad(const string& op) {
+  static const std::set<string>* ops = new std::set<string>(
+      {"EluGrad", "ReciprocalGrad", "Relu6Grad", "ReluGrad", "RsqrtGrad",
+       "SigmoidGrad", "SoftplusGrad", "SoftsignGrad", "SqrtGrad", "TanhGrad"});
+  return ops->find(op) != ops->end();
+}
+
+bool IsReduction(const string& op) {
+  return op == "Max" || op == "Mean" || op == "Min" || op == "Prod" ||
+         op == "Sum";
+}
+
+// Returns the dimension of the NCHW format holding the dimension `dim` of the
+// NHWC format, which can be negative as in python.
+int NHWCToNCHWDim(int dim) {
+  static const int kDims[] = {0, 2, 3, 1};
+  return kDims[(dim + 4) % 4];
+}
+
+// Reads the values of an int32 Const node. Returns false if the node isn't
+// such a constant.
+bool GetIntValues(const NodeDef* node, std::vector<int>* values) {
+  if (node == nullptr || node->op() != "Const" ||
+      node->attr().find("value") == node->attr().end()) {
+    return false;
   }
-  return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node->attr().at("value").tensor()) ||
+      tensor.dtype() != DT_INT32) {
+    return false;
+  }
+  values->clear();
+  for (int i = 0; i < tensor.NumElements(); i++) {
+    values->push_back(tensor.flat<int>()(i));
+  }
+  return true;
 }
 
 bool IsNodeNCHWToNHWC(const string& node_name) {
@@ -242,11 +307,52 @@ class NodeProcessor {
     node->mutable_attr()->insert({"_output_shapes", attr_output_shape});
   }
 
+  void AddNodePermVec(const string& node_name, const string& input_name,
+                      DataType data_type, bool NHWCToNCHW) {
+    NodeDef* node = graph_->add_node();
+    node_map_->AddNode(node_name, node);
+    node->set_name(node_name);
+    *node->add_input() = input_name;
+    *node->add_input() = NHWCToNCHW ? kPermNHWCToNCHW : kPermNCHWToNHWC;
+    node->set_op("Gather");
+
+    AttrValue attr_type_indices;
+    attr_type_indices.set_type(DT_INT32);
+    node->mutable_attr()->insert({"Tindices", attr_type_indices});
+
+    AttrValue attr_type_params;
+    attr_type_params.set_type(data_type);
+    node->mutable_attr()->insert({"Tparams", attr_type_params});
+
+    AttrValue attr_validate;
+    attr_validate.set_b(true);
+    node->mutable_attr()->insert({"validate_indices", attr_validate});
+  }
+
+  void AddNodeConst(const string& node_name, const Tensor& tensor) {
+    NodeDef* node = graph_->add_node();
+    node_map_->AddNode(node_name, node);
+    node->set_name(node_name);
+    node->set_op("Const");
+    AttrValue attr_data_type;
+    attr_data_type.set_type(tensor.dtype());
+    node->mutable_attr()->insert({"dtype", attr_data_type});
+    AttrValue attr_tensor;
+    tensor.AsProtoTensorContent(attr_tensor.mutable_tensor());
+    node->mutable_attr()->insert({"value", attr_tensor});
+  }
+
   virtual Status AddLayoutTransposeToInputs() {
     std::vector<int> input_pos = GetInputPos();
     for (const auto& pos : input_pos) {
       string node_name_NHWCToNCHW = strings::StrCat(
           kTransposeNHWCToNCHW, "-", node_->name(), "-", node_->input(pos));
+      // An input used several times only needs to be transposed once.
+      if (std::find(node_->input().begin(), node_->input().begin() + pos,
+                    node_name_NHWCToNCHW) != node_->input().begin() + pos) {
+        *node_->mutable_input(pos) = node_name_NHWCToNCHW;
+        continue;
+      }
       auto input_node = node_map_->GetNode(node_->input(pos));
       int output_pos = NodePosition(node_->input(pos));
       TF_RETURN_IF_ERROR(HasAttribute(*node_, "T"));
@@ -268,22 +374,26 @@ class NodeProcessor {
     for (const auto& output : outputs) {
       string node_name_NCHWToNHWC = strings::StrCat(
           kTransposeNCHWToNHWC, "-", node_->name(), "-", output->name());
-      auto it = std::find_if(output->mutable_input()->begin(),
-                             output->mutable_input()->end(),
-                             [this](const string& input) {
-                               string node_name = NodeName(input);
-                               return node_name.compare(node_->name()) == 0;
-                             });
-      if (it == output->mutable_input()->end()) {
+      // No need to process control nodes or nodes that use an output
+      // other than the first output: only the first output is of 4D NCHW/NHWC
+      // format and thus relevant here. A node can use the first output
+      // several times, e.g. to square it with a Mul.
+      bool is_input = false;
+      std::vector<int> input_pos;
+      for (int i = 0; i < output->input_size(); i++) {
+        if (NodeName(output->input(i)).compare(node_->name()) == 0) {
+          is_input = true;
+          if (NodePosition(output->input(i)) == 0) {
+            input_pos.push_back(i);
+          }
+        }
+      }
+      if (!is_input) {
         return Status(error::INVALID_ARGUMENT,
                       strings::StrCat("Expect ", node_->name(),
                                       " to be an input of ", output->name()));
       }
-      int output_pos = NodePosition(*it);
-      // No need to process control nodes or nodes that use an output
-      // other than the first output: only the first output is of 4D NCHW/NHWC
-      // format and thus relevant here.
-      if (output_pos != 0) {
+      if (input_pos.empty()) {
         continue;
       }
       TF_RETURN_IF_ERROR(HasAttribute(*node_, "T"));
@@ -291,7 +401,9 @@ class NodeProcessor {
       AddNodeTranspose(
           node_name_NCHWToNHWC, node_->name(), node_->attr().at("T").type(),
           node_->attr().at("_output_shapes").list().shape(0), false);
-      *it = node_name_NCHWToNHWC;
+      for (int pos : input_pos) {
+        *output->mutable_input(pos) = node_name_NCHWToNHWC;
+      }
       node_map_->UpdateOutput(node_->name(), output->name(),
                               node_name_NCHWToNHWC);
       node_map_->AddOutput(node_name_NCHWToNHWC, output->name());
@@ -434,7 +546,7 @@ class AgnosticNodeProcessor : public NodeProcessor {
         return true;
       }
       bool connected =
-          ops_format_agnostic.find(node->name()) != ops_format_agnostic.end();
+          ops_format_agnostic.find(node->op()) != ops_format_agnostic.end();
       if (!connected) {
         return false;
       }
@@ -567,12 +679,13 @@ class ConcatProcessor : public AgnosticNodeProcessor {
     // the last input.
     axis_node_pos_ =
         (node_->op().compare("Concat") == 0) ? 0 : (node_->input_size() - 1);
+    has_const_axis_ = GetAxis(&axis_);
   }
 
  protected:
   bool ShouldProcess() const override {
     return IsDimsFour(node_) && HasOutputs() && IsNodeAfterNCHWToNHWC() &&
-           IsAlongDimC();
+           has_const_axis_;
   }
 
   std::vector<int> GetInputPos() const override {
@@ -587,25 +700,43 @@ class ConcatProcessor : public AgnosticNodeProcessor {
   }
 
   Status CustomizedProcessing() override {
-    node_map_->AddOutput(kConcatConst, node_->name());
-    *node_->mutable_input(axis_node_pos_) = kConcatConst;
+    // The concatenation along the channels, which is the most common one, uses
+    // a shared const; the other axes get their own.
+    string axis_node_name = kConcatConst;
+    const int axis = NHWCToNCHWDim(axis_);
+    if (axis != 1) {
+      axis_node_name = strings::StrCat(kConcatConst, "-", node_->name());
+      Tensor tensor(DT_INT32, TensorShape({}));
+      tensor.scalar<int>()() = axis;
+      AddNodeConst(axis_node_name, tensor);
+    }
+    node_map_->UpdateOutput(node_->input(axis_node_pos_), node_->name(),
+                            axis_node_name);
+    node_map_->AddOutput(axis_node_name, node_->name());
+    *node_->mutable_input(axis_node_pos_) = axis_node_name;
     return Status::OK();
   }
 
-  bool IsAlongDimC() const {
+  bool GetAxis(int* axis) const {
     auto axis_node = node_map_->GetNode(node_->input(axis_node_pos_));
-    if (axis_node->attr().find("value") != axis_node->attr().end()) {
-      return axis_node->attr().at("value").tensor().int_val(0) == 3;
+    std::vector<int> values;
+    if (!GetIntValues(axis_node, &values) || values.size() != 1 ||
+        values[0] < -4 || values[0] > 3) {
+      return false;
     }
-    return false;
+    *axis = values[0];
+    return true;
   }
 
   int axis_node_pos_;
+  bool has_const_axis_;
+  // The concat axis in the NHWC format.
+  int axis_;
 };
 
-class ReluGradProcessor : public AgnosticNodeProcessor {
+class ElementwiseGradProcessor : public AgnosticNodeProcessor {
  public:
-  ReluGradProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
+  ElementwiseGradProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
       : AgnosticNodeProcessor(graph, node, node_map) {}
 
  protected:
@@ -615,6 +746,29 @@ class ReluGradProcessor : public AgnosticNodeProcessor {
   }
 };
 
+// Pad and MirrorPad, whose paddings have a row per dimension of the input.
+class PadProcessor : public AgnosticNodeProcessor {
+ public:
+  PadProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
+      : AgnosticNodeProcessor(graph, node, node_map) {}
+
+ protected:
+  Status CustomizedProcessing() override {
+    string node_name_NHWCToNCHW =
+        strings::StrCat(kPermVecNHWCToNCHW, "-", node_->name(), "-input", 1);
+    DataType paddings_type = DT_INT32;
+    if (node_->attr().find("Tpaddings") != node_->attr().end()) {
+      paddings_type = node_->attr().at("Tpaddings").type();
+    }
+    AddNodePermVec(node_name_NHWCToNCHW, node_->input(1), paddings_type, true);
+    node_map_->UpdateOutput(node_->input(1), node_->name(),
+                            node_name_NHWCToNCHW);
+    node_map_->AddOutput(node_name_NHWCToNCHW, node_->name());
+    *node_->mutable_input(1) = node_name_NHWCToNCHW;
+    return Status::OK();
+  }
+};
+
 class SliceProcessor : public AgnosticNodeProcessor {
  public:
   SliceProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
@@ -636,29 +790,6 @@ class SliceProcessor : public AgnosticNodeProcessor {
     }
     return Status::OK();
   }
-
- private:
-  void AddNodePermVec(const string& node_name, const string& input_name,
-                      DataType data_type, bool NHWCToNCHW) {
-    NodeDef* node = graph_->add_node();
-    node_map_->AddNode(node_name, node);
-    node->set_name(node_name);
-    *node->add_input() = input_name;
-    *node->add_input() = NHWCToNCHW ? kPermNHWCToNCHW : kPermNCHWToNHWC;
-    node->set_op("Gather");
-
-    AttrValue attr_type_indices;
-    attr_type_indices.set_type(DT_INT32);
-    node->mutable_attr()->insert({"Tindices", attr_type_indices});
-
-    AttrValue attr_type_params;
-    attr_type_params.set_type(data_type);
-    node->mutable_attr()->insert({"Tparams", attr_type_params});
-
-    AttrValue attr_validate;
-    attr_validate.set_b(true);
-    node->mutable_attr()->insert({"validate_indices", attr_validate});
-  }
 };
 
 // Specialized SliceProcessor, used if the second and third input are const
@@ -781,54 +912,81 @@ class SqueezeProcessor : public AgnosticNodeProcessor {
   }
 };
 
-class SumProcessor : public AgnosticNodeProcessor {
+class ReductionProcessor : public AgnosticNodeProcessor {
  public:
-  SumProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
-      : AgnosticNodeProcessor(graph, node, node_map) {}
+  ReductionProcessor(GraphDef* graph, NodeDef* node, NodeMap* node_map)
+      : AgnosticNodeProcessor(graph, node, node_map) {
+    has_const_axes_ = GetIntValues(node_map_->GetNode(node_->input(1)), &axes_);
+    keep_dims_ = node_->attr().find("keep_dims") != node_->attr().end() &&
+                 node_->attr().at("keep_dims").b();
+  }
 
  protected:
   bool ShouldProcess() const override {
     auto input0 = node_map_->GetNode(node_->input(0));
     return HasOutputs() && IsNodeAfterNCHWToNHWC() &&
            (IsDimsFour(input0) || IsNodeNCHWToNHWC(input0->name())) &&
-           IsAlongDimNHW();
+           has_const_axes_ && IsOutputLayoutAgnostic();
   }
 
-  Status AddLayoutTransposeToOutputs() override { return Status::OK(); }
+  Status AddLayoutTransposeToOutputs() override {
+    if (keep_dims_) {
+      return NodeProcessor::AddLayoutTransposeToOutputs();
+    }
+    return Status::OK();
+  }
 
   Status CustomizedProcessing() override {
-    node_map_->AddOutput(kReductionConst, node_->name());
-    *node_->mutable_input(1) = kReductionConst;
+    Tensor tensor(DT_INT32, TensorShape({static_cast<int64>(axes_.size())}));
+    for (int i = 0; i < static_cast<int>(axes_.size()); i++) {
+      tensor.flat<int>()(i) = NHWCToNCHWDim(axes_[i]);
+    }
+    string axes_node_name =
+        strings::StrCat(kReductionConst, "-", node_->name());
+    AddNodeConst(axes_node_name, tensor);
+    node_map_->UpdateOutput(node_->input(1), node_->name(), axes_node_name);
+    node_map_->AddOutput(axes_node_name, node_->name());
+    *node_->mutable_input(1) = axes_node_name;
     return Status::OK();
   }
 
  private:
-  bool IsAlongDimNHW() const {
-    NodeDef* node = node_map_->GetNode(node_->input(1));
-    Tensor tensor;
-    if (node->attr().find({"value"}) == node->attr().end()) {
-      return false;
+  // Whether the output can be produced in the NCHW format, or else is the same
+  // in both formats, so that the consumers can use it as it is.
+  bool IsOutputLayoutAgnostic() const {
+    if (keep_dims_) {
+      return IsDimsFour(node_);
     }
-    auto success = tensor.FromProto(node->attr().at({"value"}).tensor());
-    if (!success) {
-      LOG(ERROR) << "Failed to parse TensorProto.";
-      return false;
-    }
-    if (tensor.flat<int>().size() != 3) {
-      return false;
-    }
-    if (tensor.flat<int>()(0) == 0 && tensor.flat<int>()(1) == 1 &&
-        tensor.flat<int>()(2) == 2) {
-      return true;
+    // The dimensions that aren't reduced keep their relative order, which is
+    // the same in both formats unless the channels and the rows or columns
+    // are all kept.
+    std::set<int> reduced;
+    for (int axis : axes_) {
+      if (axis < -4 || axis > 3) {
+        return false;
+      }
+      reduced.insert(NHWCToNCHWDim(axis));
     }
-    return false;
+    bool reduces_c = reduced.count(1) > 0;
+    bool reduces_hw = reduced.count(2) > 0 && reduced.count(3) > 0;
+    return reduces_c || reduces_hw;
   }
+
+  bool has_const_axes_;
+  bool keep_dims_;
+  // The reduction axes in the NHWC format.
+  std::vector<int> axes_;
 };
 
 class DataLayoutOptimizer {
  public:
-  explicit DataLayoutOptimizer(GraphDef* graph)
-      : graph_(graph), node_map_(graph_) {}
+  DataLayoutOptimizer(const std::unordered_set<string>& nodes_to_preserve,
+                      const std::unordered_set<string>& nodes_fed,
+                      GraphDef* graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        nodes_fed_(nodes_fed),
+        graph_(graph),
+        node_map_(graph_) {}
 
   Status Optimize() {
     LOG(INFO) << "Number of nodes for original graph: " << graph_->node_size();
@@ -873,25 +1031,6 @@ class DataLayoutOptimizer {
     node->mutable_attr()->insert({"value", attr_tensor});
   }
 
-  void AddNodeReductionConst() {
-    NodeDef* node = graph_->add_node();
-    node_map_.AddNode(kReductionConst, node);
-    node->set_name(kReductionConst);
-    node->set_op("Const");
-    AttrValue attr_data_type;
-    attr_data_type.set_type(DT_INT32);
-    node->mutable_attr()->insert({"dtype", attr_data_type});
-
-    AttrValue attr_tensor;
-    Tensor tensor(DT_INT32, TensorShape({3}));
-    std::vector<int> axis = {0, 2, 3};
-    for (int i = 0; static_cast<size_t>(i) < axis.size(); i++) {
-      tensor.flat<int>()(i) = axis[i];
-    }
-    tensor.AsProtoTensorContent(attr_tensor.mutable_tensor());
-    node->mutable_attr()->insert({"value", attr_tensor});
-  }
-
   // Expand all nodes which is in NHWC, but supports NCHW or is layout agnostic.
   Status Expand() {
     int node_size_original = graph_->node_size();
@@ -917,7 +1056,8 @@ class DataLayoutOptimizer {
         } else if (node->op().compare("FusedBatchNormGrad") == 0) {
           node_processor.reset(
               new FusedBatchNormGradProcessor(graph_, node, &node_map_));
-        } else if (node->op().compare("MaxPoolGrad") == 0) {
+        } else if (node->op().compare("MaxPoolGrad") == 0 ||
+                   node->op().compare("MaxPoolGradGrad") == 0) {
           node_processor.reset(
               new MaxPoolGradProcessor(graph_, node, &node_map_));
         } else {
@@ -934,7 +1074,6 @@ class DataLayoutOptimizer {
       AddNodePermConst(kPermNHWCToNCHW, {0, 3, 1, 2});
       AddNodePermConst(kPermNCHWToNHWC, {0, 2, 3, 1});
       AddNodeConcatConst();
-      AddNodeReductionConst();
       std::set<string> ops_format_agnostic = GetOpsFormatAgnostic();
       for (int i = 0; i < graph_->node_size(); i++) {
         if (ops_format_agnostic.find(graph_->node(i).op()) !=
@@ -944,6 +1083,8 @@ class DataLayoutOptimizer {
           if (node->op().compare("AddN") == 0) {
             node_processor.reset(new AddNProcessor(graph_, node, &node_map_));
           } else if (node->op().compare("Add") == 0 ||
+                     node->op().compare("Maximum") == 0 ||
+                     node->op().compare("Minimum") == 0 ||
                      node->op().compare("Mul") == 0 ||
                      node->op().compare("RealDiv") == 0 ||
                      node->op().compare("SquaredDifference") == 0 ||
@@ -953,9 +1094,12 @@ class DataLayoutOptimizer {
           } else if (node->op().compare("Concat") == 0 ||
                      node->op().compare("ConcatV2") == 0) {
             node_processor.reset(new ConcatProcessor(graph_, node, &node_map_));
-          } else if (node->op().compare("ReluGrad") == 0) {
+          } else if (IsElementwiseGrad(node->op())) {
             node_processor.reset(
-                new ReluGradProcessor(graph_, node, &node_map_));
+                new ElementwiseGradProcessor(graph_, node, &node_map_));
+          } else if (node->op().compare("MirrorPad") == 0 ||
+                     node->op().compare("Pad") == 0) {
+            node_processor.reset(new PadProcessor(graph_, node, &node_map_));
           } else if (node->op().compare("Slice") == 0) {
             auto input1 = node_map_.GetNode(NodeName(node->input(1)));
             auto input2 = node_map_.GetNode(NodeName(node->input(2)));
@@ -973,8 +1117,9 @@ class DataLayoutOptimizer {
           } else if (node->op().compare("Squeeze") == 0) {
             node_processor.reset(
                 new SqueezeProcessor(graph_, node, &node_map_));
-          } else if (node->op().compare("Sum") == 0) {
-            node_processor.reset(new SumProcessor(graph_, node, &node_map_));
+          } else if (IsReduction(node->op())) {
+            node_processor.reset(
+                new ReductionProcessor(graph_, node, &node_map_));
           } else {
             node_processor.reset(
                 new AgnosticNodeProcessor(graph_, node, &node_map_));
@@ -986,30 +1131,94 @@ class DataLayoutOptimizer {
     return Status::OK();
   }
 
-  // Remove all node pairs, where a NCHW-to-NHWC node is followed by
-  // a NHWC-to-NCHW node.
+  // Returns the permutation of a Transpose node, if it is a constant.
+  bool GetPermutation(const NodeDef& node, std::vector<int>* perm) {
+    if (node.op() != "Transpose" || node.input_size() != 2) {
+      return false;
+    }
+    return GetIntValues(node_map_.GetNode(node.input(1)), perm);
+  }
+
+  // Returns true if the Transpose node undoes its input, which is another
+  // Transpose node.
+  bool IsCancellingTranspose(const NodeDef& node) {
+    std::vector<int> perm;
+    if (!GetPermutation(node, &perm)) {
+      return false;
+    }
+    const NodeDef* input = node_map_.GetNode(node.input(0));
+    std::vector<int> input_perm;
+    if (input == nullptr || !GetPermutation(*input, &input_perm) ||
+        input_perm.size() != perm.size()) {
+      return false;
+    }
+    for (int i = 0; i < static_cast<int>(perm.size()); i++) {
+      if (perm[i] < 0 || perm[i] >= static_cast<int>(perm.size()) ||
+          input_perm[perm[i]] != i) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Remove all the pairs of Transpose nodes that cancel each other: these are
+  // mostly the NCHW-to-NHWC nodes followed by NHWC-to-NCHW nodes that Expand
+  // leaves between the converted nodes, but the transposes of the original
+  // graph are removed the same way. The consumers of the second transpose are
+  // rewired to the input of the first one, and the transposes are removed
+  // once they have no consumers left. A pair with a fed transpose is kept,
+  // since its value then isn't the transpose of its input.
   Status Collapse() {
-    std::unordered_set<string> nodes_removable;
+    std::unordered_set<string> candidates;
     for (int i = 0; i < graph_->node_size(); i++) {
-      auto node = graph_->mutable_node(i);
-      if (IsNodeNHWCToNCHW(node->name())) {
-        if (IsNodeNCHWToNHWC(node->input(0))) {
-          const string& trans_first = node->input(0);
-          const string& trans_second = node->name();
-          auto outputs = node_map_.GetOutputs(trans_second);
-          CHECK(outputs.size() == 1)
-              << "There is always only a single output for a Transpose node, "
-              << "due to the way it is added by NodeProcessor.";
-          NodeDef* output = *outputs.begin();
-          string input = node_map_.GetNode(trans_first)->input(0);
-          for (int i = 0; i < output->input_size(); i++) {
-            if (output->input(i).compare(trans_second) == 0) {
-              *output->mutable_input(i) = input;
-              break;
-            }
+      NodeDef* node = graph_->mutable_node(i);
+      if (!IsCancellingTranspose(*node)) {
+        continue;
+      }
+      NodeDef* first = node_map_.GetNode(node->input(0));
+      if (nodes_fed_.find(node->name()) != nodes_fed_.end() ||
+          nodes_fed_.find(first->name()) != nodes_fed_.end()) {
+        continue;
+      }
+      const string& input = first->input(0);
+      for (NodeDef* output : node_map_.GetOutputs(node->name())) {
+        for (int j = 0; j < output->input_size(); j++) {
+          const string& output_input = output->input(j);
+          if (NodeName(output_input) != node->name()) {
+            continue;
           }
-          nodes_removable.insert(trans_first);
-          nodes_removable.insert(trans_second);
+          if (output_input[0] == '^') {
+            *output->mutable_input(j) = strings::StrCat("^", NodeName(input));
+          } else {
+            *output->mutable_input(j) = input;
+          }
+        }
+        node_map_.AddOutput(NodeName(input), output->name());
+      }
+      candidates.insert(first->name());
+      candidates.insert(node->name());
+    }
+
+    // A transpose that only fed removed nodes can be removed in turn.
+    std::unordered_set<string> nodes_removable;
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      std::unordered_set<string> consumed;
+      for (const auto& node : graph_->node()) {
+        if (nodes_removable.find(node.name()) != nodes_removable.end()) {
+          continue;
+        }
+        for (const string& input : node.input()) {
+          consumed.insert(NodeName(input));
+        }
+      }
+      for (const string& name : candidates) {
+        if (nodes_removable.find(name) == nodes_removable.end() &&
+            consumed.find(name) == consumed.end() &&
+            nodes_to_preserve_.find(name) == nodes_to_preserve_.end()) {
+          nodes_removable.insert(name);
+          changed = true;
         }
       }
     }
@@ -1023,18 +1232,45 @@ class DataLayoutOptimizer {
     return Status::OK();
   }
 
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const std::unordered_set<string>& nodes_fed_;
   GraphDef* graph_;
   NodeMap node_map_;
 };
 
+// Returns the number of GPUs of the cluster, or else of this process.
+int GetNumGPUs(const Cluster* cluster) {
+  int num_gpus = 0;
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.device_type() == DEVICE_GPU) {
+        num_gpus++;
+      }
+    }
+  }
+  return num_gpus > 0 ? num_gpus : GetNumAvailableGPUs();
+}
+
 Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* output) {
-  if (GetNumAvailableGPUs() < 1) {
+  if (GetNumGPUs(cluster) < 1) {
     // LayoutOptimizer is currently only tuned for GPU.
     return Status::OK();
   }
+  std::unordered_set<string> nodes_to_preserve;
+  std::unordered_set<string> nodes_fed;
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve.insert(NodeName(feed.first));
+    nodes_fed.insert(NodeName(feed.first));
+  }
   *output = item.graph;
-  DataLayoutOptimizer layout_optimizer(output);
+  DataLayoutOptimizer layout_optimizer(nodes_to_preserve, nodes_fed, output);
   auto status = layout_optimizer.Optimize();
   if (!status.ok()) {
     *output = item.graph;
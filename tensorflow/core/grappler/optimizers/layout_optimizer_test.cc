@@ -0,0 +1,366 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// A cluster with a single GPU, so that the graphs are converted on machines
+// without one too.
+class GpuCluster : public Cluster {
+ public:
+  GpuCluster() : Cluster(0) {}
+
+  Status Provision() override {
+    DeviceAttributes gpu;
+    gpu.set_name("/job:localhost/replica:0/task:0/gpu:0");
+    gpu.set_device_type(DEVICE_GPU);
+    devices_.push_back(gpu);
+    return Status::OK();
+  }
+
+  Status Initialize(const GrapplerItem& item) override { return Status::OK(); }
+
+  Status Run(const GraphDef& graph_def,
+             const std::vector<std::pair<string, Tensor>>& feed,
+             const std::vector<string>& fetch,
+             RunMetadata* metadata) override {
+    return errors::Unimplemented("GpuCluster doesn't run graphs");
+  }
+};
+
+class LayoutOptimizerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { TF_CHECK_OK(cluster_.Provision()); }
+
+  // Adds an NHWC convolution of a [8, 32, 32, 3] input with 16 filters.
+  Output Conv(const tensorflow::Scope& s, const string& name) {
+    const string input_name = strings::StrCat(name, "_input");
+    const string filter_name = strings::StrCat(name, "_filter");
+    Output input =
+        ops::Variable(s.WithOpName(input_name), {8, 32, 32, 3}, DT_FLOAT);
+    Output filter =
+        ops::Variable(s.WithOpName(filter_name), {3, 3, 3, 16}, DT_FLOAT);
+    shapes_[input_name] = {8, 32, 32, 3};
+    shapes_[name] = {8, 32, 32, 16};
+    return ops::Conv2D(s.WithOpName(name), input, filter, {1, 1, 1, 1},
+                       "SAME");
+  }
+
+  // Optimizes the graph of `s`, whose nodes first get the _output_shapes the
+  // optimizer relies on from shapes_.
+  Status Optimize(const tensorflow::Scope& s, GrapplerItem* item,
+                  GraphDef* output) {
+    TF_CHECK_OK(s.ToGraphDef(&item->graph));
+    for (NodeDef& node : *item->graph.mutable_node()) {
+      auto it = shapes_.find(node.name());
+      if (it == shapes_.end()) {
+        continue;
+      }
+      TensorShapeProto* shape =
+          (*node.mutable_attr())["_output_shapes"].mutable_list()->add_shape();
+      for (int64 dim : it->second) {
+        shape->add_dim()->set_size(dim);
+      }
+    }
+    LayoutOptimizer optimizer;
+    return optimizer.Optimize(&cluster_, *item, output);
+  }
+
+  // Returns the values of a Const node.
+  std::vector<int> ConstValues(const NodeDef* node) {
+    EXPECT_NE(nullptr, node);
+    if (node == nullptr) {
+      return {};
+    }
+    EXPECT_EQ("Const", node->op());
+    Tensor tensor;
+    EXPECT_TRUE(tensor.FromProto(node->attr().at("value").tensor()));
+    std::vector<int> values;
+    for (int i = 0; i < tensor.NumElements(); i++) {
+      values.push_back(tensor.flat<int>()(i));
+    }
+    return values;
+  }
+
+  GpuCluster cluster_;
+  std::unordered_map<string, std::vector<int64>> shapes_;
+};
+
+TEST_F(LayoutOptimizerTest, ReductionWithKeepDims) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output conv = Conv(s, "conv");
+  Output axes = ops::Const(s.WithOpName("axes"), {1, 2});
+  Output sum = ops::Sum(s.WithOpName("sum"), conv, axes,
+                        ops::Sum::KeepDims(true));
+  shapes_["sum"] = {8, 1, 1, 16};
+  Output out = ops::Identity(s.WithOpName("out"), sum);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("sum");
+  ASSERT_NE(nullptr, node);
+  // The rows and columns are the dimensions 2 and 3 of the NCHW format.
+  EXPECT_EQ("conv", node->input(0));
+  EXPECT_EQ("LayoutOptimizerReductionConst-sum", node->input(1));
+  EXPECT_EQ(std::vector<int>({2, 3}),
+            ConstValues(node_map.GetNode(node->input(1))));
+  // The output is NCHW too, and is transposed back for the consumers.
+  EXPECT_EQ("LayoutOptimizerTransposeNCHWToNHWC-sum-out",
+            node_map.GetNode("out")->input(0));
+  EXPECT_EQ(nullptr, node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-sum-"
+                                      "LayoutOptimizerTransposeNCHWToNHWC-"
+                                      "conv-sum"));
+}
+
+TEST_F(LayoutOptimizerTest, ReductionWithoutKeepDims) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output conv = Conv(s, "conv");
+  // Reducing the rows and columns, or the channels, leaves the remaining
+  // dimensions in the same order in both formats.
+  Output hw_axes = ops::Const(s.WithOpName("hw_axes"), {1, 2});
+  Output hw_mean = ops::Mean(s.WithOpName("hw_mean"), conv, hw_axes);
+  shapes_["hw_mean"] = {8, 16};
+  Output hw_out = ops::Identity(s.WithOpName("hw_out"), hw_mean);
+  Output c_axes = ops::Const(s.WithOpName("c_axes"), {-1});
+  Output c_max = ops::Max(s.WithOpName("c_max"), conv, c_axes);
+  shapes_["c_max"] = {8, 32, 32};
+  Output c_out = ops::Identity(s.WithOpName("c_out"), c_max);
+  // Reducing the batch would leave CHW rather than HWC.
+  Output n_axes = ops::Const(s.WithOpName("n_axes"), {0});
+  Output n_sum = ops::Sum(s.WithOpName("n_sum"), conv, n_axes);
+  shapes_["n_sum"] = {32, 32, 16};
+  Output n_out = ops::Identity(s.WithOpName("n_out"), n_sum);
+
+  GrapplerItem item;
+  item.fetch = {"hw_out", "c_out", "n_out"};
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("hw_mean");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("conv", node->input(0));
+  EXPECT_EQ(std::vector<int>({2, 3}),
+            ConstValues(node_map.GetNode(node->input(1))));
+  EXPECT_EQ("hw_mean", node_map.GetNode("hw_out")->input(0));
+
+  node = node_map.GetNode("c_max");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("conv", node->input(0));
+  EXPECT_EQ(std::vector<int>({1}),
+            ConstValues(node_map.GetNode(node->input(1))));
+  EXPECT_EQ("c_max", node_map.GetNode("c_out")->input(0));
+
+  node = node_map.GetNode("n_sum");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("LayoutOptimizerTransposeNCHWToNHWC-conv-n_sum", node->input(0));
+  EXPECT_EQ("n_axes", node->input(1));
+  EXPECT_EQ(std::vector<int>({0}), ConstValues(node_map.GetNode("n_axes")));
+}
+
+TEST_F(LayoutOptimizerTest, ConcatAlongNonChannelAxes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output conv1 = Conv(s, "conv1");
+  Output conv2 = Conv(s, "conv2");
+  Output h_axis = ops::Const(s.WithOpName("h_axis"), 1);
+  Output h_concat =
+      ops::Concat(s.WithOpName("h_concat"), {conv1, conv2}, h_axis);
+  shapes_["h_concat"] = {8, 64, 32, 16};
+  Output h_out = ops::Identity(s.WithOpName("h_out"), h_concat);
+  Output w_axis = ops::Const(s.WithOpName("w_axis"), -2);
+  Output w_concat =
+      ops::Concat(s.WithOpName("w_concat"), {conv1, conv2}, w_axis);
+  shapes_["w_concat"] = {8, 32, 64, 16};
+  Output w_out = ops::Identity(s.WithOpName("w_out"), w_concat);
+  Output c_axis = ops::Const(s.WithOpName("c_axis"), 3);
+  Output c_concat =
+      ops::Concat(s.WithOpName("c_concat"), {conv1, conv2}, c_axis);
+  shapes_["c_concat"] = {8, 32, 32, 32};
+  Output c_out = ops::Identity(s.WithOpName("c_out"), c_concat);
+
+  GrapplerItem item;
+  item.fetch = {"h_out", "w_out", "c_out"};
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("h_concat");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("conv1", node->input(0));
+  EXPECT_EQ("conv2", node->input(1));
+  EXPECT_EQ("LayoutOptimizerConcatConst-h_concat", node->input(2));
+  EXPECT_EQ(std::vector<int>({2}),
+            ConstValues(node_map.GetNode(node->input(2))));
+  EXPECT_EQ("LayoutOptimizerTransposeNCHWToNHWC-h_concat-h_out",
+            node_map.GetNode("h_out")->input(0));
+
+  node = node_map.GetNode("w_concat");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("LayoutOptimizerConcatConst-w_concat", node->input(2));
+  EXPECT_EQ(std::vector<int>({3}),
+            ConstValues(node_map.GetNode(node->input(2))));
+
+  // The concatenations along the channels share a single constant.
+  node = node_map.GetNode("c_concat");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("LayoutOptimizerConcatConst", node->input(2));
+  EXPECT_EQ(std::vector<int>({1}),
+            ConstValues(node_map.GetNode(node->input(2))));
+}
+
+TEST_F(LayoutOptimizerTest, PadPermutesPaddings) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output conv = Conv(s, "conv");
+  Output paddings =
+      ops::Const(s.WithOpName("paddings"), {{0, 0}, {1, 1}, {2, 2}, {0, 0}});
+  Output pad = ops::Pad(s.WithOpName("pad"), conv, paddings);
+  shapes_["pad"] = {8, 34, 36, 16};
+  Output out = ops::Identity(s.WithOpName("out"), pad);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("pad");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("conv", node->input(0));
+  EXPECT_EQ("LayoutOptimizerPermVecNHWCToNCHW-pad-input1", node->input(1));
+  // The rows of the paddings are gathered in the NCHW order.
+  const NodeDef* gather = node_map.GetNode(node->input(1));
+  ASSERT_NE(nullptr, gather);
+  EXPECT_EQ("Gather", gather->op());
+  EXPECT_EQ("paddings", gather->input(0));
+  EXPECT_EQ(std::vector<int>({0, 3, 1, 2}),
+            ConstValues(node_map.GetNode(gather->input(1))));
+  EXPECT_EQ(DT_INT32, gather->attr().at("Tparams").type());
+  EXPECT_EQ("LayoutOptimizerTransposeNCHWToNHWC-pad-out",
+            node_map.GetNode("out")->input(0));
+}
+
+TEST_F(LayoutOptimizerTest, CancelTransposesKeepsFetchedNode) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output p1 = ops::Const(s.WithOpName("p1"), {0, 3, 1, 2});
+  Output p2 = ops::Const(s.WithOpName("p2"), {0, 2, 3, 1});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, p1);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, p2);
+  Output out = ops::Identity(s.WithOpName("out"), t2);
+
+  GrapplerItem item;
+  item.fetch = {"t1", "out"};
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ("x", node_map.GetNode("out")->input(0));
+  EXPECT_NE(nullptr, node_map.GetNode("t1"));
+  EXPECT_EQ(nullptr, node_map.GetNode("t2"));
+}
+
+TEST_F(LayoutOptimizerTest, KeepTransposesOfFedNode) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output p1 = ops::Const(s.WithOpName("p1"), {0, 3, 1, 2});
+  Output p2 = ops::Const(s.WithOpName("p2"), {0, 2, 3, 1});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, p1);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, p2);
+  Output out = ops::Identity(s.WithOpName("out"), t2);
+
+  // Whichever transpose is fed, the consumers of t2 must see the feed.
+  for (const string& fed : {"t1", "t2"}) {
+    GrapplerItem item;
+    item.fetch.push_back("out");
+    item.feed.emplace_back(fed, Tensor(DT_FLOAT, TensorShape({1, 2, 3, 4})));
+    GraphDef output;
+    TF_EXPECT_OK(Optimize(s, &item, &output));
+
+    NodeMap node_map(&output);
+    EXPECT_EQ(item.graph.node_size(), output.node_size()) << fed;
+    EXPECT_EQ("t2", node_map.GetNode("out")->input(0)) << fed;
+    EXPECT_EQ("t1", node_map.GetNode("t2")->input(0)) << fed;
+  }
+}
+
+TEST_F(LayoutOptimizerTest, CancelTransposesConsumedTwice) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output p1 = ops::Const(s.WithOpName("p1"), {0, 3, 1, 2});
+  Output p2 = ops::Const(s.WithOpName("p2"), {0, 2, 3, 1});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, p1);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, p2);
+  // Both inputs of the Mul, and the Neg, use the output of t2.
+  Output square = ops::Mul(s.WithOpName("square"), t2, t2);
+  Output neg = ops::Neg(s.WithOpName("neg"), t2);
+  // t1 has a consumer of its own, which keeps it in the graph.
+  Output other = ops::Identity(s.WithOpName("other"), t1);
+
+  GrapplerItem item;
+  item.fetch = {"square", "neg", "other"};
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("square");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("x", node->input(0));
+  EXPECT_EQ("x", node->input(1));
+  EXPECT_EQ("x", node_map.GetNode("neg")->input(0));
+  EXPECT_EQ("t1", node_map.GetNode("other")->input(0));
+  EXPECT_NE(nullptr, node_map.GetNode("t1"));
+  EXPECT_EQ(nullptr, node_map.GetNode("t2"));
+}
+
+TEST_F(LayoutOptimizerTest, ConvolutionUsedTwice) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output conv = Conv(s, "conv");
+  Output square = ops::Mul(s.WithOpName("square"), conv, conv);
+  shapes_["square"] = {8, 32, 32, 16};
+  Output out = ops::Identity(s.WithOpName("out"), square);
+
+  GrapplerItem item;
+  item.fetch.push_back("out");
+  GraphDef output;
+  TF_EXPECT_OK(Optimize(s, &item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("square");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("conv", node->input(0));
+  EXPECT_EQ("conv", node->input(1));
+  EXPECT_EQ("LayoutOptimizerTransposeNCHWToNHWC-square-out",
+            node_map.GetNode("out")->input(0));
+  EXPECT_EQ(nullptr,
+            node_map.GetNode("LayoutOptimizerTransposeNCHWToNHWC-conv-square"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
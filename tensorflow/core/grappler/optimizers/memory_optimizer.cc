@@ -15,14 +15,32 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_rewriter.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/platform.h"
+
+// The recomputation heuristics rely on the cost models, which mobile builds
+// don't link.
+#ifndef IS_MOBILE_PLATFORM
+#include "tensorflow/core/grappler/costs/graph_memory.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#endif  // IS_MOBILE_PLATFORM
 
 namespace tensorflow {
 namespace grappler {
@@ -32,7 +50,7 @@ const char* kRecomputedNodePrefix = "Recomputed";
 string RecomputedOrOriginalNodeName(
     const std::unordered_set<string>& recomputed_node_names,
     const string& original_node_name) {
-  if (recomputed_node_names.find(original_node_name) ==
+  if (recomputed_node_names.find(NodeName(original_node_name)) ==
       recomputed_node_names.end()) {
     return original_node_name;
   } else {
@@ -101,26 +119,562 @@ std::pair<NodeDef*, NodeDef*> BuildSwapPair(NodeDef* node, int input_to_swap,
   return std::make_pair(swap_out_node, swap_in_node);
 }
 
+// The ids of the inputs to swap to the host, keyed by the name of the node
+// that reads them.
+typedef std::map<string, std::vector<int>> SwappedInputs;
+
+#ifndef IS_MOBILE_PLATFORM
+namespace {
+
+bool IsControlInput(const string& input) {
+  return !input.empty() && input[0] == '^';
+}
+
+// The ops whose outputs are cheap to compute again from their inputs.
+bool IsCheapToRecompute(const NodeDef& node) {
+  static const std::unordered_set<string>* cheap_ops =
+      new std::unordered_set<string>{"BiasAdd", "Elu",     "FusedBatchNorm",
+                                     "Relu",    "Relu6",   "Selu",
+                                     "Sigmoid", "Softplus", "Tanh"};
+  return cheap_ops->count(node.op()) > 0;
+}
+
+// Returns true if the node belongs to the backward pass, i.e. was created in a
+// "gradients" name scope by tf.gradients.
+bool IsGradientNode(const NodeDef& node) {
+  const std::vector<string> scopes = str_util::Split(node.name(), '/');
+  for (int i = 0; i + 1 < scopes.size(); ++i) {
+    if (scopes[i] == "gradients" ||
+        StringPiece(scopes[i]).starts_with("gradients_")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the number of bytes of a tensor. Unknown dimensions count as 1.
+int64 TensorBytes(const OpInfo::TensorProperties& tensor) {
+  if (tensor.shape().unknown_rank()) {
+    return 0;
+  }
+  int64 num_elements = 1;
+  for (const auto& dim : tensor.shape().dim()) {
+    num_elements *= std::max<int64>(dim.size(), 1);
+  }
+  return num_elements * DataTypeSize(BaseType(tensor.dtype()));
+}
+
+// Returns the position of the nodes of the graph in a topological order, or
+// an empty map if the graph has a cycle.
+std::unordered_map<const NodeDef*, int> TopologicalPositions(
+    const GraphDef& graph, NodeMap* node_map) {
+  std::unordered_map<const NodeDef*, int> pending_inputs;
+  std::deque<const NodeDef*> ready;
+  for (const NodeDef& node : graph.node()) {
+    pending_inputs[&node] = node.input_size();
+    if (node.input_size() == 0) {
+      ready.push_back(&node);
+    }
+  }
+  std::unordered_map<const NodeDef*, int> positions;
+  while (!ready.empty()) {
+    const NodeDef* node = ready.front();
+    ready.pop_front();
+    positions[node] = positions.size();
+    for (const NodeDef* output : node_map->GetOutputs(node->name())) {
+      // A node may read several outputs of the same input.
+      for (const string& input : output->input()) {
+        if (NodeName(input) == node->name() && --pending_inputs[output] == 0) {
+          ready.push_back(output);
+        }
+      }
+    }
+  }
+  if (positions.size() != graph.node_size()) {
+    positions.clear();
+  }
+  return positions;
+}
+
+// The nodes added to a graph with loops would have to be added to the frames
+// of the loops.
+bool HasLoops(const GraphDef& graph) {
+  for (const NodeDef& node : graph.node()) {
+    if (node.op() == "Enter" || node.op() == "NextIteration") {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the memory budget of the heuristics: the configured one, or else
+// the memory of the smallest device of the cluster. 0 means no budget.
+int64 GetMemoryBudget(Cluster* cluster, int64 memory_budget) {
+  if (memory_budget <= 0 && cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.memory_limit() > 0 &&
+          (memory_budget <= 0 || device.memory_limit() < memory_budget)) {
+        memory_budget = device.memory_limit();
+      }
+    }
+  }
+  return memory_budget;
+}
+
+// A connected subgraph of cheap forward nodes whose outputs are read by the
+// backward pass.
+struct RecomputedSubgraph {
+  std::vector<const NodeDef*> nodes;
+  // The gradient nodes that read the outputs of the subgraph.
+  std::vector<NodeDef*> targets;
+  // The recomputation runs once this node of the backward pass has run.
+  string trigger;
+  // The number of bytes that no longer need to stay alive between the forward
+  // and the backward pass.
+  int64 saved_bytes = 0;
+};
+
+// Recomputes the cheap activations of the forward pass that are read by the
+// backward pass, starting with those that save the most memory, until the
+// worst case memory usage estimated by GraphMemory fits in memory_budget.
+Status RecomputeActivations(const GrapplerItem& item, int64 memory_budget,
+                            GraphDef* graph) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferFromGraphProperties(&properties));
+  int64 memory_usage = memory.GetWorstCaseMemoryUsage();
+  if (memory_budget > 0 && memory_usage <= memory_budget) {
+    return Status::OK();
+  }
+
+  NodeMap node_map(graph);
+  const std::unordered_map<const NodeDef*, int> positions =
+      TopologicalPositions(*graph, &node_map);
+  if (positions.empty()) {
+    return Status::OK();
+  }
+  auto by_position = [&positions](const NodeDef* a, const NodeDef* b) {
+    return positions.at(a) < positions.at(b);
+  };
+  std::unordered_set<string> fed_nodes;
+  for (const auto& feed : item.feed) {
+    fed_nodes.insert(NodeName(feed.first));
+  }
+  auto is_candidate = [&fed_nodes, &node_map](const NodeDef& node) {
+    return IsCheapToRecompute(node) && !IsGradientNode(node) &&
+           fed_nodes.find(node.name()) == fed_nodes.end() &&
+           !StringPiece(node.name()).starts_with(kRecomputedNodePrefix) &&
+           node_map.GetNode(AddPrefixToNodeName(
+               node.name(), kRecomputedNodePrefix)) == nullptr;
+  };
+  auto reads_gradient_node = [&node_map](const NodeDef& node) {
+    for (const NodeDef* output : node_map.GetOutputs(node.name())) {
+      if (IsGradientNode(*output)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<RecomputedSubgraph> subgraphs;
+  std::unordered_set<const NodeDef*> visited;
+  for (const NodeDef& root : graph->node()) {
+    if (visited.count(&root) > 0 || !is_candidate(root)) {
+      continue;
+    }
+    // Collect the candidates connected to the root by data edges.
+    RecomputedSubgraph subgraph;
+    std::unordered_set<string> names;
+    std::vector<const NodeDef*> queue = {&root};
+    visited.insert(&root);
+    while (!queue.empty()) {
+      const NodeDef* node = queue.back();
+      queue.pop_back();
+      subgraph.nodes.push_back(node);
+      names.insert(node->name());
+      std::vector<const NodeDef*> neighbors;
+      for (const string& input : node->input()) {
+        if (!IsControlInput(input)) {
+          neighbors.push_back(node_map.GetNode(input));
+        }
+      }
+      for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+        neighbors.push_back(output);
+      }
+      for (const NodeDef* neighbor : neighbors) {
+        if (neighbor != nullptr && is_candidate(*neighbor) &&
+            visited.insert(neighbor).second) {
+          queue.push_back(neighbor);
+        }
+      }
+    }
+    std::sort(subgraph.nodes.begin(), subgraph.nodes.end(), by_position);
+
+    std::unordered_set<NodeDef*> targets;
+    std::unordered_set<string> external_inputs;
+    for (const NodeDef* node : subgraph.nodes) {
+      for (NodeDef* output : node_map.GetOutputs(node->name())) {
+        if (IsGradientNode(*output)) {
+          targets.insert(output);
+        }
+      }
+      for (const auto& output : properties.GetOutputProperties(node->name())) {
+        subgraph.saved_bytes += TensorBytes(output);
+      }
+      // The inputs of the subgraph need to stay alive until the recomputation,
+      // unless the backward pass reads them anyway.
+      const std::vector<OpInfo::TensorProperties> inputs =
+          properties.GetInputProperties(node->name());
+      for (int i = 0; i < node->input_size(); ++i) {
+        const string& input = node->input(i);
+        const NodeDef* input_node = node_map.GetNode(input);
+        if (IsControlInput(input) || input_node == nullptr ||
+            names.count(input_node->name()) > 0 ||
+            !external_inputs.insert(input).second ||
+            reads_gradient_node(*input_node)) {
+          continue;
+        }
+        if (i < inputs.size()) {
+          subgraph.saved_bytes -= TensorBytes(inputs[i]);
+        }
+      }
+    }
+    if (targets.empty() || subgraph.saved_bytes <= 0) {
+      continue;
+    }
+    subgraph.targets.assign(targets.begin(), targets.end());
+    std::sort(subgraph.targets.begin(), subgraph.targets.end(), by_position);
+
+    // Delay the recomputation until the backward pass reaches the first
+    // target. None of its inputs depends on the other targets, so the trigger
+    // can't create a cycle.
+    const NodeDef* trigger = nullptr;
+    for (const string& input : subgraph.targets[0]->input()) {
+      const NodeDef* input_node = node_map.GetNode(input);
+      if (input_node != nullptr && IsGradientNode(*input_node) &&
+          (trigger == nullptr ||
+           positions.at(input_node) > positions.at(trigger))) {
+        trigger = input_node;
+      }
+    }
+    if (trigger == nullptr) {
+      continue;
+    }
+    subgraph.trigger = trigger->name();
+    subgraphs.push_back(std::move(subgraph));
+  }
+
+  std::stable_sort(
+      subgraphs.begin(), subgraphs.end(),
+      [](const RecomputedSubgraph& a, const RecomputedSubgraph& b) {
+        return a.saved_bytes > b.saved_bytes;
+      });
+  for (const RecomputedSubgraph& subgraph : subgraphs) {
+    if (memory_budget > 0 && memory_usage <= memory_budget) {
+      break;
+    }
+    VLOG(1) << "Recomputing " << subgraph.nodes.size() << " nodes from "
+            << subgraph.nodes[0]->name() << " after " << subgraph.trigger
+            << " to save " << subgraph.saved_bytes << " bytes";
+    RecomputeSubgraph(subgraph.nodes, subgraph.trigger, subgraph.targets,
+                      graph);
+    memory_usage -= subgraph.saved_bytes;
+  }
+  return Status::OK();
+}
+
+// Returns true if the node runs on a GPU, or may be placed on one of the GPUs
+// of the cluster.
+bool MayRunOnGpu(const NodeDef& node, bool cluster_has_gpu) {
+  if (node.device().empty()) {
+    return cluster_has_gpu;
+  }
+  DeviceNameUtils::ParsedName parsed;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+         parsed.has_type && str_util::Uppercase(parsed.type) == "GPU";
+}
+
+// Sustained bandwidth of the PCIe 3.0 x16 link between a GPU and its host, in
+// GB/s (i.e. bytes per nanosecond).
+constexpr double kHostDeviceGBPerSec = 10;
+// Only the tensors this large are worth the cost of two copies.
+constexpr int64 kMinSwappedBytes = 1 << 20;
+// The minimum number of nodes between the producer of a swapped tensor and
+// its consumer in the topological order, for the copies to overlap with the
+// computation.
+constexpr int kMinSwappedLifetime = 8;
+
+// Adds to swapped_inputs the inputs of the backward pass that hold large
+// activations of the forward pass and that have no other consumer in the
+// backward pass, starting with the largest ones, until the worst case memory
+// usage estimated by GraphMemory fits in memory_budget.
+Status IdentifySwappingCandidates(Cluster* cluster, const GrapplerItem& item,
+                                  int64 memory_budget, GraphDef* graph,
+                                  SwappedInputs* swapped_inputs) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferFromGraphProperties(&properties));
+  int64 memory_usage = memory.GetWorstCaseMemoryUsage();
+  if (memory_budget > 0 && memory_usage <= memory_budget) {
+    return Status::OK();
+  }
+
+  NodeMap node_map(graph);
+  const std::unordered_map<const NodeDef*, int> positions =
+      TopologicalPositions(*graph, &node_map);
+  if (positions.empty()) {
+    return Status::OK();
+  }
+  bool cluster_has_gpu = false;
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      cluster_has_gpu |= device.device_type() == "GPU";
+    }
+  }
+
+  // The inputs of the gradient nodes that read each tensor of the forward
+  // pass.
+  std::map<string, std::vector<std::pair<NodeDef*, int>>> gradient_consumers;
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (!IsGradientNode(node) || swapped_inputs->count(node.name()) > 0) {
+      continue;
+    }
+    for (int i = 0; i < node.input_size(); ++i) {
+      const string& input = node.input(i);
+      const NodeDef* producer = node_map.GetNode(input);
+      if (IsControlInput(input) || producer == nullptr ||
+          IsGradientNode(*producer)) {
+        continue;
+      }
+      int port;
+      const string name = ParseNodeName(input, &port);
+      gradient_consumers[strings::StrCat(name, ":", port)].emplace_back(&node,
+                                                                        i);
+    }
+  }
+
+  struct Candidate {
+    NodeDef* consumer;
+    int input_id;
+    int64 bytes;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& tensor : gradient_consumers) {
+    // The tensor has to stay alive for the other consumers anyway.
+    if (tensor.second.size() != 1) {
+      continue;
+    }
+    NodeDef* consumer = tensor.second[0].first;
+    const int input_id = tensor.second[0].second;
+    const NodeDef* producer = node_map.GetNode(consumer->input(input_id));
+    if (!MayRunOnGpu(*producer, cluster_has_gpu) ||
+        positions.at(consumer) - positions.at(producer) <
+            kMinSwappedLifetime) {
+      continue;
+    }
+    const std::vector<OpInfo::TensorProperties> inputs =
+        properties.GetInputProperties(consumer->name());
+    if (input_id >= inputs.size()) {
+      continue;
+    }
+    // Refs and resources can't be copied, and int32 tensors are kept in host
+    // memory.
+    const DataType dtype = inputs[input_id].dtype();
+    if (IsRefType(dtype) || dtype == DT_RESOURCE || dtype == DT_INT32 ||
+        dtype == DT_STRING) {
+      continue;
+    }
+    const int64 bytes = TensorBytes(inputs[input_id]);
+    if (bytes >= kMinSwappedBytes) {
+      candidates.push_back({consumer, input_id, bytes});
+    }
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.bytes > b.bytes;
+                   });
+  for (const Candidate& candidate : candidates) {
+    if (memory_budget > 0 && memory_usage <= memory_budget) {
+      break;
+    }
+    VLOG(1) << "Swapping input " << candidate.input_id << " of "
+            << candidate.consumer->name() << " to save " << candidate.bytes
+            << " bytes";
+    (*swapped_inputs)[candidate.consumer->name()].push_back(
+        candidate.input_id);
+    memory_usage -= candidate.bytes;
+  }
+  return Status::OK();
+}
+
+// Picks, for each swapped input, the node after which the tensor is copied
+// back to the device: the copy is started early enough to complete right
+// before the consumer runs, according to the compute times predicted by the
+// OpLevelCostEstimator along the latest inputs of the consumer. The triggers
+// are keyed by consumer name and input id.
+Status FindSwapInTriggers(const GrapplerItem& item, GraphDef* graph,
+                          const SwappedInputs& swapped_inputs,
+                          std::map<std::pair<string, int>, string>* triggers) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  NodeMap node_map(graph);
+  const std::unordered_map<const NodeDef*, int> positions =
+      TopologicalPositions(*graph, &node_map);
+  if (positions.empty()) {
+    return Status::OK();
+  }
+
+  OpLevelCostEstimator estimator;
+  auto compute_time = [&properties, &estimator](const NodeDef& node) {
+    OpInfo op_features;
+    op_features.set_op(node.op());
+    *op_features.mutable_attr() = node.attr();
+    for (const auto& input : properties.GetInputProperties(node.name())) {
+      *op_features.add_inputs() = input;
+    }
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_features.add_outputs() = output;
+    }
+    op_features.mutable_device()->set_type(MayRunOnGpu(node, false) ? "GPU"
+                                                                     : "CPU");
+    return estimator.PredictCosts(op_features).execution_time;
+  };
+  // Returns the input of node that is computed last, among those computed
+  // after the producer of the swapped tensor.
+  auto latest_input = [&node_map, &positions](const NodeDef& node,
+                                              const NodeDef& producer) {
+    const NodeDef* latest = nullptr;
+    for (const string& input : node.input()) {
+      const NodeDef* input_node = node_map.GetNode(input);
+      if (input_node != nullptr &&
+          positions.at(input_node) > positions.at(&producer) &&
+          (latest == nullptr ||
+           positions.at(input_node) > positions.at(latest))) {
+        latest = input_node;
+      }
+    }
+    return latest;
+  };
+
+  for (const auto& swapped : swapped_inputs) {
+    const NodeDef* node = node_map.GetNode(swapped.first);
+    if (node == nullptr) {
+      continue;
+    }
+    const std::vector<OpInfo::TensorProperties> inputs =
+        properties.GetInputProperties(node->name());
+    for (int input_id : swapped.second) {
+      if (input_id < 0 || input_id >= node->input_size()) {
+        continue;
+      }
+      const NodeDef* producer = node_map.GetNode(node->input(input_id));
+      if (producer == nullptr) {
+        continue;
+      }
+      const Costs::Duration transfer_time(
+          input_id < inputs.size()
+              ? TensorBytes(inputs[input_id]) / kHostDeviceGBPerSec
+              : 0);
+      const NodeDef* trigger = latest_input(*node, *producer);
+      Costs::Duration elapsed(0);
+      while (trigger != nullptr && elapsed < transfer_time) {
+        const NodeDef* previous = latest_input(*trigger, *producer);
+        if (previous == nullptr) {
+          break;
+        }
+        elapsed += compute_time(*trigger);
+        trigger = previous;
+      }
+      if (trigger != nullptr) {
+        (*triggers)[std::make_pair(node->name(), input_id)] = trigger->name();
+      }
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+#endif  // IS_MOBILE_PLATFORM
+
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* optimized_graph) {
   *optimized_graph = item.graph;
 
+  // The swap_to_host attributes aren't part of the op definitions, and are
+  // removed from the graph.
+  SwappedInputs swapped_inputs;
   for (auto& node : *optimized_graph->mutable_node()) {
-    if (node.attr().count("swap_to_host") == 0) {
+    auto swap_to_host = node.attr().find("swap_to_host");
+    if (swap_to_host != node.attr().end()) {
+      for (int input_id : swap_to_host->second.list().i()) {
+        swapped_inputs[node.name()].push_back(input_id);
+      }
+      node.mutable_attr()->erase("swap_to_host");
+    }
+  }
+
+  // The swap-in of the tensors is scheduled with the cost models, which mobile
+  // builds don't link: they only honor the manual annotations, and may copy
+  // the tensors back right away.
+  std::map<std::pair<string, int>, string> swap_in_triggers;
+#ifndef IS_MOBILE_PLATFORM
+  const bool recompute =
+      optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
+      optimization_level_ == RewriterConfig::HEURISTICS;
+  const bool swap =
+      optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
+      optimization_level_ == RewriterConfig::HEURISTICS;
+  if (HasLoops(item.graph)) {
+    VLOG(1) << "Not optimizing the memory usage of a graph with loops";
+  } else if (recompute || swap || !swapped_inputs.empty()) {
+    const int64 memory_budget = GetMemoryBudget(cluster, memory_budget_);
+    GrapplerItem optimized_item = item;
+    optimized_item.graph = *optimized_graph;
+    if (recompute) {
+      TF_RETURN_IF_ERROR(RecomputeActivations(optimized_item, memory_budget,
+                                              optimized_graph));
+      optimized_item.graph = *optimized_graph;
+    }
+    if (swap) {
+      TF_RETURN_IF_ERROR(IdentifySwappingCandidates(
+          cluster, optimized_item, memory_budget, optimized_graph,
+          &swapped_inputs));
+    }
+    if (!swapped_inputs.empty()) {
+      TF_RETURN_IF_ERROR(FindSwapInTriggers(optimized_item, optimized_graph,
+                                            swapped_inputs,
+                                            &swap_in_triggers));
+    }
+  }
+#endif  // IS_MOBILE_PLATFORM
+
+  // The swap nodes are appended to the graph while its nodes are visited.
+  const int num_nodes = optimized_graph->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    auto swapped = swapped_inputs.find(node->name());
+    if (swapped == swapped_inputs.end()) {
       continue;
     }
 
     // Swap all the tensors that are marked with the 'swap_to_host' attribute.
-    for (int input_id : node.attr().at("swap_to_host").list().i()) {
+    for (int input_id : swapped->second) {
       std::pair<NodeDef*, NodeDef*> swap_nodes =
-          BuildSwapPair(&node, input_id, optimized_graph);
-      *swap_nodes.first->add_input() = node.input(input_id);
-      *node.mutable_input(input_id) = swap_nodes.second->name();
-
-      // TODO(bsteiner): Make sure the tensor isn't swapped back in right away
-      // by adding a control dependency to delay the execution of the swap.
-      // string trigger;
-      //*swap_nodes.second->add_input() = strings::StrCat("^", trigger);
+          BuildSwapPair(node, input_id, optimized_graph);
+      *swap_nodes.first->add_input() = node->input(input_id);
+      *node->mutable_input(input_id) = swap_nodes.second->name();
+
+      // Make sure the tensor isn't swapped back in right away by delaying the
+      // swap-in until the trigger has run.
+      auto trigger =
+          swap_in_triggers.find(std::make_pair(node->name(), input_id));
+      if (trigger != swap_in_triggers.end()) {
+        *swap_nodes.second->add_input() =
+            strings::StrCat("^", trigger->second);
+      }
     }
   }
 
@@ -19,14 +19,23 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
 namespace tensorflow {
 namespace grappler {
 
-// Swap tensors in and out of device memory.
+// Swap tensors in and out of device memory, and recompute activations of the
+// forward pass during the backward pass instead of keeping them alive.
 class MemoryOptimizer : public GraphOptimizer {
  public:
-  MemoryOptimizer() {}
+  MemoryOptimizer() : MemoryOptimizer(RewriterConfig::MANUAL, 0) {}
+  // With the heuristics levels, the cheap activations are recomputed and the
+  // large ones swapped until the graph is estimated to fit in memory_budget
+  // bytes (see the memory_budget field of the RewriterConfig).
+  MemoryOptimizer(RewriterConfig::MemOptType optimization_level,
+                  int64 memory_budget)
+      : optimization_level_(optimization_level),
+        memory_budget_(memory_budget) {}
   ~MemoryOptimizer() override {}
 
   string name() const override { return "memory_optimizer"; };
@@ -36,6 +45,10 @@ class MemoryOptimizer : public GraphOptimizer {
 
   void Feedback(Cluster* cluster, const GrapplerItem& item,
                 const GraphDef& pruned_graph, double result) override;
+
+ private:
+  RewriterConfig::MemOptType optimization_level_;
+  int64 memory_budget_;
 };
 
 // Helper function to recompute a sub-graph (recomputed_source_nodes) on a
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -158,6 +159,121 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   EXPECT_EQ(NodeName(swap_out.name()), swap_in.input(0));
 }
 
+
+class RecomputationHeuristicsTest : public ::testing::Test {
+ protected:
+  // Builds the forward and backward pass of relu(x * w + bias) * w2.
+  GrapplerItem TrainingGraph() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output x = ops::Const(s.WithOpName("x"), 1.f, {64, 256});
+    Output w = ops::Const(s.WithOpName("w"), 1.f, {256, 256});
+    Output bias = ops::Const(s.WithOpName("bias"), 1.f, {256});
+    Output m = ops::MatMul(s.WithOpName("m"), x, w);
+    Output b = ops::BiasAdd(s.WithOpName("b"), m, bias);
+    Output r = ops::Relu(s.WithOpName("r"), b);
+    Output y = ops::MatMul(s.WithOpName("y"), r, w);
+
+    tensorflow::Scope grad = s.NewSubScope("gradients");
+    Output grad_y = ops::Const(grad.WithOpName("grad_y"), 1.f, {64, 256});
+    Output grad_r = ops::MatMul(grad.WithOpName("grad_r"), grad_y, w,
+                                ops::MatMul::TransposeB(true));
+    Output grad_b = ops::ReluGrad(grad.WithOpName("grad_b"), grad_r, r);
+    Output grad_w = ops::MatMul(grad.WithOpName("grad_w"), x, grad_b,
+                                ops::MatMul::TransposeA(true));
+
+    GrapplerItem item;
+    item.fetch = {"y", "gradients/grad_w"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(RecomputationHeuristicsTest, RecomputeActivations) {
+  GrapplerItem item = TrainingGraph();
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS, 0);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The BiasAdd and the Relu are recomputed from the output of the MatMul
+  // once the backward pass reaches the ReluGrad.
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size() + 2, output.node_size());
+  const NodeDef* recomputed_b = node_map.GetNode("Recomputed/b");
+  ASSERT_NE(nullptr, recomputed_b);
+  EXPECT_EQ("m", recomputed_b->input(0));
+  EXPECT_EQ("^gradients/grad_r", recomputed_b->input(2));
+  const NodeDef* recomputed_r = node_map.GetNode("Recomputed/r");
+  ASSERT_NE(nullptr, recomputed_r);
+  EXPECT_EQ("Recomputed/b", recomputed_r->input(0));
+  EXPECT_EQ("^gradients/grad_r", recomputed_r->input(1));
+
+  EXPECT_EQ("Recomputed/r", node_map.GetNode("gradients/grad_b")->input(1));
+  // The forward pass still uses the original activations.
+  EXPECT_EQ("r", node_map.GetNode("y")->input(0));
+}
+
+TEST_F(RecomputationHeuristicsTest, FitsInBudget) {
+  GrapplerItem item = TrainingGraph();
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                            1LL << 30);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(RecomputationHeuristicsTest, ManualAnnotationsOnly) {
+  GrapplerItem item = TrainingGraph();
+  MemoryOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+class SwappingHeuristicsTest : public ::testing::Test {};
+
+TEST_F(SwappingHeuristicsTest, SwapLargeActivations) {
+  // A 2MB activation of the forward pass on a GPU, read again at the end of
+  // the backward pass.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/gpu:0");
+  Output x = ops::Const(s.WithOpName("x"), 1.f, {512, 1024});
+  Output a = ops::Relu(s.WithOpName("a"), x);
+  Output forward = a;
+  for (int i = 0; i < 10; ++i) {
+    forward = ops::Tanh(s.WithOpName(strings::StrCat("t", i)), forward);
+  }
+  tensorflow::Scope grad = s.NewSubScope("gradients");
+  Output backward = forward;
+  for (int i = 0; i < 10; ++i) {
+    backward = ops::Tanh(grad.WithOpName(strings::StrCat("g", i)), backward);
+  }
+  Output relu_grad = ops::ReluGrad(grad.WithOpName("final"), backward, a);
+
+  GrapplerItem item;
+  item.fetch = {"gradients/final"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS, 0);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size() + 2, output.node_size());
+  EXPECT_EQ("swap_in_gradients/final_1",
+            node_map.GetNode("gradients/final")->input(1));
+  EXPECT_EQ(0, node_map.GetNode("gradients/final")->attr().count(
+                   "swap_to_host"));
+  const NodeDef* swap_out = node_map.GetNode("swap_out_gradients/final_1");
+  ASSERT_NE(nullptr, swap_out);
+  EXPECT_EQ("a", swap_out->input(0));
+  // The tensor is swapped back in once the backward pass is underway.
+  const NodeDef* swap_in = node_map.GetNode("swap_in_gradients/final_1");
+  ASSERT_NE(nullptr, swap_in);
+  EXPECT_EQ(2, swap_in->input_size());
+  EXPECT_EQ("swap_out_gradients/final_1", swap_in->input(0));
+  EXPECT_EQ('^', swap_in->input(1)[0]);
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
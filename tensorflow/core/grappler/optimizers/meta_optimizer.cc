@@ -15,13 +15,23 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/mixed_precision_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/platform.h"
+
+// Mobile builds run on a single device, and don't link the cost models.
+#ifndef IS_MOBILE_PLATFORM
+#include "tensorflow/core/grappler/optimizers/cost_based_placement.h"
+#endif  // IS_MOBILE_PLATFORM
 
 namespace tensorflow {
 namespace grappler {
@@ -36,11 +46,29 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
   if (optimizer == "constfold") {
     graph_optimizer.reset(new ConstantFolding());
   }
+  if (optimizer == "arithmetic") {
+    graph_optimizer.reset(new ArithmeticOptimizer());
+  }
+#ifndef IS_MOBILE_PLATFORM
+  if (optimizer == "placement") {
+    graph_optimizer.reset(new CostBasedPlacement());
+  }
+#endif  // IS_MOBILE_PLATFORM
+  if (optimizer == "fusion") {
+    graph_optimizer.reset(new FusionOptimizer());
+  }
+  if (optimizer == "multiapply") {
+    graph_optimizer.reset(new MultiApplyOptimizer());
+  }
+  if (optimizer == "mixedprecision") {
+    graph_optimizer.reset(new MixedPrecisionOptimizer());
+  }
   if (optimizer == "layout") {
     graph_optimizer.reset(new LayoutOptimizer());
   }
   if (optimizer == "memory") {
-    graph_optimizer.reset(new MemoryOptimizer());
+    graph_optimizer.reset(new MemoryOptimizer(cfg_.memory_optimization(),
+                                              cfg_.memory_budget()));
   }
   if (optimizer == "autoparallel") {
     graph_optimizer.reset(
@@ -60,21 +88,47 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new ConstantFolding()));
     }
+    if (cfg_.arithmetic_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new ArithmeticOptimizer()));
+    }
+#ifndef IS_MOBILE_PLATFORM
+    if (cfg_.placement_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new CostBasedPlacement()));
+    }
+#endif  // IS_MOBILE_PLATFORM
     if (cfg_.optimize_tensor_layout()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new LayoutOptimizer()));
     }
-    if (cfg_.memory_optimization() > 0) {
+    // Fuse after the layout optimization, which does not know the fused ops.
+    if (cfg_.op_fusion()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new FusionOptimizer()));
+    }
+    if (cfg_.multi_apply_optimization()) {
       optimizers.push_back(
-          std::unique_ptr<GraphOptimizer>(new MemoryOptimizer()));
+          std::unique_ptr<GraphOptimizer>(new MultiApplyOptimizer()));
+    }
+    // Convert after the fusion, whose patterns end with float BiasAdds.
+    if (cfg_.mixed_precision()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new MixedPrecisionOptimizer()));
+    }
+    if (cfg_.memory_optimization() > 0) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(new MemoryOptimizer(
+          cfg_.memory_optimization(), cfg_.memory_budget())));
     }
     if (cfg_.auto_parallel().enable()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
           new AutoParallel(cfg_.auto_parallel().num_replicas())));
     }
   } else {
-    std::set<string> available_optimizers = {"pruning", "constfold", "layout",
-                                             "memory", "autoparallel"};
+    std::set<string> available_optimizers = {
+        "pruning",      "constfold",     "arithmetic", "placement",
+        "fusion",       "layout",        "memory",     "multiapply",
+        "autoparallel", "mixedprecision"};
     for (const auto& optimizer : cfg_.optimizers()) {
       if (available_optimizers.find(optimizer) != available_optimizers.end()) {
         optimizers.push_back(NewOptimizer(optimizer));
@@ -90,13 +144,13 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool already_optimized = false;
   for (const auto& optimizer : optimizers) {
     if (!already_optimized) {
-      TF_RETURN_IF_ERROR(optimizer->Optimize(nullptr, item, optimized_graph));
+      TF_RETURN_IF_ERROR(optimizer->Optimize(cluster, item, optimized_graph));
       already_optimized = true;
     } else {
       GrapplerItem optimized_item = item;
       optimized_item.graph = *optimized_graph;
       TF_RETURN_IF_ERROR(
-          optimizer->Optimize(nullptr, optimized_item, optimized_graph));
+          optimizer->Optimize(cluster, optimized_item, optimized_graph));
     }
   }
   // Copy the graph version.
@@ -112,6 +166,10 @@ void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
 
 bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
   return cfg.optimize_tensor_layout() || cfg.constant_folding() ||
+         cfg.arithmetic_optimization() || cfg.placement_optimization() ||
+         cfg.op_fusion() || cfg.multi_apply_optimization() ||
+         cfg.mixed_precision() ||
+         cfg.memory_optimization() > 0 ||
          cfg.auto_parallel().enable() || !cfg.optimizers().empty();
 }
 
@@ -0,0 +1,187 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/mixed_precision_optimizer.h"
+#include <algorithm>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/devices.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+bool IsControlInput(const string& input) {
+  return !input.empty() && input[0] == '^';
+}
+
+// The ops which have both float and half GPU kernels, with the indices of
+// their inputs of type T. Each of them has a single output, of type T.
+const std::unordered_map<string, std::vector<int>>& HalfOps() {
+  static const std::unordered_map<string, std::vector<int>>* ops =
+      new std::unordered_map<string, std::vector<int>>({
+          {"MatMul", {0, 1}},
+          {"Conv2D", {0, 1}},
+          {"Conv2DBackpropInput", {1, 2}},
+          {"Conv2DBackpropFilter", {0, 2}},
+          {"_FusedConv2D", {0, 1, 2}},
+      });
+  return *ops;
+}
+
+}  // namespace
+
+const std::vector<int>* MixedPrecisionOptimizer::HalfInputs(
+    const NodeDef& node) const {
+  auto op = HalfOps().find(node.op());
+  if (op == HalfOps().end() ||
+      nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+    return nullptr;
+  }
+  auto type = node.attr().find("T");
+  if (type == node.attr().end() || type->second.type() != DT_FLOAT) {
+    return nullptr;
+  }
+  for (int index : op->second) {
+    if (index >= node.input_size() || IsControlInput(node.input(index))) {
+      return nullptr;
+    }
+  }
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(node.device(), &parsed) ||
+      !parsed.has_type) {
+    return has_gpu_ ? &op->second : nullptr;
+  }
+  return str_util::Uppercase(parsed.type) == DEVICE_GPU ? &op->second
+                                                        : nullptr;
+}
+
+string MixedPrecisionOptimizer::CastTo(DataType type, const string& input,
+                                       const string& device) {
+  int position;
+  const string producer = ParseNodeName(input, &position);
+  const string key = strings::StrCat(DataTypeString(type), ":", producer, ":",
+                                     position, "@", device);
+  auto cast = casts_.find(key);
+  if (cast != casts_.end()) {
+    return cast->second;
+  }
+  string prefix = producer;
+  if (position > 0) {
+    strings::StrAppend(&prefix, "_", position);
+  }
+  strings::StrAppend(&prefix,
+                     type == DT_HALF ? "/CastToHalf" : "/CastToFloat");
+  string name = prefix;
+  for (int i = 1; node_names_.find(name) != node_names_.end(); ++i) {
+    name = strings::StrCat(prefix, "_", i);
+  }
+  node_names_.insert(name);
+  casts_[key] = name;
+
+  cast_nodes_.emplace_back();
+  NodeDef* node = &cast_nodes_.back();
+  node->set_name(name);
+  node->set_op("Cast");
+  node->set_device(device);
+  node->add_input(input);
+  (*node->mutable_attr())["SrcT"].set_type(type == DT_HALF ? DT_FLOAT
+                                                           : DT_HALF);
+  (*node->mutable_attr())["DstT"].set_type(type);
+  return name;
+}
+
+Status MixedPrecisionOptimizer::Optimize(Cluster* cluster,
+                                         const GrapplerItem& item,
+                                         GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_.clear();
+  node_names_.clear();
+  casts_.clear();
+  cast_nodes_.clear();
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+  has_gpu_ = GetNumAvailableGPUs() > 0;
+
+  // The devices of the converted nodes, keyed by their name.
+  std::unordered_map<string, string> converted;
+  for (const NodeDef& node : optimized_graph->node()) {
+    node_names_.insert(node.name());
+    if (HalfInputs(node) != nullptr) {
+      converted[node.name()] = node.device();
+    }
+  }
+  if (converted.empty()) {
+    return Status::OK();
+  }
+
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    const std::vector<int>* half_inputs =
+        converted.find(node.name()) != converted.end() ? HalfInputs(node)
+                                                       : nullptr;
+    for (int i = 0; i < node.input_size(); ++i) {
+      const string& input = node.input(i);
+      if (IsControlInput(input)) {
+        continue;
+      }
+      int position;
+      auto producer = converted.find(ParseNodeName(input, &position));
+      const bool from_converted =
+          producer != converted.end() && position == 0;
+      const bool to_half =
+          half_inputs != nullptr &&
+          std::find(half_inputs->begin(), half_inputs->end(), i) !=
+              half_inputs->end();
+      // Cast the inputs of the converted nodes on their device, and their
+      // outputs on theirs, before they are sent to another device.
+      if (to_half && !from_converted) {
+        node.set_input(i, CastTo(DT_HALF, input, node.device()));
+      } else if (!to_half && from_converted) {
+        node.set_input(i, CastTo(DT_FLOAT, input, producer->second));
+      }
+    }
+    if (half_inputs != nullptr) {
+      (*node.mutable_attr())["T"].set_type(DT_HALF);
+    }
+  }
+  for (NodeDef& cast : cast_nodes_) {
+    optimized_graph->add_node()->Swap(&cast);
+  }
+  cast_nodes_.clear();
+  return Status::OK();
+}
+
+void MixedPrecisionOptimizer::Feedback(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       const GraphDef& optimized_graph,
+                                       double result) {
+  // Nothing to do for MixedPrecisionOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,71 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_MIXED_PRECISION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_MIXED_PRECISION_OPTIMIZER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Runs the float32 MatMul and convolution nodes of the GPU in half precision.
+// Their float inputs are cast to half, and their outputs are cast back to
+// float for the nodes which are not converted, so that the variables, the
+// batch normalizations and the apply ops keep running in float32. Chains of
+// converted nodes pass half tensors to each other without casts. cuBLAS and
+// cuDNN accumulate these products in float32.
+// Only the nodes assigned to a GPU, or not assigned yet when the process has
+// a GPU, are converted.
+class MixedPrecisionOptimizer : public GraphOptimizer {
+ public:
+  MixedPrecisionOptimizer() {}
+  ~MixedPrecisionOptimizer() override {}
+
+  string name() const override { return "mixed_precision_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns the indices of the inputs of `node` to convert to half, or
+  // nullptr if the node is not converted.
+  const std::vector<int>* HalfInputs(const NodeDef& node) const;
+
+  // Returns the name of a node which casts `input` to `type` on `device`,
+  // adding it to the graph the first time.
+  string CastTo(DataType type, const string& input, const string& device);
+
+  std::unordered_set<string> nodes_to_preserve_;
+  // Whether the nodes which are not assigned to a device yet may be converted.
+  bool has_gpu_ = false;
+  // The names of the nodes of the graph, including the casts.
+  std::unordered_set<string> node_names_;
+  // The casts added to the graph, keyed by their type, input and device.
+  std::unordered_map<string, string> casts_;
+  std::vector<NodeDef> cast_nodes_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_MIXED_PRECISION_OPTIMIZER_H_
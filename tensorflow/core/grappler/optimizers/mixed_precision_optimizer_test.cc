@@ -0,0 +1,135 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/mixed_precision_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class MixedPrecisionOptimizerTest : public ::testing::Test {};
+
+TEST_F(MixedPrecisionOptimizerTest, ConvertChainOfMatMuls) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Variable(s.WithOpName("b"), {2, 2}, DT_FLOAT);
+  Output m1 = ops::MatMul(s.WithOpName("m1").WithDevice("/gpu:0"), a, b);
+  Output m2 = ops::MatMul(s.WithOpName("m2").WithDevice("/gpu:0"), m1, b);
+  Output relu = ops::Relu(s.WithOpName("relu").WithDevice("/gpu:0"), m2);
+
+  GrapplerItem item;
+  item.fetch.push_back("relu");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MixedPrecisionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size() + 3, output.node_size());
+  const NodeDef* node = node_map.GetNode("m1");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ(DT_HALF, node->attr().at("T").type());
+  EXPECT_EQ("a/CastToHalf", node->input(0));
+  EXPECT_EQ("b/CastToHalf", node->input(1));
+
+  // The converted nodes pass half tensors to each other.
+  node = node_map.GetNode("m2");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ(DT_HALF, node->attr().at("T").type());
+  EXPECT_EQ("m1", node->input(0));
+  EXPECT_EQ("b/CastToHalf", node->input(1));
+
+  node = node_map.GetNode("relu");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ(DT_FLOAT, node->attr().at("T").type());
+  EXPECT_EQ("m2/CastToFloat", node->input(0));
+
+  const NodeDef* cast = node_map.GetNode("b/CastToHalf");
+  ASSERT_NE(nullptr, cast);
+  EXPECT_EQ("Cast", cast->op());
+  EXPECT_EQ("/gpu:0", cast->device());
+  EXPECT_EQ(DT_FLOAT, cast->attr().at("SrcT").type());
+  EXPECT_EQ(DT_HALF, cast->attr().at("DstT").type());
+  cast = node_map.GetNode("m2/CastToFloat");
+  ASSERT_NE(nullptr, cast);
+  EXPECT_EQ(DT_HALF, cast->attr().at("SrcT").type());
+  EXPECT_EQ(DT_FLOAT, cast->attr().at("DstT").type());
+}
+
+TEST_F(MixedPrecisionOptimizerTest, KeepCpuAndFetchedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output cpu = ops::MatMul(s.WithOpName("cpu").WithDevice("/cpu:0"), a, b);
+  Output fetched =
+      ops::MatMul(s.WithOpName("fetched").WithDevice("/gpu:0"), cpu, b);
+
+  GrapplerItem item;
+  item.fetch.push_back("fetched");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MixedPrecisionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  for (const NodeDef& node : output.node()) {
+    if (node.op() == "MatMul") {
+      EXPECT_EQ(DT_FLOAT, node.attr().at("T").type());
+    }
+  }
+}
+
+TEST_F(MixedPrecisionOptimizerTest, ConvertConvolutionGradients) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT);
+  Output grad = ops::Placeholder(s.WithOpName("grad"), DT_FLOAT);
+  Output filter_sizes = ops::Const(s.WithOpName("filter_sizes"), {3, 3, 1, 1});
+  Output filter_grad = ops::Conv2DBackpropFilter(
+      s.WithOpName("filter_grad").WithDevice("/gpu:0"), input, filter_sizes,
+      grad, {1, 1, 1, 1}, "SAME");
+  Output update = ops::Identity(s.WithOpName("update"), filter_grad);
+
+  GrapplerItem item;
+  item.fetch.push_back("update");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MixedPrecisionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The gradient is cast back to float before it updates the variable.
+  NodeMap node_map(&output);
+  const NodeDef* node = node_map.GetNode("filter_grad");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ(DT_HALF, node->attr().at("T").type());
+  EXPECT_EQ("input/CastToHalf", node->input(0));
+  EXPECT_EQ("filter_sizes", node->input(1));
+  EXPECT_EQ("grad/CastToHalf", node->input(2));
+  node = node_map.GetNode("update");
+  ASSERT_NE(nullptr, node);
+  EXPECT_EQ("filter_grad/CastToFloat", node->input(0));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
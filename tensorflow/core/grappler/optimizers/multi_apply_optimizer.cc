@@ -0,0 +1,314 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
+#include <map>
+#include <utility>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+struct MultiApplyOp {
+  const char* fused_op;
+  // The number of data inputs of the apply op.
+  int num_inputs;
+};
+
+const std::map<string, MultiApplyOp>& MultiApplyOps() {
+  static const std::map<string, MultiApplyOp>* ops =
+      new std::map<string, MultiApplyOp>({
+          {"ApplyAdam", {"_MultiApplyAdam", 10}},
+          {"ResourceApplyAdam", {"_ResourceMultiApplyAdam", 10}},
+          {"ApplyMomentum", {"_MultiApplyMomentum", 5}},
+          {"ResourceApplyMomentum", {"_ResourceMultiApplyMomentum", 5}},
+          {"ApplyRMSProp", {"_MultiApplyRMSProp", 8}},
+          {"ResourceApplyRMSProp", {"_ResourceMultiApplyRMSProp", 8}},
+      });
+  return *ops;
+}
+
+bool IsControlInput(const string& input) {
+  return !input.empty() && input[0] == '^';
+}
+
+bool IsControlFlow(const NodeDef& node) {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"Switch", "RefSwitch", "Merge", "RefMerge", "Enter", "RefEnter", "Exit",
+       "RefExit", "NextIteration", "RefNextIteration", "LoopCond"});
+  return ops->find(node.op()) != ops->end();
+}
+
+int NumDataInputs(const NodeDef& node) {
+  int num_inputs = 0;
+  while (num_inputs < node.input_size() &&
+         !IsControlInput(node.input(num_inputs))) {
+    ++num_inputs;
+  }
+  return num_inputs;
+}
+
+string GetAttrString(const NodeDef& node, const string& name) {
+  auto attr = node.attr().find(name);
+  if (attr == node.attr().end()) {
+    return "";
+  }
+  return SummarizeAttrValue(attr->second);
+}
+
+// Returns true if a kernel is registered for the fused node on the device it
+// is assigned to, or on the CPU if it is not assigned yet.
+bool HasFusedKernel(const NodeDef& node) {
+  string device_type = DEVICE_CPU;
+  DeviceNameUtils::ParsedName parsed;
+  if (DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+      parsed.has_type) {
+    device_type = str_util::Uppercase(parsed.type);
+  }
+  return FindKernelDef(DeviceType(device_type), node, nullptr, nullptr).ok();
+}
+
+}  // namespace
+
+bool MultiApplyOptimizer::IsCandidate(const NodeDef& node) const {
+  auto op = MultiApplyOps().find(node.op());
+  if (op == MultiApplyOps().end() ||
+      nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end() ||
+      NumDataInputs(node) != op->second.num_inputs ||
+      node.attr().find("T") == node.attr().end()) {
+    return false;
+  }
+  // The grouped node is replaced by a NoOp, so nothing may read its output.
+  for (const NodeDef* output : node_map_->GetOutputs(node.name())) {
+    for (const string& input : output->input()) {
+      if (!IsControlInput(input) && NodeName(input) == node.name()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::unordered_set<string> MultiApplyOptimizer::IndependentCandidates(
+    const GraphDef& graph, const std::unordered_set<string>& candidates) {
+  // Whether each node is, or depends on, a candidate or a control flow node.
+  // A candidate which depends on another can't run at the same time, and the
+  // nodes of a conditional or a loop may not run, or run many times.
+  std::unordered_map<string, bool> depends;
+  std::unordered_set<string> visiting;
+  std::vector<std::pair<const NodeDef*, bool>> stack;
+  auto depends_on_input = [&depends](const NodeDef& node) {
+    for (const string& input : node.input()) {
+      auto found = depends.find(NodeName(input));
+      if (found != depends.end() && found->second) {
+        return true;
+      }
+    }
+    return false;
+  };
+  for (const NodeDef& root : graph.node()) {
+    stack.emplace_back(&root, false);
+    while (!stack.empty()) {
+      const NodeDef* node = stack.back().first;
+      const bool expanded = stack.back().second;
+      stack.pop_back();
+      if (expanded) {
+        depends[node->name()] = candidates.count(node->name()) > 0 ||
+                                IsControlFlow(*node) ||
+                                depends_on_input(*node);
+        continue;
+      }
+      // Back edges of loops are ignored, the nodes of loops being excluded
+      // anyway.
+      if (depends.count(node->name()) > 0 ||
+          !visiting.insert(node->name()).second) {
+        continue;
+      }
+      stack.emplace_back(node, true);
+      for (const string& input : node->input()) {
+        const NodeDef* input_node = node_map_->GetNode(input);
+        if (input_node != nullptr &&
+            depends.count(input_node->name()) == 0) {
+          stack.emplace_back(input_node, false);
+        }
+      }
+    }
+  }
+
+  std::unordered_set<string> independent;
+  for (const string& candidate : candidates) {
+    if (!depends_on_input(*node_map_->GetNode(candidate))) {
+      independent.insert(candidate);
+    }
+  }
+  return independent;
+}
+
+bool MultiApplyOptimizer::FuseGroup(const std::vector<const NodeDef*>& group) {
+  const NodeDef& first = *group.front();
+  const MultiApplyOp& op = MultiApplyOps().at(first.op());
+
+  NodeDef fused;
+  string name = strings::StrCat(first.name(), "_multi_apply");
+  for (int i = 1; node_names_.find(name) != node_names_.end(); ++i) {
+    name = strings::StrCat(first.name(), "_multi_apply_", i);
+  }
+  fused.set_name(name);
+  fused.set_op(op.fused_op);
+  fused.set_device(first.device());
+  // The list of each input of the apply ops.
+  for (int input = 0; input < op.num_inputs; ++input) {
+    for (const NodeDef* node : group) {
+      *fused.add_input() = node->input(input);
+    }
+  }
+  // The fused node runs after the control inputs of all the nodes it groups,
+  // and is colocated with all their colocation groups.
+  std::unordered_set<string> control_inputs;
+  std::unordered_set<string> colocation_groups;
+  AttrValue colocation;
+  for (const NodeDef* node : group) {
+    for (const string& input : node->input()) {
+      if (IsControlInput(input) && control_inputs.insert(input).second) {
+        *fused.add_input() = input;
+      }
+    }
+    auto attr = node->attr().find("_class");
+    if (attr != node->attr().end()) {
+      for (const string& group_name : attr->second.list().s()) {
+        if (colocation_groups.insert(group_name).second) {
+          colocation.mutable_list()->add_s(group_name);
+        }
+      }
+    }
+  }
+  *fused.mutable_attr() = first.attr();
+  fused.mutable_attr()->erase("_output_shapes");
+  fused.mutable_attr()->erase("_class");
+  if (!colocation_groups.empty()) {
+    (*fused.mutable_attr())["_class"] = colocation;
+  }
+  (*fused.mutable_attr())["N"].set_i(group.size());
+  if (!HasFusedKernel(fused)) {
+    return false;
+  }
+
+  for (const NodeDef* node : group) {
+    NodeDef& replaced = replaced_nodes_[node->name()];
+    replaced.set_name(node->name());
+    replaced.set_op("NoOp");
+    replaced.set_device(node->device());
+    *replaced.add_input() = strings::StrCat("^", fused.name());
+  }
+  node_names_.insert(fused.name());
+  fused_nodes_.push_back(std::move(fused));
+  return true;
+}
+
+Status MultiApplyOptimizer::Optimize(Cluster* cluster,
+                                     const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  GraphDef graph = item.graph;
+  node_map_.reset(new NodeMap(&graph));
+  nodes_to_preserve_.clear();
+  node_names_.clear();
+  fused_nodes_.clear();
+  replaced_nodes_.clear();
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+
+  std::unordered_set<string> candidates;
+  for (const auto& node : graph.node()) {
+    node_names_.insert(node.name());
+    if (IsCandidate(node)) {
+      candidates.insert(node.name());
+    }
+  }
+  const std::unordered_set<string> independent =
+      IndependentCandidates(graph, candidates);
+
+  // Group the nodes by op, device and attributes, in the order of the graph.
+  std::vector<std::vector<const NodeDef*>> groups;
+  std::unordered_map<string, int> group_index;
+  for (const auto& node : graph.node()) {
+    if (independent.find(node.name()) == independent.end()) {
+      continue;
+    }
+    const string key = strings::StrCat(
+        node.op(), ";", node.device(), ";", GetAttrString(node, "T"), ";",
+        GetAttrString(node, "use_locking"), ";",
+        GetAttrString(node, "use_nesterov"));
+    auto inserted = group_index.emplace(key, groups.size());
+    if (inserted.second) {
+      groups.emplace_back();
+    }
+    groups[inserted.first->second].push_back(&node);
+  }
+  int num_grouped = 0;
+  for (const auto& group : groups) {
+    if (group.size() >= 2 && FuseGroup(group)) {
+      num_grouped += group.size();
+    }
+  }
+
+  optimized_graph->Clear();
+  for (const auto& node : graph.node()) {
+    auto replaced = replaced_nodes_.find(node.name());
+    if (replaced != replaced_nodes_.end()) {
+      *optimized_graph->add_node() = replaced->second;
+    } else {
+      *optimized_graph->add_node() = node;
+    }
+  }
+  for (const auto& fused : fused_nodes_) {
+    *optimized_graph->add_node() = fused;
+  }
+  *optimized_graph->mutable_versions() = graph.versions();
+  *optimized_graph->mutable_library() = graph.library();
+
+  VLOG(1) << "Grouped " << num_grouped << " apply nodes into "
+          << fused_nodes_.size() << " multi-apply nodes.";
+  node_map_.reset();
+  node_names_.clear();
+  fused_nodes_.clear();
+  replaced_nodes_.clear();
+  return Status::OK();
+}
+
+void MultiApplyOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                   const GraphDef& optimized_graph,
+                                   double result) {
+  // Nothing to do for MultiApplyOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,76 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_MULTI_APPLY_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_MULTI_APPLY_OPTIMIZER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Groups the dense ApplyAdam, ApplyMomentum and ApplyRMSProp nodes (and their
+// resource variants) which run on the same device with the same attributes
+// into a single _MultiApply* node, which updates all their variables in one
+// pass instead of one kernel launch per variable.
+// Each grouped node is replaced by a NoOp of the same name that runs after the
+// multi-apply node, so that the nodes having a control dependency on it still
+// run after the update. The nodes whose output is read, which depend on
+// another apply node or which run in a conditional or a loop are left alone.
+class MultiApplyOptimizer : public GraphOptimizer {
+ public:
+  MultiApplyOptimizer() {}
+  ~MultiApplyOptimizer() override {}
+
+  string name() const override { return "multi_apply_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns true if `node` is an apply node which may be grouped, ignoring
+  // its ancestors.
+  bool IsCandidate(const NodeDef& node) const;
+
+  // Returns the names of the candidates which have neither a candidate nor a
+  // control flow node among their ancestors.
+  std::unordered_set<string> IndependentCandidates(
+      const GraphDef& graph, const std::unordered_set<string>& candidates);
+
+  // Groups the apply nodes in `group` into a multi-apply node. Returns false if
+  // there is no kernel for it.
+  bool FuseGroup(const std::vector<const NodeDef*>& group);
+
+  std::unique_ptr<NodeMap> node_map_;
+  std::unordered_set<string> nodes_to_preserve_;
+  // The names of the nodes of the graph, including the multi-apply nodes.
+  std::unordered_set<string> node_names_;
+  // The multi-apply nodes, which are added to the graph.
+  std::vector<NodeDef> fused_nodes_;
+  // The NoOps replacing the grouped nodes, keyed by their name.
+  std::unordered_map<string, NodeDef> replaced_nodes_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_MULTI_APPLY_OPTIMIZER_H_
@@ -0,0 +1,163 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/multi_apply_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class MultiApplyOptimizerTest : public ::testing::Test {
+ protected:
+  // Adds an ApplyMomentum node named `name` updating a new variable.
+  Output AddMomentum(const Scope& s, const string& name,
+                     bool use_nesterov = false) {
+    Output var = ops::Variable(s.WithOpName(name + "_var"), {2}, DT_FLOAT);
+    Output accum = ops::Variable(s.WithOpName(name + "_accum"), {2}, DT_FLOAT);
+    Output grad = ops::Placeholder(s.WithOpName(name + "_grad"), DT_FLOAT);
+    Output lr = ops::Const(s.WithOpName(name + "_lr"), 0.1f);
+    Output momentum = ops::Const(s.WithOpName(name + "_momentum"), 0.9f);
+    return ops::ApplyMomentum(s.WithOpName(name), var, accum, lr, grad,
+                              momentum,
+                              ops::ApplyMomentum::UseNesterov(use_nesterov));
+  }
+};
+
+TEST_F(MultiApplyOptimizerTest, GroupApplyAdam) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  std::vector<Output> applies;
+  for (const string name : {"adam0", "adam1"}) {
+    Output var = ops::Variable(s.WithOpName(name + "_var"), {2}, DT_FLOAT);
+    Output m = ops::Variable(s.WithOpName(name + "_m"), {2}, DT_FLOAT);
+    Output v = ops::Variable(s.WithOpName(name + "_v"), {2}, DT_FLOAT);
+    Output grad = ops::Placeholder(s.WithOpName(name + "_grad"), DT_FLOAT);
+    Output scalar = ops::Const(s.WithOpName(name + "_scalar"), 0.5f);
+    applies.push_back(ops::ApplyAdam(s.WithOpName(name), var, m, v, scalar,
+                                     scalar, scalar, scalar, scalar, scalar,
+                                     grad));
+  }
+  ops::NoOp train(s.WithOpName("train").WithControlDependencies(applies));
+
+  GrapplerItem item;
+  item.fetch.push_back("train");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size() + 1, output.node_size());
+  const NodeDef* fused = node_map.GetNode("adam0_multi_apply");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_MultiApplyAdam", fused->op());
+  EXPECT_EQ(2, fused->attr().at("N").i());
+  ASSERT_EQ(20, fused->input_size());
+  EXPECT_EQ("adam0_var", fused->input(0));
+  EXPECT_EQ("adam1_var", fused->input(1));
+  EXPECT_EQ("adam0_m", fused->input(2));
+  EXPECT_EQ("adam1_m", fused->input(3));
+  EXPECT_EQ("adam0_grad", fused->input(18));
+  EXPECT_EQ("adam1_grad", fused->input(19));
+  for (const string name : {"adam0", "adam1"}) {
+    const NodeDef* replaced = node_map.GetNode(name);
+    ASSERT_NE(nullptr, replaced);
+    EXPECT_EQ("NoOp", replaced->op());
+    ASSERT_EQ(1, replaced->input_size());
+    EXPECT_EQ("^adam0_multi_apply", replaced->input(0));
+  }
+  EXPECT_EQ("^adam0", node_map.GetNode("train")->input(0));
+  EXPECT_EQ("^adam1", node_map.GetNode("train")->input(1));
+}
+
+TEST_F(MultiApplyOptimizerTest, GroupByAttributes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output momentum0 = AddMomentum(s, "momentum0");
+  Output nesterov = AddMomentum(s, "nesterov", true);
+  Output momentum1 = AddMomentum(s, "momentum1");
+  ops::NoOp train(s.WithOpName("train").WithControlDependencies(
+      {momentum0, nesterov, momentum1}));
+
+  GrapplerItem item;
+  item.fetch.push_back("train");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* fused = node_map.GetNode("momentum0_multi_apply");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_MultiApplyMomentum", fused->op());
+  EXPECT_EQ(2, fused->attr().at("N").i());
+  EXPECT_FALSE(fused->attr().at("use_nesterov").b());
+  EXPECT_EQ("NoOp", node_map.GetNode("momentum0")->op());
+  EXPECT_EQ("NoOp", node_map.GetNode("momentum1")->op());
+  EXPECT_EQ("ApplyMomentum", node_map.GetNode("nesterov")->op());
+}
+
+TEST_F(MultiApplyOptimizerTest, DoNotGroupReadOutput) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output momentum0 = AddMomentum(s, "momentum0");
+  Output momentum1 = AddMomentum(s, "momentum1");
+  Output read = ops::Identity(s.WithOpName("read"), momentum1);
+
+  GrapplerItem item;
+  item.fetch.push_back("read");
+  item.fetch.push_back("momentum0");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("ApplyMomentum", node_map.GetNode("momentum0")->op());
+  EXPECT_EQ("ApplyMomentum", node_map.GetNode("momentum1")->op());
+}
+
+TEST_F(MultiApplyOptimizerTest, DoNotGroupDependentApplies) {
+  // The second update runs after the first one, so they can't be grouped.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output momentum0 = AddMomentum(s, "momentum0");
+  Output momentum1 =
+      AddMomentum(s.WithControlDependencies({momentum0}), "momentum1");
+  ops::NoOp train(s.WithOpName("train").WithControlDependencies({momentum1}));
+
+  GrapplerItem item;
+  item.fetch.push_back("train");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  MultiApplyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("ApplyMomentum", node_map.GetNode("momentum0")->op());
+  EXPECT_EQ("ApplyMomentum", node_map.GetNode("momentum1")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
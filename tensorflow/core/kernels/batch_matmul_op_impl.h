@@ -17,6 +17,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <type_traits>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op.h"
@@ -188,6 +189,93 @@ struct SequentialMatMulKernel {
   }
 };
 
+template <typename Tx, typename Ty, typename Tz>
+static void LazyMultiply(bool adj_x, bool adj_y, Tx x, Ty y, Tz z) {
+  if (!adj_x) {
+    if (!adj_y) {
+      z.noalias() = x.lazyProduct(y);
+    } else {
+      z.noalias() = x.lazyProduct(y.adjoint());
+    }
+  } else {
+    if (!adj_y) {
+      z.noalias() = x.adjoint().lazyProduct(y);
+    } else {
+      z.noalias() = x.adjoint().lazyProduct(y.adjoint());
+    }
+  }
+}
+
+// Batch matmul kernel for batches of small square matrices, as in attention
+// and capsule layers. For a size known at compile time, Eigen evaluates the
+// product coefficient by coefficient with unrolled, vectorized inner loops,
+// while its general matrix product spends more time packing the operands
+// of such small matrices than multiplying them. From 32x32 on, the general
+// product is faster again. Only instantiated for float and double, to
+// bound the compile time.
+template <typename Scalar,
+          bool Enabled = std::is_same<Scalar, float>::value ||
+                         std::is_same<Scalar, double>::value>
+struct SmallMatMulKernel {
+  // Returns the size of the matrices of "in_x" and "in_y" if they are all
+  // square matrices of a size with a specialized kernel, and 0 otherwise.
+  static int FixedSize(const Tensor& in_x, const Tensor& in_y) {
+    const int64 size = in_x.dim_size(1);
+    if (in_x.dim_size(2) != size || in_y.dim_size(1) != size ||
+        in_y.dim_size(2) != size) {
+      return 0;
+    }
+    switch (size) {
+      case 4:
+      case 8:
+      case 16:
+        return size;
+      default:
+        return 0;
+    }
+  }
+
+  static void Run(int size, const Tensor& in_x, const Tensor& in_y,
+                  bool adj_x, bool adj_y, Tensor* out, int start, int limit) {
+    switch (size) {
+      case 4:
+        return Run<4>(in_x, in_y, adj_x, adj_y, out, start, limit);
+      case 8:
+        return Run<8>(in_x, in_y, adj_x, adj_y, out, start, limit);
+      case 16:
+        return Run<16>(in_x, in_y, adj_x, adj_y, out, start, limit);
+      default:
+        LOG(FATAL) << "No kernel for matrices of size " << size;
+    }
+  }
+
+ private:
+  template <int Size>
+  static void Run(const Tensor& in_x, const Tensor& in_y, bool adj_x,
+                  bool adj_y, Tensor* out, int start, int limit) {
+    using Matrix = Eigen::Matrix<Scalar, Size, Size, Eigen::RowMajor>;
+    const Scalar* x_data = in_x.flat<Scalar>().data();
+    const Scalar* y_data = in_y.flat<Scalar>().data();
+    Scalar* z_data = out->flat<Scalar>().data();
+    for (int64 i = start; i < limit; ++i) {
+      Eigen::Map<const Matrix> x(x_data + i * Size * Size);
+      Eigen::Map<const Matrix> y(y_data + i * Size * Size);
+      Eigen::Map<Matrix> z(z_data + i * Size * Size);
+      LazyMultiply(adj_x, adj_y, x, y, z);
+    }
+  }
+};
+
+template <typename Scalar>
+struct SmallMatMulKernel<Scalar, false> {
+  static int FixedSize(const Tensor& in_x, const Tensor& in_y) { return 0; }
+
+  static void Run(int size, const Tensor& in_x, const Tensor& in_y,
+                  bool adj_x, bool adj_y, Tensor* out, int start, int limit) {
+    LOG(FATAL) << "No small matrix kernel for this type";
+  }
+};
+
 }  // namespace
 
 template <typename Device, typename Scalar>
@@ -209,7 +297,18 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
                                    out->dim_size(2));
     const int64 kMaxCostOuterParallelism = 128 * 256 * 256;  // heuristic.
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    if (min_dim > 1 &&
+    const int fixed_size = SmallMatMulKernel<Scalar>::FixedSize(in_x, in_y);
+    if (fixed_size > 0) {
+      // Parallelize over outer dims only; a single small product is far
+      // too cheap to split. The cost counts a multiply-add per inner step.
+      Shard(worker_threads.num_threads, worker_threads.workers, num_units,
+            2 * cost_per_unit,
+            [fixed_size, &in_x, &in_y, adj_x, adj_y, out](int start,
+                                                          int limit) {
+              SmallMatMulKernel<Scalar>::Run(fixed_size, in_x, in_y, adj_x,
+                                             adj_y, out, start, limit);
+            });
+    } else if (min_dim > 1 &&
         (num_units == 1 || cost_per_unit > kMaxCostOuterParallelism)) {
       // Parallelize over inner dims.
       // For large matrix products it is counter-productive to parallelize
@@ -315,29 +414,9 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
     OP_REQUIRES(context, stream, errors::Internal("No GPU stream available."));
 
     typedef perftools::gputools::DeviceMemory<Scalar> DeviceMemoryType;
-    std::vector<DeviceMemoryType> a_device_memory;
-    std::vector<DeviceMemoryType> b_device_memory;
-    std::vector<DeviceMemoryType> c_device_memory;
-    std::vector<DeviceMemoryType*> a_ptrs;
-    std::vector<DeviceMemoryType*> b_ptrs;
-    std::vector<DeviceMemoryType*> c_ptrs;
-    a_device_memory.reserve(batch_size);
-    b_device_memory.reserve(batch_size);
-    c_device_memory.reserve(batch_size);
-    a_ptrs.reserve(batch_size);
-    b_ptrs.reserve(batch_size);
-    c_ptrs.reserve(batch_size);
     auto* a_base_ptr = in_x.template flat<Scalar>().data();
     auto* b_base_ptr = in_y.template flat<Scalar>().data();
     auto* c_base_ptr = out->template flat<Scalar>().data();
-    for (int64 i = 0; i < batch_size; ++i) {
-      a_device_memory.push_back(AsDeviceMemory(a_base_ptr + i * m * k));
-      b_device_memory.push_back(AsDeviceMemory(b_base_ptr + i * k * n));
-      c_device_memory.push_back(AsDeviceMemory(c_base_ptr + i * m * n));
-      a_ptrs.push_back(&a_device_memory.back());
-      b_ptrs.push_back(&b_device_memory.back());
-      c_ptrs.push_back(&c_device_memory.back());
-    }
 
     // Cublas does
     // C = A x B
@@ -348,6 +427,9 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
     if (batch_size == 1) {
       // This is a regular matrix*matrix or matrix*vector multiply. Avoid the
       // overhead of the scratch allocator and the batch interface.
+      DeviceMemoryType a_device_memory = AsDeviceMemory(a_base_ptr);
+      DeviceMemoryType b_device_memory = AsDeviceMemory(b_base_ptr);
+      DeviceMemoryType c_device_memory = AsDeviceMemory(c_base_ptr);
       if (n == 1 &&
           blas_transpose_b !=
               perftools::gputools::blas::Transpose::kConjugateTranspose &&
@@ -365,9 +447,9 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
         bool blas_launch_status =
             stream
                 ->ThenBlasGemv(gemv_trans_a, adj_x ? m : k, adj_x ? k : m,
-                               static_cast<Scalar>(1.0), *(a_ptrs[0]),
-                               adj_x ? m : k, *(b_ptrs[0]), 1,
-                               static_cast<Scalar>(0.0), c_ptrs[0], 1)
+                               static_cast<Scalar>(1.0), a_device_memory,
+                               adj_x ? m : k, b_device_memory, 1,
+                               static_cast<Scalar>(0.0), &c_device_memory, 1)
                 .ok();
         if (!blas_launch_status) {
           context->SetStatus(errors::Internal(
@@ -379,9 +461,9 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
         bool blas_launch_status =
             stream
                 ->ThenBlasGemm(blas_transpose_b, blas_transpose_a, n, m, k,
-                               static_cast<Scalar>(1.0), *(b_ptrs[0]),
-                               adj_y ? k : n, *(a_ptrs[0]), adj_x ? m : k,
-                               static_cast<Scalar>(0.0), c_ptrs[0], n)
+                               static_cast<Scalar>(1.0), b_device_memory,
+                               adj_y ? k : n, a_device_memory, adj_x ? m : k,
+                               static_cast<Scalar>(0.0), &c_device_memory, n)
                 .ok();
         if (!blas_launch_status) {
           context->SetStatus(errors::Internal(
@@ -391,6 +473,48 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
         }
       }
     } else {
+#if CUDA_VERSION >= 8000
+      // The inputs and the output are contiguous, so the i-th matrices are at
+      // a fixed stride from the first ones and cuBLAS can compute the batch
+      // without the device arrays of pointers the batch interface needs.
+      DeviceMemoryType c_memory = AsDeviceMemory(c_base_ptr);
+      bool blas_launch_status =
+          stream
+              ->ThenBlasGemmStridedBatched(
+                  blas_transpose_b, blas_transpose_a, n, m, k,
+                  static_cast<Scalar>(1.0), AsDeviceMemory(b_base_ptr),
+                  adj_y ? k : n, k * n, AsDeviceMemory(a_base_ptr),
+                  adj_x ? m : k, m * k, static_cast<Scalar>(0.0), &c_memory,
+                  n, m * n, batch_size)
+              .ok();
+      if (!blas_launch_status) {
+        context->SetStatus(errors::Internal(
+            "Blas xGEMMStridedBatched launch failed : a.shape=",
+            in_x.shape().DebugString(),
+            ", b.shape=", in_y.shape().DebugString(), ", m=", m, ", n=", n,
+            ", k=", k, ", batch_size=", batch_size));
+      }
+#else
+      std::vector<DeviceMemoryType> a_device_memory;
+      std::vector<DeviceMemoryType> b_device_memory;
+      std::vector<DeviceMemoryType> c_device_memory;
+      std::vector<DeviceMemoryType*> a_ptrs;
+      std::vector<DeviceMemoryType*> b_ptrs;
+      std::vector<DeviceMemoryType*> c_ptrs;
+      a_device_memory.reserve(batch_size);
+      b_device_memory.reserve(batch_size);
+      c_device_memory.reserve(batch_size);
+      a_ptrs.reserve(batch_size);
+      b_ptrs.reserve(batch_size);
+      c_ptrs.reserve(batch_size);
+      for (int64 i = 0; i < batch_size; ++i) {
+        a_device_memory.push_back(AsDeviceMemory(a_base_ptr + i * m * k));
+        b_device_memory.push_back(AsDeviceMemory(b_base_ptr + i * k * n));
+        c_device_memory.push_back(AsDeviceMemory(c_base_ptr + i * m * n));
+        a_ptrs.push_back(&a_device_memory.back());
+        b_ptrs.push_back(&b_device_memory.back());
+        c_ptrs.push_back(&c_device_memory.back());
+      }
       CublasScratchAllocator scratch_allocator(context);
       bool blas_launch_status =
           stream
@@ -407,6 +531,7 @@ struct LaunchBatchMatMul<GPUDevice, Scalar> {
             ", b.shape=", in_y.shape().DebugString(), ", m=", m, ", n=", n,
             ", k=", k, ", batch_size=", batch_size));
       }
+#endif  // CUDA_VERSION >= 8000
     }
   }
 };
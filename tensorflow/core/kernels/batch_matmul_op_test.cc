@@ -103,6 +103,14 @@ BM_BatchMatmul(32, 256, 256, 256, false, false);
 BM_BatchMatmul(32, 1024, 1024, 1024, false, false);
 BM_BatchMatmul(32, 2048, 2048, 2048, false, false);
 
+// Batches of small square matrices, as in attention and capsule layers.
+BM_BatchMatmul(10000, 4, 4, 4, false, false);
+BM_BatchMatmul(10000, 8, 8, 8, false, false);
+BM_BatchMatmul(10000, 8, 8, 8, true, false);
+BM_BatchMatmul(10000, 16, 16, 16, false, false);
+BM_BatchMatmul(10000, 16, 16, 16, false, true);
+BM_BatchMatmul(1000, 32, 32, 32, false, false);
+
 // Matrix-vector multiplies.
 BM_BatchMatmul(1, 10000, 200, 1, false, false);
 BM_BatchMatmul(8, 10000, 200, 1, false, false);
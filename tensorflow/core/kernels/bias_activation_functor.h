@@ -0,0 +1,95 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
+#define TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
+// Functor definition for the fused convolution and matrix multiplication ops,
+// must be compilable by nvcc.
+
+#include <string>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The activations that the fused ops apply after adding their bias.
+enum class FusedActivation { kIdentity, kRelu, kRelu6 };
+
+// Parses the "activation" attr of the fused ops.  Returns false if the name
+// is not that of a FusedActivation.
+inline bool FusedActivationFromString(const std::string& name,
+                                      FusedActivation* activation) {
+  if (name == "Identity") {
+    *activation = FusedActivation::kIdentity;
+  } else if (name == "Relu") {
+    *activation = FusedActivation::kRelu;
+  } else if (name == "Relu6") {
+    *activation = FusedActivation::kRelu6;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Functor used by the fused ops to finish their output.
+template <typename Device, typename T>
+struct BiasActivation {
+  // Add "bias" to "output" in place, broadcasting it on the first and last
+  // dimensions, and apply "activation" to the sum, in a single pass over
+  // "output".
+  void operator()(const Device& d, typename TTypes<T>::ConstVec bias,
+                  FusedActivation activation,
+                  typename TTypes<T, 3>::Tensor output) {
+    if (output.dimension(2) == 1) {
+      // The bias is the innermost dimension, as in NHWC, so it repeats along
+      // the flattened output.
+      Eigen::DSizes<Eigen::DenseIndex, 1> one_d(output.size());
+      Eigen::DSizes<Eigen::DenseIndex, 1> bcast(output.dimension(0));
+      Apply(d, activation, output.reshape(one_d),
+            output.reshape(one_d) + bias.broadcast(bcast));
+    } else {
+      Eigen::DSizes<Eigen::DenseIndex, 3> bias_shape(1, bias.dimension(0), 1);
+      Eigen::DSizes<Eigen::DenseIndex, 3> bcast(output.dimension(0), 1,
+                                                output.dimension(2));
+      Apply(d, activation, output,
+            output + bias.reshape(bias_shape).broadcast(bcast));
+    }
+  }
+
+ private:
+  template <typename Output, typename Sum>
+  static void Apply(const Device& d, FusedActivation activation, Output output,
+                    const Sum& sum) {
+    switch (activation) {
+      case FusedActivation::kIdentity:
+        output.device(d) = sum;
+        break;
+      case FusedActivation::kRelu:
+        output.device(d) = sum.cwiseMax(static_cast<T>(0));
+        break;
+      case FusedActivation::kRelu6:
+        output.device(d) =
+            sum.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+        break;
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
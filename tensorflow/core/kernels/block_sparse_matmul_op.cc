@@ -0,0 +1,274 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+typedef Eigen::internal::packet_traits<float>::type Packet;
+// Blocks narrower than a packet, or their remaining columns, are computed with
+// half packets.
+typedef Eigen::internal::unpacket_traits<Packet>::half HalfPacket;
+
+// The rows of the product and packets of columns accumulated in registers at a
+// time, so that each block of values is loaded once for several rows.
+static const int kTileRows = 4;
+static const int kTilePackets = 2;
+
+// Computes the kRows x kPackets packets of the product of the rows 'a' of
+// stride 'depth' by the 'num_blocks' blocks of 'b' starting at 'values', of
+// stride 'block_size', at rows 'rows', into 'out' of stride 'out_stride'.
+template <typename P, int kRows, int kPackets>
+void MultiplyTile(const float* a, int64 depth, const float* values,
+                  const int32* rows, int64 num_blocks, int64 block_size,
+                  float* out, int64 out_stride) {
+  using Eigen::internal::pmadd;
+  using Eigen::internal::pset1;
+  using Eigen::internal::ploadu;
+  using Eigen::internal::pstoreu;
+  const int kSize = Eigen::internal::unpacket_traits<P>::size;
+  P acc[kRows][kPackets];
+  for (int r = 0; r < kRows; ++r) {
+    for (int p = 0; p < kPackets; ++p) {
+      acc[r][p] = pset1<P>(0.0f);
+    }
+  }
+  for (int64 i = 0; i < num_blocks; ++i, values += block_size) {
+    P b[kPackets];
+    for (int p = 0; p < kPackets; ++p) {
+      b[p] = ploadu<P>(values + p * kSize);
+    }
+    for (int r = 0; r < kRows; ++r) {
+      const P a_r = pset1<P>(a[r * depth + rows[i]]);
+      for (int p = 0; p < kPackets; ++p) {
+        acc[r][p] = pmadd(a_r, b[p], acc[r][p]);
+      }
+    }
+  }
+  for (int r = 0; r < kRows; ++r) {
+    for (int p = 0; p < kPackets; ++p) {
+      pstoreu(out + r * out_stride + p * kSize, acc[r][p]);
+    }
+  }
+}
+
+// Computes the columns from 'col' of the product of the kRows rows 'a' by the
+// blocks of 'b' of a group of columns which fill packets of type P. Returns
+// the first column left.
+template <typename P, int kRows>
+int64 MultiplyPackets(const float* a, int64 depth, const float* values,
+                      const int32* rows, int64 num_blocks, int64 block_size,
+                      int64 col, float* out, int64 out_stride) {
+  const int kSize = Eigen::internal::unpacket_traits<P>::size;
+  const int kTileSize = kTilePackets * kSize;
+  for (; col + kTileSize <= block_size; col += kTileSize) {
+    MultiplyTile<P, kRows, kTilePackets>(a, depth, values + col, rows,
+                                         num_blocks, block_size, out + col,
+                                         out_stride);
+  }
+  for (; col + kSize <= block_size; col += kSize) {
+    MultiplyTile<P, kRows, 1>(a, depth, values + col, rows, num_blocks,
+                              block_size, out + col, out_stride);
+  }
+  return col;
+}
+
+// Computes the 'block_size' columns of the product of the kRows rows 'a' by
+// the blocks of 'b' of a group of columns.
+template <int kRows>
+void MultiplyRows(const float* a, int64 depth, const float* values,
+                  const int32* rows, int64 num_blocks, int64 block_size,
+                  float* out, int64 out_stride) {
+  int64 col = MultiplyPackets<Packet, kRows>(a, depth, values, rows,
+                                             num_blocks, block_size, 0, out,
+                                             out_stride);
+  col = MultiplyPackets<HalfPacket, kRows>(a, depth, values, rows, num_blocks,
+                                           block_size, col, out, out_stride);
+  for (; col < block_size; ++col) {
+    for (int r = 0; r < kRows; ++r) {
+      float sum = 0.0f;
+      const float* value = values + col;
+      for (int64 i = 0; i < num_blocks; ++i, value += block_size) {
+        sum += a[r * depth + rows[i]] * *value;
+      }
+      out[r * out_stride + col] = sum;
+    }
+  }
+}
+
+// Computes the 'block_size' columns of the product of the 'num_rows' rows 'a'
+// by the blocks of 'b' of a group of columns, by tiles of kTileRows rows.
+void MultiplyGroup(const float* a, int64 num_rows, int64 depth,
+                   const float* values, const int32* rows, int64 num_blocks,
+                   int64 block_size, float* out, int64 out_stride) {
+  for (int64 r = 0; r < num_rows; r += kTileRows) {
+    const float* a_tile = a + r * depth;
+    float* out_tile = out + r * out_stride;
+    switch (std::min<int64>(kTileRows, num_rows - r)) {
+      case 4:
+        MultiplyRows<4>(a_tile, depth, values, rows, num_blocks, block_size,
+                        out_tile, out_stride);
+        break;
+      case 3:
+        MultiplyRows<3>(a_tile, depth, values, rows, num_blocks, block_size,
+                        out_tile, out_stride);
+        break;
+      case 2:
+        MultiplyRows<2>(a_tile, depth, values, rows, num_blocks, block_size,
+                        out_tile, out_stride);
+        break;
+      default:
+        MultiplyRows<1>(a_tile, depth, values, rows, num_blocks, block_size,
+                        out_tile, out_stride);
+    }
+  }
+}
+
+}  // namespace
+
+// The product of a dense matrix by a matrix stored by blocks of a row and
+// consecutive columns, such as pruned weights. Each group of columns of the
+// product is accumulated in registers over the non-zero blocks of the group.
+class BlockSparseMatMulOp : public OpKernel {
+ public:
+  explicit BlockSparseMatMulOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b_values = ctx->input(1);
+    const Tensor& b_block_rows = ctx->input(2);
+    const Tensor& b_block_splits = ctx->input(3);
+    const Tensor& b_dense_shape = ctx->input(4);
+
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("a is not a matrix: ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(b_values.shape()),
+                errors::InvalidArgument("b_values is not a matrix: ",
+                                        b_values.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(b_block_rows.shape()),
+                errors::InvalidArgument("b_block_rows is not a vector: ",
+                                        b_block_rows.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(b_block_splits.shape()),
+                errors::InvalidArgument("b_block_splits is not a vector: ",
+                                        b_block_splits.shape().DebugString()));
+    OP_REQUIRES(ctx, b_dense_shape.shape() == TensorShape({2}),
+                errors::InvalidArgument("b_dense_shape is not of shape [2]: ",
+                                        b_dense_shape.shape().DebugString()));
+
+    const int64 num_blocks = b_values.dim_size(0);
+    const int64 block_size = b_values.dim_size(1);
+    const int64 rows = a.dim_size(0);
+    const int64 depth = b_dense_shape.vec<int64>()(0);
+    const int64 cols = b_dense_shape.vec<int64>()(1);
+    OP_REQUIRES(ctx, a.dim_size(1) == depth,
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: a: ", a.shape().DebugString(),
+                    ", b: [", depth, ", ", cols, "]"));
+    OP_REQUIRES(ctx, cols >= 0 && (cols == 0 || block_size > 0),
+                errors::InvalidArgument("Invalid block size ", block_size,
+                                        " for ", cols, " columns"));
+    OP_REQUIRES(ctx, b_block_rows.NumElements() == num_blocks,
+                errors::InvalidArgument(
+                    "b_block_rows has ", b_block_rows.NumElements(),
+                    " rows for ", num_blocks, " blocks"));
+    const int64 num_groups =
+        cols == 0 ? 0 : (cols + block_size - 1) / block_size;
+    OP_REQUIRES(ctx, b_block_splits.NumElements() == num_groups + 1,
+                errors::InvalidArgument(
+                    "b_block_splits has ", b_block_splits.NumElements(),
+                    " splits for ", num_groups, " groups of columns"));
+
+    const auto block_rows = b_block_rows.vec<int32>();
+    const auto block_splits = b_block_splits.vec<int32>();
+    OP_REQUIRES(ctx,
+                block_splits(0) == 0 && block_splits(num_groups) == num_blocks,
+                errors::InvalidArgument(
+                    "b_block_splits must start at 0 and end at ", num_blocks));
+    for (int64 g = 0; g < num_groups; ++g) {
+      OP_REQUIRES(ctx, block_splits(g) <= block_splits(g + 1),
+                  errors::InvalidArgument("b_block_splits must not decrease"));
+    }
+    for (int64 i = 0; i < num_blocks; ++i) {
+      OP_REQUIRES(ctx, block_rows(i) >= 0 && block_rows(i) < depth,
+                  errors::InvalidArgument("Block row ", block_rows(i),
+                                          " is out of range [0, ", depth,
+                                          ")"));
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_output(0, TensorShape({rows, cols}), &out));
+    if (out->NumElements() == 0) {
+      return;
+    }
+
+    const float* a_data = a.flat<float>().data();
+    const float* values = b_values.flat<float>().data();
+    const int32* rows_data = block_rows.data();
+    const int32* splits_data = block_splits.data();
+    float* out_data = out->flat<float>().data();
+    auto multiply_groups = [&](int64 start, int64 limit) {
+      // The last group of columns may be narrower than the blocks.
+      std::vector<float> partial;
+      for (int64 g = start; g < limit; ++g) {
+        const int64 col = g * block_size;
+        const int64 width = std::min(block_size, cols - col);
+        const int64 first_block = splits_data[g];
+        const int64 group_blocks = splits_data[g + 1] - first_block;
+        const float* group_values = values + first_block * block_size;
+        const int32* group_rows = rows_data + first_block;
+        if (width == block_size) {
+          MultiplyGroup(a_data, rows, depth, group_values, group_rows,
+                        group_blocks, block_size, out_data + col, cols);
+          continue;
+        }
+        partial.resize(rows * block_size);
+        MultiplyGroup(a_data, rows, depth, group_values, group_rows,
+                      group_blocks, block_size, partial.data(), block_size);
+        for (int64 r = 0; r < rows; ++r) {
+          memcpy(out_data + r * cols + col, partial.data() + r * block_size,
+                 width * sizeof(float));
+        }
+      }
+    };
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    const int64 cost_per_group =
+        std::max<int64>(1, rows * (num_blocks / num_groups + 1) * block_size);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_groups,
+          cost_per_group, multiply_groups);
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("_BlockSparseMatMul").Device(DEVICE_CPU),
+                        BlockSparseMatMulOp);
+
+}  // namespace tensorflow
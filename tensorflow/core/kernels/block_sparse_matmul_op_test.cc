@@ -0,0 +1,155 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class BlockSparseMatMulOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("block_sparse_matmul", "_BlockSparseMatMul")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT64))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Adds the inputs of 'b' of shape [depth, cols] stored by blocks of
+  // 'block_size' columns, skipping the blocks of zeros.
+  void AddBlockSparseInputs(const std::vector<float>& b, int depth, int cols,
+                            int block_size) {
+    std::vector<float> values;
+    std::vector<int32> block_rows;
+    std::vector<int32> block_splits = {0};
+    for (int col = 0; col < cols; col += block_size) {
+      for (int row = 0; row < depth; ++row) {
+        std::vector<float> block(block_size, 0.0f);
+        bool zero = true;
+        for (int c = col; c < std::min(col + block_size, cols); ++c) {
+          block[c - col] = b[row * cols + c];
+          zero &= block[c - col] == 0.0f;
+        }
+        if (!zero) {
+          values.insert(values.end(), block.begin(), block.end());
+          block_rows.push_back(row);
+        }
+      }
+      block_splits.push_back(block_rows.size());
+    }
+    const int64 num_blocks = block_rows.size();
+    AddInputFromArray<float>(TensorShape({num_blocks, block_size}), values);
+    AddInputFromArray<int32>(TensorShape({num_blocks}), block_rows);
+    AddInputFromArray<int32>(
+        TensorShape({static_cast<int64>(block_splits.size())}), block_splits);
+    AddInputFromArray<int64>(TensorShape({2}), {depth, cols});
+  }
+
+  // Checks the product of random 'a' of shape [rows, depth] by 'b' of shape
+  // [depth, cols] whose blocks are zero with probability 'sparsity'.
+  void TestRandomProduct(int rows, int depth, int cols, int block_size,
+                         float sparsity) {
+    MakeOp();
+    random::PhiloxRandom philox(7, 13);
+    random::SimplePhilox rnd(&philox);
+    std::vector<float> a(rows * depth);
+    for (float& value : a) {
+      value = rnd.RandFloat() - 0.5f;
+    }
+    std::vector<float> b(depth * cols, 0.0f);
+    for (int row = 0; row < depth; ++row) {
+      for (int col = 0; col < cols; col += block_size) {
+        if (rnd.RandFloat() < sparsity) {
+          continue;
+        }
+        for (int c = col; c < std::min(col + block_size, cols); ++c) {
+          b[row * cols + c] = rnd.RandFloat() - 0.5f;
+        }
+      }
+    }
+    AddInputFromArray<float>(TensorShape({rows, depth}), a);
+    AddBlockSparseInputs(b, depth, cols, block_size);
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_FLOAT, TensorShape({rows, cols}));
+    auto expected_matrix = expected.matrix<float>();
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        float sum = 0.0f;
+        for (int k = 0; k < depth; ++k) {
+          sum += a[r * depth + k] * b[k * cols + c];
+        }
+        expected_matrix(r, c) = sum;
+      }
+    }
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(BlockSparseMatMulOpTest, Small) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  // b is
+  //   [[1, 2, 0],
+  //    [0, 0, 3],
+  //    [0, 0, 0]]
+  // by blocks of two columns.
+  AddBlockSparseInputs({1, 2, 0, 0, 0, 3, 0, 0, 0}, 3, 3, 2);
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {1, 2, 6, 4, 8, 15});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(BlockSparseMatMulOpTest, RandomPacketBlocks) {
+  TestRandomProduct(5, 70, 130, 16, 0.8f);
+}
+
+TEST_F(BlockSparseMatMulOpTest, RandomOddBlocks) {
+  TestRandomProduct(3, 40, 37, 7, 0.5f);
+}
+
+TEST_F(BlockSparseMatMulOpTest, AllZero) {
+  TestRandomProduct(2, 10, 12, 4, 1.0f);
+}
+
+TEST_F(BlockSparseMatMulOpTest, InvalidBlockRow) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({1, 2}), {1, 2});
+  AddInputFromArray<int32>(TensorShape({1}), {2});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 1});
+  AddInputFromArray<int64>(TensorShape({2}), {2, 2});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString()).contains("out of range")) << s;
+}
+
+}  // namespace tensorflow
@@ -64,8 +64,24 @@ class CastOpBase : public OpKernel {
     if (work_ == nullptr) {
       ctx->set_output(0, inp);
     } else {
+      // Each element of the input is read before its result is written
+      // over it, so a cast between types of the same width can reuse the
+      // buffer of an input that has no other consumers.
+      std::unique_ptr<Tensor> forwarded;
+      if (CanCastInPlace()) {
+        forwarded = ctx->forward_input(0, src_dtype_, inp.shape(),
+                                       ctx->output_memory_type(0),
+                                       ctx->output_alloc_attr(0));
+      }
       Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, ctx->allocate_output(0, inp.shape(), &out));
+      if (forwarded != nullptr) {
+        Tensor in_place;
+        in_place.UnsafeCopyFromInternal(*forwarded, dst_dtype_, inp.shape());
+        ctx->set_output(0, in_place);
+        out = ctx->mutable_output(0);
+      } else {
+        OP_REQUIRES_OK(ctx, ctx->allocate_output(0, inp.shape(), &out));
+      }
       work_(ctx, inp, out);
     }
   }
@@ -75,6 +91,12 @@ class CastOpBase : public OpKernel {
   DataType dst_dtype_;
   std::function<void(OpKernelContext*, const Tensor&, Tensor*)> work_ = nullptr;
 
+  bool CanCastInPlace() const {
+    return DataTypeCanUseMemcpy(src_dtype_) &&
+           DataTypeCanUseMemcpy(dst_dtype_) &&
+           DataTypeSize(src_dtype_) == DataTypeSize(dst_dtype_);
+  }
+
   Status Unimplemented() {
     return errors::Unimplemented("Cast ", DataTypeString(src_dtype_), " to ",
                                  DataTypeString(dst_dtype_),
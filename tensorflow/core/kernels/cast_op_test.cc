@@ -91,6 +91,18 @@ TEST_ALL_CASTS_FROM(double)
 
 // TODO(wicke): check conversions from/to bool, and bfloat16
 
+// A cast between types of the same width reuses the buffer of an input
+// with no other consumers.
+TEST_F(CastOpTest, CastInPlace) {
+  MakeOp(DT_FLOAT, DT_INT32);
+  AddInputFromArray<float>(TensorShape({4}), {1.0f, 2.0f, 3.0f, 4.0f});
+  const char* input_data = GetInput(0).tensor_data().data();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({1, 2, 3, 4}),
+                                 *GetOutput(0));
+  EXPECT_EQ(input_data, GetOutput(0)->tensor_data().data());
+}
+
 static void BM_cpu_float_int64(int iters, int num) {
   testing::ItemsProcessed(static_cast<int64>(iters) * num);
   testing::BytesProcessed(static_cast<int64>(iters) * num *
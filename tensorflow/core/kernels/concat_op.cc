@@ -41,6 +41,67 @@ typedef Eigen::SyclDevice SYCLDevice;
 
 enum AxisArgumentName { NAME_IS_AXIS, NAME_IS_CONCAT_DIM };
 
+// Concatenates the rows "inputs" into the row "output" on the CPU if some
+// of them lie in the output, as when a static memory plan has let their
+// producers write them directly into their place (see executor.cc). Only
+// the inputs that are not in place are copied, after moving those that
+// lie elsewhere in the output out of the way. Sets *done to false, and
+// does nothing, if no input lies in the output.
+template <typename T>
+Status ConcatRowsInPlace(
+    OpKernelContext* c,
+    const std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>&
+        inputs,
+    typename TTypes<T, 2>::Matrix* output, bool* done) {
+  typedef std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>
+      ConstMatrixVector;
+  *done = false;
+  const T* begin = output->data();
+  const T* end = begin + output->size();
+  auto in_output = [begin, end](const T* data, int64 size) {
+    return data < end && begin < data + size;
+  };
+  bool any_in_output = false;
+  for (const auto& input : inputs) {
+    any_in_output |= in_output(input->data(), input->size());
+  }
+  if (!any_in_output) return Status::OK();
+
+  std::vector<Tensor> moved;
+  std::vector<const T*> srcs;
+  int64 offset = 0;
+  for (const auto& input : inputs) {
+    const T* data = input->data();
+    const int64 size = input->size();
+    if (data != begin + offset && in_output(data, size)) {
+      moved.emplace_back();
+      TF_RETURN_IF_ERROR(c->allocate_temp(DataTypeToEnum<T>::value,
+                                          TensorShape({1, size}),
+                                          &moved.back()));
+      auto moved_flat = moved.back().matrix<T>();
+      ConstMatrixVector src;
+      src.emplace_back(new typename TTypes<T, 2>::ConstMatrix(data, 1, size));
+      ConcatCPU<T>(c->device(), src, &moved_flat);
+      data = moved_flat.data();
+    }
+    srcs.push_back(data);
+    offset += size;
+  }
+  offset = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const int64 size = inputs[i]->size();
+    T* dst = output->data() + offset;
+    offset += size;
+    if (srcs[i] == dst) continue;
+    ConstMatrixVector src;
+    src.emplace_back(new typename TTypes<T, 2>::ConstMatrix(srcs[i], 1, size));
+    typename TTypes<T, 2>::Matrix dst_flat(dst, 1, size);
+    ConcatCPU<T>(c->device(), src, &dst_flat);
+  }
+  *done = true;
+  return Status::OK();
+}
+
 // --------------------------------------------------------------------------
 template <typename Device, typename T, AxisArgumentName AxisArgName>
 class ConcatBaseOp : public OpKernel {
@@ -143,6 +204,12 @@ class ConcatBaseOp : public OpKernel {
         return;
       }
 #endif // TENSORFLOW_USE_SYCL
+      if (inputs_flat_dim0 == 1) {
+        bool done;
+        OP_REQUIRES_OK(
+            c, ConcatRowsInPlace<T>(c, inputs_flat, &output_flat, &done));
+        if (done) return;
+      }
       ConcatCPU<T>(c->device(), inputs_flat, &output_flat);
     }
   }
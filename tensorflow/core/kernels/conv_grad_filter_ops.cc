@@ -774,7 +774,8 @@ class Conv2DSlowBackpropFilterOp : public OpKernel {
     };
     AlgorithmConfig algorithm_config;
     if (cudnn_use_autotune_ && !AutoTuneConvBwdFilter::GetInstance()->Find(
-                                   conv_parameters, &algorithm_config)) {
+                                   conv_parameters, AutoTuneDeviceKey(stream),
+                                   &algorithm_config)) {
       std::vector<AlgorithmType> algorithms;
       CHECK(stream->parent()->GetConvolveBackwardFilterAlgorithms(&algorithms));
       ProfileResult best_result;
@@ -818,8 +819,8 @@ class Conv2DSlowBackpropFilterOp : public OpKernel {
       algorithm_config.set_algorithm(best_result.algorithm());
       algorithm_config.set_algorithm_no_scratch(
           best_result_no_scratch.algorithm());
-      AutoTuneConvBwdFilter::GetInstance()->Insert(conv_parameters,
-                                                   algorithm_config);
+      AutoTuneConvBwdFilter::GetInstance()->Insert(
+          conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
     }
     CudnnScratchAllocator scratch_allocator(ConvolveBackwardFilterScratchSize,
                                             context);
@@ -854,7 +854,8 @@ class Conv2DSlowBackpropInputOp : public OpKernel {
     };
     AlgorithmConfig algorithm_config;
     if (cudnn_use_autotune_ && !AutoTuneConvBwdData::GetInstance()->Find(
-                                   conv_parameters, &algorithm_config)) {
+                                   conv_parameters, AutoTuneDeviceKey(stream),
+                                   &algorithm_config)) {
       std::vector<AlgorithmType> algorithms;
       CHECK(stream->parent()->GetConvolveBackwardDataAlgorithms(&algorithms));
       ProfileResult best_result;
@@ -897,8 +898,8 @@ class Conv2DSlowBackpropInputOp : public OpKernel {
       algorithm_config.set_algorithm(best_result.algorithm());
       algorithm_config.set_algorithm_no_scratch(
           best_result_no_scratch.algorithm());
-      AutoTuneConvBwdData::GetInstance()->Insert(conv_parameters,
-                                                 algorithm_config);
+      AutoTuneConvBwdData::GetInstance()->Insert(
+          conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
     }
     bool cudnn_launch_status =
         stream
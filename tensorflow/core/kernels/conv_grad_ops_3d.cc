@@ -654,7 +654,8 @@ class Conv3DBackpropInputOp<GPUDevice, T> : public OpKernel {
     using perftools::gputools::dnn::kDefaultAlgorithm;
     AlgorithmConfig algorithm_config;
     if (cudnn_use_autotune_ && !AutoTuneConv3dBwdData::GetInstance()->Find(
-                                   conv_parameters, &algorithm_config)) {
+                                   conv_parameters, AutoTuneDeviceKey(stream),
+                                   &algorithm_config)) {
       std::vector<AlgorithmType> algorithms;
       CHECK(stream->parent()->GetConvolveBackwardDataAlgorithms(&algorithms));
       ProfileResult best_result;
@@ -697,8 +698,8 @@ class Conv3DBackpropInputOp<GPUDevice, T> : public OpKernel {
       algorithm_config.set_algorithm(best_result.algorithm());
       algorithm_config.set_algorithm_no_scratch(
           best_result_no_scratch.algorithm());
-      AutoTuneConv3dBwdData::GetInstance()->Insert(conv_parameters,
-                                                   algorithm_config);
+      AutoTuneConv3dBwdData::GetInstance()->Insert(
+          conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
     }
     CudnnScratchAllocator scratch_allocator(ConvolveBackwardDataScratchSize,
                                             context);
@@ -1022,7 +1023,8 @@ class Conv3DBackpropFilterOp<GPUDevice, T> : public OpKernel {
     AlgorithmConfig algorithm_config;
 
     if (cudnn_use_autotune_ && !AutoTuneConv3dBwdFilter::GetInstance()->Find(
-                                   conv_parameters, &algorithm_config)) {
+                                   conv_parameters, AutoTuneDeviceKey(stream),
+                                   &algorithm_config)) {
       std::vector<AlgorithmType> algorithms;
       CHECK(stream->parent()->GetConvolveBackwardFilterAlgorithms(&algorithms));
       ProfileResult best_result;
@@ -1066,8 +1068,8 @@ class Conv3DBackpropFilterOp<GPUDevice, T> : public OpKernel {
       algorithm_config.set_algorithm(best_result.algorithm());
       algorithm_config.set_algorithm_no_scratch(
           best_result_no_scratch.algorithm());
-      AutoTuneConv3dBwdFilter::GetInstance()->Insert(conv_parameters,
-                                                     algorithm_config);
+      AutoTuneConv3dBwdFilter::GetInstance()->Insert(
+          conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
     }
     CudnnScratchAllocator scratch_allocator(ConvolveBackwardFilterScratchSize,
                                             context);
@@ -22,16 +22,18 @@ limitations under the License.
 #include <string.h>
 #include <map>
 #include <vector>
-#include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/kernels/bias_activation_functor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
+#include "tensorflow/core/kernels/conv_ops_autotune.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/kernels/prepacked_gemm.h"
 #ifdef TENSORFLOW_USE_LIBXSMM
 #include "tensorflow/core/kernels/xsmm_conv2d.h"
 #endif
@@ -39,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/padding.h"
@@ -137,12 +140,64 @@ class LaunchDeepConvOp {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  const Eigen::PaddingType& padding, Tensor* output,
+                  TensorFormat data_format) {
     return false;
   }
 };
 
+// The algorithms Conv2D on CPU can compute a convolution with.
+class CpuConvAlgorithm {
+ public:
+  enum Type {
+    // The generic Eigen convolution, i.e. im2col followed by a GEMM, or a
+    // plain matrix multiplication for 1x1 filters.
+    kEigen,
+    // DeepConv2D with the F(2x2, 3x3) Winograd transform.
+    kWinogradF2x2,
+    // DeepConv2D with the F(4x4, 3x3) Winograd transform.
+    kWinogradF4x4,
+  };
+
+  CpuConvAlgorithm() : type_(kEigen) {}
+  explicit CpuConvAlgorithm(Type type) : type_(type) {}
+
+  Type type() const { return type_; }
+
+  bool operator==(const CpuConvAlgorithm& other) const {
+    return type_ == other.type_;
+  }
+  bool operator!=(const CpuConvAlgorithm& other) const {
+    return !(*this == other);
+  }
+
+  string ToString() const {
+    switch (type_) {
+      case kEigen:
+        return "Eigen";
+      case kWinogradF2x2:
+        return "WinogradF2x2";
+      case kWinogradF4x4:
+        return "WinogradF4x4";
+    }
+    return "Unknown";
+  }
+
+ private:
+  Type type_;
+};
+
+struct CpuConvAutoTuneGroup {
+  static string name() { return "CpuConv"; }
+};
+typedef AutoTuneSingleton<CpuConvAutoTuneGroup, ConvParameters,
+                          CpuConvAlgorithm>
+    AutoTuneCpuConv;
+
 // Conditionally launches DeepConv operation based on convolution parameters.
+// If CpuConvUseAutotune() is true, the algorithm is instead picked by timing
+// the Eigen convolution and both DeepConv2D transforms the first time each
+// shape is seen.
 template <>
 class LaunchDeepConvOp<CPUDevice, float> {
  public:
@@ -151,13 +206,126 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
-    if (data_format != FORMAT_NHWC ||
-        !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
+                  const Eigen::PaddingType& padding, Tensor* output,
+                  TensorFormat data_format) {
+    if (data_format != FORMAT_NHWC) {
+      return false;
+    }
+    if (CpuConvUseAutotune() &&
+        DeepConv2DSupports(stride_rows, stride_cols, filter_rows,
+                           filter_cols)) {
+      return RunAutotuned(ctx, input, filter, batch, input_rows, input_cols,
+                          in_depth, filter_rows, filter_cols, pad_rows,
+                          pad_cols, out_rows, out_cols, out_depth, stride_rows,
+                          stride_cols, padding, output);
+    }
+    if (!CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
                           in_depth, out_depth, out_rows, out_cols)) {
       return false;
     }
+    RunDeepConv2D(ctx, input, filter, batch, input_rows, input_cols, in_depth,
+                  filter_rows, filter_cols, pad_rows, pad_cols, out_rows,
+                  out_cols, out_depth, DeepConv2DTransformType::kWinogradF2x2,
+                  output);
+    return true;
+  }
+
+ private:
+  // Computes the convolution with the autotuned algorithm, timing each of
+  // them if none was picked yet for this shape. Returns false if the Eigen
+  // convolution is the fastest, and leaves it to the caller.
+  static bool RunAutotuned(OpKernelContext* ctx, const Tensor& input,
+                           const Tensor& filter, int batch, int input_rows,
+                           int input_cols, int in_depth, int filter_rows,
+                           int filter_cols, int pad_rows, int pad_cols,
+                           int out_rows, int out_cols, int out_depth,
+                           int stride_rows, int stride_cols,
+                           const Eigen::PaddingType& padding, Tensor* output) {
+    ConvParameters conv_parameters = {
+        batch,                       // batch
+        in_depth,                    // in_depths
+        {{input_rows,                // in_rows
+          input_cols}},              // in_cols
+        out_depth,                   // out_depths
+        {{filter_rows,               // filter_rows
+          filter_cols}},             // filter_cols
+        {{stride_rows,               // stride_rows
+          stride_cols}},             // stride_cols
+        {{pad_rows,                  // padding_rows
+          pad_cols}},                // padding_cols
+        DataTypeToEnum<float>::v(),  // tensor datatype
+        0,                           // device_id
+    };
+    CpuConvAlgorithm algorithm;
+    if (!AutoTuneCpuConv::GetInstance()->Find(conv_parameters, &algorithm)) {
+      const CpuConvAlgorithm::Type candidates[] = {
+          CpuConvAlgorithm::kEigen, CpuConvAlgorithm::kWinogradF2x2,
+          CpuConvAlgorithm::kWinogradF4x4};
+      uint64 best_micros = 0;
+      for (CpuConvAlgorithm::Type candidate : candidates) {
+        const uint64 start_micros = Env::Default()->NowMicros();
+        RunAlgorithm(ctx, input, filter, batch, input_rows, input_cols,
+                     in_depth, filter_rows, filter_cols, pad_rows, pad_cols,
+                     out_rows, out_cols, out_depth, stride_rows, stride_cols,
+                     padding, CpuConvAlgorithm(candidate), output);
+        const uint64 elapsed_micros =
+            Env::Default()->NowMicros() - start_micros;
+        if (candidate == candidates[0] || elapsed_micros < best_micros) {
+          best_micros = elapsed_micros;
+          algorithm = CpuConvAlgorithm(candidate);
+        }
+      }
+      AutoTuneCpuConv::GetInstance()->Insert(conv_parameters, algorithm);
+      // The output holds the result of the last candidate, which is as good
+      // as the one of the winner.
+      return true;
+    }
+    if (algorithm.type() == CpuConvAlgorithm::kEigen) {
+      return false;
+    }
+    RunAlgorithm(ctx, input, filter, batch, input_rows, input_cols, in_depth,
+                 filter_rows, filter_cols, pad_rows, pad_cols, out_rows,
+                 out_cols, out_depth, stride_rows, stride_cols, padding,
+                 algorithm, output);
+    return true;
+  }
 
+  static void RunAlgorithm(OpKernelContext* ctx, const Tensor& input,
+                           const Tensor& filter, int batch, int input_rows,
+                           int input_cols, int in_depth, int filter_rows,
+                           int filter_cols, int pad_rows, int pad_cols,
+                           int out_rows, int out_cols, int out_depth,
+                           int stride_rows, int stride_cols,
+                           const Eigen::PaddingType& padding,
+                           const CpuConvAlgorithm& algorithm, Tensor* output) {
+    switch (algorithm.type()) {
+      case CpuConvAlgorithm::kEigen:
+        LaunchGeneric<CPUDevice, float>::launch(ctx, input, filter,
+                                                stride_rows, stride_cols,
+                                                padding, output, FORMAT_NHWC);
+        break;
+      case CpuConvAlgorithm::kWinogradF2x2:
+        RunDeepConv2D(ctx, input, filter, batch, input_rows, input_cols,
+                      in_depth, filter_rows, filter_cols, pad_rows, pad_cols,
+                      out_rows, out_cols, out_depth,
+                      DeepConv2DTransformType::kWinogradF2x2, output);
+        break;
+      case CpuConvAlgorithm::kWinogradF4x4:
+        RunDeepConv2D(ctx, input, filter, batch, input_rows, input_cols,
+                      in_depth, filter_rows, filter_cols, pad_rows, pad_cols,
+                      out_rows, out_cols, out_depth,
+                      DeepConv2DTransformType::kWinogradF4x4, output);
+        break;
+    }
+  }
+
+  static void RunDeepConv2D(OpKernelContext* ctx, const Tensor& input,
+                            const Tensor& filter, int batch, int input_rows,
+                            int input_cols, int in_depth, int filter_rows,
+                            int filter_cols, int pad_rows, int pad_cols,
+                            int out_rows, int out_cols, int out_depth,
+                            DeepConv2DTransformType transform,
+                            Tensor* output) {
     Conv2DArgs args;
     args.batch = batch;
     args.in_rows = input_rows;
@@ -170,6 +338,7 @@ class LaunchDeepConvOp<CPUDevice, float> {
     args.out_rows = out_rows;
     args.out_cols = out_cols;
     args.out_depth = out_depth;
+    args.transform = transform;
 
     auto input_ptr = input.template flat<float>().data();
     auto filter_ptr = filter.template flat<float>().data();
@@ -177,7 +346,6 @@ class LaunchDeepConvOp<CPUDevice, float> {
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
                                             output_ptr);
-    return true;
   }
 };
 
@@ -250,10 +418,55 @@ class LaunchXsmmConvOp<CPUDevice, float> {
 };
 #endif
 
+// Computes the convolutions by 1x1 filters as multiplications by filters
+// packed once across steps, see prepacked_gemm.h. Returns whether it did.
+template <typename Device, typename T>
+class LaunchPrepackedConvOp {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, int stride_rows, int stride_cols,
+                  PrepackedGemmWeightsCache<T>* filter_cache, Tensor* output,
+                  TensorFormat data_format) {
+    return false;
+  }
+};
+
+template <>
+class LaunchPrepackedConvOp<CPUDevice, float> {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, int stride_rows, int stride_cols,
+                  PrepackedGemmWeightsCache<float>* filter_cache,
+                  Tensor* output, TensorFormat data_format) {
+    if (data_format != FORMAT_NHWC || filter.dim_size(0) != 1 ||
+        filter.dim_size(1) != 1 || stride_rows != 1 || stride_cols != 1) {
+      return false;
+    }
+    const int64 in_depth = filter.dim_size(2);
+    const int64 out_depth = filter.dim_size(3);
+    const int64 conv_width = output->NumElements() / out_depth;
+    if (conv_width == 1 || out_depth == 1) {
+      return false;
+    }
+    // The reshaped filter shares the buffer of the constant.
+    Tensor weights;
+    CHECK(weights.CopyFrom(filter, TensorShape({in_depth, out_depth})));
+    filter_cache->Get(ctx, weights, false)
+        ->Multiply(ctx, input.flat<float>().data(), conv_width,
+                   output->flat<float>().data());
+    return true;
+  }
+};
+
 template <typename Device, typename T>
-class Conv2DOp : public BinaryOp<T> {
+class Conv2DOp : public OpKernel {
  public:
-  explicit Conv2DOp(OpKernelConstruction* context) : BinaryOp<T>(context) {
+  explicit Conv2DOp(OpKernelConstruction* context) : OpKernel(context) {
+    // The input and the filter, followed by the bias of _FusedConv2D.
+    const DataType dt = DataTypeToEnum<T>::v();
+    OP_REQUIRES_OK(context,
+                   context->MatchSignature(
+                       DataTypeVector(context->num_inputs(), dt), {dt}));
     OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
     string data_format;
     OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
@@ -272,6 +485,10 @@ class Conv2DOp : public BinaryOp<T> {
         errors::InvalidArgument("Current implementation does not yet support "
                                 "strides in the batch and depth dimensions."));
     OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    if (context->def().attr().count(kPrepackWeightsAttr) > 0) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr(kPrepackWeightsAttr, &prepack_filter_));
+    }
   }
 
   void Compute(OpKernelContext* context) override {
@@ -380,10 +597,18 @@ class Conv2DOp : public BinaryOp<T> {
     }
 #endif
 
+    if (prepack_filter_ &&
+        LaunchPrepackedConvOp<Device, T>::Run(
+            context, input, filter, stride_rows, stride_cols,
+            &prepacked_filter_, output, data_format_)) {
+      return;
+    }
+
     if (LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, batch, input_rows, input_cols, in_depth,
             filter_rows, filter_cols, pad_rows, pad_cols, out_rows, out_cols,
-            out_depth, stride_rows, stride_cols, output, data_format_)) {
+            out_depth, stride_rows, stride_cols,
+            BrainPadding2EigenPadding(padding_), output, data_format_)) {
       return;
     }
 
@@ -399,14 +624,77 @@ class Conv2DOp : public BinaryOp<T> {
   TensorFormat data_format_;
   LaunchConv2DOp<Device, T> launcher_;
   bool cudnn_use_autotune_;
+  // Whether the filter is constant and packed once, see prepacked_gemm.h.
+  bool prepack_filter_ = false;
+  PrepackedGemmWeightsCache<T> prepacked_filter_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
 
-#define REGISTER_CPU(T)                                         \
-  REGISTER_KERNEL_BUILDER(                                      \
-      Name("Conv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
-      Conv2DOp<CPUDevice, T>);
+// Conv2D followed by BiasAdd and an activation.  The bias and the activation
+// are applied in a single pass over the output of the convolution, instead of
+// the two passes of separate BiasAdd and activation kernels.
+template <typename Device, typename T>
+class FusedConv2DOp : public Conv2DOp<Device, T> {
+ public:
+  explicit FusedConv2DOp(OpKernelConstruction* context)
+      : Conv2DOp<Device, T>(context) {
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES(context, FormatFromString(data_format, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    OP_REQUIRES(context,
+                functor::FusedActivationFromString(activation, &activation_),
+                errors::InvalidArgument("Unsupported activation: ",
+                                        activation));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("bias must be 1-dimensional: ",
+                                        bias.shape().DebugString()));
+    Conv2DOp<Device, T>::Compute(context);
+    if (!context->status().ok()) {
+      return;
+    }
+
+    Tensor* output = context->mutable_output(0);
+    const int64 depth = GetTensorDim(*output, data_format_, 'C');
+    OP_REQUIRES(context, bias.dim_size(0) == depth,
+                errors::InvalidArgument(
+                    "bias must have the size of the output depth: ",
+                    bias.dim_size(0), " vs ", depth));
+    if (output->NumElements() == 0) {
+      return;
+    }
+    // View the output as [outer, depth, inner] for the bias to broadcast.
+    const int64 batch = GetTensorDim(*output, data_format_, 'N');
+    const int64 image_size = output->NumElements() / (batch * depth);
+    const bool nhwc = data_format_ == FORMAT_NHWC;
+    const int64 outer = nhwc ? batch * image_size : batch;
+    const int64 inner = nhwc ? 1 : image_size;
+    functor::BiasActivation<Device, T>()(
+        context->eigen_device<Device>(), bias.vec<T>(), activation_,
+        output->shaped<T, 3>({outer, depth, inner}));
+  }
+
+ private:
+  TensorFormat data_format_;
+  functor::FusedActivation activation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedConv2DOp);
+};
+
+#define REGISTER_CPU(T)                                               \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("Conv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"),       \
+      Conv2DOp<CPUDevice, T>);                                        \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedConv2DOp<CPUDevice, T>);
 
 // If we're using the alternative GEMM-based implementation of Conv2D for the
 // CPU implementation, don't register this EigenTensor-based version.
@@ -666,7 +954,8 @@ void LaunchConv2DOp<GPUDevice, T>::launch(
   };
   AlgorithmConfig algorithm_config;
   if (cudnn_use_autotune &&
-      !AutoTuneConv::GetInstance()->Find(conv_parameters, &algorithm_config)) {
+      !AutoTuneConv::GetInstance()->Find(
+          conv_parameters, AutoTuneDeviceKey(stream), &algorithm_config)) {
     std::vector<AlgorithmType> algorithms;
     CHECK(stream->parent()->GetConvolveAlgorithms(&algorithms));
     ProfileResult best_result;
@@ -708,7 +997,8 @@ void LaunchConv2DOp<GPUDevice, T>::launch(
     algorithm_config.set_algorithm(best_result.algorithm());
     algorithm_config.set_algorithm_no_scratch(
         best_result_no_scratch.algorithm());
-    AutoTuneConv::GetInstance()->Insert(conv_parameters, algorithm_config);
+    AutoTuneConv::GetInstance()->Insert(
+        conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
   }
 
   CudnnScratchAllocator scratch_allocator(ConvolveScratchSize, ctx);
@@ -765,7 +1055,12 @@ namespace functor {
       const std::array<int, 2>& padding_left,                                \
       const std::array<int, 2>& padding_right,                               \
       typename TTypes<T, 4, int>::Tensor out, TensorFormat data_format);     \
-  extern template struct PadInput<GPUDevice, T, int, 4>
+  extern template struct PadInput<GPUDevice, T, int, 4>;                     \
+  template <>                                                                \
+  void BiasActivation<GPUDevice, T>::operator()(                             \
+      const GPUDevice& d, typename TTypes<T>::ConstVec bias,                 \
+      FusedActivation activation, typename TTypes<T, 3>::Tensor output);     \
+  extern template struct BiasActivation<GPUDevice, T>
 
 DECLARE_GPU_SPEC(float);
 DECLARE_GPU_SPEC(Eigen::half);
@@ -779,6 +1074,12 @@ REGISTER_KERNEL_BUILDER(
 REGISTER_KERNEL_BUILDER(
     Name("Conv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
     Conv2DOp<GPUDevice, float>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<Eigen::half>("T"),
+    FusedConv2DOp<GPUDevice, Eigen::half>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedConv2DOp<GPUDevice, float>);
 
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<GPUDevice, float>;
@@ -390,7 +390,8 @@ struct LaunchConvOp<GPUDevice, T> {
     AlgorithmConfig algorithm_config;
 
     if (cudnn_use_autotune && !AutoTuneConv3d::GetInstance()->Find(
-                                  conv_parameters, &algorithm_config)) {
+                                  conv_parameters, AutoTuneDeviceKey(stream),
+                                  &algorithm_config)) {
       std::vector<AlgorithmType> algorithms;
       CHECK(stream->parent()->GetConvolveAlgorithms(&algorithms));
       ProfileResult best_result;
@@ -432,7 +433,8 @@ struct LaunchConvOp<GPUDevice, T> {
       algorithm_config.set_algorithm(best_result.algorithm());
       algorithm_config.set_algorithm_no_scratch(
           best_result_no_scratch.algorithm());
-      AutoTuneConv3d::GetInstance()->Insert(conv_parameters, algorithm_config);
+      AutoTuneConv3d::GetInstance()->Insert(
+          conv_parameters, AutoTuneDeviceKey(stream), algorithm_config);
     }
 
     CudnnScratchAllocator scratch_allocator(ConvolveScratchSize, ctx);
@@ -0,0 +1,95 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/conv_ops_autotune.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace tensorflow {
+
+AutoTuneCache::AutoTuneCache(const string& filename) : filename_(filename) {
+  if (filename_.empty()) {
+    return;
+  }
+  Env* env = Env::Default();
+  if (!env->FileExists(filename_).ok()) {
+    return;
+  }
+  string contents;
+  Status status = ReadFileToString(env, filename_, &contents);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read the autotune cache " << filename_ << ": "
+                 << status;
+    return;
+  }
+  mutex_lock lock(mu_);
+  for (StringPiece line : str_util::Split(contents, '\n')) {
+    // Skip the truncated line a process may have been killed writing.
+    const std::vector<string> key_value = str_util::Split(line, '\t');
+    if (key_value.size() != 2 || key_value[1].empty()) {
+      continue;
+    }
+    values_[key_value[0]] = key_value[1];
+  }
+  VLOG(1) << "Loaded " << values_.size() << " autotune results from "
+          << filename_;
+}
+
+AutoTuneCache* AutoTuneCache::Global() {
+  static AutoTuneCache* cache = [] {
+    const char* filename = getenv("TF_AUTOTUNE_CACHE_FILE");
+    return new AutoTuneCache(filename == nullptr ? "" : filename);
+  }();
+  return cache;
+}
+
+bool AutoTuneCache::Find(const string& key, string* value) const {
+  mutex_lock lock(mu_);
+  auto iter = values_.find(key);
+  if (iter == values_.end()) {
+    return false;
+  }
+  *value = iter->second;
+  return true;
+}
+
+void AutoTuneCache::Insert(const string& key, const string& value) {
+  mutex_lock lock(mu_);
+  values_[key] = value;
+  if (filename_.empty()) {
+    return;
+  }
+  // Append the whole line at once, so that the lines of the processes sharing
+  // the file don't interleave.
+  std::unique_ptr<WritableFile> file;
+  Status status = Env::Default()->NewAppendableFile(filename_, &file);
+  if (status.ok()) {
+    status = file->Append(strings::StrCat(key, "\t", value, "\n"));
+  }
+  if (status.ok()) {
+    status = file->Close();
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write the autotune cache " << filename_ << ": "
+                 << status;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/conv_ops_autotune.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the name of a cache file which doesn't exist yet.
+string CacheFilename(const string& name) {
+  const string filename = io::JoinPath(testing::TmpDir(), name);
+  Env::Default()->DeleteFile(filename).IgnoreError();
+  return filename;
+}
+
+TEST(AutoTuneCacheTest, InMemory) {
+  AutoTuneCache cache("");
+  string value;
+  EXPECT_FALSE(cache.Find("a", &value));
+  cache.Insert("a", "1");
+  ASSERT_TRUE(cache.Find("a", &value));
+  EXPECT_EQ("1", value);
+}
+
+TEST(AutoTuneCacheTest, PersistsAcrossInstances) {
+  const string filename = CacheFilename("persists");
+  {
+    AutoTuneCache cache(filename);
+    cache.Insert("conv: device A: 1, 2", "3,4");
+    cache.Insert("conv: device B: 1, 2", "5,6");
+  }
+  AutoTuneCache cache(filename);
+  string value;
+  ASSERT_TRUE(cache.Find("conv: device A: 1, 2", &value));
+  EXPECT_EQ("3,4", value);
+  ASSERT_TRUE(cache.Find("conv: device B: 1, 2", &value));
+  EXPECT_EQ("5,6", value);
+  EXPECT_FALSE(cache.Find("conv: device C: 1, 2", &value));
+}
+
+TEST(AutoTuneCacheTest, LastValueWins) {
+  const string filename = CacheFilename("last_value_wins");
+  AutoTuneCache first(filename);
+  AutoTuneCache second(filename);
+  first.Insert("key", "1");
+  second.Insert("key", "2");
+  string value;
+  AutoTuneCache cache(filename);
+  ASSERT_TRUE(cache.Find("key", &value));
+  EXPECT_EQ("2", value);
+}
+
+TEST(AutoTuneCacheTest, SkipsMalformedLines) {
+  const string filename = CacheFilename("malformed");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 "good\t1\nno value\nempty\t\ntruncated\t"));
+  AutoTuneCache cache(filename);
+  string value;
+  ASSERT_TRUE(cache.Find("good", &value));
+  EXPECT_EQ("1", value);
+  EXPECT_FALSE(cache.Find("no value", &value));
+  EXPECT_FALSE(cache.Find("empty", &value));
+  EXPECT_FALSE(cache.Find("truncated", &value));
+}
+
+TEST(ConvParametersTest, ToStringWithoutDevice) {
+  const ConvParameters on_device0 = {
+      1, 2, {{3, 4}}, 5, {{3, 3}}, {{1, 1}}, {{0, 0}}, DT_FLOAT, 0};
+  const ConvParameters on_device1 = {
+      1, 2, {{3, 4}}, 5, {{3, 3}}, {{1, 1}}, {{0, 0}}, DT_FLOAT, 1};
+  EXPECT_NE(on_device0.ToString(), on_device1.ToString());
+  EXPECT_EQ(on_device0.ToStringWithoutDevice(),
+            on_device1.ToStringWithoutDevice());
+}
+
+}  // namespace
+}  // namespace tensorflow
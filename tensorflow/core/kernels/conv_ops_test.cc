@@ -303,4 +303,65 @@ TEST_F(FusedResizePadConvOpTest, ResizeAndPadSymmetricComparativeLarge) {
                           "SYMMETRIC", 1, "SAME");
 }
 
+class FusedConv2DOpTest : public OpsTestBase {
+ protected:
+  void RunFusedConv2D(const string& activation) {
+    TF_EXPECT_OK(NodeDefBuilder("fused_conv_op", "_FusedConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("strides", {1, 1, 1, 1})
+                     .Attr("padding", "VALID")
+                     .Attr("activation", activation)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+    // A 1x1 filter with two output channels, which multiply the image by 1
+    // and -1.
+    AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+    AddInputFromArray<float>(TensorShape({1, 1, 1, 2}), {1, -1});
+    AddInputFromArray<float>(TensorShape({2}), {0.5, 2.5});
+    TF_ASSERT_OK(RunOpKernel());
+  }
+};
+
+TEST_F(FusedConv2DOpTest, BiasOnly) {
+  RunFusedConv2D("Identity");
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 2, 2}));
+  test::FillValues<float>(&expected,
+                          {1.5, 1.5, 2.5, 0.5, 3.5, -0.5, 4.5, -1.5});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedConv2DOpTest, BiasAndRelu) {
+  RunFusedConv2D("Relu");
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 2, 2}));
+  test::FillValues<float>(&expected, {1.5, 1.5, 2.5, 0.5, 3.5, 0, 4.5, 0});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedConv2DOpTest, BiasAndRelu6) {
+  RunFusedConv2D("Relu6");
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 2, 2}));
+  test::FillValues<float>(&expected, {1.5, 1.5, 2.5, 0.5, 3.5, 0, 4.5, 0});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedConv2DOpTest, BiasOfWrongSize) {
+  TF_EXPECT_OK(NodeDefBuilder("fused_conv_op", "_FusedConv2D")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("strides", {1, 1, 1, 1})
+                   .Attr("padding", "VALID")
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 1, 1, 2}), {1, -1});
+  AddInputFromArray<float>(TensorShape({3}), {0, 0, 0});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(StringPiece(s.ToString()).contains("output depth")) << s;
+}
+
 }  // namespace tensorflow
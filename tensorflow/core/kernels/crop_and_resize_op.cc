@@ -19,8 +19,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/crop_and_resize_op.h"
 
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -97,6 +99,51 @@ inline void RunIfBoxIndexIsValid<CPUDevice>(
   done();
 }
 
+// The horizontal interpolation weights of one column of a crop. lower and
+// upper are the offsets in an image row of the input pixels to the left and
+// to the right of the column, and lower is -1 if the column is outside of
+// the image.
+struct CachedInterpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+// Interpolates one row of a crop between the image rows "top" and "bottom".
+// kChannels is the number of channels if it is known at compile time, which
+// is the case for RGB and RGBA images, and 0 otherwise.
+template <typename T, int kChannels>
+inline void InterpolateRow(const T* top, const T* bottom, const float y_lerp,
+                           const CachedInterpolation* xs, const int crop_width,
+                           const int depth, const float extrapolation_value,
+                           float* output) {
+  const int channels = kChannels > 0 ? kChannels : depth;
+  for (int x = 0; x < crop_width; ++x, output += channels) {
+    if (xs[x].lower < 0) {
+      for (int c = 0; c < channels; ++c) {
+        output[c] = extrapolation_value;
+      }
+      continue;
+    }
+    const T* top_left = top + xs[x].lower;
+    const T* top_right = top + xs[x].upper;
+    const T* bottom_left = bottom + xs[x].lower;
+    const T* bottom_right = bottom + xs[x].upper;
+    const float x_lerp = xs[x].lerp;
+    for (int c = 0; c < channels; ++c) {
+      const float top_left_value(static_cast<float>(top_left[c]));
+      const float top_right_value(static_cast<float>(top_right[c]));
+      const float bottom_left_value(static_cast<float>(bottom_left[c]));
+      const float bottom_right_value(static_cast<float>(bottom_right[c]));
+      const float top_value =
+          top_left_value + (top_right_value - top_left_value) * x_lerp;
+      const float bottom_value =
+          bottom_left_value + (bottom_right_value - bottom_left_value) * x_lerp;
+      output[c] = top_value + (bottom_value - top_value) * y_lerp;
+    }
+  }
+}
+
 }  // namespace
 
 template <typename Device, typename T>
@@ -207,71 +254,94 @@ struct CropAndResize<CPUDevice, T> {
     const int crop_width = crops.dimension(2);
     const int depth = crops.dimension(3);
 
-    for (int b = 0; b < num_boxes; ++b) {
-      const float y1 = boxes(b, 0);
-      const float x1 = boxes(b, 1);
-      const float y2 = boxes(b, 2);
-      const float x2 = boxes(b, 3);
-
-      const int32 b_in = box_index(b);
-      if (!FastBoundsCheck(b_in, batch_size)) {
-        continue;
-      }
-
-      const float height_scale =
-          (crop_height > 1) ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
-                            : 0;
-      const float width_scale =
-          (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
-                           : 0;
-
-      for (int y = 0; y < crop_height; ++y) {
-        const float in_y = (crop_height > 1)
-                               ? y1 * (image_height - 1) + y * height_scale
-                               : 0.5 * (y1 + y2) * (image_height - 1);
-        if (in_y < 0 || in_y > image_height - 1) {
-          for (int x = 0; x < crop_width; ++x) {
-            for (int d = 0; d < depth; ++d) {
-              crops(b, y, x, d) = extrapolation_value;
-            }
-          }
+    const int64 in_row_size = static_cast<int64>(image_width) * depth;
+    const int64 in_batch_size = image_height * in_row_size;
+    const int64 out_row_size = static_cast<int64>(crop_width) * depth;
+    const int64 out_box_size = crop_height * out_row_size;
+
+    // Crops the boxes in [start_box, limit_box). The horizontal interpolation
+    // weights of a box are computed once for all of its rows.
+    auto crop_boxes = [&](int64 start_box, int64 limit_box) {
+      std::vector<CachedInterpolation> xs(crop_width);
+      for (int64 b = start_box; b < limit_box; ++b) {
+        const float y1 = boxes(b, 0);
+        const float x1 = boxes(b, 1);
+        const float y2 = boxes(b, 2);
+        const float x2 = boxes(b, 3);
+
+        const int32 b_in = box_index(b);
+        if (!FastBoundsCheck(b_in, batch_size)) {
           continue;
         }
-        const int top_y_index = floorf(in_y);
-        const int bottom_y_index = ceilf(in_y);
-        const float y_lerp = in_y - top_y_index;
+
+        const float height_scale =
+            (crop_height > 1)
+                ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
+                : 0;
+        const float width_scale =
+            (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
+                             : 0;
 
         for (int x = 0; x < crop_width; ++x) {
           const float in_x = (crop_width > 1)
                                  ? x1 * (image_width - 1) + x * width_scale
                                  : 0.5 * (x1 + x2) * (image_width - 1);
           if (in_x < 0 || in_x > image_width - 1) {
-            for (int d = 0; d < depth; ++d) {
-              crops(b, y, x, d) = extrapolation_value;
-            }
+            xs[x].lower = -1;
             continue;
           }
           const int left_x_index = floorf(in_x);
           const int right_x_index = ceilf(in_x);
-          const float x_lerp = in_x - left_x_index;
+          xs[x].lower = static_cast<int64>(left_x_index) * depth;
+          xs[x].upper = static_cast<int64>(right_x_index) * depth;
+          xs[x].lerp = in_x - left_x_index;
+        }
 
-          for (int d = 0; d < depth; ++d) {
-            const float top_left(
-                static_cast<float>(image(b_in, top_y_index, left_x_index, d)));
-            const float top_right(
-                static_cast<float>(image(b_in, top_y_index, right_x_index, d)));
-            const float bottom_left(static_cast<float>(
-                image(b_in, bottom_y_index, left_x_index, d)));
-            const float bottom_right(static_cast<float>(
-                image(b_in, bottom_y_index, right_x_index, d)));
-            const float top = top_left + (top_right - top_left) * x_lerp;
-            const float bottom =
-                bottom_left + (bottom_right - bottom_left) * x_lerp;
-            crops(b, y, x, d) = top + (bottom - top) * y_lerp;
+        const T* image_b = image.data() + b_in * in_batch_size;
+        float* crop_y = crops.data() + b * out_box_size;
+        for (int y = 0; y < crop_height; ++y, crop_y += out_row_size) {
+          const float in_y = (crop_height > 1)
+                                 ? y1 * (image_height - 1) + y * height_scale
+                                 : 0.5 * (y1 + y2) * (image_height - 1);
+          if (in_y < 0 || in_y > image_height - 1) {
+            std::fill(crop_y, crop_y + out_row_size, extrapolation_value);
+            continue;
+          }
+          const int top_y_index = floorf(in_y);
+          const int bottom_y_index = ceilf(in_y);
+          const float y_lerp = in_y - top_y_index;
+          const T* top_row = image_b + top_y_index * in_row_size;
+          const T* bottom_row = image_b + bottom_y_index * in_row_size;
+
+          switch (depth) {
+            case 3:
+              InterpolateRow<T, 3>(top_row, bottom_row, y_lerp, xs.data(),
+                                   crop_width, depth, extrapolation_value,
+                                   crop_y);
+              break;
+            case 4:
+              InterpolateRow<T, 4>(top_row, bottom_row, y_lerp, xs.data(),
+                                   crop_width, depth, extrapolation_value,
+                                   crop_y);
+              break;
+            default:
+              InterpolateRow<T, 0>(top_row, bottom_row, y_lerp, xs.data(),
+                                   crop_width, depth, extrapolation_value,
+                                   crop_y);
+              break;
           }
         }
       }
-    }
+    };
+
+    // Each output value reads four input values and takes three linear
+    // interpolations.
+    const double values_per_box = static_cast<double>(out_box_size);
+    d.parallelFor(num_boxes,
+                  Eigen::TensorOpCost(4 * sizeof(T) * values_per_box,
+                                      sizeof(float) * values_per_box,
+                                      9 * values_per_box),
+                  crop_boxes);
     return true;
   }
 };
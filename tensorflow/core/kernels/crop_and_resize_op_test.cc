@@ -230,6 +230,29 @@ TEST_F(CropAndResizeOpTest, TestCropAndResize2x2To3x3NoCrop) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(CropAndResizeOpTest, TestCropAndResize2x2To2x2RGBExtrapolated) {
+  MakeOp<uint8>(-1);
+  // Input:
+  //  (1, 2, 3),  (4, 5, 6)
+  //  (7, 8, 9), (10, 11, 12)
+  AddInputFromArray<uint8>(TensorShape({1, 2, 2, 3}),
+                           {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  AddInputFromArray<float>(TensorShape({2, 4}), {0, 0, 1, 1, 0, 0, 1, 2});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 0});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2, 2, 3}));
+  // clang-format off
+  test::FillValues<float>(&expected,
+    {1, 2, 3,  4,  5,  6,
+     7, 8, 9, 10, 11, 12,
+     1, 2, 3, -1, -1, -1,
+     7, 8, 9, -1, -1, -1});
+  // clang-format on
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 TEST_F(CropAndResizeOpTest, TestInvalidInputShape) {
   MakeOp<float>(0);
   AddInputFromArray<float>(TensorShape({2, 2, 1}), {1, 2, 3, 4});
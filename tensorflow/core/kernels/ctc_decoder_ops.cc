@@ -26,7 +26,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -280,42 +282,53 @@ class CTCBeamSearchDecoderOp : public OpKernel {
 
     log_prob_t.setZero();
 
-    std::vector<TTypes<float>::UnalignedConstMatrix> input_list_t;
-
-    for (std::size_t t = 0; t < max_time; ++t) {
-      input_list_t.emplace_back(inputs_t.data() + t * batch_size * num_classes,
-                                batch_size, num_classes);
-    }
-
-    ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
-                                            &beam_scorer_, 1 /* batch_size */,
-                                            merge_repeated_);
-    Tensor input_chip(DT_FLOAT, TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<float>();
-
+    const int top_paths = decode_helper_.GetTopPaths();
     std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<float> log_probs;
 
-    // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi =
-            Eigen::Map<const Eigen::ArrayXf>(input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
-      }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
+    // The batch entries are decoded independently, each shard with its own
+    // decoder. The beam scorer is stateless and shared by all of them.
+    mutex mu;
+    Status status;
+    auto decode = [this, &inputs_t, &seq_len_t, &log_prob_t, &best_paths,
+                   batch_size, num_classes, top_paths, &mu,
+                   &status](int64 start, int64 limit) {
+      ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
+                                              &beam_scorer_, 1 /* batch_size */,
+                                              merge_repeated_);
+      std::vector<float> log_probs;
+      // Assumption: the blank index is num_classes - 1
+      for (int64 b = start; b < limit; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(top_paths);
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          // The inputs of batch entry b at time t are contiguous.
+          auto input_bi = Eigen::Map<const Eigen::ArrayXf>(
+              inputs_t.data() + (t * batch_size + b) * num_classes,
+              num_classes);
+          beam_search.Step(input_bi);
+        }
+        Status s = beam_search.TopPaths(top_paths, &best_paths_b, &log_probs,
+                                        merge_repeated_);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          status.Update(s);
+          return;
+        }
 
-      beam_search.Reset();
+        beam_search.Reset();
 
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+        for (int bp = 0; bp < top_paths; ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
-    }
+    };
+    // Each step of the search expands every entry of the beam with every
+    // label.
+    const int64 cost_per_entry = 10 * max_time * beam_width_ * num_classes;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_entry, decode);
+    OP_REQUIRES_OK(ctx, status);
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
                             best_paths, &decoded_indices, &decoded_values,
@@ -255,6 +255,74 @@ void Assign(const D& d, Out out, Rhs rhs) {
   out.device(d) = rhs;
 }
 
+// Cost of evaluating one row of "cols" coefficients of a broadcasting binary
+// op.
+template <typename Functor>
+Eigen::TensorOpCost BroadcastRowCost(int64 cols) {
+  typedef typename Functor::out_type Tout;
+  typedef typename Functor::in_type Tin;
+  typedef typename Functor::func Binary;
+  return Eigen::TensorOpCost(
+      2 * sizeof(Tin) * cols, sizeof(Tout) * cols,
+      Eigen::internal::functor_traits<Binary>::Cost * cols);
+}
+
+// Sets row r of the [rows, cols] matrix "out" to func(in[r], vec[r /
+// rows_per_vec]), where "in" is a [rows, cols] matrix and "vec" holds
+// rows / rows_per_vec rows of "cols" coefficients, or to func(vec[...], in[r])
+// if "vec_is_lhs". Rows are evaluated as contiguous expressions, which Eigen
+// vectorizes without the index arithmetic of broadcast() on each coefficient.
+template <typename Functor, bool vec_is_lhs>
+void RowBroadcast(const CPUDevice& d, typename Functor::out_type* out,
+                  const typename Functor::in_type* in,
+                  const typename Functor::in_type* vec, int64 rows, int64 cols,
+                  int64 rows_per_vec) {
+  typedef typename Functor::out_type Tout;
+  typedef typename Functor::in_type Tin;
+  typedef typename Functor::func Binary;
+  auto work = [out, in, vec, cols, rows_per_vec](int64 start, int64 limit) {
+    Binary func;
+    for (int64 r = start; r < limit; ++r) {
+      typename TTypes<Tout>::UnalignedFlat out_row(out + r * cols, cols);
+      typename TTypes<Tin>::UnalignedConstFlat in_row(in + r * cols, cols);
+      typename TTypes<Tin>::UnalignedConstFlat vec_row(
+          vec + (r / rows_per_vec) * cols, cols);
+      if (vec_is_lhs) {
+        out_row = vec_row.binaryExpr(in_row, func);
+      } else {
+        out_row = in_row.binaryExpr(vec_row, func);
+      }
+    }
+  };
+  d.parallelFor(rows, BroadcastRowCost<Functor>(cols), work);
+}
+
+// Sets row r of the [rows, cols] matrix "out" to func(in[r], scalars[r]), or
+// to func(scalars[r], in[r]) if "scalar_is_lhs".
+template <typename Functor, bool scalar_is_lhs>
+void ColumnBroadcast(const CPUDevice& d, typename Functor::out_type* out,
+                     const typename Functor::in_type* in,
+                     const typename Functor::in_type* scalars, int64 rows,
+                     int64 cols) {
+  typedef typename Functor::out_type Tout;
+  typedef typename Functor::in_type Tin;
+  typedef typename Functor::func Binary;
+  typedef typename Eigen::internal::scalar_left<Tout, Tin, Binary> Left;
+  typedef typename Eigen::internal::scalar_right<Tout, Tin, Binary> Right;
+  auto work = [out, in, scalars, cols](int64 start, int64 limit) {
+    for (int64 r = start; r < limit; ++r) {
+      typename TTypes<Tout>::UnalignedFlat out_row(out + r * cols, cols);
+      typename TTypes<Tin>::UnalignedConstFlat in_row(in + r * cols, cols);
+      if (scalar_is_lhs) {
+        out_row = in_row.unaryExpr(Left(scalars + r));
+      } else {
+        out_row = in_row.unaryExpr(Right(scalars + r));
+      }
+    }
+  };
+  d.parallelFor(rows, BroadcastRowCost<Functor>(cols), work);
+}
+
 // Partial specialization of BinaryFunctor<Device=CPUDevice, Functor, NDIMS>
 // for functors with with no error checking.
 template <typename Functor, int NDIMS>
@@ -348,28 +416,25 @@ struct BinaryFunctor<CPUDevice, Functor, NDIMS, false> {
         Assign(dev, out, lhs.binaryExpr(rhs, func));
         return;
       }
+      // Row vector op matrix, e.g. a bias add, and column vector op matrix.
       if (a == 1) {
-        auto lhs = in0.reshape(OneByM(b)).broadcast(NByOne(c));
-        auto rhs = in1;
-        Assign(dev, out, lhs.binaryExpr(rhs, func));
+        RowBroadcast<Functor, true>(dev, out.data(), in1.data(), in0.data(),
+                                    c, d, c);
         return;
       }
       if (b == 1) {
-        auto lhs = in0.reshape(NByOne(a)).broadcast(OneByM(d));
-        auto rhs = in1;
-        Assign(dev, out, lhs.binaryExpr(rhs, func));
+        ColumnBroadcast<Functor, true>(dev, out.data(), in1.data(),
+                                       in0.data(), c, d);
         return;
       }
       if (c == 1) {
-        auto lhs = in0;
-        auto rhs = in1.reshape(OneByM(d)).broadcast(NByOne(a));
-        Assign(dev, out, lhs.binaryExpr(rhs, func));
+        RowBroadcast<Functor, false>(dev, out.data(), in0.data(), in1.data(),
+                                     a, b, a);
         return;
       }
       if (d == 1) {
-        auto lhs = in0;
-        auto rhs = in1.reshape(NByOne(c)).broadcast(OneByM(b));
-        Assign(dev, out, lhs.binaryExpr(rhs, func));
+        ColumnBroadcast<Functor, false>(dev, out.data(), in0.data(),
+                                        in1.data(), a, b);
         return;
       }
 
@@ -389,6 +454,27 @@ struct BinaryFunctor<CPUDevice, Functor, NDIMS, false> {
         return;
       }
     }
+    if ((NDIMS == 3) && Functor::use_bcast_optimization &&
+        use_bcast_optimization<T>::value) {
+      // Channel broadcast of an [n, h * w, c] tensor with an [n, 1, c] one,
+      // as in a per-image scaling of NHWC activations. Other 3-D patterns
+      // fall back to broadcast().
+      const int64 n = out.dimension(0);
+      const int64 hw = out.dimension(1);
+      const int64 ch = out.dimension(NDIMS - 1);
+      if (in0.dimension(1) == 1 && in1.dimension(1) == hw &&
+          in0.dimension(0) == n && in0.dimension(NDIMS - 1) == ch) {
+        RowBroadcast<Functor, true>(dev, out.data(), in1.data(), in0.data(),
+                                    n * hw, ch, hw);
+        return;
+      }
+      if (in1.dimension(1) == 1 && in0.dimension(1) == hw &&
+          in1.dimension(0) == n && in1.dimension(NDIMS - 1) == ch) {
+        RowBroadcast<Functor, false>(dev, out.data(), in0.data(), in1.data(),
+                                     n * hw, ch, hw);
+        return;
+      }
+    }
 
     // Fallback path. Always work and probably slower.
     auto lhs = in0.broadcast(bcast0);
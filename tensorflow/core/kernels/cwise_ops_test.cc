@@ -299,4 +299,37 @@ BM_BCAST_ADD_COL_ALL(sycl);
 #undef BM_BCAST_ADD_COL_ALL
 #undef BM_BCAST_ADD_COL
 
+// Scales each image and channel of an NHWC batch, which broadcasts a
+// [batch, 1, 1, channels] tensor over the spatial dimensions.
+static Graph* BcastMulChannel(int batch, int pixels, int channels) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor lhs(DT_FLOAT, TensorShape({batch, pixels, pixels, channels}));
+  lhs.flat<float>().setRandom();
+  Tensor rhs(DT_FLOAT, TensorShape({batch, 1, 1, channels}));
+  rhs.flat<float>().setRandom();
+  test::graph::Binary(g, "Mul", test::graph::Constant(g, lhs),
+                      test::graph::Constant(g, rhs));
+  return g;
+}
+
+#define BM_BCAST_MUL_CHANNEL(DEVICE, B, P, C)                                \
+  static void BM_##DEVICE##_BcastMulChannel_B##B##_P##P##_C##C(int iters) { \
+    const int64 tot = static_cast<int64>(iters) * B * P * P * C;            \
+    testing::ItemsProcessed(tot);                                           \
+    testing::BytesProcessed(tot * sizeof(float));                           \
+    test::Benchmark(#DEVICE, BcastMulChannel(B, P, C)).Run(iters);          \
+  }                                                                         \
+  BENCHMARK(BM_##DEVICE##_BcastMulChannel_B##B##_P##P##_C##C);
+
+#define BM_BCAST_MUL_CHANNEL_ALL(DEVICE)      \
+  BM_BCAST_MUL_CHANNEL(DEVICE, 32, 28, 256); \
+  BM_BCAST_MUL_CHANNEL(DEVICE, 32, 56, 64);  \
+  BM_BCAST_MUL_CHANNEL(DEVICE, 32, 7, 1024);
+BM_BCAST_MUL_CHANNEL_ALL(cpu);
+#if GOOGLE_CUDA
+BM_BCAST_MUL_CHANNEL_ALL(gpu);
+#endif  // GOOGLE_CUDA
+#undef BM_BCAST_MUL_CHANNEL_ALL
+#undef BM_BCAST_MUL_CHANNEL
+
 }  // end namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/array_ops.cc.
+#define EIGEN_USE_THREADS
+
 #include "tensorflow/core/kernels/debug_ops.h"
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -23,6 +25,9 @@ limitations under the License.
 
 namespace tensorflow {
 
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
 // Register Copy ops.
 REGISTER_KERNEL_BUILDER(Name("Copy").Device(DEVICE_CPU), CopyOp);
 
@@ -137,4 +142,38 @@ REGISTER_GPU_DEBUG_NUMERIC_SUMMARY_COUNT(float);
 REGISTER_GPU_DEBUG_NUMERIC_SUMMARY_COUNT(double);
 #endif  // TENSORFLOW_USE_SYCL
 
+// Register debug numerics monitor ops.
+#define REGISTER_DEBUG_NUMERICS_MONITOR(type)             \
+  REGISTER_KERNEL_BUILDER(Name("DebugNumericsMonitor")    \
+                              .Device(DEVICE_CPU)         \
+                              .TypeConstraint<type>("T"), \
+                          DebugNumericsMonitorOp<CPUDevice, type>);
+TF_CALL_half(REGISTER_DEBUG_NUMERICS_MONITOR);
+TF_CALL_float(REGISTER_DEBUG_NUMERICS_MONITOR);
+TF_CALL_double(REGISTER_DEBUG_NUMERICS_MONITOR);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                        \
+  template <>                                                      \
+  void NumericsAccumulate<GPUDevice, T>::operator()(               \
+      const GPUDevice& d, typename TTypes<T>::ConstFlat input,     \
+      typename TTypes<double>::Vec accum);                         \
+  extern template struct NumericsAccumulate<GPUDevice, T>;
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+// The input stays in device memory, the output is the summary last read
+// back, in host memory.
+#define REGISTER_GPU_DEBUG_NUMERICS_MONITOR(type)         \
+  REGISTER_KERNEL_BUILDER(Name("DebugNumericsMonitor")    \
+                              .Device(DEVICE_GPU)         \
+                              .HostMemory("output")       \
+                              .TypeConstraint<type>("T"), \
+                          DebugNumericsMonitorOp<GPUDevice, type>);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_DEBUG_NUMERICS_MONITOR);
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensorflow
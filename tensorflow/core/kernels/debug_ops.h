@@ -19,12 +19,15 @@ limitations under the License.
 #if GOOGLE_CUDA
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #endif
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/debug/debug_io_utils.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/debug_ops_functor.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -116,6 +119,8 @@ class BaseDebugOp : public OpKernel {
   bool IsExpensive() override { return false; }
 
  protected:
+  const string& watch_key() const { return watch_key_; }
+
   // Apply gRPC gating (if gated_grpc_ attribute is true).
   //
   // Returns false if and only if all grpc:// debug URLs of the debug op are
@@ -342,6 +347,201 @@ class DebugNumericSummaryOp : public BaseDebugOp {
   bool mute_if_healthy_;
 };
 
+// Numerics monitor op for debugging.
+//   Accumulates the NaN and inf counts and the range of its inputs in device
+//   memory, and only reads them back to the host, asynchronously, every
+//   readback_interval steps, or every step after a read back summary showed
+//   non-finite elements, until one shows none. The step never waits for the
+//   device. The output is the latest summary read back.
+template <typename Device, typename T>
+class DebugNumericsMonitorOp : public BaseDebugOp {
+ public:
+  // The elements of the summary.
+  enum SummaryIndex {
+    kStepCount = 0,
+    kElementCount,
+    kNanCount,
+    kNegativeInfCount,
+    kPositiveInfCount,
+    kMin,
+    kMax,
+    kSummarySize,
+  };
+
+  explicit DebugNumericsMonitorOp(OpKernelConstruction* context)
+      : BaseDebugOp("DebugNumericsMonitor", context) {
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("readback_interval", &readback_interval_));
+    OP_REQUIRES(context, readback_interval_ > 0,
+                errors::InvalidArgument("readback_interval must be positive, "
+                                        "but is ",
+                                        readback_interval_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("mute_if_healthy", &mute_if_healthy_));
+    for (int i = 0; i < kSummarySize; ++i) {
+      last_summary_[i] = 0.0;
+    }
+  }
+
+  ~DebugNumericsMonitorOp() override {
+    // The read backs in flight call Report() on this kernel.
+    mutex_lock l(mu_);
+    while (num_pending_readbacks_ > 0) {
+      readback_done_.wait(l);
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    if (!ApplyGrpcGating(context)) {
+      return;
+    }
+
+    const Tensor& input = context->input(0);
+    const Device& d = context->eigen_device<Device>();
+    const TensorShape accum_shape({functor::kNumericsAccumulatorSize});
+    Tensor snapshot;
+    int64 num_steps = 0;
+    Tensor* output_tensor;
+    const TensorShape summary_shape({kSummarySize});
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, summary_shape, &output_tensor));
+    {
+      // Serializes the updates of the accumulator, which are enqueued on the
+      // stream of the device in order.
+      mutex_lock l(mu_);
+      if (!accum_.IsInitialized()) {
+        Tensor* accum;
+        OP_REQUIRES_OK(context, context->allocate_persistent(
+                                    DT_DOUBLE, accum_shape, &accum_, &accum));
+        ResetAccumulator(d, accum->vec<double>());
+      }
+      Tensor* accum = accum_.AccessTensor(context);
+      if (input.IsInitialized()) {
+        functor::NumericsAccumulate<Device, T>()(
+            d, input.template flat<T>(), accum->vec<double>());
+      }
+      ++num_steps_;
+      if (num_steps_ >= readback_interval_ || anomaly_) {
+        OP_REQUIRES_OK(context, context->allocate_temp(DT_DOUBLE, accum_shape,
+                                                       &snapshot));
+        snapshot.vec<double>().device(d) = accum->vec<double>();
+        ResetAccumulator(d, accum->vec<double>());
+        num_steps = num_steps_;
+        num_steps_ = 0;
+        ++num_pending_readbacks_;
+      }
+      for (int i = 0; i < kSummarySize; ++i) {
+        output_tensor->vec<double>()(i) = last_summary_[i];
+      }
+    }
+    if (num_steps > 0) {
+      ReadBack(context, snapshot, num_steps);
+    }
+  }
+
+ private:
+  static void ResetAccumulator(const Device& d,
+                               typename TTypes<double>::Vec accum) {
+    accum.device(d) = accum.constant(0.0);
+    accum.template chip<0>(functor::kNumericsMin).device(d) =
+        accum.template chip<0>(functor::kNumericsMin)
+            .constant(std::numeric_limits<double>::infinity());
+    accum.template chip<0>(functor::kNumericsMax).device(d) =
+        accum.template chip<0>(functor::kNumericsMax)
+            .constant(-std::numeric_limits<double>::infinity());
+  }
+
+  // Copies "snapshot", the accumulator of the last "num_steps" steps, to the
+  // host without waiting for it, and reports it once copied.
+  void ReadBack(OpKernelContext* context, const Tensor& snapshot,
+                int64 num_steps) {
+    DeviceContext* device_context = context->op_device_context();
+    if (device_context == nullptr) {
+      // The accumulator is in host memory.
+      Report(Status::OK(), snapshot, num_steps);
+      return;
+    }
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    attr.set_gpu_compatible(true);
+    Tensor* host_snapshot = new Tensor;
+    Status s = context->allocate_temp(DT_DOUBLE, snapshot.shape(),
+                                      host_snapshot, attr);
+    if (!s.ok()) {
+      delete host_snapshot;
+      Report(s, snapshot, num_steps);
+      return;
+    }
+    // "snapshot" is captured to keep its buffer alive until copied.
+    device_context->CopyDeviceTensorToCPU(
+        &snapshot, "", static_cast<::tensorflow::Device*>(context->device()),
+        host_snapshot,
+        [this, snapshot, host_snapshot, num_steps](const Status& s) {
+          Report(s, *host_snapshot, num_steps);
+          delete host_snapshot;
+        });
+  }
+
+  // Publishes the summary of "accum", a host accumulator of "num_steps"
+  // steps, unless it is healthy and mute_if_healthy_ is set.
+  void Report(const Status& s, const Tensor& accum, int64 num_steps) {
+    Tensor summary(DT_DOUBLE, TensorShape({kSummarySize}));
+    bool anomaly = false;
+    if (s.ok()) {
+      auto a = accum.vec<double>();
+      auto out = summary.vec<double>();
+      out(kStepCount) = num_steps;
+      out(kElementCount) = a(functor::kNumericsElementCount);
+      out(kNanCount) = a(functor::kNumericsNanCount);
+      out(kNegativeInfCount) = a(functor::kNumericsNegativeInfCount);
+      out(kPositiveInfCount) = a(functor::kNumericsPositiveInfCount);
+      out(kMin) = a(functor::kNumericsMin);
+      out(kMax) = a(functor::kNumericsMax);
+      anomaly = out(kNanCount) > 0 || out(kNegativeInfCount) > 0 ||
+                out(kPositiveInfCount) > 0;
+      if (anomaly) {
+        LOG(WARNING) << "Debug node of watch key " << watch_key()
+                     << " saw " << out(kNanCount) << " NaN, "
+                     << out(kNegativeInfCount) << " -inf and "
+                     << out(kPositiveInfCount) << " +inf elements in the last "
+                     << num_steps << " steps";
+      }
+    } else {
+      LOG(ERROR) << "Debug node of watch key " << watch_key()
+                 << " failed to read back its numerics: " << s;
+    }
+    {
+      mutex_lock l(mu_);
+      if (s.ok()) {
+        for (int i = 0; i < kSummarySize; ++i) {
+          last_summary_[i] = summary.vec<double>()(i);
+        }
+        anomaly_ = anomaly;
+      }
+    }
+    if (s.ok() && (anomaly || !mute_if_healthy_)) {
+      PublishTensor(summary);
+    }
+    mutex_lock l(mu_);
+    --num_pending_readbacks_;
+    readback_done_.notify_all();
+  }
+
+  int64 readback_interval_;
+  bool mute_if_healthy_;
+
+  mutex mu_;
+  condition_variable readback_done_;
+  // The accumulator in device memory, see NumericsAccumulatorIndex.
+  PersistentTensor accum_ GUARDED_BY(mu_);
+  // The number of steps accumulated in accum_.
+  int64 num_steps_ GUARDED_BY(mu_) = 0;
+  // True if the last summary read back has non-finite elements.
+  bool anomaly_ GUARDED_BY(mu_) = false;
+  double last_summary_[kSummarySize] GUARDED_BY(mu_);
+  int num_pending_readbacks_ GUARDED_BY(mu_) = 0;
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_DEBUG_OP_H_
@@ -0,0 +1,103 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_DEBUG_OPS_FUNCTOR_H_
+#define TENSORFLOW_KERNELS_DEBUG_OPS_FUNCTOR_H_
+// Functor definitions for DebugNumericsMonitorOp, must be compilable by nvcc.
+
+#include <limits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The elements of the accumulator of DebugNumericsMonitorOp.
+enum NumericsAccumulatorIndex {
+  kNumericsElementCount = 0,
+  kNumericsNanCount,
+  kNumericsNegativeInfCount,
+  kNumericsPositiveInfCount,
+  // Of the finite elements.
+  kNumericsMin,
+  kNumericsMax,
+  kNumericsAccumulatorSize,
+};
+
+// 1.0 if x is NaN, and 0.0 otherwise.
+template <typename T>
+struct NumericsIsNan {
+  typedef double result_type;
+  EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE double operator()(const T& x) const {
+    return Eigen::numext::isnan(x) ? 1.0 : 0.0;
+  }
+};
+
+// 1.0 if x is +inf (if positive) or -inf, and 0.0 otherwise.
+template <typename T, bool positive>
+struct NumericsIsInf {
+  typedef double result_type;
+  EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE double operator()(const T& x) const {
+    return Eigen::numext::isinf(x) && (static_cast<double>(x) > 0.0) == positive
+               ? 1.0
+               : 0.0;
+  }
+};
+
+// x if it is finite, and inf (if positive) or -inf otherwise, so that
+// non-finite elements do not change the min (max) of the elements.
+template <typename T, bool positive>
+struct NumericsFiniteOr {
+  typedef double result_type;
+  EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE double operator()(const T& x) const {
+    if (Eigen::numext::isnan(x) || Eigen::numext::isinf(x)) {
+      return positive ? std::numeric_limits<double>::infinity()
+                      : -std::numeric_limits<double>::infinity();
+    }
+    return static_cast<double>(x);
+  }
+};
+
+// Functor used by DebugNumericsMonitorOp to accumulate the numerics of its
+// inputs on the device that computed them.
+template <typename Device, typename T>
+struct NumericsAccumulate {
+  // accum: a vector of kNumericsAccumulatorSize elements, the accumulated
+  //        counts and range of the elements of "input" are added to.
+  void operator()(const Device& d, typename TTypes<T>::ConstFlat input,
+                  typename TTypes<double>::Vec accum) {
+    accum.template chip<0>(kNumericsElementCount).device(d) +=
+        accum.template chip<0>(kNumericsElementCount).constant(
+            static_cast<double>(input.size()));
+    accum.template chip<0>(kNumericsNanCount).device(d) +=
+        input.unaryExpr(NumericsIsNan<T>()).sum();
+    accum.template chip<0>(kNumericsNegativeInfCount).device(d) +=
+        input.unaryExpr(NumericsIsInf<T, false>()).sum();
+    accum.template chip<0>(kNumericsPositiveInfCount).device(d) +=
+        input.unaryExpr(NumericsIsInf<T, true>()).sum();
+    accum.template chip<0>(kNumericsMin).device(d) =
+        accum.template chip<0>(kNumericsMin)
+            .cwiseMin(input.unaryExpr(NumericsFiniteOr<T, true>()).minimum());
+    accum.template chip<0>(kNumericsMax).device(d) =
+        accum.template chip<0>(kNumericsMax)
+            .cwiseMax(input.unaryExpr(NumericsFiniteOr<T, false>()).maximum());
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_DEBUG_OPS_FUNCTOR_H_
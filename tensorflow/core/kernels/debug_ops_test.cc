@@ -619,4 +619,68 @@ TEST_F(DebugNumericSummaryOpCustomLowerUpperBoundsTest, Int32Success) {
   test::ExpectTensorNear<double>(expected, *GetOutput(0), 1e-8);
 }
 
+class DebugNumericsMonitorOpTest : public OpsTestBase {
+ protected:
+  Status Init(DataType input_type, int readback_interval) {
+    TF_CHECK_OK(NodeDefBuilder("op", "DebugNumericsMonitor")
+                    .Input(FakeInput(input_type))
+                    .Attr("tensor_name", "FakeTensor:0")
+                    .Attr("readback_interval", readback_interval)
+                    .Finalize(node_def()));
+    return InitOp();
+  }
+
+  void SetInput(const std::vector<float>& values) {
+    inputs_.clear();
+    AddInputFromArray<float>(TensorShape({static_cast<int64>(values.size())}),
+                             values);
+  }
+
+  void ExpectSummary(const std::vector<double>& summary) {
+    Tensor expected(allocator(), DT_DOUBLE, TensorShape({7}));
+    test::FillValues<double>(&expected, summary);
+    test::ExpectTensorEqual<double>(expected, *GetOutput(0));
+  }
+};
+
+TEST_F(DebugNumericsMonitorOpTest, ReadsBackEveryIntervalOrAfterAnomaly) {
+  TF_ASSERT_OK(Init(DT_FLOAT, 2));
+  const float kInf = std::numeric_limits<float>::infinity();
+  SetInput({1.0f, std::numeric_limits<float>::quiet_NaN(), -kInf, 3.0f});
+
+  // Nothing is read back before the end of the first interval.
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+
+  // The anomaly of the first interval makes the next steps read back every
+  // step, until one has no anomaly.
+  SetInput({2.0f, kInf});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({2.0, 8.0, 2.0, 2.0, 0.0, 1.0, 3.0});
+  SetInput({-1.0f, 0.5f});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({1.0, 2.0, 0.0, 0.0, 1.0, 2.0, 2.0});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({1.0, 2.0, 0.0, 0.0, 0.0, -1.0, 0.5});
+
+  // Back to one read back per interval.
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({1.0, 2.0, 0.0, 0.0, 0.0, -1.0, 0.5});
+  TF_ASSERT_OK(RunOpKernel());
+  ExpectSummary({2.0, 4.0, 0.0, 0.0, 0.0, -1.0, 0.5});
+}
+
+TEST_F(DebugNumericsMonitorOpTest, AllNonFinite) {
+  TF_ASSERT_OK(Init(DT_FLOAT, 1));
+  SetInput({std::numeric_limits<float>::quiet_NaN()});
+  TF_ASSERT_OK(RunOpKernel());
+  TF_ASSERT_OK(RunOpKernel());
+  // The range of no finite element is empty.
+  ExpectSummary({1.0, 1.0, 1.0, 0.0, 0.0,
+                 std::numeric_limits<double>::infinity(),
+                 -std::numeric_limits<double>::infinity()});
+}
+
 }  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <string.h>
+#include <algorithm>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,9 +23,57 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+namespace {
+
+// A field of a record, which points into the record.  If 'escaped' is true
+// the field is quoted and its quotes are doubled.
+struct Field {
+  StringPiece text;
+  bool escaped = false;
+};
+
+// Returns the text of 'field' with its doubled quotes collapsed.
+string Unescape(const Field& field) {
+  if (!field.escaped) return field.text.ToString();
+  string result;
+  result.reserve(field.text.size());
+  for (size_t i = 0; i < field.text.size(); ++i) {
+    result += field.text[i];
+    // Inside an escaped field every quote is followed by another.
+    if (field.text[i] == '"') ++i;
+  }
+  return result;
+}
+
+// Parses 'field' as a float, copying it to a buffer on the stack unless it is
+// long, since safe_strtof expects a NUL-terminated string.
+bool ParseFloat(const Field& field, float* value) {
+  char buffer[64];
+  if (!field.escaped && field.text.size() < sizeof(buffer)) {
+    memcpy(buffer, field.text.data(), field.text.size());
+    buffer[field.text.size()] = '\0';
+    return strings::safe_strtof(buffer, value);
+  }
+  return strings::safe_strtof(Unescape(field).c_str(), value);
+}
+
+bool ParseInt32(const Field& field, int32* value) {
+  if (!field.escaped) return strings::safe_strto32(field.text, value);
+  return strings::safe_strto32(Unescape(field), value);
+}
+
+bool ParseInt64(const Field& field, int64* value) {
+  if (!field.escaped) return strings::safe_strto64(field.text, value);
+  return strings::safe_strto64(Unescape(field), value);
+}
+
+}  // namespace
+
 class DecodeCSVOp : public OpKernel {
  public:
   explicit DecodeCSVOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
@@ -65,173 +115,186 @@ class DecodeCSVOp : public OpKernel {
       OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int32: ",
-                                                  fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int64: ",
-                                                  fields[f]));
-              output[f]->flat<int64>()(i) = value;
-            }
-            break;
-          }
-          case DT_FLOAT: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid float: ",
-                                                  fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
+    // The records are decoded in parallel, each directly into its position in
+    // the outputs.  The error reported is the one of the first failed record.
+    mutex mu;
+    int64 error_record = records_size;
+    Status error;
+    auto decode = [&](int64 start, int64 limit) {
+      std::vector<Field> fields;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = DecodeRecord(records_t(i), i, record_defaults, &output,
+                                &fields);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < error_record) {
+            error_record = i;
+            error = s;
           }
-          case DT_STRING: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
-            }
-            break;
-          }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
+    };
+    int64 total_bytes = 0;
+    for (int64 i = 0; i < records_size; ++i) {
+      total_bytes += records_t(i).size();
     }
+    const int64 cost_per_record =
+        10 * (total_bytes / std::max<int64>(1, records_size)) +
+        50 * out_type_.size();
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          cost_per_record, &cost_estimator_, decode);
+    OP_REQUIRES_OK(ctx, error);
   }
 
  private:
   std::vector<DataType> out_type_;
   char delim_;
+  // Corrects cost_per_record, which only guesses the cost of parsing.
+  ShardCostEstimator cost_estimator_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+  // Decodes 'record', the i-th one, into the i-th element of each output.
+  // 'fields' is scratch space.
+  Status DecodeRecord(StringPiece record, int64 i,
+                      const OpInputList& record_defaults, OpOutputList* output,
+                      std::vector<Field>* fields) const {
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
 
-        bool quoted = false;
-        if (input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const Field& field = (*fields)[f];
+      const DataType& dtype = out_type_[f];
+      // If this field is empty, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (field.text.empty() && record_defaults[f].NumElements() != 1) {
+        return errors::InvalidArgument(
+            "Field ", f, " is required but missing in record ", i, "!");
+      }
+      switch (dtype) {
+        case DT_INT32: {
+          int32& value = (*output)[f]->flat<int32>()(i);
+          if (field.text.empty()) {
+            value = record_defaults[f].flat<int32>()(0);
+          } else if (!ParseInt32(field, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int32: ",
+                                           Unescape(field));
+          }
+          break;
+        }
+        case DT_INT64: {
+          int64& value = (*output)[f]->flat<int64>()(i);
+          if (field.text.empty()) {
+            value = record_defaults[f].flat<int64>()(0);
+          } else if (!ParseInt64(field, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int64: ",
+                                           Unescape(field));
+          }
+          break;
+        }
+        case DT_FLOAT: {
+          float& value = (*output)[f]->flat<float>()(i);
+          if (field.text.empty()) {
+            value = record_defaults[f].flat<float>()(0);
+          } else if (!ParseFloat(field, &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid float: ",
+                                           Unescape(field));
+          }
+          break;
+        }
+        case DT_STRING: {
+          string& value = (*output)[f]->flat<string>()(i);
+          if (field.text.empty()) {
+            value = record_defaults[f].flat<string>()(0);
+          } else if (!field.escaped) {
+            value.assign(field.text.data(), field.text.size());
+          } else {
+            value = Unescape(field);
+          }
+          break;
         }
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
+      }
+    }
+    return Status::OK();
+  }
 
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx, input[current_idx] != '"' &&
-                                 input[current_idx] != '\n' &&
-                                 input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
-            current_idx++;
+  // Splits 'input' into the fields in 'result', which point into 'input'.
+  Status ExtractFields(StringPiece input, std::vector<Field>* result) const {
+    result->clear();
+    if (input.empty()) return Status::OK();
+
+    const char* data = input.data();
+    const size_t size = input.size();
+    size_t current_idx = 0;
+    while (current_idx < size) {
+      if (data[current_idx] == '\n' || data[current_idx] == '\r') {
+        current_idx++;
+        continue;
+      }
+
+      Field field;
+      if (data[current_idx] != '"') {
+        // Find the end of the field with memchr, which the C library
+        // vectorizes, then check its body.
+        const char* delim = static_cast<const char*>(
+            memchr(data + current_idx, delim_, size - current_idx));
+        const size_t end = delim == nullptr ? size : delim - data;
+        for (size_t j = current_idx; j < end; ++j) {
+          if (data[j] == '"' || data[j] == '\n' || data[j] == '\r') {
+            return errors::InvalidArgument(
+                "Unquoted fields cannot have quotes/CRLFs inside");
           }
+        }
+        field.text = StringPiece(data + current_idx, end - current_idx);
 
-          // Go to next field or the end
-          current_idx++;
-        } else {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
+        // Go to next field or the end
+        current_idx = end + 1;
+      } else {
+        // Quoted field needs to be ended with '"' and delim or end
+        current_idx++;
+        const size_t begin = current_idx;
+        while (current_idx + 1 < size &&
+               (data[current_idx] != '"' || data[current_idx + 1] != delim_)) {
+          if (data[current_idx] != '"') {
+            current_idx++;
+          } else {
+            if (data[current_idx + 1] != '"') {
+              return errors::InvalidArgument(
+                  "Quote inside a string has to be escaped by another quote");
             }
+            field.escaped = true;
+            current_idx += 2;
           }
+        }
 
-          OP_REQUIRES(
-              ctx, (static_cast<size_t>(current_idx) < input.size() &&
-                    input[current_idx] == '"' &&
-                    (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                     input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
-
-          current_idx += 2;
+        if (!(current_idx < size && data[current_idx] == '"' &&
+              (current_idx == size - 1 || data[current_idx + 1] == delim_))) {
+          return errors::InvalidArgument(
+              "Quoted field has to end with quote followed by delim or end");
         }
+        field.text = StringPiece(data + begin, current_idx - begin);
 
-        result->push_back(field);
+        current_idx += 2;
       }
 
-      // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
+      result->push_back(field);
     }
+
+    // Check if the last field is missing
+    if (data[size - 1] == delim_) result->push_back(Field());
+    return Status::OK();
   }
 };
 
@@ -92,15 +92,12 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
 
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
-// TODO(andydavis) Add support for other filter sizes and strides.
-// TODO(andydavis) Add support for autotuning.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols) {
   // Check if convolution parameters are supported.
-  // TODO(andydavis) Add support for multiple filter sizes and strides.
-  if (stride_rows > 1 || stride_cols > 1 || filter_rows != 3 ||
-      filter_cols != 3) {
+  if (!DeepConv2DSupports(stride_rows, stride_cols, filter_rows,
+                          filter_cols)) {
     return false;
   }
 
@@ -127,6 +124,18 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   return deep_conv_cost < direct_conv_cost;
 }
 
+// TODO(andydavis) Add support for multiple filter sizes and strides.
+bool DeepConv2DSupports(int stride_rows, int stride_cols, int filter_rows,
+                        int filter_cols) {
+  return stride_rows == 1 && stride_cols == 1 && filter_rows == 3 &&
+         filter_cols == 3;
+}
+
+// NOTE: IF this environment variable name changes, update conv_ops_test.py.
+bool CpuConvUseAutotune() {
+  return ReadBoolFromEnvVar("TF_CPU_CONV_USE_AUTOTUNE", false);
+}
+
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
 // Copies data from 'filter_in' to 'filter_buf' along 'in_depth' dimension.
@@ -936,8 +945,12 @@ template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
                   const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+    std::unique_ptr<DeepConv2DTransform<T>> transform;
+    if (args.transform == DeepConv2DTransformType::kWinogradF4x4) {
+      transform.reset(new WinogradF4x4Transform<T>);
+    } else {
+      transform.reset(new WinogradTransform<T>);
+    }
 
     const int64 in_depth = args.in_depth;
     const int64 out_depth = args.out_depth;
@@ -63,6 +63,14 @@ class DeepConv2DTransform {
   virtual const Shape& output_shape() const = 0;
 };
 
+// The transforms DeepConv2D can compute convolutions with.
+enum class DeepConv2DTransformType {
+  // Winograd F(2x2, 3x3), see WinogradTransform.
+  kWinogradF2x2,
+  // Winograd F(4x4, 3x3), see WinogradF4x4Transform.
+  kWinogradF4x4,
+};
+
 // Conv2D arguments used by DeepConv2D implementation.
 struct Conv2DArgs {
   // Input layer dimensions
@@ -80,6 +88,9 @@ struct Conv2DArgs {
   int out_cols;
   int out_depth;
 
+  // The transform to compute the convolution with.
+  DeepConv2DTransformType transform;
+
   Conv2DArgs()
       : batch(0),
         in_rows(0),
@@ -91,7 +102,8 @@ struct Conv2DArgs {
         pad_cols(0),
         out_rows(0),
         out_cols(0),
-        out_depth(0) {}
+        out_depth(0),
+        transform(DeepConv2DTransformType::kWinogradF2x2) {}
 };
 
 // Returns true if convolution operation specified by function arguments
@@ -101,6 +113,16 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
                       int out_rows, int out_cols);
 
+// Returns true if the transforms of DeepConv2D can compute the convolution
+// specified by function arguments, whatever its cost.
+bool DeepConv2DSupports(int stride_rows, int stride_cols, int filter_rows,
+                        int filter_cols);
+
+// Returns true if Conv2D on CPU should pick its algorithm among the Eigen
+// convolution and the DeepConv2D transforms by timing them on each shape,
+// which the environment variable TF_CPU_CONV_USE_AUTOTUNE enables.
+bool CpuConvUseAutotune();
+
 namespace functor {
 
 // Calls DeepConv2D implementation (see deep_conv2d.cc for details).
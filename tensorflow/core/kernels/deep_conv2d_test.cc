@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <vector>
+
 #include "tensorflow/core/kernels/winograd_transform.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -155,5 +157,110 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+// Checks that 'transform' computes the correlation of an input tile with a
+// filter, as y = C[Ad * Bg].
+static void TestTransformComputesCorrelation(
+    const DeepConv2DTransform<float>& transform) {
+  const int filter_rows = transform.filter_shape().rows;
+  const int filter_cols = transform.filter_shape().cols;
+  const int tile_rows = transform.input_shape().rows;
+  const int tile_cols = transform.input_shape().cols;
+  const int out_rows = transform.output_shape().rows;
+  const int out_cols = transform.output_shape().cols;
+  const int filter_size = filter_rows * filter_cols;
+  const int tile_size = tile_rows * tile_cols;
+  const int out_size = out_rows * out_cols;
+
+  std::vector<float> filter_transform(tile_size * filter_size);
+  transform.GetFilterTransformMatrix(tile_size, filter_size,
+                                     filter_transform.data());
+  std::vector<float> input_transform(tile_size * tile_size);
+  transform.GetInputTransformMatrix(tile_size, tile_size,
+                                    input_transform.data());
+  std::vector<float> output_transform(out_size * tile_size);
+  transform.GetOutputTransformMatrix(out_size, tile_size,
+                                     output_transform.data());
+
+  std::vector<float> tile(tile_size);
+  for (int i = 0; i < tile_size; ++i) tile[i] = (i * 7 % 11) / 11.0f - 0.5f;
+  std::vector<float> filter(filter_size);
+  for (int i = 0; i < filter_size; ++i) filter[i] = (i * 5 % 9) / 9.0f - 0.3f;
+
+  // The products of the transformed tile and filter.
+  std::vector<float> products(tile_size);
+  for (int i = 0; i < tile_size; ++i) {
+    float ad = 0.0f;
+    for (int j = 0; j < tile_size; ++j) {
+      ad += input_transform[i * tile_size + j] * tile[j];
+    }
+    float bg = 0.0f;
+    for (int j = 0; j < filter_size; ++j) {
+      bg += filter_transform[i * filter_size + j] * filter[j];
+    }
+    products[i] = ad * bg;
+  }
+
+  for (int r = 0; r < out_rows; ++r) {
+    for (int c = 0; c < out_cols; ++c) {
+      float expected = 0.0f;
+      for (int fr = 0; fr < filter_rows; ++fr) {
+        for (int fc = 0; fc < filter_cols; ++fc) {
+          expected += tile[(r + fr) * tile_cols + c + fc] *
+                      filter[fr * filter_cols + fc];
+        }
+      }
+      float y = 0.0f;
+      for (int j = 0; j < tile_size; ++j) {
+        y += output_transform[(r * out_cols + c) * tile_size + j] *
+             products[j];
+      }
+      EXPECT_NEAR(expected, y, 1e-5) << "output " << r << ", " << c;
+    }
+  }
+}
+
+TEST(DeepConv2DTransformTest, WinogradComputesCorrelation) {
+  TestTransformComputesCorrelation(WinogradTransform<float>());
+}
+
+TEST(DeepConv2DTransformTest, WinogradF4x4ComputesCorrelation) {
+  TestTransformComputesCorrelation(WinogradF4x4Transform<float>());
+}
+
+TEST(DeepConv2DTransformTest, WinogradF4x4InputTransformMatrix) {
+  // Test that the input transform matrix returned is the kronecker product of
+  // the following matrix:
+  //
+  //   [4   0  -5   0   1   0]
+  //   [0  -4  -4   1   1   0]
+  //   [0   4  -4  -1   1   0]
+  //   [0  -2  -1   2   1   0]
+  //   [0   2  -1  -2   1   0]
+  //   [0   4   0  -5   0   1]
+  //
+  const int rows = 6;
+  const int cols = 6;
+
+  float transform_matrix[] = {4, 0,  -5, 0,  1, 0, 0, -4, -4, 1,  1, 0,
+                              0, 4,  -4, -1, 1, 0, 0, -2, -1, 2,  1, 0,
+                              0, 2,  -1, -2, 1, 0, 0, 4,  0,  -5, 0, 1};
+
+  const int kron_rows = rows * rows;
+  const int kron_cols = cols * cols;
+
+  float transform_matrix_kron[kron_rows * kron_cols];
+
+  ComputeKroneckerProduct(rows, cols, &transform_matrix[0],
+                          &transform_matrix_kron[0]);
+
+  float transform_matrix_test[kron_rows * kron_cols];
+  WinogradF4x4Transform<float> t;
+  t.GetInputTransformMatrix(kron_rows, kron_cols, &transform_matrix_test[0]);
+
+  for (int i = 0; i < kron_rows * kron_cols; ++i) {
+    EXPECT_FLOAT_EQ(transform_matrix_kron[i], transform_matrix_test[i]);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -141,6 +141,103 @@ struct DepthwiseConv2DKernel {
   }
 };
 
+// Computes the output row 'out_r' of one image into 'output' when
+// 'args.depth_multiplier' is 1, reading 'input' and 'filter' in place.
+//
+// Each output channel then only depends on the same input channel, so the
+// packets of consecutive channels of the input pixels under the filter are
+// multiplied by the packets of the same channels of the filter taps, without
+// the input copies and filter padding of DepthwiseConv2DKernel. The channels
+// are the outer loop, so that the filter packets of a 3x3 filter, the most
+// common one, are loaded once per row and stay in registers across the row.
+template <typename T>
+struct DepthwiseConv2DDirectKernel {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+
+  static void Run(const DepthwiseArgs& args, const int64 out_r, const T* input,
+                  const T* filter, T* output) {
+    static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+    const int64 depth = args.in_depth;
+    const int64 vectorized_depth = (depth / kPacketSize) * kPacketSize;
+    const int64 in_r_start = out_r * args.stride - args.pad_rows;
+    // The filter rows over the input, the others being padding.
+    const int64 f_r_start = std::max<int64>(0, -in_r_start);
+    const int64 f_r_end = std::min<int64>(args.filter_rows,
+                                          args.in_rows - in_r_start);
+    const bool full_rows = f_r_start == 0 && f_r_end == args.filter_rows;
+    const bool is_3x3 = args.filter_rows == 3 && args.filter_cols == 3;
+    T* output_row = output + out_r * args.out_cols * depth;
+
+    for (int64 d = 0; d < vectorized_depth; d += kPacketSize) {
+      Packet taps[9];
+      if (is_3x3) {
+        for (int i = 0; i < 9; ++i) {
+          taps[i] = Eigen::internal::ploadu<Packet>(filter + i * depth + d);
+        }
+      }
+      for (int64 out_c = 0; out_c < args.out_cols; ++out_c) {
+        const int64 in_c_start = out_c * args.stride - args.pad_cols;
+        const int64 f_c_start = std::max<int64>(0, -in_c_start);
+        const int64 f_c_end = std::min<int64>(args.filter_cols,
+                                              args.in_cols - in_c_start);
+        Packet acc = Eigen::internal::pset1<Packet>(0);
+        if (is_3x3 && full_rows && f_c_start == 0 && f_c_end == 3) {
+          const T* in =
+              input + (in_r_start * args.in_cols + in_c_start) * depth + d;
+          const int64 row_stride = args.in_cols * depth;
+          for (int f_r = 0; f_r < 3; ++f_r) {
+            acc = Eigen::internal::pmadd<Packet>(
+                taps[f_r * 3], Eigen::internal::ploadu<Packet>(in), acc);
+            acc = Eigen::internal::pmadd<Packet>(
+                taps[f_r * 3 + 1],
+                Eigen::internal::ploadu<Packet>(in + depth), acc);
+            acc = Eigen::internal::pmadd<Packet>(
+                taps[f_r * 3 + 2],
+                Eigen::internal::ploadu<Packet>(in + 2 * depth), acc);
+            in += row_stride;
+          }
+        } else {
+          for (int64 f_r = f_r_start; f_r < f_r_end; ++f_r) {
+            for (int64 f_c = f_c_start; f_c < f_c_end; ++f_c) {
+              const int64 in_index =
+                  ((in_r_start + f_r) * args.in_cols + in_c_start + f_c) *
+                      depth +
+                  d;
+              const int64 filter_index =
+                  (f_r * args.filter_cols + f_c) * depth + d;
+              acc = Eigen::internal::pmadd<Packet>(
+                  Eigen::internal::ploadu<Packet>(filter + filter_index),
+                  Eigen::internal::ploadu<Packet>(input + in_index), acc);
+            }
+          }
+        }
+        Eigen::internal::pstoreu<T>(output_row + out_c * depth + d, acc);
+      }
+    }
+
+    // The channels left after the packets.
+    for (int64 d = vectorized_depth; d < depth; ++d) {
+      for (int64 out_c = 0; out_c < args.out_cols; ++out_c) {
+        const int64 in_c_start = out_c * args.stride - args.pad_cols;
+        const int64 f_c_start = std::max<int64>(0, -in_c_start);
+        const int64 f_c_end = std::min<int64>(args.filter_cols,
+                                              args.in_cols - in_c_start);
+        T acc = 0;
+        for (int64 f_r = f_r_start; f_r < f_r_end; ++f_r) {
+          for (int64 f_c = f_c_start; f_c < f_c_end; ++f_c) {
+            acc += filter[(f_r * args.filter_cols + f_c) * depth + d] *
+                   input[((in_r_start + f_r) * args.in_cols + in_c_start +
+                          f_c) *
+                             depth +
+                         d];
+          }
+        }
+        output_row[out_c * depth + d] = acc;
+      }
+    }
+  }
+};
+
 // Computes the depthwise conv2d of 'input' by 'depthwise_filter' and stores
 // the result in 'output'. This implementation trades off copying small patches
 // of the input to achieve better data alignment, which enables vectorized
@@ -164,6 +261,29 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
         errors::Unimplemented(
             "Depthwise convolution on CPU is only supported for NHWC format"));
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+    const int64 total_shards = args.batch * args.out_rows;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+
+    if (args.depth_multiplier == 1) {
+      auto direct_shard = [&args, input, depthwise_filter, output](
+                              int64 start, int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.out_rows;
+          DepthwiseConv2DDirectKernel<T>::Run(
+              args, i % args.out_rows, input + b * input_image_size,
+              depthwise_filter, output + b * output_image_size);
+        }
+      };
+      const int64 direct_shard_cost = args.out_cols * args.out_depth *
+                                      args.filter_rows * args.filter_cols;
+      Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
+            direct_shard_cost, direct_shard);
+      return;
+    }
 
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
@@ -227,8 +347,6 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
       }
     };
 
-    const int64 total_shards = args.batch * args.out_rows;
-
     // Empirically tested to give reasonable performance boosts at batch size 1
     // without reducing throughput at batch size 32.
     const float kCostMultiplier = 2.5f;
@@ -237,7 +355,6 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
     // flops/loads/stores required to compute one shard.
     const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
 
-    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
           shard_cost, shard);
   }
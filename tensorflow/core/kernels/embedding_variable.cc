@@ -0,0 +1,121 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/embedding_variable.h"
+
+#include <string.h>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+namespace lookup {
+
+EmbeddingVariable::EmbeddingVariable(OpKernelContext* ctx, OpKernel* kernel) {
+  TensorShape value_shape;
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "value_shape", &value_shape));
+  OP_REQUIRES(ctx, TensorShapeUtils::IsVector(value_shape),
+              errors::InvalidArgument("Value shape must be a vector, got ",
+                                      value_shape.DebugString()));
+  dim_ = value_shape.dim_size(0);
+  OP_REQUIRES_OK(ctx,
+                 GetNodeAttr(kernel->def(), "initial_value", &initial_value_));
+  OP_REQUIRES_OK(ctx,
+                 GetNodeAttr(kernel->def(), "initial_scale", &initial_scale_));
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "seed", &seed_));
+}
+
+void EmbeddingVariable::InitializeRow(int64 id, Row* row) const {
+  row->resize(dim_);
+  const uint64 id_hash = Hash64Combine(seed_, id);
+  for (int64 j = 0; j < dim_; ++j) {
+    // The top 24 bits of the hash, as a float in [0, 1).
+    const float uniform =
+        static_cast<float>(Hash64Combine(id_hash, j) >> 40) / (1 << 24);
+    (*row)[j] = initial_value_ + initial_scale_ * (2 * uniform - 1);
+  }
+}
+
+void EmbeddingVariable::Gather(const int64* ids, int64 n, float* rows) {
+  const int64 dim = dim_;
+  Update(ids, n, [rows, dim](int64 i, const float* row) {
+    memcpy(rows + i * dim, row, dim * sizeof(float));
+  });
+}
+
+Status EmbeddingVariable::Find(OpKernelContext* ctx, const Tensor& keys,
+                               Tensor* values, const Tensor& default_value) {
+  const auto key_values = keys.flat<int64>();
+  Gather(key_values.data(), key_values.size(), values->flat<float>().data());
+  return Status::OK();
+}
+
+Status EmbeddingVariable::Insert(OpKernelContext* ctx, const Tensor& keys,
+                                 const Tensor& values) {
+  const auto key_values = keys.flat<int64>();
+  const auto value_values = values.flat_inner_dims<float, 2>();
+  const int64 dim = dim_;
+  Update(key_values.data(), key_values.size(),
+         [&value_values, dim](int64 i, float* row) {
+           for (int64 j = 0; j < dim; ++j) {
+             row[j] = value_values(i, j);
+           }
+         });
+  return Status::OK();
+}
+
+Status EmbeddingVariable::ExportValues(OpKernelContext* ctx) {
+  const int64 dim = dim_;
+  Tensor* keys;
+  Tensor* values;
+  return table_.Export(
+      [ctx, dim, &keys, &values](int64 size) {
+        TF_RETURN_IF_ERROR(
+            ctx->allocate_output("keys", TensorShape({size}), &keys));
+        return ctx->allocate_output("values", TensorShape({size, dim}),
+                                    &values);
+      },
+      [&keys, &values, dim](int64 i, const int64& key, const Row& row) {
+        keys->flat<int64>()(i) = key;
+        memcpy(values->flat<float>().data() + i * dim, row.data(),
+               dim * sizeof(float));
+      });
+}
+
+Status EmbeddingVariable::ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                                       const Tensor& values) {
+  const auto key_values = keys.flat<int64>();
+  const auto value_values = values.flat_inner_dims<float, 2>();
+  const int64 dim = dim_;
+  table_.Assign(key_values.data(), key_values.size(),
+                [&value_values, dim](int64 i, Row* row) {
+                  row->resize(dim);
+                  for (int64 j = 0; j < dim; ++j) {
+                    (*row)[j] = value_values(i, j);
+                  }
+                });
+  return Status::OK();
+}
+
+int64 EmbeddingVariable::MemoryUsed() const {
+  // Rows that do not fit in a Row are allocated out of line.
+  const int64 out_of_line_bytes =
+      dim_ * sizeof(float) > sizeof(Row) ? dim_ * sizeof(float) : 0;
+  return size() * (sizeof(int64) + sizeof(Row) + out_of_line_bytes);
+}
+
+}  // namespace lookup
+}  // namespace tensorflow
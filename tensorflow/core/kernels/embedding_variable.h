@@ -0,0 +1,113 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_EMBEDDING_VARIABLE_H_
+#define TENSORFLOW_KERNELS_EMBEDDING_VARIABLE_H_
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A variable of float rows keyed by int64 ids, which only holds the rows of
+// the ids it has seen: the row of an id is created the first time the id is
+// looked up or updated, so the memory of the variable grows with the number
+// of distinct ids rather than with the range of ids.
+//
+// A new row is initialized to initial_value plus a uniform noise in
+// [-initial_scale, initial_scale) that is a hash of the seed, the id and the
+// position in the row, so it does not depend on when the row is created.
+//
+// As a LookupInterface, Find looks rows up like Gather (ignoring the default
+// value), and ExportValues and ImportValues read and replace all the rows,
+// which lets the lookup table ops and savers checkpoint the live rows.
+class EmbeddingVariable final : public LookupInterface {
+ public:
+  EmbeddingVariable(OpKernelContext* ctx, OpKernel* kernel);
+
+  // The number of elements of each row.
+  int64 dim() const { return dim_; }
+
+  // Copies the rows of the `n` ids into the n x dim() matrix `rows`, creating
+  // the rows that do not exist yet.
+  void Gather(const int64* ids, int64 n, float* rows);
+
+  // Calls fn(i, row) for each of the `n` ids, where row points to the dim()
+  // elements of the row of ids[i], created if needed.  No other call reads or
+  // updates the row during fn, and the calls for repeated ids are made in the
+  // order of the ids.
+  template <typename Fn>
+  void Update(const int64* ids, int64 n, Fn fn) {
+    table_.Insert(ids, n, [this, ids, &fn](int64 i, Row* row) {
+      if (row->empty()) {
+        InitializeRow(ids[i], row);
+      }
+      fn(i, row->data());
+    });
+  }
+
+  // Implementations of LookupInterface methods --------------------------------
+
+  size_t size() const override { return table_.size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& keys, Tensor* values,
+              const Tensor& default_value) override;
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override;
+
+  Status ExportValues(OpKernelContext* ctx) override;
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override;
+
+  DataType key_dtype() const override { return DT_INT64; }
+
+  DataType value_dtype() const override { return DT_FLOAT; }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape({dim_}); }
+
+  int64 MemoryUsed() const override;
+
+  EmbeddingVariable* GetEmbeddingVariable() override { return this; }
+
+ private:
+  typedef gtl::InlinedVector<float, 4> Row;
+
+  void InitializeRow(int64 id, Row* row) const;
+
+  int64 dim_ = 0;
+  float initial_value_ = 0;
+  float initial_scale_ = 0;
+  int64 seed_ = 0;
+  ShardedHashMap<int64, Row> table_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EmbeddingVariable);
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_EMBEDDING_VARIABLE_H_
@@ -0,0 +1,172 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/data_flow_ops.cc.
+
+#include <math.h>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/embedding_variable.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/lookup_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+REGISTER_KERNEL_BUILDER(
+    Name("EmbeddingVariable").Device(DEVICE_CPU),
+    LookupTableOp<lookup::EmbeddingVariable, int64, float>);
+
+class EmbeddingVariableGatherOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableGatherOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::EmbeddingVariable* var;
+    OP_REQUIRES_OK(ctx, lookup::GetEmbeddingVariable("resource", ctx, &var));
+    core::ScopedUnref unref_me(var);
+
+    const Tensor& ids = ctx->input(1);
+    TensorShape output_shape = ids.shape();
+    output_shape.AddDim(var->dim());
+    Tensor* out;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &out));
+    const auto ids_flat = ids.flat<int64>();
+    var->Gather(ids_flat.data(), ids_flat.size(), out->flat<float>().data());
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("EmbeddingVariableGather").Device(DEVICE_CPU),
+                        EmbeddingVariableGatherOp);
+
+// Checks the learning rate, gradient and indices inputs of the sparse apply
+// ops of an embedding variable of rows of `dim` elements.
+static Status CheckSparseApplyInputs(const Tensor& lr, const Tensor& grad,
+                                     const Tensor& indices, int64 dim) {
+  if (!TensorShapeUtils::IsScalar(lr.shape())) {
+    return errors::InvalidArgument("lr is not a scalar: ",
+                                   lr.shape().DebugString());
+  }
+  if (!TensorShapeUtils::IsVector(indices.shape())) {
+    return errors::InvalidArgument("indices must be one-dimensional");
+  }
+  if (!TensorShapeUtils::IsMatrix(grad.shape()) ||
+      grad.dim_size(0) != indices.dim_size(0) || grad.dim_size(1) != dim) {
+    return errors::InvalidArgument(
+        "grad must be a matrix of a row of ", dim,
+        " elements for each of the indices, got shape ",
+        grad.shape().DebugString(), " for ", indices.dim_size(0), " indices");
+  }
+  return Status::OK();
+}
+
+class EmbeddingVariableSparseApplyGradientDescentOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableSparseApplyGradientDescentOp(
+      OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::EmbeddingVariable* var;
+    OP_REQUIRES_OK(ctx, lookup::GetEmbeddingVariable("var", ctx, &var));
+    core::ScopedUnref unref_var(var);
+
+    const Tensor& alpha = ctx->input(1);
+    const Tensor& grad = ctx->input(2);
+    const Tensor& indices = ctx->input(3);
+    const int64 dim = var->dim();
+    OP_REQUIRES_OK(ctx, CheckSparseApplyInputs(alpha, grad, indices, dim));
+
+    const float alpha_scalar = alpha.scalar<float>()();
+    const auto grad_matrix = grad.matrix<float>();
+    const auto indices_vec = indices.vec<int64>();
+    var->Update(indices_vec.data(), indices_vec.size(),
+                [&grad_matrix, alpha_scalar, dim](int64 i, float* v) {
+                  for (int64 j = 0; j < dim; ++j) {
+                    v[j] -= alpha_scalar * grad_matrix(i, j);
+                  }
+                });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("EmbeddingVariableSparseApplyGradientDescent").Device(DEVICE_CPU),
+    EmbeddingVariableSparseApplyGradientDescentOp);
+
+class EmbeddingVariableSparseApplyAdagradOp : public OpKernel {
+ public:
+  explicit EmbeddingVariableSparseApplyAdagradOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::EmbeddingVariable* var;
+    OP_REQUIRES_OK(ctx, lookup::GetEmbeddingVariable("var", ctx, &var));
+    core::ScopedUnref unref_var(var);
+    lookup::EmbeddingVariable* accum;
+    OP_REQUIRES_OK(ctx, lookup::GetEmbeddingVariable("accum", ctx, &accum));
+    core::ScopedUnref unref_accum(accum);
+    OP_REQUIRES(ctx, var != accum,
+                errors::InvalidArgument("var and accum must be different"));
+    OP_REQUIRES(ctx, accum->dim() == var->dim(),
+                errors::InvalidArgument(
+                    "var and accum do not have the same row size: ",
+                    var->dim(), " vs. ", accum->dim()));
+
+    const Tensor& lr = ctx->input(2);
+    const Tensor& grad = ctx->input(3);
+    const Tensor& indices = ctx->input(4);
+    const int64 dim = var->dim();
+    OP_REQUIRES_OK(ctx, CheckSparseApplyInputs(lr, grad, indices, dim));
+
+    const float lr_scalar = lr.scalar<float>()();
+    const auto grad_matrix = grad.matrix<float>();
+    const auto indices_vec = indices.vec<int64>();
+    const int64 n = indices_vec.size();
+
+    // The rows of accum and var are updated one after the other, so that the
+    // shards of both are never locked at the same time.  accum_rows keeps the
+    // row of accum after each update, which the update of var at the same
+    // position uses.
+    Tensor accum_rows;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, TensorShape({n, dim}),
+                                           &accum_rows));
+    auto accum_matrix = accum_rows.matrix<float>();
+    accum->Update(indices_vec.data(), n,
+                  [&grad_matrix, &accum_matrix, dim](int64 i, float* a) {
+                    for (int64 j = 0; j < dim; ++j) {
+                      const float g = grad_matrix(i, j);
+                      a[j] += g * g;
+                      accum_matrix(i, j) = a[j];
+                    }
+                  });
+    var->Update(indices_vec.data(), n,
+                [&grad_matrix, &accum_matrix, lr_scalar, dim](int64 i,
+                                                              float* v) {
+                  for (int64 j = 0; j < dim; ++j) {
+                    v[j] -= lr_scalar * grad_matrix(i, j) /
+                            sqrtf(accum_matrix(i, j));
+                  }
+                });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("EmbeddingVariableSparseApplyAdagrad").Device(DEVICE_CPU),
+    EmbeddingVariableSparseApplyAdagradOp);
+
+}  // namespace tensorflow
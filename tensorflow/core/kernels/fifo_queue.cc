@@ -19,6 +19,7 @@ limitations under the License.
 #include <deque>
 #include <vector>
 
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
@@ -315,9 +316,12 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                       const TensorShape shape =
                           ManyOutShape(i, attempt->elements_requested);
                       Tensor element;
+                      // The batch becomes output i of the op, allocated as
+                      // the output, e.g. in pinned memory for a GPU.
                       attempt->context->SetStatus(
-                          attempt->context->allocate_temp(component_dtypes_[i],
-                                                          shape, &element));
+                          attempt->context->allocate_temp(
+                              component_dtypes_[i], shape, &element,
+                              attempt->context->output_alloc_attr(i)));
                       if (!attempt->context->status().ok()) return kComplete;
                       attempt->tuple.emplace_back(element);
                     }
@@ -359,6 +363,11 @@ Status FIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
       !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
     return errors::InvalidArgument("Expected FIFOQueue, found ", node_def.op());
   }
+  bool lock_free = false;
+  if (GetNodeAttr(node_def, "lock_free", &lock_free).ok() && lock_free) {
+    return errors::InvalidArgument(
+        "Expected FIFOQueue, found lock-free FIFOQueueV2");
+  }
   TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
   TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
   TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fifo_queue.h"
+#include "tensorflow/core/kernels/lock_free_fifo_queue.h"
 #include "tensorflow/core/kernels/queue_base.h"
 #include "tensorflow/core/kernels/queue_op.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -36,24 +37,34 @@ limitations under the License.
 namespace tensorflow {
 
 // Defines a FIFOQueueOp, which produces a Queue (specifically, one
-// backed by FIFOQueue) that persists across different graph
+// backed by FIFOQueue, or by LockFreeFIFOQueue if the lock_free attr
+// of FIFOQueueV2 is set) that persists across different graph
 // executions, and sessions. Running this op produces a single-element
 // tensor of handles to Queues in the corresponding device.
 class FIFOQueueOp : public TypedQueueOp {
  public:
   explicit FIFOQueueOp(OpKernelConstruction* context) : TypedQueueOp(context) {
     OP_REQUIRES_OK(context, context->GetAttr("shapes", &component_shapes_));
+    if (context->def().attr().count("lock_free") > 0) {
+      OP_REQUIRES_OK(context, context->GetAttr("lock_free", &lock_free_));
+    }
   }
 
  private:
   Status CreateResource(QueueInterface** ret) override
       EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (lock_free_) {
+      LockFreeFIFOQueue* queue = new LockFreeFIFOQueue(
+          capacity_, component_types_, component_shapes_, cinfo_.name());
+      return CreateTypedQueue(queue, ret);
+    }
     FIFOQueue* queue = new FIFOQueue(capacity_, component_types_,
                                      component_shapes_, cinfo_.name());
     return CreateTypedQueue(queue, ret);
   }
 
   std::vector<TensorShape> component_shapes_;
+  bool lock_free_ = false;
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueueOp);
 };
 
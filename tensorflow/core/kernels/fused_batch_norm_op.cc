@@ -23,12 +23,17 @@ limitations under the License.
 #include "tensorflow/core/util/stream_executor_util.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/util/tensor_format.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 using CPUDevice = Eigen::ThreadPoolDevice;
@@ -43,8 +48,19 @@ struct FusedBatchNorm;
 template <typename Device, typename T>
 struct FusedBatchNormGrad;
 
+// The CPU implementation of FusedBatchNorm reads x once to compute the batch
+// statistics and once more to normalize it, for both NHWC and NCHW.
+//
+// The statistics are computed per block of x: a range of rows for NHWC, one
+// image of one channel for NCHW.  Each block sums the deviations of its values
+// from its first value (per channel), which keeps the sums in T accurate as
+// long as the block isn't much larger than kMaxBlockValues.  The mean and sum
+// of squared deviations of the blocks are then merged in double, in block
+// order, so the result does not depend on how the blocks were scheduled.
 template <typename T>
 struct FusedBatchNorm<CPUDevice, T> {
+  static constexpr int64 kMaxBlockValues = 16384;
+
   void operator()(OpKernelContext* context, const Tensor& x_input,
                   const Tensor& scale_input, const Tensor& offset_input,
                   const Tensor& estimated_mean_input,
@@ -53,78 +69,206 @@ struct FusedBatchNorm<CPUDevice, T> {
                   Tensor* batch_var_output, Tensor* saved_mean_output,
                   Tensor* saved_var_output, TensorFormat tensor_format,
                   bool is_training) {
-    CHECK(tensor_format == FORMAT_NHWC)
-        << "The CPU implementation of FusedBatchNorm only supports "
-        << "NHWC tensor format for now.";
-    typename TTypes<T, 4>::ConstTensor x(x_input.tensor<T, 4>());
-    typename TTypes<T>::ConstVec scale(scale_input.vec<T>());
-    typename TTypes<T>::ConstVec offset(offset_input.vec<T>());
-    typename TTypes<T>::ConstVec estimated_mean(estimated_mean_input.vec<T>());
-    typename TTypes<T>::ConstVec estimated_variance(
-        estimated_variance_input.vec<T>());
-    typename TTypes<T, 4>::Tensor y(y_output->tensor<T, 4>());
-    typename TTypes<T>::Vec batch_mean(batch_mean_output->vec<T>());
-    typename TTypes<T>::Vec batch_var(batch_var_output->vec<T>());
-    typename TTypes<T>::Vec saved_mean(saved_mean_output->vec<T>());
-    typename TTypes<T>::Vec saved_var(saved_var_output->vec<T>());
-
-    const CPUDevice& d = context->eigen_device<CPUDevice>();
-
-    const int depth = x.dimension(3);
-    const int size = x.size();
-    const int rest_size = size / depth;
-    Eigen::DSizes<Eigen::Index, 2> rest_by_depth(rest_size, depth);
-
-#if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::DSizes<Eigen::Index, 2> one_by_depth(1, depth);
-    Eigen::array<int, 1> reduce_dims({0});
-    Eigen::array<int, 2> bcast_spec({rest_size, 1});
-#else
-    Eigen::IndexList<Eigen::type2index<1>, Eigen::Index> one_by_depth;
-    one_by_depth.set(1, depth);
-    Eigen::IndexList<Eigen::type2index<0> > reduce_dims;
-    Eigen::IndexList<Eigen::Index, Eigen::type2index<1> > bcast_spec;
-    bcast_spec.set(0, rest_size);
-#endif
-
-    auto x_rest_by_depth = x.reshape(rest_by_depth);
-    const int rest_size_minus_one = (rest_size > 1) ? (rest_size - 1) : 1;
-    T rest_size_inv = static_cast<T>(1.0f / static_cast<T>(rest_size));
-    // This adjustment is for Bessel's correction
-    T rest_size_adjust =
-        static_cast<T>(rest_size) / static_cast<T>(rest_size_minus_one);
-
-    Eigen::Tensor<T, 1, Eigen::RowMajor> mean(depth);
-    Eigen::Tensor<T, 1, Eigen::RowMajor> variance(depth);
+    OP_REQUIRES(
+        context,
+        tensor_format == FORMAT_NHWC || tensor_format == FORMAT_NCHW,
+        errors::Internal("Unsupported tensor format: ", tensor_format));
+    const bool nchw = tensor_format == FORMAT_NCHW;
+    const int64 batch_size = GetTensorDim(x_input, tensor_format, 'N');
+    const int64 depth = GetTensorDim(x_input, tensor_format, 'C');
+    const int64 image_size = GetTensorDim(x_input, tensor_format, 'H') *
+                             GetTensorDim(x_input, tensor_format, 'W');
+    const int64 rest_size = batch_size * image_size;
+    if (depth == 0) return;
+
+    const T* x = x_input.flat<T>().data();
+    T* y = y_output->flat<T>().data();
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+
+    std::vector<double> mean(depth);
+    std::vector<double> variance(depth);
     if (is_training) {
-      mean.device(d) = (x_rest_by_depth.sum(reduce_dims) * rest_size_inv);
-      batch_mean.device(d) = mean;
-      saved_mean.device(d) = mean;
+      ComputeMoments(worker_threads, x, nchw, batch_size, image_size, depth,
+                     &mean, &variance);
+      auto batch_mean = batch_mean_output->vec<T>();
+      auto batch_var = batch_var_output->vec<T>();
+      auto saved_mean = saved_mean_output->vec<T>();
+      auto saved_var = saved_var_output->vec<T>();
+      // Bessel's correction for the running variance.
+      const double rest_size_adjust =
+          rest_size > 1 ? static_cast<double>(rest_size) / (rest_size - 1)
+                        : 1.0;
+      for (int64 c = 0; c < depth; ++c) {
+        batch_mean(c) = saved_mean(c) = static_cast<T>(mean[c]);
+        saved_var(c) = static_cast<T>(variance[c]);
+        batch_var(c) = static_cast<T>(variance[c] * rest_size_adjust);
+      }
     } else {
-      mean.device(d) = estimated_mean;
+      auto estimated_mean = estimated_mean_input.vec<T>();
+      auto estimated_variance = estimated_variance_input.vec<T>();
+      for (int64 c = 0; c < depth; ++c) {
+        mean[c] = static_cast<double>(estimated_mean(c));
+        variance[c] = static_cast<double>(estimated_variance(c));
+      }
     }
 
-    auto x_centered =
-        x_rest_by_depth - mean.reshape(one_by_depth).broadcast(bcast_spec);
+    // y = x * multiplier + shift, per channel.
+    auto scale = scale_input.vec<T>();
+    auto offset = offset_input.vec<T>();
+    std::vector<T> multiplier(depth);
+    std::vector<T> shift(depth);
+    for (int64 c = 0; c < depth; ++c) {
+      const double m = static_cast<double>(scale(c)) /
+                       std::sqrt(variance[c] + static_cast<double>(epsilon));
+      multiplier[c] = static_cast<T>(m);
+      shift[c] = static_cast<T>(static_cast<double>(offset(c)) - mean[c] * m);
+    }
+    Normalize(worker_threads, x, nchw, batch_size, image_size, depth,
+              multiplier.data(), shift.data(), y);
+  }
 
-    if (is_training) {
-      variance.device(d) = x_centered.square().sum(reduce_dims) * rest_size_inv;
-      batch_var.device(d) = variance * rest_size_adjust;
-      saved_var.device(d) = variance;
+ private:
+  // Sets (*mean)[c] and (*variance)[c] to the mean and (biased) variance of
+  // channel c of x.
+  static void ComputeMoments(const DeviceBase::CpuWorkerThreads& workers,
+                             const T* x, bool nchw, int64 batch_size,
+                             int64 image_size, int64 depth,
+                             std::vector<double>* mean,
+                             std::vector<double>* variance) {
+    const int64 rest_size = batch_size * image_size;
+    if (rest_size == 0) {
+      std::fill(mean->begin(), mean->end(), 0.0);
+      std::fill(variance->begin(), variance->end(), 0.0);
+      return;
+    }
+
+    // block_mean and block_m2 hold the mean and sum of squared deviations of
+    // each channel of each of the num_blocks blocks, which have block_rows
+    // rows of each channel, except for the last NHWC one.
+    int64 num_blocks;
+    int64 block_rows;
+    if (nchw) {
+      num_blocks = batch_size;
+      block_rows = image_size;
+    } else {
+      block_rows = std::max<int64>(1, kMaxBlockValues / depth);
+      num_blocks = (rest_size + block_rows - 1) / block_rows;
+    }
+    std::vector<double> block_mean(num_blocks * depth);
+    std::vector<double> block_m2(num_blocks * depth);
+
+    if (nchw) {
+      // Each work unit is one image of one channel.
+      auto work = [x, image_size, &block_mean, &block_m2](int64 start,
+                                                           int64 limit) {
+        for (int64 plane = start; plane < limit; ++plane) {
+          const T* values = x + plane * image_size;
+          const T first = values[0];
+          T sum(0);
+          T sum_squares(0);
+          for (int64 i = 0; i < image_size; ++i) {
+            const T deviation = values[i] - first;
+            sum += deviation;
+            sum_squares += deviation * deviation;
+          }
+          const double n = image_size;
+          block_mean[plane] = static_cast<double>(first) + sum / n;
+          block_m2[plane] = static_cast<double>(sum_squares) -
+                            static_cast<double>(sum) * sum / n;
+        }
+      };
+      Shard(workers.num_threads, workers.workers, batch_size * depth,
+            image_size * 3, work);
     } else {
-      mean.device(d) = estimated_mean;
-      variance.device(d) = estimated_variance;
+      // Each work unit is one block of block_rows rows of all the channels.
+      auto work = [x, rest_size, depth, block_rows, &block_mean, &block_m2](
+          int64 start, int64 limit) {
+        std::vector<T> sum(depth);
+        std::vector<T> sum_squares(depth);
+        for (int64 block = start; block < limit; ++block) {
+          const int64 row_begin = block * block_rows;
+          const int64 row_end = std::min(rest_size, row_begin + block_rows);
+          const T* first = x + row_begin * depth;
+          std::fill(sum.begin(), sum.end(), T(0));
+          std::fill(sum_squares.begin(), sum_squares.end(), T(0));
+          for (int64 row = row_begin; row < row_end; ++row) {
+            const T* values = x + row * depth;
+            for (int64 c = 0; c < depth; ++c) {
+              const T deviation = values[c] - first[c];
+              sum[c] += deviation;
+              sum_squares[c] += deviation * deviation;
+            }
+          }
+          const double n = row_end - row_begin;
+          for (int64 c = 0; c < depth; ++c) {
+            block_mean[block * depth + c] =
+                static_cast<double>(first[c]) + sum[c] / n;
+            block_m2[block * depth + c] =
+                static_cast<double>(sum_squares[c]) -
+                static_cast<double>(sum[c]) * sum[c] / n;
+          }
+        }
+      };
+      Shard(workers.num_threads, workers.workers, num_blocks,
+            block_rows * depth * 3, work);
     }
 
-    auto scaling_factor = ((variance + epsilon).rsqrt() * scale)
-                              .eval()
-                              .reshape(one_by_depth)
-                              .broadcast(bcast_spec);
-    auto x_scaled = x_centered * scaling_factor;
-    auto x_shifted =
-        x_scaled + offset.reshape(one_by_depth).broadcast(bcast_spec);
+    // Merges the blocks with the update of Chan et al., "Updating Formulae
+    // and a Pairwise Algorithm for Computing Sample Variances".
+    for (int64 c = 0; c < depth; ++c) {
+      double count = 0;
+      double channel_mean = 0;
+      double channel_m2 = 0;
+      for (int64 block = 0; block < num_blocks; ++block) {
+        const double block_count =
+            std::min(block_rows, rest_size - block * block_rows);
+        const double delta = block_mean[block * depth + c] - channel_mean;
+        const double new_count = count + block_count;
+        channel_mean += delta * block_count / new_count;
+        channel_m2 += block_m2[block * depth + c] +
+                      delta * delta * count * block_count / new_count;
+        count = new_count;
+      }
+      (*mean)[c] = channel_mean;
+      (*variance)[c] = std::max(0.0, channel_m2) / count;
+    }
+  }
 
-    y.reshape(rest_by_depth).device(d) = x_shifted;
+  // Sets y to x * multiplier + shift, per channel.  y may alias x.
+  static void Normalize(const DeviceBase::CpuWorkerThreads& workers,
+                        const T* x, bool nchw, int64 batch_size,
+                        int64 image_size, int64 depth, const T* multiplier,
+                        const T* shift, T* y) {
+    if (nchw) {
+      auto work = [x, image_size, depth, multiplier, shift, y](int64 start,
+                                                                int64 limit) {
+        for (int64 plane = start; plane < limit; ++plane) {
+          const int64 c = plane % depth;
+          const T m = multiplier[c];
+          const T s = shift[c];
+          const T* in = x + plane * image_size;
+          T* out = y + plane * image_size;
+          for (int64 i = 0; i < image_size; ++i) {
+            out[i] = in[i] * m + s;
+          }
+        }
+      };
+      Shard(workers.num_threads, workers.workers, batch_size * depth,
+            image_size * 2, work);
+    } else {
+      auto work = [x, depth, multiplier, shift, y](int64 start, int64 limit) {
+        for (int64 row = start; row < limit; ++row) {
+          const T* in = x + row * depth;
+          T* out = y + row * depth;
+          for (int64 c = 0; c < depth; ++c) {
+            out[c] = in[c] * multiplier[c] + shift[c];
+          }
+        }
+      };
+      Shard(workers.num_threads, workers.workers, batch_size * image_size,
+            depth * 2, work);
+    }
   }
 };
 
@@ -136,9 +280,10 @@ struct FusedBatchNormGrad<CPUDevice, T> {
                   T epsilon, Tensor* x_backprop_output,
                   Tensor* scale_backprop_output, Tensor* offset_backprop_output,
                   TensorFormat tensor_format) {
-    CHECK(tensor_format == FORMAT_NHWC)
-        << "The CPU implementation of FusedBatchNorm only support "
-        << "NHWC tensor format for now.";
+    OP_REQUIRES(context, tensor_format == FORMAT_NHWC,
+                errors::InvalidArgument(
+                    "The CPU implementation of FusedBatchNormGrad only "
+                    "supports NHWC tensor format for now."));
     typename TTypes<T, 4>::ConstTensor y_backprop(
         y_backprop_input.tensor<T, 4>());
     typename TTypes<T, 4>::ConstTensor x(x_input.tensor<T, 4>());
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
 #include <vector>
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -63,6 +64,101 @@ TEST_F(FusedBatchNormOpTest, Training) {
   test::ExpectTensorNear<float>(expected_variance, *GetOutput(2), 0.01);
 }
 
+TEST_F(FusedBatchNormOpTest, TrainingNCHW) {
+  TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("epsilon", 0.001)
+                   .Attr("data_format", "NCHW")
+                   .Attr("is_training", true)
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  // The same values as in Training, transposed to NCHW.
+  AddInputFromArray<float>(TensorShape({1, 2, 1, 6}),
+                           {5, 7, 9, 11, 13, 15, 5, 7, 9, 11, 13, 15});
+  AddInputFromArray<float>(TensorShape({2}), {4.0, 4.0});
+  AddInputFromArray<float>(TensorShape({2}), {2.0, 2.0});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0}), {});
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 1, 6}));
+  test::FillValues<float>(&expected, {-3.86, -1.51, 0.83, 3.17, 5.51, 7.86,
+                                      -3.86, -1.51, 0.83, 3.17, 5.51, 7.86});
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.01);
+
+  Tensor expected_mean(allocator(), DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_mean, {10, 10});
+  test::ExpectTensorNear<float>(expected_mean, *GetOutput(1), 0.01);
+
+  Tensor expected_variance(allocator(), DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_variance, {14.00, 14.00});
+  test::ExpectTensorNear<float>(expected_variance, *GetOutput(2), 0.01);
+}
+
+TEST_F(FusedBatchNormOpTest, TrainingManyBlocks) {
+  TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("epsilon", 0.001)
+                   .Attr("is_training", true)
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  // Enough rows for the statistics to be merged from several blocks, with a
+  // large mean relative to the variance.
+  const int kRows = 4 * 64 * 80;
+  std::vector<float> x(kRows * 2);
+  double sum[2] = {0, 0};
+  for (int i = 0; i < kRows; ++i) {
+    x[2 * i] = 1000.0f + (i % 7);
+    x[2 * i + 1] = -0.5f * (i % 13);
+    sum[0] += x[2 * i];
+    sum[1] += x[2 * i + 1];
+  }
+  float mean[2];
+  float variance[2];
+  for (int c = 0; c < 2; ++c) {
+    mean[c] = sum[c] / kRows;
+    double sum_squares = 0;
+    for (int i = 0; i < kRows; ++i) {
+      sum_squares += (x[2 * i + c] - mean[c]) * (x[2 * i + c] - mean[c]);
+    }
+    variance[c] = sum_squares / kRows;
+  }
+  AddInputFromArray<float>(TensorShape({4, 64, 80, 2}), x);
+  AddInputFromArray<float>(TensorShape({2}), {1.0, 1.0});
+  AddInputFromArray<float>(TensorShape({2}), {0.0, 0.0});
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0}), {});
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected_mean(allocator(), DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_mean, {mean[0], mean[1]});
+  test::ExpectTensorNear<float>(expected_mean, *GetOutput(1), 1e-3);
+
+  Tensor expected_variance(allocator(), DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_variance,
+                          {variance[0] * kRows / (kRows - 1),
+                           variance[1] * kRows / (kRows - 1)});
+  test::ExpectTensorNear<float>(expected_variance, *GetOutput(2), 1e-3);
+
+  const Tensor& y = *GetOutput(0);
+  for (int i = 0; i < kRows; i += 997) {
+    for (int c = 0; c < 2; ++c) {
+      EXPECT_NEAR((x[2 * i + c] - mean[c]) / std::sqrt(variance[c] + 0.001f),
+                  y.flat<float>()(2 * i + c), 1e-3);
+    }
+  }
+}
+
 TEST_F(FusedBatchNormOpTest, Inference) {
   TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
                    .Input(FakeInput(DT_FLOAT))
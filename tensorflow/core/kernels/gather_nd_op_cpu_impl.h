@@ -102,21 +102,24 @@ struct GatherNdSlice<CPUDevice, T, Index, IXDIM> {
                    typename TTypes<T>::Matrix Tout) {
     std::atomic<Index> error_loc(-1);
 
+    // Every index selects a contiguous slice of slice_size elements, which
+    // the generator copies with std::copy_n.  Shards the indices by the cost
+    // of these copies rather than through a reduction over the generator,
+    // whose cost per index Eigen can't know.
     const Eigen::DenseIndex batch_size = Tindices.dimension(0);
-#if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::Tensor<Eigen::DenseIndex, 1>::Dimensions reshape_dims{{ 1 }};
-    Eigen::array<Eigen::DenseIndex, 1> broadcast_dims{{ batch_size }};
-#else
-    Eigen::IndexList<Eigen::type2index<1> > reshape_dims;
-    Eigen::IndexList<Eigen::DenseIndex> broadcast_dims;
-    broadcast_dims.set(0, batch_size);
-#endif
     generator::GatherNdSliceGenerator<T, Index, IXDIM> gather_nd_generator(
         slice_size, Tindices, Tparams, Tout, &error_loc);
-    Tscratch.device(d) = Tscratch.reshape(reshape_dims)
-                             .broadcast(broadcast_dims)
-                             .generate(gather_nd_generator)
-                             .sum();
+    const double slice_bytes = static_cast<double>(slice_size) * sizeof(T);
+    d.parallelFor(batch_size,
+                  Eigen::TensorOpCost(
+                      slice_bytes + IXDIM * sizeof(Index), slice_bytes, IXDIM),
+                  [&gather_nd_generator](Eigen::DenseIndex first,
+                                         Eigen::DenseIndex last) {
+                    Eigen::array<Eigen::DenseIndex, 1> loc;
+                    for (loc[0] = first; loc[0] < last; ++loc[0]) {
+                      gather_nd_generator(loc);
+                    }
+                  });
 
     // error_loc() returns -1 if there's no out-of-bounds index,
     // otherwise it returns the location of an OOB index in Tindices.
@@ -258,40 +258,51 @@ bool HexagonControlWrapper::SetupGraph() {
   // return soc_interface_setupDummyGraph(3 /* inception version */);
 }
 
-bool HexagonControlWrapper::ExecuteGraph() {
-  return soc_interface_ExecuteGraph();
-}
+bool HexagonControlWrapper::ExecuteGraph() { return ExecuteGraphInBuffer(0); }
 
 bool HexagonControlWrapper::TeardownGraph() {
   soc_interface_ReleaseNodeInputAndNodeOutputArray();
   return soc_interface_TeardownGraph();
 }
 
-bool HexagonControlWrapper::FillInputNode(const string& node_name,
-                                          const ConstByteArray bytes) {
-  uint64 byte_size;
+int HexagonControlWrapper::GetBufferCount() {
+  return soc_interface_GetNodeDataBufferCount();
+}
+
+bool HexagonControlWrapper::ExecuteGraphInBuffer(int buffer_index) {
+  return soc_interface_ExecuteGraphInBuffer(buffer_index);
+}
+
+bool HexagonControlWrapper::FillInputNodeInBuffer(int buffer_index,
+                                                  const string& node_name,
+                                                  const ConstByteArray bytes) {
   const int x = 1;
   const int y = 299;
   const int z = 299;
   const int d = 3;
   if (DBG_USE_DUMMY_INPUT) {
     const int array_length = x * y * z * d;
-    byte_size = array_length * sizeof(float);
-    dummy_input_float_.resize(array_length);
-    std::memset(dummy_input_float_.data(), 0, byte_size);
-  } else {
-    CHECK(std::get<2>(bytes) == DT_FLOAT);
-    byte_size = std::get<1>(bytes);
-    dummy_input_float_.resize(byte_size / sizeof(float));
-    std::memcpy(dummy_input_float_.data(), std::get<0>(bytes), byte_size);
+    const std::vector<float> dummy_input_float(array_length, 0.0f);
+    return soc_interface_FillInputNodeFloatInBuffer(
+        buffer_index, x, y, z, d,
+        reinterpret_cast<const uint8*>(dummy_input_float.data()),
+        array_length * sizeof(float));
   }
-  return soc_interface_FillInputNodeFloat(
-      x, y, z, d, reinterpret_cast<uint8*>(dummy_input_float_.data()),
-      byte_size);
+  CHECK(std::get<2>(bytes) == DT_FLOAT);
+  // The input buffers are shared with the DSP, so the tensor data is copied
+  // to them directly.
+  return soc_interface_FillInputNodeFloatInBuffer(
+      buffer_index, x, y, z, d, std::get<0>(bytes), std::get<1>(bytes));
 }
 
 bool HexagonControlWrapper::ReadOutputNode(
     const string& node_name, TensorAllocatorFunc tensor_allocator) {
+  return ReadOutputNodeInBuffer(0, node_name, tensor_allocator);
+}
+
+bool HexagonControlWrapper::ReadOutputNodeInBuffer(
+    int buffer_index, const string& node_name,
+    TensorAllocatorFunc tensor_allocator) {
   CHECK_NE(execute_info_, nullptr);
   TensorShape output_shape;
   // TODO(satok): Switch shape corresponding to input shape
@@ -305,7 +316,9 @@ bool HexagonControlWrapper::ReadOutputNode(
     }
   }
   std::vector<IRemoteFusedGraphExecutor::ByteArray> outputs;
-  ReadOutputNode(node_name, &outputs);
+  if (!ReadOutputNodeInBuffer(buffer_index, node_name, &outputs)) {
+    return false;
+  }
   CHECK_EQ(1, outputs.size());
   IRemoteFusedGraphExecutor::ByteArray& output = outputs[0];
   Tensor* output_tensor = tensor_allocator(output_shape);
@@ -314,14 +327,24 @@ bool HexagonControlWrapper::ReadOutputNode(
   // TODO(satok): Avoid specifying float
   std::memcpy(output_tensor->flat<float>().data(), std::get<0>(output),
               std::get<1>(output));
+  return true;
 }
 
 bool HexagonControlWrapper::ReadOutputNode(
     const string& node_name, std::vector<ByteArray>* const outputs) {
+  return ReadOutputNodeInBuffer(0, node_name, outputs);
+}
+
+bool HexagonControlWrapper::ReadOutputNodeInBuffer(
+    int buffer_index, const string& node_name,
+    std::vector<ByteArray>* const outputs) {
   CHECK(outputs != nullptr);
   ByteArray output;
-  soc_interface_ReadOutputNodeFloat(node_name.c_str(), &std::get<0>(output),
-                                    &std::get<1>(output));
+  if (!soc_interface_ReadOutputNodeFloatInBuffer(
+          buffer_index, node_name.c_str(), &std::get<0>(output),
+          &std::get<1>(output))) {
+    return false;
+  }
   // TODO: Accept all results
   std::get<2>(output) = DT_FLOAT;
   outputs->emplace_back(output);
@@ -330,6 +353,12 @@ bool HexagonControlWrapper::ReadOutputNode(
 
 bool HexagonControlWrapper::FillInputNode(const string& node_name,
                                           const Tensor& tensor) {
+  return FillInputNodeInBuffer(0, node_name, tensor);
+}
+
+bool HexagonControlWrapper::FillInputNodeInBuffer(int buffer_index,
+                                                  const string& node_name,
+                                                  const Tensor& tensor) {
   StringPiece tensor_data = tensor.tensor_data();
   const ConstByteArray ba =
       ConstByteArray(reinterpret_cast<const uint8*>(tensor_data.data()),
@@ -347,8 +376,7 @@ bool HexagonControlWrapper::FillInputNode(const string& node_name,
       }
     }
   }
-  FillInputNode(node_name, ba);
-  return true;
+  return FillInputNodeInBuffer(buffer_index, node_name, ba);
 }
 
 #else
@@ -360,9 +388,6 @@ bool HexagonControlWrapper::Finalize() { return false; }
 bool HexagonControlWrapper::SetupGraph() { return false; }
 bool HexagonControlWrapper::ExecuteGraph() { return false; }
 bool HexagonControlWrapper::TeardownGraph() { return false; }
-bool HexagonControlWrapper::FillInputNode(const string&, const ConstByteArray) {
-  return false;
-}
 bool HexagonControlWrapper::FillInputNode(const string&, const Tensor&) {
   return false;
 }
@@ -374,6 +399,24 @@ bool HexagonControlWrapper::ReadOutputNode(const string&,
                                            std::vector<ByteArray>* const) {
   return false;
 }
+int HexagonControlWrapper::GetBufferCount() { return 1; }
+bool HexagonControlWrapper::FillInputNodeInBuffer(int, const string&,
+                                                  const ConstByteArray) {
+  return false;
+}
+bool HexagonControlWrapper::FillInputNodeInBuffer(int, const string&,
+                                                  const Tensor&) {
+  return false;
+}
+bool HexagonControlWrapper::ExecuteGraphInBuffer(int) { return false; }
+bool HexagonControlWrapper::ReadOutputNodeInBuffer(int, const string&,
+                                                   TensorAllocatorFunc) {
+  return false;
+}
+bool HexagonControlWrapper::ReadOutputNodeInBuffer(
+    int, const string&, std::vector<ByteArray>* const) {
+  return false;
+}
 #endif
 
 }  // namespace tensorflow
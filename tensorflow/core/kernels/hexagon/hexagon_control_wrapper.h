@@ -43,9 +43,18 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
   bool ReadOutputNode(const string& node_name,
                       TensorAllocatorFunc tensor_allocator) final;
   bool ReadOutputNode(const string& node_name, std::vector<ByteArray>* outputs);
+  int GetBufferCount() final;
+  bool FillInputNodeInBuffer(int buffer_index, const string& node_name,
+                             const Tensor& tensor) final;
+  bool ExecuteGraphInBuffer(int buffer_index) final;
+  bool ReadOutputNodeInBuffer(int buffer_index, const string& node_name,
+                              TensorAllocatorFunc tensor_allocator) final;
 
  private:
-  bool FillInputNode(const string& node_name, const ConstByteArray bytes);
+  bool FillInputNodeInBuffer(int buffer_index, const string& node_name,
+                             const ConstByteArray bytes);
+  bool ReadOutputNodeInBuffer(int buffer_index, const string& node_name,
+                              std::vector<ByteArray>* outputs);
 
   // CAVEAT: Need offset as HVX library reserves some ids
   static constexpr int NODE_ID_OFFSET = 0x10000;
@@ -55,9 +64,6 @@ class HexagonControlWrapper final : public IRemoteFusedGraphExecutor {
 
   const RemoteFusedGraphExecuteInfo* execute_info_{};
   GraphTransferer graph_transferer_{};
-  // Dummy float array for input node.
-  // TODO(satok): Use actual data passed by FillInputNode and remove
-  std::vector<float> dummy_input_float_{};
   // Dummy byte array for cosnt node.
   // TODO(satok): Remove
   std::unordered_map<int, std::vector<uint8>> dummy_const_data_{};
@@ -63,6 +63,30 @@ class IRemoteFusedGraphExecutor {
   virtual bool ReadOutputNode(const string& node_name,
                               TensorAllocatorFunc tensor_allocator) = 0;
 
+  // Return the number of sets of input and output buffers of the executor.
+  // The inputs of an execution can be filled in one buffer set while the
+  // graph runs on the inputs of another one, so that the transfers to the
+  // remote processor overlap with its executions. Executors for which the
+  // inputs and outputs of an execution aren't buffered separately return 1.
+  virtual int GetBufferCount() { return 1; }
+
+  // Same as FillInputNode, ExecuteGraph and ReadOutputNode, with the input
+  // and output buffers of 'buffer_index' in [0, GetBufferCount()). They can
+  // be called for different buffers at the same time, except
+  // ExecuteGraphInBuffer which runs one execution at a time.
+  virtual bool FillInputNodeInBuffer(int buffer_index, const string& node_name,
+                                     const Tensor& tensor) {
+    return buffer_index == 0 && FillInputNode(node_name, tensor);
+  }
+  virtual bool ExecuteGraphInBuffer(int buffer_index) {
+    return buffer_index == 0 && ExecuteGraph();
+  }
+  virtual bool ReadOutputNodeInBuffer(int buffer_index,
+                                      const string& node_name,
+                                      TensorAllocatorFunc tensor_allocator) {
+    return buffer_index == 0 && ReadOutputNode(node_name, tensor_allocator);
+  }
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(IRemoteFusedGraphExecutor);
 };
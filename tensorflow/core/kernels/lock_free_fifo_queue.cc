@@ -0,0 +1,450 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/data_flow_ops.cc.
+
+#include "tensorflow/core/kernels/lock_free_fifo_queue.h"
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+LockFreeFIFOQueue::LockFreeFIFOQueue(
+    int32 capacity, const DataTypeVector& component_dtypes,
+    const std::vector<TensorShape>& component_shapes, const string& name)
+    : QueueBase(capacity, component_dtypes, component_shapes, name),
+      head_(0),
+      tail_(0),
+      closing_(false),
+      num_pushing_(0) {
+  num_waiting_[kEnqueue] = 0;
+  num_waiting_[kDequeue] = 0;
+}
+
+Status LockFreeFIFOQueue::Initialize() {
+  if (component_dtypes_.empty()) {
+    return errors::InvalidArgument("Empty component types for queue ", name_);
+  }
+  if (!component_shapes_.empty() &&
+      component_dtypes_.size() != component_shapes_.size()) {
+    return errors::InvalidArgument(
+        "Different number of component types.  ", "Types: ",
+        DataTypeSliceString(component_dtypes_), ", Shapes: ",
+        ShapeListString(component_shapes_));
+  }
+  if (capacity_ <= 0 || capacity_ == kUnbounded) {
+    return errors::InvalidArgument("Lock-free FIFOQueue '", name_,
+                                   "' requires a positive capacity, got ",
+                                   capacity_);
+  }
+  slots_ = std::vector<Slot>(capacity_);
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  return Status::OK();
+}
+
+int64 LockFreeFIFOQueue::Push(std::vector<Tuple>* elements, int64 begin,
+                              int64 min_count) {
+  const uint64 capacity = slots_.size();
+  const int64 max_count = elements->size() - begin;
+  uint64 pos = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    // Counts the free slots from `pos` on, or notices that `pos` was already
+    // claimed by another enqueue.
+    int64 count = 0;
+    int64 diff = 0;
+    while (count < max_count) {
+      const uint64 seq = slots_[(pos + count) % capacity].sequence.load(
+          std::memory_order_acquire);
+      diff = static_cast<int64>(seq - (pos + count));
+      if (diff != 0) break;
+      ++count;
+    }
+    if (diff > 0) {
+      pos = tail_.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (count == 0 || count < min_count) return 0;
+    if (tail_.compare_exchange_weak(pos, pos + count,
+                                    std::memory_order_relaxed)) {
+      for (int64 i = 0; i < count; ++i) {
+        Slot& slot = slots_[(pos + i) % capacity];
+        slot.tuple = std::move((*elements)[begin + i]);
+        slot.sequence.store(pos + i + 1, std::memory_order_release);
+      }
+      return count;
+    }
+  }
+}
+
+int64 LockFreeFIFOQueue::Pop(int64 max_count, int64 min_count,
+                             std::vector<Tuple>* elements) {
+  const uint64 capacity = slots_.size();
+  uint64 pos = head_.load(std::memory_order_relaxed);
+  while (true) {
+    // Counts the stored elements from `pos` on, or notices that `pos` was
+    // already claimed by another dequeue.
+    int64 count = 0;
+    int64 diff = 0;
+    while (count < max_count) {
+      const uint64 seq = slots_[(pos + count) % capacity].sequence.load(
+          std::memory_order_acquire);
+      diff = static_cast<int64>(seq - (pos + count + 1));
+      if (diff != 0) break;
+      ++count;
+    }
+    if (diff > 0) {
+      pos = head_.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (count == 0 || count < min_count) return 0;
+    if (head_.compare_exchange_weak(pos, pos + count,
+                                    std::memory_order_relaxed)) {
+      for (int64 i = 0; i < count; ++i) {
+        Slot& slot = slots_[(pos + i) % capacity];
+        elements->push_back(std::move(slot.tuple));
+        slot.tuple.clear();
+        slot.sequence.store(pos + i + capacity, std::memory_order_release);
+      }
+      return count;
+    }
+  }
+}
+
+Status LockFreeFIFOQueue::SplitBatch(const Tuple& tuple, OpKernelContext* ctx,
+                                     std::vector<Tuple>* elements) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  elements->resize(batch_size);
+  for (int i = 0; i < num_components(); ++i) {
+    TensorShape element_shape(tuple[i].shape());
+    element_shape.RemoveDim(0);
+    for (int64 index = 0; index < batch_size; ++index) {
+      const Tensor slice = tuple[i].Slice(index, index + 1);
+      Tensor element;
+      if (!slice.IsAligned() || !element.CopyFrom(slice, element_shape)) {
+        TF_RETURN_IF_ERROR(
+            ctx->allocate_temp(tuple[i].dtype(), element_shape, &element));
+        TF_RETURN_IF_ERROR(CopySliceToElement(tuple[i], &element, index));
+      }
+      (*elements)[index].push_back(std::move(element));
+    }
+  }
+  return Status::OK();
+}
+
+Status LockFreeFIFOQueue::GatherBatch(const std::vector<Tuple>& elements,
+                                      OpKernelContext* ctx, Tuple* tuple) {
+  const int64 batch_size = elements.size();
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor batch;
+    // The batch becomes output i of the op, allocated as the output, e.g.
+    // in pinned memory for a GPU.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(component_dtypes_[i],
+                                          ManyOutShape(i, batch_size), &batch,
+                                          ctx->output_alloc_attr(i)));
+    if (DataTypeCanUseMemcpy(batch.dtype())) {
+      // Elements split from the same batch by SplitBatch are contiguous, and
+      // are copied together.
+      char* dst = const_cast<char*>(batch.tensor_data().data());
+      const size_t element_bytes =
+          batch_size > 0 ? batch.tensor_data().size() / batch_size : 0;
+      int64 begin = 0;
+      while (element_bytes > 0 && begin < batch_size) {
+        const char* src = elements[begin][i].tensor_data().data();
+        int64 end = begin + 1;
+        while (end < batch_size && elements[end][i].tensor_data().data() ==
+                                       src + (end - begin) * element_bytes) {
+          ++end;
+        }
+        memcpy(dst + begin * element_bytes, src,
+               (end - begin) * element_bytes);
+        begin = end;
+      }
+    } else {
+      for (int64 index = 0; index < batch_size; ++index) {
+        TF_RETURN_IF_ERROR(
+            CopyElementToSlice(elements[index][i], &batch, index));
+      }
+    }
+    tuple->push_back(std::move(batch));
+  }
+  return Status::OK();
+}
+
+bool LockFreeFIFOQueue::TryPushUnlocked(std::vector<Tuple>* elements) {
+  if (elements->size() > slots_.size()) return false;
+  num_pushing_.fetch_add(1);
+  bool pushed = false;
+  if (!closing_.load() && num_waiting_[kEnqueue].load() == 0) {
+    pushed = Push(elements, 0, elements->size()) > 0;
+  }
+  num_pushing_.fetch_sub(1);
+  if (pushed) NotifyWaiting(kDequeue);
+  return pushed;
+}
+
+void LockFreeFIFOQueue::NotifyWaiting(Action action) {
+  // Pairs with the fence in CountWaiting: either the waiting attempt sees
+  // the change to the ring, or it is counted here and flushed.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_waiting_[action].load() > 0) {
+    FlushUnlocked();
+  }
+}
+
+QueueBase::DoneCallback LockFreeFIFOQueue::CountWaiting(
+    Action action, DoneCallback callback) {
+  num_waiting_[action].fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return [this, action, callback]() {
+    num_waiting_[action].fetch_sub(1);
+    callback();
+  };
+}
+
+void LockFreeFIFOQueue::EnqueueElements(std::vector<Tuple>* elements,
+                                        OpKernelContext* ctx,
+                                        DoneCallback callback) {
+  if (TryPushUnlocked(elements)) {
+    callback();
+    return;
+  }
+
+  std::shared_ptr<std::vector<Tuple>> pending(
+      new std::vector<Tuple>(std::move(*elements)));
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      enqueue_attempts_.emplace_back(
+          pending->size(), CountWaiting(kEnqueue, callback), ctx, cm, token,
+          [pending, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_) {
+              attempt->context->SetStatus(errors::Cancelled(
+                  "FIFOQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            const int64 pushed =
+                Push(pending.get(),
+                     pending->size() - attempt->elements_requested, 1);
+            if (pushed == 0) return kNoProgress;
+            attempt->elements_requested -= pushed;
+            return attempt->elements_requested == 0 ? kComplete : kProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void LockFreeFIFOQueue::DequeueElements(int64 num_elements,
+                                        bool allow_small_batch,
+                                        OpKernelContext* ctx,
+                                        ElementsCallback callback) {
+  if (num_waiting_[kDequeue].load() == 0 && num_elements <= capacity_) {
+    std::vector<Tuple> elements;
+    if (Pop(num_elements, num_elements, &elements) > 0) {
+      NotifyWaiting(kEnqueue);
+      callback(elements);
+      return;
+    }
+  }
+
+  // The elements dequeued so far.  An attempt that fails after taking some is
+  // a cancelled one, whose elements are dropped as FIFOQueue drops them.
+  std::shared_ptr<std::vector<Tuple>> result(new std::vector<Tuple>);
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      DoneCallback done = [ctx, callback, result]() {
+        if (!ctx->status().ok()) result->clear();
+        callback(*result);
+      };
+      dequeue_attempts_.emplace_back(
+          num_elements, CountWaiting(kDequeue, done), ctx, cm, token,
+          [num_elements, allow_small_batch, result,
+           this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            // Dequeues that fit in the ring take all their elements at once,
+            // so that none is lost if the queue is closed meanwhile.
+            const int64 requested = attempt->elements_requested;
+            int64 min_count = requested <= capacity_ ? requested : 1;
+            if (closed_ && allow_small_batch) min_count = 1;
+            const int64 popped = Pop(requested, min_count, result.get());
+            attempt->elements_requested -= popped;
+            if (attempt->elements_requested == 0) return kComplete;
+            if (closed_) {
+              if (allow_small_batch && !result->empty()) return kComplete;
+              attempt->context->SetStatus(errors::OutOfRange(
+                  "FIFOQueue '", name_, "' is closed and has ",
+                  "insufficient elements (requested ", num_elements,
+                  ", current size ", size(), ")"));
+              return kComplete;
+            }
+            return popped > 0 ? kProgress : kNoProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(std::vector<Tuple>());
+  }
+}
+
+void LockFreeFIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                                   DoneCallback callback) {
+  std::vector<Tuple> elements(1, tuple);
+  EnqueueElements(&elements, ctx, callback);
+}
+
+void LockFreeFIFOQueue::TryEnqueueMany(const Tuple& tuple,
+                                       OpKernelContext* ctx,
+                                       DoneCallback callback) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  if (batch_size == 0) {
+    callback();
+    return;
+  }
+  std::vector<Tuple> elements;
+  Status status = SplitBatch(tuple, ctx, &elements);
+  if (!status.ok()) {
+    ctx->SetStatus(status);
+    callback();
+    return;
+  }
+  EnqueueElements(&elements, ctx, callback);
+}
+
+void LockFreeFIFOQueue::TryDequeue(OpKernelContext* ctx,
+                                   CallbackWithTuple callback) {
+  DequeueElements(1, false, ctx,
+                  [callback](const std::vector<Tuple>& elements) {
+                    callback(elements.empty() ? Tuple() : elements[0]);
+                  });
+}
+
+void LockFreeFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                                       bool allow_small_batch,
+                                       CallbackWithTuple callback) {
+  if (!specified_shapes()) {
+    ctx->SetStatus(errors::InvalidArgument(
+        "FIFOQueue's DequeueMany and DequeueUpTo require the "
+        "components to have specified shapes."));
+    callback(Tuple());
+    return;
+  }
+  ElementsCallback gather = [this, ctx,
+                             callback](const std::vector<Tuple>& elements) {
+    if (!ctx->status().ok()) {
+      callback(Tuple());
+      return;
+    }
+    Tuple tuple;
+    Status status = GatherBatch(elements, ctx, &tuple);
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+      callback(Tuple());
+      return;
+    }
+    callback(tuple);
+  };
+  if (num_elements == 0) {
+    gather(std::vector<Tuple>());
+    return;
+  }
+  if (num_elements > capacity_ && !allow_small_batch) {
+    ctx->SetStatus(errors::InvalidArgument(
+        "Lock-free FIFOQueue '", name_, "' cannot dequeue ", num_elements,
+        " elements at once, more than its capacity of ", capacity_));
+    callback(Tuple());
+    return;
+  }
+  DequeueElements(num_elements, allow_small_batch, ctx, gather);
+}
+
+void LockFreeFIFOQueue::Close(OpKernelContext* ctx,
+                              bool cancel_pending_enqueues,
+                              DoneCallback callback) {
+  // Diverts new enqueues to the attempt queue, and waits for those already
+  // pushing into the ring, so that none completes after the queue is closed.
+  closing_.store(true);
+  while (num_pushing_.load() > 0) {
+    std::this_thread::yield();
+  }
+  QueueBase::Close(ctx, cancel_pending_enqueues, callback);
+}
+
+Status LockFreeFIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
+  bool lock_free = false;
+  if (!MatchesNodeDefOp(node_def, "FIFOQueueV2").ok() ||
+      !GetNodeAttr(node_def, "lock_free", &lock_free).ok() || !lock_free) {
+    return errors::InvalidArgument("Expected lock-free FIFOQueueV2, found ",
+                                   node_def.op());
+  }
+  TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
+  TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
+  TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
+  return Status::OK();
+}
+
+int32 LockFreeFIFOQueue::size() {
+  const uint64 head = head_.load();
+  const uint64 tail = tail_.load();
+  // The head may pass the tail loaded after it, or leave it more than the
+  // capacity behind, while other callers push and pop.
+  const int64 size = static_cast<int64>(tail - head);
+  return static_cast<int32>(
+      std::min<int64>(std::max<int64>(size, 0), capacity_));
+}
+
+int64 LockFreeFIFOQueue::MemoryUsed() const {
+  // Only the ring itself: the elements it holds cannot be read without
+  // dequeuing them, and often share the buffers of the batches they were
+  // enqueued in.
+  return sizeof(LockFreeFIFOQueue) + slots_.size() * sizeof(Slot);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+#define TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A FIFO queue of bounded capacity, whose elements are kept in a ring buffer
+// of slots that producers and consumers claim with atomic operations (see
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue).
+//
+// Enqueues and dequeues that find room or elements in the ring complete
+// without taking mu_.  Only those that have to wait, because the ring is full
+// or empty or other callers of the same kind are waiting, go through the
+// attempt queues of QueueBase, which keeps them in order.
+//
+// Elements enqueued together by EnqueueMany share the buffer of the batch
+// when possible, so that DequeueMany copies each run of such elements into
+// its output with a single memcpy.
+//
+// Unlike FIFOQueue, a DequeueMany of more elements than the capacity is an
+// error: it would have to take elements a few at a time, and the ring cannot
+// put them back if the queue is closed before it completes.
+class LockFreeFIFOQueue : public QueueBase {
+ public:
+  LockFreeFIFOQueue(int32 capacity, const DataTypeVector& component_dtypes,
+                    const std::vector<TensorShape>& component_shapes,
+                    const string& name);
+
+  Status Initialize();  // Must be called before any other method.
+
+  // Implementations of QueueInterface methods --------------------------------
+
+  void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                  DoneCallback callback) override;
+  void TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                      DoneCallback callback) override;
+  void TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) override;
+  void TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                      bool allow_small_batch,
+                      CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
+  Status MatchesNodeDef(const NodeDef& node_def) override;
+
+  int32 size() override;
+
+  int64 MemoryUsed() const override;
+
+ protected:
+  ~LockFreeFIFOQueue() override {}
+
+ private:
+  typedef std::function<void(const std::vector<Tuple>&)> ElementsCallback;
+
+  struct Slot {
+    // Equal to the position of the slot when it is free for the element at
+    // that position, to the position + 1 once that element is stored, and
+    // to the position + capacity once it is dequeued.
+    std::atomic<uint64> sequence;
+    Tuple tuple;
+  };
+
+  // Moves the elements of `elements` from `begin` on into the ring, as many
+  // as there is room for, if there is room for at least `min_count` of them.
+  // Returns how many were moved.
+  int64 Push(std::vector<Tuple>* elements, int64 begin, int64 min_count);
+
+  // Appends to `elements` the next elements of the ring, as many as are
+  // stored up to `max_count`, if there are at least `min_count` of them.
+  // Returns how many were appended.
+  int64 Pop(int64 max_count, int64 min_count, std::vector<Tuple>* elements);
+
+  // Splits the batch `tuple` into elements, which share its buffers when
+  // they are aligned.
+  Status SplitBatch(const Tuple& tuple, OpKernelContext* ctx,
+                    std::vector<Tuple>* elements);
+
+  // Allocates a batch of `elements` into `tuple`, copying each run of
+  // elements that are contiguous in memory with a single memcpy.
+  Status GatherBatch(const std::vector<Tuple>& elements, OpKernelContext* ctx,
+                     Tuple* tuple);
+
+  // Enqueues `elements`, in the ring if they fit at once or else through an
+  // attempt.
+  void EnqueueElements(std::vector<Tuple>* elements, OpKernelContext* ctx,
+                       DoneCallback callback);
+
+  // Dequeues `num_elements` elements, or fewer if `allow_small_batch` and
+  // the queue is closed, and passes them to `callback`.  Passes no elements
+  // if the dequeue fails.
+  void DequeueElements(int64 num_elements, bool allow_small_batch,
+                       OpKernelContext* ctx, ElementsCallback callback);
+
+  // Pushes all of `elements` without taking mu_, unless the queue is closing
+  // or other enqueues are waiting.  Returns true if they were pushed.
+  bool TryPushUnlocked(std::vector<Tuple>* elements);
+
+  // Flushes the attempts of `action` if there are any, after the ring
+  // changed outside of them.
+  void NotifyWaiting(Action action);
+
+  // Counts an attempt of `action` as waiting until `callback`, its done
+  // callback, is run.
+  DoneCallback CountWaiting(Action action, DoneCallback callback);
+
+  std::vector<Slot> slots_;
+  std::atomic<uint64> head_;  // The position of the next element to dequeue.
+  std::atomic<uint64> tail_;  // The position of the next element to enqueue.
+
+  // Set by Close, after which every enqueue goes through the attempt queue.
+  std::atomic<bool> closing_;
+  // The number of enqueues pushing into the ring without holding mu_.
+  std::atomic<int64> num_pushing_;
+  // The number of attempts of each Action in the attempt queues.
+  std::atomic<int64> num_waiting_[2];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LockFreeFIFOQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
@@ -16,20 +16,25 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/memmapped_lookup_table.h"
 
 namespace tensorflow {
 namespace lookup {
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+// Lookup table that wraps a ShardedHashMap, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
@@ -48,10 +53,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -59,28 +61,23 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)),
-          default_val);
-    }
-
+    table_.Find(key_values.data(), key_values.size(),
+                [&value_values, &default_val](int64 i, const V* found) {
+                  value_values(i) = found != nullptr ? *found : default_val;
+                });
     return Status::OK();
   }
 
   Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
-
-    mutex_lock l(mu_);
+    auto set_value = [&value_values](int64 i, V* value) {
+      *value = SubtleMustCopyUnlessStringOrFloat(value_values(i));
+    };
     if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_,
-                          SubtleMustCopyUnlessStringOrFloat(key_values(i)),
-                          SubtleMustCopyUnlessStringOrFloat(value_values(i)));
+      table_.Assign(key_values.data(), key_values.size(), set_value);
+    } else {
+      table_.Insert(key_values.data(), key_values.size(), set_value);
     }
     return Status::OK();
   }
@@ -96,24 +93,18 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
-
     Tensor* keys;
     Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+    return table_.Export(
+        [ctx, &keys, &values](int64 size) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          return ctx->allocate_output("values", TensorShape({size}), &values);
+        },
+        [&keys, &values](int64 i, const K& key, const V& value) {
+          keys->flat<K>()(i) = key;
+          values->flat<V>()(i) = value;
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -125,12 +116,10 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
  private:
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  ShardedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a ShardedHashMap. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -144,10 +133,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -156,21 +142,18 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec = gtl::FindOrNull(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = default_flat(j);
-        }
-      }
-    }
-
+    table_.Find(key_values.data(), key_values.size(),
+                [&](int64 i, const ValueArray* value_vec) {
+                  if (value_vec != nullptr) {
+                    for (int64 j = 0; j < value_dim; j++) {
+                      value_values(i, j) = value_vec->at(j);
+                    }
+                  } else {
+                    for (int64 j = 0; j < value_dim; j++) {
+                      value_values(i, j) = default_flat(j);
+                    }
+                  }
+                });
     return Status::OK();
   }
 
@@ -179,18 +162,16 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray value_vec;
+    auto set_value = [&value_values, value_dim](int64 i, ValueArray* value) {
+      value->clear();
       for (int64 j = 0; j < value_dim; j++) {
-        V value = value_values(i, j);
-        value_vec.push_back(value);
+        value->push_back(value_values(i, j));
       }
-      gtl::InsertOrUpdate(
-          &table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)), value_vec);
+    };
+    if (clear) {
+      table_.Assign(key_values.data(), key_values.size(), set_value);
+    } else {
+      table_.Insert(key_values.data(), key_values.size(), set_value);
     }
     return Status::OK();
   }
@@ -206,29 +187,23 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
     int64 value_dim = value_shape_.dim_size(0);
-
     Tensor* keys;
     Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
-      }
-    }
-    return Status::OK();
+    return table_.Export(
+        [ctx, value_dim, &keys, &values](int64 size) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          return ctx->allocate_output(
+              "values", TensorShape({size, value_dim}), &values);
+        },
+        [&keys, &values, value_dim](int64 i, const K& key,
+                                    const ValueArray& value) {
+          keys->flat<K>()(i) = key;
+          for (int64 j = 0; j < value_dim; j++) {
+            values->matrix<V>()(i, j) = value[j];
+          }
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -241,10 +216,8 @@ class MutableHashTableOfTensors final : public LookupInterface {
 
  private:
   TensorShape value_shape_;
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
+  ShardedHashMap<K, ValueArray> table_;
 };
 
 namespace {
@@ -256,6 +229,18 @@ inline uint64 HashScalar(const T& key) {
 
 inline uint64 HashScalar(const string& key) { return Hash64(key); }
 
+// Sets hashes[i] to HashScalar(keys[i]) for each of the n keys.
+template <typename T>
+void HashScalars(const T* keys, int64 n, uint64* hashes) {
+  for (int64 i = 0; i < n; ++i) {
+    hashes[i] = HashScalar(keys[i]);
+  }
+}
+
+inline void HashScalars(const string* keys, int64 n, uint64* hashes) {
+  Hash64Batch(keys, n, hashes);
+}
+
 // If the given shape is a scalar return {1} instead. Otherwise leave it alone.
 TensorShape MaybeVectorizeShape(const TensorShape& shape) {
   if (shape.dims() == 0) {
@@ -327,6 +312,8 @@ class MutableDenseHashTable final : public LookupInterface {
     const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
     auto value_matrix = value->shaped<V, 2>({num_elements, value_size});
     const auto default_flat = default_value.flat<V>();
+    std::vector<uint64> key_hashes;
+    HashKeys(key_matrix, num_elements, &key_hashes);
 
     mutex_lock l(mu_);
     const auto key_buckets_matrix =
@@ -338,7 +325,7 @@ class MutableDenseHashTable final : public LookupInterface {
     const int64 bit_mask = num_buckets_ - 1;
     // TODO(andreasst): parallelize using work_sharder
     for (int64 i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
+      const uint64 key_hash = key_hashes[i];
       if (empty_key_hash_ == key_hash &&
           IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
         return errors::InvalidArgument(
@@ -483,8 +470,10 @@ class MutableDenseHashTable final : public LookupInterface {
     const auto empty_key_tensor =
         empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
     const int64 bit_mask = num_buckets_ - 1;
+    std::vector<uint64> key_hashes;
+    HashKeys(key_matrix, num_elements, &key_hashes);
     for (int64 i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
+      const uint64 key_hash = key_hashes[i];
       if (empty_key_hash_ == key_hash &&
           IsEqualKey(empty_key_tensor, 0, key_matrix, i)) {
         if (ignore_empty_key) {
@@ -587,6 +576,20 @@ class MutableDenseHashTable final : public LookupInterface {
     return result;
   }
 
+  // Sets (*hashes)[i] to HashKey(key, i) for the first num_elements keys,
+  // hashing scalar keys in a batch.
+  void HashKeys(typename TTypes<K>::ConstMatrix key, int64 num_elements,
+                std::vector<uint64>* hashes) const {
+    hashes->resize(num_elements);
+    if (key_shape_.num_elements() == 1) {
+      HashScalars(key.data(), num_elements, hashes->data());
+      return;
+    }
+    for (int64 i = 0; i < num_elements; ++i) {
+      (*hashes)[i] = HashKey(key, i);
+    }
+  }
+
   // Use a template to allow this function to be used both with Matrix and
   // ConstMatrix types.
   template <typename MT2>
@@ -612,6 +615,116 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 empty_key_hash_;
 };
 
+// Accessors of the keys and values of a MemmappedLookupTable by their type.
+template <class T>
+struct MemmappedColumn;
+
+template <>
+struct MemmappedColumn<int64> {
+  static int64 Key(const MemmappedLookupTable& table, int64 i) {
+    return table.int64_key(i);
+  }
+  static int64 Value(const MemmappedLookupTable& table, int64 i) {
+    return table.int64_value(i);
+  }
+};
+
+template <>
+struct MemmappedColumn<string> {
+  static string Key(const MemmappedLookupTable& table, int64 i) {
+    return table.string_key(i).ToString();
+  }
+  static string Value(const MemmappedLookupTable& table, int64 i) {
+    return table.string_value(i).ToString();
+  }
+};
+
+// Immutable lookup table served from a file written by
+// WriteMemmappedLookupTable, which is memory-mapped when the table is
+// created, from the filename given as the first input of the op.  Lookups
+// read the mapped file directly, so creating the table costs neither parsing
+// nor memory beyond the pages of the file, which are shared by all processes
+// that map it.
+template <class K, class V>
+class MemmappedHashTable final : public LookupInterface {
+ public:
+  MemmappedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    const Tensor& filename = ctx->input(0);
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsScalar(filename.shape()),
+        errors::InvalidArgument("filename should be a single string, but got ",
+                                filename.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, MemmappedLookupTable::Open(
+                            ctx->env(), filename.scalar<string>()(), &table_));
+    OP_REQUIRES(
+        ctx,
+        table_->key_dtype() == key_dtype() &&
+            table_->value_dtype() == value_dtype(),
+        errors::InvalidArgument(
+            "Table in ", filename.scalar<string>()(), " maps ",
+            DataTypeString(table_->key_dtype()), " to ",
+            DataTypeString(table_->value_dtype()), ", expected ",
+            DataTypeString(key_dtype()), " to ",
+            DataTypeString(value_dtype())));
+  }
+
+  size_t size() const override { return table_->size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const V default_val = default_value.flat<V>()(0);
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const int64 index = table_->Find(key_values(i));
+      value_values(i) = index >= 0
+                            ? MemmappedColumn<V>::Value(*table_, index)
+                            : default_val;
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::Unimplemented(
+        "Insert not supported by MemmappedHashTable implementations");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::Unimplemented(
+        "ImportValues not supported by MemmappedHashTable implementations");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64 size = table_->size();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    for (int64 i = 0; i < size; ++i) {
+      keys_data(i) = MemmappedColumn<K>::Key(*table_, i);
+      values_data(i) = MemmappedColumn<V>::Value(*table_, i);
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+ private:
+  std::unique_ptr<MemmappedLookupTable> table_;
+};
+
 }  // namespace lookup
 
 // Table lookup op. Perform the lookup operation on the given table.
@@ -870,4 +983,28 @@ REGISTER_KERNEL(int64, bool);
 
 #undef REGISTER_KERNEL
 
+// Register the MemmappedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                         \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("MemmappedHashTable")                                        \
+          .Device(DEVICE_CPU)                                           \
+          .TypeConstraint<key_dtype>("key_dtype")                       \
+          .TypeConstraint<value_dtype>("value_dtype"),                  \
+      LookupTableOp<lookup::MemmappedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)                            \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("MemmappedHashTableV2")                                      \
+          .Device(DEVICE_CPU)                                           \
+          .TypeConstraint<key_dtype>("key_dtype")                       \
+          .TypeConstraint<value_dtype>("value_dtype"),                  \
+      LookupTableOp<lookup::MemmappedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(string, int64);
+REGISTER_KERNEL(int64, string);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(string, string);
+
+#undef REGISTER_KERNEL
+
 }  // namespace tensorflow
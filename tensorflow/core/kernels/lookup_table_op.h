@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_LOOKUP_TABLE_OP_H_
 #define TENSORFLOW_KERNELS_LOOKUP_TABLE_OP_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -25,8 +28,11 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
@@ -141,7 +147,189 @@ inline const double SubtleMustCopyUnlessStringOrFloat(const double value) {
   return value;
 }
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+// Hash functor for the keys of the hash tables.  gtl::FlatMap picks buckets
+// with the bits above the lowest 8 of the hash, so integer keys are mixed
+// rather than hashed to themselves.
+template <typename K>
+struct HashTableKeyHash {
+  size_t operator()(const K& key) const {
+    const uint64 h = static_cast<uint64>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+};
+
+template <>
+struct HashTableKeyHash<string> {
+  size_t operator()(const string& key) const {
+    return static_cast<size_t>(Hash64(key));
+  }
+};
+
+// How many keys ahead of the current one lookups in a batch prefetch the
+// bucket of.
+const int kHashTablePrefetchDistance = 8;
+
+// A hash map split into shards by the hash of their keys, each a gtl::FlatMap
+// under its own lock, so that inserts and finds of keys in different shards do
+// not wait for each other.
+//
+// Batches of keys are grouped by shard, so that each shard is locked once per
+// batch, and the lookups in a shard prefetch the buckets of the keys that
+// follow.
+template <class K, class V>
+class ShardedHashMap {
+ public:
+  ShardedHashMap() {}
+
+  size_t size() const {
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // Calls fn(i, value) for each of the `n` keys, where value points to the
+  // value of keys[i], or is null if it is not in the map.
+  template <typename Fn>
+  void Find(const K* keys, int64 n, Fn fn) const {
+    ForEachShard(keys, n, [this, keys, &fn](int s, const int64* indices,
+                                            int64 num_indices) {
+      const Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64 j = 0; j < num_indices; ++j) {
+        if (j + kHashTablePrefetchDistance < num_indices) {
+          shard.map.prefetch_value(
+              keys[indices[j + kHashTablePrefetchDistance]]);
+        }
+        const int64 i = indices[j];
+        fn(i, gtl::FindOrNull(shard.map,
+                              SubtleMustCopyUnlessStringOrFloat(keys[i])));
+      }
+    });
+  }
+
+  // Calls fn(i, &value) for each of the `n` keys, where value is the value of
+  // keys[i] in the map, default constructed if it was not in the map.
+  template <typename Fn>
+  void Insert(const K* keys, int64 n, Fn fn) {
+    ForEachShard(keys, n, [this, keys, &fn](int s, const int64* indices,
+                                            int64 num_indices) {
+      Shard& shard = shards_[s];
+      mutex_lock l(shard.mu);
+      for (int64 j = 0; j < num_indices; ++j) {
+        const int64 i = indices[j];
+        fn(i, &shard.map[SubtleMustCopyUnlessStringOrFloat(keys[i])]);
+      }
+    });
+  }
+
+  // Replaces the contents of the map with `n` keys, whose values fn(i, &value)
+  // fills, while no other caller can see the map.
+  template <typename Fn>
+  void Assign(const K* keys, int64 n, Fn fn) {
+    LockAll();
+    for (Shard& shard : shards_) {
+      shard.map.clear();
+    }
+    for (int64 i = 0; i < n; ++i) {
+      const K key = SubtleMustCopyUnlessStringOrFloat(keys[i]);
+      fn(i, &shards_[ShardOf(key)].map[key]);
+    }
+    UnlockAll();
+  }
+
+  // Calls size_fn(size) and then fn(i, key, value) for each of the `size`
+  // elements of the map, while no other caller can change the map.
+  template <typename SizeFn, typename Fn>
+  Status Export(SizeFn size_fn, Fn fn) const {
+    LockAll();
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      size += shard.map.size();
+    }
+    Status status = size_fn(size);
+    int64 i = 0;
+    for (const Shard& shard : shards_) {
+      if (!status.ok()) break;
+      for (auto it = shard.map.begin(); it != shard.map.end(); ++it, ++i) {
+        fn(i, it->first, it->second);
+      }
+    }
+    UnlockAll();
+    return status;
+  }
+
+ private:
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    mutable mutex mu;
+    gtl::FlatMap<K, V, HashTableKeyHash<K>> map GUARDED_BY(mu);
+  };
+
+  // The top bits of the hash, which gtl::FlatMap does not use to pick
+  // buckets.
+  static int ShardOf(const K& key) {
+    return static_cast<int>(static_cast<uint64>(HashTableKeyHash<K>()(key)) >>
+                            60);
+  }
+
+  // Calls fn(shard, indices, num_indices) for each shard with the indices of
+  // the keys in it, in order.
+  template <typename Fn>
+  static void ForEachShard(const K* keys, int64 n, Fn fn) {
+    if (n == 1) {
+      const int64 index = 0;
+      fn(ShardOf(keys[0]), &index, 1);
+      return;
+    }
+    // A counting sort of the keys by shard.
+    std::vector<uint8> key_shards(n);
+    int64 ends[kNumShards] = {0};
+    for (int64 i = 0; i < n; ++i) {
+      key_shards[i] = ShardOf(keys[i]);
+      ++ends[key_shards[i]];
+    }
+    for (int s = 1; s < kNumShards; ++s) {
+      ends[s] += ends[s - 1];
+    }
+    std::vector<int64> indices(n);
+    int64 begins[kNumShards];
+    for (int s = 0; s < kNumShards; ++s) {
+      begins[s] = s == 0 ? 0 : ends[s - 1];
+    }
+    int64 positions[kNumShards];
+    std::copy(begins, begins + kNumShards, positions);
+    for (int64 i = 0; i < n; ++i) {
+      indices[positions[key_shards[i]]++] = i;
+    }
+    for (int s = 0; s < kNumShards; ++s) {
+      if (ends[s] > begins[s]) {
+        fn(s, indices.data() + begins[s], ends[s] - begins[s]);
+      }
+    }
+  }
+
+  void LockAll() const NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) {
+      shard.mu.lock();
+    }
+  }
+
+  void UnlockAll() const NO_THREAD_SAFETY_ANALYSIS {
+    for (const Shard& shard : shards_) {
+      shard.mu.unlock();
+    }
+  }
+
+  Shard shards_[kNumShards];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedHashMap);
+};
+
+// Lookup table that wraps a gtl::FlatMap, where the key and value data type
 // is specified.
 //
 // This table is recommended for any variations to key values.
@@ -152,8 +340,8 @@ inline const double SubtleMustCopyUnlessStringOrFloat(const double value) {
 // Sample use case:
 //
 // HashTable<int64, int64> table;  // int64 -> int64.
-// table.Prepare(10); // Prepare the underlying data structure, the number of
-//                    // elements is required by interface, but not used.
+// table.Prepare(10); // Prepare the underlying data structure, sized for the
+//                    // number of elements if it is known.
 // // Populate the table, elements could be added in one or multiple calls.
 // table.Insert(key_tensor, value_tensor); // Populate the table.
 // ...
@@ -180,13 +368,16 @@ class HashTable : public InitializableLookupTable {
   DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
 
  protected:
-  Status DoPrepare(size_t unused) override {
+  Status DoPrepare(size_t size) override {
     if (is_initialized_) {
       return errors::Aborted("HashTable already initialized.");
     }
     if (!table_) {
-      table_ = std::unique_ptr<std::unordered_map<K, V>>(
-          new std::unordered_map<K, V>());
+      table_ = std::unique_ptr<Table>(new Table);
+    }
+    // The size is -1 when the number of elements is unknown.
+    if (static_cast<int64>(size) > 0) {
+      table_->reserve(table_->size() + size);
     }
     return Status::OK();
   };
@@ -201,7 +392,7 @@ class HashTable : public InitializableLookupTable {
     for (int64 i = 0; i < key_values.size(); ++i) {
       const K key = SubtleMustCopyUnlessStringOrFloat(key_values(i));
       const V value = SubtleMustCopyUnlessStringOrFloat(value_values(i));
-      const V& previous_value = gtl::LookupOrInsert(table_.get(), key, value);
+      const V& previous_value = table_->insert({key, value}).first->second;
       if (previous_value != value) {
         return errors::FailedPrecondition(
             "HashTable has different value for same key. Key ", key, " has ",
@@ -217,7 +408,11 @@ class HashTable : public InitializableLookupTable {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    for (int64 i = 0; i < key_values.size(); ++i) {
+    const int64 num_keys = key_values.size();
+    for (int64 i = 0; i < num_keys; ++i) {
+      if (i + kHashTablePrefetchDistance < num_keys) {
+        table_->prefetch_value(key_values(i + kHashTablePrefetchDistance));
+      }
       value_values(i) = gtl::FindWithDefault(
           *table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)),
           default_val);
@@ -227,15 +422,17 @@ class HashTable : public InitializableLookupTable {
 
   int64 MemoryUsed() const override {
     if (table_) {
-      const int64 num_elements = table_->size();
-      return num_elements * (sizeof(K) + sizeof(V));
+      // Each slot of a bucket holds a key, a value and a marker byte.
+      const int64 num_slots = table_->bucket_count();
+      return num_slots * (sizeof(K) + sizeof(V) + 1);
     } else {
       return 0;
     }
   }
 
  private:
-  std::unique_ptr<std::unordered_map<K, V>> table_;
+  typedef gtl::FlatMap<K, V, HashTableKeyHash<K>> Table;
+  std::unique_ptr<Table> table_;
 };
 
 }  // namespace lookup
@@ -0,0 +1,183 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/lookup_table_op.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+// Finds 'keys' in 'map', with -1 for the missing ones.
+std::vector<int64> FindAll(const ShardedHashMap<int64, int64>& map,
+                           const std::vector<int64>& keys) {
+  std::vector<int64> values(keys.size());
+  map.Find(keys.data(), keys.size(), [&values](int64 i, const int64* value) {
+    values[i] = value == nullptr ? -1 : *value;
+  });
+  return values;
+}
+
+TEST(ShardedHashMapTest, InsertWithDuplicateKeysKeepsLastValue) {
+  ShardedHashMap<int64, int64> map;
+  const std::vector<int64> keys = {1, 2, 1, 3, 2, 1};
+  const std::vector<int64> values = {10, 20, 11, 30, 21, 12};
+  map.Insert(keys.data(), keys.size(),
+             [&values](int64 i, int64* value) { *value = values[i]; });
+
+  EXPECT_EQ(3, map.size());
+  EXPECT_EQ(std::vector<int64>({12, 21, 30, -1}), FindAll(map, {1, 2, 3, 4}));
+}
+
+TEST(ShardedHashMapTest, AssignAndExportImportRoundTrip) {
+  ShardedHashMap<string, int64> map;
+  const std::vector<string> old_keys = {"old0", "old1"};
+  map.Insert(old_keys.data(), old_keys.size(),
+             [](int64 i, int64* value) { *value = i; });
+
+  std::vector<string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(strings::StrCat("key", i));
+  }
+  map.Assign(keys.data(), keys.size(),
+             [](int64 i, int64* value) { *value = 2 * i; });
+  EXPECT_EQ(keys.size(), map.size());
+  map.Find(old_keys.data(), old_keys.size(),
+           [](int64 i, const int64* value) { EXPECT_EQ(nullptr, value); });
+
+  std::vector<string> exported_keys;
+  std::vector<int64> exported_values;
+  TF_EXPECT_OK(map.Export(
+      [&](int64 size) {
+        exported_keys.resize(size);
+        exported_values.resize(size);
+        return Status::OK();
+      },
+      [&](int64 i, const string& key, int64 value) {
+        exported_keys[i] = key;
+        exported_values[i] = value;
+      }));
+  ASSERT_EQ(keys.size(), exported_keys.size());
+
+  ShardedHashMap<string, int64> imported;
+  imported.Assign(exported_keys.data(), exported_keys.size(),
+                  [&exported_values](int64 i, int64* value) {
+                    *value = exported_values[i];
+                  });
+  EXPECT_EQ(keys.size(), imported.size());
+  imported.Find(keys.data(), keys.size(), [](int64 i, const int64* value) {
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(2 * i, *value);
+  });
+}
+
+TEST(ShardedHashMapTest, ExportStopsOnSizeError) {
+  ShardedHashMap<int64, int64> map;
+  const std::vector<int64> keys = {1, 2, 3};
+  map.Insert(keys.data(), keys.size(),
+             [](int64 i, int64* value) { *value = i; });
+
+  int64 num_exported = 0;
+  const Status status = map.Export(
+      [](int64 size) { return errors::ResourceExhausted("too big"); },
+      [&num_exported](int64 i, int64 key, int64 value) { ++num_exported; });
+  EXPECT_TRUE(errors::IsResourceExhausted(status));
+  EXPECT_EQ(0, num_exported);
+}
+
+TEST(ShardedHashMapTest, FindsWhileInserting) {
+  const int kNumBatches = 200;
+  const int kBatchSize = 64;
+  ShardedHashMap<int64, int64> map;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 4);
+    // One writer inserts the batches in order, while the readers check that
+    // every key found has its final value.
+    pool.Schedule([&map]() {
+      for (int b = 0; b < kNumBatches; ++b) {
+        std::vector<int64> keys(kBatchSize);
+        for (int j = 0; j < kBatchSize; ++j) {
+          keys[j] = b * kBatchSize + j;
+        }
+        map.Insert(keys.data(), keys.size(), [&keys](int64 i, int64* value) {
+          *value = 3 * keys[i];
+        });
+      }
+    });
+    for (int r = 0; r < 3; ++r) {
+      pool.Schedule([&map, r]() {
+        std::vector<int64> keys(kBatchSize);
+        for (int b = 0; b < kNumBatches; ++b) {
+          for (int j = 0; j < kBatchSize; ++j) {
+            keys[j] = ((b + r) % kNumBatches) * kBatchSize + j;
+          }
+          map.Find(keys.data(), keys.size(),
+                   [&keys](int64 i, const int64* value) {
+                     if (value != nullptr) EXPECT_EQ(3 * keys[i], *value);
+                   });
+        }
+      });
+    }
+  }
+
+  std::vector<int64> keys(kNumBatches * kBatchSize);
+  std::vector<int64> expected(keys.size());
+  for (int64 i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+    expected[i] = 3 * i;
+  }
+  EXPECT_EQ(keys.size(), map.size());
+  EXPECT_EQ(expected, FindAll(map, keys));
+}
+
+TEST(ShardedHashMapTest, Int64KeysSpreadAcrossShards) {
+  // Shards are picked by the top 4 bits of the hash.  Sequential ids, and ids
+  // differing only in their high bits, must land in every shard.
+  const int kNumShards = 16;
+  const int kNumKeys = 16 * 1024;
+  for (const int64 stride : {int64{1}, int64{1} << 40}) {
+    std::vector<int> counts(kNumShards, 0);
+    std::vector<int64> keys(kNumKeys);
+    for (int i = 0; i < kNumKeys; ++i) {
+      keys[i] = i * stride;
+      ++counts[static_cast<uint64>(HashTableKeyHash<int64>()(keys[i])) >> 60];
+    }
+    for (int s = 0; s < kNumShards; ++s) {
+      EXPECT_GT(counts[s], kNumKeys / kNumShards / 2) << "stride " << stride;
+      EXPECT_LT(counts[s], kNumKeys / kNumShards * 2) << "stride " << stride;
+    }
+
+    ShardedHashMap<int64, int64> map;
+    map.Insert(keys.data(), keys.size(),
+               [&keys](int64 i, int64* value) { *value = keys[i] + 1; });
+    EXPECT_EQ(kNumKeys, map.size());
+    std::vector<int64> expected(kNumKeys);
+    for (int i = 0; i < kNumKeys; ++i) {
+      expected[i] = keys[i] + 1;
+    }
+    EXPECT_EQ(expected, FindAll(map, keys));
+  }
+}
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -95,6 +95,22 @@ Status GetInitializableLookupTable(const string& input_name,
   return Status::OK();
 }
 
+Status GetEmbeddingVariable(const string& input_name, OpKernelContext* ctx,
+                            EmbeddingVariable** var) {
+  ResourceHandle handle;
+  TF_RETURN_IF_ERROR(HandleFromInput(ctx, input_name, &handle));
+  LookupInterface* lookup_table;
+  TF_RETURN_IF_ERROR(LookupResource(ctx, handle, &lookup_table));
+  *var = lookup_table->GetEmbeddingVariable();
+  if (*var == nullptr) {
+    lookup_table->Unref();
+    return errors::InvalidArgument("Table ", handle.container(), " ",
+                                   handle.name(),
+                                   " is not an embedding variable");
+  }
+  return Status::OK();
+}
+
 Status CheckTableDataTypes(const LookupInterface& table, DataType key_dtype,
                            DataType value_dtype, const string& table_name) {
   if (table.key_dtype() != key_dtype || table.value_dtype() != value_dtype) {
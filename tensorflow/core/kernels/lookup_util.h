@@ -36,6 +36,11 @@ Status GetInitializableLookupTable(const string& input_name,
                                    OpKernelContext* ctx,
                                    InitializableLookupTable** table);
 
+// Gets the EmbeddingVariable stored in the ctx->resource_manager() with the
+// resource handle passed by the input with name input_name.
+Status GetEmbeddingVariable(const string& input_name, OpKernelContext* ctx,
+                            EmbeddingVariable** var);
+
 // Verify that the given key_dtype and value_dtype matches the corresponding
 // table's data types.
 Status CheckTableDataTypes(const LookupInterface& table, DataType key_dtype,
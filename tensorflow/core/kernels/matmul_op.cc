@@ -22,7 +22,9 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/bias_activation_functor.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/prepacked_gemm.h"
 
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -254,12 +256,44 @@ struct LaunchMatMul<GPUDevice, T, true /* USE_CUBLAS */> {
 
 #endif  // GOOGLE_CUDA
 
+// Multiplies by weights packed once across steps if it is supported, and
+// returns whether it did.
+template <typename Device, typename T>
+struct LaunchPrepackedMatMul {
+  static bool launch(OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+                     bool transpose_a, bool transpose_b,
+                     PrepackedGemmWeightsCache<T>* weights_cache,
+                     Tensor* out) {
+    return false;
+  }
+};
+
+template <>
+struct LaunchPrepackedMatMul<CPUDevice, float> {
+  static bool launch(OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+                     bool transpose_a, bool transpose_b,
+                     PrepackedGemmWeightsCache<float>* weights_cache,
+                     Tensor* out) {
+    // The matrix-vector products are already faster.
+    if (transpose_a || out->dim_size(0) == 1 || out->dim_size(1) == 1) {
+      return false;
+    }
+    weights_cache->Get(ctx, b, transpose_b)
+        ->Multiply(ctx, a.flat<float>().data(), a.dim_size(0),
+                   out->flat<float>().data());
+    return true;
+  }
+};
+
 template <typename Device, typename T, bool USE_CUBLAS>
 class MatMulOp : public OpKernel {
  public:
   explicit MatMulOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_a", &transpose_a_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_b", &transpose_b_));
+    if (ctx->def().attr().count(kPrepackWeightsAttr) > 0) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kPrepackWeightsAttr, &prepack_weights_));
+    }
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -302,12 +336,64 @@ class MatMulOp : public OpKernel {
       return;
     }
 
+    if (prepack_weights_ && LaunchPrepackedMatMul<Device, T>::launch(
+                                ctx, a, b, transpose_a_, transpose_b_,
+                                &prepacked_weights_, out)) {
+      return;
+    }
     LaunchMatMul<Device, T, USE_CUBLAS>::launch(ctx, this, a, b, dim_pair, out);
   }
 
  private:
   bool transpose_a_;
   bool transpose_b_;
+  // Whether the weights 'b' are constant and packed once, see
+  // prepacked_gemm.h.
+  bool prepack_weights_ = false;
+  PrepackedGemmWeightsCache<T> prepacked_weights_;
+};
+
+// MatMul followed by BiasAdd and an activation.  The bias and the activation
+// are applied in a single pass over the product, instead of the two passes of
+// separate BiasAdd and activation kernels.
+template <typename Device, typename T, bool USE_CUBLAS>
+class FusedMatMulOp : public MatMulOp<Device, T, USE_CUBLAS> {
+ public:
+  explicit FusedMatMulOp(OpKernelConstruction* ctx)
+      : MatMulOp<Device, T, USE_CUBLAS>(ctx) {
+    string activation;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("activation", &activation));
+    OP_REQUIRES(ctx,
+                functor::FusedActivationFromString(activation, &activation_),
+                errors::InvalidArgument("Unsupported activation: ",
+                                        activation));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& bias = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("bias must be 1-dimensional: ",
+                                        bias.shape().DebugString()));
+    MatMulOp<Device, T, USE_CUBLAS>::Compute(ctx);
+    if (!ctx->status().ok()) {
+      return;
+    }
+
+    Tensor* out = ctx->mutable_output(0);
+    OP_REQUIRES(ctx, bias.dim_size(0) == out->dim_size(1),
+                errors::InvalidArgument(
+                    "bias must have the size of the columns of the product: ",
+                    bias.dim_size(0), " vs ", out->dim_size(1)));
+    if (out->NumElements() == 0) {
+      return;
+    }
+    functor::BiasActivation<Device, T>()(
+        ctx->eigen_device<Device>(), bias.vec<T>(), activation_,
+        out->shaped<T, 3>({out->dim_size(0), out->dim_size(1), 1}));
+  }
+
+ private:
+  functor::FusedActivation activation_;
 };
 
 namespace functor {
@@ -338,6 +424,19 @@ struct MatMulFunctor<SYCLDevice, T> {
 };
 #endif  // TENSORFLOW_USE_SYCL
 
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+#define DECLARE_GPU_SPEC(T)                                              \
+  template <>                                                            \
+  void BiasActivation<GPUDevice, T>::operator()(                         \
+      const GPUDevice& d, typename TTypes<T>::ConstVec bias,             \
+      FusedActivation activation, typename TTypes<T, 3>::Tensor output); \
+  extern template struct BiasActivation<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(float);
+#undef DECLARE_GPU_SPEC
+#endif  // GOOGLE_CUDA
+
 }  // end namespace functor
 
 #define REGISTER_CPU(T)                                                        \
@@ -374,7 +473,15 @@ TF_CALL_complex64(REGISTER_CPU);
 TF_CALL_complex128(REGISTER_CPU);
 #endif
 
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedMatMul").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    FusedMatMulOp<CPUDevice, float, false /* cublas, ignored for CPU */>);
+
 #if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedMatMulOp<GPUDevice, float, true /* cublas */>);
+
 TF_CALL_float(REGISTER_GPU);
 TF_CALL_double(REGISTER_GPU);
 TF_CALL_complex64(REGISTER_GPU);
@@ -652,6 +652,12 @@ BM_ConvFloatDepthwiseFwd(32, 7, 7, 1024, 1, 1024, 3, 3, 1, SAME, conv6);
 // Benchmarks with different stride and padding options.
 BM_ConvFloatDepthwiseFwd(32, 112, 112, 3, 8, 24, 3, 3, 2, SAME, conv7);
 BM_ConvFloatDepthwiseFwd(32, 112, 112, 3, 8, 24, 3, 3, 2, VALID, conv8);
+// Single images, as in inference on mobile devices.
+BM_ConvFloatDepthwiseFwd(1, 112, 112, 32, 1, 32, 3, 3, 1, SAME, mobile0);
+BM_ConvFloatDepthwiseFwd(1, 112, 112, 64, 1, 64, 3, 3, 2, SAME, mobile1);
+BM_ConvFloatDepthwiseFwd(1, 28, 28, 256, 1, 256, 3, 3, 1, SAME, mobile2);
+BM_ConvFloatDepthwiseFwd(1, 14, 14, 512, 1, 512, 3, 3, 1, SAME, mobile3);
+BM_ConvFloatDepthwiseFwd(1, 7, 7, 1024, 1, 1024, 3, 3, 1, SAME, mobile4);
 
 #define BM_ConvFloatDepthwiseBk(BS, R, C, ID, DM, OD, KR, KC, STR, PAD, LABEL) \
   static void BM_ConvFloatDepthwiseBkInCPU1_##LABEL(int iters) {               \
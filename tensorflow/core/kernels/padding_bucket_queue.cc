@@ -0,0 +1,355 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/data_flow_ops.cc.
+
+#include "tensorflow/core/kernels/padding_bucket_queue.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+PaddingBucketQueue::PaddingBucketQueue(
+    int32 capacity, const DataTypeVector& component_dtypes,
+    const std::vector<PartialTensorShape>& component_shapes,
+    int bucket_component, const std::vector<int64>& bucket_boundaries,
+    const string& name)
+    : PaddingFIFOQueue(capacity, component_dtypes, component_shapes, name),
+      bucket_component_(bucket_component),
+      bucket_boundaries_(bucket_boundaries) {}
+
+Status PaddingBucketQueue::Initialize() {
+  TF_RETURN_IF_ERROR(PaddingFIFOQueue::Initialize());
+  if (bucket_component_ < 0 || bucket_component_ >= num_components()) {
+    return errors::InvalidArgument("bucket_component ", bucket_component_,
+                                   " is not a component of the ",
+                                   num_components(), " of queue ", name_);
+  }
+  if (partial_shapes_[bucket_component_].dims() < 1) {
+    return errors::InvalidArgument(
+        "Component ", bucket_component_, " of queue ", name_,
+        " has no dimension to bucket by, its shape is ",
+        partial_shapes_[bucket_component_].DebugString());
+  }
+  for (size_t b = 1; b < bucket_boundaries_.size(); ++b) {
+    if (bucket_boundaries_[b] <= bucket_boundaries_[b - 1]) {
+      return errors::InvalidArgument(
+          "bucket_boundaries of queue ", name_,
+          " must be strictly increasing, got ",
+          str_util::Join(bucket_boundaries_, ", "));
+    }
+  }
+
+  mutex_lock lock(mu_);
+  queues_.resize(num_buckets() * num_components());
+  return Status::OK();
+}
+
+int PaddingBucketQueue::Bucket(int64 size) const {
+  return std::upper_bound(bucket_boundaries_.begin(), bucket_boundaries_.end(),
+                          size) -
+         bucket_boundaries_.begin();
+}
+
+int PaddingBucketQueue::FullestBucketLocked() const {
+  int fullest = 0;
+  for (int b = 1; b < num_buckets(); ++b) {
+    if (BucketSize(b) > BucketSize(fullest)) {
+      fullest = b;
+    }
+  }
+  return fullest;
+}
+
+void PaddingBucketQueue::EnqueueLocked(int64 size,
+                                       std::vector<PersistentTensor> element) {
+  const int bucket = Bucket(size);
+  for (int i = 0; i < num_components(); ++i) {
+    BucketComponent(bucket, i).push_back(std::move(element[i]));
+  }
+  ++num_elements_;
+}
+
+void PaddingBucketQueue::DequeueBatchLocked(int bucket, int num_elements,
+                                            OpKernelContext* ctx,
+                                            std::vector<Tuple>* tuples) {
+  DCHECK_LE(num_elements, num_elements_);
+  // Visit bucket, bucket - 1, bucket + 1, bucket - 2, ...
+  for (int distance = 0; tuples->size() < num_elements; ++distance) {
+    DCHECK_LT(distance, num_buckets());
+    for (const int b : {bucket - distance, bucket + distance}) {
+      if (b < 0 || b >= num_buckets()) {
+        continue;
+      }
+      while (tuples->size() < num_elements && BucketSize(b) > 0) {
+        Tuple tuple;
+        tuple.reserve(num_components());
+        for (int i = 0; i < num_components(); ++i) {
+          std::deque<PersistentTensor>& component = BucketComponent(b, i);
+          tuple.push_back(*component.front().AccessTensor(ctx));
+          component.pop_front();
+        }
+        tuples->push_back(std::move(tuple));
+        --num_elements_;
+      }
+    }
+  }
+}
+
+void PaddingBucketQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                                    DoneCallback callback) {
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      enqueue_attempts_.emplace_back(
+          1, callback, ctx, cm, token,
+          [tuple, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_) {
+              attempt->context->SetStatus(errors::Cancelled(
+                  "PaddingBucketQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            if (num_elements_ < capacity_) {
+              std::vector<PersistentTensor> element;
+              element.reserve(num_components());
+              for (int i = 0; i < num_components(); ++i) {
+                element.emplace_back(tuple[i]);
+              }
+              EnqueueLocked(tuple[bucket_component_].dim_size(0),
+                            std::move(element));
+              return kComplete;
+            } else {
+              return kNoProgress;
+            }
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void PaddingBucketQueue::TryEnqueueMany(const Tuple& tuple,
+                                        OpKernelContext* ctx,
+                                        DoneCallback callback) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  if (batch_size == 0) {
+    callback();
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      enqueue_attempts_.emplace_back(
+          batch_size, callback, ctx, cm, token,
+          [tuple, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_) {
+              attempt->context->SetStatus(errors::Cancelled(
+                  "PaddingBucketQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            RunResult result = kNoProgress;
+            while (num_elements_ < capacity_) {
+              result = kProgress;
+              const int64 index =
+                  tuple[0].dim_size(0) - attempt->elements_requested;
+              std::vector<PersistentTensor> element(num_components());
+              for (int i = 0; i < num_components(); ++i) {
+                attempt->context->SetStatus(GetElementComponentFromBatch(
+                    tuple, index, i, attempt->context, &element[i]));
+                if (!attempt->context->status().ok()) return kComplete;
+              }
+              EnqueueLocked(tuple[bucket_component_].dim_size(1),
+                            std::move(element));
+              --attempt->elements_requested;
+              if (attempt->elements_requested == 0) {
+                return kComplete;
+              }
+            }
+            return result;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void PaddingBucketQueue::TryDequeue(OpKernelContext* ctx,
+                                    CallbackWithTuple callback) {
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      dequeue_attempts_.emplace_back(
+          1, [callback]() { callback(Tuple()); }, ctx, cm, token,
+          [callback, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_ && num_elements_ == 0) {
+              attempt->context->SetStatus(errors::OutOfRange(
+                  "PaddingBucketQueue '", name_, "' is closed and has ",
+                  "insufficient elements (requested ", 1, ", current size ",
+                  num_elements_, ")"));
+              return kComplete;
+            }
+            if (num_elements_ > 0) {
+              std::vector<Tuple> tuples;
+              DequeueBatchLocked(FullestBucketLocked(), 1, attempt->context,
+                                 &tuples);
+              const Tuple tuple = tuples[0];
+              attempt->done_callback = [callback, tuple]() { callback(tuple); };
+              return kComplete;
+            } else {
+              return kNoProgress;
+            }
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(Tuple());
+  }
+}
+
+void PaddingBucketQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                                        bool allow_small_batch,
+                                        CallbackWithTuple callback) {
+  if (num_elements == 0) {
+    PaddingFIFOQueue::TryDequeueMany(num_elements, ctx, allow_small_batch,
+                                     callback);
+    return;
+  }
+  // Batches are dequeued at once, so they have to fit in the queue.
+  if (num_elements > capacity_) {
+    ctx->SetStatus(errors::InvalidArgument(
+        "PaddingBucketQueue '", name_, "' can't dequeue ", num_elements,
+        " elements, which is more than its capacity of ", capacity_));
+    callback(Tuple());
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      dequeue_attempts_.emplace_back(
+          num_elements, [callback]() { callback(Tuple()); }, ctx, cm, token,
+          [callback, allow_small_batch,
+           this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            const int32 requested = attempt->elements_requested;
+            const int fullest = FullestBucketLocked();
+            int batch_size = 0;
+            if (BucketSize(fullest) >= requested) {
+              batch_size = requested;
+            } else if (closed_ && allow_small_batch && num_elements_ > 0) {
+              // Rather than mixing the remaining elements of all buckets,
+              // return them bucket by bucket.
+              batch_size = BucketSize(fullest);
+            } else if (num_elements_ >= requested &&
+                       (closed_ || num_elements_ >= capacity_)) {
+              // No bucket is going to fill a batch on its own.
+              batch_size = requested;
+            } else if (closed_) {
+              // There may be some enqueue attempts containing values.  If
+              // so, we'll yield and wait for them to add elements to the
+              // queue.
+              if (allow_small_batch && !enqueue_attempts_.empty()) {
+                return kProgress;
+              }
+              attempt->context->SetStatus(errors::OutOfRange(
+                  "PaddingBucketQueue '", name_, "' is closed and has ",
+                  "insufficient elements (requested ", requested,
+                  ", current size ", num_elements_, ")"));
+              return kComplete;
+            } else {
+              return kNoProgress;
+            }
+
+            DequeueBatchLocked(fullest, batch_size, attempt->context,
+                               &attempt->tuples);
+            attempt->context->SetStatus(CopyElementsToPaddedBatch(
+                attempt->tuples, attempt->context, &attempt->tuple));
+            attempt->tuples.clear();
+            if (!attempt->context->status().ok()) return kComplete;
+            const Tuple tuple = attempt->tuple;
+            attempt->done_callback = [callback, tuple]() { callback(tuple); };
+            return kComplete;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(Tuple());
+  }
+}
+
+Status PaddingBucketQueue::MatchesNodeDef(const NodeDef& node_def) {
+  TF_RETURN_IF_ERROR(MatchesNodeDefOp(node_def, "PaddingBucketQueue"));
+  TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
+  TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
+  TF_RETURN_IF_ERROR(CompatibleNodeDefShapes(node_def));
+  int bucket_component;
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(node_def, "bucket_component", &bucket_component));
+  std::vector<int64> bucket_boundaries;
+  TF_RETURN_IF_ERROR(
+      GetNodeAttr(node_def, "bucket_boundaries", &bucket_boundaries));
+  if (bucket_component != bucket_component_ ||
+      bucket_boundaries != bucket_boundaries_) {
+    return errors::InvalidArgument(
+        "Shared queue '", name_, "' buckets component ", bucket_component_,
+        " with boundaries [", str_util::Join(bucket_boundaries_, ", "),
+        "] but requested component ", bucket_component,
+        " with boundaries [", str_util::Join(bucket_boundaries, ", "), "]");
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,116 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_PADDING_BUCKET_QUEUE_H_
+#define TENSORFLOW_KERNELS_PADDING_BUCKET_QUEUE_H_
+
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/padding_fifo_queue.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A PaddingFIFOQueue whose elements are grouped into buckets by the size of
+// the first dimension of one of their components, e.g. the length of a
+// sequence, so that DequeueMany returns batches of elements of similar sizes
+// that need little padding.
+//
+// An element goes to the first bucket b whose boundary bucket_boundaries[b]
+// is larger than its size, or to the last of the bucket_boundaries.size() + 1
+// buckets if there is none.  DequeueMany(n) takes its n elements from the
+// fullest bucket once one holds n of them.  When the queue is full or closed
+// and no bucket can fill a batch on its own, the batch is completed from the
+// buckets nearest to the fullest one, so that producers never block on
+// buckets that fill up slowly.  Each bucket keeps its elements in first-in
+// first-out order.
+class PaddingBucketQueue : public PaddingFIFOQueue {
+ public:
+  PaddingBucketQueue(int32 capacity, const DataTypeVector& component_dtypes,
+                     const std::vector<PartialTensorShape>& component_shapes,
+                     int bucket_component,
+                     const std::vector<int64>& bucket_boundaries,
+                     const string& name);
+
+  Status Initialize() override;
+
+  // Implementations of QueueInterface methods --------------------------------
+
+  void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                  DoneCallback callback) override;
+  void TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                      DoneCallback callback) override;
+  void TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) override;
+  void TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                      bool allow_small_batch,
+                      CallbackWithTuple callback) override;
+  Status MatchesNodeDef(const NodeDef& node_def) override;
+
+  int32 size() override {
+    mutex_lock lock(mu_);
+    return num_elements_;
+  }
+
+ private:
+  ~PaddingBucketQueue() override {}
+
+  int num_buckets() const { return bucket_boundaries_.size() + 1; }
+
+  // Returns the bucket of the elements whose bucketed component has "size"
+  // as first dimension.
+  int Bucket(int64 size) const;
+
+  // queues_ holds the components of the elements of each bucket, bucket
+  // after bucket.
+  std::deque<PersistentTensor>& BucketComponent(int bucket, int component)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queues_[bucket * num_components() + component];
+  }
+  int64 BucketSize(int bucket) const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queues_[bucket * num_components()].size();
+  }
+
+  // Returns the bucket holding the most elements, the first one on ties.
+  int FullestBucketLocked() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Appends "element", whose bucketed component has "size" as first
+  // dimension, to its bucket.
+  void EnqueueLocked(int64 size, std::vector<PersistentTensor> element)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Removes "num_elements" elements from the queue into "tuples", taking all
+  // of them from "bucket" if it holds enough, and the rest from the buckets
+  // nearest to it.
+  void DequeueBatchLocked(int bucket, int num_elements, OpKernelContext* ctx,
+                          std::vector<Tuple>* tuples)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int bucket_component_;
+  const std::vector<int64> bucket_boundaries_;
+  int32 num_elements_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PaddingBucketQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_PADDING_BUCKET_QUEUE_H_
@@ -154,63 +154,9 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
               if (attempt->elements_requested == 0) {
                 // Finished.  Allocate attempt->tuple and
                 // copy from attempt->tuples to attempt->tuple.
-                attempt->tuple.reserve(num_components());
-                const std::vector<Tuple>& tuples = attempt->tuples;
-
-                std::vector<bool> dynamic_shape;
-                const int64 batch_size = tuples.size();
-
-                for (int i = 0; i < num_components(); ++i) {
-                  const PartialTensorShape partial_shape =
-                      PartialTensorShape({batch_size})
-                          .Concatenate(partial_shapes_[i]);
-                  TensorShape shape({batch_size});
-
-                  for (int j = 0; j < partial_shape.dims() - 1; ++j) {
-                    if (partial_shape.dim_size(j + 1) > -1) {
-                      shape.AddDim(partial_shape.dim_size(j + 1));
-                    } else {
-                      // Expand sizes to match.
-                      int64 max_val = 0;
-                      for (const Tuple& t : tuples) {
-                        max_val = std::max(max_val, t[i].shape().dim_size(j));
-                      }
-                      shape.AddDim(max_val);
-                    }
-                  }
-
-                  Tensor element;
-                  attempt->context->SetStatus(attempt->context->allocate_temp(
-                      component_dtypes_[i], shape, &element));
-                  if (!attempt->context->status().ok()) return kComplete;
-
-                  bool has_dynamic_shape = !partial_shape.IsFullyDefined();
-                  if (has_dynamic_shape) {
-                    // Set all values to zero because not all values
-                    // will get written over.
-                    attempt->context->SetStatus(SetElementZero(&element));
-                    if (!attempt->context->status().ok()) return kComplete;
-                  }
-
-                  dynamic_shape.push_back(has_dynamic_shape);
-
-                  // TODO(ebrevdo): should this be a persistent tensor?
-                  attempt->tuple.emplace_back(element);
-                }
-
-                for (size_t index = 0; index < tuples.size(); ++index) {
-                  for (int i = 0; i < num_components(); ++i) {
-                    if (dynamic_shape[i]) {
-                      // Slightly slower copy operation
-                      attempt->context->SetStatus(CopyElementToLargerSlice(
-                          tuples[index][i], &attempt->tuple[i], index));
-                    } else {
-                      attempt->context->SetStatus(CopyElementToSlice(
-                          tuples[index][i], &attempt->tuple[i], index));
-                    }
-                    if (!attempt->context->status().ok()) return kComplete;
-                  }
-                }
+                attempt->context->SetStatus(CopyElementsToPaddedBatch(
+                    attempt->tuples, attempt->context, &attempt->tuple));
+                if (!attempt->context->status().ok()) return kComplete;
                 tuple = attempt->tuple;
                 attempt->tuples.clear();
                 attempt->done_callback = [callback, tuple]() {
@@ -231,6 +177,63 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 }
 
+Status PaddingFIFOQueue::CopyElementsToPaddedBatch(
+    const std::vector<Tuple>& tuples, OpKernelContext* ctx, Tuple* batch) {
+  batch->reserve(num_components());
+  std::vector<bool> dynamic_shape;
+  const int64 batch_size = tuples.size();
+
+  for (int i = 0; i < num_components(); ++i) {
+    const PartialTensorShape partial_shape =
+        PartialTensorShape({batch_size}).Concatenate(partial_shapes_[i]);
+    TensorShape shape({batch_size});
+
+    for (int j = 0; j < partial_shape.dims() - 1; ++j) {
+      if (partial_shape.dim_size(j + 1) > -1) {
+        shape.AddDim(partial_shape.dim_size(j + 1));
+      } else {
+        // Expand sizes to match.
+        int64 max_val = 0;
+        for (const Tuple& t : tuples) {
+          max_val = std::max(max_val, t[i].shape().dim_size(j));
+        }
+        shape.AddDim(max_val);
+      }
+    }
+
+    Tensor element;
+    // The batch becomes output i of the op, allocated as the output, e.g. in
+    // pinned memory for a GPU.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(component_dtypes_[i], shape,
+                                          &element, ctx->output_alloc_attr(i)));
+
+    bool has_dynamic_shape = !partial_shape.IsFullyDefined();
+    if (has_dynamic_shape) {
+      // Set all values to zero because not all values will get written over.
+      TF_RETURN_IF_ERROR(SetElementZero(&element));
+    }
+
+    dynamic_shape.push_back(has_dynamic_shape);
+
+    // TODO(ebrevdo): should this be a persistent tensor?
+    batch->emplace_back(element);
+  }
+
+  for (size_t index = 0; index < tuples.size(); ++index) {
+    for (int i = 0; i < num_components(); ++i) {
+      if (dynamic_shape[i]) {
+        // Slightly slower copy operation
+        TF_RETURN_IF_ERROR(
+            CopyElementToLargerSlice(tuples[index][i], &(*batch)[i], index));
+      } else {
+        TF_RETURN_IF_ERROR(
+            CopyElementToSlice(tuples[index][i], &(*batch)[i], index));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status PaddingFIFOQueue::ValidateTuple(const Tuple& tuple) {
   TF_RETURN_IF_ERROR(ValidateTupleCommon(tuple));
   for (size_t i = 0; i < tuple.size(); ++i) {
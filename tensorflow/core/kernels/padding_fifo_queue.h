@@ -62,6 +62,12 @@ class PaddingFIFOQueue : public FIFOQueue {
   // Sets the values in the given element to zero.
   static Status SetElementZero(Tensor* element);
 
+  // Allocates in "batch" the batch of the elements in "tuples", with the
+  // dimensions of unknown size of each component padded with zeros to the
+  // largest element, and copies the elements into it.
+  Status CopyElementsToPaddedBatch(const std::vector<Tuple>& tuples,
+                                   OpKernelContext* ctx, Tuple* batch);
+
   // Copies element into the index^th slice (in the first dimension)
   // of parent.  Allows for the parent's slice to have a larger size
   // than the element, and copies the element into the upper left hand
@@ -71,9 +77,10 @@ class PaddingFIFOQueue : public FIFOQueue {
 
   std::vector<PartialTensorShape> partial_shapes_;
 
- private:
   ~PaddingFIFOQueue() override {}
 
+ private:
+
   static Status GetElementComponent(const PaddingFIFOQueue::Tuple& tuple,
                                     int component, OpKernelContext* ctx,
                                     PersistentTensor* out_tensor);
@@ -0,0 +1,248 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_PREPACKED_GEMM_H_
+#define TENSORFLOW_KERNELS_PREPACKED_GEMM_H_
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Boolean attribute of the MatMul and Conv2D nodes whose weights are constant,
+// set by the prepack_weights graph transform. Their CPU kernels then pack the
+// weights once in the blocked layout of the GEMM kernels, instead of on every
+// step.
+constexpr const char* const kPrepackWeightsAttr = "_prepack_weights";
+
+// Weights of matrix multiplications out = in * weights, packed once in the
+// blocked layout of the Eigen GEMM kernels, so that the multiplications skip
+// the packing of the weights.
+//
+// The row-major product is computed as out' = weights' * in' in column-major
+// order, so the weights are the left-hand side of the GEMM. They are packed by
+// blocks of mc_ columns and kc_ depth.
+template <typename T>
+class PrepackedGemmWeights {
+ public:
+  typedef Eigen::internal::gebp_traits<T, T> Traits;
+
+  // Packs 'weights' of shape [depth, cols], or [cols, depth] if 'transposed',
+  // in blocks for multiplications sharded over 'num_threads'.
+  PrepackedGemmWeights(const Tensor& weights, bool transposed,
+                       int num_threads)
+      : source_(weights.tensor_data().data()),
+        source_shape_(weights.shape()),
+        transposed_(transposed),
+        depth_(weights.dim_size(transposed ? 1 : 0)),
+        cols_(weights.dim_size(transposed ? 0 : 1)) {
+    // The blocking of the weights depends little on the number of rows of
+    // the inputs, so it is chosen for a small batch.
+    int64 kc = depth_;
+    int64 mc = cols_;
+    int64 nc = kInputRowsBlock;
+    Eigen::internal::computeProductBlockingSizes<T, T, 1>(kc, mc, nc);
+    kc_ = std::max<int64>(1, kc);
+    // There are at least as many blocks of columns as threads.
+    const int64 cols_per_thread =
+        RoundUp((cols_ + num_threads - 1) / num_threads, Traits::mr);
+    mc_ = std::max<int64>(1, std::min(mc, cols_per_thread));
+
+    int64 size = 0;
+    for (int64 i = 0; i < cols_; i += mc_) {
+      for (int64 k = 0; k < depth_; k += kc_) {
+        block_offsets_.push_back(size);
+        size += RoundUp(BlockSize(i, mc_, cols_) * BlockSize(k, kc_, depth_),
+                        kAlignment);
+      }
+    }
+    packed_ = Tensor(DataTypeToEnum<T>::value, TensorShape({size}));
+    const T* data = weights.flat<T>().data();
+    if (transposed) {
+      PackWeights<Eigen::RowMajor>(LhsMapper<Eigen::RowMajor>(data, depth_));
+    } else {
+      PackWeights<Eigen::ColMajor>(LhsMapper<Eigen::ColMajor>(data, cols_));
+    }
+  }
+
+  // Whether these are the packed 'weights'. Const tensors keep their buffer
+  // across steps.
+  bool IsPackedFrom(const Tensor& weights, bool transposed) const {
+    return source_ == weights.tensor_data().data() &&
+           source_shape_ == weights.shape() && transposed_ == transposed;
+  }
+
+  int64 depth() const { return depth_; }
+  int64 cols() const { return cols_; }
+
+  // Computes 'out' = 'in' * weights, with row-major 'in' of shape
+  // [rows, depth] and 'out' of shape [rows, cols].
+  void Multiply(OpKernelContext* ctx, const T* in, int64 rows, T* out) const {
+    const int64 num_k_blocks = (depth_ + kc_ - 1) / kc_;
+    const int64 num_col_blocks = (cols_ + mc_ - 1) / mc_;
+    const int64 num_row_blocks =
+        (rows + kInputRowsBlock - 1) / kInputRowsBlock;
+
+    // Only the inputs are packed on each call.
+    std::vector<int64> in_offsets;
+    int64 size = 0;
+    for (int64 j = 0; j < rows; j += kInputRowsBlock) {
+      for (int64 k = 0; k < depth_; k += kc_) {
+        in_offsets.push_back(size);
+        size += RoundUp(
+            BlockSize(j, kInputRowsBlock, rows) * BlockSize(k, kc_, depth_),
+            kAlignment);
+      }
+    }
+    Tensor packed_in;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                           TensorShape({size}), &packed_in));
+    T* packed_in_data = packed_in.flat<T>().data();
+    const RhsMapper in_mapper(in, depth_);
+    Eigen::internal::gemm_pack_rhs<T, int64, RhsMapper, Traits::nr,
+                                   Eigen::ColMajor>
+        pack_rhs;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_row_blocks,
+          kInputRowsBlock * depth_, [&](int64 start, int64 limit) {
+            for (int64 jb = start; jb < limit; ++jb) {
+              const int64 j = jb * kInputRowsBlock;
+              for (int64 kb = 0; kb < num_k_blocks; ++kb) {
+                const int64 k = kb * kc_;
+                pack_rhs(packed_in_data + in_offsets[jb * num_k_blocks + kb],
+                         in_mapper.getSubMapper(k, j),
+                         BlockSize(k, kc_, depth_),
+                         BlockSize(j, kInputRowsBlock, rows));
+              }
+            }
+          });
+
+    // Each block of columns and rows of the output is computed separately.
+    memset(out, 0, rows * cols_ * sizeof(T));
+    const OutputMapper out_mapper(out, cols_);
+    const T* packed_weights = packed_.flat<T>().data();
+    Eigen::internal::gebp_kernel<T, T, int64, OutputMapper, Traits::mr,
+                                 Traits::nr, false, false>
+        gebp;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_col_blocks * num_row_blocks, mc_ * kInputRowsBlock * depth_,
+          [&](int64 start, int64 limit) {
+            for (int64 block = start; block < limit; ++block) {
+              const int64 ib = block / num_row_blocks;
+              const int64 jb = block % num_row_blocks;
+              const int64 i = ib * mc_;
+              const int64 j = jb * kInputRowsBlock;
+              for (int64 kb = 0; kb < num_k_blocks; ++kb) {
+                const int64 k = kb * kc_;
+                gebp(out_mapper.getSubMapper(i, j),
+                     packed_weights + block_offsets_[ib * num_k_blocks + kb],
+                     packed_in_data + in_offsets[jb * num_k_blocks + kb],
+                     BlockSize(i, mc_, cols_), BlockSize(k, kc_, depth_),
+                     BlockSize(j, kInputRowsBlock, rows), T(1));
+              }
+            }
+          });
+  }
+
+ private:
+  template <int StorageOrder>
+  using LhsMapper =
+      Eigen::internal::const_blas_data_mapper<T, int64, StorageOrder>;
+  typedef Eigen::internal::const_blas_data_mapper<T, int64, Eigen::ColMajor>
+      RhsMapper;
+  typedef Eigen::internal::blas_data_mapper<T, int64, Eigen::ColMajor>
+      OutputMapper;
+
+  // The number of rows of the inputs packed together.
+  static constexpr int64 kInputRowsBlock = 64;
+  // The packed blocks are aligned for packet loads.
+  static constexpr int64 kAlignment =
+      std::max<int64>(1, EIGEN_MAX_ALIGN_BYTES / sizeof(T));
+
+  static int64 RoundUp(int64 value, int64 multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+  }
+
+  // The size of the block starting at 'start' along a dimension of 'size'.
+  static int64 BlockSize(int64 start, int64 block, int64 size) {
+    return std::min(start + block, size) - start;
+  }
+
+  template <int StorageOrder>
+  void PackWeights(const LhsMapper<StorageOrder>& mapper) {
+    Eigen::internal::gemm_pack_lhs<T, int64, LhsMapper<StorageOrder>,
+                                   Traits::mr, Traits::LhsProgress,
+                                   StorageOrder>
+        pack_lhs;
+    T* packed = packed_.flat<T>().data();
+    const int64 num_k_blocks = (depth_ + kc_ - 1) / kc_;
+    for (int64 i = 0, ib = 0; i < cols_; i += mc_, ++ib) {
+      for (int64 k = 0, kb = 0; k < depth_; k += kc_, ++kb) {
+        pack_lhs(packed + block_offsets_[ib * num_k_blocks + kb],
+                 mapper.getSubMapper(i, k), BlockSize(k, kc_, depth_),
+                 BlockSize(i, mc_, cols_));
+      }
+    }
+  }
+
+  const char* const source_;
+  const TensorShape source_shape_;
+  const bool transposed_;
+  const int64 depth_;
+  const int64 cols_;
+  int64 kc_;
+  int64 mc_;
+  std::vector<int64> block_offsets_;
+  Tensor packed_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrepackedGemmWeights);
+};
+
+// Caches the packed weights of a kernel across steps, repacking them only if
+// the kernel gets other weights.
+template <typename T>
+class PrepackedGemmWeightsCache {
+ public:
+  std::shared_ptr<const PrepackedGemmWeights<T>> Get(OpKernelContext* ctx,
+                                                     const Tensor& weights,
+                                                     bool transposed) {
+    mutex_lock l(mu_);
+    if (weights_ == nullptr || !weights_->IsPackedFrom(weights, transposed)) {
+      const int num_threads =
+          ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+      weights_.reset(
+          new PrepackedGemmWeights<T>(weights, transposed, num_threads));
+    }
+    return weights_;
+  }
+
+ private:
+  mutex mu_;
+  std::shared_ptr<const PrepackedGemmWeights<T>> weights_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_PREPACKED_GEMM_H_
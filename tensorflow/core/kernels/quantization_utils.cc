@@ -39,4 +39,16 @@ void GetOutputMinAndMaxForQuantizedAdd(float input_min, float input_max,
   *output_min = -(*output_max);
 }
 
+void RescaleQuantizedChannels(const std::vector<double>& channel_scales,
+                              Tensor* accumulators) {
+  auto values = accumulators->flat_inner_dims<qint32>();
+  DCHECK_EQ(channel_scales.size(), values.dimension(1));
+  for (int64 row = 0; row < values.dimension(0); ++row) {
+    for (int64 channel = 0; channel < values.dimension(1); ++channel) {
+      values(row, channel) = static_cast<int32>(
+          std::round(values(row, channel).value * channel_scales[channel]));
+    }
+  }
+}
+
 }  // namespace tensorflow
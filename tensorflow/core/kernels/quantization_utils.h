@@ -24,10 +24,14 @@ limitations under the License.
 // optimized. They should be implementable using fixed point representations
 // to avoid a dependency on floating-point hardware.
 
+#include <cmath>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #define GEMMLOWP_ALLOW_SLOW_SCALAR_FALLBACK
 #include "public/gemmlowp.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 
 namespace tensorflow {
@@ -395,6 +399,137 @@ Tensor QuantizedTensorToFloat(const Tensor& input, float min, float max) {
   return result;
 }
 
+// With per-channel quantization, each slice of a tensor along one dimension,
+// usually the output channels of weights, has its own range. The quantized
+// ops need the quantized value of zero to be the same in all the channels, so
+// the channel ranges are symmetric around zero, covering
+// [-2^(bits - 1), 2^(bits - 1) - 1] quantization steps.
+
+// Sets 'min' and 'max' to the symmetric range holding values up to 'abs_max'.
+template <class T>
+void SymmetricQuantizationRange(float abs_max, float* min, float* max) {
+  const int number_of_bits = sizeof(T) * 8;
+  const double half_steps =
+      static_cast<double>(static_cast<int64>(1) << (number_of_bits - 1));
+  // An all-zero channel still needs a non-empty range.
+  const double step = (abs_max > 0.0f ? abs_max : 1.0f) / (half_steps - 1.0);
+  *min = -half_steps * step;
+  *max = (half_steps - 1.0) * step;
+}
+
+// Quantizes each slice of 'input' along 'channel_dim' into its own symmetric
+// range, which is returned in the 1-D 'mins' and 'maxs'.
+template <class T>
+void FloatTensorToQuantizedPerChannel(const Tensor& input, int channel_dim,
+                                      Tensor* output, Tensor* mins,
+                                      Tensor* maxs) {
+  const int64 num_channels = input.dim_size(channel_dim);
+  int64 outer_size = 1;
+  for (int i = 0; i < channel_dim; ++i) {
+    outer_size *= input.dim_size(i);
+  }
+  int64 inner_size = 1;
+  for (int i = channel_dim + 1; i < input.dims(); ++i) {
+    inner_size *= input.dim_size(i);
+  }
+  *output = Tensor(DataTypeToEnum<T>::v(), input.shape());
+  *mins = Tensor(DT_FLOAT, TensorShape({num_channels}));
+  *maxs = Tensor(DT_FLOAT, TensorShape({num_channels}));
+  auto input_values =
+      input.shaped<float, 3>({outer_size, num_channels, inner_size});
+  auto output_values =
+      output->shaped<T, 3>({outer_size, num_channels, inner_size});
+  for (int64 channel = 0; channel < num_channels; ++channel) {
+    float abs_max = 0.0f;
+    for (int64 outer = 0; outer < outer_size; ++outer) {
+      for (int64 inner = 0; inner < inner_size; ++inner) {
+        abs_max =
+            std::max(abs_max, std::abs(input_values(outer, channel, inner)));
+      }
+    }
+    float min;
+    float max;
+    SymmetricQuantizationRange<T>(abs_max, &min, &max);
+    mins->flat<float>()(channel) = min;
+    maxs->flat<float>()(channel) = max;
+    for (int64 outer = 0; outer < outer_size; ++outer) {
+      for (int64 inner = 0; inner < inner_size; ++inner) {
+        output_values(outer, channel, inner) =
+            FloatToQuantized<T>(input_values(outer, channel, inner), min, max);
+      }
+    }
+  }
+}
+
+// Reads the range of an input of a quantized op, given as 'min_tensor' and
+// 'max_tensor' holding either a single range or one per each of the
+// 'num_channels' channels. Sets 'min' and 'max' to the widest of the ranges,
+// and 'channel_scales' to the width of each channel range relative to it, or
+// clears it if all the ranges are the same. The 32-bit results of each channel
+// are then brought into the widest range by RescaleQuantizedChannels().
+template <class T>
+Status GetChannelQuantizationRanges(const Tensor& min_tensor,
+                                    const Tensor& max_tensor,
+                                    int64 num_channels, float* min,
+                                    float* max,
+                                    std::vector<double>* channel_scales) {
+  channel_scales->clear();
+  if (min_tensor.NumElements() == 1 && max_tensor.NumElements() == 1) {
+    *min = min_tensor.flat<float>()(0);
+    *max = max_tensor.flat<float>()(0);
+    return Status::OK();
+  }
+  if (min_tensor.dims() != 1 || max_tensor.dims() != 1 ||
+      min_tensor.NumElements() != num_channels ||
+      max_tensor.NumElements() != num_channels) {
+    return errors::InvalidArgument(
+        "The quantization ranges must be scalars or vectors of the ",
+        num_channels, " channels: ", min_tensor.shape().DebugString(), " and ",
+        max_tensor.shape().DebugString());
+  }
+  const auto mins = min_tensor.flat<float>();
+  const auto maxs = max_tensor.flat<float>();
+  int64 widest = 0;
+  for (int64 channel = 0; channel < num_channels; ++channel) {
+    if (!(maxs(channel) > mins(channel))) {
+      return errors::InvalidArgument("The quantization range of channel ",
+                                     channel, " is empty: [", mins(channel),
+                                     ", ", maxs(channel), "]");
+    }
+    if (FloatToQuantizedUnclamped<T>(0.0f, mins(channel), maxs(channel)) !=
+        FloatToQuantizedUnclamped<T>(0.0f, mins(0), maxs(0))) {
+      return errors::InvalidArgument(
+          "The quantization ranges of all the channels must represent zero "
+          "with the same quantized value, as the symmetric ranges of "
+          "per-channel quantization do, but channel ",
+          channel, " has the range [", mins(channel), ", ", maxs(channel),
+          "] and channel 0 [", mins(0), ", ", maxs(0), "]");
+    }
+    if (maxs(channel) - mins(channel) > maxs(widest) - mins(widest)) {
+      widest = channel;
+    }
+  }
+  *min = mins(widest);
+  *max = maxs(widest);
+  const double widest_range = static_cast<double>(*max) - *min;
+  bool all_same = true;
+  channel_scales->resize(num_channels);
+  for (int64 channel = 0; channel < num_channels; ++channel) {
+    (*channel_scales)[channel] =
+        (static_cast<double>(maxs(channel)) - mins(channel)) / widest_range;
+    all_same &= (*channel_scales)[channel] == 1.0;
+  }
+  if (all_same) {
+    channel_scales->clear();
+  }
+  return Status::OK();
+}
+
+// Multiplies the 32-bit values of the innermost dimension of 'accumulators' by
+// 'channel_scales', rounding them to the nearest value.
+void RescaleQuantizedChannels(const std::vector<double>& channel_scales,
+                              Tensor* accumulators);
+
 void GetOutputMinAndMaxForQuantizedAdd(float input_min, float input_max,
                                        float smaller_input_min,
                                        float smaller_input_max,
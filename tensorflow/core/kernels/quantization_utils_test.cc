@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -498,6 +499,67 @@ TEST_F(QuantizationUtilsTest, FloatTensorToQuantized) {
   test::ExpectTensorEqual<quint8>(expected, output);
 }
 
+TEST_F(QuantizationUtilsTest, FloatTensorToQuantizedPerChannel) {
+  Tensor input(DT_FLOAT, TensorShape({3, 2}));
+  test::FillValues<float>(&input, {1.0f, 100.0f, 0.0f, 0.0f, -1.0f, -100.0f});
+  Tensor output;
+  Tensor mins;
+  Tensor maxs;
+  FloatTensorToQuantizedPerChannel<quint8>(input, 1, &output, &mins, &maxs);
+  Tensor expected(DT_QUINT8, TensorShape({3, 2}));
+  test::FillValues<quint8>(&expected, {255, 255, 128, 128, 1, 1});
+  test::ExpectTensorEqual<quint8>(expected, output);
+  test::ExpectTensorNear<float>(
+      test::AsTensor<float>({-128.0f / 127.0f, -12800.0f / 127.0f}), mins,
+      1e-5);
+  test::ExpectTensorNear<float>(test::AsTensor<float>({1.0f, 100.0f}), maxs,
+                                1e-5);
+}
+
+TEST_F(QuantizationUtilsTest, GetChannelQuantizationRanges) {
+  float min;
+  float max;
+  std::vector<double> channel_scales;
+  TF_EXPECT_OK(GetChannelQuantizationRanges<quint8>(
+      test::AsScalar<float>(-1.0f), test::AsScalar<float>(2.0f), 2, &min, &max,
+      &channel_scales));
+  EXPECT_EQ(-1.0f, min);
+  EXPECT_EQ(2.0f, max);
+  EXPECT_TRUE(channel_scales.empty());
+
+  TF_EXPECT_OK(GetChannelQuantizationRanges<quint8>(
+      test::AsTensor<float>({-1.28f, -128.0f}),
+      test::AsTensor<float>({1.27f, 127.0f}), 2, &min, &max,
+      &channel_scales));
+  EXPECT_EQ(-128.0f, min);
+  EXPECT_EQ(127.0f, max);
+  ASSERT_EQ(2, channel_scales.size());
+  EXPECT_NEAR(0.01, channel_scales[0], 1e-6);
+  EXPECT_EQ(1.0, channel_scales[1]);
+
+  // The channels quantize zero differently.
+  EXPECT_FALSE(GetChannelQuantizationRanges<quint8>(
+                   test::AsTensor<float>({0.0f, -1.0f}),
+                   test::AsTensor<float>({1.0f, 1.0f}), 2, &min, &max,
+                   &channel_scales)
+                   .ok());
+  // There are not as many ranges as channels.
+  EXPECT_FALSE(GetChannelQuantizationRanges<quint8>(
+                   test::AsTensor<float>({-1.0f, -1.0f}),
+                   test::AsTensor<float>({1.0f, 1.0f}), 3, &min, &max,
+                   &channel_scales)
+                   .ok());
+}
+
+TEST_F(QuantizationUtilsTest, RescaleQuantizedChannels) {
+  Tensor accumulators(DT_QINT32, TensorShape({2, 2}));
+  test::FillValues<qint32>(&accumulators, {100, 100, -30, 7});
+  RescaleQuantizedChannels({0.5, 1.0}, &accumulators);
+  Tensor expected(DT_QINT32, TensorShape({2, 2}));
+  test::FillValues<qint32>(&expected, {50, 100, -15, 7});
+  test::ExpectTensorEqual<qint32>(expected, accumulators);
+}
+
 // Verify that FloatToQuantizedInPlaceUsingEigen is same result as
 // FloatToQuantized.
 TEST_F(QuantizationUtilsTest, FloatToQuantizedInPlaceUsingEigen) {
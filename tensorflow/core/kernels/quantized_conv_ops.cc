@@ -16,6 +16,8 @@ limitations under the License.
 // Implements quantized eight-bit versions of the convolution operations.
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <vector>
 
 #define EIGEN_USE_THREADS
@@ -194,16 +196,26 @@ const size_t kMaxChunkSize = (1 * 1024 * 1024);
 // Implements convolution as a two stage process, first packing the patches of
 // the input image into columns (im2col) and then running GEMM to produce the
 // final result.
+// If an output stage is given, 'output_data' is ignored and the results of
+// each chunk of patches are written to a small scratch buffer instead, which
+// is passed to the output stage with the index of the first patch and the
+// number of patches of the chunk. This lets the accumulators be converted while
+// they're still in the cache, without ever holding all of them in memory.
 template <class T1, class T2, class T3>
 class Im2ColConvFunctor {
  public:
+  typedef std::function<void(int64 patch_start, int64 patch_count,
+                             const T3* chunk_output_data)>
+      OutputStage;
+
   void operator()(OpKernelContext* context, const T1* input_data,
                   int input_batches, int input_height, int input_width,
                   int input_depth, int input_offset, const T2* filter_data,
                   int filter_height, int filter_width, int filter_count,
                   int filter_offset, int stride, Padding padding,
                   T3* output_data, int output_height, int output_width,
-                  int output_shift, int output_offset, int output_mult) {
+                  int output_shift, int output_offset, int output_mult,
+                  const OutputStage& output_stage = nullptr) {
     if (input_offset < 0) {
       // Only log the first few occurrences of this warning.
       static int warning_count = 0;
@@ -218,12 +230,24 @@ class Im2ColConvFunctor {
             << " represented easily. You should try to construct graphs that"
             << " avoid this situation.";
       }
+      const int64 patch_count = input_batches * output_height * output_width;
+      Tensor full_output;
+      if (output_stage) {
+        OP_REQUIRES_OK(context, context->allocate_temp(
+                                    DataTypeToEnum<T3>::v(),
+                                    TensorShape({patch_count * filter_count}),
+                                    &full_output));
+        output_data = full_output.flat<T3>().data();
+      }
       ReferenceConvFunctor<T1, T2, T3> conv_functor;
       conv_functor(context, input_data, input_batches, input_height,
                    input_width, input_depth, input_offset, filter_data,
                    filter_height, filter_width, filter_count, filter_offset,
                    stride, padding, output_data, output_height, output_width,
                    output_shift, output_offset, output_mult);
+      if (output_stage) {
+        output_stage(0, patch_count, output_data);
+      }
       return;
     }
 
@@ -255,8 +279,22 @@ class Im2ColConvFunctor {
     // by the width, then the height. This is the standard memory order in the
     // image world if it helps to visualize it.
     const int filter_value_count = filter_width * filter_height * input_depth;
-    const int64 patches_per_chunk =
+    int64 patches_per_chunk =
         kMaxChunkSize / (filter_value_count * sizeof(T1));
+    // The results of a chunk are kept in a scratch buffer of the same limit
+    // for the output stage.
+    Tensor chunk_output;
+    if (output_stage) {
+      patches_per_chunk =
+          std::max<int64>(1, std::min<int64>(patches_per_chunk,
+                                             kMaxChunkSize /
+                                                 (filter_count * sizeof(T3))));
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(
+                         DataTypeToEnum<T3>::v(),
+                         TensorShape({patches_per_chunk * filter_count}),
+                         &chunk_output));
+    }
     const int64 chunk_value_count =
         (kMaxChunkSize + (sizeof(T1) - 1)) / sizeof(T1);
     // TODO(petewarden) - Memory allocation can be very slow on Android. Can we
@@ -376,7 +414,9 @@ class Im2ColConvFunctor {
       const int lda = filter_value_count;
       const int ldb = filter_count;
       const int ldc = filter_count;
-      T3* chunk_output_data = output_data + (patch_index_start * filter_count);
+      T3* chunk_output_data =
+          output_stage ? chunk_output.flat<T3>().data()
+                       : output_data + (patch_index_start * filter_count);
 
       if (meta::IsSupportedAndEnabled() && std::is_same<T1, quint8>() &&
           std::is_same<T2, quint8>() && std::is_same<T3, qint32>() &&
@@ -435,6 +475,9 @@ class Im2ColConvFunctor {
             input_offset, lda, filter_data, filter_offset, ldb,
             chunk_output_data, output_shift, output_offset, output_mult, ldc);
       }
+      if (output_stage) {
+        output_stage(patch_index_start, how_many_patches, chunk_output_data);
+      }
     }
   }
 };
@@ -479,15 +522,6 @@ class QuantizedConv2DOp : public OpKernel {
 
     const float min_input = context->input(2).flat<float>()(0);
     const float max_input = context->input(3).flat<float>()(0);
-    const float min_filter = context->input(4).flat<float>()(0);
-    const float max_filter = context->input(5).flat<float>()(0);
-    const int32 offset_input =
-        FloatToQuantizedUnclamped<T1>(0.0f, min_input, max_input);
-    const int32 offset_filter =
-        FloatToQuantizedUnclamped<T2>(0.0f, min_filter, max_filter);
-    const int32 offset_output = 0;
-    const int32 mult_output = 1;
-    const int32 shift_output = 0;
 
     // The last dimension for input is in_depth. It must be the same as the
     // filter's in_depth.
@@ -500,6 +534,23 @@ class QuantizedConv2DOp : public OpKernel {
     // The last dimension for filter is out_depth.
     const int64 out_depth = filter.dim_size(3);
 
+    // The filter can have a range per output channel, in which case the
+    // results of each channel are rescaled into the widest range.
+    float min_filter;
+    float max_filter;
+    std::vector<double> channel_scales;
+    OP_REQUIRES_OK(context, GetChannelQuantizationRanges<T2>(
+                                context->input(4), context->input(5),
+                                out_depth, &min_filter, &max_filter,
+                                &channel_scales));
+    const int32 offset_input =
+        FloatToQuantizedUnclamped<T1>(0.0f, min_input, max_input);
+    const int32 offset_filter =
+        FloatToQuantizedUnclamped<T2>(0.0f, min_filter, max_filter);
+    const int32 offset_output = 0;
+    const int32 mult_output = 1;
+    const int32 shift_output = 0;
+
     // The second dimension for input is rows/height.
     // The first dimension for filter is rows/height.
     const int64 input_rows = input.dim_size(1);
@@ -544,6 +595,9 @@ class QuantizedConv2DOp : public OpKernel {
                  filter_rows, filter_cols, out_depth, offset_filter, stride,
                  padding_, output->flat<T3>().data(), out_rows, out_cols,
                  shift_output, offset_output, mult_output);
+    if (!channel_scales.empty()) {
+      RescaleQuantizedChannels(channel_scales, output);
+    }
 
     float min_output_value;
     float max_output_value;
@@ -575,4 +629,181 @@ REGISTER_KERNEL_BUILDER(
         .TypeConstraint<qint32>("out_type"),
     QuantizedConv2DOp<quint8, quint8, qint32, Im2ColConvFunctor>);
 
+// Computes QuantizedConv2D followed by a BiasAdd, a Requantize into a frozen
+// range and optionally a Relu, without materializing the 32-bit results. Each
+// chunk of accumulators produced by the im2col GEMM is scaled into the output
+// range right away, using a multiplier and an offset per channel, the offset
+// also holding the bias.
+template <class T1, class T2, class T3>
+class QuantizedConv2DAndRequantizeOp : public OpKernel {
+ public:
+  explicit QuantizedConv2DAndRequantizeOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES(context, strides_.size() == 4,
+                errors::InvalidArgument("Sliding window strides field must "
+                                        "specify 4 dimensions"));
+    OP_REQUIRES(context, strides_[1] == strides_[2],
+                errors::InvalidArgument(
+                    "Current implementation only supports equal length "
+                    "strides in the row and column dimensions."));
+    OP_REQUIRES(
+        context, (strides_[0] == 1 && strides_[3] == 1),
+        errors::InvalidArgument("Current implementation does not yet support "
+                                "strides in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    OP_REQUIRES_OK(context, context->GetAttr("fuse_relu", &fuse_relu_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, input.dims() == 4,
+                errors::InvalidArgument("input must be 4-dimensional",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional: ",
+                                        filter.shape().DebugString()));
+    for (int i : {3, 4, 7, 8}) {
+      const TensorShape& shape = context->input(i).shape();
+      OP_REQUIRES(context, TensorShapeUtils::IsScalar(shape),
+                  errors::InvalidArgument("Input ", i, " must be a scalar: ",
+                                          shape.DebugString()));
+    }
+    const float min_input = context->input(3).flat<float>()(0);
+    const float max_input = context->input(4).flat<float>()(0);
+    const float min_output = context->input(7).flat<float>()(0);
+    const float max_output = context->input(8).flat<float>()(0);
+    OP_REQUIRES(context, min_output < max_output,
+                errors::InvalidArgument(
+                    "min_freezed_output must be less than max_freezed_output: ",
+                    min_output, " vs ", max_output));
+
+    const int64 in_depth = input.dim_size(3);
+    OP_REQUIRES(context, in_depth == filter.dim_size(2),
+                errors::InvalidArgument(
+                    "input and filter must have the same depth: ", in_depth,
+                    " vs ", filter.dim_size(2)));
+    const int64 out_depth = filter.dim_size(3);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(bias.shape()) &&
+                    bias.dim_size(0) == out_depth,
+                errors::InvalidArgument(
+                    "bias must have one value per output channel: ",
+                    bias.shape().DebugString(), " vs ", out_depth));
+    float min_filter;
+    float max_filter;
+    std::vector<double> channel_scales;
+    OP_REQUIRES_OK(context, GetChannelQuantizationRanges<T2>(
+                                context->input(5), context->input(6),
+                                out_depth, &min_filter, &max_filter,
+                                &channel_scales));
+    const int32 offset_input =
+        FloatToQuantizedUnclamped<T1>(0.0f, min_input, max_input);
+    const int32 offset_filter =
+        FloatToQuantizedUnclamped<T2>(0.0f, min_filter, max_filter);
+    const int64 input_rows = input.dim_size(1);
+    const int64 filter_rows = filter.dim_size(0);
+    const int64 input_cols = input.dim_size(2);
+    const int64 filter_cols = filter.dim_size(1);
+    const int64 batch = input.dim_size(0);
+    const int stride = strides_[1];
+
+    int64 out_rows = 0, out_cols = 0, pad_rows = 0, pad_cols = 0;
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_rows, filter_rows, stride,
+                                         padding_, &out_rows, &pad_rows));
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSize(input_cols, filter_cols, stride,
+                                         padding_, &out_cols, &pad_cols));
+    CHECK_GT(batch, 0);
+    CHECK_GT(out_rows, 0);
+    CHECK_GT(out_cols, 0);
+    CHECK_GT(out_depth, 0);
+    TensorShape out_shape({batch, out_rows, out_cols, out_depth});
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+
+    // An accumulator 'a' of a channel stands for the real value
+    // 'a * accumulator_scale * channel_scales[channel]', which is quantized
+    // into the output range as 'round(a * multipliers[channel] +
+    // offsets[channel])'.
+    auto quantization_step = [](double min, double max, double lowest,
+                                double highest) {
+      return (max - min) / (highest - lowest);
+    };
+    const double accumulator_scale =
+        quantization_step(min_input, max_input,
+                          Eigen::NumTraits<T1>::lowest(),
+                          Eigen::NumTraits<T1>::highest()) *
+        quantization_step(min_filter, max_filter,
+                          Eigen::NumTraits<T2>::lowest(),
+                          Eigen::NumTraits<T2>::highest());
+    const double output_scale =
+        quantization_step(min_output, max_output,
+                          Eigen::NumTraits<T3>::lowest(),
+                          Eigen::NumTraits<T3>::highest());
+    const double zero_point =
+        static_cast<double>(Eigen::NumTraits<T3>::lowest()) -
+        std::round(min_output / output_scale);
+    const auto bias_flat = bias.flat<float>();
+    std::vector<float> multipliers(out_depth);
+    std::vector<float> offsets(out_depth);
+    for (int64 channel = 0; channel < out_depth; ++channel) {
+      multipliers[channel] =
+          accumulator_scale / output_scale *
+          (channel_scales.empty() ? 1.0 : channel_scales[channel]);
+      offsets[channel] = bias_flat(channel) / output_scale + zero_point;
+    }
+    const float lowest = static_cast<float>(Eigen::NumTraits<T3>::lowest());
+    const float highest = static_cast<float>(Eigen::NumTraits<T3>::highest());
+    const float clamp_min = fuse_relu_ ? std::max<float>(lowest, zero_point)
+                                       : lowest;
+    T3* output_data = output->flat<T3>().data();
+    auto output_stage = [output_data, out_depth, &multipliers, &offsets,
+                         clamp_min, highest](int64 patch_start,
+                                             int64 patch_count,
+                                             const qint32* accumulators) {
+      T3* patch_output = output_data + patch_start * out_depth;
+      for (int64 patch = 0; patch < patch_count; ++patch) {
+        for (int64 channel = 0; channel < out_depth; ++channel) {
+          const float value =
+              std::round(accumulators->value * multipliers[channel] +
+                         offsets[channel]);
+          *patch_output = static_cast<T3>(static_cast<int32>(
+              std::min(highest, std::max(clamp_min, value))));
+          ++accumulators;
+          ++patch_output;
+        }
+      }
+    };
+
+    Im2ColConvFunctor<T1, T2, qint32> conv_functor;
+    conv_functor(context, input.flat<T1>().data(), batch, input_rows,
+                 input_cols, in_depth, offset_input, filter.flat<T2>().data(),
+                 filter_rows, filter_cols, out_depth, offset_filter, stride,
+                 padding_, nullptr, out_rows, out_cols, 0, 0, 1, output_stage);
+
+    Tensor* output_min = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, {}, &output_min));
+    output_min->flat<float>()(0) = min_output;
+    Tensor* output_max = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(2, {}, &output_max));
+    output_max->flat<float>()(0) = max_output;
+  }
+
+ private:
+  std::vector<int32> strides_;
+  Padding padding_;
+  bool fuse_relu_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_QuantizedConv2DAndRequantize")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("Tinput")
+                            .TypeConstraint<quint8>("Tfilter")
+                            .TypeConstraint<quint8>("out_type"),
+                        QuantizedConv2DAndRequantizeOp<quint8, quint8, quint8>);
+
 }  // namespace tensorflow
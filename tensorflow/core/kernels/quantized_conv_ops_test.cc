@@ -36,6 +36,66 @@ namespace tensorflow {
 
 class QuantizedConv2DTest : public OpsTestBase {
  protected:
+  // Runs _QuantizedConv2DAndRequantize on the 3x4 image and 3x3 filter of the
+  // Small test, with the outputs requantized into [-51, 306], and checks the
+  // results against 'expected_values'.
+  void RunConvAndRequantize(float image_min, float bias, bool fuse_relu,
+                            const std::vector<float>& expected_values) {
+    TF_ASSERT_OK(
+        NodeDefBuilder("quantized_conv_op", "_QuantizedConv2DAndRequantize")
+            .Input(FakeInput(DT_QUINT8))
+            .Input(FakeInput(DT_QUINT8))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("out_type", DataTypeToEnum<quint8>::v())
+            .Attr("strides", {1, 1, 1, 1})
+            .Attr("padding", "SAME")
+            .Attr("fuse_relu", fuse_relu)
+            .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const float image_max = 12.0f;
+    Tensor image_float(DT_FLOAT, {1, 3, 4, 1});
+    test::FillValues<float>(&image_float,
+                            {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+    Tensor image_quantized =
+        FloatTensorToQuantized<quint8>(image_float, image_min, image_max);
+    const float filter_min = 1.0f;
+    const float filter_max = 9.0f;
+    Tensor filter_float(DT_FLOAT, {3, 3, 1, 1});
+    test::FillValues<float>(&filter_float, {1, 4, 7, 2, 5, 8, 3, 6, 9});
+    Tensor filter_quantized =
+        FloatTensorToQuantized<quint8>(filter_float, filter_min, filter_max);
+    const float output_min = -51.0f;
+    const float output_max = 306.0f;
+
+    AddInputFromArray<quint8>(image_quantized.shape(),
+                              image_quantized.flat<quint8>());
+    AddInputFromArray<quint8>(filter_quantized.shape(),
+                              filter_quantized.flat<quint8>());
+    AddInputFromArray<float>(TensorShape({1}), {bias});
+    AddInputFromArray<float>(TensorShape({}), {image_min});
+    AddInputFromArray<float>(TensorShape({}), {image_max});
+    AddInputFromArray<float>(TensorShape({}), {filter_min});
+    AddInputFromArray<float>(TensorShape({}), {filter_max});
+    AddInputFromArray<float>(TensorShape({}), {output_min});
+    AddInputFromArray<float>(TensorShape({}), {output_max});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected_float(DT_FLOAT, TensorShape({1, 3, 4, 1}));
+    test::FillValues<float>(&expected_float, expected_values);
+    EXPECT_EQ(output_min, GetOutput(1)->flat<float>()(0));
+    EXPECT_EQ(output_max, GetOutput(2)->flat<float>()(0));
+    Tensor output_float =
+        QuantizedTensorToFloat<quint8>(*GetOutput(0), output_min, output_max);
+    // One output step is 1.4, on top of the error of the inputs.
+    test::ExpectTensorNear<float>(expected_float, output_float, 2.0);
+  }
 };
 
 TEST_F(QuantizedConv2DTest, Small) {
@@ -321,4 +381,18 @@ TEST_F(QuantizedConv2DTest, SmallWithNoZero) {
   test::ExpectTensorNear<float>(expected_float, output_float, 1.0);
 }
 
+TEST_F(QuantizedConv2DTest, SmallAndRequantize) {
+  // The convolution results of the Small test, less the bias of 100, with the
+  // negative values clamped to zero.
+  RunConvAndRequantize(0.0f, -100.0f, true,
+                       {5, 50, 83, 0, 135, 212, 257, 78, 87, 134, 161, 21});
+}
+
+TEST_F(QuantizedConv2DTest, SmallWithNoZeroAndRequantize) {
+  // Zero isn't representable in the image, so this uses the slow path of the
+  // convolution, and the negative values are kept without a Relu.
+  RunConvAndRequantize(1.0f, -100.0f, false,
+                       {5, 50, 83, -5, 135, 212, 257, 78, 87, 134, 161, 21});
+}
+
 }  // namespace tensorflow
@@ -77,8 +77,22 @@ class QuantizedMatMulOp : public OpKernel {
     const Tensor& b = context->input(1);
     const float min_a = context->input(2).flat<float>()(0);
     const float max_a = context->input(3).flat<float>()(0);
-    const float min_b = context->input(4).flat<float>()(0);
-    const float max_b = context->input(5).flat<float>()(0);
+
+    // Check that the dimensions of the two matrices are valid.
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("In[1] is not a matrix"));
+
+    // The matrix b can have a range per column of the output, in which case
+    // the results of each column are rescaled into the widest range.
+    float min_b;
+    float max_b;
+    std::vector<double> channel_scales;
+    OP_REQUIRES_OK(context, GetChannelQuantizationRanges<T2>(
+                                context->input(4), context->input(5),
+                                b.dim_size(transpose_b_ ? 0 : 1), &min_b,
+                                &max_b, &channel_scales));
 
     // Make sure that we have valid quantization ranges for the input buffers.
     // If the difference between the min and max is negative or zero, it makes
@@ -92,12 +106,6 @@ class QuantizedMatMulOp : public OpKernel {
     const int32 offset_c = 0;
     const int32 mult_c = 1;
     const int32 shift_c = 0;
-
-    // Check that the dimensions of the two matrices are valid.
-    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
-                errors::InvalidArgument("In[0] is not a matrix"));
-    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(b.shape()),
-                errors::InvalidArgument("In[1] is not a matrix"));
     Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
     dim_pair[0].first = transpose_a_ ? 0 : 1;
     dim_pair[0].second = transpose_b_ ? 1 : 0;
@@ -172,6 +180,9 @@ class QuantizedMatMulOp : public OpKernel {
           transpose_a_, transpose_b_, transpose_c, m, n, k, a_data, offset_a,
           lda, b_data, offset_b, ldb, c_data, shift_c, offset_c, mult_c, ldc);
     }
+    if (!channel_scales.empty()) {
+      RescaleQuantizedChannels(channel_scales, c);
+    }
 
     float min_c_value;
     float max_c_value;
@@ -18,6 +18,8 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -25,6 +27,13 @@ namespace tensorflow {
 
 namespace {
 
+auto* queue_wait_time_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/queue/wait_time_usecs",
+     "The time from an enqueue or dequeue request until it completes, by "
+     "queue.",
+     "queue", "action"},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+
 template <DataType DT>
 Status HandleSliceToElement(const Tensor& parent, Tensor* element,
                             int64 index) {
@@ -73,7 +82,9 @@ QueueBase::QueueBase(int32 capacity, const DataTypeVector& component_dtypes,
       component_dtypes_(component_dtypes),
       component_shapes_(component_shapes),
       name_(name),
-      closed_(false) {}
+      closed_(false),
+      enqueue_wait_time_(queue_wait_time_usecs->GetCell(name, "enqueue")),
+      dequeue_wait_time_(queue_wait_time_usecs->GetCell(name, "dequeue")) {}
 
 QueueBase::~QueueBase() {}
 
@@ -317,6 +328,8 @@ bool QueueBase::TryAttemptLocked(Action action,
           break;
         case kComplete:
           progress = true;
+          (action == kEnqueue ? enqueue_wait_time_ : dequeue_wait_time_)
+              ->Add(Env::Default()->NowMicros() - cur_attempt->start_micros);
           clean_up->emplace_back(std::move(cur_attempt->done_callback),
                                  cur_attempt->cancellation_token,
                                  cur_attempt->context->cancellation_manager());
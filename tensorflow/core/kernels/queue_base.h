@@ -25,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -62,6 +64,11 @@ class QueueBase : public QueueInterface {
   void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
              DoneCallback callback) override;
 
+  bool closed() override {
+    mutex_lock lock(mu_);
+    return closed_;
+  }
+
   // Other public methods -----------------------------------------------------
   const std::vector<TensorShape>& component_shapes() const {
     return component_shapes_;
@@ -69,11 +76,6 @@ class QueueBase : public QueueInterface {
 
   int32 capacity() const { return capacity_; }
 
-  bool closed() {
-    mutex_lock lock(mu_);
-    return closed_;
-  }
-
   // Copies the index^th slice (in the first dimension) of parent into element.
   static Status CopySliceToElement(const Tensor& parent, Tensor* element,
                                    int64 index);
@@ -159,6 +161,8 @@ class QueueBase : public QueueInterface {
     Tuple tuple;
     // tuples is used by some implementations allowing dynamic shapes.
     std::vector<Tuple> tuples;
+    // When the attempt was made, for the wait time metric.
+    int64 start_micros;
 
     Attempt(int32 elements_requested, DoneCallback done_callback,
             OpKernelContext* context, CancellationManager* cancellation_manager,
@@ -169,11 +173,16 @@ class QueueBase : public QueueInterface {
           cancellation_manager(cancellation_manager),
           cancellation_token(cancellation_token),
           run_callback(run_callback),
-          is_cancelled(false) {}
+          is_cancelled(false),
+          start_micros(Env::Default()->NowMicros()) {}
   };
   std::deque<Attempt> enqueue_attempts_ GUARDED_BY(mu_);
   std::deque<Attempt> dequeue_attempts_ GUARDED_BY(mu_);
 
+  // Cells of the wait time metric of this queue.
+  monitoring::SamplerCell* const enqueue_wait_time_;
+  monitoring::SamplerCell* const dequeue_wait_time_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(QueueBase);
 };
 
@@ -74,17 +74,22 @@ struct FillPhiloxRandomTask;
 template <class Distribution>
 struct FillPhiloxRandomTask<Distribution, false> {
   typedef typename Distribution::ResultElementType T;
+  // The number of Philox counters that are computed together.
+  static const int kPhiloxBatchSize = 8;
+
   static void Run(random::PhiloxRandom gen, T* data, int64 size,
                   int64 start_group, int64 limit_group, Distribution dist) {
     const int kGroupSize = Distribution::kResultElementCount;
 
+    // Each group takes one sample of the generator.
     gen.Skip(start_group);
+    random::PhiloxRandomBatch<kPhiloxBatchSize> batch_gen(&gen);
     int64 offset = start_group * kGroupSize;
 
     // First fill all the full-size groups
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
     for (int64 index = start_group; index < limit_group_full; ++index) {
-      auto samples = dist(&gen);
+      auto samples = dist(&batch_gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
     }
@@ -92,7 +97,7 @@ struct FillPhiloxRandomTask<Distribution, false> {
     // If there are any remaining elements that need to be filled, process them
     if (limit_group_full < limit_group) {
       int64 remaining_size = size - limit_group_full * kGroupSize;
-      auto samples = dist(&gen);
+      auto samples = dist(&batch_gen);
       std::copy(&samples[0], &samples[0] + remaining_size, data + offset);
     }
   }
@@ -393,9 +393,12 @@ void RandomShuffleQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                       const TensorShape shape =
                           ManyOutShape(i, attempt->elements_requested);
                       Tensor element;
+                      // The batch becomes output i of the op, allocated as
+                      // the output, e.g. in pinned memory for a GPU.
                       attempt->context->SetStatus(
-                          attempt->context->allocate_temp(component_dtypes_[i],
-                                                          shape, &element));
+                          attempt->context->allocate_temp(
+                              component_dtypes_[i], shape, &element,
+                              attempt->context->output_alloc_attr(i)));
                       if (!attempt->context->status().ok()) return kComplete;
                       attempt->tuple.emplace_back(element);
                     }
@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/io_ops.cc.
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/columnar/columnar_table.h"
+
+namespace tensorflow {
+
+class ReadColumnarChunkOp : public OpKernel {
+ public:
+  explicit ReadColumnarChunkOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("columns", &columns_));
+    OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+    OP_REQUIRES(context, columns_.size() == dtypes_.size(),
+                errors::InvalidArgument("Got ", columns_.size(),
+                                        " columns but ", dtypes_.size(),
+                                        " dtypes"));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& filename = context->input(0);
+    const Tensor& chunk = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(filename.shape()),
+                errors::InvalidArgument("filename must be a scalar, got ",
+                                        filename.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(chunk.shape()),
+                errors::InvalidArgument("chunk must be a scalar, got ",
+                                        chunk.shape().DebugString()));
+
+    std::shared_ptr<OpenTable> table;
+    OP_REQUIRES_OK(context, GetTable(context->env(),
+                                     filename.scalar<string>()(), &table));
+    std::vector<ColumnChunk> columns;
+    OP_REQUIRES_OK(context,
+                   table->reader->ReadChunk(chunk.scalar<int64>()(),
+                                            table->column_indices, &columns));
+    const int64 num_rows = table->reader->num_rows(chunk.scalar<int64>()());
+
+    OpOutputList values;
+    OP_REQUIRES_OK(context, context->output_list("values", &values));
+    Tensor* row_lengths = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       "row_lengths",
+                       TensorShape({static_cast<int64>(columns_.size()),
+                                    num_rows}),
+                       &row_lengths));
+    auto row_lengths_matrix = row_lengths->matrix<int64>();
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const ColumnSchema& schema =
+          table->reader->columns()[table->column_indices[i]];
+      if (schema.varlen) {
+        row_lengths_matrix.chip<0>(i) = columns[i].row_lengths.vec<int64>();
+      } else {
+        row_lengths_matrix.chip<0>(i).setConstant(
+            schema.row_shape.num_elements());
+      }
+      values.set(i, columns[i].values);
+    }
+  }
+
+ private:
+  // An opened table, and the indices of the columns to read in it.
+  struct OpenTable {
+    std::unique_ptr<ColumnarTableReader> reader;
+    std::vector<int> column_indices;
+  };
+
+  // Returns the table at `filename`, which is only opened again when it is
+  // not the one of the previous call.
+  Status GetTable(Env* env, const string& filename,
+                  std::shared_ptr<OpenTable>* table) {
+    {
+      mutex_lock l(mu_);
+      if (table_ != nullptr && filename == filename_) {
+        *table = table_;
+        return Status::OK();
+      }
+    }
+    std::shared_ptr<OpenTable> opened(new OpenTable);
+    opened->reader.reset(new ColumnarTableReader(env, filename));
+    TF_RETURN_IF_ERROR(opened->reader->status());
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const int index = opened->reader->ColumnIndex(columns_[i]);
+      if (index < 0) {
+        return errors::NotFound("Column ", columns_[i], " not found in ",
+                                filename);
+      }
+      const DataType dtype = opened->reader->columns()[index].dtype;
+      if (dtype != dtypes_[i]) {
+        return errors::InvalidArgument(
+            "Column ", columns_[i], " of ", filename, " has type ",
+            DataTypeString(dtype), ", expected ", DataTypeString(dtypes_[i]));
+      }
+      opened->column_indices.push_back(index);
+    }
+    mutex_lock l(mu_);
+    filename_ = filename;
+    table_ = opened;
+    *table = std::move(opened);
+    return Status::OK();
+  }
+
+  std::vector<string> columns_;
+  DataTypeVector dtypes_;
+
+  mutex mu_;
+  string filename_ GUARDED_BY(mu_);
+  std::shared_ptr<OpenTable> table_ GUARDED_BY(mu_);
+};
+
+REGISTER_KERNEL_BUILDER(Name("ReadColumnarChunk").Device(DEVICE_CPU),
+                        ReadColumnarChunkOp);
+
+}  // namespace tensorflow
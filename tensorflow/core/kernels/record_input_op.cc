@@ -36,6 +36,8 @@ class RecordInputOp : public OpKernel {
     GETATTR(int64, file_buffer_size);
     GETATTR(int64, file_parallelism);
     GETATTR(int64, batch_size);
+    GETATTR(string, spill_dir);
+    GETATTR(int64, num_spill_files);
 #undef GETATTR
 
     RecordYielder::Options yopts;
@@ -44,6 +46,8 @@ class RecordInputOp : public OpKernel {
     yopts.bufsize = file_buffer_size;
     yopts.file_shuffle_shift_ratio = file_shuffle_shift_ratio;
     yopts.parallelism = file_parallelism;
+    yopts.spill_dir = spill_dir;
+    yopts.num_spill_files = num_spill_files;
     yielder_ = std::unique_ptr<RecordYielder>(new RecordYielder(ctx, yopts));
 
     batch_size_ = batch_size;
@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/record_yielder.h"
 
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -71,6 +75,7 @@ Status RecordYielder::YieldOne(string* value) {
 struct RecordYielder::Shard {
   int index;                      // Shard index.
   std::vector<string> filenames;  // File names given to this shard.
+  std::vector<string> spill_filenames;  // Files spilled by this shard.
   Notification done;              // Notified when this shard is done.
   Status status;                  // Shard status.
 };
@@ -124,20 +129,21 @@ void RecordYielder::MainLoop() {
                   filenames.end());
     }
 
-    // Shards files and use one thread to go through each shard.
-    const int N = opts_.parallelism;
-    std::vector<Shard> shards(N);
-    for (int i = 0; i < N; ++i) {
-      Shard* shard = &shards[i];
-      shard->index = i;
-      for (std::vector<string>::size_type j = i; j < filenames.size(); j += N) {
-        shard->filenames.push_back(filenames[j]);
-      }
-      thread_->Schedule([this, shard]() { ShardLoop(shard); });
+    // Spills the records to files that are then read instead of the
+    // data files, in a random order.
+    std::vector<string> spill_filenames;
+    if (!opts_.spill_dir.empty()) {
+      s = RunShards(filenames, [this](Shard* shard) { SpillLoop(shard); },
+                    &spill_filenames);
+      filenames = spill_filenames;
+      std::shuffle(filenames.begin(), filenames.end(), shuffle_rnd);
+    }
+    if (s.ok()) {
+      s = RunShards(filenames, [this](Shard* shard) { ShardLoop(shard); },
+                    nullptr);
     }
-    for (int i = 0; i < N; ++i) {
-      shards[i].done.WaitForNotification();
-      s.Update(shards[i].status);
+    for (const string& filename : spill_filenames) {
+      Env::Default()->DeleteFile(filename).IgnoreError();
     }
     if (ShouldFinish(s)) break;
 
@@ -154,6 +160,33 @@ void RecordYielder::MainLoop() {
   main_loop_done_.Notify();
 }
 
+Status RecordYielder::RunShards(const std::vector<string>& filenames,
+                                const std::function<void(Shard*)>& loop,
+                                std::vector<string>* spill_filenames) {
+  // Shards files and use one thread to go through each shard.
+  const int N = opts_.parallelism;
+  std::vector<Shard> shards(N);
+  for (int i = 0; i < N; ++i) {
+    Shard* shard = &shards[i];
+    shard->index = i;
+    for (std::vector<string>::size_type j = i; j < filenames.size(); j += N) {
+      shard->filenames.push_back(filenames[j]);
+    }
+    thread_->Schedule([&loop, shard]() { loop(shard); });
+  }
+  Status s;
+  for (int i = 0; i < N; ++i) {
+    shards[i].done.WaitForNotification();
+    s.Update(shards[i].status);
+    if (spill_filenames != nullptr) {
+      spill_filenames->insert(spill_filenames->end(),
+                              shards[i].spill_filenames.begin(),
+                              shards[i].spill_filenames.end());
+    }
+  }
+  return s;
+}
+
 bool RecordYielder::Add(std::vector<string>* values) {
   mutex_lock l(mu_);
   while (!BufNotFull()) {
@@ -214,4 +247,68 @@ void RecordYielder::ShardLoop(Shard* shard) {
   shard->done.Notify();
 }
 
+void RecordYielder::SpillLoop(Shard* shard) {
+  // Records are written to their spill file kRecords at a time.
+  const int64 kRecords = 16;
+  const int N = opts_.parallelism;
+  const int num_files = std::max(1, (opts_.num_spill_files + N - 1) / N);
+  const string prefix = io::JoinPath(
+      opts_.spill_dir, strings::StrCat("record_yielder-", random::New64()));
+  std::vector<std::unique_ptr<WritableFile>> files;
+  std::vector<std::unique_ptr<io::RecordWriter>> writers;
+  Status s;
+  for (int k = 0; k < num_files; ++k) {
+    const string filename = strings::StrCat(prefix, "-", k);
+    std::unique_ptr<WritableFile> file;
+    s = Env::Default()->NewWritableFile(filename, &file);
+    if (!s.ok()) break;
+    shard->spill_filenames.push_back(filename);
+    writers.emplace_back(new io::RecordWriter(file.get()));
+    files.push_back(std::move(file));
+  }
+
+  // Each record goes to a spill file chosen according to the epoch #,
+  // random seed and shard.
+  const int64 epoch = epoch_;
+  std::mt19937_64 rnd(Hash64(reinterpret_cast<const char*>(&epoch),
+                             sizeof(epoch), opts_.seed + shard->index));
+  std::vector<std::vector<string>> values(writers.size());
+  for (const string& filename : shard->filenames) {
+    if (!s.ok() || ShouldFinish(Status::OK())) break;
+    std::unique_ptr<RandomAccessFile> file;
+    if (!Env::Default()->NewRandomAccessFile(filename, &file).ok()) {
+      s = errors::InvalidArgument("Can't open ", filename);
+      break;
+    }
+    io::RecordReader rdr(file.get());
+    uint64 offset = 0;
+    string record;
+    while (s.ok()) {
+      Status read_status = rdr.ReadRecord(&offset, &record);
+      if (errors::IsOutOfRange(read_status)) {
+        break;
+      } else if (!read_status.ok()) {
+        s = read_status;
+        break;
+      }
+      const int k = rnd() % writers.size();
+      values[k].emplace_back(std::move(record));
+      if (values[k].size() >= kRecords) {
+        s = writers[k]->WriteRecords(values[k]);
+        values[k].clear();
+      }
+    }
+  }
+  for (size_t k = 0; k < writers.size(); ++k) {
+    if (s.ok() && !values[k].empty()) {
+      s = writers[k]->WriteRecords(values[k]);
+    }
+    writers[k].reset();
+    Status close_status = files[k]->Close();
+    s.Update(close_status);
+  }
+  shard->status = s;
+  shard->done.Notify();
+}
+
 }  // namespace tensorflow
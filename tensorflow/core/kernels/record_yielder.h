@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_RECORD_YIELDER_H_
 
 #include <atomic>
+#include <functional>
 #include <random>
 #include <string>
 #include <vector>
@@ -40,6 +41,16 @@ namespace tensorflow {
 //   4) the peak memory usage is roughly avg record size *
 //      (opts.bufsize + opts.parellelism * 16).
 //
+// A randomization buffer much smaller than the data set yields records
+// that were read close to each other.  When opts.spill_dir is set, each
+// epoch first writes the records to opts.num_spill_files temporary files,
+// each record to a randomly chosen one, and then reads these files in a
+// random order through the randomization buffer.  Every spill file holds a
+// random sample of the whole data set, so the records are shuffled across
+// it without keeping it in memory, at the cost of writing and reading it
+// once more, sequentially, per epoch.  Records are only yielded once the
+// epoch has been spilled.
+//
 // Usage example:
 //   RecordYielder::Options opts;
 //   opts.file_pattern = "input-*";
@@ -78,6 +89,15 @@ class RecordYielder {
     // Uses these many concurrent tfrecord iterators to iterate through
     // tfrecords.
     int32 parallelism = 1;
+
+    // If not empty, the directory the records of each epoch are spilled to
+    // before being yielded.  The spill files are deleted at the end of the
+    // epoch.
+    string spill_dir;
+
+    // Number of spill files per epoch, split among the "parallelism"
+    // shards.
+    int32 num_spill_files = 64;
   };
 
   explicit RecordYielder(OpKernelConstruction* context,
@@ -148,6 +168,12 @@ class RecordYielder {
   void MainLoop();
   struct Shard;
   void ShardLoop(Shard* shard);
+  void SpillLoop(Shard* shard);
+  // Runs "loop" over opts_.parallelism shards of "filenames" and appends
+  // the files spilled by the shards to "spill_filenames".
+  Status RunShards(const std::vector<string>& filenames,
+                   const std::function<void(Shard*)>& loop,
+                   std::vector<string>* spill_filenames);
   bool ShouldFinish(const Status& s);
   bool Add(std::vector<string>* values);
 };
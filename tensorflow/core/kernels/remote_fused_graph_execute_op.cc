@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -56,6 +58,14 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
 
       // 2. Setup graph in remote processor
       remote_fused_graph_executor_->SetupGraph();
+
+      // Concurrent steps fill their inputs in different buffer sets while
+      // the graph runs on the inputs of another step.
+      mutex_lock l(buffer_mu_);
+      for (int i = remote_fused_graph_executor_->GetBufferCount() - 1; i >= 0;
+           --i) {
+        free_buffer_indices_.push_back(i);
+      }
     }
   }
 
@@ -79,19 +89,23 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
         << ", gt input count = " << execute_info_.graph_input_node_name_size()
         << ", type count = " << input_types_.size();
 
+    const int buffer_index =
+        remote_fused_graph_executor_ ? AcquireBuffer() : -1;
+
     // 3. Send first data type inputs into remote processor
     for (int i = 0; i < graph_input_count; ++i) {
       const Tensor& input_tensor = ctx->input(i);
       const string& input_node_name = execute_info_.graph_input_node_name(i);
       if (remote_fused_graph_executor_) {
-        remote_fused_graph_executor_->FillInputNode(input_node_name,
-                                                    input_tensor);
+        remote_fused_graph_executor_->FillInputNodeInBuffer(
+            buffer_index, input_node_name, input_tensor);
       }
     }
 
     // 4. Execute graph in remote processor
     if (remote_fused_graph_executor_) {
-      remote_fused_graph_executor_->ExecuteGraph();
+      mutex_lock l(execute_mu_);
+      remote_fused_graph_executor_->ExecuteGraphInBuffer(buffer_index);
     }
 
     // 5. Load outputs from remote processor
@@ -102,24 +116,50 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
       Tensor* output = nullptr;
       const string& output_node_name = execute_info_.graph_output_node_name(i);
       if (remote_fused_graph_executor_) {
-        remote_fused_graph_executor_->ReadOutputNode(
-            output_node_name,
+        remote_fused_graph_executor_->ReadOutputNodeInBuffer(
+            buffer_index, output_node_name,
             [i, &ctx, &output](const TensorShape& shape) -> Tensor* {
               TF_CHECK_OK(ctx->allocate_output(i, shape, &output));
               return output;
             });
       }
     }
+    if (remote_fused_graph_executor_) {
+      ReleaseBuffer(buffer_index);
+    }
   }
 
   bool IsExpensive() final { return true; }
 
  private:
+  // Waits for a buffer set of the executor which no step uses.
+  int AcquireBuffer() {
+    mutex_lock l(buffer_mu_);
+    while (free_buffer_indices_.empty()) {
+      buffer_cond_var_.wait(l);
+    }
+    const int buffer_index = free_buffer_indices_.back();
+    free_buffer_indices_.pop_back();
+    return buffer_index;
+  }
+
+  void ReleaseBuffer(int buffer_index) {
+    mutex_lock l(buffer_mu_);
+    free_buffer_indices_.push_back(buffer_index);
+    buffer_cond_var_.notify_one();
+  }
+
   RemoteFusedGraphExecuteInfo execute_info_;
   std::unique_ptr<IRemoteFusedGraphExecutor> remote_fused_graph_executor_;
   DataTypeVector input_types_;
   DataTypeVector output_types_;
 
+  mutex buffer_mu_;
+  condition_variable buffer_cond_var_;
+  std::vector<int> free_buffer_indices_ GUARDED_BY(buffer_mu_);
+  // The remote processor runs one execution at a time.
+  mutex execute_mu_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RemoteFusedGraphExecuteOp);
 };
 
@@ -160,8 +160,12 @@ static RemoteFusedGraphExecuteInfo BuildRemoteFusedGraphExecuteInfo(
 }
 
 // 1. Create TestRemoteFusedGraphExecutor to execute your fused graph
+// This executor has two buffer sets, so that the inputs of an execution can
+// be filled while the graph runs on the other one.
 class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
  public:
+  static constexpr int BUFFER_COUNT = 2;
+
   int GetVersion() final { return 1; }
   bool Init(const RemoteFusedGraphExecuteInfo& info) final {
     info_ = &info;
@@ -172,14 +176,38 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
   }
   bool Finalize() final { return true; }
   bool SetupGraph() final { return true; }
-  bool ExecuteGraph() final {
+  bool ExecuteGraph() final { return ExecuteGraphInBuffer(0); }
+
+  bool TeardownGraph() final { return true; }
+
+  bool FillInputNode(const string& node_name, const Tensor& tensor) final {
+    return FillInputNodeInBuffer(0, node_name, tensor);
+  }
+
+  bool ReadOutputNode(const string& node_name,
+                      TensorAllocatorFunc tensor_allocator) final {
+    return ReadOutputNodeInBuffer(0, node_name, tensor_allocator);
+  }
+
+  int GetBufferCount() final { return BUFFER_COUNT; }
+
+  bool FillInputNodeInBuffer(int buffer_index, const string& node_name,
+                             const Tensor& tensor) final {
+    CHECK(buffer_index >= 0 && buffer_index < BUFFER_COUNT);
+    input_tensor_cache_[buffer_index][node_name] = tensor;
+    return true;
+  }
+
+  bool ExecuteGraphInBuffer(int buffer_index) final {
     CHECK(info_ != nullptr);
+    CHECK(buffer_index >= 0 && buffer_index < BUFFER_COUNT);
     // TODO(satok): Add utilities to implement this function more easily.
     // CAVEAT: This test only handles add op. You can implement here as you
     // like.
     CHECK_EQ(1, info_->graph_input_node_name_size());
     const string& input_node_name = info_->graph_input_node_name(0);
-    const Tensor& input_tensor = input_tensor_cache_[input_node_name];
+    const Tensor& input_tensor =
+        input_tensor_cache_[buffer_index][input_node_name];
     const float input_val = *input_tensor.scalar<float>().data();
     // TODO(satok): Read NAME_B from node_a_plus_b
     const NodeDef& node_b = *node_def_map_.at(NAME_B);
@@ -191,22 +219,17 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
     const float b_val = *const_tensor.scalar<float>().data();
     Tensor output_a_plus_b(DT_FLOAT, {});
     output_a_plus_b.flat<float>().data()[0] = input_val + b_val;
-    output_tensor_buf_.emplace(info_->graph_output_node_name(0),
-                               output_a_plus_b);
+    output_tensor_buf_[buffer_index][info_->graph_output_node_name(0)] =
+        output_a_plus_b;
     return true;
   }
 
-  bool TeardownGraph() final { return true; }
-
-  bool FillInputNode(const string& node_name, const Tensor& tensor) final {
-    input_tensor_cache_[node_name] = tensor;
-    return true;
-  }
-
-  bool ReadOutputNode(const string& node_name,
-                      TensorAllocatorFunc tensor_allocator) final {
+  bool ReadOutputNodeInBuffer(int buffer_index, const string& node_name,
+                              TensorAllocatorFunc tensor_allocator) final {
+    CHECK(buffer_index >= 0 && buffer_index < BUFFER_COUNT);
     // TODO(satok): Specify tensor shape by using default_graph_tensor_shape.
-    const Tensor& buffered_output_tensor = output_tensor_buf_.at(node_name);
+    const Tensor& buffered_output_tensor =
+        output_tensor_buf_[buffer_index].at(node_name);
     const TensorShape& output_shape = buffered_output_tensor.shape();
     Tensor* output_tensor = tensor_allocator(output_shape);
     CHECK_EQ(buffered_output_tensor.dtype(), output_tensor->dtype());
@@ -216,9 +239,9 @@ class TestRemoteFusedGraphExecutor final : public IRemoteFusedGraphExecutor {
 
  private:
   const RemoteFusedGraphExecuteInfo* info_;
-  std::unordered_map<string, Tensor> input_tensor_cache_;
+  std::unordered_map<string, Tensor> input_tensor_cache_[BUFFER_COUNT];
   std::unordered_map<string, const NodeDef*> node_def_map_;
-  std::unordered_map<string, Tensor> output_tensor_buf_;
+  std::unordered_map<string, Tensor> output_tensor_buf_[BUFFER_COUNT];
 };
 
 // 2. Register a builder of your custom executor
@@ -314,4 +337,40 @@ TEST(RemoteFusedExecuteGraphOp, EndToEndTest) {
 // End-to-end test: End   //
 ////////////////////////////
 
+TEST(RemoteFusedExecuteGraphOp, ExecuteGraphBatch) {
+  const GraphDef original_graph =
+      RemoteFusedGraphExecuteOpTestUtils::BuildAddGraph(
+          NAME_A, NODE_A_VAL, NAME_B, NODE_B_VAL, NAME_A_PLUS_B);
+  const RemoteFusedGraphExecuteInfo execute_info =
+      BuildRemoteFusedGraphExecuteInfo(original_graph);
+  TestRemoteFusedGraphExecutor executor;
+  ASSERT_TRUE(executor.Init(execute_info));
+  ASSERT_TRUE(executor.SetupGraph());
+
+  // Run more executions than buffer sets so that the buffers are reused.
+  const int execution_count = 5;
+  std::vector<std::vector<Tensor>> inputs_batch;
+  for (int i = 0; i < execution_count; ++i) {
+    Tensor input_a(DT_FLOAT, {});
+    input_a.flat<float>().data()[0] = static_cast<float>(i);
+    inputs_batch.push_back({input_a});
+  }
+  std::vector<std::vector<Tensor>> outputs_batch;
+  TF_ASSERT_OK(RemoteFusedGraphExecuteUtils::ExecuteGraphBatch(
+      execute_info, &executor, inputs_batch, &outputs_batch));
+
+  ASSERT_EQ(execution_count, outputs_batch.size());
+  for (int i = 0; i < execution_count; ++i) {
+    ASSERT_EQ(1, outputs_batch[i].size());
+    EXPECT_NEAR(i + NODE_B_VAL, outputs_batch[i][0].flat<float>().data()[0],
+                FLOAT_VALUE_TOLERANCE);
+  }
+
+  // The inputs of each execution must match the graph inputs.
+  inputs_batch.push_back({});
+  EXPECT_FALSE(RemoteFusedGraphExecuteUtils::ExecuteGraphBatch(
+                   execute_info, &executor, inputs_batch, &outputs_batch)
+                   .ok());
+}
+
 }  // namespace tensorflow
@@ -22,6 +22,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -406,6 +409,132 @@ RemoteFusedGraphExecuteUtils::BuildRemoteGraphInputsAndOutputsFromProto(
   }
 }
 
+/* static */ Status RemoteFusedGraphExecuteUtils::ExecuteGraphBatch(
+    const RemoteFusedGraphExecuteInfo& info,
+    IRemoteFusedGraphExecutor* executor,
+    const std::vector<std::vector<Tensor>>& inputs_batch,
+    std::vector<std::vector<Tensor>>* outputs_batch) {
+  CHECK(executor != nullptr);
+  CHECK(outputs_batch != nullptr);
+  const int input_count = info.graph_input_node_name_size();
+  const int output_count = info.graph_output_node_name_size();
+  for (const std::vector<Tensor>& inputs : inputs_batch) {
+    if (inputs.size() != input_count) {
+      return errors::InvalidArgument("Expected ", input_count,
+                                     " inputs for each execution, got ",
+                                     inputs.size());
+    }
+  }
+  const int buffer_count = std::max(1, executor->GetBufferCount());
+  const int execution_count = inputs_batch.size();
+
+  // Execution i uses the buffer set i % buffer_count.
+  auto fill_inputs = [&](int i) {
+    for (int j = 0; j < input_count; ++j) {
+      if (!executor->FillInputNodeInBuffer(i % buffer_count,
+                                           info.graph_input_node_name(j),
+                                           inputs_batch[i][j])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  auto execute_and_read_outputs = [&](int i) -> Status {
+    const int buffer_index = i % buffer_count;
+    if (!executor->ExecuteGraphInBuffer(buffer_index)) {
+      return errors::Internal("Failed to execute the graph for execution ", i);
+    }
+    std::vector<Tensor> outputs(output_count);
+    for (int j = 0; j < output_count; ++j) {
+      const DataType dtype =
+          j < info.default_graph_output_tensor_shape_size()
+              ? info.default_graph_output_tensor_shape(j).dtype()
+              : DT_FLOAT;
+      if (!executor->ReadOutputNodeInBuffer(
+              buffer_index, info.graph_output_node_name(j),
+              [&outputs, j, dtype](const TensorShape& shape) {
+                outputs[j] = Tensor(dtype, shape);
+                return &outputs[j];
+              })) {
+        return errors::Internal("Failed to read the outputs of execution ",
+                                i);
+      }
+    }
+    outputs_batch->emplace_back(std::move(outputs));
+    return Status::OK();
+  };
+
+  if (buffer_count == 1) {
+    for (int i = 0; i < execution_count; ++i) {
+      if (!fill_inputs(i)) {
+        return errors::Internal("Failed to fill the inputs of execution ", i);
+      }
+      TF_RETURN_IF_ERROR(execute_and_read_outputs(i));
+    }
+    return Status::OK();
+  }
+
+  // The inputs are filled on another thread, at most buffer_count executions
+  // ahead of the ones whose outputs are read.
+  mutex mu;
+  condition_variable cond_var;
+  int filled_count = 0;
+  int read_count = 0;
+  bool fill_failed = false;
+  bool cancelled = false;
+  Status status;
+  {
+    std::unique_ptr<Thread> fill_thread(Env::Default()->StartThread(
+        ThreadOptions(), "remote_fused_graph_fill_inputs", [&]() {
+          for (int i = 0; i < execution_count; ++i) {
+            {
+              mutex_lock l(mu);
+              while (i - read_count >= buffer_count && !cancelled) {
+                cond_var.wait(l);
+              }
+              if (cancelled) {
+                return;
+              }
+            }
+            const bool success = fill_inputs(i);
+            mutex_lock l(mu);
+            if (success) {
+              filled_count = i + 1;
+            } else {
+              fill_failed = true;
+            }
+            cond_var.notify_all();
+            if (!success) {
+              return;
+            }
+          }
+        }));
+    for (int i = 0; i < execution_count && status.ok(); ++i) {
+      {
+        mutex_lock l(mu);
+        while (filled_count <= i && !fill_failed) {
+          cond_var.wait(l);
+        }
+        if (filled_count <= i) {
+          status =
+              errors::Internal("Failed to fill the inputs of execution ", i);
+          break;
+        }
+      }
+      status = execute_and_read_outputs(i);
+      mutex_lock l(mu);
+      if (status.ok()) {
+        read_count = i + 1;
+      } else {
+        cancelled = true;
+      }
+      cond_var.notify_all();
+    }
+    // Destroying the thread waits for it to finish.
+  }
+  return status;
+}
+
 /* static */ void RemoteFusedGraphExecuteUtils::EmplaceTensorShapeType(
     const string& name, const Tensor& tensor,
     TensorShapeMap* tensor_shape_map) {
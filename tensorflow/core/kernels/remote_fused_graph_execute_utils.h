@@ -124,6 +124,17 @@ class RemoteFusedGraphExecuteUtils {
       std::vector<std::pair<string, Tensor>>* inputs,
       std::vector<string>* outputs);
 
+  // Runs the graph of 'executor' once for each element of 'inputs_batch',
+  // which holds the tensors of the graph input nodes of 'info', and appends
+  // the tensors of the graph output nodes of each execution to
+  // 'outputs_batch'. When the executor has several buffer sets, the inputs of
+  // the next executions are filled on another thread while the graph runs.
+  static Status ExecuteGraphBatch(
+      const RemoteFusedGraphExecuteInfo& info,
+      IRemoteFusedGraphExecutor* executor,
+      const std::vector<std::vector<Tensor>>& inputs_batch,
+      std::vector<std::vector<Tensor>>* outputs_batch);
+
  private:
   static void EmplaceTensorShapeType(const string& name, const Tensor& tensor,
                                      TensorShapeMap* tensor_shape_map);
@@ -18,7 +18,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/resize_bilinear_op.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -28,42 +31,14 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-template <typename Device, typename T>
-class ResizeBilinearOp : public OpKernel {
- public:
-  explicit ResizeBilinearOp(OpKernelConstruction* context) : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
-  }
-
-  void Compute(OpKernelContext* context) override {
-    const Tensor& input = context->input(0);
-    ImageResizerState st(align_corners_);
-    st.ValidateAndCreateOutput(context, input);
-
-    if (!context->status().ok()) return;
-
-    // Return if the output is empty.
-    if (st.output->NumElements() == 0) return;
-
-    typename TTypes<T, 4>::ConstTensor image_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
-
-    functor::ResizeBilinear<Device, T>()(context->eigen_device<Device>(),
-                                         image_data, st.height_scale,
-                                         st.width_scale, output_data);
-  }
-
- private:
-  bool align_corners_;
-};
-
 namespace {
 // Compute the interpolation indices only once.
 struct CachedInterpolation {
@@ -88,6 +63,63 @@ inline void compute_interpolation_weights(const int64 out_size,
   }
 }
 
+// The interpolation weights of a resize, which only depend on the sizes of
+// the input and output images. The lower and upper indices of ys are offsets
+// of input rows and those of xs offsets of pixels within a row, so that the
+// inner loops do not multiply them by the row and pixel sizes.
+struct InterpolationTables {
+  int64 in_height;
+  int64 in_width;
+  int64 out_height;
+  int64 out_width;
+  int64 channels;
+  float height_scale;
+  float width_scale;
+  std::vector<CachedInterpolation> ys;
+  std::vector<CachedInterpolation> xs;
+
+  bool Matches(const int64 in_height, const int64 in_width,
+               const int64 out_height, const int64 out_width,
+               const int64 channels, const float height_scale,
+               const float width_scale) const {
+    return this->in_height == in_height && this->in_width == in_width &&
+           this->out_height == out_height && this->out_width == out_width &&
+           this->channels == channels && this->height_scale == height_scale &&
+           this->width_scale == width_scale;
+  }
+};
+
+std::shared_ptr<const InterpolationTables> compute_interpolation_tables(
+    const int64 in_height, const int64 in_width, const int64 out_height,
+    const int64 out_width, const int64 channels, const float height_scale,
+    const float width_scale) {
+  std::shared_ptr<InterpolationTables> tables =
+      std::make_shared<InterpolationTables>();
+  tables->in_height = in_height;
+  tables->in_width = in_width;
+  tables->out_height = out_height;
+  tables->out_width = out_width;
+  tables->channels = channels;
+  tables->height_scale = height_scale;
+  tables->width_scale = width_scale;
+  tables->ys.resize(out_height + 1);
+  tables->xs.resize(out_width + 1);
+  compute_interpolation_weights(out_height, in_height, height_scale,
+                                tables->ys.data());
+  compute_interpolation_weights(out_width, in_width, width_scale,
+                                tables->xs.data());
+  const int64 in_row_size = in_width * channels;
+  for (CachedInterpolation& y : tables->ys) {
+    y.lower *= in_row_size;
+    y.upper *= in_row_size;
+  }
+  for (CachedInterpolation& x : tables->xs) {
+    x.lower *= channels;
+    x.upper *= channels;
+  }
+  return tables;
+}
+
 /**
  * Computes the bilinear interpolation from the appropriate 4 float points
  * and the linear interpolation weights.
@@ -100,35 +132,30 @@ inline float compute_lerp(const float top_left, const float top_right,
   return top + (bottom - top) * y_lerp;
 }
 
+// Interpolates each output pixel directly from the four input pixels around
+// it.
 template <typename T>
-void resize_image(
-    typename TTypes<T, 4>::ConstTensor images, const int batch_size,
-    const int64 in_height, const int64 in_width, const int64 out_height,
-    const int64 out_width, const int channels,
-    const std::vector<CachedInterpolation>& xs,
-    const std::vector<CachedInterpolation>& ys,
-    typename TTypes<float, 4>::Tensor output) TF_ATTRIBUTE_NOINLINE;
-template <typename T>
-void resize_image(typename TTypes<T, 4>::ConstTensor images,
-                  const int batch_size, const int64 in_height,
-                  const int64 in_width, const int64 out_height,
-                  const int64 out_width, const int channels,
-                  const std::vector<CachedInterpolation>& xs_vec,
-                  const std::vector<CachedInterpolation>& ys,
-                  typename TTypes<float, 4>::Tensor output) {
-  const int64 in_row_size = in_width * channels;
-  const int64 in_batch_num_values = in_height * in_row_size;
-  const int64 out_row_size = out_width * channels;
+void resize_image_direct(typename TTypes<T, 4>::ConstTensor images,
+                         const InterpolationTables& tables,
+                         typename TTypes<float, 4>::Tensor output) {
+  const int batch_size = images.dimension(0);
+  const int channels = tables.channels;
+  const int64 in_batch_num_values =
+      tables.in_height * tables.in_width * channels;
+  const int64 out_row_size = tables.out_width * channels;
+  const int64 out_height = tables.out_height;
+  const int64 out_width = tables.out_width;
+  const CachedInterpolation* xs = tables.xs.data();
+  const CachedInterpolation* ys = tables.ys.data();
 
   const T* input_b_ptr = images.data();
-  const CachedInterpolation* xs = xs_vec.data();
 
   if (channels == 3) {
     float* output_y_ptr = output.data();
     for (int b = 0; b < batch_size; ++b) {
       for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
+        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower;
+        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper;
         const float ys_lerp = ys[y].lerp;
         for (int64 x = 0; x < out_width; ++x) {
           const int64 xs_lower = xs[x].lower;
@@ -172,8 +199,8 @@ void resize_image(typename TTypes<T, 4>::ConstTensor images,
     float* output_y_ptr = output.data();
     for (int b = 0; b < batch_size; ++b) {
       for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
+        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower;
+        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper;
         const float ys_lerp = ys[y].lerp;
         for (int64 x = 0; x < out_width; ++x) {
           auto xs_lower = xs[x].lower;
@@ -196,8 +223,177 @@ void resize_image(typename TTypes<T, 4>::ConstTensor images,
   }
 }
 
+// Interpolates the input row "row" horizontally at the output columns.
+// kChannels is the number of channels if it is known at compile time and 0
+// otherwise.
+template <typename T, int kChannels>
+inline void interpolate_row(const T* row, const CachedInterpolation* xs,
+                            const int64 out_width, const int num_channels,
+                            float* output) {
+  const int channels = kChannels > 0 ? kChannels : num_channels;
+  for (int64 x = 0; x < out_width; ++x) {
+    const T* left = row + xs[x].lower;
+    const T* right = row + xs[x].upper;
+    const float x_lerp = xs[x].lerp;
+    for (int c = 0; c < channels; ++c) {
+      const float left_value(left[c]);
+      const float right_value(right[c]);
+      output[c] = left_value + (right_value - left_value) * x_lerp;
+    }
+    output += channels;
+  }
+}
+
+// When the image is enlarged vertically consecutive output rows interpolate
+// between the same two input rows, so the input rows are interpolated
+// horizontally once into row buffers, and each output row is then a
+// vectorized interpolation between two buffers.
+template <typename T, int kChannels>
+void resize_image_by_rows(typename TTypes<T, 4>::ConstTensor images,
+                          const InterpolationTables& tables,
+                          typename TTypes<float, 4>::Tensor output) {
+  typedef Eigen::Map<Eigen::ArrayXf> Row;
+  const int batch_size = images.dimension(0);
+  const int channels = kChannels > 0 ? kChannels : tables.channels;
+  const int64 in_batch_num_values =
+      tables.in_height * tables.in_width * channels;
+  const int64 out_row_size = tables.out_width * channels;
+  const CachedInterpolation* xs = tables.xs.data();
+  const CachedInterpolation* ys = tables.ys.data();
+
+  std::vector<float> buffers(2 * out_row_size);
+  float* top = buffers.data();
+  float* bottom = top + out_row_size;
+  const T* input_b_ptr = images.data();
+  float* output_y_ptr = output.data();
+  for (int b = 0; b < batch_size; ++b) {
+    // The input rows held by the "top" and "bottom" buffers.
+    int64 top_row = -1;
+    int64 bottom_row = -1;
+    for (int64 y = 0; y < tables.out_height; ++y) {
+      if (ys[y].lower == bottom_row) {
+        std::swap(top, bottom);
+        std::swap(top_row, bottom_row);
+      }
+      if (ys[y].lower != top_row) {
+        top_row = ys[y].lower;
+        interpolate_row<T, kChannels>(input_b_ptr + top_row, xs,
+                                      tables.out_width, channels, top);
+      }
+      if (ys[y].upper != bottom_row) {
+        bottom_row = ys[y].upper;
+        interpolate_row<T, kChannels>(input_b_ptr + bottom_row, xs,
+                                      tables.out_width, channels, bottom);
+      }
+      Row top_values(top, out_row_size);
+      Row bottom_values(bottom, out_row_size);
+      Row(output_y_ptr, out_row_size) =
+          top_values + (bottom_values - top_values) * ys[y].lerp;
+      output_y_ptr += out_row_size;
+    }
+    input_b_ptr += in_batch_num_values;
+  }
+}
+
+// Resizes "images" into "output", which must have the sizes "tables" were
+// computed for. When enlarging images with 1, 3 or 4 channels, such as
+// grayscale, RGB and RGBA images, the rows are interpolated with the number
+// of channels known at compile time so that the loops over the channels are
+// unrolled.
+template <typename T>
+void resize_image(typename TTypes<T, 4>::ConstTensor images,
+                  const InterpolationTables& tables,
+                  typename TTypes<float, 4>::Tensor output)
+    TF_ATTRIBUTE_NOINLINE;
+template <typename T>
+void resize_image(typename TTypes<T, 4>::ConstTensor images,
+                  const InterpolationTables& tables,
+                  typename TTypes<float, 4>::Tensor output) {
+  if (tables.out_height <= tables.in_height) {
+    resize_image_direct<T>(images, tables, output);
+    return;
+  }
+  switch (tables.channels) {
+    case 1:
+      resize_image_by_rows<T, 1>(images, tables, output);
+      break;
+    case 3:
+      resize_image_by_rows<T, 3>(images, tables, output);
+      break;
+    case 4:
+      resize_image_by_rows<T, 4>(images, tables, output);
+      break;
+    default:
+      resize_image_by_rows<T, 0>(images, tables, output);
+      break;
+  }
+}
+
 }  // namespace
 
+template <typename Device, typename T>
+class ResizeBilinearOp : public OpKernel {
+ public:
+  explicit ResizeBilinearOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    ImageResizerState st(align_corners_);
+    st.ValidateAndCreateOutput(context, input);
+
+    if (!context->status().ok()) return;
+
+    // Return if the output is empty.
+    if (st.output->NumElements() == 0) return;
+
+    typename TTypes<T, 4>::ConstTensor image_data = input.tensor<T, 4>();
+    typename TTypes<float, 4>::Tensor output_data =
+        st.output->tensor<float, 4>();
+
+    Resize(context->eigen_device<Device>(), st, image_data, output_data);
+  }
+
+ private:
+  // On the CPU the interpolation tables are kept from one step to the next,
+  // as the images fed to a resize mostly have the same sizes on every step.
+  void Resize(const CPUDevice& d, const ImageResizerState& st,
+              typename TTypes<T, 4>::ConstTensor image_data,
+              typename TTypes<float, 4>::Tensor output_data) {
+    // Handle no-op resizes efficiently.
+    if (st.out_height == st.in_height && st.out_width == st.in_width) {
+      output_data = image_data.template cast<float>();
+      return;
+    }
+    std::shared_ptr<const InterpolationTables> tables;
+    {
+      mutex_lock l(mu_);
+      if (tables_ == nullptr ||
+          !tables_->Matches(st.in_height, st.in_width, st.out_height,
+                            st.out_width, st.channels, st.height_scale,
+                            st.width_scale)) {
+        tables_ = compute_interpolation_tables(
+            st.in_height, st.in_width, st.out_height, st.out_width,
+            st.channels, st.height_scale, st.width_scale);
+      }
+      tables = tables_;
+    }
+    resize_image<T>(image_data, *tables, output_data);
+  }
+
+  void Resize(const GPUDevice& d, const ImageResizerState& st,
+              typename TTypes<T, 4>::ConstTensor image_data,
+              typename TTypes<float, 4>::Tensor output_data) {
+    functor::ResizeBilinear<GPUDevice, T>()(d, image_data, st.height_scale,
+                                            st.width_scale, output_data);
+  }
+
+  bool align_corners_;
+  mutex mu_;
+  std::shared_ptr<const InterpolationTables> tables_ GUARDED_BY(mu_);
+};
+
 // Partial specialization of ResizeBilinear functor for a CPUDevice.
 namespace functor {
 template <typename T>
@@ -205,7 +401,6 @@ struct ResizeBilinear<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T, 4>::ConstTensor images,
                   const float height_scale, const float width_scale,
                   typename TTypes<float, 4>::Tensor output) {
-    const int batch_size = images.dimension(0);
     const int64 in_height = images.dimension(1);
     const int64 in_width = images.dimension(2);
     const int channels = images.dimension(3);
@@ -219,22 +414,12 @@ struct ResizeBilinear<CPUDevice, T> {
       return;
     }
 
-    std::vector<CachedInterpolation> ys(out_height + 1);
-    std::vector<CachedInterpolation> xs(out_width + 1);
-
-    // Compute the cached interpolation weights on the x and y dimensions.
-    compute_interpolation_weights(out_height, in_height, height_scale,
-                                  ys.data());
-    compute_interpolation_weights(out_width, in_width, width_scale, xs.data());
-
-    // Scale x interpolation weights to avoid a multiplication during iteration.
-    for (int i = 0; i < xs.size(); ++i) {
-      xs[i].lower *= channels;
-      xs[i].upper *= channels;
-    }
-
-    resize_image<T>(images, batch_size, in_height, in_width, out_height,
-                    out_width, channels, xs, ys, output);
+    resize_image<T>(images,
+                    *compute_interpolation_tables(in_height, in_width,
+                                                  out_height, out_width,
+                                                  channels, height_scale,
+                                                  width_scale),
+                    output);
   }
 };
 }  // namespace functor
@@ -165,6 +165,20 @@ TEST_F(ResizeBilinearOpTest, TestResizeRandomDataSeveralInputsSizes4Channels) {
   RunManyRandomTests(4);
 }
 
+TEST_F(ResizeBilinearOpTest, TestResizeRandomDataSeveralInputsSizes5Channels) {
+  for (int target_height : {2, 50, 113}) {
+    TestResize(2, 20, 30, 5, 40, target_height);
+  }
+}
+
+TEST_F(ResizeBilinearOpTest, TestResizeSameSizesDifferentChannels) {
+  // The kernel keeps the interpolation weights of the previous resize, which
+  // must not be reused for an input with another number of channels.
+  TestResize(2, 20, 30, 3, 40, 50);
+  TestResize(2, 20, 30, 4, 40, 50);
+  TestResize(2, 20, 30, 3, 40, 50);
+}
+
 TEST_F(ResizeBilinearOpTest, TestBilinear2x2To1x1) {
   // Input:
   //  1, 2
@@ -198,6 +198,7 @@ class AssignVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, ASSIGN> copy_functor;
     copy_functor(context->eigen_device<Device>(), variable->tensor()->flat<T>(),
                  value.flat<T>());
+    variable->MarkDirty();
   }
 
  private:
@@ -255,6 +256,7 @@ class AssignUpdateVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(),
                    variable->tensor()->flat<T>(), value.flat<T>());
+    variable->MarkDirty();
   }
 };
 
@@ -415,6 +417,7 @@ class ResourceScatterUpdateOp : public OpKernel {
       functor::ScatterFunctor<Device, T, Index, op> functor;
       const Index bad_i = functor(c, c->template eigen_device<Device>(),
                                   params_flat, updates_flat, indices_flat);
+      v->MarkDirtyRows(indices);
       OP_REQUIRES(c, bad_i < 0,
                   errors::InvalidArgument(
                       "indices", SliceDebugString(indices.shape(), bad_i),
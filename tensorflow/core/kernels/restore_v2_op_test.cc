@@ -31,7 +31,9 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -354,5 +356,51 @@ TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveSlicesV1) { RunTest("SaveSlices"); }
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV1) { RunTest("Save"); }
 
+// Restores tensors large enough to be split among several readers.
+TEST_F(RestoreV2OpTest, RestoreLargeTensorsInParallel) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_large");
+  const int kNumTensors = 4;
+  const int kNumElements = 3 << 20;  // 12MB of floats.
+  {
+    BundleWriter writer(Env::Default(), prefix);
+    for (int i = 0; i < kNumTensors; ++i) {
+      Tensor tensor = MakeInput<float>(
+          TensorShape({kNumElements}),
+          [i](int x) -> float { return static_cast<float>(x % 1000 + i); });
+      TF_ASSERT_OK(writer.Add(strings::StrCat("tensor_", i), tensor));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())  // prefix
+                   .Input(FakeInput())  // tensor_names
+                   .Input(FakeInput())  // shape_and_slices
+                   .Attr("dtypes", DataTypeVector(kNumTensors, DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<string>(TensorShape({}), {prefix});
+  AddInput<string>(TensorShape({kNumTensors}), [](int x) -> string {
+    return strings::StrCat("tensor_", x);
+  });
+  // The last tensor is restored as a slice.
+  AddInputFromArray<string>(
+      TensorShape({kNumTensors}),
+      {"", "", "", strings::StrCat(kNumElements, " 2,", kNumElements - 4)});
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int i = 0; i < kNumTensors - 1; ++i) {
+    const Tensor* output = GetOutput(i);
+    ASSERT_EQ(kNumElements, output->NumElements());
+    const auto flat = output->flat<float>();
+    for (int x = 0; x < kNumElements; x += 4099) {
+      ASSERT_EQ(static_cast<float>(x % 1000 + i), flat(x));
+    }
+  }
+  const Tensor* slice = GetOutput(kNumTensors - 1);
+  ASSERT_EQ(kNumElements - 4, slice->NumElements());
+  EXPECT_EQ(2 + kNumTensors - 1, slice->flat<float>()(0));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,34 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/row_locks.h"
+
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+
+namespace {
+// Enough stripes that updates of distinct rows on all cores rarely contend.
+constexpr int kNumRowMutexes = 4096;
+}  // namespace
+
+mutex* GetRowMutex(const void* base, int64 row) {
+  static mutex* mutexes = new mutex[kNumRowMutexes];
+  const uint64 hash = Hash64Combine(reinterpret_cast<uintptr_t>(base),
+                                    static_cast<uint64>(row));
+  return &mutexes[hash % kNumRowMutexes];
+}
+
+}  // namespace tensorflow
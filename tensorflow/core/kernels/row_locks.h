@@ -0,0 +1,82 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_ROW_LOCKS_H_
+#define TENSORFLOW_KERNELS_ROW_LOCKS_H_
+
+#include <atomic>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Returns the mutex that guards row `row` of the tensor buffer `base`.  The
+// mutexes are a fixed set of stripes shared by all buffers, so different rows
+// may map to the same mutex, but a row always maps to the same one.
+mutex* GetRowMutex(const void* base, int64 row);
+
+// Calls `update(i, index)` for each position i of `indices`, where index is
+// indices(i), the row of the buffer `base` that the update writes, split
+// across the CPU worker threads of `ctx` with Shard given the cost of one
+// update.  Each update holds the mutex of its row when the updates run in
+// parallel, so that updates of rows that are repeated in indices are
+// serialized, and also when `always_lock_rows`, so that the update of a row
+// is atomic with respect to any other update that holds the row mutex.
+//
+// Returns the first position whose index is not in [0, limit), or -1 if there
+// is none.  The updates of indices out of range are skipped, and some updates
+// after them may still be applied.
+template <typename Tindex, typename Update>
+Tindex ShardedRowUpdate(OpKernelContext* ctx,
+                        typename TTypes<Tindex>::ConstFlat indices,
+                        Tindex limit, const void* base, int64 cost_per_update,
+                        bool always_lock_rows, Update update) {
+  const int64 n = indices.size();
+  std::atomic<int64> bad_position(n);
+  auto work = [&](int64 begin, int64 end) {
+    // A shard of all updates runs alone.
+    const bool lock_rows = always_lock_rows || end - begin < n;
+    for (int64 i = begin; i < end; ++i) {
+      const Tindex index = internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(index, limit)) {
+        int64 bad = bad_position.load();
+        while (i < bad && !bad_position.compare_exchange_weak(bad, i)) {
+        }
+        return;
+      }
+      if (lock_rows) {
+        mutex_lock l(*GetRowMutex(base, index));
+        update(i, index);
+      } else {
+        update(i, index);
+      }
+    }
+  };
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, n,
+        cost_per_update, work);
+  const int64 bad = bad_position.load();
+  return bad < n ? static_cast<Tindex>(bad) : -1;
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_ROW_LOCKS_H_
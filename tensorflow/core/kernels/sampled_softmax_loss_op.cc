@@ -0,0 +1,408 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Added to the logit of a sampled class that is also a true class of the
+// example, like the weights of ComputeAccidentalHits.
+constexpr float kAccidentalHitLogit = -FLT_MAX;
+
+Status CheckIds(const Tensor& ids, int64 num_classes, const char* name) {
+  const auto ids_flat = ids.flat<int64>();
+  for (int64 i = 0; i < ids_flat.size(); ++i) {
+    if (!FastBoundsCheck(ids_flat(i), num_classes)) {
+      return errors::InvalidArgument(name, "[", i, "] = ", ids_flat(i),
+                                     " is not in [0, ", num_classes, ")");
+    }
+  }
+  return Status::OK();
+}
+
+template <typename T>
+T Dot(const T* a, const T* b, int64 size) {
+  T sum(0);
+  for (int64 i = 0; i < size; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// Sets the rows of gathered to the rows of params given by ids.
+template <typename T>
+void GatherRows(const DeviceBase::CpuWorkerThreads& workers,
+                typename TTypes<T>::ConstMatrix params,
+                typename TTypes<int64>::ConstVec ids,
+                typename TTypes<T>::Matrix gathered) {
+  const int64 dim = params.dimension(1);
+  Shard(workers.num_threads, workers.workers, ids.size(), dim,
+        [&params, &ids, &gathered, dim](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            std::copy_n(&params(ids(i), 0), dim, &gathered(i, 0));
+          }
+        });
+}
+
+// Returns the sampled rows of weights, as a new [num_sampled, dim] tensor.
+template <typename T>
+Status GatherSampledWeights(OpKernelContext* context, const Tensor& weights,
+                            const Tensor& sampled, Tensor* sampled_weights) {
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataTypeToEnum<T>::value,
+      TensorShape({sampled.NumElements(), weights.dim_size(1)}),
+      sampled_weights));
+  GatherRows<T>(*context->device()->tensorflow_cpu_worker_threads(),
+                weights.matrix<T>(), sampled.vec<int64>(),
+                sampled_weights->matrix<T>());
+  return Status::OK();
+}
+
+// The contraction of the last dimension of two matrices, a * b^T.
+const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> kContractDim1Dim1 =
+    {Eigen::IndexPair<Eigen::DenseIndex>(1, 1)};
+// a * b.
+const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> kContractDim1Dim0 =
+    {Eigen::IndexPair<Eigen::DenseIndex>(1, 0)};
+// a^T * b.
+const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> kContractDim0Dim0 =
+    {Eigen::IndexPair<Eigen::DenseIndex>(0, 0)};
+
+}  // namespace
+
+template <typename T>
+class SampledSoftmaxLossOp : public OpKernel {
+ public:
+  explicit SampledSoftmaxLossOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("remove_accidental_hits",
+                                             &remove_accidental_hits_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& weights = context->input(0);
+    const Tensor& biases = context->input(1);
+    const Tensor& inputs = context->input(2);
+    const Tensor& labels = context->input(3);
+    const Tensor& sampled = context->input(4);
+    const Tensor& true_expected_count = context->input(5);
+    const Tensor& sampled_expected_count = context->input(6);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(weights.shape()),
+                errors::InvalidArgument("weights must be 2-D, got shape ",
+                                        weights.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(inputs.shape()),
+                errors::InvalidArgument("inputs must be 2-D, got shape ",
+                                        inputs.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(labels.shape()),
+                errors::InvalidArgument("labels must be 2-D, got shape ",
+                                        labels.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(sampled.shape()),
+                errors::InvalidArgument(
+                    "sampled_candidates must be 1-D, got shape ",
+                    sampled.shape().DebugString()));
+    const int64 num_classes = weights.dim_size(0);
+    const int64 dim = weights.dim_size(1);
+    const int64 batch_size = inputs.dim_size(0);
+    const int64 num_true = labels.dim_size(1);
+    const int64 num_sampled = sampled.dim_size(0);
+    OP_REQUIRES(context, biases.shape() == TensorShape({num_classes}),
+                errors::InvalidArgument("biases must have shape [",
+                                        num_classes, "], got shape ",
+                                        biases.shape().DebugString()));
+    OP_REQUIRES(context, inputs.dim_size(1) == dim,
+                errors::InvalidArgument(
+                    "inputs and weights must have the same number of "
+                    "columns, got shapes ",
+                    inputs.shape().DebugString(), " and ",
+                    weights.shape().DebugString()));
+    OP_REQUIRES(context, labels.dim_size(0) == batch_size,
+                errors::InvalidArgument(
+                    "labels and inputs must have the same number of rows, "
+                    "got shapes ",
+                    labels.shape().DebugString(), " and ",
+                    inputs.shape().DebugString()));
+    OP_REQUIRES(context, true_expected_count.shape() == labels.shape(),
+                errors::InvalidArgument(
+                    "true_expected_count must have the shape of labels ",
+                    labels.shape().DebugString(), ", got shape ",
+                    true_expected_count.shape().DebugString()));
+    OP_REQUIRES(context, sampled_expected_count.shape() == sampled.shape(),
+                errors::InvalidArgument(
+                    "sampled_expected_count must have the shape of "
+                    "sampled_candidates ",
+                    sampled.shape().DebugString(), ", got shape ",
+                    sampled_expected_count.shape().DebugString()));
+    OP_REQUIRES_OK(context, CheckIds(labels, num_classes, "labels"));
+    OP_REQUIRES_OK(context,
+                   CheckIds(sampled, num_classes, "sampled_candidates"));
+
+    const int64 num_logits = num_true + num_sampled;
+    Tensor* loss_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch_size}), &loss_out));
+    Tensor* backprop_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                1, TensorShape({batch_size, num_logits}),
+                                &backprop_out));
+    if (batch_size == 0 || num_logits == 0) return;
+
+    // The sampled logits are a matrix product, computed before the per
+    // example pass, which adds everything else.
+    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    Tensor sampled_weights;
+    OP_REQUIRES_OK(context, GatherSampledWeights<T>(context, weights, sampled,
+                                                    &sampled_weights));
+    Tensor sampled_logits_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({batch_size, num_sampled}),
+                                &sampled_logits_tensor));
+    auto sampled_logits = sampled_logits_tensor.matrix<T>();
+    sampled_logits.device(d) = inputs.matrix<T>().contract(
+        sampled_weights.matrix<T>(), kContractDim1Dim1);
+
+    const auto weights_t = weights.matrix<T>();
+    const auto biases_t = biases.vec<T>();
+    const auto inputs_t = inputs.matrix<T>();
+    const auto labels_t = labels.matrix<int64>();
+    const auto sampled_t = sampled.vec<int64>();
+    const auto true_expected_t = true_expected_count.matrix<float>();
+    std::vector<T> sampled_offsets(num_sampled);
+    for (int64 s = 0; s < num_sampled; ++s) {
+      sampled_offsets[s] =
+          biases_t(sampled_t(s)) -
+          static_cast<T>(std::log(sampled_expected_count.vec<float>()(s)));
+    }
+    auto loss = loss_out->vec<T>();
+    auto backprop = backprop_out->matrix<T>();
+    const bool remove_accidental_hits = remove_accidental_hits_;
+    auto compute_examples = [&, remove_accidental_hits](int64 start,
+                                                        int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        T* logits = &backprop(b, 0);
+        T true_sum(0);
+        for (int64 t = 0; t < num_true; ++t) {
+          const int64 label = labels_t(b, t);
+          logits[t] = Dot(&inputs_t(b, 0), &weights_t(label, 0), dim) +
+                      biases_t(label) -
+                      static_cast<T>(std::log(true_expected_t(b, t)));
+          true_sum += logits[t];
+        }
+        for (int64 s = 0; s < num_sampled; ++s) {
+          T logit = sampled_logits(b, s) + sampled_offsets[s];
+          if (remove_accidental_hits) {
+            for (int64 t = 0; t < num_true; ++t) {
+              if (sampled_t(s) == labels_t(b, t)) {
+                logit += static_cast<T>(kAccidentalHitLogit);
+                break;
+              }
+            }
+          }
+          logits[num_true + s] = logit;
+        }
+
+        const T max_logit = *std::max_element(logits, logits + num_logits);
+        T sum_exp(0);
+        for (int64 j = 0; j < num_logits; ++j) {
+          logits[j] = std::exp(logits[j] - max_logit);
+          sum_exp += logits[j];
+        }
+        // The labels are 1 / num_true for the true classes, 0 otherwise.
+        const T label = num_true > 0 ? T(1) / num_true : T(0);
+        loss(b) = std::log(sum_exp) + max_logit - true_sum * label;
+        for (int64 j = 0; j < num_logits; ++j) {
+          logits[j] = logits[j] / sum_exp - (j < num_true ? label : T(0));
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    Shard(workers.num_threads, workers.workers, batch_size,
+          num_true * dim * 2 + num_logits * 20, compute_examples);
+  }
+
+ private:
+  bool remove_accidental_hits_;
+};
+
+template <typename T>
+class SampledSoftmaxLossGradOp : public OpKernel {
+ public:
+  explicit SampledSoftmaxLossGradOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad_loss = context->input(0);
+    const Tensor& backprop = context->input(1);
+    const Tensor& weights = context->input(2);
+    const Tensor& inputs = context->input(3);
+    const Tensor& labels = context->input(4);
+    const Tensor& sampled = context->input(5);
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(weights.shape()),
+                errors::InvalidArgument("weights must be 2-D, got shape ",
+                                        weights.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(inputs.shape()),
+                errors::InvalidArgument("inputs must be 2-D, got shape ",
+                                        inputs.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsMatrix(labels.shape()),
+                errors::InvalidArgument("labels must be 2-D, got shape ",
+                                        labels.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(sampled.shape()),
+                errors::InvalidArgument(
+                    "sampled_candidates must be 1-D, got shape ",
+                    sampled.shape().DebugString()));
+    const int64 num_classes = weights.dim_size(0);
+    const int64 dim = weights.dim_size(1);
+    const int64 batch_size = inputs.dim_size(0);
+    const int64 num_true = labels.dim_size(1);
+    const int64 num_sampled = sampled.dim_size(0);
+    const int64 num_logits = num_true + num_sampled;
+    OP_REQUIRES(context,
+                inputs.dim_size(1) == dim && labels.dim_size(0) == batch_size,
+                errors::InvalidArgument(
+                    "Incompatible shapes of weights ",
+                    weights.shape().DebugString(), ", inputs ",
+                    inputs.shape().DebugString(), " and labels ",
+                    labels.shape().DebugString()));
+    OP_REQUIRES(context, grad_loss.shape() == TensorShape({batch_size}),
+                errors::InvalidArgument("grad_loss must have shape [",
+                                        batch_size, "], got shape ",
+                                        grad_loss.shape().DebugString()));
+    OP_REQUIRES(
+        context, backprop.shape() == TensorShape({batch_size, num_logits}),
+        errors::InvalidArgument("backprop must have shape [", batch_size,
+                                ", ", num_logits, "], got shape ",
+                                backprop.shape().DebugString()));
+    OP_REQUIRES_OK(context, CheckIds(labels, num_classes, "labels"));
+    OP_REQUIRES_OK(context,
+                   CheckIds(sampled, num_classes, "sampled_candidates"));
+
+    const int64 num_true_rows = batch_size * num_true;
+    Tensor* inputs_grad_out = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, inputs.shape(),
+                                                     &inputs_grad_out));
+    Tensor* weights_grad_out = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       1, TensorShape({num_true_rows + num_sampled, dim}),
+                       &weights_grad_out));
+    Tensor* biases_grad_out = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            2, TensorShape({num_true_rows + num_sampled}), &biases_grad_out));
+
+    // The gradients with respect to the sampled logits.
+    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    Tensor sampled_grad_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DataTypeToEnum<T>::value,
+                                TensorShape({batch_size, num_sampled}),
+                                &sampled_grad_tensor));
+    auto sampled_grad = sampled_grad_tensor.matrix<T>();
+    const auto grad_loss_t = grad_loss.vec<T>();
+    const auto backprop_t = backprop.matrix<T>();
+    for (int64 b = 0; b < batch_size; ++b) {
+      for (int64 s = 0; s < num_sampled; ++s) {
+        sampled_grad(b, s) = grad_loss_t(b) * backprop_t(b, num_true + s);
+      }
+    }
+    Tensor sampled_weights;
+    OP_REQUIRES_OK(context, GatherSampledWeights<T>(context, weights, sampled,
+                                                    &sampled_weights));
+
+    // The sampled rows contribute a matrix product to the gradients with
+    // respect to inputs and the rows of weights.
+    const auto inputs_t = inputs.matrix<T>();
+    auto inputs_grad = inputs_grad_out->matrix<T>();
+    auto weights_grad = weights_grad_out->matrix<T>();
+    auto biases_grad = biases_grad_out->vec<T>();
+    if (num_sampled > 0) {
+      inputs_grad.device(d) = sampled_grad.contract(sampled_weights.matrix<T>(),
+                                                    kContractDim1Dim0);
+      Eigen::DSizes<Eigen::DenseIndex, 2> offsets(num_true_rows, 0);
+      Eigen::DSizes<Eigen::DenseIndex, 2> extents(num_sampled, dim);
+      weights_grad.slice(offsets, extents).device(d) =
+          sampled_grad.contract(inputs_t, kContractDim0Dim0);
+    } else {
+      inputs_grad.setZero();
+    }
+    for (int64 s = 0; s < num_sampled; ++s) {
+      T sum(0);
+      for (int64 b = 0; b < batch_size; ++b) {
+        sum += sampled_grad(b, s);
+      }
+      biases_grad(num_true_rows + s) = sum;
+    }
+
+    // The true rows are added per example.
+    const auto weights_t = weights.matrix<T>();
+    const auto labels_t = labels.matrix<int64>();
+    auto add_true_rows = [&](int64 start, int64 limit) {
+      for (int64 b = start; b < limit; ++b) {
+        T* input_grad = &inputs_grad(b, 0);
+        const T* input = &inputs_t(b, 0);
+        for (int64 t = 0; t < num_true; ++t) {
+          const T g = grad_loss_t(b) * backprop_t(b, t);
+          const T* w = &weights_t(labels_t(b, t), 0);
+          T* w_grad = &weights_grad(b * num_true + t, 0);
+          for (int64 i = 0; i < dim; ++i) {
+            input_grad[i] += g * w[i];
+            w_grad[i] = g * input[i];
+          }
+          biases_grad(b * num_true + t) = g;
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    Shard(workers.num_threads, workers.workers, batch_size,
+          num_true * dim * 4, add_true_rows);
+  }
+};
+
+#define REGISTER_CPU(T)                                                     \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("SampledSoftmaxLoss").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      SampledSoftmaxLossOp<T>);                                             \
+  REGISTER_KERNEL_BUILDER(Name("SampledSoftmaxLossGrad")                    \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("T"),                      \
+                          SampledSoftmaxLossGradOp<T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
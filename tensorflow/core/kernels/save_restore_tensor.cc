@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <numeric>
 #include <unordered_map>
 
 #include <vector>
@@ -22,6 +24,8 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -166,15 +170,12 @@ void RestoreTensor(OpKernelContext* context,
   }
 
   // If we cannot find a cached reader we will allocate our own.
-  std::unique_ptr<checkpoint::TensorSliceReader> allocated_reader;
-
-  const checkpoint::TensorSliceReader* reader =
+  std::shared_ptr<const checkpoint::TensorSliceReader> reader =
       context->slice_reader_cache()->GetReader(file_pattern, open_func,
                                                preferred_shard);
   if (!reader) {
-    allocated_reader.reset(new checkpoint::TensorSliceReader(
-        file_pattern, open_func, preferred_shard));
-    reader = allocated_reader.get();
+    reader.reset(new checkpoint::TensorSliceReader(file_pattern, open_func,
+                                                   preferred_shard));
   }
   OP_REQUIRES_OK(context, CHECK_NOTNULL(reader)->status());
 
@@ -215,9 +216,14 @@ void RestoreTensor(OpKernelContext* context,
 
   if (output_shape.num_elements() == 0) return;
 
-#define READER_COPY(T)                                                      \
-  case DataTypeToEnum<T>::value:                                            \
-    reader->CopySliceData(tensor_name, slice_to_load, t->flat<T>().data()); \
+  // A slice restored from a checkpoint saved with a different partitioning
+  // spans several stored slices, which are read concurrently.
+  thread::ThreadPool* workers =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+#define READER_COPY(T)                                                     \
+  case DataTypeToEnum<T>::value:                                           \
+    reader->CopySliceData(tensor_name, slice_to_load, t->flat<T>().data(), \
+                          workers);                                        \
     break;
 
   switch (type) {
@@ -230,6 +236,36 @@ void RestoreTensor(OpKernelContext* context,
 #undef READER_COPY
 }
 
+namespace {
+
+// Restores the tensors 'indices' of 'tensor_names' into 'restored_tensors',
+// reading their slices of 'slices' if their 'shape_and_slices' aren't empty.
+Status RestoreTensorsFromReader(BundleReader* reader,
+                                const std::vector<int64>& indices,
+                                const Tensor& tensor_names,
+                                const Tensor& shape_and_slices,
+                                const std::vector<TensorSlice>& slices,
+                                const std::vector<Tensor*>& restored_tensors) {
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+  for (int64 i : indices) {
+    const string& tensor_name = tensor_names_flat(i);
+    if (shape_and_slices_flat(i).empty()) {
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensors[i]));
+    } else {
+      TF_RETURN_IF_ERROR(
+          reader->LookupSlice(tensor_name, slices[i], restored_tensors[i]));
+    }
+  }
+  return Status::OK();
+}
+
+// The minimum number of bytes restored by each reader. Below this, opening
+// another reader costs more than the concurrent reads save.
+constexpr int64 kMinBytesPerReader = 16 << 20;
+
+}  // namespace
+
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
@@ -237,16 +273,19 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   const string& prefix_string = prefix.scalar<string>()();
   const auto& tensor_names_flat = tensor_names.flat<string>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+  const int64 num_tensors = tensor_names_flat.size();
 
   BundleReader reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(reader.status());
 
+  // Allocates all the outputs first, since the context must not be used
+  // concurrently.
   // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
+  std::vector<Tensor*> restored_tensors(num_tensors, nullptr);
+  std::vector<TensorSlice> slices(num_tensors);
+  int64 total_bytes = 0;
   TensorShape restored_full_shape;
-  Tensor* restored_tensor = nullptr;
-  for (size_t i = 0; i < tensor_names_flat.size(); ++i) {
+  for (int64 i = 0; i < num_tensors; ++i) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
     TF_RETURN_IF_ERROR(
@@ -254,18 +293,16 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
     if (shape_and_slice.empty()) {
       // Lookup the full tensor.
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
+      TF_RETURN_IF_ERROR(context->allocate_output(i, restored_full_shape,
+                                                  &restored_tensors[i]));
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
-      TensorSlice parsed_slice;
       TensorShape parsed_slice_shape;
 
       TF_RETURN_IF_ERROR(
           checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
-                                         &parsed_slice, &parsed_slice_shape));
+                                         &slices[i], &parsed_slice_shape));
       if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
         return errors::InvalidArgument(
             "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
@@ -274,17 +311,78 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
             restored_full_shape.DebugString());
       }
 
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
+      TF_RETURN_IF_ERROR(context->allocate_output(i, parsed_slice_shape,
+                                                  &restored_tensors[i]));
     }
-    if (dtypes[i] != restored_tensor->dtype()) {
+    if (dtypes[i] != restored_tensors[i]->dtype()) {
       return errors::InvalidArgument(
           "tensor_name = ", tensor_name, "; expected dtype ",
           DataTypeString(dtypes[i]), " does not equal restored dtype ",
-          DataTypeString(restored_tensor->dtype()));
+          DataTypeString(restored_tensors[i]->dtype()));
+    }
+    total_bytes += restored_tensors[i]->TotalBytes();
+  }
+
+  // Reading many large tensors one at a time leaves the file system mostly
+  // idle, so the tensors are split into groups of similar sizes, each
+  // restored by its own reader on a worker thread.
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      context->device()->tensorflow_cpu_worker_threads();
+  const int64 num_readers = std::min<int64>(
+      {static_cast<int64>(worker_threads->num_threads), num_tensors,
+       total_bytes / kMinBytesPerReader});
+  if (num_readers <= 1) {
+    std::vector<int64> indices(num_tensors);
+    std::iota(indices.begin(), indices.end(), 0);
+    return RestoreTensorsFromReader(&reader, indices, tensor_names,
+                                    shape_and_slices, slices,
+                                    restored_tensors);
+  }
+
+  // Assigns the largest tensors first, each to the group with the fewest
+  // bytes so far.
+  std::vector<int64> sorted_indices(num_tensors);
+  std::iota(sorted_indices.begin(), sorted_indices.end(), 0);
+  std::sort(sorted_indices.begin(), sorted_indices.end(),
+            [&restored_tensors](int64 a, int64 b) {
+              return restored_tensors[a]->TotalBytes() >
+                     restored_tensors[b]->TotalBytes();
+            });
+  std::vector<std::vector<int64>> groups(num_readers);
+  std::vector<int64> group_bytes(num_readers, 0);
+  for (int64 i : sorted_indices) {
+    const int64 group =
+        std::min_element(group_bytes.begin(), group_bytes.end()) -
+        group_bytes.begin();
+    groups[group].push_back(i);
+    group_bytes[group] += restored_tensors[i]->TotalBytes();
+  }
+
+  std::vector<Status> statuses(num_readers);
+  BlockingCounter counter(num_readers - 1);
+  auto restore_group = [&](int64 group) {
+    // A BundleReader can't be used concurrently, so each group has its own.
+    BundleReader group_reader(Env::Default(), prefix_string);
+    statuses[group] = group_reader.status();
+    if (statuses[group].ok()) {
+      statuses[group] = RestoreTensorsFromReader(
+          &group_reader, groups[group], tensor_names, shape_and_slices, slices,
+          restored_tensors);
     }
+  };
+  for (int64 group = 1; group < num_readers; ++group) {
+    worker_threads->workers->Schedule([&restore_group, &counter, group]() {
+      restore_group(group);
+      counter.DecrementCount();
+    });
+  }
+  // The first group reuses the reader of this thread.
+  statuses[0] =
+      RestoreTensorsFromReader(&reader, groups[0], tensor_names,
+                               shape_and_slices, slices, restored_tensors);
+  counter.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
   }
   return Status::OK();
 }
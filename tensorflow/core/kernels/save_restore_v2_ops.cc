@@ -15,23 +15,39 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -85,12 +101,220 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// The environment variable which, when true, makes the SaveV2 and
+// MergeV2Checkpoints ops write their checkpoints in the background.
+constexpr char kAsyncSaveEnvVar[] = "TF_ASYNC_CHECKPOINT_SAVE";
+
+// The minimum number of bytes written by each writer. Below this, another
+// data file costs more than the concurrent writes save.
+constexpr int64 kMinBytesPerWriter = 16 << 20;
+
+// Tracks the checkpoints being written in the background, so that the ops
+// reading, merging or overwriting one first wait for it to be complete.
+class PendingCheckpoints {
+ public:
+  static PendingCheckpoints* Global() {
+    static PendingCheckpoints* pending = [] {
+      // A process exiting right after a save must not truncate the files.
+      std::atexit([] { Global()->WaitForAll(); });
+      return new PendingCheckpoints;
+    }();
+    return pending;
+  }
+
+  // Registers a background write of 'prefix', after the previous one ends.
+  void Start(const string& prefix) {
+    mutex_lock l(mu_);
+    while (pending_.count(prefix) > 0) {
+      cv_.wait(l);
+    }
+    pending_.insert(prefix);
+    statuses_.erase(prefix);
+  }
+
+  // Records the end of the background write of 'prefix'.
+  void Finish(const string& prefix, const Status& status) {
+    if (!status.ok()) {
+      LOG(ERROR) << "Writing checkpoint " << prefix
+                 << " in the background failed: " << status;
+    }
+    mutex_lock l(mu_);
+    pending_.erase(prefix);
+    if (!status.ok()) {
+      statuses_[prefix] = status;
+    }
+    cv_.notify_all();
+  }
+
+  // Waits for the background write of 'prefix', if any. Returns its error the
+  // first time it is waited for after failing, and OK otherwise.
+  Status Wait(const string& prefix) {
+    mutex_lock l(mu_);
+    while (pending_.count(prefix) > 0) {
+      cv_.wait(l);
+    }
+    auto it = statuses_.find(prefix);
+    if (it == statuses_.end()) {
+      return Status::OK();
+    }
+    const Status status = it->second;
+    statuses_.erase(it);
+    return status;
+  }
+
+  void WaitForAll() {
+    mutex_lock l(mu_);
+    while (!pending_.empty()) {
+      cv_.wait(l);
+    }
+  }
+
+ private:
+  mutex mu_;
+  condition_variable cv_;
+  std::unordered_set<string> pending_ GUARDED_BY(mu_);
+  // The errors of the failed writes not waited for yet.
+  std::unordered_map<string, Status> statuses_ GUARDED_BY(mu_);
+};
+
+// A tensor to save, with the slice of the full tensor it holds if any.
+struct TensorToSave {
+  string name;
+  bool is_slice = false;
+  TensorShape full_shape;
+  TensorSlice slice;
+  Tensor tensor;
+};
+
+// Sets 'to_save' to be the slice given by 'shape_spec', a non-empty
+// shape_and_slices element, of a full tensor.
+Status ParseSliceToSave(const string& shape_spec, TensorToSave* to_save) {
+  TensorShape slice_shape;
+  to_save->is_slice = true;
+  to_save->slice = TensorSlice(to_save->tensor.dims());
+  TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+      shape_spec, &to_save->full_shape, &to_save->slice, &slice_shape));
+  if (!slice_shape.IsSameSize(to_save->tensor.shape())) {
+    return errors::InvalidArgument(
+        "Slice in shape_and_slice specification does not match the shape of "
+        "the tensor to  save: ",
+        shape_spec, ", tensor: ", to_save->tensor.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// Writes the tensors of 'tensors' at 'indices' to a bundle at 'prefix'.
+Status WriteBundle(const string& prefix,
+                   const std::vector<TensorToSave>& tensors,
+                   const std::vector<int64>& indices,
+                   const BundleWriter::Options& options =
+                       BundleWriter::Options()) {
+  BundleWriter writer(Env::Default(), prefix, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+  for (int64 i : indices) {
+    const TensorToSave& to_save = tensors[i];
+    if (to_save.is_slice) {
+      TF_RETURN_IF_ERROR(writer.AddSlice(to_save.name, to_save.full_shape,
+                                         to_save.slice, to_save.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(to_save.name, to_save.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+// Writes 'tensors' to a checkpoint at 'prefix'. A large checkpoint is split
+// into groups of tensors of similar sizes, each written to its own temporary
+// bundle by its own thread, which are then merged into one bundle with a data
+// file per group.
+Status WriteCheckpoint(const string& prefix,
+                       const std::vector<TensorToSave>& tensors) {
+  const int64 num_tensors = tensors.size();
+  int64 total_bytes = 0;
+  for (const TensorToSave& to_save : tensors) {
+    total_bytes += to_save.tensor.TotalBytes();
+  }
+  const int64 num_writers = std::min<int64>(
+      {static_cast<int64>(port::NumSchedulableCPUs()), num_tensors,
+       total_bytes / kMinBytesPerWriter});
+  if (num_writers <= 1) {
+    std::vector<int64> indices(num_tensors);
+    std::iota(indices.begin(), indices.end(), 0);
+    return WriteBundle(prefix, tensors, indices);
+  }
+
+  // Assigns the largest tensors first, each to the group with the fewest
+  // bytes so far.
+  std::vector<int64> sorted_indices(num_tensors);
+  std::iota(sorted_indices.begin(), sorted_indices.end(), 0);
+  std::sort(sorted_indices.begin(), sorted_indices.end(),
+            [&tensors](int64 a, int64 b) {
+              return tensors[a].tensor.TotalBytes() >
+                     tensors[b].tensor.TotalBytes();
+            });
+  std::vector<std::vector<int64>> groups(num_writers);
+  std::vector<int64> group_bytes(num_writers, 0);
+  for (int64 i : sorted_indices) {
+    const int64 group =
+        std::min_element(group_bytes.begin(), group_bytes.end()) -
+        group_bytes.begin();
+    groups[group].push_back(i);
+    group_bytes[group] += tensors[i].tensor.TotalBytes();
+  }
+
+  Env* env = Env::Default();
+  const string tmp_dir =
+      strings::StrCat(prefix, "_temp_parallel_", random::New64());
+  std::vector<string> group_prefixes(num_writers);
+  std::vector<Status> statuses(num_writers);
+  {
+    // The writes mostly wait for the file system, so they run on their own
+    // threads rather than on the compute ones.
+    thread::ThreadPool writers(env, "save_v2_writers", num_writers - 1);
+    for (int64 group = 0; group < num_writers; ++group) {
+      group_prefixes[group] = io::JoinPath(
+          tmp_dir, strings::Printf("part-%05lld-of-%05lld",
+                                   static_cast<long long>(group),
+                                   static_cast<long long>(num_writers)));
+    }
+    for (int64 group = 1; group < num_writers; ++group) {
+      writers.Schedule([&, group]() {
+        statuses[group] =
+            WriteBundle(group_prefixes[group], tensors, groups[group]);
+      });
+    }
+    statuses[0] = WriteBundle(group_prefixes[0], tensors, groups[0]);
+  }
+  Status status;
+  for (const Status& group_status : statuses) {
+    status.Update(group_status);
+  }
+  if (status.ok()) {
+    status = MergeBundles(env, group_prefixes, prefix);
+  }
+  // Best effort: the data files were renamed by the merge.
+  int64 undeleted_files, undeleted_dirs;
+  env->DeleteRecursively(tmp_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return status;
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
+//
+// If the TF_ASYNC_CHECKPOINT_SAVE environment variable is true, the op only
+// copies the tensors, which takes a fraction of the time of writing them, and
+// writes the checkpoint in the background. The RestoreV2 and
+// MergeV2Checkpoints ops wait for the checkpoints they read to be complete,
+// and report the errors of writing them.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar(kAsyncSaveEnvVar, false, &async_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -98,6 +322,7 @@ class SaveV2 : public OpKernel {
     const Tensor& shape_and_slices = context->input(2);
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
                    shape_and_slices);
+    if (!context->status().ok()) return;
 
     const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
     const int num_tensors = static_cast<int>(tensor_names.NumElements());
@@ -105,40 +330,170 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<string>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<TensorToSave> tensors(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
+      TensorToSave& to_save = tensors[i];
+      to_save.name = tensor_names_flat(i);
+      to_save.tensor = context->input(i + kFixedInputs);
 
       if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
         OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+                       ParseSliceToSave(shape_and_slices_flat(i), &to_save));
       }
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+
+    if (!async_) {
+      OP_REQUIRES_OK(context, WriteCheckpoint(prefix_string, tensors));
+      return;
+    }
+
+    // The inputs may share their buffers with variables that the next steps
+    // update in place, so they are copied before this op completes.
+    int64 total_bytes = 0;
+    for (const TensorToSave& to_save : tensors) {
+      total_bytes += to_save.tensor.TotalBytes();
+    }
+    const DeviceBase::CpuWorkerThreads* worker_threads =
+        context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_tensors,
+          total_bytes / std::max(1, num_tensors),
+          [&tensors](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              tensors[i].tensor = tensor::DeepCopy(tensors[i].tensor);
+            }
+          });
+
+    PendingCheckpoints::Global()->Start(prefix_string);
+    Env::Default()->SchedClosure([prefix_string, tensors]() {
+      PendingCheckpoints::Global()->Finish(
+          prefix_string, WriteCheckpoint(prefix_string, tensors));
+    });
   }
+
+ private:
+  // Whether the checkpoint is written in the background.
+  bool async_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+// Saves the rows of resource variables changed since their last save by this
+// op, in a tensor bundle that is a delta on a base bundle.  Each run of
+// consecutive changed rows is stored as a slice of the variable.
+class SaveDeltaV2 : public OpKernel {
+ public:
+  explicit SaveDeltaV2(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& base_prefix = context->input(1);
+    const Tensor& tensor_names = context->input(2);
+    const Tensor& shape_and_slices = context->input(3);
+    ValidateInputs(false /* not save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    const int kFixedInputs = 4;  // Prefixes, tensor names, shape_and_slices.
+    const int num_tensors = static_cast<int>(tensor_names.NumElements());
+    OP_REQUIRES(context, base_prefix.NumElements() == 1,
+                errors::InvalidArgument(
+                    "Input base_prefix should have a single element, got ",
+                    base_prefix.NumElements(), " instead."));
+    OP_REQUIRES(context, context->num_inputs() == num_tensors + kFixedInputs,
+                errors::InvalidArgument(
+                    "Got ", num_tensors, " tensor names but ",
+                    context->num_inputs() - kFixedInputs, " variables."));
+    const string& prefix_string = prefix.scalar<string>()();
+    BundleWriter::Options options;
+    options.base_prefix = base_prefix.scalar<string>()();
+    OP_REQUIRES(context, options.base_prefix != prefix_string,
+                errors::InvalidArgument("A delta checkpoint cannot be its own "
+                                        "base: ",
+                                        prefix_string));
+    // The delta is unreadable until its base is complete.
+    OP_REQUIRES_OK(context,
+                   PendingCheckpoints::Global()->Wait(options.base_prefix));
+    const auto& tensor_names_flat = tensor_names.flat<string>();
+    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+
+    // The changed rows are taken from the variables before they are written,
+    // so if this op fails the variables are saved in full next time.
+    std::vector<Var*> variables;
+    auto unref = gtl::MakeCleanup([context, &variables] {
+      for (Var* variable : variables) {
+        if (!context->status().ok()) variable->MarkDirty();
+        variable->Unref();
+      }
+    });
+    std::vector<TensorToSave> tensors;
+    for (int i = 0; i < num_tensors; ++i) {
+      Var* variable = nullptr;
+      OP_REQUIRES_OK(context,
+                     LookupResource(context,
+                                    HandleFromInput(context, i + kFixedInputs),
+                                    &variable));
+      if (std::find(variables.begin(), variables.end(), variable) !=
+          variables.end()) {
+        // Only the first save of it would get its changed rows.
+        variable->Unref();
+        context->CtxFailure(errors::InvalidArgument(
+            "Variable ", tensor_names_flat(i), " is saved more than once"));
+        return;
+      }
+      variables.push_back(variable);
+
+      mutex_lock ml(*variable->mu());
+      TensorToSave full;
+      full.name = tensor_names_flat(i);
+      full.tensor = *variable->tensor();
+      OP_REQUIRES(context, full.tensor.IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to save uninitialized variable ", full.name));
+      if (!shape_and_slices_flat(i).empty()) {
+        OP_REQUIRES_OK(context,
+                       ParseSliceToSave(shape_and_slices_flat(i), &full));
+      }
+
+      std::vector<int64> rows;
+      const int64 num_rows = full.tensor.dims() > 0 ? full.tensor.dim_size(0)
+                                                    : 0;
+      if (variable->TakeDirtyRows(num_rows, &rows) ||
+          options.base_prefix.empty()) {
+        // The variable is updated in place once the lock is released.
+        full.tensor = tensor::DeepCopy(full.tensor);
+        tensors.push_back(std::move(full));
+        continue;
+      }
+      if (rows.empty()) continue;
+      if (!full.is_slice) {
+        full.full_shape = full.tensor.shape();
+        full.slice = TensorSlice(full.tensor.dims());
+      }
+      const int64 first_row = full.slice.IsFullAt(0) ? 0 : full.slice.start(0);
+      for (size_t begin = 0; begin < rows.size();) {
+        size_t end = begin + 1;
+        while (end < rows.size() && rows[end] == rows[end - 1] + 1) ++end;
+        TensorToSave to_save;
+        to_save.name = full.name;
+        to_save.is_slice = true;
+        to_save.full_shape = full.full_shape;
+        to_save.slice = full.slice;
+        to_save.slice.set_start(0, first_row + rows[begin]);
+        to_save.slice.set_length(0, end - begin);
+        to_save.tensor = tensor::DeepCopy(
+            full.tensor.Slice(rows[begin], rows[end - 1] + 1));
+        tensors.push_back(std::move(to_save));
+        begin = end;
+      }
+    }
+
+    std::vector<int64> indices(tensors.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    OP_REQUIRES_OK(context,
+                   WriteBundle(prefix_string, tensors, indices, options));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("SaveDeltaV2").Device(DEVICE_CPU), SaveDeltaV2);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
@@ -158,6 +513,7 @@ class RestoreV2 : public OpKernel {
                    shape_and_slices);
 
     const string& prefix_string = prefix.scalar<string>()();
+    OP_REQUIRES_OK(context, PendingCheckpoints::Global()->Wait(prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -185,12 +541,17 @@ class RestoreV2 : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
 // The final step in saving sharded V2 checkpoints: merges metadata files.
+//
+// In the async mode of SaveV2, the merge also runs in the background, after
+// the input checkpoints are written.
 class MergeV2Checkpoints : public OpKernel {
  public:
   explicit MergeV2Checkpoints(OpKernelConstruction* context)
       : OpKernel(context) {
     OP_REQUIRES_OK(context,
                    context->GetAttr("delete_old_dirs", &delete_old_dirs_));
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar(kAsyncSaveEnvVar, false, &async_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -206,14 +567,38 @@ class MergeV2Checkpoints : public OpKernel {
                     "Input destination_prefix should be a scalar tensor, got ",
                     destination_prefix.shape().DebugString(), " instead."));
 
-    const gtl::ArraySlice<string> input_prefixes =
-        gtl::ArraySlice<string>(checkpoint_prefixes.flat<string>());
-    Env* env = Env::Default();
+    const auto& checkpoint_prefixes_flat = checkpoint_prefixes.flat<string>();
+    const std::vector<string> input_prefixes(
+        checkpoint_prefixes_flat.data(),
+        checkpoint_prefixes_flat.data() + checkpoint_prefixes_flat.size());
     const string& merged_prefix = destination_prefix.scalar<string>()();
-    OP_REQUIRES_OK(
-        context, tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
+    if (!async_) {
+      OP_REQUIRES_OK(context,
+                     Merge(input_prefixes, merged_prefix, delete_old_dirs_));
+      return;
+    }
+    // The closure may outlive the kernel, so it doesn't refer to it.
+    PendingCheckpoints::Global()->Start(merged_prefix);
+    const bool delete_old_dirs = delete_old_dirs_;
+    Env::Default()->SchedClosure(
+        [input_prefixes, merged_prefix, delete_old_dirs]() {
+          PendingCheckpoints::Global()->Finish(
+              merged_prefix,
+              Merge(input_prefixes, merged_prefix, delete_old_dirs));
+        });
+  }
+
+ private:
+  static Status Merge(const std::vector<string>& input_prefixes,
+                      const string& merged_prefix, bool delete_old_dirs) {
+    for (const string& input_prefix : input_prefixes) {
+      TF_RETURN_IF_ERROR(PendingCheckpoints::Global()->Wait(input_prefix));
+    }
+    Env* env = Env::Default();
+    TF_RETURN_IF_ERROR(
+        tensorflow::MergeBundles(env, input_prefixes, merged_prefix));
 
-    if (delete_old_dirs_) {
+    if (delete_old_dirs) {
       const string& merged_dir = io::Dirname(merged_prefix).ToString();
       for (const string& input_prefix : input_prefixes) {
         const string& dirname = io::Dirname(input_prefix).ToString();
@@ -224,11 +609,13 @@ class MergeV2Checkpoints : public OpKernel {
         if (!status.ok()) VLOG(1) << status;
       }
     }
+    return Status::OK();
   }
 
- private:
   // On merge, whether or not to delete the input (temporary) directories.
   bool delete_old_dirs_;
+  // Whether the merge runs in the background.
+  bool async_;
 };
 REGISTER_KERNEL_BUILDER(Name("MergeV2Checkpoints").Device(DEVICE_CPU),
                         MergeV2Checkpoints);
@@ -20,11 +20,13 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
@@ -339,5 +341,55 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+TEST_F(SaveV2OpTest, SaveLargeTensorsInParallel) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_large");
+  const int kNumTensors = 4;
+  const int64 kNumElements = 3 << 20;  // 12MB per tensor.
+
+  TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                   .Input(FakeInput())  // prefix
+                   .Input(FakeInput())  // tensor_names
+                   .Input(FakeInput())  // shape_and_slices
+                   .Input(FakeInput({DT_FLOAT, DT_FLOAT, DT_FLOAT, DT_FLOAT}))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<string>(TensorShape({}),
+                   [&prefix](int x) -> string { return prefix; });
+  AddInput<string>(TensorShape({kNumTensors}), [](int x) -> string {
+    return strings::StrCat("tensor_", x);
+  });
+  // The last tensor is saved as the second half of a larger one.
+  AddInput<string>(TensorShape({kNumTensors}), [](int x) -> string {
+    return x == kNumTensors - 1
+               ? strings::StrCat(2 * kNumElements, " ", kNumElements, ",",
+                                 kNumElements)
+               : "";
+  });
+  for (int t = 0; t < kNumTensors; ++t) {
+    AddInput<float>(TensorShape({kNumElements}),
+                    [t](int x) -> float { return t * 1000 + x % 1000; });
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  for (int t = 0; t < kNumTensors; ++t) {
+    const string name = strings::StrCat("tensor_", t);
+    Tensor val(DT_FLOAT, TensorShape({kNumElements}));
+    if (t == kNumTensors - 1) {
+      TensorSlice slice(1);
+      slice.set_start(0, kNumElements);
+      slice.set_length(0, kNumElements);
+      TF_ASSERT_OK(reader.LookupSlice(name, slice, &val));
+    } else {
+      TF_ASSERT_OK(reader.Lookup(name, &val));
+    }
+    const auto flat = val.flat<float>();
+    for (int64 i = 0; i < kNumElements; i += 4099) {
+      ASSERT_EQ(t * 1000 + i % 1000, flat(i)) << name << " " << i;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/row_locks.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -110,6 +111,28 @@ struct ScatterFunctorBase {
   }
 };
 
+// The arithmetic updates of rows on CPU are split across the worker threads,
+// and the updates of rows that are repeated in indices are serialized with
+// the row mutexes of params.
+template <typename T, typename Index, scatter_op::UpdateOp op>
+struct ScatterFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    // indices and params sizes were validated in DoCompute().
+    const Index limit = static_cast<Index>(params.dimension(0));
+    const int64 cost_per_update = updates.dimension(1) * 2;
+    return ShardedRowUpdate<Index>(
+        c, indices, limit, params.data(), cost_per_update,
+        /*always_lock_rows=*/false, [&](int64 i, Index index) {
+          // Copy last Ndim-1 dimensions of updates[i] to params[index]
+          scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
+                                                updates.template chip<0>(i));
+        });
+  }
+};
+
 template <typename T, typename Index>
 struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
   Index operator()(OpKernelContext* c, const CPUDevice& d,
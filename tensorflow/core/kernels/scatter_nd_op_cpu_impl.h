@@ -20,7 +20,10 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <atomic>
+#include <numeric>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
@@ -127,6 +130,9 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
       }
     }
 
+    // Output slice of each update.  All the indices are checked before any
+    // update is applied.
+    std::vector<Index> out_slices(batch_size);
     for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
       Index i = 0;
       bool out_of_bounds = false;
@@ -137,17 +143,67 @@ struct ScatterNdFunctor<CPUDevice, T, Index, OP, IXDIM> {
       }
       if (TF_PREDICT_FALSE(out_of_bounds)) {
         error_loc = loc;
-        break;
-      } else {
-        auto input_chip = Toutput.template chip<0>(i);
-        auto output_chip = input_chip.device(d);
-        auto update_chip = Tupdates.template chip<0>(loc);
-        update_executor::UpdateExecutor<
-            decltype(input_chip), decltype(update_chip), decltype(output_chip),
-            OP>::Execute(input_chip, update_chip, output_chip);
+        return error_loc;
+      }
+      out_slices[loc] = i;
+    }
+    if (slice_size == 0) {
+      return error_loc;
+    }
+
+    // Slices are contiguous, so each update is a single vectorized
+    // operation on two flat maps.
+    auto update_slice = [&](Eigen::DenseIndex loc) {
+      typename TTypes<T>::UnalignedFlat output(&Toutput(out_slices[loc], 0),
+                                               slice_size);
+      typename TTypes<T>::UnalignedConstFlat update(&Tupdates(loc, 0),
+                                                    slice_size);
+      update_executor::UpdateExecutor<decltype(output), decltype(update),
+                                      decltype(output),
+                                      OP>::Execute(output, update, output);
+    };
+
+    const int64 kMinParallelElements = 1 << 15;
+    if (d.numThreads() <= 1 ||
+        batch_size * static_cast<int64>(slice_size) < kMinParallelElements) {
+      for (Eigen::DenseIndex loc = 0; loc < batch_size; ++loc) {
+        update_slice(loc);
       }
+      return error_loc;
     }
 
+    // Sorts the updates by output slice, and moves the boundaries of the
+    // shards so that all the updates of a slice are applied by one shard in
+    // their original order.  Shards never write to the same slice, and
+    // duplicate indices give the same result as the serial loop.
+    std::vector<Eigen::DenseIndex> order(batch_size);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&out_slices](Eigen::DenseIndex a, Eigen::DenseIndex b) {
+                       return out_slices[a] < out_slices[b];
+                     });
+    const double slice_bytes = static_cast<double>(slice_size) * sizeof(T);
+    d.parallelFor(
+        batch_size, Eigen::TensorOpCost(2 * slice_bytes, slice_bytes,
+                                        slice_size),
+        [&](Eigen::DenseIndex first, Eigen::DenseIndex last) {
+          auto same_slice = [&](Eigen::DenseIndex k) {
+            return out_slices[order[k]] == out_slices[order[k - 1]];
+          };
+          while (first > 0 && first < last && same_slice(first)) {
+            ++first;
+          }
+          if (first == last) {
+            return;
+          }
+          while (last < batch_size && same_slice(last)) {
+            ++last;
+          }
+          for (Eigen::DenseIndex k = first; k < last; ++k) {
+            update_slice(order[k]);
+          }
+        });
+
     return error_loc;
   }
 };
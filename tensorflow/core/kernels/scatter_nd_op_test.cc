@@ -113,6 +113,36 @@ TEST_F(ScatterNdUpdateOpTest, Simple_Two64) {
   test::ExpectTensorEqual<float>(expected, params_tensor);
 }
 
+TEST_F(ScatterNdUpdateOpTest, ManyDuplicateIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  // Enough updates to be applied in parallel. Each row is updated many
+  // times, and keeps the value of its last update.
+  const int kRows = 8;
+  const int kSliceSize = 16;
+  const int kUpdates = 4096;
+  std::vector<int32> indices(kUpdates);
+  std::vector<float> updates(kUpdates * kSliceSize);
+  std::vector<float> expected_values(kRows * kSliceSize, 0);
+  for (int u = 0; u < kUpdates; ++u) {
+    indices[u] = (u * 5) % kRows;
+    for (int k = 0; k < kSliceSize; ++k) {
+      updates[u * kSliceSize + k] = u * kSliceSize + k;
+      expected_values[indices[u] * kSliceSize + k] = u * kSliceSize + k;
+    }
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kSliceSize}),
+                           std::vector<float>(kRows * kSliceSize, 0));
+  AddInputFromArray<int32>(TensorShape({kUpdates, 1}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kSliceSize}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kSliceSize}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
 /*TEST_F(ScatterNdUpdateOpTest, Simple_ZeroElements) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
@@ -224,6 +224,59 @@ TEST_F(ScatterUpdateOpTest, Error_MismatchedIndicesAndUpdateDimensions) {
       << s;
 }
 
+class ScatterAddOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType variable_ref_type, DataType index_type) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "ScatterAdd")
+                     .Input(FakeInput(variable_ref_type))
+                     .Input(FakeInput(index_type))
+                     .Input(FakeInput(RemoveRefType(variable_ref_type)))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(ScatterAddOpTest, RepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  // Enough updates that they are split across threads, most of which update
+  // the same rows.
+  const int kRows = 8;
+  const int kCols = 64;
+  const int kUpdates = 16 << 10;
+  std::vector<int32> indices(kUpdates);
+  for (int i = 0; i < kUpdates; ++i) {
+    indices[i] = i % kRows;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 0));
+  AddInputFromArray<int32>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}),
+                           std::vector<float>(kUpdates * kCols, 1));
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillFn<float>(&expected,
+                      [](int) -> float { return kUpdates / kRows; });
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
+TEST_F(ScatterAddOpTest, Error_IndexOutOfRange) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  // Feed and run
+  AddInputFromArray<float>(TensorShape({5, 3}),
+                           {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  AddInputFromArray<int32>(TensorShape({3}), {0, 99, 5});
+  AddInputFromArray<float>(TensorShape({3, 3}),
+                           {100, 101, 102, 777, 778, 779, 10000, 10001, 10002});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      StringPiece(s.ToString()).contains("indices[1] = 99 is not in [0, 5)"))
+      << s;
+}
+
 class ScatterUpdateBM : public ScatterUpdateOpTest {
  public:
   virtual void TestBody() {}
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sdca_internal.h"
 
+#include <atomic>
 #include <limits>
 #include <random>
 
@@ -30,6 +31,28 @@ namespace sdca {
 using UnalignedFloatVector = TTypes<const float>::UnalignedConstVec;
 using UnalignedInt64Vector = TTypes<const int64>::UnalignedConstVec;
 
+namespace {
+
+// How many sparse features ahead the weights are prefetched.
+constexpr int64 kPrefetchDistance = 8;
+
+// Adds delta to *value without taking a lock. The examples are processed
+// concurrently, and a plain += would lose the updates made by other threads
+// to the weights of the features their examples share.
+inline void AtomicAdd(const double delta, float* const value) {
+  static_assert(sizeof(std::atomic<float>) == sizeof(float),
+                "std::atomic<float> must have the layout of float");
+  std::atomic<float>* const atomic_value =
+      reinterpret_cast<std::atomic<float>*>(value);
+  float old_value = atomic_value->load(std::memory_order_relaxed);
+  while (!atomic_value->compare_exchange_weak(
+      old_value, static_cast<float>(old_value + delta),
+      std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
 void FeatureWeightsDenseStorage::UpdateDenseDeltaWeights(
     const Eigen::ThreadPoolDevice& device,
     const Example::DenseVector& dense_vector,
@@ -60,18 +83,25 @@ void FeatureWeightsSparseStorage::UpdateSparseDeltaWeights(
     const Eigen::ThreadPoolDevice& device,
     const Example::SparseFeatures& sparse_features,
     const std::vector<double>& normalized_bounded_dual_delta) {
-  for (int64 k = 0; k < sparse_features.indices->size(); ++k) {
+  for (int64 k = 0; k < sparse_features.ids->size(); ++k) {
     const double feature_value = sparse_features.values == nullptr
                                      ? 1.0
                                      : (*sparse_features.values)(k);
-    auto it = indices_to_id_.find((*sparse_features.indices)(k));
+    const int64 id = (*sparse_features.ids)(k);
     for (size_t l = 0; l < normalized_bounded_dual_delta.size(); ++l) {
-      deltas_(l, it->second) +=
-          feature_value * normalized_bounded_dual_delta[l];
+      AtomicAdd(feature_value * normalized_bounded_dual_delta[l],
+                &deltas_(l, id));
     }
   }
 }
 
+void FeatureWeightsSparseStorage::CreateIndexMap() {
+  indices_to_id_.reserve(indices_.size());
+  for (int64 j = 0; j < indices_.size(); ++j) {
+    indices_to_id_[indices_(j)] = j;
+  }
+}
+
 void ModelWeights::UpdateDeltaWeights(
     const Eigen::ThreadPoolDevice& device, const Example& example,
     const std::vector<double>& normalized_bounded_dual_delta) {
@@ -120,6 +150,25 @@ Status ModelWeights::Initialize(OpKernelContext* const context) {
             {1, sparse_weights_inputs[i].NumElements()}),
         deltas});
   }
+  // The index maps of large feature groups take long to build, so the groups
+  // are built in parallel.
+  const auto create_index_maps = [this](const int64 begin, const int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      sparse_weights_[i].CreateIndexMap();
+    }
+  };
+  int64 num_sparse_weights = 0;
+  for (const Tensor& sparse_indices : sparse_indices_inputs) {
+    num_sparse_weights += sparse_indices.NumElements();
+  }
+  if (!sparse_weights_.empty()) {
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64 kCostPerUnit =
+        100 * num_sparse_weights / sparse_weights_.size();
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          sparse_weights_.size(), kCostPerUnit, create_index_maps);
+  }
 
   // Reads in the weights, and allocates and initializes the delta weights.
   const auto initialize_weights = [&](
@@ -161,16 +210,21 @@ const ExampleStatistics Example::ComputeWxAndWeightedExampleNorm(
     const FeatureWeightsSparseStorage& sparse_weights =
         model_weights.sparse_weights()[j];
 
-    for (int64 k = 0; k < sparse_features.indices->size(); ++k) {
-      const int64 feature_index = (*sparse_features.indices)(k);
+    const int64 num_features = sparse_features.ids->size();
+    for (int64 k = 0; k < num_features; ++k) {
+      if (k + kPrefetchDistance < num_features) {
+        sparse_weights.PrefetchById(
+            (*sparse_features.ids)(k + kPrefetchDistance));
+      }
+      const int64 id = (*sparse_features.ids)(k);
       const double feature_value = sparse_features.values == nullptr
                                        ? 1.0
                                        : (*sparse_features.values)(k);
       for (int l = 0; l < num_weight_vectors; ++l) {
-        const float sparse_weight = sparse_weights.nominals(l, feature_index);
+        const float sparse_weight = sparse_weights.nominal_by_id(l, id);
         const double feature_weight =
             sparse_weight +
-            sparse_weights.deltas(l, feature_index) * num_loss_partitions;
+            sparse_weights.delta_by_id(l, id) * num_loss_partitions;
         result.prev_wx[l] +=
             feature_value * regularization.Shrink(sparse_weight);
         result.wx[l] += feature_value * regularization.Shrink(feature_weight);
@@ -360,7 +414,7 @@ Status Examples::Initialize(OpKernelContext* const context,
   TF_RETURN_IF_ERROR(CreateSparseFeatureRepresentation(
       worker_threads, num_examples, num_sparse_features, weights,
       sparse_example_indices_inputs, sparse_feature_indices_inputs,
-      sparse_feature_values_inputs, &examples_));
+      sparse_feature_values_inputs, &sparse_feature_ids_, &examples_));
   TF_RETURN_IF_ERROR(CreateDenseFeatureRepresentation(
       worker_threads, num_examples, num_dense_features, weights,
       dense_features_inputs, &examples_));
@@ -376,9 +430,11 @@ Status Examples::CreateSparseFeatureRepresentation(
     const OpInputList& sparse_example_indices_inputs,
     const OpInputList& sparse_feature_indices_inputs,
     const OpInputList& sparse_feature_values_inputs,
+    std::vector<std::vector<int64>>* const sparse_feature_ids,
     std::vector<Example>* const examples) {
   mutex mu;
   Status result GUARDED_BY(mu);
+  sparse_feature_ids->resize(num_sparse_features);
   auto parse_partition = [&](const int64 begin, const int64 end) {
     // The static_cast here is safe since begin and end can be at most
     // num_examples which is an int.
@@ -387,6 +443,10 @@ Status Examples::CreateSparseFeatureRepresentation(
           sparse_example_indices_inputs[i].template flat<int64>();
       auto feature_indices =
           sparse_feature_indices_inputs[i].template flat<int64>();
+      const FeatureWeightsSparseStorage& sparse_weights =
+          weights.sparse_weights()[i];
+      std::vector<int64>* const ids = &(*sparse_feature_ids)[i];
+      ids->resize(feature_indices.size());
 
       // Parse features for each example. Features for a particular example
       // are at the offsets (start_id, end_id]
@@ -404,6 +464,8 @@ Status Examples::CreateSparseFeatureRepresentation(
             example_indices(start_id) == example_id) {
           sparse_features->indices.reset(new UnalignedInt64Vector(
               &(feature_indices(start_id)), end_id - start_id));
+          sparse_features->ids.reset(new UnalignedInt64Vector(
+              ids->data() + start_id, end_id - start_id));
           if (sparse_feature_values_inputs.size() > i) {
             auto feature_weights =
                 sparse_feature_values_inputs[i].flat<float>();
@@ -416,19 +478,22 @@ Status Examples::CreateSparseFeatureRepresentation(
             // operations from eigen.
             for (int64 k = 0; k < sparse_features->indices->size(); ++k) {
               const int64 feature_index = (*sparse_features->indices)(k);
-              if (!weights.SparseIndexValid(i, feature_index)) {
+              const int64 id = sparse_weights.IndexToId(feature_index);
+              if (id < 0) {
                 mutex_lock l(mu);
                 result = errors::InvalidArgument(
                     "Found sparse feature indices out of valid range: ",
                     (*sparse_features->indices)(k));
                 return;
               }
+              (*ids)[start_id + k] = id;
             }
           }
         } else {
           // Add a Tensor that has size 0.
           sparse_features->indices.reset(
               new UnalignedInt64Vector(&(feature_indices(0)), 0));
+          sparse_features->ids.reset(new UnalignedInt64Vector(ids->data(), 0));
           // If values exist for this feature group.
           if (sparse_feature_values_inputs.size() > i) {
             auto feature_weights =
@@ -23,7 +23,6 @@ limitations under the License.
 #include <cmath>
 #include <memory>
 #include <new>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -39,9 +38,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/random/distribution_sampler.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/guarded_philox_random.h"
 #include "tensorflow/core/util/sparse/group_iterator.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
@@ -146,10 +147,12 @@ class Example {
   // Sparse features associated with the example.
   // Indices and Values are the associated feature index, and values. Values
   // can be optionally absent, in which we case we implicitly assume a value of
-  // 1.0f.
+  // 1.0f. Ids are the positions of the weights of the features in their
+  // FeatureWeightsSparseStorage, resolved once when the examples are read.
   struct SparseFeatures {
     std::unique_ptr<TTypes<const int64>::UnalignedConstVec> indices;
     std::unique_ptr<TTypes<const float>::UnalignedConstVec> values;  // nullptr encodes optional.
+    std::unique_ptr<TTypes<const int64>::UnalignedConstVec> ids;
   };
 
   // A dense vector which is a row-slice of the underlying matrix.
@@ -227,51 +230,66 @@ class FeatureWeightsDenseStorage {
 };
 
 // Similar to FeatureWeightsDenseStorage, but the underlying weights are stored
-// in an unordered map.
+// in a dense matrix indexed through a hash map.
 class FeatureWeightsSparseStorage {
  public:
   FeatureWeightsSparseStorage(const TTypes<const int64>::Vec indices,
                               const TTypes<const float>::Matrix nominals,
                               TTypes<float>::Matrix deltas)
-      : nominals_(nominals), deltas_(deltas) {
-    // Create a map from sparse index to the dense index of the underlying
-    // storage.
-    for (int64 j = 0; j < indices.size(); ++j) {
-      indices_to_id_[indices(j)] = j;
-    }
-  }
+      : indices_(indices), nominals_(nominals), deltas_(deltas) {}
 
   // Check if a feature index exists.
   bool IndexValid(const int64 index) const {
     return indices_to_id_.find(index) != indices_to_id_.end();
   }
 
-  // Nominal value at a particular feature index and class label.
-  float nominals(const int class_id, const int64 index) const {
+  // Returns the position of the weight of a feature index in the underlying
+  // storage, or -1 if the feature index does not exist.
+  int64 IndexToId(const int64 index) const {
     auto it = indices_to_id_.find(index);
-    return nominals_(class_id, it->second);
+    return it == indices_to_id_.end() ? -1 : it->second;
   }
 
-  // Delta weights durining mini-batch updates.
-  float deltas(const int class_id, const int64 index) const {
-    auto it = indices_to_id_.find(index);
-    return deltas_(class_id, it->second);
+  // Nominal value and delta weight of a feature, given its id (see
+  // IndexToId), without the hash map lookup.
+  float nominal_by_id(const int class_id, const int64 id) const {
+    return nominals_(class_id, id);
+  }
+  float delta_by_id(const int class_id, const int64 id) const {
+    return deltas_(class_id, id);
+  }
+
+  // Prefetches the weights of the feature with the given id.
+  void PrefetchById(const int64 id) const {
+    port::prefetch<port::PREFETCH_HINT_T0>(&nominals_(0, id));
+    port::prefetch<port::PREFETCH_HINT_T0>(&deltas_(0, id));
   }
 
   // Updates delta weights based on active sparse features in the example and
-  // the corresponding dual residual.
+  // the corresponding dual residual. The updates are atomic, so that the
+  // threads processing examples which share features do not lose each
+  // other's updates.
   void UpdateSparseDeltaWeights(
       const Eigen::ThreadPoolDevice& device,
       const Example::SparseFeatures& sparse_features,
       const std::vector<double>& normalized_bounded_dual_delta);
 
  private:
+  // Creates the map from sparse index to the dense index of the underlying
+  // storage. Called by ModelWeights::Initialize(), for all the feature groups
+  // in parallel, before any other method.
+  void CreateIndexMap();
+
+  // The feature indices, in the order of their weights in the storage.
+  const TTypes<const int64>::Vec indices_;
   // The nominal value of the weight for a feature (indexed by its id).
   const TTypes<const float>::Matrix nominals_;
   // The accumulated delta weight for a feature (indexed by its id).
   TTypes<float>::Matrix deltas_;
   // Map from feature index to an index to the dense vector.
-  std::unordered_map<int64, int64> indices_to_id_;
+  gtl::FlatMap<int64, int64> indices_to_id_;
+
+  friend class ModelWeights;
 };
 
 // Weights in the model, wraps both current weights, and the delta weights
@@ -356,6 +374,7 @@ class Examples {
       const OpInputList& sparse_example_indices_inputs,
       const OpInputList& sparse_feature_indices_inputs,
       const OpInputList& sparse_feature_values_inputs,
+      std::vector<std::vector<int64>>* const sparse_feature_ids,
       std::vector<Example>* const examples);
 
   // Reads the input tensors, and builds the internal representation for dense
@@ -377,6 +396,10 @@ class Examples {
   // All examples in the batch.
   std::vector<Example> examples_;
 
+  // The ids of the sparse features of all the examples, per feature group.
+  // The ids of Example::SparseFeatures point into these.
+  std::vector<std::vector<int64>> sparse_feature_ids_;
+
   // Adaptative sampling variables
   std::vector<float> probabilities_;
   std::vector<int> sampled_index_;
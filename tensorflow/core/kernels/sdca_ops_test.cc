@@ -253,10 +253,32 @@ void BM_SDCA_LARGE_SPARSE(const int iters, const int num_examples) {
   testing::StartTiming();
   test::Benchmark("cpu", train, GetMultiThreadedOptions(), init).Run(iters);
 }
+
+// Measures how the training step scales with the number of threads.
+void BM_SDCA_LARGE_SPARSE_SCALING(const int iters, const int num_threads) {
+  testing::StopTiming();
+  Graph* init = nullptr;
+  Graph* train = nullptr;
+  GetGraphs(4096 /* examples */, 65 /* sparse feature groups */,
+            1e6 /* sparse features per group */, 0 /* dense feature groups*/,
+            0 /* dense features per group */, &init, &train);
+  SessionOptions options;
+  options.config.set_intra_op_parallelism_threads(num_threads);
+  options.config.set_inter_op_parallelism_threads(1);
+  options.config.add_session_inter_op_thread_pool()->set_num_threads(1);
+  testing::StartTiming();
+  test::Benchmark("cpu", train, &options, init).Run(iters);
+}
 }  // namespace
 
 BENCHMARK(BM_SDCA)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
 BENCHMARK(BM_SDCA_LARGE_DENSE)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
 BENCHMARK(BM_SDCA_LARGE_SPARSE)->Arg(128)->Arg(256)->Arg(512)->Arg(1024);
+BENCHMARK(BM_SDCA_LARGE_SPARSE_SCALING)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
 
 }  // namespace tensorflow
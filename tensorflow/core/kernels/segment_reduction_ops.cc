@@ -18,6 +18,9 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <vector>
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -30,7 +33,14 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA
 
 namespace tensorflow {
 
@@ -100,87 +110,103 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
-#if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
-    dims_to_reduce[0] = 0;
-#else
-    Eigen::IndexList<Eigen::type2index<0>> dims_to_reduce;
-#endif
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
-    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
+    // Find the segments, which are reduced in parallel below. The ids are
+    // checked in the order of the rows, so that the first invalid one is
+    // reported.
+    std::vector<int64> segment_ends;
+    std::vector<Index> segment_out_indices;
+    Index out_index = internal::SubtleMustCopy(segment_vec(0));
+    for (int64 end = 1; end <= num_indices; ++end) {
       Index next_index = 0;
       if (end < num_indices) {
         next_index = internal::SubtleMustCopy(segment_vec(end));
         if (out_index == next_index) {
-          ++end;
           continue;
         }
         // We have a new segment here.  Verify that the segment ids are growing.
         OP_REQUIRES(context, out_index < next_index,
                     errors::InvalidArgument("segment ids are not increasing"));
       }
-
-      // Process segment [start, end)
-      const T* in_slice_ptr = &input_flat(start, 0);
-      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                               Eigen::Unaligned>
-          OutT;
-
       OP_REQUIRES(
           context, FastBoundsCheck(out_index, output_rows),
           errors::InvalidArgument(
               "Segment id ", out_index, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
+      segment_ends.push_back(end);
+      segment_out_indices.push_back(out_index);
+      out_index = next_index;
+    }
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(T(default_value));
-      }
+#if !defined(EIGEN_HAS_INDEX_LIST)
+    Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
+    dims_to_reduce[0] = 0;
+#else
+    Eigen::IndexList<Eigen::type2index<0>> dims_to_reduce;
+#endif
+    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
+    typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                             Eigen::Unaligned>
+        OutT;
+
+    // Reduces the segments [begin, end), each one also setting the gap of
+    // output rows which no segment maps to before it to the default value.
+    auto reduce_segments = [&](int64 begin, int64 end) {
+      for (int64 segment = begin; segment < end; ++segment) {
+        const int64 start = segment == 0 ? 0 : segment_ends[segment - 1];
+        const int64 stop = segment_ends[segment];
+        const Index out_index = segment_out_indices[segment];
+        const Index uninitialized_index =
+            segment == 0 ? 0 : segment_out_indices[segment - 1] + 1;
+        if (out_index > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              out_index - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(T(default_value));
+        }
 
-      T* out_slice_ptr = &output_flat(out_index, 0);
-      OutT out_slice(out_slice_ptr, out_slice_shape);
-      // We don't use out_slice.device(context->eigen_device<Device>)
-      // because these pieces of work are likely to be very small and
-      // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
-      if (start == end - 1) {
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, out_slice_shape);
-        out_slice = in_slice;
-      } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
-                                                           num_col);
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, in_slice_shape);
-
-        out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        const T* in_slice_ptr = &input_flat(start, 0);
+        OutT out_slice(&output_flat(out_index, 0), out_slice_shape);
+        // We don't use out_slice.device(context->eigen_device<Device>)
+        // because these pieces of work are likely to be very small and
+        // the context switching overhead dwarfs any benefit we get from
+        // using another thread to do this work.
+        if (start == stop - 1) {
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, out_slice_shape);
+          out_slice = in_slice;
+        } else {
+          Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(stop - start,
+                                                             num_col);
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, in_slice_shape);
+
+          out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        }
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
-    }
+    };
+
+    // The segments write disjoint output rows, so they are sharded across
+    // threads, each costing about the mean number of input and output values
+    // of a segment.
+    const int64 num_segments = segment_ends.size();
+    const int64 cost_per_segment =
+        (num_indices + output_rows) * num_col / num_segments + 1;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_segments,
+          cost_per_segment, &cost_estimator_, reduce_segments);
   }
+
+ private:
+  // Segment sizes are often skewed, so the mean based estimate above is
+  // corrected by the running times of earlier steps.
+  ShardCostEstimator cost_estimator_;
 };
 
 #define REGISTER_CPU_KERNEL_SEGMENT(name, functor, type, index_type, \
@@ -227,10 +253,252 @@ REGISTER_COMPLEX_CPU_KERNELS_ALL(complex128);
 #undef REGISTER_REAL_CPU_KERNELS_ALL
 #undef REGISTER_COMPLEX_CPU_KERNELS_ALL
 
+#if GOOGLE_CUDA
+// SegmentSum on GPU, which sums tiles of consecutive rows of the same segment
+// before accumulating them into the output, instead of accumulating each value
+// atomically. The number of output rows is read back from the device, so the
+// rest of the op runs once the copy is done.
+template <class T, class Index>
+class SegmentSumGPUOp : public AsyncOpKernel {
+ public:
+  explicit SegmentSumGPUOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const Tensor& segment_ids = context->input(1);
+
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(segment_ids.shape()),
+        errors::InvalidArgument("segment_ids should be a vector."), done);
+
+    const int64 num_indices = segment_ids.NumElements();
+    OP_REQUIRES_ASYNC(
+        context, num_indices == input.dim_size(0),
+        errors::InvalidArgument(
+            "segment_ids should be the same size as dimension 0 of"
+            " input."),
+        done);
+
+    if (num_indices == 0) {
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, 0);
+
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+      done();
+      return;
+    }
+
+    // The number of output rows is the last segment id plus one, which is
+    // copied to pinned host memory to avoid unnecessary synchronization.
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(context, stream,
+                      errors::Internal("No GPU stream available."), done);
+    Tensor output_rows_host;
+    AllocatorAttributes alloc_attr;
+    alloc_attr.set_on_host(true);
+    alloc_attr.set_gpu_compatible(true);
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DataTypeToEnum<Index>::value, TensorShape({}),
+                               &output_rows_host, alloc_attr),
+        done);
+    perftools::gputools::DeviceMemoryBase output_rows_device(
+        const_cast<Index*>(segment_ids.flat<Index>().data()) +
+            (num_indices - 1),
+        sizeof(Index));
+    const bool status =
+        stream
+            ->ThenMemcpy(output_rows_host.scalar<Index>().data(),
+                         output_rows_device, sizeof(Index))
+            .ok();
+    OP_REQUIRES_ASYNC(
+        context, status,
+        errors::Internal("Failed to launch copy of output_rows from device "
+                         "to host."),
+        done);
+
+    auto create_and_check_output = [context, input, segment_ids,
+                                    output_rows_host, done]() {
+      const Index output_rows = output_rows_host.scalar<Index>()() + 1;
+      OP_REQUIRES_ASYNC(context, output_rows > 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, output_rows);
+
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+
+      auto output_flat = output->flat_outer_dims<T>();
+      functor::SegmentSumFunctor<T, Index>()(
+          context, context->eigen_device<GPUDevice>(), output_rows,
+          segment_ids.shape(), segment_ids.flat<Index>(), input.NumElements(),
+          input.flat<T>().data(), output_flat);
+      done();
+    };
+
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, create_and_check_output);
+  }
+};
+
+#define REGISTER_GPU_SORTED_KERNELS(type, index_type)                  \
+  REGISTER_KERNEL_BUILDER(Name("SegmentSum")                           \
+                              .Device(DEVICE_GPU)                      \
+                              .TypeConstraint<type>("T")               \
+                              .TypeConstraint<index_type>("Tindices"), \
+                          SegmentSumGPUOp<type, index_type>)
+
+#define REGISTER_GPU_SORTED_KERNELS_ALL(type) \
+  REGISTER_GPU_SORTED_KERNELS(type, int32);   \
+  REGISTER_GPU_SORTED_KERNELS(type, int64);
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_SORTED_KERNELS_ALL);
+#undef REGISTER_GPU_SORTED_KERNELS
+#undef REGISTER_GPU_SORTED_KERNELS_ALL
+#endif  // GOOGLE_CUDA
+
 namespace functor {
 
+namespace {
+
+// Combines the 'n' values of a row of the input into a row of the output of
+// the unsorted segment reductions on CPU, as vectorized Eigen expressions.
+template <typename T>
+struct UnsortedSegmentSumReducer {
+  static T Identity() { return T(0); }
+  static void Reduce(const T* input, int64 n, T* output) {
+    typename TTypes<T>::Flat out(output, n);
+    out += typename TTypes<T>::ConstFlat(input, n);
+  }
+};
+
+template <typename T>
+struct UnsortedSegmentMaxReducer {
+  static T Identity() { return std::numeric_limits<T>::lowest(); }
+  static void Reduce(const T* input, int64 n, T* output) {
+    typename TTypes<T>::Flat out(output, n);
+    out = out.cwiseMax(typename TTypes<T>::ConstFlat(input, n));
+  }
+};
+
+// The minimum number of input values reduced into a partial output of the
+// unsorted segment reductions.
+const int64 kMinValuesPerPartialOutput = 32 * 1024;
+
+// Reduces the rows of 'data' into the rows of 'output' given by
+// 'segment_ids', after checking them.
+//
+// The reduction is sharded across the CPU threads in one of three ways:
+// *) if the segment ids are sorted, each thread reduces the input rows of a
+//    range of output rows, which it finds by binary search;
+// *) if there are many more input rows than output rows, each thread reduces
+//    a block of input rows into its own partial output, and the partial
+//    outputs are then merged;
+// *) otherwise, each thread reduces the input rows of a range of output rows,
+//    scanning all the segment ids.
+template <typename T, typename Index, typename Reducer>
+void UnsortedSegmentReduceCpu(OpKernelContext* ctx, const Index output_rows,
+                              const TensorShape& segment_ids_shape,
+                              typename TTypes<Index>::ConstFlat segment_ids,
+                              const Index data_size, const T* data,
+                              typename TTypes<T, 2>::Tensor output) {
+  output.setConstant(Reducer::Identity());
+  if (data_size == 0) {
+    return;
+  }
+  const int64 N = segment_ids.dimension(0);
+  const int64 num_col = data_size / N;
+  std::vector<Index> ids(N);
+  bool sorted = true;
+  for (int64 i = 0; i < N; ++i) {
+    ids[i] = internal::SubtleMustCopy(segment_ids(i));
+    OP_REQUIRES(ctx, FastBoundsCheck(ids[i], output_rows),
+                errors::InvalidArgument(
+                    "segment_ids", SliceDebugString(segment_ids_shape, i),
+                    " = ", ids[i], " is out of range [0, ", output_rows, ")"));
+    sorted = sorted && (i == 0 || ids[i - 1] <= ids[i]);
+  }
+
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  T* output_data = output.data();
+  const int64 cost_per_output_row = (N / output_rows + 1) * num_col;
+
+  if (sorted) {
+    auto reduce_sorted = [&](int64 begin, int64 end) {
+      auto first = std::lower_bound(ids.begin(), ids.end(), begin);
+      auto last = std::lower_bound(first, ids.end(), end);
+      for (int64 i = first - ids.begin(); i < last - ids.begin(); ++i) {
+        Reducer::Reduce(data + i * num_col, num_col,
+                        output_data + ids[i] * num_col);
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, output_rows,
+          cost_per_output_row, reduce_sorted);
+    return;
+  }
+
+  const int64 num_partial_outputs = std::max<int64>(
+      1, std::min<int64>(worker_threads.num_threads,
+                         data_size / kMinValuesPerPartialOutput));
+  if (num_partial_outputs > 1 && output_rows * num_partial_outputs <= N) {
+    // The first block of rows is reduced into 'output' itself.
+    Tensor partial_outputs;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::value,
+                            TensorShape({num_partial_outputs - 1,
+                                         output_rows * num_col}),
+                            &partial_outputs));
+    auto partial_outputs_flat = partial_outputs.matrix<T>();
+    partial_outputs_flat.setConstant(Reducer::Identity());
+    const int64 rows_per_block =
+        (N + num_partial_outputs - 1) / num_partial_outputs;
+    auto reduce_blocks = [&](int64 begin, int64 end) {
+      for (int64 block = begin; block < end; ++block) {
+        T* block_output = block == 0 ? output_data
+                                     : &partial_outputs_flat(block - 1, 0);
+        const int64 last = std::min(N, (block + 1) * rows_per_block);
+        for (int64 i = block * rows_per_block; i < last; ++i) {
+          Reducer::Reduce(data + i * num_col, num_col,
+                          block_output + ids[i] * num_col);
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_partial_outputs, rows_per_block * num_col, reduce_blocks);
+    auto merge = [&](int64 begin, int64 end) {
+      for (int64 block = 0; block < num_partial_outputs - 1; ++block) {
+        Reducer::Reduce(&partial_outputs_flat(block, begin * num_col),
+                        (end - begin) * num_col, output_data + begin * num_col);
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, output_rows,
+          (num_partial_outputs - 1) * num_col, merge);
+    return;
+  }
+
+  auto reduce_unsorted = [&](int64 begin, int64 end) {
+    for (int64 i = 0; i < N; ++i) {
+      if (ids[i] >= begin && ids[i] < end) {
+        Reducer::Reduce(data + i * num_col, num_col,
+                        output_data + ids[i] * num_col);
+      }
+    }
+  };
+  // Each shard reads all the segment ids.
+  Shard(worker_threads.num_threads, worker_threads.workers, output_rows,
+        cost_per_output_row + N / output_rows + 1, reduce_unsorted);
+}
+
+}  // namespace
+
 // UnsortedSegmentSumFunctor implementation for CPUDevice.
-// todo: Remove duplicate code in UnsortedSegmentSumFunctor and UnsortedSegmentMaxFunctor.
 template <typename T, typename Index>
 struct UnsortedSegmentSumFunctor<CPUDevice, T, Index>
     : UnsortedSegmentBaseFunctor<CPUDevice, T, Index> {
@@ -239,20 +507,9 @@ struct UnsortedSegmentSumFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setZero();
-    if (data_size == 0) {
-      return;
-    }
-    const int64 N = segment_ids.dimension(0);
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
-    for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
-      OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
-                  errors::InvalidArgument(
-                      "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) += data_flat.template chip<0>(i);
-    }
+    UnsortedSegmentReduceCpu<T, Index, UnsortedSegmentSumReducer<T>>(
+        ctx, output_rows, segment_ids_shape, segment_ids, data_size, data,
+        output);
   }
 };
 // UnsortedSegmentMaxFunctor implementation for CPUDevice.
@@ -264,21 +521,9 @@ struct UnsortedSegmentMaxFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setConstant(std::numeric_limits<T>::lowest());
-    if (data_size == 0) {
-      return;
-    }
-    const int64 N = segment_ids.dimension(0);
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
-    for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
-      OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
-                  errors::InvalidArgument(
-                      "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) =
-          data_flat.template chip<0>(i).cwiseMax(output.template chip<0>(j));
-    }
+    UnsortedSegmentReduceCpu<T, Index, UnsortedSegmentMaxReducer<T>>(
+        ctx, output_rows, segment_ids_shape, segment_ids, data_size, data,
+        output);
   }
 };
 }  // namespace functor
@@ -855,4 +1100,291 @@ REGISTER_CPU_SPARSE_KERNELS(double);
 REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
+
+// The ways SparseEmbeddingCombine reduces the rows of a segment.
+enum class EmbeddingCombiner { kSum, kMean, kSqrtN };
+
+static Status GetEmbeddingCombiner(OpKernelConstruction* context,
+                                   EmbeddingCombiner* combiner) {
+  string name;
+  TF_RETURN_IF_ERROR(context->GetAttr("combiner", &name));
+  if (name == "sum") {
+    *combiner = EmbeddingCombiner::kSum;
+  } else if (name == "mean") {
+    *combiner = EmbeddingCombiner::kMean;
+  } else if (name == "sqrtn") {
+    *combiner = EmbeddingCombiner::kSqrtN;
+  } else {
+    return errors::InvalidArgument("Unknown combiner ", name);
+  }
+  return Status::OK();
+}
+
+// Checks the indices, segment_ids and weights inputs of SparseEmbeddingCombine
+// and of its gradient, and computes the position in indices where each
+// segment present in segment_ids starts, followed by the number of indices,
+// and the factor each segment is scaled by after the weighted sum of its rows.
+template <class T>
+static Status ComputeEmbeddingSegments(const Tensor& indices,
+                                       const Tensor& segment_ids,
+                                       const Tensor& weights,
+                                       EmbeddingCombiner combiner,
+                                       std::vector<int64>* starts,
+                                       std::vector<T>* scales) {
+  if (!TensorShapeUtils::IsVector(indices.shape())) {
+    return errors::InvalidArgument("indices should be a vector.");
+  }
+  if (!TensorShapeUtils::IsVector(segment_ids.shape())) {
+    return errors::InvalidArgument("segment_ids should be a vector.");
+  }
+  if (!TensorShapeUtils::IsVector(weights.shape())) {
+    return errors::InvalidArgument("weights should be a vector.");
+  }
+  const int64 num_indices = indices.NumElements();
+  if (num_indices != segment_ids.NumElements()) {
+    return errors::InvalidArgument(
+        "segment_ids and indices should have same size.");
+  }
+  const bool has_weights = weights.NumElements() > 0;
+  if (has_weights && num_indices != weights.NumElements()) {
+    return errors::InvalidArgument(
+        "weights should be empty or have the same size as indices.");
+  }
+
+  // The factor of a segment, given the sum of its weights, or of their
+  // squares for kSqrtN.
+  auto scale = [combiner](double denominator) {
+    if (combiner == EmbeddingCombiner::kSum) return T(1);
+    if (denominator == 0) return T(0);
+    return static_cast<T>(combiner == EmbeddingCombiner::kMean
+                              ? 1.0 / denominator
+                              : 1.0 / sqrt(denominator));
+  };
+  const auto segment_vec = segment_ids.vec<int32>();
+  const auto weights_vec = weights.vec<T>();
+  double denominator = 0;
+  for (int64 i = 0; i < num_indices; ++i) {
+    const int32 segment = internal::SubtleMustCopy(segment_vec(i));
+    if (i == 0 || segment != segment_vec(i - 1)) {
+      if (segment < 0) {
+        return errors::InvalidArgument("segment ids must be >= 0");
+      }
+      if (i > 0 && segment < segment_vec(i - 1)) {
+        return errors::InvalidArgument("segment ids are not increasing");
+      }
+      if (i > 0) {
+        scales->push_back(scale(denominator));
+      }
+      starts->push_back(i);
+      denominator = 0;
+    }
+    const double weight = has_weights ? weights_vec(i) : 1.0;
+    denominator += combiner == EmbeddingCombiner::kSqrtN ? weight * weight
+                                                          : weight;
+  }
+  if (num_indices > 0) {
+    scales->push_back(scale(denominator));
+  }
+  starts->push_back(num_indices);
+  return Status::OK();
+}
+
+// The number of indices ahead of the current one whose rows are prefetched
+// by SparseEmbeddingCombine and its gradient.
+static const int64 kEmbeddingPrefetchDistance = 4;
+
+// Gathers the rows of data at indices, and reduces the rows of each segment
+// to their weighted sum scaled by the combiner, in a single pass over the
+// indices without any intermediate tensor.  Segments are processed in
+// parallel.
+template <class T>
+class SparseEmbeddingCombineOp : public OpKernel {
+ public:
+  explicit SparseEmbeddingCombineOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetEmbeddingCombiner(context, &combiner_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& weights = context->input(3);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(data.shape()),
+                errors::InvalidArgument("data should be at least a vector."));
+
+    std::vector<int64> starts;
+    std::vector<T> scales;
+    OP_REQUIRES_OK(context,
+                   ComputeEmbeddingSegments(indices, segment_ids, weights,
+                                            combiner_, &starts, &scales));
+
+    const int64 num_indices = indices.NumElements();
+    const auto segment_vec = segment_ids.vec<int32>();
+    const int32 output_rows =
+        num_indices > 0 ? segment_vec(num_indices - 1) + 1 : 0;
+    TensorShape output_shape = data.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    auto output_flat = output->flat_outer_dims<T>();
+    // Rows of segments that have no indices are zero.
+    output_flat.setZero();
+    if (num_indices == 0) return;
+
+    const auto data_flat = data.flat_outer_dims<T>();
+    const auto indices_vec = indices.vec<Index>();
+    const auto weights_vec = weights.vec<T>();
+    const bool has_weights = weights.NumElements() > 0;
+    const Index num_rows = data_flat.dimension(0);
+    const int64 num_col = data_flat.dimension(1);
+    // The position of the first index that is out of range, if any.
+    std::atomic<int64> bad_position(num_indices);
+
+    auto reduce = [&](int64 begin, int64 end) {
+      for (int64 s = begin; s < end; ++s) {
+        auto out = output_flat.template chip<0>(segment_vec(starts[s]));
+        for (int64 i = starts[s]; i < starts[s + 1]; ++i) {
+          if (i + kEmbeddingPrefetchDistance < num_indices) {
+            const Index next = internal::SubtleMustCopy(
+                indices_vec(i + kEmbeddingPrefetchDistance));
+            if (FastBoundsCheck(next, num_rows)) {
+              port::prefetch<port::PREFETCH_HINT_T0>(
+                  reinterpret_cast<const char*>(&data_flat(next, 0)));
+            }
+          }
+          const Index index = internal::SubtleMustCopy(indices_vec(i));
+          if (!FastBoundsCheck(index, num_rows)) {
+            int64 bad = bad_position.load();
+            while (i < bad && !bad_position.compare_exchange_weak(bad, i)) {
+            }
+            return;
+          }
+          if (has_weights) {
+            out += data_flat.template chip<0>(index) * weights_vec(i);
+          } else {
+            out += data_flat.template chip<0>(index);
+          }
+        }
+        if (scales[s] != T(1)) {
+          out = out * scales[s];
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64 num_segments = scales.size();
+    const int64 cost_per_segment = num_indices / num_segments * num_col * 2;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_segments,
+          cost_per_segment, reduce);
+
+    const int64 bad = bad_position.load();
+    OP_REQUIRES(context, bad == num_indices,
+                errors::InvalidArgument("Bad: indices[", bad, "] == ",
+                                        indices_vec(bad), " out of range [0, ",
+                                        num_rows, ")"));
+  }
+
+ private:
+  typedef int32 Index;
+
+  EmbeddingCombiner combiner_;
+};
+
+#define REGISTER_CPU_SPARSE_KERNELS(type)                 \
+  REGISTER_KERNEL_BUILDER(Name("SparseEmbeddingCombine")  \
+                              .Device(DEVICE_CPU)         \
+                              .TypeConstraint<type>("T"), \
+                          SparseEmbeddingCombineOp<type>);
+REGISTER_CPU_SPARSE_KERNELS(float);
+REGISTER_CPU_SPARSE_KERNELS(double);
+#undef REGISTER_CPU_SPARSE_KERNELS
+
+// Computes the gradient of SparseEmbeddingCombine with respect to data: each
+// row of grad, scaled by the combiner, is added with the weight of each index
+// of its segment to the row of the output at that index.
+template <class T>
+class SparseEmbeddingCombineGradOp : public OpKernel {
+ public:
+  explicit SparseEmbeddingCombineGradOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetEmbeddingCombiner(context, &combiner_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& weights = context->input(3);
+    const Tensor& output_dim0 = context->input(4);
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad should be at least a vector."));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(output_dim0.shape()),
+                errors::InvalidArgument("output_dim0 should be a scalar."));
+
+    std::vector<int64> starts;
+    std::vector<T> scales;
+    OP_REQUIRES_OK(context,
+                   ComputeEmbeddingSegments(indices, segment_ids, weights,
+                                            combiner_, &starts, &scales));
+
+    const int64 num_indices = indices.NumElements();
+    const auto segment_vec = segment_ids.vec<int32>();
+    const Index M = internal::SubtleMustCopy(output_dim0.scalar<int32>()());
+    OP_REQUIRES(context, M >= 0,
+                errors::InvalidArgument("output_dim0 must be >= 0"));
+    TensorShape output_shape = grad.shape();
+    output_shape.set_dim(0, M);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    auto output_flat = output->flat_outer_dims<T>();
+    output_flat.setZero();
+    if (num_indices == 0) return;
+
+    const auto grad_flat = grad.flat_outer_dims<T>();
+    OP_REQUIRES(context, segment_vec(num_indices - 1) < grad_flat.dimension(0),
+                errors::InvalidArgument("Invalid number of segments"));
+    const auto indices_vec = indices.vec<Index>();
+    const auto weights_vec = weights.vec<T>();
+    const bool has_weights = weights.NumElements() > 0;
+
+    for (size_t s = 0; s < scales.size(); ++s) {
+      const auto in = grad_flat.template chip<0>(segment_vec(starts[s]));
+      for (int64 i = starts[s]; i < starts[s + 1]; ++i) {
+        if (i + kEmbeddingPrefetchDistance < num_indices) {
+          const Index next = internal::SubtleMustCopy(
+              indices_vec(i + kEmbeddingPrefetchDistance));
+          if (FastBoundsCheck(next, M)) {
+            port::prefetch<port::PREFETCH_HINT_T0>(
+                reinterpret_cast<const char*>(&output_flat(next, 0)));
+          }
+        }
+        const Index index = internal::SubtleMustCopy(indices_vec(i));
+        OP_REQUIRES(context, FastBoundsCheck(index, M),
+                    errors::InvalidArgument("Index ", index,
+                                            " out of range [0, ", M, ")."));
+        const T scale = has_weights ? weights_vec(i) * scales[s] : scales[s];
+        if (scale == T(1)) {
+          output_flat.template chip<0>(index) += in;
+        } else {
+          output_flat.template chip<0>(index) += in * scale;
+        }
+      }
+    }
+  }
+
+ private:
+  typedef int32 Index;
+
+  EmbeddingCombiner combiner_;
+};
+
+#define REGISTER_CPU_SPARSE_KERNELS(type)                    \
+  REGISTER_KERNEL_BUILDER(Name("SparseEmbeddingCombineGrad") \
+                              .Device(DEVICE_CPU)            \
+                              .TypeConstraint<type>("T"),    \
+                          SparseEmbeddingCombineGradOp<type>);
+REGISTER_CPU_SPARSE_KERNELS(float);
+REGISTER_CPU_SPARSE_KERNELS(double);
+#undef REGISTER_CPU_SPARSE_KERNELS
 }  // namespace tensorflow
@@ -63,13 +63,13 @@ __global__ void UnsortedSegmentSumCustomKernel(
     const Index output_outer_dim_size, const Index* segment_ids, const T* input,
     T* output) {
   const Index input_total_size = input_outer_dim_size * inner_dim_size;
-  const Index output_total_size = output_outer_dim_size * inner_dim_size;
   CUDA_1D_KERNEL_LOOP(input_index, input_total_size) {
     const Index input_segment_index = input_index / inner_dim_size;
     const Index segment_offset = input_index % inner_dim_size;
     const Index output_segment_index = segment_ids[input_segment_index];
 
-    if (output_segment_index < 0 || output_segment_index >= output_total_size) {
+    if (output_segment_index < 0 ||
+        output_segment_index >= output_outer_dim_size) {
       continue;
     }
     const Index output_index =
@@ -78,8 +78,97 @@ __global__ void UnsortedSegmentSumCustomKernel(
   }
 }
 
+// SortedSegmentSumCustomKernel sums the rows of 'input' into the rows of
+// 'output' given by the sorted 'segment_ids'. Each thread sums one column of a
+// tile of 'OuterDimTileSize' consecutive rows, keeping the partial sum of the
+// current segment in a register. Only the first and the last segments of a
+// tile may span other tiles and are accumulated atomically; the output of the
+// segments in between is written directly.
+template <typename T, typename Index, int OuterDimTileSize>
+__global__ void SortedSegmentSumCustomKernel(
+    const Index input_outer_dim_size, const Index inner_dim_size,
+    const Index output_outer_dim_size, const Index* segment_ids, const T* input,
+    T* output, const Index total_stripe_count) {
+  CUDA_1D_KERNEL_LOOP(stripe_index, total_stripe_count) {
+    const Index segment_offset = stripe_index % inner_dim_size;
+    const Index input_outer_dim_index_base =
+        stripe_index / inner_dim_size * Index(OuterDimTileSize);
+    const Index actual_stripe_height =
+        min(Index(OuterDimTileSize),
+            input_outer_dim_size - input_outer_dim_index_base);
+
+    const Index first_segment_id =
+        ldg(segment_ids + input_outer_dim_index_base);
+    Index last_segment_id = first_segment_id;
+    T sum = T(0);
+    for (Index j = 0; j < actual_stripe_height; j++) {
+      const Index segment_id =
+          ldg(segment_ids + input_outer_dim_index_base + j);
+      if (segment_id != last_segment_id) {
+        if (last_segment_id >= 0 && last_segment_id < output_outer_dim_size) {
+          T* dest = output + last_segment_id * inner_dim_size + segment_offset;
+          if (last_segment_id == first_segment_id) {
+            AccumulateInto<T>(dest, sum);
+          } else {
+            *dest = sum;
+          }
+        }
+        sum = T(0);
+        last_segment_id = segment_id;
+      }
+      sum += ldg(input + (input_outer_dim_index_base + j) * inner_dim_size +
+                 segment_offset);
+    }
+    if (last_segment_id >= 0 && last_segment_id < output_outer_dim_size) {
+      AccumulateInto<T>(
+          output + last_segment_id * inner_dim_size + segment_offset, sum);
+    }
+  }
+}
+
 namespace functor {
 
+// SegmentSumFunctor implementation for GPUDevice.
+template <typename T, typename Index>
+void SegmentSumFunctor<T, Index>::operator()(
+    OpKernelContext* ctx, const GPUDevice& d, const Index output_rows,
+    const TensorShape& segment_ids_shape,
+    typename TTypes<Index>::ConstFlat segment_ids, const Index data_size,
+    const T* data, typename TTypes<T, 2>::Tensor output) {
+  if (output.size() == 0) {
+    return;
+  }
+  // Set 'output' to zeros.
+  CudaLaunchConfig config = GetCudaLaunchConfig(output.size(), d);
+  SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      output.size(), output.data());
+  if (data_size == 0 || segment_ids_shape.num_elements() == 0) {
+    return;
+  }
+
+  // Launch kernel to compute sorted segment sum.
+  // Notes:
+  // *) 'input_total_size' is the total number of elements to process.
+  // *) 'segment_ids.shape' is a prefix of data's shape.
+  // *) 'input_outer_dim_size' is the total number of segments to process.
+  // *) 'total_stripe_count' is the number of tiles of a column, one per
+  //    thread.
+  const int OuterDimTileSize = 8;
+  const Index input_total_size = data_size;
+  const Index input_outer_dim_size = segment_ids.dimension(0);
+  const Index input_inner_dim_size = input_total_size / input_outer_dim_size;
+  const Index input_outer_dim_num_stripe =
+      Eigen::divup(input_outer_dim_size, Index(OuterDimTileSize));
+  const Index total_stripe_count =
+      input_inner_dim_size * input_outer_dim_num_stripe;
+
+  config = GetCudaLaunchConfig(total_stripe_count, d);
+  SortedSegmentSumCustomKernel<T, Index, OuterDimTileSize><<<
+      config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      input_outer_dim_size, input_inner_dim_size, output_rows,
+      segment_ids.data(), data, output.data(), total_stripe_count);
+}
+
 // UnsortedSegmentSumFunctor implementation for GPUDevice.
 template <typename T, typename Index>
 struct UnsortedSegmentSumFunctor<GPUDevice, T, Index>: UnsortedSegmentBaseFunctor<GPUDevice, T, Index> {
@@ -131,6 +220,18 @@ TF_CALL_complex128(DEFINE_GPU_SPECS);
 #undef DEFINE_GPU_SPECS
 #undef DEFINE_GPU_SPECS_INDEX
 
+#define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index) \
+  template struct SegmentSumFunctor<T, Index>
+
+#define DEFINE_SORTED_GPU_SPECS(T)         \
+  DEFINE_SORTED_GPU_SPECS_INDEX(T, int32); \
+  DEFINE_SORTED_GPU_SPECS_INDEX(T, int64);
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_SORTED_GPU_SPECS);
+
+#undef DEFINE_SORTED_GPU_SPECS
+#undef DEFINE_SORTED_GPU_SPECS_INDEX
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -112,6 +112,49 @@ BM_Reduce_Arg(16, 8, 2);
 BM_Reduce_Arg(64, 32, 2);
 BM_Reduce_Arg(4096, 32, 2);
 BM_Reduce_Arg(4096, 128, 2);
+BM_Reduce_Arg(65536, 128, 4);
+
+static void UnsortedSegmentSumHelper(int iters, int num_rows,
+                                     int num_segments) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kDim1 = 128;
+  Tensor input(DT_FLOAT, TensorShape({num_rows, kDim1}));
+  input.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_rows; ++i) {
+    segment_ids_flat(i) = (i * 31) % num_segments;
+  }
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments_t))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows * kDim1 *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_UnsortedSegmentSum_FewSegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, 64);
+}
+
+static void BM_UnsortedSegmentSum_ManySegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, num_rows / 2);
+}
+
+BENCHMARK(BM_UnsortedSegmentSum_FewSegments)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnsortedSegmentSum_ManySegments)->Arg(1000)->Arg(100000);
 
 static void SparseSegmentMeanGradHelper(int iters, float uniqueness, int size) {
   testing::StopTiming();
@@ -39,6 +39,11 @@ static void GetRendezvousKey(const string& key_prefix,
                      frame_iter.iter_id);
 }
 
+// Sends and Recvs outside of loops, which are most of them, all run in the
+// root frame, so their kernels parse its key once instead of formatting and
+// parsing it again on every step.
+static const FrameAndIter kRootFrameIter(0, 0);
+
 SendOp::SendOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
   string send_device;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("send_device", &send_device));
@@ -52,17 +57,22 @@ SendOp::SendOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
   OP_REQUIRES_OK(ctx, ctx->GetAttr("tensor_name", &tensor_name));
   key_prefix_ = GetRendezvousKeyPrefix(send_device, recv_device,
                                        send_device_incarnation, tensor_name);
+  GetRendezvousKey(key_prefix_, kRootFrameIter, &parsed_key_.buf_);
+  OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed_key_.buf_, &parsed_key_));
 }
 
 void SendOp::Compute(OpKernelContext* ctx) {
   OP_REQUIRES(
       ctx, ctx->rendezvous() != nullptr,
       errors::Internal("Op kernel context needs to provide a rendezvous."));
+  const Rendezvous::ParsedKey* key = &parsed_key_;
   Rendezvous::ParsedKey parsed;
-  GetRendezvousKey(key_prefix_, ctx->frame_iter(), &parsed.buf_);
-  VLOG(2) << "Send " << parsed.buf_;
-
-  OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed.buf_, &parsed));
+  if (!(ctx->frame_iter() == kRootFrameIter)) {
+    GetRendezvousKey(key_prefix_, ctx->frame_iter(), &parsed.buf_);
+    OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed.buf_, &parsed));
+    key = &parsed;
+  }
+  VLOG(2) << "Send " << key->buf_;
 
   // The device context may be passed between the Send/Recv
   // boundary, so that the device context used to produce the Tensor
@@ -71,7 +81,7 @@ void SendOp::Compute(OpKernelContext* ctx) {
   Rendezvous::Args args;
   args.device_context = ctx->op_device_context();
   args.alloc_attrs = ctx->input_alloc_attr(0);
-  OP_REQUIRES_OK(ctx, ctx->rendezvous()->Send(parsed, args, ctx->input(0),
+  OP_REQUIRES_OK(ctx, ctx->rendezvous()->Send(*key, args, ctx->input(0),
                                               ctx->is_input_dead()));
 }
 
@@ -101,17 +111,23 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   OP_REQUIRES_OK(ctx, ctx->GetAttr("tensor_name", &tensor_name));
   key_prefix_ = GetRendezvousKeyPrefix(send_device, recv_device,
                                        send_device_incarnation, tensor_name);
+  GetRendezvousKey(key_prefix_, kRootFrameIter, &parsed_key_.buf_);
+  OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed_key_.buf_, &parsed_key_));
 }
 
 void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   OP_REQUIRES(
       ctx, ctx->rendezvous() != nullptr,
       errors::Internal("Op kernel context needs to provide a rendezvous."));
+  const Rendezvous::ParsedKey* key = &parsed_key_;
   Rendezvous::ParsedKey parsed;
-  GetRendezvousKey(key_prefix_, ctx->frame_iter(), &parsed.buf_);
-  VLOG(2) << "Recv " << parsed.buf_;
-
-  OP_REQUIRES_OK_ASYNC(ctx, Rendezvous::ParseKey(parsed.buf_, &parsed), done);
+  if (!(ctx->frame_iter() == kRootFrameIter)) {
+    GetRendezvousKey(key_prefix_, ctx->frame_iter(), &parsed.buf_);
+    OP_REQUIRES_OK_ASYNC(ctx, Rendezvous::ParseKey(parsed.buf_, &parsed),
+                         done);
+    key = &parsed;
+  }
+  VLOG(2) << "Recv " << key->buf_;
 
   Rendezvous::Args args;
   args.device_context = ctx->op_device_context();
@@ -136,7 +152,7 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
         done();
       },
       std::move(done), _1, _2, _3, _4, _5);
-  ctx->rendezvous()->RecvAsync(parsed, args, std::move(done_cb));
+  ctx->rendezvous()->RecvAsync(*key, args, std::move(done_cb));
 }
 
 REGISTER_KERNEL_BUILDER(Name("_Recv").Device(DEVICE_CPU), RecvOp);
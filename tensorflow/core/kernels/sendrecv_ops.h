@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_SENDRECV_OPS_H_
 
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -28,6 +29,8 @@ class SendOp : public OpKernel {
 
  private:
   string key_prefix_;
+  // The key of the root frame, where most Sends run, parsed once.
+  Rendezvous::ParsedKey parsed_key_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(SendOp);
 };
@@ -39,6 +42,8 @@ class RecvOp : public AsyncOpKernel {
 
  private:
   string key_prefix_;
+  // The key of the root frame, where most Recvs run, parsed once.
+  Rendezvous::ParsedKey parsed_key_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
 };
@@ -121,17 +121,19 @@ class SparseConcatOp : public OpKernel {
       }
     }
 
+    thread::ThreadPool* pool =
+        context->device()->tensorflow_cpu_worker_threads()->workers;
     std::vector<sparse::SparseTensor> sp_inputs;
     for (int i = 0; i < N; ++i) {
       const TensorShape current_shape(shapes[i].vec<int64>());
       sp_inputs.emplace_back(tensor::DeepCopy(inds[i]),
                              tensor::DeepCopy(vals[i]), current_shape,
                              std_order);
-      sp_inputs[i].Reorder<T>(concat_order);
+      sp_inputs[i].Reorder<T>(concat_order, pool);
     }
 
     sparse::SparseTensor concat = sparse::SparseTensor::Concat<T>(sp_inputs);
-    concat.Reorder<T>(std_order);
+    concat.Reorder<T>(std_order, pool);
 
     context->set_output(0, concat.indices());
     context->set_output(1, concat.values());
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_matmul_op.h"
 
+#include <algorithm>
 #include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/device.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 #ifdef TENSORFLOW_USE_LIBXSMM
 #include "include/libxsmm_intrinsics_x86.h"
 #include "include/libxsmm_malloc.h"
@@ -748,6 +750,90 @@ inline void GEPP(
 #undef STORE
 #undef FMA
 
+// Converts the 'size' bfloat16 values of 'src' to float in 'dst', sharded
+// across the CPU threads.
+void ParallelBFloat16ToFloat(const DeviceBase::CpuWorkerThreads& worker_threads,
+                             const bfloat16* src, float* dst, int64 size) {
+  Shard(worker_threads.num_threads, worker_threads.workers, size,
+        /*cost_per_unit=*/1, [src, dst](int64 begin, int64 end) {
+          BFloat16ToFloat(src + begin, dst + begin, end - begin);
+        });
+}
+
+// The float panels of the bfloat16 right hand side of a dense
+// multiplication, which are converted on the fly, take up to this many bytes
+// so that they stay in the cache of the thread multiplying them.
+static const int64 kBFloat16PanelBytes = 128 * 1024;
+
+// The dense multiplications with a bfloat16 right hand side and up to this
+// many output rows are done by panels, their cost being dominated by reading
+// the right hand side. The larger ones are compute bound, and the right hand
+// side is converted to float up front instead.
+static const int64 kMaxRowsForBFloat16Panels = 128;
+
+// Multiplies the float matrix 'a' by the bfloat16 matrix 'b' into 'out',
+// accumulating in float. The columns of 'out' are computed by panels, each of
+// which converts the matching columns of 'b' to float in a buffer small enough
+// to stay in cache, so that 'b' is only read once, at half the size of a float
+// matrix. The panels are sharded across the CPU threads.
+void DenseMatMulBFloat16Panels(
+    const DeviceBase::CpuWorkerThreads& worker_threads, const Tensor& a,
+    bool transpose_a, const Tensor& b, bool transpose_b,
+    TTypes<float>::Matrix out) {
+  typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      RowMajorMatrix;
+  typedef Eigen::Map<const RowMajorMatrix> ConstRowMajorMap;
+  typedef Eigen::Map<RowMajorMatrix, Eigen::Unaligned, Eigen::OuterStride<>>
+      StridedRowMajorMap;
+
+  const int64 m = out.dimension(0);
+  const int64 n = out.dimension(1);
+  const int64 k = transpose_b ? b.dim_size(1) : b.dim_size(0);
+  const ConstRowMajorMap a_map(a.flat<float>().data(), a.dim_size(0),
+                               a.dim_size(1));
+  const bfloat16* b_data = b.flat<bfloat16>().data();
+  float* out_data = out.data();
+
+  // The panels are a multiple of 16 columns wide, so that the conversions
+  // and the multiplications are vectorized.
+  int64 panel_cols = kBFloat16PanelBytes / (k * sizeof(float));
+  panel_cols = std::max<int64>(16, panel_cols / 16 * 16);
+  const int64 num_panels = (n + panel_cols - 1) / panel_cols;
+
+  auto multiply_panels = [&](int64 begin, int64 end) {
+    std::vector<float> panel(k * panel_cols);
+    for (int64 p = begin; p < end; ++p) {
+      const int64 col = p * panel_cols;
+      const int64 cols = std::min(panel_cols, n - col);
+      StridedRowMajorMap out_panel(out_data + col, m, cols,
+                                   Eigen::OuterStride<>(n));
+      if (transpose_b) {
+        // The panel is made of consecutive rows of 'b'.
+        BFloat16ToFloat(b_data + col * k, panel.data(), cols * k);
+        const ConstRowMajorMap panel_map(panel.data(), cols, k);
+        if (transpose_a) {
+          out_panel.noalias() = a_map.transpose() * panel_map.transpose();
+        } else {
+          out_panel.noalias() = a_map * panel_map.transpose();
+        }
+      } else {
+        for (int64 row = 0; row < k; ++row) {
+          BFloat16ToFloat(b_data + row * n + col, panel.data() + row * cols,
+                          cols);
+        }
+        const ConstRowMajorMap panel_map(panel.data(), k, cols);
+        if (transpose_a) {
+          out_panel.noalias() = a_map.transpose() * panel_map;
+        } else {
+          out_panel.noalias() = a_map * panel_map;
+        }
+      }
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_panels,
+        /*cost_per_unit=*/(m + 1) * k * panel_cols, multiply_panels);
+}
+
 }  // namespace
 
 template <typename TL, typename TR>
@@ -985,19 +1071,27 @@ class SparseMatMulOp : public OpKernel {
     std::unique_ptr<Tensor> a_float;
     std::unique_ptr<Tensor> b_float;
     if (!a_is_sparse_ && !b_is_sparse_) {
+      const DeviceBase::CpuWorkerThreads& worker_threads =
+          *ctx->device()->tensorflow_cpu_worker_threads();
+      // A float input, typically activations, multiplied by bfloat16 weights.
+      if (std::is_same<TL, float>::value && std::is_same<TR, bfloat16>::value &&
+          m <= kMaxRowsForBFloat16Panels) {
+        DenseMatMulBFloat16Panels(worker_threads, a, transpose_a_, b,
+                                  transpose_b_, out);
+        return;
+      }
       auto left = &a;
       auto right = &b;
-      // TODO(agarwal): multi-thread the conversions from bfloat16 to float.
       if (std::is_same<TL, bfloat16>::value) {
         a_float.reset(new Tensor(DT_FLOAT, a.shape()));
-        BFloat16ToFloat(a.flat<bfloat16>().data(),
-                        a_float->flat<float>().data(), a.NumElements());
+        ParallelBFloat16ToFloat(worker_threads, a.flat<bfloat16>().data(),
+                                a_float->flat<float>().data(), a.NumElements());
         left = a_float.get();
       }
       if (std::is_same<TR, bfloat16>::value) {
         b_float.reset(new Tensor(DT_FLOAT, b.shape()));
-        BFloat16ToFloat(b.flat<bfloat16>().data(),
-                        b_float->flat<float>().data(), b.NumElements());
+        ParallelBFloat16ToFloat(worker_threads, b.flat<bfloat16>().data(),
+                                b_float->flat<float>().data(), b.NumElements());
         right = b_float.get();
       }
       Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> dim_pair;
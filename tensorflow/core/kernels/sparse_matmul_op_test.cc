@@ -208,6 +208,10 @@ BM_SPARSE_BFLOAT16_FLOAT(2048, 2048, 2048, 85, 0, false, false);
 BM_SPARSE_BFLOAT16_FLOAT(2048, 2048, 2048, 99, 0, false, false);
 BM_SPARSE_FLOAT_BFLOAT16(2048, 2048, 2048, 85, 0, false, false);
 BM_SPARSE_FLOAT_BFLOAT16(2048, 2048, 2048, 99, 0, false, false);
+BM_SPARSE_FLOAT_BFLOAT16(1, 4096, 4096, 0, 0, false, false);
+BM_SPARSE_FLOAT_BFLOAT16(32, 4096, 4096, 0, 0, false, false);
+BM_SPARSE_FLOAT_BFLOAT16(32, 4096, 4096, 0, 0, false, true);
+BM_SPARSE_FLOAT(32, 4096, 4096, 0, 0, false, false);
 
 static Graph* MultiSparseMatMul(int m, int n, int d, float sparsity_1,
                                 float sparsity_2, int copies) {
@@ -19,16 +19,56 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+// The nonzeros of the sparse operand of a SparseTensorDenseMatMul grouped by
+// the row of the output they contribute to, in compressed sparse row form.
+template <typename Tindices>
+struct SparseTensorDenseMatMulRows {
+  // The nonzeros of output row m are row_starts[m] to row_starts[m + 1] of
+  // entries and columns, in the order of a_indices.
+  std::vector<int64> row_starts;
+  // The position of each nonzero in a_indices and a_values.
+  std::vector<int64> entries;
+  // The row of the (maybe adjoint) dense operand each nonzero multiplies.
+  std::vector<Tindices> columns;
+};
+
+// Groups the nonzeros of a_indices by output row, checking that they are in
+// a matrix of out_rows x lhs_right once a is adjoint if ADJ_A.
+template <typename Tindices, bool ADJ_A>
+Status BuildSparseTensorDenseMatMulRows(
+    typename TTypes<Tindices>::ConstMatrix a_indices, int64 out_rows,
+    int64 lhs_right, SparseTensorDenseMatMulRows<Tindices>* rows);
+
+// Computes out = a * b with the nonzeros of a grouped by rows, where a and b
+// are adjoint if ADJ_A and ADJ_B.
+template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
+void MultiplySparseTensorDenseMatMulRows(
+    const CPUDevice& d, const SparseTensorDenseMatMulRows<Tindices>& rows,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b,
+    typename TTypes<T>::Matrix out);
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Tindices>
 class SparseTensorDenseMatMulOp : public OpKernel {
  public:
@@ -139,14 +179,19 @@ class SparseTensorDenseMatMulOp : public OpKernel {
                                              TensorShape({0}), &scratch));
     }
 
-#define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                        \
-  if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                        \
-    Status functor_status = functor::SparseTensorDenseMatMulFunctor<       \
-        Device, T, Tindices, ADJ_A,                                        \
-        ADJ_B>::Compute(ctx->eigen_device<Device>(), out->matrix<T>(),     \
-                        a_indices->matrix<Tindices>(), a_values->vec<T>(), \
-                        b->matrix<T>(), scratch.vec<T>());                 \
-    OP_REQUIRES_OK(ctx, functor_status);                                   \
+#define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                          \
+  if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                          \
+    if (std::is_same<Device, CPUDevice>::value) {                            \
+      OP_REQUIRES_OK(ctx, (ComputeOnCpu<ADJ_A, ADJ_B>(ctx, *a_indices,       \
+                                                      *a_values, *b, out))); \
+    } else {                                                                 \
+      Status functor_status = functor::SparseTensorDenseMatMulFunctor<       \
+          Device, T, Tindices, ADJ_A,                                        \
+          ADJ_B>::Compute(ctx->eigen_device<Device>(), out->matrix<T>(),     \
+                          a_indices->matrix<Tindices>(), a_values->vec<T>(), \
+                          b->matrix<T>(), scratch.vec<T>());                 \
+      OP_REQUIRES_OK(ctx, functor_status);                                   \
+    }                                                                        \
   }
 
     MAYBE_ADJOINT(false, false);
@@ -158,8 +203,57 @@ class SparseTensorDenseMatMulOp : public OpKernel {
   }
 
  private:
+  typedef functor::SparseTensorDenseMatMulRows<Tindices> Rows;
+
+  // Computes out on the CPU from the nonzeros of a grouped by output row.
+  // The grouping of the last a_indices is kept and reused while a_indices
+  // and the shape of a do not change, as when a is a constant, so that only
+  // the multiplication runs again.
+  template <bool ADJ_A, bool ADJ_B>
+  Status ComputeOnCpu(OpKernelContext* ctx, const Tensor& a_indices,
+                      const Tensor& a_values, const Tensor& b, Tensor* out) {
+    const int64 out_rows = out->dim_size(0);
+    const int64 lhs_right = ADJ_B ? b.dim_size(1) : b.dim_size(0);
+    std::shared_ptr<const Rows> rows;
+    {
+      mutex_lock l(mu_);
+      if (cached_rows_ != nullptr && cached_out_rows_ == out_rows &&
+          cached_lhs_right_ == lhs_right &&
+          cached_indices_.shape() == a_indices.shape() &&
+          memcmp(cached_indices_.tensor_data().data(),
+                 a_indices.tensor_data().data(),
+                 a_indices.tensor_data().size()) == 0) {
+        rows = cached_rows_;
+      }
+    }
+    if (rows == nullptr) {
+      std::shared_ptr<Rows> new_rows(new Rows);
+      TF_RETURN_IF_ERROR(
+          (functor::BuildSparseTensorDenseMatMulRows<Tindices, ADJ_A>(
+              a_indices.matrix<Tindices>(), out_rows, lhs_right,
+              new_rows.get())));
+      Tensor indices_copy = tensor::DeepCopy(a_indices);
+      mutex_lock l(mu_);
+      cached_indices_ = indices_copy;
+      cached_out_rows_ = out_rows;
+      cached_lhs_right_ = lhs_right;
+      cached_rows_ = new_rows;
+      rows = new_rows;
+    }
+    functor::MultiplySparseTensorDenseMatMulRows<T, Tindices, ADJ_A, ADJ_B>(
+        ctx->eigen_device<CPUDevice>(), *rows, a_values.vec<T>(),
+        b.matrix<T>(), out->matrix<T>());
+    return Status::OK();
+  }
+
   bool adjoint_a_;
   bool adjoint_b_;
+
+  mutex mu_;
+  Tensor cached_indices_ GUARDED_BY(mu_);
+  int64 cached_out_rows_ GUARDED_BY(mu_) = 0;
+  int64 cached_lhs_right_ GUARDED_BY(mu_) = 0;
+  std::shared_ptr<const Rows> cached_rows_ GUARDED_BY(mu_);
 };
 
 #define REGISTER_CPU(TypeT, TypeIndex)           \
@@ -247,78 +341,133 @@ Status MOutOfBoundsError(int64 m, std::size_t i, int lhs_index_a,
 }
 }  // namespace
 
+template <typename Tindices, bool ADJ_A>
+Status BuildSparseTensorDenseMatMulRows(
+    typename TTypes<Tindices>::ConstMatrix a_indices, int64 out_rows,
+    int64 lhs_right, SparseTensorDenseMatMulRows<Tindices>* rows) {
+  const std::size_t nnz = a_indices.dimension(0);
+  const int lhs_index_a = ADJ_A ? 1 : 0;
+  const int rhs_index_a = ADJ_A ? 0 : 1;
+
+  // Count the nonzeros of each row, keeping the rows that were checked since
+  // a_indices may change while it is read.
+  std::vector<Tindices> nonzero_rows(nnz);
+  rows->row_starts.assign(out_rows + 1, 0);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    if (!FastBoundsCheck(m, out_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, out_rows);
+    }
+    nonzero_rows[i] = m;
+    ++rows->row_starts[m + 1];
+  }
+  for (int64 m = 0; m < out_rows; ++m) {
+    rows->row_starts[m + 1] += rows->row_starts[m];
+  }
+
+  // Then place the nonzeros after the previous ones of their row.
+  std::vector<int64> next(rows->row_starts.begin(),
+                          rows->row_starts.end() - 1);
+  rows->entries.resize(nnz);
+  rows->columns.resize(nnz);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    const int64 position = next[nonzero_rows[i]]++;
+    rows->entries[position] = i;
+    rows->columns[position] = k;
+  }
+  return Status::OK();
+}
+
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
-struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
-  // Vectorize certain operations above this size.
-  static const std::size_t kNumVectorize = 32;
+void MultiplySparseTensorDenseMatMulRows(
+    const CPUDevice& d, const SparseTensorDenseMatMulRows<Tindices>& rows,
+    typename TTypes<T>::ConstVec a_values, typename TTypes<T>::ConstMatrix b,
+    typename TTypes<T>::Matrix out) {
+  // Vectorize the updates of output rows of at least this size.
+  static const int64 kNumVectorize = 32;
+  // The output rows are updated by tiles of this many columns, so that the
+  // tile stays in the L1 cache while the nonzeros of the row add to it.
+  static const int64 kColumnTile = 1024;
+
+  const int64 out_rows = out.dimension(0);
+  const int64 out_cols = out.dimension(1);
+
+  // The rows of the adjoint of b are its columns, so transpose and conjugate
+  // b once to read them contiguously.
+  Eigen::Tensor<T, 2, Eigen::RowMajor> adjoint_b;
+  const T* b_rows = b.data();
+  if (ADJ_B) {
+    Eigen::array<int, 2> shuffle{{1, 0}};
+    adjoint_b.resize(b.dimension(1), b.dimension(0));
+    adjoint_b.device(d) = b.shuffle(shuffle).conjugate();
+    b_rows = adjoint_b.data();
+  }
+
+  typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Tile;
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstTile;
+  auto work = [&rows, &a_values, &out, b_rows, out_cols](int64 begin,
+                                                         int64 end) {
+    for (int64 m = begin; m < end; ++m) {
+      const int64 row_begin = rows.row_starts[m];
+      const int64 row_end = rows.row_starts[m + 1];
+      T* out_row = &out(m, 0);
+      for (int64 n = 0; n < out_cols; n += kColumnTile) {
+        const int64 tile_cols = std::min(kColumnTile, out_cols - n);
+        if (tile_cols < kNumVectorize) {
+          for (int64 j = row_begin; j < row_end; ++j) {
+            const T a_value = ADJ_A ? MaybeConj(a_values(rows.entries[j]))
+                                    : a_values(rows.entries[j]);
+            const T* b_row = b_rows + rows.columns[j] * out_cols + n;
+            for (int64 c = 0; c < tile_cols; ++c) {
+              out_row[n + c] += a_value * b_row[c];
+            }
+          }
+        } else {
+          Tile out_tile(out_row + n, tile_cols);
+          for (int64 j = row_begin; j < row_end; ++j) {
+            const T a_value = ADJ_A ? MaybeConj(a_values(rows.entries[j]))
+                                    : a_values(rows.entries[j]);
+            out_tile +=
+                a_value *
+                ConstTile(b_rows + rows.columns[j] * out_cols + n, tile_cols);
+          }
+        }
+      }
+    }
+  };
+
+  out.device(d) = out.constant(T(0));
+  const double nonzeros_per_row =
+      static_cast<double>(rows.entries.size()) / std::max<int64>(out_rows, 1);
+  d.parallelFor(out_rows,
+                Eigen::TensorOpCost(nonzeros_per_row * out_cols * sizeof(T),
+                                    out_cols * sizeof(T),
+                                    nonzeros_per_row * out_cols *
+                                        Eigen::TensorOpCost::MulCost<T>()),
+                work);
+}
 
+template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
+struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
                         typename TTypes<T>::ConstVec a_values,
                         typename TTypes<T>::ConstMatrix b,
                         typename TTypes<T>::Vec scratch) {
-    const std::size_t nnz = a_values.size();
-    const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
-    const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
-    const int lhs_index_a = ADJ_A ? 1 : 0;
-    const int rhs_index_a = ADJ_A ? 0 : 1;
-
-    out.setZero();
-
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
-
-    if (rhs_right < kNumVectorize) {
-      // Disable vectorization if the RHS of output is too small
-      auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
-
-      for (std::size_t i = 0; i < nnz; ++i) {
-        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-        if (!FastBoundsCheck(k, lhs_right)) {
-          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-        }
-        if (!FastBoundsCheck(m, out.dimension(0))) {
-          return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-        }
-        const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-        for (std::size_t n = 0; n < rhs_right; ++n) {
-          const T b_value = maybe_adjoint_b(k, n);
-          out(m, n) += a_value * b_value;
-        }
-      }
-    } else {
-      // Vectorization via Eigen.
-      const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k) * a_value;                  \
-  }
-
-      if (ADJ_B) {
-        // Perform transpose and conjugation on B once, since we chip out B's
-        // columns in the nnz loop.
-        Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
-        Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-            b.swap_layout().shuffle(shuffle).conjugate();
-        LOOP_NNZ(col_major_conj_b);
-      } else {
-        LOOP_NNZ(b);
-      }
-#undef LOOP_NNZ
-    }
+    const int64 lhs_right = ADJ_B ? b.dimension(1) : b.dimension(0);
+    SparseTensorDenseMatMulRows<Tindices> rows;
+    TF_RETURN_IF_ERROR((BuildSparseTensorDenseMatMulRows<Tindices, ADJ_A>(
+        a_indices, out.dimension(0), lhs_right, &rows)));
+    MultiplySparseTensorDenseMatMulRows<T, Tindices, ADJ_A, ADJ_B>(
+        d, rows, a_values, b, out);
     return Status::OK();
   }
 };
@@ -16,13 +16,16 @@ limitations under the License.
 #include <deque>
 #include <vector>
 
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -30,16 +33,31 @@ namespace {
 
 class Buffer : public ResourceBase {
  public:
-  explicit Buffer() {}
+  // A capacity or memory_limit of 0 means unbounded.
+  Buffer(int64 capacity, int64 memory_limit)
+      : capacity_(capacity), memory_limit_(memory_limit) {}
 
   typedef std::vector<Tensor> Tuple;
 
-  // the Buffer takes ownership of the Tuple
-  void Put(Tuple* tuple) {
+  // the Buffer takes ownership of the Tuple.  Blocks while the buffer is
+  // full.
+  Status Put(Tuple* tuple) {
+    const int64 tuple_bytes = GetTupleBytes(*tuple);
+    if (memory_limit_ > 0 && tuple_bytes > memory_limit_) {
+      return errors::ResourceExhausted(
+          "Attempted to insert tensors with combined size of ", tuple_bytes,
+          " bytes into Staging Area with a memory limit of ", memory_limit_,
+          " bytes.");
+    }
     mutex_lock l(mu_);
+    while (IsFull(tuple_bytes)) {
+      full_cond_var_.wait(l);
+    }
+    current_bytes_ += tuple_bytes;
     buf_.push_back(std::move(*tuple));
     non_empty_cond_var_.notify_one();  // maybe possible to optimize by reducing
                                        // how often this signal is sent
+    return Status::OK();
   }
 
   void Get(Tuple* tuple) {  // TODO(zhifengc): Support cancellation.
@@ -50,30 +68,75 @@ class Buffer : public ResourceBase {
 
     *tuple = std::move(buf_.front());
     buf_.pop_front();
+    current_bytes_ -= GetTupleBytes(*tuple);
+    if (IsBounded()) full_cond_var_.notify_all();
+  }
+
+  size_t Size() {
+    mutex_lock l(mu_);
+    return buf_.size();
+  }
+
+  void Clear() {
+    mutex_lock l(mu_);
+    buf_.clear();
+    current_bytes_ = 0;
+    if (IsBounded()) full_cond_var_.notify_all();
   }
 
   string DebugString() {
     mutex_lock l(mu_);
-    return strings::StrCat("Staging size: ", buf_.size());
+    return strings::StrCat("Staging size: ", buf_.size(), ", bytes: ",
+                           current_bytes_);
   }
 
  private:
+  static int64 GetTupleBytes(const Tuple& tuple) {
+    int64 bytes = 0;
+    for (const Tensor& tensor : tuple) {
+      bytes += tensor.TotalBytes();
+    }
+    return bytes;
+  }
+
+  bool IsBounded() const { return capacity_ > 0 || memory_limit_ > 0; }
+
+  // Whether a tuple of `tuple_bytes` bytes has to wait for room.  A buffer
+  // that is not empty below its memory limit still takes any tuple that fits
+  // the limit on its own, so that a large tuple cannot wait forever.
+  bool IsFull(int64 tuple_bytes) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (capacity_ > 0 && buf_.size() >= static_cast<size_t>(capacity_)) {
+      return true;
+    }
+    return memory_limit_ > 0 && !buf_.empty() &&
+           current_bytes_ + tuple_bytes > memory_limit_;
+  }
+
+  const int64 capacity_;
+  const int64 memory_limit_;
+
   mutex mu_;
   condition_variable non_empty_cond_var_;
+  condition_variable full_cond_var_;
   std::deque<Tuple> buf_ GUARDED_BY(mu_);
+  int64 current_bytes_ GUARDED_BY(mu_) = 0;
 };
 
-Status CreateBuffer(Buffer** ret) {
-  *ret = new Buffer;
-  return Status::OK();
-}
-
 Status GetBuffer(OpKernelContext* ctx, const NodeDef& ndef, Buffer** buf) {
   auto rm = ctx->resource_manager();
   ContainerInfo cinfo;
   TF_RETURN_IF_ERROR(cinfo.Init(rm, ndef, true /* use name() */));
+  // The bounds of the buffer are those of the op that creates it.
+  auto create_fn = [&ndef](Buffer** ret) {
+    int64 capacity = 0;
+    int64 memory_limit = 0;
+    TF_RETURN_IF_ERROR(GetNodeAttr(ndef, "capacity", &capacity));
+    TF_RETURN_IF_ERROR(GetNodeAttr(ndef, "memory_limit", &memory_limit));
+    *ret = new Buffer(capacity, memory_limit);
+    return Status::OK();
+  };
   TF_RETURN_IF_ERROR(rm->LookupOrCreate<Buffer>(cinfo.container(), cinfo.name(),
-                                                buf, CreateBuffer));
+                                                buf, create_fn));
   return Status::OK();
 }
 
@@ -91,7 +154,7 @@ class StageOp : public OpKernel {
     for (int i = 0; i < ctx->num_inputs(); ++i) {
       tuple.push_back(ctx->input(i));
     }
-    buf->Put(&tuple);
+    OP_REQUIRES_OK(ctx, buf->Put(&tuple));
   }
 };
 
@@ -133,4 +196,48 @@ REGISTER_KERNEL_BUILDER(Name("Unstage").Device(DEVICE_GPU), UnstageOp);
 REGISTER_KERNEL_BUILDER(Name("Unstage").Device(DEVICE_SYCL), UnstageOp);
 #endif // TENSORFLOW_USE_SYCL
 
+class StageSizeOp : public OpKernel {
+ public:
+  explicit StageSizeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    Buffer* buf = nullptr;
+    OP_REQUIRES_OK(ctx, GetBuffer(ctx, def(), &buf));
+    core::ScopedUnref scope(buf);
+    Tensor* size = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &size));
+    size->scalar<int32>()() = static_cast<int32>(buf->Size());
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("StageSize").Device(DEVICE_CPU), StageSizeOp);
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("StageSize").HostMemory("size").Device(DEVICE_GPU),
+                        StageSizeOp);
+#endif
+#ifdef TENSORFLOW_USE_SYCL
+REGISTER_KERNEL_BUILDER(
+    Name("StageSize").HostMemory("size").Device(DEVICE_SYCL), StageSizeOp);
+#endif // TENSORFLOW_USE_SYCL
+
+class StageClearOp : public OpKernel {
+ public:
+  explicit StageClearOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    Buffer* buf = nullptr;
+    OP_REQUIRES_OK(ctx, GetBuffer(ctx, def(), &buf));
+    core::ScopedUnref scope(buf);
+    buf->Clear();
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("StageClear").Device(DEVICE_CPU), StageClearOp);
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("StageClear").Device(DEVICE_GPU), StageClearOp);
+#endif
+#ifdef TENSORFLOW_USE_SYCL
+REGISTER_KERNEL_BUILDER(Name("StageClear").Device(DEVICE_SYCL), StageClearOp);
+#endif // TENSORFLOW_USE_SYCL
+
 }  // namespace tensorflow
@@ -67,7 +67,7 @@ class StringJoinOp : public OpKernel {
       for (int j = 0; j < input_list.size(); ++j) {
         strings[j] = (is_scalar[j]) ? inputs[j](0) : inputs[j](i);
       }
-      output_flat(i) = str_util::Join(strings, separator_.c_str());
+      str_util::JoinInto(strings, separator_, &output_flat(i));
     }
   }
 
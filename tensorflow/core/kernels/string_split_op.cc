@@ -16,32 +16,59 @@ limitations under the License.
 // See docs in ../ops/string_ops.cc.
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace tensorflow {
 
 namespace {
 
-std::vector<string> Split(const string& str, const string& delimiter) {
-  if (delimiter.size()) {
-    return str_util::Split(str, delimiter, str_util::SkipEmpty());
+// Splits strings at any of the bytes of a delimiter, skipping empty tokens,
+// or into single bytes if the delimiter is empty.  The tokens point into the
+// split string, so splitting allocates nothing.
+class Tokenizer {
+ public:
+  explicit Tokenizer(StringPiece delimiter)
+      : split_bytes_(delimiter.empty()), is_delimiter_() {
+    for (char c : delimiter) {
+      is_delimiter_[static_cast<uint8>(c)] = true;
+    }
   }
-  std::vector<string> char_vector(str.size());
-  for (size_t i = 0; i < str.size(); ++i) {
-    char_vector[i] = str[i];
+
+  // Appends the tokens of "str" to "tokens".
+  void Split(StringPiece str, std::vector<StringPiece>* tokens) const {
+    if (split_bytes_) {
+      for (size_t i = 0; i < str.size(); ++i) {
+        tokens->emplace_back(str.data() + i, 1);
+      }
+      return;
+    }
+    size_t start = 0;
+    for (size_t i = 0; i <= str.size(); ++i) {
+      if (i == str.size() || is_delimiter_[static_cast<uint8>(str[i])]) {
+        if (i > start) tokens->emplace_back(str.data() + start, i - start);
+        start = i + 1;
+      }
+    }
   }
-  return char_vector;
-}
+
+ private:
+  const bool split_bytes_;
+  bool is_delimiter_[256];
+};
 
 }  // namespace
 
-class StringSplitOp : public OpKernel {
+// Splits the elements of a vector of strings into a SparseTensor of tokens,
+// whose values SetValues() computes from the tokens.
+class StringSplitOpBase : public OpKernel {
  public:
   using OpKernel::OpKernel;
 
@@ -62,36 +89,34 @@ class StringSplitOp : public OpKernel {
         errors::InvalidArgument("delimiter must scalar, got shape: ",
                                 delimiter_tensor->shape().DebugString()));
     const auto delimiter_vec = delimiter_tensor->flat<string>();
-    const string& delimiter = delimiter_vec(0);
     // Empty delimiter means split the input character by character.
-    std::vector<string> tokens;
+    const Tokenizer tokenizer(delimiter_vec(0));
+    std::vector<StringPiece> tokens;
     // Guess that we'll be unpacking a handful of tokens per example.
     static constexpr int kReserveSize = 4;
     tokens.reserve(batch_size * kReserveSize);
 
-    int64 output_size = 0;
     int64 max_num_entries = 0;
     std::vector<int64> num_indices(batch_size);
     for (int64 i = 0; i < batch_size; ++i) {
-      std::vector<string> parts = Split(input_vec(i), delimiter);
-      int64 n_entries = parts.size();
+      const size_t begin = tokens.size();
+      tokenizer.Split(input_vec(i), &tokens);
+      const int64 n_entries = tokens.size() - begin;
       num_indices[i] = n_entries;
-      output_size += n_entries;
       max_num_entries = std::max(max_num_entries, n_entries);
-      tokens.insert(tokens.end(), parts.begin(), parts.end());
     }
+    const int64 output_size = tokens.size();
 
     Tensor* sp_indices_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
                                              &sp_indices_t));
-    Tensor* sp_tokens_t;
+    Tensor* sp_values_t;
     OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
+        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_values_t));
     Tensor* sp_shape_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
 
     auto sp_indices = sp_indices_t->matrix<int64>();
-    auto sp_tokens = sp_tokens_t->vec<string>();
     auto sp_shape = sp_shape_t->vec<int64>();
     sp_shape(0) = batch_size;
     sp_shape(1) = max_num_entries;
@@ -100,13 +125,62 @@ class StringSplitOp : public OpKernel {
       for (size_t j = 0; j < num_indices[i]; ++j) {
         sp_indices(c, 0) = i;
         sp_indices(c, 1) = j;
-        sp_tokens(c) = tokens[c];
         ++c;
       }
     }
+    SetValues(tokens, sp_values_t);
+  }
+
+ protected:
+  // Sets the elements of "values", a vector of tokens.size() elements, to the
+  // values of the tokens.
+  virtual void SetValues(const std::vector<StringPiece>& tokens,
+                         Tensor* values) = 0;
+};
+
+class StringSplitOp : public StringSplitOpBase {
+ public:
+  using StringSplitOpBase::StringSplitOpBase;
+
+ protected:
+  void SetValues(const std::vector<StringPiece>& tokens,
+                 Tensor* values) override {
+    auto sp_tokens = values->vec<string>();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      sp_tokens(i).assign(tokens[i].data(), tokens[i].size());
+    }
   }
 };
 
 REGISTER_KERNEL_BUILDER(Name("StringSplit").Device(DEVICE_CPU), StringSplitOp);
 
+// Hashes the tokens straight from the bytes of the input, as
+// StringToHashBucketFast would, without creating a string per token.
+class StringSplitToHashBucketFastOp : public StringSplitOpBase {
+ public:
+  explicit StringSplitToHashBucketFastOp(OpKernelConstruction* ctx)
+      : StringSplitOpBase(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_buckets", &num_buckets_));
+  }
+
+ protected:
+  void SetValues(const std::vector<StringPiece>& tokens,
+                 Tensor* values) override {
+    auto sp_ids = values->vec<int64>();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      const uint64 hash = Fingerprint64(tokens[i].data(), tokens[i].size());
+      // The number of buckets is always in the positive range of int64, so
+      // casting the bucket id to int64 is safe.
+      sp_ids(i) = static_cast<int64>(hash % num_buckets_);
+    }
+  }
+
+ private:
+  int64 num_buckets_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("StringSplitToHashBucketFast").Device(DEVICE_CPU),
+    StringSplitToHashBucketFastOp);
+
 }  // namespace tensorflow
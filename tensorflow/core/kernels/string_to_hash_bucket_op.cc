@@ -41,10 +41,11 @@ class LegacyStringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
+    uint64* hashes = reinterpret_cast<uint64*>(output_flat.data());
+    Hash64Batch(input_flat.data(), input_flat.size(), hashes);
     typedef decltype(input_flat.size()) Index;
     for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = Hash64(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
+      const uint64 bucket_id = hashes[i] % num_buckets_;
       // The number of buckets is always in the positive range of int64 so is
       // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
       // safe.
@@ -63,7 +64,7 @@ REGISTER_KERNEL_BUILDER(Name("StringToHashBucket").Device(DEVICE_CPU),
                         LegacyStringToHashBucketOp);
 
 REGISTER_KERNEL_BUILDER(Name("StringToHashBucketFast").Device(DEVICE_CPU),
-                        StringToHashBucketOp<Fingerprint64>);
+                        StringToHashBucketOp<Fingerprint64Batch>);
 
 REGISTER_KERNEL_BUILDER(Name("StringToHashBucketStrong").Device(DEVICE_CPU),
                         StringToKeyedHashBucketOp<StrongKeyedHash>);
@@ -26,7 +26,9 @@ limitations under the License.
 
 namespace tensorflow {
 
-template <uint64 hash(const string&)>
+// Hashes its input with hash_batch(keys, num_keys, hashes), which sets
+// hashes[i] to the hash of keys[i].
+template <void hash_batch(const string*, size_t, uint64*)>
 class StringToHashBucketOp : public OpKernel {
  public:
   explicit StringToHashBucketOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
@@ -44,10 +46,13 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
+    // The hashes are computed in place in the output, which has the same
+    // size, and then reduced to the buckets.
+    uint64* hashes = reinterpret_cast<uint64*>(output_flat.data());
+    hash_batch(input_flat.data(), input_flat.size(), hashes);
     typedef decltype(input_flat.size()) Index;
     for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
+      const uint64 bucket_id = hashes[i] % num_buckets_;
       // The number of buckets is always in the positive range of int64 so is
       // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
       // safe.
@@ -64,26 +64,26 @@ class SubstrOp : public OpKernel {
         const T len =
             tensorflow::internal::SubtleMustCopy(len_tensor.scalar<T>()());
         for (size_t i = 0; i < input_tensor.NumElements(); ++i) {
-          string in = input(i);
+          const string& in = input(i);
           OP_REQUIRES(
               context, FastBoundsCheck(pos, in.size()),
               errors::InvalidArgument("pos ", pos, " out of range for string",
                                       "b'", in, "' at index ", i));
-          output(i) = in.substr(pos, len);
+          output(i).assign(in, pos, len);
         }
       } else {
         // Perform Op element-wise with tensor pos/len
         auto pos_flat = pos_tensor.flat<T>();
         auto len_flat = len_tensor.flat<T>();
         for (size_t i = 0; i < input_tensor.NumElements(); ++i) {
-          string in = input(i);
+          const string& in = input(i);
           const T pos = tensorflow::internal::SubtleMustCopy(pos_flat(i));
           const T len = tensorflow::internal::SubtleMustCopy(len_flat(i));
           OP_REQUIRES(
               context, FastBoundsCheck(pos, in.size()),
               errors::InvalidArgument("pos ", pos, " out of range for string",
                                       "b'", in, "' at index ", i));
-          output(i) = in.substr(pos, len);
+          output(i).assign(in, pos, len);
         }
       }
     } else {
@@ -142,14 +142,14 @@ class SubstrOp : public OpKernel {
 
           // Iterate through broadcasted tensors and perform substr
           for (int i = 0; i < output_shape.dim_size(0); ++i) {
-            string in = input_bcast(i);
+            const string& in = input_bcast(i);
             const T pos = tensorflow::internal::SubtleMustCopy(pos_bcast(i));
             const T len = tensorflow::internal::SubtleMustCopy(len_bcast(i));
             OP_REQUIRES(
                 context, FastBoundsCheck(pos, input_bcast(i).size()),
                 errors::InvalidArgument("pos ", pos, " out of range for string",
                                         "b'", in, "' at index ", i));
-            output(i) = in.substr(pos, len);
+            output(i).assign(in, pos, len);
           }
           break;
         }
@@ -192,7 +192,7 @@ class SubstrOp : public OpKernel {
           // Iterate through broadcasted tensors and perform substr
           for (int i = 0; i < output_shape.dim_size(0); ++i) {
             for (int j = 0; j < output_shape.dim_size(1); ++j) {
-              string in = input_bcast(i, j);
+              const string& in = input_bcast(i, j);
               const T pos =
                   tensorflow::internal::SubtleMustCopy(pos_bcast(i, j));
               const T len =
@@ -201,7 +201,7 @@ class SubstrOp : public OpKernel {
                           errors::InvalidArgument(
                               "pos ", pos, " out of range for ", "string b'",
                               in, "' at index (", i, ", ", j, ")"));
-              output(i, j) = in.substr(pos, len);
+              output(i, j).assign(in, pos, len);
             }
           }
           break;
@@ -85,6 +85,17 @@ Status GetTensorArray(OpKernelContext* ctx, TensorArray** tensor_array) {
   }
 }
 
+// Sets *element to the rows [start, limit) of value, in the given shape,
+// if they are aligned, and returns true. The element then shares the buffer
+// of value instead of being copied out of it by one allocation and one
+// kernel per element. This is safe because the TensorArray never updates the
+// tensors written to it in place: aggregating writes allocate a new tensor.
+bool SliceIfAligned(const Tensor& value, int64 start, int64 limit,
+                    const TensorShape& shape, Tensor* element) {
+  Tensor slice = value.Slice(start, limit);
+  return slice.IsAligned() && element->CopyFrom(slice, shape);
+}
+
 Status SetupFlowControlInputs(OpKernelContext* ctx, bool set_output) {
   const Tensor* flow_control;
   TF_RETURN_IF_ERROR(ctx->input("flow_in", &flow_control));
@@ -1075,6 +1086,11 @@ class TensorArrayUnpackOrScatterOp : public OpKernel {
     write_values.reserve(num_values);
 
     for (int i = 0; i < num_values; ++i) {
+      Tensor element;
+      if (SliceIfAligned(*tensor_value, i, i + 1, element_shape, &element)) {
+        write_values.push_back(PersistentTensor(element));
+        continue;
+      }
       Tensor* tensor_value_i;
       PersistentTensor persistent_tensor;
       OP_REQUIRES_OK(
@@ -1259,10 +1275,17 @@ class TensorArraySplitOp : public OpKernel {
     write_values.reserve(array_size);
 
     for (int i = 0; i < array_size; ++i) {
+      int64 previous_length = (i == 0) ? 0 : cumulative_lengths[i - 1];
+      Tensor element;
+      if (SliceIfAligned(*tensor_value, previous_length,
+                         previous_length + tensor_lengths_t(i),
+                         element_shapes[i], &element)) {
+        write_values.push_back(PersistentTensor(element));
+        continue;
+      }
+
       Tensor* tensor_value_i;
       PersistentTensor persistent_tensor;
-
-      int64 previous_length = (i == 0) ? 0 : cumulative_lengths[i - 1];
       Eigen::DSizes<Eigen::DenseIndex, 3> indices{0, previous_length, 0};
       Eigen::DSizes<Eigen::DenseIndex, 3> sizes{1, tensor_lengths_t(i),
                                                 elements_per_row};
@@ -15,13 +15,20 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <deque>
 #include <memory>
+#include <vector>
+#include "tensorflow/core/framework/queue_interface.h"
 #include "tensorflow/core/framework/reader_base.h"
 #include "tensorflow/core/framework/reader_op_kernel.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -101,4 +108,324 @@ REGISTER_KERNEL_BUILDER(Name("TFRecordReader").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("TFRecordReaderV2").Device(DEVICE_CPU),
                         TFRecordReaderOp);
 
+// Reads up to `num_parallel_files` TFRecord files at once and interleaves
+// their records.
+//
+// Each open file is read ahead into a buffer of at most `buffer_size` records
+// by a thread of the reader's pool, so the I/O, checksumming and
+// decompression of the open files overlap.  In the default, deterministic
+// mode the records are taken from the open files in turn, one at a time.  In
+// sloppy mode the next record comes from any open file that has one ready,
+// so a slow file does not hold up the others.
+//
+// The work items are assigned to the open files in the order in which the
+// files were emptied, so the order of the records in deterministic mode only
+// depends on the contents of the work queue.
+class ParallelTFRecordReader : public ReaderInterface {
+ public:
+  ParallelTFRecordReader(const string& node_name,
+                         const string& compression_type,
+                         int num_parallel_files, int buffer_size, bool sloppy,
+                         Env* env)
+      : name_(strings::StrCat("ParallelTFRecordReader '", node_name, "'")),
+        env_(env),
+        options_(io::RecordReaderOptions::CreateRecordReaderOptions(
+            compression_type)),
+        buffer_size_(buffer_size),
+        sloppy_(sloppy),
+        files_(num_parallel_files),
+        pool_(new thread::ThreadPool(env, "parallel_tf_record_reader",
+                                     num_parallel_files)) {
+    ResetSlots();
+  }
+
+  ~ParallelTFRecordReader() override {
+    CancelFiles();
+    // Waits for the reading threads to notice the cancellation.
+    pool_.reset();
+  }
+
+  void Read(QueueInterface* queue, string* key, string* value,
+            OpKernelContext* context) override {
+    mutex_lock read_lock(read_mu_);
+    NextRecord(queue, context, true /* may_wait_for_work */, key, value);
+  }
+
+  int64 ReadUpTo(const int64 num_records, QueueInterface* queue,
+                 std::vector<string>* keys, std::vector<string>* values,
+                 OpKernelContext* context) override {
+    mutex_lock read_lock(read_mu_);
+    int64 num_read = 0;
+    string key;
+    string value;
+    // Once some records are read, returns them rather than wait for work.
+    while (num_read < num_records &&
+           NextRecord(queue, context, num_read == 0, &key, &value)) {
+      keys->push_back(std::move(key));
+      values->push_back(std::move(value));
+      ++num_read;
+    }
+    return num_read;
+  }
+
+  Status Reset() override {
+    mutex_lock read_lock(read_mu_);
+    CancelFiles();
+    ResetSlots();
+    mutex_lock lock(mu_);
+    num_records_produced_ = 0;
+    num_work_units_completed_ = 0;
+    return Status::OK();
+  }
+
+  int64 NumRecordsProduced() override {
+    mutex_lock lock(mu_);
+    return num_records_produced_;
+  }
+
+  int64 NumWorkUnitsCompleted() override {
+    mutex_lock lock(mu_);
+    return num_work_units_completed_;
+  }
+
+  // TODO(josh11b): Implement serializing and restoring the state.
+  Status SerializeState(string* state) override {
+    return errors::Unimplemented("Reader SerializeState");
+  }
+
+  Status RestoreState(const string& state) override {
+    return errors::Unimplemented("Reader RestoreState");
+  }
+
+  string DebugString() override { return name_; }
+
+ private:
+  // A file being read ahead by a thread of pool_.  All fields but filename
+  // are guarded by mu_.
+  struct OpenFile {
+    explicit OpenFile(const string& filename) : filename(filename) {}
+
+    const string filename;
+    // The keys and values read ahead.
+    std::deque<std::pair<string, string>> records;
+    // Set once the reading thread reached the end of the file or an error.
+    bool done = false;
+    Status status;
+    // Set when the reader no longer wants the records of the file.
+    bool cancelled = false;
+  };
+
+  // Produces the next record into *key and *value, and returns true.  Returns
+  // false if there is none, and sets the status of `context` if it is because
+  // of an error or the end of `queue`.  Only waits for new work items if
+  // `may_wait_for_work`.
+  bool NextRecord(QueueInterface* queue, OpKernelContext* context,
+                  bool may_wait_for_work, string* key, string* value)
+      EXCLUSIVE_LOCKS_REQUIRED(read_mu_) {
+    while (true) {
+      // Opens files for the available work items, without waiting.
+      while (!empty_slots_.empty() && queue->size() > 0) {
+        if (!OpenNextFile(queue, context)) return false;
+      }
+      if (empty_slots_.size() == files_.size()) {
+        // Nothing is open, so this waits for work, or sets the OutOfRange
+        // error of a closed queue.
+        if (!may_wait_for_work || !OpenNextFile(queue, context)) return false;
+        continue;
+      }
+
+      const int slot = sloppy_ ? WaitForAnyFile() : cursor_;
+      std::shared_ptr<OpenFile> file = files_[slot];
+      if (file == nullptr) {
+        // Only in deterministic mode: the file of this turn is not open yet.
+        if (queue->closed() && queue->size() == 0) {
+          cursor_ = (slot + 1) % files_.size();
+        } else if (!may_wait_for_work || !OpenNextFile(queue, context)) {
+          return false;
+        }
+        continue;
+      }
+
+      mutex_lock lock(mu_);
+      while (file->records.empty() && !file->done) {
+        record_ready_.wait(lock);
+      }
+      if (!file->records.empty()) {
+        *key = std::move(file->records.front().first);
+        *value = std::move(file->records.front().second);
+        file->records.pop_front();
+        space_ready_.notify_all();
+        ++num_records_produced_;
+        cursor_ = (slot + 1) % files_.size();
+        return true;
+      }
+      files_[slot] = nullptr;
+      empty_slots_.push_back(slot);
+      ++num_work_units_completed_;
+      if (!file->status.ok()) {
+        context->SetStatus(file->status);
+        return false;
+      }
+    }
+  }
+
+  // Returns the first open file from the cursor on that has a record ready or
+  // is done.
+  int WaitForAnyFile() EXCLUSIVE_LOCKS_REQUIRED(read_mu_) {
+    mutex_lock lock(mu_);
+    while (true) {
+      for (size_t i = 0; i < files_.size(); ++i) {
+        const int slot = (cursor_ + i) % files_.size();
+        const OpenFile* file = files_[slot].get();
+        if (file != nullptr && (!file->records.empty() || file->done)) {
+          return slot;
+        }
+      }
+      record_ready_.wait(lock);
+    }
+  }
+
+  // Dequeues a work item from `queue`, which may block, and starts reading it
+  // into the slot that has been empty the longest.  Returns false if the
+  // dequeue failed, with the error set on `context`.
+  bool OpenNextFile(QueueInterface* queue, OpKernelContext* context)
+      EXCLUSIVE_LOCKS_REQUIRED(read_mu_) {
+    string work;
+    Notification n;
+    queue->TryDequeue(context, [context, &n, &work](
+                                   const QueueInterface::Tuple& tuple) {
+      if (context->status().ok()) {
+        if (tuple.size() != 1) {
+          context->SetStatus(
+              errors::InvalidArgument("Expected single component queue"));
+        } else if (tuple[0].dtype() != DT_STRING) {
+          context->SetStatus(errors::InvalidArgument(
+              "Expected queue with single string component"));
+        } else if (tuple[0].NumElements() != 1) {
+          context->SetStatus(errors::InvalidArgument(
+              "Expected to dequeue a one-element string tensor"));
+        } else {
+          work = tuple[0].flat<string>()(0);
+        }
+      }
+      n.Notify();
+    });
+    n.WaitForNotification();
+    if (!context->status().ok()) return false;
+
+    const int slot = empty_slots_.front();
+    empty_slots_.pop_front();
+    std::shared_ptr<OpenFile> file(new OpenFile(work));
+    files_[slot] = file;
+    pool_->Schedule([this, file]() { ReadFile(file.get()); });
+    return true;
+  }
+
+  // Reads the records of `file` until it is done or cancelled.
+  void ReadFile(OpenFile* file) {
+    std::unique_ptr<RandomAccessFile> raf;
+    Status status = env_->NewRandomAccessFile(file->filename, &raf);
+    std::unique_ptr<io::RecordReader> reader;
+    if (status.ok()) {
+      reader.reset(new io::RecordReader(raf.get(), options_));
+    }
+    uint64 offset = 0;
+    while (status.ok()) {
+      string key = strings::StrCat(file->filename, ":", offset);
+      string value;
+      status = reader->ReadRecord(&offset, &value);
+      if (!status.ok()) break;
+      mutex_lock lock(mu_);
+      while (!file->cancelled && file->records.size() >= buffer_size_) {
+        space_ready_.wait(lock);
+      }
+      if (file->cancelled) return;
+      file->records.emplace_back(std::move(key), std::move(value));
+      record_ready_.notify_all();
+    }
+    mutex_lock lock(mu_);
+    file->done = true;
+    if (!errors::IsOutOfRange(status)) {
+      file->status = status;
+    }
+    record_ready_.notify_all();
+  }
+
+  // Stops reading the open files.  Their threads finish in the background.
+  void CancelFiles() {
+    mutex_lock lock(mu_);
+    for (const std::shared_ptr<OpenFile>& file : files_) {
+      if (file != nullptr) file->cancelled = true;
+    }
+    space_ready_.notify_all();
+  }
+
+  void ResetSlots() {
+    cursor_ = 0;
+    empty_slots_.clear();
+    for (size_t i = 0; i < files_.size(); ++i) {
+      files_[i] = nullptr;
+      empty_slots_.push_back(i);
+    }
+  }
+
+  const string name_;
+  Env* const env_;
+  const io::RecordReaderOptions options_;
+  const size_t buffer_size_;
+  const bool sloppy_;
+
+  // Serializes the calls of the reader, and guards the fields below but those
+  // that are guarded by mu_.
+  mutex read_mu_;
+  // The open files, or nullptr for the empty slots.  The threads reading the
+  // files hold references to them until they finish.
+  std::vector<std::shared_ptr<OpenFile>> files_;
+  // The empty slots of files_, in the order in which they were emptied.
+  std::deque<int> empty_slots_;
+  // The slot of the next record in deterministic mode, and of the first one
+  // looked at in sloppy mode.
+  int cursor_ = 0;
+
+  mutex mu_;
+  // Notified when a file has a new record or is done.
+  condition_variable record_ready_;
+  // Notified when records are taken out of a file, or files are cancelled.
+  condition_variable space_ready_;
+  int64 num_records_produced_ GUARDED_BY(mu_) = 0;
+  int64 num_work_units_completed_ GUARDED_BY(mu_) = 0;
+
+  // Destroyed first, so the threads finish while the rest is alive.
+  std::unique_ptr<thread::ThreadPool> pool_;
+};
+
+class ParallelTFRecordReaderOp : public ReaderOpKernel {
+ public:
+  explicit ParallelTFRecordReaderOp(OpKernelConstruction* context)
+      : ReaderOpKernel(context) {
+    Env* env = context->env();
+
+    string compression_type;
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("compression_type", &compression_type));
+    int num_parallel_files;
+    OP_REQUIRES_OK(context, context->GetAttr("num_parallel_files",
+                                             &num_parallel_files));
+    int buffer_size;
+    OP_REQUIRES_OK(context, context->GetAttr("buffer_size", &buffer_size));
+    bool sloppy;
+    OP_REQUIRES_OK(context, context->GetAttr("sloppy", &sloppy));
+
+    SetReaderFactory([this, compression_type, num_parallel_files, buffer_size,
+                      sloppy, env]() {
+      return new ParallelTFRecordReader(name(), compression_type,
+                                        num_parallel_files, buffer_size,
+                                        sloppy, env);
+    });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParallelTFRecordReader").Device(DEVICE_CPU),
+                        ParallelTFRecordReaderOp);
+
 }  // namespace tensorflow
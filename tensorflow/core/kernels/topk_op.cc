@@ -17,17 +17,26 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include "tensorflow/core/kernels/topk_op.h"
+
+#include <algorithm>
+#include <numeric>
 #include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
-template <typename T>
+typedef Eigen::ThreadPoolDevice CPUDevice;
+typedef Eigen::GpuDevice GPUDevice;
+
+template <typename Device, typename T>
 class TopK : public OpKernel {
  public:
   explicit TopK(OpKernelConstruction* context) : OpKernel(context) {
@@ -56,6 +65,13 @@ class TopK : public OpKernel {
                                         input_in.shape().DebugString()));
     OP_REQUIRES(context, input_in.dim_size(input_in.dims() - 1) >= k,
                 errors::InvalidArgument("input must have at least k columns"));
+    OP_REQUIRES(
+        context,
+        input_in.dim_size(input_in.dims() - 1) <=
+            std::numeric_limits<int32>::max(),
+        errors::InvalidArgument("input must have at most ",
+                                std::numeric_limits<int32>::max(),
+                                " columns"));
 
     const auto& input = input_in.flat_inner_dims<T>();
 
@@ -71,54 +87,198 @@ class TopK : public OpKernel {
     OP_REQUIRES_OK(context,
                    context->allocate_output(1, output_shape, &indices_out));
 
-    // Nothing to do for top-nothing.
-    if (k == 0) return;
+    // Nothing to do for top-nothing or no rows.
+    if (k == 0 || num_rows == 0) return;
 
     auto values = values_out->flat_inner_dims<T>();
     auto indices = indices_out->flat_inner_dims<int32>();
+    Status s = functor::TopKFunctor<Device, T>::Compute(
+        context, sorted_, k, input, num_rows, num_cols, values, indices);
+    OP_REQUIRES_OK(context, s);
+  }
+
+ private:
+  int k_;
+  bool sorted_;
+};
+
+namespace functor {
+
+// The number of consecutive columns whose maximum is compared with the
+// smallest of the top k values found so far, so that the columns which
+// can't be in the top k are skipped in a vectorizable loop.
+static const int kTopKBlockSize = 16;
+
+// The rows with more than this many columns per value in the top k are
+// filtered with a heap, and the others are partially sorted.
+static const int kTopKHeapRatio = 8;
+
+template <typename T>
+struct TopKFunctor<CPUDevice, T> {
+  static Status Compute(OpKernelContext* context, bool sorted, int k,
+                        const typename TTypes<T, 2>::ConstTensor& input,
+                        int64 num_rows, int64 num_cols,
+                        typename TTypes<T, 2>::Tensor values,
+                        typename TTypes<int32, 2>::Tensor indices) {
+    const bool use_heap = k != 1 && num_cols / kTopKHeapRatio >= k;
+    auto top_k = [&](int64 start, int64 limit) {
+      std::vector<int32> columns;
+      for (int64 r = start; r < limit; ++r) {
+        const T* row = &input(r, 0);
+        if (k == 1) {
+          TopOne(row, num_cols, &values(r, 0), &indices(r, 0));
+        } else if (use_heap) {
+          TopKHeap(row, num_cols, k, sorted, &values(r, 0), &indices(r, 0));
+        } else {
+          TopKPartialSort(row, num_cols, k, sorted, &columns, &values(r, 0),
+                          &indices(r, 0));
+        }
+      }
+    };
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    // Roughly the cost of comparing each value, and of sorting the top k.
+    const int64 cost_per_row =
+        num_cols * 2 + (sorted ? k * Log2Ceiling(k) * 10 : 0);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          cost_per_row, top_k);
+    return Status::OK();
+  }
+
+ private:
+  static void TopOne(const T* row, int64 num_cols, T* value, int32* index) {
+    int32 top = 0;
+    for (int32 c = 1; c < num_cols; ++c) {
+      if (row[c] > row[top]) {
+        top = c;
+      }
+    }
+    *value = row[top];
+    *index = top;
+  }
+
+  static void TopKHeap(const T* row, int64 num_cols, int k, bool sorted,
+                       T* values, int32* indices) {
+    // The second element is the negated index, so that lower-index elements
+    // are considered larger than higher-index elements in case of ties.
     gtl::TopN<std::pair<T, int32>> filter(k);
-    for (int r = 0; r < num_rows; r++) {
-      for (int32 c = 0; c < num_cols; ++c) {
-        // The second element is the negated index, so that lower-index elements
-        // are considered larger than higher-index elements in case of ties.
-        filter.push(std::make_pair(input(r, c), -c));
+    int32 c = 0;
+    // Fill the heap, past which its bottom is known in constant time.
+    for (; c <= k; ++c) {
+      filter.push(std::make_pair(row[c], -c));
+    }
+    for (; c + kTopKBlockSize <= num_cols; c += kTopKBlockSize) {
+      // The columns come after the ones in the heap, so they only replace
+      // values which are strictly smaller.
+      const T bottom = filter.peek_bottom().first;
+      bool has_larger = false;
+      for (int i = 0; i < kTopKBlockSize; ++i) {
+        has_larger |= row[c + i] > bottom;
       }
+      if (!has_larger) {
+        continue;
+      }
+      for (int i = 0; i < kTopKBlockSize; ++i) {
+        filter.push(std::make_pair(row[c + i], -(c + i)));
+      }
+    }
+    for (; c < num_cols; ++c) {
+      filter.push(std::make_pair(row[c], -c));
+    }
 
-      int32 i = 0;
-      if (sorted_ && k > 1) {
-        std::unique_ptr<std::vector<std::pair<T, int32>>> top_k(
-            filter.Extract());
-        for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-             ++top_k_it, ++i) {
-          values(r, i) = top_k_it->first;
-          indices(r, i) = -top_k_it->second;
-        }
-      } else {
-        for (auto top_k_it = filter.unsorted_begin();
-             top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-          values(r, i) = top_k_it->first;
-          indices(r, i) = -top_k_it->second;
-        }
+    int i = 0;
+    if (sorted) {
+      std::unique_ptr<std::vector<std::pair<T, int32>>> top_k(
+          filter.Extract());
+      for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
+           ++top_k_it, ++i) {
+        values[i] = top_k_it->first;
+        indices[i] = -top_k_it->second;
+      }
+    } else {
+      for (auto top_k_it = filter.unsorted_begin();
+           top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
+        values[i] = top_k_it->first;
+        indices[i] = -top_k_it->second;
       }
-      filter.Reset();
     }
   }
 
- private:
-  int k_;
-  bool sorted_;
+  static void TopKPartialSort(const T* row, int64 num_cols, int k, bool sorted,
+                              std::vector<int32>* columns, T* values,
+                              int32* indices) {
+    columns->resize(num_cols);
+    std::iota(columns->begin(), columns->end(), 0);
+    auto greater = [row](int32 a, int32 b) {
+      return row[a] > row[b] || (!(row[b] > row[a]) && a < b);
+    };
+    if (k < num_cols) {
+      std::nth_element(columns->begin(), columns->begin() + k - 1,
+                       columns->end(), greater);
+    }
+    if (sorted) {
+      std::sort(columns->begin(), columns->begin() + k, greater);
+    }
+    for (int i = 0; i < k; ++i) {
+      values[i] = row[(*columns)[i]];
+      indices[i] = (*columns)[i];
+    }
+  }
+
+  static int64 Log2Ceiling(int64 n) {
+    int64 log2 = 0;
+    while ((int64{1} << log2) < n) {
+      ++log2;
+    }
+    return log2;
+  }
 };
 
-#define REGISTER_KERNELS_NAME(name, type) \
-  REGISTER_KERNEL_BUILDER(                \
-      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), TopK<type>)
+}  // namespace functor
+
+#define REGISTER_KERNELS_NAME(name, type)                       \
+  REGISTER_KERNEL_BUILDER(                                      \
+      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      TopK<CPUDevice, type>)
 
 #define REGISTER_KERNELS(type)       \
   REGISTER_KERNELS_NAME(TopK, type); \
   REGISTER_KERNELS_NAME(TopKV2, type)
 
 TF_CALL_REAL_NUMBER_TYPES(REGISTER_KERNELS);
-#undef REGISTER_KERNELS_TO_NAME
+#undef REGISTER_KERNELS_NAME
+#undef REGISTER_KERNELS
+
+#if GOOGLE_CUDA
+
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                  \
+  template <>                                                                \
+  Status TopKFunctor<GPUDevice, T>::Compute(                                 \
+      OpKernelContext* context, bool sorted, int k,                          \
+      const typename TTypes<T, 2>::ConstTensor& input, int64 num_rows,       \
+      int64 num_cols, typename TTypes<T, 2>::Tensor values,                  \
+      typename TTypes<int32, 2>::Tensor indices);                            \
+  extern template struct functor::TopKFunctor<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+#define REGISTER_KERNELS(type)                                   \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("TopK").Device(DEVICE_GPU).TypeConstraint<type>("T"), \
+      TopK<GPUDevice, type>)                                     \
+  REGISTER_KERNEL_BUILDER(Name("TopKV2")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .HostMemory("k"),                  \
+                          TopK<GPUDevice, type>)
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_KERNELS);
 #undef REGISTER_KERNELS
 
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensorflow
@@ -0,0 +1,318 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/topk_op.h"
+
+#include <type_traits>
+
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// The values are selected by one thread block per row.
+const int kTopKThreads = 1024;
+
+// The number of bits of the keys the radix select considers in each pass.
+const int kRadixBits = 8;
+const int kRadixSize = 1 << kRadixBits;
+
+// The rows of the top k whose keys and indices take up to this many bytes are
+// sorted in shared memory, and the others in global memory.
+const int kMaxSharedSortBytes = 32 * 1024;
+
+// Maps the values to unsigned keys in the same order.
+template <typename T>
+struct RadixKey;
+
+template <>
+struct RadixKey<float> {
+  typedef uint32 Key;
+  static __device__ Key Convert(float value) {
+    const uint32 bits = __float_as_uint(value);
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  typedef uint64 Key;
+  static __device__ Key Convert(double value) {
+    const uint64 bits = static_cast<uint64>(__double_as_longlong(value));
+    return (bits & 0x8000000000000000ull) ? ~bits
+                                          : bits | 0x8000000000000000ull;
+  }
+};
+
+template <>
+struct RadixKey<Eigen::half> {
+  typedef uint32 Key;
+  static __device__ Key Convert(Eigen::half value) {
+    const uint32 bits = value.x;
+    return (bits & 0x8000u) ? ~bits & 0xffffu : bits | 0x8000u;
+  }
+};
+
+// Writes the 'k' largest values of the row of 'input' of the block, and their
+// columns, to 'values' and 'indices' in the order of their columns.
+//
+// The key of the k-th largest value is found digit by digit from the most
+// significant one, each pass counting the keys which have the digits found so
+// far in a histogram of their next digit. The values with a larger key are
+// then selected, with the values with the same key in the smallest columns.
+template <typename T>
+__global__ void RadixSelectTopKKernel(const T* input, int num_cols, int k,
+                                      T* values, int32* indices) {
+  typedef typename RadixKey<T>::Key Key;
+  const T* row = input + static_cast<int64>(blockIdx.x) * num_cols;
+  values += static_cast<int64>(blockIdx.x) * k;
+  indices += static_cast<int64>(blockIdx.x) * k;
+
+  __shared__ int histogram[kRadixSize];
+  __shared__ int digit_found;
+  __shared__ int remaining_found;
+
+  // The digits of the key of the k-th largest value found so far, and the
+  // number of values with this key in the top k.
+  Key desired = 0;
+  Key desired_mask = 0;
+  int remaining = k;
+  for (int shift = sizeof(Key) * 8 - kRadixBits; shift >= 0;
+       shift -= kRadixBits) {
+    for (int i = threadIdx.x; i < kRadixSize; i += blockDim.x) {
+      histogram[i] = 0;
+    }
+    __syncthreads();
+    for (int i = threadIdx.x; i < num_cols; i += blockDim.x) {
+      const Key key = RadixKey<T>::Convert(ldg(row + i));
+      if ((key & desired_mask) == desired) {
+        atomicAdd(&histogram[(key >> shift) & (kRadixSize - 1)], 1);
+      }
+    }
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      int digit = kRadixSize - 1;
+      while (histogram[digit] < remaining) {
+        remaining -= histogram[digit];
+        --digit;
+      }
+      digit_found = digit;
+      remaining_found = remaining;
+    }
+    __syncthreads();
+    desired |= static_cast<Key>(digit_found) << shift;
+    desired_mask |= static_cast<Key>(kRadixSize - 1) << shift;
+    remaining = remaining_found;
+  }
+
+  // Select the values by chunks of consecutive columns, so that the values
+  // equal to the k-th largest one are taken in the smallest columns.
+  __shared__ int num_written;
+  __shared__ int num_equal_left;
+  __shared__ int num_equal_in_chunk;
+  __shared__ bool done;
+  if (threadIdx.x == 0) {
+    num_written = 0;
+    num_equal_left = remaining;
+  }
+  for (int chunk = 0; chunk < num_cols; chunk += blockDim.x) {
+    // 'num_written' changes after the barrier, so all the threads read
+    // whether the top k is complete from 'done'.
+    if (threadIdx.x == 0) {
+      num_equal_in_chunk = 0;
+      done = num_written == k;
+    }
+    __syncthreads();
+    if (done) {
+      break;
+    }
+    const int i = chunk + threadIdx.x;
+    const Key key = i < num_cols ? RadixKey<T>::Convert(ldg(row + i)) : 0;
+    const bool equal = i < num_cols && key == desired;
+    if (i < num_cols && key > desired) {
+      const int position = atomicAdd(&num_written, 1);
+      values[position] = ldg(row + i);
+      indices[position] = i;
+    } else if (equal) {
+      atomicAdd(&num_equal_in_chunk, 1);
+    }
+    __syncthreads();
+    const int equal_left = num_equal_left;
+    if (num_equal_in_chunk <= equal_left) {
+      if (equal) {
+        const int position = atomicAdd(&num_written, 1);
+        values[position] = ldg(row + i);
+        indices[position] = i;
+      }
+    } else if (threadIdx.x == 0) {
+      // Only the smallest columns of this chunk are in the top k.
+      int left = equal_left;
+      for (int j = chunk; left > 0; ++j) {
+        if (RadixKey<T>::Convert(ldg(row + j)) == desired) {
+          values[num_written] = ldg(row + j);
+          indices[num_written] = j;
+          ++num_written;
+          --left;
+        }
+      }
+    }
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      num_equal_left = max(0, equal_left - num_equal_in_chunk);
+    }
+  }
+}
+
+// Sorts the 'k' values of the row of 'values' of the block in descending
+// order, the equal values by column, with a bitonic sort of 'n' keys and
+// indices, 'n' being the power of 2 following 'k'. The keys and indices are
+// sorted in shared memory if 'scratch_keys' is null, and else in the rows of
+// 'scratch_keys' and 'scratch_indices'.
+template <typename T>
+__global__ void BitonicSortTopKKernel(const T* input, int num_cols, int k,
+                                      int n,
+                                      typename RadixKey<T>::Key* scratch_keys,
+                                      int32* scratch_indices, T* values,
+                                      int32* indices) {
+  typedef typename RadixKey<T>::Key Key;
+  extern __shared__ __align__(sizeof(uint64)) unsigned char shared_memory[];
+  Key* keys;
+  int32* key_indices;
+  if (scratch_keys == nullptr) {
+    keys = reinterpret_cast<Key*>(shared_memory);
+    key_indices = reinterpret_cast<int32*>(keys + n);
+  } else {
+    keys = scratch_keys + static_cast<int64>(blockIdx.x) * n;
+    key_indices = scratch_indices + static_cast<int64>(blockIdx.x) * n;
+  }
+  const T* row = input + static_cast<int64>(blockIdx.x) * num_cols;
+  values += static_cast<int64>(blockIdx.x) * k;
+  indices += static_cast<int64>(blockIdx.x) * k;
+
+  // The padding sorts after all the values.
+  for (int i = threadIdx.x; i < n; i += blockDim.x) {
+    if (i < k) {
+      keys[i] = RadixKey<T>::Convert(values[i]);
+      key_indices[i] = indices[i];
+    } else {
+      keys[i] = 0;
+      key_indices[i] = kint32max;
+    }
+  }
+  __syncthreads();
+
+  for (int size = 2; size <= n; size <<= 1) {
+    for (int stride = size / 2; stride > 0; stride >>= 1) {
+      for (int i = threadIdx.x; i < n; i += blockDim.x) {
+        const int j = i ^ stride;
+        if (j <= i) {
+          continue;
+        }
+        // Whether the entry at 'a' goes before the one at 'b'.
+        auto before = [keys, key_indices](int a, int b) {
+          return keys[a] > keys[b] ||
+                 (keys[a] == keys[b] && key_indices[a] < key_indices[b]);
+        };
+        const bool descending = (i & size) == 0;
+        if (descending ? before(j, i) : before(i, j)) {
+          const Key key = keys[i];
+          keys[i] = keys[j];
+          keys[j] = key;
+          const int32 index = key_indices[i];
+          key_indices[i] = key_indices[j];
+          key_indices[j] = index;
+        }
+      }
+      __syncthreads();
+    }
+  }
+
+  for (int i = threadIdx.x; i < k; i += blockDim.x) {
+    values[i] = ldg(row + key_indices[i]);
+    indices[i] = key_indices[i];
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T>
+struct TopKFunctor<GPUDevice, T> {
+  static Status Compute(OpKernelContext* context, bool sorted, int k,
+                        const typename TTypes<T, 2>::ConstTensor& input,
+                        int64 num_rows, int64 num_cols,
+                        typename TTypes<T, 2>::Tensor values,
+                        typename TTypes<int32, 2>::Tensor indices) {
+    typedef typename RadixKey<T>::Key Key;
+    const GPUDevice& d = context->eigen_device<GPUDevice>();
+    RadixSelectTopKKernel<T><<<num_rows, kTopKThreads, 0, d.stream()>>>(
+        input.data(), num_cols, k, values.data(), indices.data());
+    if (sorted && k > 1) {
+      int n = 1;
+      while (n < k) {
+        n <<= 1;
+      }
+      const int64 sort_bytes = n * (sizeof(Key) + sizeof(int32));
+      Tensor scratch_keys;
+      Tensor scratch_indices;
+      Key* scratch_keys_ptr = nullptr;
+      int32* scratch_indices_ptr = nullptr;
+      if (sort_bytes > kMaxSharedSortBytes) {
+        // The keys are stored in signed integers of the same size.
+        TF_RETURN_IF_ERROR(context->allocate_temp(
+            DataTypeToEnum<typename std::make_signed<Key>::type>::value,
+            TensorShape({num_rows * n}), &scratch_keys));
+        TF_RETURN_IF_ERROR(context->allocate_temp(
+            DT_INT32, TensorShape({num_rows * n}), &scratch_indices));
+        scratch_keys_ptr = reinterpret_cast<Key*>(
+            scratch_keys.flat<typename std::make_signed<Key>::type>().data());
+        scratch_indices_ptr = scratch_indices.flat<int32>().data();
+      }
+      const int shared_bytes =
+          scratch_keys_ptr == nullptr ? static_cast<int>(sort_bytes) : 0;
+      BitonicSortTopKKernel<T>
+          <<<num_rows, kTopKThreads, shared_bytes, d.stream()>>>(
+              input.data(), num_cols, k, n, scratch_keys_ptr,
+              scratch_indices_ptr, values.data(), indices.data());
+    }
+    if (!d.ok()) {
+      return errors::Internal("Launch of the TopK kernels failed");
+    }
+    return Status::OK();
+  }
+};
+
+}  // namespace functor
+
+#define DEFINE_GPU_SPEC(T) template struct functor::TopKFunctor<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPEC);
+
+#undef DEFINE_GPU_SPEC
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
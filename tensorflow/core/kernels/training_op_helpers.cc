@@ -58,7 +58,7 @@ std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
             [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
 
   for (auto input : acquire_order) {
-    mutex* mu = GetTrainingVariableMutex(ctx, input);
+    mutex* mu = mutexes[input];
     if (mu != nullptr) {
       locks.emplace_back(*mu);
     }
@@ -93,4 +93,33 @@ void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
   }
 }
 
+namespace {
+
+template <typename Mark>
+void ForEachVariableInput(OpKernelContext* ctx,
+                          const std::vector<int>& input_ids, Mark mark) {
+  for (int input : input_ids) {
+    if (ctx->input_dtype(input) != DT_RESOURCE) continue;
+    Var* var;
+    if (LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) {
+      core::ScopedUnref unref(var);
+      mark(var);
+    }
+  }
+}
+
+}  // namespace
+
+void MarkVariableInputsDirty(OpKernelContext* ctx,
+                             const std::vector<int>& input_ids) {
+  ForEachVariableInput(ctx, input_ids, [](Var* var) { var->MarkDirty(); });
+}
+
+void MarkVariableInputRowsDirty(OpKernelContext* ctx,
+                                const std::vector<int>& input_ids,
+                                const Tensor& indices) {
+  ForEachVariableInput(ctx, input_ids,
+                       [&indices](Var* var) { var->MarkDirtyRows(indices); });
+}
+
 }  // end namespace tensorflow
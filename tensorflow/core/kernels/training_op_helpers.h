@@ -31,6 +31,19 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
+// Records, for delta checkpoints, that the resource variables at "input_ids"
+// changed as a whole (see Var::MarkDirty).  Ref inputs are skipped.
+void MarkVariableInputsDirty(OpKernelContext* ctx,
+                             const std::vector<int>& input_ids);
+
+// Records that rows "indices" of the resource variables at "input_ids"
+// changed (see Var::MarkDirtyRows).  Ref inputs are skipped.  Sparse apply
+// kernels call this from a cleanup, so that it also runs when an update stops
+// at a bad index.
+void MarkVariableInputRowsDirty(OpKernelContext* ctx,
+                                const std::vector<int>& input_ids,
+                                const Tensor& indices);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_TRAINING_OP_HELPERS_H_
@@ -17,11 +17,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include <algorithm>
+#include <numeric>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/row_locks.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 
 namespace tensorflow {
 
@@ -38,6 +41,11 @@ inline T sgn(const T x) {
 }
 }
 
+// The costs of the update of one element by the sparse apply kernels that
+// update rows in parallel, as passed to Shard.
+static const int64 kSparseApplyAdagradCost = 10;
+static const int64 kSparseApplyFtrlCost = 50;
+
 namespace functor {
 template <typename T>
 struct ApplyGradientDescent<CPUDevice, T> {
@@ -293,6 +301,49 @@ struct ApplyCenteredRMSProp<CPUDevice, T> {
   }
 };
 
+template <typename T, typename Update>
+struct MultiApply<CPUDevice, T, Update> {
+  void operator()(const CPUDevice& d,
+                  const MultiApplyTensors<T, Update>& tensors,
+                  bool use_nesterov) {
+    // The elements of all the variables are split among the threads as one
+    // flat range, element 'offsets[i]' being the first of variable 'i'.
+    const int num_tensors = tensors.var.size();
+    std::vector<int64> offsets(num_tensors + 1, 0);
+    for (int i = 0; i < num_tensors; ++i) {
+      offsets[i + 1] = offsets[i] + tensors.sizes[i];
+    }
+    auto work = [&tensors, &offsets, num_tensors, use_nesterov](int64 begin,
+                                                                int64 end) {
+      int i = std::upper_bound(offsets.begin(), offsets.end(), begin) -
+              offsets.begin() - 1;
+      for (; i < num_tensors && offsets[i] < end; ++i) {
+        T* slots[Update::kNumSlots];
+        for (int j = 0; j < Update::kNumSlots; ++j) {
+          slots[j] = tensors.slots[j][i];
+        }
+        const T* scalars[Update::kNumScalars];
+        for (int k = 0; k < Update::kNumScalars; ++k) {
+          scalars[k] = tensors.scalars[k][i];
+        }
+        const typename Update::Coefficients c =
+            Update::GetCoefficients(scalars, use_nesterov);
+        T* var = tensors.var[i];
+        const T* grad = tensors.grad[i];
+        const int64 limit = std::min(end, offsets[i + 1]) - offsets[i];
+        for (int64 index = std::max(begin, offsets[i]) - offsets[i];
+             index < limit; ++index) {
+          Update::Apply(c, index, var, slots, grad);
+        }
+      }
+    };
+    const Eigen::TensorOpCost cost((Update::kNumSlots + 2) * sizeof(T),
+                                   (Update::kNumSlots + 1) * sizeof(T),
+                                   Update::kComputeCycles);
+    d.parallelFor(offsets[num_tensors], cost, work);
+  }
+};
+
 }  // namespace functor
 
 
@@ -329,6 +380,7 @@ class ApplyGradientDescentOp : public OpKernel {
     functor::ApplyGradientDescent<Device, T>()(
         device, var.flat<T>(), alpha.scalar<T>(), delta.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -403,6 +455,7 @@ class ApplyAdadeltaOp : public OpKernel {
       if (!ctx->status().ok()) return;
       DoCompute(ctx);
     }
+    MarkVariableInputsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -597,6 +650,9 @@ class SparseApplyAdadeltaOp : public OpKernel {
     const Tensor& indices = ctx->input(7);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1, 2}, indices);
+    });
 
     for (int d = 1; d < var.dims(); d++) {
       OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
@@ -727,6 +783,7 @@ class ApplyProximalGradientDescentOp : public OpKernel {
         device, var.flat<T>(), alpha.scalar<T>(), l1.scalar<T>(),
         l2.scalar<T>(), delta.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -786,6 +843,9 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
     const Tensor& indices = ctx->input(5);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0}, indices);
+    });
 
     int64 inner_dim = 1;
     for (int d = 1; d < var.dims(); d++) {
@@ -939,6 +999,7 @@ class ApplyAdagradOp : public OpKernel {
     functor::ApplyAdagrad<Device, T>()(device, var.flat<T>(), accum.flat<T>(),
                                        lr.scalar<T>(), grad.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1049,6 +1110,7 @@ class ApplyProximalAdagradOp : public OpKernel {
         device, var.flat<T>(), accum.flat<T>(), lr.scalar<T>(), l1.scalar<T>(),
         l2.scalar<T>(), grad.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1135,6 +1197,9 @@ class SparseApplyAdagradOp : public OpKernel {
     const Tensor& indices = ctx->input(4);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1}, indices);
+    });
 
     int64 inner_dim = 1;
     for (int d = 1; d < var.dims(); d++) {
@@ -1162,20 +1227,20 @@ class SparseApplyAdagradOp : public OpKernel {
         auto grad_flat = grad.flat_outer_dims<T>();
         T lr_scalar = lr.scalar<T>()();
 
-        // Note(yonghui): It might be worth multi-threading square() and
-        // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          auto a = accum_flat.template chip<0>(index);
-          auto g = grad_flat.template chip<0>(i);
-          auto v = var_flat.template chip<0>(index);
-          a += g.square();
-          v -= g.constant(lr_scalar) * g * a.rsqrt();
-        }
+        const Tindex bad_i = ShardedRowUpdate<Tindex>(
+            ctx, indices_vec, first_dim_size, var_flat.data(),
+            inner_dim * kSparseApplyAdagradCost, !use_exclusive_lock_,
+            [&](int64 i, Tindex index) {
+              auto a = accum_flat.template chip<0>(index);
+              auto g = grad_flat.template chip<0>(i);
+              auto v = var_flat.template chip<0>(index);
+              a += g.square();
+              v -= g.constant(lr_scalar) * g * a.rsqrt();
+            });
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", indices_vec(bad_i), " at offset ", bad_i,
+                        " in indices is out of range")));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1184,17 +1249,19 @@ class SparseApplyAdagradOp : public OpKernel {
         T lr_scalar = lr.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          T& a = accum_flat(index);
-          const T& g = grad_flat(i);
-          a += g * g;
-          var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-        }
+        const Tindex bad_i = ShardedRowUpdate<Tindex>(
+            ctx, indices_vec, first_dim_size, var_flat.data(),
+            kSparseApplyAdagradCost, !use_exclusive_lock_,
+            [&](int64 i, Tindex index) {
+              T& a = accum_flat(index);
+              const T& g = grad_flat(i);
+              a += g * g;
+              var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
+            });
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", indices_vec(bad_i), " at offset ", bad_i,
+                        " in indices is out of range")));
       }
     }
 
@@ -1286,6 +1353,9 @@ class SparseApplyProximalAdagradOp : public OpKernel {
     const Tensor& indices = ctx->input(6);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1}, indices);
+    });
 
     int64 inner_dim = 1;
     for (int d = 1; d < var.dims(); d++) {
@@ -1476,6 +1546,7 @@ class ApplyAdagradDAOp : public OpKernel {
         global_step.scalar<int64>()(), l1.scalar<T>(), l2.scalar<T>(),
         grad.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1552,6 +1623,9 @@ class SparseApplyAdagradDAOp : public OpKernel {
     const Tensor& indices = ctx->input(4);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1, 2}, indices);
+    });
 
     const Tensor& lr = ctx->input(5);
     OP_REQUIRES(ctx, IsLegacyScalar(lr.shape()),
@@ -1783,6 +1857,7 @@ class ApplyFtrlOp : public OpKernel {
                                     lr.scalar<T>(), l1.scalar<T>(),
                                     l2.scalar<T>(), lr_power.scalar<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1862,6 +1937,9 @@ class SparseApplyFtrlOp : public OpKernel {
     const Tensor& indices = ctx->input(4);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1, 2}, indices);
+    });
 
     const Tensor& lr = ctx->input(5);
     OP_REQUIRES(ctx,
@@ -1922,42 +2000,44 @@ class SparseApplyFtrlOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          auto accum = accum_flat.template chip<0>(index);
-          auto linear = linear_flat.template chip<0>(index);
-          auto grad = grad_flat.template chip<0>(i);
-          auto var = var_flat.template chip<0>(index);
-
-          auto new_accum = accum + grad.square();
-          if (lr_power_scalar == static_cast<T>(-0.5)) {
-            linear +=
-                grad - (new_accum.sqrt() - accum.sqrt()) / lr_scalar * var;
-          } else {
-            linear += grad -
-                      (new_accum.pow(-lr_power_scalar) -
-                       accum.pow(-lr_power_scalar)) /
-                          lr_scalar * var;
-          }
-          auto x = (linear.constant(l1_scalar) * linear.sign() - linear);
-          if (lr_power_scalar == static_cast<T>(-0.5)) {
-            auto y = new_accum.sqrt() / new_accum.constant(lr_scalar) +
-                     linear.constant(static_cast<T>(2) * l2_scalar);
-            var = x / y;
-          } else {
-            auto y = new_accum.pow(-lr_power_scalar) /
-                         new_accum.constant(lr_scalar) +
-                     linear.constant(static_cast<T>(2) * l2_scalar);
-            var = x / y;
-          }
-          var = (linear.abs() > linear.constant(l1_scalar))
-                    .select(var, var.constant(static_cast<T>(0)));
-          accum += grad.square();
-        }
+        const Tindex bad_i = ShardedRowUpdate<Tindex>(
+            ctx, indices_vec, first_dim_size, var_flat.data(),
+            inner_dim * kSparseApplyFtrlCost, !use_exclusive_lock_,
+            [&](int64 i, Tindex index) {
+              auto accum = accum_flat.template chip<0>(index);
+              auto linear = linear_flat.template chip<0>(index);
+              auto grad = grad_flat.template chip<0>(i);
+              auto var = var_flat.template chip<0>(index);
+
+              auto new_accum = accum + grad.square();
+              if (lr_power_scalar == static_cast<T>(-0.5)) {
+                linear +=
+                    grad - (new_accum.sqrt() - accum.sqrt()) / lr_scalar * var;
+              } else {
+                linear += grad -
+                          (new_accum.pow(-lr_power_scalar) -
+                           accum.pow(-lr_power_scalar)) /
+                              lr_scalar * var;
+              }
+              auto x = (linear.constant(l1_scalar) * linear.sign() - linear);
+              if (lr_power_scalar == static_cast<T>(-0.5)) {
+                auto y = new_accum.sqrt() / new_accum.constant(lr_scalar) +
+                         linear.constant(static_cast<T>(2) * l2_scalar);
+                var = x / y;
+              } else {
+                auto y = new_accum.pow(-lr_power_scalar) /
+                             new_accum.constant(lr_scalar) +
+                         linear.constant(static_cast<T>(2) * l2_scalar);
+                var = x / y;
+              }
+              var = (linear.abs() > linear.constant(l1_scalar))
+                        .select(var, var.constant(static_cast<T>(0)));
+              accum += grad.square();
+            });
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", indices_vec(bad_i), " at offset ", bad_i,
+                        " in indices is out of range")));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1970,27 +2050,30 @@ class SparseApplyFtrlOp : public OpKernel {
         T lr_power_scalar = lr_power.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
-          T& a = accum_flat(index);
-          T& l = linear_flat(index);
-          T& v = var_flat(index);
-          const T& g = grad_flat(i);
-
-          T updated_a = a + g * g;
-          using Eigen::numext::pow;
-          T sigma = pow(updated_a, -lr_power_scalar) - pow(a, -lr_power_scalar);
-          sigma /= lr_scalar;
-          T updated_l = l + g - sigma * v;
-          v = FtrlCompute(updated_a, updated_l, lr_scalar, l1_scalar, l2_scalar,
-                          lr_power_scalar);
-          a = updated_a;
-          l = updated_l;
-        }
+        const Tindex bad_i = ShardedRowUpdate<Tindex>(
+            ctx, indices_vec, first_dim_size, var_flat.data(),
+            kSparseApplyFtrlCost, !use_exclusive_lock_,
+            [&](int64 i, Tindex index) {
+              T& a = accum_flat(index);
+              T& l = linear_flat(index);
+              T& v = var_flat(index);
+              const T& g = grad_flat(i);
+
+              T updated_a = a + g * g;
+              using Eigen::numext::pow;
+              T sigma =
+                  pow(updated_a, -lr_power_scalar) - pow(a, -lr_power_scalar);
+              sigma /= lr_scalar;
+              T updated_l = l + g - sigma * v;
+              v = FtrlCompute(updated_a, updated_l, lr_scalar, l1_scalar,
+                              l2_scalar, lr_power_scalar);
+              a = updated_a;
+              l = updated_l;
+            });
+        OP_REQUIRES(ctx, bad_i < 0,
+                    errors::InvalidArgument(strings::StrCat(
+                        "Index ", indices_vec(bad_i), " at offset ", bad_i,
+                        " in indices is out of range")));
       }
     }
 
@@ -2074,6 +2157,7 @@ class ApplyMomentumOp : public OpKernel {
     functor::ApplyMomentum<Device, T>()(device, var.flat<T>(), accum.flat<T>(),
                                         lr.scalar<T>(), grad.flat<T>(),
                                         momentum.scalar<T>(), use_nesterov_);
+    MarkVariableInputsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2168,6 +2252,9 @@ class SparseApplyMomentumOp : public OpKernel {
     const Tensor& indices = ctx->input(4);
     OP_REQUIRES(ctx, TensorShapeUtils::IsVector(indices.shape()),
                 errors::InvalidArgument("indices must be one-dimensional"));
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1}, indices);
+    });
 
     for (int d = 1; d < var.dims(); d++) {
       OP_REQUIRES(ctx, var.dim_size(d) == grad.dim_size(d),
@@ -2324,6 +2411,7 @@ class ApplyAdamOp : public OpKernel {
                                     beta1.scalar<T>(), beta2.scalar<T>(),
                                     epsilon.scalar<T>(), grad.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2462,6 +2550,7 @@ class ApplyRMSPropOp : public OpKernel {
                                        rho.scalar<T>(), momentum.scalar<T>(),
                                        epsilon.scalar<T>(), grad.flat<T>());
 
+    MarkVariableInputsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2555,6 +2644,7 @@ class ApplyCenteredRMSPropOp : public OpKernel {
         device, var.flat<T>(), mg.flat<T>(), ms.flat<T>(), mom.flat<T>(),
         lr.scalar<T>(), rho.scalar<T>(), momentum.scalar<T>(),
         epsilon.scalar<T>(), grad.flat<T>());
+    MarkVariableInputsDirty(ctx, {0, 1, 2, 3});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2670,6 +2760,9 @@ class SparseApplyRMSPropOp : public OpKernel {
     const Tensor& epsilon = ctx->input(6);
     const Tensor& grad = ctx->input(7);
     const Tensor& indices = ctx->input(8);
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1, 2}, indices);
+    });
 
     OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
                 errors::InvalidArgument("lr is not a scalar: ",
@@ -2802,6 +2895,9 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
     const Tensor& epsilon = ctx->input(7);
     const Tensor& grad = ctx->input(8);
     const Tensor& indices = ctx->input(9);
+    auto mark_dirty = gtl::MakeCleanup([ctx, &indices] {
+      MarkVariableInputRowsDirty(ctx, {0, 1, 2, 3}, indices);
+    });
 
     OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
                 errors::InvalidArgument("lr is not a scalar: ",
@@ -2929,4 +3025,153 @@ REGISTER_KERNELS(double, int64);
 
 #undef REGISTER_KERNELS
 
+// Applies an update to many variables at once, see MultiApplyAdamUpdate.
+// The inputs of the op are the lists of the inputs of the apply op it
+// replaces, with 'N' tensors each.
+template <typename Device, typename T, typename Update>
+class MultiApplyOp : public OpKernel {
+ public:
+  explicit MultiApplyOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_vars_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    use_nesterov_ = false;
+    if (Update::kHasUseNesterov) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    // The variables and their slots are the first lists of inputs.
+    std::vector<int> variable_inputs((Update::kNumSlots + 1) * num_vars_);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    // Hold the variables until they are updated.
+    std::vector<Tensor> variables(variable_inputs.size());
+    for (int input : variable_inputs) {
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(
+                              ctx, input, use_exclusive_lock_,
+                              &variables[input]));
+      OP_REQUIRES(ctx, variables[input].IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables: ",
+                      def().input(input)));
+    }
+
+    functor::MultiApplyTensors<T, Update> tensors;
+    for (int i = 0; i < num_vars_; ++i) {
+      Tensor& var = variables[i];
+      tensors.var.push_back(var.flat<T>().data());
+      tensors.sizes.push_back(var.NumElements());
+      for (int j = 0; j < Update::kNumSlots; ++j) {
+        const int input = Update::SlotInput(j) * num_vars_ + i;
+        const Tensor& slot = variables[input];
+        OP_REQUIRES(ctx, var.shape().IsSameSize(slot.shape()),
+                    errors::InvalidArgument(
+                        "var and ", def().input(input),
+                        " do not have the same shape",
+                        var.shape().DebugString(), " ",
+                        slot.shape().DebugString()));
+        tensors.slots[j].push_back(const_cast<T*>(slot.flat<T>().data()));
+      }
+      for (int k = 0; k < Update::kNumScalars; ++k) {
+        const int input = Update::ScalarInput(k) * num_vars_ + i;
+        const Tensor& scalar = ctx->input(input);
+        OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scalar.shape()),
+                    errors::InvalidArgument(def().input(input),
+                                            " is not a scalar: ",
+                                            scalar.shape().DebugString()));
+        tensors.scalars[k].push_back(scalar.flat<T>().data());
+      }
+      const Tensor& grad = ctx->input(Update::kGradInput * num_vars_ + i);
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(grad.shape()),
+          errors::InvalidArgument("var and grad do not have the same shape",
+                                  var.shape().DebugString(), " ",
+                                  grad.shape().DebugString()));
+      tensors.grad.push_back(grad.flat<T>().data());
+    }
+
+    functor::MultiApply<Device, T, Update>()(ctx->eigen_device<Device>(),
+                                             tensors, use_nesterov_);
+
+    MarkVariableInputsDirty(ctx, variable_inputs);
+    for (int i = 0; i < num_vars_; ++i) {
+      MaybeForwardRefInputToRefOutput(ctx, i, i);
+    }
+  }
+
+ private:
+  int num_vars_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_KERNELS(D, T)                                                 \
+  REGISTER_KERNEL_BUILDER(                                                     \
+      Name("_MultiApplyAdam").Device(DEVICE_##D).TypeConstraint<T>("T"),       \
+      MultiApplyOp<D##Device, T, functor::MultiApplyAdamUpdate<T>>);           \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceMultiApplyAdam")                      \
+                              .HostMemory("var")                               \
+                              .HostMemory("m")                                 \
+                              .HostMemory("v")                                 \
+                              .Device(DEVICE_##D)                              \
+                              .TypeConstraint<T>("T"),                         \
+                          MultiApplyOp<D##Device, T,                           \
+                                       functor::MultiApplyAdamUpdate<T>>);     \
+  REGISTER_KERNEL_BUILDER(                                                     \
+      Name("_MultiApplyMomentum").Device(DEVICE_##D).TypeConstraint<T>("T"),   \
+      MultiApplyOp<D##Device, T, functor::MultiApplyMomentumUpdate<T>>);       \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceMultiApplyMomentum")                  \
+                              .HostMemory("var")                               \
+                              .HostMemory("accum")                             \
+                              .Device(DEVICE_##D)                              \
+                              .TypeConstraint<T>("T"),                         \
+                          MultiApplyOp<D##Device, T,                           \
+                                       functor::MultiApplyMomentumUpdate<T>>); \
+  REGISTER_KERNEL_BUILDER(                                                     \
+      Name("_MultiApplyRMSProp").Device(DEVICE_##D).TypeConstraint<T>("T"),    \
+      MultiApplyOp<D##Device, T, functor::MultiApplyRMSPropUpdate<T>>);        \
+  REGISTER_KERNEL_BUILDER(Name("_ResourceMultiApplyRMSProp")                   \
+                              .HostMemory("var")                               \
+                              .HostMemory("ms")                                \
+                              .HostMemory("mom")                               \
+                              .Device(DEVICE_##D)                              \
+                              .TypeConstraint<T>("T"),                         \
+                          MultiApplyOp<D##Device, T,                           \
+                                       functor::MultiApplyRMSPropUpdate<T>>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC_UPDATE(T, Update)                                \
+  template <>                                                             \
+  void MultiApply<GPUDevice, T, Update<T>>::operator()(                   \
+      const GPUDevice& d, const MultiApplyTensors<T, Update<T>>& tensors, \
+      bool use_nesterov);                                                 \
+  extern template struct MultiApply<GPUDevice, T, Update<T>>;
+#define DECLARE_GPU_SPEC(T)                             \
+  DECLARE_GPU_SPEC_UPDATE(T, MultiApplyAdamUpdate);     \
+  DECLARE_GPU_SPEC_UPDATE(T, MultiApplyMomentumUpdate); \
+  DECLARE_GPU_SPEC_UPDATE(T, MultiApplyRMSPropUpdate);
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+#undef DECLARE_GPU_SPEC_UPDATE
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_TRAINING_OPS_H_
 #define TENSORFLOW_KERNELS_TRAINING_OPS_H_
 
+#include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
@@ -148,6 +149,152 @@ struct ApplyCenteredRMSProp {
                   typename TTypes<T>::ConstScalar epsilon,
                   typename TTypes<T>::ConstFlat grad);
 };
+
+// The multi-tensor apply ops (_MultiApplyAdam etc.) update many variables at
+// once, in a single parallel loop on CPU and in a few kernel launches on GPU.
+// Each of them is described by an update struct below, which lists where the
+// slots, scalars and gradient of each variable are among the inputs of the op
+// and whether it has a use_nesterov attr, and computes the update of one
+// element of a variable and its slots.
+
+// The update of ApplyAdam. The slots are m and v, and the scalars
+// beta1_power, beta2_power, lr, beta1, beta2 and epsilon.
+template <typename T>
+struct MultiApplyAdamUpdate {
+  static constexpr bool kHasUseNesterov = false;
+  static constexpr int kNumSlots = 2;
+  static constexpr int kNumScalars = 6;
+  static constexpr int kGradInput = 9;
+  static constexpr int kComputeCycles = 20;
+  static int SlotInput(int slot) { return 1 + slot; }
+  static int ScalarInput(int scalar) { return 3 + scalar; }
+
+  struct Coefficients {
+    T alpha;
+    T one_minus_beta1;
+    T one_minus_beta2;
+    T epsilon;
+  };
+
+  EIGEN_DEVICE_FUNC static Coefficients GetCoefficients(
+      const T* const* scalars, bool use_nesterov) {
+    Coefficients c;
+    c.alpha = *scalars[2] * Eigen::numext::sqrt(T(1) - *scalars[1]) /
+              (T(1) - *scalars[0]);
+    c.one_minus_beta1 = T(1) - *scalars[3];
+    c.one_minus_beta2 = T(1) - *scalars[4];
+    c.epsilon = *scalars[5];
+    return c;
+  }
+
+  EIGEN_DEVICE_FUNC static void Apply(const Coefficients& c, int64 i, T* var,
+                                      T* const* slots, const T* grad) {
+    T& m = slots[0][i];
+    T& v = slots[1][i];
+    m += (grad[i] - m) * c.one_minus_beta1;
+    v += (grad[i] * grad[i] - v) * c.one_minus_beta2;
+    var[i] -= (m * c.alpha) / (Eigen::numext::sqrt(v) + c.epsilon);
+  }
+};
+
+// The update of ApplyMomentum. The slot is accum, and the scalars lr and
+// momentum.
+template <typename T>
+struct MultiApplyMomentumUpdate {
+  static constexpr bool kHasUseNesterov = true;
+  static constexpr int kNumSlots = 1;
+  static constexpr int kNumScalars = 2;
+  static constexpr int kGradInput = 3;
+  static constexpr int kComputeCycles = 4;
+  static int SlotInput(int slot) { return 1; }
+  static int ScalarInput(int scalar) { return scalar == 0 ? 2 : 4; }
+
+  struct Coefficients {
+    T lr;
+    T momentum;
+    bool use_nesterov;
+  };
+
+  EIGEN_DEVICE_FUNC static Coefficients GetCoefficients(
+      const T* const* scalars, bool use_nesterov) {
+    Coefficients c;
+    c.lr = *scalars[0];
+    c.momentum = *scalars[1];
+    c.use_nesterov = use_nesterov;
+    return c;
+  }
+
+  EIGEN_DEVICE_FUNC static void Apply(const Coefficients& c, int64 i, T* var,
+                                      T* const* slots, const T* grad) {
+    T& accum = slots[0][i];
+    accum = accum * c.momentum + grad[i];
+    if (c.use_nesterov) {
+      var[i] -= grad[i] * c.lr + accum * c.momentum * c.lr;
+    } else {
+      var[i] -= accum * c.lr;
+    }
+  }
+};
+
+// The update of ApplyRMSProp. The slots are ms and mom, and the scalars lr,
+// rho, momentum and epsilon.
+template <typename T>
+struct MultiApplyRMSPropUpdate {
+  static constexpr bool kHasUseNesterov = false;
+  static constexpr int kNumSlots = 2;
+  static constexpr int kNumScalars = 4;
+  static constexpr int kGradInput = 7;
+  static constexpr int kComputeCycles = 20;
+  static int SlotInput(int slot) { return 1 + slot; }
+  static int ScalarInput(int scalar) { return 3 + scalar; }
+
+  struct Coefficients {
+    T lr;
+    T one_minus_rho;
+    T momentum;
+    T epsilon;
+  };
+
+  EIGEN_DEVICE_FUNC static Coefficients GetCoefficients(
+      const T* const* scalars, bool use_nesterov) {
+    Coefficients c;
+    c.lr = *scalars[0];
+    c.one_minus_rho = T(1) - *scalars[1];
+    c.momentum = *scalars[2];
+    c.epsilon = *scalars[3];
+    return c;
+  }
+
+  EIGEN_DEVICE_FUNC static void Apply(const Coefficients& c, int64 i, T* var,
+                                      T* const* slots, const T* grad) {
+    T& ms = slots[0][i];
+    T& mom = slots[1][i];
+    ms += (grad[i] * grad[i] - ms) * c.one_minus_rho;
+    mom = mom * c.momentum +
+          (grad[i] * c.lr) / Eigen::numext::sqrt(ms + c.epsilon);
+    var[i] -= mom;
+  }
+};
+
+// The data of the tensors updated by a multi-tensor apply op: the variable
+// 'i' has 'sizes[i]' elements, which are updated from the slots
+// 'slots[j][i]', the scalars 'scalars[k][i]' and the gradient 'grad[i]'.
+// All of them are in the memory of the device.
+template <typename T, typename Update>
+struct MultiApplyTensors {
+  std::vector<T*> var;
+  std::vector<T*> slots[Update::kNumSlots];
+  std::vector<const T*> scalars[Update::kNumScalars];
+  std::vector<const T*> grad;
+  std::vector<int64> sizes;
+};
+
+template <typename Device, typename T, typename Update>
+struct MultiApply {
+  void operator()(const Device& d, const MultiApplyTensors<T, Update>& tensors,
+                  bool use_nesterov);
+};
+
 }  // end namespace functor
 }  // end namespace tensorflow
 
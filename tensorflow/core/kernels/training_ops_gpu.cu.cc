@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
@@ -179,6 +180,93 @@ struct ApplyCenteredRMSProp<GPUDevice, T> {
   }
 };
 
+namespace {
+
+// The data of the tensors of up to kMaxTensors variables updated by one
+// launch of MultiApplyKernel, which is passed them by value.
+template <typename T, typename Update>
+struct MultiApplyChunk {
+  static constexpr int kMaxTensors = 24;
+  T* var[kMaxTensors];
+  T* slots[Update::kNumSlots][kMaxTensors];
+  const T* scalars[Update::kNumScalars][kMaxTensors];
+  const T* grad[kMaxTensors];
+  // The element 'offsets[i]' of the chunk is the first of variable 'i'.
+  int offsets[kMaxTensors + 1];
+  int num_tensors;
+};
+
+template <typename T, typename Update>
+__global__ void MultiApplyKernel(const MultiApplyChunk<T, Update> chunk,
+                                 bool use_nesterov) {
+  // The consecutive elements of a thread are increasing, so it only moves
+  // forward through the variables.
+  int i = -1;
+  typename Update::Coefficients c;
+  T* slots[Update::kNumSlots];
+  CUDA_1D_KERNEL_LOOP(index, chunk.offsets[chunk.num_tensors]) {
+    if (i < 0 || index >= chunk.offsets[i + 1]) {
+      do {
+        ++i;
+      } while (index >= chunk.offsets[i + 1]);
+      const T* scalars[Update::kNumScalars];
+      for (int k = 0; k < Update::kNumScalars; ++k) {
+        scalars[k] = chunk.scalars[k][i];
+      }
+      c = Update::GetCoefficients(scalars, use_nesterov);
+      for (int j = 0; j < Update::kNumSlots; ++j) {
+        slots[j] = chunk.slots[j][i];
+      }
+    }
+    Update::Apply(c, index - chunk.offsets[i], chunk.var[i], slots,
+                  chunk.grad[i]);
+  }
+}
+
+}  // namespace
+
+template <typename T, typename Update>
+struct MultiApply<GPUDevice, T, Update> {
+  void operator()(const GPUDevice& d,
+                  const MultiApplyTensors<T, Update>& tensors,
+                  bool use_nesterov) {
+    typedef MultiApplyChunk<T, Update> Chunk;
+    const int num_tensors = tensors.var.size();
+    int begin = 0;
+    while (begin < num_tensors) {
+      // The chunks have at most kMaxTensors variables, and fewer elements
+      // than the kernel loop can index.
+      Chunk chunk;
+      chunk.num_tensors = 0;
+      chunk.offsets[0] = 0;
+      while (begin < num_tensors && chunk.num_tensors < Chunk::kMaxTensors &&
+             (chunk.num_tensors == 0 ||
+              chunk.offsets[chunk.num_tensors] + tensors.sizes[begin] <=
+                  kint32max)) {
+        const int i = chunk.num_tensors++;
+        chunk.var[i] = tensors.var[begin];
+        for (int j = 0; j < Update::kNumSlots; ++j) {
+          chunk.slots[j][i] = tensors.slots[j][begin];
+        }
+        for (int k = 0; k < Update::kNumScalars; ++k) {
+          chunk.scalars[k][i] = tensors.scalars[k][begin];
+        }
+        chunk.grad[i] = tensors.grad[begin];
+        chunk.offsets[i + 1] = chunk.offsets[i] + tensors.sizes[begin];
+        ++begin;
+      }
+      if (chunk.offsets[chunk.num_tensors] == 0) {
+        continue;
+      }
+      CudaLaunchConfig config =
+          GetCudaLaunchConfig(chunk.offsets[chunk.num_tensors], d);
+      MultiApplyKernel<T, Update>
+          <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+              chunk, use_nesterov);
+    }
+  }
+};
+
 }  // namespace functor
 
 template struct functor::ApplyGradientDescent<GPUDevice, Eigen::half>;
@@ -208,6 +296,18 @@ template struct functor::ApplyRMSProp<GPUDevice, double>;
 template struct functor::ApplyCenteredRMSProp<GPUDevice, Eigen::half>;
 template struct functor::ApplyCenteredRMSProp<GPUDevice, float>;
 template struct functor::ApplyCenteredRMSProp<GPUDevice, double>;
+
+#define DEFINE_GPU_SPEC(T)                                                   \
+  template struct functor::MultiApply<GPUDevice, T,                          \
+                                      functor::MultiApplyAdamUpdate<T>>;     \
+  template struct functor::MultiApply<GPUDevice, T,                          \
+                                      functor::MultiApplyMomentumUpdate<T>>; \
+  template struct functor::MultiApply<GPUDevice, T,                          \
+                                      functor::MultiApplyRMSPropUpdate<T>>;
+DEFINE_GPU_SPEC(Eigen::half);
+DEFINE_GPU_SPEC(float);
+DEFINE_GPU_SPEC(double);
+#undef DEFINE_GPU_SPEC
 }  // end namespace tensorflow
 
 #endif  // GOOGLE_CUDA
@@ -13,9 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
@@ -193,6 +202,178 @@ static void BM_Adam(int iters, int params) {
 }
 BENCHMARK(BM_Adam)->Arg(128 << 10)->Arg(256 << 10);
 
+// Updates 'num_vars' variables of 'n' elements with a single _MultiApplyAdam
+// node if 'multi_apply', or with one ApplyAdam node per variable.
+static void ManyAdam(int num_vars, int32 n, bool multi_apply, Graph** init_g,
+                     Graph** train_g) {
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    for (int i = 0; i < num_vars; ++i) {
+      for (int slot = 0; slot < 3; ++slot) {
+        test::graph::Assign(g, Var(g, n), Zeros(g, n));
+      }
+    }
+    *init_g = g;
+  }
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    // The inputs of the apply ops, in the order of their op.
+    std::vector<std::vector<NodeBuilder::NodeOut>> inputs(10);
+    const float scalars[] = {0.9, 0.99, 0.01, 0.9, 0.99, 1e-8};
+    for (int i = 0; i < num_vars; ++i) {
+      for (int slot = 0; slot < 3; ++slot) {
+        inputs[slot].push_back(Var(g, n));
+      }
+      for (int scalar = 0; scalar < 6; ++scalar) {
+        inputs[3 + scalar].push_back(Scalar(g, scalars[scalar]));
+      }
+      inputs[9].push_back(Random(g, n));
+    }
+    if (multi_apply) {
+      NodeBuilder builder(g->NewName("n"), "_MultiApplyAdam");
+      for (const auto& input : inputs) {
+        builder.Input(input);
+      }
+      TF_CHECK_OK(builder.Finalize(g, nullptr));
+    } else {
+      for (int i = 0; i < num_vars; ++i) {
+        std::vector<Node*> var_inputs;
+        for (const auto& input : inputs) {
+          var_inputs.push_back(input[i].node);
+        }
+        test::graph::Multi(g, "ApplyAdam", var_inputs);
+      }
+    }
+    *train_g = g;
+  }
+}
+
+static void BM_ManyAdam(int iters, int num_vars, int multi_apply) {
+  const int32 n = 1 << 10;
+  const int64 tot = static_cast<int64>(iters) * num_vars * n;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  Graph* init;
+  Graph* train;
+  ManyAdam(num_vars, n, multi_apply, &init, &train);
+  test::Benchmark("cpu", train, GetOptions(), init).Run(iters);
+}
+BENCHMARK(BM_ManyAdam)->ArgPair(100, 0)->ArgPair(100, 1);
+
+class MultiApplyOpTest : public OpsTestBase {};
+
+TEST_F(MultiApplyOpTest, MultiApplyAdam) {
+  TF_ASSERT_OK(NodeDefBuilder("multi_apply", "_MultiApplyAdam")
+                   .Input(FakeInput(2, DT_FLOAT_REF))
+                   .Input(FakeInput(2, DT_FLOAT_REF))
+                   .Input(FakeInput(2, DT_FLOAT_REF))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<std::vector<float>> var = {{1, 2, 3}, {4, 5}};
+  const std::vector<std::vector<float>> m = {{0.1, 0.2, 0.3}, {0.4, 0.5}};
+  const std::vector<std::vector<float>> v = {{0.5, 0.4, 0.3}, {0.2, 0.1}};
+  const std::vector<std::vector<float>> grad = {{-1, 0, 1}, {2, -2}};
+  // beta1_power, beta2_power, lr, beta1, beta2 and epsilon, which differ
+  // between the variables.
+  const std::vector<std::vector<float>> scalars = {
+      {0.9, 0.8}, {0.99, 0.98}, {0.1, 0.2}, {0.9, 0.8}, {0.99, 0.98},
+      {1e-3, 1e-2}};
+  for (const auto* input : {&var, &m, &v}) {
+    for (const auto& values : *input) {
+      AddInputFromArray<float>(TensorShape({static_cast<int64>(values.size())}),
+                               values);
+    }
+  }
+  for (const auto& values : scalars) {
+    for (float value : values) {
+      AddInputFromArray<float>(TensorShape({}), {value});
+    }
+  }
+  for (const auto& values : grad) {
+    AddInputFromArray<float>(TensorShape({static_cast<int64>(values.size())}),
+                             values);
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int i = 0; i < 2; ++i) {
+    const float beta1_power = scalars[0][i];
+    const float beta2_power = scalars[1][i];
+    const float lr = scalars[2][i];
+    const float beta1 = scalars[3][i];
+    const float beta2 = scalars[4][i];
+    const float epsilon = scalars[5][i];
+    const float alpha = lr * std::sqrt(1 - beta2_power) / (1 - beta1_power);
+    const int64 size = var[i].size();
+    Tensor expected_var(DT_FLOAT, TensorShape({size}));
+    Tensor expected_m(DT_FLOAT, TensorShape({size}));
+    Tensor expected_v(DT_FLOAT, TensorShape({size}));
+    for (int64 j = 0; j < size; ++j) {
+      const float new_m = m[i][j] + (grad[i][j] - m[i][j]) * (1 - beta1);
+      const float new_v =
+          v[i][j] + (grad[i][j] * grad[i][j] - v[i][j]) * (1 - beta2);
+      expected_m.flat<float>()(j) = new_m;
+      expected_v.flat<float>()(j) = new_v;
+      expected_var.flat<float>()(j) =
+          var[i][j] - new_m * alpha / (std::sqrt(new_v) + epsilon);
+    }
+    test::ExpectTensorNear<float>(expected_var, *mutable_input(i).tensor,
+                                  1e-5);
+    test::ExpectTensorNear<float>(expected_m, *mutable_input(2 + i).tensor,
+                                  1e-5);
+    test::ExpectTensorNear<float>(expected_v, *mutable_input(4 + i).tensor,
+                                  1e-5);
+    test::ExpectTensorNear<float>(expected_var, *GetOutput(i), 1e-5);
+  }
+}
+
+TEST_F(MultiApplyOpTest, MultiApplyMomentumNesterov) {
+  TF_ASSERT_OK(NodeDefBuilder("multi_apply", "_MultiApplyMomentum")
+                   .Input(FakeInput(2, DT_FLOAT_REF))
+                   .Input(FakeInput(2, DT_FLOAT_REF))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Input(FakeInput(2, DT_FLOAT))
+                   .Attr("use_nesterov", true)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});       // var[0]
+  AddInputFromArray<float>(TensorShape({1}), {3});          // var[1]
+  AddInputFromArray<float>(TensorShape({2}), {0.5, -0.5});  // accum[0]
+  AddInputFromArray<float>(TensorShape({1}), {1});          // accum[1]
+  AddInputFromArray<float>(TensorShape({}), {0.1});         // lr[0]
+  AddInputFromArray<float>(TensorShape({}), {0.2});         // lr[1]
+  AddInputFromArray<float>(TensorShape({2}), {1, -1});      // grad[0]
+  AddInputFromArray<float>(TensorShape({1}), {2});          // grad[1]
+  AddInputFromArray<float>(TensorShape({}), {0.9});         // momentum[0]
+  AddInputFromArray<float>(TensorShape({}), {0.5});         // momentum[1]
+  TF_ASSERT_OK(RunOpKernel());
+
+  // accum = accum * momentum + grad
+  // var -= grad * lr + accum * momentum * lr
+  Tensor expected_accum0(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_accum0, {1.45, -1.45});
+  Tensor expected_accum1(DT_FLOAT, TensorShape({1}));
+  test::FillValues<float>(&expected_accum1, {2.5});
+  Tensor expected_var0(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&expected_var0, {1 - 0.1 - 1.45 * 0.9 * 0.1,
+                                           2 + 0.1 + 1.45 * 0.9 * 0.1});
+  Tensor expected_var1(DT_FLOAT, TensorShape({1}));
+  test::FillValues<float>(&expected_var1, {3 - 2 * 0.2 - 2.5 * 0.5 * 0.2});
+  test::ExpectTensorNear<float>(expected_var0, *mutable_input(0).tensor, 1e-5);
+  test::ExpectTensorNear<float>(expected_var1, *mutable_input(1).tensor, 1e-5);
+  test::ExpectTensorNear<float>(expected_accum0, *mutable_input(2).tensor,
+                                1e-5);
+  test::ExpectTensorNear<float>(expected_accum1, *mutable_input(3).tensor,
+                                1e-5);
+}
+
 static void RMSProp(int32 n, Graph** init_g, Graph** train_g) {
   TensorShape shape({n});
   {
@@ -233,4 +414,118 @@ static void BM_RMSProp(int iters, int params) {
 }
 BENCHMARK(BM_RMSProp)->Arg(128 << 10)->Arg(256 << 10);
 
+// The sparse apply kernels update rows in parallel, so their benchmarks run
+// with the default number of threads.
+static SessionOptions* GetMultiThreadedOptions() {
+  static SessionOptions opts;
+  return &opts;
+}
+
+static const int kSparseRows = 64 << 10;
+static const int kSparseCols = 64;
+
+static Node* SparseVar(Graph* g) {
+  return test::graph::Var(g, DT_FLOAT, TensorShape({kSparseRows, kSparseCols}));
+}
+
+static Node* SparseRandom(Graph* g, int rows) {
+  Tensor data(DT_FLOAT, TensorShape({rows, kSparseCols}));
+  data.flat<float>().setRandom();
+  return test::graph::Constant(g, data);
+}
+
+// Indices of `n` rows of a sparse variable, a quarter of which are repeated.
+static Node* SparseIndices(Graph* g, int n) {
+  Tensor data(DT_INT32, TensorShape({n}));
+  auto indices = data.flat<int32>();
+  for (int i = 0; i < n; ++i) {
+    indices(i) = (i % 4 == 0 ? i / 4 : i) * 7919 % kSparseRows;
+  }
+  return test::graph::Constant(g, data);
+}
+
+static void SparseAdagrad(int32 n, bool use_locking, Graph** init_g,
+                          Graph** train_g) {
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    auto var = SparseVar(g);
+    auto accum = SparseVar(g);
+    test::graph::Assign(g, var, SparseRandom(g, kSparseRows));
+    test::graph::Assign(g, accum, SparseRandom(g, kSparseRows));
+    *init_g = g;
+  }
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    Node* ret;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseApplyAdagrad")
+                    .Input(SparseVar(g))
+                    .Input(SparseVar(g))
+                    .Input(Scalar(g, 0.01))
+                    .Input(SparseRandom(g, n))
+                    .Input(SparseIndices(g, n))
+                    .Attr("use_locking", use_locking)
+                    .Finalize(g, &ret));
+    *train_g = g;
+  }
+}
+
+static void BM_SparseAdagrad(int iters, int updates, int use_locking) {
+  const int64 tot = static_cast<int64>(iters) * updates * kSparseCols;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  Graph* init;
+  Graph* train;
+  SparseAdagrad(updates, use_locking, &init, &train);
+  test::Benchmark("cpu", train, GetMultiThreadedOptions(), init).Run(iters);
+}
+BENCHMARK(BM_SparseAdagrad)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(16 << 10, 0)
+    ->ArgPair(16 << 10, 1);
+
+static void SparseFtrl(int32 n, bool use_locking, Graph** init_g,
+                       Graph** train_g) {
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    auto var = SparseVar(g);
+    auto accum = SparseVar(g);
+    auto linear = SparseVar(g);
+    test::graph::Assign(g, var, SparseRandom(g, kSparseRows));
+    test::graph::Assign(g, accum, SparseRandom(g, kSparseRows));
+    test::graph::Assign(g, linear, SparseRandom(g, kSparseRows));
+    *init_g = g;
+  }
+  {
+    Graph* g = new Graph(OpRegistry::Global());
+    Node* ret;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseApplyFtrl")
+                    .Input(SparseVar(g))
+                    .Input(SparseVar(g))
+                    .Input(SparseVar(g))
+                    .Input(SparseRandom(g, n))
+                    .Input(SparseIndices(g, n))
+                    .Input(Scalar(g, 0.01))
+                    .Input(Scalar(g, 0.001))
+                    .Input(Scalar(g, 0.001))
+                    .Input(Scalar(g, -0.5))
+                    .Attr("use_locking", use_locking)
+                    .Finalize(g, &ret));
+    *train_g = g;
+  }
+}
+
+static void BM_SparseFtrl(int iters, int updates, int use_locking) {
+  const int64 tot = static_cast<int64>(iters) * updates * kSparseCols;
+  testing::ItemsProcessed(tot);
+  testing::BytesProcessed(tot * sizeof(float));
+  Graph* init;
+  Graph* train;
+  SparseFtrl(updates, use_locking, &init, &train);
+  test::Benchmark("cpu", train, GetMultiThreadedOptions(), init).Run(iters);
+}
+BENCHMARK(BM_SparseFtrl)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(16 << 10, 0)
+    ->ArgPair(16 << 10, 1);
+
 }  // end namespace tensorflow
@@ -17,6 +17,13 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/transpose_functor.h"
 
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace tensorflow {
 namespace internal {
 
@@ -59,6 +66,245 @@ void TransposeUsingEigen(const Device& d, const Tensor& in,
   y.device(d) = x.shuffle(p);
 }
 
+namespace {
+
+// Transposes the kSize x kSize block of 'src', whose rows are 'src_stride'
+// elements apart, into 'dst', whose rows are 'dst_stride' elements apart.
+// Types with SSE2 shuffles transpose blocks of a vector register width.
+template <typename T>
+struct TransposeMicroKernel {
+  static constexpr int kSize = 1;
+  static void Run(const T* src, int64 src_stride, T* dst, int64 dst_stride) {
+    *dst = *src;
+  }
+};
+
+#if defined(__SSE2__)
+template <>
+struct TransposeMicroKernel<uint8> {
+  static constexpr int kSize = 8;
+  static void Run(const uint8* src, int64 src_stride, uint8* dst,
+                  int64 dst_stride) {
+    __m128i r[8];
+    for (int i = 0; i < 8; ++i) {
+      r[i] = _mm_loadl_epi64(
+          reinterpret_cast<const __m128i*>(src + i * src_stride));
+    }
+    // Interleave the bytes of pairs of rows, then the pairs of bytes of pairs
+    // of those, then the quadruples, so that each register holds two columns.
+    const __m128i t0 = _mm_unpacklo_epi8(r[0], r[1]);
+    const __m128i t1 = _mm_unpacklo_epi8(r[2], r[3]);
+    const __m128i t2 = _mm_unpacklo_epi8(r[4], r[5]);
+    const __m128i t3 = _mm_unpacklo_epi8(r[6], r[7]);
+    const __m128i u0 = _mm_unpacklo_epi16(t0, t1);
+    const __m128i u1 = _mm_unpackhi_epi16(t0, t1);
+    const __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+    const __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+    const __m128i v[4] = {
+        _mm_unpacklo_epi32(u0, u2), _mm_unpackhi_epi32(u0, u2),
+        _mm_unpacklo_epi32(u1, u3), _mm_unpackhi_epi32(u1, u3)};
+    for (int i = 0; i < 4; ++i) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 2 * i * dst_stride),
+                       v[i]);
+      _mm_storel_epi64(
+          reinterpret_cast<__m128i*>(dst + (2 * i + 1) * dst_stride),
+          _mm_unpackhi_epi64(v[i], v[i]));
+    }
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint16> {
+  static constexpr int kSize = 8;
+  static void Run(const uint16* src, int64 src_stride, uint16* dst,
+                  int64 dst_stride) {
+    __m128i r[8];
+    for (int i = 0; i < 8; ++i) {
+      r[i] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(src + i * src_stride));
+    }
+    __m128i t[8];
+    for (int i = 0; i < 4; ++i) {
+      t[2 * i] = _mm_unpacklo_epi16(r[2 * i], r[2 * i + 1]);
+      t[2 * i + 1] = _mm_unpackhi_epi16(r[2 * i], r[2 * i + 1]);
+    }
+    // u[2 * k] and u[2 * k + 1] hold columns 2 * k and 2 * k + 1 of the rows
+    // 0 to 3 and 4 to 7 respectively.
+    __m128i u[8];
+    for (int i = 0; i < 2; ++i) {
+      u[4 * i] = _mm_unpacklo_epi32(t[4 * i], t[4 * i + 2]);
+      u[4 * i + 1] = _mm_unpackhi_epi32(t[4 * i], t[4 * i + 2]);
+      u[4 * i + 2] = _mm_unpacklo_epi32(t[4 * i + 1], t[4 * i + 3]);
+      u[4 * i + 3] = _mm_unpackhi_epi32(t[4 * i + 1], t[4 * i + 3]);
+    }
+    for (int i = 0; i < 4; ++i) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i * dst_stride),
+                       _mm_unpacklo_epi64(u[i], u[i + 4]));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dst + (2 * i + 1) * dst_stride),
+          _mm_unpackhi_epi64(u[i], u[i + 4]));
+    }
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint32> {
+  static constexpr int kSize = 4;
+  static void Run(const uint32* src, int64 src_stride, uint32* dst,
+                  int64 dst_stride) {
+    // The shuffles move the bits unchanged, whatever the type.
+    __m128 r0 = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+    __m128 r1 = _mm_loadu_ps(reinterpret_cast<const float*>(src + src_stride));
+    __m128 r2 =
+        _mm_loadu_ps(reinterpret_cast<const float*>(src + 2 * src_stride));
+    __m128 r3 =
+        _mm_loadu_ps(reinterpret_cast<const float*>(src + 3 * src_stride));
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(reinterpret_cast<float*>(dst), r0);
+    _mm_storeu_ps(reinterpret_cast<float*>(dst + dst_stride), r1);
+    _mm_storeu_ps(reinterpret_cast<float*>(dst + 2 * dst_stride), r2);
+    _mm_storeu_ps(reinterpret_cast<float*>(dst + 3 * dst_stride), r3);
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint64> {
+  static constexpr int kSize = 2;
+  static void Run(const uint64* src, int64 src_stride, uint64* dst,
+                  int64 dst_stride) {
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i r1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + src_stride));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_unpacklo_epi64(r0, r1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride),
+                     _mm_unpackhi_epi64(r0, r1));
+  }
+};
+#endif  // __SSE2__
+
+// Transposes the rows x cols matrix 'src', whose rows are 'src_stride'
+// elements apart, into 'dst', whose rows are 'dst_stride' elements apart.
+template <typename T>
+void TransposeTile(const T* src, int64 src_stride, T* dst, int64 dst_stride,
+                   int64 rows, int64 cols) {
+  typedef TransposeMicroKernel<T> MicroKernel;
+  const int64 k = MicroKernel::kSize;
+  int64 r = 0;
+  for (; r + k <= rows; r += k) {
+    int64 c = 0;
+    for (; c + k <= cols; c += k) {
+      MicroKernel::Run(src + r * src_stride + c, src_stride,
+                       dst + c * dst_stride + r, dst_stride);
+    }
+    for (; c < cols; ++c) {
+      for (int64 i = r; i < r + k; ++i) {
+        dst[c * dst_stride + i] = src[i * src_stride + c];
+      }
+    }
+  }
+  for (; r < rows; ++r) {
+    for (int64 c = 0; c < cols; ++c) {
+      dst[c * dst_stride + r] = src[r * src_stride + c];
+    }
+  }
+}
+
+// Transposes each of the 'batch' rows x cols matrices of 'src' into 'dst'.
+// The matrices are split into tiles small enough for the rows of a tile of the
+// source and of the destination to stay in the L1 cache, and the tiles are
+// transposed in parallel.
+template <typename T>
+void TransposeBatchedMatrices(const Eigen::ThreadPoolDevice& d, const T* src,
+                              T* dst, int64 batch, int64 rows, int64 cols) {
+  const int64 kTileSize = 64;
+  const int64 row_tiles = (rows + kTileSize - 1) / kTileSize;
+  const int64 col_tiles = (cols + kTileSize - 1) / kTileSize;
+  const int64 matrix_size = rows * cols;
+  auto work = [=](int64 first, int64 last) {
+    for (int64 tile = first; tile < last; ++tile) {
+      const int64 b = tile / (row_tiles * col_tiles);
+      const int64 r = (tile / col_tiles) % row_tiles * kTileSize;
+      const int64 c = tile % col_tiles * kTileSize;
+      TransposeTile(src + b * matrix_size + r * cols + c, cols,
+                    dst + b * matrix_size + c * rows + r, rows,
+                    std::min(kTileSize, rows - r),
+                    std::min(kTileSize, cols - c));
+    }
+  };
+  const double tile_bytes = kTileSize * kTileSize * sizeof(T);
+  d.parallelFor(batch * row_tiles * col_tiles,
+                Eigen::TensorOpCost(tile_bytes, tile_bytes,
+                                    kTileSize * kTileSize),
+                work);
+}
+
+// Transposes 'src' of shape 'dims' by 'perm' into 'dst', when the permutation
+// keeps the innermost dimension in place, by copying its contiguous rows.
+template <typename T>
+void TransposeRows(const Eigen::ThreadPoolDevice& d, const T* src, T* dst,
+                   const TransposeDimsVec& dims,
+                   const TransposePermsVec& perm) {
+  const int ndims = dims.size();
+  TransposeDimsVec in_strides(ndims);
+  int64 stride = 1;
+  for (int i = ndims - 1; i >= 0; --i) {
+    in_strides[i] = stride;
+    stride *= dims[i];
+  }
+  const int64 row_size = dims[ndims - 1];
+  const int64 num_rows = stride / row_size;
+  auto work = [&](int64 first, int64 last) {
+    for (int64 row = first; row < last; ++row) {
+      int64 in_offset = 0;
+      int64 t = row;
+      for (int i = ndims - 2; i >= 0; --i) {
+        in_offset += (t % dims[perm[i]]) * in_strides[perm[i]];
+        t /= dims[perm[i]];
+      }
+      memcpy(dst + row * row_size, src + in_offset, row_size * sizeof(T));
+    }
+  };
+  const double row_bytes = row_size * sizeof(T);
+  d.parallelFor(num_rows, Eigen::TensorOpCost(row_bytes, row_bytes, 4 * ndims),
+                work);
+}
+
+// Transposes 'in' into 'out' with native kernels, given the dimensions and
+// permutation computed by ReduceTransposeDimensions.  Returns false if neither
+// applies, in which case 'out' is untouched.
+template <typename T>
+bool TransposeNative(const Eigen::ThreadPoolDevice& d, const Tensor& in,
+                     const TransposeDimsVec& dims,
+                     const TransposePermsVec& perm, Tensor* out) {
+  const T* src = reinterpret_cast<const T*>(in.tensor_data().data());
+  T* dst = reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data()));
+  const int ndims = dims.size();
+  if (ndims == 1) {
+    memcpy(dst, src, in.tensor_data().size());
+  } else if (ndims == 2) {
+    TransposeBatchedMatrices(d, src, dst, 1, dims[0], dims[1]);
+  } else if (ndims == 3 && perm[0] == 0 && perm[1] == 2) {
+    // This is the case of the NHWC <-> NCHW layout conversions.
+    TransposeBatchedMatrices(d, src, dst, dims[0], dims[1], dims[2]);
+  } else if (perm[ndims - 1] == ndims - 1) {
+    TransposeRows(d, src, dst, dims, perm);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Strings are not trivially copyable.
+template <>
+bool TransposeNative<string>(const Eigen::ThreadPoolDevice& d,
+                             const Tensor& in, const TransposeDimsVec& dims,
+                             const TransposePermsVec& perm, Tensor* out) {
+  return false;
+}
+
+}  // namespace
+
 }  // end namespace internal
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -67,6 +313,36 @@ template <typename T>
 struct Transpose<CPUDevice, T> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+    if (in.NumElements() == 0) return;
+    // Merge the dimensions which stay next to each other, which turns most
+    // transposes into batched matrix transposes or row copies.
+    internal::TransposePermsVec new_perm;
+    internal::TransposeDimsVec new_dims;
+    internal::ReduceTransposeDimensions(in.shape(), perm, &new_perm,
+                                        &new_dims);
+    if (internal::TransposeNative<T>(d, in, new_dims, new_perm, out)) {
+      return;
+    }
+    const int new_ndims = new_perm.size();
+    if (new_ndims < 2 || new_ndims == in.dims()) {
+      TransposeUsingEigenOrSimple(d, in, perm, out);
+      return;
+    }
+    TensorShape in_shape, out_shape;
+    for (int i = 0; i < new_ndims; ++i) {
+      in_shape.AddDim(new_dims[i]);
+      out_shape.AddDim(new_dims[new_perm[i]]);
+    }
+    Tensor in_view, out_view;
+    CHECK(in_view.CopyFrom(in, in_shape));
+    CHECK(out_view.CopyFrom(*out, out_shape));
+    TransposeUsingEigenOrSimple(d, in_view, new_perm, &out_view);
+  }
+
+ private:
+  static void TransposeUsingEigenOrSimple(const CPUDevice& d, const Tensor& in,
+                                          const gtl::ArraySlice<int32> perm,
+                                          Tensor* out) {
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, out);
@@ -13,10 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 namespace tensorflow {
 
@@ -98,4 +103,135 @@ TEST_F(TransposeUtilTest, LargeDimensionReduction) {
                          {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {0}, {72576000});
 }
 
+// Returns 'in' transposed by 'perm', one element at a time.
+template <typename T>
+Tensor ReferenceTranspose(const Tensor& in, const gtl::ArraySlice<int32> perm) {
+  const int ndims = in.dims();
+  TensorShape out_shape;
+  for (int i = 0; i < ndims; ++i) out_shape.AddDim(in.dim_size(perm[i]));
+  Tensor out(in.dtype(), out_shape);
+  gtl::InlinedVector<int64, 8> in_strides(ndims);
+  internal::ComputeStride(in.shape(), in_strides.data());
+  auto in_flat = in.flat<T>();
+  auto out_flat = out.flat<T>();
+  for (int64 o = 0; o < out.NumElements(); ++o) {
+    int64 i = 0;
+    int64 t = o;
+    for (int d = ndims - 1; d >= 0; --d) {
+      i += (t % out_shape.dim_size(d)) * in_strides[perm[d]];
+      t /= out_shape.dim_size(d);
+    }
+    out_flat(o) = in_flat(i);
+  }
+  return out;
+}
+
+template <typename T>
+void TestTranspose(const Eigen::ThreadPoolDevice& device,
+                   const TensorShape& shape,
+                   const gtl::ArraySlice<int32> perm) {
+  Tensor in(DataTypeToEnum<T>::value, shape);
+  auto in_flat = in.flat<T>();
+  for (int64 i = 0; i < in.NumElements(); ++i) {
+    in_flat(i) = static_cast<T>(i * 7 + 3);
+  }
+  Tensor expected = ReferenceTranspose<T>(in, perm);
+  Tensor out(in.dtype(), expected.shape());
+  TF_ASSERT_OK(DoTranspose(device, in, perm, &out));
+  test::ExpectTensorEqual<T>(expected, out);
+}
+
+TEST(TransposeTest, MatchesReference) {
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, 4);
+  const std::vector<std::pair<TensorShape, std::vector<int32>>> cases = {
+      // Matrix transposes, with sizes that aren't multiples of the tiles.
+      {{37, 29}, {1, 0}},
+      {{200, 131}, {1, 0}},
+      {{3, 1}, {1, 0}},
+      // NHWC <-> NCHW.
+      {{2, 9, 11, 19}, {0, 3, 1, 2}},
+      {{2, 19, 9, 11}, {0, 2, 3, 1}},
+      // The innermost dimension stays in place.
+      {{5, 6, 7}, {1, 0, 2}},
+      {{2, 3, 4, 5}, {2, 0, 1, 3}},
+      // Neither case, which are left to Eigen.
+      {{5, 6, 7}, {2, 1, 0}},
+      {{2, 3, 4, 5, 6, 7}, {5, 3, 1, 4, 0, 2}},
+      // Identity.
+      {{4, 5}, {0, 1}},
+      // Empty.
+      {{0, 5}, {1, 0}},
+  };
+  for (const auto& c : cases) {
+    TestTranspose<uint8>(device, c.first, c.second);
+    TestTranspose<int16>(device, c.first, c.second);
+    TestTranspose<float>(device, c.first, c.second);
+    TestTranspose<double>(device, c.first, c.second);
+    TestTranspose<complex128>(device, c.first, c.second);
+  }
+}
+
+TEST(TransposeTest, Strings) {
+  Eigen::ThreadPool pool(2);
+  Eigen::ThreadPoolDevice device(&pool, 2);
+  Tensor in(DT_STRING, TensorShape({2, 3}));
+  test::FillValues<string>(&in, {"a", "b", "c", "d", "e", "f"});
+  Tensor out(DT_STRING, TensorShape({3, 2}));
+  TF_ASSERT_OK(DoTranspose(device, in, {1, 0}, &out));
+  Tensor expected(DT_STRING, TensorShape({3, 2}));
+  test::FillValues<string>(&expected, {"a", "d", "b", "e", "c", "f"});
+  test::ExpectTensorEqual<string>(expected, out);
+}
+
+template <typename T>
+static void BM_Transpose(int iters, const TensorShape& shape,
+                         const gtl::ArraySlice<int32> perm, int num_threads) {
+  testing::StopTiming();
+  Eigen::ThreadPool pool(num_threads);
+  Eigen::ThreadPoolDevice device(&pool, num_threads);
+  Tensor in(DataTypeToEnum<T>::value, shape);
+  in.flat<T>().setZero();
+  TensorShape out_shape;
+  for (int i = 0; i < shape.dims(); ++i) {
+    out_shape.AddDim(shape.dim_size(perm[i]));
+  }
+  Tensor out(in.dtype(), out_shape);
+  testing::BytesProcessed(static_cast<int64>(iters) * in.TotalBytes() * 2);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(DoTranspose(device, in, perm, &out));
+  }
+}
+
+static void BM_TransposeMatrixUint8(int iters, int threads) {
+  BM_Transpose<uint8>(iters, {2048, 2048}, {1, 0}, threads);
+}
+BENCHMARK(BM_TransposeMatrixUint8)->Arg(1)->Arg(4);
+
+static void BM_TransposeMatrixFloat(int iters, int threads) {
+  BM_Transpose<float>(iters, {2048, 2048}, {1, 0}, threads);
+}
+BENCHMARK(BM_TransposeMatrixFloat)->Arg(1)->Arg(4);
+
+static void BM_TransposeMatrixDouble(int iters, int threads) {
+  BM_Transpose<double>(iters, {2048, 2048}, {1, 0}, threads);
+}
+BENCHMARK(BM_TransposeMatrixDouble)->Arg(1)->Arg(4);
+
+static void BM_TransposeNHWCToNCHW(int iters, int threads) {
+  BM_Transpose<float>(iters, {32, 56, 56, 64}, {0, 3, 1, 2}, threads);
+}
+BENCHMARK(BM_TransposeNHWCToNCHW)->Arg(1)->Arg(4);
+
+static void BM_TransposeNCHWToNHWC(int iters, int threads) {
+  BM_Transpose<float>(iters, {32, 64, 56, 56}, {0, 2, 3, 1}, threads);
+}
+BENCHMARK(BM_TransposeNCHWToNHWC)->Arg(1)->Arg(4);
+
+static void BM_TransposeHalfNHWCToNCHW(int iters, int threads) {
+  BM_Transpose<Eigen::half>(iters, {32, 56, 56, 64}, {0, 3, 1, 2}, threads);
+}
+BENCHMARK(BM_TransposeHalfNHWCToNCHW)->Arg(1)->Arg(4);
+
 }  // namespace tensorflow
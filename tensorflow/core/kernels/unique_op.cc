@@ -13,19 +13,114 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <unordered_map>
-#include <utility>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Inputs with fewer elements than this are deduplicated by a single thread.
+const int64 kMinParallelUniqueSize = 32 * 1024;
+
+// The maximum number of shards the values are partitioned into by hash, so
+// that the shard of each element fits in a byte.
+const int kMaxUniqueShards = 64;
+
+// The estimated cost of hashing a value.
+const int64 kUniqueHashCost = 10;
+
+// Returns the hash of 'value'. std::hash is the identity for the integers,
+// so it is mixed with the murmur3 finalizer for both its low bits, which
+// select the slot, and its high bits, which select the shard, to spread the
+// values.
+template <typename T>
+inline uint64 UniqueHash(const T& value) {
+  uint64 h = std::hash<T>()(value);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// An open addressing hash table assigning ids to the distinct values of the
+// input in the order of their first occurrence. The values are not copied:
+// each id refers to the position of the first occurrence of its value.
+template <typename T>
+class UniqueTable {
+ public:
+  explicit UniqueTable(typename TTypes<T>::ConstVec input)
+      : input_(input), slots_(16, -1) {}
+
+  // Returns the id of the value at position 'i' of the input, whose hash is
+  // 'hash', assigning it the next id if it wasn't seen before.
+  int32 Insert(int64 i, uint64 hash) {
+    if (2 * (first_.size() + 1) > slots_.size()) {
+      Grow();
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+      const int32 id = slots_[slot];
+      if (id < 0) {
+        slots_[slot] = first_.size();
+        first_.push_back(i);
+        hashes_.push_back(hash);
+        return slots_[slot];
+      }
+      if (hashes_[id] == hash && input_(first_[id]) == input_(i)) {
+        return id;
+      }
+    }
+  }
+
+  // The number of distinct values.
+  int32 size() const { return first_.size(); }
+
+  // The position of the first occurrence of the value with id 'id'.
+  int32 first(int32 id) const { return first_[id]; }
+
+ private:
+  void Grow() {
+    std::vector<int32> slots(2 * slots_.size(), -1);
+    const size_t mask = slots.size() - 1;
+    for (int32 id = 0; id < size(); ++id) {
+      size_t slot = hashes_[id] & mask;
+      while (slots[slot] >= 0) {
+        slot = (slot + 1) & mask;
+      }
+      slots[slot] = id;
+    }
+    slots_.swap(slots);
+  }
+
+  typename TTypes<T>::ConstVec input_;
+  // The id of the value in each slot, or -1 if the slot is empty.
+  std::vector<int32> slots_;
+  // The position of the first occurrence and the hash of each value.
+  std::vector<int32> first_;
+  std::vector<uint64> hashes_;
+};
+
+}  // namespace
+
+// Deduplicates the input in parallel: the values are partitioned into shards
+// by hash, the distinct values of each shard are found by a thread of its
+// own, then they are numbered in the order of their first occurrence, which
+// is the order of the output.
 template <typename T>
 class UniqueOp : public OpKernel {
  public:
@@ -45,38 +140,146 @@ class UniqueOp : public OpKernel {
     auto Tin = input.vec<T>();
     const int64 N = static_cast<int64>(Tin.size());
 
+    // The ids are computed in the output before the input is read entirely,
+    // so it can't be forwarded.
     Tensor* idx = nullptr;
-    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
-                                {0}, 1, input.shape(), &idx));
+    OP_REQUIRES_OK(context, context->allocate_output(1, input.shape(), &idx));
     auto idx_vec = idx->template vec<int32>();
 
-    std::unordered_map<T, int32> uniq;
-    uniq.reserve(2 * N);
-    for (int64 i = 0, j = 0; i < N; ++i) {
-      auto it = uniq.insert(std::make_pair(Tin(i), j));
-      idx_vec(i) = it.first->second;
-      if (it.second) {
-        ++j;
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int num_shards =
+        N < kMinParallelUniqueSize
+            ? 1
+            : std::min(worker_threads.num_threads, kMaxUniqueShards);
+    const bool with_counts = num_outputs() > 2;
+
+    std::vector<uint8> shard_of;
+    if (num_shards > 1) {
+      shard_of.resize(N);
+      Shard(worker_threads.num_threads, worker_threads.workers, N,
+            kUniqueHashCost, [&](int64 start, int64 limit) {
+              for (int64 i = start; i < limit; ++i) {
+                shard_of[i] = (UniqueHash(Tin(i)) >> 32) % num_shards;
+              }
+            });
+    }
+
+    // Find the distinct values of each shard, and the id of the value of
+    // each element among them.
+    std::vector<std::unique_ptr<UniqueTable<T>>> tables(num_shards);
+    std::vector<std::vector<int32>> counts(num_shards);
+    std::vector<uint8> is_first;
+    if (num_shards > 1) {
+      is_first.resize(N, 0);
+    }
+    auto find_distinct = [&](int64 start, int64 limit) {
+      for (int64 shard = start; shard < limit; ++shard) {
+        tables[shard].reset(new UniqueTable<T>(Tin));
+        UniqueTable<T>* table = tables[shard].get();
+        std::vector<int32>* shard_counts = &counts[shard];
+        for (int64 i = 0; i < N; ++i) {
+          if (num_shards > 1 && shard_of[i] != shard) {
+            continue;
+          }
+          const int32 id = table->Insert(i, UniqueHash(Tin(i)));
+          idx_vec(i) = id;
+          if (num_shards > 1 && table->first(id) == i) {
+            is_first[i] = 1;
+          }
+          if (with_counts) {
+            if (static_cast<size_t>(id) == shard_counts->size()) {
+              shard_counts->push_back(0);
+            }
+            ++(*shard_counts)[id];
+          }
+        }
+      }
+    };
+    if (num_shards == 1) {
+      find_distinct(0, 1);
+    } else {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_shards,
+            N * kUniqueHashCost, find_distinct);
+    }
+
+    int64 uniq_size = 0;
+    for (const auto& table : tables) {
+      uniq_size += table->size();
+    }
+
+    // Number the distinct values of the shards in the order of their first
+    // occurrence, by counting the first occurrences in blocks of the input.
+    std::vector<std::vector<int32>> global_ids(num_shards);
+    if (num_shards > 1) {
+      for (int shard = 0; shard < num_shards; ++shard) {
+        global_ids[shard].resize(tables[shard]->size());
+      }
+      const int64 num_blocks = 4 * num_shards;
+      const int64 block_size = (N + num_blocks - 1) / num_blocks;
+      std::vector<int32> block_offsets(num_blocks + 1, 0);
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            block_size, [&](int64 start, int64 limit) {
+              for (int64 block = start; block < limit; ++block) {
+                const int64 begin = std::min(N, block * block_size);
+                const int64 end = std::min(N, begin + block_size);
+                block_offsets[block + 1] = std::count(
+                    is_first.begin() + begin, is_first.begin() + end, 1);
+              }
+            });
+      for (int64 block = 0; block < num_blocks; ++block) {
+        block_offsets[block + 1] += block_offsets[block];
       }
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            block_size, [&](int64 start, int64 limit) {
+              for (int64 block = start; block < limit; ++block) {
+                int32 global_id = block_offsets[block];
+                const int64 begin = std::min(N, block * block_size);
+                const int64 end = std::min(N, begin + block_size);
+                for (int64 i = begin; i < end; ++i) {
+                  if (is_first[i]) {
+                    global_ids[shard_of[i]][idx_vec(i)] = global_id++;
+                  }
+                }
+              }
+            });
+      Shard(worker_threads.num_threads, worker_threads.workers, N, 1,
+            [&](int64 start, int64 limit) {
+              for (int64 i = start; i < limit; ++i) {
+                idx_vec(i) = global_ids[shard_of[i]][idx_vec(i)];
+              }
+            });
     }
-    int64 uniq_size = static_cast<int64>(uniq.size());
+
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(
                                 0, TensorShape({uniq_size}), &output));
     auto output_vec = output->template vec<T>();
-
-    for (auto it : uniq) {
-      output_vec(it.second) = it.first;
+    Tensor* count_output = nullptr;
+    if (with_counts) {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(2, TensorShape({uniq_size}),
+                                              &count_output));
     }
-
-    if (num_outputs() > 2) {
-      OP_REQUIRES_OK(context, context->allocate_output(
-                                  2, TensorShape({uniq_size}), &output));
-      auto count_output_vec = output->template vec<int32>();
-      count_output_vec.setZero();
-      for (int64 i = 0; i < N; ++i) {
-        count_output_vec(idx_vec(i))++;
+    auto write_outputs = [&](int64 start, int64 limit) {
+      for (int64 shard = start; shard < limit; ++shard) {
+        const UniqueTable<T>& table = *tables[shard];
+        for (int32 id = 0; id < table.size(); ++id) {
+          const int32 global_id =
+              num_shards == 1 ? id : global_ids[shard][id];
+          output_vec(global_id) = Tin(table.first(id));
+          if (with_counts) {
+            count_output->template vec<int32>()(global_id) =
+                counts[shard][id];
+          }
+        }
       }
+    };
+    if (num_shards == 1) {
+      write_outputs(0, 1);
+    } else {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_shards,
+            uniq_size / num_shards + 1, write_outputs);
     }
   }
 };
@@ -116,4 +319,22 @@ REGISTER_KERNEL_BUILDER(Name("Unique")
                             .HostMemory("y")
                             .HostMemory("idx"),
                         UniqueOp<int64>);
+REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")
+                            .Device(DEVICE_GPU)
+                            .TypeConstraint<int32>("T")
+                            .TypeConstraint<int32>("out_idx")
+                            .HostMemory("x")
+                            .HostMemory("y")
+                            .HostMemory("idx")
+                            .HostMemory("count"),
+                        UniqueOp<int32>);
+REGISTER_KERNEL_BUILDER(Name("UniqueWithCounts")
+                            .Device(DEVICE_GPU)
+                            .TypeConstraint<int64>("T")
+                            .TypeConstraint<int32>("out_idx")
+                            .HostMemory("x")
+                            .HostMemory("y")
+                            .HostMemory("idx")
+                            .HostMemory("count"),
+                        UniqueOp<int64>);
 }  // namespace tensorflow
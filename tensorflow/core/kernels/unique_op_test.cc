@@ -96,7 +96,8 @@ BENCHMARK(BM_Unique_INT32)
     ->Arg(4 * 1024)
     ->Arg(16 * 1024)
     ->Arg(64 * 1024)
-    ->Arg(256 * 1024);
+    ->Arg(256 * 1024)
+    ->Arg(1024 * 1024);
 
 BENCHMARK(BM_Unique_STRING)
     ->Arg(32)
@@ -105,7 +106,8 @@ BENCHMARK(BM_Unique_STRING)
     ->Arg(4 * 1024)
     ->Arg(16 * 1024)
     ->Arg(64 * 1024)
-    ->Arg(256 * 1024);
+    ->Arg(256 * 1024)
+    ->Arg(1024 * 1024);
 
 }  // namespace
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_VARIABLE_OPS_H_
 #define TENSORFLOW_KERNELS_VARIABLE_OPS_H_
 
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -39,10 +41,72 @@ class Var : public ResourceBase {
                            tensor_.shape().DebugString());
   }
 
+  // Delta checkpoints (see the SaveDeltaV2 op) save only the rows of tensor()
+  // changed since the variable was last saved.  Kernels updating rows given
+  // by "indices", an int32 or int64 tensor, call MarkDirtyRows() after the
+  // update; every other update calls MarkDirty() after it to mark the whole
+  // variable.  These take their own mutex rather than mu(), as updates may run
+  // without holding mu().
+  void MarkDirtyRows(const Tensor& indices) {
+    mutex_lock l(dirty_mu_);
+    if (all_dirty_) return;
+    if (indices.dtype() == DT_INT32) {
+      MarkDirtyRowsLocked<int32>(indices);
+    } else if (indices.dtype() == DT_INT64) {
+      MarkDirtyRowsLocked<int64>(indices);
+    } else {
+      all_dirty_ = true;
+    }
+  }
+
+  void MarkDirty() {
+    mutex_lock l(dirty_mu_);
+    all_dirty_ = true;
+  }
+
+  // Returns true if the whole variable changed since the last call.
+  // Otherwise stores the rows that changed, in ascending order, in "rows".
+  // Either way, tracking starts anew for a tensor() with "num_rows" rows.
+  // Before the first call, the whole variable counts as changed.
+  bool TakeDirtyRows(int64 num_rows, std::vector<int64>* rows) {
+    mutex_lock l(dirty_mu_);
+    const bool all_dirty = all_dirty_;
+    rows->clear();
+    if (!all_dirty) {
+      for (int64 row = 0; row < dirty_rows_.size(); ++row) {
+        if (dirty_rows_[row]) rows->push_back(row);
+      }
+    }
+    all_dirty_ = false;
+    dirty_rows_.assign(num_rows, false);
+    return all_dirty;
+  }
+
  private:
+  template <typename Index>
+  void MarkDirtyRowsLocked(const Tensor& indices)
+      EXCLUSIVE_LOCKS_REQUIRED(dirty_mu_) {
+    const int64 num_rows = dirty_rows_.size();
+    const auto indices_flat = indices.flat<Index>();
+    for (int64 i = 0; i < indices_flat.size(); ++i) {
+      const int64 row = indices_flat(i);
+      if (row < 0 || row >= num_rows) {
+        // The variable was resized, or the update failed on this index.
+        all_dirty_ = true;
+        return;
+      }
+      dirty_rows_[row] = true;
+    }
+  }
+
   mutex mu_;
   Tensor tensor_;
 
+  mutex dirty_mu_;
+  bool all_dirty_ GUARDED_BY(dirty_mu_) = true;
+  // One bit per row of tensor(), set for the rows that changed.
+  std::vector<bool> dirty_rows_ GUARDED_BY(dirty_mu_);
+
   ~Var() override {}
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
 };
@@ -372,6 +372,115 @@ void WinogradTransform<T>::GetOutputTransformMatrix(const int64 rows,
   transform_matrix[3 * cols + 15] = T(1.0);
 };
 
+namespace winograd_internal {
+
+// Sets the 'rows' x 'cols' 'transform_matrix' to the kronecker product
+// 'M * M' of the 'm_rows' x 'm_cols' matrix 'M', given in row-major order.
+template <typename T>
+void SetKroneckerSquare(const double* m, const int64 m_rows,
+                        const int64 m_cols, const int64 rows, const int64 cols,
+                        T* transform_matrix) {
+  CHECK_EQ(rows, m_rows * m_rows);
+  CHECK_EQ(cols, m_cols * m_cols);
+  for (int64 i0 = 0; i0 < m_rows; ++i0) {
+    for (int64 i1 = 0; i1 < m_rows; ++i1) {
+      for (int64 j0 = 0; j0 < m_cols; ++j0) {
+        for (int64 j1 = 0; j1 < m_cols; ++j1) {
+          transform_matrix[(i0 * m_rows + i1) * cols + j0 * m_cols + j1] =
+              T(m[i0 * m_cols + j0] * m[i1 * m_cols + j1]);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace winograd_internal
+
+// Winograd F(4x4, 3x3) DeepConv2DTransform implementation for 3x3 filters,
+// which computes 4x4 output tiles from 6x6 input tiles. It takes 2.25 times
+// fewer multiplications per output than WinogradTransform above, but its
+// larger transforms are less precise.
+// Details:
+// *) Fast Algorithms for Convolutional Neural Networks: Lavin, Gray
+template <typename T>
+class WinogradF4x4Transform : public DeepConv2DTransform<T> {
+ public:
+  typedef typename DeepConv2DTransform<T>::Shape Shape;
+
+  WinogradF4x4Transform()
+      : filter_shape_(3, 3), input_shape_(6, 6), output_shape_(4, 4) {}
+
+  // The filter transform matrix is the kronecker product 'M * M' of the
+  // following matrix 'M':
+  //
+  //   [ 1/4   0     0    ]
+  //   [-1/6  -1/6  -1/6  ]
+  //   [-1/6   1/6  -1/6  ]
+  //   [ 1/24  1/12  1/6  ]
+  //   [ 1/24 -1/12  1/6  ]
+  //   [ 0     0     1    ]
+  //
+  // The data layout of 'transform_matrix':
+  //   [input_tile_spatial_size, filter_spatial_size]
+  virtual void GetFilterTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const {
+    static const double kMatrix[] = {
+        1.0 / 4,  0.0,       0.0,      -1.0 / 6, -1.0 / 6, -1.0 / 6,
+        -1.0 / 6, 1.0 / 6,   -1.0 / 6, 1.0 / 24, 1.0 / 12, 1.0 / 6,
+        1.0 / 24, -1.0 / 12, 1.0 / 6,  0.0,      0.0,      1.0};
+    winograd_internal::SetKroneckerSquare(kMatrix, 6, 3, rows, cols,
+                                          transform_matrix);
+  }
+
+  // The input transform matrix is the kronecker product 'M * M' of the
+  // following matrix 'M':
+  //
+  //   [4   0  -5   0   1   0]
+  //   [0  -4  -4   1   1   0]
+  //   [0   4  -4  -1   1   0]
+  //   [0  -2  -1   2   1   0]
+  //   [0   2  -1  -2   1   0]
+  //   [0   4   0  -5   0   1]
+  //
+  // Data layout of 'transform_matrix':
+  //   [tile_spatial_size, tile_spatial_size]
+  virtual void GetInputTransformMatrix(const int64 rows, const int64 cols,
+                                       T* transform_matrix) const {
+    static const double kMatrix[] = {
+        4, 0,  -5, 0,  1, 0, 0, -4, -4, 1,  1, 0, 0, 4, -4, -1, 1, 0,
+        0, -2, -1, 2,  1, 0, 0, 2,  -1, -2, 1, 0, 0, 4, 0,  -5, 0, 1};
+    winograd_internal::SetKroneckerSquare(kMatrix, 6, 6, rows, cols,
+                                          transform_matrix);
+  }
+
+  // The output transform matrix is the kronecker product 'M * M' of the
+  // following matrix 'M':
+  //
+  //   [1  1  1  1  1  0]
+  //   [0  1 -1  2 -2  0]
+  //   [0  1  1  4  4  0]
+  //   [0  1 -1  8 -8  1]
+  //
+  // Data layout of 'transform_matrix':
+  //   [out_tile_spatial_size, tile_spatial_size]
+  virtual void GetOutputTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const {
+    static const double kMatrix[] = {1, 1, 1,  1, 1, 0, 0, 1, -1, 2, -2, 0,
+                                     0, 1, 1,  4, 4, 0, 0, 1, -1, 8, -8, 1};
+    winograd_internal::SetKroneckerSquare(kMatrix, 4, 6, rows, cols,
+                                          transform_matrix);
+  }
+
+  virtual const Shape& filter_shape() const { return filter_shape_; }
+  virtual const Shape& input_shape() const { return input_shape_; }
+  virtual const Shape& output_shape() const { return output_shape_; }
+
+ private:
+  const Shape filter_shape_;
+  const Shape input_shape_;
+  const Shape output_shape_;
+};
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <algorithm>
+#include <atomic>
+
 #define EIGEN_USE_THREADS
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -49,6 +53,11 @@ struct EigenEnvironment {
 
   EnvThread* CreateThread(std::function<void()> f) {
     return env_->StartThread(thread_options_, name_, [=]() {
+      if (thread_options_.numa_node != port::kNUMANoAffinity &&
+          !port::NUMASetThreadNodeAffinity(thread_options_.numa_node)) {
+        LOG(WARNING) << "Could not bind thread of " << name_
+                     << " to NUMA node " << thread_options_.numa_node;
+      }
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
       // Set the processor rounding mode to ROUND TO NEAREST.
@@ -90,15 +99,19 @@ struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
             num_threads, low_latency_hint,
             EigenEnvironment(env, thread_options, name)) {}
 
-  void ParallelFor(int64 total, int64 cost_per_unit,
+  // The ParallelFor cost model sizes the blocks for "num_threads" threads.
+  void ParallelFor(int64 total, int64 cost_per_unit, int num_threads,
                    std::function<void(int64, int64)> fn) {
     CHECK_GE(total, 0);
     CHECK_EQ(total, (int64)(Eigen::Index)total);
-    Eigen::ThreadPoolDevice device(this, this->NumThreads());
+    Eigen::ThreadPoolDevice device(this, num_threads);
     device.parallelFor(
         total, Eigen::TensorOpCost(0, 0, cost_per_unit),
         [&fn](Eigen::Index first, Eigen::Index last) { fn(first, last); });
   }
+
+  // The number of ParallelRegions alive on the pool.
+  std::atomic<int> num_parallel_regions{0};
 };
 
 ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
@@ -125,13 +138,16 @@ void ThreadPool::Schedule(std::function<void()> fn) {
 
 void ThreadPool::ParallelFor(int64 total, int64 cost_per_unit,
                              std::function<void(int64, int64)> fn) {
-  impl_->ParallelFor(total, cost_per_unit, std::move(fn));
+  ParallelRegion region(this);
+  impl_->ParallelFor(total, cost_per_unit, region.num_threads(),
+                     std::move(fn));
 }
 
 void ThreadPool::ParallelForWithWorkerId(
     int64 total, int64 cost_per_unit,
     const std::function<void(int64, int64, int)>& fn) {
-  impl_->ParallelFor(total, cost_per_unit,
+  ParallelRegion region(this);
+  impl_->ParallelFor(total, cost_per_unit, region.num_threads(),
                      [this, &fn](int64 start, int64 limit) {
                        // ParallelFor may use the current thread to do some
                        // work synchronously. When calling CurrentThreadId()
@@ -146,5 +162,14 @@ int ThreadPool::NumThreads() const { return impl_->NumThreads(); }
 
 int ThreadPool::CurrentThreadId() const { return impl_->CurrentThreadId(); }
 
+ThreadPool::ParallelRegion::ParallelRegion(ThreadPool* pool) : pool_(pool) {
+  const int num_regions = pool_->impl_->num_parallel_regions.fetch_add(1) + 1;
+  num_threads_ = std::max(1, pool_->NumThreads() / num_regions);
+}
+
+ThreadPool::ParallelRegion::~ParallelRegion() {
+  pool_->impl_->num_parallel_regions.fetch_sub(1);
+}
+
 }  // namespace thread
 }  // namespace tensorflow
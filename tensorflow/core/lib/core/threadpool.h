@@ -98,6 +98,25 @@ class ThreadPool {
   // thread in the pool. Returns -1 otherwise.
   int CurrentThreadId() const;
 
+  // A ParallelFor or Shard call in progress on the pool.  The threads of the
+  // pool are split evenly between the regions that are running when one
+  // starts, so that ops parallelizing at once (e.g. from the inter-op
+  // threads) create fewer, larger shards instead of oversubscribing the
+  // pool.
+  class ParallelRegion {
+   public:
+    explicit ParallelRegion(ThreadPool* pool);
+    ~ParallelRegion();
+
+    // Returns the number of threads, at least 1, this region should use.
+    int num_threads() const { return num_threads_; }
+
+   private:
+    ThreadPool* const pool_;
+    int num_threads_;
+    TF_DISALLOW_COPY_AND_ASSIGN(ParallelRegion);
+  };
+
   struct Impl;
 
  private:
@@ -80,6 +80,27 @@ TEST(ThreadPool, ParallelFor) {
   }
 }
 
+TEST(ThreadPool, ParallelRegionsSplitThreads) {
+  ThreadPool pool(Env::Default(), "test", 8);
+  ThreadPool::ParallelRegion first(&pool);
+  EXPECT_EQ(8, first.num_threads());
+  {
+    ThreadPool::ParallelRegion second(&pool);
+    EXPECT_EQ(4, second.num_threads());
+    ThreadPool::ParallelRegion third(&pool);
+    EXPECT_EQ(2, third.num_threads());
+  }
+  ThreadPool::ParallelRegion fourth(&pool);
+  EXPECT_EQ(4, fourth.num_threads());
+  ThreadPool::ParallelRegion fifth(&pool);
+  ThreadPool::ParallelRegion sixth(&pool);
+  ThreadPool::ParallelRegion seventh(&pool);
+  ThreadPool::ParallelRegion eighth(&pool);
+  ThreadPool::ParallelRegion ninth(&pool);
+  ThreadPool::ParallelRegion tenth(&pool);
+  EXPECT_EQ(1, tenth.num_threads());
+}
+
 TEST(ThreadPool, ParallelForWithWorkerId) {
   // Make ParallelForWithWorkerId use as many threads as possible.
   int64 kHugeCost = 1 << 30;
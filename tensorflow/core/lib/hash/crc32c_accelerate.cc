@@ -16,20 +16,26 @@ limitations under the License.
 #include <stddef.h>
 #include <stdint.h>
 
-// SSE4.2 accelerated CRC32c.
+#include "tensorflow/core/platform/cpu_info.h"
+
+// Hardware accelerated CRC32c, with the SSE4.2 crc32 instruction on x86-64,
+// and the CRC32 extension on ARMv8.
+//
+// The x86-64 version is compiled for SSE4.2 whatever the target of the rest
+// of the build, and only used if the CPU running it supports SSE4.2.  The
+// ARMv8 version needs the build to target the CRC32 extension.
 
-// See if the SSE4.2 crc32c instruction is available.
 #undef USE_SSE_CRC32C
-#ifdef __SSE4_2__
-#if defined(__x86_64__) && defined(__GNUC__) && \
-    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+#undef USE_ARM_CRC32C
+#if defined(__x86_64__) && defined(__clang__)
 #define USE_SSE_CRC32C 1
-#elif defined(__x86_64__) && defined(__clang__)
-#if __has_builtin(__builtin_cpu_supports)
+#elif defined(__x86_64__) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
 #define USE_SSE_CRC32C 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && \
+    defined(__linux__)
+#define USE_ARM_CRC32C 1
 #endif
-#endif
-#endif /* __SSE4_2__ */
 
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
@@ -37,14 +43,24 @@ limitations under the License.
 #undef USE_SSE_CRC32C
 #endif
 
-#ifdef USE_SSE_CRC32C
+#if defined(USE_SSE_CRC32C)
 #include <nmmintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#define CRC32C_U8(crc, v) _mm_crc32_u8(crc, v)
+#define CRC32C_U64(crc, v) _mm_crc32_u64(crc, v)
+#elif defined(USE_ARM_CRC32C)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define CRC32C_TARGET
+#define CRC32C_U8(crc, v) __crc32cb(crc, v)
+#define CRC32C_U64(crc, v) __crc32cd(crc, v)
 #endif
 
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,39 +70,139 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
-bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+namespace {
+
+// Large buffers are split into three streams of kLongBlock (or kShortBlock)
+// bytes, whose crcs are computed together to hide the latency of the crc32
+// instruction, and then combined.
+const size_t kLongBlock = 8192;
+const size_t kShortBlock = 256;
+
+// The reflected CRC32c polynomial.
+const uint32_t kPoly = 0x82f63b78;
+
+// Multiplies the 32x32 matrix over GF(2) "mat" by the vector "vec".
+uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  while (vec) {
+    if (vec & 1) sum ^= *mat;
+    vec >>= 1;
+    mat++;
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = Gf2MatrixTimes(mat, mat[n]);
+  }
+}
+
+// Tables that advance a crc over "len" zero bytes, a power of two, a byte of
+// the crc at a time.  Appending "len" bytes with crc "b" to a string with
+// crc "a" gives Shift(a) ^ b, for the crcs before their final inversion.
+class ZerosOperator {
+ public:
+  explicit ZerosOperator(size_t len) {
+    // The operator for one zero bit, then two and four zero bits.
+    uint32_t odd[32];
+    uint32_t even[32];
+    odd[0] = kPoly;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = row;
+      row <<= 1;
+    }
+    Gf2MatrixSquare(even, odd);
+    Gf2MatrixSquare(odd, even);
+    // Squares the operator for each bit of len, starting with one byte.
+    const uint32_t *op = odd;
+    while (len > 0) {
+      Gf2MatrixSquare(even, odd);
+      op = even;
+      len >>= 1;
+      if (len == 0) break;
+      Gf2MatrixSquare(odd, even);
+      op = odd;
+      len >>= 1;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      table_[0][n] = Gf2MatrixTimes(op, n);
+      table_[1][n] = Gf2MatrixTimes(op, n << 8);
+      table_[2][n] = Gf2MatrixTimes(op, n << 16);
+      table_[3][n] = Gf2MatrixTimes(op, n << 24);
+    }
+  }
+
+  uint32_t Shift(uint32_t crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+
+ private:
+  uint32_t table_[4][256];
+};
+
+// Computes the crcs of the three consecutive blocks of "block" bytes at "p",
+// the first one continuing from "crc", and returns the crc of all three.
+template <size_t block>
+CRC32C_TARGET uint64_t ExtendThreeBlocks(uint64_t crc, const uint8_t *p,
+                                         const ZerosOperator &shift) {
+  uint64_t crc1 = 0;
+  uint64_t crc2 = 0;
+  const uint8_t *end = p + block;
+  do {
+    crc = CRC32C_U64(crc, *reinterpret_cast<const uint64_t *>(p));
+    crc1 = CRC32C_U64(crc1, *reinterpret_cast<const uint64_t *>(p + block));
+    crc2 =
+        CRC32C_U64(crc2, *reinterpret_cast<const uint64_t *>(p + 2 * block));
+    p += 8;
+  } while (p < end);
+  crc = shift.Shift(crc) ^ crc1;
+  return shift.Shift(crc) ^ crc2;
+}
+
+}  // namespace
+
+#if defined(USE_SSE_CRC32C)
+bool CanAccelerate() { return port::TestCPUFeature(port::SSE4_2); }
+#else
+bool CanAccelerate() { return getauxval(AT_HWCAP) & HWCAP_CRC32; }
+#endif
+
+CRC32C_TARGET uint32_t AcceleratedExtend(uint32_t crc, const char *buf,
+                                         size_t size) {
+  static const ZerosOperator *long_shift = new ZerosOperator(kLongBlock);
+  static const ZerosOperator *short_shift = new ZerosOperator(kShortBlock);
 
-uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
 
-  // Advance p until aligned to 8-bytes..
-  // Point x at first 7-byte aligned byte in string.  This might be
-  // just past the end of the string.
-  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
-  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 7) >> 3) << 3);
-  if (x <= e) {
-    // Process bytes until finished or p is 8-byte aligned
-    while (p != x) {
-      l = _mm_crc32_u8(l, *p);
-      p++;
-    }
+  // Process bytes until finished or p is 8-byte aligned.
+  while (p != e && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    l = CRC32C_U8(l, *p);
+    p++;
   }
 
-  // Process bytes 16 at a time
   uint64_t l64 = l;
-  while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
-    p += 16;
+  while (static_cast<size_t>(e - p) >= 3 * kLongBlock) {
+    l64 = ExtendThreeBlocks<kLongBlock>(l64, p, *long_shift);
+    p += 3 * kLongBlock;
+  }
+  while (static_cast<size_t>(e - p) >= 3 * kShortBlock) {
+    l64 = ExtendThreeBlocks<kShortBlock>(l64, p, *short_shift);
+    p += 3 * kShortBlock;
   }
 
-  // Process remaining bytes one at a time.
+  // Process bytes 8 at a time, then the remaining bytes one at a time.
+  while ((e - p) >= 8) {
+    l64 = CRC32C_U64(l64, *reinterpret_cast<const uint64_t *>(p));
+    p += 8;
+  }
   l = l64;
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = CRC32C_U8(l, *p);
     p++;
   }
 
@@ -56,6 +56,36 @@ TEST(CRC, StandardResults) {
             Value(reinterpret_cast<char*>(data) + 1, sizeof(data) - 4));
 }
 
+// A bit at a time implementation, to check the table-driven and the
+// accelerated ones against.
+static uint32 BitwiseExtend(uint32 crc, const char* data, size_t n) {
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= static_cast<uint8>(data[i]);
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0x82f63b78 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+TEST(CRC, LargeUnalignedBuffers) {
+  // Covers the sizes around the blocks of three interleaved streams used by
+  // the accelerated code, of 3 * 256 and 3 * 8192 bytes.
+  string data(100000, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 131 + (i >> 7));
+  }
+  for (size_t n : {100, 767, 768, 769, 1000, 24575, 24576, 24577, 99992}) {
+    for (int offset = 0; offset < 8; ++offset) {
+      const uint32 init_crc = n * 7919 + offset;
+      ASSERT_EQ(BitwiseExtend(init_crc, data.data() + offset, n),
+                Extend(init_crc, data.data() + offset, n))
+          << "size " << n << ", offset " << offset;
+    }
+  }
+}
+
 TEST(CRC, Values) { ASSERT_NE(Value("a", 1), Value("foo", 3)); }
 
 TEST(CRC, Extend) {
@@ -79,7 +109,7 @@ static void BM_CRC(int iters, int len) {
   testing::BytesProcessed(static_cast<int64>(iters) * len);
   VLOG(1) << h;
 }
-BENCHMARK(BM_CRC)->Range(1, 256 * 1024);
+BENCHMARK(BM_CRC)->Range(1, 16 * 1024 * 1024);
 
 }  // namespace crc32c
 }  // namespace tensorflow
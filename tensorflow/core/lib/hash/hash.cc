@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/raw_coding.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 
 #include <string.h>
@@ -76,11 +77,19 @@ uint32 Hash32(const char* data, size_t n, uint32 seed) {
   return h;
 }
 
-uint64 Hash64(const char* data, size_t n, uint64 seed) {
-  const uint64 m = 0xc6a4a7935bd1e995;
-  const int r = 47;
+namespace {
+
+const uint64 kHash64Mul = 0xc6a4a7935bd1e995;
+const int kHash64Shift = 47;
+
+inline uint64 Hash64Init(size_t n, uint64 seed) {
+  return seed ^ (n * kHash64Mul);
+}
 
-  uint64 h = seed ^ (n * m);
+// Mixes the n bytes at data into the initial hash h.
+uint64 Hash64Finish(const char* data, size_t n, uint64 h) {
+  const uint64 m = kHash64Mul;
+  const int r = kHash64Shift;
 
   while (n >= 8) {
     uint64 k = core::DecodeFixed64(data);
@@ -95,28 +104,18 @@ uint64 Hash64(const char* data, size_t n, uint64 seed) {
     h *= m;
   }
 
-  switch (n) {
-    case 7:
-      h ^= ByteAs64(data[6]) << 48;
-      TF_FALLTHROUGH_INTENDED;
-    case 6:
-      h ^= ByteAs64(data[5]) << 40;
-      TF_FALLTHROUGH_INTENDED;
-    case 5:
-      h ^= ByteAs64(data[4]) << 32;
-      TF_FALLTHROUGH_INTENDED;
-    case 4:
-      h ^= ByteAs64(data[3]) << 24;
-      TF_FALLTHROUGH_INTENDED;
-    case 3:
-      h ^= ByteAs64(data[2]) << 16;
-      TF_FALLTHROUGH_INTENDED;
-    case 2:
-      h ^= ByteAs64(data[1]) << 8;
-      TF_FALLTHROUGH_INTENDED;
-    case 1:
-      h ^= ByteAs64(data[0]);
-      h *= m;
+  // Mixes in the remaining n < 8 bytes as a little-endian word. The bytes
+  // are read with loads that may overlap, rather than one at a time: the
+  // branches of a switch on n are mispredicted on keys of mixed lengths.
+  if (n >= 4) {
+    const uint64 lo = core::DecodeFixed32(data);
+    const uint64 hi = core::DecodeFixed32(data + n - 4);
+    h ^= lo | (hi << (8 * (n - 4)));
+    h *= m;
+  } else if (n > 0) {
+    h ^= ByteAs64(data[0]) | (ByteAs64(data[n / 2]) << (8 * (n / 2))) |
+         (ByteAs64(data[n - 1]) << (8 * (n - 1)));
+    h *= m;
   }
 
   h ^= h >> r;
@@ -126,4 +125,25 @@ uint64 Hash64(const char* data, size_t n, uint64 seed) {
   return h;
 }
 
+}  // namespace
+
+uint64 Hash64(const char* data, size_t n, uint64 seed) {
+  return Hash64Finish(data, n, Hash64Init(n, seed));
+}
+
+void Hash64Batch(const string* keys, size_t num_keys, uint64 seed,
+                 uint64* hashes) {
+  // Keys longer than the inline buffer of a string are stored out of line,
+  // so the bytes of the keys a few ahead are prefetched.
+  constexpr size_t kPrefetchDistance = 8;
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (i + kPrefetchDistance < num_keys) {
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          keys[i + kPrefetchDistance].data());
+    }
+    hashes[i] = Hash64Finish(keys[i].data(), keys[i].size(),
+                             Hash64Init(keys[i].size(), seed));
+  }
+}
+
 }  // namespace tensorflow
@@ -38,6 +38,15 @@ inline uint64 Hash64(const string& str) {
   return Hash64(str.data(), str.size());
 }
 
+// Sets hashes[i] to Hash64(keys[i], seed) for each of the num_keys keys.
+// This avoids a call per key and prefetches the keys stored out of line.
+extern void Hash64Batch(const string* keys, size_t num_keys, uint64 seed,
+                        uint64* hashes);
+
+inline void Hash64Batch(const string* keys, size_t num_keys, uint64* hashes) {
+  Hash64Batch(keys, num_keys, 0xDECAFCAFFE, hashes);
+}
+
 inline uint64 Hash64Combine(uint64 a, uint64 b) {
   return a ^ (b + 0x9e3779b97f4a7800ULL + (a << 10) + (a >> 4));
 }
@@ -65,6 +65,30 @@ TEST(Hash, SignedUnsignedIssue) {
   }
 }
 
+TEST(Hash, Hash64Batch) {
+  // Keys of all lengths up to a few words, so that the keys hashed together
+  // share different numbers of words.
+  std::vector<string> keys;
+  for (int i = 0; i < 45; ++i) {
+    string key;
+    for (int j = 0; j < (i * 7) % 37; ++j) {
+      key.push_back(static_cast<char>(i * 31 + j * 17));
+    }
+    keys.push_back(key);
+  }
+  for (size_t num_keys : {0, 1, 3, 4, 5, 8, 45}) {
+    std::vector<uint64> hashes(num_keys);
+    Hash64Batch(keys.data(), num_keys, 0x12345678, hashes.data());
+    for (size_t i = 0; i < num_keys; ++i) {
+      EXPECT_EQ(Hash64(keys[i].data(), keys[i].size(), 0x12345678), hashes[i]);
+    }
+    Hash64Batch(keys.data(), num_keys, hashes.data());
+    for (size_t i = 0; i < num_keys; ++i) {
+      EXPECT_EQ(Hash64(keys[i]), hashes[i]);
+    }
+  }
+}
+
 static void BM_Hash32(int iters, int len) {
   std::string input(len, 'x');
   uint32 h = 0;
@@ -76,4 +100,15 @@ static void BM_Hash32(int iters, int len) {
 }
 BENCHMARK(BM_Hash32)->Range(1, 1024);
 
+static void BM_Hash64Batch(int iters, int len) {
+  std::vector<string> keys(1024, string(len, 'x'));
+  std::vector<uint64> hashes(keys.size());
+  for (int i = 0; i < iters; i++) {
+    Hash64Batch(keys.data(), keys.size(), hashes.data());
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * keys.size());
+  VLOG(1) << hashes[0];
+}
+BENCHMARK(BM_Hash64Batch)->Range(1, 64);
+
 }  // namespace tensorflow
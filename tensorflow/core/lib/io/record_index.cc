@@ -0,0 +1,150 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// Format of a serialized index:
+//  uint64    magic number
+//  uint64    interval
+//  uint64    number of records
+//  uint64    end offset
+//  uint64    offsets[ceil(number of records / interval)]
+//  uint32    masked crc of all of the above
+const uint64 kRecordIndexMagic = 0x7866726563696478ull;
+const size_t kHeaderSize = 4 * sizeof(uint64);
+
+}  // namespace
+
+RecordIndex::RecordIndex(uint64 interval)
+    : interval_(std::max<uint64>(interval, 1)) {}
+
+void RecordIndex::AddRecord(uint64 offset, uint64 length) {
+  if (num_records_ % interval_ == 0) {
+    offsets_.push_back(offset);
+  }
+  ++num_records_;
+  end_offset_ = offset + length;
+}
+
+Status RecordIndex::Locate(uint64 record, uint64* offset,
+                           uint64* records_to_skip) const {
+  if (record >= num_records_) {
+    return errors::OutOfRange("Record ", record, " is past the ", num_records_,
+                              " records of the file");
+  }
+  *offset = offsets_[record / interval_];
+  *records_to_skip = record % interval_;
+  return Status::OK();
+}
+
+void RecordIndex::GetShard(int64 shard, int64 num_shards, uint64* begin,
+                           uint64* end) const {
+  // Returns the first indexed record at or after byte "shard * end_offset_ /
+  // num_shards" of the file, without overflowing.
+  auto shard_start = [this, num_shards](int64 shard) -> uint64 {
+    if (shard <= 0) return 0;
+    if (shard >= num_shards) return num_records_;
+    const uint64 target = end_offset_ / num_shards * shard +
+                          end_offset_ % num_shards * shard / num_shards;
+    const size_t entry =
+        std::lower_bound(offsets_.begin(), offsets_.end(), target) -
+        offsets_.begin();
+    return std::min(num_records_, entry * interval_);
+  };
+  *begin = shard_start(shard);
+  *end = shard_start(shard + 1);
+}
+
+void RecordIndex::EncodeTo(string* dst) const {
+  const size_t start = dst->size();
+  core::PutFixed64(dst, kRecordIndexMagic);
+  core::PutFixed64(dst, interval_);
+  core::PutFixed64(dst, num_records_);
+  core::PutFixed64(dst, end_offset_);
+  for (uint64 offset : offsets_) {
+    core::PutFixed64(dst, offset);
+  }
+  core::PutFixed32(dst, crc32c::Mask(crc32c::Value(dst->data() + start,
+                                                   dst->size() - start)));
+}
+
+Status RecordIndex::DecodeFrom(StringPiece src) {
+  if (src.size() < kHeaderSize + sizeof(uint32)) {
+    return errors::DataLoss("Truncated record index");
+  }
+  const size_t n = src.size() - sizeof(uint32);
+  const uint32 masked_crc = core::DecodeFixed32(src.data() + n);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(src.data(), n)) {
+    return errors::DataLoss("Corrupted record index");
+  }
+  const char* p = src.data();
+  if (core::DecodeFixed64(p) != kRecordIndexMagic) {
+    return errors::DataLoss("Not a record index");
+  }
+  const uint64 interval = core::DecodeFixed64(p + sizeof(uint64));
+  const uint64 num_records = core::DecodeFixed64(p + 2 * sizeof(uint64));
+  const uint64 end_offset = core::DecodeFixed64(p + 3 * sizeof(uint64));
+  if (interval == 0) {
+    return errors::DataLoss("Invalid interval in record index");
+  }
+  const uint64 num_offsets = (num_records + interval - 1) / interval;
+  if ((n - kHeaderSize) / sizeof(uint64) != num_offsets ||
+      (n - kHeaderSize) % sizeof(uint64) != 0) {
+    return errors::DataLoss("Record index has ", (n - kHeaderSize),
+                            " bytes of offsets for ", num_records,
+                            " records");
+  }
+  interval_ = interval;
+  num_records_ = num_records;
+  end_offset_ = end_offset;
+  offsets_.resize(num_offsets);
+  for (uint64 i = 0; i < num_offsets; ++i) {
+    offsets_[i] = core::DecodeFixed64(p + kHeaderSize + i * sizeof(uint64));
+  }
+  return Status::OK();
+}
+
+string RecordIndexFilename(const string& filename) {
+  return strings::StrCat(filename, ".index");
+}
+
+Status WriteRecordIndex(Env* env, const string& filename,
+                        const RecordIndex& index) {
+  string contents;
+  index.EncodeTo(&contents);
+  return WriteStringToFile(env, RecordIndexFilename(filename), contents);
+}
+
+Status ReadRecordIndex(Env* env, const string& filename, RecordIndex* index) {
+  string contents;
+  TF_RETURN_IF_ERROR(
+      ReadFileToString(env, RecordIndexFilename(filename), &contents));
+  return index->DecodeFrom(contents);
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+
+namespace io {
+
+// An index of the records of an uncompressed TFRecord file, written by
+// RecordWriter next to the file it describes.
+//
+// The index holds the offset of every "interval"-th record, starting with
+// the first one, so that a reader can seek to any record by skipping fewer
+// than "interval" records, and split the file into shards of about the same
+// number of bytes.
+class RecordIndex {
+ public:
+  explicit RecordIndex(uint64 interval = 1);
+
+  // Adds the record that takes "length" bytes of the file from "offset" on,
+  // including its header and footer.  Records must be added in order.
+  void AddRecord(uint64 offset, uint64 length);
+
+  uint64 interval() const { return interval_; }
+  uint64 num_records() const { return num_records_; }
+
+  // The offset just past the last record.
+  uint64 end_offset() const { return end_offset_; }
+
+  // Sets "*offset" to the offset of the last indexed record at or before
+  // "record", and "*records_to_skip" to the number of records between the
+  // two.  Returns OUT_OF_RANGE if "record" is not in the file.
+  Status Locate(uint64 record, uint64* offset, uint64* records_to_skip) const;
+
+  // Sets the records ["*begin", "*end") to the "shard"-th of "num_shards"
+  // splits of the file of about the same number of bytes.  The splits start
+  // at indexed records, and together hold every record once.
+  void GetShard(int64 shard, int64 num_shards, uint64* begin,
+                uint64* end) const;
+
+  // Appends the serialized index to "*dst".
+  void EncodeTo(string* dst) const;
+
+  // Replaces this index with the serialized one in "src".
+  Status DecodeFrom(StringPiece src);
+
+ private:
+  uint64 interval_;
+  uint64 num_records_ = 0;
+  uint64 end_offset_ = 0;
+  // The offsets of records 0, interval_, 2 * interval_, ...
+  std::vector<uint64> offsets_;
+};
+
+// Returns the name of the index of the TFRecord file "filename".
+string RecordIndexFilename(const string& filename);
+
+// Writes "index" as the index of the TFRecord file "filename".
+Status WriteRecordIndex(Env* env, const string& filename,
+                        const RecordIndex& index);
+
+// Reads the index of the TFRecord file "filename" into "*index".  Returns
+// NOT_FOUND if the file has no index.
+Status ReadRecordIndex(Env* env, const string& filename, RecordIndex* index);
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_RECORD_INDEX_H_
@@ -172,5 +172,72 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+Status RecordReader::SkipRecords(uint64* offset, uint64 num_records) {
+  static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+  static const size_t kFooterSize = sizeof(uint32);
+
+  string storage;
+  for (uint64 i = 0; i < num_records; ++i) {
+    if (options_.compression_type != RecordReaderOptions::NONE) {
+      // Compressed files can only be read sequentially.
+      TF_RETURN_IF_ERROR(ReadRecord(offset, &storage));
+      continue;
+    }
+    StringPiece lbuf;
+    TF_RETURN_IF_ERROR(
+        ReadChecksummed(*offset, sizeof(uint64), &lbuf, &storage));
+    const uint64 length = core::DecodeFixed64(lbuf.data());
+    *offset += kHeaderSize + length + kFooterSize;
+  }
+  return Status::OK();
+}
+
+Status RecordReader::SeekToRecord(const RecordIndex& index, uint64 record,
+                                  uint64* offset) {
+  if (options_.compression_type != RecordReaderOptions::NONE) {
+    return errors::Unimplemented("Cannot seek in compressed record files");
+  }
+  uint64 records_to_skip;
+  TF_RETURN_IF_ERROR(index.Locate(record, offset, &records_to_skip));
+  return SkipRecords(offset, records_to_skip);
+}
+
+MemmappedRecordReader::MemmappedRecordReader(ReadOnlyMemoryRegion* region)
+    : data_(static_cast<const char*>(region->data())),
+      size_(region->length()) {}
+
+Status MemmappedRecordReader::ReadRecord(uint64* offset,
+                                         StringPiece* record) const {
+  static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+  static const size_t kFooterSize = sizeof(uint32);
+
+  if (*offset >= size_) {
+    return errors::OutOfRange("eof");
+  }
+  if (size_ - *offset < kHeaderSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  const char* header = data_ + *offset;
+  uint32 masked_crc = core::DecodeFixed32(header + sizeof(uint64));
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(header, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", *offset);
+  }
+  const uint64 length = core::DecodeFixed64(header);
+
+  const uint64 remaining = size_ - *offset - kHeaderSize;
+  if (remaining < kFooterSize || length > remaining - kFooterSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  const char* data = header + kHeaderSize;
+  masked_crc = core::DecodeFixed32(data + length);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data, length)) {
+    return errors::DataLoss("corrupted record at ", *offset);
+  }
+  *record = StringPiece(data, length);
+
+  *offset += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
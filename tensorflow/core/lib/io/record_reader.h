@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
@@ -29,6 +30,7 @@ limitations under the License.
 namespace tensorflow {
 
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -60,6 +62,17 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(uint64* offset, string* record);
 
+  // Skip the "num_records" records from "*offset" on, and update *offset
+  // to point to the offset of the record after them.  Only the headers of
+  // the records of uncompressed files are read.
+  Status SkipRecords(uint64* offset, uint64 num_records);
+
+  // Set *offset to the offset of the "record"-th record of the file, as
+  // found in "index", the index of the file.  Returns OUT_OF_RANGE if the
+  // file has fewer records, and UNIMPLEMENTED for compressed files.
+  Status SeekToRecord(const RecordIndex& index, uint64 record,
+                      uint64* offset);
+
  private:
   Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result,
                          string* storage);
@@ -74,6 +87,26 @@ class RecordReader {
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
+// Reads the records of an uncompressed file in place from a memory region,
+// such as one returned by Env::NewReadOnlyMemoryRegionFromFile(), so that
+// no record is copied.
+class MemmappedRecordReader {
+ public:
+  // "*region" must remain live while this Reader and the records it
+  // returned are in use.
+  explicit MemmappedRecordReader(ReadOnlyMemoryRegion* region);
+
+  // Same as RecordReader::ReadRecord(), but sets *record to point at the
+  // record in the region, once its checksums are verified.
+  Status ReadRecord(uint64* offset, StringPiece* record) const;
+
+ private:
+  const char* const data_;
+  const uint64 size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -67,6 +67,32 @@ TEST(RecordReaderWriterTest, TestBasics) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestWriteRecords) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_records_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecords({"defg", "", "hi"}));
+    TF_EXPECT_OK(writer.WriteRecords({}));
+    TF_EXPECT_OK(writer.WriteRecord("jkl"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(read_file.get());
+  uint64 offset = 0;
+  string record;
+  for (const char* expected : {"abc", "defg", "", "hi", "jkl"}) {
+    TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(expected, record);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
 TEST(RecordReaderWriterTest, TestZlib) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_zlib_test";
@@ -105,4 +131,153 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestMemmapped) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_memmapped_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  io::MemmappedRecordReader reader(region.get());
+  const char* begin = static_cast<const char*>(region->data());
+  uint64 offset = 0;
+  StringPiece record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  // The record points into the region.
+  EXPECT_EQ(begin + 12, record.data());
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("", record);
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("defg", record);
+  EXPECT_EQ(region->length(), offset);
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+  // Truncated and corrupted records are reported as data loss.
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  for (const string& bad_contents :
+       {contents.substr(0, contents.size() - 1),
+        contents.substr(0, 5),
+        string(contents).replace(13, 1, "x")}) {
+    const string bad_fname = fname + ".bad";
+    TF_CHECK_OK(WriteStringToFile(env, bad_fname, bad_contents));
+    std::unique_ptr<ReadOnlyMemoryRegion> bad_region;
+    TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(bad_fname, &bad_region));
+    io::MemmappedRecordReader bad_reader(bad_region.get());
+    offset = 0;
+    Status status;
+    while (status.ok()) {
+      status = bad_reader.ReadRecord(&offset, &record);
+    }
+    EXPECT_TRUE(errors::IsDataLoss(status)) << status;
+  }
+}
+
+TEST(RecordReaderWriterTest, TestIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  const int kNumRecords = 10;
+  std::vector<string> records;
+  for (int i = 0; i < kNumRecords; ++i) {
+    records.push_back(string(i * 10, 'a' + i));
+  }
+
+  for (uint64 interval : {1, 3, 20}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+      io::RecordWriterOptions options;
+      options.index_interval = interval;
+      io::RecordWriter writer(file.get(), options);
+      for (const string& record : records) {
+        TF_EXPECT_OK(writer.WriteRecord(record));
+      }
+      TF_CHECK_OK(writer.Flush());
+      ASSERT_NE(nullptr, writer.index());
+      TF_CHECK_OK(io::WriteRecordIndex(env, fname, *writer.index()));
+    }
+
+    io::RecordIndex index;
+    TF_CHECK_OK(io::ReadRecordIndex(env, fname, &index));
+    EXPECT_EQ(interval, index.interval());
+    EXPECT_EQ(kNumRecords, index.num_records());
+    uint64 file_size;
+    TF_CHECK_OK(env->GetFileSize(fname, &file_size));
+    EXPECT_EQ(file_size, index.end_offset());
+
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReader reader(read_file.get());
+    // Seeks to every record, in reverse.
+    for (int i = kNumRecords - 1; i >= 0; --i) {
+      uint64 offset;
+      TF_CHECK_OK(reader.SeekToRecord(index, i, &offset));
+      string record;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(records[i], record);
+    }
+    uint64 offset;
+    EXPECT_TRUE(
+        errors::IsOutOfRange(reader.SeekToRecord(index, kNumRecords, &offset)));
+
+    // The shards hold every record once, and are about the same size.
+    uint64 expected_begin = 0;
+    for (int shard = 0; shard < 3; ++shard) {
+      uint64 begin, end;
+      index.GetShard(shard, 3, &begin, &end);
+      EXPECT_EQ(expected_begin, begin);
+      EXPECT_LE(begin, end);
+      expected_begin = end;
+    }
+    EXPECT_EQ(kNumRecords, expected_begin);
+  }
+
+  // Record 7 is the first one that starts in the second half of the 610
+  // bytes of the file, at byte 322.
+  uint64 begin, end;
+  io::RecordIndex fine_index(1);
+  uint64 offset = 0;
+  for (const string& record : records) {
+    fine_index.AddRecord(offset, record.size() + 16);
+    offset += record.size() + 16;
+  }
+  fine_index.GetShard(0, 2, &begin, &end);
+  EXPECT_EQ(0, begin);
+  EXPECT_EQ(7, end);
+  fine_index.GetShard(1, 2, &begin, &end);
+  EXPECT_EQ(7, begin);
+  EXPECT_EQ(kNumRecords, end);
+}
+
+TEST(RecordReaderWriterTest, TestCorruptedIndex) {
+  io::RecordIndex index(2);
+  index.AddRecord(0, 20);
+  index.AddRecord(20, 30);
+  index.AddRecord(50, 10);
+  string encoded;
+  index.EncodeTo(&encoded);
+
+  io::RecordIndex decoded;
+  TF_EXPECT_OK(decoded.DecodeFrom(encoded));
+  EXPECT_EQ(3, decoded.num_records());
+  EXPECT_EQ(60, decoded.end_offset());
+
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    string corrupted = encoded;
+    corrupted[i] ^= 1;
+    EXPECT_TRUE(errors::IsDataLoss(decoded.DecodeFrom(corrupted)));
+  }
+  EXPECT_TRUE(errors::IsDataLoss(decoded.DecodeFrom(encoded.substr(1))));
+}
+
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/record_writer.h"
 
+#include <string.h>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
@@ -77,6 +79,13 @@ RecordWriter::RecordWriter(WritableFile* dest,
   } else {
     LOG(FATAL) << "Unspecified compression type :" << options.compression_type;
   }
+  if (options.index_interval > 0) {
+    if (options.compression_type == RecordWriterOptions::NONE) {
+      index_.reset(new RecordIndex(options.index_interval));
+    } else {
+      LOG(ERROR) << "Compressed record files cannot be indexed.";
+    }
+  }
 }
 
 RecordWriter::~RecordWriter() {
@@ -95,22 +104,64 @@ static uint32 MaskedCrc(const char* data, size_t n) {
   return crc32c::Mask(crc32c::Value(data, n));
 }
 
-Status RecordWriter::WriteRecord(StringPiece data) {
-  // Format of a single record:
-  //  uint64    length
-  //  uint32    masked crc of length
-  //  byte      data[length]
-  //  uint32    masked crc of data
-  char header[sizeof(uint64) + sizeof(uint32)];
+// Format of a single record:
+//  uint64    length
+//  uint32    masked crc of length
+//  byte      data[length]
+//  uint32    masked crc of data
+void RecordWriter::PopulateHeader(char* header, StringPiece data) {
   core::EncodeFixed64(header + 0, data.size());
   core::EncodeFixed32(header + sizeof(uint64),
                       MaskedCrc(header, sizeof(uint64)));
-  char footer[sizeof(uint32)];
+}
+
+void RecordWriter::PopulateFooter(char* footer, StringPiece data) {
   core::EncodeFixed32(footer, MaskedCrc(data.data(), data.size()));
+}
+
+void RecordWriter::RecordWritten(StringPiece data) {
+  const uint64 length = kHeaderSize + data.size() + kFooterSize;
+  if (index_ != nullptr) {
+    index_->AddRecord(offset_, length);
+  }
+  offset_ += length;
+}
+
+Status RecordWriter::WriteRecord(StringPiece data) {
+  char header[kHeaderSize];
+  PopulateHeader(header, data);
+  char footer[kFooterSize];
+  PopulateFooter(footer, data);
 
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+
+  RecordWritten(data);
+  return Status::OK();
+}
+
+Status RecordWriter::WriteRecords(gtl::ArraySlice<string> records) {
+  size_t size = 0;
+  for (const string& data : records) {
+    size += kHeaderSize + data.size() + kFooterSize;
+  }
+  string buffer(size, '\0');
+  char* p = &buffer[0];
+  for (const string& data : records) {
+    PopulateHeader(p, data);
+    p += kHeaderSize;
+    memcpy(p, data.data(), data.size());
+    p += data.size();
+    PopulateFooter(p, data);
+    p += kFooterSize;
+  }
+
+  TF_RETURN_IF_ERROR(dest_->Append(buffer));
+  for (const string& data : records) {
+    RecordWritten(data);
+  }
+  return Status::OK();
 }
 
 Status RecordWriter::Flush() {
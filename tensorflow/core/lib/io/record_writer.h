@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 
+#include <memory>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
@@ -39,6 +42,10 @@ class RecordWriterOptions {
   static RecordWriterOptions CreateRecordWriterOptions(
       const string& compression_type);
 
+  // If positive, the writer indexes every "index_interval"-th record, see
+  // RecordWriter::index().  Compressed files are not indexed.
+  uint64 index_interval = 0;
+
 // Options specific to zlib compression.
 #if !defined(IS_SLIM_BUILD)
   ZlibCompressionOptions zlib_options;
@@ -57,14 +64,37 @@ class RecordWriter {
 
   Status WriteRecord(StringPiece slice);
 
+  // Writes "records" in order, like as many calls to WriteRecord(), but
+  // with a single Append() of all of them to the destination, which is
+  // cheaper for files backed by a remote store.
+  Status WriteRecords(gtl::ArraySlice<string> records);
+
   // Flushes any buffered data held by underlying containers of the
   // RecordWriter to the WritableFile. Does *not* flush the
   // WritableFile.
   Status Flush();
 
+  // Returns the index of the records written so far, or nullptr if
+  // options.index_interval is zero.  It is usually saved with
+  // WriteRecordIndex() once all records are written.
+  const RecordIndex* index() const { return index_.get(); }
+
  private:
+  static constexpr size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+  static constexpr size_t kFooterSize = sizeof(uint32);
+
+  // Encodes the header and the footer of the record of "data".
+  static void PopulateHeader(char* header, StringPiece data);
+  static void PopulateFooter(char* footer, StringPiece data);
+
+  // Accounts for a written record of "data".
+  void RecordWritten(StringPiece data);
+
   WritableFile* dest_;
   RecordWriterOptions options_;
+  // The number of bytes of records written so far.
+  uint64 offset_ = 0;
+  std::unique_ptr<RecordIndex> index_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordWriter);
 };
@@ -159,8 +159,44 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
     return nullptr;
   }
 
+  // The size of the output, and the columns of the decoded scanlines to skip.
+  JDIMENSION output_width = cinfo.output_width;
+  JDIMENSION output_height = cinfo.output_height;
+  JDIMENSION skipped_columns = 0;
+  if (flags.crop) {
+    if (flags.crop_x < 0 || flags.crop_y < 0 || flags.crop_width <= 0 ||
+        flags.crop_height <= 0 ||
+        static_cast<JDIMENSION>(flags.crop_x + flags.crop_width) >
+            cinfo.output_width ||
+        static_cast<JDIMENSION>(flags.crop_y + flags.crop_height) >
+            cinfo.output_height) {
+      LOG(ERROR) << "Invalid crop window: " << flags.crop_width << " x "
+                 << flags.crop_height << " at (" << flags.crop_x << ", "
+                 << flags.crop_y << ") in an image of " << cinfo.output_width
+                 << " x " << cinfo.output_height;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+    output_width = flags.crop_width;
+    output_height = flags.crop_height;
+    // libjpeg aligns the decoded columns on iMCU boundaries, so it may decode
+    // a few more columns on the left of the window, which are then skipped.
+    JDIMENSION xoffset = flags.crop_x;
+    JDIMENSION width = flags.crop_width;
+    jpeg_crop_scanline(&cinfo, &xoffset, &width);
+    skipped_columns = flags.crop_x - xoffset;
+    if (flags.crop_y > 0 &&
+        jpeg_skip_scanlines(&cinfo, flags.crop_y) !=
+            static_cast<JDIMENSION>(flags.crop_y)) {
+      LOG(ERROR) << "Premature end of JPEG data while skipping to line "
+                 << flags.crop_y;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+  }
+
   // check for compatible stride
-  const int min_stride = cinfo.output_width * components * sizeof(JSAMPLE);
+  const int min_stride = output_width * components * sizeof(JSAMPLE);
   if (stride == 0) {
     stride = min_stride;
   } else if (stride < min_stride) {
@@ -170,34 +206,41 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   }
 
   // Remember stride and height for use in Uncompress
-  argball->height_ = cinfo.output_height;
+  argball->height_ = output_height;
   argball->stride_ = stride;
 
-  uint8* const dstdata = argball->allocate_output_(
-      cinfo.output_width, cinfo.output_height, components);
+  uint8* const dstdata =
+      argball->allocate_output_(output_width, output_height, components);
   if (dstdata == nullptr) {
     jpeg_destroy_decompress(&cinfo);
     return nullptr;
   }
   JSAMPLE* output_line = static_cast<JSAMPLE*>(dstdata);
 
-  // Temporary buffer used for CMYK -> RGB conversion.
+  // Temporary buffer used for CMYK -> RGB conversion, or to skip the columns
+  // decoded on the left and on the right of a crop window.
   const bool use_cmyk = (cinfo.out_color_space == JCS_CMYK);
-  tempdata = use_cmyk ? new JSAMPLE[cinfo.output_width * 4] : NULL;
+  const bool use_tempdata = use_cmyk || cinfo.output_width != output_width;
+  tempdata = use_tempdata
+                 ? new JSAMPLE[cinfo.output_width * cinfo.output_components]
+                 : NULL;
 
   // If there is an error reading a line, this aborts the reading.
   // Save the fraction of the image that has been read.
-  argball->height_read_ = cinfo.output_height;
-  while (cinfo.output_scanline < cinfo.output_height) {
+  argball->height_read_ = output_height;
+  const JDIMENSION first_line = cinfo.output_scanline;
+  const JDIMENSION end_line = first_line + output_height;
+  while (cinfo.output_scanline < end_line) {
     int num_lines_read = 0;
     if (cinfo.out_color_space == JCS_CMYK) {
       num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
       // Convert CMYK to RGB
-      for (size_t i = 0; i < cinfo.output_width; ++i) {
-        int c = tempdata[4 * i + 0];
-        int m = tempdata[4 * i + 1];
-        int y = tempdata[4 * i + 2];
-        int k = tempdata[4 * i + 3];
+      for (size_t i = 0; i < output_width; ++i) {
+        const JSAMPLE* cmyk_pixel = tempdata + 4 * (skipped_columns + i);
+        int c = cmyk_pixel[0];
+        int m = cmyk_pixel[1];
+        int y = cmyk_pixel[2];
+        int k = cmyk_pixel[3];
         int r, g, b;
         if (cinfo.saw_Adobe_marker) {
           r = (k * c) / 255;
@@ -212,6 +255,9 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
         output_line[3 * i + 1] = g;
         output_line[3 * i + 2] = b;
       }
+    } else if (use_tempdata) {
+      num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
+      memcpy(output_line, tempdata + skipped_columns * components, min_stride);
     } else {
       num_lines_read = jpeg_read_scanlines(&cinfo, &output_line, 1);
     }
@@ -220,12 +266,11 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
       LOG(ERROR) << "Premature end of JPEG data. Stopped at line "
                  << cinfo.output_scanline << "/" << cinfo.output_height;
       if (!flags.try_recover_truncated_jpeg) {
-        argball->height_read_ = cinfo.output_scanline;
+        argball->height_read_ = cinfo.output_scanline - first_line;
         error = JPEGERRORS_UNEXPECTED_END_OF_DATA;
       } else {
-        for (size_t line = cinfo.output_scanline; line < cinfo.output_height;
-             ++line) {
-          if (line == 0) {
+        for (size_t line = cinfo.output_scanline; line < end_line; ++line) {
+          if (line == first_line) {
             // If even the first line is missing, fill with black color
             memset(output_line, 0, min_stride);
           } else {
@@ -234,8 +279,7 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
           }
           output_line += stride;
         }
-        argball->height_read_ =
-            cinfo.output_height;  // consider all lines as read
+        argball->height_read_ = output_height;  // consider all lines as read
         // prevent error-on-exit in libjpeg:
         cinfo.output_scanline = cinfo.output_height;
       }
@@ -254,17 +298,17 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   if (components == 4) {
     // Start on the last line.
     JSAMPLE* scanlineptr = static_cast<JSAMPLE*>(
-        dstdata + static_cast<int64>(cinfo.output_height - 1) * stride);
+        dstdata + static_cast<int64>(output_height - 1) * stride);
     const JSAMPLE kOpaque = -1;  // All ones appropriate for JSAMPLE.
-    const int right_rgb = (cinfo.output_width - 1) * 3;
-    const int right_rgba = (cinfo.output_width - 1) * 4;
+    const int right_rgb = (output_width - 1) * 3;
+    const int right_rgba = (output_width - 1) * 4;
 
-    for (int y = cinfo.output_height; y-- > 0;) {
+    for (int y = output_height; y-- > 0;) {
       // We do all the transformations in place, going backwards for each row.
       const JSAMPLE* rgb_pixel = scanlineptr + right_rgb;
       JSAMPLE* rgba_pixel = scanlineptr + right_rgba;
       scanlineptr -= stride;
-      for (int x = cinfo.output_width; x-- > 0;
+      for (int x = output_width; x-- > 0;
            rgba_pixel -= 4, rgb_pixel -= 3) {
         // We copy the 3 bytes at rgb_pixel into the 4 bytes at rgba_pixel
         // The "a" channel is set to be opaque.
@@ -309,7 +353,12 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   // Handle errors in JPEG
   switch (error) {
     case JPEGERRORS_OK:
-      jpeg_finish_decompress(&cinfo);
+      // The lines below a crop window are not decoded at all.
+      if (cinfo.output_scanline < cinfo.output_height) {
+        jpeg_abort(reinterpret_cast<j_common_ptr>(&cinfo));
+      } else {
+        jpeg_finish_decompress(&cinfo);
+      }
       break;
     case JPEGERRORS_UNEXPECTED_END_OF_DATA:
     case JPEGERRORS_BAD_PARAM:
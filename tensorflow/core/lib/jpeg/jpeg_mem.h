@@ -61,6 +61,17 @@ struct UncompressFlags {
   //
   // Setting this has a quality/speed trade-off implication.
   J_DCT_METHOD dct_method = JDCT_DEFAULT;
+
+  // If true, only the window of the image of crop_width x crop_height pixels
+  // whose top left corner is at (crop_x, crop_y) is decoded and output.  The
+  // window is in the coordinates of the image scaled down by the ratio, and
+  // must lie within it.  The rows above and below the window are skipped
+  // without being fully decoded, as are most of the columns around it.
+  bool crop = false;
+  int crop_x = 0;
+  int crop_y = 0;
+  int crop_width = 0;
+  int crop_height = 0;
 };
 
 // Uncompress some raw JPEG data given by the pointer srcdata and the length
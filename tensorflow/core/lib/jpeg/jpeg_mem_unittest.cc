@@ -209,6 +209,71 @@ TEST(JpegMemTest, Jpeg2) {
   }
 }
 
+// Checks that decoding a window of "jpegfile" scaled down by "ratio" outputs
+// the same pixels, up to the chroma upsampling at the window edges, as
+// decoding the whole image and cropping it.
+void TestCropAndDecodeJpeg(const string& jpegfile, int components, int ratio,
+                           int crop_x, int crop_y, int crop_width,
+                           int crop_height) {
+  string jpeg;
+  ReadFileToStringOrDie(Env::Default(), jpegfile, &jpeg);
+
+  UncompressFlags flags;
+  flags.components = components;
+  flags.ratio = ratio;
+  int w, h, c;
+  std::unique_ptr<uint8[]> imgdata(
+      Uncompress(jpeg.data(), jpeg.size(), flags, &w, &h, &c, nullptr));
+  ASSERT_NE(nullptr, imgdata.get());
+
+  flags.crop = true;
+  flags.crop_x = crop_x;
+  flags.crop_y = crop_y;
+  flags.crop_width = crop_width;
+  flags.crop_height = crop_height;
+  int crop_w, crop_h, crop_c;
+  std::unique_ptr<uint8[]> cropdata(Uncompress(
+      jpeg.data(), jpeg.size(), flags, &crop_w, &crop_h, &crop_c, nullptr));
+  ASSERT_NE(nullptr, cropdata.get());
+  EXPECT_EQ(crop_width, crop_w);
+  EXPECT_EQ(crop_height, crop_h);
+  EXPECT_EQ(c, crop_c);
+
+  int64 totalerr = 0;
+  for (int i = 0; i < crop_height; ++i) {
+    for (int j = 0; j < crop_width * c; ++j) {
+      const int full = imgdata[((crop_y + i) * w + crop_x) * c + j];
+      const int cropped = cropdata[i * crop_width * c + j];
+      totalerr += std::abs(full - cropped);
+    }
+  }
+  EXPECT_LE(totalerr, crop_width * crop_height * c / 4)
+      << jpegfile << " ratio " << ratio;
+
+  // The window must lie within the scaled image.
+  flags.crop_x = w - crop_width + 1;
+  imgdata.reset(
+      Uncompress(jpeg.data(), jpeg.size(), flags, &w, &h, &c, nullptr));
+  EXPECT_EQ(nullptr, imgdata.get());
+}
+
+TEST(JpegMemTest, CropAndDecodeJpeg) {
+  const string data_path = kTestData;
+  for (const int ratio : {1, 2}) {
+    for (const int components : {1, 3}) {
+      TestCropAndDecodeJpeg(data_path + "jpeg_merge_test1.jpg", components,
+                            ratio, 37 / ratio, 21 / ratio, 64 / ratio,
+                            40 / ratio);
+    }
+    // Exercise CMYK machinery as well
+    TestCropAndDecodeJpeg(data_path + "jpeg_merge_test1_cmyk.jpg", 3, ratio,
+                          37 / ratio, 21 / ratio, 64 / ratio, 40 / ratio);
+  }
+  // A window starting on an iMCU boundary and spanning the full height.
+  TestCropAndDecodeJpeg(data_path + "jpeg_merge_test1.jpg", 3, 1, 16, 0, 16,
+                        100);
+}
+
 // Takes JPEG data and reads its headers to determine whether or not the JPEG
 // was chroma downsampled.
 bool IsChromaDownsampled(const string& jpegdata) {
@@ -29,6 +29,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/monitoring/metric_def.h"
+#include "tensorflow/core/lib/monitoring/thread_shard.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -45,10 +46,13 @@ namespace monitoring {
 // to which both cells belong) and performance (since map indexing and
 // associated locking are both avoided).
 //
+// The value is sharded by thread, so that a cell incremented on every step of
+// many threads doesn't bounce a cache line between them.
+//
 // This class is thread-safe.
 class CounterCell {
  public:
-  CounterCell(const int64 value) : value_(value) {}
+  CounterCell(const int64 value) { shards_[0].value = value; }
   ~CounterCell() {}
 
   // Atomically increments the value by step.
@@ -59,7 +63,12 @@ class CounterCell {
   int64 value() const;
 
  private:
-  std::atomic<int64> value_;
+  // Padded to a cache line.
+  struct Shard {
+    std::atomic<int64> value{0};
+    char padding[64 - sizeof(std::atomic<int64>)];
+  };
+  Shard shards_[internal::kNumThreadShards];
 
   TF_DISALLOW_COPY_AND_ASSIGN(CounterCell);
 };
@@ -131,10 +140,17 @@ class Counter {
 
 inline void CounterCell::IncrementBy(const int64 step) {
   DCHECK_LE(0, step) << "Must not decrement cumulative metrics.";
-  value_ += step;
+  shards_[internal::CurrentThreadShard()].value.fetch_add(
+      step, std::memory_order_relaxed);
 }
 
-inline int64 CounterCell::value() const { return value_; }
+inline int64 CounterCell::value() const {
+  int64 value = 0;
+  for (const Shard& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
 
 template <int NumLabels>
 template <typename... MetricDefArgs>
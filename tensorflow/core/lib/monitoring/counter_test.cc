@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/monitoring/counter.h"
 
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -44,6 +46,21 @@ TEST(LabeledCounterTest, GetCell) {
   EXPECT_EQ(100, same_cell->value());
 }
 
+TEST(LabeledCounterTest, IncrementFromManyThreads) {
+  auto* cell = counter_with_labels->GetCell("ManyThreads");
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 16);
+    for (int i = 0; i < 64; ++i) {
+      pool.Schedule([cell]() {
+        for (int j = 0; j < 1000; ++j) {
+          cell->IncrementBy(1);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(64000, cell->value());
+}
+
 TEST(LabeledCounterDeathTest, DiesOnDecrement) {
   EXPECT_DEBUG_DEATH(
       { counter_with_labels->GetCell("DyingOp")->IncrementBy(-1); },
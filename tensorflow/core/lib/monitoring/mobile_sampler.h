@@ -18,6 +18,8 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_LIB_MONITORING_MOBILE_SAMPLER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_LIB_MONITORING_MOBILE_SAMPLER_H_
 
+#include <vector>
+
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -25,6 +27,21 @@ limitations under the License.
 namespace tensorflow {
 namespace monitoring {
 
+// Returns the 'bucket_count' bucket limits scale, scale * growth_factor,
+// scale * growth_factor^2, ..., e.g. to measure latencies over several orders
+// of magnitude.
+inline std::vector<double> ExponentialBuckets(double scale,
+                                              double growth_factor,
+                                              int bucket_count) {
+  std::vector<double> bucket_limits;
+  double bound = scale;
+  for (int i = 0; i < bucket_count; ++i) {
+    bucket_limits.push_back(bound);
+    bound *= growth_factor;
+  }
+  return bucket_limits;
+}
+
 // SamplerCell which has a null implementation.
 class SamplerCell {
  public:
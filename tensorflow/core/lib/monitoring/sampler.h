@@ -24,12 +24,16 @@ limitations under the License.
 #else
 
 #include <float.h>
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/monitoring/metric_def.h"
+#include "tensorflow/core/lib/monitoring/thread_shard.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -37,6 +41,21 @@ limitations under the License.
 namespace tensorflow {
 namespace monitoring {
 
+// Returns the 'bucket_count' bucket limits scale, scale * growth_factor,
+// scale * growth_factor^2, ..., e.g. to measure latencies over several orders
+// of magnitude.
+inline std::vector<double> ExponentialBuckets(double scale,
+                                              double growth_factor,
+                                              int bucket_count) {
+  std::vector<double> bucket_limits;
+  double bound = scale;
+  for (int i = 0; i < bucket_count; ++i) {
+    bucket_limits.push_back(bound);
+    bound *= growth_factor;
+  }
+  return bucket_limits;
+}
+
 // SamplerCell stores each value of an Sampler.
 //
 // A cell can be passed off to a module which may repeatedly update it without
@@ -45,11 +64,17 @@ namespace monitoring {
 // to which both cells belong) and performance (since map indexing and
 // associated locking are both avoided).
 //
+// The histogram is sharded by thread, so that threads adding samples to the
+// same cell rarely contend for a lock.
+//
 // This class is thread-safe.
 class SamplerCell {
  public:
-  SamplerCell(const std::vector<double>& bucket_limits)
-      : histogram_(bucket_limits) {}
+  SamplerCell(const std::vector<double>& bucket_limits) {
+    for (auto& shard : shards_) {
+      shard.reset(new histogram::ThreadSafeHistogram(bucket_limits));
+    }
+  }
 
   ~SamplerCell() {}
 
@@ -60,7 +85,8 @@ class SamplerCell {
   HistogramProto value() const;
 
  private:
-  histogram::ThreadSafeHistogram histogram_;
+  std::unique_ptr<histogram::ThreadSafeHistogram>
+      shards_[internal::kNumThreadShards];
 
   TF_DISALLOW_COPY_AND_ASSIGN(SamplerCell);
 };
@@ -150,11 +176,26 @@ class Sampler {
 //  Implementation details follow. API readers may skip.
 ////
 
-inline void SamplerCell::Add(const double sample) { histogram_.Add(sample); }
+inline void SamplerCell::Add(const double sample) {
+  shards_[internal::CurrentThreadShard()]->Add(sample);
+}
 
 inline HistogramProto SamplerCell::value() const {
   HistogramProto pb;
-  histogram_.EncodeToProto(&pb, true /* preserve_zero_buckets */);
+  shards_[0]->EncodeToProto(&pb, true /* preserve_zero_buckets */);
+  for (int i = 1; i < internal::kNumThreadShards; ++i) {
+    // The shards have the same buckets, all of which are preserved.
+    HistogramProto shard_pb;
+    shards_[i]->EncodeToProto(&shard_pb, true /* preserve_zero_buckets */);
+    pb.set_min(std::min(pb.min(), shard_pb.min()));
+    pb.set_max(std::max(pb.max(), shard_pb.max()));
+    pb.set_num(pb.num() + shard_pb.num());
+    pb.set_sum(pb.sum() + shard_pb.sum());
+    pb.set_sum_squares(pb.sum_squares() + shard_pb.sum_squares());
+    for (int j = 0; j < pb.bucket_size(); ++j) {
+      pb.set_bucket(j, pb.bucket(j) + shard_pb.bucket(j));
+    }
+  }
   return pb;
 }
 
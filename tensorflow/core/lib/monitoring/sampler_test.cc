@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/monitoring/sampler.h"
 
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -87,6 +89,40 @@ TEST(UnlabeledSamplerTest, BucketBoundaries) {
   EqHistograms(expected, cell->value());
 }
 
+TEST(UnlabeledSamplerTest, AddFromManyThreads) {
+  auto* sampler = Sampler<0>::New(
+      {"/tensorflow/test/sampler_many_threads",
+       "Sampler added to from many threads."},
+      {1.5, 2.8});
+  Histogram expected({1.5, 2.8, DBL_MAX});
+  auto* cell = sampler->GetCell();
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 16);
+    for (int i = 0; i < 64; ++i) {
+      pool.Schedule([cell]() {
+        for (int j = 0; j < 100; ++j) {
+          cell->Add(j % 4);
+        }
+      });
+    }
+  }
+  for (int i = 0; i < 64; ++i) {
+    for (int j = 0; j < 100; ++j) {
+      expected.Add(j % 4);
+    }
+  }
+
+  EqHistograms(expected, cell->value());
+  delete sampler;
+}
+
+TEST(ExponentialBucketsTest, Limits) {
+  EXPECT_EQ(std::vector<double>({1.0, 2.0, 4.0, 8.0}),
+            ExponentialBuckets(1.0, 2.0, 4));
+  EXPECT_EQ(std::vector<double>({0.5, 1.5, 4.5}),
+            ExponentialBuckets(0.5, 3.0, 3));
+}
+
 }  // namespace
 }  // namespace monitoring
 }  // namespace tensorflow
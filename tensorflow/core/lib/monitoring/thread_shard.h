@@ -0,0 +1,47 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_LIB_MONITORING_THREAD_SHARD_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_LIB_MONITORING_THREAD_SHARD_H_
+
+#include <functional>
+#include <thread>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace monitoring {
+namespace internal {
+
+// The values of the metric cells are split in kNumThreadShards shards, each
+// updated by the threads that hash to it, so that threads updating the same
+// cell concurrently mostly touch different cache lines and locks.
+constexpr int kThreadShardBits = 3;
+constexpr int kNumThreadShards = 1 << kThreadShardBits;
+
+// Returns the shard of the calling thread, in [0, kNumThreadShards).
+inline int CurrentThreadShard() {
+  const uint64 id = std::hash<std::thread::id>()(std::this_thread::get_id());
+  // Thread ids are often aligned addresses, so mix all their bits into the
+  // top ones.
+  return static_cast<int>((id * 0x9E3779B97F4A7C15ull) >>
+                          (64 - kThreadShardBits));
+}
+
+}  // namespace internal
+}  // namespace monitoring
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_LIB_MONITORING_THREAD_SHARD_H_
@@ -24,6 +24,10 @@ limitations under the License.
 
 #include "tensorflow/core/platform/types.h"
 
+#if defined(__AVX2__) && !defined(__CUDACC__)
+#include <immintrin.h>
+#endif
+
 // Function qualifiers that need to work on both CPU and GPU.
 #if defined(__CUDACC__)
 // For nvcc.
@@ -150,6 +154,47 @@ class PhiloxRandom {
     }
   }
 
+  // Sets results[0..kBatchSize) to the results of the next kBatchSize calls of
+  // operator(), and skips them. The rounds of the kBatchSize counters are
+  // computed lane by lane, so that the compiler can run the lanes in parallel
+  // in SIMD registers.
+  template <int kBatchSize>
+  PHILOX_DEVICE_INLINE void NextBatch(ResultType* results) {
+    uint32 c0[kBatchSize], c1[kBatchSize], c2[kBatchSize], c3[kBatchSize];
+    for (int i = 0; i < kBatchSize; ++i) {
+      c0[i] = counter_[0];
+      c1[i] = counter_[1];
+      c2[i] = counter_[2];
+      c3[i] = counter_[3];
+      SkipOne();
+    }
+    Key key = key_;
+    for (int round = 0; round < 10; ++round) {
+      const uint32 key0 = key[0];
+      const uint32 key1 = key[1];
+      for (int i = 0; i < kBatchSize; ++i) {
+        // The same as ComputeSingleRound().
+        const uint64 product0 = static_cast<uint64>(kPhiloxM4x32A) * c0[i];
+        const uint64 product1 = static_cast<uint64>(kPhiloxM4x32B) * c2[i];
+        const uint32 next0 =
+            static_cast<uint32>(product1 >> 32) ^ c1[i] ^ key0;
+        const uint32 next2 =
+            static_cast<uint32>(product0 >> 32) ^ c3[i] ^ key1;
+        c1[i] = static_cast<uint32>(product1);
+        c3[i] = static_cast<uint32>(product0);
+        c0[i] = next0;
+        c2[i] = next2;
+      }
+      RaiseKey(&key);
+    }
+    for (int i = 0; i < kBatchSize; ++i) {
+      results[i][0] = c0[i];
+      results[i][1] = c1[i];
+      results[i][2] = c2[i];
+      results[i][3] = c3[i];
+    }
+  }
+
   // Returns a group of four random numbers using the underlying Philox
   // algorithm.
   PHILOX_DEVICE_INLINE ResultType operator()() {
@@ -245,6 +290,104 @@ class PhiloxRandom {
   Key key_;
 };
 
+#if defined(__AVX2__) && !defined(__CUDACC__)
+// Computes the eight counters of a batch in the lanes of AVX2 registers.
+template <>
+inline void PhiloxRandom::NextBatch<8>(ResultType* results) {
+  __m256i c0, c1, c2, c3;
+  if (counter_[0] <= ~uint32{0} - 7) {
+    // The common case, in which only the lowest word of the counters differs.
+    c0 = _mm256_add_epi32(_mm256_set1_epi32(counter_[0]),
+                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    c1 = _mm256_set1_epi32(counter_[1]);
+    c2 = _mm256_set1_epi32(counter_[2]);
+    c3 = _mm256_set1_epi32(counter_[3]);
+    Skip(8);
+  } else {
+    uint32 counters[4][8];
+    for (int i = 0; i < 8; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        counters[j][i] = counter_[j];
+      }
+      SkipOne();
+    }
+    c0 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(counters[0]));
+    c1 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(counters[1]));
+    c2 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(counters[2]));
+    c3 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(counters[3]));
+  }
+  const __m256i m_a = _mm256_set1_epi32(kPhiloxM4x32A);
+  const __m256i m_b = _mm256_set1_epi32(kPhiloxM4x32B);
+  // Sets "lo" and "hi" to the low and high 32 bits of the products of the
+  // lanes of "a" and "b": _mm256_mul_epu32() multiplies the even lanes.
+  auto multiply_high_low = [](__m256i a, __m256i b, __m256i* lo, __m256i* hi) {
+    const __m256i even = _mm256_mul_epu32(a, b);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32),
+                                         _mm256_srli_epi64(b, 32));
+    *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+  };
+  Key key = key_;
+  for (int round = 0; round < 10; ++round) {
+    // The same as ComputeSingleRound().
+    __m256i lo0, hi0, lo1, hi1;
+    multiply_high_low(m_a, c0, &lo0, &hi0);
+    multiply_high_low(m_b, c2, &lo1, &hi1);
+    c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1),
+                          _mm256_set1_epi32(key[0]));
+    c1 = lo1;
+    c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3),
+                          _mm256_set1_epi32(key[1]));
+    c3 = lo0;
+    RaiseKey(&key);
+  }
+  // Transposes the words of the counters into the results: r04 holds results
+  // 0 and 4, r15 results 1 and 5, and so on.
+  const __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+  const __m256i t1 = _mm256_unpackhi_epi32(c0, c1);
+  const __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+  const __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+  const __m256i r04 = _mm256_unpacklo_epi64(t0, t2);
+  const __m256i r15 = _mm256_unpackhi_epi64(t0, t2);
+  const __m256i r26 = _mm256_unpacklo_epi64(t1, t3);
+  const __m256i r37 = _mm256_unpackhi_epi64(t1, t3);
+  static_assert(sizeof(ResultType) == 16, "ResultType must be 128 bits");
+  __m256i* out = reinterpret_cast<__m256i*>(results);
+  _mm256_storeu_si256(out, _mm256_permute2x128_si256(r04, r15, 0x20));
+  _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(r26, r37, 0x20));
+  _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(r04, r15, 0x31));
+  _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(r26, r37, 0x31));
+}
+#endif  // defined(__AVX2__) && !defined(__CUDACC__)
+
+// A generator that returns the same results as the PhiloxRandom that it is
+// constructed with, but computes them kBatchSize at a time with
+// PhiloxRandom::NextBatch(). It advances the PhiloxRandom by up to
+// kBatchSize - 1 results more than it returns.
+template <int kBatchSize>
+class PhiloxRandomBatch {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+  using ResultElementType = PhiloxRandom::ResultElementType;
+  static const int kResultElementCount = PhiloxRandom::kResultElementCount;
+
+  PHILOX_DEVICE_INLINE
+  explicit PhiloxRandomBatch(PhiloxRandom* gen) : gen_(gen) {}
+
+  PHILOX_DEVICE_INLINE ResultType operator()() {
+    if (next_ == kBatchSize) {
+      gen_->NextBatch<kBatchSize>(results_);
+      next_ = 0;
+    }
+    return results_[next_++];
+  }
+
+ private:
+  PhiloxRandom* gen_;
+  ResultType results_[kBatchSize];
+  int next_ = kBatchSize;
+};
+
 }  // namespace random
 }  // namespace tensorflow
 
@@ -68,6 +68,26 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// This test checks that the batched generator returns the same samples as the
+// generator it batches, including across the carries of the counter.
+TEST(PhiloxRandomTest, BatchMatchTest) {
+  PhiloxRandom::ResultType counter;
+  counter[0] = 0xfffffffa;
+  counter[1] = 0xffffffff;
+  PhiloxRandom::Key key;
+  key[0] = static_cast<uint32>(GetTestSeed());
+  PhiloxRandom gen(counter, key);
+  PhiloxRandom batched(counter, key);
+  PhiloxRandomBatch<8> batch_gen(&batched);
+  for (int i = 0; i < 100; ++i) {
+    const PhiloxRandom::ResultType expected = gen();
+    const PhiloxRandom::ResultType actual = batch_gen();
+    for (int j = 0; j < PhiloxRandom::kResultElementCount; ++j) {
+      ASSERT_EQ(expected[j], actual[j]) << i << " " << j;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
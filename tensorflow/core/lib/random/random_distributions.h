@@ -48,6 +48,9 @@ PHILOX_DEVICE_INLINE double Uint64ToDouble(uint32 x0, uint32 x1);
 //             distribution. This could be either float or double for now.
 // This class is meant to be implemented through specialization. The default
 // is not defined by design.
+//
+// The samples can also come from another generator with the same ResultType,
+// such as a PhiloxRandomBatch<kBatchSize> for Generator = PhiloxRandom.
 template <class Generator, typename RealType>
 class UniformDistribution;
 
@@ -64,8 +67,8 @@ class UniformDistribution<Generator, Eigen::half> {
   typedef Array<Eigen::half, kResultElementCount> ResultType;
   typedef Eigen::half ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -88,8 +91,8 @@ class UniformDistribution<Generator, float> {
   typedef Array<float, kResultElementCount> ResultType;
   typedef float ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -112,8 +115,8 @@ class UniformDistribution<Generator, double> {
   typedef Array<double, kResultElementCount> ResultType;
   typedef double ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -139,8 +142,8 @@ class UniformDistribution<Generator, int32> {
   // Must have lo < hi
   UniformDistribution(int32 lo, int32 hi) : lo_(lo), range_(hi - lo) {}
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -173,8 +176,8 @@ class UniformDistribution<Generator, int64> {
   // Must have lo < hi
   UniformDistribution(int64 lo, int64 hi) : lo_(lo), range_(hi - lo) {}
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; ++i) {
@@ -261,8 +264,8 @@ class NormalDistribution<Generator, Eigen::half> {
   typedef Array<Eigen::half, kResultElementCount> ResultType;
   typedef Eigen::half ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -288,8 +291,8 @@ class NormalDistribution<Generator, float> {
   typedef Array<float, kResultElementCount> ResultType;
   typedef float ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -312,8 +315,8 @@ class NormalDistribution<Generator, double> {
   typedef Array<double, kResultElementCount> ResultType;
   typedef double ResultElementType;
 
-  PHILOX_DEVICE_INLINE
-  ResultType operator()(Generator* gen) {
+  template <class SampleGenerator>
+  PHILOX_DEVICE_INLINE ResultType operator()(SampleGenerator* gen) {
     typename Generator::ResultType sample = (*gen)();
     ResultType result;
     for (int i = 0; i < kResultElementCount; i += 2) {
@@ -248,6 +248,22 @@ string Uppercase(StringPiece s) {
   return result;
 }
 
+void JoinInto(gtl::ArraySlice<StringPiece> s, StringPiece sep,
+              string* result) {
+  result->clear();
+  if (s.empty()) return;
+  size_t size = sep.size() * (s.size() - 1);
+  for (StringPiece piece : s) {
+    size += piece.size();
+  }
+  result->reserve(size);
+  result->append(s[0].data(), s[0].size());
+  for (size_t i = 1; i < s.size(); ++i) {
+    result->append(sep.data(), sep.size());
+    result->append(s[i].data(), s[i].size());
+  }
+}
+
 void TitlecaseString(string* s, StringPiece delimiters) {
   bool upper = true;
   for (string::iterator ss = s->begin(); ss != s->end(); ++ss) {
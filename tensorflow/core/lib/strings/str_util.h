@@ -95,6 +95,11 @@ string Join(const T& s, const char* sep);
 template <typename T, typename Formatter>
 string Join(const T& s, const char* sep, Formatter f);
 
+// Sets "*result" to the elements of "s" joined by "sep".  Unlike Join, it
+// reserves the size of the result first, so it allocates at most once and
+// reuses the capacity "*result" already has.
+void JoinInto(gtl::ArraySlice<StringPiece> s, StringPiece sep, string* result);
+
 struct AllowEmpty {
   bool operator()(StringPiece sp) const { return true; }
 };
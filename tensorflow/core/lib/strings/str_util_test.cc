@@ -232,6 +232,19 @@ TEST(JoinStrings, Join3) {
   EXPECT_EQ(str_util::Join(s, " ", l2), "h t s");
 }
 
+TEST(JoinStrings, JoinInto) {
+  string result = "previous";
+  str_util::JoinInto({}, ",", &result);
+  EXPECT_EQ("", result);
+  str_util::JoinInto({"hi"}, ",,", &result);
+  EXPECT_EQ("hi", result);
+  str_util::JoinInto({"hi", "", "strings"}, "--", &result);
+  EXPECT_EQ("hi----strings", result);
+  std::vector<StringPiece> sp = {"a", "b", "c"};
+  str_util::JoinInto(sp, "", &result);
+  EXPECT_EQ("abc", result);
+}
+
 TEST(Split, Basic) {
   EXPECT_TRUE(str_util::Split("", ',').empty());
   EXPECT_EQ(str_util::Join(str_util::Split("a", ','), "|"), "a");
@@ -338,6 +338,7 @@ REGISTER_OP("FIFOQueueV2")
     .Attr("capacity: int = -1")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
+    .Attr("lock_free: bool = false")
     .SetIsStateful()
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
@@ -355,6 +356,10 @@ container: If non-empty, this queue is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this queue will be shared under the given name
   across multiple sessions.
+lock_free: If true, the elements of this queue are kept in a ring buffer that
+  enqueues and dequeues access without taking a lock, unless they have to
+  wait.  Requires a positive capacity, and a DequeueMany of at most the
+  capacity.
 )doc");
 
 REGISTER_OP("PaddingFIFOQueue")
@@ -425,6 +430,50 @@ shared_name: If non-empty, this queue will be shared under the given name
   across multiple sessions.
 )doc");
 
+REGISTER_OP("PaddingBucketQueue")
+    .Output("handle: resource")
+    .Attr("component_types: list(type) >= 1")
+    .Attr("shapes: list(shape) >= 1")
+    .Attr("bucket_component: int = 0")
+    .Attr("bucket_boundaries: list(int) = []")
+    .Attr("capacity: int = -1")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+A padding queue that batches elements of similar sizes together.
+
+Elements are grouped into buckets by the size of the first dimension of their
+component `bucket_component`, e.g. the length of a sequence.  DequeueMany
+returns the elements of a single bucket, padded like in a PaddingFIFOQueue,
+once a bucket holds enough of them.  If the queue is full or closed and no
+bucket can fill a batch, the batch is completed from the buckets nearest to
+the fullest one.  DequeueUpTo on a closed queue returns the remaining
+elements bucket by bucket.  Each bucket is first-in first-out.
+
+handle: The handle to the queue.
+component_types: The type of each component in a value.
+shapes: The shape of each component in a value. The length of this attr must
+  be the same as the length of component_types.  Shapes of fixed rank but
+  variable size are allowed by setting any shape dimension to -1.  In this
+  case, the inputs' shape may vary along the given dimension, and DequeueMany
+  will pad the given dimension with zeros up to the maximum shape of all
+  elements in the given batch.
+bucket_component: The component whose first dimension selects the bucket of
+  an element.  It must have a rank of at least 1.
+bucket_boundaries: Strictly increasing boundaries of the buckets.  An element
+  of size s goes to the first bucket i such that s < bucket_boundaries[i], or
+  to the last of the len(bucket_boundaries) + 1 buckets.
+capacity: The upper bound on the number of elements in this queue, over all
+  buckets.  Negative numbers mean no limit.  DequeueMany can't request more
+  elements than the capacity.
+container: If non-empty, this queue is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this queue will be shared under the given name
+  across multiple sessions.
+)doc");
+
 REGISTER_OP("PriorityQueue")
     .Output("handle: Ref(string)")
     .Attr("component_types: list(type) >= 0 = []")
@@ -2350,6 +2399,205 @@ max_load_factor: The maximum ratio between number of entries and number of
   buckets before growing the table. Must be between 0 and 1.
 )doc");
 
+REGISTER_OP("MemmappedHashTable")
+    .Input("filename: string")
+    .Output("table_handle: Ref(string)")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      return TwoElementOutput(c);
+    })
+    .Doc(R"doc(
+Creates an immutable hash table served from a memory-mapped file.
+
+The table is read from a file written by `WriteMemmappedLookupTable`, such as
+the output of the `convert_vocab_memmapped_format` tool, when the op is first
+run.  The file is mapped into memory and lookups read it directly, so creating
+the table neither parses nor copies its contents.  The table does not support
+the insert and initialization operations.
+
+filename: Filename of the memmapped lookup table.
+table_handle: Handle to a table.
+container: If non-empty, this table is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this table is shared under the given name across
+  multiple sessions.
+use_node_name_sharing: If true and shared_name is empty, the table is shared
+  using the node name.
+key_dtype: Type of the table keys.
+value_dtype: Type of the table values.
+)doc");
+
+REGISTER_OP("MemmappedHashTableV2")
+    .Input("filename: string")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      return ScalarOutput(c);
+    })
+    .Doc(R"doc(
+Creates an immutable hash table served from a memory-mapped file.
+
+The table is read from a file written by `WriteMemmappedLookupTable`, such as
+the output of the `convert_vocab_memmapped_format` tool, when the op is first
+run.  The file is mapped into memory and lookups read it directly, so creating
+the table neither parses nor copies its contents.  The table does not support
+the insert and initialization operations.
+
+filename: Filename of the memmapped lookup table.
+table_handle: Handle to a table.
+container: If non-empty, this table is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this table is shared under the given name across
+  multiple sessions.
+use_node_name_sharing: If true and shared_name is empty, the table is shared
+  using the node name.
+key_dtype: Type of the table keys.
+value_dtype: Type of the table values.
+)doc");
+
+REGISTER_OP("EmbeddingVariable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("value_shape: shape")
+    .Attr("initial_value: float = 0")
+    .Attr("initial_scale: float = 0")
+    .Attr("seed: int = 0")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput)
+    .Doc(R"doc(
+Creates an embedding variable of float rows keyed by int64 ids.
+
+The variable only holds the rows of the ids it has seen: the row of an id is
+created the first time the id is gathered or updated, so the memory of the
+variable grows with the number of distinct ids instead of with the largest id.
+A new row is `initial_value` plus a uniform noise in
+`[-initial_scale, initial_scale)` that only depends on `seed`, the id and the
+position in the row.
+
+The variable is also a mutable hash table: the lookup table size, find, insert,
+export and import ops apply to it, so savers checkpoint only the live rows.
+
+table_handle: Handle to the variable.
+container: If non-empty, this variable is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this variable is shared under the given name across
+  multiple sessions.
+use_node_name_sharing: If true and shared_name is empty, the variable is shared
+  using the node name.
+value_shape: The shape of each row, a vector.
+initial_value: The mean of the initial values of the rows.
+initial_scale: The half width of the range of the initial values of the rows.
+seed: The seed of the initial values of the rows.
+)doc");
+
+REGISTER_OP("EmbeddingVariableGather")
+    .Input("resource: resource")
+    .Input("ids: int64")
+    .Output("values: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(
+          c->Concatenate(c->input(1), c->Vector(InferenceContext::kUnknownDim),
+                         &out));
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Gathers the rows of an embedding variable, creating the missing ones.
+
+resource: Handle to the embedding variable.
+ids: The ids of the rows to gather.
+values: The rows of the ids, of shape `ids.shape + value_shape`.
+)doc");
+
+namespace {
+
+// Checks the scalar learning rate at input `lr`, and the gradient and indices
+// that follow it, of an embedding variable sparse apply op.
+Status EmbeddingVariableSparseApplyShapeFn(InferenceContext* c, int lr) {
+  ShapeHandle unused;
+  for (int i = 0; i <= lr; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  ShapeHandle grad;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(lr + 1), 2, &grad));
+  ShapeHandle indices;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(lr + 2), 1, &indices));
+  DimensionHandle unused_dim;
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(indices, 0), c->Dim(grad, 0), &unused_dim));
+  return Status::OK();
+}
+
+}  // namespace
+
+REGISTER_OP("EmbeddingVariableSparseApplyGradientDescent")
+    .Input("var: resource")
+    .Input("alpha: float")
+    .Input("grad: float")
+    .Input("indices: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      return EmbeddingVariableSparseApplyShapeFn(c, 1 /* lr */);
+    })
+    .Doc(R"doc(
+Update rows of an embedding variable by subtracting 'alpha' * 'grad' from them.
+
+The rows of the indices that do not exist yet are created before the update.
+The update of each row is atomic with respect to the other ops on the variable.
+
+var: Handle to the embedding variable.
+alpha: Scaling factor. Must be a scalar.
+grad: The gradient, one row for each of the indices.
+indices: A vector of ids of rows of var.
+)doc");
+
+REGISTER_OP("EmbeddingVariableSparseApplyAdagrad")
+    .Input("var: resource")
+    .Input("accum: resource")
+    .Input("lr: float")
+    .Input("grad: float")
+    .Input("indices: int64")
+    .SetShapeFn([](InferenceContext* c) {
+      return EmbeddingVariableSparseApplyShapeFn(c, 2 /* lr */);
+    })
+    .Doc(R"doc(
+Update rows of an embedding variable according to the adagrad scheme.
+
+That is for rows we have grad for, we update var and accum as follows:
+accum += grad * grad
+var -= lr * grad * (1 / sqrt(accum))
+
+The rows of the indices that do not exist yet are created before the update,
+so accum should be created with a positive initial_value.  The update of each
+row of accum, and then of var, is atomic with respect to the other ops on the
+variable.
+
+var: Handle to the embedding variable.
+accum: Handle to the embedding variable of the accumulators, with the same
+  value_shape as var.
+lr: Learning rate. Must be a scalar.
+grad: The gradient, one row for each of the indices.
+indices: A vector of ids of rows of var and accum.
+)doc");
+
 REGISTER_OP("InitializeTable")
     .Input("table_handle: Ref(string)")
     .Input("keys: Tkey")
@@ -2532,6 +2780,8 @@ handle: The handle for a tensor stored in the session state.
 
 REGISTER_OP("Stage")
     .Input("values: dtypes")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
     .Attr("dtypes: list(type)")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
@@ -2543,6 +2793,10 @@ Op is similar to a queue with many fewer capabilities and options.  This Op is
 optimized for performance.
 
 values: a list of tensors
+capacity: Maximum number of elements in the Staging Area. If > 0, inserts
+  on the container will block when the capacity is reached.
+memory_limit: The maximum number of bytes allowed for Tensors in the Staging
+  Area. If > 0, inserts will block until sufficient space is available.
 container: If non-empty, this queue is placed in the given container. Otherwise,
   a default container is used.
 shared_name: It is necessary to match this name to the matching Unstage Op.
@@ -2550,6 +2804,8 @@ shared_name: It is necessary to match this name to the matching Unstage Op.
 
 REGISTER_OP("Unstage")
     .Output("values: dtypes")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
     .Attr("dtypes: list(type)")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
@@ -2561,6 +2817,31 @@ dequeue with many fewer capabilities and options.  This Op is optimized for
 performance.
     )doc");
 
+REGISTER_OP("StageSize")
+    .Output("size: int32")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
+    .Attr("dtypes: list(type)")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .SetIsStateful()
+    .Doc(R"doc(
+Op returns the number of elements in the underlying container.
+    )doc");
+
+REGISTER_OP("StageClear")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
+    .Attr("dtypes: list(type)")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .SetIsStateful()
+    .Doc(R"doc(
+Op removes all elements in the underlying container.
+    )doc");
+
 REGISTER_OP("RecordInput")
     .Output("records: string")
     .Attr("file_pattern: string")
@@ -2569,6 +2850,8 @@ REGISTER_OP("RecordInput")
     .Attr("file_buffer_size: int = 10000")
     .Attr("file_parallelism: int = 16")
     .Attr("batch_size: int = 32")
+    .Attr("spill_dir: string = ''")
+    .Attr("num_spill_files: int = 64")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnknownShape)
     .Doc(R"doc(
@@ -2582,6 +2865,11 @@ file_shuffle_shift_ratio: Shifts the list of files after the list is randomly
 file_buffer_size: The randomization shuffling buffer.
 file_parallelism: How many sstables are opened and concurrently iterated over.
 batch_size: The batch size.
+spill_dir: If not empty, the records of each epoch are first written to
+    randomly chosen temporary files in this directory, which are then read in
+    a random order, so that the records are shuffled across the whole epoch.
+num_spill_files: The number of temporary files the records of an epoch are
+    spilled to.
 )doc");
 
 }  // namespace tensorflow
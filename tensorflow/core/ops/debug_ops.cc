@@ -190,4 +190,50 @@ gated_grpc: Whether this op will be gated. If any of the debug_urls of this
 
 )doc");
 
+REGISTER_OP("DebugNumericsMonitor")
+    .Input("input: T")
+    .Output("output: double")
+    .Attr("T: {half, float, double}")
+    .Attr("tensor_name: string = ''")
+    .Attr("debug_urls: list(string) = []")
+    .Attr("readback_interval: int = 100")
+    .Attr("mute_if_healthy: bool = false")
+    .Attr("gated_grpc: bool = false")
+    .SetAllowsUninitializedInput()
+    .Doc(R"doc(
+Debug Numerics Monitor Op.
+
+Accumulates the NaN and infinity counts and the range of the input tensor
+across steps, on the device of the input, without synchronizing with it. The
+accumulated values are copied to the host asynchronously every
+readback_interval steps, and every step after a summary that had NaN or
+infinite elements until one has none. Each summary read back is sent to the
+debug URLs.
+
+input: Input tensor, non-Reference type, half, float or double.
+output: The summary last read back, a double tensor of shape [7], the elements
+  of which are:
+  [0]: number of steps accumulated in the summary.
+  [1]: total number of elements in those steps.
+  [2]: NaN element count.
+  [3]: -inf element count.
+  [4]: +inf element count.
+  [5]: minimum of all non-inf and non-NaN elements, or +inf if none.
+  [6]: maximum of all non-inf and non-NaN elements, or -inf if none.
+  All elements are zero until the first summary is read back.
+tensor_name: Name of the input tensor.
+debug_urls: List of URLs to debug targets, e.g.,
+  file:///foo/tfdbg_dump, grpc:://localhost:11011
+readback_interval: (int) The number of steps accumulated between two copies to
+  the host, when the last summary had no NaN or infinite element.
+mute_if_healthy: (bool) Do not send summaries to the debug URLs unless they
+  have NaN or infinite elements.
+gated_grpc: Whether this op will be gated. If any of the debug_urls of this
+  debug node is of the grpc:// scheme, when the value of this attribute is set
+  to True, the data will not actually be sent via the grpc stream unless this
+  debug op has been enabled at the debug_url. If all of the debug_urls of this
+  debug node are of the grpc:// scheme and the debug op is enabled at none of
+  them, the output will be an empty Tensor.
+)doc");
+
 }  // namespace tensorflow
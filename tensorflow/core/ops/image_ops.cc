@@ -366,6 +366,62 @@ dct_method: string specifying a hint about the algorithm used for
 image: 3-D with shape `[height, width, channels]`..
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeJpegBatch")
+    .Input("contents: string")
+    .Input("crop_windows: int32")
+    .Input("size: int32")
+    .Attr("channels: int = 3")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("dct_method: string = ''")
+    .Output("images: uint8")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &crop_windows));
+      DimensionHandle batch_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(contents, 0), c->Dim(crop_windows, 0), &batch_dim));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_windows, 1), 4, &unused));
+
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels != 1 && channels != 3) {
+        return errors::InvalidArgument("channels must be 1 or 3, got ",
+                                       channels);
+      }
+      return SetOutputToSizedImage(c, batch_dim, 2 /* size_input_idx */,
+                                   c->MakeDim(channels));
+    })
+    .Doc(R"doc(
+Decode a batch of JPEG-encoded images, cropping and resizing them to a common
+size.
+
+Each image is decoded at the largest of the downscaling ratios 1, 2, 4 and 8
+that keeps its crop window at least as large as `size`, and only the rows and
+most of the columns of the window are decoded.  The decoded window is then
+bilinearly resized to `size`.  This is much faster than decoding the whole
+images and cropping and resizing them later, and the images are decoded in
+parallel.
+
+contents: 1-D with shape `[batch]`.  The JPEG-encoded images.
+crop_windows: 2-D with shape `[batch, 4]`.  The `i`-th row is the window
+  `[y, x, height, width]` of the `i`-th image to crop, in pixels of the
+  original image.  A window of zero height or width stands for the whole image.
+size: A 1-D int32 Tensor of 2 elements: `new_height, new_width`.  The new size
+  of the images.
+channels: Number of color channels for the decoded images, 1 or 3.
+fancy_upscaling: If true use a slower but nicer upscaling of the
+  chroma planes (yuv420/422 only).
+dct_method: string specifying a hint about the algorithm used for
+  decompression.  Defaults to "" which maps to a system-specific
+  default.  Currently valid values are ["INTEGER_FAST",
+  "INTEGER_ACCURATE"].
+images: 4-D with shape `[batch, new_height, new_width, channels]`.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -95,6 +95,55 @@ shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
 tensors: `N` tensors to save.
 )doc");
 
+REGISTER_OP("SaveDeltaV2")
+    .Input("prefix: string")
+    .Input("base_prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("resources: N * resource")
+    .Attr("N: int >= 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+
+      // Validate prefix and base_prefix.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      // Validate tensor_names and shapes_and_slices.
+      for (int i = 2; i <= 3; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(
+            c->WithValue(c->Dim(s, 0), c->num_inputs() - 4, &unused_dim));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Saves resource variables in a V2 checkpoint that is a delta on a base one.
+
+For each variable, saves only the rows changed since the variable was last
+saved by this op, and restoring from "prefix" reads the other rows from
+"base_prefix".  A variable updated other than by sparse apply or scatter ops,
+or never saved by this op before, is saved in full.  A save holding no change
+to a variable stores nothing for it.  An empty "base_prefix" saves every
+variable in full, in a checkpoint with no base.
+
+"base_prefix" must name a checkpoint written after the previous save of the
+variables by this op, usually that previous one, or the rows changed in
+between are lost.
+
+prefix: Must have a single element. The prefix of the V2 checkpoint to which we
+  write the variables.
+base_prefix: Must have a single element. The prefix of the V2 checkpoint the
+  written one is a delta on.
+tensor_names: shape {N}. The names of the variables to be saved.
+shape_and_slices: shape {N}.  The slice specs of the variables to be saved.
+  Empty strings indicate that they are non-partitioned variables.
+resources: `N` resource variables to save.
+)doc");
+
 REGISTER_OP("RestoreV2")
     .Input("prefix: string")
     .Input("tensor_names: string")
@@ -520,6 +569,36 @@ shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
 )doc");
 
+REGISTER_OP("ParallelTFRecordReader")
+    .Output("reader_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("compression_type: string = ''")
+    .Attr("num_parallel_files: int >= 1 = 4")
+    .Attr("buffer_size: int >= 1 = 256")
+    .Attr("sloppy: bool = false")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+A Reader that outputs the interleaved records of several TensorFlow Records
+files, which it reads concurrently.
+
+Up to `num_parallel_files` work items are read at once, each on its own
+thread, and the records are taken from them in turn.  A file that ends is
+replaced by the next work item from the queue.
+
+reader_handle: The handle to reference the Reader.
+container: If non-empty, this reader is placed in the given container.
+        Otherwise, a default container is used.
+shared_name: If non-empty, this reader is named in the given bucket
+             with this shared_name. Otherwise, the node name is used instead.
+num_parallel_files: The number of files read at the same time.
+buffer_size: The number of records read ahead for each file.
+sloppy: If true, the next record is taken from any file that has one ready,
+        instead of from each file in turn, so the order of the records is
+        not deterministic.
+)doc");
+
 // TODO(cwhipkey): mark this deprecated in favor of V2.
 REGISTER_OP("IdentityReader")
     .Output("reader_handle: Ref(string)")
@@ -821,6 +900,49 @@ filename: scalar. The name of the file to which we write the contents.
 contents: scalar. The content to be written to the output file.
 )doc");
 
+REGISTER_OP("ReadColumnarChunk")
+    .Input("filename: string")
+    .Input("chunk: int64")
+    .Output("values: dtypes")
+    .Output("row_lengths: int64")
+    .Attr("columns: list(string) >= 1")
+    .Attr("dtypes: list(type) >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      std::vector<string> columns;
+      TF_RETURN_IF_ERROR(c->GetAttr("columns", &columns));
+      if (static_cast<int>(columns.size()) != c->num_outputs() - 1) {
+        return errors::InvalidArgument("Got ", columns.size(),
+                                       " columns but ", c->num_outputs() - 1,
+                                       " dtypes");
+      }
+      for (int i = 0; i < columns.size(); ++i) {
+        c->set_output(i, c->UnknownShape());
+      }
+      c->set_output(columns.size(),
+                    c->Matrix(columns.size(), InferenceContext::kUnknownDim));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Reads the given columns of a chunk of rows of a columnar table.
+
+Only the data of the requested columns is read from the file, and each column
+is decoded with a single copy into its output tensor.  See
+tensorflow/core/util/columnar/columnar_table.h for the file format.
+
+filename: scalar. The name of the columnar table file.
+chunk: scalar. The index of the chunk to read.
+columns: The names of the columns to read.
+dtypes: The types of the columns.  Must match those stored in the table.
+values: For a fixed column, its rows stacked into a tensor of shape
+  [num_rows] + row_shape.  For a variable-length column, the values of all its
+  rows concatenated into a vector.
+row_lengths: shape [N, num_rows].  The number of values in each row of each
+  column.
+)doc");
+
 REGISTER_OP("MatchingFiles")
     .Input("pattern: string")
     .Output("filenames: string")
@@ -1067,6 +1067,32 @@ transpose_a: If true, "a" is transposed before multiplication.
 transpose_b: If true, "b" is transposed before multiplication.
 )doc");
 
+REGISTER_OP("_FusedMatMul")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("bias: T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {float}")
+    .Attr("activation: {'Identity', 'Relu', 'Relu6'} = 'Identity'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      return shape_inference::MatMulShape(c);
+    })
+    .Doc(R"doc(
+Computes `activation(BiasAdd(MatMul(a, b), bias))`.
+
+The bias and the activation are applied in the same pass over the product.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+bias: A 1-D tensor with the size of the columns of the product.
+activation: The activation applied to the sum of the product and the bias.
+)doc");
+
 REGISTER_OP("SparseMatMul")
     .Input("a: Ta")
     .Input("b: Tb")
@@ -1087,6 +1113,48 @@ least one of "a" or "b" is sparse. The breakeven for using this versus a dense
 matrix multiply on one platform was 30% zero values in the sparse matrix.
 )doc");
 
+REGISTER_OP("_BlockSparseMatMul")
+    .Input("a: float")
+    .Input("b_values: float")
+    .Input("b_block_rows: int32")
+    .Input("b_block_splits: int32")
+    .Input("b_dense_shape: int64")
+    .Output("product: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->MakeShapeFromShapeTensor(4, &b));
+      TF_RETURN_IF_ERROR(c->WithRank(b, 2, &b));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(a, 1), c->Dim(b, 0), &unused_dim));
+      c->set_output(0, c->Matrix(c->Dim(a, 0), c->Dim(b, 1)));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Multiplies the dense matrix "a" by the block-sparse matrix "b".
+
+"b" is stored by blocks of one row and `block_size` consecutive columns, where
+`block_size` is the second dimension of `b_values`. The columns are split into
+groups of `block_size`, the last one possibly smaller, and the non-zero blocks
+of each group are stored consecutively in the order of their rows.
+
+NOTE Do not invoke this operator directly in Python. The sparsify_matmul graph
+transform is expected to create these operators.
+
+b_values: The values of the non-zero blocks, of shape `[num_blocks,
+  block_size]`. The columns of the last blocks past `b_dense_shape[1]` are
+  ignored.
+b_block_rows: The row of each non-zero block.
+b_block_splits: The non-zero blocks of the i-th group of columns are
+  `b_values[b_block_splits[i]:b_block_splits[i + 1]]`.
+b_dense_shape: The shape of "b".
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
@@ -1330,7 +1398,10 @@ Status SparseSegmentReductionShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
-Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
+// Shape function of the gradients of sparse segment reductions, whose input
+// `dim0_input` is output_dim0.
+Status SparseSegmentReductionGradShapeFnWithDim0(InferenceContext* c,
+                                                 int dim0_input) {
   ShapeHandle data_shape;
   TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &data_shape));
 
@@ -1342,12 +1413,12 @@ Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
   TF_RETURN_IF_ERROR(c->Merge(c->input(2), indices_shape, &unused));
 
   // output_dim0 should be a scalar
-  TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(dim0_input), 0, &unused));
 
   ShapeHandle subshape;
   TF_RETURN_IF_ERROR(c->Subshape(data_shape, 1, &subshape));
 
-  const Tensor* dim0 = c->input_tensor(3);
+  const Tensor* dim0 = c->input_tensor(dim0_input);
   ShapeHandle dim0_shape;
   if (dim0 == nullptr) {
     // We don't have the value at inference time, so the output
@@ -1368,6 +1439,22 @@ Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
   return Status::OK();
 }
 
+Status SparseSegmentReductionGradShapeFn(InferenceContext* c) {
+  return SparseSegmentReductionGradShapeFnWithDim0(c, 3);
+}
+
+Status SparseEmbeddingCombineShapeFn(InferenceContext* c) {
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+  return SparseSegmentReductionShapeFn(c);
+}
+
+Status SparseEmbeddingCombineGradShapeFn(InferenceContext* c) {
+  ShapeHandle unused;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+  return SparseSegmentReductionGradShapeFnWithDim0(c, 4);
+}
+
 Status UnsortedSegmentReductionShapeFn(InferenceContext* c) {
   ShapeHandle s_data = c->input(0);
   ShapeHandle s_segment_ids = c->input(1);
@@ -1763,6 +1850,62 @@ segment_ids: segment_ids passed to the corresponding SparseSegmentSqrtN op.
 output_dim0: dimension 0 of "data" passed to SparseSegmentSqrtN op.
 )doc");
 
+REGISTER_OP("SparseEmbeddingCombine")
+    .Input("data: T")
+    .Input("indices: int32")
+    .Input("segment_ids: int32")
+    .Input("weights: T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'}")
+    .SetShapeFn(SparseEmbeddingCombineShapeFn)
+    .Doc(R"doc(
+Computes the weighted combination of rows of a tensor along sparse segments.
+
+Like `SparseSegmentSum`, but each row of `data` selected by `indices` is
+multiplied by the corresponding element of `weights`, and the weighted sum of
+each segment is scaled as specified by `combiner`:
+
+- "sum": the weighted sum.
+- "mean": the weighted sum divided by the sum of the weights of the segment.
+- "sqrtn": the weighted sum divided by the square root of the sum of the
+  squares of the weights of the segment.
+
+Segments whose weights sum up to zero are zero for "mean" and "sqrtn".  The
+rows are gathered and combined in a single pass, without intermediate tensors,
+and the segments are combined in parallel.  This is the combining step of
+`embedding_lookup_sparse`.
+
+indices: A 1-D tensor. Has same rank as `segment_ids`.
+segment_ids: A 1-D tensor. Values should be sorted and can be repeated.
+weights: A 1-D tensor of the size of `indices`, or empty for weights of 1.
+output: Has same shape as data, except for dimension 0 which
+  has size `k`, the number of segments.
+)doc");
+
+REGISTER_OP("SparseEmbeddingCombineGrad")
+    .Input("grad: T")
+    .Input("indices: int32")
+    .Input("segment_ids: int32")
+    .Input("weights: T")
+    .Input("output_dim0: int32")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'}")
+    .SetShapeFn(SparseEmbeddingCombineGradShapeFn)
+    .Doc(R"doc(
+Computes gradients for SparseEmbeddingCombine with respect to data.
+
+Returns tensor "output" with same shape as grad, except for dimension 0 whose
+value is output_dim0.
+
+grad: gradient propagated to the SparseEmbeddingCombine op.
+indices: indices passed to the corresponding SparseEmbeddingCombine op.
+segment_ids: segment_ids passed to the corresponding SparseEmbeddingCombine op.
+weights: weights passed to the corresponding SparseEmbeddingCombine op.
+output_dim0: dimension 0 of "data" passed to SparseEmbeddingCombine op.
+)doc");
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
@@ -2188,8 +2331,8 @@ REGISTER_OP("QuantizedMatMul")
       ShapeHandle unused;
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(4), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
 
       c->set_output(1, c->Scalar());
       c->set_output(2, c->Scalar());
@@ -2209,8 +2352,11 @@ transpose_a: If true, `a` is transposed before multiplication.
 transpose_b: If true, `b` is transposed before multiplication.
 min_a: The float value that the lowest quantized `a` value represents.
 max_a: The float value that the highest quantized `a` value represents.
-min_b: The float value that the lowest quantized `b` value represents.
-max_b: The float value that the highest quantized `b` value represents.
+min_b: The float value that the lowest quantized `b` value represents, or a
+  vector of one value per output column for per-channel quantization.
+max_b: The float value that the highest quantized `b` value represents, or a
+  vector of one value per output column for per-channel quantization. The
+  ranges of all the columns must quantize zero to the same value.
 min_out: The float value that the lowest quantized output value represents.
 max_out: The float value that the highest quantized output value represents.
 Tactivation: The type of output produced by activation function
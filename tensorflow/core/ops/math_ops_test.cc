@@ -345,6 +345,33 @@ TEST(MathOpsTest, SparseSegmentGrad_ShapeFn) {
   INFER_ERROR("Cannot specify a negative value", op, "[2,4,3];[3];[3];[]");
 }
 
+TEST(MathOpsTest, SparseEmbeddingCombine_ShapeFn) {
+  ShapeInferenceTestOp op("SparseEmbeddingCombine");
+  INFER_OK(op, "?;?;?;?", "?");
+  INFER_OK(op, "[2,4,3];[3];[3];[3]", "[?,d0_1,d0_2]");
+  INFER_OK(op, "[2,4,3];[3];[3];[0]", "[?,d0_1,d0_2]");
+
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op, "[2,4,3];[3];[3];[]");
+  INFER_ERROR("Dimension 0 in both shapes must be equal, but are 3 and 4", op,
+              "[2,4,3];[3];[4];[3]");
+}
+
+TEST(MathOpsTest, SparseEmbeddingCombineGrad_ShapeFn) {
+  ShapeInferenceTestOp op("SparseEmbeddingCombineGrad");
+  op.input_tensors.resize(5);
+  INFER_OK(op, "?;?;?;?;?", "?");
+  INFER_OK(op, "[2,4,3];[3];[3];[3];[]", "[?,d0_1,d0_2]");
+
+  Tensor output_dim0_t = test::AsScalar(100);
+  op.input_tensors[4] = &output_dim0_t;
+  INFER_OK(op, "[2,4,3];[3];[3];[3];[]", "[100,d0_1,d0_2]");
+
+  INFER_ERROR("Shape must be rank 1 but is rank 2", op,
+              "[2,4,3];[3];[3];[3,1];[]");
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op,
+              "[2,4,3];[3];[3];[3];[1]");
+}
+
 TEST(MathOpsTest, BatchMatMul_ShapeFn) {
   ShapeInferenceTestOp op("BatchMatMul");
   auto set_adj = [&op](bool adj_x, bool adj_y) {
@@ -552,6 +552,36 @@ data_format: Specify the data format of the input and output data. With the
         [batch, channels, height, width].
 )doc");
 
+REGISTER_OP("_FusedConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("bias: T")
+    .Output("output: T")
+    .Attr("T: {half, float}")
+    .Attr("strides: list(int)")
+    .Attr("use_cudnn_on_gpu: bool = true")
+    .Attr(GetPaddingAttrString())
+    .Attr(GetConvnetDataFormatAttrString())
+    .Attr("activation: {'Identity', 'Relu', 'Relu6'} = 'Identity'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      return shape_inference::Conv2DShape(c);
+    })
+    .Doc(R"doc(
+Computes `activation(BiasAdd(Conv2D(input, filter), bias))`.
+
+The bias and the activation are applied in the same pass over the output of
+the convolution.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+bias: A 1-D tensor with the size of the output channels.
+activation: The activation applied to the sum of the convolution and the
+  bias.
+)doc");
+
 REGISTER_OP("Conv2DBackpropInput")
     .Input("input_sizes: int32")
     .Input("filter: T")
@@ -1928,6 +1958,129 @@ loss: Per example loss (batch_size vector).
 backprop: backpropagated gradients (batch_size x num_classes matrix).
 )doc");
 
+REGISTER_OP("SampledSoftmaxLoss")
+    .Input("weights: T")
+    .Input("biases: T")
+    .Input("inputs: T")
+    .Input("labels: int64")
+    .Input("sampled_candidates: int64")
+    .Input("true_expected_count: float")
+    .Input("sampled_expected_count: float")
+    .Output("loss: T")
+    .Output("backprop: T")
+    .Attr("T: {float, double}")
+    .Attr("remove_accidental_hits: bool = true")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle weights;
+      ShapeHandle biases;
+      ShapeHandle inputs;
+      ShapeHandle labels;
+      ShapeHandle sampled;
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &weights));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &biases));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &inputs));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 2, &labels));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 1, &sampled));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(weights, 0), c->Dim(biases, 0), &unused_dim));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(weights, 1), c->Dim(inputs, 1), &unused_dim));
+      DimensionHandle batch_size;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(inputs, 0), c->Dim(labels, 0), &batch_size));
+      TF_RETURN_IF_ERROR(c->Merge(c->input(5), labels, &unused));
+      TF_RETURN_IF_ERROR(c->Merge(c->input(6), sampled, &unused));
+      DimensionHandle num_logits;
+      TF_RETURN_IF_ERROR(
+          c->Add(c->Dim(labels, 1), c->Dim(sampled, 0), &num_logits));
+      c->set_output(0, c->Vector(batch_size));
+      c->set_output(1, c->Matrix(batch_size, num_logits));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the sampled softmax loss and its gradient with respect to the logits.
+
+The logits of each example are those of its `num_true` true classes and of the
+`num_sampled` sampled classes: the dot products of `inputs` with the
+corresponding rows of `weights`, plus `biases`, minus the log of the expected
+counts of the classes.  The loss is the softmax cross entropy of these logits
+against labels that give each true class a probability of 1 / `num_true`.
+This is the loss of `tf.nn.sampled_softmax_loss` computed in a single kernel:
+the true logits are dot products with rows read in place in `weights`, and the
+sampled rows are gathered once and multiplied with `inputs` as a matrix.
+
+weights: `[num_classes, dim]`, the class embeddings.
+biases: `[num_classes]`, the class biases.
+inputs: `[batch_size, dim]`, the forward activations of the input network.
+labels: `[batch_size, num_true]`, the target classes.
+sampled_candidates: `[num_sampled]`, the sampled classes.
+true_expected_count: `[batch_size, num_true]`, the expected counts of the
+  target classes under the sampling distribution.
+sampled_expected_count: `[num_sampled]`, the expected counts of the sampled
+  classes.
+remove_accidental_hits: Whether to remove the sampled classes of an example
+  that equal one of its target classes.
+loss: Per example loss (batch_size vector).
+backprop: The gradient of the loss with respect to the logits, the true ones
+  first (batch_size x (num_true + num_sampled) matrix).
+)doc");
+
+REGISTER_OP("SampledSoftmaxLossGrad")
+    .Input("grad_loss: T")
+    .Input("backprop: T")
+    .Input("weights: T")
+    .Input("inputs: T")
+    .Input("labels: int64")
+    .Input("sampled_candidates: int64")
+    .Output("inputs_grad: T")
+    .Output("weights_grad: T")
+    .Output("biases_grad: T")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle weights;
+      ShapeHandle inputs;
+      ShapeHandle labels;
+      ShapeHandle sampled;
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &weights));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 2, &inputs));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 2, &labels));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 1, &sampled));
+      DimensionHandle dim;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(weights, 1), c->Dim(inputs, 1), &dim));
+      DimensionHandle num_true_rows;
+      TF_RETURN_IF_ERROR(c->Multiply(c->Dim(labels, 0), c->Dim(labels, 1),
+                                     &num_true_rows));
+      DimensionHandle num_rows;
+      TF_RETURN_IF_ERROR(
+          c->Add(num_true_rows, c->Dim(sampled, 0), &num_rows));
+      c->set_output(0, inputs);
+      c->set_output(1, c->Matrix(num_rows, dim));
+      c->set_output(2, c->Vector(num_rows));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the gradients of SampledSoftmaxLoss.
+
+grad_loss: The gradient with respect to the `loss` output of
+  SampledSoftmaxLoss.
+backprop: The `backprop` output of SampledSoftmaxLoss.
+weights: The `weights` passed to SampledSoftmaxLoss.
+inputs: The `inputs` passed to SampledSoftmaxLoss.
+labels: The `labels` passed to SampledSoftmaxLoss.
+sampled_candidates: The `sampled_candidates` passed to SampledSoftmaxLoss.
+inputs_grad: The gradient with respect to `inputs`.
+weights_grad: The gradient with respect to the rows of `weights` given by the
+  flattened `labels` followed by `sampled_candidates`, one row per id
+  (repeated ids are not summed).
+biases_grad: The gradient with respect to the elements of `biases` given by
+  the same ids as `weights_grad`.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("InTopK")
@@ -2386,8 +2539,8 @@ REGISTER_OP("QuantizedConv2D")
       ShapeHandle unused;
       TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 0, &unused));
       TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 0, &unused));
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(5), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(4), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
       c->set_output(1, c->Scalar());
       c->set_output(2, c->Scalar());
       return Status::OK();
@@ -2405,13 +2558,73 @@ strides: The stride of the sliding window for each dimension of the input
 padding: The type of padding algorithm to use.
 min_input: The float value that the lowest quantized input value represents.
 max_input: The float value that the highest quantized input value represents.
-min_filter: The float value that the lowest quantized filter value represents.
-max_filter: The float value that the highest quantized filter value represents.
+min_filter: The float value that the lowest quantized filter value represents,
+  or a vector of one value per output channel for per-channel quantization.
+max_filter: The float value that the highest quantized filter value represents,
+  or a vector of one value per output channel for per-channel quantization.
+  The ranges of all the channels must quantize zero to the same value.
 min_output: The float value that the lowest quantized output value represents.
 max_output: The float value that the highest quantized output value represents.
 
 )doc");
 
+REGISTER_OP("_QuantizedConv2DAndRequantize")
+    .Input("input: Tinput")
+    .Input("filter: Tfilter")
+    .Input("bias: float")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_filter: float")
+    .Input("max_filter: float")
+    .Input("min_freezed_output: float")
+    .Input("max_freezed_output: float")
+    .Output("output: out_type")
+    .Output("min_output: float")
+    .Output("max_output: float")
+    .Attr("Tinput: quantizedtype")
+    .Attr("Tfilter: quantizedtype")
+    .Attr("out_type: quantizedtype = DT_QUINT8")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("fuse_relu: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::Conv2DShape(c));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      for (int i : {3, 4, 7, 8}) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(5), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(6), 1, &unused));
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes QuantizedConv2D, adds 'bias' and requantizes the result into the
+range ['min_freezed_output', 'max_freezed_output'], optionally followed by a
+QuantizedRelu.
+
+The 32-bit accumulators of the convolution are converted to 'out_type' chunk by
+chunk, so the graph doesn't need a RequantizationRange and a Requantize after
+the convolution.
+
+bias: A 1-D float tensor with one value per output channel.
+min_filter: A scalar, or a vector of one value per output channel for
+  per-channel quantization.
+max_filter: A scalar, or a vector of one value per output channel for
+  per-channel quantization.
+min_freezed_output: The float value that the lowest quantized output value
+  represents.
+max_freezed_output: The float value that the highest quantized output value
+  represents.
+fuse_relu: Whether to clamp the output values below zero.
+
+NOTE Do not invoke this operator directly in Python. The
+fuse_quantized_conv_requantize graph transform is expected to create these
+operators.
+)doc");
+
 REGISTER_OP("QuantizedMaxPool")
     .Input("input: T")
     .Input("min_input: float")
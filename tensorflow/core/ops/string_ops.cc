@@ -245,6 +245,40 @@ shape: a length-2 vector of int64 representing the shape of the sparse
   of tokens in a single input entry.
 )doc");
 
+REGISTER_OP("StringSplitToHashBucketFast")
+    .Input("input: string")
+    .Input("delimiter: string")
+    .Output("indices: int64")
+    .Output("values: int64")
+    .Output("shape: int64")
+    .Attr("num_buckets: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      c->set_output(0, c->Matrix(InferenceContext::kUnknownDim, 2));
+      c->set_output(1, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(2, c->Vector(2));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Splits the elements of `input` like `StringSplit`, and hashes the tokens into
+buckets like `StringToHashBucketFast`.
+
+The result is the same as applying `StringToHashBucketFast` to the values of
+`StringSplit`, without creating a string per token in between.
+
+input: 1-D. Strings to split.
+delimiter: 0-D. Delimiter characters (bytes), or empty string.
+indices: A dense matrix of int64 representing the indices of the sparse tensor.
+values: A vector of the bucket ids of the tokens, in [0, num_buckets).
+shape: a length-2 vector of int64 representing the shape of the sparse
+  tensor, where the first value is N and the second value is the maximum number
+  of tokens in a single input entry.
+num_buckets: The number of buckets.
+)doc");
+
 REGISTER_OP("EncodeBase64")
     .Input("input: string")
     .Output("output: string")
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
 
@@ -55,6 +58,33 @@ static Status HandleGradAndIndicesInputs(InferenceContext* c, bool sparse,
   return Status::OK();
 }
 
+// Handles the inputs of a multi-tensor apply op, which are the lists of the
+// 'N' inputs of the apply ops it groups, the ones at 'scalar_inputs' being
+// scalars. The lists of the variables come first.
+static Status MultiApplyShapeFn(InferenceContext* c,
+                                const std::vector<int>& scalar_inputs) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  const int num_inputs = c->num_inputs() / n;
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = ShapeOrHandleShape(c, i);  // var
+    for (int input = 1; input < num_inputs; ++input) {
+      if (std::find(scalar_inputs.begin(), scalar_inputs.end(), input) !=
+          scalar_inputs.end()) {
+        ShapeHandle unused;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(input * n + i), 0, &unused));
+      } else {
+        TF_RETURN_IF_ERROR(
+            c->Merge(s, ShapeOrHandleShape(c, input * n + i), &s));
+      }
+    }
+    if (c->num_outputs() > 0) {
+      c->set_output(i, s);
+    }
+  }
+  return Status::OK();
+}
+
 static Status ApplyGradientDescentShapeFn(InferenceContext* c) {
   ShapeHandle unused;
   ShapeHandle s = ShapeOrHandleShape(c, 0);                  // var
@@ -537,8 +567,8 @@ grad: The gradient.
 indices: A vector of indices into the first dimension of var and accum.
 out: Same as "var".
 use_locking: If `True`, updating of the var and accum tensors will be protected
-  by a lock; otherwise the behavior is undefined, but may exhibit less
-  contention.
+  by a lock; otherwise each row is updated under a lock of the row, so that
+  concurrent updates only contend on the rows they share.
 )doc");
 
 REGISTER_OP("ResourceSparseApplyAdagrad")
@@ -566,8 +596,8 @@ lr: Learning rate. Must be a scalar.
 grad: The gradient.
 indices: A vector of indices into the first dimension of var and accum.
 use_locking: If `True`, updating of the var and accum tensors will be protected
-  by a lock; otherwise the behavior is undefined, but may exhibit less
-  contention.
+  by a lock; otherwise each row is updated under a lock of the row, so that
+  concurrent updates only contend on the rows they share.
 )doc");
 
 static Status ApplyAdagradDAShapeFn(InferenceContext* c, bool sparse) {
@@ -880,8 +910,8 @@ l2: L2 regularization. Must be a scalar.
 lr_power: Scaling factor. Must be a scalar.
 out: Same as "var".
 use_locking: If `True`, updating of the var and accum tensors will be protected
-  by a lock; otherwise the behavior is undefined, but may exhibit less
-  contention.
+  by a lock; otherwise each row is updated under a lock of the row, so that
+  concurrent updates only contend on the rows they share.
 )doc");
 
 REGISTER_OP("ResourceApplyFtrl")
@@ -956,8 +986,8 @@ l1: L1 regularization. Must be a scalar.
 l2: L2 regularization. Must be a scalar.
 lr_power: Scaling factor. Must be a scalar.
 use_locking: If `True`, updating of the var and accum tensors will be protected
-  by a lock; otherwise the behavior is undefined, but may exhibit less
-  contention.
+  by a lock; otherwise each row is updated under a lock of the row, so that
+  concurrent updates only contend on the rows they share.
 )doc");
 
 static Status ApplyMomentumShapeFn(InferenceContext* c, bool sparse) {
@@ -1080,6 +1110,51 @@ var - lr * momentum * accum, so in the end, the var you get is actually
 var - lr * momentum * accum.
 )doc");
 
+REGISTER_OP("_MultiApplyMomentum")
+    .Input("var: Ref(N * T)")
+    .Input("accum: Ref(N * T)")
+    .Input("lr: N * T")
+    .Input("grad: N * T")
+    .Input("momentum: N * T")
+    .Output("out: Ref(N * T)")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {2, 4} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ApplyMomentum to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_ResourceMultiApplyMomentum")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: N * T")
+    .Input("grad: N * T")
+    .Input("momentum: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {2, 4} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ResourceApplyMomentum to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 REGISTER_OP("ResourceSparseApplyMomentum")
     .Input("var: resource")
     .Input("accum: resource")
@@ -1251,6 +1326,59 @@ static Status ApplyCenteredRMSPropShapeFn(InferenceContext* c, bool sparse) {
   return Status::OK();
 }
 
+REGISTER_OP("_MultiApplyAdam")
+    .Input("var: Ref(N * T)")
+    .Input("m: Ref(N * T)")
+    .Input("v: Ref(N * T)")
+    .Input("beta1_power: N * T")
+    .Input("beta2_power: N * T")
+    .Input("lr: N * T")
+    .Input("beta1: N * T")
+    .Input("beta2: N * T")
+    .Input("epsilon: N * T")
+    .Input("grad: N * T")
+    .Output("out: Ref(N * T)")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {3, 4, 5, 6, 7, 8} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ApplyAdam to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_ResourceMultiApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: N * T")
+    .Input("beta2_power: N * T")
+    .Input("lr: N * T")
+    .Input("beta1: N * T")
+    .Input("beta2: N * T")
+    .Input("epsilon: N * T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {3, 4, 5, 6, 7, 8} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ResourceApplyAdam to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 REGISTER_OP("ApplyRMSProp")
     .Input("var: Ref(T)")
     .Input("ms: Ref(T)")
@@ -1478,6 +1606,55 @@ use_locking: If `True`, updating of the var, ms, and mom tensors is protected
   contention.
 )doc");
 
+REGISTER_OP("_MultiApplyRMSProp")
+    .Input("var: Ref(N * T)")
+    .Input("ms: Ref(N * T)")
+    .Input("mom: Ref(N * T)")
+    .Input("lr: N * T")
+    .Input("rho: N * T")
+    .Input("momentum: N * T")
+    .Input("epsilon: N * T")
+    .Input("grad: N * T")
+    .Output("out: Ref(N * T)")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {3, 4, 5, 6} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ApplyRMSProp to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_ResourceMultiApplyRMSProp")
+    .Input("var: N * resource")
+    .Input("ms: N * resource")
+    .Input("mom: N * resource")
+    .Input("lr: N * T")
+    .Input("rho: N * T")
+    .Input("momentum: N * T")
+    .Input("epsilon: N * T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      return MultiApplyShapeFn(c, {3, 4, 5, 6} /* scalar_inputs */);
+    })
+    .Doc(R"doc(
+Applies ResourceApplyRMSProp to each of the 'N' variables 'var[i]'.
+
+The variables are updated in parallel, in a single pass over all of them.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 REGISTER_OP("ResourceApplyCenteredRMSProp")
     .Input("var: resource")
     .Input("mg: resource")
@@ -0,0 +1,205 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <algorithm>
+#include <cstring>
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+FileBlockCache::FileBlockCache(size_t block_size, size_t max_bytes,
+                               size_t prefetch_blocks, int num_fetch_threads,
+                               BlockFetcher block_fetcher, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      prefetch_blocks_(num_fetch_threads > 0 ? prefetch_blocks : 0),
+      block_fetcher_(std::move(block_fetcher)) {
+  if (num_fetch_threads > 0) {
+    fetch_pool_.reset(new thread::ThreadPool(env, ThreadOptions(),
+                                             "file_block_cache_fetch",
+                                             num_fetch_threads,
+                                             false /* low_latency_hint */));
+  }
+}
+
+FileBlockCache::~FileBlockCache() { fetch_pool_.reset(); }
+
+std::shared_ptr<FileBlockCache::Block> FileBlockCache::LookupOrCreate(
+    const Key& key, bool* created) {
+  auto iter = block_map_.find(key);
+  if (iter != block_map_.end()) {
+    *created = false;
+    lru_list_.splice(lru_list_.begin(), lru_list_, iter->second->lru_iter);
+    return iter->second;
+  }
+  *created = true;
+  std::shared_ptr<Block> block(new Block);
+  lru_list_.push_front(key);
+  block->lru_iter = lru_list_.begin();
+  block_map_.emplace(key, block);
+  return block;
+}
+
+void FileBlockCache::Fetch(const Key& key,
+                           const std::shared_ptr<Block>& block) {
+  std::vector<char> data;
+  data.reserve(block_size_);
+  const Status status = block_fetcher_(key.first, key.second, block_size_,
+                                       &data);
+  {
+    mutex_lock lock(mu_);
+    block->data.swap(data);
+    block->status = status;
+    block->done = true;
+    if (status.ok()) {
+      stats_.bytes_fetched += block->data.size();
+      if (!block->removed) {
+        cache_size_ += block->data.size();
+        Trim();
+      }
+    } else if (!block->removed) {
+      // Failed blocks are fetched again by the next read that needs them.
+      Remove(block_map_.find(key));
+    }
+  }
+  block_done_.notify_all();
+}
+
+void FileBlockCache::Remove(
+    std::map<Key, std::shared_ptr<Block>>::iterator iter) {
+  Block* block = iter->second.get();
+  if (block->done) {
+    cache_size_ -= block->data.size();
+  }
+  block->removed = true;
+  lru_list_.erase(block->lru_iter);
+  block_map_.erase(iter);
+}
+
+void FileBlockCache::Trim() {
+  // Walks from the least recently used block to the most recently used one.
+  auto key = lru_list_.end();
+  while (cache_size_ > max_bytes_ && key != lru_list_.begin()) {
+    --key;
+    auto iter = block_map_.find(*key);
+    if (!iter->second->done) {
+      // Blocks being fetched have no bytes in the cache yet.
+      continue;
+    }
+    // Remove() erases *key, so the walk goes on from its older neighbor.
+    auto older = std::next(key);
+    Remove(iter);
+    key = older;
+    ++stats_.evictions;
+  }
+}
+
+Status FileBlockCache::Read(const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  if (n == 0) {
+    return Status::OK();
+  }
+  const size_t first = offset - offset % block_size_;
+  const size_t last = offset + n - 1 - (offset + n - 1) % block_size_;
+  std::vector<std::shared_ptr<Block>> blocks;
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> to_fetch;
+  {
+    mutex_lock lock(mu_);
+    for (size_t pos = first; pos <= last; pos += block_size_) {
+      const Key key(filename, pos);
+      bool created;
+      blocks.push_back(LookupOrCreate(key, &created));
+      if (created) {
+        ++stats_.misses;
+        to_fetch.emplace_back(key, blocks.back());
+      } else {
+        ++stats_.hits;
+      }
+    }
+  }
+
+  // Fetches the missing blocks in parallel, the first one on this thread.
+  size_t num_inline_fetches = to_fetch.size();
+  if (fetch_pool_ != nullptr && !to_fetch.empty()) {
+    for (size_t i = 1; i < to_fetch.size(); ++i) {
+      const Key key = to_fetch[i].first;
+      std::shared_ptr<Block> block = to_fetch[i].second;
+      fetch_pool_->Schedule([this, key, block]() { Fetch(key, block); });
+    }
+    num_inline_fetches = 1;
+  }
+  for (size_t i = 0; i < num_inline_fetches; ++i) {
+    Fetch(to_fetch[i].first, to_fetch[i].second);
+  }
+
+  // Copies the requested range out of the blocks, up to the end of the file.
+  bool reached_eof = false;
+  for (size_t i = 0; i < blocks.size() && !reached_eof; ++i) {
+    const Block& block = *blocks[i];
+    {
+      mutex_lock lock(mu_);
+      while (!block.done) {
+        block_done_.wait(lock);
+      }
+    }
+    // The data of a done block is immutable, so it is read without the lock.
+    TF_RETURN_IF_ERROR(block.status);
+    const size_t pos = first + i * block_size_;
+    const size_t begin = i == 0 ? offset - first : 0;
+    const size_t end = std::min(block.data.size(), offset + n - pos);
+    if (begin < end) {
+      memcpy(buffer + *bytes_transferred, block.data.data() + begin,
+             end - begin);
+      *bytes_transferred += end - begin;
+    }
+    reached_eof = block.data.size() < block_size_;
+  }
+
+  if (reached_eof || prefetch_blocks_ == 0) {
+    return Status::OK();
+  }
+  mutex_lock lock(mu_);
+  for (size_t i = 1; i <= prefetch_blocks_; ++i) {
+    const Key key(filename, last + i * block_size_);
+    if (block_map_.count(key) > 0) continue;
+    bool created;
+    std::shared_ptr<Block> block = LookupOrCreate(key, &created);
+    ++stats_.prefetches;
+    fetch_pool_->Schedule([this, key, block]() { Fetch(key, block); });
+  }
+  return Status::OK();
+}
+
+void FileBlockCache::RemoveFile(const string& filename) {
+  mutex_lock lock(mu_);
+  auto iter = block_map_.lower_bound(Key(filename, 0));
+  while (iter != block_map_.end() && iter->first.first == filename) {
+    Remove(iter++);
+  }
+}
+
+FileBlockCache::Stats FileBlockCache::GetStats() const {
+  mutex_lock lock(mu_);
+  return stats_;
+}
+
+size_t FileBlockCache::CacheSize() const {
+  mutex_lock lock(mu_);
+  return cache_size_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,150 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief An LRU cache of file blocks, shared by all files of a file system.
+///
+/// Files are read in aligned blocks of `block_size` bytes, each of which is
+/// loaded with one call to the block fetcher. The blocks a read needs are
+/// fetched concurrently, and after each read that did not reach the end of
+/// the file, the next `prefetch_blocks` blocks are fetched in the background.
+/// The cache holds at most `max_bytes` bytes of blocks, and evicts the least
+/// recently used blocks first.
+///
+/// This class is thread-safe.
+class FileBlockCache {
+ public:
+  /// \brief Loads `n` bytes at `offset` of `filename` into `out`.
+  ///
+  /// Fewer than `n` bytes may only be returned at the end of the file.
+  typedef std::function<Status(const string& filename, size_t offset,
+                               size_t n, std::vector<char>* out)>
+      BlockFetcher;
+
+  /// Counters of the blocks read through the cache.
+  struct Stats {
+    /// Blocks found in the cache, either loaded or being fetched.
+    int64 hits = 0;
+    /// Blocks that had to be fetched for a read.
+    int64 misses = 0;
+    /// Blocks fetched in the background ahead of the reads.
+    int64 prefetches = 0;
+    /// Bytes returned by the block fetcher.
+    int64 bytes_fetched = 0;
+    /// Blocks evicted to stay below the size limit.
+    int64 evictions = 0;
+  };
+
+  /// Fetches blocks on `num_fetch_threads` background threads. If it is
+  /// zero, blocks are fetched one at a time by the reader, and none are
+  /// prefetched.
+  FileBlockCache(size_t block_size, size_t max_bytes, size_t prefetch_blocks,
+                 int num_fetch_threads, BlockFetcher block_fetcher,
+                 Env* env = Env::Default());
+
+  /// Waits for the pending fetches to finish.
+  ~FileBlockCache();
+
+  /// \brief Reads `n` bytes at `offset` of `filename` into `buffer`.
+  ///
+  /// Sets `bytes_transferred` to the number of bytes read, which is less
+  /// than `n` only at the end of the file. Returns the error of the first
+  /// needed block that could not be fetched; such blocks are not cached.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred);
+
+  /// Discards the cached blocks of `filename`, e.g. after it was written.
+  void RemoveFile(const string& filename);
+
+  /// Returns the counters accumulated since the cache was created.
+  Stats GetStats() const;
+
+  /// Returns the number of bytes of the loaded blocks in the cache.
+  size_t CacheSize() const;
+
+  size_t block_size() const { return block_size_; }
+
+ private:
+  /// The file name and offset of a block.
+  typedef std::pair<string, size_t> Key;
+
+  struct Block {
+    std::vector<char> data;
+    /// Set once `data` and `status` are final.
+    bool done = false;
+    Status status;
+    /// Set when the block is dropped from block_map_ and lru_list_.
+    bool removed = false;
+    std::list<Key>::iterator lru_iter;
+  };
+
+  /// Returns the block at `key`, creating it if `created` is set.
+  std::shared_ptr<Block> LookupOrCreate(const Key& key, bool* created)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Loads `block`, the block at `key`, and wakes up its readers.
+  void Fetch(const Key& key, const std::shared_ptr<Block>& block);
+
+  /// Drops the block at `iter` from the cache.
+  void Remove(std::map<Key, std::shared_ptr<Block>>::iterator iter)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  /// Evicts loaded blocks until the cache fits in max_bytes_.
+  void Trim() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t block_size_;
+  const size_t max_bytes_;
+  const size_t prefetch_blocks_;
+  const BlockFetcher block_fetcher_;
+
+  mutable mutex mu_;
+  /// Notified whenever a block is done.
+  condition_variable block_done_;
+  std::map<Key, std::shared_ptr<Block>> block_map_ GUARDED_BY(mu_);
+  /// The keys of block_map_, the most recently used first.
+  std::list<Key> lru_list_ GUARDED_BY(mu_);
+  /// The bytes of the loaded blocks in block_map_.
+  size_t cache_size_ GUARDED_BY(mu_) = 0;
+  Stats stats_ GUARDED_BY(mu_);
+
+  /// Destroyed first, so that the pending fetches finish while the rest of
+  /// the cache is alive.
+  std::unique_ptr<thread::ThreadPool> fetch_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FileBlockCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
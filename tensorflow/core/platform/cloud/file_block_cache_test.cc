@@ -0,0 +1,195 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <map>
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+/// Serves reads of in-memory files, and counts them.
+class FakeFiles {
+ public:
+  void Add(const string& filename, const string& contents) {
+    mutex_lock lock(mu_);
+    files_[filename] = contents;
+  }
+
+  FileBlockCache::BlockFetcher Fetcher() {
+    return [this](const string& filename, size_t offset, size_t n,
+                  std::vector<char>* out) {
+      mutex_lock lock(mu_);
+      ++num_fetches_;
+      const string& contents = files_[filename];
+      out->clear();
+      if (offset < contents.size()) {
+        const size_t end = std::min(contents.size(), offset + n);
+        out->insert(out->end(), contents.begin() + offset,
+                    contents.begin() + end);
+      }
+      return Status::OK();
+    };
+  }
+
+  int num_fetches() {
+    mutex_lock lock(mu_);
+    return num_fetches_;
+  }
+
+ private:
+  mutex mu_;
+  std::map<string, string> files_ GUARDED_BY(mu_);
+  int num_fetches_ GUARDED_BY(mu_) = 0;
+};
+
+string ReadCache(FileBlockCache* cache, const string& filename, size_t offset,
+                 size_t n) {
+  string result(n, '\0');
+  size_t bytes_transferred = 0;
+  TF_EXPECT_OK(
+      cache->Read(filename, offset, n, &result[0], &bytes_transferred));
+  result.resize(bytes_transferred);
+  return result;
+}
+
+TEST(FileBlockCacheTest, ReadsAcrossBlocksAndHitsCache) {
+  FakeFiles files;
+  files.Add("a", "0123456789abcdefghij");
+  FileBlockCache cache(8, 1024, 0, 0, files.Fetcher());
+
+  EXPECT_EQ("6789abcdefgh", ReadCache(&cache, "a", 6, 12));
+  EXPECT_EQ(3, files.num_fetches());
+  EXPECT_EQ("89ab", ReadCache(&cache, "a", 8, 4));
+  EXPECT_EQ(3, files.num_fetches());
+
+  // Reads past the end of the file return what is left.
+  EXPECT_EQ("ghij", ReadCache(&cache, "a", 16, 8));
+  EXPECT_EQ("", ReadCache(&cache, "a", 24, 8));
+  EXPECT_EQ(20, cache.CacheSize());
+
+  const FileBlockCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(4, stats.misses);
+  EXPECT_EQ(20, stats.bytes_fetched);
+  EXPECT_EQ(0, stats.evictions);
+}
+
+TEST(FileBlockCacheTest, EvictsLeastRecentlyUsedBlocks) {
+  FakeFiles files;
+  files.Add("a", "aaaaaaaa");
+  files.Add("b", "bbbbbbbb");
+  files.Add("c", "cccccccc");
+  FileBlockCache cache(4, 8, 0, 0, files.Fetcher());
+
+  EXPECT_EQ("aaaa", ReadCache(&cache, "a", 0, 4));
+  EXPECT_EQ("bbbb", ReadCache(&cache, "b", 0, 4));
+  EXPECT_EQ("aa", ReadCache(&cache, "a", 2, 2));
+  EXPECT_EQ("cccc", ReadCache(&cache, "c", 0, 4));
+  EXPECT_EQ(3, files.num_fetches());
+  EXPECT_EQ(8, cache.CacheSize());
+  EXPECT_EQ(1, cache.GetStats().evictions);
+
+  // "b" was the least recently used block, so only it is fetched again.
+  EXPECT_EQ("aaaa", ReadCache(&cache, "a", 0, 4));
+  EXPECT_EQ(3, files.num_fetches());
+  EXPECT_EQ("bbbb", ReadCache(&cache, "b", 0, 4));
+  EXPECT_EQ(4, files.num_fetches());
+}
+
+TEST(FileBlockCacheTest, PrefetchesNextBlocks) {
+  FakeFiles files;
+  files.Add("a", "0123456789a");
+  FileBlockCache cache(4, 1024, 2, 2, files.Fetcher());
+
+  EXPECT_EQ("0123", ReadCache(&cache, "a", 0, 4));
+  while (files.num_fetches() < 3) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  // The last block is short, so nothing more is prefetched.
+  EXPECT_EQ("456789a", ReadCache(&cache, "a", 4, 8));
+
+  const FileBlockCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(2, stats.prefetches);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(2, stats.hits);
+}
+
+TEST(FileBlockCacheTest, FetchesMissingBlocksInParallel) {
+  FakeFiles files;
+  files.Add("a", "0123456789abcdef");
+  FileBlockCache::BlockFetcher fetcher = files.Fetcher();
+  // Every fetch waits for all others to start, so the read only completes
+  // if the four blocks are fetched at the same time.
+  BlockingCounter all_started(4);
+  FileBlockCache cache(4, 1024, 0, 3,
+                       [&fetcher, &all_started](const string& filename,
+                                                size_t offset, size_t n,
+                                                std::vector<char>* out) {
+                         all_started.DecrementCount();
+                         all_started.Wait();
+                         return fetcher(filename, offset, n, out);
+                       });
+
+  EXPECT_EQ("0123456789abcdef", ReadCache(&cache, "a", 0, 16));
+  EXPECT_EQ(4, files.num_fetches());
+}
+
+TEST(FileBlockCacheTest, DoesNotCacheErrors) {
+  FakeFiles files;
+  files.Add("a", "0123");
+  FileBlockCache::BlockFetcher fetcher = files.Fetcher();
+  bool fail = true;
+  FileBlockCache cache(4, 1024, 0, 0,
+                       [&fetcher, &fail](const string& filename,
+                                         size_t offset, size_t n,
+                                         std::vector<char>* out) {
+                         if (fail) {
+                           return errors::Unavailable("Try again");
+                         }
+                         return fetcher(filename, offset, n, out);
+                       });
+
+  char buffer[4];
+  size_t bytes_transferred;
+  EXPECT_TRUE(errors::IsUnavailable(
+      cache.Read("a", 0, 4, buffer, &bytes_transferred)));
+  EXPECT_EQ(0, cache.CacheSize());
+  fail = false;
+  EXPECT_EQ("0123", ReadCache(&cache, "a", 0, 4));
+}
+
+TEST(FileBlockCacheTest, RemoveFile) {
+  FakeFiles files;
+  files.Add("a", "aaaaaaaa");
+  files.Add("b", "bbbb");
+  FileBlockCache cache(4, 1024, 0, 0, files.Fetcher());
+
+  EXPECT_EQ("aaaaaaaa", ReadCache(&cache, "a", 0, 8));
+  EXPECT_EQ("bbbb", ReadCache(&cache, "b", 0, 4));
+  files.Add("a", "AAAAAAAA");
+  cache.RemoveFile("a");
+  EXPECT_EQ(4, cache.CacheSize());
+  EXPECT_EQ("AAAAAAAA", ReadCache(&cache, "a", 0, 8));
+  EXPECT_EQ("bbbb", ReadCache(&cache, "b", 0, 4));
+  EXPECT_EQ(5, files.num_fetches());
+}
+
+}  // namespace
+}  // namespace tensorflow
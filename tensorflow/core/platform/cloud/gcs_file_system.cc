@@ -21,9 +21,11 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <set>
 #include <vector>
 #include "include/json/json.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/retrying_utils.h"
 #include "tensorflow/core/platform/cloud/time_util.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -53,9 +56,36 @@ constexpr uint64 kUploadRetryDelayMicros = 1000000L;
 // The HTTP response code "308 Resume Incomplete".
 constexpr uint64 HTTP_CODE_RESUME_INCOMPLETE = 308;
 
+// The environment variables that configure the block cache of the default
+// GcsFileSystem. The cache is only used if its maximum size is set.
+constexpr char kReadCacheMaxSizeMB[] = "GCS_READ_CACHE_MAX_SIZE_MB";
+constexpr char kReadCacheBlockSizeMB[] = "GCS_READ_CACHE_BLOCK_SIZE_MB";
+constexpr uint64 kDefaultReadCacheBlockSizeMB = 16;
+constexpr char kReadCachePrefetchBlocks[] = "GCS_READ_CACHE_PREFETCH_BLOCKS";
+constexpr uint64 kDefaultReadCachePrefetchBlocks = 2;
+constexpr char kReadCacheFetchThreads[] = "GCS_READ_CACHE_FETCH_THREADS";
+constexpr uint64 kDefaultReadCacheFetchThreads = 8;
+// The environment variables that configure composite uploads in the default
+// GcsFileSystem. They are only used if the part size is set.
+constexpr char kWritePartSizeMB[] = "GCS_WRITE_PART_SIZE_MB";
+constexpr char kWriteUploadThreads[] = "GCS_WRITE_UPLOAD_THREADS";
+constexpr uint64 kDefaultWriteUploadThreads = 8;
+
 // The file statistics returned by Stat() for directories.
 const FileStatistics DIRECTORY_STAT(0, 0, true);
 
+/// \brief Returns the value of the environment variable 'name'.
+///
+/// Returns 'default_value' if the variable is not set or not a number.
+uint64 GetEnvVarOrDefault(const char* name, uint64 default_value) {
+  const char* value = std::getenv(name);
+  uint64 result;
+  if (value != nullptr && strings::safe_strtou64(value, &result)) {
+    return result;
+  }
+  return default_value;
+}
+
 Status GetTmpFilename(string* filename) {
   if (!filename) {
     return errors::Internal("'filename' cannot be nullptr.");
@@ -298,6 +328,36 @@ class GcsRandomAccessFile : public RandomAccessFile {
   mutable size_t buffer_start_offset_ GUARDED_BY(mu_) = 0;
 };
 
+/// A GCS-based implementation of a random access file that reads through the
+/// block cache of its file system.
+class GcsBlockCacheRandomAccessFile : public RandomAccessFile {
+ public:
+  GcsBlockCacheRandomAccessFile(const string& filename,
+                                FileBlockCache* file_block_cache)
+      : filename_(filename), file_block_cache_(file_block_cache) {}
+
+  /// The implementation of reads with the block cache. Thread-safe.
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    size_t bytes_transferred = 0;
+    TF_RETURN_IF_ERROR(file_block_cache_->Read(filename_, offset, n, scratch,
+                                               &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      // This is not an error per se. The RandomAccessFile interface expects
+      // that Read returns OutOfRange if fewer bytes were read than requested.
+      return errors::OutOfRange("EOF reached, ", result->size(),
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  string filename_;
+  FileBlockCache* file_block_cache_;  // Not owned.
+};
+
 /// \brief GCS-based implementation of a writeable file.
 ///
 /// Since GCS objects are immutable, this implementation writes to a local
@@ -307,13 +367,15 @@ class GcsWritableFile : public WritableFile {
   GcsWritableFile(const string& bucket, const string& object,
                   AuthProvider* auth_provider,
                   HttpRequest::Factory* http_request_factory,
-                  int64 initial_retry_delay_usec)
+                  int64 initial_retry_delay_usec,
+                  std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
         sync_needed_(true),
-        initial_retry_delay_usec_(initial_retry_delay_usec) {
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        file_cache_erase_(std::move(file_cache_erase)) {
     if (GetTmpFilename(&tmp_content_filename_).ok()) {
       outfile_.open(tmp_content_filename_,
                     std::ofstream::binary | std::ofstream::app);
@@ -329,13 +391,15 @@ class GcsWritableFile : public WritableFile {
                   AuthProvider* auth_provider,
                   const string& tmp_content_filename,
                   HttpRequest::Factory* http_request_factory,
-                  int64 initial_retry_delay_usec)
+                  int64 initial_retry_delay_usec,
+                  std::function<void()> file_cache_erase)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
         sync_needed_(true),
-        initial_retry_delay_usec_(initial_retry_delay_usec) {
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        file_cache_erase_(std::move(file_cache_erase)) {
     tmp_content_filename_ = tmp_content_filename;
     outfile_.open(tmp_content_filename_,
                   std::ofstream::binary | std::ofstream::app);
@@ -373,6 +437,8 @@ class GcsWritableFile : public WritableFile {
     Status status = SyncImpl();
     if (status.ok()) {
       sync_needed_ = false;
+      // Cached blocks of the file are stale now.
+      file_cache_erase_();
     }
     return status;
   }
@@ -568,8 +634,290 @@ class GcsWritableFile : public WritableFile {
   HttpRequest::Factory* http_request_factory_;
   bool sync_needed_;  // whether there is buffered data that needs to be synced
   int64 initial_retry_delay_usec_;
+  std::function<void()> file_cache_erase_;
 };
 
+/// \brief GCS-based writable file that uploads its contents in parts.
+///
+/// Appended data is buffered in memory until it fills a part of 'part_size'
+/// bytes, which is then uploaded as a temporary object on 'upload_pool' while
+/// the writer goes on. At most 'max_parts_in_flight' parts are uploaded at a
+/// time, which bounds the memory used for the buffers. Sync() and Close()
+/// upload the last part and compose all parts into the object, and Close()
+/// then deletes the temporary objects. A file that never fills a part is
+/// uploaded directly as the object.
+class GcsCompositeWritableFile : public WritableFile {
+ public:
+  GcsCompositeWritableFile(const string& bucket, const string& object,
+                           AuthProvider* auth_provider,
+                           HttpRequest::Factory* http_request_factory,
+                           int64 initial_retry_delay_usec, size_t part_size,
+                           thread::ThreadPool* upload_pool,
+                           int max_parts_in_flight,
+                           std::function<void()> file_cache_erase)
+      : bucket_(bucket),
+        object_(object),
+        auth_provider_(auth_provider),
+        http_request_factory_(http_request_factory),
+        initial_retry_delay_usec_(initial_retry_delay_usec),
+        part_size_(part_size),
+        upload_pool_(upload_pool),
+        max_parts_in_flight_(std::max(max_parts_in_flight, 1)),
+        file_cache_erase_(std::move(file_cache_erase)) {
+    buffer_.reserve(part_size_);
+  }
+
+  ~GcsCompositeWritableFile() override {
+    Close().IgnoreError();
+    // The uploads refer to this file, so they must finish even if Close()
+    // failed.
+    WaitForUploads().IgnoreError();
+  }
+
+  Status Append(const StringPiece& data) override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    // Fails before taking any data, so that retrying the call is safe.
+    {
+      mutex_lock lock(mu_);
+      TF_RETURN_IF_ERROR(upload_status_);
+    }
+    sync_needed_ = true;
+    StringPiece rest = data;
+    while (!rest.empty()) {
+      const size_t n = std::min(rest.size(), part_size_ - buffer_.size());
+      buffer_.append(rest.data(), n);
+      rest.remove_prefix(n);
+      if (buffer_.size() == part_size_) {
+        StartPartUpload();
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    if (closed_) {
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(Sync());
+    DeleteTemporaryObjects();
+    closed_ = true;
+    return Status::OK();
+  }
+
+  /// The parts are uploaded as they fill up, so there is nothing to flush.
+  Status Flush() override { return CheckWritable(); }
+
+  Status Sync() override {
+    TF_RETURN_IF_ERROR(CheckWritable());
+    if (!sync_needed_) {
+      return Status::OK();
+    }
+    if (parts_.empty()) {
+      // The buffer is kept, as it becomes the first part if the file grows.
+      TF_RETURN_IF_ERROR(RetryingUtils::CallWithRetries(
+          [this]() { return UploadObject(object_, buffer_); },
+          initial_retry_delay_usec_));
+    } else {
+      if (!buffer_.empty()) {
+        StartPartUpload();
+      }
+      TF_RETURN_IF_ERROR(WaitForUploads());
+      TF_RETURN_IF_ERROR(ComposeParts());
+    }
+    sync_needed_ = false;
+    // Cached blocks of the file are stale now.
+    file_cache_erase_();
+    return Status::OK();
+  }
+
+ private:
+  /// GCS composes at most this many objects in one request.
+  static constexpr size_t kMaxComposeSources = 32;
+
+  Status CheckWritable() const {
+    if (closed_) {
+      return errors::FailedPrecondition("The file is already closed.");
+    }
+    return Status::OK();
+  }
+
+  /// Returns the name of the temporary object for the 'index'-th object
+  /// composed at 'level', where the parts are at level 0.
+  string TemporaryObjectName(int level, size_t index) const {
+    return strings::StrCat(object_, ".part-", level, "-", index);
+  }
+
+  /// Uploads buffer_ as the next part, and empties buffer_.
+  void StartPartUpload() {
+    std::shared_ptr<string> data(new string);
+    data->swap(buffer_);
+    buffer_.reserve(part_size_);
+    const string name = TemporaryObjectName(0, parts_.size());
+    parts_.push_back(name);
+    {
+      mutex_lock lock(mu_);
+      while (parts_in_flight_ >= max_parts_in_flight_) {
+        upload_done_.wait(lock);
+      }
+      ++parts_in_flight_;
+    }
+    upload_pool_->Schedule([this, name, data]() {
+      const Status status = RetryingUtils::CallWithRetries(
+          [this, &name, &data]() { return UploadObject(name, *data); },
+          initial_retry_delay_usec_);
+      {
+        mutex_lock lock(mu_);
+        upload_status_.Update(status);
+        --parts_in_flight_;
+      }
+      upload_done_.notify_all();
+    });
+  }
+
+  /// Waits for all part uploads to finish, and returns the first error.
+  Status WaitForUploads() {
+    mutex_lock lock(mu_);
+    while (parts_in_flight_ > 0) {
+      upload_done_.wait(lock);
+    }
+    return upload_status_;
+  }
+
+  /// Composes parts_ into the object, in a tree of temporary objects if
+  /// there are more parts than one request can compose. Each request has
+  /// the same result if it is repeated, which makes retries safe.
+  Status ComposeParts() {
+    std::vector<string> sources = parts_;
+    for (int level = 1; sources.size() > kMaxComposeSources; ++level) {
+      std::vector<string> composed;
+      for (size_t i = 0; i < sources.size(); i += kMaxComposeSources) {
+        const string name = TemporaryObjectName(level, composed.size());
+        const size_t end = std::min(sources.size(), i + kMaxComposeSources);
+        TF_RETURN_IF_ERROR(ComposeWithRetries(
+            std::vector<string>(sources.begin() + i, sources.begin() + end),
+            name));
+        composed.push_back(name);
+        intermediate_objects_.insert(name);
+      }
+      sources.swap(composed);
+    }
+    return ComposeWithRetries(sources, object_);
+  }
+
+  Status ComposeWithRetries(const std::vector<string>& sources,
+                            const string& target) {
+    return RetryingUtils::CallWithRetries(
+        [this, &sources, &target]() { return Compose(sources, target); },
+        initial_retry_delay_usec_);
+  }
+
+  /// Uploads 'data' as the object 'name' in one request.
+  Status UploadObject(const string& name, const string& data) {
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(
+        strings::StrCat(kGcsUploadUriBase, "b/", bucket_,
+                        "/o?uploadType=media&name=",
+                        request->EscapeString(name))));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->SetPostFromBuffer(data.data(), data.size()));
+    std::vector<char> output_buffer;
+    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading gs://",
+                                    bucket_, "/", name);
+    return Status::OK();
+  }
+
+  /// Composes the objects 'sources' into the object 'target'.
+  Status Compose(const std::vector<string>& sources, const string& target) {
+    string body = "{\"sourceObjects\":[";
+    for (size_t i = 0; i < sources.size(); ++i) {
+      strings::StrAppend(&body, i > 0 ? "," : "", "{\"name\":",
+                         Json::valueToQuotedString(sources[i].c_str()), "}");
+    }
+    strings::StrAppend(&body, "]}");
+
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(
+        strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                        request->EscapeString(target), "/compose")));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->AddHeader("Content-Type", "application/json"));
+    TF_RETURN_IF_ERROR(request->SetPostFromBuffer(body.data(), body.size()));
+    std::vector<char> output_buffer;
+    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when composing gs://",
+                                    bucket_, "/", target);
+    return Status::OK();
+  }
+
+  /// Deletes the parts and intermediate objects. The file is complete at
+  /// this point, so failures are only logged.
+  void DeleteTemporaryObjects() {
+    std::vector<string> names = parts_;
+    names.insert(names.end(), intermediate_objects_.begin(),
+                 intermediate_objects_.end());
+    for (const string& name : names) {
+      const Status status = RetryingUtils::DeleteWithRetries(
+          [this, &name]() { return DeleteObject(name); },
+          initial_retry_delay_usec_);
+      if (!status.ok()) {
+        LOG(WARNING) << "Could not delete the temporary object gs://"
+                     << bucket_ << "/" << name << ": " << status;
+      }
+    }
+  }
+
+  Status DeleteObject(const string& name) {
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
+        kGcsUriBase, "b/", bucket_, "/o/", request->EscapeString(name))));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->SetDeleteRequest());
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when deleting gs://",
+                                    bucket_, "/", name);
+    return Status::OK();
+  }
+
+  string bucket_;
+  string object_;
+  AuthProvider* auth_provider_;
+  HttpRequest::Factory* http_request_factory_;
+  const int64 initial_retry_delay_usec_;
+  const size_t part_size_;
+  thread::ThreadPool* upload_pool_;  // Not owned.
+  const int max_parts_in_flight_;
+  std::function<void()> file_cache_erase_;
+
+  // The data appended since the last part was started.
+  string buffer_;
+  // The names of the parts, in file order.
+  std::vector<string> parts_;
+  // The objects composed from parts, which are deleted with them.
+  std::set<string> intermediate_objects_;
+  bool sync_needed_ = true;
+  bool closed_ = false;
+
+  mutex mu_;
+  condition_variable upload_done_;
+  int parts_in_flight_ GUARDED_BY(mu_) = 0;
+  // The first error of a part upload. The file cannot be completed after one.
+  Status upload_status_ GUARDED_BY(mu_);
+};
+
+constexpr size_t GcsCompositeWritableFile::kMaxComposeSources;
+
 class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
  public:
   GcsReadOnlyMemoryRegion(std::unique_ptr<char[]> data, uint64 length)
@@ -585,7 +933,38 @@ class GcsReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
 
 GcsFileSystem::GcsFileSystem()
     : auth_provider_(new GoogleAuthProvider()),
-      http_request_factory_(new HttpRequest::Factory()) {}
+      http_request_factory_(new HttpRequest::Factory()) {
+  const uint64 max_size_mb = GetEnvVarOrDefault(kReadCacheMaxSizeMB, 0);
+  if (max_size_mb > 0) {
+    const uint64 block_size_mb = GetEnvVarOrDefault(
+        kReadCacheBlockSizeMB, kDefaultReadCacheBlockSizeMB);
+    const uint64 prefetch_blocks = GetEnvVarOrDefault(
+        kReadCachePrefetchBlocks, kDefaultReadCachePrefetchBlocks);
+    const uint64 fetch_threads = GetEnvVarOrDefault(
+        kReadCacheFetchThreads, kDefaultReadCacheFetchThreads);
+    InitFileBlockCache(std::max<uint64>(block_size_mb, 1) * 1024 * 1024,
+                       max_size_mb * 1024 * 1024, prefetch_blocks,
+                       fetch_threads);
+  }
+  const uint64 part_size_mb = GetEnvVarOrDefault(kWritePartSizeMB, 0);
+  if (part_size_mb > 0) {
+    SetCompositeUploadOptions(
+        part_size_mb * 1024 * 1024,
+        GetEnvVarOrDefault(kWriteUploadThreads, kDefaultWriteUploadThreads));
+  }
+}
+
+void GcsFileSystem::SetCompositeUploadOptions(size_t part_size,
+                                              int num_upload_threads) {
+  composite_part_size_ = part_size;
+  composite_upload_threads_ = std::max(num_upload_threads, 1);
+  upload_pool_.reset();
+  if (composite_part_size_ > 0) {
+    upload_pool_.reset(new thread::ThreadPool(
+        Env::Default(), ThreadOptions(), "gcs_upload",
+        composite_upload_threads_, false /* low_latency_hint */));
+  }
+}
 
 GcsFileSystem::GcsFileSystem(
     std::unique_ptr<AuthProvider> auth_provider,
@@ -596,13 +975,67 @@ GcsFileSystem::GcsFileSystem(
       read_ahead_bytes_(read_ahead_bytes),
       initial_retry_delay_usec_(initial_retry_delay_usec) {}
 
+GcsFileSystem::GcsFileSystem(
+    std::unique_ptr<AuthProvider> auth_provider,
+    std::unique_ptr<HttpRequest::Factory> http_request_factory,
+    size_t block_size, size_t block_cache_max_bytes, size_t prefetch_blocks,
+    int num_fetch_threads, int64 initial_retry_delay_usec)
+    : auth_provider_(std::move(auth_provider)),
+      http_request_factory_(std::move(http_request_factory)),
+      initial_retry_delay_usec_(initial_retry_delay_usec) {
+  InitFileBlockCache(block_size, block_cache_max_bytes, prefetch_blocks,
+                     num_fetch_threads);
+}
+
+void GcsFileSystem::InitFileBlockCache(size_t block_size, size_t max_bytes,
+                                       size_t prefetch_blocks,
+                                       int num_fetch_threads) {
+  file_block_cache_.reset(new FileBlockCache(
+      block_size, max_bytes, prefetch_blocks, num_fetch_threads,
+      [this](const string& fname, size_t offset, size_t n,
+             std::vector<char>* out) {
+        return LoadBufferFromGCS(fname, offset, n, out);
+      }));
+}
+
+Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
+                                        size_t n, std::vector<char>* out) {
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
+
+  string auth_token;
+  TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_.get(), &auth_token));
+
+  std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+  TF_RETURN_IF_ERROR(request->Init());
+  TF_RETURN_IF_ERROR(
+      request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket,
+                                      "/", request->EscapeString(object))));
+  TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+  TF_RETURN_IF_ERROR(request->SetRange(offset, offset + n - 1));
+  TF_RETURN_IF_ERROR(request->SetResultBuffer(out));
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading ", fname);
+  return Status::OK();
+}
+
+void GcsFileSystem::RemoveFromCache(const string& fname) {
+  if (file_block_cache_ != nullptr) {
+    file_block_cache_->RemoveFile(fname);
+  }
+}
+
 Status GcsFileSystem::NewRandomAccessFile(
     const string& fname, std::unique_ptr<RandomAccessFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
-  result->reset(new GcsRandomAccessFile(bucket, object, auth_provider_.get(),
-                                        http_request_factory_.get(),
-                                        read_ahead_bytes_));
+  if (file_block_cache_ != nullptr) {
+    result->reset(
+        new GcsBlockCacheRandomAccessFile(fname, file_block_cache_.get()));
+  } else {
+    result->reset(new GcsRandomAccessFile(bucket, object, auth_provider_.get(),
+                                          http_request_factory_.get(),
+                                          read_ahead_bytes_));
+  }
   return Status::OK();
 }
 
@@ -610,9 +1043,17 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
                                       std::unique_ptr<WritableFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
-  result->reset(new GcsWritableFile(bucket, object, auth_provider_.get(),
-                                    http_request_factory_.get(),
-                                    initial_retry_delay_usec_));
+  if (composite_part_size_ > 0) {
+    result->reset(new GcsCompositeWritableFile(
+        bucket, object, auth_provider_.get(), http_request_factory_.get(),
+        initial_retry_delay_usec_, composite_part_size_, upload_pool_.get(),
+        composite_upload_threads_,
+        [this, fname]() { RemoveFromCache(fname); }));
+    return Status::OK();
+  }
+  result->reset(new GcsWritableFile(
+      bucket, object, auth_provider_.get(), http_request_factory_.get(),
+      initial_retry_delay_usec_, [this, fname]() { RemoveFromCache(fname); }));
   return Status::OK();
 }
 
@@ -652,7 +1093,8 @@ Status GcsFileSystem::NewAppendableFile(const string& fname,
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
   result->reset(new GcsWritableFile(
       bucket, object, auth_provider_.get(), old_content_filename,
-      http_request_factory_.get(), initial_retry_delay_usec_));
+      http_request_factory_.get(), initial_retry_delay_usec_,
+      [this, fname]() { RemoveFromCache(fname); }));
   return Status::OK();
 }
 
@@ -994,6 +1436,7 @@ Status GcsFileSystem::DeleteFile(const string& fname) {
   TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
   TF_RETURN_IF_ERROR(request->SetDeleteRequest());
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when deleting ", fname);
+  RemoveFromCache(fname);
   return Status::OK();
 }
 
@@ -1106,6 +1549,7 @@ Status GcsFileSystem::RenameObject(const string& src, const string& target) {
         ": moving large files between buckets with different "
         "locations or storage classes is not supported.");
   }
+  RemoveFromCache(target);
 
   // In case the delete API call failed, but the deletion actually happened
   // on the server side, we can't just retry the whole RenameFile operation
@@ -19,7 +19,9 @@ limitations under the License.
 #include <string>
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cloud/auth_provider.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
 #include "tensorflow/core/platform/cloud/retrying_file_system.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -37,6 +39,18 @@ class GcsFileSystem : public FileSystem {
                 std::unique_ptr<HttpRequest::Factory> http_request_factory,
                 size_t read_ahead_bytes, int64 initial_retry_delay_usec);
 
+  /// \brief Reads files through a block cache shared by all files.
+  ///
+  /// Instead of a read-ahead buffer per file, the file system caches up to
+  /// 'block_cache_max_bytes' bytes of blocks of 'block_size' bytes, fetched
+  /// by 'num_fetch_threads' threads, and prefetches 'prefetch_blocks' blocks
+  /// after each read. See FileBlockCache.
+  GcsFileSystem(std::unique_ptr<AuthProvider> auth_provider,
+                std::unique_ptr<HttpRequest::Factory> http_request_factory,
+                size_t block_size, size_t block_cache_max_bytes,
+                size_t prefetch_blocks, int num_fetch_threads,
+                int64 initial_retry_delay_usec);
+
   Status NewRandomAccessFile(
       const string& filename,
       std::unique_ptr<RandomAccessFile>* result) override;
@@ -75,6 +89,19 @@ class GcsFileSystem : public FileSystem {
   Status DeleteRecursively(const string& dirname, int64* undeleted_files,
                            int64* undeleted_dirs) override;
 
+  /// \brief Makes new writable files upload their contents in parts.
+  ///
+  /// Parts of 'part_size' bytes are uploaded while a file is written, up to
+  /// 'num_upload_threads' at a time per file, and composed into the object
+  /// by Sync() and Close(). A 'part_size' of 0 turns composite uploads off.
+  /// Must not be called while files are written.
+  void SetCompositeUploadOptions(size_t part_size, int num_upload_threads);
+
+  /// Returns the block cache, or nullptr if reads use read-ahead buffers.
+  const FileBlockCache* file_block_cache() const {
+    return file_block_cache_.get();
+  }
+
  private:
   /// \brief Checks if the bucket exists. Returns OK if the check succeeded.
   ///
@@ -107,6 +134,15 @@ class GcsFileSystem : public FileSystem {
                        FileStatistics* stat);
   Status RenameObject(const string& src, const string& target);
 
+  /// Creates file_block_cache_, which loads blocks with LoadBufferFromGCS().
+  void InitFileBlockCache(size_t block_size, size_t max_bytes,
+                          size_t prefetch_blocks, int num_fetch_threads);
+  /// Loads 'n' bytes at 'offset' of the GCS file 'fname' into 'out'.
+  Status LoadBufferFromGCS(const string& fname, size_t offset, size_t n,
+                           std::vector<char>* out);
+  /// Drops the cached blocks of 'fname', whose contents changed.
+  void RemoveFromCache(const string& fname);
+
   std::unique_ptr<AuthProvider> auth_provider_;
   std::unique_ptr<HttpRequest::Factory> http_request_factory_;
 
@@ -117,6 +153,18 @@ class GcsFileSystem : public FileSystem {
   // The initial delay for exponential backoffs when retrying failed calls.
   const int64 initial_retry_delay_usec_ = 1000000L;
 
+  // The block cache shared by all files read from this file system, if
+  // enabled. The default constructor enables it when the environment
+  // variable GCS_READ_CACHE_MAX_SIZE_MB is set.
+  std::unique_ptr<FileBlockCache> file_block_cache_;
+
+  // The part size and upload threads of composite uploads, which are used
+  // if the part size is positive. The default constructor enables them when
+  // the environment variable GCS_WRITE_PART_SIZE_MB is set.
+  size_t composite_part_size_ = 0;
+  int composite_upload_threads_ = 1;
+  std::unique_ptr<thread::ThreadPool> upload_pool_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GcsFileSystem);
 };
 
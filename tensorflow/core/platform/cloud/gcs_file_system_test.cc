@@ -192,6 +192,52 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_WithReadAhead) {
   EXPECT_EQ("0123", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "01234567"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 8-15\n",
+           "89")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   8 /* block size */, 16 /* block cache max bytes */,
+                   0 /* prefetch blocks */, 0 /* num fetch threads */,
+                   0 /* initial retry delay */);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/random_access.txt", &file));
+
+  char scratch[10];
+  StringPiece result;
+
+  // The first read loads the whole block, and the second one is served
+  // from the cache.
+  TF_EXPECT_OK(file->Read(0, 6, &result, scratch));
+  EXPECT_EQ("012345", result);
+  TF_EXPECT_OK(file->Read(4, 4, &result, scratch));
+  EXPECT_EQ("4567", result);
+
+  // Another file of the same object shares the cache.
+  std::unique_ptr<RandomAccessFile> other_file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", &other_file));
+  EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+            other_file->Read(6, 10, &result, scratch).code());
+  EXPECT_EQ("6789", result);
+
+  const FileBlockCache::Stats stats = fs.file_block_cache()->GetStats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(10, stats.bytes_fetched);
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_NoObjectName) {
   std::vector<HttpRequest*> requests;
   GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
@@ -443,6 +489,87 @@ TEST(GcsFileSystemTest, NewWritableFile_NoObjectName) {
             fs.NewWritableFile("gs://bucket/", &file).code());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUpload) {
+  const string upload_uri =
+      "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+      "uploadType=media&name=path%2Fwriteable.txt.part-0-";
+  const string object_uri =
+      "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+      "path%2Fwriteable.txt";
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(strings::StrCat(upload_uri, "0\n",
+                                           "Auth Token: fake_token\n"
+                                           "Post body: content1\n"),
+                           ""),
+       new FakeHttpRequest(strings::StrCat(upload_uri, "1\n",
+                                           "Auth Token: fake_token\n"
+                                           "Post body: ,content\n"),
+                           ""),
+       new FakeHttpRequest(strings::StrCat(upload_uri, "2\n",
+                                           "Auth Token: fake_token\n"
+                                           "Post body: 2\n"),
+                           ""),
+       new FakeHttpRequest(
+           strings::StrCat(object_uri, "/compose\n",
+                           "Auth Token: fake_token\n"
+                           "Header Content-Type: application/json\n"
+                           "Post body: {\"sourceObjects\":["
+                           "{\"name\":\"path/writeable.txt.part-0-0\"},"
+                           "{\"name\":\"path/writeable.txt.part-0-1\"},"
+                           "{\"name\":\"path/writeable.txt.part-0-2\"}]}\n"),
+           ""),
+       new FakeHttpRequest(strings::StrCat(object_uri, ".part-0-0\n",
+                                           "Auth Token: fake_token\n"
+                                           "Delete: yes\n"),
+                           ""),
+       new FakeHttpRequest(strings::StrCat(object_uri, ".part-0-1\n",
+                                           "Auth Token: fake_token\n"
+                                           "Delete: yes\n"),
+                           ""),
+       new FakeHttpRequest(strings::StrCat(object_uri, ".part-0-2\n",
+                                           "Auth Token: fake_token\n"
+                                           "Delete: yes\n"),
+                           "")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   0 /* read ahead bytes */, 0 /* initial retry delay */);
+  // One upload at a time keeps the order of the requests fixed.
+  fs.SetCompositeUploadOptions(8 /* part size */, 1 /* upload threads */);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable.txt", &file));
+
+  TF_EXPECT_OK(file->Append("content1,"));
+  TF_EXPECT_OK(file->Append("content2"));
+  TF_EXPECT_OK(file->Flush());
+  TF_EXPECT_OK(file->Close());
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUploadOfSmallFile) {
+  std::vector<HttpRequest*> requests({new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+      "uploadType=media&name=path%2Fwriteable.txt\n"
+      "Auth Token: fake_token\n"
+      "Post body: content1,content2\n",
+      "")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   0 /* read ahead bytes */, 0 /* initial retry delay */);
+  fs.SetCompositeUploadOptions(1024 /* part size */, 2 /* upload threads */);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable.txt", &file));
+
+  // A file that fits in one part is uploaded directly.
+  TF_EXPECT_OK(file->Append("content1,"));
+  TF_EXPECT_OK(file->Append("content2"));
+  TF_EXPECT_OK(file->Close());
+  EXPECT_EQ(errors::Code::FAILED_PRECONDITION,
+            file->Append("content3").code());
+}
+
 TEST(GcsFileSystemTest, NewAppendableFile) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
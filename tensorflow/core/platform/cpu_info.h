@@ -34,6 +34,22 @@ constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
 // software can change it dynamically.
 int NumSchedulableCPUs();
 
+// The NUMA node of threads and memory that are not bound to any node.
+constexpr int kNUMANoAffinity = -1;
+
+// Returns the number of NUMA nodes of the host, or 1 if the host is not a
+// NUMA system or its topology can't be determined.
+int NUMANumNodes();
+
+// Returns the number of schedulable CPUs of this process on NUMA node
+// 'node'.
+int NUMANumNodeCPUs(int node);
+
+// Binds the calling thread to the schedulable CPUs of NUMA node 'node'.
+// The kernel then backs the memory the thread touches first with pages of
+// that node.  Returns false if the binding is not supported or failed.
+bool NUMASetThreadNodeAffinity(int node);
+
 // Mostly ISA related features that we care about
 enum CPUFeature {
   // Do not change numeric assignments.
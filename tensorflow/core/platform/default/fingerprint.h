@@ -24,6 +24,10 @@ inline uint64 Fingerprint64(const string& s) {
   return ::util::Fingerprint64(s);
 }
 
+inline uint64 Fingerprint64(const char* data, size_t size) {
+  return ::util::Fingerprint64(data, size);
+}
+
 inline Fprint128 Fingerprint128(const string& s) {
   const auto fingerprint = ::util::Fingerprint128(s);
   return {::util::Uint128Low64(fingerprint),
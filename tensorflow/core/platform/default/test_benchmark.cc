@@ -86,6 +86,33 @@ void AddRange(std::vector<int>* dst, int lo, int hi, int mult) {
   }
 }
 
+// Returns true if the benchmark 'name' is selected by 'pattern'.  "all",
+// ".*" and ".." select every benchmark; any other pattern is a
+// comma-separated list of substrings of the names to run.
+bool MatchesPattern(const string& name, StringPiece pattern) {
+  if (pattern == "all" || pattern == ".*" || pattern == "..") {
+    return true;
+  }
+  for (const string& part : str_util::Split(pattern, ',')) {
+    if (!part.empty() && StringPiece(name).contains(part)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the name of the benchmark 'base' run with 'arg'.
+string ArgName(const string& base, const std::pair<int, int>& arg) {
+  string name = base;
+  if (arg.first >= 0) {
+    strings::StrAppend(&name, "/", arg.first);
+    if (arg.second >= 0) {
+      strings::StrAppend(&name, "/", arg.second);
+    }
+  }
+  return name;
+}
+
 }  // namespace
 
 Benchmark* Benchmark::Range(int lo, int hi) {
@@ -113,52 +140,26 @@ Benchmark* Benchmark::RangePair(int lo1, int hi1, int lo2, int hi2) {
 void Benchmark::Run(const char* pattern) {
   if (!all_benchmarks) return;
 
-  // Converts "all" into the wildcard '.*'.  Currently pattern isn't
-  // specified by clients, but we keep this here to match the internal
-  // Google implementation, should we ever enable user-specified
-  // pattern specification.
-  if (StringPiece(pattern) == "all") {
-    pattern = ".*";
-  }
-
   // Compute name width.
   int width = 10;
-  string name;
   for (auto b : *all_benchmarks) {
-    name = b->name_;
     for (auto arg : b->args_) {
-      name.resize(b->name_.size());
-      if (arg.first >= 0) {
-        strings::StrAppend(&name, "/", arg.first);
-        if (arg.second >= 0) {
-          strings::StrAppend(&name, "/", arg.second);
-        }
+      const string name = ArgName(b->name_, arg);
+      if (MatchesPattern(name, pattern)) {
+        width = std::max<int>(width, name.size());
       }
-
-      // TODO(vrv): Check against 'pattern' using a regex before
-      // computing the width, if we start allowing clients to pass in
-      // a custom pattern.
-      width = std::max<int>(width, name.size());
     }
   }
 
   printf("%-*s %10s %10s\n", width, "Benchmark", "Time(ns)", "Iterations");
   printf("%s\n", string(width + 22, '-').c_str());
   for (auto b : *all_benchmarks) {
-    name = b->name_;
     for (auto arg : b->args_) {
-      name.resize(b->name_.size());
-      if (arg.first >= 0) {
-        strings::StrAppend(&name, "/", arg.first);
-        if (arg.second >= 0) {
-          strings::StrAppend(&name, "/", arg.second);
-        }
+      const string name = ArgName(b->name_, arg);
+      if (!MatchesPattern(name, pattern)) {
+        continue;
       }
 
-      // TODO(vrv): Match 'name' against 'pattern' using a regex
-      // before continuing, if we start allowing clients to pass in a
-      // custom pattern.
-
       int iters;
       double seconds;
       b->Run(arg.first, arg.second, &iters, &seconds);
@@ -184,8 +185,17 @@ void Benchmark::Run(const char* pattern) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
       }
-      s = reporter.Benchmark(iters, 0.0, seconds,
-                             items_processed * 1e-6 / seconds);
+      // The throughput of a BenchmarkEntry is in MB/s.
+      const double throughput =
+          bytes_processed > 0 ? bytes_processed * 1e-6 / seconds : 0.0;
+      s = reporter.Benchmark(iters, 0.0, seconds, throughput);
+      if (s.ok() && items_processed > 0) {
+        s = reporter.SetProperty("items_per_second",
+                                 items_processed / seconds);
+      }
+      if (s.ok() && !label.empty()) {
+        s = reporter.SetProperty("label", label);
+      }
       if (!s.ok()) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
@@ -241,9 +251,6 @@ void Benchmark::Run(int arg1, int arg2, int* run_count, double* run_seconds) {
   }
 }
 
-// TODO(vrv): Add support for running a subset of benchmarks by having
-// RunBenchmarks take in a spec (and maybe other options such as
-// benchmark_min_time, etc).
 void RunBenchmarks() { Benchmark::Run("all"); }
 void SetLabel(const std::string& l) { label = l; }
 void BytesProcessed(int64 n) { bytes_processed = n; }
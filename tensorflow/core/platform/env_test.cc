@@ -81,6 +81,38 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadV) {
+  const string filename = io::JoinPath(BaseDir(), "read_v");
+  const string input = CreateTestFile(env_, filename, 1000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  std::vector<RandomAccessFile::ReadRequest> requests(3);
+  std::vector<char> scratch(1000);
+  requests[0].offset = 700;
+  requests[0].n = 300;
+  requests[0].scratch = &scratch[0];
+  requests[1].offset = 10;
+  requests[1].n = 20;
+  requests[1].scratch = &scratch[300];
+  requests[2].offset = 0;
+  requests[2].n = 0;
+  requests[2].scratch = &scratch[320];
+  TF_EXPECT_OK(f->ReadV(&requests));
+  EXPECT_EQ(input.substr(700, 300), requests[0].result);
+  EXPECT_EQ(input.substr(10, 20), requests[1].result);
+  EXPECT_EQ("", requests[2].result);
+
+  // A read past EOF fails on its own, and does not stop the other reads.
+  requests[0].offset = 900;
+  requests[0].n = 200;
+  EXPECT_EQ(error::OUT_OF_RANGE, f->ReadV(&requests).code());
+  EXPECT_EQ(error::OUT_OF_RANGE, requests[0].status.code());
+  EXPECT_EQ(input.substr(900), requests[0].result);
+  TF_EXPECT_OK(requests[1].status);
+  EXPECT_EQ(input.substr(10, 20), requests[1].result);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1}) {
@@ -72,6 +72,17 @@ Status FileSystem::IsDirectory(const string& name) {
 
 RandomAccessFile::~RandomAccessFile() {}
 
+Status RandomAccessFile::ReadV(std::vector<ReadRequest>* requests) const {
+  for (ReadRequest& request : *requests) {
+    request.status =
+        Read(request.offset, request.n, &request.result, request.scratch);
+  }
+  for (const ReadRequest& request : *requests) {
+    TF_RETURN_IF_ERROR(request.status);
+  }
+  return Status::OK();
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
@@ -235,6 +235,28 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief One of the reads issued together by `ReadV()`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// Must hold at least `n` bytes, as for `Read()`.
+    char* scratch = nullptr;
+    /// Set by `ReadV()` as `Read()` sets its `result` and return value.
+    StringPiece result;
+    Status status;
+  };
+
+  /// \brief Reads all of `requests`, in no particular order.
+  ///
+  /// Issuing many reads at once lets implementations overlap them, e.g. to
+  /// keep the queue of a local disk full from a single thread. Every request
+  /// is attempted; returns the first non-OK status in `requests`, if any.
+  ///
+  /// The default implementation calls `Read()` for each request in turn.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual Status ReadV(std::vector<ReadRequest>* requests) const;
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_FINGERPRINT_H_
 #define TENSORFLOW_CORE_PLATFORM_FINGERPRINT_H_
 
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -43,6 +44,10 @@ struct Fprint128Hasher {
 // However, it is not suitable for cryptography.
 uint64 Fingerprint64(const string& s);
 
+// Fingerprint64 of the "size" bytes at "data", which need not be copied into
+// a string first.
+uint64 Fingerprint64(const char* data, size_t size);
+
 // 128-bit variant of Fingerprint64 above (same properties and caveats apply).
 Fprint128 Fingerprint128(const string& s);
 
@@ -82,4 +87,23 @@ inline uint64 FingerprintCat64(const uint64 fp1, const uint64 fp2) {
 #include "tensorflow/core/platform/default/fingerprint.h"
 #endif
 
+namespace tensorflow {
+
+// Sets fingerprints[i] to Fingerprint64(keys[i]) for each of the num_keys
+// keys. The bytes of the keys a few ahead are prefetched, which hides the
+// cache misses on keys that are stored out of line.
+inline void Fingerprint64Batch(const string* keys, size_t num_keys,
+                               uint64* fingerprints) {
+  constexpr size_t kPrefetchDistance = 8;
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (i + kPrefetchDistance < num_keys) {
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          keys[i + kPrefetchDistance].data());
+    }
+    fingerprints[i] = Fingerprint64(keys[i]);
+  }
+}
+
+}  // namespace tensorflow
+
 #endif  // TENSORFLOW_CORE_PLATFORM_FINGERPRINT_H_
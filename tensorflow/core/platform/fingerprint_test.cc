@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/platform/fingerprint.h"
 
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
@@ -28,6 +29,18 @@ TEST(Fingerprint64, IsForeverFrozen) {
   EXPECT_EQ(18308117990299812472ULL, Fingerprint64("World"));
 }
 
+TEST(Fingerprint64Batch, MatchesFingerprint64) {
+  std::vector<string> keys;
+  for (int i = 0; i < 40; ++i) {
+    keys.push_back(string(i, 'a' + i % 26));
+  }
+  std::vector<uint64> fingerprints(keys.size());
+  Fingerprint64Batch(keys.data(), keys.size(), fingerprints.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(Fingerprint64(keys[i]), fingerprints[i]);
+  }
+}
+
 TEST(Fingerprint128, IsForeverFrozen) {
   {
     const Fprint128 fingerprint = Fingerprint128("Hello");
@@ -17,9 +17,14 @@ limitations under the License.
 
 #include <errno.h>
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/logging.h"
@@ -29,6 +34,35 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The environment variables that configure the block cache of the default
+// HadoopFileSystem. The cache is only used if its maximum size is set.
+constexpr char kReadCacheMaxSizeMB[] = "HDFS_READ_CACHE_MAX_SIZE_MB";
+constexpr char kReadCacheBlockSizeMB[] = "HDFS_READ_CACHE_BLOCK_SIZE_MB";
+constexpr uint64 kDefaultReadCacheBlockSizeMB = 16;
+constexpr char kReadCachePrefetchBlocks[] = "HDFS_READ_CACHE_PREFETCH_BLOCKS";
+constexpr uint64 kDefaultReadCachePrefetchBlocks = 2;
+constexpr char kReadCacheFetchThreads[] = "HDFS_READ_CACHE_FETCH_THREADS";
+constexpr uint64 kDefaultReadCacheFetchThreads = 8;
+// If set to 1, the blocks of the cache are loaded with zero-copy reads, which
+// map the data of local blocks (read with short-circuit local reads) instead
+// of copying it through the JVM.
+constexpr char kReadCacheZeroCopy[] = "HDFS_READ_CACHE_ZERO_COPY";
+
+// Returns the value of the environment variable 'name', or 'default_value'
+// if the variable is not set or not a number.
+uint64 GetEnvVarOrDefault(const char* name, uint64 default_value) {
+  const char* value = std::getenv(name);
+  uint64 result;
+  if (value != nullptr && strings::safe_strtou64(value, &result)) {
+    return result;
+  }
+  return default_value;
+}
+
+}  // namespace
+
 template <typename R, typename... Args>
 Status BindFunc(void* handle, const char* name,
                 std::function<R(Args...)>* func) {
@@ -74,6 +108,21 @@ class LibHDFS {
   std::function<int(hdfsFS, const char*)> hdfsCreateDirectory;
   std::function<hdfsFileInfo*(hdfsFS, const char*)> hdfsGetPathInfo;
   std::function<int(hdfsFS, const char*, const char*)> hdfsRename;
+  std::function<int(hdfsFS, hdfsFile, tOffset)> hdfsSeek;
+
+  // The zero-copy read API. It is optional, and only bound if
+  // has_zero_copy().
+  std::function<hadoopRzOptions*()> hadoopRzOptionsAlloc;
+  std::function<int(hadoopRzOptions*, const char*)>
+      hadoopRzOptionsSetByteBufferPool;
+  std::function<void(hadoopRzOptions*)> hadoopRzOptionsFree;
+  std::function<hadoopRzBuffer*(hdfsFile, hadoopRzOptions*, int32_t)>
+      hadoopReadZero;
+  std::function<int32_t(const hadoopRzBuffer*)> hadoopRzBufferLength;
+  std::function<const void*(const hadoopRzBuffer*)> hadoopRzBufferGet;
+  std::function<void(hdfsFile, hadoopRzBuffer*)> hadoopRzBufferFree;
+
+  bool has_zero_copy() const { return has_zero_copy_; }
 
  private:
   void LoadAndBind() {
@@ -100,7 +149,23 @@ class LibHDFS {
       BIND_HDFS_FUNC(hdfsCreateDirectory);
       BIND_HDFS_FUNC(hdfsGetPathInfo);
       BIND_HDFS_FUNC(hdfsRename);
+      BIND_HDFS_FUNC(hdfsSeek);
 #undef BIND_HDFS_FUNC
+
+      // Older versions of libhdfs have no zero-copy reads.
+      has_zero_copy_ =
+          BindFunc(*handle, "hadoopRzOptionsAlloc", &hadoopRzOptionsAlloc)
+              .ok() &&
+          BindFunc(*handle, "hadoopRzOptionsSetByteBufferPool",
+                   &hadoopRzOptionsSetByteBufferPool)
+              .ok() &&
+          BindFunc(*handle, "hadoopRzOptionsFree", &hadoopRzOptionsFree)
+              .ok() &&
+          BindFunc(*handle, "hadoopReadZero", &hadoopReadZero).ok() &&
+          BindFunc(*handle, "hadoopRzBufferLength", &hadoopRzBufferLength)
+              .ok() &&
+          BindFunc(*handle, "hadoopRzBufferGet", &hadoopRzBufferGet).ok() &&
+          BindFunc(*handle, "hadoopRzBufferFree", &hadoopRzBufferFree).ok();
       return Status::OK();
     };
 
@@ -129,9 +194,45 @@ class LibHDFS {
 
   Status status_;
   void* handle_ = nullptr;
+  bool has_zero_copy_ = false;
 };
 
-HadoopFileSystem::HadoopFileSystem() : hdfs_(LibHDFS::Load()) {}
+HadoopFileSystem::HadoopFileSystem() : hdfs_(LibHDFS::Load()) {
+  const uint64 max_size_mb = GetEnvVarOrDefault(kReadCacheMaxSizeMB, 0);
+  if (max_size_mb > 0) {
+    const uint64 block_size_mb = GetEnvVarOrDefault(
+        kReadCacheBlockSizeMB, kDefaultReadCacheBlockSizeMB);
+    const uint64 prefetch_blocks = GetEnvVarOrDefault(
+        kReadCachePrefetchBlocks, kDefaultReadCachePrefetchBlocks);
+    const uint64 fetch_threads = GetEnvVarOrDefault(
+        kReadCacheFetchThreads, kDefaultReadCacheFetchThreads);
+    InitFileBlockCache(std::max<uint64>(block_size_mb, 1) * 1024 * 1024,
+                       max_size_mb * 1024 * 1024, prefetch_blocks,
+                       fetch_threads,
+                       GetEnvVarOrDefault(kReadCacheZeroCopy, 0) == 1);
+  }
+}
+
+HadoopFileSystem::HadoopFileSystem(size_t block_size, size_t max_bytes,
+                                   size_t prefetch_blocks,
+                                   int num_fetch_threads, bool zero_copy)
+    : hdfs_(LibHDFS::Load()) {
+  InitFileBlockCache(block_size, max_bytes, prefetch_blocks,
+                     num_fetch_threads, zero_copy);
+}
+
+void HadoopFileSystem::InitFileBlockCache(size_t block_size, size_t max_bytes,
+                                          size_t prefetch_blocks,
+                                          int num_fetch_threads,
+                                          bool zero_copy) {
+  zero_copy_ = zero_copy;
+  file_block_cache_.reset(new FileBlockCache(
+      block_size, max_bytes, prefetch_blocks, num_fetch_threads,
+      [this](const string& fname, size_t offset, size_t n,
+             std::vector<char>* out) {
+        return LoadBlock(fname, offset, n, out);
+      }));
+}
 
 HadoopFileSystem::~HadoopFileSystem() {}
 
@@ -252,8 +353,129 @@ class HDFSRandomAccessFile : public RandomAccessFile {
   mutable hdfsFile file_ GUARDED_BY(mu_);
 };
 
+// An HDFS random access file that reads through the block cache of its file
+// system. Unlike HDFSRandomAccessFile, it does not see data appended to the
+// file after the blocks holding the end of the file were cached.
+class HDFSBlockCacheRandomAccessFile : public RandomAccessFile {
+ public:
+  HDFSBlockCacheRandomAccessFile(const string& filename,
+                                 FileBlockCache* file_block_cache)
+      : filename_(filename), file_block_cache_(file_block_cache) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    size_t bytes_transferred = 0;
+    TF_RETURN_IF_ERROR(file_block_cache_->Read(filename_, offset, n, scratch,
+                                               &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      return errors::OutOfRange("Read less bytes than requested");
+    }
+    return Status::OK();
+  }
+
+ private:
+  string filename_;
+  FileBlockCache* file_block_cache_;  // Not owned.
+};
+
+// Each block is read with its own file handle, so that concurrent fetches of
+// the blocks of a file don't contend on a lock, and every fetch sees the
+// latest contents of the file.
+Status HadoopFileSystem::LoadBlock(const string& fname, size_t offset,
+                                   size_t n, std::vector<char>* out) {
+  hdfsFS fs = nullptr;
+  TF_RETURN_IF_ERROR(Connect(fname, &fs));
+
+  hdfsFile file =
+      hdfs_->hdfsOpenFile(fs, TranslateName(fname).c_str(), O_RDONLY, 0, 0, 0);
+  if (file == nullptr) {
+    return IOError(fname, errno);
+  }
+  out->resize(n);
+  size_t bytes_read = 0;
+  Status s;
+  if (zero_copy_ && hdfs_->has_zero_copy()) {
+    s = ReadZeroCopy(fname, fs, file, offset, out, &bytes_read);
+  } else {
+    while (bytes_read < n) {
+      tSize r = hdfs_->hdfsPread(fs, file,
+                                 static_cast<tOffset>(offset + bytes_read),
+                                 out->data() + bytes_read,
+                                 static_cast<tSize>(n - bytes_read));
+      if (r > 0) {
+        bytes_read += r;
+      } else if (r == 0) {
+        break;
+      } else if (errno != EINTR && errno != EAGAIN) {
+        s = IOError(fname, errno);
+        break;
+      }
+    }
+  }
+  out->resize(bytes_read);
+  if (hdfs_->hdfsCloseFile(fs, file) != 0 && s.ok()) {
+    s = IOError(fname, errno);
+  }
+  return s;
+}
+
+// Reads out->size() bytes at offset with hadoopReadZero, which maps the
+// data of local blocks. Remote blocks fall back to a copy into buffers of
+// the byte buffer pool.
+Status HadoopFileSystem::ReadZeroCopy(const string& fname, hdfsFS fs,
+                                      hdfsFile file, size_t offset,
+                                      std::vector<char>* out,
+                                      size_t* bytes_read) {
+  if (hdfs_->hdfsSeek(fs, file, static_cast<tOffset>(offset)) != 0) {
+    return IOError(fname, errno);
+  }
+  hadoopRzOptions* options = hdfs_->hadoopRzOptionsAlloc();
+  if (options == nullptr) {
+    return IOError(fname, errno);
+  }
+  Status s;
+  if (hdfs_->hadoopRzOptionsSetByteBufferPool(
+          options, ELASTIC_BYTE_BUFFER_POOL_CLASS) != 0) {
+    s = IOError(fname, errno);
+  }
+  while (s.ok() && *bytes_read < out->size()) {
+    hadoopRzBuffer* buffer = hdfs_->hadoopReadZero(
+        file, options, static_cast<int32_t>(out->size() - *bytes_read));
+    if (buffer == nullptr) {
+      s = IOError(fname, errno);
+      break;
+    }
+    const void* data = hdfs_->hadoopRzBufferGet(buffer);
+    const int32_t length = hdfs_->hadoopRzBufferLength(buffer);
+    if (data != nullptr && length > 0) {
+      memcpy(out->data() + *bytes_read, data, length);
+      *bytes_read += length;
+    }
+    hdfs_->hadoopRzBufferFree(file, buffer);
+    if (data == nullptr || length <= 0) {
+      // End of file.
+      break;
+    }
+  }
+  hdfs_->hadoopRzOptionsFree(options);
+  return s;
+}
+
+void HadoopFileSystem::RemoveFromCache(const string& fname) {
+  if (file_block_cache_ != nullptr) {
+    file_block_cache_->RemoveFile(fname);
+  }
+}
+
 Status HadoopFileSystem::NewRandomAccessFile(
     const string& fname, std::unique_ptr<RandomAccessFile>* result) {
+  if (file_block_cache_ != nullptr) {
+    result->reset(
+        new HDFSBlockCacheRandomAccessFile(fname, file_block_cache_.get()));
+    return Status::OK();
+  }
+
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
 
@@ -322,6 +544,7 @@ Status HadoopFileSystem::NewWritableFile(
     const string& fname, std::unique_ptr<WritableFile>* result) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
+  RemoveFromCache(fname);
 
   hdfsFile file =
       hdfs_->hdfsOpenFile(fs, TranslateName(fname).c_str(), O_WRONLY, 0, 0, 0);
@@ -336,6 +559,7 @@ Status HadoopFileSystem::NewAppendableFile(
     const string& fname, std::unique_ptr<WritableFile>* result) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
+  RemoveFromCache(fname);
 
   hdfsFile file = hdfs_->hdfsOpenFile(fs, TranslateName(fname).c_str(),
                                       O_WRONLY | O_APPEND, 0, 0, 0);
@@ -397,6 +621,7 @@ Status HadoopFileSystem::GetChildren(const string& dir,
 Status HadoopFileSystem::DeleteFile(const string& fname) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(fname, &fs));
+  RemoveFromCache(fname);
 
   if (hdfs_->hdfsDelete(fs, TranslateName(fname).c_str(),
                         /*recursive=*/0) != 0) {
@@ -463,6 +688,8 @@ Status HadoopFileSystem::GetFileSize(const string& fname, uint64* size) {
 Status HadoopFileSystem::RenameFile(const string& src, const string& target) {
   hdfsFS fs = nullptr;
   TF_RETURN_IF_ERROR(Connect(src, &fs));
+  RemoveFromCache(src);
+  RemoveFromCache(target);
 
   if (hdfs_->hdfsExists(fs, TranslateName(target).c_str()) == 0 &&
       hdfs_->hdfsDelete(fs, TranslateName(target).c_str(),
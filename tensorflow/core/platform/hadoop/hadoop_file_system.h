@@ -16,20 +16,34 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_PLATFORM_HADOOP_HADOOP_FILE_SYSTEM_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_PLATFORM_HADOOP_HADOOP_FILE_SYSTEM_H_
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/platform/env.h"
 
 extern "C" {
 struct hdfs_internal;
 typedef hdfs_internal* hdfsFS;
+struct hdfsFile_internal;
+typedef hdfsFile_internal* hdfsFile;
 }
 
 namespace tensorflow {
 
+class FileBlockCache;
 class LibHDFS;
 
 class HadoopFileSystem : public FileSystem {
  public:
+  // Reads through a block cache if the HDFS_READ_CACHE_MAX_SIZE_MB
+  // environment variable is set.
   HadoopFileSystem();
+  // Reads through a block cache of at most max_bytes bytes, loaded in blocks
+  // of block_size bytes on num_fetch_threads threads, with prefetch_blocks
+  // blocks prefetched after each read. If zero_copy is set and libhdfs
+  // supports it, the blocks are loaded with zero-copy reads.
+  HadoopFileSystem(size_t block_size, size_t max_bytes, size_t prefetch_blocks,
+                   int num_fetch_threads, bool zero_copy);
   ~HadoopFileSystem();
 
   Status NewRandomAccessFile(
@@ -65,7 +79,28 @@ class HadoopFileSystem : public FileSystem {
 
  private:
   Status Connect(StringPiece fname, hdfsFS* fs);
+
+  // Creates file_block_cache_, which loads blocks with LoadBlock().
+  void InitFileBlockCache(size_t block_size, size_t max_bytes,
+                          size_t prefetch_blocks, int num_fetch_threads,
+                          bool zero_copy);
+
+  // Loads up to n bytes of fname at offset into out.
+  Status LoadBlock(const string& fname, size_t offset, size_t n,
+                   std::vector<char>* out);
+
+  // Fills out with the bytes of file at offset using zero-copy reads, and
+  // sets bytes_read to the number of bytes read, fewer at the end of file.
+  Status ReadZeroCopy(const string& fname, hdfsFS fs, hdfsFile file,
+                      size_t offset, std::vector<char>* out,
+                      size_t* bytes_read);
+
+  // Drops the cached blocks of fname, if there is a block cache.
+  void RemoveFromCache(const string& fname);
+
   LibHDFS* hdfs_;
+  bool zero_copy_ = false;
+  std::unique_ptr<FileBlockCache> file_block_cache_;
 };
 
 }  // namespace tensorflow
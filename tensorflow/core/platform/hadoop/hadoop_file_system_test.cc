@@ -229,6 +229,42 @@ TEST_F(HadoopFileSystemTest, WriteWhileReading) {
   TF_EXPECT_OK(writer->Close());
 }
 
+TEST_F(HadoopFileSystemTest, BlockCacheRandomAccessFile) {
+  for (const bool zero_copy : {false, true}) {
+    // Blocks of 4 bytes, so that reads span several blocks.
+    HadoopFileSystem cached_hdfs(4, 64, 2, 2, zero_copy);
+    const string fname = TmpDir("BlockCacheRandomAccessFile");
+    const string content = "abcdefghijklmn";
+    TF_ASSERT_OK(WriteString(fname, content));
+
+    std::unique_ptr<RandomAccessFile> reader;
+    TF_EXPECT_OK(cached_hdfs.NewRandomAccessFile(fname, &reader));
+
+    string got;
+    got.resize(content.size());
+    StringPiece result;
+    TF_EXPECT_OK(
+        reader->Read(0, content.size(), &result, gtl::string_as_array(&got)));
+    EXPECT_EQ(content, result);
+
+    TF_EXPECT_OK(reader->Read(3, 6, &result, gtl::string_as_array(&got)));
+    EXPECT_EQ(content.substr(3, 6), result);
+
+    EXPECT_EQ(error::OUT_OF_RANGE,
+              reader->Read(10, 10, &result, gtl::string_as_array(&got))
+                  .code());
+    EXPECT_EQ(content.substr(10), result);
+
+    // Rewriting the file through the same file system drops its blocks.
+    std::unique_ptr<WritableFile> writer;
+    TF_EXPECT_OK(cached_hdfs.NewWritableFile(fname, &writer));
+    TF_EXPECT_OK(writer->Append("0123456789"));
+    TF_EXPECT_OK(writer->Close());
+    TF_EXPECT_OK(reader->Read(2, 5, &result, gtl::string_as_array(&got)));
+    EXPECT_EQ("23456", result);
+  }
+}
+
 // NewAppendableFile() is not testable. Local filesystem maps to
 // ChecksumFileSystem in Hadoop, where appending is an unsupported operation.
 
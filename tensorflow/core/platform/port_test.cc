@@ -76,5 +76,29 @@ TEST(TestCPUFeature, TestFeature) {
   LOG(INFO) << "has_avx2 = " << has_avx2;
 }
 
+TEST(Port, NUMA) {
+  // The topology depends on the host, so just check that it is consistent
+  // and that a pool bound to a node runs its closures.
+  const int num_nodes = NUMANumNodes();
+  ASSERT_GE(num_nodes, 1);
+  for (int node = 0; node < num_nodes; ++node) {
+    EXPECT_GT(NUMANumNodeCPUs(node), 0) << "node " << node;
+  }
+  ThreadOptions thread_options;
+  thread_options.numa_node = num_nodes - 1;
+  mutex mu;
+  int count = 0;
+  {
+    thread::ThreadPool pool(Env::Default(), thread_options, "numa", 2);
+    for (int i = 0; i < 10; ++i) {
+      pool.Schedule([&mu, &count]() {
+        mutex_lock l(mu);
+        ++count;
+      });
+    }
+  }
+  EXPECT_EQ(10, count);
+}
+
 }  // namespace port
 }  // namespace tensorflow
@@ -66,6 +66,76 @@ int NumSchedulableCPUs() {
   return kDefaultCores;
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Sets 'cpus' to the schedulable CPUs of this process on NUMA node 'node',
+// read from the "0-3,8-11" cpulist of the node in sysfs.
+bool NUMANodeCPUSet(int node, cpu_set_t* cpus) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+           node);
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  CPU_ZERO(cpus);
+  int first;
+  while (fscanf(f, "%d", &first) == 1) {
+    int last = first;
+    int c = fgetc(f);
+    if (c == '-') {
+      if (fscanf(f, "%d", &last) != 1) break;
+      c = fgetc(f);
+    }
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, cpus);
+    }
+    if (c != ',') break;
+  }
+  fclose(f);
+  cpu_set_t schedulable;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &schedulable) == 0) {
+    CPU_AND(cpus, cpus, &schedulable);
+  }
+  return CPU_COUNT(cpus) > 0;
+}
+
+}  // namespace
+#endif
+
+int NUMANumNodes() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  static const int num_nodes = [] {
+    int n = 0;
+    cpu_set_t cpus;
+    while (NUMANodeCPUSet(n, &cpus)) ++n;
+    return n > 0 ? n : 1;
+  }();
+  return num_nodes;
+#else
+  return 1;
+#endif
+}
+
+int NUMANumNodeCPUs(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpus;
+  if (NUMANumNodes() > 1 && NUMANodeCPUSet(node, &cpus)) {
+    return CPU_COUNT(&cpus);
+  }
+#endif
+  return NumSchedulableCPUs();
+}
+
+bool NUMASetThreadNodeAffinity(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpus;
+  if (NUMANodeCPUSet(node, &cpus)) {
+    return sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+  }
+#endif
+  return false;
+}
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #if defined(__ANDROID__)
   return memalign(minimum_alignment, size);
@@ -66,6 +66,20 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+  Status ReadV(std::vector<ReadRequest>* requests) const override {
+#if defined(POSIX_FADV_WILLNEED)
+    // Starts the reads of all requests in the kernel before waiting for the
+    // first one, so the device sees them at once instead of one at a time.
+    if (requests->size() > 1) {
+      for (const ReadRequest& request : *requests) {
+        posix_fadvise(fd_, static_cast<off_t>(request.offset),
+                      static_cast<off_t>(request.n), POSIX_FADV_WILLNEED);
+      }
+    }
+#endif
+    return RandomAccessFile::ReadV(requests);
+  }
 };
 
 class PosixWritableFile : public WritableFile {
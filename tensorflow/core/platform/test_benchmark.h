@@ -55,6 +55,8 @@ class Benchmark {
   Benchmark* ArgPair(int x, int y);
   Benchmark* Range(int lo, int hi);
   Benchmark* RangePair(int lo1, int hi1, int lo2, int hi2);
+  // Runs the benchmarks selected by 'pattern': "all" (or ".*", "..") or a
+  // comma-separated list of substrings of their names.
   static void Run(const char* pattern);
 
  private:
@@ -56,6 +56,12 @@ int NumSchedulableCPUs() {
   return system_info.dwNumberOfProcessors;
 }
 
+int NUMANumNodes() { return 1; }
+
+int NUMANumNodeCPUs(int node) { return NumSchedulableCPUs(); }
+
+bool NUMASetThreadNodeAffinity(int node) { return false; }
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #ifdef TENSORFLOW_USE_JEMALLOC
   void* ptr = NULL;
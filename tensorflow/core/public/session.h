@@ -170,6 +170,36 @@ class Session {
                       const std::vector<string>& output_names,
                       std::vector<Tensor>* outputs);
 
+  /// \brief A handle to a subgraph, created with `Session::MakeCallable()`.
+  typedef int64 CallableHandle;
+
+  /// \brief Prepares the executors running the subgraph defined by
+  /// `callable_options`, and returns a handle to run it with
+  /// `Session::RunCallable()`. Unlike `Run()`, which looks up its executors by
+  /// the names of its feeds and fetches on every call, the handle resolves them
+  /// once.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status MakeCallable(const CallableOptions& callable_options,
+                              CallableHandle* out_handle);
+
+  /// \brief Runs the subgraph of `handle`, feeding `feed_tensors` in the order
+  /// of `CallableOptions.feed`, and fills `fetch_tensors` in the order of
+  /// `CallableOptions.fetch`. The storage of `fetch_tensors` is reused across
+  /// calls. `run_metadata` may be nullptr.
+  ///
+  /// The feeds in `CallableOptions.feed_devices` must be allocated on their
+  /// device, and the fetches in `CallableOptions.fetch_devices` are returned
+  /// on their device, once the device has finished computing them.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status RunCallable(CallableHandle handle,
+                             const std::vector<Tensor>& feed_tensors,
+                             std::vector<Tensor>* fetch_tensors,
+                             RunMetadata* run_metadata);
+
+  /// \brief Releases the resources of `handle`, which can no longer be run.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status ReleaseCallable(CallableHandle handle);
+
   /// \brief Closes this session.
   ///
   /// Closing a session releases the resources used by this session
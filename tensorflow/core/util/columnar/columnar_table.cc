@@ -0,0 +1,413 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/columnar/columnar_table.h"
+
+#include <string.h>
+#include <utility>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/iterator.h"
+#include "tensorflow/core/lib/io/table_options.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+namespace {
+
+// Version of the columnar table format.
+const int kColumnarTableVersion = 1;
+
+// The header holds the schema and the number of rows of each chunk.  It is
+// written last, so its key sorts after the keys of all the column chunks.
+const char kHeaderKey[] = "h";
+const char kChunkKeyPrefix = 'c';
+
+// Returns the key of `column` in `chunk`, which sorts the columns of a chunk
+// together, and the chunks in order.
+string ChunkKey(int64 chunk, int column) {
+  string key(1, kChunkKeyPrefix);
+  // Big-endian, so that the byte order of the keys is the numeric order.
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>(static_cast<uint64>(chunk) >> shift));
+  }
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>(static_cast<uint32>(column) >> shift));
+  }
+  return key;
+}
+
+bool IsSupportedType(DataType dtype) {
+  return dtype == DT_STRING || DataTypeCanUseMemcpy(dtype);
+}
+
+Status CheckSchema(const std::vector<ColumnSchema>& columns) {
+  for (const ColumnSchema& column : columns) {
+    if (!IsSupportedType(column.dtype)) {
+      return errors::InvalidArgument("Column ", column.name,
+                                     " has unsupported type ",
+                                     DataTypeString(column.dtype));
+    }
+  }
+  return Status::OK();
+}
+
+string EncodeHeader(const std::vector<ColumnSchema>& columns,
+                    const std::vector<int64>& chunk_rows) {
+  string header;
+  core::PutVarint32(&header, kColumnarTableVersion);
+  header.push_back(port::kLittleEndian ? 1 : 0);
+  core::PutVarint32(&header, columns.size());
+  for (const ColumnSchema& column : columns) {
+    core::PutVarint32(&header, column.name.size());
+    header.append(column.name);
+    core::PutVarint32(&header, column.dtype);
+    header.push_back(column.varlen ? 1 : 0);
+    const int dims = column.varlen ? 0 : column.row_shape.dims();
+    core::PutVarint32(&header, dims);
+    for (int d = 0; d < dims; ++d) {
+      core::PutVarint64(&header, column.row_shape.dim_size(d));
+    }
+  }
+  core::PutVarint64(&header, chunk_rows.size());
+  for (const int64 rows : chunk_rows) {
+    core::PutVarint64(&header, rows);
+  }
+  return header;
+}
+
+Status DecodeHeader(StringPiece header, std::vector<ColumnSchema>* columns,
+                    std::vector<int64>* chunk_rows) {
+  const auto corrupted = [] {
+    return errors::DataLoss("Corrupted columnar table header");
+  };
+  uint32 version;
+  if (!core::GetVarint32(&header, &version)) return corrupted();
+  if (version != kColumnarTableVersion) {
+    return errors::Unimplemented("Unsupported columnar table version ",
+                                 version);
+  }
+  if (header.empty()) return corrupted();
+  if ((header[0] != 0) != port::kLittleEndian) {
+    return errors::Unimplemented(
+        "Reading a columnar table with different endianness from the reader");
+  }
+  header.remove_prefix(1);
+  uint32 num_columns;
+  if (!core::GetVarint32(&header, &num_columns)) return corrupted();
+  columns->clear();
+  for (uint32 i = 0; i < num_columns; ++i) {
+    ColumnSchema column;
+    uint32 name_size, dtype, dims;
+    if (!core::GetVarint32(&header, &name_size) || header.size() < name_size) {
+      return corrupted();
+    }
+    column.name.assign(header.data(), name_size);
+    header.remove_prefix(name_size);
+    if (!core::GetVarint32(&header, &dtype) || header.empty()) {
+      return corrupted();
+    }
+    column.dtype = static_cast<DataType>(dtype);
+    column.varlen = header[0] != 0;
+    header.remove_prefix(1);
+    if (!core::GetVarint32(&header, &dims)) return corrupted();
+    std::vector<int64> dim_sizes;
+    for (uint32 d = 0; d < dims; ++d) {
+      uint64 dim_size;
+      if (!core::GetVarint64(&header, &dim_size)) return corrupted();
+      dim_sizes.push_back(dim_size);
+    }
+    TF_RETURN_IF_ERROR(
+        TensorShapeUtils::MakeShape(dim_sizes, &column.row_shape));
+    columns->push_back(std::move(column));
+  }
+  uint64 num_chunks;
+  if (!core::GetVarint64(&header, &num_chunks)) return corrupted();
+  chunk_rows->clear();
+  for (uint64 i = 0; i < num_chunks; ++i) {
+    uint64 rows;
+    if (!core::GetVarint64(&header, &rows)) return corrupted();
+    chunk_rows->push_back(rows);
+  }
+  if (!header.empty()) return corrupted();
+  return CheckSchema(*columns);
+}
+
+// Appends the encoding of the values of `tensor` to `out`: their raw bytes,
+// or for strings, their varint lengths followed by their bytes.
+void AppendValues(const Tensor& tensor, string* out) {
+  if (tensor.dtype() != DT_STRING) {
+    const StringPiece data = tensor.tensor_data();
+    out->append(data.data(), data.size());
+    return;
+  }
+  const auto values = tensor.flat<string>();
+  for (int64 i = 0; i < values.size(); ++i) {
+    core::PutVarint64(out, values(i).size());
+  }
+  for (int64 i = 0; i < values.size(); ++i) {
+    out->append(values(i));
+  }
+}
+
+// Decodes the values at the front of `data` into `tensor`, and removes them
+// from `data`.
+Status ConsumeValues(StringPiece* data, Tensor* tensor) {
+  if (tensor->dtype() != DT_STRING) {
+    const StringPiece buffer = tensor->tensor_data();
+    if (data->size() < buffer.size()) {
+      return errors::DataLoss("Column chunk holds ", data->size(),
+                              " bytes, expected at least ", buffer.size());
+    }
+    memcpy(const_cast<char*>(buffer.data()), data->data(), buffer.size());
+    data->remove_prefix(buffer.size());
+    return Status::OK();
+  }
+  auto values = tensor->flat<string>();
+  std::vector<uint64> lengths(values.size());
+  for (int64 i = 0; i < values.size(); ++i) {
+    if (!core::GetVarint64(data, &lengths[i])) {
+      return errors::DataLoss("Corrupted string lengths in column chunk");
+    }
+  }
+  for (int64 i = 0; i < values.size(); ++i) {
+    if (data->size() < lengths[i]) {
+      return errors::DataLoss("Column chunk ends in the middle of a string");
+    }
+    values(i).assign(data->data(), lengths[i]);
+    data->remove_prefix(lengths[i]);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+ColumnarTableWriter::ColumnarTableWriter(Env* env, const string& filename,
+                                         std::vector<ColumnSchema> columns)
+    : columns_(std::move(columns)) {
+  status_ = CheckSchema(columns_);
+  if (!status_.ok()) return;
+  status_ = env->NewWritableFile(filename, &file_);
+  if (!status_.ok()) return;
+  // Column chunks are raw tensor bytes, which rarely compress well enough to
+  // be worth the decompression on every read.
+  table::Options options;
+  options.compression = table::kNoCompression;
+  builder_.reset(new table::TableBuilder(options, file_.get()));
+}
+
+ColumnarTableWriter::~ColumnarTableWriter() {
+  if (builder_ != nullptr) builder_->Abandon();
+}
+
+Status ColumnarTableWriter::WriteChunk(const std::vector<ColumnChunk>& chunk) {
+  TF_RETURN_IF_ERROR(status_);
+  if (builder_ == nullptr) {
+    return errors::FailedPrecondition("Columnar table already finished");
+  }
+  if (chunk.size() != columns_.size()) {
+    return errors::InvalidArgument("Chunk has ", chunk.size(),
+                                   " columns, but the schema has ",
+                                   columns_.size());
+  }
+  int64 num_rows = -1;
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    const ColumnSchema& column = columns_[c];
+    const Tensor& values = chunk[c].values;
+    if (values.dtype() != column.dtype) {
+      return errors::InvalidArgument(
+          "Column ", column.name, " has type ", DataTypeString(column.dtype),
+          ", but its chunk has type ", DataTypeString(values.dtype()));
+    }
+    int64 rows;
+    if (column.varlen) {
+      const Tensor& row_lengths = chunk[c].row_lengths;
+      if (!TensorShapeUtils::IsVector(values.shape()) ||
+          row_lengths.dtype() != DT_INT64 ||
+          !TensorShapeUtils::IsVector(row_lengths.shape())) {
+        return errors::InvalidArgument(
+            "Chunk of variable-length column ", column.name,
+            " needs vectors of values and int64 row lengths");
+      }
+      int64 total_length = 0;
+      for (int64 i = 0; i < row_lengths.NumElements(); ++i) {
+        const int64 length = row_lengths.vec<int64>()(i);
+        if (length < 0) {
+          return errors::InvalidArgument("Negative row length in column ",
+                                         column.name);
+        }
+        total_length += length;
+      }
+      if (total_length != values.NumElements()) {
+        return errors::InvalidArgument(
+            "Row lengths of column ", column.name, " add up to ",
+            total_length, ", but it has ", values.NumElements(), " values");
+      }
+      rows = row_lengths.NumElements();
+    } else {
+      TensorShape row_shape = values.shape();
+      if (row_shape.dims() == 0) {
+        return errors::InvalidArgument("Chunk of column ", column.name,
+                                       " must have a dimension for the rows");
+      }
+      rows = row_shape.dim_size(0);
+      row_shape.RemoveDim(0);
+      if (row_shape != column.row_shape) {
+        return errors::InvalidArgument(
+            "Rows of column ", column.name, " have shape ",
+            row_shape.DebugString(), ", expected ",
+            column.row_shape.DebugString());
+      }
+    }
+    if (num_rows >= 0 && rows != num_rows) {
+      return errors::InvalidArgument("Column ", column.name, " has ", rows,
+                                     " rows, but the previous ones have ",
+                                     num_rows);
+    }
+    num_rows = rows;
+  }
+
+  const int64 chunk_index = chunk_rows_.size();
+  string buffer;
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    const Tensor& values = chunk[c].values;
+    StringPiece value;
+    if (!columns_[c].varlen && values.dtype() != DT_STRING) {
+      // Fixed numeric columns are added straight from the tensor buffer.
+      value = values.tensor_data();
+    } else {
+      buffer.clear();
+      if (columns_[c].varlen) AppendValues(chunk[c].row_lengths, &buffer);
+      AppendValues(values, &buffer);
+      value = buffer;
+    }
+    builder_->Add(ChunkKey(chunk_index, c), value);
+    // Gives every column chunk its own data blocks, so that reading a column
+    // never reads the bytes of another.
+    builder_->Flush();
+  }
+  status_ = builder_->status();
+  TF_RETURN_IF_ERROR(status_);
+  chunk_rows_.push_back(num_rows);
+  return Status::OK();
+}
+
+Status ColumnarTableWriter::Finish() {
+  TF_RETURN_IF_ERROR(status_);
+  if (builder_ == nullptr) {
+    return errors::FailedPrecondition("Columnar table already finished");
+  }
+  builder_->Add(kHeaderKey, EncodeHeader(columns_, chunk_rows_));
+  status_ = builder_->Finish();
+  builder_.reset();
+  if (status_.ok()) {
+    status_ = file_->Close();
+  }
+  file_.reset();
+  return status_;
+}
+
+ColumnarTableReader::ColumnarTableReader(Env* env, const string& filename) {
+  uint64 file_size;
+  status_ = env->GetFileSize(filename, &file_size);
+  if (!status_.ok()) return;
+  status_ = env->NewRandomAccessFile(filename, &file_);
+  if (!status_.ok()) return;
+  table::Table* table;
+  status_ =
+      table::Table::Open(table::Options(), file_.get(), file_size, &table);
+  if (!status_.ok()) return;
+  table_.reset(table);
+
+  std::unique_ptr<table::Iterator> iter(table_->NewIterator());
+  iter->Seek(kHeaderKey);
+  if (!iter->Valid() || iter->key() != kHeaderKey) {
+    status_ = iter->status().ok()
+                  ? errors::DataLoss("Columnar table ", filename,
+                                     " has no header")
+                  : iter->status();
+    return;
+  }
+  status_ = DecodeHeader(iter->value(), &columns_, &chunk_rows_);
+}
+
+ColumnarTableReader::~ColumnarTableReader() {
+  // The table reads from file_, and is destroyed first.
+  table_.reset();
+}
+
+int ColumnarTableReader::ColumnIndex(StringPiece name) const {
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    if (columns_[c].name == name) return c;
+  }
+  return -1;
+}
+
+Status ColumnarTableReader::ReadChunk(int64 chunk,
+                                      const std::vector<int>& columns,
+                                      std::vector<ColumnChunk>* out) const {
+  TF_RETURN_IF_ERROR(status_);
+  if (chunk < 0 || chunk >= num_chunks()) {
+    return errors::OutOfRange("Chunk ", chunk, " is not in [0, ",
+                              num_chunks(), ")");
+  }
+  const int64 num_rows = chunk_rows_[chunk];
+  out->clear();
+  out->resize(columns.size());
+  std::unique_ptr<table::Iterator> iter(table_->NewIterator());
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const int c = columns[i];
+    if (c < 0 || c >= static_cast<int>(columns_.size())) {
+      return errors::InvalidArgument("Column index ", c, " is not in [0, ",
+                                     columns_.size(), ")");
+    }
+    const ColumnSchema& column = columns_[c];
+    const string key = ChunkKey(chunk, c);
+    iter->Seek(key);
+    TF_RETURN_IF_ERROR(iter->status());
+    if (!iter->Valid() || iter->key() != key) {
+      return errors::DataLoss("Columnar table is missing column ",
+                              column.name, " of chunk ", chunk);
+    }
+    StringPiece data = iter->value();
+    ColumnChunk* result = &(*out)[i];
+    if (column.varlen) {
+      result->row_lengths = Tensor(DT_INT64, TensorShape({num_rows}));
+      TF_RETURN_IF_ERROR(ConsumeValues(&data, &result->row_lengths));
+      int64 num_values = 0;
+      const auto row_lengths = result->row_lengths.vec<int64>();
+      for (int64 r = 0; r < num_rows; ++r) {
+        if (row_lengths(r) < 0) {
+          return errors::DataLoss("Negative row length in column ",
+                                  column.name, " of chunk ", chunk);
+        }
+        num_values += row_lengths(r);
+      }
+      result->values = Tensor(column.dtype, TensorShape({num_values}));
+    } else {
+      TensorShape shape = column.row_shape;
+      shape.InsertDim(0, num_rows);
+      result->values = Tensor(column.dtype, shape);
+    }
+    TF_RETURN_IF_ERROR(ConsumeValues(&data, &result->values));
+    if (!data.empty()) {
+      return errors::DataLoss("Column ", column.name, " of chunk ", chunk,
+                              " has ", data.size(), " unexpected bytes");
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A columnar file format for input features with a fixed schema.
+//
+// A columnar table stores rows of named columns, split into chunks of rows.
+// Each column of a chunk is stored as one entry of a table (see
+// lib/io/table.h), laid out as the raw bytes of a Tensor, in its own data
+// block.  Reading a chunk thus decodes each column with a single copy into a
+// Tensor buffer, and never reads the blocks of the columns that are not
+// requested.
+//
+// A column is either fixed, where every row holds a tensor of the same shape,
+// or variable-length, where every row holds a vector of any length.  The
+// values of a variable-length column in a chunk are concatenated, and come
+// with the length of each row.
+//
+// Usage:
+//   ColumnarTableWriter writer(env, filename, schema);
+//   for (...) TF_RETURN_IF_ERROR(writer.WriteChunk(chunk));
+//   TF_RETURN_IF_ERROR(writer.Finish());
+//
+//   ColumnarTableReader reader(env, filename);
+//   TF_RETURN_IF_ERROR(reader.status());
+//   std::vector<ColumnChunk> chunk;
+//   TF_RETURN_IF_ERROR(reader.ReadChunk(0, {reader.ColumnIndex("a")}, &chunk));
+
+#ifndef TENSORFLOW_CORE_UTIL_COLUMNAR_COLUMNAR_TABLE_H_
+#define TENSORFLOW_CORE_UTIL_COLUMNAR_COLUMNAR_TABLE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/table.h"
+#include "tensorflow/core/lib/io/table_builder.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Describes one column of a columnar table.
+struct ColumnSchema {
+  string name;
+  DataType dtype = DT_INVALID;
+  // Whether the rows are vectors of any length rather than of row_shape.
+  bool varlen = false;
+  // The shape of every row of a fixed column.  Ignored if varlen is set.
+  TensorShape row_shape;
+};
+
+// The values of one column in a chunk of rows.
+struct ColumnChunk {
+  // For a fixed column, the rows stacked into a tensor of shape
+  // [num_rows] + row_shape.  For a variable-length column, the values of all
+  // rows concatenated into a vector.
+  Tensor values;
+  // For a variable-length column only, the int64 vector of the number of
+  // values of each row.
+  Tensor row_lengths;
+};
+
+// Writes a columnar table.  Not thread-safe.
+class ColumnarTableWriter {
+ public:
+  ColumnarTableWriter(Env* env, const string& filename,
+                      std::vector<ColumnSchema> columns);
+  ~ColumnarTableWriter();
+
+  // Returns an error if the table could not be created, or if a previous
+  // call failed.
+  Status status() const { return status_; }
+
+  // Appends a chunk of rows, with one ColumnChunk per column of the schema.
+  // All columns must hold the same number of rows.
+  Status WriteChunk(const std::vector<ColumnChunk>& chunk);
+
+  // Writes the schema and closes the file.  Must be called once, after the
+  // last chunk, for the table to be readable.
+  Status Finish();
+
+ private:
+  const std::vector<ColumnSchema> columns_;
+  std::unique_ptr<WritableFile> file_;
+  std::unique_ptr<table::TableBuilder> builder_;
+  std::vector<int64> chunk_rows_;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarTableWriter);
+};
+
+// Reads a columnar table.  Thread-safe after construction.
+class ColumnarTableReader {
+ public:
+  ColumnarTableReader(Env* env, const string& filename);
+  ~ColumnarTableReader();
+
+  // Returns an error if the table could not be opened.
+  Status status() const { return status_; }
+
+  const std::vector<ColumnSchema>& columns() const { return columns_; }
+
+  // Returns the index of the column called `name`, or -1 if there is none.
+  int ColumnIndex(StringPiece name) const;
+
+  int64 num_chunks() const { return chunk_rows_.size(); }
+
+  // Returns the number of rows of `chunk`.
+  int64 num_rows(int64 chunk) const { return chunk_rows_[chunk]; }
+
+  // Reads the given columns of `chunk` into `out`, one ColumnChunk per index
+  // in `columns`.  Only the data blocks of these columns are read.
+  Status ReadChunk(int64 chunk, const std::vector<int>& columns,
+                   std::vector<ColumnChunk>* out) const;
+
+ private:
+  std::unique_ptr<RandomAccessFile> file_;
+  std::unique_ptr<table::Table> table_;
+  std::vector<ColumnSchema> columns_;
+  std::vector<int64> chunk_rows_;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarTableReader);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_COLUMNAR_COLUMNAR_TABLE_H_
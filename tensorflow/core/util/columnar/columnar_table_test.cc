@@ -0,0 +1,224 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/columnar/columnar_table.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TmpFile(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+std::vector<ColumnSchema> TestSchema() {
+  std::vector<ColumnSchema> columns(3);
+  columns[0].name = "label";
+  columns[0].dtype = DT_FLOAT;
+  columns[1].name = "embedding";
+  columns[1].dtype = DT_INT64;
+  columns[1].row_shape = TensorShape({2});
+  columns[2].name = "tokens";
+  columns[2].dtype = DT_STRING;
+  columns[2].varlen = true;
+  return columns;
+}
+
+// Returns a chunk of TestSchema() with `num_rows` rows, from row `first_row`
+// of the table on.
+std::vector<ColumnChunk> TestChunk(int first_row, int num_rows) {
+  std::vector<ColumnChunk> chunk(3);
+  chunk[0].values = Tensor(DT_FLOAT, TensorShape({num_rows}));
+  chunk[1].values = Tensor(DT_INT64, TensorShape({num_rows, 2}));
+  chunk[2].row_lengths = Tensor(DT_INT64, TensorShape({num_rows}));
+  std::vector<string> tokens;
+  for (int r = 0; r < num_rows; ++r) {
+    const int row = first_row + r;
+    chunk[0].values.vec<float>()(r) = row * 0.5f;
+    chunk[1].values.matrix<int64>()(r, 0) = row;
+    chunk[1].values.matrix<int64>()(r, 1) = -row;
+    // Row i has i % 3 tokens.
+    chunk[2].row_lengths.vec<int64>()(r) = row % 3;
+    for (int i = 0; i < row % 3; ++i) {
+      tokens.push_back(strings::StrCat("token", row, "_", i));
+    }
+  }
+  chunk[2].values = test::AsTensor<string>(tokens);
+  return chunk;
+}
+
+// Expects `actual` to hold the given columns of `expected`, a chunk of
+// TestSchema().
+void ExpectChunksEqual(const std::vector<ColumnChunk>& expected,
+                       const std::vector<int>& columns,
+                       const std::vector<ColumnChunk>& actual) {
+  ASSERT_EQ(columns.size(), actual.size());
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const ColumnChunk& want = expected[columns[i]];
+    switch (want.values.dtype()) {
+      case DT_FLOAT:
+        test::ExpectTensorEqual<float>(want.values, actual[i].values);
+        break;
+      case DT_INT64:
+        test::ExpectTensorEqual<int64>(want.values, actual[i].values);
+        break;
+      case DT_STRING:
+        test::ExpectTensorEqual<string>(want.values, actual[i].values);
+        break;
+      default:
+        FAIL() << "Unexpected type";
+    }
+    if (TestSchema()[columns[i]].varlen) {
+      test::ExpectTensorEqual<int64>(want.row_lengths, actual[i].row_lengths);
+    }
+  }
+}
+
+TEST(ColumnarTableTest, WriteAndRead) {
+  const string filename = TmpFile("write_and_read");
+  const std::vector<std::vector<ColumnChunk>> chunks = {
+      TestChunk(0, 5), TestChunk(5, 3), TestChunk(8, 0)};
+  {
+    ColumnarTableWriter writer(Env::Default(), filename, TestSchema());
+    TF_ASSERT_OK(writer.status());
+    for (const auto& chunk : chunks) {
+      TF_ASSERT_OK(writer.WriteChunk(chunk));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  ColumnarTableReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  ASSERT_EQ(3, reader.columns().size());
+  EXPECT_EQ("embedding", reader.columns()[1].name);
+  EXPECT_EQ(DT_INT64, reader.columns()[1].dtype);
+  EXPECT_EQ(TensorShape({2}), reader.columns()[1].row_shape);
+  EXPECT_TRUE(reader.columns()[2].varlen);
+  EXPECT_EQ(2, reader.ColumnIndex("tokens"));
+  EXPECT_EQ(-1, reader.ColumnIndex("missing"));
+  ASSERT_EQ(3, reader.num_chunks());
+  EXPECT_EQ(5, reader.num_rows(0));
+  EXPECT_EQ(3, reader.num_rows(1));
+  EXPECT_EQ(0, reader.num_rows(2));
+
+  for (int64 chunk = 0; chunk < reader.num_chunks(); ++chunk) {
+    for (const std::vector<int>& columns :
+         std::vector<std::vector<int>>{{0, 1, 2}, {2, 0}, {1}, {}}) {
+      std::vector<ColumnChunk> out;
+      TF_ASSERT_OK(reader.ReadChunk(chunk, columns, &out));
+      ExpectChunksEqual(chunks[chunk], columns, out);
+    }
+  }
+
+  std::vector<ColumnChunk> out;
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadChunk(3, {0}, &out)));
+  EXPECT_TRUE(errors::IsInvalidArgument(reader.ReadChunk(0, {3}, &out)));
+}
+
+Tensor LargeColumnValues() {
+  Tensor values(DT_DOUBLE, TensorShape({4, 1000}));
+  values.flat<double>().setConstant(1.0);
+  return values;
+}
+
+TEST(ColumnarTableTest, ReadsOnlyRequestedColumns) {
+  const string filename = TmpFile("reads_only_requested_columns");
+  std::vector<ColumnSchema> columns(2);
+  columns[0].name = "small";
+  columns[0].dtype = DT_INT32;
+  columns[1].name = "large";
+  columns[1].dtype = DT_DOUBLE;
+  columns[1].row_shape = TensorShape({1000});
+  {
+    ColumnarTableWriter writer(Env::Default(), filename, columns);
+    std::vector<ColumnChunk> chunk(2);
+    chunk[0].values = test::AsTensor<int32>({1, 2, 3, 4});
+    chunk[1].values = LargeColumnValues();
+    TF_ASSERT_OK(writer.WriteChunk(chunk));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  // Corrupts the data block of the large column, which fails its checksum
+  // whenever the block is read.
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  const string ones(reinterpret_cast<const char*>(
+                        LargeColumnValues().flat<double>().data()),
+                    100 * sizeof(double));
+  const size_t pos = contents.find(ones);
+  ASSERT_NE(string::npos, pos);
+  contents[pos] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  ColumnarTableReader reader(Env::Default(), filename);
+  TF_ASSERT_OK(reader.status());
+  std::vector<ColumnChunk> out;
+  TF_ASSERT_OK(reader.ReadChunk(0, {0}, &out));
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>({1, 2, 3, 4}),
+                                 out[0].values);
+  EXPECT_TRUE(errors::IsDataLoss(reader.ReadChunk(0, {1}, &out)));
+}
+
+TEST(ColumnarTableTest, InvalidChunks) {
+  ColumnarTableWriter writer(Env::Default(), TmpFile("invalid_chunks"),
+                             TestSchema());
+  TF_ASSERT_OK(writer.status());
+
+  // Too few columns.
+  std::vector<ColumnChunk> chunk = TestChunk(0, 2);
+  chunk.pop_back();
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.WriteChunk(chunk)));
+
+  // Wrong type.
+  chunk = TestChunk(0, 2);
+  chunk[0].values = test::AsTensor<double>({1.0, 2.0});
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.WriteChunk(chunk)));
+
+  // Wrong row shape.
+  chunk = TestChunk(0, 2);
+  chunk[1].values = Tensor(DT_INT64, TensorShape({2, 3}));
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.WriteChunk(chunk)));
+
+  // Different numbers of rows.
+  chunk = TestChunk(0, 2);
+  chunk[0].values = test::AsTensor<float>({1.0f, 2.0f, 3.0f});
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.WriteChunk(chunk)));
+
+  // Row lengths that do not match the values.
+  chunk = TestChunk(0, 3);
+  chunk[2].row_lengths = test::AsTensor<int64>({0, 1, 1});
+  EXPECT_TRUE(errors::IsInvalidArgument(writer.WriteChunk(chunk)));
+
+  TF_EXPECT_OK(writer.WriteChunk(TestChunk(0, 3)));
+  TF_EXPECT_OK(writer.Finish());
+  EXPECT_TRUE(
+      errors::IsFailedPrecondition(writer.WriteChunk(TestChunk(3, 1))));
+}
+
+TEST(ColumnarTableTest, NotAColumnarTable) {
+  const string filename = TmpFile("not_a_columnar_table");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "garbage"));
+  ColumnarTableReader reader(Env::Default(), filename);
+  EXPECT_FALSE(reader.status().ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
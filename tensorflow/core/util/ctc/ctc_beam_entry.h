@@ -52,37 +52,12 @@ struct BeamProbability {
 
 template <class CTCBeamState = EmptyBeamState>
 struct BeamEntry {
-  // Default constructor does not create a vector of children.
+  // Entries are owned by the decoder. They cannot be copied and should not
+  // be moved, otherwise the parent pointers of their children become invalid.
+  // The children of an entry are not stored in the entry: the decoder looks
+  // them up by (parent, label).
   BeamEntry() : parent(nullptr), label(-1) {}
-  // Constructor giving parent, label, and number of children does
-  // create a vector of children.  The object pointed to by p
-  // cannot be copied and should not be moved, otherwise parent will
-  // become invalid.
-  BeamEntry(BeamEntry* p, int l, int L, int t) : parent(p), label(l) {
-    PopulateChildren(L);
-  }
   inline bool Active() const { return newp.total != kLogZero; }
-  inline bool HasChildren() const { return !children.empty(); }
-  void PopulateChildren(int L) {
-    CHECK(!HasChildren());
-    children = std::vector<BeamEntry>(L);
-    int ci = 0;
-    for (auto& c : children) {
-      // The current object cannot be copied, and should not be moved.
-      // Otherwise the child's parent will become invalid.
-      c.parent = this;
-      c.label = ci;
-      ++ci;
-    }
-  }
-  inline std::vector<BeamEntry>* Children() {
-    CHECK(HasChildren());
-    return &children;
-  }
-  inline const std::vector<BeamEntry>* Children() const {
-    CHECK(HasChildren());
-    return &children;
-  }
   std::vector<int> LabelSeq(bool merge_repeated) const {
     std::vector<int> labels;
     int prev_label = -1;
@@ -100,7 +75,6 @@ struct BeamEntry {
 
   BeamEntry<CTCBeamState>* parent;
   int label;
-  std::vector<BeamEntry<CTCBeamState>> children;
   BeamProbability oldp;
   BeamProbability newp;
   CTCBeamState state;
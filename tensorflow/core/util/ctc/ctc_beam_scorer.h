@@ -24,6 +24,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_CTC_CTC_BEAM_SCORER_H_
 #define TENSORFLOW_CORE_UTIL_CTC_CTC_BEAM_SCORER_H_
 
+#include <algorithm>
+
 #include "tensorflow/core/util/ctc/ctc_beam_entry.h"
 
 namespace tensorflow {
@@ -69,6 +71,71 @@ class BaseBeamScorer {
   }
 };
 
+// Beam state used by NgramBeamScorer.
+template <int kOrder>
+struct NgramBeamState {
+  // The last kOrder - 1 labels of the beam, oldest first. Beams with fewer
+  // labels are padded at the front with -1.
+  int context[kOrder - 1];
+  // The cached score of the last expansion of the beam.
+  float score;
+};
+
+// Beam scorer for an n-gram language model over the labels of order kOrder.
+// The beam state only holds the fixed size history the model conditions on,
+// so expanding a beam copies kOrder - 2 ints and makes a single model lookup,
+// which GetStateExpansionScore() then reuses at every later timestep.
+// Subclasses implement the model lookup in LogProbability(). The decoder may
+// call the scorer for many candidates at each timestep: label selection (see
+// CTCBeamSearchDecoder::SetLabelSelectionParameters) limits the lookups to
+// the most likely labels of the input.
+template <int kOrder>
+class NgramBeamScorer : public BaseBeamScorer<NgramBeamState<kOrder>> {
+  static_assert(kOrder >= 2, "n-gram models must be at least of order 2");
+
+ public:
+  typedef NgramBeamState<kOrder> State;
+
+  // The expansion of a beam with a label is scored as
+  //   lm_weight * log P(label | context) + insertion_bonus,
+  // and the end of the sequence as lm_weight * log P(end | context).
+  NgramBeamScorer(float lm_weight, float insertion_bonus)
+      : lm_weight_(lm_weight), insertion_bonus_(insertion_bonus) {}
+
+  // Returns the log-probability of label following the kOrder - 1 labels of
+  // context, oldest first and padded at the front with -1. label is -1 for
+  // the end of the sequence.
+  virtual float LogProbability(const int* context, int label) const = 0;
+
+  void InitializeState(State* root) const override {
+    std::fill(root->context, root->context + kOrder - 1, -1);
+    root->score = 0;
+  }
+  void ExpandState(const State& from_state, int from_label, State* to_state,
+                   int to_label) const override {
+    to_state->score =
+        lm_weight_ * LogProbability(from_state.context, to_label) +
+        insertion_bonus_;
+    std::copy(from_state.context + 1, from_state.context + kOrder - 1,
+              to_state->context);
+    to_state->context[kOrder - 2] = to_label;
+  }
+  void ExpandStateEnd(State* state) const override {
+    state->score = lm_weight_ * LogProbability(state->context, -1);
+  }
+  float GetStateExpansionScore(const State& state,
+                               float previous_score) const override {
+    return previous_score + state.score;
+  }
+  float GetStateEndExpansionScore(const State& state) const override {
+    return state.score;
+  }
+
+ private:
+  const float lm_weight_;
+  const float insertion_bonus_;
+};
+
 }  // namespace ctc
 }  // namespace tensorflow
 
@@ -17,11 +17,16 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_CTC_CTC_BEAM_SEARCH_H_
 
 #include <cmath>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <utility>
 
 #include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -86,6 +91,7 @@ class CTCBeamSearchDecoder : public CTCDecoder {
       : CTCDecoder(num_classes, batch_size, merge_repeated),
         beam_width_(beam_width),
         leaves_(beam_width),
+        beam_root_(nullptr),
         beam_scorer_(CHECK_NOTNULL(scorer)) {
     Reset();
   }
@@ -113,6 +119,14 @@ class CTCBeamSearchDecoder : public CTCDecoder {
     label_selection_margin_ = label_selection_margin;
   }
 
+  // Set the beam pruning threshold: a candidate whose log-probability is more
+  // than beam_threshold below that of the best candidate of the timestep is
+  // not added to the beam, even if the beam is not full. Default is to do no
+  // pruning.
+  void SetBeamThreshold(float beam_threshold) {
+    beam_threshold_ = beam_threshold;
+  }
+
   // Reset the beam search
   void Reset();
 
@@ -136,8 +150,30 @@ class CTCBeamSearchDecoder : public CTCDecoder {
   int label_selection_size_ = 0;       // zero means unlimited
   float label_selection_margin_ = -1;  // -1 means unlimited.
 
+  float beam_threshold_ = std::numeric_limits<float>::infinity();
+
+  // Returns an entry for the prefix of parent followed by label, reusing the
+  // entries allocated before the last Reset().
+  BeamEntry* NewEntry(BeamEntry* parent, int label);
+
+  typedef std::pair<const BeamEntry*, int> ChildKey;
+  struct ChildKeyHash {
+    size_t operator()(const ChildKey& key) const {
+      return Hash64Combine(reinterpret_cast<uintptr_t>(key.first), key.second);
+    }
+  };
+
   gtl::TopN<BeamEntry*, CTCBeamComparer> leaves_;
-  std::unique_ptr<BeamEntry> beam_root_;
+  BeamEntry* beam_root_;
+  // All the prefixes seen since the last Reset() live in entries_, of which
+  // the first num_entries_ are in use.  The deque never moves its elements,
+  // so the parent pointers stay valid as it grows.
+  std::deque<BeamEntry> entries_;
+  size_t num_entries_ = 0;
+  // Maps (parent, label) to the entry extending parent with label.  Children
+  // are only created once they enter the beam, rather than num_classes - 1 at
+  // a time for each expanded entry.
+  gtl::FlatMap<ChildKey, BeamEntry*, ChildKeyHash> children_;
   BaseBeamScorer<CTCBeamState>* beam_scorer_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
@@ -236,6 +272,9 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     b->oldp = b->newp;
   }
 
+  // The best total probability of the beam at this timestep, for pruning.
+  float best_total = kLogZero;
+
   for (BeamEntry* b : *branches) {
     if (b->parent != nullptr) {  // if not the root
       if (b->parent->Active()) {
@@ -258,6 +297,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     b->newp.blank = b->oldp.total + input(blank_index_);
     // P(l=abc @ t=6) = Plabel(l=abc @ t=6) + Pblank(l=abc @ t=6)
     b->newp.total = LogSumExp(b->newp.blank, b->newp.label);
+    best_total = std::max(best_total, b->newp.total);
 
     // Push the entry back to the top paths list.
     // Note, this will always fill leaves back up in sorted order.
@@ -269,76 +309,104 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // branches is in descending oldp order because it was
   // originally in descending newp order and we copied newp to oldp.
 
+  // A new leaf (represented by its BeamProbability) is a candidate
+  // iff its total probability is nonzero and within the beam threshold
+  // of the best entry, and either the beam list isn't full, or the
+  // lowest probability entry in the beam has a lower probability than
+  // the leaf.
+  auto is_candidate = [this, &best_total](const BeamProbability& prob) {
+    return (prob.total > kLogZero &&
+            prob.total >= best_total - beam_threshold_ &&
+            (leaves_.size() < beam_width_ ||
+             prob.total > leaves_.peek_bottom()->newp.total));
+  };
+
   // Grow new leaves
   for (BeamEntry* b : *branches) {
-    // A new leaf (represented by its BeamProbability) is a candidate
-    // iff its total probability is nonzero and either the beam list
-    // isn't full, or the lowest probability entry in the beam has a
-    // lower probability than the leaf.
-    auto is_candidate = [this](const BeamProbability& prob) {
-      return (prob.total > kLogZero &&
-              (leaves_.size() < beam_width_ ||
-               prob.total > leaves_.peek_bottom()->newp.total));
-    };
-
     if (!is_candidate(b->oldp)) {
       continue;
     }
 
-    if (!b->HasChildren()) {
-      b->PopulateChildren(num_classes_ - 1);
-    }
-
-    for (BeamEntry& c : *b->Children()) {
-      if (!c.Active()) {
-        // Perform label selection: if input for this label looks very
-        // unpromising, never evaluate it with a scorer.
-        if (input(c.label) < label_selection_input_min) {
-          continue;
+    for (int label = 0; label < num_classes_ - 1; ++label) {
+      // Perform label selection: if input for this label looks very
+      // unpromising, never evaluate it with a scorer.
+      if (input(label) < label_selection_input_min) {
+        continue;
+      }
+      // A child already in the beam was updated above.
+      auto child = children_.find(ChildKey(b, label));
+      BeamEntry* c = child == children_.end() ? nullptr : child->second;
+      if (c != nullptr && c->Active()) {
+        continue;
+      }
+      // The state is only stored in an entry if the child enters the beam.
+      CTCBeamState state;
+      beam_scorer_->ExpandState(b->state, b->label, &state, label);
+      //   Pblank(l=abcd @ t=6) = 0
+      // If new child label is identical to beam label:
+      //   Plabel(l=abcc @ t=6) = Pblank(l=abc @ t=5) * P(c @ 6)
+      // Otherwise:
+      //   Plabel(l=abcd @ t=6) = P(l=abc @ t=5) * P(d @ 6)
+      // P(l=abcd @ t=6) = Plabel(l=abcd @ t=6)
+      BeamProbability prob;
+      float previous = (label == b->label) ? b->oldp.blank : b->oldp.total;
+      prob.label =
+          input(label) + beam_scorer_->GetStateExpansionScore(state, previous);
+      prob.total = prob.label;
+
+      if (is_candidate(prob)) {
+        if (c == nullptr) {
+          c = NewEntry(b, label);
+          children_[ChildKey(b, label)] = c;
         }
-        //   Pblank(l=abcd @ t=6) = 0
-        c.newp.blank = kLogZero;
-        // If new child label is identical to beam label:
-        //   Plabel(l=abcc @ t=6) = Pblank(l=abc @ t=5) * P(c @ 6)
-        // Otherwise:
-        //   Plabel(l=abcd @ t=6) = P(l=abc @ t=5) * P(d @ 6)
-        beam_scorer_->ExpandState(b->state, b->label, &c.state, c.label);
-        float previous = (c.label == b->label) ? b->oldp.blank : b->oldp.total;
-        c.newp.label = input(c.label) +
-                       beam_scorer_->GetStateExpansionScore(c.state, previous);
-        // P(l=abcd @ t=6) = Plabel(l=abcd @ t=6)
-        c.newp.total = c.newp.label;
-
-        if (is_candidate(c.newp)) {
-          BeamEntry* bottom = leaves_.peek_bottom();
-          leaves_.push(&c);
-          if (leaves_.size() == beam_width_) {
-            // Bottom is no longer in the beam search.  Reset
-            // its probability; signal it's no longer in the beam search.
-            bottom->newp.Reset();
-          }
-        } else {
-          // Deactivate child (signal it's not in the beam)
-          c.oldp.Reset();
-          c.newp.Reset();
+        c->state = std::move(state);
+        c->newp = prob;
+        best_total = std::max(best_total, prob.total);
+        BeamEntry* bottom = leaves_.peek_bottom();
+        leaves_.push(c);
+        if (leaves_.size() == beam_width_) {
+          // Bottom is no longer in the beam search.  Reset
+          // its probability; signal it's no longer in the beam search.
+          bottom->newp.Reset();
         }
-      }  // if (!c.Active()) ...
-    }    // for (BeamEntry& c in children...
-  }      // for (BeamEntry* b...
+      } else if (c != nullptr) {
+        // Deactivate child (signal it's not in the beam)
+        c->oldp.Reset();
+        c->newp.Reset();
+      }
+    }  // for (int label...
+  }    // for (BeamEntry* b...
+}
+
+template <typename CTCBeamState, typename CTCBeamComparer>
+typename CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::BeamEntry*
+CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::NewEntry(
+    BeamEntry* parent, int label) {
+  if (num_entries_ == entries_.size()) {
+    entries_.emplace_back();
+  }
+  BeamEntry* entry = &entries_[num_entries_++];
+  entry->parent = parent;
+  entry->label = label;
+  entry->oldp.Reset();
+  entry->newp.Reset();
+  entry->state = CTCBeamState();
+  return entry;
 }
 
 template <typename CTCBeamState, typename CTCBeamComparer>
 void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   leaves_.Reset();
 
-  // This beam root, and all of its children, will be in memory until
-  // the next reset.
-  beam_root_.reset(new BeamEntry(nullptr, -1, num_classes_ - 1, -1));
+  // The entries of the previous search are kept allocated and reused.
+  num_entries_ = 0;
+  children_.clear_no_resize();
+  beam_root_ = NewEntry(nullptr, -1);
   beam_root_->newp.total = 0.0;  // ln(1)
   beam_root_->newp.blank = 0.0;  // ln(1)
 
   // Add the root as the initial leaf.
-  leaves_.push(beam_root_.get());
+  leaves_.push(beam_root_);
 
   // Call initialize state on the root object.
   beam_scorer_->InitializeState(&beam_root_->state);
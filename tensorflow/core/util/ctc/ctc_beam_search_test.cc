@@ -300,4 +300,112 @@ TEST(CtcBeamSearch, LabelSelection) {
   }
 }
 
+TEST(CtcBeamSearch, BeamThreshold) {
+  const int timesteps = 3;
+  const int num_classes = 4;
+  const int beam_width = 4;
+
+  CTCBeamSearchDecoder<>::DefaultBeamScorer default_scorer;
+  CTCBeamSearchDecoder<> decoder(num_classes, beam_width, &default_scorer);
+
+  // Label 0 is much more likely than label 1 at every timestep, and label 2
+  // is never emitted.
+  float input_data_mat[timesteps][num_classes] = {
+      {0.9, 0.09, 0.0001, 0.0099},
+      {0.9, 0.09, 0.0001, 0.0099},
+      {0.9, 0.09, 0.0001, 0.0099}};
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      input_data_mat[t][c] = std::log(input_data_mat[t][c]);
+    }
+  }
+
+  std::vector<std::vector<int>> default_paths;
+  std::vector<float> default_log_probs;
+  for (int t = 0; t < timesteps; ++t) {
+    decoder.Step(Eigen::Map<const Eigen::ArrayXf>(input_data_mat[t],
+                                                  num_classes));
+  }
+  EXPECT_TRUE(
+      decoder.TopPaths(beam_width, &default_paths, &default_log_probs, false)
+          .ok());
+
+  // With a threshold of 1.0, only the candidates within a factor e of the
+  // best one are kept in the beam, which is then not full.
+  decoder.Reset();
+  decoder.SetBeamThreshold(1.0);
+  for (int t = 0; t < timesteps; ++t) {
+    decoder.Step(Eigen::Map<const Eigen::ArrayXf>(input_data_mat[t],
+                                                  num_classes));
+  }
+  std::vector<std::vector<int>> paths;
+  std::vector<float> log_probs;
+  EXPECT_FALSE(decoder.TopPaths(beam_width, &paths, &log_probs, false).ok());
+  EXPECT_TRUE(decoder.TopPaths(1, &paths, &log_probs, false).ok());
+  EXPECT_EQ(default_paths[0], paths[0]);
+}
+
+// A bigram model over the labels which only allows sequences made of a
+// single label 3.
+class SingleThreeScorer : public tensorflow::ctc::NgramBeamScorer<2> {
+ public:
+  SingleThreeScorer() : tensorflow::ctc::NgramBeamScorer<2>(1.0, 0.0) {}
+
+  float LogProbability(const int* context, int label) const override {
+    if ((context[0] == -1 && label == 3) || (context[0] == 3 && label == -1)) {
+      return 0;
+    }
+    return std::log(0.01);
+  }
+};
+
+TEST(CtcBeamSearch, NgramScorer) {
+  const int batch_size = 1;
+  const int timesteps = 5;
+  const int top_paths = 3;
+  const int num_classes = 6;
+
+  SingleThreeScorer scorer;
+  CTCBeamSearchDecoder<SingleThreeScorer::State> decoder(
+      num_classes, 10 * top_paths, &scorer);
+
+  int sequence_lengths[batch_size] = {timesteps};
+  float input_data_mat[timesteps][batch_size][num_classes] = {
+      {{0, 0.6, 0, 0.4, 0, 0}},
+      {{0, 0.5, 0, 0.5, 0, 0}},
+      {{0, 0.4, 0, 0.6, 0, 0}},
+      {{0, 0.4, 0, 0.6, 0, 0}},
+      {{0, 0.4, 0, 0.6, 0, 0}}};
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      input_data_mat[t][0][c] = std::log(input_data_mat[t][0][c]);
+    }
+  }
+
+  // Without any additional scoring, the best paths are {1, 3}, {1, 3, 1} and
+  // {3, 1, 3}, see DecodingWithAndWithoutDictionary. The single 3 is now the
+  // best, and the model penalizes {1, 3} and {3, 1, 3} equally.
+  std::vector<CTCDecoder::Output> expected_output = {
+      {{3}, {1, 3}, {3, 1, 3}},
+  };
+
+  Eigen::Map<const Eigen::ArrayXi> seq_len(&sequence_lengths[0], batch_size);
+  std::vector<Eigen::Map<const Eigen::MatrixXf>> inputs;
+  for (int t = 0; t < timesteps; ++t) {
+    inputs.emplace_back(&input_data_mat[t][0][0], batch_size, num_classes);
+  }
+
+  std::vector<CTCDecoder::Output> outputs(top_paths);
+  for (CTCDecoder::Output& output : outputs) {
+    output.resize(batch_size);
+  }
+  float score[batch_size][top_paths] = {{0.0}};
+  Eigen::Map<Eigen::MatrixXf> scores(&score[0][0], batch_size, top_paths);
+
+  EXPECT_TRUE(decoder.Decode(seq_len, inputs, &outputs, &scores).ok());
+  for (int path = 0; path < top_paths; ++path) {
+    EXPECT_EQ(outputs[path][0], expected_output[0][path]);
+  }
+}
+
 }  // namespace
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
@@ -28,6 +30,22 @@ limitations under the License.
 #include "tensorflow/core/util/event.pb.h"
 
 namespace tensorflow {
+namespace {
+
+auto* async_events = monitoring::Counter<1>::New(
+    "/tensorflow/core/events_writer/async_events",
+    "The number of events queued by asynchronous EventsWriters, and of the "
+    "writes that blocked because the queue was full.",
+    "event");
+
+auto* async_wait_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/events_writer/async_wait_usecs",
+     "The time that writes to asynchronous EventsWriters blocked on a full "
+     "queue, and that flushes waited for the queued events to be written.",
+     "wait"},
+    monitoring::ExponentialBuckets(1.0, 2.0, 30));
+
+}  // namespace
 
 EventsWriter::EventsWriter(const string& file_prefix)
     // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
@@ -35,6 +53,37 @@ EventsWriter::EventsWriter(const string& file_prefix)
       file_prefix_(file_prefix),
       num_outstanding_events_(0) {}
 
+EventsWriter::EventsWriter(const string& file_prefix,
+                           const AsyncOptions& options)
+    : env_(Env::Default()),
+      file_prefix_(file_prefix),
+      num_outstanding_events_(0),
+      async_(true),
+      async_options_(options) {
+  writer_thread_.reset(env_->StartThread(ThreadOptions(), "events_writer",
+                                         [this]() { WriterLoop(); }));
+}
+
+EventsWriter::~EventsWriter() {
+  if (async_) {
+    {
+      mutex_lock l(queue_mu_);
+      stop_ = true;
+    }
+    queue_cv_.notify_all();
+    // Joins the thread once it has written the queued events.
+    writer_thread_.reset();
+  }
+  mutex_lock l(file_mu_);
+  CloseFile();  // Autoclose in destructor.
+}
+
+bool EventsWriter::InitWithSuffix(const string& suffix) {
+  mutex_lock l(file_mu_);
+  file_suffix_ = suffix;
+  return InitIfNeeded();
+}
+
 bool EventsWriter::InitIfNeeded() {
   if (recordio_writer_.get() != nullptr) {
     CHECK(!filename_.empty());
@@ -76,13 +125,27 @@ bool EventsWriter::InitIfNeeded() {
     Event event;
     event.set_wall_time(time_in_seconds);
     event.set_file_version(strings::StrCat(kVersionPrefix, kCurrentVersion));
-    WriteEvent(event);
-    Flush();
+    string record;
+    event.AppendToString(&record);
+    num_outstanding_events_++;
+    recordio_writer_->WriteRecord(record).IgnoreError();
+    FlushFile();
+  }
+  return true;
+}
+
+bool EventsWriter::OpenIfNeeded() {
+  if (recordio_writer_.get() == NULL) {
+    if (!InitIfNeeded()) {
+      LOG(ERROR) << "Write failed because file could not be opened.";
+      return false;
+    }
   }
   return true;
 }
 
 string EventsWriter::FileName() {
+  mutex_lock l(file_mu_);
   if (filename_.empty()) {
     InitIfNeeded();
   }
@@ -90,12 +153,40 @@ string EventsWriter::FileName() {
 }
 
 void EventsWriter::WriteSerializedEvent(StringPiece event_str) {
-  if (recordio_writer_.get() == NULL) {
-    if (!InitIfNeeded()) {
-      LOG(ERROR) << "Write failed because file could not be opened.";
-      return;
+  if (async_) {
+    static monitoring::CounterCell* queued_events =
+        async_events->GetCell("queued");
+    static monitoring::CounterCell* blocked_writes =
+        async_events->GetCell("blocked");
+    static monitoring::SamplerCell* queue_full_usecs =
+        async_wait_usecs->GetCell("queue_full");
+    mutex_lock l(queue_mu_);
+    auto queue_full = [this]() {
+      // An event larger than max_queued_bytes still goes into an empty
+      // queue.
+      const int num_events = queue_.size();
+      return num_events > 0 &&
+             (num_events >= async_options_.max_queued_events ||
+              queued_bytes_ >= async_options_.max_queued_bytes);
+    };
+    if (queue_full()) {
+      blocked_writes->IncrementBy(1);
+      const uint64 start_micros = env_->NowMicros();
+      while (queue_full() && !stop_) {
+        space_cv_.wait(l);
+      }
+      queue_full_usecs->Add(env_->NowMicros() - start_micros);
     }
+    queue_.push_back(event_str.ToString());
+    queued_bytes_ += event_str.size();
+    queued_events->IncrementBy(1);
+    if (queue_.size() == 1) {
+      queue_cv_.notify_one();
+    }
+    return;
   }
+  mutex_lock l(file_mu_);
+  if (!OpenIfNeeded()) return;
   num_outstanding_events_++;
   recordio_writer_->WriteRecord(event_str).IgnoreError();
 }
@@ -109,6 +200,12 @@ void EventsWriter::WriteEvent(const Event& event) {
 }
 
 bool EventsWriter::Flush() {
+  if (async_) return FlushQueue();
+  mutex_lock l(file_mu_);
+  return FlushFile();
+}
+
+bool EventsWriter::FlushFile() {
   if (num_outstanding_events_ == 0) return true;
   CHECK(recordio_file_.get() != NULL) << "Unexpected NULL file";
 
@@ -138,7 +235,13 @@ bool EventsWriter::Flush() {
 }
 
 bool EventsWriter::Close() {
-  bool return_value = Flush();
+  const bool queue_flushed = !async_ || FlushQueue();
+  mutex_lock l(file_mu_);
+  return CloseFile() && queue_flushed;
+}
+
+bool EventsWriter::CloseFile() {
+  bool return_value = FlushFile();
   if (recordio_file_.get() != NULL) {
     Status s = recordio_file_->Close();
     if (!s.ok()) {
@@ -164,4 +267,85 @@ bool EventsWriter::FileHasDisappeared() {
   }
 }
 
+bool EventsWriter::FlushQueue() {
+  static monitoring::SamplerCell* flush_usecs =
+      async_wait_usecs->GetCell("flush");
+  const uint64 start_micros = env_->NowMicros();
+  mutex_lock l(queue_mu_);
+  const int64 request = ++flush_requested_;
+  queue_cv_.notify_one();
+  while (flushed_ < request) {
+    flushed_cv_.wait(l);
+  }
+  flush_usecs->Add(env_->NowMicros() - start_micros);
+  return flush_ok_;
+}
+
+void EventsWriter::WriterLoop() {
+  const int64 interval_micros = async_options_.flush_interval_micros;
+  uint64 next_flush_micros = env_->NowMicros() + interval_micros;
+  // Only this thread updates flushed_.
+  int64 flushed = 0;
+  bool write_ok = true;
+  std::vector<string> batch;
+  for (;;) {
+    int64 flush_request;
+    bool stop;
+    {
+      mutex_lock l(queue_mu_);
+      while (queue_.empty() && flush_requested_ == flushed && !stop_) {
+        if (interval_micros <= 0) {
+          queue_cv_.wait(l);
+          continue;
+        }
+        const uint64 now_micros = env_->NowMicros();
+        if (now_micros >= next_flush_micros) break;
+        WaitForMilliseconds(&l, &queue_cv_,
+                            (next_flush_micros - now_micros + 999) / 1000);
+      }
+      batch.swap(queue_);
+      queued_bytes_ = 0;
+      flush_request = flush_requested_;
+      stop = stop_;
+    }
+    space_cv_.notify_all();
+
+    const uint64 now_micros = env_->NowMicros();
+    const bool flush =
+        stop || flush_request > flushed ||
+        (interval_micros > 0 && now_micros >= next_flush_micros);
+    bool flush_ok = true;
+    {
+      mutex_lock l(file_mu_);
+      if (!batch.empty()) {
+        // One Append() for the whole batch.
+        if (OpenIfNeeded()) {
+          num_outstanding_events_ += batch.size();
+          if (!recordio_writer_->WriteRecords(batch).ok()) {
+            LOG(ERROR) << "Failed to write " << batch.size() << " events to "
+                       << filename_;
+            write_ok = false;
+          }
+        } else {
+          write_ok = false;
+        }
+        batch.clear();
+      }
+      if (flush) {
+        flush_ok = FlushFile();
+      }
+    }
+    if (flush) {
+      next_flush_micros = now_micros + interval_micros;
+      flushed = flush_request;
+      mutex_lock l(queue_mu_);
+      flushed_ = flushed;
+      flush_ok_ = write_ok && flush_ok;
+      write_ok = true;
+      flushed_cv_.notify_all();
+    }
+    if (stop) return;
+  }
+}
+
 }  // namespace tensorflow
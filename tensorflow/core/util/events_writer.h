@@ -18,9 +18,12 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/event.pb.h"
 
@@ -43,7 +46,28 @@ class EventsWriter {
   // Note that it is not recommended to simultaneously have two
   // EventWriters writing to the same file_prefix.
   explicit EventsWriter(const string& file_prefix);
-  ~EventsWriter() { Close(); }  // Autoclose in destructor.
+
+#ifndef SWIG
+  // Options of an EventsWriter whose events are written to the file by a
+  // background thread rather than by the threads calling Write*().
+  struct AsyncOptions {
+    // The maximum number of events, and of their bytes, queued for the
+    // background thread. Write*() blocks while the queue is full.
+    int max_queued_events = 1024;
+    int64 max_queued_bytes = 64 << 20;
+    // How often the background thread flushes the file, or 0 to flush it
+    // only on Flush() and Close().
+    int64 flush_interval_micros = 10 * 1000 * 1000;
+  };
+
+  // Creates an EventsWriter whose Write*() only queue the events, which a
+  // background thread appends to the file in batches. Unlike the
+  // synchronous EventsWriter, it may be called from several threads.
+  // Flush() and Close() wait for the queued events to be written.
+  EventsWriter(const string& file_prefix, const AsyncOptions& options);
+#endif
+
+  ~EventsWriter();  // Autoclose in destructor.
 
   // Sets the event file filename and opens file for writing.  If not called by
   // user, will be invoked automatically by a call to FileName() or Write*().
@@ -52,10 +76,7 @@ class EventsWriter {
   // but has since disappeared (e.g. deleted by another process), this will open
   // a new file with a new timestamp in its filename.
   bool Init() { return InitWithSuffix(""); }
-  bool InitWithSuffix(const string& suffix) {
-    file_suffix_ = suffix;
-    return InitIfNeeded();
-  }
+  bool InitWithSuffix(const string& suffix);
 
   // Returns the filename for the current events file:
   // filename_ = [file_prefix_].out.events.[timestamp].[hostname][suffix]
@@ -81,16 +102,56 @@ class EventsWriter {
   bool Close();
 
  private:
-  bool FileHasDisappeared();  // True if event_file_path_ does not exist.
-  bool InitIfNeeded();
+#ifndef SWIG
+  // True if event_file_path_ does not exist.
+  bool FileHasDisappeared() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  bool InitIfNeeded() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  // Opens the file if no file is open. Returns false if it failed.
+  bool OpenIfNeeded() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  // The implementations of Flush() and Close() on the file.
+  bool FlushFile() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  bool CloseFile() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+
+  // The loop of writer_thread_.
+  void WriterLoop();
+  // Waits for writer_thread_ to write and flush the events queued so far.
+  // Returns false if any of them could not be written or flushed.
+  bool FlushQueue();
 
   Env* env_;
   const string file_prefix_;
-  string file_suffix_;
-  string filename_;
-  std::unique_ptr<WritableFile> recordio_file_;
-  std::unique_ptr<io::RecordWriter> recordio_writer_;
-  int num_outstanding_events_;
+
+  // Serializes the file operations, which are done by writer_thread_ in
+  // asynchronous mode.
+  mutex file_mu_;
+  string file_suffix_ GUARDED_BY(file_mu_);
+  string filename_ GUARDED_BY(file_mu_);
+  std::unique_ptr<WritableFile> recordio_file_ GUARDED_BY(file_mu_);
+  std::unique_ptr<io::RecordWriter> recordio_writer_ GUARDED_BY(file_mu_);
+  int num_outstanding_events_ GUARDED_BY(file_mu_);
+
+  // Asynchronous mode only.
+  const bool async_ = false;
+  AsyncOptions async_options_;
+  mutex queue_mu_;
+  // Signaled when events or a flush request are queued, or on stop.
+  condition_variable queue_cv_;
+  // Signaled when writer_thread_ takes the queued events.
+  condition_variable space_cv_;
+  // Signaled when writer_thread_ completes a flush.
+  condition_variable flushed_cv_;
+  std::vector<string> queue_ GUARDED_BY(queue_mu_);
+  int64 queued_bytes_ GUARDED_BY(queue_mu_) = 0;
+  // Flush requests are numbered from 1; flushed_ is the last one done.
+  int64 flush_requested_ GUARDED_BY(queue_mu_) = 0;
+  int64 flushed_ GUARDED_BY(queue_mu_) = 0;
+  // False if an event could not be written or the file could not be
+  // flushed, between the last two flushes by writer_thread_.
+  bool flush_ok_ GUARDED_BY(queue_mu_) = true;
+  bool stop_ GUARDED_BY(queue_mu_) = false;
+  std::unique_ptr<Thread> writer_thread_;
+#endif  // SWIG
+
   TF_DISALLOW_COPY_AND_ASSIGN(EventsWriter);
 };
 
@@ -190,6 +190,84 @@ TEST(EventWriter, NameClose) {
   TF_ASSERT_OK(env()->DeleteFile(filename));
 }
 
+TEST(EventWriter, AsyncWriteFlush) {
+  string file_prefix = GetDirName("/asyncwriteflush_test");
+  EventsWriter writer(file_prefix, EventsWriter::AsyncOptions());
+  WriteFile(&writer);
+  EXPECT_TRUE(writer.Flush());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncWriteDelete) {
+  string file_prefix = GetDirName("/asyncwritedelete_test");
+  EventsWriter* writer =
+      new EventsWriter(file_prefix, EventsWriter::AsyncOptions());
+  WriteFile(writer);
+  string filename = writer->FileName();
+  delete writer;
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncFullQueue) {
+  string file_prefix = GetDirName("/asyncfullqueue_test");
+  EventsWriter::AsyncOptions options;
+  options.max_queued_events = 1;
+  EventsWriter writer(file_prefix, options);
+  const int kNumThreads = 4;
+  const int kEventsPerThread = 100;
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumThreads; ++i) {
+      threads.emplace_back(
+          env()->StartThread(ThreadOptions(), "writer", [&writer, i]() {
+            for (int j = 0; j < kEventsPerThread; ++j) {
+              WriteSimpleValue(&writer, 1234, i * kEventsPerThread + j, "foo",
+                               j);
+            }
+          }));
+    }
+  }
+  EXPECT_TRUE(writer.Close());
+
+  std::unique_ptr<RandomAccessFile> event_file;
+  TF_ASSERT_OK(env()->NewRandomAccessFile(writer.FileName(), &event_file));
+  io::RecordReader reader(event_file.get());
+  uint64 offset = 0;
+  Event event;
+  ASSERT_TRUE(ReadEventProto(&reader, &offset, &event));
+  EXPECT_TRUE(event.has_file_version());
+  std::vector<bool> seen(kNumThreads * kEventsPerThread);
+  while (ReadEventProto(&reader, &offset, &event)) {
+    ASSERT_LT(event.step(), seen.size());
+    EXPECT_FALSE(seen[event.step()]);
+    seen[event.step()] = true;
+  }
+  EXPECT_EQ(std::vector<bool>(seen.size(), true), seen);
+}
+
+TEST(EventWriter, AsyncPeriodicFlush) {
+  string file_prefix = GetDirName("/asyncperiodicflush_test");
+  EventsWriter::AsyncOptions options;
+  options.flush_interval_micros = 1000;
+  EventsWriter writer(file_prefix, options);
+  WriteFile(&writer);
+  string filename = writer.FileName();
+  // The events are written without any call to Flush().
+  for (int i = 0; i < 1000; ++i) {
+    std::unique_ptr<RandomAccessFile> event_file;
+    TF_ASSERT_OK(env()->NewRandomAccessFile(filename, &event_file));
+    io::RecordReader reader(event_file.get());
+    uint64 offset = 0;
+    Event event;
+    int num_events = 0;
+    while (ReadEventProto(&reader, &offset, &event)) ++num_events;
+    if (num_events == 3) break;
+    env()->SleepForMicroseconds(10000);
+  }
+  VerifyFile(filename);
+}
+
 TEST(EventWriter, FileDeletionBeforeWriting) {
   string file_prefix = GetDirName("/fdbw_test");
   EventsWriter writer(file_prefix);
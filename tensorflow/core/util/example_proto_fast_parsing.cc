@@ -23,10 +23,12 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/casts.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/presized_cuckoo_map.h"
@@ -48,6 +50,81 @@ auto EnableAliasing(A* a) -> decltype(a->EnableAliasing(true), void()) {
 template <typename A>
 void EnableAliasing(A&& a) {}
 
+template <typename T>
+class LimitedArraySlice {
+ public:
+  LimitedArraySlice(T* begin, size_t num_elements)
+      : current_(begin), end_(begin + num_elements) {}
+
+  // May return negative if there were push_back calls after slice was filled.
+  int64 EndDistance() const { return end_ - current_; }
+
+  // Attempts to push value to the back of this. If the slice has
+  // already been filled, this method has no effect on the underlying data, but
+  // it changes the number returned by EndDistance into negative values.
+  void push_back(T&& value) {
+    if (EndDistance() > 0) *current_ = std::move(value);
+    ++current_;
+  }
+
+  // Attempts to push n values to the back of this, and returns where to
+  // write them.  Returns nullptr if they do not fit, with the same effect on
+  // EndDistance as n calls to push_back.
+  T* Grow(size_t n) {
+    T* values = EndDistance() >= static_cast<int64>(n) ? current_ : nullptr;
+    current_ += n;
+    return values;
+  }
+
+ private:
+  T* current_;
+  T* end_;
+};
+
+// Appends n values to the back of list, and returns where to write them, or
+// nullptr if they need not be written.
+template <typename T>
+T* Grow(SmallVector<T>* list, size_t n) {
+  const size_t size = list->size();
+  list->resize(size + n);
+  return list->data() + size;
+}
+
+template <typename T>
+T* Grow(LimitedArraySlice<T>* slice, size_t n) {
+  return slice->Grow(n);
+}
+
+// Decodes the n little-endian floats at src into dst.
+void DecodeFloats(const char* src, size_t n, float* dst) {
+  if (port::kLittleEndian) {
+    memcpy(dst, src, n * sizeof(float));
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = bit_cast<float>(core::DecodeFixed32(src + i * sizeof(float)));
+    }
+  }
+}
+
+// Decodes the varints in [src, end) into dst, which has room for all of
+// them.  Returns false if one of them is longer than 10 bytes.
+bool DecodeVarints(const uint8* src, const uint8* end, int64* dst) {
+  while (src < end) {
+    uint64 value = 0;
+    int shift = 0;
+    while (*src >= 0x80) {
+      value |= static_cast<uint64>(*src & 0x7f) << shift;
+      ++src;
+      shift += 7;
+      if (shift > 63) return false;
+    }
+    value |= static_cast<uint64>(*src) << shift;
+    ++src;
+    *dst++ = static_cast<int64>(value);
+  }
+  return true;
+}
+
 uint8 PeekTag(protobuf::io::CodedInputStream* stream) {
   DCHECK(stream != nullptr);
   const void* ptr;
@@ -139,15 +216,14 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          uint32 buffer32;
-          if (!stream.ReadLittleEndian32(&buffer32)) return false;
-          float_list->push_back(bit_cast<float>(buffer32));
-        }
-
-        stream.PopLimit(packed_limit);
+        if (packed_length % sizeof(float) != 0) return false;
+
+        // Copies the packed values at once rather than one at a time.
+        const char* packed = serialized_.data() + stream.CurrentPosition();
+        if (!stream.Skip(packed_length)) return false;
+        const size_t n = packed_length / sizeof(float);
+        float* values = Grow(float_list, n);
+        if (values != nullptr) DecodeFloats(packed, n, values);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kFixed32Tag(1))) return false;
@@ -181,15 +257,22 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        const uint8* packed = reinterpret_cast<const uint8*>(
+            serialized_.data() + stream.CurrentPosition());
+        if (!stream.Skip(packed_length)) return false;
+        const uint8* packed_end = packed + packed_length;
+        if (packed_length > 0 && packed_end[-1] >= 0x80) return false;
+        // Each varint ends with the only one of its bytes that has its high
+        // bit clear, so this counts the values in a vectorizable loop.
+        size_t n = 0;
+        for (const uint8* p = packed; p < packed_end; ++p) {
+          n += *p < 0x80;
+        }
+        int64* values = Grow(int64_list, n);
+        if (values != nullptr && !DecodeVarints(packed, packed_end, values)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -425,30 +508,8 @@ struct SeededHasher {
   uint64 seed{0xDECAFCAFFE};
 };
 
-template <typename T>
-class LimitedArraySlice {
- public:
-  LimitedArraySlice(T* begin, size_t num_elements)
-      : current_(begin), end_(begin + num_elements) {}
-
-  // May return negative if there were push_back calls after slice was filled.
-  int64 EndDistance() const { return end_ - current_; }
-
-  // Attempts to push value to the back of this. If the slice has
-  // already been filled, this method has no effect on the underlying data, but
-  // it changes the number returned by EndDistance into negative values.
-  void push_back(T&& value) {
-    if (EndDistance() > 0) *current_ = std::move(value);
-    ++current_;
-  }
-
- private:
-  T* current_;
-  T* end_;
-};
-
 Status FastParseSerializedExample(
-    const string& serialized_example, const string& example_name,
+    StringPiece serialized_example, const string& example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
     SeededHasher hasher, std::vector<Tensor>* output_dense,
@@ -833,12 +894,13 @@ void FillAndCopyVarLen(
   }
 }
 
-}  // namespace
-
-Status FastParseExample(const Config& config,
-                        gtl::ArraySlice<string> serialized,
-                        gtl::ArraySlice<string> example_names,
-                        thread::ThreadPool* thread_pool, Result* result) {
+// Implements FastParseExample() for the serialized examples held by string
+// or StringPiece.
+template <typename T>
+Status FastParseExampleImpl(const Config& config,
+                            gtl::ArraySlice<T> serialized,
+                            gtl::ArraySlice<string> example_names,
+                            thread::ThreadPool* thread_pool, Result* result) {
   DCHECK(result != nullptr);
   // Check config so we can safely CHECK(false) in switches on config.*.dtype
   for (auto& c : config.sparse) {
@@ -905,8 +967,14 @@ Status FastParseExample(const Config& config,
       }
     }
     // 'special logic'
-    const size_t min_minibatches = std::min<size_t>(8, serialized.size());
-    const size_t max_minibatches = 64;
+    // Without a thread pool the minibatches run one after the other, so a
+    // single one avoids merging buffers. Otherwise there are enough to keep
+    // every thread busy, but not so many that their buffers dominate.
+    if (thread_pool == nullptr) return std::min<size_t>(1, result);
+    const size_t num_threads = thread_pool->NumThreads() + 1;
+    const size_t min_minibatches =
+        std::min<size_t>(num_threads, serialized.size());
+    const size_t max_minibatches = 4 * num_threads;
     return std::max<size_t>(min_minibatches,
                             std::min<size_t>(max_minibatches, result));
   }();
@@ -1098,5 +1166,23 @@ Status FastParseExample(const Config& config,
   return Status::OK();
 }
 
+}  // namespace
+
+Status FastParseExample(const Config& config,
+                        gtl::ArraySlice<string> serialized,
+                        gtl::ArraySlice<string> example_names,
+                        thread::ThreadPool* thread_pool, Result* result) {
+  return FastParseExampleImpl(config, serialized, example_names, thread_pool,
+                              result);
+}
+
+Status FastParseExample(const Config& config,
+                        gtl::ArraySlice<StringPiece> serialized,
+                        gtl::ArraySlice<string> example_names,
+                        thread::ThreadPool* thread_pool, Result* result) {
+  return FastParseExampleImpl(config, serialized, example_names, thread_pool,
+                              result);
+}
+
 }  // namespace example
 }  // namespace tensorflow
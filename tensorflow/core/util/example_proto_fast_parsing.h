@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
@@ -79,6 +80,13 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         gtl::ArraySlice<string> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
+// Same as above, for serialized examples that are not held by strings, such
+// as records read in place from a memory-mapped file.
+Status FastParseExample(const FastParseExampleConfig& config,
+                        gtl::ArraySlice<StringPiece> serialized,
+                        gtl::ArraySlice<string> example_names,
+                        thread::ThreadPool* thread_pool, Result* result);
+
 // This function parses serialized Example and populates given example.
 // It uses the same specialized parser as FastParseExample which is efficient.
 // But then constructs Example which is relatively slow.
@@ -15,6 +15,8 @@ limitations under the License.
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
 #include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -165,6 +167,27 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedLists) {
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  auto* floats = features["floats"].mutable_float_list();
+  auto* int64s = features["int64s"].mutable_int64_list();
+  for (int i = 0; i < 100; ++i) {
+    floats->add_value(i * 0.25f - 3.0f);
+    // Varints of 1 to 9 bytes, and of 10 for the negative values.
+    int64s->add_value(i % 2 == 0 ? (int64{1} << (i % 63)) : -i);
+  }
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  Example fast_example;
+  // The last varint of the packed int64 list has no final byte.
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01\x8d",
+      &fast_example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -371,6 +394,43 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, StringPieces) {
+  std::vector<string> serialized(3);
+  for (int i = 0; i < serialized.size(); ++i) {
+    Example example;
+    (*example.mutable_features()->mutable_feature())["age"]
+        .mutable_int64_list()
+        ->add_value(10 * i);
+    example.SerializeToString(&serialized[i]);
+  }
+  // The pieces point into a single buffer, as records of a mapped file do.
+  const string buffer = strings::StrCat(serialized[0], serialized[1],
+                                        serialized[2]);
+  std::vector<StringPiece> pieces;
+  size_t offset = 0;
+  for (const string& s : serialized) {
+    pieces.emplace_back(buffer.data() + offset, s.size());
+    offset += s.size();
+  }
+
+  FastParseExampleConfig config;
+  config.sparse.push_back({"age", DT_INT64});
+  Result from_strings;
+  TF_EXPECT_OK(FastParseExample(config, serialized, gtl::ArraySlice<string>(),
+                                nullptr, &from_strings));
+  Result from_pieces;
+  TF_EXPECT_OK(FastParseExample(config, pieces, gtl::ArraySlice<string>(),
+                                nullptr, &from_pieces));
+
+  ASSERT_EQ(1, from_pieces.sparse_values.size());
+  test::ExpectTensorEqual<int64>(from_strings.sparse_values[0],
+                                 from_pieces.sparse_values[0]);
+  test::ExpectTensorEqual<int64>(from_strings.sparse_indices[0],
+                                 from_pieces.sparse_indices[0]);
+  test::ExpectTensorEqual<int64>(
+      test::AsTensor<int64>({0, 10, 20}), from_pieces.sparse_values[0]);
+}
+
 }  // namespace
 
 }  // namespace example
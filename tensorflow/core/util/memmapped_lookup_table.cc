@@ -0,0 +1,289 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/memmapped_lookup_table.h"
+
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+namespace {
+
+// The file starts with a Header, followed by the keys section at keys_offset
+// and the values section at values_offset.  Every section starts at a
+// multiple of kAlignment.
+//
+// A section of int64 is the array of the num_entries elements.  A section of
+// strings is the array of the num_entries + 1 offsets described in
+// MemmappedLookupTable::StringColumn, followed by the bytes of the strings,
+// padded up to kAlignment.  A keys section of strings is preceded by the
+// array of the Hash64 of each key.
+constexpr char kMagic[8] = {'T', 'F', 'M', 'M', 'L', 'K', 'U', '1'};
+constexpr uint64 kAlignment = sizeof(uint64);
+
+struct Header {
+  char magic[8];
+  int32 key_dtype;
+  int32 value_dtype;
+  uint64 num_entries;
+  uint64 keys_offset;
+  uint64 values_offset;
+};
+
+uint64 AlignUp(uint64 n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+uint64 HashKey(StringPiece key) { return Hash64(key.data(), key.size()); }
+
+bool IsSupportedDataType(DataType dtype) {
+  return dtype == DT_INT64 || dtype == DT_STRING;
+}
+
+// Returns the number of bytes of the section of `column`, which is a keys
+// section if `hashed`.
+uint64 SectionSize(const Tensor& column, bool hashed) {
+  const int64 n = column.NumElements();
+  if (column.dtype() == DT_INT64) {
+    return n * sizeof(int64);
+  }
+  const auto flat = column.flat<string>();
+  uint64 bytes = 0;
+  for (int64 i = 0; i < n; ++i) {
+    bytes += flat(i).size();
+  }
+  return (hashed ? n : 0) * sizeof(uint64) + (n + 1) * sizeof(uint64) +
+         AlignUp(bytes);
+}
+
+template <typename T>
+Status AppendArray(const std::vector<T>& array, WritableFile* file) {
+  return file->Append(StringPiece(reinterpret_cast<const char*>(array.data()),
+                                  array.size() * sizeof(T)));
+}
+
+// Writes the elements of `column` in the given order as a section.
+Status WriteSection(const Tensor& column, const std::vector<int64>& order,
+                    const std::vector<uint64>* hashes, WritableFile* file) {
+  if (column.dtype() == DT_INT64) {
+    const auto flat = column.flat<int64>();
+    std::vector<int64> values(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      values[i] = flat(order[i]);
+    }
+    return AppendArray(values, file);
+  }
+  const auto flat = column.flat<string>();
+  if (hashes != nullptr) {
+    std::vector<uint64> sorted_hashes(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      sorted_hashes[i] = (*hashes)[order[i]];
+    }
+    TF_RETURN_IF_ERROR(AppendArray(sorted_hashes, file));
+  }
+  std::vector<uint64> offsets(order.size() + 1, 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    offsets[i + 1] = offsets[i] + flat(order[i]).size();
+  }
+  TF_RETURN_IF_ERROR(AppendArray(offsets, file));
+  for (int64 i : order) {
+    TF_RETURN_IF_ERROR(file->Append(flat(i)));
+  }
+  const uint64 padding = AlignUp(offsets.back()) - offsets.back();
+  return file->Append(StringPiece("\0\0\0\0\0\0\0\0", padding));
+}
+
+// Checks that a section of `n` elements of `dtype` fits in the `length` bytes
+// of `data` at `offset`, and points `array` at its int64 elements, or
+// `hashes` (if not null), `offsets` and `bytes` at its string elements.
+Status MapSection(const char* data, uint64 length, uint64 offset, int64 n,
+                  DataType dtype, const int64** array, const uint64** hashes,
+                  const uint64** offsets, const char** bytes) {
+  if (offset % kAlignment != 0 || offset > length) {
+    return errors::DataLoss("Invalid section offset ", offset);
+  }
+  uint64 available = length - offset;
+  const char* section = data + offset;
+  if (dtype == DT_INT64) {
+    if (available / sizeof(int64) < static_cast<uint64>(n)) {
+      return errors::DataLoss("Truncated section at offset ", offset);
+    }
+    *array = reinterpret_cast<const int64*>(section);
+    return Status::OK();
+  }
+  const uint64 num_words = (hashes != nullptr ? n : 0) + n + 1;
+  if (available / sizeof(uint64) < num_words) {
+    return errors::DataLoss("Truncated section at offset ", offset);
+  }
+  if (hashes != nullptr) {
+    *hashes = reinterpret_cast<const uint64*>(section);
+    section += n * sizeof(uint64);
+  }
+  *offsets = reinterpret_cast<const uint64*>(section);
+  section += (n + 1) * sizeof(uint64);
+  available -= num_words * sizeof(uint64);
+  if ((*offsets)[0] != 0) {
+    return errors::DataLoss("Invalid string offsets at offset ", offset);
+  }
+  for (int64 i = 0; i < n; ++i) {
+    if ((*offsets)[i + 1] < (*offsets)[i]) {
+      return errors::DataLoss("Invalid string offsets at offset ", offset);
+    }
+  }
+  if ((*offsets)[n] > available) {
+    return errors::DataLoss("Truncated section at offset ", offset);
+  }
+  *bytes = section;
+  return Status::OK();
+}
+
+}  // namespace
+
+Status WriteMemmappedLookupTable(Env* env, const string& filename,
+                                 const Tensor& keys, const Tensor& values) {
+  if (!IsSupportedDataType(keys.dtype()) ||
+      !IsSupportedDataType(values.dtype())) {
+    return errors::InvalidArgument(
+        "Keys and values must be int64 or string, got ",
+        DataTypeString(keys.dtype()), " and ", DataTypeString(values.dtype()));
+  }
+  if (!TensorShapeUtils::IsVector(keys.shape()) ||
+      !keys.shape().IsSameSize(values.shape())) {
+    return errors::InvalidArgument(
+        "Keys and values must be vectors of the same size, got ",
+        keys.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+  const int64 n = keys.NumElements();
+
+  std::vector<int64> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<uint64> hashes;
+  if (keys.dtype() == DT_INT64) {
+    const auto flat = keys.flat<int64>();
+    std::sort(order.begin(), order.end(),
+              [&flat](int64 a, int64 b) { return flat(a) < flat(b); });
+    for (int64 i = 1; i < n; ++i) {
+      if (flat(order[i - 1]) == flat(order[i])) {
+        return errors::InvalidArgument("Duplicate key ", flat(order[i]));
+      }
+    }
+  } else {
+    const auto flat = keys.flat<string>();
+    hashes.resize(n);
+    for (int64 i = 0; i < n; ++i) {
+      hashes[i] = HashKey(flat(i));
+    }
+    std::sort(order.begin(), order.end(), [&flat, &hashes](int64 a, int64 b) {
+      return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : flat(a) < flat(b);
+    });
+    for (int64 i = 1; i < n; ++i) {
+      if (flat(order[i - 1]) == flat(order[i])) {
+        return errors::InvalidArgument("Duplicate key ", flat(order[i]));
+      }
+    }
+  }
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.key_dtype = keys.dtype();
+  header.value_dtype = values.dtype();
+  header.num_entries = n;
+  header.keys_offset = AlignUp(sizeof(Header));
+  header.values_offset =
+      header.keys_offset + SectionSize(keys, /*hashed=*/true);
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(&header), sizeof(header))));
+  TF_RETURN_IF_ERROR(WriteSection(
+      keys, order, keys.dtype() == DT_STRING ? &hashes : nullptr, file.get()));
+  TF_RETURN_IF_ERROR(WriteSection(values, order, nullptr, file.get()));
+  return file->Close();
+}
+
+Status MemmappedLookupTable::Open(
+    Env* env, const string& filename,
+    std::unique_ptr<MemmappedLookupTable>* table) {
+  std::unique_ptr<MemmappedLookupTable> result(new MemmappedLookupTable);
+  TF_RETURN_IF_ERROR(
+      env->NewReadOnlyMemoryRegionFromFile(filename, &result->region_));
+  const char* data = static_cast<const char*>(result->region_->data());
+  const uint64 length = result->region_->length();
+
+  Header header;
+  if (length < sizeof(header)) {
+    return errors::DataLoss("File ", filename,
+                            " is too short for a lookup table");
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return errors::DataLoss("File ", filename, " is not a lookup table");
+  }
+  result->key_dtype_ = static_cast<DataType>(header.key_dtype);
+  result->value_dtype_ = static_cast<DataType>(header.value_dtype);
+  if (!IsSupportedDataType(result->key_dtype_) ||
+      !IsSupportedDataType(result->value_dtype_)) {
+    return errors::DataLoss("Invalid key or value dtype in ", filename);
+  }
+  if (header.num_entries > length / sizeof(uint64)) {
+    return errors::DataLoss("Invalid number of entries in ", filename);
+  }
+  result->size_ = header.num_entries;
+
+  Status s = MapSection(data, length, header.keys_offset, result->size_,
+                        result->key_dtype_, &result->int64_keys_,
+                        &result->key_hashes_, &result->string_keys_.offsets,
+                        &result->string_keys_.data);
+  if (s.ok()) {
+    s = MapSection(data, length, header.values_offset, result->size_,
+                   result->value_dtype_, &result->int64_values_, nullptr,
+                   &result->string_values_.offsets,
+                   &result->string_values_.data);
+  }
+  if (!s.ok()) {
+    return errors::DataLoss("Invalid lookup table in ", filename, ": ",
+                            s.error_message());
+  }
+  *table = std::move(result);
+  return Status::OK();
+}
+
+int64 MemmappedLookupTable::Find(int64 key) const {
+  const int64* end = int64_keys_ + size_;
+  const int64* it = std::lower_bound(int64_keys_, end, key);
+  return it != end && *it == key ? it - int64_keys_ : -1;
+}
+
+int64 MemmappedLookupTable::Find(StringPiece key) const {
+  const uint64 hash = HashKey(key);
+  const uint64* end = key_hashes_ + size_;
+  for (const uint64* it = std::lower_bound(key_hashes_, end, hash);
+       it != end && *it == hash; ++it) {
+    const int64 i = it - key_hashes_;
+    if (string_keys_.Get(i) == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace tensorflow
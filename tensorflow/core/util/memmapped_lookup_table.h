@@ -0,0 +1,117 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A file format for immutable lookup tables that are served directly from a
+// memory-mapped file.
+//
+// The file holds the keys of the table sorted, followed by the values in the
+// same order, so that opening a table only maps the file and checks its
+// layout, and a lookup is a binary search over the mapped keys.  String keys
+// are sorted by their Hash64 first, and the search runs over the array of
+// hashes, comparing key bytes only for the entries that have the same hash.
+//
+// Keys are int64 or string, and so are values.  All integers are stored in
+// host byte order, as in the format of MemmappedFileSystem.
+//
+// Usage:
+//   TF_RETURN_IF_ERROR(WriteMemmappedLookupTable(env, filename, keys, values));
+//
+//   std::unique_ptr<MemmappedLookupTable> table;
+//   TF_RETURN_IF_ERROR(MemmappedLookupTable::Open(env, filename, &table));
+//   const int64 i = table->Find(StringPiece("word"));
+//   if (i >= 0) id = table->int64_value(i);
+
+#ifndef TENSORFLOW_CORE_UTIL_MEMMAPPED_LOOKUP_TABLE_H_
+#define TENSORFLOW_CORE_UTIL_MEMMAPPED_LOOKUP_TABLE_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Writes the table that maps each element of the vector `keys` to the element
+// of the vector `values` at the same index to `filename`.  Keys and values
+// must be of type int64 or string, and keys must be unique.
+Status WriteMemmappedLookupTable(Env* env, const string& filename,
+                                 const Tensor& keys, const Tensor& values);
+
+// A table written by WriteMemmappedLookupTable, mapped into memory.
+// Thread-safe.
+class MemmappedLookupTable {
+ public:
+  // Maps the table in `filename` into memory, and checks its layout.
+  static Status Open(Env* env, const string& filename,
+                     std::unique_ptr<MemmappedLookupTable>* table);
+
+  DataType key_dtype() const { return key_dtype_; }
+  DataType value_dtype() const { return value_dtype_; }
+
+  // The number of entries of the table.
+  int64 size() const { return size_; }
+
+  // The number of bytes of the mapped file.
+  uint64 length() const { return region_->length(); }
+
+  // Returns the index of the entry of `key`, or -1 if there is none.  Only
+  // the overload of the key dtype of the table may be called.
+  int64 Find(int64 key) const;
+  int64 Find(StringPiece key) const;
+
+  // Accessors of the key and value of entry `i`, for 0 <= i < size().  Only
+  // the accessors of the dtypes of the table may be called.
+  int64 int64_key(int64 i) const { return int64_keys_[i]; }
+  StringPiece string_key(int64 i) const { return string_keys_.Get(i); }
+  int64 int64_value(int64 i) const { return int64_values_[i]; }
+  StringPiece string_value(int64 i) const { return string_values_.Get(i); }
+
+ private:
+  // A column of strings: the bytes of all strings concatenated, and the
+  // offset of each string in them followed by their total length.
+  struct StringColumn {
+    const uint64* offsets = nullptr;
+    const char* data = nullptr;
+
+    StringPiece Get(int64 i) const {
+      return StringPiece(data + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+  };
+
+  MemmappedLookupTable() {}
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  DataType key_dtype_ = DT_INVALID;
+  DataType value_dtype_ = DT_INVALID;
+  int64 size_ = 0;
+
+  const int64* int64_keys_ = nullptr;
+  const uint64* key_hashes_ = nullptr;
+  StringColumn string_keys_;
+  const int64* int64_values_ = nullptr;
+  StringColumn string_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedLookupTable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_MEMMAPPED_LOOKUP_TABLE_H_
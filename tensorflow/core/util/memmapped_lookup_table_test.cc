@@ -0,0 +1,122 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/memmapped_lookup_table.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TablePath(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(MemmappedLookupTableTest, StringToInt64) {
+  const string filename = TablePath("string_to_int64");
+  Tensor keys = test::AsTensor<string>({"brain", "salad", "surgery", ""});
+  Tensor values = test::AsTensor<int64>({0, 1, 2, 3});
+  TF_ASSERT_OK(
+      WriteMemmappedLookupTable(Env::Default(), filename, keys, values));
+
+  std::unique_ptr<MemmappedLookupTable> table;
+  TF_ASSERT_OK(MemmappedLookupTable::Open(Env::Default(), filename, &table));
+  EXPECT_EQ(DT_STRING, table->key_dtype());
+  EXPECT_EQ(DT_INT64, table->value_dtype());
+  ASSERT_EQ(4, table->size());
+  for (int64 i = 0; i < keys.NumElements(); ++i) {
+    const int64 index = table->Find(keys.flat<string>()(i));
+    ASSERT_GE(index, 0);
+    EXPECT_EQ(keys.flat<string>()(i), table->string_key(index));
+    EXPECT_EQ(i, table->int64_value(index));
+  }
+  EXPECT_EQ(-1, table->Find(StringPiece("tank")));
+  EXPECT_EQ(-1, table->Find(StringPiece("brains")));
+}
+
+TEST(MemmappedLookupTableTest, Int64ToString) {
+  const string filename = TablePath("int64_to_string");
+  Tensor keys = test::AsTensor<int64>({42, -7, 1LL << 40, 0});
+  Tensor values = test::AsTensor<string>({"a", "", "ccc", "dd"});
+  TF_ASSERT_OK(
+      WriteMemmappedLookupTable(Env::Default(), filename, keys, values));
+
+  std::unique_ptr<MemmappedLookupTable> table;
+  TF_ASSERT_OK(MemmappedLookupTable::Open(Env::Default(), filename, &table));
+  ASSERT_EQ(4, table->size());
+  // The keys are sorted.
+  EXPECT_EQ(-7, table->int64_key(0));
+  EXPECT_EQ(0, table->int64_key(1));
+  EXPECT_EQ(42, table->int64_key(2));
+  EXPECT_EQ(1LL << 40, table->int64_key(3));
+  EXPECT_EQ("a", table->string_value(table->Find(42)));
+  EXPECT_EQ("", table->string_value(table->Find(-7)));
+  EXPECT_EQ("ccc", table->string_value(table->Find(1LL << 40)));
+  EXPECT_EQ("dd", table->string_value(table->Find(0)));
+  EXPECT_EQ(-1, table->Find(1));
+  EXPECT_EQ(-1, table->Find(100));
+}
+
+TEST(MemmappedLookupTableTest, Empty) {
+  const string filename = TablePath("empty");
+  TF_ASSERT_OK(WriteMemmappedLookupTable(Env::Default(), filename,
+                                         Tensor(DT_STRING, TensorShape({0})),
+                                         Tensor(DT_INT64, TensorShape({0}))));
+  std::unique_ptr<MemmappedLookupTable> table;
+  TF_ASSERT_OK(MemmappedLookupTable::Open(Env::Default(), filename, &table));
+  EXPECT_EQ(0, table->size());
+  EXPECT_EQ(-1, table->Find(StringPiece("a")));
+}
+
+TEST(MemmappedLookupTableTest, InvalidInputs) {
+  const string filename = TablePath("invalid");
+  EXPECT_TRUE(errors::IsInvalidArgument(WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<string>({"a", "b", "a"}),
+      test::AsTensor<int64>({0, 1, 2}))));
+  EXPECT_TRUE(errors::IsInvalidArgument(WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<string>({"a", "b"}),
+      test::AsTensor<int64>({0}))));
+  EXPECT_TRUE(errors::IsInvalidArgument(WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<string>({"a"}),
+      test::AsTensor<float>({0.5}))));
+}
+
+TEST(MemmappedLookupTableTest, CorruptFile) {
+  const string filename = TablePath("table");
+  TF_ASSERT_OK(WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<string>({"a", "bb", "ccc"}),
+      test::AsTensor<string>({"x", "y", "z"})));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+
+  const string truncated = TablePath("truncated");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), truncated,
+                                 contents.substr(0, contents.size() - 16)));
+  std::unique_ptr<MemmappedLookupTable> table;
+  EXPECT_TRUE(errors::IsDataLoss(
+      MemmappedLookupTable::Open(Env::Default(), truncated, &table)));
+
+  const string bad_magic = TablePath("bad_magic");
+  contents[0] = 'X';
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), bad_magic, contents));
+  EXPECT_TRUE(errors::IsDataLoss(
+      MemmappedLookupTable::Open(Env::Default(), bad_magic, &table)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -115,5 +115,28 @@ TEST(TestReporter, Benchmark) {
   EXPECT_EQ(benchmark_entry.throughput(), 3.0);
 }
 
+TEST(TestReporter, SetProperty) {
+  string fname =
+      strings::StrCat(testing::TmpDir(), "/test_reporter_property_");
+  TestReporter test_reporter(fname, "b2/3/4");
+  TF_EXPECT_OK(test_reporter.Initialize());
+  TF_EXPECT_OK(test_reporter.SetProperty("items_per_second", 5.0));
+  TF_EXPECT_OK(test_reporter.SetProperty("label", "small"));
+  TF_EXPECT_OK(test_reporter.Close());
+
+  string expected_fname = strings::StrCat(fname, "b2__3__4");
+  string read;
+  TF_EXPECT_OK(ReadFileToString(Env::Default(), expected_fname, &read));
+
+  BenchmarkEntries benchmark_entries;
+  ASSERT_TRUE(benchmark_entries.ParseFromString(read));
+  ASSERT_EQ(1, benchmark_entries.entry_size());
+  const BenchmarkEntry& benchmark_entry = benchmark_entries.entry(0);
+  const auto& extras = benchmark_entry.extras();
+  ASSERT_EQ(2, extras.size());
+  EXPECT_EQ(5.0, extras.at("items_per_second").double_value());
+  EXPECT_EQ("small", extras.at("label").string_value());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,214 @@
+/* Copyright 2015 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/sparse/sparse_tensor.h"
+
+#include <functional>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+
+namespace tensorflow {
+namespace sparse {
+
+namespace {
+
+// Below this many rows per shard, the cost of scheduling a shard outweighs
+// the work it does.
+constexpr int64 kMinRowsPerShard = 16384;
+
+// The radix sort consumes the keys this many bits at a time.
+constexpr int kRadixBits = 8;
+constexpr int kRadix = 1 << kRadixBits;
+
+// Runs fn(shard) for every shard in [0, num_shards), shard 0 on the calling
+// thread, and returns when they are all done.
+void RunShards(thread::ThreadPool* pool, int num_shards,
+               const std::function<void(int)>& fn) {
+  if (num_shards == 1) {
+    fn(0);
+    return;
+  }
+  BlockingCounter counter(num_shards - 1);
+  for (int shard = 1; shard < num_shards; ++shard) {
+    pool->Schedule([&fn, &counter, shard]() {
+      fn(shard);
+      counter.DecrementCount();
+    });
+  }
+  fn(0);
+  counter.Wait();
+}
+
+// Sorts *perm, with (*keys)[n] the key of (*perm)[n], by increasing key.
+// For each digit, every shard counts the digits of its rows, then scatters
+// them to the positions given by the counts of the lower digits and of the
+// earlier shards, which keeps the sort stable.
+void RadixSort(int64 max_key, thread::ThreadPool* pool, int num_shards,
+               std::vector<int64>* keys, std::vector<int64>* perm) {
+  const int64 N = keys->size();
+  int key_bits = 0;
+  while (key_bits < 63 && (max_key >> key_bits) != 0) ++key_bits;
+
+  std::vector<int64> other_keys(N);
+  std::vector<int64> other_perm(N);
+  std::vector<int64> offsets(num_shards * kRadix);
+  for (int shift = 0; shift < key_bits; shift += kRadixBits) {
+    const int64* from_keys = keys->data();
+    const int64* from_perm = perm->data();
+    std::fill(offsets.begin(), offsets.end(), 0);
+    RunShards(pool, num_shards, [&](int shard) {
+      int64* counts = &offsets[shard * kRadix];
+      for (int64 n = N * shard / num_shards;
+           n < N * (shard + 1) / num_shards; ++n) {
+        ++counts[(from_keys[n] >> shift) & (kRadix - 1)];
+      }
+    });
+
+    // Turn the counts into starting positions, skipping the pass entirely
+    // when all the rows share this digit.
+    bool single_digit = false;
+    int64 position = 0;
+    for (int digit = 0; digit < kRadix; ++digit) {
+      const int64 digit_start = position;
+      for (int shard = 0; shard < num_shards; ++shard) {
+        const int64 count = offsets[shard * kRadix + digit];
+        offsets[shard * kRadix + digit] = position;
+        position += count;
+      }
+      if (position - digit_start == N) single_digit = true;
+    }
+    if (single_digit) continue;
+
+    int64* to_keys = other_keys.data();
+    int64* to_perm = other_perm.data();
+    RunShards(pool, num_shards, [&](int shard) {
+      int64* next = &offsets[shard * kRadix];
+      for (int64 n = N * shard / num_shards;
+           n < N * (shard + 1) / num_shards; ++n) {
+        const int64 to = next[(from_keys[n] >> shift) & (kRadix - 1)]++;
+        to_keys[to] = from_keys[n];
+        to_perm[to] = from_perm[n];
+      }
+    });
+    keys->swap(other_keys);
+    perm->swap(other_perm);
+  }
+}
+
+}  // namespace
+
+bool SparseTensor::SortPermutation(const TTypes<int64>::Matrix& ix,
+                                   const VarDimArray& order,
+                                   const TensorShape& shape,
+                                   thread::ThreadPool* pool,
+                                   std::vector<int64>* reorder) {
+  const int64 N = ix.dimension(0);
+  const int num_dims = order.size();
+  int num_shards = 1;
+  if (pool != nullptr) {
+    num_shards = static_cast<int>(std::max<int64>(
+        1, std::min<int64>(pool->NumThreads(), N / kMinRowsPerShard)));
+  }
+
+  // The position of each row in a dense tensor whose dimensions are those
+  // of shape permuted by order, if that tensor has at most kint64max
+  // elements.
+  bool linearizable = true;
+  gtl::InlinedVector<int64, 8> dim_sizes(num_dims);
+  gtl::InlinedVector<int64, 8> strides(num_dims);
+  int64 num_elements = 1;
+  for (int d = num_dims - 1; d >= 0; --d) {
+    strides[d] = num_elements;
+    const int64 dim_size = shape.dim_size(order[d]);
+    dim_sizes[d] = dim_size;
+    if (dim_size > 0 && num_elements > kint64max / dim_size) {
+      linearizable = false;
+      break;
+    }
+    num_elements *= dim_size;
+  }
+
+  std::vector<int64> keys;
+  if (linearizable) {
+    keys.resize(N);
+    std::vector<char> in_bounds(num_shards, true);
+    std::vector<char> sorted(num_shards, true);
+    RunShards(pool, num_shards, [&](int shard) {
+      const int64 begin = N * shard / num_shards;
+      const int64 end = N * (shard + 1) / num_shards;
+      for (int64 n = begin; n < end; ++n) {
+        int64 key = 0;
+        for (int d = 0; d < num_dims; ++d) {
+          const int64 index = ix(n, order[d]);
+          if (index < 0 || index >= dim_sizes[d]) {
+            in_bounds[shard] = false;
+            return;
+          }
+          key += index * strides[d];
+        }
+        keys[n] = key;
+        if (n > begin && keys[n - 1] > key) sorted[shard] = false;
+      }
+    });
+    bool all_sorted = true;
+    for (int shard = 0; shard < num_shards; ++shard) {
+      if (!in_bounds[shard]) linearizable = false;
+      if (!sorted[shard]) all_sorted = false;
+      const int64 begin = N * shard / num_shards;
+      if (shard > 0 && begin > 0 && keys[begin - 1] > keys[begin]) {
+        all_sorted = false;
+      }
+    }
+    if (linearizable && all_sorted) return false;
+  }
+
+  reorder->resize(N);
+  std::iota(reorder->begin(), reorder->end(), 0);
+  if (linearizable) {
+    RadixSort(num_elements - 1, pool, num_shards, &keys, reorder);
+    return true;
+  }
+
+  // Out of bounds indices can only be ordered by comparing the rows.
+  switch (num_dims) {
+#define CASE_SORT(ORDER_SIZE)                                       \
+  case ORDER_SIZE: {                                                \
+    FixedDimComparator<ORDER_SIZE> sorter(ix, order, shape);      \
+    if (std::is_sorted(reorder->begin(), reorder->end(), sorter)) { \
+      return false;                                                 \
+    }                                                               \
+    std::sort(reorder->begin(), reorder->end(), sorter);            \
+    break;                                                          \
+  }
+    CASE_SORT(0);
+    CASE_SORT(1);
+    CASE_SORT(2);
+    CASE_SORT(3);
+    CASE_SORT(4);
+    CASE_SORT(5);
+#undef CASE_SORT
+    default: {
+      DimComparator sorter(ix, order, shape);
+      if (std::is_sorted(reorder->begin(), reorder->end(), sorter)) {
+        return false;
+      }
+      std::sort(reorder->begin(), reorder->end(), sorter);
+    }
+  }
+  return true;
+}
+
+}  // namespace sparse
+}  // namespace tensorflow
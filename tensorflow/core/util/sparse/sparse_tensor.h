@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_SPARSE_SPARSE_TENSOR_H_
 #define TENSORFLOW_UTIL_SPARSE_SPARSE_TENSOR_H_
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <vector>
 
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
@@ -94,8 +97,10 @@ class SparseTensor {
   const VarDimArray order() const { return order_; }
 
   // Resorts the indices and values according to the dimensions in order.
+  // If pool is not null, the sort and the permutation of the rows are split
+  // over its threads.
   template <typename T>
-  void Reorder(const VarDimArray& order);
+  void Reorder(const VarDimArray& order, thread::ThreadPool* pool = nullptr);
 
   // Returns a group iterable that can be used for clumping indices
   // and values according to the group indices of interest.
@@ -168,6 +173,19 @@ class SparseTensor {
     return gtl::InlinedVector<int64, 8>(shape.dims(), -1);
   }
 
+  // Sets *reorder to a permutation that sorts the rows of ix by the
+  // dimensions in order, i.e. row n of the result is row (*reorder)[n] of
+  // ix.  Returns false, without touching *reorder, if the rows are already
+  // sorted.  When the indices are in bounds and their linearized positions
+  // fit in an int64, this is a (stable) LSD radix sort on those positions,
+  // split over pool if it is not null; otherwise it falls back to std::sort
+  // with a DimComparator.
+  static bool SortPermutation(const TTypes<int64>::Matrix& ix,
+                              const VarDimArray& order,
+                              const TensorShape& shape,
+                              thread::ThreadPool* pool,
+                              std::vector<int64>* reorder);
+
   // Helper for IndicesValid()
   inline Status IndexValid(const TTypes<int64>::ConstMatrix& ix_t,
                            int n) const {
@@ -262,62 +280,43 @@ class SparseTensor {
 };
 
 // This operation updates the indices and values Tensor rows, so it is
-// an in-place algorithm.  It requires O(N log N) time and O(N)
-// temporary space.
+// an in-place algorithm.  It requires O(N) time for indices whose
+// linearized positions fit in an int64 (O(N log N) otherwise) and O(N)
+// temporary space, and does nothing beyond an O(N) scan if the indices are
+// already in order.
 template <typename T>
-void SparseTensor::Reorder(const VarDimArray& order) {
+void SparseTensor::Reorder(const VarDimArray& order, thread::ThreadPool* pool) {
   CHECK_EQ(DataTypeToEnum<T>::v(), dtype())
       << "Reorder requested with the wrong datatype";
   CHECK_EQ(order.size(), dims_) << "Order length must be SparseTensor rank";
+
   auto ix_t = ix_.matrix<int64>();
   auto vals_t = vals_.vec<T>();
 
-  std::vector<int64> reorder(num_entries());
-  std::iota(reorder.begin(), reorder.end(), 0);
-
-  // Sort to get order of indices
-  switch (order.size()) {
-#define CASE_SORT(ORDER_SIZE)                                    \
-  case ORDER_SIZE: {                                             \
-    FixedDimComparator<ORDER_SIZE> sorter(ix_t, order, shape()); \
-    std::sort(reorder.begin(), reorder.end(), sorter);           \
-    break;                                                       \
-  }
-    CASE_SORT(0);
-    CASE_SORT(1);
-    CASE_SORT(2);
-    CASE_SORT(3);
-    CASE_SORT(4);
-    CASE_SORT(5);
-#undef CASE_SORT
-    default: {
-      DimComparator sorter(ix_t, order, shape());
-      std::sort(reorder.begin(), reorder.end(), sorter);
-    }
-  }
-
-  // We have a forward reordering, but what we'll need is a
-  // permutation (the inverse).  This can be calculated with O(1)
-  // additional
-  // and O(n) time (INVPERM) but we just do the simple thing here.
-  std::vector<size_t> permutation(reorder.size());
-  for (std::size_t n = 0; n < reorder.size(); ++n) {
-    permutation[reorder[n]] = n;
-  }
-
-  // Update indices & values by converting the permutations to
-  // a product of transpositions.  Iterate over the cycles in the
-  // permutation, and convert each of those into a product of
-  // transpositions (swaps):
-  //   https://en.wikipedia.org/wiki/Cyclic_permutation
-  // This is N swaps, 2*N comparisons.
-  for (std::size_t n = 0; n + 1 < permutation.size(); ++n) {
-    while (n != permutation[n]) {
-      std::size_t r = permutation[n];
-      std::swap_ranges(&(ix_t(n, 0)), &(ix_t(n + 1, 0)), &(ix_t(r, 0)));
-      std::swap(vals_t(n), vals_t(r));
-      std::swap(permutation[n], permutation[r]);
+  std::vector<int64> reorder;
+  if (SortPermutation(ix_t, order, shape_, pool, &reorder)) {
+    // Gather the rows into new buffers in a single pass, then copy them
+    // back so that ix_ and vals_ keep their buffers.
+    const int64 N = num_entries();
+    std::vector<int64> new_ix(N * dims_);
+    // Not a std::vector<T>: shards must not share the packed words of a
+    // std::vector<bool>.
+    std::unique_ptr<T[]> new_vals(new T[N]);
+    auto gather = [this, &reorder, &ix_t, &vals_t, &new_ix, &new_vals](
+        int64 begin, int64 end) {
+      for (int64 n = begin; n < end; ++n) {
+        const int64 r = reorder[n];
+        std::copy_n(&ix_t(r, 0), dims_, &new_ix[n * dims_]);
+        new_vals[n] = std::move(vals_t(r));
+      }
+    };
+    if (pool != nullptr) {
+      pool->ParallelFor(N, 4 * dims_ + 8, gather);
+    } else {
+      gather(0, N);
     }
+    std::copy(new_ix.begin(), new_ix.end(), ix_t.data());
+    std::move(new_vals.get(), new_vals.get() + N, vals_t.data());
   }
 
   order_ = gtl::InlinedVector<int64, 8>(order.begin(), order.end());
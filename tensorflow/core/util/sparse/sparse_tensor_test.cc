@@ -20,10 +20,14 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -246,6 +250,103 @@ TEST(SparseTensorTest, SortingWorksCorrectly) {
   }
 }
 
+TEST(SparseTensorTest, ReorderWithPoolIsStable) {
+  // Enough rows to be split over several shards, in a small shape so that
+  // many of them share their indices.
+  const int N = 100000;
+  const int NDIM = 3;
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+
+  Tensor ix(DT_INT64, TensorShape({N, NDIM}));
+  Tensor vals(DT_INT32, TensorShape({N}));
+  TensorShape shape({10, 20, 30});
+  auto ix_t = ix.matrix<int64>();
+  ix_t = ix_t.random(Eigen::internal::UniformRandomGenerator<int64>(7));
+  ix_t = ix_t.abs() % 10;
+  Tensor original = tensor::DeepCopy(ix);
+  auto original_t = original.matrix<int64>();
+  auto vals_t = vals.vec<int32>();
+  for (int n = 0; n < N; ++n) vals_t(n) = n;
+
+  SparseTensor st(ix, vals, shape);
+  for (const std::vector<int64>& order :
+       {std::vector<int64>{0, 1, 2}, std::vector<int64>{2, 0, 1}}) {
+    st.Reorder<int32>(order, &pool);
+    for (int n = 0; n < N; ++n) {
+      // Each row kept its value, and rows with equal indices kept their
+      // relative order.
+      for (int d = 0; d < NDIM; ++d) {
+        ASSERT_EQ(original_t(vals_t(n), d), ix_t(n, d));
+      }
+      if (n > 0) {
+        bool equal = true;
+        for (const int64 d : order) {
+          if (ix_t(n - 1, d) != ix_t(n, d)) {
+            ASSERT_LT(ix_t(n - 1, d), ix_t(n, d));
+            equal = false;
+            break;
+          }
+        }
+        if (equal) ASSERT_LT(vals_t(n - 1), vals_t(n));
+      }
+    }
+  }
+
+  // Reordering already sorted rows leaves them as they are.
+  Tensor sorted = tensor::DeepCopy(ix);
+  st.Reorder<int32>({2, 0, 1});
+  test::ExpectTensorEqual<int64>(sorted, ix);
+}
+
+TEST(SparseTensorTest, ReorderBoolWithPool) {
+  // Shards of the gather write neighboring values, which must not share
+  // storage even for bool.
+  const int N = 100000;
+  const int NDIM = 2;
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+
+  Tensor ix(DT_INT64, TensorShape({N, NDIM}));
+  Tensor vals(DT_BOOL, TensorShape({N}));
+  TensorShape shape({N, 2});
+  auto ix_t = ix.matrix<int64>();
+  auto vals_t = vals.vec<bool>();
+  // Row n holds index (N - 1 - n, n % 2) and value (n % 3 == 0).
+  for (int n = 0; n < N; ++n) {
+    ix_t(n, 0) = N - 1 - n;
+    ix_t(n, 1) = n % 2;
+    vals_t(n) = n % 3 == 0;
+  }
+
+  SparseTensor st(ix, vals, shape);
+  st.Reorder<bool>({0, 1}, &pool);
+  for (int n = 0; n < N; ++n) {
+    const int original = N - 1 - n;
+    ASSERT_EQ(n, ix_t(n, 0));
+    ASSERT_EQ(original % 2, ix_t(n, 1));
+    ASSERT_EQ(original % 3 == 0, vals_t(n)) << n;
+  }
+}
+
+TEST(SparseTensorTest, ReorderOutOfBoundsIndices) {
+  // Out of bounds indices can't be linearized, so these are sorted by
+  // comparing the rows.
+  int N = 5;
+  const int NDIM = 3;
+  Tensor ix(DT_INT64, TensorShape({N, NDIM}));
+  Tensor vals(DT_STRING, TensorShape({N}));
+  ix.matrix<int64>() = GetSimpleIndexTensor(N, NDIM);
+  ix.matrix<int64>()(1, 0) = -3;
+  vals.vec<string>().setValues({"a", "b", "c", "d", "e"});
+  SparseTensor st(ix, vals, TensorShape({2, 2, 2}));
+
+  st.Reorder<string>({0, 1, 2});
+  test::ExpectTensorEqual<int64>(
+      ix, test::AsTensor<int64>({-3, 0, 0, 0, 0, 0, 0, 0, 2, 0, 1, 0, 2, 0, 0},
+                                {N, NDIM}));
+  test::ExpectTensorEqual<string>(
+      vals, test::AsTensor<string>({"b", "a", "e", "d", "c"}));
+}
+
 TEST(SparseTensorTest, ValidateIndicesFindsInvalid) {
   int N = 2;
   const int NDIM = 3;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -42,7 +43,10 @@ namespace tensorflow {
 // Versioning of the tensor bundle format.
 const int kTensorBundleMinProducer = 0;
 const int kTensorBundleMinConsumer = 0;
-const int kTensorBundleVersion = 1;
+const int kTensorBundleVersion = 2;
+
+// The first version able to read delta bundles.
+const int kDeltaBundleMinConsumer = 2;
 
 // Key to the special BundleHeaderProto entry.  Do not change this, as clients
 // can make the assumption that the header is always the first entry in the
@@ -185,8 +189,9 @@ Status WriteStringTensor(const Tensor& val, FileOutputBuffer* out,
   return Status::OK();
 }
 
-// Reads file[offset:offset+size) into destination[0:size).  Each Read() copies
-// at most "buffer_size" bytes.
+// Reads file[offset:offset+size) into destination[0:size).  Each read copies
+// at most "buffer_size" bytes, and all of them are issued with one ReadV() so
+// that the file system may overlap them.
 //
 // REQUIRES: "file" contains at least "offset + size" bytes.
 // REQUIRES: "destination" contains at least "size" bytes.
@@ -196,29 +201,30 @@ Status ReadInputByChunk(const RandomAccessFile* file, size_t offset,
   if (size == 0) return Status::OK();
   CHECK_GT(size, 0);
   CHECK_GT(buffer_size, 0);
-  size_t bytes_read = 0;
-  StringPiece result;
-
-  while (bytes_read < size) {
-    const size_t desired_bytes = std::min(buffer_size, size - bytes_read);
-    Status status = file->Read(offset + bytes_read, desired_bytes, &result,
-                               destination + bytes_read);
-
-    if (!status.ok()) {
-      return status;
-    } else if (result.size() != desired_bytes) {
-      return errors::DataLoss("Requested ", desired_bytes, " bytes but read ",
+  std::vector<RandomAccessFile::ReadRequest> requests;
+  requests.reserve((size + buffer_size - 1) / buffer_size);
+  for (size_t pos = 0; pos < size; pos += buffer_size) {
+    RandomAccessFile::ReadRequest request;
+    request.offset = offset + pos;
+    request.n = std::min(buffer_size, size - pos);
+    request.scratch = destination + pos;
+    requests.push_back(request);
+  }
+  TF_RETURN_IF_ERROR(file->ReadV(&requests));
+
+  for (const RandomAccessFile::ReadRequest& request : requests) {
+    const StringPiece result = request.result;
+    if (result.size() != request.n) {
+      return errors::DataLoss("Requested ", request.n, " bytes but read ",
                               result.size(), " bytes.");
-    } else if (result.data() == destination + bytes_read) {
+    } else if (result.data() == request.scratch) {
       // Data is already in the correct location.
     } else {
       // memmove is guaranteed to handle overlaps safely (although the src and
       // dst buffers should not overlap for this function).
-      memmove(destination + bytes_read, result.data(), result.size());
+      memmove(request.scratch, result.data(), result.size());
     }
-    bytes_read += result.size();
   }
-  CHECK_EQ(bytes_read, size);
   return Status::OK();
 }
 
@@ -238,11 +244,50 @@ bool IsFullSlice(const TensorSlice& slice_spec,
   }
 }
 
+// Copies the intersection of "stored_slice", whose values are in "stored", and
+// "slice_spec" of a tensor of shape "full_shape" into "val", which holds the
+// values of "slice_spec".
+Status CopySliceIntersection(const TensorShape& full_shape,
+                             const TensorSlice& stored_slice,
+                             const Tensor& stored,
+                             const TensorSlice& slice_spec, Tensor* val) {
+  switch (stored.dtype()) {
+#define HANDLE_COPY(T)                                                    \
+  case DataTypeToEnum<T>::value:                                          \
+    CHECK(CopyDataFromTensorSliceToTensorSlice(full_shape, stored_slice,  \
+                                               slice_spec,                \
+                                               stored.flat<T>().data(),   \
+                                               val->flat<T>().data()));   \
+    break;
+
+    HANDLE_COPY(float)
+    HANDLE_COPY(double)
+    HANDLE_COPY(int32)
+    HANDLE_COPY(uint8)
+    HANDLE_COPY(int16)
+    HANDLE_COPY(int8)
+    HANDLE_COPY(complex64)
+    HANDLE_COPY(complex128)
+    HANDLE_COPY(int64)
+    HANDLE_COPY(bool)
+    HANDLE_COPY(qint32)
+    HANDLE_COPY(quint8)
+    HANDLE_COPY(qint8)
+    default:
+      return errors::InvalidArgument("Dtype ", DataTypeString(stored.dtype()),
+                                     " not supported.");
+  }
+#undef HANDLE_COPY
+  return Status::OK();
+}
+
 }  // namespace
 
-BundleWriter::BundleWriter(Env* env, StringPiece prefix)
+BundleWriter::BundleWriter(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix.ToString()),
+      options_(options),
       tmp_metadata_path_(strings::StrCat(MetaFilename(prefix_), ".tempstate",
                                          random::New64())),
       tmp_data_path_(strings::StrCat(DataFilename(prefix_, 0, 1), ".tempstate",
@@ -370,6 +415,10 @@ Status BundleWriter::Finish() {
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
     version->set_min_consumer(kTensorBundleMinConsumer);
+    if (!options_.base_prefix.empty()) {
+      header.set_base_prefix(options_.base_prefix);
+      version->set_min_consumer(kDeltaBundleMinConsumer);
+    }
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -405,6 +454,7 @@ struct MergeState {
   bool seen_first_bundle = false;
   BundleHeaderProto_Endianness endianness;
   VersionDef version;
+  string base_prefix;
 
   // Tensor key -> BundleEntryProto.
   std::map<string, BundleEntryProto> entries;
@@ -444,6 +494,7 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
       merge_state->seen_first_bundle = true;
       merge_state->endianness = header.endianness();
       merge_state->version = header.version();
+      merge_state->base_prefix = header.base_prefix();
     } else {
       // Validates "endianness".
       if (merge_state->endianness != header.endianness()) {
@@ -459,6 +510,13 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
             "Merging bundles with different format versions: merged ",
             merge_version, " vs. curr ", curr_version);
       }
+      // Validates "base_prefix".
+      if (merge_state->base_prefix != header.base_prefix()) {
+        return errors::InvalidArgument(
+            "Merging bundles with different bases: merged \"",
+            merge_state->base_prefix, "\" vs. curr \"", header.base_prefix(),
+            "\"");
+      }
     }
     num_shards = header.num_shards();
     iter->Next();
@@ -542,6 +600,7 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
     header.set_num_shards(merge.num_shards);
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    header.set_base_prefix(merge.base_prefix);
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -598,12 +657,30 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   }
   status_ = CheckVersions(header.version(), kTensorBundleVersion,
                           kTensorBundleMinProducer, "Checkpoint", "checkpoint");
+  if (!status_.ok() || header.base_prefix().empty()) return;
+
+  if (header.base_prefix() == prefix_) {
+    status_ = errors::DataLoss("Bundle ", prefix_, " is a delta on itself");
+    return;
+  }
+  base_.reset(new BundleReader(env_, header.base_prefix()));
+  if (!base_->status().ok()) {
+    status_ = Status(
+        base_->status().code(),
+        strings::StrCat("Failed to open the base bundle of delta bundle ",
+                        prefix_, ": ", base_->status().error_message()));
+  }
 }
 
 BundleReader::~BundleReader() {
   delete metadata_;
   delete iter_;
   delete table_;
+  for (const auto& shard_and_buffer : data_) {
+    if (shard_and_buffer.second != nullptr) {
+      delete shard_and_buffer.second->file();
+    }
+  }
   gtl::STLDeleteValues(&data_);
   gtl::STLDeleteValues(&tensor_slices_);
 }
@@ -658,16 +735,18 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if not opened it.
-  std::unique_ptr<RandomAccessFile> file = nullptr;
-  std::unique_ptr<io::InputBuffer> buffered_file(data_[entry.shard_id()]);
+  // Open the data file if it has not been opened, and keep it open for the
+  // next tensors of the same shard.
+  io::InputBuffer* buffered_file = data_[entry.shard_id()];
   if (buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
     TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
         DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file.reset(
-        new io::InputBuffer(file.get(), 256 << 10 /* 256KB buffer */));
+    // The InputBuffer and the RandomAccessFile are both deleted in the dtor.
+    buffered_file =
+        new io::InputBuffer(file.release(), 256 << 10 /* 256KB buffer */);
+    data_[entry.shard_id()] = buffered_file;
   }
-  CHECK(buffered_file != nullptr);
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -684,7 +763,7 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     // Relies on io::InputBuffer's buffering, because we issue many neighboring
     // reads for a single string tensor.
     TF_RETURN_IF_ERROR(ReadStringTensor(
-        buffered_file.get(), ret->NumElements(), entry.offset(), entry.size(),
+        buffered_file, ret->NumElements(), entry.offset(), entry.size(),
         GetStringBackingBuffer(*ret), &actual_crc32c));
   }
   if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
@@ -702,7 +781,11 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  Status status = GetBundleEntryProto(key, &entry);
+  if (base_ != nullptr && errors::IsNotFound(status)) {
+    return base_->Lookup(key, val);
+  }
+  TF_RETURN_IF_ERROR(status);
 
   if (entry.slices().empty()) {
     return GetValue(entry, val);
@@ -717,7 +800,13 @@ Status BundleReader::LookupTensorSlices(StringPiece key,
                                         std::vector<TensorSlice>* slices) {
   slices->clear();
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  Status status = GetBundleEntryProto(key, &entry);
+  // The slices of a delta overwrite the tensor as partitioned in the base.
+  if (base_ != nullptr && (errors::IsNotFound(status) ||
+                           (status.ok() && base_->Contains(key)))) {
+    return base_->LookupTensorSlices(key, slices);
+  }
+  TF_RETURN_IF_ERROR(status);
   slices->reserve(entry.slices_size());
   for (const auto& slice : entry.slices()) {
     slices->emplace_back(slice);
@@ -729,7 +818,11 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
                                  const TensorSlice& slice_spec, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(full_tensor_key, &entry));
+  Status status = GetBundleEntryProto(full_tensor_key, &entry);
+  if (base_ != nullptr && errors::IsNotFound(status)) {
+    return base_->LookupSlice(full_tensor_key, slice_spec, val);
+  }
+  TF_RETURN_IF_ERROR(status);
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
@@ -766,6 +859,10 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
     CHECK_NE(tss, nullptr);
   }
   if (!tss->QueryMeta(slice_spec, &details)) {
+    if (base_ != nullptr) {
+      return GetDeltaSliceValue(full_tensor_key, full_tensor_entry, slice_spec,
+                                val);
+    }
     return errors::InvalidArgument(
         "Does not have sufficient slices for partitioned tensor ",
         full_tensor_key,
@@ -816,46 +913,65 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
     if (!status_.ok()) return status_;
 
     // Copies the intersection over.
-    const DataType common_dtype = full_tensor_entry.dtype();
-    switch (common_dtype) {
-#define HANDLE_COPY(T)                                                 \
-  case DataTypeToEnum<T>::value:                                       \
-    CHECK(CopyDataFromTensorSliceToTensorSlice(                        \
-        full_shape, stored_slice, slice_spec,                          \
-        stored_slice_tensor.flat<T>().data(), val->flat<T>().data())); \
-    break;
+    TF_RETURN_IF_ERROR(CopySliceIntersection(full_shape, stored_slice,
+                                             stored_slice_tensor, slice_spec,
+                                             val));
+  }
+  return Status::OK();
+}
 
-      HANDLE_COPY(float)
-      HANDLE_COPY(double)
-      HANDLE_COPY(int32)
-      HANDLE_COPY(uint8)
-      HANDLE_COPY(int16)
-      HANDLE_COPY(int8)
-      HANDLE_COPY(complex64)
-      HANDLE_COPY(complex128)
-      HANDLE_COPY(int64)
-      HANDLE_COPY(bool)
-      HANDLE_COPY(qint32)
-      HANDLE_COPY(quint8)
-      HANDLE_COPY(qint8)
-      default:
-        return errors::InvalidArgument("Dtype ", DataTypeString(common_dtype),
-                                       " not supported.");
-    }
-#undef HANDLE_COPY
+Status BundleReader::GetDeltaSliceValue(
+    StringPiece full_tensor_key, const BundleEntryProto& full_tensor_entry,
+    const TensorSlice& slice_spec, Tensor* val) {
+  DCHECK(base_ != nullptr);
+  const TensorShape full_shape(TensorShape(full_tensor_entry.shape()));
+  DataType base_dtype;
+  TensorShape base_shape;
+  TF_RETURN_IF_ERROR(
+      base_->LookupDtypeAndShape(full_tensor_key, &base_dtype, &base_shape));
+  if (base_dtype != full_tensor_entry.dtype() || base_shape != full_shape) {
+    return errors::DataLoss(
+        "Tensor ", full_tensor_key, " is stored with dtype ",
+        DataTypeString(full_tensor_entry.dtype()), " and shape ",
+        full_shape.DebugString(), " in delta bundle ", prefix_,
+        " but with dtype ", DataTypeString(base_dtype), " and shape ",
+        base_shape.DebugString(), " in its base");
+  }
+  TF_RETURN_IF_ERROR(base_->LookupSlice(full_tensor_key, slice_spec, val));
+
+  const string full_tensor_key_string = full_tensor_key.ToString();
+  for (const TensorSliceProto& slice_proto : full_tensor_entry.slices()) {
+    const TensorSlice stored_slice(slice_proto);
+    if (!stored_slice.Overlaps(slice_spec)) continue;
+    BundleEntryProto stored_slice_entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(
+        checkpoint::EncodeTensorNameSlice(full_tensor_key_string,
+                                          stored_slice),
+        &stored_slice_entry));
+    Tensor stored_slice_tensor(stored_slice_entry.dtype(),
+                               TensorShape(stored_slice_entry.shape()));
+    TF_RETURN_IF_ERROR(GetValue(stored_slice_entry, &stored_slice_tensor));
+    TF_RETURN_IF_ERROR(CopySliceIntersection(full_shape, stored_slice,
+                                             stored_slice_tensor, slice_spec,
+                                             val));
   }
   return Status::OK();
 }
 
 bool BundleReader::Contains(StringPiece key) {
   Seek(key);
-  return Valid() && (this->key() == key);
+  return (Valid() && (this->key() == key)) ||
+         (base_ != nullptr && base_->Contains(key));
 }
 
 Status BundleReader::LookupDtypeAndShape(StringPiece key, DataType* dtype,
                                          TensorShape* shape) {
   BundleEntryProto entry;
-  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  Status status = GetBundleEntryProto(key, &entry);
+  if (base_ != nullptr && errors::IsNotFound(status)) {
+    return base_->LookupDtypeAndShape(key, dtype, shape);
+  }
+  TF_RETURN_IF_ERROR(status);
   *dtype = entry.dtype();
   *shape = TensorShape(entry.shape());
   return Status::OK();
@@ -57,6 +57,17 @@ limitations under the License.
 //        "/fs/model/train/ckpt-step/tmp/worker1-step"},
 //       "/fs/model/train/ckpt-step/ckpt" /* merged prefix */);
 //
+// A bundle can also be a delta on a base bundle, storing only the tensors, or
+// slices of tensors, that changed since the base was written.  A BundleReader
+// of the delta reads the rest from the base.  The SaveDeltaV2 op writes such
+// deltas of the rows of resource variables changed by sparse updates:
+//
+//   BundleWriter::Options options;
+//   options.base_prefix = "/fs/model/train/ckpt-step0/ckpt";
+//   BundleWriter writer(env, "/fs/model/train/ckpt-step1/ckpt", options);
+//   writer.AddSlice("embedding", full_shape, changed_rows, rows);
+//   writer.Finish();
+//
 
 #ifndef TENSORFLOW_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 #define TENSORFLOW_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
@@ -64,6 +75,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -91,6 +103,7 @@ class FileOutputBuffer;
 // History:
 // 0. Any tensor bundles produced before this field was added.
 // 1. Added this field (2016-09-14).
+// 2. Added delta bundles, which can't be read by older consumers.
 extern const int kTensorBundleMinProducer;
 extern const int kTensorBundleMinConsumer;
 extern const int kTensorBundleVersion;
@@ -107,7 +120,14 @@ extern const char* const kHeaderEntryKey;
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
-  BundleWriter(Env* env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If non-empty, the bundle is a delta on the bundle with this prefix.  See
+    // BundleHeaderProto.base_prefix.
+    string base_prefix;
+  };
+  BundleWriter(Env* env, StringPiece prefix,
+               const Options& options = Options());
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -141,6 +161,7 @@ class BundleWriter {
  private:
   Env* const env_;  // Not owned.
   const string prefix_;
+  const Options options_;
   const string tmp_metadata_path_;
   const string tmp_data_path_;
   std::unique_ptr<FileOutputBuffer> out_;
@@ -162,6 +183,8 @@ class BundleWriter {
 // query information about a tensor.  In particular, this function does not
 // guarantee not to re-order the input data files.
 //
+// The bundles must all be deltas on the same base, or none of them a delta.
+//
 // Once merged, makes a best effort to delete the old metadata files.
 // Returns OK iff all bundles are successfully merged.
 Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
@@ -170,6 +193,11 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // On construction, silently attempts to read the metadata associated with
 // "prefix".  If caller intends to call any function afterwards, "status()"
 // must be checked.
+//
+// If the bundle is a delta, the lookups merge it with its chain of base
+// bundles, which are also opened on construction.  Seek() and the iteration
+// only cover the entries stored in the delta.
+//
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
@@ -262,9 +290,20 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the slice described by "slice_spec" from the base bundle, then
+  // overwrites it with the intersecting slices stored in this delta bundle.
+  // REQUIRES: base_ != nullptr
+  Status GetDeltaSliceValue(StringPiece full_tensor_key,
+                            const BundleEntryProto& full_tensor_entry,
+                            const TensorSlice& slice_spec,
+                            Tensor* val) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const string prefix_;
 
+  // The reader of the base bundle, if this bundle is a delta.
+  std::unique_ptr<BundleReader> base_;
+
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
   table::Table* table_;
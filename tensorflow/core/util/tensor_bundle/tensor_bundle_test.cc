@@ -317,6 +317,96 @@ TEST(TensorBundleTest, PartitionedVariables) {
   }
 }
 
+TEST(TensorBundleTest, DeltaBundles) {
+  const TensorShape kFullShape({6, 2});
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_base"));
+    TF_ASSERT_OK(writer.Add("embedding", Constant<float>(0., kFullShape)));
+    TF_ASSERT_OK(writer.Add("dense", Constant_2x3<float>(1.)));
+    TF_ASSERT_OK(writer.Add("only_base", Constant_2x3<float>(5.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options options;
+    options.base_prefix = Prefix("delta_base");
+    BundleWriter writer(Env::Default(), Prefix("delta_1"), options);
+    TF_ASSERT_OK(writer.AddSlice("embedding", kFullShape,
+                                 TensorSlice::ParseOrDie("1,2:-"),
+                                 Constant<float>(1., TensorShape({2, 2}))));
+    TF_ASSERT_OK(writer.Add("dense", Constant_2x3<float>(2.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options options;
+    options.base_prefix = Prefix("delta_1");
+    BundleWriter writer(Env::Default(), Prefix("delta_2"), options);
+    TF_ASSERT_OK(writer.AddSlice("embedding", kFullShape,
+                                 TensorSlice::ParseOrDie("2,3:-"),
+                                 Constant<float>(2., TensorShape({3, 2}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader reader(Env::Default(), Prefix("delta_2"));
+  TF_ASSERT_OK(reader.status());
+  // Only the entries stored in the delta, a sliced tensor and its slice, are
+  // iterated over.
+  const std::vector<string> keys = AllTensorKeys(&reader);
+  ASSERT_EQ(2, keys.size());
+  EXPECT_EQ("embedding", keys[0]);
+  Expect<float>(&reader, "only_base", Constant_2x3<float>(5.));
+  Expect<float>(&reader, "dense", Constant_2x3<float>(2.));
+
+  Tensor expected_val(DT_FLOAT, kFullShape);
+  test::FillValues<float>(&expected_val, {0, 0, 1, 1, 2, 2, 2, 2, 2, 2, 0, 0});
+  Expect<float>(&reader, "embedding", expected_val);
+
+  // The slices overwrite the tensor, which is not partitioned in the base.
+  std::vector<TensorSlice> slices;
+  TF_ASSERT_OK(reader.LookupTensorSlices("embedding", &slices));
+  EXPECT_TRUE(slices.empty());
+
+  // Reads a slice "cutting" the slices of both deltas.
+  Tensor val(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(
+      reader.LookupSlice("embedding", TensorSlice::ParseOrDie("1,2:-"), &val));
+  Tensor expected_slice(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected_slice, {1, 1, 2, 2});
+  test::ExpectTensorEqual<float>(val, expected_slice);
+
+  // Delta bundles can't be read by older consumers.
+  reader.Seek(kHeaderEntryKey);
+  ASSERT_TRUE(reader.Valid());
+  BundleHeaderProto header;
+  ASSERT_TRUE(ParseProtoUnlimited(&header, reader.value().data(),
+                                  reader.value().size()));
+  EXPECT_EQ(Prefix("delta_1"), header.base_prefix());
+  EXPECT_GT(header.version().min_consumer(), kTensorBundleMinConsumer);
+}
+
+TEST(TensorBundleTest, MergeDeltaBundlesOfDifferentBases) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_base"));
+    TF_ASSERT_OK(writer.Add("foo", Constant_2x3<float>(0.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options options;
+    options.base_prefix = Prefix("merge_delta_base");
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_0"), options);
+    TF_ASSERT_OK(writer.Add("foo", Constant_2x3<float>(1.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_1"));
+    TF_ASSERT_OK(writer.Add("bar", Constant_2x3<float>(2.)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const Status status = MergeBundles(
+      Env::Default(), {Prefix("merge_delta_0"), Prefix("merge_delta_1")},
+      Prefix("merge_delta_merged"));
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
 TEST(TensorBundleTest, EquivalentSliceTest) {
   const TensorShape kFullShape({5, 10});
   const Tensor kExpected(Constant<float>(1., kFullShape));
@@ -27,8 +27,10 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
@@ -88,9 +90,12 @@ class TensorSliceReader {
   // yes, copies the data of the slice to "data". The caller needs to make sure
   // that "data" points to a buffer that holds enough data.
   // This is a slow function since it needs to read sstables.
+  //
+  // If "workers" is not null, the stored slices intersecting "slice" are read
+  // and copied concurrently on it.
   template <typename T>
-  bool CopySliceData(const string& name, const TensorSlice& slice,
-                     T* data) const;
+  bool CopySliceData(const string& name, const TensorSlice& slice, T* data,
+                     thread::ThreadPool* workers = nullptr) const;
 
   // Get the tensors.
   const std::unordered_map<string, TensorSliceSet*>& Tensors() const {
@@ -139,7 +144,8 @@ Status OpenTableTensorSliceReader(const string& fname,
 
 template <typename T>
 bool TensorSliceReader::CopySliceData(const string& name,
-                                      const TensorSlice& slice, T* data) const {
+                                      const TensorSlice& slice, T* data,
+                                      thread::ThreadPool* workers) const {
   std::vector<std::pair<TensorSlice, string>> details;
   const TensorSliceSet* tss;
   {
@@ -156,15 +162,17 @@ bool TensorSliceReader::CopySliceData(const string& name,
       return false;
     }
   }
-  // We have the data -- copy it over.
-  string value;
-  for (const auto& x : details) {
+  // We have the data -- copy it over.  The stored slices don't overlap, so
+  // each one is copied to a distinct part of "data".
+  auto copy_stored_slice = [this, &name, &slice, data,
+                            tss](const std::pair<TensorSlice, string>& x) {
     const TensorSlice& slice_s = x.first;
     const string& fname = x.second;
     int idx = gtl::FindWithDefault(fname_to_index_, fname, -1);
     CHECK_GE(idx, 0) << "Failed to find the index for filename " << fname;
     // We read a record in the corresponding sstable
     const string key = EncodeTensorNameSlice(name, slice_s);
+    string value;
     CHECK(sss_[idx]->Get(key, &value))
         << "Failed to seek to the record for tensor " << name << ", slice "
         << slice_s.DebugString() << ": computed key = " << key;
@@ -175,7 +183,22 @@ bool TensorSliceReader::CopySliceData(const string& name,
     CopyDataFromTensorSliceToTensorSlice(
         tss->shape(), slice_s, slice,
         checkpoint::TensorProtoData<T>(sts.data().data()), data);
+  };
+  if (workers == nullptr || details.size() <= 1) {
+    for (const auto& x : details) {
+      copy_stored_slice(x);
+    }
+    return true;
+  }
+  BlockingCounter counter(details.size() - 1);
+  for (size_t i = 1; i < details.size(); ++i) {
+    workers->Schedule([&copy_stored_slice, &details, &counter, i]() {
+      copy_stored_slice(details[i]);
+      counter.DecrementCount();
+    });
   }
+  copy_stored_slice(details[0]);
+  counter.Wait();
   return true;
 }
 
@@ -15,7 +15,6 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
-#include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -28,7 +27,8 @@ TensorSliceReaderCacheWrapper::~TensorSliceReaderCacheWrapper() {
   cache_ = nullptr;
 }
 
-const TensorSliceReader* TensorSliceReaderCacheWrapper::GetReader(
+std::shared_ptr<const TensorSliceReader>
+TensorSliceReaderCacheWrapper::GetReader(
     const string& filepattern,
     TensorSliceReader::OpenTableFunction open_function,
     int preferred_shard) const {
@@ -39,15 +39,16 @@ const TensorSliceReader* TensorSliceReaderCacheWrapper::GetReader(
   return cache_->GetReader(filepattern, open_function, preferred_shard);
 }
 
-TensorSliceReaderCache::TensorSliceReaderCache() {}
+constexpr int TensorSliceReaderCache::kDefaultCapacity;
 
-TensorSliceReaderCache::~TensorSliceReaderCache() {
-  for (auto pair : readers_) {
-    delete pair.second.second;
-  }
+TensorSliceReaderCache::TensorSliceReaderCache(int capacity)
+    : capacity_(capacity) {
+  CHECK_GT(capacity_, 0);
 }
 
-const TensorSliceReader* TensorSliceReaderCache::GetReader(
+TensorSliceReaderCache::~TensorSliceReaderCache() {}
+
+std::shared_ptr<const TensorSliceReader> TensorSliceReaderCache::GetReader(
     const string& filepattern,
     TensorSliceReader::OpenTableFunction open_function, int preferred_shard) {
   mutex_lock l(mu_);
@@ -75,8 +76,9 @@ const TensorSliceReader* TensorSliceReaderCache::GetReader(
     cv_.wait(l);
   }
 
-  TensorSliceReader* reader = nullptr;
-  if (readers_.find(filepattern) == readers_.end()) {
+  std::shared_ptr<const TensorSliceReader> reader;
+  auto it = readers_.find(filepattern);
+  if (it == readers_.end()) {
     VLOG(1) << "Creating new TensorSliceReader for " << filepattern;
     still_opening_.insert(filepattern);
     // Release the lock temporary as constructing TensorSliceReader is
@@ -87,19 +89,29 @@ const TensorSliceReader* TensorSliceReaderCache::GetReader(
     // Acquire the lock again.
     mu_.lock();
     if (tmp_reader->status().ok()) {
-      reader = tmp_reader;
-      readers_[filepattern] = std::make_pair(*func_ptr, reader);
+      reader.reset(tmp_reader);
+      // Evicts the least recently used readers, which are deleted once their
+      // last users release them.
+      while (readers_.size() >= static_cast<size_t>(capacity_)) {
+        VLOG(1) << "Evicting TensorSliceReader for " << lru_.back();
+        readers_.erase(lru_.back());
+        lru_.pop_back();
+      }
+      lru_.push_front(filepattern);
+      readers_[filepattern] = {*func_ptr, reader, lru_.begin()};
     } else {
       delete tmp_reader;
     }
     CHECK_EQ(size_t{1}, still_opening_.erase(filepattern));
-    VLOG(1) << "Cached TensorSliceReader for " << filepattern << ": " << reader;
+    VLOG(1) << "Cached TensorSliceReader for " << filepattern << ": "
+            << reader.get();
   } else {
-    auto cached_val = readers_[filepattern];
-    if (cached_val.first == *func_ptr) {
-      reader = cached_val.second;
+    Entry& entry = it->second;
+    if (entry.open_function == *func_ptr) {
+      reader = entry.reader;
+      lru_.splice(lru_.begin(), lru_, entry.lru_position);
       VLOG(1) << "Using cached TensorSliceReader for " << filepattern << ": "
-              << reader;
+              << reader.get();
     } else {
       LOG(WARNING) << "Caching disabled because the checkpoint file "
                    << "is being opened with two different open functions: "
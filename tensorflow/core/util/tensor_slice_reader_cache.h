@@ -20,6 +20,9 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_TENSOR_SLICE_READER_CACHE_H_
 #define TENSORFLOW_UTIL_TENSOR_SLICE_READER_CACHE_H_
 
+#include <list>
+#include <memory>
+#include <set>
 #include <unordered_map>
 
 #include "tensorflow/core/lib/core/status.h"
@@ -40,7 +43,7 @@ class TensorSliceReaderCacheWrapper {
   ~TensorSliceReaderCacheWrapper();
 
   // Same as TensorSliceReaderCache::GetReader().
-  const TensorSliceReader* GetReader(
+  std::shared_ptr<const TensorSliceReader> GetReader(
       const string& filepattern,
       TensorSliceReader::OpenTableFunction open_function,
       int preferred_shard) const;
@@ -50,16 +53,23 @@ class TensorSliceReaderCacheWrapper {
   mutable TensorSliceReaderCache* cache_ = nullptr;
 };
 
-// A cache of TensorSliceReaders.
+// A cache of TensorSliceReaders, which keeps the 'capacity' most recently used
+// ones open.
 class TensorSliceReaderCache {
  public:
-  TensorSliceReaderCache();
+  // Each reader holds the metadata of all the files matching its pattern.
+  static constexpr int kDefaultCapacity = 16;
+
+  explicit TensorSliceReaderCache(int capacity = kDefaultCapacity);
   ~TensorSliceReaderCache();
 
   // Returns the TensorSliceReader corresponding to 'filepattern' and the
   // open_function.  May return nullptr if we can not create a new
   // TensorSliceReader for the filepattern/open_function combination.
-  const TensorSliceReader* GetReader(
+  //
+  // The returned reader remains valid after it is evicted from the cache, for
+  // as long as the caller holds it.
+  std::shared_ptr<const TensorSliceReader> GetReader(
       const string& filepattern,
       TensorSliceReader::OpenTableFunction open_function, int preferred_shard);
 
@@ -68,12 +78,23 @@ class TensorSliceReaderCache {
   // not support ==.
   typedef Status (*OpenFuncType)(const string&, TensorSliceReader::Table**);
 
+  struct Entry {
+    OpenFuncType open_function;
+    std::shared_ptr<const TensorSliceReader> reader;
+    // The position of the file pattern in lru_.
+    std::list<string>::iterator lru_position;
+  };
+
+  const int capacity_;
+
   // Protects attributes below.
   mutex mu_;
 
   // Maps of opened readers.
-  std::unordered_map<string, std::pair<OpenFuncType, TensorSliceReader*>>
-      readers_;
+  std::unordered_map<string, Entry> readers_;
+
+  // The file patterns of the opened readers, the most recently used first.
+  std::list<string> lru_;
 
   // Set of keys that a previous GetReader() call is still trying to populate.
   std::set<string> still_opening_;
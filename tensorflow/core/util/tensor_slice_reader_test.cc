@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -363,9 +364,9 @@ void CachedTensorSliceReaderTesterHelper(
   //   .   .   .   .   .
 
   // Now we need to read the tensor slices
-  TensorSliceReaderCache cache;
+  TensorSliceReaderCache cache(2 /* capacity */);
   const string filepattern = strings::StrCat(fname_base, "_*");
-  const TensorSliceReader* reader = cache.GetReader(
+  std::shared_ptr<const TensorSliceReader> reader = cache.GetReader(
       filepattern, open_function, TensorSliceReader::kLoadAllShards);
   EXPECT_TRUE(reader != nullptr);
   EXPECT_EQ(2, reader->num_files());
@@ -380,11 +381,43 @@ void CachedTensorSliceReaderTesterHelper(
     EXPECT_FALSE(reader->HasTensor("don't exist", nullptr, nullptr));
   }
 
+  // Reads a slice spanning stored slices of both files concurrently.
+  {
+    thread::ThreadPool workers(Env::Default(), "test", 2);
+    TensorSlice s = TensorSlice::ParseOrDie("0,4:0,3");
+    float expected[] = {0, 1, 2, 5, 6, 7, 10, 11, 12, 15, 16, 17};
+    float results[12];
+    EXPECT_TRUE(reader->CopySliceData("test", s, results, &workers));
+    for (int i = 0; i < 12; ++i) {
+      EXPECT_EQ(expected[i], results[i]);
+    }
+  }
+
   // Make sure the reader is cached.
-  const TensorSliceReader* reader2 = cache.GetReader(
+  std::shared_ptr<const TensorSliceReader> reader2 = cache.GetReader(
       filepattern, open_function, TensorSliceReader::kLoadAllShards);
   EXPECT_EQ(reader, reader2);
 
+  // Opening two other readers evicts the least recently used one, which
+  // remains valid while held.
+  const string filepattern_0 = strings::StrCat(fname_base, "_0");
+  const string filepattern_1 = strings::StrCat(fname_base, "_1");
+  std::shared_ptr<const TensorSliceReader> reader_0 = cache.GetReader(
+      filepattern_0, open_function, TensorSliceReader::kLoadAllShards);
+  EXPECT_TRUE(reader_0 != nullptr);
+  EXPECT_EQ(reader_0, cache.GetReader(filepattern_0, open_function,
+                                      TensorSliceReader::kLoadAllShards));
+  std::shared_ptr<const TensorSliceReader> reader_1 = cache.GetReader(
+      filepattern_1, open_function, TensorSliceReader::kLoadAllShards);
+  EXPECT_TRUE(reader_1 != nullptr);
+  EXPECT_EQ(reader_0, cache.GetReader(filepattern_0, open_function,
+                                      TensorSliceReader::kLoadAllShards));
+  EXPECT_TRUE(reader->HasTensor("test", nullptr, nullptr));
+  std::shared_ptr<const TensorSliceReader> reader3 = cache.GetReader(
+      filepattern, open_function, TensorSliceReader::kLoadAllShards);
+  EXPECT_TRUE(reader3 != nullptr);
+  EXPECT_NE(reader, reader3);
+
   reader = cache.GetReader("file_does_not_exist", open_function,
                            TensorSliceReader::kLoadAllShards);
   EXPECT_TRUE(reader == nullptr);
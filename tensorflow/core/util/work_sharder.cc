@@ -15,7 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -35,6 +40,10 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
     workers->ParallelFor(total, cost_per_unit, work);
     return;
   }
+  // Shards of ops running at once share the workers rather than each
+  // assuming all of them are idle.
+  thread::ThreadPool::ParallelRegion region(workers);
+  max_parallelism = std::min(max_parallelism, region.num_threads());
   cost_per_unit = std::max(1LL, cost_per_unit);
   // We shard [0, total) into "num_shards" shards.
   //   1 <= num_shards <= num worker threads
@@ -74,4 +83,71 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
   counter.Wait();
 }
 
+ShardCostEstimator::ShardCostEstimator() {
+  std::fill(scales_, scales_ + kNumBuckets, 0.0);
+}
+
+int ShardCostEstimator::Bucket(int64 total, int64 cost_per_unit) {
+  const int bucket = Log2Floor64(std::max<int64>(1, total)) +
+                     Log2Floor64(std::max<int64>(1, cost_per_unit));
+  return std::min(bucket, kNumBuckets - 1);
+}
+
+int64 ShardCostEstimator::CostPerUnit(int64 total, int64 cost_per_unit) const {
+  double scale;
+  {
+    mutex_lock l(mu_);
+    scale = scales_[Bucket(total, cost_per_unit)];
+  }
+  if (scale == 0) {
+    return cost_per_unit;
+  }
+  const double adjusted = std::max<int64>(1, cost_per_unit) * scale;
+  if (adjusted >= static_cast<double>(std::numeric_limits<int64>::max())) {
+    return std::numeric_limits<int64>::max();
+  }
+  return std::max<int64>(1, static_cast<int64>(adjusted));
+}
+
+void ShardCostEstimator::Record(int64 total, int64 cost_per_unit, int64 units,
+                                int64 nanos) {
+  // Shards too short to be timed carry no information.
+  if (units <= 0 || nanos <= 0) {
+    return;
+  }
+  // The sharding heuristics count one cost unit per nanosecond.
+  const double scale = static_cast<double>(nanos) /
+                       (static_cast<double>(units) *
+                        std::max<int64>(1, cost_per_unit));
+  mutex_lock l(mu_);
+  double& current = scales_[Bucket(total, cost_per_unit)];
+  // Smooth out the noise of single measurements.
+  current = current == 0 ? scale : 0.75 * current + 0.25 * scale;
+}
+
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           int64 cost_per_unit, ShardCostEstimator* estimator,
+           std::function<void(int64, int64)> work) {
+  CHECK(estimator != nullptr);
+  // Time the shard starting at 0, which runs exactly once however the work
+  // is split.
+  auto timed_work = [total, cost_per_unit, estimator, &work](int64 start,
+                                                             int64 limit) {
+    if (start != 0) {
+      work(start, limit);
+      return;
+    }
+    const uint64 start_micros = Env::Default()->NowMicros();
+    work(start, limit);
+    const uint64 end_micros = Env::Default()->NowMicros();
+    // Avoid clock skew.
+    if (end_micros >= start_micros) {
+      estimator->Record(total, cost_per_unit, limit - start,
+                        1000 * (end_micros - start_micros));
+    }
+  };
+  Shard(max_parallelism, workers, total,
+        estimator->CostPerUnit(total, cost_per_unit), timed_work);
+}
+
 }  // end namespace tensorflow
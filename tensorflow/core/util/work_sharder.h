@@ -19,6 +19,8 @@ limitations under the License.
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -48,6 +50,48 @@ namespace tensorflow {
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// Learns how far off the "cost_per_unit" estimate of a sharded loop is from
+// the time its shards actually take, so that later runs of the loop are
+// sharded according to measured rather than estimated costs. Kernels
+// typically own one per call site of Shard() below.
+//
+// The correction is kept separately for each power of two of the estimated
+// total cost of the loop, since the cost of a unit of work often depends on
+// how much data the loop touches.
+//
+// Thread-safe.
+class ShardCostEstimator {
+ public:
+  ShardCostEstimator();
+
+  // Returns the cost per unit to shard "total" units of work with, given
+  // the "cost_per_unit" estimate of the caller.
+  int64 CostPerUnit(int64 total, int64 cost_per_unit) const;
+
+  // Records that "units" of the "total" units of work of a loop with
+  // estimated "cost_per_unit" took "nanos" nanoseconds.
+  void Record(int64 total, int64 cost_per_unit, int64 units, int64 nanos);
+
+ private:
+  static const int kNumBuckets = 64;
+  static int Bucket(int64 total, int64 cost_per_unit);
+
+  mutable mutex mu_;
+  // Measured over estimated cost of each bucket, or 0 if nothing was
+  // recorded for it yet.
+  double scales_[kNumBuckets] GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostEstimator);
+};
+
+// Like Shard() above, but shards with the cost per unit returned by
+// "estimator" and records in it how long the first shard took.
+//
+// REQUIRES: estimator != nullptr
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           int64 cost_per_unit, ShardCostEstimator* estimator,
+           std::function<void(int64, int64)> work);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_UTIL_WORK_SHARDER_H_
@@ -76,6 +76,35 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(ShardCostEstimator, ScalesEstimateByMeasuredCost) {
+  ShardCostEstimator estimator;
+  EXPECT_EQ(10, estimator.CostPerUnit(1000, 10));
+
+  // The first 100 units took 4 times as long as estimated.
+  estimator.Record(1000, 10, 100, 4 * 100 * 10);
+  EXPECT_EQ(40, estimator.CostPerUnit(1000, 10));
+  // Measurements are smoothed.
+  estimator.Record(1000, 10, 100, 100 * 10);
+  EXPECT_EQ(32, estimator.CostPerUnit(1000, 10));
+
+  // Loops of a different size are corrected separately.
+  EXPECT_EQ(10, estimator.CostPerUnit(1 << 20, 10));
+}
+
+TEST(ShardCostEstimator, DoesAllTheWork) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  ShardCostEstimator estimator;
+  for (int run = 0; run < 10; ++run) {
+    std::atomic<int64> num_elements(0);
+    Shard(8, &threads, 100000, 1, &estimator,
+          [&num_elements](int64 start, int64 limit) {
+            num_elements += limit - start;
+          });
+    EXPECT_EQ(100000, num_elements.load());
+  }
+  EXPECT_GE(estimator.CostPerUnit(100000, 1), 1);
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -247,6 +247,58 @@ public final class Session implements AutoCloseable {
       return runHelper(true);
     }
 
+    /**
+     * Prepare the graph fragments necessary to compute the requested fetches, so that they can be
+     * executed repeatedly with different values for the fed outputs.
+     *
+     * <p>Only the outputs passed to the {@code feed} methods of this Runner matter, the tensors
+     * fed with them are not used. The returned {@link Callable} is fed and fetches in the order of
+     * the calls to {@code feed} and {@code fetch}, and is run with the options set by {@link
+     * #setOptions(byte[])}.
+     *
+     * <p><b>WARNING:</b> The caller must call {@link Callable#close()} on the returned {@link
+     * Callable} to free up resources.
+     */
+    public Callable makeCallable() {
+      long[] inputOpHandles = new long[inputs.size()];
+      int[] inputOpIndices = new int[inputs.size()];
+      long[] outputOpHandles = new long[outputs.size()];
+      int[] outputOpIndices = new int[outputs.size()];
+      long[] targetOpHandles = new long[targets.size()];
+
+      int idx = 0;
+      for (Output o : inputs) {
+        inputOpHandles[idx] = o.op().getUnsafeNativeHandle();
+        inputOpIndices[idx] = o.index();
+        idx++;
+      }
+      idx = 0;
+      for (Output o : outputs) {
+        outputOpHandles[idx] = o.op().getUnsafeNativeHandle();
+        outputOpIndices[idx] = o.index();
+        idx++;
+      }
+      idx = 0;
+      for (Operation op : targets) {
+        targetOpHandles[idx++] = op.getUnsafeNativeHandle();
+      }
+      Reference runRef = new Reference();
+      try {
+        long callableHandle =
+            Session.makeCallable(
+                nativeHandle,
+                runOptions,
+                inputOpHandles,
+                inputOpIndices,
+                outputOpHandles,
+                outputOpIndices,
+                targetOpHandles);
+        return new Callable(callableHandle, inputs.size(), outputs.size());
+      } finally {
+        runRef.close();
+      }
+    }
+
     private Run runHelper(boolean wantMetadata) {
       long[] inputTensorHandles = new long[inputTensors.size()];
       long[] inputOpHandles = new long[inputs.size()];
@@ -314,29 +366,6 @@ public final class Session implements AutoCloseable {
       return ret;
     }
 
-    private class Reference implements AutoCloseable {
-      public Reference() {
-        synchronized (nativeHandleLock) {
-          if (nativeHandle == 0) {
-            throw new IllegalStateException("run() cannot be called on the Session after close()");
-          }
-          ++numActiveRuns;
-        }
-      }
-
-      @Override
-      public void close() {
-        synchronized (nativeHandleLock) {
-          if (nativeHandle == 0) {
-            return;
-          }
-          if (--numActiveRuns == 0) {
-            nativeHandleLock.notifyAll();
-          }
-        }
-      }
-    }
-
     private Operation operationByName(String opName) {
       Operation op = graph.operation(opName);
       if (op == null) {
@@ -380,6 +409,97 @@ public final class Session implements AutoCloseable {
     public byte[] metadata;
   }
 
+  /**
+   * Graph fragments prepared by {@link Runner#makeCallable()}, which can be executed repeatedly
+   * without looking up the feeds, fetches and targets again.
+   *
+   * <p><b>WARNING:</b> A {@code Callable} owns resources that <b>must</b> be explicitly freed by
+   * invoking {@link #close()}.
+   */
+  public final class Callable implements AutoCloseable {
+    /**
+     * Execute the graph fragments, feeding {@code inputs} in the order in which they were passed to
+     * {@link Runner#feed(Output, Tensor)} and returning the fetches in the order in which they were
+     * requested.
+     *
+     * <p><b>WARNING:</b> The caller assumes ownership of all returned {@link Tensor}s, i.e., the
+     * caller must call {@link Tensor#close()} on all elements of the returned list to free up
+     * resources.
+     */
+    public List<Tensor> call(List<Tensor> inputs) {
+      if (inputs.size() != numInputs) {
+        throw new IllegalArgumentException(
+            "expected " + numInputs + " input Tensors, got " + inputs.size());
+      }
+      if (callableHandle < 0) {
+        throw new IllegalStateException("call() cannot be called on the Callable after close()");
+      }
+      long[] inputTensorHandles = new long[numInputs];
+      long[] outputTensorHandles = new long[numOutputs];
+      int idx = 0;
+      for (Tensor t : inputs) {
+        inputTensorHandles[idx++] = t.getNativeHandle();
+      }
+      Reference runRef = new Reference();
+      try {
+        Session.runCallable(nativeHandle, callableHandle, inputTensorHandles, outputTensorHandles);
+      } finally {
+        runRef.close();
+      }
+      List<Tensor> outputs = new ArrayList<Tensor>();
+      for (long h : outputTensorHandles) {
+        outputs.add(Tensor.fromHandle(h));
+      }
+      return outputs;
+    }
+
+    /** Release the resources associated with the graph fragments. */
+    @Override
+    public void close() {
+      synchronized (nativeHandleLock) {
+        if (callableHandle < 0 || nativeHandle == 0) {
+          callableHandle = -1;
+          return;
+        }
+        Session.releaseCallable(nativeHandle, callableHandle);
+        callableHandle = -1;
+      }
+    }
+
+    private Callable(long callableHandle, int numInputs, int numOutputs) {
+      this.callableHandle = callableHandle;
+      this.numInputs = numInputs;
+      this.numOutputs = numOutputs;
+    }
+
+    private long callableHandle;
+    private final int numInputs;
+    private final int numOutputs;
+  }
+
+  private class Reference implements AutoCloseable {
+    public Reference() {
+      synchronized (nativeHandleLock) {
+        if (nativeHandle == 0) {
+          throw new IllegalStateException("run() cannot be called on the Session after close()");
+        }
+        ++numActiveRuns;
+      }
+    }
+
+    @Override
+    public void close() {
+      synchronized (nativeHandleLock) {
+        if (nativeHandle == 0) {
+          return;
+        }
+        if (--numActiveRuns == 0) {
+          nativeHandleLock.notifyAll();
+        }
+      }
+    }
+  }
+
   private final Graph graph;
   private final Graph.Reference graphRef;
 
@@ -432,4 +552,29 @@ public final class Session implements AutoCloseable {
       long[] targetOpHandles,
       boolean wantRunMetadata,
       long[] outputTensorHandles);
+
+  /**
+   * Prepare the graph fragments computing the outputs of outputOpHandles and outputOpIndices from
+   * the outputs of inputOpHandles and inputOpIndices, and running targetOpHandles, as in {@link
+   * #run}.
+   *
+   * @return the handle to pass to runCallable and releaseCallable.
+   */
+  private static native long makeCallable(
+      long handle,
+      byte[] runOptions,
+      long[] inputOpHandles,
+      int[] inputOpIndices,
+      long[] outputOpHandles,
+      int[] outputOpIndices,
+      long[] targetOpHandles);
+
+  /**
+   * Execute the graph fragments prepared by makeCallable, feeding inputTensorHandles and filling
+   * outputTensorHandles with handles to the fetched outputs.
+   */
+  private static native void runCallable(
+      long handle, long callableHandle, long[] inputTensorHandles, long[] outputTensorHandles);
+
+  private static native void releaseCallable(long handle, long callableHandle);
 }
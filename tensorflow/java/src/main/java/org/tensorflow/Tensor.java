@@ -199,6 +199,45 @@ public final class Tensor implements AutoCloseable {
     return t;
   }
 
+  /**
+   * Create a Tensor that views the data of a direct buffer, without copying it.
+   *
+   * <p>The tensor holds the {@code data.remaining()} bytes of {@code data} starting from its
+   * current position, encoded as for {@link #create(DataType, long[], ByteBuffer)}. Elements of
+   * primitive types must be in native byte order. The contents of the buffer must not be modified
+   * while the tensor, or a tensor that TensorFlow derived from it, is in use; TensorFlow keeps the
+   * buffer reachable until it releases the memory, which may be after {@link #close()}.
+   *
+   * <p>TensorFlow requires tensor memory to be aligned to 64 bytes. If the data of {@code data} is
+   * not, it is copied instead.
+   *
+   * @param dataType the tensor datatype.
+   * @param shape the tensor shape.
+   * @param data a direct buffer containing the tensor data.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, or if the tensor
+   *     datatype or shape is not compatible with the buffer
+   */
+  public static Tensor createDirect(DataType dataType, long[] shape, ByteBuffer data) {
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("createDirect() requires a direct ByteBuffer");
+    }
+    if (dataType != DataType.STRING) {
+      final int nbytes = numElements(shape) * elemByteSize(dataType);
+      if (data.remaining() != nbytes) {
+        throw new IllegalArgumentException(
+            String.format(
+                "ByteBuffer with %d bytes is not compatible with a %s Tensor with shape %s",
+                data.remaining(), dataType.toString(), Arrays.toString(shape)));
+      }
+    }
+    Tensor t = new Tensor();
+    t.dtype = dataType;
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    t.nativeHandle =
+        allocateDirect(t.dtype.c(), t.shapeCopy, data, data.position(), data.remaining());
+    return t;
+  }
+
   // Helper function to allocate a Tensor for the create() methods that create a Tensor from
   // a java.nio.Buffer.
   private static Tensor allocateForBuffer(DataType dataType, long[] shape, int nBuffered) {
@@ -440,6 +479,18 @@ public final class Tensor implements AutoCloseable {
     dst.put(src);
   }
 
+  /**
+   * Returns a read-only direct buffer, in native byte order, that views the tensor data.
+   *
+   * <p>Unlike {@link #writeTo(ByteBuffer)}, this does not copy the data, which is encoded as per
+   * the specification of the TensorFlow <a
+   * href="https://www.tensorflow.org/code/tensorflow/c/c_api.h">C API</a>. The buffer <b>must
+   * not</b> be used after the Tensor is closed.
+   */
+  public ByteBuffer readOnlyBuffer() {
+    return buffer().asReadOnlyBuffer().order(ByteOrder.nativeOrder());
+  }
+
   /** Returns a string describing the type and shape of the Tensor. */
   @Override
   public String toString() {
@@ -595,6 +646,9 @@ public final class Tensor implements AutoCloseable {
 
   private static native long allocate(int dtype, long[] shape, long byteSize);
 
+  private static native long allocateDirect(
+      int dtype, long[] shape, ByteBuffer buffer, long offset, long byteSize);
+
   private static native long allocateScalarBytes(byte[] value);
 
   private static native void delete(long handle);
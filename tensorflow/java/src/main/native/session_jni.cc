@@ -228,3 +228,95 @@ JNIEXPORT jbyteArray JNICALL Java_org_tensorflow_Session_run(
   }
   return ret;
 }
+
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Session_makeCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jbyteArray jrun_options,
+    jlongArray input_op_handles, jintArray input_op_indices,
+    jlongArray output_op_handles, jintArray output_op_indices,
+    jlongArray target_op_handles) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return 0;
+
+  const jint ninputs = env->GetArrayLength(input_op_handles);
+  const jint noutputs = env->GetArrayLength(output_op_handles);
+  const jint ntargets = env->GetArrayLength(target_op_handles);
+
+  std::unique_ptr<TF_Output[]> inputs(new TF_Output[ninputs]);
+  std::unique_ptr<TF_Output[]> outputs(new TF_Output[noutputs]);
+  std::unique_ptr<TF_Operation* []> targets(new TF_Operation*[ntargets]);
+
+  resolveOutputs(env, "input", input_op_handles, input_op_indices, inputs.get(),
+                 ninputs);
+  resolveOutputs(env, "output", output_op_handles, output_op_indices,
+                 outputs.get(), noutputs);
+  resolveHandles(env, "target Operations", target_op_handles, targets.get(),
+                 ntargets);
+  if (env->ExceptionCheck()) return 0;
+
+  unique_tf_buffer run_options(MakeUniqueBuffer(nullptr));
+  jbyte* jrun_options_data = nullptr;
+  if (jrun_options != nullptr) {
+    size_t sz = env->GetArrayLength(jrun_options);
+    if (sz > 0) {
+      jrun_options_data = env->GetByteArrayElements(jrun_options, nullptr);
+      run_options.reset(
+          TF_NewBufferFromString(static_cast<void*>(jrun_options_data), sz));
+    }
+  }
+
+  TF_Status* status = TF_NewStatus();
+  int64_t callable_handle = 0;
+  TF_SessionMakeCallable(session, run_options.get(), inputs.get(),
+                         static_cast<int>(ninputs), outputs.get(),
+                         static_cast<int>(noutputs), targets.get(),
+                         static_cast<int>(ntargets), &callable_handle, status);
+
+  if (jrun_options_data != nullptr) {
+    env->ReleaseByteArrayElements(jrun_options, jrun_options_data, JNI_ABORT);
+  }
+  bool ok = throwExceptionIfNotOK(env, status);
+  TF_DeleteStatus(status);
+  return ok ? static_cast<jlong>(callable_handle) : 0;
+}
+
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_runCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jlong callable_handle,
+    jlongArray input_tensor_handles, jlongArray output_tensor_handles) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return;
+
+  const jint ninputs = env->GetArrayLength(input_tensor_handles);
+  const jint noutputs = env->GetArrayLength(output_tensor_handles);
+
+  std::unique_ptr<TF_Tensor* []> input_values(new TF_Tensor*[ninputs]);
+  std::unique_ptr<TF_Tensor* []> output_values(new TF_Tensor*[noutputs]);
+  resolveHandles(env, "input Tensors", input_tensor_handles, input_values.get(),
+                 ninputs);
+  if (env->ExceptionCheck()) return;
+
+  TF_Status* status = TF_NewStatus();
+  TF_SessionRunCallable(session, static_cast<int64_t>(callable_handle),
+                        input_values.get(), static_cast<int>(ninputs),
+                        output_values.get(), static_cast<int>(noutputs),
+                        nullptr, status);
+  bool ok = throwExceptionIfNotOK(env, status);
+  TF_DeleteStatus(status);
+  if (!ok) return;
+
+  jlong* t = env->GetLongArrayElements(output_tensor_handles, nullptr);
+  for (int i = 0; i < noutputs; ++i) {
+    t[i] = reinterpret_cast<jlong>(output_values[i]);
+  }
+  env->ReleaseLongArrayElements(output_tensor_handles, t, 0);
+}
+
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_releaseCallable(
+    JNIEnv* env, jclass clazz, jlong handle, jlong callable_handle) {
+  TF_Session* session = requireHandle(env, handle);
+  if (session == nullptr) return;
+  TF_Status* status = TF_NewStatus();
+  TF_SessionReleaseCallable(session, static_cast<int64_t>(callable_handle),
+                            status);
+  throwExceptionIfNotOK(env, status);
+  TF_DeleteStatus(status);
+}
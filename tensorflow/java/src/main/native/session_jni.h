@@ -56,6 +56,36 @@ JNIEXPORT jbyteArray JNICALL Java_org_tensorflow_Session_run(
     JNIEnv *, jclass, jlong, jbyteArray, jlongArray, jlongArray, jintArray,
     jlongArray, jintArray, jlongArray, jboolean, jlongArray);
 
+/*
+ * Class:     org_tensorflow_Session
+ * Method:    makeCallable
+ * Signature: (J[B[J[I[J[I[J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Session_makeCallable(
+    JNIEnv *, jclass, jlong, jbyteArray, jlongArray, jintArray, jlongArray,
+    jintArray, jlongArray);
+
+/*
+ * Class:     org_tensorflow_Session
+ * Method:    runCallable
+ * Signature: (JJ[J[J)V
+ */
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_runCallable(JNIEnv *,
+                                                               jclass, jlong,
+                                                               jlong,
+                                                               jlongArray,
+                                                               jlongArray);
+
+/*
+ * Class:     org_tensorflow_Session
+ * Method:    releaseCallable
+ * Signature: (JJ)V
+ */
+JNIEXPORT void JNICALL Java_org_tensorflow_Session_releaseCallable(JNIEnv *,
+                                                                   jclass,
+                                                                   jlong,
+                                                                   jlong);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -213,6 +213,37 @@ size_t readNDArray(JNIEnv* env, TF_DataType dtype, const char* src,
     return sz;
   }
 }
+
+// The argument of the deallocator of a tensor that views the memory of a
+// direct java.nio.ByteBuffer: a global reference keeps the buffer alive.
+struct DirectBufferRef {
+  JavaVM* vm;
+  jobject buffer;
+};
+
+// Releases the reference to the buffer viewed by a tensor. TensorFlow may
+// release the last reference to the tensor on one of its own threads, which
+// are attached to the JVM for the duration of the call.
+void releaseDirectBuffer(void* data, size_t len, void* arg) {
+  DirectBufferRef* ref = static_cast<DirectBufferRef*>(arg);
+  JNIEnv* env = nullptr;
+  bool attached = false;
+  if (ref->vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) ==
+      JNI_EDETACHED) {
+    if (ref->vm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env),
+                                             nullptr) != JNI_OK) {
+      // The JVM is shutting down, which releases the buffer anyway.
+      delete ref;
+      return;
+    }
+    attached = true;
+  }
+  env->DeleteGlobalRef(ref->buffer);
+  if (attached) {
+    ref->vm->DetachCurrentThread();
+  }
+  delete ref;
+}
 }  // namespace
 
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
@@ -254,28 +285,59 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
   return reinterpret_cast<jlong>(t);
 }
 
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject buffer,
+    jlong offset, jlong sizeInBytes) {
+  char* address = static_cast<char*>(env->GetDirectBufferAddress(buffer));
+  if (address == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "the ByteBuffer is not a direct buffer");
+    return 0;
+  }
+  const int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  static_assert(sizeof(jlong) == sizeof(int64_t),
+                "Java long is not compatible with the TensorFlow C API");
+  // See Java_org_tensorflow_Tensor_allocate for why the dimensions are copied.
+  std::unique_ptr<int64_t[]> dims(new int64_t[num_dims]);
+  if (num_dims > 0) {
+    jlong* jdims = env->GetLongArrayElements(shape, nullptr);
+    for (int i = 0; i < num_dims; ++i) {
+      dims[i] = static_cast<int64_t>(jdims[i]);
+    }
+    env->ReleaseLongArrayElements(shape, jdims, JNI_ABORT);
+  }
+  DirectBufferRef* ref = new DirectBufferRef;
+  if (env->GetJavaVM(&ref->vm) != JNI_OK) {
+    delete ref;
+    throwException(env, kIllegalStateException, "unable to get the JavaVM");
+    return 0;
+  }
+  ref->buffer = env->NewGlobalRef(buffer);
+  // TF_NewTensor copies the data, and releases the buffer right away, if its
+  // address is not suitably aligned. Otherwise the tensor views the buffer
+  // until TensorFlow releases its last reference to the tensor.
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.get(),
+                              num_dims, address + offset,
+                              static_cast<size_t>(sizeInBytes),
+                              releaseDirectBuffer, ref);
+  return reinterpret_cast<jlong>(t);
+}
+
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateScalarBytes(
     JNIEnv* env, jclass clazz, jbyteArray value) {
-  // TF_STRING tensors are encoded with a table of 8-byte offsets followed by
-  // TF_StringEncode-encoded bytes.
-  size_t src_len = static_cast<int>(env->GetArrayLength(value));
-  size_t dst_len = TF_StringEncodedSize(src_len);
-  TF_Tensor* t = TF_AllocateTensor(TF_STRING, nullptr, 0, 8 + dst_len);
-  char* dst = static_cast<char*>(TF_TensorData(t));
-  memset(dst, 0, 8);  // The offset table
-
+  // The bytes are copied directly into the string representation used by
+  // TensorFlow, so that the tensor doesn't need to be decoded when fed.
+  //
   // jbyte is a signed char, while the C standard doesn't require char and
-  // signed char to be the same. As a result, static_cast<char*>(src) will
-  // complain. Copy the string instead. sigh!
-  jbyte* jsrc = env->GetByteArrayElements(value, nullptr);
-  std::unique_ptr<char[]> src(new char[src_len]);
+  // signed char to be the same, so reinterpret the elements as chars.
   static_assert(sizeof(jbyte) == sizeof(char),
                 "Cannot convert Java byte to a C char");
-  memcpy(src.get(), jsrc, src_len);
-  env->ReleaseByteArrayElements(value, jsrc, JNI_ABORT);
-
+  const size_t src_len = static_cast<size_t>(env->GetArrayLength(value));
+  jbyte* jsrc = env->GetByteArrayElements(value, nullptr);
+  const char* src = reinterpret_cast<const char*>(jsrc);
   TF_Status* status = TF_NewStatus();
-  TF_StringEncode(src.get(), src_len, dst + 8, dst_len, status);
+  TF_Tensor* t = TF_NewStringTensor(nullptr, 0, &src, &src_len, status);
+  env->ReleaseByteArrayElements(value, jsrc, JNI_ABORT);
   if (!throwExceptionIfNotOK(env, status)) {
     TF_DeleteStatus(status);
     return 0;
@@ -383,26 +445,17 @@ JNIEXPORT jbyteArray JNICALL Java_org_tensorflow_Tensor_scalarBytes(
                    "Tensor is not a string/bytes scalar");
     return nullptr;
   }
-  const char* data = static_cast<const char*>(TF_TensorData(t));
-  const char* src = data + 8;
-  size_t src_len = TF_TensorByteSize(t) - 8;
-  uint64_t offset = 0;
-  memcpy(&offset, data, sizeof(offset));
-  if (offset >= src_len) {
-    throwException(env, kIllegalArgumentException,
-                   "invalid tensor encoding: bad offsets");
-    return nullptr;
-  }
+  // Read the string in place, which avoids encoding the strings of a tensor
+  // produced by TensorFlow.
   jbyteArray ret = nullptr;
-  const char* dst = nullptr;
-  size_t dst_len = 0;
+  const char* src = nullptr;
+  size_t src_len = 0;
   TF_Status* status = TF_NewStatus();
-  TF_StringDecode(src, src_len, &dst, &dst_len, status);
+  TF_TensorStringElement(t, 0, &src, &src_len, status);
   if (throwExceptionIfNotOK(env, status)) {
-    ret = env->NewByteArray(dst_len);
-    jbyte* cpy = env->GetByteArrayElements(ret, nullptr);
-    memcpy(cpy, dst, dst_len);
-    env->ReleaseByteArrayElements(ret, cpy, 0);
+    ret = env->NewByteArray(src_len);
+    env->SetByteArrayRegion(ret, 0, src_len,
+                            reinterpret_cast<const jbyte*>(src));
   }
   TF_DeleteStatus(status);
   return ret;
@@ -30,6 +30,14 @@ extern "C" {
 JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv *, jclass,
                                                             jint, jlongArray, jlong);
 
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    allocateDirect
+ * Signature: (I[JLjava/nio/ByteBuffer;JJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateDirect(
+    JNIEnv *, jclass, jint, jlongArray, jobject, jlong, jlong);
+
 /*
  * Class:     org_tensorflow_Tensor
  * Method:    allocateScalarBytes
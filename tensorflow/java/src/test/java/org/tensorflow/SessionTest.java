@@ -21,6 +21,7 @@ import static org.junit.Assert.assertTrue;
 import static org.junit.Assert.fail;
 
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.Collection;
 import org.junit.Test;
 import org.junit.runner.RunWith;
@@ -62,6 +63,26 @@ public class SessionTest {
     }
   }
 
+  @Test
+  public void runCallable() {
+    try (Graph g = new Graph();
+        Session s = new Session(g)) {
+      TestUtil.transpose_A_times_X(g, new int[][] {{2}, {3}});
+      try (Tensor x = Tensor.create(new int[][] {{5}, {7}});
+          Session.Callable callable = s.runner().feed("X", x).fetch("Y").makeCallable()) {
+        for (int i = 0; i < 2; ++i) {
+          try (Tensor xi = Tensor.create(new int[][] {{5 + i}, {7}});
+              AutoCloseableList<Tensor> outputs =
+                  new AutoCloseableList<Tensor>(callable.call(Arrays.asList(xi)))) {
+            assertEquals(1, outputs.size());
+            final int[][] expected = {{31 + 2 * i}};
+            assertArrayEquals(expected, outputs.get(0).copyTo(new int[1][1]));
+          }
+        }
+      }
+    }
+  }
+
   @Test
   public void runWithMetadata() {
     try (Graph g = new Graph();
@@ -86,6 +86,45 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void createDirect() {
+    double[] doubles = {1d, 2d, 3d, 4d};
+    ByteBuffer buf = ByteBuffer.allocateDirect(8 * doubles.length).order(ByteOrder.nativeOrder());
+    buf.asDoubleBuffer().put(doubles);
+    try (Tensor t = Tensor.createDirect(DataType.DOUBLE, new long[] {2, 2}, buf)) {
+      assertArrayEquals(new long[] {2, 2}, t.shape());
+      double[][] actual = t.copyTo(new double[2][2]);
+      assertArrayEquals(new double[] {1d, 2d}, actual[0], EPSILON);
+      assertArrayEquals(new double[] {3d, 4d}, actual[1], EPSILON);
+    }
+
+    try (Tensor t = Tensor.createDirect(DataType.DOUBLE, new long[] {4}, ByteBuffer.allocate(32))) {
+      fail("should have failed on a non-direct buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+    try (Tensor t = Tensor.createDirect(DataType.DOUBLE, new long[] {5}, buf)) {
+      fail("should have failed on incompatible buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+  }
+
+  @Test
+  public void readOnlyBuffer() {
+    float[] floats = {1f, 2f, 3f};
+    try (Tensor t = Tensor.create(floats)) {
+      ByteBuffer buf = t.readOnlyBuffer();
+      assertTrue(buf.isDirect());
+      assertTrue(buf.isReadOnly());
+      assertEquals(t.numBytes(), buf.remaining());
+      FloatBuffer actual = buf.asFloatBuffer();
+      for (int i = 0; i < floats.length; ++i) {
+        assertEquals(floats[i], actual.get(i), EPSILON_F);
+      }
+    }
+  }
+
   @Test
   public void createFromBufferWithNonNativeByteOrder() {
     double[] doubles = {1d, 2d, 3d, 4d};
@@ -119,6 +119,10 @@ class BatchMatmulOpTest(test.TestCase):
     compareNonEmpty(self, [7, 2, 3], [7, 3, 5])
     compareNonEmpty(self, [10, 64, 75], [10, 75, 30])
     compareNonEmpty(self, [5, 7, 2, 3], [5, 7, 3, 5])
+    # Square matrices of the sizes with specialized CPU kernels.
+    compareNonEmpty(self, [3, 4, 4], [3, 4, 4])
+    compareNonEmpty(self, [50, 8, 8], [50, 8, 8])
+    compareNonEmpty(self, [2, 3, 16, 16], [2, 3, 16, 16])
 
   def _testEmpty(self, dtype, adjoint_a, adjoint_b, use_static_shape):
 
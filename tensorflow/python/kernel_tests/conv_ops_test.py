@@ -1377,6 +1377,29 @@ class DeepConv2DTest(test.TestCase):
   def testConv2D3x3FilterStride1x1Same(self):
     self._RunTestCases([1, 1], "SAME")
 
+  def testConv2D3x3FilterAutotune(self):
+    # The first run of each shape times and outputs every algorithm, the
+    # second one the one picked, the F(4x4, 3x3) transform being the least
+    # precise of them.
+    input_sizes = [[3, 17, 17, 192], [2, 7, 4, 81]]
+    filter_sizes = [[3, 3, 192, 192], [3, 3, 81, 77]]
+    for input_shape, filter_shape in zip(input_sizes, filter_sizes):
+      x1 = np.random.rand(*input_shape).astype(np.float32)
+      x2 = np.random.rand(*filter_shape).astype(np.float32)
+      with self.test_session(use_gpu=False) as sess:
+        conv = nn_ops.conv2d(
+            constant_op.constant(x1), constant_op.constant(x2),
+            strides=[1, 1, 1, 1], padding="SAME")
+        os.environ["TF_CPU_CONV_USE_AUTOTUNE"] = "0"
+        values_expect = sess.run(conv)
+        try:
+          os.environ["TF_CPU_CONV_USE_AUTOTUNE"] = "1"
+          for _ in range(2):
+            self.assertAllClose(
+                values_expect, sess.run(conv), rtol=1e-4, atol=1e-4)
+        finally:
+          os.environ["TF_CPU_CONV_USE_AUTOTUNE"] = "0"
+
 
 class Conv2DBenchmark(test.Benchmark):
 
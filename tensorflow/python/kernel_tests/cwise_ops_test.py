@@ -1073,6 +1073,18 @@ class BinaryOpTest(test.TestCase):
   def testBCast_15D(self):
     self._testBCastD([10, 3, 1, 2], [3, 1, 2])
 
+  def testBCast_16A(self):
+    self._testBCastA([2, 3, 4], [2, 1, 4])
+
+  def testBCast_16B(self):
+    self._testBCastB([2, 3, 4], [2, 1, 4])
+
+  def testBCast_16C(self):
+    self._testBCastC([2, 3, 4], [2, 1, 4])
+
+  def testBCast_16D(self):
+    self._testBCastD([2, 3, 4], [2, 1, 4])
+
   def testMismatchedDimensions(self):
     for func in [
         math_ops.add, math_ops.subtract, math_ops.multiply, math_ops.div,
@@ -118,6 +118,32 @@ class DecodeCSVOpTest(test.TestCase):
 
     self._test(args, expected_out)
 
+  def testManyRecords(self):
+    # Enough records for the decoding to be split across threads.
+    num_records = 10000
+    args = {
+        "records": ['%d,"%d",%d.5,"a""%d"' % (i, i * 3, i, i)
+                    for i in range(num_records)],
+        "record_defaults": [[0], np.array([0], dtype=np.int64), [0.0], [""]]
+    }
+
+    expected_out = [
+        np.arange(num_records), np.arange(num_records) * 3,
+        np.arange(num_records) + 0.5,
+        [('a"%d' % i).encode() for i in range(num_records)]
+    ]
+
+    self._test(args, expected_out)
+
+  def testManyRecordsFirstError(self):
+    records = ["1,2"] * 10000
+    records[7000] = "3,x"
+    records[9000] = "4"
+    args = {"records": records, "record_defaults": [[0], [0]]}
+
+    self._test(
+        args, expected_err_re="Field 1 in record 7000 is not a valid int32: x")
+
   def testWithoutDefaultsError(self):
     args = {
         "records": [",1", "0.2,3", "3.0,"],
@@ -52,6 +52,7 @@ class FIFOQueueTest(test.TestCase):
       attr { key: 'capacity' value { i: 10 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testMultiQueueConstructor(self):
@@ -70,6 +71,7 @@ class FIFOQueueTest(test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: 'foo' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testConstructorWithShapes(self):
@@ -96,6 +98,7 @@ class FIFOQueueTest(test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
 
   def testEnqueue(self):
@@ -1430,6 +1433,7 @@ class FIFOQueueDictTest(test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: 'foo' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
     self.assertEqual(["i", "j"], q.names)
 
@@ -1458,6 +1462,7 @@ class FIFOQueueDictTest(test.TestCase):
       attr { key: 'capacity' value { i: 5 } }
       attr { key: 'container' value { s: '' } }
       attr { key: 'shared_name' value { s: '' } }
+      attr { key: 'lock_free' value { b: false } }
       """, q.queue_ref.op.node_def)
     self.assertEqual(["i", "f"], q.names)
 
@@ -1571,6 +1576,174 @@ class FIFOQueueDictTest(test.TestCase):
       self.assertTrue([compat.as_bytes("dd"), compat.as_bytes("ee")], list(s))
 
 
+class LockFreeFIFOQueueTest(test.TestCase):
+
+  def testEnqueueAndDequeue(self):
+    with self.test_session():
+      q = data_flow_ops.FIFOQueue(
+          10, (dtypes_lib.int32, dtypes_lib.string), lock_free=True)
+      for i in xrange(3):
+        q.enqueue((i, str(i))).run()
+      self.assertEqual(3, q.size().eval())
+      for i in xrange(3):
+        self.assertEqual([i, compat.as_bytes(str(i))], q.dequeue().eval())
+      self.assertEqual(0, q.size().eval())
+
+  def testEnqueueManyAndDequeueMany(self):
+    with self.test_session():
+      q = data_flow_ops.FIFOQueue(
+          10, (dtypes_lib.float32, dtypes_lib.string), ((2,), ()),
+          lock_free=True)
+      floats = np.arange(12, dtype=np.float32).reshape(6, 2)
+      strings = [compat.as_bytes(str(i)) for i in xrange(6)]
+      q.enqueue_many((floats[:4], strings[:4])).run()
+      q.enqueue_many((floats[4:], strings[4:])).run()
+      dequeued_floats, dequeued_strings = q.dequeue_many(5).eval()
+      self.assertAllEqual(floats[:5], dequeued_floats)
+      self.assertAllEqual(strings[:5], dequeued_strings)
+      self.assertAllEqual(floats[5:], q.dequeue()[0].eval()[np.newaxis])
+
+  def testParallelEnqueueAndDequeueMany(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(8, dtypes_lib.int32, (), lock_free=True)
+      enqueue_ops = [q.enqueue_many(([10 * i + j for j in xrange(10)],))
+                     for i in xrange(10)]
+      dequeued_t = q.dequeue_many(5)
+      dequeued = []
+
+      def enqueue(enqueue_op):
+        sess.run(enqueue_op)
+
+      def dequeue():
+        for _ in xrange(10):
+          dequeued.extend(sess.run(dequeued_t))
+
+      threads = [self.checkedThread(target=enqueue, args=(enqueue_op,))
+                 for enqueue_op in enqueue_ops]
+      threads += [self.checkedThread(target=dequeue) for _ in xrange(2)]
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+      self.assertItemsEqual(xrange(100), dequeued)
+
+  def testBlockingDequeueUpToFromClosedQueue(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(10, dtypes_lib.float32, (), lock_free=True)
+      dequeued_t = q.dequeue_up_to(3)
+      q.enqueue((10.0,)).run()
+
+      def dequeue():
+        self.assertAllEqual([10.0], sess.run(dequeued_t))
+        with self.assertRaisesRegexp(errors_impl.OutOfRangeError,
+                                     "is closed and has insufficient"):
+          sess.run(dequeued_t)
+
+      dequeue_thread = self.checkedThread(target=dequeue)
+      dequeue_thread.start()
+      # The close_op should run after the dequeue_thread has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      q.close().run()
+      dequeue_thread.join()
+
+  def testBlockingDequeueManyFromClosedQueueKeepsElements(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(4, dtypes_lib.float32, (), lock_free=True)
+      q.enqueue_many(([10.0, 20.0],)).run()
+      dequeued_t = q.dequeue_many(3)
+
+      def dequeue():
+        with self.assertRaisesRegexp(errors_impl.OutOfRangeError,
+                                     "is closed and has insufficient"):
+          sess.run(dequeued_t)
+
+      dequeue_thread = self.checkedThread(target=dequeue)
+      dequeue_thread.start()
+      # The close_op should run after the dequeue_thread has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      q.close().run()
+      dequeue_thread.join()
+      # The failed dequeue took none of the elements.
+      self.assertAllEqual([10.0, 20.0], q.dequeue_up_to(3).eval())
+
+  def testDequeueManyLargerThanCapacity(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(2, dtypes_lib.float32, (), lock_free=True)
+      with self.assertRaisesOpError("more than its capacity"):
+        q.dequeue_many(3).eval()
+
+      # DequeueUpTo may take more than the capacity, a few elements at a
+      # time, and gets the elements it took so far when the queue is closed.
+      dequeued_t = q.dequeue_up_to(3)
+      results = []
+
+      def dequeue():
+        results.append(sess.run(dequeued_t))
+        results.append(sess.run(dequeued_t))
+
+      dequeue_thread = self.checkedThread(target=dequeue)
+      dequeue_thread.start()
+      q.enqueue_many(([10.0, 20.0, 30.0, 40.0],)).run()
+      # The close_op should run after the second dequeue has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      q.close().run()
+      dequeue_thread.join()
+      self.assertAllEqual([10.0, 20.0, 30.0], results[0])
+      self.assertAllEqual([40.0], results[1])
+
+  def testBlockingEnqueueBeforeClose(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.FIFOQueue(2, dtypes_lib.float32, (), lock_free=True)
+      q.enqueue_many(([10.0, 20.0],)).run()
+      blocking_enqueue_op = q.enqueue((30.0,))
+
+      def blocking_enqueue():
+        sess.run(blocking_enqueue_op)
+
+      enqueue_thread = self.checkedThread(target=blocking_enqueue)
+      enqueue_thread.start()
+      # The close_op should run after the blocking_enqueue_op has blocked.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      close_op = q.close()
+      close_thread = self.checkedThread(target=close_op.run)
+      close_thread.start()
+
+      dequeued_t = q.dequeue()
+      self.assertEqual(10.0, dequeued_t.eval())
+      enqueue_thread.join()
+      close_thread.join()
+      self.assertEqual(20.0, dequeued_t.eval())
+      self.assertEqual(30.0, dequeued_t.eval())
+      with self.assertRaisesRegexp(errors_impl.CancelledError, "is closed"):
+        q.enqueue((40.0,)).run()
+
+  def testRequiresCapacity(self):
+    with self.test_session():
+      q = data_flow_ops.FIFOQueue(-1, dtypes_lib.float32, lock_free=True)
+      with self.assertRaisesOpError("requires a positive capacity"):
+        q.queue_ref.op.run()
+
+  def testIncompatibleSharedQueueErrors(self):
+    with self.test_session():
+      q_a_1 = data_flow_ops.FIFOQueue(
+          10, dtypes_lib.float32, shared_name="q_a", lock_free=True)
+      q_a_2 = data_flow_ops.FIFOQueue(10, dtypes_lib.float32, shared_name="q_a")
+      q_a_1.queue_ref.op.run()
+      with self.assertRaisesOpError("lock-free"):
+        q_a_2.queue_ref.op.run()
+
+      q_b_1 = data_flow_ops.FIFOQueue(10, dtypes_lib.float32, shared_name="q_b")
+      q_b_2 = data_flow_ops.FIFOQueue(
+          10, dtypes_lib.float32, shared_name="q_b", lock_free=True)
+      q_b_1.queue_ref.op.run()
+      with self.assertRaisesOpError("lock-free"):
+        q_b_2.queue_ref.op.run()
+
+
 class FIFOQueueWithTimeoutTest(test.TestCase):
 
   def testDequeueWithTimeout(self):
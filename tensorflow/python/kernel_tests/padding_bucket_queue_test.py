@@ -0,0 +1,120 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for tensorflow.ops.data_flow_ops.PaddingBucketQueue."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.python.framework import dtypes as dtypes_lib
+from tensorflow.python.framework import errors_impl
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.platform import test
+
+
+class PaddingBucketQueueTest(test.TestCase):
+
+  def _enqueueSequences(self, q, lengths):
+    elem = array_ops.placeholder(dtypes_lib.int32, shape=(None,))
+    enqueue_op = q.enqueue((elem,))
+    for length in lengths:
+      enqueue_op.run({elem: np.arange(1, length + 1, dtype=np.int32)})
+
+  def _padded(self, lengths):
+    result = np.zeros((len(lengths), max(lengths)), dtype=np.int32)
+    for i, length in enumerate(lengths):
+      result[i, :length] = np.arange(1, length + 1)
+    return result
+
+  def testDequeueManyFromSingleBucket(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, dtypes_lib.int32, ((None,),), bucket_boundaries=[4])
+      self._enqueueSequences(q, [1, 5, 2, 6])
+      dequeued_t = q.dequeue_many(2)
+      self.assertEqual(4, q.size().eval())
+
+      self.assertAllEqual(self._padded([1, 2]), dequeued_t.eval())
+      self.assertAllEqual(self._padded([5, 6]), dequeued_t.eval())
+      self.assertEqual(0, q.size().eval())
+
+  def testDequeueUsesFullestBucket(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, dtypes_lib.int32, ((None,),), bucket_boundaries=[4])
+      self._enqueueSequences(q, [1, 5, 6])
+      dequeued_t = q.dequeue()
+
+      self.assertAllEqual([1, 2, 3, 4, 5], dequeued_t.eval())
+      self.assertAllEqual([1], dequeued_t.eval())
+      self.assertAllEqual([1, 2, 3, 4, 5, 6], dequeued_t.eval())
+
+  def testFullQueueDequeuesMixedBatch(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          3, dtypes_lib.int32, ((None,),), bucket_boundaries=[2, 4])
+      self._enqueueSequences(q, [1, 3, 5])
+      dequeued_t = q.dequeue_many(2)
+
+      # No bucket holds two elements, the batch takes the only element of
+      # the first bucket and completes it from the next one.
+      self.assertAllEqual(self._padded([1, 3]), dequeued_t.eval())
+      self.assertEqual(1, q.size().eval())
+
+  def testDequeueUpToFromClosedQueueReturnsBuckets(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, dtypes_lib.int32, ((None,),), bucket_boundaries=[3])
+      self._enqueueSequences(q, [4, 1, 5, 2, 6])
+      q.close().run()
+      dequeued_t = q.dequeue_up_to(4)
+
+      self.assertAllEqual(self._padded([4, 5, 6]), dequeued_t.eval())
+      self.assertAllEqual(self._padded([1, 2]), dequeued_t.eval())
+      with self.assertRaisesRegexp(errors_impl.OutOfRangeError,
+                                   "is closed and has insufficient"):
+        dequeued_t.eval()
+
+  def testEnqueueManyBucketsByPaddedSize(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, dtypes_lib.int32, ((None,),), bucket_boundaries=[3])
+      q.enqueue_many(([[1, 2, 3, 4]],)).run()
+      q.enqueue_many(([[1], [2]],)).run()
+      dequeued_t = q.dequeue_many(2)
+
+      self.assertAllEqual([[1], [2]], dequeued_t.eval())
+
+  def testScalarBucketComponentFails(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, (dtypes_lib.int32, dtypes_lib.int32), ((), (None,)),
+          bucket_boundaries=[3])
+      with self.assertRaisesOpError("has no dimension to bucket by"):
+        q.size().eval()
+
+  def testDecreasingBoundariesFail(self):
+    with self.test_session():
+      q = data_flow_ops.PaddingBucketQueue(
+          10, dtypes_lib.int32, ((None,),), bucket_boundaries=[4, 2])
+      with self.assertRaisesOpError("must be strictly increasing"):
+        q.size().eval()
+
+
+if __name__ == "__main__":
+  test.main()
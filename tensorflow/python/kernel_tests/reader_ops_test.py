@@ -512,6 +512,55 @@ class TFRecordReaderTest(test.TestCase):
       self.assertEqual(self._num_files * self._num_records, num_k)
       self.assertEqual(self._num_files * self._num_records, num_v)
 
+  def testReadParallelFiles(self):
+    self._num_files = 3
+    files = self._CreateFiles()
+    with self.test_session() as sess:
+      reader = io_ops.TFRecordReader(name="test_reader", num_parallel_files=2)
+      queue = data_flow_ops.FIFOQueue(99, [dtypes.string], shapes=())
+      key, value = reader.read(queue)
+
+      queue.enqueue_many([files]).run()
+      queue.close().run()
+      # The first two files are interleaved, and the third one takes the
+      # place of the first when it ends.
+      expected = [(i % 2, i // 2) for i in range(2 * self._num_records)]
+      expected += [(2, j) for j in range(self._num_records)]
+      for i, j in expected:
+        k, v = sess.run([key, value])
+        self.assertTrue(compat.as_text(k).startswith("%s:" % files[i]))
+        self.assertAllEqual(self._Record(i, j), v)
+
+      with self.assertRaisesOpError("is closed and has insufficient elements "
+                                    "\\(requested 1, current size 0\\)"):
+        k, v = sess.run([key, value])
+      self.assertEqual(self._num_files,
+                       reader.num_work_units_completed().eval())
+
+  def testReadParallelFilesSloppy(self):
+    self._num_files = 5
+    files = self._CreateFiles()
+    with self.test_session() as sess:
+      reader = io_ops.TFRecordReader(
+          name="test_reader", num_parallel_files=3, sloppy=True)
+      queue = data_flow_ops.FIFOQueue(99, [dtypes.string], shapes=())
+      key, value = reader.read_up_to(queue, 4)
+
+      queue.enqueue_many([files]).run()
+      queue.close().run()
+      values = []
+      while True:
+        try:
+          k, v = sess.run([key, value])
+          self.assertLessEqual(len(k), 4)
+          values.extend(v)
+        except errors_impl.OutOfRangeError:
+          break
+
+      expected = [self._Record(i, j) for i in range(self._num_files)
+                  for j in range(self._num_records)]
+      self.assertItemsEqual(expected, values)
+
   def testReadZlibFiles(self):
     files = self._CreateFiles()
     zlib_files = []
@@ -75,6 +75,34 @@ class RecordInputOpTest(test.TestCase):
           self.assertTrue(r[0] not in epoch_set)
           epoch_set.add(r[0])
 
+  def testRecordInputSpillEpochs(self):
+    files = 10
+    records_per_file = 100
+    with self.test_session() as sess:
+      self.generateTestData("basic", files, records_per_file)
+      spill_dir = os.path.join(self.get_temp_dir(), "spill")
+      os.mkdir(spill_dir)
+
+      records = data_flow_ops.RecordInput(
+          file_pattern=os.path.join(self.get_temp_dir(), "basic.*"),
+          parallelism=2,
+          buffer_size=10,
+          batch_size=1,
+          seed=10,
+          spill_dir=spill_dir,
+          num_spill_files=8,
+          name="record_input")
+
+      yield_op = records.get_yield_op()
+
+      # Every epoch yields each record once, in an order that is shuffled
+      # across files despite the small buffer.
+      for _ in range(2):
+        epoch = [sess.run(yield_op)[0] for _ in range(files * records_per_file)]
+        self.assertEqual(files * records_per_file, len(set(epoch)))
+        first_files = set(int(r) // records_per_file for r in epoch[:100])
+        self.assertGreater(len(first_files), 5)
+
 
 if __name__ == "__main__":
   test.main()
@@ -17,10 +17,16 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.client import session
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
 from tensorflow.python.ops import gen_io_ops
+from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.platform import test
+from tensorflow.python.training import training_ops
 
 
 class ShardedFileOpsTest(test.TestCase):
@@ -36,5 +42,81 @@ class ShardedFileOpsTest(test.TestCase):
           b"foo-?????-of-00100")
 
 
+class SaveDeltaV2Test(test.TestCase):
+
+  def _variable(self, name, value):
+    handle = resource_variable_ops.var_handle_op(
+        dtype=dtypes.float32, shape=[4, 2], shared_name=name)
+    resource_variable_ops.assign_variable_op(
+        handle, constant_op.constant(value, dtype=dtypes.float32)).run()
+    return handle
+
+  def _save(self, prefix, base_prefix, names, handles):
+    gen_io_ops.save_delta_v2(prefix, base_prefix, names, [""] * len(names),
+                             handles).run()
+
+  def _restore(self, prefix, name):
+    return gen_io_ops.restore_v2(prefix, [name], [""],
+                                 [dtypes.float32])[0].eval()
+
+  def testSavesScatteredRows(self):
+    base = os.path.join(self.get_temp_dir(), "base")
+    delta = os.path.join(self.get_temp_dir(), "delta")
+    with self.test_session():
+      var = self._variable("var", [[1, 1], [2, 2], [3, 3], [4, 4]])
+      self._save(base, "", ["var"], [var])
+      resource_variable_ops.resource_scatter_add(
+          var, [2, 1], constant_op.constant([[20., 20.], [10., 10.]])).run()
+      self._save(delta, base, ["var"], [var])
+      self.assertAllEqual([[1, 1], [2, 2], [3, 3], [4, 4]],
+                          self._restore(base, "var"))
+      self.assertAllEqual([[1, 1], [12, 12], [23, 23], [4, 4]],
+                          self._restore(delta, "var"))
+
+      # The delta holds only rows 1 and 2: the others are read from the base.
+      gen_io_ops.save_v2(base, ["var"], [""],
+                         [constant_op.constant([[-1., -1.]] * 4)]).run()
+      self.assertAllEqual([[-1, -1], [12, 12], [23, 23], [-1, -1]],
+                          self._restore(delta, "var"))
+
+  def testChainsSparseApplyUpdates(self):
+    prefixes = [
+        os.path.join(self.get_temp_dir(), "ckpt-%d" % i) for i in range(3)
+    ]
+    with self.test_session():
+      var = self._variable("var", [[1, 1], [1, 1], [1, 1], [1, 1]])
+      accum = self._variable("accum", [[1, 1], [1, 1], [1, 1], [1, 1]])
+      names = ["var", "accum"]
+      self._save(prefixes[0], "", names, [var, accum])
+      training_ops.resource_sparse_apply_adagrad(
+          var, accum, constant_op.constant(1.),
+          constant_op.constant([[3., 3.]]), [3]).run()
+      self._save(prefixes[1], prefixes[0], names, [var, accum])
+      training_ops.resource_sparse_apply_adagrad(
+          var, accum, constant_op.constant(1.),
+          constant_op.constant([[0., 0.]]), [0]).run()
+      self._save(prefixes[2], prefixes[1], names, [var, accum])
+
+      self.assertAllClose([[1, 1], [1, 1], [1, 1], [10, 10]],
+                          self._restore(prefixes[2], "accum"))
+      self.assertAllClose([[1, 1], [1, 1], [1, 1], [1 - 3 / 10**0.5] * 2],
+                          self._restore(prefixes[2], "var"))
+
+  def testSavesDenseUpdatesInFull(self):
+    base = os.path.join(self.get_temp_dir(), "base")
+    delta = os.path.join(self.get_temp_dir(), "delta")
+    with self.test_session():
+      var = self._variable("var", [[1, 1], [2, 2], [3, 3], [4, 4]])
+      self._save(base, "", ["var"], [var])
+      resource_variable_ops.assign_add_variable_op(
+          var, constant_op.constant([[1., 1.]] * 4)).run()
+      self._save(delta, base, ["var"], [var])
+
+      gen_io_ops.save_v2(base, ["var"], [""],
+                         [constant_op.constant([[-1., -1.]] * 4)]).run()
+      self.assertAllEqual([[2, 2], [3, 3], [4, 4], [5, 5]],
+                          self._restore(delta, "var"))
+
+
 if __name__ == "__main__":
   test.main()
@@ -22,6 +22,7 @@ import numpy as np
 
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes as dtypes_lib
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import math_ops
 import tensorflow.python.ops.nn_grad  # pylint: disable=unused-import
@@ -215,6 +216,21 @@ class SegmentReductionOpTest(SegmentReductionHelper):
       with self.assertRaisesOpError("segment ids must be >= 0"):
         s.eval()
 
+  def testLargeValues(self):
+    # Many segments, with gaps between them, reduced by several threads.
+    np.random.seed(0)
+    num_rows = 50000
+    indices = np.sort(np.random.randint(0, 20000, size=num_rows))
+    np_x = np.random.rand(num_rows, 4)
+    for np_op, tf_op, use_gpu in [(np.add, math_ops.segment_sum, True),
+                                  (np.maximum, math_ops.segment_max, False)]:
+      np_ans = np.zeros((indices[-1] + 1, 4))
+      np_op.at(np_ans, indices, np_x)
+      with self.test_session(use_gpu=use_gpu):
+        s = tf_op(data=np_x, segment_ids=indices)
+        tf_ans = s.eval()
+      self.assertAllClose(np_ans, tf_ans)
+
   def testGradient(self):
     shape = [4, 4]
     indices = [0, 1, 2, 2]
@@ -310,6 +326,25 @@ class UnsortedSegmentSumTest(SegmentReductionHelper):
       self.assertAllClose(unsorted_jacob_t, sorted_jacob_t)
       self.assertAllClose(unsorted_jacob_n, sorted_jacob_n)
 
+  def testLargeValues(self):
+    # Covers the ways the CPU kernel shards the reduction: sorted segment ids,
+    # many more rows than segments, and as many segments as rows.
+    np.random.seed(0)
+    num_rows = 100000
+    for num_segments, sort_ids in [(1000, True), (10, False),
+                                   (num_rows, False)]:
+      indices = np.random.randint(0, num_segments, size=num_rows)
+      if sort_ids:
+        indices = np.sort(indices)
+      np_x = np.random.rand(num_rows, 4)
+      np_ans = np.zeros((num_segments, 4))
+      np.add.at(np_ans, indices, np_x)
+      with self.test_session(use_gpu=True):
+        s = math_ops.unsorted_segment_sum(
+            data=np_x, segment_ids=indices, num_segments=num_segments)
+        tf_ans = s.eval()
+      self.assertAllClose(np_ans, tf_ans)
+
   def testBadIndices(self):
     # Note: GPU kernel does not return the out-of-range error needed for this
     # test, so this test is marked as cpu-only.
@@ -636,5 +671,93 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           s.eval()
 
 
+class SparseEmbeddingCombineTest(test.TestCase):
+
+  def _combine(self, data, indices, segment_ids, weights, combiner):
+    num_segments = segment_ids[-1] + 1 if segment_ids else 0
+    output = np.zeros((num_segments,) + data.shape[1:], dtype=data.dtype)
+    norms = np.zeros(num_segments, dtype=data.dtype)
+    for index, segment, weight in zip(indices, segment_ids, weights):
+      output[segment] += data[index] * weight
+      norms[segment] += weight * weight if combiner == "sqrtn" else weight
+    for segment in range(num_segments):
+      if combiner == "mean" and norms[segment]:
+        output[segment] /= norms[segment]
+      elif combiner == "sqrtn" and norms[segment]:
+        output[segment] /= np.sqrt(norms[segment])
+    return output
+
+  def testValues(self):
+    data = np.random.rand(20, 3, 2)
+    indices = [3, 0, 3, 19, 7, 7, 7, 1]
+    segment_ids = [0, 0, 1, 1, 1, 3, 3, 4]
+    weights = [0.5, 2.0, 1.0, 0.25, 3.0, 1.5, -1.0, 2.0]
+    for dtype in [dtypes_lib.float32, dtypes_lib.float64]:
+      for combiner in ["sum", "mean", "sqrtn"]:
+        with self.test_session(use_gpu=False):
+          for np_weights in [weights, []]:
+            tf_weights = constant_op.constant(np_weights, dtype=dtype)
+            # pylint: disable=protected-access
+            s = gen_math_ops._sparse_embedding_combine(
+                constant_op.constant(data, dtype=dtype), indices, segment_ids,
+                tf_weights, combiner=combiner)
+            # pylint: enable=protected-access
+            self.assertAllEqual([None, 3, 2], s.get_shape().as_list())
+            np_ans = self._combine(
+                data.astype(dtype.as_numpy_dtype), indices, segment_ids,
+                np_weights or [1.0] * len(indices), combiner)
+            self.assertAllClose(np_ans, s.eval())
+
+  def testZeroWeights(self):
+    data = np.random.rand(4, 2)
+    with self.test_session(use_gpu=False):
+      for combiner in ["mean", "sqrtn"]:
+        # pylint: disable=protected-access
+        s = gen_math_ops._sparse_embedding_combine(
+            data, [0, 1, 2], [0, 0, 1], [0.0, 0.0, 1.0], combiner=combiner)
+        # pylint: enable=protected-access
+        self.assertAllClose([[0.0, 0.0], data[2]], s.eval())
+
+  def testGradient(self):
+    shape = [10, 4]
+    indices = [8, 3, 3, 0, 9, 3]
+    segment_ids = [0, 1, 1, 1, 2, 2]
+    np_x = np.random.rand(*shape)
+    np_w = np.random.rand(len(indices)) + 0.5
+    for combiner in ["sum", "mean", "sqrtn"]:
+      with self.test_session(use_gpu=False):
+        tf_x = constant_op.constant(np_x)
+        tf_w = constant_op.constant(np_w)
+        # pylint: disable=protected-access
+        s = gen_math_ops._sparse_embedding_combine(
+            tf_x, indices, segment_ids, tf_w, combiner=combiner)
+        # pylint: enable=protected-access
+        jacob_t, jacob_n = gradient_checker.compute_gradient(
+            [tf_x, tf_w], [shape, [len(indices)]],
+            s, [3, 4],
+            x_init_value=[np_x, np_w])
+        self.assertAllClose(jacob_t, jacob_n)
+
+  def testIndicesInvalid(self):
+    data = np.random.rand(4, 2)
+    with self.test_session(use_gpu=False):
+      # pylint: disable=protected-access
+      s = gen_math_ops._sparse_embedding_combine(
+          data, [0, 4, 2], [0, 0, 1], np.zeros([0]), combiner="sum")
+      # pylint: enable=protected-access
+      with self.assertRaisesOpError(r"indices\[1\] == 4 out of range"):
+        s.eval()
+
+  def testSegmentsInvalid(self):
+    data = np.random.rand(4, 2)
+    with self.test_session(use_gpu=False):
+      # pylint: disable=protected-access
+      s = gen_math_ops._sparse_embedding_combine(
+          data, [0, 1, 2], [1, 1, 0], np.zeros([0]), combiner="sum")
+      # pylint: enable=protected-access
+      with self.assertRaisesOpError("segment ids are not increasing"):
+        s.eval()
+
+
 if __name__ == "__main__":
   test.main()
@@ -125,6 +125,23 @@ class SparseMatMulTest(test.TestCase):
                     x_dtype=x_dtype,
                     y_dtype=y_dtype)
 
+  # Tests dense float activations by bfloat16 weights, with few rows computed
+  # by panels of the weights and more rows after converting all the weights.
+  def testDenseBFloat16Weights(self):
+    for m in [1, 32, 200]:
+      for tr_a in [True, False]:
+        for tr_b in [True, False]:
+          x = RandMatrix(m, 1000, tr_a)
+          y = RandMatrix(1000, 300, tr_b)
+          self._testCpuMatmul(
+              x,
+              y,
+              tr_a,
+              tr_b,
+              sp_a=False,
+              sp_b=False,
+              y_dtype=dtypes.bfloat16)
+
 
 class MatMulGradientTest(test.TestCase):
 
@@ -161,6 +161,27 @@ class SparseTensorDenseMatMulTest(test.TestCase):
         sparse_ops.sparse_tensor_dense_matmul(
             sparse_t, dense_t, adjoint_a=True).eval()
 
+  def testIndicesChangeBetweenRuns(self):
+    # The CPU kernel reuses the grouping of the nonzeros while the indices do
+    # not change, so run the same op on different indices.
+    with self.test_session(use_gpu=False) as sess:
+      indices = array_ops.placeholder(dtypes.int64, shape=[2, 2])
+      values = constant_op.constant([1.0, 2.0])
+      sp_x = sparse_tensor.SparseTensor(indices, values, [2, 3])
+      y = np.arange(6, dtype=np.float32).reshape(3, 2)
+      result = sparse_ops.sparse_tensor_dense_matmul(sp_x, y)
+
+      for x_indices in ([[0, 0], [1, 2]], [[0, 0], [1, 2]], [[1, 1], [0, 2]],
+                        [[0, 0], [1, 2]]):
+        x = np.zeros([2, 3], dtype=np.float32)
+        x[tuple(np.transpose(x_indices))] = [1.0, 2.0]
+        self.assertAllClose(
+            np.dot(x, y), sess.run(result, {indices: x_indices}))
+
+      with self.assertRaisesOpError(
+          "k .3. from index.1,1. out of bounds .>=3."):
+        sess.run(result, {indices: [[0, 0], [1, 3]]})
+
   # Tests setting one dimension to be a high value.
   def _testLarge(self, np_dtype):
     r1 = np.random.randint(6000, 20000)
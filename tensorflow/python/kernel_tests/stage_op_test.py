@@ -16,7 +16,11 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import threading
+import time
+
 from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
@@ -90,6 +94,86 @@ class StageTest(test.TestCase):
       x = stager.get()
       self.assertEqual(x.device, '/device:CPU:0')
 
+  def testSizeAndClear(self):
+    with self.test_session() as sess:
+      with ops.device('/cpu:0'):
+        x = array_ops.placeholder(dtypes.float32)
+        stager = data_flow_ops.StagingArea([dtypes.float32])
+        stage = stager.put([x])
+        size = stager.size()
+        clear = stager.clear()
+      for i in range(3):
+        sess.run(stage, feed_dict={x: i})
+      self.assertEqual(3, sess.run(size))
+      sess.run(clear)
+      self.assertEqual(0, sess.run(size))
+
+  def testCapacity(self):
+    capacity = 3
+    with self.test_session() as sess:
+      with ops.device('/cpu:0'):
+        x = array_ops.placeholder(dtypes.int32)
+        stager = data_flow_ops.StagingArea([dtypes.int32], capacity=capacity)
+        stage = stager.put([x])
+        ret = stager.get()
+        size = stager.size()
+
+      n = 5
+      staged = []
+
+      def put():
+        for i in range(n):
+          sess.run(stage, feed_dict={x: i})
+          staged.append(i)
+
+      thread = threading.Thread(target=put)
+      thread.start()
+      # The puts after the first `capacity` ones should block until gets
+      # make room for them.
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      self.assertEqual(capacity, len(staged))
+      self.assertEqual(capacity, sess.run(size))
+      for i in range(n):
+        self.assertEqual(i, sess.run(ret))
+      thread.join()
+      self.assertEqual(n, len(staged))
+      self.assertEqual(0, sess.run(size))
+
+  def testMemoryLimit(self):
+    # Each element takes 1024 bytes, so a limit of 1100 bytes fits only one.
+    with self.test_session() as sess:
+      with ops.device('/cpu:0'):
+        x = array_ops.placeholder(dtypes.float32, [2, 128])
+        stager = data_flow_ops.StagingArea([dtypes.float32], memory_limit=1100)
+        stage = stager.put([x])
+        too_large_stage = stager.put([array_ops.zeros([3, 128])])
+        ret = stager.get()
+        size = stager.size()
+
+      with self.assertRaisesRegexp(errors.ResourceExhaustedError,
+                                   'memory limit'):
+        sess.run(too_large_stage)
+
+      n = 4
+      staged = []
+
+      def put():
+        for i in range(n):
+          sess.run(stage, feed_dict={x: [[float(i)] * 128] * 2})
+          staged.append(i)
+
+      thread = threading.Thread(target=put)
+      thread.start()
+      # TODO(mrry): Figure out how to do this without sleeping.
+      time.sleep(0.1)
+      self.assertEqual(1, len(staged))
+      self.assertEqual(1, sess.run(size))
+      for i in range(n):
+        self.assertAllEqual([[float(i)] * 128] * 2, sess.run(ret))
+      thread.join()
+      self.assertEqual(n, len(staged))
+
 
 if __name__ == '__main__':
   test.main()
@@ -23,6 +23,7 @@ import numpy as np
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors_impl
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import gen_string_ops
 from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 
@@ -126,6 +127,21 @@ class StringSplitOpTest(test.TestCase):
                           [b"hello", b"cruel", b"world", b"hello cruel world"])
       self.assertAllEqual(shape, [2, 3])
 
+  def testStringSplitToHashBucketFast(self):
+    strings = [" hello world ", "", "a|b c", "hello"]
+
+    with self.test_session() as sess:
+      for delimiter in [" ", " |", ""]:
+        tokens = string_ops.string_split(strings, delimiter=delimiter)
+        expected = (tokens.indices,
+                    string_ops.string_to_hash_bucket_fast(tokens.values, 10),
+                    tokens.dense_shape)
+        fused = gen_string_ops.string_split_to_hash_bucket_fast(
+            strings, delimiter, num_buckets=10)
+        expected_values, fused_values = sess.run([expected, fused])
+        for expected_value, fused_value in zip(expected_values, fused_values):
+          self.assertAllEqual(expected_value, fused_value)
+
 
 if __name__ == "__main__":
   test.main()
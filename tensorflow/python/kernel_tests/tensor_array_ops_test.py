@@ -523,6 +523,26 @@ class TensorArrayTest(test.TestCase):
                   dtypes.complex64, dtypes.complex128):
       self._testTensorArrayWriteGradientAddMultipleAdds(dtype)
 
+  def testTensorArrayUnpackSplitAggregateDoesNotModifyInput(self):
+    with self.test_session(use_gpu=True) as sess:
+      value = constant_op.constant([[1.0, 2.0], [3.0, 4.0]])
+      ta_unpack = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32, tensor_array_name="foo", size=2).grad("grad")
+      ta_split = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32, tensor_array_name="bar", size=2).grad("grad")
+
+      # The elements unpacked or split from value share its buffer, so
+      # aggregating writes to them must leave value untouched.
+      w_unpack = ta_unpack.unstack(value).write(0, [10.0, 20.0])
+      w_split = ta_split.split(
+          array_ops.reshape(value, [4]), lengths=[1, 3]).write(1, [1.0] * 3)
+
+      unpacked, split, value_after = sess.run(
+          [w_unpack.read(0), w_split.read(1), value])
+      self.assertAllEqual([11.0, 22.0], unpacked)
+      self.assertAllEqual([3.0, 4.0, 5.0], split)
+      self.assertAllEqual([[1.0, 2.0], [3.0, 4.0]], value_after)
+
   def testMultiTensorArray(self):
     with self.test_session(use_gpu=True):
       h1 = tensor_array_ops.TensorArray(
@@ -39,15 +39,38 @@ class TopKTest(test.TestCase):
                     sorted=True):
     np_values = np.array(expected_values)
     np_indices = np.array(expected_indices)
-    with self.test_session():
+    with self.test_session(use_gpu=True):
       values_op, indices_op = nn_ops.top_k(inputs, k, sorted=sorted)
       values = values_op.eval()
       indices = indices_op.eval()
+      if not sorted:
+        # The order of the unsorted results is unspecified.
+        values, indices = self._sortResults(values, indices)
+        np_values, np_indices = self._sortResults(np_values, np_indices)
       self.assertAllClose(np_values, values)
       self.assertAllEqual(np_indices, indices)
       self.assertShapeEqual(np_values, values_op)
       self.assertShapeEqual(np_indices, indices_op)
 
+  def _sortResults(self, values, indices):
+    """Sorts each row of results by descending value, then by index."""
+    values = np.array(values)
+    indices = np.array(indices)
+    flat_values = values.reshape([-1, values.shape[-1]])
+    flat_indices = indices.reshape([-1, indices.shape[-1]])
+    for row in range(flat_values.shape[0]):
+      order = np.lexsort((flat_indices[row], -flat_values[row]))
+      flat_values[row] = flat_values[row][order]
+      flat_indices[row] = flat_indices[row][order]
+    return flat_values.reshape(values.shape), flat_indices.reshape(
+        indices.shape)
+
+  def _validateTopKLikeNumpy(self, inputs, k, sorted=True):
+    """Compares top_k on the 2-D `inputs` with a stable sort of its rows."""
+    order = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+    expected_values = [row[indices] for row, indices in zip(inputs, order)]
+    self._validateTopK(inputs, k, expected_values, order, sorted=sorted)
+
   def testTop1(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 1, [[0.4], [0.3]], [[3], [1]])
@@ -72,6 +95,24 @@ class TopKTest(test.TestCase):
     inputs = [3, 6, 15, 18, 6, 12, 1, 17, 3, 0, 4, 19, 1, 6]
     self._validateTopK(inputs, 3, [19, 18, 17], [11, 3, 7])
 
+  def testTopKLarge(self):
+    # Selected on the CPU with a heap, and a radix select on the GPU.
+    np.random.seed(1)
+    inputs = np.random.permutation(40000).reshape([4, 10000]).astype(
+        np.float32)
+    self._validateTopKLikeNumpy(inputs, 500)
+    self._validateTopKLikeNumpy(inputs, 500, sorted=False)
+
+  def testTopKLargeWithTies(self):
+    # Selected on the CPU with a partial sort, and the values equal to the
+    # k-th largest one are in the smallest columns.
+    np.random.seed(2)
+    for dtype in (np.float16, np.float32, np.float64):
+      inputs = np.random.randint(-50, 50, size=[3, 5000]).astype(dtype)
+      self._validateTopKLikeNumpy(inputs, 1000)
+      self._validateTopKLikeNumpy(inputs, 1000, sorted=False)
+      self._validateTopKLikeNumpy(inputs, 1)
+
   def testTensorK(self):
     inputs = [3, 6, 15, 18, 6, 12, 1, 17, 3, 0, 4, 19, 1, 6]
     k = constant_op.constant(3)
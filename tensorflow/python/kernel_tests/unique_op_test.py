@@ -49,6 +49,24 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]].decode('ascii'))
 
+  def testOrderOfFirstOccurrence(self):
+    # Large enough to be deduplicated by several threads.
+    x = np.random.randint(-5000, high=5000, size=100000)
+    with self.test_session() as sess:
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = sess.run([y, idx])
+
+    expected_y = []
+    expected_idx = []
+    ids = {}
+    for value in x:
+      if value not in ids:
+        ids[value] = len(expected_y)
+        expected_y.append(value)
+      expected_idx.append(ids[value])
+    self.assertAllEqual(expected_y, tf_y)
+    self.assertAllEqual(expected_idx, tf_idx)
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -81,6 +99,27 @@ class UniqueWithCountsTest(test.TestCase):
       v = [1 if x[i] == value.decode('ascii') else 0 for i in range(7000)]
       self.assertEqual(count, sum(v))
 
+  def testLargeString(self):
+    # Large enough to be deduplicated by several threads.
+    indx = np.random.randint(0, high=3000, size=100000)
+    x = [str(i) for i in indx]
+    with self.test_session() as sess:
+      y, idx, count = array_ops.unique_with_counts(x)
+      tf_y, tf_idx, tf_count = sess.run([y, idx, count])
+
+    expected_y = []
+    expected_count = []
+    ids = {}
+    for value in x:
+      if value not in ids:
+        ids[value] = len(expected_y)
+        expected_y.append(value)
+        expected_count.append(0)
+      expected_count[ids[value]] += 1
+    self.assertEqual(expected_y, [value.decode('ascii') for value in tf_y])
+    self.assertAllEqual([ids[value] for value in x], tf_idx)
+    self.assertAllEqual(expected_count, tf_count)
+
 
 if __name__ == '__main__':
   test.main()
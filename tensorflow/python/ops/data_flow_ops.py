@@ -636,7 +636,7 @@ class FIFOQueue(QueueBase):
   """
 
   def __init__(self, capacity, dtypes, shapes=None, names=None,
-               shared_name=None, name="fifo_queue"):
+               shared_name=None, name="fifo_queue", lock_free=False):
     """Creates a queue that dequeues elements in a first-in first-out order.
 
     A `FIFOQueue` has bounded capacity; supports multiple concurrent
@@ -665,13 +665,18 @@ class FIFOQueue(QueueBase):
       shared_name: (Optional.) If non-empty, this queue will be shared under
         the given name across multiple sessions.
       name: Optional name for the queue operation.
+      lock_free: (Optional.) If `True`, enqueues and dequeues that do not
+        have to wait access the elements without taking a lock, which scales
+        better with many concurrent producers and consumers.  Requires a
+        positive `capacity`, and `dequeue_many` calls of at most `capacity`
+        elements.
     """
     dtypes = _as_type_list(dtypes)
     shapes = _as_shape_list(shapes, dtypes)
     names = _as_name_list(names, dtypes)
     queue_ref = gen_data_flow_ops._fifo_queue_v2(
         component_types=dtypes, shapes=shapes, capacity=capacity,
-        shared_name=shared_name, name=name)
+        shared_name=shared_name, lock_free=lock_free, name=name)
 
     super(FIFOQueue, self).__init__(dtypes, shapes, names, queue_ref)
 
@@ -741,6 +746,79 @@ class PaddingFIFOQueue(QueueBase):
     super(PaddingFIFOQueue, self).__init__(dtypes, shapes, names, queue_ref)
 
 
+class PaddingBucketQueue(QueueBase):
+  """A padding queue that batches elements of similar sizes together.
+
+  A `PaddingBucketQueue` groups its elements into buckets by the size of the
+  first dimension of one of their components, e.g. the length of a sequence,
+  and `dequeue_many` returns batches drawn from a single bucket, so that they
+  need less padding than batches of a `PaddingFIFOQueue`.  This replaces
+  bucketing with one queue and queue runner per bucket.
+
+  See @{tf.QueueBase} for a description of the methods on
+  this class.
+  """
+
+  def __init__(self, capacity, dtypes, shapes, bucket_boundaries,
+               bucket_component=0, names=None, shared_name=None,
+               name="padding_bucket_queue"):
+    """Creates a queue that batches elements bucketed by size.
+
+    An element goes to the first bucket `i` such that its size is smaller than
+    `bucket_boundaries[i]`, or to the last of the `len(bucket_boundaries) + 1`
+    buckets.  `dequeue_many(n)` returns `n` elements of the fullest bucket
+    once a bucket holds that many, each bucket being first-in first-out.  When
+    the queue is full or closed and no bucket can fill a batch on its own,
+    the batch is completed with elements of the buckets nearest to the
+    fullest one.  On a closed queue, `dequeue_up_to` returns the remaining
+    elements bucket by bucket.
+
+    Components are padded within a batch as in a `PaddingFIFOQueue`.
+
+    Args:
+      capacity: An integer. The upper bound on the number of elements
+        that may be stored in this queue, over all buckets.  `dequeue_many`
+        can't request more elements than `capacity`.
+      dtypes:  A list of `DType` objects. The length of `dtypes` must equal
+        the number of tensors in each queue element.
+      shapes: A list of `TensorShape` objects, with the same length as
+        `dtypes`.  Any dimension in the `TensorShape` containing value
+        `None` is dynamic and allows values to be enqueued with
+         variable size in that dimension.
+      bucket_boundaries: A strictly increasing list of integers, the
+        boundaries of the buckets.
+      bucket_component: The index of the component whose first dimension
+        selects the bucket of an element.  Its shape must have a rank of at
+        least 1.
+      names: (Optional.) A list of string naming the components in the queue
+        with the same length as `dtypes`, or `None`.  If specified the dequeue
+        methods return a dictionary with the names as keys.
+      shared_name: (Optional.) If non-empty, this queue will be shared under
+        the given name across multiple sessions.
+      name: Optional name for the queue operation.
+
+    Raises:
+      ValueError: If shapes is not a list of shapes, or the lengths of dtypes
+        and shapes do not match, or if names is specified and the lengths of
+        dtypes and names do not match.
+    """
+    dtypes = _as_type_list(dtypes)
+    shapes = _as_shape_list(shapes, dtypes, unknown_dim_allowed=True)
+    names = _as_name_list(names, dtypes)
+    if len(dtypes) != len(shapes):
+      raise ValueError("Shapes must be provided for all components, "
+                       "but received %d dtypes and %d shapes."
+                       % (len(dtypes), len(shapes)))
+
+    queue_ref = gen_data_flow_ops._padding_bucket_queue(
+        component_types=dtypes, shapes=shapes,
+        bucket_component=bucket_component,
+        bucket_boundaries=bucket_boundaries, capacity=capacity,
+        shared_name=shared_name, name=name)
+
+    super(PaddingBucketQueue, self).__init__(dtypes, shapes, names, queue_ref)
+
+
 class PriorityQueue(QueueBase):
   """A queue implementation that dequeues elements in prioritized order.
 
@@ -1395,8 +1473,9 @@ class StagingArea(object):
   Each `StagingArea` element is a tuple of one or more tensors, where each
   tuple component has a static dtype, and may have a static shape.
 
-  The capacity of a `StagingArea` is unbounded and supports multiple
-  concurrent producers and consumers; and provides exactly-once delivery.
+  The capacity of a `StagingArea` may be bounded or unbounded.
+  It supports multiple concurrent producers and consumers; and
+  provides exactly-once delivery.
 
   Each element of a `StagingArea` is a fixed-length tuple of tensors whose
   dtypes are described by `dtypes`, and whose shapes are optionally described
@@ -1405,12 +1484,26 @@ class StagingArea(object):
   If the `shapes` argument is specified, each component of a staging area
   element must have the respective fixed shape. If it is
   unspecified, different elements may have different shapes,
+
+  It can be configured with a capacity in which case
+  put(values) will block until space becomes available.
+
+  Similarly, it can be configured with a memory limit which
+  will block put(values) until space is available.
+  This is mostly useful for limiting the number of tensors on
+  devices such as GPUs.
+
+  Together with a capacity, this allows prefetching: a staging area on a GPU
+  that is kept `capacity` elements ahead of its consumer copies each element
+  to the GPU on the device's host-to-device stream while earlier elements are
+  being computed on.
   """
 
   _identifier = 0
   _lock = threading.Lock()
 
-  def __init__(self, dtypes, shapes=None, names=None, shared_name=None):
+  def __init__(self, dtypes, shapes=None, names=None, shared_name=None,
+               capacity=0, memory_limit=0):
     """Constructs a staging area object.
 
     The two optional lists, `shapes` and `names`, must be of the same length
@@ -1435,6 +1528,11 @@ class StagingArea(object):
       shared_name: (Optional.) A name to be used for the shared object. By
         passing the same name to two different python objects they will share
         the underlying staging area. Must be a string.
+      capacity: (Optional.) Maximum number of elements.
+        An integer. If zero, the Staging Area is unbounded
+      memory_limit: (Optional.) Maximum number of bytes of all tensors
+        in the Staging Area.
+        An integer. If zero, the Staging Area is unbounded
 
     Raises:
       ValueError: If one of the arguments is invalid.
@@ -1458,6 +1556,8 @@ class StagingArea(object):
       self._names = names
     else:
       self._names = None
+    self._capacity = capacity
+    self._memory_limit = memory_limit
 
     # all get and put ops must colocate with this op
     with ops.name_scope("%s_root" % self._name):
@@ -1483,6 +1583,16 @@ class StagingArea(object):
     """The list of names for each component of a staging area element."""
     return self._names
 
+  @property
+  def capacity(self):
+    """The maximum number of elements of this staging area."""
+    return self._capacity
+
+  @property
+  def memory_limit(self):
+    """The maximum number of bytes of this staging area."""
+    return self._memory_limit
+
   def _check_put_dtypes(self, vals):
     """Validate and convert `vals` to a list of `Tensor`s.
 
@@ -1574,7 +1684,8 @@ class StagingArea(object):
 
       with ops.colocate_with(self._coloc_op):
         op = gen_data_flow_ops.stage(values=vals, shared_name=self._name,
-                                     name=scope)
+                                     name=scope, capacity=self._capacity,
+                                     memory_limit=self._memory_limit)
 
       return op
 
@@ -1628,7 +1739,9 @@ class StagingArea(object):
 
     with ops.colocate_with(self._coloc_op):
       ret = gen_data_flow_ops.unstage(dtypes=self._dtypes,
-                                      shared_name=self._name, name=name)
+                                      shared_name=self._name, name=name,
+                                      capacity=self._capacity,
+                                      memory_limit=self._memory_limit)
 
     curr_device_scope = control_flow_ops.no_op().device
     if curr_device_scope != self._coloc_op.device:
@@ -1640,6 +1753,42 @@ class StagingArea(object):
 
     return self._get_return_value(ret)
 
+  def size(self, name=None):
+    """Returns the number of elements in the staging area.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar `int32` tensor.
+    """
+    if name is None:
+      name = "%s_size" % self._name
+
+    with ops.colocate_with(self._coloc_op):
+      return gen_data_flow_ops.stage_size(name=name, shared_name=self._name,
+                                          dtypes=self._dtypes,
+                                          capacity=self._capacity,
+                                          memory_limit=self._memory_limit)
+
+  def clear(self, name=None):
+    """Clears the staging area.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      The created op.
+    """
+    if name is None:
+      name = "%s_clear" % self._name
+
+    with ops.colocate_with(self._coloc_op):
+      return gen_data_flow_ops.stage_clear(name=name, shared_name=self._name,
+                                           dtypes=self._dtypes,
+                                           capacity=self._capacity,
+                                           memory_limit=self._memory_limit)
+
 
 class RecordInput(object):
   """RecordInput asynchronously reads and randomly yields TFRecords.
@@ -1653,6 +1802,12 @@ class RecordInput(object):
 
   The order the files are read will be shifted each epoch by `shift_amount` so
   that the data is presented in a different order every epoch.
+
+  If `spill_dir` is set, the records of each epoch are first written to
+  temporary files in `spill_dir`, each record to a randomly chosen one, which
+  are then read in a random order through the buffer.  This shuffles the
+  records across the whole epoch with a small buffer, at the cost of an extra
+  sequential write and read of the data per epoch.
   """
 
   def __init__(self,
@@ -1662,6 +1817,8 @@ class RecordInput(object):
                parallelism=1,
                shift_ratio=0,
                seed=0,
+               spill_dir="",
+               num_spill_files=64,
                name=None):
     """Constructs a RecordInput Op.
 
@@ -1677,6 +1834,10 @@ class RecordInput(object):
         file forward by each epoch.
       seed: Specify the random number seed used by generator that randomizes
         records.
+      spill_dir: If not empty, a directory the records of each epoch are
+        spilled to before being yielded.  The spill files are deleted at the
+        end of each epoch.
+      num_spill_files: How many files the records of an epoch are spilled to.
       name: Optional name for the operation.
 
     Raises:
@@ -1689,6 +1850,8 @@ class RecordInput(object):
     self._parallelism = parallelism
     self._shift_ratio = shift_ratio
     self._seed = seed
+    self._spill_dir = spill_dir
+    self._num_spill_files = num_spill_files
     self._name = name
 
   def get_yield_op(self):
@@ -1700,4 +1863,6 @@ class RecordInput(object):
         file_shuffle_shift_ratio=self._shift_ratio,
         batch_size=self._batch_size,
         file_random_seed=self._seed,
+        spill_dir=self._spill_dir,
+        num_spill_files=self._num_spill_files,
         name=self._name)
@@ -27,6 +27,7 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import clip_ops
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variables
@@ -312,14 +313,27 @@ def embedding_lookup_sparse(params, sp_ids, sp_weights,
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
 
     ids = sp_ids.values
-    if ignore_weights:
-      ids, idx = array_ops.unique(ids)
-    else:
-      idx = None
+    ids, idx = array_ops.unique(ids)
 
     embeddings = embedding_lookup(
         params, ids, partition_strategy=partition_strategy, max_norm=max_norm)
+    if embeddings.dtype in (dtypes.float32, dtypes.float64):
+      # Gathers and combines the embeddings of the unique ids in a single op,
+      # so that the gradient flows to the unique ids only.
+      if ignore_weights:
+        weights = array_ops.zeros([0], dtype=embeddings.dtype)
+      else:
+        weights = sp_weights.values
+        if weights.dtype != embeddings.dtype:
+          weights = math_ops.cast(weights, embeddings.dtype)
+      # pylint: disable=protected-access
+      embeddings = gen_math_ops._sparse_embedding_combine(
+          embeddings, idx, segment_ids, weights, combiner=combiner, name=name)
+      # pylint: enable=protected-access
+      return embeddings
+
     if not ignore_weights:
+      embeddings = array_ops.gather(embeddings, idx)
       weights = sp_weights.values
       if weights.dtype != embeddings.dtype:
         weights = math_ops.cast(weights, embeddings.dtype)
@@ -356,7 +370,6 @@ def embedding_lookup_sparse(params, sp_ids, sp_weights,
       else:
         assert False, "Unrecognized combiner"
     else:
-      assert idx is not None
       if combiner == "sum":
         embeddings = math_ops.sparse_segment_sum(embeddings, idx, segment_ids,
                                                  name=name)
@@ -20,6 +20,7 @@ See the @{$python/image} guide.
 
 @@decode_gif
 @@decode_jpeg
+@@decode_jpeg_batch
 @@encode_jpeg
 @@decode_png
 @@encode_png
@@ -2412,6 +2412,34 @@ class JpegTest(test_util.TensorFlowTestCase):
       # The images should be the same.
       self.assertAllClose(image1, image2)
 
+  def testDecodeBatch(self):
+    with self.test_session(use_gpu=True) as sess:
+      jpeg0 = image_ops.encode_jpeg(constant_op.constant(_SimpleColorRamp()))
+      contents = array_ops.stack([jpeg0, jpeg0, jpeg0])
+      # The whole image, a window at ratio 4, and a window at ratio 1.
+      crop_windows = [[0, 0, 0, 0], [40, 64, 160, 128], [10, 20, 50, 30]]
+      images = image_ops.decode_jpeg_batch(
+          contents, crop_windows, [40, 32], dct_method="INTEGER_ACCURATE")
+      self.assertEqual(images.get_shape().as_list(), [3, 40, 32, 3])
+      image0 = image_ops.decode_jpeg(jpeg0, dct_method="INTEGER_ACCURATE")
+      expected = []
+      for y, x, height, width in crop_windows[1:]:
+        window = image_ops.crop_to_bounding_box(image0, y, x, height, width)
+        expected.append(image_ops.resize_bilinear([window], [40, 32])[0])
+      whole = image_ops.resize_bilinear([image0], [40, 32])[0]
+      images, whole, expected = sess.run([images, whole, expected])
+      self.assertLess(self.averageError(images[0], whole), 2)
+      for image, expected_image in zip(images[1:], expected):
+        self.assertLess(self.averageError(image, expected_image), 2)
+
+  def testDecodeBatchBadWindow(self):
+    with self.test_session(use_gpu=True):
+      jpeg0 = image_ops.encode_jpeg(constant_op.constant(_SimpleColorRamp()))
+      images = image_ops.decode_jpeg_batch([jpeg0], [[150, 0, 100, 10]],
+                                           [8, 8])
+      with self.assertRaisesOpError("does not lie within the image"):
+        images.eval()
+
   def testShape(self):
     with self.test_session(use_gpu=True) as sess:
       jpeg = constant_op.constant("nonsense")
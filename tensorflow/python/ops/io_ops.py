@@ -425,22 +425,37 @@ class TFRecordReader(ReaderBase):
   """
   # TODO(josh11b): Support serializing and restoring state.
 
-  def __init__(self, name=None, options=None):
+  def __init__(self, name=None, options=None, num_parallel_files=1,
+               sloppy=False):
     """Create a TFRecordReader.
 
+    With `num_parallel_files > 1`, the reader reads that many files from the
+    queue at the same time, each on its own thread, and interleaves their
+    records: one from each file in turn, or, if `sloppy` is true, from
+    whichever file has one ready.
+
     Args:
       name: A name for the operation (optional).
       options: A TFRecordOptions object (optional).
+      num_parallel_files: The number of files to read concurrently.
+      sloppy: If true, trade the deterministic order of the records with
+        `num_parallel_files > 1` for throughput.
     """
     compression_type = python_io.TFRecordOptions.get_compression_type_string(
         options)
 
-    rr = gen_io_ops._tf_record_reader_v2(
-        name=name, compression_type=compression_type)
+    if num_parallel_files > 1:
+      rr = gen_io_ops._parallel_tf_record_reader(
+          name=name, compression_type=compression_type,
+          num_parallel_files=num_parallel_files, sloppy=sloppy)
+    else:
+      rr = gen_io_ops._tf_record_reader_v2(
+          name=name, compression_type=compression_type)
     super(TFRecordReader, self).__init__(rr)
 
 
 ops.NotDifferentiable("TFRecordReader")
+ops.NotDifferentiable("ParallelTFRecordReader")
 
 
 class IdentityReader(ReaderBase):
@@ -27,6 +27,7 @@ from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_array_ops
 from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import math_ops
+from tensorflow.python.util import compat
 
 
 def _safe_shape_div(x, y):
@@ -188,6 +189,45 @@ def _SparseSegmentSqrtNGrad(op, grad):
                                               dim0), None, None)
 
 
+@ops.RegisterGradient("SparseEmbeddingCombine")
+def _SparseEmbeddingCombineGrad(op, grad):
+  """Gradient for SparseEmbeddingCombine."""
+  data, indices, segment_ids, weights = op.inputs
+  combiner = compat.as_str(op.get_attr("combiner"))
+  dim0 = array_ops.shape(data)[0]
+  # pylint: disable=protected-access
+  data_grad = gen_math_ops._sparse_embedding_combine_grad(
+      grad, indices, segment_ids, weights, dim0, combiner=combiner)
+  # pylint: enable=protected-access
+  if weights.get_shape().num_elements() == 0:
+    return data_grad, None, None, None
+
+  # The gradient with respect to the weight w of a row r of segment s is the
+  # dot product of grad[s] with the derivative of output[s] by w, which is r
+  # for "sum", (r - output[s]) / sum(weights[s]) for "mean", and
+  # (r - output[s] * w / n) / n for "sqrtn", where n = sqrt(sum(weights[s]^2)).
+  num_indices = array_ops.shape(indices)[0]
+  rows = array_ops.reshape(
+      array_ops.gather(data, indices), [num_indices, -1])
+  if combiner != "sum":
+    outputs = array_ops.reshape(
+        array_ops.gather(op.outputs[0], segment_ids), [num_indices, -1])
+    if combiner == "mean":
+      norms = array_ops.gather(
+          math_ops.segment_sum(weights, segment_ids), segment_ids)
+      rows = (rows - outputs) / array_ops.expand_dims(norms, 1)
+    else:
+      norms = array_ops.gather(
+          math_ops.sqrt(math_ops.segment_sum(weights * weights, segment_ids)),
+          segment_ids)
+      rows = ((rows - outputs * array_ops.expand_dims(weights / norms, 1)) /
+              array_ops.expand_dims(norms, 1))
+  segment_grads = array_ops.reshape(
+      array_ops.gather(grad, segment_ids), [num_indices, -1])
+  weights_grad = math_ops.reduce_sum(rows * segment_grads, 1)
+  return data_grad, None, None, weights_grad
+
+
 def _SegmentMinOrMaxGrad(op, grad, is_sorted):
   """Gradient for SegmentMin and (unsorted) SegmentMax. They share similar code."""
   zeros = array_ops.zeros(array_ops.shape(op.inputs[0]),
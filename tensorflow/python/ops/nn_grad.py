@@ -424,6 +424,24 @@ def _SparseSoftmaxCrossEntropyWithLogitsGrad(op, grad_0, _):
   return _BroadcastMul(grad_0, sparse_softmax_grad_without_gradient), None
 
 
+@ops.RegisterGradient("SampledSoftmaxLoss")
+def _SampledSoftmaxLossGrad(op, grad_loss, _):
+  """Gradient function for SampledSoftmaxLoss."""
+  # As for SparseSoftmaxCrossEntropyWithLogits, there is no second derivative,
+  # and there is no gradient for the labels, the sampled candidates and their
+  # expected counts.
+  weights, biases, inputs, labels, sampled = op.inputs[:5]
+  # pylint: disable=protected-access
+  inputs_grad, weights_grad, biases_grad = (
+      gen_nn_ops._sampled_softmax_loss_grad(grad_loss, op.outputs[1], weights,
+                                            inputs, labels, sampled))
+  # pylint: enable=protected-access
+  ids = array_ops.concat([array_ops.reshape(labels, [-1]), sampled], 0)
+  return (ops.IndexedSlices(weights_grad, ids, array_ops.shape(weights)),
+          ops.IndexedSlices(biases_grad, ids, array_ops.shape(biases)),
+          inputs_grad, None, None, None, None)
+
+
 @ops.RegisterGradient("Conv2D")
 def _Conv2DGrad(op, grad):
   return [nn_ops.conv2d_backprop_input(
@@ -897,6 +897,17 @@ def _sum_rows(x):
   return array_ops.reshape(math_ops.matmul(x, ones), [-1])
 
 
+def _single_tensor(params):
+  """Returns params as a single tensor, or None if it is sharded."""
+  if isinstance(params, variables.PartitionedVariable):
+    params = list(params)
+  if isinstance(params, (list, tuple)):
+    if len(params) != 1:
+      return None
+    params = params[0]
+  return ops.convert_to_tensor(params)
+
+
 def _compute_sampled_logits(weights,
                             biases,
                             labels,
@@ -1253,6 +1264,40 @@ def sampled_softmax_loss(weights,
     A `batch_size` 1-D tensor of per-example sampled softmax losses.
 
   """
+  fused_weights = _single_tensor(weights)
+  fused_biases = _single_tensor(biases)
+  if (fused_weights is not None and fused_biases is not None and
+      fused_weights.dtype.base_dtype in (dtypes.float32, dtypes.float64)):
+    # Computes the logits, loss and gradients of unsharded weights in a single
+    # op, without the intermediate gathers, logits and accidental hits.
+    with ops.name_scope(name, "sampled_softmax_loss",
+                        [fused_weights, fused_biases, inputs, labels]):
+      if labels.dtype != dtypes.int64:
+        labels = math_ops.cast(labels, dtypes.int64)
+      if sampled_values is None:
+        sampled_values = candidate_sampling_ops.log_uniform_candidate_sampler(
+            true_classes=labels,
+            num_true=num_true,
+            num_sampled=num_sampled,
+            unique=True,
+            range_max=num_classes)
+      # pylint: disable=unpacking-non-sequence
+      sampled, true_expected_count, sampled_expected_count = (
+          array_ops.stop_gradient(s) for s in sampled_values)
+      # pylint: enable=unpacking-non-sequence
+      # pylint: disable=protected-access
+      sampled_losses, _ = gen_nn_ops._sampled_softmax_loss(
+          fused_weights,
+          fused_biases,
+          inputs,
+          labels,
+          math_ops.cast(sampled, dtypes.int64),
+          math_ops.cast(true_expected_count, dtypes.float32),
+          math_ops.cast(sampled_expected_count, dtypes.float32),
+          remove_accidental_hits=remove_accidental_hits)
+      # pylint: enable=protected-access
+      return sampled_losses
+
   logits, labels = _compute_sampled_logits(
       weights=weights,
       biases=biases,
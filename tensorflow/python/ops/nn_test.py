@@ -28,6 +28,7 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gradient_checker
+from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import nn_impl
 from tensorflow.python.ops import nn_ops
 from tensorflow.python.ops import partitioned_variables
@@ -810,6 +811,86 @@ class ComputeSampledLogitsTest(test_lib.TestCase):
       self.assertAllClose(sampled_softmax_loss_np,
                           sampled_softmax_loss_tf.eval(), 1e-4)
 
+  def testSampledSoftmaxLossMatchesUnfused(self):
+    # Unsharded weights go through the fused SampledSoftmaxLoss op, which
+    # should match the logits of _compute_sampled_logits, accidental hits and
+    # gradients included.
+    weights, biases, hidden_acts, _, _ = self._GenerateTestInputs()
+    labels = [[0, 1], [1, 2], [2, 4]]
+    sampled = [1, 0, 3, 4]
+    num_true = 2
+    num_sampled = len(sampled)
+    true_exp = np.array(
+        [[0.5, 0.25], [0.125, 0.5], [0.25, 0.75]], dtype=np.float32)
+    sampled_exp = np.array([0.5, 0.25, 0.125, 0.75], dtype=np.float32)
+    test_sampled_vals = (sampled, true_exp, sampled_exp)
+
+    with self.test_session():
+      weights_tf = constant_op.constant(weights)
+      biases_tf = constant_op.constant(biases)
+      inputs_tf = constant_op.constant(hidden_acts)
+      labels_tf = constant_op.constant(labels, dtype=dtypes.int64)
+      for remove_accidental_hits in (False, True):
+        fused_loss = nn_impl.sampled_softmax_loss(
+            weights=weights_tf,
+            biases=biases_tf,
+            labels=labels_tf,
+            inputs=inputs_tf,
+            num_sampled=num_sampled,
+            num_classes=self._num_classes,
+            num_true=num_true,
+            sampled_values=test_sampled_vals,
+            remove_accidental_hits=remove_accidental_hits)
+        self.assertEqual("SampledSoftmaxLoss", fused_loss.op.type)
+        logits, out_labels = _compute_sampled_logits(
+            weights_tf,
+            biases_tf,
+            labels_tf,
+            inputs_tf,
+            num_sampled,
+            self._num_classes,
+            num_true,
+            test_sampled_vals,
+            subtract_log_q=True,
+            remove_accidental_hits=remove_accidental_hits)
+        unfused_loss = nn_ops.softmax_cross_entropy_with_logits(
+            labels=out_labels, logits=logits)
+        self.assertAllClose(unfused_loss.eval(), fused_loss.eval(), 1e-4)
+
+        loss_weights = constant_op.constant([1.0, -2.0, 0.5])
+        fused_grads = gradients_impl.gradients(
+            fused_loss * loss_weights, [weights_tf, biases_tf, inputs_tf])
+        unfused_grads = gradients_impl.gradients(
+            unfused_loss * loss_weights, [weights_tf, biases_tf, inputs_tf])
+        for fused_grad, unfused_grad in zip(fused_grads, unfused_grads):
+          self.assertAllClose(
+              ops.convert_to_tensor(unfused_grad).eval(),
+              ops.convert_to_tensor(fused_grad).eval(), 1e-4)
+
+  def testSampledSoftmaxLossGradient(self):
+    weights, biases, hidden_acts, _, _ = self._GenerateTestInputs()
+    labels = [[0], [3], [2]]
+    test_sampled_vals = ([1, 3, 4],
+                         np.full([self._batch_size, 1], 0.5, np.float32),
+                         np.full([3], 0.25, np.float32))
+    with self.test_session():
+      weights_tf = constant_op.constant(weights)
+      biases_tf = constant_op.constant(biases)
+      inputs_tf = constant_op.constant(hidden_acts)
+      loss = nn_impl.sampled_softmax_loss(
+          weights=weights_tf,
+          biases=biases_tf,
+          labels=constant_op.constant(labels, dtype=dtypes.int64),
+          inputs=inputs_tf,
+          num_sampled=3,
+          num_classes=self._num_classes,
+          sampled_values=test_sampled_vals)
+      for x, x_np in ((weights_tf, weights), (biases_tf, biases),
+                      (inputs_tf, hidden_acts)):
+        err = gradient_checker.compute_gradient_error(
+            x, x_np.shape, loss, [self._batch_size], x_init_value=x_np)
+        self.assertLess(err, 1e-3)
+
 
 class CReluTest(test_lib.TestCase):
 
@@ -265,6 +265,14 @@ PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasSgemmEx)
 
 #if CUDA_VERSION >= 8000
 PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasGemmEx)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasSgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasDgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasCgemmStridedBatched)
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasZgemmStridedBatched)
+#endif
+
+#if CUDA_VERSION >= 9000
+PERFTOOLS_GPUTOOLS_CUBLAS_WRAP(cublasSetMathMode)
 #endif
 
 }  // namespace wrap
@@ -366,6 +374,15 @@ bool CUDABlas::Init() {
     return false;
   }
 
+#if CUDA_VERSION >= 9000
+  // Allows the half precision GEMMs to use the Tensor Cores of the GPUs that
+  // have them. The float GEMMs are not affected.
+  ret = wrap::cublasSetMathMode(parent_, blas_, CUBLAS_TENSOR_OP_MATH);
+  if (ret != CUBLAS_STATUS_SUCCESS) {
+    LOG(ERROR) << "failed to set cublas math mode: " << ToString(ret);
+  }
+#endif
+
   return true;
 }
 
@@ -2130,6 +2147,76 @@ bool CUDABlas::DoBlasGemmBatched(
   return status.ok();
 }
 
+template <typename T, typename FuncT>
+bool CUDABlas::DoBlasGemmStridedBatchedInternal(
+    FuncT cublas_func, Stream *stream, blas::Transpose transa,
+    blas::Transpose transb, uint64 m, uint64 n, uint64 k, T alpha,
+    const DeviceMemory<T> &a, int lda, int64 stride_a, const DeviceMemory<T> &b,
+    int ldb, int64 stride_b, T beta, DeviceMemory<T> *c, int ldc,
+    int64 stride_c, int batch_count) {
+#if CUDA_VERSION >= 8000
+  return DoBlasInternal(
+      cublas_func, stream, true /* = pointer_mode_host */,
+      CUDABlasTranspose(transa), CUDABlasTranspose(transb), m, n, k,
+      CUDAComplex(&alpha), CUDAComplex(CUDAMemory(a)), lda, stride_a,
+      CUDAComplex(CUDAMemory(b)), ldb, stride_b, CUDAComplex(&beta),
+      CUDAComplex(CUDAMemoryMutable(c)), ldc, stride_c, batch_count);
+#else
+  LOG(ERROR) << "Strided batched GEMM requires CUDA 8.0 or later";
+  return false;
+#endif
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, float alpha, const DeviceMemory<float> &a, int lda,
+    int64 stride_a, const DeviceMemory<float> &b, int ldb, int64 stride_b,
+    float beta, DeviceMemory<float> *c, int ldc, int64 stride_c,
+    int batch_count) {
+  return DoBlasGemmStridedBatchedInternal(
+      wrap::cublasSgemmStridedBatched, stream, transa, transb, m, n, k,
+      alpha, a, lda, stride_a, b, ldb, stride_b, beta, c, ldc, stride_c,
+      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, double alpha, const DeviceMemory<double> &a, int lda,
+    int64 stride_a, const DeviceMemory<double> &b, int ldb, int64 stride_b,
+    double beta, DeviceMemory<double> *c, int ldc, int64 stride_c,
+    int batch_count) {
+  return DoBlasGemmStridedBatchedInternal(
+      wrap::cublasDgemmStridedBatched, stream, transa, transb, m, n, k,
+      alpha, a, lda, stride_a, b, ldb, stride_b, beta, c, ldc, stride_c,
+      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, std::complex<float> alpha,
+    const DeviceMemory<std::complex<float>> &a, int lda, int64 stride_a,
+    const DeviceMemory<std::complex<float>> &b, int ldb, int64 stride_b,
+    std::complex<float> beta, DeviceMemory<std::complex<float>> *c, int ldc,
+    int64 stride_c, int batch_count) {
+  return DoBlasGemmStridedBatchedInternal(
+      wrap::cublasCgemmStridedBatched, stream, transa, transb, m, n, k,
+      alpha, a, lda, stride_a, b, ldb, stride_b, beta, c, ldc, stride_c,
+      batch_count);
+}
+
+bool CUDABlas::DoBlasGemmStridedBatched(
+    Stream *stream, blas::Transpose transa, blas::Transpose transb, uint64 m,
+    uint64 n, uint64 k, std::complex<double> alpha,
+    const DeviceMemory<std::complex<double>> &a, int lda, int64 stride_a,
+    const DeviceMemory<std::complex<double>> &b, int ldb, int64 stride_b,
+    std::complex<double> beta, DeviceMemory<std::complex<double>> *c, int ldc,
+    int64 stride_c, int batch_count) {
+  return DoBlasGemmStridedBatchedInternal(
+      wrap::cublasZgemmStridedBatched, stream, transa, transb, m, n, k,
+      alpha, a, lda, stride_a, b, ldb, stride_b, beta, c, ldc, stride_c,
+      batch_count);
+}
+
 bool CUDABlas::DoBlasHemm(Stream *stream, blas::Side side,
                           blas::UpperLower uplo, uint64 m, uint64 n,
                           std::complex<float> alpha,
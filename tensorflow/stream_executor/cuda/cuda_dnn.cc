@@ -239,6 +239,15 @@ CUDNN_DNN_ROUTINE_EACH_R5(PERFTOOLS_GPUTOOLS_CUDNN_WRAP)
 #undef CUDNN_DNN_ROUTINE_EACH_R5
 #endif
 
+// APIs in R7
+#if CUDNN_VERSION >= 7000
+#define CUDNN_DNN_ROUTINE_EACH_R7(__macro)                    \
+  __macro(cudnnSetConvolutionMathType)
+
+CUDNN_DNN_ROUTINE_EACH_R7(PERFTOOLS_GPUTOOLS_CUDNN_WRAP)
+#undef CUDNN_DNN_ROUTINE_EACH_R7
+#endif
+
 #undef CUDNN_DNN_ROUTINE_EACH
 
 }  // namespace wrap
@@ -556,6 +565,17 @@ class ScopedConvolutionDescriptor {
       LOG(FATAL) << "could not set cudnn convolution descriptor: "
                  << ToString(status);
     }
+
+#if CUDNN_VERSION >= 7000
+    // Allows the half precision convolutions to use the Tensor Cores of the
+    // GPUs that have them. The float convolutions are not affected.
+    status = wrap::cudnnSetConvolutionMathType(parent_, handle_,
+                                               CUDNN_TENSOR_OP_MATH);
+    if (status != CUDNN_STATUS_SUCCESS) {
+      LOG(ERROR) << "could not set cudnn convolution math type: "
+                 << ToString(status);
+    }
+#endif
   }
 
   ~ScopedConvolutionDescriptor() {
@@ -943,6 +943,71 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   }
 }
 
+/* static */ void *CUDADriver::UnifiedMemoryAllocate(CudaContext *context,
+                                                     uint64 bytes) {
+  ScopedActivateContext activation{context};
+  CUdeviceptr result = 0;
+  // "Global" memory may be accessed from any stream of any device.
+  CUresult res = cuMemAllocManaged(&result, bytes, CU_MEM_ATTACH_GLOBAL);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to alloc "
+               << port::HumanReadableNumBytes::ToString(bytes) << " (" << bytes
+               << " bytes) of unified memory: " << ToString(res);
+    return nullptr;
+  }
+#if CUDA_VERSION >= 8000
+  CUdevice device;
+  res = cuCtxGetDevice(&device);
+  if (res == CUDA_SUCCESS) {
+    res = cuMemAdvise(result, bytes, CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+                      device);
+  }
+  if (res != CUDA_SUCCESS) {
+    VLOG(1) << "failed to set the preferred location of unified memory: "
+            << ToString(res);
+  }
+#endif
+  void *ptr = reinterpret_cast<void *>(result);
+  VLOG(2) << "allocated " << ptr << " of unified memory for context "
+          << context << " of " << bytes << " bytes";
+  return ptr;
+}
+
+/* static */ void CUDADriver::UnifiedMemoryDeallocate(CudaContext *context,
+                                                     void *location) {
+  ScopedActivateContext activation{context};
+  CUdeviceptr pointer = port::bit_cast<CUdeviceptr>(location);
+  CUresult res = cuMemFree(pointer);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to free unified memory at " << location
+               << "; result: " << ToString(res);
+  } else {
+    VLOG(2) << "deallocated unified memory at " << location
+            << " for context " << context;
+  }
+}
+
+/* static */ bool CUDADriver::PrefetchToDevice(CudaContext *context,
+                                              CUdeviceptr location,
+                                              uint64 size, CUstream stream) {
+#if CUDA_VERSION >= 8000
+  ScopedActivateContext activation{context};
+  CUdevice device;
+  CUresult res = cuCtxGetDevice(&device);
+  if (res == CUDA_SUCCESS) {
+    res = cuMemPrefetchAsync(location, size, device, stream);
+  }
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to enqueue prefetch of " << size << " bytes at "
+               << port::bit_cast<void *>(location) << ": " << ToString(res);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 /* static */ void *CUDADriver::HostAllocate(CudaContext *context,
                                             uint64 bytes) {
   ScopedActivateContext activation{context};
@@ -107,6 +107,26 @@ class CUDADriver {
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1g89b3f154e17cc89b6eea277dbdf5c93a
   static void DeviceDeallocate(CudaContext* context, void *location);
 
+  // Allocates memory of size bytes managed by the unified memory system via
+  // cuMemAllocManaged, and advises the driver to keep it on the device of the
+  // given context via cuMemAdvise. The memory is accessible from the host and
+  // all the devices, and on devices that can page fault it may exceed the
+  // device memory: pages are then evicted to the host and migrated back on
+  // demand.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1gb347ded34dc326af404aa02af5388a32
+  static void *UnifiedMemoryAllocate(CudaContext* context, uint64 bytes);
+
+  // Deallocates a location created by UnifiedMemoryAllocate, via cuMemFree.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1g89b3f154e17cc89b6eea277dbdf5c93a
+  static void UnifiedMemoryDeallocate(CudaContext* context, void *location);
+
+  // Enqueues on stream the migration of size bytes of unified memory at
+  // location to the device of the given context via cuMemPrefetchAsync.
+  // Returns false if it failed, or if CUDA is older than 8.0.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__UNIFIED.html#group__CUDA__UNIFIED_1gfe94f8b7fb56291ebcea44261aa4cb84
+  static bool PrefetchToDevice(CudaContext* context, CUdeviceptr location,
+                               uint64 size, CUstream stream);
+
   // Allocates page-locked and CUDA-registered memory on the host via
   // cuMemAllocHost.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__MEM.html#group__CUDA__MEM_1gdd8311286d2c2691605362c689bc64e0
@@ -357,8 +357,7 @@ bool CUDAExecutor::Launch(Stream *stream, const ThreadDim &thread_dims,
     }
   }
 
-  if (cuda_kernel->GetPreferredCacheConfig() !=
-      KernelCacheConfig::kNoPreference) {
+  if (cuda_kernel->UpdateAppliedCacheConfig()) {
     CUDADriver::FuncSetCacheConfig(cufunc, cuda_kernel->GetCUDACacheConfig());
   }
 
@@ -520,6 +519,14 @@ bool CUDAExecutor::MemZero(Stream *stream, DeviceMemoryBase *location,
   }
 }
 
+bool CUDAExecutor::MemPrefetch(Stream *stream, const DeviceMemoryBase &location,
+                               uint64 size) {
+  VLOG(2) << "enqueueing prefetch operation onto stream " << stream
+          << " at location " << location.opaque() << " with size " << size;
+  return CUDADriver::PrefetchToDevice(context_, AsCudaDevicePtr(location),
+                                      size, AsCUDAStreamValue(stream));
+}
+
 bool CUDAExecutor::Memset(Stream *stream, DeviceMemoryBase *location,
                            uint8 pattern, uint64 size) {
   VLOG(2) << "enqueueing memset8 operation onto stream " << stream
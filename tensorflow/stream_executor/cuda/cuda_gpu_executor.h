@@ -88,6 +88,17 @@ class CUDAExecutor : public internal::StreamExecutorInterface {
 
   bool HostMemoryRegister(void *location, uint64 size) override;
 
+  void *UnifiedMemoryAllocate(uint64 size) override {
+    return CUDADriver::UnifiedMemoryAllocate(context_, size);
+  }
+
+  void UnifiedMemoryDeallocate(void *location) override {
+    return CUDADriver::UnifiedMemoryDeallocate(context_, location);
+  }
+
+  bool MemPrefetch(Stream *stream, const DeviceMemoryBase &location,
+                   uint64 size) override;
+
   bool HostMemoryUnregister(void *location) override;
 
   bool SynchronizeAllActivity() override;
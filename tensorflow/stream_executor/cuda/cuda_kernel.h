@@ -22,6 +22,8 @@ limitations under the License.
 #ifndef TENSORFLOW_STREAM_EXECUTOR_CUDA_CUDA_KERNEL_H_
 #define TENSORFLOW_STREAM_EXECUTOR_CUDA_CUDA_KERNEL_H_
 
+#include <atomic>
+
 #include "tensorflow/stream_executor/kernel_cache_config.h"
 #include "tensorflow/stream_executor/stream_executor_internal.h"
 #include "tensorflow/stream_executor/cuda/cuda_driver.h"
@@ -85,6 +87,14 @@ class CUDAKernel : public internal::KernelInterface {
     return preferred_cache_config_;
   }
 
+  // Returns true if the preference changed since the last call, and so has to
+  // be set on the CUfunction before the next launch. Saves a driver call on
+  // every launch of kernels that keep their preference.
+  bool UpdateAppliedCacheConfig() const {
+    return applied_cache_config_.exchange(preferred_cache_config_) !=
+           preferred_cache_config_;
+  }
+
   // Returns the current kernel cache configuration preference as a
   // CUfunc_cache.
   CUfunc_cache GetCUDACacheConfig() const {
@@ -109,6 +119,11 @@ class CUDAKernel : public internal::KernelInterface {
 
   // Preferred (but not required) cache configuration for this kernel.
   KernelCacheConfig preferred_cache_config_;
+
+  // The configuration last set on cuda_function_. Functions start without a
+  // preference.
+  mutable std::atomic<KernelCacheConfig> applied_cache_config_{
+      KernelCacheConfig::kNoPreference};
 };
 
 // Given a platform-independent kernel datatype, returns the (const) internal
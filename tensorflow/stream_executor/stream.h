@@ -21,6 +21,7 @@ limitations under the License.
 #ifndef TENSORFLOW_STREAM_EXECUTOR_STREAM_H_
 #define TENSORFLOW_STREAM_EXECUTOR_STREAM_H_
 
+#include <atomic>
 #include <complex>
 #include <functional>
 #include <memory>
@@ -1296,6 +1297,34 @@ class Stream {
       const port::ArraySlice<DeviceMemory<std::complex<double>> *> &c, int ldc,
       int batch_count, ScratchAllocator *scratch_allocator);
 
+  // See BlasSupport::DoBlasGemmStridedBatched.
+  Stream &ThenBlasGemmStridedBatched(
+      blas::Transpose transa, blas::Transpose transb, uint64 m, uint64 n,
+      uint64 k, float alpha, const DeviceMemory<float> &a, int lda,
+      int64 stride_a, const DeviceMemory<float> &b, int ldb, int64 stride_b,
+      float beta, DeviceMemory<float> *c, int ldc, int64 stride_c,
+      int batch_count);
+  Stream &ThenBlasGemmStridedBatched(
+      blas::Transpose transa, blas::Transpose transb, uint64 m, uint64 n,
+      uint64 k, double alpha, const DeviceMemory<double> &a, int lda,
+      int64 stride_a, const DeviceMemory<double> &b, int ldb, int64 stride_b,
+      double beta, DeviceMemory<double> *c, int ldc, int64 stride_c,
+      int batch_count);
+  Stream &ThenBlasGemmStridedBatched(
+      blas::Transpose transa, blas::Transpose transb, uint64 m, uint64 n,
+      uint64 k, std::complex<float> alpha,
+      const DeviceMemory<std::complex<float>> &a, int lda, int64 stride_a,
+      const DeviceMemory<std::complex<float>> &b, int ldb, int64 stride_b,
+      std::complex<float> beta, DeviceMemory<std::complex<float>> *c, int ldc,
+      int64 stride_c, int batch_count);
+  Stream &ThenBlasGemmStridedBatched(
+      blas::Transpose transa, blas::Transpose transb, uint64 m, uint64 n,
+      uint64 k, std::complex<double> alpha,
+      const DeviceMemory<std::complex<double>> &a, int lda, int64 stride_a,
+      const DeviceMemory<std::complex<double>> &b, int ldb, int64 stride_b,
+      std::complex<double> beta, DeviceMemory<std::complex<double>> *c,
+      int ldc, int64 stride_c, int batch_count);
+
   // See BlasSupport::DoBlasHemm.
   Stream &ThenBlasHemm(blas::Side side, blas::UpperLower uplo, uint64 m,
                        uint64 n, std::complex<float> alpha,
@@ -1658,10 +1687,9 @@ class Stream {
   friend struct ThenBlasImpl;  // for implementing ThenBlasXXX.
   friend class ocl::CLBlas;    // for parent_.
 
-  bool InErrorState() const {
-    shared_lock lock{mu_};
-    return !ok_;
-  }
+  // Every Then* call checks the error state, so it is read without taking
+  // mu_.
+  bool InErrorState() const { return !ok_.load(std::memory_order_acquire); }
 
   // Sets the error state if operation_retcode is false.
   // This is a useful shorthand for many stream routines.
@@ -1669,8 +1697,7 @@ class Stream {
     if (operation_retcode) {
       return;
     }
-    mutex_lock lock{mu_};
-    ok_ = false;
+    ok_.store(false, std::memory_order_release);
   }
 
   void SetError() { CheckError(false /* = operation_retcode */); }
@@ -1698,8 +1725,9 @@ class Stream {
   bool allocated_ GUARDED_BY(mu_);
 
   // Whether all operations have entrained successfully to the current program
-  // point.
-  bool ok_ GUARDED_BY(mu_);
+  // point. Written under mu_ by Init(), and never becomes true again once
+  // an operation has failed.
+  std::atomic<bool> ok_;
 
   // Sub-streams that are generated from this stream. Each element has a pointer
   // to sub-stream and a boolean value indicating if this substream is ready to
@@ -194,6 +194,12 @@ class StreamExecutorInterface {
   virtual void *HostMemoryAllocate(uint64 size) = 0;
   virtual void HostMemoryDeallocate(void *mem) = 0;
   virtual bool HostMemoryRegister(void *mem, uint64 size) = 0;
+  virtual void *UnifiedMemoryAllocate(uint64 size) { return nullptr; }
+  virtual void UnifiedMemoryDeallocate(void *mem) {}
+  virtual bool MemPrefetch(Stream *stream, const DeviceMemoryBase &location,
+                           uint64 size) {
+    return false;
+  }
   virtual bool HostMemoryUnregister(void *mem) = 0;
   virtual bool SynchronizeAllActivity() = 0;
   virtual bool SynchronousMemZero(DeviceMemoryBase *location, uint64 size) = 0;
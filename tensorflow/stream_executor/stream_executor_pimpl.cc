@@ -447,6 +447,26 @@ void StreamExecutor::HostMemoryDeallocate(void *location) {
   return implementation_->HostMemoryDeallocate(location);
 }
 
+void *StreamExecutor::UnifiedMemoryAllocate(uint64 size) {
+  void *buffer = implementation_->UnifiedMemoryAllocate(size);
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryAllocate(size=" << size
+          << ") returns " << buffer << StackTraceIfVLOG10();
+  return buffer;
+}
+
+void StreamExecutor::UnifiedMemoryDeallocate(void *location) {
+  VLOG(1) << "Called StreamExecutor::UnifiedMemoryDeallocate(location="
+          << location << ")" << StackTraceIfVLOG10();
+
+  return implementation_->UnifiedMemoryDeallocate(location);
+}
+
+bool StreamExecutor::MemPrefetch(Stream *stream,
+                                 const DeviceMemoryBase &location,
+                                 uint64 size) {
+  return implementation_->MemPrefetch(stream, location, size);
+}
+
 bool StreamExecutor::HostMemoryRegister(void *location, uint64 size) {
   VLOG(1) << "Called StreamExecutor::HostMemoryRegister(location=" << location
           << ", size=" << size << ")" << StackTraceIfVLOG10();
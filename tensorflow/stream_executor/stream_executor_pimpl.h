@@ -193,6 +193,22 @@ class StreamExecutor {
   // Deallocates a region of host memory allocated by HostMemoryAllocate().
   void HostMemoryDeallocate(void *location);
 
+  // Allocates a region of memory managed by the platform's unified memory
+  // system: accessible from the host and the devices, and migrated by the
+  // platform to wherever it is accessed. Returns nullptr if the platform
+  // has no unified memory.
+  void *UnifiedMemoryAllocate(uint64 bytes);
+
+  // Deallocates a region of memory allocated by UnifiedMemoryAllocate().
+  void UnifiedMemoryDeallocate(void *location);
+
+  // Enqueues onto stream the migration of size bytes of unified memory at
+  // location to this device, ahead of the operations that access it. Only
+  // a hint: returns whether the operation was enqueued, and leaves the
+  // stream ok either way.
+  bool MemPrefetch(Stream *stream, const DeviceMemoryBase &location,
+                   uint64 size);
+
   // Registers a region of host memory with the platform API. Registered memory
   // (or memory allocated with HostMemoryAllocate) is required for use with
   // asynchronous memcpy operations, such as Stream::ThenMemcpy. This method
@@ -1196,3 +1196,28 @@ def cc_library_with_android_deps(deps,
                                  **kwargs):
   deps = if_not_android(deps) + if_android(android_deps) + common_deps
   native.cc_library(deps=deps, **kwargs)
+
+
+# Generates the ops_to_register.h header used with -DSELECTIVE_REGISTRATION,
+# registering only the ops and kernels that the GraphDefs in graphs need. The
+# header is exported by the cc_library name. See
+# tensorflow/core/framework/selective_registration.h.
+def tf_selective_registration_header(
+    name,
+    graphs,
+    proto_fileformat="rawproto",
+    default_ops="NoOp:NoOp,_Recv:RecvOp,_Send:SendOp",
+    **kwargs):
+  tool = clean_dep(
+      "//tensorflow/python/tools:print_selective_registration_header")
+  header = name + "/ops_to_register.h"
+  native.genrule(
+      name=name + "_gen",
+      srcs=graphs,
+      outs=[header],
+      cmd=("$(location " + tool + ")" + " --graphs=" +
+           ",".join(["$(location " + graph + ")" for graph in graphs]) +
+           " --proto_fileformat=" + proto_fileformat + " --default_ops=" +
+           default_ops + " > $@"),
+      tools=[tool],)
+  native.cc_library(name=name, hdrs=[header], includes=[name], **kwargs)
@@ -20,6 +20,8 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -42,6 +45,8 @@ limitations under the License.
 #include "tensorflow/core/util/command_line_flags.h"
 #include "tensorflow/core/util/reporter.h"
 #include "tensorflow/core/util/stat_summarizer.h"
+#include "tensorflow/tools/benchmark/device_control.h"
+#include "tensorflow/tools/benchmark/run_stats.h"
 
 namespace tensorflow {
 namespace benchmark_model {
@@ -209,7 +214,8 @@ Status CalculateFlops(const GraphDef& graph,
 
 Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
                     const std::vector<string>& outputs, Session* session,
-                    StatSummarizer* stats, int64* inference_time_us) {
+                    StatSummarizer* stats, int64* inference_time_us,
+                    RunStats* run_stats) {
   std::vector<std::pair<string, tensorflow::Tensor> > input_tensors;
   CreateTensorsFromInputInfo(inputs, &input_tensors);
 
@@ -238,6 +244,11 @@ Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
     assert(run_metadata.has_step_stats());
     const StepStats& step_stats = run_metadata.step_stats();
     stats->ProcessStepStats(step_stats);
+    if (run_stats != nullptr) {
+      run_stats->ProcessStepStats(step_stats);
+    }
+  } else if (run_stats != nullptr) {
+    run_stats->AddRunTime(*inference_time_us);
   }
 
   return s;
@@ -246,7 +257,8 @@ Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
 Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         const std::vector<InputLayerInfo>& inputs,
                         const std::vector<string>& outputs, Session* session,
-                        StatSummarizer* stats, int64* total_time_us) {
+                        StatSummarizer* stats, int64* total_time_us,
+                        RunStats* run_stats) {
   // Convert the run_delay string into a timespec.
   timespec req;
   req.tv_sec = static_cast<time_t>(sleep_seconds);
@@ -261,7 +273,8 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   Stat<int64> stat;
   for (int i = 0; i < num_runs; ++i) {
     int64 time;
-    Status run_status = RunBenchmark(inputs, outputs, session, stats, &time);
+    Status run_status =
+        RunBenchmark(inputs, outputs, session, stats, &time, run_stats);
     stat.UpdateStat(time);
     *total_time_us += time;
     if (!run_status.ok()) {
@@ -287,6 +300,36 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   return Status::OK();
 }
 
+Status WarmUpUntilSteady(double sleep_seconds, int window_runs, int max_runs,
+                         double tolerance,
+                         const std::vector<InputLayerInfo>& inputs,
+                         const std::vector<string>& outputs, Session* session,
+                         int* num_runs) {
+  *num_runs = 0;
+  double previous_mean_us = -1.0;
+  while (*num_runs < max_runs) {
+    const int runs = std::min(window_runs, max_runs - *num_runs);
+    RunStats window_stats;
+    int64 window_time_us;
+    TF_RETURN_IF_ERROR(TimeMultipleRuns(sleep_seconds, runs, inputs, outputs,
+                                        session, nullptr, &window_time_us,
+                                        &window_stats));
+    *num_runs += runs;
+    const double mean_us =
+        grappler::RobustStats(window_stats.run_times_us()).mean();
+    LOG(INFO) << "Warmup mean after " << *num_runs << " runs: " << mean_us
+              << "us";
+    if (previous_mean_us > 0.0 &&
+        std::abs(mean_us - previous_mean_us) <= tolerance * previous_mean_us) {
+      return Status::OK();
+    }
+    previous_mean_us = mean_us;
+  }
+  LOG(WARNING) << "The run time is still not steady after " << *num_runs
+               << " warmup runs";
+  return Status::OK();
+}
+
 int Main(int argc, char** argv) {
   string graph = "/data/local/tmp/tensorflow_inception_graph.pb";
   string input_layer_string = "input:0";
@@ -310,6 +353,14 @@ int Main(int argc, char** argv) {
   bool show_summary = true;
   bool show_flops = false;
   int warmup_runs = 2;
+  int max_warmup_runs = 0;
+  float warmup_tolerance = 0.02f;
+  string cpu_affinity = "";
+  float max_temperature = -1.0f;
+  float cooldown_timeout = 300.0f;
+  string stats_output_file = "";
+  string compare_stats = "";
+  float significance_threshold = 3.0f;
 
   std::vector<Flag> flag_list = {
       Flag("graph", &graph, "graph file name"),
@@ -339,6 +390,25 @@ int Main(int argc, char** argv) {
            "whether to show a summary of the stats"),
       Flag("show_flops", &show_flops, "whether to estimate the model's FLOPs"),
       Flag("warmup_runs", &warmup_runs, "how many runs to initialize model"),
+      Flag("max_warmup_runs", &max_warmup_runs,
+           "if above warmup_runs, warm up by windows of warmup_runs runs until "
+           "the run time is steady, for at most this many runs"),
+      Flag("warmup_tolerance", &warmup_tolerance,
+           "relative change of the mean run time of a warmup window below "
+           "which the run time is steady"),
+      Flag("cpu_affinity", &cpu_affinity,
+           "CPUs to run on: a comma-separated list, or big or little"),
+      Flag("max_temperature", &max_temperature,
+           "if positive, wait until the device is at most this hot in "
+           "degrees Celsius before benchmarking"),
+      Flag("cooldown_timeout", &cooldown_timeout,
+           "how many seconds to wait for the device to cool down"),
+      Flag("stats_output_file", &stats_output_file,
+           "file to write the run and node times to, for --compare_stats"),
+      Flag("compare_stats", &compare_stats,
+           "compare two --stats_output_file files, base,test, and exit"),
+      Flag("significance_threshold", &significance_threshold,
+           "t-value above which a change of time is significant"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   const bool parse_result = Flags::Parse(&argc, argv, flag_list);
@@ -378,6 +448,31 @@ int Main(int argc, char** argv) {
     return -1;
   }
 
+  if (!compare_stats.empty()) {
+    const std::vector<string> files = str_util::Split(compare_stats, ',');
+    if (files.size() != 2) {
+      LOG(ERROR) << "--compare_stats must be two files, base,test";
+      return -1;
+    }
+    RunStats base_stats;
+    RunStats test_stats;
+    Status read_status =
+        RunStats::ReadFromFile(Env::Default(), files[0], &base_stats);
+    if (read_status.ok()) {
+      read_status =
+          RunStats::ReadFromFile(Env::Default(), files[1], &test_stats);
+    }
+    if (!read_status.ok()) {
+      LOG(ERROR) << "Reading the stats failed with " << read_status;
+      return -1;
+    }
+    LOG(INFO) << "Comparison of " << files[1] << " to " << files[0] << ":\n"
+              << FormatComparisons(CompareRunStats(base_stats, test_stats,
+                                                   significance_threshold),
+                                   time_limit);
+    return 0;
+  }
+
   LOG(INFO) << "Graph: [" << graph << "]";
   LOG(INFO) << "Input layers: [" << input_layer_string << "]";
   LOG(INFO) << "Input shapes: [" << input_layer_shape_string << "]";
@@ -390,6 +485,18 @@ int Main(int argc, char** argv) {
   LOG(INFO) << "Output prefix: [" << output_prefix << "]";
   LOG(INFO) << "Show sizes: [" << show_sizes << "]";
   LOG(INFO) << "Warmup runs: [" << warmup_runs << "]";
+  LOG(INFO) << "CPU affinity: [" << cpu_affinity << "]";
+
+  // The threads of the session inherit the affinity.
+  std::vector<int> cpus;
+  if (!cpu_affinity.empty()) {
+    Status affinity_status = SetCpuAffinity(cpu_affinity, &cpus);
+    if (!affinity_status.ok()) {
+      LOG(ERROR) << "Setting the CPU affinity failed with " << affinity_status;
+      return -1;
+    }
+    LOG(INFO) << "Running on CPUs " << str_util::Join(cpus, ",");
+  }
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
@@ -437,7 +544,17 @@ int Main(int argc, char** argv) {
   // If requested, run through the graph first to preinitialize everything
   // before the benchmarking runs.
   int64 warmup_time_us = 0;
-  if (warmup_runs > 0) {
+  if (warmup_runs > 0 && max_warmup_runs > warmup_runs) {
+    const int64 warmup_start_us = Env::Default()->NowMicros();
+    Status warmup_status = WarmUpUntilSteady(
+        sleep_seconds, warmup_runs, max_warmup_runs, warmup_tolerance, inputs,
+        output_layers, session.get(), &warmup_runs);
+    warmup_time_us = Env::Default()->NowMicros() - warmup_start_us;
+    if (!warmup_status.ok()) {
+      LOG(ERROR) << "Warmup failed with " << warmup_status;
+      return -1;
+    }
+  } else if (warmup_runs > 0) {
     Status warmup_time_status =
         TimeMultipleRuns(sleep_seconds, warmup_runs, inputs, output_layers,
                          session.get(), nullptr, &warmup_time_us);
@@ -447,29 +564,66 @@ int Main(int argc, char** argv) {
     }
   }
 
+  if (max_temperature > 0.0f) {
+    Status cooldown_status = WaitForTemperature(
+        static_cast<int64>(max_temperature * 1000), cooldown_timeout);
+    if (!cooldown_status.ok()) {
+      LOG(WARNING) << "Cooling down failed with " << cooldown_status;
+    }
+  }
+  const std::vector<int64> start_frequencies = GetCpuFrequenciesKHz(cpus);
+  const int64 start_temperature = GetMaxTemperatureMilliCelsius();
+
   // Capture overall inference time without stat logging overhead. This is the
   // timing data that can be compared to other libaries.
   int64 no_stat_time_us = 0;
+  RunStats run_stats(*graph_def);
   Status no_stat_time_status =
       TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
-                       session.get(), nullptr, &no_stat_time_us);
+                       session.get(), nullptr, &no_stat_time_us, &run_stats);
   const double no_stat_wall_time = no_stat_time_us / 1000000.0;
   if (!no_stat_time_status.ok()) {
     LOG(ERROR) << "Timing failed with " << no_stat_time_status;
     return -1;
   }
 
+  // A drop of the frequency of the CPUs during the runs is likely thermal
+  // throttling, which makes the times unreliable.
+  const std::vector<int64> end_frequencies = GetCpuFrequenciesKHz(cpus);
+  for (int i = 0; i < cpus.size(); ++i) {
+    if (end_frequencies[i] < start_frequencies[i] * 0.9) {
+      LOG(WARNING) << "The frequency of CPU " << cpus[i] << " dropped from "
+                   << start_frequencies[i] << "kHz to " << end_frequencies[i]
+                   << "kHz during the runs, which may have been throttled";
+    }
+  }
+  const int64 end_temperature = GetMaxTemperatureMilliCelsius();
+  if (start_temperature >= 0) {
+    LOG(INFO) << "Device temperature: " << start_temperature / 1000.0
+              << "C before the runs, " << end_temperature / 1000.0
+              << "C after";
+  }
+
   // Run again to gather detailed log stats to get a better idea of where
   // relative time is going within the graph.
   int64 stat_time_us = 0;
   Status stat_time_status =
       TimeMultipleRuns(sleep_seconds, num_runs, inputs, output_layers,
-                       session.get(), stats.get(), &stat_time_us);
+                       session.get(), stats.get(), &stat_time_us, &run_stats);
   if (!stat_time_status.ok()) {
     LOG(ERROR) << "Timing failed with " << stat_time_status;
     return -1;
   }
 
+  if (!stats_output_file.empty()) {
+    Status write_status =
+        run_stats.WriteToFile(Env::Default(), stats_output_file);
+    if (!write_status.ok()) {
+      LOG(ERROR) << "Writing the stats failed with " << write_status;
+      return -1;
+    }
+  }
+
   LOG(INFO) << "Average inference timings in us: "
             << "Warmup: "
             << (warmup_runs > 0 ? warmup_time_us / warmup_runs : 0) << ", "
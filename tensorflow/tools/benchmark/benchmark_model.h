@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/stat_summarizer.h"
+#include "tensorflow/tools/benchmark/run_stats.h"
 
 namespace tensorflow {
 namespace benchmark_model {
@@ -36,15 +37,30 @@ Status InitializeSession(int num_threads, const string& graph,
                          std::unique_ptr<GraphDef>* graph_def);
 
 // Does a single run of the model that's been loaded into the given session.
+// The run is traced if 'stats' is not null. If 'run_stats' is not null, the
+// node times of a traced run, or else the total time of the run, are added to
+// it, since tracing slows the runs down.
 Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
                     const std::vector<string>& outputs, Session* session,
-                    StatSummarizer* stats, int64* inference_time_us);
+                    StatSummarizer* stats, int64* inference_time_us,
+                    RunStats* run_stats = nullptr);
 
 // Runs the model multiple time, keeping track of timing information.
 Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         const std::vector<InputLayerInfo>& inputs,
                         const std::vector<string>& outputs, Session* session,
-                        StatSummarizer* stats, int64* total_time_us);
+                        StatSummarizer* stats, int64* total_time_us,
+                        RunStats* run_stats = nullptr);
+
+// Runs the model by windows of 'window_runs' runs until the robust mean time of
+// a window differs by at most 'tolerance' times from that of the previous one,
+// so that the caches, allocators and CPU frequencies are in their steady state,
+// or until 'max_runs' runs. Returns the number of runs in 'num_runs'.
+Status WarmUpUntilSteady(double sleep_seconds, int window_runs, int max_runs,
+                         double tolerance,
+                         const std::vector<InputLayerInfo>& inputs,
+                         const std::vector<string>& outputs, Session* session,
+                         int* num_runs);
 
 // Handles all setup and argument parsing.
 int Main(int argc, char** argv);
@@ -0,0 +1,153 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/device_control.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace benchmark_model {
+
+namespace {
+
+// Reads the integer in the sysfs file 'path', or returns -1.
+int64 ReadSysfsInt(const string& path) {
+  std::ifstream file(path);
+  int64 value = -1;
+  if (!(file >> value)) {
+    return -1;
+  }
+  return value;
+}
+
+string CpuFrequencyPath(int cpu, const string& name) {
+  return strings::StrCat("/sys/devices/system/cpu/cpu", cpu, "/cpufreq/",
+                         name);
+}
+
+}  // namespace
+
+Status SetCpuAffinity(const string& spec, std::vector<int>* cpus) {
+  cpus->clear();
+#if defined(__linux__)
+  const int num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+  if (spec == "big" || spec == "little") {
+    std::vector<int64> max_frequencies(num_cpus);
+    for (int cpu = 0; cpu < num_cpus; ++cpu) {
+      max_frequencies[cpu] =
+          ReadSysfsInt(CpuFrequencyPath(cpu, "cpuinfo_max_freq"));
+    }
+    const auto extreme =
+        spec == "big"
+            ? std::max_element(max_frequencies.begin(), max_frequencies.end())
+            : std::min_element(max_frequencies.begin(), max_frequencies.end());
+    if (extreme == max_frequencies.end() || *extreme <= 0) {
+      return errors::Unavailable("The CPU frequencies are unknown");
+    }
+    for (int cpu = 0; cpu < num_cpus; ++cpu) {
+      if (max_frequencies[cpu] == *extreme) {
+        cpus->push_back(cpu);
+      }
+    }
+  } else {
+    std::vector<int32> parsed;
+    if (!str_util::SplitAndParseAsInts(spec, ',', &parsed) || parsed.empty()) {
+      return errors::InvalidArgument("Invalid CPU list '", spec, "'");
+    }
+    for (int32 cpu : parsed) {
+      if (cpu < 0 || cpu >= num_cpus || cpu >= CPU_SETSIZE) {
+        return errors::InvalidArgument("CPU ", cpu, " is out of range [0, ",
+                                       num_cpus, ")");
+      }
+      cpus->push_back(cpu);
+    }
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : *cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    return errors::Internal("Could not set the CPU affinity to ", spec);
+  }
+  return Status::OK();
+#else
+  return errors::Unimplemented("CPU affinity is not supported");
+#endif
+}
+
+std::vector<int64> GetCpuFrequenciesKHz(const std::vector<int>& cpus) {
+  std::vector<int64> frequencies;
+  for (int cpu : cpus) {
+    frequencies.push_back(std::max<int64>(
+        0, ReadSysfsInt(CpuFrequencyPath(cpu, "scaling_cur_freq"))));
+  }
+  return frequencies;
+}
+
+int64 GetMaxTemperatureMilliCelsius() {
+  int64 max_temperature = -1;
+#if defined(__linux__)
+  std::vector<string> paths;
+  if (!Env::Default()
+           ->GetMatchingPaths("/sys/class/thermal/thermal_zone*/temp", &paths)
+           .ok()) {
+    return -1;
+  }
+  for (const string& path : paths) {
+    max_temperature = std::max(max_temperature, ReadSysfsInt(path));
+  }
+#endif
+  return max_temperature;
+}
+
+Status WaitForTemperature(int64 max_temperature_millicelsius,
+                          double timeout_seconds) {
+  Env* env = Env::Default();
+  const int64 deadline_us =
+      env->NowMicros() + static_cast<int64>(timeout_seconds * 1e6);
+  int64 temperature = GetMaxTemperatureMilliCelsius();
+  if (temperature < 0) {
+    return errors::Unavailable("The temperature of the device is unknown");
+  }
+  while (temperature > max_temperature_millicelsius) {
+    if (env->NowMicros() >= deadline_us) {
+      return errors::DeadlineExceeded(
+          "The device is still at ", temperature / 1000.0, "C after ",
+          timeout_seconds, " seconds");
+    }
+    LOG(INFO) << "Waiting for the device to cool down from "
+              << temperature / 1000.0 << "C";
+    env->SleepForMicroseconds(1000000);
+    temperature = GetMaxTemperatureMilliCelsius();
+  }
+  return Status::OK();
+}
+
+}  // namespace benchmark_model
+}  // namespace tensorflow
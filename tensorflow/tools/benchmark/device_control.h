@@ -0,0 +1,55 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_DEVICE_CONTROL_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_DEVICE_CONTROL_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+// Control of the CPUs and temperature of the device running a benchmark, so
+// that mobile benchmarks are not skewed by the scheduler moving threads across
+// cores of different speeds, or by thermal throttling. These read the Linux
+// sysfs, and do nothing on other platforms.
+
+namespace tensorflow {
+namespace benchmark_model {
+
+// Restricts the calling thread, and the threads it creates afterwards, to the
+// CPUs given by 'spec': a comma-separated list of CPU numbers, or "big" or
+// "little" for the CPUs with the highest or lowest maximum frequency of a
+// big.LITTLE device. Returns the CPUs in 'cpus'.
+Status SetCpuAffinity(const string& spec, std::vector<int>* cpus);
+
+// Returns the current frequency in kHz of each of 'cpus', or 0 for those
+// unknown.
+std::vector<int64> GetCpuFrequenciesKHz(const std::vector<int>& cpus);
+
+// Returns the highest temperature of the thermal zones of the device, in
+// millidegrees Celsius, or -1 if unknown.
+int64 GetMaxTemperatureMilliCelsius();
+
+// Sleeps until the temperature of the device is at most
+// 'max_temperature_millicelsius', for up to 'timeout_seconds'.
+Status WaitForTemperature(int64 max_temperature_millicelsius,
+                          double timeout_seconds);
+
+}  // namespace benchmark_model
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_DEVICE_CONTROL_H_
@@ -0,0 +1,201 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/run_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace benchmark_model {
+
+namespace {
+
+string JoinTimes(const std::vector<double>& times_us) {
+  return str_util::Join(times_us, ",", [](string* out, double time) {
+    strings::StrAppend(out, time);
+  });
+}
+
+Status ParseTimes(const string& text, std::vector<double>* times_us) {
+  for (const string& value :
+       str_util::Split(text, ',', str_util::SkipEmpty())) {
+    double time;
+    if (!strings::safe_strtod(value.c_str(), &time)) {
+      return errors::InvalidArgument("Invalid time '", value, "'");
+    }
+    times_us->push_back(time);
+  }
+  return Status::OK();
+}
+
+// Compares the times of a node, or of the whole run, with Welch's t-test on
+// the robust means and standard deviations of the times.
+TimeComparison CompareTimes(const string& name, const string& type,
+                            const std::vector<double>& base_us,
+                            const std::vector<double>& test_us,
+                            double min_t_value) {
+  const grappler::RobustStats base(base_us);
+  const grappler::RobustStats test(test_us);
+  TimeComparison comparison;
+  comparison.name = name;
+  comparison.type = type;
+  comparison.base_us = base.mean();
+  comparison.test_us = test.mean();
+  const double difference = test.mean() - base.mean();
+  const double standard_error =
+      std::sqrt(base.stddev() * base.stddev() / base_us.size() +
+                test.stddev() * test.stddev() / test_us.size());
+  if (standard_error > 0.0) {
+    comparison.t_value = difference / standard_error;
+  } else if (difference == 0.0) {
+    comparison.t_value = 0.0;
+  } else {
+    // The times of both runs are constant but differ.
+    comparison.t_value = std::copysign(
+        std::numeric_limits<double>::infinity(), difference);
+  }
+  comparison.significant = std::abs(comparison.t_value) >= min_t_value;
+  return comparison;
+}
+
+}  // namespace
+
+RunStats::RunStats(const GraphDef& graph_def) {
+  for (const NodeDef& node : graph_def.node()) {
+    node_types_[node.name()] = node.op();
+  }
+}
+
+void RunStats::AddRunTime(int64 time_us) { run_times_us_.push_back(time_us); }
+
+void RunStats::ProcessStepStats(const StepStats& step_stats) {
+  std::map<string, int64> run_node_times_us;
+  for (const auto& ds : step_stats.dev_stats()) {
+    for (const auto& ns : ds.node_stats()) {
+      run_node_times_us[ns.node_name()] += ns.all_end_rel_micros();
+    }
+  }
+  for (const auto& node_time : run_node_times_us) {
+    NodeTimes* times = &node_times_[node_time.first];
+    if (times->type.empty()) {
+      auto it = node_types_.find(node_time.first);
+      times->type = it == node_types_.end() ? "-" : it->second;
+    }
+    times->times_us.push_back(node_time.second);
+  }
+}
+
+Status RunStats::WriteToFile(Env* env, const string& filename) const {
+  string contents = strings::StrCat("total\t-\t-\t", JoinTimes(run_times_us_),
+                                    "\n");
+  for (const auto& node : node_times_) {
+    strings::StrAppend(&contents, "node\t", node.first, "\t", node.second.type,
+                       "\t", JoinTimes(node.second.times_us), "\n");
+  }
+  return WriteStringToFile(env, filename, contents);
+}
+
+Status RunStats::ReadFromFile(Env* env, const string& filename,
+                              RunStats* stats) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+  *stats = RunStats();
+  for (const string& line :
+       str_util::Split(contents, '\n', str_util::SkipEmpty())) {
+    const std::vector<string> fields = str_util::Split(line, '\t');
+    if (fields.size() != 4) {
+      return errors::InvalidArgument("Invalid line in ", filename, ": '", line,
+                                     "'");
+    }
+    if (fields[0] == "total") {
+      TF_RETURN_IF_ERROR(ParseTimes(fields[3], &stats->run_times_us_));
+    } else if (fields[0] == "node") {
+      NodeTimes* times = &stats->node_times_[fields[1]];
+      times->type = fields[2];
+      TF_RETURN_IF_ERROR(ParseTimes(fields[3], &times->times_us));
+    } else {
+      return errors::InvalidArgument("Invalid line in ", filename, ": '", line,
+                                     "'");
+    }
+  }
+  return Status::OK();
+}
+
+std::vector<TimeComparison> CompareRunStats(const RunStats& base,
+                                            const RunStats& test,
+                                            double min_t_value) {
+  std::vector<TimeComparison> comparisons;
+  if (!base.run_times_us().empty() && !test.run_times_us().empty()) {
+    comparisons.push_back(CompareTimes("", "", base.run_times_us(),
+                                       test.run_times_us(), min_t_value));
+  }
+  const size_t first_node = comparisons.size();
+  for (const auto& base_node : base.node_times()) {
+    auto test_node = test.node_times().find(base_node.first);
+    if (test_node == test.node_times().end() ||
+        base_node.second.times_us.empty() ||
+        test_node->second.times_us.empty()) {
+      continue;
+    }
+    comparisons.push_back(CompareTimes(
+        base_node.first, base_node.second.type, base_node.second.times_us,
+        test_node->second.times_us, min_t_value));
+  }
+  std::stable_sort(comparisons.begin() + first_node, comparisons.end(),
+                   [](const TimeComparison& a, const TimeComparison& b) {
+                     return std::abs(a.test_us - a.base_us) >
+                            std::abs(b.test_us - b.base_us);
+                   });
+  return comparisons;
+}
+
+string FormatComparisons(const std::vector<TimeComparison>& comparisons,
+                         int limit) {
+  std::stringstream stream;
+  stream << std::setw(12) << "[base us]" << std::setw(12) << "[test us]"
+         << std::setw(10) << "[change]" << std::setw(10) << "[t]"
+         << "  [significant]  [type]  [name]" << std::endl;
+  int num_nodes = 0;
+  for (const TimeComparison& comparison : comparisons) {
+    if (!comparison.name.empty() && limit > 0 && ++num_nodes > limit) {
+      break;
+    }
+    const double change =
+        comparison.base_us > 0.0
+            ? (comparison.test_us - comparison.base_us) / comparison.base_us
+            : 0.0;
+    stream << std::fixed << std::setprecision(1) << std::setw(12)
+           << comparison.base_us << std::setw(12) << comparison.test_us
+           << std::setw(9) << change * 100.0 << "%" << std::setw(10)
+           << std::setprecision(2) << comparison.t_value << "  "
+           << std::setw(13) << (comparison.significant ? "yes" : "no") << "  "
+           << (comparison.name.empty() ? "total" : comparison.type) << "  "
+           << comparison.name << std::endl;
+  }
+  return stream.str();
+}
+
+}  // namespace benchmark_model
+}  // namespace tensorflow
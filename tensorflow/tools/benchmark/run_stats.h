@@ -0,0 +1,100 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TOOLS_BENCHMARK_RUN_STATS_H_
+#define TENSORFLOW_TOOLS_BENCHMARK_RUN_STATS_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace benchmark_model {
+
+// The time of each run of a model and of each of its nodes, kept to compare
+// benchmarks of different builds or devices.
+//
+// The stats are written as lines of tab-separated values:
+//   total \t - \t - \t <comma-separated microseconds of each run>
+//   node \t <node name> \t <op type> \t <comma-separated microseconds>
+class RunStats {
+ public:
+  RunStats() {}
+  // The op types of the nodes are looked up in 'graph_def'.
+  explicit RunStats(const GraphDef& graph_def);
+
+  // Adds the total time of a run.
+  void AddRunTime(int64 time_us);
+  // Adds the time of each node of a run, the sum of its executions if it's
+  // executed several times.
+  void ProcessStepStats(const StepStats& step_stats);
+
+  struct NodeTimes {
+    string type;
+    std::vector<double> times_us;
+  };
+
+  const std::vector<double>& run_times_us() const { return run_times_us_; }
+  const std::map<string, NodeTimes>& node_times() const { return node_times_; }
+
+  Status WriteToFile(Env* env, const string& filename) const;
+  static Status ReadFromFile(Env* env, const string& filename,
+                             RunStats* stats);
+
+ private:
+  std::map<string, string> node_types_;
+  std::vector<double> run_times_us_;
+  std::map<string, NodeTimes> node_times_;
+};
+
+// The change of the time of a node, or of the whole run if 'name' is empty,
+// between two benchmarks.
+struct TimeComparison {
+  string name;
+  string type;
+  // Huber robust means of the times, in microseconds.
+  double base_us;
+  double test_us;
+  // The difference of the means in units of its estimated standard error.
+  double t_value;
+  // Whether |t_value| is at least the significance threshold.
+  bool significant;
+};
+
+// Compares the run and node times of 'test' to those of 'base', using robust
+// estimates of the means and standard deviations of each so that outlier runs
+// don't hide or fake a change. A change is significant if the difference of
+// the means is at least 'min_t_value' standard errors. The comparisons of the
+// nodes present in both are sorted by decreasing absolute change of time,
+// after the comparison of the total time.
+std::vector<TimeComparison> CompareRunStats(const RunStats& base,
+                                            const RunStats& test,
+                                            double min_t_value);
+
+// Formats the comparisons as a table, showing the 'limit' largest changes of
+// the nodes if 'limit' is positive.
+string FormatComparisons(const std::vector<TimeComparison>& comparisons,
+                         int limit);
+
+}  // namespace benchmark_model
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TOOLS_BENCHMARK_RUN_STATS_H_
@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/benchmark/run_stats.h"
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace benchmark_model {
+namespace {
+
+StepStats MakeStepStats(const std::vector<std::pair<string, int64>>& times) {
+  StepStats step_stats;
+  DeviceStepStats* device_stats = step_stats.add_dev_stats();
+  for (const auto& time : times) {
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_node_name(time.first);
+    node_stats->set_all_end_rel_micros(time.second);
+  }
+  return step_stats;
+}
+
+// Returns stats of 'num_runs' runs of 'total_us' and of a MatMul node of
+// 'matmul_us', with small deterministic noise and an outlier run.
+RunStats MakeRunStats(int num_runs, double total_us, double matmul_us) {
+  GraphDef graph_def;
+  NodeDef* node = graph_def.add_node();
+  node->set_name("matmul");
+  node->set_op("MatMul");
+  RunStats stats(graph_def);
+  for (int i = 0; i < num_runs; ++i) {
+    const int64 noise = (i % 5) - 2 + (i == 0 ? 1000 : 0);
+    stats.AddRunTime(total_us + noise);
+    stats.ProcessStepStats(MakeStepStats(
+        {{"matmul", matmul_us + noise}, {"relu", 10 + (i % 3)}}));
+  }
+  return stats;
+}
+
+TEST(RunStatsTest, ProcessStepStatsSumsExecutions) {
+  RunStats stats;
+  stats.ProcessStepStats(MakeStepStats({{"a", 3}, {"b", 4}, {"a", 5}}));
+  ASSERT_EQ(2, stats.node_times().size());
+  EXPECT_EQ(std::vector<double>({8}), stats.node_times().at("a").times_us);
+  EXPECT_EQ("-", stats.node_times().at("a").type);
+  EXPECT_EQ(std::vector<double>({4}), stats.node_times().at("b").times_us);
+}
+
+TEST(RunStatsTest, WriteAndRead) {
+  const RunStats stats = MakeRunStats(10, 500, 100);
+  const string filename = io::JoinPath(testing::TmpDir(), "run_stats.tsv");
+  TF_ASSERT_OK(stats.WriteToFile(Env::Default(), filename));
+  RunStats read_stats;
+  TF_ASSERT_OK(RunStats::ReadFromFile(Env::Default(), filename, &read_stats));
+  EXPECT_EQ(stats.run_times_us(), read_stats.run_times_us());
+  ASSERT_EQ(2, read_stats.node_times().size());
+  EXPECT_EQ("MatMul", read_stats.node_times().at("matmul").type);
+  EXPECT_EQ(stats.node_times().at("matmul").times_us,
+            read_stats.node_times().at("matmul").times_us);
+  EXPECT_EQ(stats.node_times().at("relu").times_us,
+            read_stats.node_times().at("relu").times_us);
+}
+
+TEST(RunStatsTest, ReadInvalidFile) {
+  const string filename = io::JoinPath(testing::TmpDir(), "invalid.tsv");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "total\t1,2\n"));
+  RunStats stats;
+  EXPECT_FALSE(RunStats::ReadFromFile(Env::Default(), filename, &stats).ok());
+}
+
+TEST(RunStatsTest, CompareSignificantChange) {
+  const RunStats base = MakeRunStats(20, 500, 100);
+  const RunStats test = MakeRunStats(20, 450, 50);
+  const std::vector<TimeComparison> comparisons =
+      CompareRunStats(base, test, 3.0);
+  ASSERT_EQ(3, comparisons.size());
+
+  // The outlier runs don't move the robust means.
+  EXPECT_EQ("", comparisons[0].name);
+  EXPECT_NEAR(500, comparisons[0].base_us, 2);
+  EXPECT_NEAR(450, comparisons[0].test_us, 2);
+  EXPECT_LT(comparisons[0].t_value, -3.0);
+  EXPECT_TRUE(comparisons[0].significant);
+
+  EXPECT_EQ("matmul", comparisons[1].name);
+  EXPECT_EQ("MatMul", comparisons[1].type);
+  EXPECT_TRUE(comparisons[1].significant);
+
+  EXPECT_EQ("relu", comparisons[2].name);
+  EXPECT_EQ(0.0, comparisons[2].t_value);
+  EXPECT_FALSE(comparisons[2].significant);
+
+  EXPECT_FALSE(FormatComparisons(comparisons, 0).empty());
+}
+
+TEST(RunStatsTest, CompareNoise) {
+  const RunStats base = MakeRunStats(20, 500, 100);
+  RunStats test;
+  for (int i = 0; i < 20; ++i) {
+    test.AddRunTime(500 + ((i + 2) % 5) - 2);
+  }
+  const std::vector<TimeComparison> comparisons =
+      CompareRunStats(base, test, 3.0);
+  ASSERT_EQ(1, comparisons.size());
+  EXPECT_FALSE(comparisons[0].significant);
+}
+
+}  // namespace
+}  // namespace benchmark_model
+}  // namespace tensorflow
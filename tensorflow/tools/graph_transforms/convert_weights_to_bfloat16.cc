@@ -0,0 +1,121 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Returns true if 'node' is not assigned to a device other than the CPU.
+bool RunsOnCpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  return !DeviceNameUtils::ParseFullName(node.device(), &parsed) ||
+         !parsed.has_type || str_util::Uppercase(parsed.type) == "CPU";
+}
+
+}  // namespace
+
+// Replaces the float MatMul ops whose weights are a large Const by SparseMatMul
+// ops with bfloat16 weights, which the CPU kernel reads at half the size and
+// multiplies with float accumulation. Weights used by other ops, and MatMul ops
+// assigned to other devices, are left alone.
+Status ConvertWeightsToBFloat16(const GraphDef& input_graph_def,
+                                const TransformFuncContext& context,
+                                GraphDef* output_graph_def) {
+  int32 minimum_size;
+  TF_RETURN_IF_ERROR(
+      context.GetOneInt32Parameter("minimum_size", 1024, &minimum_size));
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"MatMul",             // matmul_node
+        {
+          {"*"},             // input_node
+          {"Const"},         // weights_node
+        }
+      },  // clang-format on
+      [minimum_size](const NodeMatch& match,
+                     const std::set<string>& input_nodes,
+                     const std::set<string>& output_nodes,
+                     std::vector<NodeDef>* new_nodes) {
+        const NodeDef& matmul_node = match.node;
+        const NodeDef& input_node = match.inputs[0].node;
+        const NodeDef& weights_node = match.inputs[1].node;
+
+        Tensor weights = GetNodeTensorAttr(weights_node, "value");
+        // Small weights tend to be used for more accuracy-sensitive
+        // calculations, and the benefit of shrinking them is very marginal.
+        if (!RunsOnCpu(matmul_node) ||
+            matmul_node.attr().at("T").type() != DT_FLOAT ||
+            weights.dtype() != DT_FLOAT ||
+            weights.NumElements() < minimum_size ||
+            output_nodes.count(weights_node.name())) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+
+        Tensor bfloat16_weights(DT_BFLOAT16, weights.shape());
+        FloatToBFloat16(weights.flat<float>().data(),
+                        bfloat16_weights.flat<bfloat16>().data(),
+                        weights.NumElements());
+        NodeDef bfloat16_weights_node;
+        bfloat16_weights_node.set_op("Const");
+        bfloat16_weights_node.set_name(
+            strings::StrCat(weights_node.name(), "_bfloat16"));
+        bfloat16_weights_node.set_device(weights_node.device());
+        SetNodeAttr("dtype", DT_BFLOAT16, &bfloat16_weights_node);
+        SetNodeTensorAttr<bfloat16>("value", bfloat16_weights,
+                                    &bfloat16_weights_node);
+        new_nodes->push_back(bfloat16_weights_node);
+
+        new_nodes->push_back(input_node);
+
+        NodeDef sparse_matmul_node;
+        sparse_matmul_node.set_op("SparseMatMul");
+        sparse_matmul_node.set_name(matmul_node.name());
+        sparse_matmul_node.set_device(matmul_node.device());
+        AddNodeInput(matmul_node.input(0), &sparse_matmul_node);
+        AddNodeInput(bfloat16_weights_node.name(), &sparse_matmul_node);
+        for (int i = 2; i < matmul_node.input_size(); ++i) {
+          AddNodeInput(matmul_node.input(i), &sparse_matmul_node);
+        }
+        CopyNodeAttr(matmul_node, "transpose_a", "transpose_a",
+                     &sparse_matmul_node);
+        CopyNodeAttr(matmul_node, "transpose_b", "transpose_b",
+                     &sparse_matmul_node);
+        SetNodeAttr("a_is_sparse", false, &sparse_matmul_node);
+        SetNodeAttr("b_is_sparse", false, &sparse_matmul_node);
+        SetNodeAttr("Ta", DT_FLOAT, &sparse_matmul_node);
+        SetNodeAttr("Tb", DT_BFLOAT16, &sparse_matmul_node);
+        new_nodes->push_back(sparse_matmul_node);
+
+        return Status::OK();
+      },
+      {}, output_graph_def));
+
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("convert_weights_to_bfloat16",
+                         ConvertWeightsToBFloat16);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status ConvertWeightsToBFloat16(const GraphDef& input_graph_def,
+                                const TransformFuncContext& context,
+                                GraphDef* output_graph_def);
+
+class ConvertWeightsToBFloat16Test : public ::testing::Test {
+ protected:
+  void TestConvertWeightsToBFloat16(bool transpose_b) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({3, 40}));
+    test::FillFn<float>(&input_data, [](int i) { return (i % 7) - 3.0f; });
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    // The weights are exactly representable in bfloat16.
+    Tensor weights_data(DT_FLOAT, TensorShape({40, 40}));
+    test::FillFn<float>(&weights_data,
+                        [](int i) { return ((i % 11) - 5) * 0.25f; });
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output matmul_op = MatMul(root.WithOpName("output"), input_op, weights_op,
+                              MatMul::TransposeB(transpose_b));
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    GraphDef converted_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    context.params["minimum_size"] = {"100"};
+    TF_ASSERT_OK(ConvertWeightsToBFloat16(original_graph_def, context,
+                                          &converted_graph_def));
+
+    std::unique_ptr<Session> converted_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(converted_session->Create(converted_graph_def));
+    std::vector<Tensor> converted_outputs;
+    TF_ASSERT_OK(
+        converted_session->Run({}, {"output"}, {}, &converted_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], converted_outputs[0],
+                                  1e-5);
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(converted_graph_def, &node_lookup);
+    EXPECT_EQ(0, node_lookup.count("weights_op"));
+    ASSERT_EQ(1, node_lookup.count("weights_op_bfloat16"));
+    EXPECT_EQ(DT_BFLOAT16,
+              node_lookup.at("weights_op_bfloat16")->attr().at("dtype").type());
+    const NodeDef* output_node = node_lookup.at("output");
+    EXPECT_EQ("SparseMatMul", output_node->op());
+    EXPECT_EQ("weights_op_bfloat16", output_node->input(1));
+    EXPECT_EQ(transpose_b, output_node->attr().at("transpose_b").b());
+    EXPECT_EQ(DT_BFLOAT16, output_node->attr().at("Tb").type());
+  }
+
+  void TestKeepSharedAndSmallWeights() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({2, 40}));
+    test::FillIota<float>(&input_data, 1.0f);
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    Tensor weights_data(DT_FLOAT, TensorShape({40, 40}));
+    test::FillIota<float>(&weights_data, 1.0f);
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output matmul_op =
+        MatMul(root.WithOpName("matmul_op"), input_op, weights_op);
+    Output shared_op = Identity(root.WithOpName("shared_op"), weights_op);
+
+    Tensor small_weights_data(DT_FLOAT, TensorShape({40, 2}));
+    test::FillIota<float>(&small_weights_data, 1.0f);
+    Output small_weights_op = Const(root.WithOpName("small_weights_op"),
+                                    Input::Initializer(small_weights_data));
+    Output small_matmul_op =
+        MatMul(root.WithOpName("small_matmul_op"), input_op, small_weights_op);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    GraphDef converted_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"matmul_op", "shared_op", "small_matmul_op"};
+    context.params["minimum_size"] = {"100"};
+    TF_ASSERT_OK(ConvertWeightsToBFloat16(original_graph_def, context,
+                                          &converted_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(converted_graph_def, &node_lookup);
+    EXPECT_EQ("MatMul", node_lookup.at("matmul_op")->op());
+    EXPECT_EQ("MatMul", node_lookup.at("small_matmul_op")->op());
+    EXPECT_EQ(DT_FLOAT,
+              node_lookup.at("weights_op")->attr().at("dtype").type());
+    EXPECT_EQ(0, node_lookup.count("weights_op_bfloat16"));
+    EXPECT_EQ(0, node_lookup.count("small_weights_op_bfloat16"));
+  }
+};
+
+TEST_F(ConvertWeightsToBFloat16Test, TestConvertWeightsToBFloat16) {
+  TestConvertWeightsToBFloat16(false);
+}
+
+TEST_F(ConvertWeightsToBFloat16Test, TestConvertTransposedWeightsToBFloat16) {
+  TestConvertWeightsToBFloat16(true);
+}
+
+TEST_F(ConvertWeightsToBFloat16Test, TestKeepSharedAndSmallWeights) {
+  TestKeepSharedAndSmallWeights();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
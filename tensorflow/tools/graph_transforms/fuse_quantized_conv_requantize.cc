@@ -0,0 +1,318 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+const char kFusedOp[] = "_QuantizedConv2DAndRequantize";
+
+// Returns true if the 'attr_name' attribute of 'node' is 'expected'.
+bool HasTypeAttr(const NodeDef& node, const string& attr_name,
+                 DataType expected) {
+  DataType type;
+  return GetNodeAttr(node, attr_name, &type).ok() && type == expected;
+}
+
+// Returns true if the three inputs of 'node' starting at 'first_input' are the
+// quantized output, the min and the max of 'producer'.
+bool ReadsQuantizedOutputs(const NodeDef& node, int first_input,
+                           const NodeDef& producer) {
+  if (node.input_size() < first_input + 3) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (CanonicalInputName(node.input(first_input + i)) !=
+        CanonicalInputName(strings::StrCat(producer.name(), ":", i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if 'conv_node' is a QuantizedConv2D with a kernel for the fused
+// op, whose 32-bit results go to 'requantize_node' only through its three
+// outputs.
+bool IsFusableConv(const NodeDef& conv_node, const NodeDef& requantize_node) {
+  return HasTypeAttr(conv_node, "Tinput", DT_QUINT8) &&
+         HasTypeAttr(conv_node, "Tfilter", DT_QUINT8) &&
+         HasTypeAttr(conv_node, "out_type", DT_QINT32) &&
+         ReadsQuantizedOutputs(requantize_node, 0, conv_node);
+}
+
+// Adds the Const nodes of the match other than its root that are used outside
+// of it to 'new_nodes', except those in 'kept_nodes' which the caller adds
+// itself. Returns false if another kind of node is used outside of the match,
+// since it can't be removed.
+bool KeepSharedConsts(const NodeMatch& match,
+                      const std::set<string>& output_nodes,
+                      const std::set<string>& kept_nodes,
+                      std::vector<NodeDef>* new_nodes) {
+  std::vector<NodeDef> matched_nodes;
+  MatchedNodesAsArray(match, &matched_nodes);
+  std::vector<NodeDef> shared_consts;
+  std::set<string> added_nodes = kept_nodes;
+  for (const NodeDef& node : matched_nodes) {
+    // The same Const can be matched by several inputs.
+    if (node.name() == match.node.name() || !output_nodes.count(node.name()) ||
+        !added_nodes.insert(node.name()).second) {
+      continue;
+    }
+    if (node.op() != "Const") {
+      return false;
+    }
+    shared_consts.push_back(node);
+  }
+  new_nodes->insert(new_nodes->end(), shared_consts.begin(),
+                    shared_consts.end());
+  return true;
+}
+
+// Returns a float Const node named 'name' holding 'bias'.
+NodeDef BiasNode(const string& name, const string& device, const Tensor& bias) {
+  NodeDef bias_node;
+  bias_node.set_op("Const");
+  bias_node.set_name(name);
+  bias_node.set_device(device);
+  SetNodeAttr("dtype", DT_FLOAT, &bias_node);
+  SetNodeTensorAttr<float>("value", bias, &bias_node);
+  return bias_node;
+}
+
+// Returns the fused node named 'name' computing 'conv_node' plus 'bias_name'
+// requantized into the range of the frozen Const inputs of 'requantize_node'.
+NodeDef FusedNode(const string& name, const NodeDef& conv_node,
+                  const string& bias_name, const NodeDef& requantize_node) {
+  NodeDef fused_node;
+  fused_node.set_op(kFusedOp);
+  fused_node.set_name(name);
+  fused_node.set_device(conv_node.device());
+  AddNodeInput(conv_node.input(0), &fused_node);
+  AddNodeInput(conv_node.input(1), &fused_node);
+  AddNodeInput(bias_name, &fused_node);
+  for (int i = 2; i < 6; ++i) {
+    AddNodeInput(conv_node.input(i), &fused_node);
+  }
+  AddNodeInput(requantize_node.input(3), &fused_node);
+  AddNodeInput(requantize_node.input(4), &fused_node);
+  CopyNodeAttr(conv_node, "Tinput", "Tinput", &fused_node);
+  CopyNodeAttr(conv_node, "Tfilter", "Tfilter", &fused_node);
+  CopyNodeAttr(conv_node, "strides", "strides", &fused_node);
+  CopyNodeAttr(conv_node, "padding", "padding", &fused_node);
+  SetNodeAttr("out_type", DT_QUINT8, &fused_node);
+  SetNodeAttr("fuse_relu", false, &fused_node);
+  return fused_node;
+}
+
+}  // namespace
+
+// Replaces the QuantizedConv2D ops followed by an optional QuantizedBiasAdd
+// and a Requantize into a frozen range by a single
+// _QuantizedConv2DAndRequantize op, which converts the 32-bit results of the
+// convolution to eight bits as they're produced. A QuantizedRelu after it is
+// merged into the fused op too. The frozen ranges come from the
+// freeze_requantization_ranges transform, and the bias of QuantizedBiasAdd
+// has to be a Const, as left by fold_constants.
+Status FuseQuantizedConvRequantize(const GraphDef& input_graph_def,
+                                   const TransformFuncContext& context,
+                                   GraphDef* output_graph_def) {
+  // The bias is added to the 32-bit results of the convolution, rather than
+  // to their requantized values as QuantizedBiasAdd does.
+  GraphDef bias_fused_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"Requantize",                  // requantize_node
+        {
+          {"QuantizedBiasAdd",        // bias_add_node
+            {
+              {"Requantize",          // conv_requantize_node
+                {
+                  {"QuantizedConv2D"},  // conv_node
+                  {"QuantizedConv2D"},
+                  {"QuantizedConv2D"},
+                  {"Const"},
+                  {"Const"},
+                }
+              },
+              {"Const"},              // bias_node
+              {"Requantize"},
+              {"Requantize"},
+              {"Const"},              // bias_min_node
+              {"Const"},              // bias_max_node
+            }
+          },
+          {"QuantizedBiasAdd"},
+          {"QuantizedBiasAdd"},
+          {"Const"},                  // frozen_min_node
+          {"Const"},                  // frozen_max_node
+        }
+      },  // clang-format on
+      [](const NodeMatch& match, const std::set<string>& input_nodes,
+         const std::set<string>& output_nodes,
+         std::vector<NodeDef>* new_nodes) {
+        const NodeDef& requantize_node = match.node;
+        const NodeDef& bias_add_node = match.inputs[0].node;
+        const NodeDef& conv_requantize_node = match.inputs[0].inputs[0].node;
+        const NodeDef& conv_node = match.inputs[0].inputs[0].inputs[0].node;
+        const NodeDef& bias_node = match.inputs[0].inputs[1].node;
+        const NodeDef& bias_min_node = match.inputs[0].inputs[4].node;
+        const NodeDef& bias_max_node = match.inputs[0].inputs[5].node;
+        const NodeDef& frozen_min_node = match.inputs[3].node;
+        const NodeDef& frozen_max_node = match.inputs[4].node;
+
+        const Tensor bias = GetNodeTensorAttr(bias_node, "value");
+        const Tensor bias_min = GetNodeTensorAttr(bias_min_node, "value");
+        const Tensor bias_max = GetNodeTensorAttr(bias_max_node, "value");
+        const std::set<string> kept_nodes = {frozen_min_node.name(),
+                                             frozen_max_node.name()};
+        std::vector<NodeDef> shared_nodes;
+        if (!IsFusableConv(conv_node, conv_requantize_node) ||
+            !HasTypeAttr(requantize_node, "out_type", DT_QUINT8) ||
+            !ReadsQuantizedOutputs(bias_add_node, 0, conv_requantize_node) ||
+            !ReadsQuantizedOutputs(requantize_node, 0, bias_add_node) ||
+            bias.dtype() != DT_QUINT8 || bias.dims() != 1 ||
+            bias_min.dtype() != DT_FLOAT || bias_min.NumElements() != 1 ||
+            bias_max.dtype() != DT_FLOAT || bias_max.NumElements() != 1 ||
+            !KeepSharedConsts(match, output_nodes, kept_nodes,
+                              &shared_nodes)) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+
+        const Tensor float_bias = QuantizedTensorToFloat<quint8>(
+            bias, bias_min.flat<float>()(0), bias_max.flat<float>()(0));
+        const NodeDef float_bias_node =
+            BiasNode(strings::StrCat(requantize_node.name(), "/bias"),
+                     bias_node.device(), float_bias);
+        new_nodes->push_back(float_bias_node);
+        new_nodes->insert(new_nodes->end(), shared_nodes.begin(),
+                          shared_nodes.end());
+        new_nodes->push_back(frozen_min_node);
+        new_nodes->push_back(frozen_max_node);
+        new_nodes->push_back(FusedNode(requantize_node.name(), conv_node,
+                                       float_bias_node.name(),
+                                       requantize_node));
+        return Status::OK();
+      },
+      {}, &bias_fused_graph_def));
+
+  // A convolution without a bias gets a zero bias, which needs the depth of
+  // its filter.
+  std::map<string, const NodeDef*> node_map;
+  MapNamesToNodes(bias_fused_graph_def, &node_map);
+  GraphDef conv_fused_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      bias_fused_graph_def,  // clang-format off
+      {"Requantize",              // requantize_node
+        {
+          {"QuantizedConv2D"},    // conv_node
+          {"QuantizedConv2D"},
+          {"QuantizedConv2D"},
+          {"Const"},              // frozen_min_node
+          {"Const"},              // frozen_max_node
+        }
+      },  // clang-format on
+      [&node_map](const NodeMatch& match, const std::set<string>& input_nodes,
+                  const std::set<string>& output_nodes,
+                  std::vector<NodeDef>* new_nodes) {
+        const NodeDef& requantize_node = match.node;
+        const NodeDef& conv_node = match.inputs[0].node;
+        const NodeDef& frozen_min_node = match.inputs[3].node;
+        const NodeDef& frozen_max_node = match.inputs[4].node;
+
+        const NodeDef* filter_node = nullptr;
+        if (conv_node.input_size() > 1 &&
+            node_map.count(NodeNameFromInput(conv_node.input(1)))) {
+          filter_node = node_map.at(NodeNameFromInput(conv_node.input(1)));
+        }
+        Tensor filter;
+        if (filter_node != nullptr && filter_node->op() == "Const") {
+          filter = GetNodeTensorAttr(*filter_node, "value");
+        }
+        const std::set<string> kept_nodes = {frozen_min_node.name(),
+                                             frozen_max_node.name()};
+        std::vector<NodeDef> shared_nodes;
+        if (filter.dims() != 4 || !IsFusableConv(conv_node, requantize_node) ||
+            !HasTypeAttr(requantize_node, "out_type", DT_QUINT8) ||
+            !KeepSharedConsts(match, output_nodes, kept_nodes,
+                              &shared_nodes)) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+
+        Tensor zero_bias(DT_FLOAT, TensorShape({filter.dim_size(3)}));
+        zero_bias.flat<float>().setZero();
+        const NodeDef zero_bias_node =
+            BiasNode(strings::StrCat(requantize_node.name(), "/bias"),
+                     conv_node.device(), zero_bias);
+        new_nodes->push_back(zero_bias_node);
+        new_nodes->insert(new_nodes->end(), shared_nodes.begin(),
+                          shared_nodes.end());
+        new_nodes->push_back(frozen_min_node);
+        new_nodes->push_back(frozen_max_node);
+        new_nodes->push_back(FusedNode(requantize_node.name(), conv_node,
+                                       zero_bias_node.name(),
+                                       requantize_node));
+        return Status::OK();
+      },
+      {}, &conv_fused_graph_def));
+
+  // QuantizedRelu clamps its input to the quantized value of zero, which the
+  // fused op can do directly on its outputs.
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      conv_fused_graph_def,  // clang-format off
+      {"QuantizedRelu",
+        {
+          {kFusedOp},
+          {kFusedOp},
+          {kFusedOp},
+        }
+      },  // clang-format on
+      [](const NodeMatch& match, const std::set<string>& input_nodes,
+         const std::set<string>& output_nodes,
+         std::vector<NodeDef>* new_nodes) {
+        const NodeDef& relu_node = match.node;
+        const NodeDef& fused_node = match.inputs[0].node;
+        if (output_nodes.count(fused_node.name()) ||
+            !HasTypeAttr(relu_node, "out_type", DT_QUINT8) ||
+            !ReadsQuantizedOutputs(relu_node, 0, fused_node)) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+        NodeDef fused_relu_node = fused_node;
+        fused_relu_node.set_name(relu_node.name());
+        SetNodeAttr("fuse_relu", true, &fused_relu_node);
+        new_nodes->push_back(fused_relu_node);
+        return Status::OK();
+      },
+      {}, output_graph_def));
+
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("fuse_quantized_conv_requantize",
+                         FuseQuantizedConvRequantize);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
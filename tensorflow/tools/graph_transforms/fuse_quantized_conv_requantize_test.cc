@@ -0,0 +1,239 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status FuseQuantizedConvRequantize(const GraphDef& input_graph_def,
+                                   const TransformFuncContext& context,
+                                   GraphDef* output_graph_def);
+
+class FuseQuantizedConvRequantizeTest : public ::testing::Test {
+ protected:
+  // Returns a Const holding 'values' quantized into [min, max].
+  Output QuantizedConst(const Scope& root, const string& name,
+                        const TensorShape& shape,
+                        const std::vector<float>& values, float min,
+                        float max) {
+    Tensor float_tensor(DT_FLOAT, shape);
+    test::FillValues<float>(&float_tensor, values);
+    return ops::Const(
+        root.WithOpName(name),
+        Input::Initializer(FloatTensorToQuantized<quint8>(float_tensor, min,
+                                                          max)));
+  }
+
+  // Adds a QuantizedConv2D of a 3x4 image by two 3x3 filters, with its results
+  // requantized into the frozen range [0, 400].
+  ops::Requantize AddConvAndRequantize(const Scope& root) {
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    Output input = QuantizedConst(root, "input", {1, 3, 4, 1},
+                                  {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+                                  0.0f, 12.0f);
+    Output input_min = Const(root.WithOpName("input_min"), 0.0f);
+    Output input_max = Const(root.WithOpName("input_max"), 12.0f);
+    Output filter = QuantizedConst(
+        root, "filter", {3, 3, 1, 2},
+        {1, 9, 4, 6, 7, 3, 2, 8, 5, 5, 8, 2, 3, 7, 6, 4, 9, 1}, 0.0f, 9.0f);
+    Output filter_min = Const(root.WithOpName("filter_min"), 0.0f);
+    Output filter_max = Const(root.WithOpName("filter_max"), 9.0f);
+    QuantizedConv2D conv(root.WithOpName("conv"), input, filter, input_min,
+                         input_max, filter_min, filter_max, {1, 1, 1, 1},
+                         "SAME");
+    Output conv_frozen_min = Const(root.WithOpName("conv_frozen_min"), 0.0f);
+    Output conv_frozen_max = Const(root.WithOpName("conv_frozen_max"), 400.0f);
+    return Requantize(root.WithOpName("conv_requantize"), conv.output,
+                      conv.min_output, conv.max_output, conv_frozen_min,
+                      conv_frozen_max, DT_QUINT8);
+  }
+
+  // Adds a QuantizedBiasAdd after 'conv_requantize', with its results
+  // requantized into the frozen range [-100, 500].
+  ops::Requantize AddBiasAndRequantize(
+      const Scope& root, const ops::Requantize& conv_requantize) {
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    Output bias =
+        QuantizedConst(root, "bias", {2}, {-100.0f, 50.0f}, -128.0f, 127.0f);
+    Output bias_min = Const(root.WithOpName("bias_min"), -128.0f);
+    Output bias_max = Const(root.WithOpName("bias_max"), 127.0f);
+    QuantizedBiasAdd bias_add(root.WithOpName("bias_add"),
+                              conv_requantize.output, bias,
+                              conv_requantize.output_min,
+                              conv_requantize.output_max, bias_min, bias_max,
+                              DT_QINT32);
+    Output frozen_min = Const(root.WithOpName("frozen_min"), -100.0f);
+    Output frozen_max = Const(root.WithOpName("frozen_max"), 500.0f);
+    return Requantize(root.WithOpName("requantize"), bias_add.output,
+                      bias_add.min_out, bias_add.max_out, frozen_min,
+                      frozen_max, DT_QUINT8);
+  }
+
+  // Runs 'graph_def' and 'fused_graph_def', and checks that they have the same
+  // float outputs up to a few quantization steps.
+  void ExpectSameOutputs(const GraphDef& graph_def,
+                         const GraphDef& fused_graph_def,
+                         const std::vector<string>& output_names) {
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(
+        original_session->Run({}, output_names, {}, &original_outputs));
+
+    std::unique_ptr<Session> fused_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(fused_session->Create(fused_graph_def));
+    std::vector<Tensor> fused_outputs;
+    TF_ASSERT_OK(fused_session->Run({}, output_names, {}, &fused_outputs));
+
+    ASSERT_EQ(original_outputs.size(), fused_outputs.size());
+    for (int i = 0; i < original_outputs.size(); ++i) {
+      test::ExpectTensorNear<float>(original_outputs[i], fused_outputs[i],
+                                    5.0);
+    }
+  }
+
+  void TestFuseConvBiasAndRelu() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    Requantize requantize =
+        AddBiasAndRequantize(root, AddConvAndRequantize(root));
+    QuantizedRelu relu(root.WithOpName("relu"), requantize.output,
+                       requantize.output_min, requantize.output_max);
+    Output dequantize =
+        Dequantize(root.WithOpName("dequantize"), relu.activations,
+                   relu.min_activations, relu.max_activations);
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+    TransformFuncContext context;
+    context.output_names = {"dequantize"};
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(
+        FuseQuantizedConvRequantize(graph_def, context, &fused_graph_def));
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(fused_graph_def, &node_map);
+    for (const string& name :
+         {"conv", "conv_requantize", "bias_add", "requantize"}) {
+      EXPECT_EQ(0, node_map.count(name)) << name;
+    }
+    ASSERT_EQ(1, node_map.count("relu"));
+    const NodeDef* fused_node = node_map.at("relu");
+    EXPECT_EQ("_QuantizedConv2DAndRequantize", fused_node->op());
+    EXPECT_TRUE(fused_node->attr().at("fuse_relu").b());
+    ASSERT_EQ(9, fused_node->input_size());
+    EXPECT_EQ("input", fused_node->input(0));
+    EXPECT_EQ("filter", fused_node->input(1));
+    EXPECT_EQ("requantize/bias", fused_node->input(2));
+    EXPECT_EQ("frozen_min", fused_node->input(7));
+    EXPECT_EQ("frozen_max", fused_node->input(8));
+    Tensor bias = GetNodeTensorAttr(*node_map.at("requantize/bias"), "value");
+    EXPECT_EQ(DT_FLOAT, bias.dtype());
+    EXPECT_NEAR(-100.0f, bias.flat<float>()(0), 1.0f);
+    EXPECT_NEAR(50.0f, bias.flat<float>()(1), 1.0f);
+
+    ExpectSameOutputs(graph_def, fused_graph_def, {"dequantize"});
+  }
+
+  void TestFuseConvWithoutBias() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    Requantize conv_requantize = AddConvAndRequantize(root);
+    Output dequantize = Dequantize(
+        root.WithOpName("dequantize"), conv_requantize.output,
+        conv_requantize.output_min, conv_requantize.output_max);
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+    TransformFuncContext context;
+    context.output_names = {"dequantize"};
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(
+        FuseQuantizedConvRequantize(graph_def, context, &fused_graph_def));
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(fused_graph_def, &node_map);
+    EXPECT_EQ(0, node_map.count("conv"));
+    ASSERT_EQ(1, node_map.count("conv_requantize"));
+    const NodeDef* fused_node = node_map.at("conv_requantize");
+    EXPECT_EQ("_QuantizedConv2DAndRequantize", fused_node->op());
+    EXPECT_FALSE(fused_node->attr().at("fuse_relu").b());
+    ASSERT_EQ(1, node_map.count("conv_requantize/bias"));
+    test::ExpectTensorEqual<float>(
+        GetNodeTensorAttr(*node_map.at("conv_requantize/bias"), "value"),
+        test::AsTensor<float>({0.0f, 0.0f}));
+
+    ExpectSameOutputs(graph_def, fused_graph_def, {"dequantize"});
+  }
+
+  void TestSharedIntermediateResult() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+    Requantize conv_requantize = AddConvAndRequantize(root);
+    Requantize requantize = AddBiasAndRequantize(root, conv_requantize);
+    Output dequantize =
+        Dequantize(root.WithOpName("dequantize"), requantize.output,
+                   requantize.output_min, requantize.output_max);
+    Output conv_dequantize = Dequantize(
+        root.WithOpName("conv_dequantize"), conv_requantize.output,
+        conv_requantize.output_min, conv_requantize.output_max);
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+    TransformFuncContext context;
+    context.output_names = {"dequantize", "conv_dequantize"};
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(
+        FuseQuantizedConvRequantize(graph_def, context, &fused_graph_def));
+
+    // The 8-bit convolution results are used elsewhere, so only the
+    // convolution and its Requantize are fused.
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(fused_graph_def, &node_map);
+    EXPECT_EQ("_QuantizedConv2DAndRequantize",
+              node_map.at("conv_requantize")->op());
+    EXPECT_EQ("QuantizedBiasAdd", node_map.at("bias_add")->op());
+    EXPECT_EQ("Requantize", node_map.at("requantize")->op());
+
+    ExpectSameOutputs(graph_def, fused_graph_def,
+                      {"dequantize", "conv_dequantize"});
+  }
+};
+
+TEST_F(FuseQuantizedConvRequantizeTest, TestFuseConvBiasAndRelu) {
+  TestFuseConvBiasAndRelu();
+}
+
+TEST_F(FuseQuantizedConvRequantizeTest, TestFuseConvWithoutBias) {
+  TestFuseConvWithoutBias();
+}
+
+TEST_F(FuseQuantizedConvRequantizeTest, TestSharedIntermediateResult) {
+  TestSharedIntermediateResult();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,53 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Marks the float MatMul and Conv2D ops whose weights are a Const, so that
+// their CPU kernels pack the weights once in the layout of the matrix
+// multiplication kernels instead of on every step. The packed layout depends on
+// the instruction set of the device running the graph, so it's computed when
+// the kernel is created rather than stored in the graph.
+Status PrepackWeights(const GraphDef& input_graph_def,
+                      const TransformFuncContext& context,
+                      GraphDef* output_graph_def) {
+  std::map<string, const NodeDef*> node_map;
+  MapNamesToNodes(input_graph_def, &node_map);
+  const std::set<string> weighted_ops = {"MatMul", "_FusedMatMul", "Conv2D",
+                                         "_FusedConv2D"};
+  *output_graph_def = input_graph_def;
+  for (NodeDef& node : *output_graph_def->mutable_node()) {
+    if (!weighted_ops.count(node.op()) || node.input_size() < 2 ||
+        node.attr().at("T").type() != DT_FLOAT) {
+      continue;
+    }
+    const string weights_name = NodeNameFromInput(node.input(1));
+    if (!node_map.count(weights_name) ||
+        node_map.at(weights_name)->op() != "Const") {
+      continue;
+    }
+    SetNodeAttr("_prepack_weights", true, &node);
+  }
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("prepack_weights", PrepackWeights);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,167 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status PrepackWeights(const GraphDef& input_graph_def,
+                      const TransformFuncContext& context,
+                      GraphDef* output_graph_def);
+
+class PrepackWeightsTest : public ::testing::Test {
+ protected:
+  // Runs 'graph_def' feeding 'input_data' to "input_op", twice to also use the
+  // weights packed by the first run.
+  void RunGraph(const GraphDef& graph_def, const Tensor& input_data,
+                const std::vector<string>& output_names,
+                std::vector<Tensor>* outputs) {
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(session->Create(graph_def));
+    TF_ASSERT_OK(
+        session->Run({{"input_op", input_data}}, output_names, {}, outputs));
+    TF_ASSERT_OK(
+        session->Run({{"input_op", input_data}}, output_names, {}, outputs));
+  }
+
+  void TestPrepackMatMulWeights(bool transpose_b) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({70, 40}));
+    test::FillFn<float>(&input_data, [](int i) { return (i % 7) - 3.0f; });
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+
+    Tensor weights_data(DT_FLOAT, transpose_b ? TensorShape({30, 40})
+                                              : TensorShape({40, 30}));
+    test::FillFn<float>(&weights_data,
+                        [](int i) { return ((i % 11) - 5) * 0.25f; });
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output matmul_op = MatMul(root.WithOpName("output"), input_op, weights_op,
+                              MatMul::TransposeB(transpose_b));
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+    std::vector<Tensor> original_outputs;
+    RunGraph(original_graph_def, input_data, {"output"}, &original_outputs);
+
+    GraphDef prepacked_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    TF_ASSERT_OK(
+        PrepackWeights(original_graph_def, context, &prepacked_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(prepacked_graph_def, &node_lookup);
+    EXPECT_TRUE(node_lookup.at("output")->attr().at("_prepack_weights").b());
+
+    std::vector<Tensor> prepacked_outputs;
+    RunGraph(prepacked_graph_def, input_data, {"output"}, &prepacked_outputs);
+    test::ExpectTensorNear<float>(original_outputs[0], prepacked_outputs[0],
+                                  1e-4);
+  }
+
+  void TestPrepackConvFilter() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({1, 9, 10, 16}));
+    test::FillFn<float>(&input_data, [](int i) { return (i % 13) - 6.0f; });
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+
+    Tensor filter_data(DT_FLOAT, TensorShape({1, 1, 16, 24}));
+    test::FillFn<float>(&filter_data,
+                        [](int i) { return ((i % 5) - 2) * 0.5f; });
+    Output filter_op =
+        Const(root.WithOpName("filter_op"), Input::Initializer(filter_data));
+    Output conv_op = Conv2D(root.WithOpName("output"), input_op, filter_op,
+                            {1, 1, 1, 1}, "SAME");
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+    std::vector<Tensor> original_outputs;
+    RunGraph(original_graph_def, input_data, {"output"}, &original_outputs);
+
+    GraphDef prepacked_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    TF_ASSERT_OK(
+        PrepackWeights(original_graph_def, context, &prepacked_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(prepacked_graph_def, &node_lookup);
+    EXPECT_TRUE(node_lookup.at("output")->attr().at("_prepack_weights").b());
+
+    std::vector<Tensor> prepacked_outputs;
+    RunGraph(prepacked_graph_def, input_data, {"output"}, &prepacked_outputs);
+    test::ExpectTensorNear<float>(original_outputs[0], prepacked_outputs[0],
+                                  1e-4);
+  }
+
+  void TestKeepVariableWeights() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+    Tensor weights_data(DT_FLOAT, TensorShape({40, 30}));
+    test::FillIota<float>(&weights_data, 1.0f);
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+    Output identity_op = Identity(root.WithOpName("identity_op"), weights_op);
+    Output matmul_op =
+        MatMul(root.WithOpName("matmul_op"), input_op, identity_op);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    GraphDef prepacked_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"matmul_op"};
+    TF_ASSERT_OK(
+        PrepackWeights(original_graph_def, context, &prepacked_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(prepacked_graph_def, &node_lookup);
+    EXPECT_EQ(0, node_lookup.at("matmul_op")->attr().count("_prepack_weights"));
+  }
+};
+
+TEST_F(PrepackWeightsTest, TestPrepackMatMulWeights) {
+  TestPrepackMatMulWeights(false);
+}
+
+TEST_F(PrepackWeightsTest, TestPrepackTransposedMatMulWeights) {
+  TestPrepackMatMulWeights(true);
+}
+
+TEST_F(PrepackWeightsTest, TestPrepackConvFilter) { TestPrepackConvFilter(); }
+
+TEST_F(PrepackWeightsTest, TestKeepVariableWeights) {
+  TestKeepVariableWeights();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -185,6 +185,26 @@ bool AreAttrsEqual(const NodeDef* current_node, const NodeDef* other_node) {
   return true;
 }
 
+// Returns the dimension of the output channels of input 'input_index' of
+// 'float_node' if its weights can be quantized per channel, or -1.
+int PerChannelWeightsDim(const NodeDef& float_node, int input_index) {
+  if (input_index != 1) {
+    return -1;
+  }
+  if (float_node.op() == "Conv2D") {
+    // The filter is [filter_height, filter_width, in_depth, out_depth].
+    return 3;
+  }
+  if (float_node.op() == "MatMul") {
+    bool transpose_b = false;
+    if (!GetNodeAttr(float_node, "transpose_b", &transpose_b).ok()) {
+      return -1;
+    }
+    return transpose_b ? 0 : 1;
+  }
+  return -1;
+}
+
 }  // namespace
 
 // Analyzes all the nodes in the graph to figure out which ones are duplicates
@@ -691,12 +711,21 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
       context, "fallback_min", "fallback_max", &fallback_min, &fallback_max,
       &has_fallback_range));
 
+  // If per_channel_weights is set, the constant weights of Conv2D and MatMul
+  // get a range per output channel, rather than a single one.
+  bool per_channel_weights;
+  TF_RETURN_IF_ERROR(context.GetOneBoolParameter("per_channel_weights", false,
+                                                 &per_channel_weights));
+  std::map<string, const NodeDef*> node_map;
+  MapNamesToNodes(converted_graph_def, &node_map);
+
   // Replace all occurrences of the current float op with its quantized
   // equivalent.
   GraphDef quantized_graph_def;
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       converted_graph_def, {op_pattern},
-      [&op_map, fallback_min, fallback_max, has_fallback_range](
+      [&op_map, &node_map, fallback_min, fallback_max, has_fallback_range,
+       per_channel_weights](
           const NodeMatch& match, const std::set<string>& input_nodes,
           const std::set<string>& output_nodes,
           std::vector<NodeDef>* new_nodes) {
@@ -731,7 +760,9 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
         string namespace_prefix = float_node.name() + "_eightbit";
 
         // Quantize all of the inputs.
-        std::vector<string> quantized_input_names;
+        std::vector<string> quantized_inputs;
+        std::vector<string> quantized_input_mins;
+        std::vector<string> quantized_input_maxs;
         for (int i = 0; i < float_node.input_size(); ++i) {
           // Skip any non-float inputs.
           if (op_info.unquantized_inputs.count(i)) {
@@ -742,6 +773,50 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
           string unique_input_name =
               namespace_prefix + "/" + UniqueNodeNameFromInput(input_name);
 
+          // Constant weights quantized per channel are computed right away,
+          // with a vector of ranges.
+          const int channel_dim =
+              per_channel_weights ? PerChannelWeightsDim(float_node, i) : -1;
+          const NodeDef* weights_node = nullptr;
+          if (channel_dim >= 0 &&
+              CanonicalInputName(input_name) ==
+                  NodeNameFromInput(input_name) + ":0" &&
+              node_map.count(NodeNameFromInput(input_name))) {
+            weights_node = node_map.at(NodeNameFromInput(input_name));
+          }
+          if (weights_node != nullptr && weights_node->op() == "Const") {
+            const Tensor weights = GetNodeTensorAttr(*weights_node, "value");
+            if (weights.dtype() == DT_FLOAT && channel_dim < weights.dims()) {
+              Tensor quantized_weights;
+              Tensor mins;
+              Tensor maxs;
+              FloatTensorToQuantizedPerChannel<quint8>(
+                  weights, channel_dim, &quantized_weights, &mins, &maxs);
+              const std::vector<std::pair<string, Tensor>> consts = {
+                  {"/per_channel_quantized", quantized_weights},
+                  {"/per_channel_min", mins},
+                  {"/per_channel_max", maxs}};
+              for (const auto& name_and_tensor : consts) {
+                NodeDef const_node;
+                const_node.set_op("Const");
+                const_node.set_name(unique_input_name + name_and_tensor.first);
+                const_node.set_device(weights_node->device());
+                SetNodeAttr("dtype", name_and_tensor.second.dtype(),
+                            &const_node);
+                SetNodeTensorAttr<float>("value", name_and_tensor.second,
+                                         &const_node);
+                new_nodes->push_back(const_node);
+              }
+              quantized_inputs.push_back(unique_input_name +
+                                         "/per_channel_quantized");
+              quantized_input_mins.push_back(unique_input_name +
+                                             "/per_channel_min");
+              quantized_input_maxs.push_back(unique_input_name +
+                                             "/per_channel_max");
+              continue;
+            }
+          }
+
           // Add some common constants we need for reshaping inputs.
           NodeDef reshape_dims;
           reshape_dims.set_op("Const");
@@ -797,7 +872,9 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
           AddNodeInput(min_node.name(), &quantize_node);
           AddNodeInput(max_node.name(), &quantize_node);
           new_nodes->push_back(quantize_node);
-          quantized_input_names.push_back(quantize_node.name());
+          quantized_inputs.push_back(quantize_node.name() + ":0");
+          quantized_input_mins.push_back(quantize_node.name() + ":1");
+          quantized_input_maxs.push_back(quantize_node.name() + ":2");
         }
 
         // Set up the quantized version of the current op.
@@ -818,23 +895,22 @@ Status QuantizeNodes(const GraphDef& input_graph_def,
           if (op_info.unquantized_inputs.count(i)) {
             AddNodeInput(float_node.input(i), &quantized_main_node);
           } else {
-            const string& quantized_input_name =
-                quantized_input_names[quantized_input_index];
-            AddNodeInput(quantized_input_name + ":0", &quantized_main_node);
+            AddNodeInput(quantized_inputs[quantized_input_index],
+                         &quantized_main_node);
             ++quantized_input_index;
           }
         }
         if (op_info.min_max_order == QuantizedOpInfo::CONTIGUOUS_MIN_MAX) {
-          for (const string& quantized_input_name : quantized_input_names) {
-            AddNodeInput(quantized_input_name + ":1", &quantized_main_node);
-            AddNodeInput(quantized_input_name + ":2", &quantized_main_node);
+          for (int j = 0; j < quantized_inputs.size(); ++j) {
+            AddNodeInput(quantized_input_mins[j], &quantized_main_node);
+            AddNodeInput(quantized_input_maxs[j], &quantized_main_node);
           }
         } else {
-          for (const string& quantized_input_name : quantized_input_names) {
-            AddNodeInput(quantized_input_name + ":1", &quantized_main_node);
+          for (const string& quantized_input_min : quantized_input_mins) {
+            AddNodeInput(quantized_input_min, &quantized_main_node);
           }
-          for (const string& quantized_input_name : quantized_input_names) {
-            AddNodeInput(quantized_input_name + ":2", &quantized_main_node);
+          for (const string& quantized_input_max : quantized_input_maxs) {
+            AddNodeInput(quantized_input_max, &quantized_main_node);
           }
         }
         new_nodes->push_back(quantized_main_node);
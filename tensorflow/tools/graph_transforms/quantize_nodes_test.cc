@@ -306,6 +306,72 @@ class QuantizeNodesTest : public ::testing::Test {
     TestQuantizedVersusFloatGraph(float_graph_def, {}, {"conv_op"});
   }
 
+  void TestQuantizePerChannelWeights() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    // The weights of the first output channel of each op are much smaller
+    // than those of the second one.
+    Tensor a_tensor(DT_FLOAT, TensorShape({2, 3}));
+    test::FillValues<float>(&a_tensor, {1, 2, 3, 4, 5, 6});
+    Output a_op = Const(root.WithOpName("a_op"), Input::Initializer(a_tensor));
+    Tensor b_tensor(DT_FLOAT, TensorShape({3, 2}));
+    test::FillValues<float>(&b_tensor, {0.1f, 10, 0.2f, -20, 0.3f, 30});
+    Output b_op = Const(root.WithOpName("b_op"), Input::Initializer(b_tensor));
+    Output mat_mul_op = MatMul(root.WithOpName("mat_mul_op"), a_op, b_op);
+
+    Tensor input_tensor(DT_FLOAT, TensorShape({1, 3, 4, 1}));
+    test::FillValues<float>(&input_tensor,
+                            {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_tensor));
+    Tensor filter_tensor(DT_FLOAT, TensorShape({2, 2, 1, 2}));
+    test::FillValues<float>(&filter_tensor,
+                            {0.1f, 4, -0.2f, 3, 0.3f, -2, 0.4f, 1});
+    Output filter_op =
+        Const(root.WithOpName("filter_op"), Input::Initializer(filter_tensor));
+    Output conv_op = Conv2D(root.WithOpName("conv_op"), input_op, filter_op,
+                            {1, 1, 1, 1}, "SAME");
+
+    GraphDef float_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&float_graph_def));
+
+    TransformFuncContext context;
+    context.params["per_channel_weights"] = {"true"};
+    GraphDef quantized_graph_def;
+    TestTransformedVersusFloatGraph(QuantizeNodes, float_graph_def, {}, {},
+                                    {"mat_mul_op", "conv_op"}, context, 1.0,
+                                    &quantized_graph_def);
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(quantized_graph_def, &node_map);
+    for (const string& weights_name :
+         {"mat_mul_op_eightbit/b_op", "conv_op_eightbit/filter_op"}) {
+      ASSERT_EQ(1, node_map.count(weights_name + "/per_channel_min"))
+          << weights_name;
+      const Tensor mins =
+          GetNodeTensorAttr(*node_map.at(weights_name + "/per_channel_min"),
+                            "value");
+      const Tensor maxs =
+          GetNodeTensorAttr(*node_map.at(weights_name + "/per_channel_max"),
+                            "value");
+      ASSERT_EQ(1, mins.dims());
+      ASSERT_EQ(2, mins.dim_size(0));
+      // Each channel has its own symmetric range.
+      EXPECT_LT(maxs.flat<float>()(0), 1.0f);
+      EXPECT_GT(maxs.flat<float>()(1), 1.0f);
+      EXPECT_LT(mins.flat<float>()(0), -maxs.flat<float>()(0));
+    }
+    ASSERT_EQ(1, node_map.count("mat_mul_op/eightbit"));
+    const NodeDef* mat_mul_node = node_map.at("mat_mul_op/eightbit");
+    EXPECT_EQ("mat_mul_op_eightbit/b_op/per_channel_quantized",
+              mat_mul_node->input(1));
+    EXPECT_EQ("mat_mul_op_eightbit/b_op/per_channel_min",
+              mat_mul_node->input(4));
+    EXPECT_EQ("mat_mul_op_eightbit/b_op/per_channel_max",
+              mat_mul_node->input(5));
+  }
+
   void TestQuantizeBiasAdd() {
     auto root = tensorflow::Scope::NewRootScope();
     using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
@@ -1395,6 +1461,10 @@ TEST_F(QuantizeNodesTest, TestQuantizeConv2D) {
                      {1, 4, 7, 2, 5, 8, 3, 6, 9});
 }
 
+TEST_F(QuantizeNodesTest, TestQuantizePerChannelWeights) {
+  TestQuantizePerChannelWeights();
+}
+
 TEST_F(QuantizeNodesTest, TestQuantizeBiasAdd) { TestQuantizeBiasAdd(); }
 
 TEST_F(QuantizeNodesTest, TestQuantizeConcat) { TestQuantizeConcat(); }
@@ -0,0 +1,207 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/graph_memory.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Ops whose outputs are not allocated when the graph runs, so that they don't
+// count towards the memory used by the schedule.
+bool HasPersistentOutputs(const NodeDef& node) {
+  return node.op() == "Const" || node.op() == "Variable" ||
+         node.op() == "VariableV2" || node.op() == "VarHandleOp";
+}
+
+bool IsControlFlowOp(const NodeDef& node) {
+  return node.op() == "Enter" || node.op() == "RefEnter" ||
+         node.op() == "Exit" || node.op() == "RefExit" ||
+         node.op() == "Merge" || node.op() == "RefMerge" ||
+         node.op() == "Switch" || node.op() == "RefSwitch" ||
+         node.op() == "NextIteration" || node.op() == "RefNextIteration";
+}
+
+}  // namespace
+
+// Orders the nodes of the graph to keep the memory held by intermediate
+// tensors low, and optionally adds control dependencies so that the executor
+// runs them in that order. The schedule is built greedily: out of the nodes
+// whose inputs are all available, the next one is the one that grows the
+// live memory the least, counting the size of its outputs against the size of
+// the inputs it is the last consumer of. Ties go to the most recently readied
+// node, which keeps the order depth-first like sort_by_execution_order.
+Status SortByMemoryUse(const GraphDef& input_graph_def,
+                       const TransformFuncContext& context,
+                       GraphDef* output_graph_def) {
+  bool add_control_dependencies;
+  TF_RETURN_IF_ERROR(context.GetOneBoolParameter(
+      "add_control_dependencies", true, &add_control_dependencies));
+
+  const int num_nodes = input_graph_def.node_size();
+  std::map<string, int> name_index;
+  for (int n = 0; n < num_nodes; ++n) {
+    const NodeDef& node = input_graph_def.node(n);
+    if (IsControlFlowOp(node)) {
+      return errors::InvalidArgument(
+          "sort_by_memory_use doesn't support graphs with control flow, found ",
+          node.op(), " node '", node.name(), "'");
+    }
+    name_index[node.name()] = n;
+  }
+
+  // Sizes of the outputs of each node, as estimated by static shape inference.
+  grappler::GrapplerItem item;
+  item.graph = input_graph_def;
+  grappler::GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  std::vector<std::vector<int64>> output_bytes(num_nodes);
+  for (int n = 0; n < num_nodes; ++n) {
+    const NodeDef& node = input_graph_def.node(n);
+    for (const OpInfo::TensorProperties& output :
+         properties.GetOutputProperties(node.name())) {
+      output_bytes[n].push_back(
+          HasPersistentOutputs(node)
+              ? 0
+              : grappler::GraphMemory::InferMemUsageForNeighbors({output}));
+    }
+  }
+
+  // The distinct tensors each node reads as (node, output) pairs, the nodes
+  // each node has to run before, and the number of nodes still to read each
+  // tensor.
+  std::vector<std::set<std::pair<int, int>>> input_tensors(num_nodes);
+  std::vector<std::set<int>> input_nodes(num_nodes);
+  std::vector<std::vector<int>> outputs(num_nodes);
+  std::map<std::pair<int, int>, int> pending_reads;
+  for (int n = 0; n < num_nodes; ++n) {
+    const NodeDef& node = input_graph_def.node(n);
+    for (const string& input : node.input()) {
+      string prefix;
+      string input_node_name;
+      string suffix;
+      NodeNamePartsFromInput(input, &prefix, &input_node_name, &suffix);
+      if (!name_index.count(input_node_name)) {
+        return errors::InvalidArgument("Node '", node.name(),
+                                       "': Unknown input node '", input, "'");
+      }
+      const int input_node = name_index[input_node_name];
+      if (input_nodes[n].insert(input_node).second) {
+        outputs[input_node].push_back(n);
+      }
+      if (prefix == "^") {
+        continue;
+      }
+      int32 port = 0;
+      if (!suffix.empty() &&
+          !strings::safe_strto32(suffix.substr(1), &port)) {
+        return errors::InvalidArgument("Node '", node.name(),
+                                       "': Invalid input '", input, "'");
+      }
+      if (input_tensors[n].insert({input_node, port}).second) {
+        ++pending_reads[{input_node, port}];
+      }
+    }
+  }
+
+  // Bytes that running 'n' adds to the live memory, given the tensors that
+  // are still to be read.
+  auto memory_delta = [&](int n) {
+    int64 delta = 0;
+    for (int port = 0; port < output_bytes[n].size(); ++port) {
+      if (pending_reads.count({n, port})) {
+        delta += output_bytes[n][port];
+      }
+    }
+    for (const std::pair<int, int>& tensor : input_tensors[n]) {
+      if (pending_reads[tensor] == 1 &&
+          tensor.second < output_bytes[tensor.first].size()) {
+        delta -= output_bytes[tensor.first][tensor.second];
+      }
+    }
+    return delta;
+  };
+
+  std::vector<int> pending_count(num_nodes);
+  std::vector<int> ready;
+  for (int n = 0; n < num_nodes; ++n) {
+    pending_count[n] = input_nodes[n].size();
+    if (pending_count[n] == 0) {
+      ready.push_back(n);
+    }
+  }
+  std::vector<int> schedule;
+  schedule.reserve(num_nodes);
+  while (!ready.empty()) {
+    // Scan from the back so that ties go to the most recently readied node.
+    int best = ready.size() - 1;
+    int64 best_delta = memory_delta(ready[best]);
+    for (int i = best - 1; i >= 0; --i) {
+      const int64 delta = memory_delta(ready[i]);
+      if (delta < best_delta) {
+        best = i;
+        best_delta = delta;
+      }
+    }
+    const int n = ready[best];
+    ready.erase(ready.begin() + best);
+    schedule.push_back(n);
+    for (const std::pair<int, int>& tensor : input_tensors[n]) {
+      if (--pending_reads[tensor] == 0) {
+        pending_reads.erase(tensor);
+      }
+    }
+    for (const int output : outputs[n]) {
+      if (--pending_count[output] == 0) {
+        ready.push_back(output);
+      }
+    }
+  }
+  if (schedule.size() < num_nodes) {
+    return errors::InvalidArgument(num_nodes - schedule.size(),
+                                   " nodes in a cycle");
+  }
+
+  // The executor runs any node whose inputs are ready, so the schedule is
+  // only followed if each node waits for the one before it. Nodes with no
+  // inputs are left out of the chain: they hold constants, variables or fed
+  // tensors, which don't depend on when they run.
+  output_graph_def->Clear();
+  int previous = -1;
+  for (const int n : schedule) {
+    NodeDef* node = output_graph_def->mutable_node()->Add();
+    *node = input_graph_def.node(n);
+    if (!add_control_dependencies || input_nodes[n].empty()) {
+      continue;
+    }
+    if (previous >= 0 && !input_nodes[n].count(previous)) {
+      node->add_input(
+          strings::StrCat("^", input_graph_def.node(previous).name()));
+    }
+    previous = n;
+  }
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("sort_by_memory_use", SortByMemoryUse);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,126 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status SortByMemoryUse(const GraphDef& input_graph_def,
+                       const TransformFuncContext& context,
+                       GraphDef* output_graph_def);
+
+class SortByMemoryUseTest : public ::testing::Test {
+ protected:
+  void GetOrder(const GraphDef& graph_def, std::map<string, int>* order) {
+    for (int i = 0; i < graph_def.node_size(); ++i) {
+      (*order)[graph_def.node(i).name()] = i;
+    }
+  }
+
+  // Two branches each expand a constant into a large tensor and reduce it to
+  // a scalar. Running them one after the other keeps a single large tensor
+  // alive at a time.
+  void BuildBranches(GraphDef* graph_def) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({1000}));
+    test::FillIota<float>(&input_data, 0.0f);
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+    Output axis_op = Const(root.WithOpName("axis_op"), 0);
+    Output a_neg_op = Neg(root.WithOpName("a_neg_op"), input_op);
+    Output b_neg_op = Neg(root.WithOpName("b_neg_op"), input_op);
+    Output a_sum_op = Sum(root.WithOpName("a_sum_op"), a_neg_op, axis_op);
+    Output b_sum_op = Sum(root.WithOpName("b_sum_op"), b_neg_op, axis_op);
+    Add(root.WithOpName("output"), a_sum_op, b_sum_op);
+    TF_ASSERT_OK(root.ToGraphDef(graph_def));
+  }
+
+  void TestBranchesRunOneAfterTheOther() {
+    GraphDef graph_def;
+    BuildBranches(&graph_def);
+
+    GraphDef result;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    TF_ASSERT_OK(SortByMemoryUse(graph_def, context, &result));
+
+    std::map<string, int> order;
+    GetOrder(result, &order);
+    EXPECT_EQ(graph_def.node_size(), result.node_size());
+    const bool a_first = order["a_neg_op"] < order["b_neg_op"];
+    const string first = a_first ? "a" : "b";
+    const string second = a_first ? "b" : "a";
+    EXPECT_LT(order[first + "_sum_op"], order[second + "_neg_op"]);
+    EXPECT_EQ(result.node_size() - 1, order["output"]);
+
+    // The second branch waits for the first one through a control
+    // dependency.
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(result, &node_lookup);
+    const NodeDef* second_neg = node_lookup.at(second + "_neg_op");
+    EXPECT_EQ("^" + first + "_sum_op",
+              second_neg->input(second_neg->input_size() - 1));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    std::unique_ptr<Session> sorted_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(sorted_session->Create(result));
+    std::vector<Tensor> sorted_outputs;
+    TF_ASSERT_OK(sorted_session->Run({}, {"output"}, {}, &sorted_outputs));
+    test::ExpectTensorEqual<float>(original_outputs[0], sorted_outputs[0]);
+  }
+
+  void TestWithoutControlDependencies() {
+    GraphDef graph_def;
+    BuildBranches(&graph_def);
+
+    GraphDef result;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    context.params["add_control_dependencies"] = {"false"};
+    TF_ASSERT_OK(SortByMemoryUse(graph_def, context, &result));
+
+    for (const NodeDef& node : result.node()) {
+      for (const string& input : node.input()) {
+        EXPECT_NE('^', input[0]) << node.name();
+      }
+    }
+  }
+};
+
+TEST_F(SortByMemoryUseTest, TestBranchesRunOneAfterTheOther) {
+  TestBranchesRunOneAfterTheOther();
+}
+
+TEST_F(SortByMemoryUseTest, TestWithoutControlDependencies) {
+  TestWithoutControlDependencies();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,192 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Returns true if 'node' is not assigned to a device other than the CPU, the
+// only one with a _BlockSparseMatMul kernel.
+bool RunsOnCpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  return !DeviceNameUtils::ParseFullName(node.device(), &parsed) ||
+         !parsed.has_type || str_util::Uppercase(parsed.type) == "CPU";
+}
+
+// Returns a Const node named 'name' on 'device' holding 'value'.
+template <typename T>
+NodeDef MakeConstNode(const string& name, const string& device,
+                      const Tensor& value) {
+  NodeDef node;
+  node.set_op("Const");
+  node.set_name(name);
+  node.set_device(device);
+  SetNodeAttr("dtype", DataTypeToEnum<T>::v(), &node);
+  SetNodeTensorAttr<T>("value", value, &node);
+  return node;
+}
+
+}  // namespace
+
+// Replaces the float MatMul ops whose weights are a mostly zero Const, such as
+// pruned fully-connected layers, by _BlockSparseMatMul ops storing only the
+// blocks of 'block_size' consecutive columns of the weights in a row which are
+// not all zeros. Weights used by other ops, and MatMul ops assigned to other
+// devices than the CPU, are left alone.
+Status SparsifyMatMul(const GraphDef& input_graph_def,
+                      const TransformFuncContext& context,
+                      GraphDef* output_graph_def) {
+  int32 block_size;
+  TF_RETURN_IF_ERROR(
+      context.GetOneInt32Parameter("block_size", 8, &block_size));
+  float minimum_sparsity;
+  TF_RETURN_IF_ERROR(context.GetOneFloatParameter("minimum_sparsity", 0.8f,
+                                                  &minimum_sparsity));
+  int32 minimum_size;
+  TF_RETURN_IF_ERROR(
+      context.GetOneInt32Parameter("minimum_size", 1024, &minimum_size));
+  if (block_size <= 0) {
+    return errors::InvalidArgument("block_size must be positive, got ",
+                                   block_size);
+  }
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"MatMul",             // matmul_node
+        {
+          {"*"},             // input_node
+          {"Const"},         // weights_node
+        }
+      },  // clang-format on
+      [block_size, minimum_sparsity, minimum_size](
+          const NodeMatch& match, const std::set<string>& input_nodes,
+          const std::set<string>& output_nodes,
+          std::vector<NodeDef>* new_nodes) {
+        const NodeDef& matmul_node = match.node;
+        const NodeDef& input_node = match.inputs[0].node;
+        const NodeDef& weights_node = match.inputs[1].node;
+
+        Tensor weights = GetNodeTensorAttr(weights_node, "value");
+        if (!RunsOnCpu(matmul_node) ||
+            matmul_node.attr().at("T").type() != DT_FLOAT ||
+            matmul_node.attr().at("transpose_a").b() ||
+            weights.dtype() != DT_FLOAT || weights.dims() != 2 ||
+            weights.NumElements() < minimum_size ||
+            output_nodes.count(weights_node.name())) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+
+        // The weights as a [depth, cols] matrix.
+        const bool transpose_b = matmul_node.attr().at("transpose_b").b();
+        const auto matrix = weights.matrix<float>();
+        const int64 depth = weights.dim_size(transpose_b ? 1 : 0);
+        const int64 cols = weights.dim_size(transpose_b ? 0 : 1);
+        auto weight = [&matrix, transpose_b](int64 row, int64 col) {
+          return transpose_b ? matrix(col, row) : matrix(row, col);
+        };
+
+        std::vector<float> values;
+        std::vector<int32> block_rows;
+        std::vector<int32> block_splits = {0};
+        for (int64 col = 0; col < cols; col += block_size) {
+          const int64 width = std::min<int64>(block_size, cols - col);
+          for (int64 row = 0; row < depth; ++row) {
+            bool zero = true;
+            for (int64 c = col; zero && c < col + width; ++c) {
+              zero = weight(row, c) == 0.0f;
+            }
+            if (zero) {
+              continue;
+            }
+            for (int64 c = col; c < col + block_size; ++c) {
+              values.push_back(c < cols ? weight(row, c) : 0.0f);
+            }
+            block_rows.push_back(row);
+          }
+          block_splits.push_back(block_rows.size());
+        }
+        const int64 num_blocks = block_rows.size();
+        const int64 total_blocks = depth * (block_splits.size() - 1);
+        if (num_blocks > (1.0f - minimum_sparsity) * total_blocks) {
+          CopyOriginalMatch(match, new_nodes);
+          return Status::OK();
+        }
+
+        Tensor values_tensor(DT_FLOAT, TensorShape({num_blocks, block_size}));
+        std::copy(values.begin(), values.end(),
+                  values_tensor.flat<float>().data());
+        Tensor block_rows_tensor(DT_INT32, TensorShape({num_blocks}));
+        std::copy(block_rows.begin(), block_rows.end(),
+                  block_rows_tensor.flat<int32>().data());
+        Tensor block_splits_tensor(
+            DT_INT32,
+            TensorShape({static_cast<int64>(block_splits.size())}));
+        std::copy(block_splits.begin(), block_splits.end(),
+                  block_splits_tensor.flat<int32>().data());
+        Tensor dense_shape_tensor(DT_INT64, TensorShape({2}));
+        dense_shape_tensor.flat<int64>()(0) = depth;
+        dense_shape_tensor.flat<int64>()(1) = cols;
+
+        const string& prefix = weights_node.name();
+        const string& device = weights_node.device();
+        const std::vector<NodeDef> sparse_weights_nodes = {
+            MakeConstNode<float>(strings::StrCat(prefix, "_values"), device,
+                                 values_tensor),
+            MakeConstNode<int32>(strings::StrCat(prefix, "_block_rows"),
+                                 device, block_rows_tensor),
+            MakeConstNode<int32>(strings::StrCat(prefix, "_block_splits"),
+                                 device, block_splits_tensor),
+            MakeConstNode<int64>(strings::StrCat(prefix, "_dense_shape"),
+                                 device, dense_shape_tensor),
+        };
+        new_nodes->insert(new_nodes->end(), sparse_weights_nodes.begin(),
+                          sparse_weights_nodes.end());
+
+        new_nodes->push_back(input_node);
+
+        NodeDef sparse_matmul_node;
+        sparse_matmul_node.set_op("_BlockSparseMatMul");
+        sparse_matmul_node.set_name(matmul_node.name());
+        sparse_matmul_node.set_device(matmul_node.device());
+        AddNodeInput(matmul_node.input(0), &sparse_matmul_node);
+        for (const NodeDef& node : sparse_weights_nodes) {
+          AddNodeInput(node.name(), &sparse_matmul_node);
+        }
+        for (int i = 2; i < matmul_node.input_size(); ++i) {
+          AddNodeInput(matmul_node.input(i), &sparse_matmul_node);
+        }
+        new_nodes->push_back(sparse_matmul_node);
+
+        return Status::OK();
+      },
+      {}, output_graph_def));
+
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("sparsify_matmul", SparsifyMatMul);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
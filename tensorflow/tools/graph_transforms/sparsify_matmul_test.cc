@@ -0,0 +1,153 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status SparsifyMatMul(const GraphDef& input_graph_def,
+                      const TransformFuncContext& context,
+                      GraphDef* output_graph_def);
+
+class SparsifyMatMulTest : public ::testing::Test {
+ protected:
+  void TestSparsifyMatMul(bool transpose_b) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({3, 40}));
+    test::FillFn<float>(&input_data, [](int i) { return (i % 7) - 3.0f; });
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    // One block of four weights in ten is not zero, and the 30 columns are not
+    // a multiple of the block size.
+    Tensor weights_data(DT_FLOAT, transpose_b ? TensorShape({30, 40})
+                                              : TensorShape({40, 30}));
+    test::FillFn<float>(&weights_data, [transpose_b](int i) {
+      const int row = transpose_b ? i % 40 : i / 30;
+      const int col = transpose_b ? i / 40 : i % 30;
+      return (row + col / 4) % 10 == 0 ? (i % 5) - 2.0f : 0.0f;
+    });
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output matmul_op = MatMul(root.WithOpName("output"), input_op, weights_op,
+                              MatMul::TransposeB(transpose_b));
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    GraphDef sparse_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"output"};
+    context.params["block_size"] = {"4"};
+    context.params["minimum_size"] = {"100"};
+    TF_ASSERT_OK(
+        SparsifyMatMul(original_graph_def, context, &sparse_graph_def));
+
+    std::unique_ptr<Session> sparse_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(sparse_session->Create(sparse_graph_def));
+    std::vector<Tensor> sparse_outputs;
+    TF_ASSERT_OK(sparse_session->Run({}, {"output"}, {}, &sparse_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], sparse_outputs[0],
+                                  1e-5);
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(sparse_graph_def, &node_lookup);
+    EXPECT_EQ(0, node_lookup.count("weights_op"));
+    EXPECT_EQ("_BlockSparseMatMul", node_lookup.at("output")->op());
+    ASSERT_EQ(1, node_lookup.count("weights_op_values"));
+    const Tensor values =
+        GetNodeTensorAttr(*node_lookup.at("weights_op_values"), "value");
+    // At most four rows of each of the eight groups of columns have non-zero
+    // blocks.
+    EXPECT_EQ(4, values.dim_size(1));
+    EXPECT_GT(values.dim_size(0), 0);
+    EXPECT_LE(values.dim_size(0), 4 * 8);
+  }
+
+  void TestKeepDenseAndSharedWeights() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({2, 40}));
+    test::FillIota<float>(&input_data, 1.0f);
+    Output input_op =
+        Const(root.WithOpName("input_op"), Input::Initializer(input_data));
+
+    Tensor dense_weights_data(DT_FLOAT, TensorShape({40, 40}));
+    test::FillIota<float>(&dense_weights_data, 1.0f);
+    Output dense_weights_op = Const(root.WithOpName("dense_weights_op"),
+                                    Input::Initializer(dense_weights_data));
+    Output dense_matmul_op =
+        MatMul(root.WithOpName("dense_matmul_op"), input_op, dense_weights_op);
+
+    Tensor shared_weights_data(DT_FLOAT, TensorShape({40, 40}));
+    test::FillZeros<float>(&shared_weights_data);
+    Output shared_weights_op = Const(root.WithOpName("shared_weights_op"),
+                                     Input::Initializer(shared_weights_data));
+    Output shared_matmul_op = MatMul(root.WithOpName("shared_matmul_op"),
+                                     input_op, shared_weights_op);
+    Output shared_op =
+        Identity(root.WithOpName("shared_op"), shared_weights_op);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    GraphDef sparse_graph_def;
+    TransformFuncContext context;
+    context.output_names = {"dense_matmul_op", "shared_matmul_op",
+                            "shared_op"};
+    context.params["minimum_size"] = {"100"};
+    TF_ASSERT_OK(
+        SparsifyMatMul(original_graph_def, context, &sparse_graph_def));
+
+    std::map<string, const NodeDef*> node_lookup;
+    MapNamesToNodes(sparse_graph_def, &node_lookup);
+    EXPECT_EQ("MatMul", node_lookup.at("dense_matmul_op")->op());
+    EXPECT_EQ("MatMul", node_lookup.at("shared_matmul_op")->op());
+    EXPECT_EQ(0, node_lookup.count("dense_weights_op_values"));
+    EXPECT_EQ(0, node_lookup.count("shared_weights_op_values"));
+  }
+};
+
+TEST_F(SparsifyMatMulTest, TestSparsifyMatMul) { TestSparsifyMatMul(false); }
+
+TEST_F(SparsifyMatMulTest, TestSparsifyTransposedMatMul) {
+  TestSparsifyMatMul(true);
+}
+
+TEST_F(SparsifyMatMulTest, TestKeepDenseAndSharedWeights) {
+  TestKeepDenseAndSharedWeights();
+}
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
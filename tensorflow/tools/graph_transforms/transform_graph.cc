@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/tools/graph_transforms/transform_graph.h"
+#include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
 
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -130,6 +131,8 @@ int ParseFlagsAndTransformGraph(int argc, char* argv[], bool init_main) {
   string outputs_string = "";
   string transforms_string = "";
   bool output_as_text = false;
+  bool output_as_memmapped = false;
+  int memmapped_min_size_bytes = 10000;
   std::vector<Flag> flag_list = {
       Flag("in_graph", &in_graph, "input graph file name"),
       Flag("out_graph", &out_graph, "output graph file name"),
@@ -138,6 +141,13 @@ int ParseFlagsAndTransformGraph(int argc, char* argv[], bool init_main) {
       Flag("transforms", &transforms_string, "list of transforms"),
       Flag("output_as_text", &output_as_text,
            "whether to write the graph in text protobuf format"),
+      Flag("output_as_memmapped", &output_as_memmapped,
+           "whether to write the graph in the memmapped package format, with "
+           "the large constants stored outside of the GraphDef so that they "
+           "can be mapped at load time"),
+      Flag("memmapped_min_size_bytes", &memmapped_min_size_bytes,
+           "constants with fewer bytes than this are kept in the GraphDef of "
+           "the memmapped package"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   usage += "\nTransforms are:\n";
@@ -171,6 +181,15 @@ int ParseFlagsAndTransformGraph(int argc, char* argv[], bool init_main) {
     LOG(ERROR) << "You must specify at least one transform.\n" << usage;
     return -1;
   }
+  if (output_as_text && output_as_memmapped) {
+    LOG(ERROR) << "output_as_text and output_as_memmapped can't both be set.\n"
+               << usage;
+    return -1;
+  }
+  if (memmapped_min_size_bytes <= 0) {
+    LOG(ERROR) << "memmapped_min_size_bytes must be > 0.\n" << usage;
+    return -1;
+  }
 
   std::vector<string> inputs = str_util::Split(inputs_string, ',');
   std::vector<string> outputs = str_util::Split(outputs_string, ',');
@@ -208,6 +227,9 @@ int ParseFlagsAndTransformGraph(int argc, char* argv[], bool init_main) {
   Status save_status;
   if (output_as_text) {
     save_status = WriteTextProto(Env::Default(), out_graph, graph_def);
+  } else if (output_as_memmapped) {
+    save_status = ConvertGraphDefConstantsToImmutable(graph_def, out_graph,
+                                                      memmapped_min_size_bytes);
   } else {
     save_status = WriteBinaryProto(Env::Default(), out_graph, graph_def);
   }
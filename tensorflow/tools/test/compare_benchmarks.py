@@ -0,0 +1,68 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Compares the benchmark results of two builds and flags regressions.
+
+Example:
+  compare_benchmarks --baseline=/tmp/old.json --candidate=/tmp/new.json
+
+Exits with status 1 if a benchmark of the candidate is slower than the
+baseline by more than --threshold.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import sys
+
+from tensorflow.python.platform import app
+from tensorflow.tools.test import compare_benchmarks_lib
+
+FLAGS = None
+
+
+def main(unused_args):
+  baseline = compare_benchmarks_lib.load_benchmark_entries(FLAGS.baseline)
+  candidate = compare_benchmarks_lib.load_benchmark_entries(FLAGS.candidate)
+  comparisons, missing, added = compare_benchmarks_lib.compare(
+      baseline, candidate, FLAGS.threshold)
+  print(compare_benchmarks_lib.format_report(comparisons, missing, added))
+  regressions = [c for c in comparisons if c.regressed]
+  if regressions:
+    print("%d of %d benchmarks regressed by more than %.1f%%." %
+          (len(regressions), len(comparisons), FLAGS.threshold * 100))
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--baseline",
+      type=str,
+      default="",
+      help="Glob of the benchmark results of the baseline build.")
+  parser.add_argument(
+      "--candidate",
+      type=str,
+      default="",
+      help="Glob of the benchmark results of the candidate build.")
+  parser.add_argument(
+      "--threshold",
+      type=float,
+      default=0.1,
+      help="Relative slowdown above which a benchmark has regressed.")
+  FLAGS, unparsed = parser.parse_known_args()
+  app.run(main=main, argv=[sys.argv[0]] + unparsed)
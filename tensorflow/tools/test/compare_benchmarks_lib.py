@@ -0,0 +1,121 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Library for comparing the benchmark results of two builds."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from google.protobuf import json_format
+from google.protobuf import text_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+# The comparison of one benchmark.  The times are wall times per iteration,
+# in seconds, and change is the relative change of the candidate time.
+Comparison = collections.namedtuple(
+    "Comparison",
+    ["name", "baseline_time", "candidate_time", "change", "regressed"])
+
+
+def load_benchmark_entries(pattern):
+  """Loads benchmark results from the files matching a glob pattern.
+
+  Files ending in ".json" or ".pbtxt" hold a TestResults proto, as written
+  by run_and_gather_logs.  Other files hold a serialized BenchmarkEntries
+  proto, as written by the TestReporter of a benchmark binary run with
+  TEST_REPORT_FILE_PREFIX set.
+
+  Args:
+    pattern: A glob pattern, e.g. "/tmp/results.json" or "/tmp/run_*".
+
+  Returns:
+    A dict from benchmark name to BenchmarkEntry.
+
+  Raises:
+    IOError: If no file matches the pattern.
+    ValueError: If a file cannot be parsed.
+  """
+  files = gfile.Glob(pattern)
+  if not files:
+    raise IOError("No benchmark results found at %s" % pattern)
+  entries = {}
+  for f in files:
+    content = gfile.GFile(f, "rb").read()
+    if f.endswith(".json") or f.endswith(".pbtxt"):
+      results = test_log_pb2.TestResults()
+      if f.endswith(".json"):
+        json_format.Parse(content, results)
+      else:
+        text_format.Merge(content, results)
+      benchmarks = results.entries
+    else:
+      benchmarks = test_log_pb2.BenchmarkEntries()
+      if benchmarks.MergeFromString(content) != len(content):
+        raise ValueError("Failed parsing benchmark entries from %s" % f)
+    for entry in benchmarks.entry:
+      entries[entry.name] = entry
+  return entries
+
+
+def compare(baseline, candidate, threshold):
+  """Compares the wall time per iteration of two sets of benchmarks.
+
+  Args:
+    baseline: A dict from benchmark name to BenchmarkEntry.
+    candidate: A dict from benchmark name to BenchmarkEntry.
+    threshold: The relative slowdown above which a benchmark regressed,
+      e.g. 0.1 for 10%.
+
+  Returns:
+    A tuple (comparisons, missing, added), where comparisons is a list of
+    Comparison for the benchmarks in both sets, sorted by name, missing the
+    sorted names only in baseline, and added those only in candidate.
+  """
+  comparisons = []
+  for name in sorted(set(baseline) & set(candidate)):
+    baseline_time = baseline[name].wall_time
+    candidate_time = candidate[name].wall_time
+    if baseline_time > 0:
+      change = (candidate_time - baseline_time) / baseline_time
+    else:
+      change = 0.0
+    comparisons.append(
+        Comparison(name, baseline_time, candidate_time, change,
+                   change > threshold))
+  missing = sorted(set(baseline) - set(candidate))
+  added = sorted(set(candidate) - set(baseline))
+  return comparisons, missing, added
+
+
+def format_report(comparisons, missing, added):
+  """Returns a table of the comparisons, in nanoseconds per iteration."""
+  width = max([len("Benchmark")] + [len(c.name) for c in comparisons])
+  lines = ["%-*s %14s %14s %9s" % (width, "Benchmark", "Baseline(ns)",
+                                   "Candidate(ns)", "Change")]
+  lines.append("-" * (width + 40))
+  for c in comparisons:
+    lines.append("%-*s %14.0f %14.0f %+8.1f%%%s" %
+                 (width, c.name, c.baseline_time * 1e9,
+                  c.candidate_time * 1e9, c.change * 100,
+                  "  REGRESSED" if c.regressed else ""))
+  for name in missing:
+    lines.append("Missing from candidate: %s" % name)
+  for name in added:
+    lines.append("New in candidate: %s" % name)
+  return "\n".join(lines)
@@ -0,0 +1,88 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks_lib."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from google.protobuf import json_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_benchmarks_lib
+
+
+def _entries(**wall_times):
+  entries = test_log_pb2.BenchmarkEntries()
+  for name, wall_time in wall_times.items():
+    entry = entries.entry.add()
+    entry.name = name
+    entry.iters = 100
+    entry.wall_time = wall_time
+  return entries
+
+
+class CompareBenchmarksLibTest(googletest.TestCase):
+
+  def testLoadReporterFilesAndTestResults(self):
+    tmpdir = googletest.GetTempDir()
+    for name, wall_time in [("BM_a", 1e-6), ("BM_b", 2e-6)]:
+      with gfile.GFile(os.path.join(tmpdir, "run_" + name), "wb") as f:
+        f.write(_entries(**{name: wall_time}).SerializeToString())
+    entries = compare_benchmarks_lib.load_benchmark_entries(
+        os.path.join(tmpdir, "run_*"))
+    self.assertEqual(["BM_a", "BM_b"], sorted(entries))
+    self.assertEqual(2e-6, entries["BM_b"].wall_time)
+
+    results = test_log_pb2.TestResults()
+    results.entries.CopyFrom(_entries(BM_c=3e-6))
+    json_file = os.path.join(tmpdir, "results.json")
+    with gfile.GFile(json_file, "w") as f:
+      f.write(json_format.MessageToJson(results))
+    entries = compare_benchmarks_lib.load_benchmark_entries(json_file)
+    self.assertEqual(3e-6, entries["BM_c"].wall_time)
+
+  def testLoadMissingFiles(self):
+    with self.assertRaises(IOError):
+      compare_benchmarks_lib.load_benchmark_entries(
+          os.path.join(googletest.GetTempDir(), "does_not_exist_*"))
+
+  def testCompare(self):
+    baseline = {e.name: e for e in _entries(
+        BM_same=1e-6, BM_slower=1e-6, BM_faster=1e-6, BM_gone=1e-6).entry}
+    candidate = {e.name: e for e in _entries(
+        BM_same=1.05e-6, BM_slower=1.5e-6, BM_faster=0.5e-6,
+        BM_new=1e-6).entry}
+    comparisons, missing, added = compare_benchmarks_lib.compare(
+        baseline, candidate, 0.1)
+    self.assertEqual(["BM_faster", "BM_same", "BM_slower"],
+                     [c.name for c in comparisons])
+    self.assertEqual([False, False, True], [c.regressed for c in comparisons])
+    self.assertAlmostEqual(0.5, comparisons[2].change)
+    self.assertEqual(["BM_gone"], missing)
+    self.assertEqual(["BM_new"], added)
+
+    report = compare_benchmarks_lib.format_report(comparisons, missing, added)
+    self.assertIn("BM_slower", report)
+    self.assertIn("REGRESSED", report)
+    self.assertIn("Missing from candidate: BM_gone", report)
+
+
+if __name__ == "__main__":
+  googletest.main()
@@ -0,0 +1,362 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/tfprof/internal/tfprof_critical_path.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/regexp.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_constants.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_utils.h"
+
+namespace tensorflow {
+namespace tfprof {
+namespace {
+
+// Returns the op name of a node input, "^name" or "name:output".
+string InputOpName(const string& input) {
+  StringPiece name(input);
+  name.Consume("^");
+  const auto colon = name.rfind(':');
+  if (colon != StringPiece::npos) {
+    name = name.substr(0, colon);
+  }
+  return name.ToString();
+}
+
+bool IsCpuDevice(const string& device) {
+  const string lower = str_util::Lowercase(device);
+  return lower.find("/cpu:") != lower.npos ||
+         lower.find("device:cpu:") != lower.npos;
+}
+
+bool IsQueueOp(const NodeDef* node_def) {
+  if (node_def == nullptr) return false;
+  return StringPiece(node_def->op()).starts_with("QueueDequeue") ||
+         node_def->op() == "Unstage";
+}
+
+bool ShowDevice(const string& device, const Options& opts) {
+  if (opts.device_regexes.empty() ||
+      (opts.device_regexes.size() == 1 && opts.device_regexes[0] == ".*")) {
+    return true;
+  }
+  for (const string& regex : opts.device_regexes) {
+    if (RE2::FullMatch(device, regex)) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TFCriticalPath::TFCriticalPath(const GraphDef& graph,
+                               const StepStats& step_stats)
+    : step_start_micros_(0), step_end_micros_(0) {
+  for (const NodeDef& node : graph.node()) {
+    node_defs_[node.name()] = &node;
+  }
+  ParseStepStats(step_stats);
+  BuildCriticalPath();
+  BuildGaps();
+}
+
+const char* TFCriticalPath::GapCauseString(GapCause cause) {
+  switch (cause) {
+    case kHostCompute:
+      return "host compute";
+    case kDeviceCompute:
+      return "device compute";
+    case kTransfer:
+      return "transfer";
+    case kQueueWait:
+      return "queue wait";
+    case kScheduling:
+      return "scheduling";
+    default:
+      break;
+  }
+  return "unknown";
+}
+
+void TFCriticalPath::ParseStepStats(const StepStats& step_stats) {
+  for (const auto& dev_stat : step_stats.dev_stats()) {
+    const string& device = dev_stat.device();
+    // The GPU tracer records each kernel and memcpy twice, on its stream and
+    // on "stream:all". Only the latter is used, as the timeline of the GPU.
+    const bool is_gpu_stream =
+        device.find("/stream:") != device.npos &&
+        StringPiece(device).ends_with("/stream:all");
+    if (!is_gpu_stream && (device.find("/stream:") != device.npos ||
+                           StringPiece(device).ends_with("/memcpy"))) {
+      continue;
+    }
+    for (const auto& node_stat : dev_stat.node_stats()) {
+      Execution execution;
+      execution.name = node_stat.node_name();
+      execution.device = device;
+      execution.start_micros = node_stat.all_start_micros();
+      execution.end_micros = node_stat.all_start_micros() +
+                             std::max(node_stat.all_end_rel_micros(),
+                                      node_stat.op_end_rel_micros());
+      execution.is_gpu_stream = is_gpu_stream;
+      auto node_def = node_defs_.find(execution.name);
+      if (node_def == node_defs_.end() && is_gpu_stream) {
+        // The GPU tracer names the kernels "<op name>:<op type>".
+        execution.name = InputOpName(execution.name);
+        node_def = node_defs_.find(execution.name);
+      }
+      execution.node_def =
+          node_def != node_defs_.end() ? node_def->second : nullptr;
+      executions_.push_back(execution);
+    }
+  }
+
+  step_start_micros_ = std::numeric_limits<int64>::max();
+  step_end_micros_ = 0;
+  for (const Execution& execution : executions_) {
+    step_start_micros_ = std::min(step_start_micros_, execution.start_micros);
+    step_end_micros_ = std::max(step_end_micros_, execution.end_micros);
+    if (!execution.is_gpu_stream) {
+      op_executions_[execution.name].push_back(&execution);
+    }
+  }
+  if (executions_.empty()) step_start_micros_ = 0;
+  for (auto& it : op_executions_) {
+    std::sort(it.second.begin(), it.second.end(),
+              [](const Execution* a, const Execution* b) {
+                return a->end_micros < b->end_micros;
+              });
+  }
+}
+
+const TFCriticalPath::Execution* TFCriticalPath::BindingInput(
+    const Execution& execution) const {
+  if (execution.node_def == nullptr) return nullptr;
+  const Execution* binding = nullptr;
+  for (const string& input : execution.node_def->input()) {
+    auto it = op_executions_.find(InputOpName(input));
+    if (it == op_executions_.end()) continue;
+    // The last execution of the input that ended before this one started,
+    // which is the one it consumed if the input is in a loop.
+    for (auto e = it->second.rbegin(); e != it->second.rend(); ++e) {
+      if (*e == &execution) continue;
+      if ((*e)->end_micros <= execution.start_micros) {
+        if (binding == nullptr || (*e)->end_micros > binding->end_micros) {
+          binding = *e;
+        }
+        break;
+      }
+    }
+  }
+  return binding;
+}
+
+const TFCriticalPath::Execution* TFCriticalPath::ExecutorExecution(
+    const Execution& execution) const {
+  if (!execution.is_gpu_stream) return &execution;
+  auto it = op_executions_.find(execution.name);
+  if (it == op_executions_.end()) return nullptr;
+  const Execution* launch = nullptr;
+  for (const Execution* e : it->second) {
+    if (e->start_micros <= execution.start_micros &&
+        (launch == nullptr || e->start_micros > launch->start_micros)) {
+      launch = e;
+    }
+  }
+  return launch;
+}
+
+TFCriticalPath::GapCause TFCriticalPath::Cause(
+    const Execution& next, int64 gap_start_micros,
+    const Execution** waited_for) const {
+  *waited_for = nullptr;
+  const Execution* launch = ExecutorExecution(next);
+  // A kernel launched before the gap was not held back by the host.
+  if (launch == nullptr || launch->start_micros < gap_start_micros) {
+    return kScheduling;
+  }
+  const Execution* input = BindingInput(*launch);
+  *waited_for = input;
+  if (input == nullptr) return kScheduling;
+  const bool other_device = input->device != launch->device;
+  if (input->end_micros <= gap_start_micros) {
+    return other_device ? kTransfer : kScheduling;
+  }
+  if (IsQueueOp(input->node_def)) return kQueueWait;
+  if (!other_device) return kScheduling;
+  if (launch->start_micros - input->end_micros >
+      input->end_micros - gap_start_micros) {
+    return kTransfer;
+  }
+  return IsCpuDevice(input->device) ? kHostCompute : kDeviceCompute;
+}
+
+void TFCriticalPath::BuildCriticalPath() {
+  const Execution* last = nullptr;
+  for (const Execution& execution : executions_) {
+    if (execution.is_gpu_stream) continue;
+    if (last == nullptr || execution.end_micros > last->end_micros) {
+      last = &execution;
+    }
+  }
+  std::set<const Execution*> visited;
+  for (const Execution* e = last; e != nullptr && visited.insert(e).second;
+       e = BindingInput(*e)) {
+    critical_path_.push_back(e);
+  }
+  std::reverse(critical_path_.begin(), critical_path_.end());
+}
+
+void TFCriticalPath::BuildGaps() {
+  std::map<string, std::vector<const Execution*>> device_executions;
+  for (const Execution& execution : executions_) {
+    device_executions[execution.device].push_back(&execution);
+  }
+  for (auto& it : device_executions) {
+    std::vector<const Execution*>& executions = it.second;
+    std::sort(executions.begin(), executions.end(),
+              [](const Execution* a, const Execution* b) {
+                return a->start_micros < b->start_micros;
+              });
+    std::vector<Gap>& gaps = gaps_[it.first];
+    int64& busy_micros = busy_micros_[it.first];
+    // Ops may run concurrently on a device, so it is idle only when none
+    // runs.
+    int64 busy_until = step_start_micros_;
+    for (const Execution* execution : executions) {
+      if (execution->start_micros > busy_until) {
+        Gap gap;
+        gap.start_micros = busy_until;
+        gap.end_micros = execution->start_micros;
+        gap.next = execution;
+        gap.cause = Cause(*execution, busy_until, &gap.waited_for);
+        gaps.push_back(gap);
+      }
+      busy_micros += std::max<int64>(
+          0, execution->end_micros -
+                 std::max(execution->start_micros, busy_until));
+      busy_until = std::max(busy_until, execution->end_micros);
+    }
+  }
+}
+
+const TFProfNode& TFCriticalPath::Show(const Options& opts) {
+  root_.Clear();
+  root_.set_name(kTFProfRoot);
+  root_.set_exec_micros(0);
+
+  string out;
+  if (critical_path_.empty()) {
+    strings::StrAppend(&out, "No op executions in the RunMetadata.\n");
+  } else {
+    const int64 path_start = critical_path_.front()->start_micros;
+    const int64 path_micros = critical_path_.back()->end_micros - path_start;
+    root_.set_total_exec_micros(path_micros);
+    strings::StrAppend(
+        &out, strings::Printf("Critical path: %s in %d ops, step %s\n",
+                              FormatTime(path_micros).c_str(),
+                              static_cast<int>(critical_path_.size()),
+                              FormatTime(step_end_micros_ - step_start_micros_)
+                                  .c_str()));
+    int64 prev_end = path_start;
+    for (const Execution* e : critical_path_) {
+      const int64 micros = e->end_micros - e->start_micros;
+      strings::StrAppend(
+          &out,
+          strings::Printf(
+              "  +%-10s %-10s (waited %s) %s (%s)\n",
+              FormatTime(e->start_micros - step_start_micros_).c_str(),
+              FormatTime(micros).c_str(),
+              FormatTime(e->start_micros - prev_end).c_str(), e->name.c_str(),
+              e->device.c_str()));
+      prev_end = e->end_micros;
+
+      TFProfNode* node = root_.add_children();
+      node->set_name(e->name);
+      node->set_device(e->device);
+      node->set_exec_micros(micros);
+      node->set_total_exec_micros(micros);
+    }
+  }
+
+  strings::StrAppend(&out, "\nDevice idle time:\n");
+  for (const auto& it : gaps_) {
+    const string& device = it.first;
+    if (!ShowDevice(device, opts)) continue;
+    int64 idle_micros = 0;
+    int64 cause_micros[kNumGapCauses] = {};
+    for (const Gap& gap : it.second) {
+      idle_micros += gap.end_micros - gap.start_micros;
+      cause_micros[gap.cause] += gap.end_micros - gap.start_micros;
+    }
+    const int64 step_micros = step_end_micros_ - step_start_micros_;
+    strings::StrAppend(
+        &out,
+        strings::Printf("%s: busy %s, idle %s (%.1f%% of step) in %d gaps\n",
+                        device.c_str(),
+                        FormatTime(busy_micros_[device]).c_str(),
+                        FormatTime(idle_micros).c_str(),
+                        step_micros > 0 ? 100.0 * idle_micros / step_micros : 0,
+                        static_cast<int>(it.second.size())));
+    std::vector<string> causes;
+    for (int c = 0; c < kNumGapCauses; ++c) {
+      if (cause_micros[c] == 0) continue;
+      causes.push_back(
+          strings::StrCat(GapCauseString(static_cast<GapCause>(c)), " ",
+                          FormatTime(cause_micros[c])));
+    }
+    if (!causes.empty()) {
+      strings::StrAppend(&out, "  ", str_util::Join(causes, ", "), "\n");
+    }
+    for (const Gap& gap : it.second) {
+      const int64 micros = gap.end_micros - gap.start_micros;
+      if (micros < opts.min_micros) continue;
+      strings::StrAppend(
+          &out,
+          strings::Printf(
+              "  +%-10s idle %-10s %s before %s",
+              FormatTime(gap.start_micros - step_start_micros_).c_str(),
+              FormatTime(micros).c_str(), GapCauseString(gap.cause),
+              gap.next->name.c_str()));
+      if (gap.waited_for != nullptr) {
+        strings::StrAppend(&out, ", waiting for ", gap.waited_for->name,
+                           " (", gap.waited_for->device, ")");
+      }
+      strings::StrAppend(&out, "\n");
+    }
+  }
+
+  if (opts.dump_to_file.empty()) {
+    printf("%s", out.c_str());
+    fflush(stdout);
+  } else {
+    Status s = WriteStringToFile(Env::Default(), opts.dump_to_file, out);
+    if (!s.ok()) {
+      fprintf(stderr, "%s\n", s.ToString().c_str());
+    }
+  }
+  return root_;
+}
+
+}  // namespace tfprof
+}  // namespace tensorflow
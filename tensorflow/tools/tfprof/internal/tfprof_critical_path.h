@@ -0,0 +1,128 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Critical path and idle time analysis of a step.
+// The dependency DAG of the step is rebuilt from the inputs of the GraphDef
+// and the op executions in the StepStats of the RunMetadata. The critical
+// path is then found by walking back from the op that ends last to the input
+// that finished last before each op started. Independently, the timeline of
+// each device is scanned for the gaps in which it was idle, and each gap is
+// attributed to what the op that ended it was waiting for.
+
+#ifndef THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_CRITICAL_PATH_H_
+#define THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_CRITICAL_PATH_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_options.h"
+#include "tensorflow/tools/tfprof/tfprof_output.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+class TFCriticalPath {
+ public:
+  // One execution of an op on a device.
+  struct Execution {
+    string name;
+    string device;
+    int64 start_micros;
+    int64 end_micros;
+    // nullptr if the op is not in the GraphDef.
+    const NodeDef* node_def;
+    // True if recorded by the GPU tracer on a stream rather than by the
+    // executor.
+    bool is_gpu_stream;
+  };
+
+  // What the op that ended an idle gap was waiting for.
+  enum GapCause {
+    // An input computed on a CPU device.
+    kHostCompute = 0,
+    // An input computed on another, non-CPU device.
+    kDeviceCompute,
+    // An input from another device, which had finished before most of the
+    // gap, so that the gap is spent moving the tensor.
+    kTransfer,
+    // An input that is a dequeue from a queue.
+    kQueueWait,
+    // Nothing: the inputs were ready before the gap, or there were none.
+    kScheduling,
+    kNumGapCauses,
+  };
+
+  struct Gap {
+    int64 start_micros;
+    int64 end_micros;
+    GapCause cause;
+    // The execution that ended the gap.
+    const Execution* next;
+    // The input 'next' waited for, or nullptr.
+    const Execution* waited_for;
+  };
+
+  TFCriticalPath(const GraphDef& graph, const StepStats& step_stats);
+
+  // Prints the critical path and the idle gaps of the devices matching
+  // opts.device_regexes that last at least opts.min_micros. Returns the ops
+  // of the critical path, in order, as the children of the root.
+  const TFProfNode& Show(const Options& opts);
+
+  static const char* GapCauseString(GapCause cause);
+
+  // The executions on the critical path of the step, in order.
+  const std::vector<const Execution*>& critical_path() const {
+    return critical_path_;
+  }
+  // The idle gaps of each device, in order.
+  const std::map<string, std::vector<Gap>>& gaps() const { return gaps_; }
+
+ private:
+  void ParseStepStats(const StepStats& step_stats);
+  void BuildCriticalPath();
+  void BuildGaps();
+
+  // Returns the input of 'execution' that finished last before it started,
+  // or nullptr.
+  const Execution* BindingInput(const Execution& execution) const;
+  // Returns the execution by the executor of the op of 'execution', which
+  // launched it if it is a GPU stream execution.
+  const Execution* ExecutorExecution(const Execution& execution) const;
+  GapCause Cause(const Execution& next, int64 gap_start_micros,
+                 const Execution** waited_for) const;
+
+  std::map<string, const NodeDef*> node_defs_;
+  std::vector<Execution> executions_;
+  // The executor executions of each op, ordered by end time.
+  std::map<string, std::vector<const Execution*>> op_executions_;
+  int64 step_start_micros_;
+  int64 step_end_micros_;
+
+  std::vector<const Execution*> critical_path_;
+  std::map<string, std::vector<Gap>> gaps_;
+  std::map<string, int64> busy_micros_;
+
+  TFProfNode root_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_TFPROF_CRITICAL_PATH_H_
@@ -0,0 +1,151 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tools/tfprof/internal/tfprof_critical_path.h"
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_options.h"
+#include "tensorflow/tools/tfprof/tfprof_output.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+namespace {
+
+const char kCpu[] = "/job:localhost/replica:0/task:0/cpu:0";
+const char kGpu[] = "/job:localhost/replica:0/task:0/gpu:0";
+const char kGpuStream[] = "/gpu:0/stream:all";
+
+void AddNode(const string& name, const string& op,
+             const std::vector<string>& inputs, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  for (const string& input : inputs) {
+    node->add_input(input);
+  }
+}
+
+void AddExecution(const string& name, int64 start, int64 end,
+                  DeviceStepStats* dev_stats) {
+  NodeExecStats* node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name(name);
+  node_stats->set_all_start_micros(start);
+  node_stats->set_op_end_rel_micros(end - start);
+  node_stats->set_all_end_rel_micros(end - start);
+}
+
+class TFCriticalPathTest : public ::testing::Test {
+ protected:
+  TFCriticalPathTest() {
+    AddNode("dequeue", "QueueDequeueV2", {"queue"}, &graph_);
+    AddNode("preprocess", "Cast", {"dequeue"}, &graph_);
+    AddNode("side", "Identity", {"dequeue:1"}, &graph_);
+    AddNode("copy", "Identity", {"dequeue"}, &graph_);
+    AddNode("conv", "Conv2D", {"preprocess", "copy"}, &graph_);
+    AddNode("bias", "BiasAdd", {"conv"}, &graph_);
+    AddNode("loss", "Sum", {"bias:0", "^side"}, &graph_);
+
+    DeviceStepStats* cpu = step_stats_.add_dev_stats();
+    cpu->set_device(kCpu);
+    AddExecution("dequeue", 0, 100, cpu);
+    AddExecution("preprocess", 100, 150, cpu);
+    AddExecution("side", 100, 400, cpu);
+    AddExecution("loss", 520, 530, cpu);
+
+    DeviceStepStats* gpu = step_stats_.add_dev_stats();
+    gpu->set_device(kGpu);
+    AddExecution("copy", 130, 135, gpu);
+    AddExecution("conv", 200, 210, gpu);
+    AddExecution("bias", 210, 215, gpu);
+
+    DeviceStepStats* stream = step_stats_.add_dev_stats();
+    stream->set_device(kGpuStream);
+    AddExecution("conv:Conv2D", 220, 300, stream);
+    AddExecution("bias:BiasAdd", 300, 320, stream);
+
+    // Ignored in favor of stream:all.
+    DeviceStepStats* stream_7 = step_stats_.add_dev_stats();
+    stream_7->set_device("/gpu:0/stream:7");
+    AddExecution("conv:Conv2D", 220, 300, stream_7);
+  }
+
+  GraphDef graph_;
+  StepStats step_stats_;
+};
+
+TEST_F(TFCriticalPathTest, CriticalPath) {
+  TFCriticalPath critical_path(graph_, step_stats_);
+  std::vector<string> names;
+  for (const auto* execution : critical_path.critical_path()) {
+    names.push_back(execution->name);
+  }
+  // "side" ends after "bias", so it binds "loss".
+  EXPECT_EQ(std::vector<string>({"dequeue", "side", "loss"}), names);
+
+  Options opts(3, 0, 0, 0, 0, {".*"}, "name", {".*"}, {".*"}, {""}, {".*"},
+               {""}, false, {"micros"}, false);
+  const TFProfNode& root = critical_path.Show(opts);
+  EXPECT_EQ(530, root.total_exec_micros());
+  ASSERT_EQ(3, root.children_size());
+  EXPECT_EQ("side", root.children(1).name());
+  EXPECT_EQ(kCpu, root.children(1).device());
+  EXPECT_EQ(300, root.children(1).exec_micros());
+}
+
+TEST_F(TFCriticalPathTest, Gaps) {
+  TFCriticalPath critical_path(graph_, step_stats_);
+  const auto& gaps = critical_path.gaps();
+  EXPECT_EQ(3, gaps.size());
+
+  const auto& cpu_gaps = gaps.at(kCpu);
+  ASSERT_EQ(1, cpu_gaps.size());
+  EXPECT_EQ(400, cpu_gaps[0].start_micros);
+  EXPECT_EQ(520, cpu_gaps[0].end_micros);
+  EXPECT_EQ(TFCriticalPath::kScheduling, cpu_gaps[0].cause);
+  EXPECT_EQ("side", cpu_gaps[0].waited_for->name);
+
+  const auto& gpu_gaps = gaps.at(kGpu);
+  ASSERT_EQ(2, gpu_gaps.size());
+  EXPECT_EQ(0, gpu_gaps[0].start_micros);
+  EXPECT_EQ(130, gpu_gaps[0].end_micros);
+  EXPECT_EQ(TFCriticalPath::kQueueWait, gpu_gaps[0].cause);
+  EXPECT_EQ("dequeue", gpu_gaps[0].waited_for->name);
+  EXPECT_EQ(135, gpu_gaps[1].start_micros);
+  EXPECT_EQ(200, gpu_gaps[1].end_micros);
+  EXPECT_EQ(TFCriticalPath::kTransfer, gpu_gaps[1].cause);
+  EXPECT_EQ("preprocess", gpu_gaps[1].waited_for->name);
+
+  // The GPU waits for the host to compute the input of its first kernel.
+  const auto& stream_gaps = gaps.at(kGpuStream);
+  ASSERT_EQ(1, stream_gaps.size());
+  EXPECT_EQ(0, stream_gaps[0].start_micros);
+  EXPECT_EQ(220, stream_gaps[0].end_micros);
+  EXPECT_EQ(TFCriticalPath::kHostCompute, stream_gaps[0].cause);
+  EXPECT_EQ("conv", stream_gaps[0].next->name);
+  EXPECT_EQ("preprocess", stream_gaps[0].waited_for->name);
+}
+
+TEST_F(TFCriticalPathTest, Empty) {
+  TFCriticalPath critical_path(graph_, StepStats());
+  EXPECT_TRUE(critical_path.critical_path().empty());
+  EXPECT_TRUE(critical_path.gaps().empty());
+}
+
+}  // namespace
+}  // namespace tfprof
+}  // namespace tensorflow
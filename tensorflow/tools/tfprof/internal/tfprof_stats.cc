@@ -62,6 +62,10 @@ TFStats::TFStats(std::unique_ptr<GraphDef> graph,
   }
   scope_view_->Build();
   graph_view_->Build();
+  if (run_meta_ && run_meta_->has_step_stats()) {
+    critical_path_view_.reset(
+        new TFCriticalPath(*graph_, run_meta_->step_stats()));
+  }
 }
 
 const TFProfNode& TFStats::PrintGraph(const string& cmd, const Options& opts) {
@@ -69,6 +73,12 @@ const TFProfNode& TFStats::PrintGraph(const string& cmd, const Options& opts) {
     return scope_view_->Show(opts);
   } else if (cmd == kCmds[1]) {
     return graph_view_->Show(opts);
+  } else if (cmd == kCmds[4]) {
+    if (!critical_path_view_) {
+      fprintf(stderr, "critical_path needs a RunMetadata with StepStats\n");
+      return empty_node_;
+    }
+    return critical_path_view_->Show(opts);
   } else {
     fprintf(stderr, "Unknown command: %s\n", cmd.c_str());
     return empty_node_;
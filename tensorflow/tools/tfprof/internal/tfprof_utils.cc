@@ -283,6 +283,11 @@ void PrintHelp() {
       "the source (inputs) and sink (outputs). 'graph' command builds "
       "a graph pointing *from output to input*, and aggregates "
       "statistics based on it.\n\n"
+      "  critical_path: Rebuilds the dependency graph of the step from the "
+      "RunMetadata and shows the ops on its critical path, and the gaps in "
+      "which each device was idle with what it was waiting for: host "
+      "compute, device compute, transfer, queue wait or scheduling. Honors "
+      "-device_regexes, and -min_micros for the gaps shown.\n\n"
       "  set: Set options that will be default for follow up commands.\n\n"
       "  help: Show helps.\n"
       "\nOptions\n\n"